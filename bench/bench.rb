@@ -0,0 +1,143 @@
+# Benchmark harness for Ruby/GSL.
+#
+# A suite file (bench/*_bench.rb) declares cases; each case is built
+# once per size and returns the operation to time:
+#
+#   GSL::Bench.suite("vector") do
+#     bench("Vector#sum", [1000, 1000000]) do |n|
+#       v = GSL::Vector.alloc(n).set_all(1.0)
+#       lambda { v.sum }
+#     end
+#   end
+#
+# The operation is repeated for at least min_time seconds; a result
+# gives the time per call and per element (elements: size, or the
+# :elements proc of the case), the objects allocated per call and the
+# GC runs during the measurement.  Results are written as JSON and can
+# be compared with those of another build (see bench/run.rb).
+require("json")
+require("gsl")
+
+module GSL
+  module Bench
+    Case = Struct.new(:suite, :name, :sizes, :elements, :builder)
+    Result = Struct.new(:suite, :name, :size, :elements, :iterations, :seconds,
+                        :ns_per_op, :ns_per_element, :allocations_per_op, :gc_count) do
+      def key
+        [suite, name, size]
+      end
+
+      def to_h
+        Hash[members.zip(values)]
+      end
+    end
+
+    @cases = []
+
+    class << self
+      attr_reader :cases
+    end
+
+    class Suite
+      def initialize(name)
+        @name = name
+      end
+
+      # bench(name, sizes, :elements => proc { |n| n*n }) { |n| lambda { ... } }
+      def bench(name, sizes, opts = {}, &builder)
+        Bench.cases << Case.new(@name, name, sizes, opts[:elements], builder)
+      end
+    end
+
+    def self.suite(name, &block)
+      Suite.new(name).instance_eval(&block)
+    end
+
+    def self.clock
+      Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    end
+
+    def self.measure(c, size, min_time)
+      op = c.builder.call(size)
+      op.call
+      GC.start
+      alloc = GC.stat(:total_allocated_objects)
+      gc = GC.count
+      iterations = 0
+      t0 = clock
+      begin
+        op.call
+        iterations += 1
+        elapsed = clock - t0
+      end while elapsed < min_time
+      alloc = GC.stat(:total_allocated_objects) - alloc
+      gc = GC.count - gc
+      elements = c.elements ? c.elements.call(size) : size
+      ns = elapsed*1e9/iterations
+      Result.new(c.suite, c.name, size, elements, iterations, elapsed,
+                 ns, ns/elements, alloc.to_f/iterations, gc)
+    end
+
+    # Runs the cases, printing each result as it is measured
+    def self.run(opts = {}, io = $stdout)
+      min_time = opts[:min_time] || 0.5
+      results = []
+      io.printf("%-10s %-28s %9s %14s %12s %10s %5s\n", "suite", "case", "size",
+                "ns/op", "ns/elem", "allocs/op", "GC")
+      cases.each do |c|
+        next if opts[:only] and !opts[:only].include?(c.suite)
+        c.sizes.each do |size|
+          next if opts[:max_size] and size > opts[:max_size]
+          r = measure(c, size, min_time)
+          io.printf("%-10s %-28s %9d %14.1f %12.3f %10.1f %5d\n", r.suite, r.name,
+                    r.size, r.ns_per_op, r.ns_per_element, r.allocations_per_op, r.gc_count)
+          results << r
+        end
+      end
+      results
+    end
+
+    def self.environment
+      {
+        "ruby" => RUBY_DESCRIPTION,
+        "gsl" => GSL::VERSION,
+        "rb_gsl" => GSL::RB_GSL_VERSION,
+        "parallel_threads" => (GSL.parallel_threads rescue nil),
+        "time" => Time.now.utc.strftime("%Y-%m-%dT%H:%M:%SZ")
+      }
+    end
+
+    def self.save(path, results)
+      File.open(path, "w") do |f|
+        f.write(JSON.pretty_generate("environment" => environment,
+                                     "results" => results.collect { |r| r.to_h }))
+      end
+    end
+
+    def self.load(path)
+      JSON.parse(File.read(path))["results"].collect do |h|
+        Result.new(*Result.members.collect { |m| h[m.to_s] })
+      end
+    end
+
+    # Prints the time ratio of each case to the baseline and returns the
+    # results slower by more than threshold percent
+    def self.compare(results, baseline, threshold = 10.0, io = $stdout)
+      base = {}
+      baseline.each { |r| base[r.key] = r }
+      slower = []
+      io.printf("\n%-10s %-28s %9s %14s %14s %8s\n", "suite", "case", "size",
+                "base ns/op", "ns/op", "ratio")
+      results.each do |r|
+        b = base[r.key]
+        next unless b
+        ratio = r.ns_per_op/b.ns_per_op
+        flag = ratio > 1.0 + threshold/100.0
+        slower << r if flag
+        io.printf("%-10s %-28s %9d %14.1f %14.1f %8.3f%s\n", r.suite, r.name, r.size,
+                  b.ns_per_op, r.ns_per_op, ratio, flag ? "  SLOWER" : "")
+      end
+      slower
+    end
+  end
+end
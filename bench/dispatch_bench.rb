@@ -0,0 +1,45 @@
+# Per-call cost of small inputs, where deciding the argument types
+# (VECTOR_P, MATRIX_P, CHECK_VECTOR ...) weighs as much as the math.
+# The size is the number of calls per operation: ns_per_element is the
+# cost of one call.
+GSL::Bench.suite("dispatch") do
+  calls = [1000]
+
+  bench("Sf::erf(Vector[3])", calls) do |n|
+    v = GSL::Vector[0.1, 0.2, 0.3]
+    lambda { n.times { GSL::Sf::erf(v) } }
+  end
+
+  bench("Sf::erf(Array[3])", calls) do |n|
+    a = [0.1, 0.2, 0.3]
+    lambda { n.times { GSL::Sf::erf(a) } }
+  end
+
+  bench("Sf::erf(Range)", calls) do |n|
+    r = 1..3
+    lambda { n.times { GSL::Sf::erf(r) } }
+  end
+
+  bench("Vector#+ (3)", calls) do |n|
+    a = GSL::Vector[1, 2, 3]
+    b = GSL::Vector[4, 5, 6]
+    lambda { n.times { a + b } }
+  end
+
+  bench("Matrix#* Vector (2x2)", calls) do |n|
+    m = GSL::Matrix[[1, 2], [3, 4]]
+    v = GSL::Vector[1, 1].col
+    lambda { n.times { m*v } }
+  end
+
+  bench("Blas.ddot (3)", calls) do |n|
+    a = GSL::Vector[1, 2, 3]
+    b = GSL::Vector[4, 5, 6]
+    lambda { n.times { GSL::Blas.ddot(a, b) } }
+  end
+
+  bench("Vector::View#sum (3)", calls) do |n|
+    v = GSL::Vector.alloc(10).set_all(1.0).subvector(2, 3)
+    lambda { n.times { v.sum } }
+  end
+end
@@ -0,0 +1,17 @@
+GSL::Bench.suite("fft") do
+  bench("Vector#fft (2^k)", [256, 65536, 1048576]) do |n|
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { v.fft }
+  end
+
+  bench("Vector#fft (mixed radix)", [300, 60000, 1000000]) do |n|
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { v.fft }
+  end
+
+  bench("Vector::Complex#forward", [256, 65536]) do |n|
+    r = GSL::Rng.alloc
+    c = GSL::Vector::Complex.alloc(r.uniform(n), r.uniform(n))
+    lambda { c.forward }
+  end
+end
@@ -0,0 +1,13 @@
+GSL::Bench.suite("histogram") do
+  bench("Histogram#increment(Vector)", [1000, 100000, 1000000]) do |n|
+    h = GSL::Histogram.alloc(100, [0, 1])
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { h.increment(v) }
+  end
+
+  bench("Histogram#increment(x) loop", [1000, 100000]) do |n|
+    h = GSL::Histogram.alloc(100, [0, 1])
+    a = GSL::Rng.alloc.uniform(n).to_a
+    lambda { a.each { |x| h.increment(x) } }
+  end
+end
@@ -0,0 +1,29 @@
+GSL::Bench.suite("matrix") do
+  sizes = [8, 64, 256]
+
+  random_matrix = lambda do |r, n|
+    m = GSL::Matrix.alloc(n, n)
+    n.times { |i| m.set_row(i, r.uniform(n)) }
+    m
+  end
+
+  bench("Matrix#* (ns per n^3)", sizes, :elements => lambda { |n| n**3 }) do |n|
+    r = GSL::Rng.alloc
+    a = random_matrix.call(r, n)
+    b = random_matrix.call(r, n)
+    lambda { a*b }
+  end
+
+  bench("Matrix#transpose", sizes + [2048], :elements => lambda { |n| n*n }) do |n|
+    m = random_matrix.call(GSL::Rng.alloc, n)
+    lambda { m.transpose }
+  end
+
+  bench("Linalg::LU.solve (n^3)", sizes, :elements => lambda { |n| n**3 }) do |n|
+    r = GSL::Rng.alloc
+    m = random_matrix.call(r, n)
+    n.times { |i| m[i, i] += n }
+    b = r.uniform(n)
+    lambda { GSL::Linalg::LU.solve(m, b) }
+  end
+end
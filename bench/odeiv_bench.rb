@@ -0,0 +1,29 @@
+GSL::Bench.suite("odeiv") do
+  # size: steps of a harmonic oscillator with fixed step; ns per step
+  oscillator = Proc.new { |t, y, dydt|
+    dydt[0] = y[1]
+    dydt[1] = -y[0]
+  }
+
+  bench("Odeiv::Step RK4 apply", [100, 10000]) do |n|
+    step = GSL::Odeiv::Step.alloc(GSL::Odeiv::Step::RK4, 2)
+    sys = GSL::Odeiv::System.alloc(oscillator, 2)
+    y = GSL::Vector.alloc(1.0, 0.0)
+    yerr = GSL::Vector.alloc(2)
+    lambda {
+      t = 0.0
+      n.times { step.apply(t, 0.01, y, yerr, sys); t += 0.01 }
+    }
+  end
+
+  bench("Odeiv::Solver RKF45 apply", [100, 10000]) do |n|
+    solver = GSL::Odeiv::Solver.alloc(GSL::Odeiv::Step::RKF45, [1e-8, 0.0], oscillator, 2)
+    lambda {
+      solver.reset
+      y = GSL::Vector.alloc(1.0, 0.0)
+      t = 0.0
+      h = 1e-3
+      n.times { t, h, status = solver.apply(t, 1e9, h, y) }
+    }
+  end
+end
@@ -0,0 +1,31 @@
+#!/usr/bin/env ruby
+# Runs the Ruby/GSL benchmark suites (bench/*_bench.rb).
+#   usage: run.rb [--only vector,fft] [--max-size N] [--min-time SEC]
+#                 [--out results.json] [--compare baseline.json]
+#                 [--threshold PERCENT]
+# With --compare, the exit status is 1 when a case is slower than the
+# baseline by more than the threshold (10% by default).
+require("optparse")
+require(File.expand_path("bench.rb", File.dirname(__FILE__)))
+
+opts = {}
+out = nil
+baseline = nil
+threshold = 10.0
+OptionParser.new do |o|
+  o.on("--only SUITES", Array) { |a| opts[:only] = a }
+  o.on("--max-size N", Integer) { |n| opts[:max_size] = n }
+  o.on("--min-time SEC", Float) { |t| opts[:min_time] = t }
+  o.on("--out FILE") { |f| out = f }
+  o.on("--compare FILE") { |f| baseline = f }
+  o.on("--threshold PERCENT", Float) { |t| threshold = t }
+end.parse!
+
+Dir.glob(File.join(File.dirname(__FILE__), "*_bench.rb")).sort.each { |f| require(File.expand_path(f)) }
+
+results = GSL::Bench.run(opts)
+GSL::Bench.save(out, results) if out
+if baseline
+  slower = GSL::Bench.compare(results, GSL::Bench.load(baseline), threshold)
+  exit(1) unless slower.empty?
+end
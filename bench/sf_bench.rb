@@ -0,0 +1,16 @@
+GSL::Bench.suite("sf") do
+  bench("Sf::bessel_J0(Vector)", [100, 100000]) do |n|
+    v = GSL::Vector.linspace(0, 100, n)
+    lambda { GSL::Sf::bessel_J0(v) }
+  end
+
+  bench("Sf::erf(x) loop", [100, 100000]) do |n|
+    a = GSL::Vector.linspace(-3, 3, n).to_a
+    lambda { a.each { |x| GSL::Sf::erf(x) } }
+  end
+
+  bench("Sf::gamma(Vector)", [100, 100000]) do |n|
+    v = GSL::Vector.linspace(0.5, 50, n)
+    lambda { GSL::Sf::gamma(v) }
+  end
+end
@@ -0,0 +1,37 @@
+GSL::Bench.suite("vector") do
+  sizes = [100, 10000, 1000000]
+
+  bench("Vector#sum", sizes) do |n|
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { v.sum }
+  end
+
+  bench("Vector#+", sizes) do |n|
+    r = GSL::Rng.alloc
+    a = r.uniform(n)
+    b = r.uniform(n)
+    lambda { a + b }
+  end
+
+  bench("Vector#scale", sizes) do |n|
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { v.scale(2.0) }
+  end
+
+  bench("Vector#dot", sizes) do |n|
+    r = GSL::Rng.alloc
+    a = r.uniform(n)
+    b = r.uniform(n)
+    lambda { a.dot(b) }
+  end
+
+  bench("Vector#sort", sizes) do |n|
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { v.sort }
+  end
+
+  bench("Vector#mean,#sd", sizes) do |n|
+    v = GSL::Rng.alloc.uniform(n)
+    lambda { v.mean; v.sd }
+  end
+end
@@ -0,0 +1,29 @@
+#!/usr/bin/env ruby
+# Compares Matrix#transpose (tiled, threaded for large matrices) and
+# Matrix#transpose! (in place) with the element-by-element
+# Matrix#transpose_naive.
+#   usage: transpose_bench.rb [size1 [size2 [repeat]]]
+require 'benchmark'
+require 'gsl'
+
+size1 = (ARGV[0] || 4000).to_i
+size2 = (ARGV[1] || size1).to_i
+repeat = (ARGV[2] || 5).to_i
+
+r = GSL::Rng.alloc
+m = GSL::Matrix.alloc(size1, size2)
+size1.times { |i| m.set_row(i, r.uniform(size2)) }
+
+printf("%d x %d, %d threads from %d elements\n", size1, size2,
+       GSL.parallel_threads, GSL.parallel_threshold)
+Benchmark.bm(22) do |x|
+  x.report("transpose_naive") { repeat.times { m.transpose_naive } }
+  x.report("transpose") { repeat.times { m.transpose } }
+  x.report("transpose (1 thread)") {
+    th = GSL.parallel_threshold
+    GSL.parallel_threshold = 0
+    repeat.times { m.transpose }
+    GSL.parallel_threshold = th
+  }
+  x.report("transpose!") { repeat.times { m.transpose! } }
+end
@@ -43,6 +43,8 @@ VALUE cgsl_vector_int, cgsl_vector_int_col;
 VALUE cgsl_vector_int_view, cgsl_vector_int_col_view;
 VALUE cgsl_vector_int_view_ro, cgsl_vector_int_col_view_ro;
 VALUE cgsl_matrix_int, cgsl_matrix_int_view, cgsl_matrix_int_view_ro;
+VALUE cgsl_vector_float, cgsl_vector_float_view;
+VALUE cgsl_matrix_float, cgsl_matrix_float_view;
 
 double* get_vector_ptr(VALUE ary, size_t *stride, size_t *n)
 {
@@ -73,6 +75,10 @@ double* get_vector_ptr(VALUE ary, size_t *stride, size_t *n)
     *stride = 1;
     ary2 = na_change_type(ary, NA_DFLOAT);
     return NA_PTR_TYPE(ary2,double*);
+#endif
+#ifdef HAVE_NUMO_NARRAY_H
+  } else if (rb_gsl_numo_p(ary)) {
+    return rb_gsl_numo_vector_ptr(ary, stride, n);
 #endif
   } else {
     rb_raise(rb_eTypeError,
@@ -597,6 +603,142 @@ void rb_gsl_matrix_int_view_free(gsl_matrix_int_view * mv)
   free((gsl_matrix_int_view *) mv);
 }
 
+/*
+  A frozen vector or matrix which owns its data can be shared between
+  Ractors (Ractor.make_shareable(v), Ractor.new(v) without a copy): the
+  setters ([]=, set, set_all, set_zero, set_row, swap_rows!, ...) raise
+  FrozenError, and the other methods which write in place must not be
+  given a shared object either.  A frozen view is not shareable, since
+  the object it looks into may still be changed.
+*/
+static VALUE rb_gsl_array_freeze(VALUE obj)
+{
+  rb_obj_freeze(obj);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  /* the gsl_vector and gsl_matrix types of all elements share one layout */
+  if ((MATRIX_P(obj) || MATRIX_INT_P(obj) || MATRIX_COMPLEX_P(obj)) ?
+      rb_gsl_matrix_owns_data(DATA_PTR(obj)) : rb_gsl_vector_owns_data(DATA_PTR(obj)))
+    RB_FL_SET_RAW(obj, RUBY_FL_SHAREABLE);
+#endif
+  return obj;
+}
+
+/*
+  Shared clones.  The clone of a frozen Vector or Matrix (double, int or
+  complex) which owns its data is a frozen object of the same class whose
+  gsl_vector (gsl_matrix) points into the data of the original, instead
+  of a copy of it: cloning costs one small record, whatever the size.
+  Neither object can be written, and dup, the mutable copy, is the point
+  where the data is copied:
+
+    a = GSL::Matrix.alloc(10000, 10000).freeze
+    b = a.clone                 # frozen, shares the data of a
+    c = b.dup                   # a copy, not frozen
+
+  The record keeps the owner of the data alive through the mark
+  function, and the clone of a clone refers to the same owner.  The
+  clone of an object which is not frozen, or of a frozen view, is still
+  a copy; clone(:freeze => false) always copies.
+*/
+typedef struct {
+  gsl_vector x;
+  VALUE src;
+} array_share_vector;
+
+typedef struct {
+  gsl_matrix x;
+  VALUE src;
+} array_share_matrix;
+
+static void array_share_vector_mark(array_share_vector *p)
+{
+  rb_gc_mark(p->src);
+}
+
+static void array_share_matrix_mark(array_share_matrix *p)
+{
+  rb_gc_mark(p->src);
+}
+
+static void array_share_free(void *p)
+{
+  free(p);
+}
+
+static int array_share_p(VALUE obj)
+{
+  return RDATA(obj)->dmark == (RUBY_DATA_FUNC) array_share_vector_mark
+    || RDATA(obj)->dmark == (RUBY_DATA_FUNC) array_share_matrix_mark;
+}
+
+static VALUE array_share_wrap(VALUE obj, VALUE src, RUBY_DATA_FUNC mark, void *p)
+{
+  VALUE share = Data_Wrap_Struct(rb_obj_class(obj), mark, array_share_free, p);
+  rb_obj_freeze(share);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  if (RB_FL_TEST_RAW(src, RUBY_FL_SHAREABLE)) RB_FL_SET_RAW(share, RUBY_FL_SHAREABLE);
+#endif
+  return share;
+}
+
+/* A shared clone of obj, or nil if obj is not frozen or does not own its
+   data.  The gsl_vector (gsl_matrix) types of all elements share one
+   layout. */
+VALUE rb_gsl_vector_share(VALUE obj)
+{
+  array_share_vector *p;
+  VALUE src = obj;
+  if (!OBJ_FROZEN(obj)) return Qnil;
+  if (array_share_p(obj)) src = ((array_share_vector *) DATA_PTR(obj))->src;
+  else if (!rb_gsl_vector_owns_data(DATA_PTR(obj))) return Qnil;
+  if ((p = (array_share_vector *) malloc(sizeof(array_share_vector))) == NULL)
+    rb_raise(rb_eNoMemError, "malloc failed");
+  memcpy(&p->x, DATA_PTR(obj), sizeof(gsl_vector));
+  p->x.owner = 0;
+  p->src = src;
+  return array_share_wrap(obj, src, (RUBY_DATA_FUNC) array_share_vector_mark, &p->x);
+}
+
+VALUE rb_gsl_matrix_share(VALUE obj)
+{
+  array_share_matrix *p;
+  VALUE src = obj;
+  if (!OBJ_FROZEN(obj)) return Qnil;
+  if (array_share_p(obj)) src = ((array_share_matrix *) DATA_PTR(obj))->src;
+  else if (!rb_gsl_matrix_owns_data(DATA_PTR(obj))) return Qnil;
+  if ((p = (array_share_matrix *) malloc(sizeof(array_share_matrix))) == NULL)
+    rb_raise(rb_eNoMemError, "malloc failed");
+  memcpy(&p->x, DATA_PTR(obj), sizeof(gsl_matrix));
+  p->x.owner = 0;
+  p->src = src;
+  return array_share_wrap(obj, src, (RUBY_DATA_FUNC) array_share_matrix_mark, &p->x);
+}
+
+/* clone([:freeze => true/false]) of the Vector and Matrix classes, dup
+   being the copy: as Object#clone, the clone of a frozen object is
+   frozen unless :freeze => false is given */
+VALUE rb_gsl_array_clone(int argc, VALUE *argv, VALUE obj, VALUE (*dup)(VALUE))
+{
+  VALUE freeze = Qnil, vnew;
+  switch (argc) {
+  case 0:
+    break;
+  case 1:
+    Check_Type(argv[0], T_HASH);
+    freeze = rb_hash_aref(argv[0], ID2SYM(rb_intern("freeze")));
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  }
+  if (freeze == Qfalse) return (*dup)(obj);
+  vnew = (MATRIX_P(obj) || MATRIX_INT_P(obj) || MATRIX_COMPLEX_P(obj)) ?
+    rb_gsl_matrix_share(obj) : rb_gsl_vector_share(obj);
+  if (!NIL_P(vnew)) return vnew;
+  vnew = (*dup)(obj);
+  if (RTEST(freeze) || OBJ_FROZEN(obj)) rb_funcall(vnew, rb_intern("freeze"), 0);
+  return vnew;
+}
+
 void Init_gsl_array(VALUE module)
 {
   cgsl_block = rb_define_class_under(module, "Block", 
@@ -665,6 +807,13 @@ void Init_gsl_array(VALUE module)
   cgsl_matrix_int_view_ro = rb_define_class_under(cgsl_matrix_int_view, "ReadOnly",
 					      cgsl_matrix_int_view);
   /*****/
+  cgsl_vector_float = rb_define_class_under(cgsl_vector, "Float", cGSL_Object);
+  cgsl_vector_float_view = rb_define_class_under(cgsl_vector_float, "View",
+						 cgsl_vector_float);
+  cgsl_matrix_float = rb_define_class_under(cgsl_matrix, "Float", cGSL_Object);
+  cgsl_matrix_float_view = rb_define_class_under(cgsl_matrix_float, "View",
+						 cgsl_matrix_float);
+  /*****/
   Init_gsl_block_init(module);
   Init_gsl_block_int_init(module);
   Init_gsl_block_uchar_init(module);
@@ -672,9 +821,18 @@ void Init_gsl_array(VALUE module)
   Init_gsl_vector_int(module);
 
   Init_gsl_vector_complex(module);
+  Init_gsl_vector_lazy(module);
   Init_gsl_matrix(module);
+  Init_gsl_matrix_lazy(module);
   Init_gsl_matrix_int(module);
   Init_gsl_matrix_complex(module);
+  Init_gsl_vector_float(module);
+  Init_gsl_matrix_float(module);
+  Init_gsl_array_mask(module);
+  Init_gsl_array_mmap(module);
+  Init_gsl_array_text(module);
+  Init_gsl_reduce(module);
+  Init_gsl_vmath(module);
   Init_gsl_permutation(module);
 #ifdef GSL_1_1_LATER
   Init_gsl_combination(module);
@@ -689,4 +847,11 @@ void Init_gsl_array(VALUE module)
   rb_define_method(cgsl_vector_complex_view_ro, "set", rb_gsl_obj_read_only, -1);
   rb_define_method(cgsl_matrix_complex_view_ro, "set", rb_gsl_obj_read_only, -1);
 
+  rb_define_method(cgsl_vector, "freeze", rb_gsl_array_freeze, 0);
+  rb_define_method(cgsl_vector_int, "freeze", rb_gsl_array_freeze, 0);
+  rb_define_method(cgsl_vector_complex, "freeze", rb_gsl_array_freeze, 0);
+  rb_define_method(cgsl_matrix, "freeze", rb_gsl_array_freeze, 0);
+  rb_define_method(cgsl_matrix_int, "freeze", rb_gsl_array_freeze, 0);
+  rb_define_method(cgsl_matrix_complex, "freeze", rb_gsl_array_freeze, 0);
+
 }
@@ -13,6 +13,8 @@
 #include "rb_gsl_complex.h"
 #include "rb_gsl_array.h"
 
+gsl_complex rb_gsl_obj_to_gsl_complex(VALUE obj, gsl_complex *z);
+
 enum {
   GSL_COMPLEX_ADD,
   GSL_COMPLEX_SUB,
@@ -65,7 +67,8 @@ static VALUE rb_gsl_complex_arithmetics5(int flag, VALUE obj, VALUE bb)
   case T_FLOAT:
   case T_FIXNUM:
   case T_BIGNUM:
-    tmp2 = gsl_complex_rect(NUM2DBL(bb), 0.0);
+  case T_COMPLEX:
+    tmp2 = rb_gsl_obj_to_gsl_complex(bb, NULL);
     b = &tmp2;
     tmp = (*func1)(*a, *b);
     switch (flag) {
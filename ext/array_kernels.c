@@ -0,0 +1,190 @@
+/*
+  array_kernels.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Elementwise kernels for the arithmetic operators of GSL::Vector and
+  GSL::Matrix.  The result is written to a separate output in one pass
+  (instead of cloning the operand and updating the clone).  Unit-stride
+  data, the common case, goes through plain indexed loops with the
+  operation chosen outside the loop, so that the compiler can vectorize
+  them; other strides fall back to strided loops.  When the operands
+  all start on a 64-byte boundary (GSL::Memory.align = 64), the loops
+  are told so and run without the peeling for alignment.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+#define KERNEL_ALIGNED(p) RB_GSL_ALIGNED(p, RB_GSL_SIMD_ALIGN)
+#define KERNEL_ASSUME(p) RB_GSL_ASSUME_ALIGNED(p, RB_GSL_SIMD_ALIGN)
+
+#define KERNEL_BINOP_LOOPS(o, a, b, n, op)				\
+  switch (op) {								\
+  case MYGSL_KERNEL_ADD: for (i = 0; i < n; i++) o[i] = a[i] + b[i]; break; \
+  case MYGSL_KERNEL_SUB: for (i = 0; i < n; i++) o[i] = a[i] - b[i]; break; \
+  case MYGSL_KERNEL_MUL: for (i = 0; i < n; i++) o[i] = a[i] * b[i]; break; \
+  case MYGSL_KERNEL_DIV: for (i = 0; i < n; i++) o[i] = a[i] / b[i]; break; \
+  }
+
+static void kernel_binop_aligned(double *o, const double *a, const double *b,
+				 size_t n, int op)
+{
+  double *oa = KERNEL_ASSUME(o);
+  const double *aa = KERNEL_ASSUME(a), *ba = KERNEL_ASSUME(b);
+  size_t i;
+  KERNEL_BINOP_LOOPS(oa, aa, ba, n, op);
+}
+
+static void kernel_binop(double *o, size_t so, const double *a, size_t sa,
+			 const double *b, size_t sb, size_t n, int op)
+{
+  size_t i;
+  if (so == 1 && sa == 1 && sb == 1) {
+    if (KERNEL_ALIGNED(o) && KERNEL_ALIGNED(a) && KERNEL_ALIGNED(b)) {
+      kernel_binop_aligned(o, a, b, n, op);
+      return;
+    }
+    KERNEL_BINOP_LOOPS(o, a, b, n, op);
+    return;
+  }
+  switch (op) {
+  case MYGSL_KERNEL_ADD: for (i = 0; i < n; i++) o[i*so] = a[i*sa] + b[i*sb]; break;
+  case MYGSL_KERNEL_SUB: for (i = 0; i < n; i++) o[i*so] = a[i*sa] - b[i*sb]; break;
+  case MYGSL_KERNEL_MUL: for (i = 0; i < n; i++) o[i*so] = a[i*sa] * b[i*sb]; break;
+  case MYGSL_KERNEL_DIV: for (i = 0; i < n; i++) o[i*so] = a[i*sa] / b[i*sb]; break;
+  }
+}
+
+/* DIV by a constant multiplies by its inverse, as gsl_vector_scale(1/c)
+   did before */
+static void kernel_binop_const_aligned(double *o, const double *a, double c,
+				       size_t n, int op)
+{
+  double *oa = KERNEL_ASSUME(o);
+  const double *aa = KERNEL_ASSUME(a);
+  size_t i;
+  if (op == MYGSL_KERNEL_ADD) for (i = 0; i < n; i++) oa[i] = aa[i] + c;
+  else for (i = 0; i < n; i++) oa[i] = aa[i] * c;
+}
+
+static void kernel_binop_const(double *o, size_t so, const double *a, size_t sa,
+			       double c, size_t n, int op)
+{
+  size_t i;
+  if (op == MYGSL_KERNEL_SUB) { op = MYGSL_KERNEL_ADD; c = -c; }
+  if (op == MYGSL_KERNEL_DIV) { op = MYGSL_KERNEL_MUL; c = 1.0/c; }
+  if (so == 1 && sa == 1) {
+    if (KERNEL_ALIGNED(o) && KERNEL_ALIGNED(a)) {
+      kernel_binop_const_aligned(o, a, c, n, op);
+      return;
+    }
+    if (op == MYGSL_KERNEL_ADD) for (i = 0; i < n; i++) o[i] = a[i] + c;
+    else for (i = 0; i < n; i++) o[i] = a[i] * c;
+    return;
+  }
+  if (op == MYGSL_KERNEL_ADD) for (i = 0; i < n; i++) o[i*so] = a[i*sa] + c;
+  else for (i = 0; i < n; i++) o[i*so] = a[i*sa] * c;
+}
+
+#define KERNEL_UNOP_LOOPS(o, a, n, op)					\
+  switch (op) {								\
+  case MYGSL_KERNEL_ABS: for (i = 0; i < n; i++) o[i] = fabs(a[i]); break; \
+  case MYGSL_KERNEL_SQRT: for (i = 0; i < n; i++) o[i] = sqrt(a[i]); break; \
+  case MYGSL_KERNEL_SQUARE: for (i = 0; i < n; i++) o[i] = a[i]*a[i]; break; \
+  }
+
+static void kernel_unop_aligned(double *o, const double *a, size_t n, int op)
+{
+  double *oa = KERNEL_ASSUME(o);
+  const double *aa = KERNEL_ASSUME(a);
+  size_t i;
+  KERNEL_UNOP_LOOPS(oa, aa, n, op);
+}
+
+static void kernel_unop(double *o, size_t so, const double *a, size_t sa,
+			size_t n, int op)
+{
+  size_t i;
+  if (so == 1 && sa == 1) {
+    if (KERNEL_ALIGNED(o) && KERNEL_ALIGNED(a)) {
+      kernel_unop_aligned(o, a, n, op);
+      return;
+    }
+    KERNEL_UNOP_LOOPS(o, a, n, op);
+    return;
+  }
+  switch (op) {
+  case MYGSL_KERNEL_ABS: for (i = 0; i < n; i++) o[i*so] = fabs(a[i*sa]); break;
+  case MYGSL_KERNEL_SQRT: for (i = 0; i < n; i++) o[i*so] = sqrt(a[i*sa]); break;
+  case MYGSL_KERNEL_SQUARE: for (i = 0; i < n; i++) o[i*so] = a[i*sa]*a[i*sa]; break;
+  }
+}
+
+/* out = a op b; out may be a or b */
+int mygsl_vector_binop(gsl_vector *out, const gsl_vector *a, const gsl_vector *b,
+		       int op)
+{
+  if (a->size != b->size || out->size != a->size)
+    GSL_ERROR("vectors must have same length", GSL_EBADLEN);
+  kernel_binop(out->data, out->stride, a->data, a->stride, b->data, b->stride,
+	       a->size, op);
+  return GSL_SUCCESS;
+}
+
+int mygsl_vector_binop_const(gsl_vector *out, const gsl_vector *a, double c, int op)
+{
+  if (out->size != a->size)
+    GSL_ERROR("vectors must have same length", GSL_EBADLEN);
+  kernel_binop_const(out->data, out->stride, a->data, a->stride, c, a->size, op);
+  return GSL_SUCCESS;
+}
+
+int mygsl_vector_unop(gsl_vector *out, const gsl_vector *a, int op)
+{
+  if (out->size != a->size)
+    GSL_ERROR("vectors must have same length", GSL_EBADLEN);
+  kernel_unop(out->data, out->stride, a->data, a->stride, a->size, op);
+  return GSL_SUCCESS;
+}
+
+/* Packed matrices are processed as one contiguous array, others row by
+   row */
+int mygsl_matrix_binop(gsl_matrix *out, const gsl_matrix *a, const gsl_matrix *b,
+		       int op)
+{
+  size_t i;
+  if (a->size1 != b->size1 || a->size2 != b->size2
+      || out->size1 != a->size1 || out->size2 != a->size2)
+    GSL_ERROR("matrices must have same dimensions", GSL_EBADLEN);
+  if (out->tda == out->size2 && a->tda == a->size2 && b->tda == b->size2) {
+    kernel_binop(out->data, 1, a->data, 1, b->data, 1, a->size1*a->size2, op);
+    return GSL_SUCCESS;
+  }
+  for (i = 0; i < a->size1; i++)
+    kernel_binop(out->data + i*out->tda, 1, a->data + i*a->tda, 1,
+		 b->data + i*b->tda, 1, a->size2, op);
+  return GSL_SUCCESS;
+}
+
+int mygsl_matrix_binop_const(gsl_matrix *out, const gsl_matrix *a, double c, int op)
+{
+  size_t i;
+  if (out->size1 != a->size1 || out->size2 != a->size2)
+    GSL_ERROR("matrices must have same dimensions", GSL_EBADLEN);
+  if (out->tda == out->size2 && a->tda == a->size2) {
+    kernel_binop_const(out->data, 1, a->data, 1, c, a->size1*a->size2, op);
+    return GSL_SUCCESS;
+  }
+  for (i = 0; i < a->size1; i++)
+    kernel_binop_const(out->data + i*out->tda, 1, a->data + i*a->tda, 1, c,
+		       a->size2, op);
+  return GSL_SUCCESS;
+}
@@ -0,0 +1,669 @@
+/*
+  array_mask.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Block::Bit, a boolean mask of one bit per element, and the fused
+  compare-select operations of GSL::Vector and GSL::Matrix:
+
+    m = v.mask(:gt, 0.5)            # :eq, :ne, :gt, :ge, :lt, :le
+    m.count; m.any?; m.all?; m.where
+    w = v.select(m)                 # or v.select(:gt, 0.5)
+    v.masked_set!(m, 0.0)           # or v.masked_set!(:gt, 0.5, x)
+    n = v.count(:gt, 0.5)
+
+  The second operand of a comparison is a number or a Vector (Matrix) of
+  the same size.  A mask of a Matrix numbers the elements row by row.
+  select and masked_set! also take the GSL::Block::Byte of v.gt(0.5) and
+  the like.  The elements are compared 64 at a time into a word, in a
+  branch-free loop of fixed length for unit-stride data, built also for
+  AVX2 (target_clones) where the compiler supports it; the fused forms use the word at once, without writing a mask, and
+  count, any?, all? and none? go by popcount over the words.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include <stdint.h>
+
+VALUE cgsl_block_bit;
+
+typedef struct {
+  size_t size;
+  uint64_t *data;
+} mygsl_bitmask;
+
+enum { MASK_EQ, MASK_NE, MASK_GT, MASK_GE, MASK_LT, MASK_LE };
+
+#define MASK_WORDS(n) (((n) + 63)/64)
+
+#if defined(__GNUC__)
+#define MASK_POPCOUNT(w) ((size_t) __builtin_popcountll(w))
+#define MASK_CTZ(w) ((size_t) __builtin_ctzll(w))
+#else
+static size_t MASK_POPCOUNT(uint64_t w)
+{
+  size_t c = 0;
+  for (; w; w &= w - 1) c++;
+  return c;
+}
+static size_t MASK_CTZ(uint64_t w)
+{
+  size_t c = 0;
+  while (!(w & 1)) { w >>= 1; c++; }
+  return c;
+}
+#endif
+
+static void mygsl_bitmask_free(mygsl_bitmask *m)
+{
+  if (m) {
+    free(m->data);
+    free(m);
+  }
+}
+
+static mygsl_bitmask* mygsl_bitmask_calloc(size_t n)
+{
+  mygsl_bitmask *m;
+  m = ALLOC(mygsl_bitmask);
+  m->size = n;
+  m->data = (uint64_t *) calloc(MASK_WORDS(n) ? MASK_WORDS(n) : 1, sizeof(uint64_t));
+  if (m->data == NULL) {
+    free(m);
+    rb_raise(rb_eNoMemError, "cannot allocate a mask of %d bits", (int) n);
+  }
+  return m;
+}
+
+static VALUE rb_gsl_bitmask_wrap(mygsl_bitmask *m)
+{
+  return Data_Wrap_Struct(cgsl_block_bit, 0, mygsl_bitmask_free, m);
+}
+
+static mygsl_bitmask* rb_gsl_get_bitmask(VALUE obj)
+{
+  mygsl_bitmask *m;
+  if (!rb_obj_is_kind_of(obj, cgsl_block_bit))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Block::Bit expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_bitmask, m);
+  return m;
+}
+
+/* the low n bits of the mask from bit pos on */
+static uint64_t mask_bits_get(const uint64_t *d, size_t pos, size_t n)
+{
+  size_t k = pos/64, s = pos%64;
+  uint64_t w = d[k] >> s;
+  if (s && s + n > 64) w |= d[k+1] << (64 - s);
+  return n == 64 ? w : w & (((uint64_t) 1 << n) - 1);
+}
+
+/* d must be zero at the n bits from pos on */
+static void mask_bits_put(uint64_t *d, size_t pos, uint64_t w, size_t n)
+{
+  size_t k = pos/64, s = pos%64;
+  d[k] |= w << s;
+  if (s && s + n > 64) d[k+1] |= w >> (64 - s);
+}
+
+/*****/
+
+/* A Vector or a Matrix as rows of cols elements, element (r, j) at
+   data[r*tda + j*stride]; a contiguous Matrix is one row. */
+typedef struct {
+  double *data;
+  size_t rows, cols, tda, stride;
+} mask_src;
+
+static int mask_src_get(VALUE obj, mask_src *s)
+{
+  gsl_vector *v;
+  gsl_matrix *m;
+  if (VECTOR_P(obj)) {
+    Data_Get_Struct(obj, gsl_vector, v);
+    s->data = v->data;
+    s->rows = 1;
+    s->cols = v->size;
+    s->tda = 0;
+    s->stride = v->stride;
+    return 1;
+  } else if (MATRIX_P(obj)) {
+    Data_Get_Struct(obj, gsl_matrix, m);
+    s->data = m->data;
+    s->stride = 1;
+    if (m->tda == m->size2 || m->size1 <= 1) {
+      s->rows = 1;
+      s->cols = m->size1*m->size2;
+      s->tda = 0;
+    } else {
+      s->rows = m->size1;
+      s->cols = m->size2;
+      s->tda = m->tda;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+static size_t mask_src_size(const mask_src *s)
+{
+  return s->rows*s->cols;
+}
+
+/* Element k (row by row) of an operand shaped differently in memory */
+static double* mask_src_ptr(const mask_src *s, size_t k)
+{
+  size_t r = s->rows == 1 ? 0 : k/s->cols, j = s->rows == 1 ? k : k%s->cols;
+  return s->data + r*s->tda + j*s->stride;
+}
+
+#define MASK_LOOP(cmp) do {						\
+    if (b == NULL && sa == 1) for (j = 0; j < n; j++) w |= (uint64_t) (a[j] cmp c) << j; \
+    else if (b == NULL) for (j = 0; j < n; j++) w |= (uint64_t) (a[j*sa] cmp c) << j; \
+    else if (sa == 1 && sb == 1) for (j = 0; j < n; j++) w |= (uint64_t) (a[j] cmp b[j]) << j; \
+    else for (j = 0; j < n; j++) w |= (uint64_t) (a[j*sa] cmp b[j*sb]) << j; \
+  } while (0)
+
+/* bit j of the word: a[j] op (b ? b[j] : c), n <= 64 */
+static uint64_t mask_word(int op, const double *a, size_t sa, const double *b, size_t sb,
+			  double c, size_t n)
+{
+  uint64_t w = 0;
+  size_t j;
+  switch (op) {
+  case MASK_EQ: MASK_LOOP(==); break;
+  case MASK_NE: MASK_LOOP(!=); break;
+  case MASK_GT: MASK_LOOP(>); break;
+  case MASK_GE: MASK_LOOP(>=); break;
+  case MASK_LT: MASK_LOOP(<); break;
+  case MASK_LE: MASK_LOOP(<=); break;
+  }
+  return w;
+}
+
+#undef MASK_LOOP
+
+#ifdef HAVE_ATTRIBUTE_TARGET_CLONES
+#define MASK_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define MASK_CLONES
+#endif
+
+#define MASK_LOOP64(cmp) do {						\
+    if (b == NULL) for (j = 0; j < 64; j++) w |= (uint64_t) (a[j] cmp c) << j; \
+    else for (j = 0; j < 64; j++) w |= (uint64_t) (a[j] cmp b[j]) << j; \
+  } while (0)
+
+/* the same for 64 unit-stride elements: a fixed trip count, which the
+   AVX2 clone turns into packed compares */
+MASK_CLONES
+static uint64_t mask_word64(int op, const double *a, const double *b, double c)
+{
+  uint64_t w = 0;
+  size_t j;
+  switch (op) {
+  case MASK_EQ: MASK_LOOP64(==); break;
+  case MASK_NE: MASK_LOOP64(!=); break;
+  case MASK_GT: MASK_LOOP64(>); break;
+  case MASK_GE: MASK_LOOP64(>=); break;
+  case MASK_LT: MASK_LOOP64(<); break;
+  case MASK_LE: MASK_LOOP64(<=); break;
+  }
+  return w;
+}
+
+#undef MASK_LOOP64
+
+/*
+  What selects the elements of a: a mask (Bit or Byte), or a comparison
+  of a with a number or an operand of the same shape.
+*/
+typedef struct {
+  const mask_src *a;
+  const mygsl_bitmask *bits;
+  const gsl_block_uchar *bytes;
+  int op;
+  double c;
+  mask_src b;
+  int has_b;
+} mask_cond;
+
+/* the word of the 64 (or fewer, n) elements of row r from column j0 on */
+static uint64_t mask_cond_word(const mask_cond *m, size_t r, size_t j0, size_t n)
+{
+  const mask_src *a = m->a;
+  size_t k = r*a->cols + j0, j;
+  uint64_t w = 0;
+  const double *pb = NULL;
+  if (m->bits) return mask_bits_get(m->bits->data, k, n);
+  if (m->bytes) {
+    for (j = 0; j < n; j++) w |= (uint64_t) (m->bytes->data[k + j] != 0) << j;
+    return w;
+  }
+  if (m->has_b) {
+    /* b is walked as a whole only when laid out like a */
+    if (m->b.rows == a->rows) {
+      pb = m->b.data + r*m->b.tda + j0*m->b.stride;
+    } else {
+      double tmp[64];
+      for (j = 0; j < n; j++) tmp[j] = *mask_src_ptr(&m->b, k + j);
+      return mask_word(m->op, a->data + r*a->tda + j0*a->stride, a->stride, tmp, 1, 0.0, n);
+    }
+  }
+  if (n == 64 && a->stride == 1 && (pb == NULL || m->b.stride == 1))
+    return mask_word64(m->op, a->data + r*a->tda + j0, pb, m->c);
+  return mask_word(m->op, a->data + r*a->tda + j0*a->stride, a->stride,
+		   pb, m->b.stride, m->c, n);
+}
+
+static int mask_op_from_symbol(VALUE sym)
+{
+  ID id;
+  if (!SYMBOL_P(sym)) rb_raise(rb_eTypeError, "comparison must be a Symbol (:eq, :ne, :gt, :ge, :lt or :le)");
+  id = SYM2ID(sym);
+  if (id == rb_intern("eq") || id == rb_intern("==")) return MASK_EQ;
+  if (id == rb_intern("ne") || id == rb_intern("!=")) return MASK_NE;
+  if (id == rb_intern("gt") || id == rb_intern(">")) return MASK_GT;
+  if (id == rb_intern("ge") || id == rb_intern(">=")) return MASK_GE;
+  if (id == rb_intern("lt") || id == rb_intern("<")) return MASK_LT;
+  if (id == rb_intern("le") || id == rb_intern("<=")) return MASK_LE;
+  rb_raise(rb_eArgError, "unknown comparison :%s", rb_id2name(id));
+  return -1;
+}
+
+/* argv[0] a mask, or argv[0], argv[1] a comparison; the number of
+   arguments taken */
+static int mask_cond_get(int argc, VALUE *argv, const mask_src *a, mask_cond *m)
+{
+  size_t n = mask_src_size(a);
+  memset(m, 0, sizeof(mask_cond));
+  m->a = a;
+  if (argc < 1) rb_raise(rb_eArgError, "too few arguments (a mask or a comparison expected)");
+  if (rb_obj_is_kind_of(argv[0], cgsl_block_bit)) {
+    m->bits = rb_gsl_get_bitmask(argv[0]);
+    if (m->bits->size != n)
+      rb_raise(rb_eArgError, "mask of %d bits (%d expected)", (int) m->bits->size, (int) n);
+    return 1;
+  }
+  if (BLOCK_UCHAR_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_block_uchar, m->bytes);
+    if (m->bytes->size != n)
+      rb_raise(rb_eArgError, "mask of %d bytes (%d expected)", (int) m->bytes->size, (int) n);
+    return 1;
+  }
+  if (argc < 2) rb_raise(rb_eArgError, "too few arguments (comparison and operand expected)");
+  m->op = mask_op_from_symbol(argv[0]);
+  if (mask_src_get(argv[1], &m->b)) {
+    if (mask_src_size(&m->b) != n)
+      rb_raise(rb_eArgError, "operand of size %d (%d expected)", (int) mask_src_size(&m->b), (int) n);
+    m->has_b = 1;
+  } else {
+    m->c = NUM2DBL(argv[1]);
+  }
+  return 2;
+}
+
+/*****/
+
+static void mygsl_mask_build(const mask_cond *m, mygsl_bitmask *out)
+{
+  const mask_src *a = m->a;
+  size_t r, j0, n;
+  for (r = 0; r < a->rows; r++) {
+    for (j0 = 0; j0 < a->cols; j0 += 64) {
+      n = GSL_MIN(64, a->cols - j0);
+      mask_bits_put(out->data, r*a->cols + j0, mask_cond_word(m, r, j0, n), n);
+    }
+  }
+}
+
+static size_t mygsl_mask_count(const mask_cond *m)
+{
+  const mask_src *a = m->a;
+  size_t r, j0, c = 0;
+  for (r = 0; r < a->rows; r++)
+    for (j0 = 0; j0 < a->cols; j0 += 64)
+      c += MASK_POPCOUNT(mask_cond_word(m, r, j0, GSL_MIN(64, a->cols - j0)));
+  return c;
+}
+
+static void mygsl_mask_select(const mask_cond *m, double *out)
+{
+  const mask_src *a = m->a;
+  const double *row;
+  size_t r, j0, k = 0;
+  uint64_t w;
+  for (r = 0; r < a->rows; r++) {
+    row = a->data + r*a->tda;
+    for (j0 = 0; j0 < a->cols; j0 += 64) {
+      w = mask_cond_word(m, r, j0, GSL_MIN(64, a->cols - j0));
+      for (; w; w &= w - 1) out[k++] = row[(j0 + MASK_CTZ(w))*a->stride];
+    }
+  }
+}
+
+/* a[k] = x (or x[k]) where the condition holds */
+static void mygsl_mask_set(const mask_cond *m, const mask_src *x, double c)
+{
+  const mask_src *a = m->a;
+  double *row;
+  size_t r, j0, j;
+  uint64_t w;
+  for (r = 0; r < a->rows; r++) {
+    row = a->data + r*a->tda;
+    for (j0 = 0; j0 < a->cols; j0 += 64) {
+      w = mask_cond_word(m, r, j0, GSL_MIN(64, a->cols - j0));
+      for (; w; w &= w - 1) {
+	j = j0 + MASK_CTZ(w);
+	row[j*a->stride] = x ? *mask_src_ptr(x, r*a->cols + j) : c;
+      }
+    }
+  }
+}
+
+/*****/
+
+/* v.mask(op, b), m.mask(op, b) */
+static VALUE rb_gsl_array_mask(VALUE obj, VALUE op, VALUE bb)
+{
+  mask_src a;
+  mask_cond m;
+  mygsl_bitmask *out;
+  VALUE argv[2];
+  mask_src_get(obj, &a);
+  argv[0] = op;
+  argv[1] = bb;
+  if (!SYMBOL_P(op)) rb_raise(rb_eTypeError, "comparison must be a Symbol (:eq, :ne, :gt, :ge, :lt or :le)");
+  mask_cond_get(2, argv, &a, &m);
+  out = mygsl_bitmask_calloc(mask_src_size(&a));
+  mygsl_mask_build(&m, out);
+  return rb_gsl_bitmask_wrap(out);
+}
+
+/* v.count(mask), v.count(op, b) */
+static VALUE rb_gsl_array_mask_count(int argc, VALUE *argv, VALUE obj)
+{
+  mask_src a;
+  mask_cond m;
+  mask_src_get(obj, &a);
+  if (mask_cond_get(argc, argv, &a, &m) != argc)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d)", argc);
+  return SIZET2NUM(mygsl_mask_count(&m));
+}
+
+/* v.select(mask), v.select(op, b): a new Vector of the elements chosen,
+   nil if none (as Vector#where) */
+static VALUE rb_gsl_array_select(int argc, VALUE *argv, VALUE obj)
+{
+  mask_src a;
+  mask_cond m;
+  gsl_vector *v;
+  size_t n;
+  mask_src_get(obj, &a);
+  if (mask_cond_get(argc, argv, &a, &m) != argc)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d)", argc);
+  n = mygsl_mask_count(&m);
+  if (n == 0) return Qnil;
+  v = gsl_vector_alloc(n);
+  mygsl_mask_select(&m, v->data);
+  return Data_Wrap_Struct(VECTOR_P(obj) ? VECTOR_ROW_COL(CLASS_OF(obj)) : cgsl_vector,
+			  0, gsl_vector_free, v);
+}
+
+/* v.masked_set!(mask, x), v.masked_set!(op, b, x): x a number or an
+   operand of the same size */
+static VALUE rb_gsl_array_masked_set(int argc, VALUE *argv, VALUE obj)
+{
+  mask_src a, x;
+  mask_cond m;
+  int k;
+  rb_check_frozen(obj);
+  mask_src_get(obj, &a);
+  k = mask_cond_get(argc, argv, &a, &m);
+  if (argc != k + 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for %d)", argc, k + 1);
+  if (mask_src_get(argv[k], &x)) {
+    if (mask_src_size(&x) != mask_src_size(&a))
+      rb_raise(rb_eArgError, "operand of size %d (%d expected)", (int) mask_src_size(&x),
+	       (int) mask_src_size(&a));
+    mygsl_mask_set(&m, &x, 0.0);
+  } else {
+    mygsl_mask_set(&m, NULL, NUM2DBL(argv[k]));
+  }
+  return obj;
+}
+
+/*****/
+
+static VALUE rb_gsl_block_bit_alloc(VALUE klass, VALUE nn)
+{
+  long n = NUM2LONG(nn);
+  if (n < 0) rb_raise(rb_eArgError, "negative size");
+  return rb_gsl_bitmask_wrap(mygsl_bitmask_calloc((size_t) n));
+}
+
+static VALUE rb_gsl_block_bit_size(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_get_bitmask(obj)->size);
+}
+
+static size_t bit_index(const mygsl_bitmask *m, VALUE ii)
+{
+  long i = NUM2LONG(ii);
+  if (i < 0) i += (long) m->size;
+  if (i < 0 || (size_t) i >= m->size) rb_raise(rb_eIndexError, "index %ld out of range", NUM2LONG(ii));
+  return (size_t) i;
+}
+
+static VALUE rb_gsl_block_bit_get(VALUE obj, VALUE ii)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  size_t i = bit_index(m, ii);
+  return (m->data[i/64] >> (i%64)) & 1 ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_block_bit_set(VALUE obj, VALUE ii, VALUE x)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  size_t i = bit_index(m, ii);
+  rb_check_frozen(obj);
+  if (RTEST(x) && !(FIXNUM_P(x) && FIX2INT(x) == 0)) m->data[i/64] |= (uint64_t) 1 << (i%64);
+  else m->data[i/64] &= ~((uint64_t) 1 << (i%64));
+  return x;
+}
+
+static size_t mygsl_bitmask_count(const mygsl_bitmask *m)
+{
+  size_t k, c = 0;
+  for (k = 0; k < MASK_WORDS(m->size); k++) c += MASK_POPCOUNT(m->data[k]);
+  return c;
+}
+
+static VALUE rb_gsl_block_bit_count(VALUE obj)
+{
+  return SIZET2NUM(mygsl_bitmask_count(rb_gsl_get_bitmask(obj)));
+}
+
+static VALUE rb_gsl_block_bit_any(VALUE obj)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  size_t k;
+  for (k = 0; k < MASK_WORDS(m->size); k++) if (m->data[k]) return Qtrue;
+  return Qfalse;
+}
+
+static VALUE rb_gsl_block_bit_none(VALUE obj)
+{
+  return rb_gsl_block_bit_any(obj) == Qtrue ? Qfalse : Qtrue;
+}
+
+static VALUE rb_gsl_block_bit_all(VALUE obj)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  return mygsl_bitmask_count(m) == m->size ? Qtrue : Qfalse;
+}
+
+/* the Index of the bits set, nil if none (as Vector#where) */
+static VALUE rb_gsl_block_bit_where(VALUE obj)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  gsl_index *p;
+  size_t k, j = 0, n = mygsl_bitmask_count(m);
+  uint64_t w;
+  if (n == 0) return Qnil;
+  p = gsl_permutation_alloc(n);
+  for (k = 0; k < MASK_WORDS(m->size); k++)
+    for (w = m->data[k]; w; w &= w - 1) p->data[j++] = 64*k + MASK_CTZ(w);
+  return Data_Wrap_Struct(cgsl_index, 0, gsl_permutation_free, p);
+}
+
+enum { BIT_AND, BIT_OR, BIT_XOR };
+
+static VALUE rb_gsl_block_bit_logic(VALUE obj, VALUE other, int op)
+{
+  mygsl_bitmask *a = rb_gsl_get_bitmask(obj), *b = rb_gsl_get_bitmask(other), *c;
+  size_t k;
+  if (a->size != b->size)
+    rb_raise(rb_eArgError, "masks of different sizes (%d and %d)", (int) a->size, (int) b->size);
+  c = mygsl_bitmask_calloc(a->size);
+  for (k = 0; k < MASK_WORDS(a->size); k++) {
+    switch (op) {
+    case BIT_AND: c->data[k] = a->data[k] & b->data[k]; break;
+    case BIT_OR: c->data[k] = a->data[k] | b->data[k]; break;
+    case BIT_XOR: c->data[k] = a->data[k] ^ b->data[k]; break;
+    }
+  }
+  return rb_gsl_bitmask_wrap(c);
+}
+
+static VALUE rb_gsl_block_bit_and(VALUE obj, VALUE other)
+{
+  return rb_gsl_block_bit_logic(obj, other, BIT_AND);
+}
+
+static VALUE rb_gsl_block_bit_or(VALUE obj, VALUE other)
+{
+  return rb_gsl_block_bit_logic(obj, other, BIT_OR);
+}
+
+static VALUE rb_gsl_block_bit_xor(VALUE obj, VALUE other)
+{
+  return rb_gsl_block_bit_logic(obj, other, BIT_XOR);
+}
+
+static VALUE rb_gsl_block_bit_not(VALUE obj)
+{
+  mygsl_bitmask *a = rb_gsl_get_bitmask(obj), *c;
+  size_t k, nw = MASK_WORDS(a->size);
+  c = mygsl_bitmask_calloc(a->size);
+  for (k = 0; k < nw; k++) c->data[k] = ~a->data[k];
+  /* the bits past the end stay clear */
+  if (a->size % 64) c->data[nw-1] &= ((uint64_t) 1 << (a->size % 64)) - 1;
+  return rb_gsl_bitmask_wrap(c);
+}
+
+static VALUE rb_gsl_block_bit_equal(VALUE obj, VALUE other)
+{
+  mygsl_bitmask *a, *b;
+  if (!rb_obj_is_kind_of(other, cgsl_block_bit)) return Qfalse;
+  a = rb_gsl_get_bitmask(obj);
+  b = rb_gsl_get_bitmask(other);
+  if (a->size != b->size) return Qfalse;
+  return memcmp(a->data, b->data, sizeof(uint64_t)*MASK_WORDS(a->size)) ? Qfalse : Qtrue;
+}
+
+/* mask.to_byte: the GSL::Block::Byte of one byte per element */
+static VALUE rb_gsl_block_bit_to_byte(VALUE obj)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  gsl_block_uchar *b;
+  size_t i;
+  b = gsl_block_uchar_alloc(m->size ? m->size : 1);
+  b->size = m->size;
+  for (i = 0; i < m->size; i++) b->data[i] = (m->data[i/64] >> (i%64)) & 1;
+  return Data_Wrap_Struct(cgsl_block_uchar, 0, gsl_block_uchar_free, b);
+}
+
+/* Block::Byte#to_bit */
+static VALUE rb_gsl_block_uchar_to_bit(VALUE obj)
+{
+  gsl_block_uchar *b;
+  mygsl_bitmask *m;
+  size_t i;
+  Data_Get_Struct(obj, gsl_block_uchar, b);
+  m = mygsl_bitmask_calloc(b->size);
+  for (i = 0; i < b->size; i++) m->data[i/64] |= (uint64_t) (b->data[i] != 0) << (i%64);
+  return rb_gsl_bitmask_wrap(m);
+}
+
+static VALUE rb_gsl_block_bit_to_a(VALUE obj)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  VALUE ary;
+  size_t i;
+  ary = rb_ary_new2(m->size);
+  for (i = 0; i < m->size; i++)
+    rb_ary_store(ary, i, (m->data[i/64] >> (i%64)) & 1 ? Qtrue : Qfalse);
+  return ary;
+}
+
+static VALUE rb_gsl_block_bit_inspect(VALUE obj)
+{
+  mygsl_bitmask *m = rb_gsl_get_bitmask(obj);
+  VALUE str;
+  size_t i, n = GSL_MIN(m->size, 64);
+  str = rb_str_new2(rb_class2name(CLASS_OF(obj)));
+  rb_str_cat2(str, "\n[ ");
+  for (i = 0; i < n; i++) rb_str_cat2(str, (m->data[i/64] >> (i%64)) & 1 ? "1" : "0");
+  if (n < m->size) rb_str_cat2(str, " ...");
+  rb_str_cat2(str, " ]");
+  return str;
+}
+
+void Init_gsl_array_mask(VALUE module)
+{
+  cgsl_block_bit = rb_define_class_under(cgsl_block, "Bit", cGSL_Object);
+  rb_define_singleton_method(cgsl_block_bit, "alloc", rb_gsl_block_bit_alloc, 1);
+  rb_define_singleton_method(cgsl_block_bit, "new", rb_gsl_block_bit_alloc, 1);
+  rb_define_singleton_method(cgsl_block_bit, "calloc", rb_gsl_block_bit_alloc, 1);
+  rb_define_method(cgsl_block_bit, "size", rb_gsl_block_bit_size, 0);
+  rb_define_alias(cgsl_block_bit, "length", "size");
+  rb_define_method(cgsl_block_bit, "get", rb_gsl_block_bit_get, 1);
+  rb_define_alias(cgsl_block_bit, "[]", "get");
+  rb_define_method(cgsl_block_bit, "set", rb_gsl_block_bit_set, 2);
+  rb_define_alias(cgsl_block_bit, "[]=", "set");
+  rb_define_method(cgsl_block_bit, "count", rb_gsl_block_bit_count, 0);
+  rb_define_method(cgsl_block_bit, "any?", rb_gsl_block_bit_any, 0);
+  rb_define_method(cgsl_block_bit, "all?", rb_gsl_block_bit_all, 0);
+  rb_define_method(cgsl_block_bit, "none?", rb_gsl_block_bit_none, 0);
+  rb_define_method(cgsl_block_bit, "where", rb_gsl_block_bit_where, 0);
+  rb_define_method(cgsl_block_bit, "and", rb_gsl_block_bit_and, 1);
+  rb_define_alias(cgsl_block_bit, "&", "and");
+  rb_define_method(cgsl_block_bit, "or", rb_gsl_block_bit_or, 1);
+  rb_define_alias(cgsl_block_bit, "|", "or");
+  rb_define_method(cgsl_block_bit, "xor", rb_gsl_block_bit_xor, 1);
+  rb_define_alias(cgsl_block_bit, "^", "xor");
+  rb_define_method(cgsl_block_bit, "not", rb_gsl_block_bit_not, 0);
+  rb_define_alias(cgsl_block_bit, "~", "not");
+  rb_define_method(cgsl_block_bit, "==", rb_gsl_block_bit_equal, 1);
+  rb_define_method(cgsl_block_bit, "to_byte", rb_gsl_block_bit_to_byte, 0);
+  rb_define_method(cgsl_block_bit, "to_a", rb_gsl_block_bit_to_a, 0);
+  rb_define_method(cgsl_block_bit, "inspect", rb_gsl_block_bit_inspect, 0);
+  rb_define_method(cgsl_block_uchar, "to_bit", rb_gsl_block_uchar_to_bit, 0);
+
+  rb_define_method(cgsl_vector, "mask", rb_gsl_array_mask, 2);
+  rb_define_method(cgsl_vector, "count", rb_gsl_array_mask_count, -1);
+  rb_define_method(cgsl_vector, "select", rb_gsl_array_select, -1);
+  rb_define_method(cgsl_vector, "masked_set!", rb_gsl_array_masked_set, -1);
+  rb_define_method(cgsl_matrix, "mask", rb_gsl_array_mask, 2);
+  rb_define_method(cgsl_matrix, "count", rb_gsl_array_mask_count, -1);
+  rb_define_method(cgsl_matrix, "select", rb_gsl_array_select, -1);
+  rb_define_method(cgsl_matrix, "masked_set!", rb_gsl_array_masked_set, -1);
+}
@@ -0,0 +1,222 @@
+/*
+  array_mmap.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Vector.mmap and GSL::Matrix.mmap: vectors and matrices whose data
+  is a memory mapping of a file of native doubles (the format written by
+  Vector#fwrite and Matrix#fwrite), instead of a heap block filled by
+  fread.  Pages are read on first access.
+
+    v = GSL::Vector.mmap("series.dat", :offset => 8*1024, :size => 1000)
+    m = GSL::Matrix.mmap("grid.dat", :size2 => 256, :mode => "r+")
+
+  Options:
+    :offset  byte offset of the first element, a multiple of 8 (default 0)
+    :size    number of elements (Vector, default: up to the end of file)
+    :size1, :size2
+             rows and columns (Matrix; :size2 is required, :size1
+             defaults to as many rows as the file holds)
+    :mode    "r"  (default) private mapping: the pages are shared with
+                  the file and with forked processes until written, and
+                  writes are never carried to the file
+             "r+" shared mapping: writes go to the file
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct mmap_region {
+  void *addr;
+  size_t len;
+};
+
+/* The gsl_vector (gsl_matrix) comes first, so that the pointer wrapped in
+   the Ruby object is also the address of the whole record */
+typedef struct {
+  gsl_vector v;
+  gsl_block b;
+  struct mmap_region r;
+} mmap_vector;
+
+typedef struct {
+  gsl_matrix m;
+  gsl_block b;
+  struct mmap_region r;
+} mmap_matrix;
+
+static void mmap_vector_free(mmap_vector *p)
+{
+  munmap(p->r.addr, p->r.len);
+  free(p);
+}
+
+static void mmap_matrix_free(mmap_matrix *p)
+{
+  munmap(p->r.addr, p->r.len);
+  free(p);
+}
+
+static VALUE mmap_opt(VALUE opts, const char *key)
+{
+  if (NIL_P(opts)) return Qnil;
+  return rb_hash_aref(opts, ID2SYM(rb_intern(key)));
+}
+
+static int mmap_shared(VALUE opts)
+{
+  VALUE mode = mmap_opt(opts, "mode");
+  const char *s;
+  if (NIL_P(mode)) return 0;
+  if (SYMBOL_P(mode)) mode = rb_funcall(mode, rb_intern("to_s"), 0);
+  s = StringValuePtr(mode);
+  if (strcmp(s, "r") == 0) return 0;
+  if (strcmp(s, "r+") == 0) return 1;
+  rb_raise(rb_eArgError, "unknown mode \"%s\" (\"r\" or \"r+\" expected)", s);
+  return 0;
+}
+
+/* Maps n elements (all of the remaining file if *n is 0) of the file path
+   starting at byte offset; returns the address of the first element */
+static double* mmap_file(VALUE path, VALUE opts, size_t *n, size_t unit,
+			 struct mmap_region *r)
+{
+  VALUE voff = mmap_opt(opts, "offset");
+  size_t offset = NIL_P(voff) ? 0 : NUM2SIZET(voff), delta, avail;
+  long pagesize = sysconf(_SC_PAGESIZE);
+  int shared = mmap_shared(opts), fd;
+  struct stat st;
+  void *addr;
+  const char *name;
+  name = StringValuePtr(path);
+  if (offset % sizeof(double))
+    rb_raise(rb_eArgError, "offset must be a multiple of %d", (int) sizeof(double));
+  fd = open(name, shared ? O_RDWR : O_RDONLY);
+  if (fd < 0) rb_sys_fail(name);
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    rb_sys_fail(name);
+  }
+  avail = (size_t) st.st_size > offset ? ((size_t) st.st_size - offset)/sizeof(double) : 0;
+  if (*n == 0) *n = avail/unit*unit;
+  if (*n == 0 || *n > avail) {
+    close(fd);
+    rb_raise(rb_eRangeError, "%s: file too short for the requested size", name);
+  }
+  delta = offset % (size_t) pagesize;
+  r->len = delta + *n*sizeof(double);
+  addr = mmap(NULL, r->len, PROT_READ | PROT_WRITE,
+	      shared ? MAP_SHARED : MAP_PRIVATE, fd, (off_t) (offset - delta));
+  close(fd);
+  if (addr == MAP_FAILED) rb_sys_fail(name);
+  r->addr = addr;
+  return (double*) ((char*) addr + delta);
+}
+
+static VALUE mmap_opts(int argc, VALUE *argv)
+{
+  VALUE opts = Qnil;
+  switch (argc) {
+  case 1: break;
+  case 2:
+    opts = argv[1];
+    Check_Type(opts, T_HASH);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  return opts;
+}
+
+static VALUE rb_gsl_vector_mmap(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = mmap_opts(argc, argv), vsize;
+  struct mmap_region r;
+  mmap_vector *p;
+  double *data;
+  size_t n;
+  vsize = mmap_opt(opts, "size");
+  n = NIL_P(vsize) ? 0 : NUM2SIZET(vsize);
+  if (!NIL_P(vsize) && n == 0) rb_raise(rb_eArgError, "size must be positive");
+  data = mmap_file(argv[0], opts, &n, 1, &r);
+  p = (mmap_vector*) malloc(sizeof(mmap_vector));
+  if (p == NULL) {
+    munmap(r.addr, r.len);
+    rb_raise(rb_eNoMemError, "malloc failed");
+  }
+  p->b.size = n;
+  p->b.data = data;
+  p->v.size = n;
+  p->v.stride = 1;
+  p->v.data = data;
+  p->v.block = &p->b;
+  p->v.owner = 0;
+  p->r = r;
+  return Data_Wrap_Struct(cgsl_vector, 0, mmap_vector_free, &p->v);
+}
+
+static VALUE rb_gsl_matrix_mmap(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = mmap_opts(argc, argv), vsize1, vsize2;
+  struct mmap_region r;
+  mmap_matrix *p;
+  double *data;
+  size_t size1, size2, n;
+  vsize1 = mmap_opt(opts, "size1");
+  vsize2 = mmap_opt(opts, "size2");
+  if (NIL_P(vsize2)) rb_raise(rb_eArgError, ":size2 must be given");
+  size2 = NUM2SIZET(vsize2);
+  size1 = NIL_P(vsize1) ? 0 : NUM2SIZET(vsize1);
+  if (size2 == 0 || (!NIL_P(vsize1) && size1 == 0))
+    rb_raise(rb_eArgError, "matrix dimensions must be positive");
+  n = size1*size2;
+  data = mmap_file(argv[0], opts, &n, size2, &r);
+  p = (mmap_matrix*) malloc(sizeof(mmap_matrix));
+  if (p == NULL) {
+    munmap(r.addr, r.len);
+    rb_raise(rb_eNoMemError, "malloc failed");
+  }
+  p->b.size = n;
+  p->b.data = data;
+  p->m.size1 = n/size2;
+  p->m.size2 = size2;
+  p->m.tda = size2;
+  p->m.data = data;
+  p->m.block = &p->b;
+  p->m.owner = 0;
+  p->r = r;
+  return Data_Wrap_Struct(cgsl_matrix, 0, mmap_matrix_free, &p->m);
+}
+#else
+static VALUE rb_gsl_vector_mmap(int argc, VALUE *argv, VALUE klass)
+{
+  rb_raise(rb_eNotImpError, "mmap is not available on this platform");
+  return Qnil;
+}
+
+static VALUE rb_gsl_matrix_mmap(int argc, VALUE *argv, VALUE klass)
+{
+  rb_raise(rb_eNotImpError, "mmap is not available on this platform");
+  return Qnil;
+}
+#endif
+
+void Init_gsl_array_mmap(VALUE module)
+{
+  rb_define_singleton_method(cgsl_vector, "mmap", rb_gsl_vector_mmap, -1);
+  rb_define_singleton_method(cgsl_matrix, "mmap", rb_gsl_matrix_mmap, -1);
+}
@@ -0,0 +1,509 @@
+/*
+  array_text.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Matrix.loadtxt and GSL::Vector.loadtxt: numeric text and CSV
+  files read in one pass over a memory mapping of the file (read into
+  memory where mmap is not available).  The file is cut at line
+  boundaries into one chunk per thread (GSL.parallel_threads, for files
+  of at least GSL.parallel_threshold bytes); the rows of each chunk are
+  counted, then parsed into their place in the result, without the GVL.
+
+    m = GSL::Matrix.loadtxt("data.csv", :delimiter => ",", :header => true)
+    t, y = GSL::Vector.loadtxt("series.txt", :columns => [0, 3])
+
+  Options:
+    :delimiter  a one-character String; by default the fields are
+                separated by blanks, a comma or both
+    :header     true to skip the first line, or the number of lines
+    :columns    the indices of the columns to keep, in the order wanted
+                (default: all the columns of the first row)
+    :comments   the character starting a comment, to the end of the
+                line (default "#"; nil for none)
+
+  Blank and comment lines are skipped.  An empty field (two delimiters
+  in a row) reads as NaN, as do "nan" and "NaN"; "inf" and "Infinity"
+  are read too.  Every row must have as many fields as the first one.
+  Numbers with up to 15 significant digits and a decimal exponent of at
+  most 22 in magnitude are converted exactly with one multiplication or
+  division; the others go through strtod.  Quoted fields are not
+  supported.
+
+  GSL::Vector.filescan(path) is GSL::Vector.loadtxt(path).
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#define TEXT_CHUNK (1 << 16)
+
+enum {
+  TEXT_OK = 0,
+  TEXT_NCOLS,
+  TEXT_NUMBER,
+  TEXT_NOMEM
+};
+
+struct text_chunk {
+  const char *p, *end;
+  size_t rows, lines;         /* data rows and lines, counted in pass 1 */
+  size_t row0;                /* index of the first row */
+  int err;                    /* first error of the chunk */
+  size_t err_line, err_fields;
+};
+
+struct text_task {
+  const char *buf;
+  size_t len;
+  char delim, comment;
+  size_t nfields;             /* fields per row */
+  const long *map;            /* field -> output column, or -1 */
+  double **base;              /* element (i, j) at base[j][i*rstride] */
+  size_t rstride;
+  struct text_chunk *chunks;
+  size_t nchunks;
+};
+
+static const double text_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int text_blank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* The end of the line starting at p */
+static const char* text_eol(const char *p, const char *end)
+{
+  const char *q = memchr(p, '\n', end - p);
+  return q ? q : end;
+}
+
+/* Whether the line [p, e) holds data */
+static int text_data_line(const char *p, const char *e, char comment)
+{
+  while (p < e && text_blank(*p)) p++;
+  return p < e && *p != comment;
+}
+
+/* Converts the token [s, e); 0 when it is not a number */
+static int text_number(const char *s, const char *e, double *x)
+{
+  const char *p = s;
+  uint64_t m = 0;
+  int neg = 0, nd = 0, digits = 0, ex = 0, eneg = 0, ee = 0;
+  char buf[64], *tmp, *q;
+  size_t len;
+  if (p < e && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+  for (; p < e && *p >= '0' && *p <= '9'; p++, digits++) {
+    if (m == 0 && *p == '0') continue;
+    if (nd < 19) m = 10*m + (uint64_t) (*p - '0');
+    else ex++;
+    nd++;
+  }
+  if (p < e && *p == '.') {
+    for (p++; p < e && *p >= '0' && *p <= '9'; p++, digits++) {
+      if (m == 0 && *p == '0') { ex--; continue; }
+      if (nd < 19) { m = 10*m + (uint64_t) (*p - '0'); ex--; }
+      nd++;
+    }
+  }
+  if (digits > 0 && p < e && (*p == 'e' || *p == 'E')) {
+    const char *q0 = p++;
+    if (p < e && (*p == '-' || *p == '+')) eneg = (*p++ == '-');
+    if (p == e || *p < '0' || *p > '9') p = q0;
+    else for (; p < e && *p >= '0' && *p <= '9'; p++) if (ee < 10000) ee = 10*ee + (*p - '0');
+  }
+  if (digits > 0 && p == e) {
+    ex += eneg ? -ee : ee;
+    if (nd <= 15 && ex >= -22 && ex <= 22) {
+      *x = ex < 0 ? (double) m/text_pow10[-ex] : (double) m*text_pow10[ex];
+      if (neg) *x = -*x;
+      return 1;
+    }
+  }
+  /* many digits, large exponents, nan and inf */
+  len = e - s;
+  tmp = len < sizeof(buf) ? buf : malloc(len + 1);
+  if (tmp == NULL) return 0;
+  memcpy(tmp, s, len);
+  tmp[len] = '\0';
+  *x = strtod(tmp, &q);
+  digits = (len > 0 && q == tmp + len);
+  if (tmp != buf) free(tmp);
+  return digits;
+}
+
+/* Splits the line [p, e) into its fields, stores those to keep in
+   *dst[column] (unless dst is NULL) and returns the number of fields;
+   *bad is set if one is not a number */
+static size_t text_fields(const struct text_task *t, const char *p, const char *e,
+                          double *const *dst, int *bad)
+{
+  size_t f = 0;
+  const char *s, *q;
+  double x;
+  if (t->comment) for (q = p; q < e; q++) if (*q == t->comment) { e = q; break; }
+  while (e > p && text_blank(e[-1])) e--;
+  while (p < e && text_blank(*p)) p++;
+  if (p == e) return 0;
+  for (;;) {
+    if (t->delim) {
+      for (s = p; p < e && *p != t->delim; p++);
+      q = p;
+      while (s < q && text_blank(*s)) s++;
+      while (q > s && text_blank(q[-1])) q--;
+    } else {
+      for (s = p; p < e && !text_blank(*p) && *p != ','; p++);
+      q = p;
+      while (p < e && text_blank(*p)) p++;
+    }
+    if (dst && f < t->nfields && t->map[f] >= 0) {
+      if (s == q) x = GSL_NAN;
+      else if (!text_number(s, q, &x)) *bad = 1;
+      *dst[t->map[f]] = x;
+    }
+    f++;
+    if (p == e) break;
+    /* after a trailing delimiter, p == e makes one more empty field */
+    if (t->delim || *p == ',') {
+      p++;
+      if (!t->delim) while (p < e && text_blank(*p)) p++;
+    }
+  }
+  return f;
+}
+
+static int text_count(void *data, size_t k)
+{
+  struct text_task *t = (struct text_task *) data;
+  struct text_chunk *c = t->chunks + k;
+  const char *p = c->p, *e;
+  for (c->rows = c->lines = 0; p < c->end; p = e + 1, c->lines++) {
+    e = text_eol(p, c->end);
+    if (text_data_line(p, e, t->comment)) c->rows++;
+  }
+  return GSL_SUCCESS;
+}
+
+static int text_count_serial(void *data)
+{
+  struct text_task *t = (struct text_task *) data;
+  size_t k;
+  for (k = 0; k < t->nchunks; k++) text_count(data, k);
+  return GSL_SUCCESS;
+}
+
+static int text_parse(void *data, size_t k)
+{
+  struct text_task *t = (struct text_task *) data;
+  struct text_chunk *c = t->chunks + k;
+  const char *p = c->p, *e;
+  double *dst[256], **d = dst;
+  size_t i = c->row0, line = 0, j, n, ncols = 0;
+  int bad;
+  for (j = 0; j < t->nfields; j++) if (t->map[j] >= 0) ncols++;
+  if (ncols > 256 && (d = malloc(ncols*sizeof(double *))) == NULL) {
+    c->err = TEXT_NOMEM;
+    return GSL_SUCCESS;
+  }
+  c->err = TEXT_OK;
+  for (; p < c->end; p = e + 1, line++) {
+    e = text_eol(p, c->end);
+    if (!text_data_line(p, e, t->comment)) continue;
+    for (j = 0; j < ncols; j++) d[j] = t->base[j] + i*t->rstride;
+    bad = 0;
+    n = text_fields(t, p, e, d, &bad);
+    if (n != t->nfields || bad) {
+      c->err = bad ? TEXT_NUMBER : TEXT_NCOLS;
+      c->err_line = line;
+      c->err_fields = n;
+      break;
+    }
+    i++;
+  }
+  if (d != dst) free(d);
+  return GSL_SUCCESS;
+}
+
+static int text_parse_serial(void *data)
+{
+  struct text_task *t = (struct text_task *) data;
+  size_t k;
+  for (k = 0; k < t->nchunks; k++) text_parse(data, k);
+  return GSL_SUCCESS;
+}
+
+static void text_run(struct text_task *t, int (*worker)(void *, size_t),
+                     int (*serial)(void *))
+{
+  if (t->nchunks > 1) rb_gsl_nogvl_parallel(worker, t, t->nchunks);
+  else rb_gsl_nogvl_call(serial, t, t->len);
+}
+
+struct text_file {
+  char *addr;
+  size_t len;
+  int mapped;
+};
+
+static void text_open(VALUE path, struct text_file *f)
+{
+  const char *name = StringValueCStr(path);
+  struct stat st;
+  int fd = open(name, O_RDONLY);
+  if (fd < 0) rb_sys_fail(name);
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    rb_sys_fail(name);
+  }
+  f->len = (size_t) st.st_size;
+  f->mapped = 0;
+  f->addr = NULL;
+  if (f->len == 0) {
+    close(fd);
+    rb_raise(rb_eArgError, "%s: empty file", name);
+  }
+#ifdef HAVE_SYS_MMAN_H
+  f->addr = mmap(NULL, f->len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (f->addr != MAP_FAILED) {
+    f->mapped = 1;
+#ifdef MADV_SEQUENTIAL
+    madvise(f->addr, f->len, MADV_SEQUENTIAL);
+#endif
+    close(fd);
+    return;
+  }
+  f->addr = NULL;
+#endif
+  {
+    size_t got = 0;
+    ssize_t r;
+    f->addr = ALLOC_N(char, f->len);
+    while (got < f->len && (r = read(fd, f->addr + got, f->len - got)) > 0) got += r;
+    close(fd);
+    f->len = got;
+  }
+}
+
+static VALUE text_close(VALUE arg)
+{
+  struct text_file *f = (struct text_file *) arg;
+#ifdef HAVE_SYS_MMAN_H
+  if (f->mapped) {
+    munmap(f->addr, f->len);
+    return Qnil;
+  }
+#endif
+  xfree(f->addr);
+  return Qnil;
+}
+
+static VALUE text_opt(VALUE opts, const char *key)
+{
+  if (NIL_P(opts)) return Qnil;
+  return rb_hash_aref(opts, ID2SYM(rb_intern(key)));
+}
+
+/* def when the key is absent, '\0' for nil */
+static char text_char_opt(VALUE opts, const char *key, char def)
+{
+  VALUE v;
+  if (NIL_P(opts)) return def;
+  v = rb_hash_lookup2(opts, ID2SYM(rb_intern(key)), Qundef);
+  if (v == Qundef) return def;
+  if (NIL_P(v)) return '\0';
+  StringValue(v);
+  if (RSTRING_LEN(v) != 1)
+    rb_raise(rb_eArgError, ":%s must be a single character", key);
+  return RSTRING_PTR(v)[0];
+}
+
+struct text_load {
+  VALUE path, opts, klass;
+  int vectors;
+  struct text_file f;
+};
+
+static VALUE text_load_body(VALUE arg)
+{
+  struct text_load *l = (struct text_load *) arg;
+  struct text_task t;
+  struct text_chunk *c;
+  VALUE vh, vcols, ary = Qnil, vbase, vmap, vchunks, result;
+  const char *p, *end, *e, *first = NULL;
+  size_t skip = 0, lines0 = 0, ncols, i, j, k, rows, nthreads;
+  long *map;
+  gsl_matrix *m = NULL;
+  gsl_vector *v;
+
+  t.delim = text_char_opt(l->opts, "delimiter", '\0');
+  t.comment = text_char_opt(l->opts, "comments", '#');
+  if (t.delim == '\n' || (t.delim && t.delim == t.comment))
+    rb_raise(rb_eArgError, "bad delimiter");
+  vh = text_opt(l->opts, "header");
+  if (vh == Qtrue) skip = 1;
+  else if (RTEST(vh)) {
+    if (NUM2LONG(vh) < 0) rb_raise(rb_eArgError, ":header must not be negative");
+    skip = NUM2SIZET(vh);
+  }
+
+  text_open(l->path, &l->f);
+  p = l->f.addr;
+  end = p + l->f.len;
+  for (; p < end && lines0 < skip; lines0++) p = text_eol(p, end) + 1;
+  if (p > end) p = end;
+  t.buf = p;
+  t.len = end - p;
+  /* the first data line gives the number of fields */
+  for (e = p; e < end; e++) {
+    const char *q = text_eol(e, end);
+    if (text_data_line(e, q, t.comment)) { first = e; break; }
+    e = q;
+  }
+  if (first == NULL) rb_raise(rb_eArgError, "%s: no data", StringValueCStr(l->path));
+  t.map = NULL;
+  t.nfields = 0;
+  t.nfields = text_fields(&t, first, text_eol(first, end), NULL, NULL);
+
+  vcols = text_opt(l->opts, "columns");
+  vmap = rb_str_new(NULL, t.nfields*sizeof(long));
+  map = (long *) RSTRING_PTR(vmap);
+  if (NIL_P(vcols)) {
+    for (j = 0; j < t.nfields; j++) map[j] = (long) j;
+    ncols = t.nfields;
+  } else {
+    long col;
+    Check_Type(vcols, T_ARRAY);
+    ncols = RARRAY_LEN(vcols);
+    if (ncols == 0) rb_raise(rb_eArgError, ":columns is empty");
+    for (j = 0; j < t.nfields; j++) map[j] = -1;
+    for (j = 0; j < ncols; j++) {
+      col = NUM2LONG(rb_ary_entry(vcols, j));
+      if (col < 0) col += (long) t.nfields;
+      if (col < 0 || col >= (long) t.nfields)
+        rb_raise(rb_eIndexError, "column %ld out of range (%lu fields)",
+                 NUM2LONG(rb_ary_entry(vcols, j)), (unsigned long) t.nfields);
+      if (map[col] >= 0) rb_raise(rb_eArgError, "column %ld given twice", col);
+      map[col] = (long) j;
+    }
+  }
+  t.map = map;
+
+  /* chunks cut after a newline */
+  nthreads = rb_gsl_parallel_nthreads(t.len, t.len/TEXT_CHUNK + 1);
+  t.nchunks = nthreads;
+  vchunks = rb_str_new(NULL, t.nchunks*sizeof(struct text_chunk));
+  t.chunks = c = (struct text_chunk *) RSTRING_PTR(vchunks);
+  for (k = 0, p = t.buf; k < t.nchunks; k++) {
+    c[k].p = p;
+    if (k == t.nchunks - 1) e = end;
+    else {
+      e = t.buf + (t.len*(k + 1))/t.nchunks;
+      if (e < p) e = p;
+      e = e < end ? text_eol(e, end) : end;
+      if (e < end) e++;
+    }
+    c[k].end = e;
+    p = e;
+  }
+  text_run(&t, text_count, text_count_serial);
+  for (k = 0, rows = 0; k < t.nchunks; k++) {
+    c[k].row0 = rows;
+    rows += c[k].rows;
+  }
+
+  vbase = rb_str_new(NULL, ncols*sizeof(double *));
+  t.base = (double **) RSTRING_PTR(vbase);
+  if (l->vectors) {
+    ary = rb_ary_new2(ncols);
+    for (j = 0; j < ncols; j++) {
+      v = gsl_vector_alloc(rows);
+      rb_ary_store(ary, j, Data_Wrap_Struct(l->klass, 0, gsl_vector_free, v));
+      t.base[j] = v->data;
+    }
+    t.rstride = 1;
+    result = ary;
+  } else {
+    m = gsl_matrix_alloc(rows, ncols);
+    result = Data_Wrap_Struct(l->klass, 0, gsl_matrix_free, m);
+    for (j = 0; j < ncols; j++) t.base[j] = m->data + j;
+    t.rstride = m->tda;
+  }
+  text_run(&t, text_parse, text_parse_serial);
+
+  for (k = 0, i = lines0; k < t.nchunks; i += c[k].lines, k++) {
+    if (c[k].err == TEXT_NCOLS)
+      rb_raise(rb_eArgError, "%s:%lu: %lu fields (%lu expected)",
+               StringValueCStr(l->path), (unsigned long) (i + c[k].err_line + 1),
+               (unsigned long) c[k].err_fields, (unsigned long) t.nfields);
+    if (c[k].err == TEXT_NOMEM) rb_memerror();
+    if (c[k].err == TEXT_NUMBER)
+      rb_raise(rb_eArgError, "%s:%lu: not a number",
+               StringValueCStr(l->path), (unsigned long) (i + c[k].err_line + 1));
+  }
+  RB_GC_GUARD(vmap);
+  RB_GC_GUARD(vchunks);
+  RB_GC_GUARD(vbase);
+  return result;
+}
+
+static VALUE text_load(int argc, VALUE *argv, VALUE klass, int vectors)
+{
+  struct text_load l;
+  VALUE opts = Qnil;
+  rb_scan_args(argc, argv, "11", &l.path, &opts);
+  if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+  FilePathValue(l.path);
+  l.opts = opts;
+  l.klass = klass;
+  l.vectors = vectors;
+  l.f.addr = NULL;
+  l.f.mapped = 0;
+  return rb_ensure(text_load_body, (VALUE) &l, text_close, (VALUE) &l.f);
+}
+
+/* GSL::Matrix.loadtxt(path[, opts]) */
+static VALUE rb_gsl_matrix_loadtxt(int argc, VALUE *argv, VALUE klass)
+{
+  return text_load(argc, argv, klass, 0);
+}
+
+/* GSL::Vector.loadtxt(path[, opts]): an Array of the columns */
+static VALUE rb_gsl_vector_loadtxt(int argc, VALUE *argv, VALUE klass)
+{
+  return text_load(argc, argv, klass, 1);
+}
+
+static VALUE rb_gsl_vector_filescan(VALUE klass, VALUE path)
+{
+  return text_load(1, &path, klass, 1);
+}
+
+void Init_gsl_array_text(VALUE module)
+{
+  rb_define_singleton_method(cgsl_matrix, "loadtxt", rb_gsl_matrix_loadtxt, -1);
+  rb_define_singleton_method(cgsl_vector, "loadtxt", rb_gsl_vector_loadtxt, -1);
+  rb_define_singleton_method(cgsl_vector, "filescan", rb_gsl_vector_filescan, 1);
+}
@@ -14,16 +14,117 @@
 #include "rb_gsl_common.h"
 #include "rb_gsl_array.h"
 
+#include <stdint.h>
+
 void Init_gsl_blas1(VALUE module);
 void Init_gsl_blas2(VALUE module);
 void Init_gsl_blas3(VALUE module);
+void Init_gsl_blas_batch(VALUE module);
+
+/*
+  The CBLAS linked in place of -lgslcblas is chosen by extconf.rb
+  (--with-blas=...).  GSL::Blas.backend names it, and
+  GSL::Blas.num_threads= sets the number of threads of a multithreaded
+  one; the environment variable RB_GSL_BLAS_THREADS does the same when
+  the library is loaded.
+*/
+#if defined(RB_GSL_BLAS_OPENBLAS)
+#define BLAS_BACKEND "openblas"
+#elif defined(RB_GSL_BLAS_MKL)
+#define BLAS_BACKEND "mkl"
+#elif defined(RB_GSL_BLAS_BLIS)
+#define BLAS_BACKEND "blis"
+#elif defined(RB_GSL_BLAS_ATLAS)
+#define BLAS_BACKEND "atlas"
+#else
+#define BLAS_BACKEND "gslcblas"
+#endif
+
+#ifdef HAVE_OPENBLAS_SET_NUM_THREADS
+void openblas_set_num_threads(int n);
+#endif
+#ifdef HAVE_OPENBLAS_GET_NUM_THREADS
+int openblas_get_num_threads(void);
+#endif
+#ifdef HAVE_MKL_SET_NUM_THREADS
+void MKL_Set_Num_Threads(int n);
+#endif
+#ifdef HAVE_MKL_GET_MAX_THREADS
+int MKL_Get_Max_Threads(void);
+#endif
+#ifdef HAVE_BLI_THREAD_SET_NUM_THREADS
+void bli_thread_set_num_threads(int64_t n);
+#endif
+#ifdef HAVE_BLI_THREAD_GET_NUM_THREADS
+int64_t bli_thread_get_num_threads(void);
+#endif
+
+/* Returns 0 when the backend has no thread control; also used by
+   GSL::ThreadPool (thread_pool.c) */
+int mygsl_blas_set_num_threads(int n)
+{
+#if defined(HAVE_OPENBLAS_SET_NUM_THREADS)
+  openblas_set_num_threads(n);
+  return 1;
+#elif defined(HAVE_MKL_SET_NUM_THREADS)
+  MKL_Set_Num_Threads(n);
+  return 1;
+#elif defined(HAVE_BLI_THREAD_SET_NUM_THREADS)
+  bli_thread_set_num_threads((int64_t) n);
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+int mygsl_blas_get_num_threads(void)
+{
+#if defined(HAVE_OPENBLAS_GET_NUM_THREADS)
+  return openblas_get_num_threads();
+#elif defined(HAVE_MKL_GET_MAX_THREADS)
+  return MKL_Get_Max_Threads();
+#elif defined(HAVE_BLI_THREAD_GET_NUM_THREADS)
+  return (int) bli_thread_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+static VALUE rb_gsl_blas_backend(VALUE module)
+{
+  return rb_str_new2(BLAS_BACKEND);
+}
+
+static VALUE rb_gsl_blas_num_threads(VALUE module)
+{
+  return INT2FIX(mygsl_blas_get_num_threads());
+}
+
+static VALUE rb_gsl_blas_set_num_threads(VALUE module, VALUE nn)
+{
+  int n = NUM2INT(nn);
+  if (n < 1) rb_raise(rb_eArgError, "number of threads must be positive");
+  if (!mygsl_blas_set_num_threads(n) && n != 1)
+    rb_raise(rb_eNotImpError, "the %s BLAS backend has no thread control",
+	     BLAS_BACKEND);
+  return nn;
+}
 
 void Init_gsl_blas(VALUE module)
 {
   VALUE mgsl_blas;
+  const char *env;
   mgsl_blas = rb_define_module_under(module, "Blas");
 
   Init_gsl_blas1(mgsl_blas);
   Init_gsl_blas2(mgsl_blas);
   Init_gsl_blas3(mgsl_blas);
+  Init_gsl_blas_batch(mgsl_blas);
+
+  rb_define_module_function(mgsl_blas, "backend", rb_gsl_blas_backend, 0);
+  rb_define_module_function(mgsl_blas, "num_threads", rb_gsl_blas_num_threads, 0);
+  rb_define_module_function(mgsl_blas, "num_threads=", rb_gsl_blas_set_num_threads, 1);
+
+  env = getenv("RB_GSL_BLAS_THREADS");
+  if (env && atoi(env) > 0) mygsl_blas_set_num_threads(atoi(env));
 }
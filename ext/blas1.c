@@ -148,11 +148,19 @@ static VALUE rb_gsl_blas_zdotc(int argc, VALUE *argv, VALUE obj)
   return Data_Wrap_Struct(cgsl_complex, 0, free, r);
 }
 
+/* Large vectors use the threaded reduction of reduce.c */
+static double rb_gsl_blas_dnrm2_large(const gsl_vector *x)
+{
+  if (rb_gsl_parallel_threshold > 0 && x->size >= rb_gsl_parallel_threshold)
+    return mygsl_reduce(x->data, x->stride, x->size, MYGSL_REDUCE_NRM2, 0.0);
+  return gsl_blas_dnrm2(x);
+}
+
 static VALUE rb_gsl_blas_dnrm2(int argc, VALUE *argv, VALUE obj)
 {
   gsl_vector *x = NULL;
   get_vector1(argc, argv, obj, &x);
-  return rb_float_new(gsl_blas_dnrm2(x));
+  return rb_float_new(rb_gsl_blas_dnrm2_large(x));
 }
 
 static VALUE rb_gsl_blas_dnrm(int argc, VALUE *argv, VALUE obj)
@@ -160,7 +168,7 @@ static VALUE rb_gsl_blas_dnrm(int argc, VALUE *argv, VALUE obj)
   gsl_vector *x = NULL;
   double a;
   get_vector1(argc, argv, obj, &x);
-  a = gsl_blas_dnrm2(x);
+  a = rb_gsl_blas_dnrm2_large(x);
   return rb_float_new(a*a);
 }
 
@@ -52,7 +52,8 @@ static VALUE rb_gsl_blas_dgemv(int argc, VALUE *argv, VALUE obj)
   gsl_matrix *A = NULL;
   gsl_vector *x = NULL, *y = NULL;
   double a, b;
-  int type, istart, flag = 0;
+  CBLAS_TRANSPOSE_t type;
+  int istart, flag = 0;
   switch (TYPE(obj)) {
   case T_MODULE:
   case T_CLASS:
@@ -61,11 +62,10 @@ static VALUE rb_gsl_blas_dgemv(int argc, VALUE *argv, VALUE obj)
 			   argc);
     CHECK_FIXNUM(argv[0]);
     Need_Float(argv[1]);
-    CHECK_MATRIX(argv[2]);
     CHECK_VECTOR(argv[3]);
     type = FIX2INT(argv[0]);
     a = NUM2DBL(argv[1]);
-    Data_Get_Struct(argv[2], gsl_matrix, A);
+    A = rb_gsl_matrix_op(argv[2], &type);
     Data_Get_Struct(argv[3], gsl_vector, x);
     istart = 4;
     break;
@@ -91,7 +91,7 @@ static VALUE rb_gsl_blas_dgemv(int argc, VALUE *argv, VALUE obj)
     break;
   case 0:
     b = 0.0;
-    y = gsl_vector_alloc(x->size);
+    y = gsl_vector_alloc(type == CblasNoTrans ? A->size1 : A->size2);
     flag = 1;
     break;
   default:
@@ -109,7 +109,8 @@ static VALUE rb_gsl_blas_dgemv2(int argc, VALUE *argv, VALUE obj)
   gsl_matrix *A = NULL;
   gsl_vector *x = NULL, *y, *ynew;
   double a, b;
-  int type, istart, flag = 0;
+  CBLAS_TRANSPOSE_t type;
+  int istart, flag = 0;
   switch (TYPE(obj)) {
   case T_MODULE:
   case T_CLASS:
@@ -118,11 +119,10 @@ static VALUE rb_gsl_blas_dgemv2(int argc, VALUE *argv, VALUE obj)
 			   argc);
     CHECK_FIXNUM(argv[0]);
     Need_Float(argv[1]);
-    CHECK_MATRIX(argv[2]);
     CHECK_VECTOR(argv[3]);
     type = FIX2INT(argv[0]);
     a = NUM2DBL(argv[1]);
-    Data_Get_Struct(argv[2], gsl_matrix, A);
+    A = rb_gsl_matrix_op(argv[2], &type);
     Data_Get_Struct(argv[3], gsl_vector, x);
     istart = 4;
     break;
@@ -148,7 +148,7 @@ static VALUE rb_gsl_blas_dgemv2(int argc, VALUE *argv, VALUE obj)
     break;
   case 0:
     b = 0.0;
-    y = gsl_vector_alloc(x->size);
+    y = gsl_vector_alloc(type == CblasNoTrans ? A->size1 : A->size2);
     flag = 1;
     break;
   default:
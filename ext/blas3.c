@@ -23,28 +23,22 @@ static VALUE rb_gsl_blas_dgemm(int argc, VALUE *argv, VALUE obj)
   int flag = 0;
   switch (argc) {
   case 2:
-    CHECK_MATRIX(argv[0]);
-    CHECK_MATRIX(argv[1]);
-    Data_Get_Struct(argv[0], gsl_matrix, A);
-    Data_Get_Struct(argv[1], gsl_matrix, B);
-    C = gsl_matrix_calloc(A->size1, B->size2);
+    TransA = CblasNoTrans;  TransB = CblasNoTrans;
+    A = rb_gsl_matrix_op(argv[0], &TransA);
+    B = rb_gsl_matrix_op(argv[1], &TransB);
     alpha = 1.0;
     beta = 0.0;
-    TransA = CblasNoTrans;  TransB = CblasNoTrans;
     flag = 1;
     break;
   case 5:
     CHECK_FIXNUM(argv[0]);
     CHECK_FIXNUM(argv[1]);
     Need_Float(argv[2]);
-    CHECK_MATRIX(argv[3]);
-    CHECK_MATRIX(argv[4]);
     TransA = FIX2INT(argv[0]);
     TransB = FIX2INT(argv[1]);
     alpha = NUM2DBL(argv[2]);
-    Data_Get_Struct(argv[3], gsl_matrix, A);
-    Data_Get_Struct(argv[4], gsl_matrix, B);
-    C = gsl_matrix_calloc(A->size1, B->size2);
+    A = rb_gsl_matrix_op(argv[3], &TransA);
+    B = rb_gsl_matrix_op(argv[4], &TransB);
     beta = 0.0;
     flag = 1;
     break;
@@ -52,31 +46,26 @@ static VALUE rb_gsl_blas_dgemm(int argc, VALUE *argv, VALUE obj)
     CHECK_FIXNUM(argv[0]);
     CHECK_FIXNUM(argv[1]);
     Need_Float(argv[2]);
-    CHECK_MATRIX(argv[3]);
-    CHECK_MATRIX(argv[4]);
     Need_Float(argv[5]);
     TransA = FIX2INT(argv[0]);
     TransB = FIX2INT(argv[1]);
     alpha = NUM2DBL(argv[2]);
-    Data_Get_Struct(argv[3], gsl_matrix, A);
-    Data_Get_Struct(argv[4], gsl_matrix, B);
+    A = rb_gsl_matrix_op(argv[3], &TransA);
+    B = rb_gsl_matrix_op(argv[4], &TransB);
     beta = NUM2DBL(argv[5]);
-    C = gsl_matrix_calloc(A->size1, B->size2);
     flag = 1;
     break;
   case 7:
     CHECK_FIXNUM(argv[0]);
     CHECK_FIXNUM(argv[1]);
     Need_Float(argv[2]);
-    CHECK_MATRIX(argv[3]);
-    CHECK_MATRIX(argv[4]);
     Need_Float(argv[5]);
     CHECK_MATRIX(argv[6]);
     TransA = FIX2INT(argv[0]);
     TransB = FIX2INT(argv[1]);
     alpha = NUM2DBL(argv[2]);
-    Data_Get_Struct(argv[3], gsl_matrix, A);
-    Data_Get_Struct(argv[4], gsl_matrix, B);
+    A = rb_gsl_matrix_op(argv[3], &TransA);
+    B = rb_gsl_matrix_op(argv[4], &TransB);
     beta = NUM2DBL(argv[5]);
     Data_Get_Struct(argv[6], gsl_matrix, C);
     break;
@@ -84,6 +73,10 @@ static VALUE rb_gsl_blas_dgemm(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 2, 5, 6, or 7)", argc);
     break;
   }
+  /* A and B may be transpose views (a.t): C is op(A) op(B) */
+  if (flag == 1)
+    C = gsl_matrix_calloc(TransA == CblasNoTrans ? A->size1 : A->size2,
+			  TransB == CblasNoTrans ? B->size2 : B->size1);
   gsl_blas_dgemm(TransA, TransB, alpha, A, B, beta, C);
   if (flag == 1) return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, C);
   else return argv[6];
@@ -0,0 +1,465 @@
+/*
+  blas_batch.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Many independent matrix products in one call.
+
+    c = GSL::Blas.dgemm_batched([a0, a1, ...], [b0, b1, ...])
+    c = GSL::Blas.dgemm_strided_batched(a, b, :batch => 1000)
+    y = GSL::Blas.dgemv_batched([a0, a1, ...], [x0, x1, ...])
+    y = GSL::Blas.dgemv_strided_batched(a, x)
+
+  c_i = alpha op(a_i) op(b_i) + beta c_i, and y_i = alpha op(a_i) x_i +
+  beta y_i.  The _batched forms take Arrays of matrices (and vectors),
+  or a single matrix b (or vector x) shared by the whole batch, and
+  return an Array.  The _strided_batched forms take the matrices
+  stacked: a is (batch*rows) x cols, b a stack as well or one matrix,
+  and c the (batch*m) x n stack of the results; for dgemv x is a
+  batch x n matrix of one vector per row and y the batch x m matrix of
+  the results.  A rank 3 GSL::Tensor of dimension d is also a stack of
+  d matrices d x d.  The batch size is found from the shapes when
+  neither matrix is transposed, and is given as :batch otherwise.
+
+  Options :trans_a, :trans_b (GSL::Blas::NoTrans or Trans), :alpha (1)
+  and :beta (0).  c (or y) may be given as the third argument; beta
+  applies to it.
+
+  With MKL the strided dgemm is one cblas_dgemm_batch_strided call.
+  Otherwise the batch is split over GSL.parallel_threads threads with
+  the GVL released, products of up to BLASB_SMALL multiply-adds going
+  through an inline kernel and larger ones through cblas_dgemm and
+  cblas_dgemv.
+*/
+
+#include "rb_gsl_config.h"
+
+#include <gsl/gsl_blas.h>
+#include "rb_gsl_common.h"
+#include "rb_gsl_array.h"
+#ifdef HAVE_TENSOR_TENSOR_H
+#include "rb_gsl_tensor.h"
+#endif
+
+#define BLASB_SMALL 4096
+
+#ifdef HAVE_CBLAS_DGEMM_BATCH_STRIDED
+void cblas_dgemm_batch_strided(const enum CBLAS_ORDER layout,
+			       const enum CBLAS_TRANSPOSE transa,
+			       const enum CBLAS_TRANSPOSE transb,
+			       const int m, const int n, const int k,
+			       const double alpha, const double *a, const int lda,
+			       const int stridea, const double *b, const int ldb,
+			       const int strideb, const double beta, double *c,
+			       const int ldc, const int stridec, const int batch_size);
+#endif
+
+/*
+  Product i: op(A) is m x k, op(B) k x n, C m x n, all row-major.  The
+  operands are at a + i*sa (leading dimension lda), or pa[i] (plda[i])
+  for Arrays.  For dgemv n = 1, B is the vector x with the stride ldb,
+  and C the vector y with the stride ldc.
+*/
+struct blasb_task {
+  int gemv;
+  CBLAS_TRANSPOSE_t ta, tb;
+  size_t m, n, k;
+  double alpha, beta;
+  const double *a, *b;
+  double *c;
+  size_t lda, ldb, ldc, sa, sb, sc;
+  const double **pa, **pb;
+  double **pc;
+  size_t *plda, *pldb, *pldc;
+  size_t batch, nthreads;
+};
+
+static void blasb_small(const struct blasb_task *t, const double *a, size_t lda,
+			const double *b, size_t ldb, double *c, size_t ldc)
+{
+  size_t i, j, l;
+  double x;
+  for (i = 0; i < t->m; i++) {
+    double *ci = c + i*ldc;
+    if (t->gemv) {
+      x = 0.0;
+      for (l = 0; l < t->k; l++)
+	x += (t->ta == CblasNoTrans ? a[i*lda + l] : a[l*lda + i])*b[l*ldb];
+      *ci = t->alpha*x + (t->beta == 0.0 ? 0.0 : t->beta*(*ci));
+      continue;
+    }
+    if (t->beta == 0.0) for (j = 0; j < t->n; j++) ci[j] = 0.0;
+    else if (t->beta != 1.0) for (j = 0; j < t->n; j++) ci[j] *= t->beta;
+    for (l = 0; l < t->k; l++) {
+      x = t->alpha*(t->ta == CblasNoTrans ? a[i*lda + l] : a[l*lda + i]);
+      if (x == 0.0) continue;
+      if (t->tb == CblasNoTrans) {
+	const double *bl = b + l*ldb;
+	for (j = 0; j < t->n; j++) ci[j] += x*bl[j];
+      } else {
+	for (j = 0; j < t->n; j++) ci[j] += x*b[j*ldb + l];
+      }
+    }
+  }
+}
+
+static void blasb_one(const struct blasb_task *t, size_t i)
+{
+  const double *a, *b;
+  double *c;
+  size_t lda, ldb, ldc, ra, ca;
+  if (t->pa) {
+    a = t->pa[i]; lda = t->plda[i];
+    b = t->pb[i]; ldb = t->pldb[i];
+    c = t->pc[i]; ldc = t->pldc[i];
+  } else {
+    a = t->a + i*t->sa; lda = t->lda;
+    b = t->b + i*t->sb; ldb = t->ldb;
+    c = t->c + i*t->sc; ldc = t->ldc;
+  }
+  if (t->m*t->n*t->k <= BLASB_SMALL) {
+    blasb_small(t, a, lda, b, ldb, c, ldc);
+    return;
+  }
+  if (t->gemv) {
+    ra = t->ta == CblasNoTrans ? t->m : t->k;
+    ca = t->ta == CblasNoTrans ? t->k : t->m;
+    cblas_dgemv(CblasRowMajor, t->ta, (int) ra, (int) ca, t->alpha, a, (int) lda,
+		b, (int) ldb, t->beta, c, (int) ldc);
+  } else {
+    cblas_dgemm(CblasRowMajor, t->ta, t->tb, (int) t->m, (int) t->n, (int) t->k,
+		t->alpha, a, (int) lda, b, (int) ldb, t->beta, c, (int) ldc);
+  }
+}
+
+static int blasb_worker(void *data, size_t id)
+{
+  struct blasb_task *t = (struct blasb_task *) data;
+  size_t chunk = (t->batch + t->nthreads - 1)/t->nthreads, i;
+  for (i = id*chunk; i < GSL_MIN((id + 1)*chunk, t->batch); i++) blasb_one(t, i);
+  return GSL_SUCCESS;
+}
+
+static int blasb_serial(void *data)
+{
+  struct blasb_task *t = (struct blasb_task *) data;
+  size_t i;
+#ifdef HAVE_CBLAS_DGEMM_BATCH_STRIDED
+  if (!t->gemv && !t->pa) {
+    cblas_dgemm_batch_strided(CblasRowMajor, t->ta, t->tb, (int) t->m, (int) t->n,
+			      (int) t->k, t->alpha, t->a, (int) t->lda, (int) t->sa,
+			      t->b, (int) t->ldb, (int) t->sb, t->beta, t->c,
+			      (int) t->ldc, (int) t->sc, (int) t->batch);
+    return GSL_SUCCESS;
+  }
+#endif
+  for (i = 0; i < t->batch; i++) blasb_one(t, i);
+  return GSL_SUCCESS;
+}
+
+static void blasb_run(struct blasb_task *t)
+{
+  size_t work = t->batch*t->m*t->n*t->k;
+  t->nthreads = rb_gsl_parallel_nthreads(work, t->batch);
+#ifdef HAVE_CBLAS_DGEMM_BATCH_STRIDED
+  if (!t->gemv && !t->pa) t->nthreads = 1;
+#endif
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(blasb_worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(blasb_serial, t, work);
+}
+
+static VALUE blasb_options(int *argc, VALUE *argv, struct blasb_task *t, long *batch)
+{
+  VALUE opts = Qnil, v;
+  t->ta = t->tb = CblasNoTrans;
+  t->alpha = 1.0;
+  t->beta = 0.0;
+  *batch = -1;
+  if (*argc > 2 && TYPE(argv[*argc-1]) == T_HASH) opts = argv[--(*argc)];
+  if (*argc < 2 || *argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", *argc);
+  if (NIL_P(opts)) return *argc > 2 ? argv[2] : Qnil;
+  if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("trans_a"))))) t->ta = FIX2INT(v);
+  if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("trans_b"))))) t->tb = FIX2INT(v);
+  if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("alpha"))))) t->alpha = NUM2DBL(v);
+  if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("beta"))))) t->beta = NUM2DBL(v);
+  if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("batch"))))) *batch = NUM2LONG(v);
+  if ((t->ta != CblasNoTrans && t->ta != CblasTrans)
+      || (t->tb != CblasNoTrans && t->tb != CblasTrans))
+    rb_raise(rb_eArgError, "trans_a and trans_b must be GSL::Blas::NoTrans or Trans");
+  return *argc > 2 ? argv[2] : Qnil;
+}
+
+/* The dimensions of op(a): m x k from a rows x cols */
+static void blasb_op_dims(CBLAS_TRANSPOSE_t trans, size_t rows, size_t cols,
+			  size_t *m, size_t *k)
+{
+  *m = trans == CblasNoTrans ? rows : cols;
+  *k = trans == CblasNoTrans ? cols : rows;
+}
+
+static gsl_matrix* blasb_get_matrix(VALUE v, const char *name)
+{
+  gsl_matrix *m;
+  if (!MATRIX_P(v))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix expected for %s)",
+	     rb_class2name(CLASS_OF(v)), name);
+  Data_Get_Struct(v, gsl_matrix, m);
+  return m;
+}
+
+/*
+  Arrays of matrices
+*/
+static VALUE rb_gsl_blas_batched0(int argc, VALUE *argv, int gemv)
+{
+  struct blasb_task t;
+  gsl_matrix *A, *B = NULL, *C;
+  gsl_vector *x = NULL, *y;
+  VALUE vc, va = argv[0], vb = argv[1], item, ary, keep;
+  size_t i, batch, m, k, kb, n = 1;
+  int shared;
+  long nb;
+  memset(&t, 0, sizeof(t));
+  t.gemv = gemv;
+  vc = blasb_options(&argc, argv, &t, &nb);
+  Check_Type(va, T_ARRAY);
+  batch = RARRAY_LEN(va);
+  if (batch == 0) rb_raise(rb_eArgError, "no matrices given");
+  shared = TYPE(vb) != T_ARRAY;
+  if (!shared && (size_t) RARRAY_LEN(vb) != batch)
+    rb_raise(rb_eArgError, "%d matrices and %d operands", (int) batch, (int) RARRAY_LEN(vb));
+  A = blasb_get_matrix(rb_ary_entry(va, 0), "a");
+  blasb_op_dims(t.ta, A->size1, A->size2, &m, &k);
+  if (gemv) {
+    item = shared ? vb : rb_ary_entry(vb, 0);
+    CHECK_VECTOR(item);
+    Data_Get_Struct(item, gsl_vector, x);
+    kb = x->size;
+  } else {
+    B = blasb_get_matrix(shared ? vb : rb_ary_entry(vb, 0), "b");
+    blasb_op_dims(t.tb, B->size2, B->size1, &n, &kb);
+  }
+  if (kb != k)
+    rb_raise(rb_eArgError, "op(a) is %d x %d, op(b) has %d rows", (int) m, (int) k, (int) kb);
+  if (NIL_P(vc)) {
+    ary = rb_ary_new2(batch);
+    for (i = 0; i < batch; i++) {
+      if (gemv) {
+	y = gsl_vector_calloc(m);
+	rb_ary_push(ary, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y));
+      } else {
+	C = gsl_matrix_calloc(m, n);
+	rb_ary_push(ary, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, C));
+      }
+    }
+    vc = ary;
+  } else {
+    Check_Type(vc, T_ARRAY);
+    if ((size_t) RARRAY_LEN(vc) != batch)
+      rb_raise(rb_eArgError, "%d results for %d products", (int) RARRAY_LEN(vc), (int) batch);
+  }
+  t.m = m;
+  t.n = n;
+  t.k = k;
+  t.batch = batch;
+  t.pa = (const double **) ALLOCV(keep, batch*(3*sizeof(double*) + 3*sizeof(size_t)));
+  t.pb = t.pa + batch;
+  t.pc = (double **) (t.pb + batch);
+  t.plda = (size_t *) (t.pc + batch);
+  t.pldb = t.plda + batch;
+  t.pldc = t.pldb + batch;
+  for (i = 0; i < batch; i++) {
+    A = blasb_get_matrix(rb_ary_entry(va, i), "a");
+    if (A->size1 != (t.ta == CblasNoTrans ? m : k) || A->size2 != (t.ta == CblasNoTrans ? k : m))
+      rb_raise(rb_eArgError, "matrix a[%d] is %d x %d", (int) i, (int) A->size1, (int) A->size2);
+    t.pa[i] = A->data;
+    t.plda[i] = A->tda;
+    item = shared ? vb : rb_ary_entry(vb, i);
+    if (gemv) {
+      CHECK_VECTOR(item);
+      Data_Get_Struct(item, gsl_vector, x);
+      if (x->size != k) rb_raise(rb_eArgError, "vector x[%d] of size %d", (int) i, (int) x->size);
+      t.pb[i] = x->data;
+      t.pldb[i] = x->stride;
+      item = rb_ary_entry(vc, i);
+      CHECK_VECTOR(item);
+      Data_Get_Struct(item, gsl_vector, y);
+      if (y->size != m) rb_raise(rb_eArgError, "vector y[%d] of size %d", (int) i, (int) y->size);
+      t.pc[i] = y->data;
+      t.pldc[i] = y->stride;
+    } else {
+      B = blasb_get_matrix(item, "b");
+      if (B->size1 != (t.tb == CblasNoTrans ? k : n) || B->size2 != (t.tb == CblasNoTrans ? n : k))
+	rb_raise(rb_eArgError, "matrix b[%d] is %d x %d", (int) i, (int) B->size1, (int) B->size2);
+      t.pb[i] = B->data;
+      t.pldb[i] = B->tda;
+      C = blasb_get_matrix(rb_ary_entry(vc, i), "c");
+      if (C->size1 != m || C->size2 != n)
+	rb_raise(rb_eArgError, "matrix c[%d] must be %d x %d", (int) i, (int) m, (int) n);
+      t.pc[i] = C->data;
+      t.pldc[i] = C->tda;
+    }
+  }
+  blasb_run(&t);
+  ALLOCV_END(keep);
+  return vc;
+}
+
+/*
+  Stacked matrices
+*/
+
+/* A stacked operand: a Matrix, or a rank 3 Tensor as d matrices d x d */
+static const double* blasb_stack(VALUE v, size_t *rows, size_t *cols, size_t *ld,
+				 size_t *count, const char *name)
+{
+  gsl_matrix *m;
+#ifdef HAVE_TENSOR_TENSOR_H
+  rbgsl_tensor *t;
+  if (rb_obj_is_kind_of(v, cgsl_tensor)) {
+    Data_Get_Struct(v, rbgsl_tensor, t);
+    if (t->tensor->rank != 3)
+      rb_raise(rb_eArgError, "tensor of rank %d for %s (3 expected)", (int) t->tensor->rank, name);
+    *count = t->tensor->dimension;
+    *rows = t->tensor->dimension*t->tensor->dimension;
+    *cols = *ld = t->tensor->dimension;
+    return t->tensor->data;
+  }
+#endif
+  m = blasb_get_matrix(v, name);
+  *rows = m->size1;
+  *cols = m->size2;
+  *ld = m->tda;
+  *count = 0;
+  return m->data;
+}
+
+static VALUE rb_gsl_blas_strided_batched0(int argc, VALUE *argv, int gemv)
+{
+  struct blasb_task t;
+  gsl_matrix *M;
+  VALUE vc;
+  size_t ra, ca, rb, cb, rc, cc, na, nb, nc, batch, m, n, k;
+  long nbatch;
+  memset(&t, 0, sizeof(t));
+  t.gemv = gemv;
+  vc = blasb_options(&argc, argv, &t, &nbatch);
+  t.a = blasb_stack(argv[0], &ra, &ca, &t.lda, &na, "a");
+  t.b = blasb_stack(argv[1], &rb, &cb, &t.ldb, &nb, gemv ? "x" : "b");
+  if (gemv && nb) rb_raise(rb_eTypeError, "x must be a GSL::Matrix");
+  if (na) {
+    batch = na;
+  } else if (nbatch > 0) {
+    batch = (size_t) nbatch;
+  } else if (gemv) {
+    batch = rb;
+  } else if (t.ta == CblasNoTrans && t.tb == CblasNoTrans && nb == 0) {
+    /* a is (batch*m) x k, b (batch*k) x n or k x n */
+    if (ca == 0 || rb % ca != 0)
+      rb_raise(rb_eArgError, "b of %d rows for a of %d columns", (int) rb, (int) ca);
+    batch = rb == ca ? 0 : rb/ca;
+    if (batch == 0) rb_raise(rb_eArgError, "give :batch for a shared b");
+  } else if (nb) {
+    batch = nb;
+  } else {
+    rb_raise(rb_eArgError, "give :batch for transposed stacks");
+  }
+  if (batch == 0 || ra % batch != 0)
+    rb_raise(rb_eArgError, "a of %d rows is not a stack of %d matrices", (int) ra, (int) batch);
+  blasb_op_dims(t.ta, ra/batch, ca, &m, &k);
+  t.sa = (ra/batch)*t.lda;
+  if (gemv) {
+    /* x: batch x k, one vector per row, or a single row shared */
+    if (cb != k || (rb != batch && rb != 1))
+      rb_raise(rb_eArgError, "x must be %d x %d", (int) batch, (int) k);
+    n = 1;
+    t.sb = rb == 1 ? 0 : t.ldb;
+    t.ldb = 1;
+  } else {
+    if (nb && nb != batch)
+      rb_raise(rb_eArgError, "stacks of %d and %d matrices", (int) batch, (int) nb);
+    if (t.tb == CblasNoTrans) {
+      if (rb == batch*k) t.sb = k*t.ldb;
+      else if (rb == k) t.sb = 0;
+      else rb_raise(rb_eArgError, "b of %d rows for op(a) of %d columns", (int) rb, (int) k);
+      n = cb;
+    } else {
+      if (cb != k)
+	rb_raise(rb_eArgError, "b of %d columns for op(a) of %d columns", (int) cb, (int) k);
+      if (rb % batch == 0) {
+	n = rb/batch;
+	t.sb = n*t.ldb;
+      } else {
+	n = rb;
+	t.sb = 0;
+      }
+    }
+  }
+  if (NIL_P(vc)) {
+#ifdef HAVE_TENSOR_TENSOR_H
+    if (na && !gemv && m == batch && n == batch) {
+      rbgsl_tensor *tc = rbgsl_tensor_alloc(3, batch);
+      memset(tc->tensor->data, 0, sizeof(double)*tc->tensor->size);
+      vc = Data_Wrap_Struct(cgsl_tensor, 0, rbgsl_tensor_free, tc);
+    } else
+#endif
+    {
+      M = gemv ? gsl_matrix_calloc(batch, m) : gsl_matrix_calloc(batch*m, n);
+      vc = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, M);
+    }
+  }
+  t.c = (double *) blasb_stack(vc, &rc, &cc, &t.ldc, &nc, gemv ? "y" : "c");
+  if (gemv) {
+    if (rc != batch || cc != m)
+      rb_raise(rb_eArgError, "y must be %d x %d", (int) batch, (int) m);
+    t.sc = t.ldc;
+    t.ldc = 1;
+  } else {
+    if (rc != batch*m || cc != n)
+      rb_raise(rb_eArgError, "c must be a stack of %d matrices %d x %d", (int) batch, (int) m, (int) n);
+    t.sc = m*t.ldc;
+  }
+  t.m = m;
+  t.n = n;
+  t.k = k;
+  t.batch = batch;
+  blasb_run(&t);
+  return vc;
+}
+
+static VALUE rb_gsl_blas_dgemm_batched(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_blas_batched0(argc, argv, 0);
+}
+
+static VALUE rb_gsl_blas_dgemv_batched(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_blas_batched0(argc, argv, 1);
+}
+
+static VALUE rb_gsl_blas_dgemm_strided_batched(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_blas_strided_batched0(argc, argv, 0);
+}
+
+static VALUE rb_gsl_blas_dgemv_strided_batched(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_blas_strided_batched0(argc, argv, 1);
+}
+
+void Init_gsl_blas_batch(VALUE module)
+{
+  rb_define_module_function(module, "dgemm_batched", rb_gsl_blas_dgemm_batched, -1);
+  rb_define_module_function(module, "dgemm_strided_batched",
+			    rb_gsl_blas_dgemm_strided_batched, -1);
+  rb_define_module_function(module, "dgemv_batched", rb_gsl_blas_dgemv_batched, -1);
+  rb_define_module_function(module, "dgemv_strided_batched",
+			    rb_gsl_blas_dgemv_strided_batched, -1);
+}
@@ -99,6 +99,133 @@ static VALUE rb_gsl_bspline_eval(int argc, VALUE *argv, VALUE obj)
 	return vB;
 }
 #ifdef GSL_1_13_LATER
+/*
+  The design matrix of the basis at the points of x: row r holds the
+  order non-zero values (of the nderiv-th derivatives) at x[r] in
+  val[r*order ...], from column start[r] on
+*/
+struct bspline_design {
+  gsl_bspline_workspace *w;
+#ifndef HAVE_GSL_BSPLINE_DERIV_NOWS
+  gsl_bspline_deriv_workspace *dw;
+#endif
+  const gsl_vector *x;
+  size_t nderiv, *start;
+  double *val;
+  gsl_matrix *dB;       /* order x (nderiv + 1) */
+};
+
+static int bspline_design_run(void *data)
+{
+  struct bspline_design *d = (struct bspline_design *) data;
+  size_t r, j, k = gsl_bspline_order(d->w), istart, iend;
+  gsl_vector_view B;
+  double x;
+  for (r = 0; r < d->x->size; r++) {
+    x = gsl_vector_get(d->x, r);
+    if (d->nderiv == 0) {
+      B = gsl_vector_view_array(d->val + r*k, k);
+      gsl_bspline_eval_nonzero(x, &B.vector, &istart, &iend, d->w);
+    } else {
+#ifdef HAVE_GSL_BSPLINE_DERIV_NOWS
+      gsl_bspline_deriv_eval_nonzero(x, d->nderiv, d->dB, &istart, &iend, d->w);
+#else
+      gsl_bspline_deriv_eval_nonzero(x, d->nderiv, d->dB, &istart, &iend, d->w, d->dw);
+#endif
+      for (j = 0; j < k; j++) d->val[r*k + j] = gsl_matrix_get(d->dB, j, d->nderiv);
+    }
+    d->start[r] = istart;
+  }
+  return GSL_SUCCESS;
+}
+
+/*
+  design(x, opts = {}): the design matrix of the basis at the points of
+  the vector x, x.size x ncoeffs, for a least-squares fit.  The options
+  are :nderiv (0; the basis of the nderiv-th derivatives) and :format:
+  :dense (a GSL::Matrix, the default), :sparse (a GSL::SpMatrix) or
+  :band, [vals, start], vals a x.size x order GSL::Matrix holding the
+  non-zero values of each row and start a GSL::Vector::Int of the
+  column of the first.  The basis is evaluated once per point, by
+  gsl_bspline_eval_nonzero, with the GVL released.
+*/
+static VALUE rb_gsl_bspline_design(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_bspline_workspace *w;
+  gsl_vector *x;
+  gsl_matrix *vals, *D;
+  gsl_vector_int *vstart;
+  struct bspline_design d;
+  VALUE opts = Qnil, v, vvals, ret;
+  const char *format = "dense";
+  size_t n, k, r, j;
+  double t0, t1, xr;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_VECTOR(argv[0]);
+  Data_Get_Struct(obj, gsl_bspline_workspace, w);
+  Data_Get_Struct(argv[0], gsl_vector, x);
+  memset(&d, 0, sizeof(d));
+  if (argc == 2) {
+    opts = argv[1];
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("nderiv"))))) d.nderiv = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("format")))))
+      format = SYMBOL_P(v) ? rb_id2name(SYM2ID(v)) : StringValuePtr(v);
+  }
+  if (strcmp(format, "dense") && strcmp(format, "sparse") && strcmp(format, "band"))
+    rb_raise(rb_eArgError, "unknown format %s (:dense, :sparse or :band)", format);
+#ifndef HAVE_GSL_GSL_SPMATRIX_H
+  if (strcmp(format, "sparse") == 0)
+    rb_raise(rb_eNotImpError, "GSL::SpMatrix needs GSL 2.0 or later");
+#endif
+  n = x->size;
+  k = gsl_bspline_order(w);
+  /* checked here so that GSL raises nothing past the allocations */
+  t0 = gsl_vector_get(w->knots, 0);
+  t1 = gsl_vector_get(w->knots, w->knots->size - 1);
+  for (r = 0; r < n; r++) {
+    xr = gsl_vector_get(x, r);
+    if (!(xr >= t0 && xr <= t1))
+      rb_raise(rb_eRangeError, "x[%d] = %g is outside the knots [%g, %g]",
+	       (int) r, xr, t0, t1);
+  }
+  vals = gsl_matrix_alloc(n > 0 ? n : 1, k);
+  vvals = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, vals);
+  d.w = w;
+  d.x = x;
+  d.val = vals->data;
+  d.start = ALLOC_N(size_t, n > 0 ? n : 1);
+  if (d.nderiv > 0) {
+    d.dB = gsl_matrix_alloc(k, d.nderiv + 1);
+#ifndef HAVE_GSL_BSPLINE_DERIV_NOWS
+    d.dw = gsl_bspline_deriv_alloc(k);
+#endif
+  }
+  rb_gsl_nogvl_call(bspline_design_run, &d, n*k*k*(d.nderiv + 1));
+  if (d.dB) gsl_matrix_free(d.dB);
+#ifndef HAVE_GSL_BSPLINE_DERIV_NOWS
+  if (d.dw) gsl_bspline_deriv_free(d.dw);
+#endif
+  if (strcmp(format, "band") == 0) {
+    vstart = gsl_vector_int_alloc(n > 0 ? n : 1);
+    for (r = 0; r < n; r++) gsl_vector_int_set(vstart, r, (int) d.start[r]);
+    ret = rb_ary_new3(2, vvals, Data_Wrap_Struct(cgsl_vector_int, 0,
+						 gsl_vector_int_free, vstart));
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  } else if (strcmp(format, "sparse") == 0) {
+    ret = rb_gsl_spmatrix_band_rows(n, gsl_bspline_ncoeffs(w), k, d.start, d.val);
+#endif
+  } else {
+    D = gsl_matrix_calloc(n > 0 ? n : 1, gsl_bspline_ncoeffs(w));
+    for (r = 0; r < n; r++)
+      for (j = 0; j < k; j++) gsl_matrix_set(D, r, d.start[r] + j, d.val[r*k + j]);
+    ret = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, D);
+  }
+  xfree(d.start);
+  return ret;
+}
+
 static VALUE rb_gsl_bspline_greville_abscissa(VALUE obj, VALUE i)
 {
   gsl_bspline_workspace *w;
@@ -124,6 +251,7 @@ void Init_bspline(VALUE module)
 
 #ifdef GSL_1_13_LATER
   rb_define_method(cBSWS, "greville_abscissa", rb_gsl_bspline_greville_abscissa, 1);
+  rb_define_method(cBSWS, "design", rb_gsl_bspline_design, -1);
 #endif
 
 }
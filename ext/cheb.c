@@ -87,74 +87,233 @@ static VALUE rb_gsl_cheb_init(VALUE obj, VALUE ff, VALUE aa, VALUE bb)
   Data_Get_Struct(ff, gsl_function, fff);
   a = NUM2DBL(aa);
   b = NUM2DBL(bb);
+  rb_check_frozen(obj);
   gsl_cheb_init(p, fff, a, b);
+  rb_ivar_set(obj, rb_intern("@deriv"), Qnil);
+  rb_ivar_set(obj, rb_intern("@integ"), Qnil);
   return obj;
 }
 
+/*
+  Evaluation over Vectors, Matrices and Arrays: the Clenshaw recurrence
+  of gsl_cheb_eval_n, run for four points side by side (and, for
+  eval_fdf, for the derivative series too in the same loop). Large
+  arguments are split over GSL.parallel_threads, the GVL released.
+*/
+#define RB_GSL_CHEB_BLOCK 1024
+
+typedef struct {
+  const gsl_cheb_series *cs, *ds;       /* ds, the derivative, or NULL */
+  size_t order;
+  size_t n, ncols, nthreads;
+  const double *x;                      /* x[r*xtda + c*xstride] */
+  size_t xtda, xstride;
+  double *y, *dy;
+  size_t ytda, ystride;
+} rb_gsl_cheb_map;
+
+static void rb_gsl_cheb_eval4(const rb_gsl_cheb_map *m, const double *x, double *y, double *dy)
+{
+  const double *c = m->cs->c, *dc = m->ds ? m->ds->c : NULL;
+  double u[4], d1[4], d2[4], e1[4], e2[4], t;
+  size_t i, k;
+  for (k = 0; k < 4; k++) {
+    u[k] = 2.0*(2.0*x[k] - m->cs->a - m->cs->b)/(m->cs->b - m->cs->a);
+    d1[k] = d2[k] = e1[k] = e2[k] = 0.0;
+  }
+  for (i = m->order; i >= 1; i--) {
+    for (k = 0; k < 4; k++) {
+      t = d1[k];
+      d1[k] = u[k]*d1[k] - d2[k] + c[i];
+      d2[k] = t;
+    }
+    if (dc) {
+      for (k = 0; k < 4; k++) {
+	t = e1[k];
+	e1[k] = u[k]*e1[k] - e2[k] + dc[i];
+	e2[k] = t;
+      }
+    }
+  }
+  for (k = 0; k < 4; k++) {
+    y[k] = 0.5*u[k]*d1[k] - d2[k] + 0.5*c[0];
+    if (dc) dy[k] = 0.5*u[k]*e1[k] - e2[k] + 0.5*dc[0];
+  }
+}
+
+static void rb_gsl_cheb_map_range(const rb_gsl_cheb_map *m, size_t lo, size_t hi)
+{
+  double x[4], y[4], dy[4];
+  size_t idx[4], k, l, nb, r, c;
+  while (lo < hi) {
+    nb = GSL_MIN(hi - lo, 4);
+    for (l = 0; l < 4; l++) {
+      k = lo + (l < nb ? l : 0);
+      r = k/m->ncols;
+      c = k%m->ncols;
+      x[l] = m->x[r*m->xtda + c*m->xstride];
+      idx[l] = r*m->ytda + c*m->ystride;
+    }
+    rb_gsl_cheb_eval4(m, x, y, dy);
+    for (l = 0; l < nb; l++) {
+      m->y[idx[l]] = y[l];
+      if (m->ds) m->dy[idx[l]] = dy[l];
+    }
+    lo += nb;
+  }
+}
+
+static int rb_gsl_cheb_map_worker(void *data, size_t id)
+{
+  rb_gsl_cheb_map *m = (rb_gsl_cheb_map *) data;
+  rb_gsl_cheb_map_range(m, m->n*id/m->nthreads, m->n*(id + 1)/m->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int rb_gsl_cheb_map_serial(void *data)
+{
+  rb_gsl_cheb_map *m = (rb_gsl_cheb_map *) data;
+  rb_gsl_cheb_map_range(m, 0, m->n);
+  return GSL_SUCCESS;
+}
+
+static void rb_gsl_cheb_map_run(rb_gsl_cheb_map *m)
+{
+  if (m->n == 0) return;
+  m->nthreads = rb_gsl_parallel_nthreads(m->n*(m->order + 1),
+					 (m->n + RB_GSL_CHEB_BLOCK - 1)/RB_GSL_CHEB_BLOCK);
+  if (m->nthreads > 1) rb_gsl_nogvl_parallel(rb_gsl_cheb_map_worker, m, m->nthreads);
+  else rb_gsl_nogvl_call(rb_gsl_cheb_map_serial, m, m->n*(m->order + 1));
+}
+
+/* The series of cs up to order at xx, a Vector, a Matrix or an Array (a
+   Range as an Array), and of its derivative ds too if not NULL; Qundef
+   for other types. A pair [f, df] with ds. */
+static VALUE rb_gsl_cheb_map_eval(const gsl_cheb_series *cs, const gsl_cheb_series *ds,
+				  size_t order, VALUE xx)
+{
+  rb_gsl_cheb_map m;
+  gsl_vector *v = NULL, *vy, *vdy = NULL;
+  gsl_matrix *mx = NULL, *my, *mdy = NULL;
+  VALUE y, dy = Qnil, ary, dary, tmp = 0;
+  double *buf;
+  size_t i;
+  memset(&m, 0, sizeof(rb_gsl_cheb_map));
+  m.cs = cs;
+  m.ds = ds;
+  m.order = GSL_MIN(order, cs->order);
+  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+  if (TYPE(xx) == T_ARRAY) {
+    m.n = RARRAY_LEN(xx);
+    buf = ALLOCV_N(double, tmp, 3*m.n + 1);
+    for (i = 0; i < m.n; i++) buf[i] = NUM2DBL(rb_ary_entry(xx, i));
+    m.ncols = GSL_MAX(m.n, 1);
+    m.x = buf;
+    m.y = buf + m.n;
+    m.dy = buf + 2*m.n;
+    m.xstride = m.ystride = 1;
+    rb_gsl_cheb_map_run(&m);
+    ary = rb_ary_new2(m.n);
+    dary = ds ? rb_ary_new2(m.n) : Qnil;
+    for (i = 0; i < m.n; i++) {
+      rb_ary_store(ary, i, rb_float_new(m.y[i]));
+      if (ds) rb_ary_store(dary, i, rb_float_new(m.dy[i]));
+    }
+    ALLOCV_END(tmp);
+    return ds ? rb_ary_new3(2, ary, dary) : ary;
+  }
+  if (VECTOR_P(xx)) {
+    Data_Get_Struct(xx, gsl_vector, v);
+    vy = gsl_vector_alloc(v->size);
+    y = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vy);
+    if (ds) {
+      vdy = gsl_vector_alloc(v->size);
+      dy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vdy);
+      m.dy = vdy->data;
+    }
+    m.n = v->size;
+    m.ncols = GSL_MAX(v->size, 1);
+    m.x = v->data;
+    m.xstride = v->stride;
+    m.y = vy->data;
+    m.ystride = 1;
+  } else if (MATRIX_P(xx)) {
+    Data_Get_Struct(xx, gsl_matrix, mx);
+    my = gsl_matrix_alloc(mx->size1, mx->size2);
+    y = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, my);
+    if (ds) {
+      mdy = gsl_matrix_alloc(mx->size1, mx->size2);
+      dy = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mdy);
+      m.dy = mdy->data;
+    }
+    m.n = mx->size1*mx->size2;
+    m.ncols = mx->size2;
+    m.x = mx->data;
+    m.xtda = mx->tda;
+    m.xstride = 1;
+    m.y = my->data;
+    m.ytda = my->tda;
+    m.ystride = 1;
+  } else {
+    return Qundef;
+  }
+  rb_gsl_cheb_map_run(&m);
+  return ds ? rb_ary_new3(2, y, dy) : y;
+}
+
+/* The derivative (or integral) series of obj, computed once and kept
+   frozen on it until the next init (a new one each time if obj is itself
+   frozen, a cached series) */
+static VALUE rb_gsl_cheb_cached(VALUE obj, const char *name,
+				int (*calc)(gsl_cheb_series *, const gsl_cheb_series *))
+{
+  gsl_cheb_series *cs = NULL, *d = NULL;
+  ID id = rb_intern(name);
+  VALUE vd;
+  if (rb_ivar_defined(obj, id) && !NIL_P(vd = rb_ivar_get(obj, id))) return vd;
+  Data_Get_Struct(obj, gsl_cheb_series, cs);
+  d = gsl_cheb_alloc(cs->order);
+  vd = Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_cheb_free, d);
+  (*calc)(d, cs);
+  if (OBJ_FROZEN(obj)) return vd;
+  rb_obj_freeze(vd);
+  rb_ivar_set(obj, id, vd);
+  return vd;
+}
+
 static VALUE rb_gsl_cheb_eval(VALUE obj, VALUE xx)
 {
   gsl_cheb_series *p = NULL;
-  VALUE x, ary;
-  size_t i, j, n;
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
+  VALUE y;
 #ifdef HAVE_NARRAY_H
   struct NARRAY *na;
   double *ptr1, *ptr2;
+  size_t i, n;
 #endif
   Data_Get_Struct(obj, gsl_cheb_series, p);
-  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
   switch (TYPE(xx)) {
   case T_FIXNUM:
   case T_BIGNUM:
   case T_FLOAT:
     return rb_float_new(gsl_cheb_eval(p, NUM2DBL(xx)));
     break;
-  case T_ARRAY:
-    //    n = RARRAY(xx)->len;
-    n = RARRAY_LEN(xx);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      x = rb_ary_entry(xx, i);
-      Need_Float(xx);
-      rb_ary_store(ary, i, rb_float_new(gsl_cheb_eval(p, NUM2DBL(x))));
-    }
-    return ary;
-    break;
   default:
 #ifdef HAVE_NARRAY_H
     if (NA_IsNArray(xx)) {
       GetNArray(xx, na);
       ptr1 = (double*) na->ptr;
       n = na->total;
-      ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
-      ptr2 = NA_PTR_TYPE(ary,double*);
+      y = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
+      ptr2 = NA_PTR_TYPE(y,double*);
       for (i = 0; i < n; i++) ptr2[i] = gsl_cheb_eval(p, ptr1[i]);
-      return ary;
+      return y;
     }
 #endif
-    if (VECTOR_P(xx)) {
-      Data_Get_Struct(xx, gsl_vector, v);
-      vnew = gsl_vector_alloc(v->size);
-      for (i = 0; i < v->size; i++) {
-	gsl_vector_set(vnew, i, gsl_cheb_eval(p, gsl_vector_get(v, i)));
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    } else if (MATRIX_P(xx)) {
-      Data_Get_Struct(xx, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (j = 0; j < m->size2; j++) {
-	  gsl_matrix_set(mnew, i, j, gsl_cheb_eval(p, gsl_matrix_get(m, i, j)));
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      rb_raise(rb_eTypeError, "wrong argument type");
-    }
     break;
   }
-  return Qnil;   /* never reach here */
+  if ((y = rb_gsl_cheb_map_eval(p, NULL, p->order, xx)) == Qundef)
+    rb_raise(rb_eTypeError, "wrong argument type");
+  return y;
 }
 
 static VALUE rb_gsl_cheb_eval_err(VALUE obj, VALUE xx)
@@ -247,70 +406,39 @@ static VALUE rb_gsl_cheb_eval_err(VALUE obj, VALUE xx)
 static VALUE rb_gsl_cheb_eval_n(VALUE obj, VALUE nn, VALUE xx)
 {
   gsl_cheb_series *p = NULL;
-  VALUE x, ary;
-  size_t n, order, i, j;
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
+  size_t order;
+  VALUE y;
 #ifdef HAVE_NARRAY_H
   struct NARRAY *na;
   double *ptr1, *ptr2;
+  size_t i, n;
 #endif
   CHECK_FIXNUM(nn);
   order = FIX2INT(nn);
   Data_Get_Struct(obj, gsl_cheb_series, p);
-  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
   switch (TYPE(xx)) {
   case T_FIXNUM:
   case T_BIGNUM:
   case T_FLOAT:
     return rb_float_new(gsl_cheb_eval_n(p, order, NUM2DBL(xx)));
     break;
-  case T_ARRAY:
-    //    n = RARRAY(xx)->len;
-    n = RARRAY_LEN(xx);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      x = rb_ary_entry(xx, i);
-      Need_Float(xx);
-      rb_ary_store(ary, i, rb_float_new(gsl_cheb_eval_n(p, order, NUM2DBL(x))));
-    }
-    return ary;
-    break;
   default:
 #ifdef HAVE_NARRAY_H
     if (NA_IsNArray(xx)) {
       GetNArray(xx, na);
       ptr1 = (double*) na->ptr;
       n = na->total;
-      ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
-      ptr2 = NA_PTR_TYPE(ary,double*);
+      y = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
+      ptr2 = NA_PTR_TYPE(y,double*);
       for (i = 0; i < n; i++) ptr2[i] = gsl_cheb_eval_n(p, order, ptr1[i]);
-      return ary;
+      return y;
     }
 #endif
-    if (VECTOR_P(xx)) {
-      Data_Get_Struct(xx, gsl_vector, v);
-      vnew = gsl_vector_alloc(v->size);
-      for (i = 0; i < v->size; i++) {
-	gsl_vector_set(vnew, i, gsl_cheb_eval_n(p, order, gsl_vector_get(v, i)));
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    } else if (MATRIX_P(xx)) {
-      Data_Get_Struct(xx, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (j = 0; j < m->size2; j++) {
-	  gsl_matrix_set(mnew, i, j, 
-			 gsl_cheb_eval_n(p, order, gsl_matrix_get(m, i, j)));
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      rb_raise(rb_eTypeError, "wrong argument type");
-    }
     break;
   }
-  return Qnil;   /* never reach here */
+  if ((y = rb_gsl_cheb_map_eval(p, NULL, order, xx)) == Qundef)
+    rb_raise(rb_eTypeError, "wrong argument type");
+  return y;
 }
 
 static VALUE rb_gsl_cheb_eval_n_err(VALUE obj, VALUE nn, VALUE xx)
@@ -402,6 +530,49 @@ static VALUE rb_gsl_cheb_eval_n_err(VALUE obj, VALUE nn, VALUE xx)
   return Qnil;   /* never reach here */
 }
 
+static VALUE rb_gsl_cheb_deriv_series(VALUE obj)
+{
+  return rb_gsl_cheb_cached(obj, "@deriv", gsl_cheb_calc_deriv);
+}
+
+static VALUE rb_gsl_cheb_integ_series(VALUE obj)
+{
+  return rb_gsl_cheb_cached(obj, "@integ", gsl_cheb_calc_integ);
+}
+
+/* The derivative (or integral) at x, by the cached series */
+static VALUE rb_gsl_cheb_eval_deriv(VALUE obj, VALUE xx)
+{
+  return rb_gsl_cheb_eval(rb_gsl_cheb_deriv_series(obj), xx);
+}
+
+static VALUE rb_gsl_cheb_eval_integ(VALUE obj, VALUE xx)
+{
+  return rb_gsl_cheb_eval(rb_gsl_cheb_integ_series(obj), xx);
+}
+
+/* [f(x), f'(x)], both series run in the same loop */
+static VALUE rb_gsl_cheb_eval_fdf(VALUE obj, VALUE xx)
+{
+  gsl_cheb_series *p = NULL, *d = NULL;
+  VALUE vd, y;
+  Data_Get_Struct(obj, gsl_cheb_series, p);
+  vd = rb_gsl_cheb_deriv_series(obj);
+  Data_Get_Struct(vd, gsl_cheb_series, d);
+  switch (TYPE(xx)) {
+  case T_FIXNUM:
+  case T_BIGNUM:
+  case T_FLOAT:
+    return rb_ary_new3(2, rb_float_new(gsl_cheb_eval(p, NUM2DBL(xx))),
+		       rb_float_new(gsl_cheb_eval(d, NUM2DBL(xx))));
+  default:
+    break;
+  }
+  if ((y = rb_gsl_cheb_map_eval(p, d, p->order, xx)) == Qundef)
+    rb_raise(rb_eTypeError, "wrong argument type");
+  return y;
+}
+
 static VALUE rb_gsl_cheb_calc_deriv(int argc, VALUE *argv, VALUE obj)
 {
   gsl_cheb_series *deriv = NULL, *cs = NULL;
@@ -439,8 +610,7 @@ static VALUE rb_gsl_cheb_calc_deriv(int argc, VALUE *argv, VALUE obj)
     Data_Get_Struct(obj, gsl_cheb_series, cs);
     switch (argc) {
     case 0:
-      deriv = gsl_cheb_alloc(cs->order);
-      retval = Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_cheb_free, deriv);
+      return rb_gsl_cheb_deriv_series(obj);
       break;
     case 1:
       if (!rb_obj_is_kind_of(argv[0], cgsl_cheb)) 
@@ -455,6 +625,7 @@ static VALUE rb_gsl_cheb_calc_deriv(int argc, VALUE *argv, VALUE obj)
     }
     break;
   }
+  rb_check_frozen(retval);
   gsl_cheb_calc_deriv(deriv, cs);
   return retval;
 }
@@ -496,8 +667,7 @@ static VALUE rb_gsl_cheb_calc_integ(int argc, VALUE *argv, VALUE obj)
     Data_Get_Struct(obj, gsl_cheb_series, cs);
     switch (argc) {
     case 0:
-      deriv = gsl_cheb_alloc(cs->order);
-      retval = Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_cheb_free, deriv);
+      return rb_gsl_cheb_integ_series(obj);
       break;
     case 1:
       if (!rb_obj_is_kind_of(argv[0], cgsl_cheb)) 
@@ -512,6 +682,7 @@ static VALUE rb_gsl_cheb_calc_integ(int argc, VALUE *argv, VALUE obj)
     }
     break;
   }
+  rb_check_frozen(retval);
   gsl_cheb_calc_integ(deriv, cs);
   return retval;
 }
@@ -536,6 +707,9 @@ void Init_gsl_cheb(VALUE module)
   rb_define_alias(cgsl_cheb, "deriv", "calc_deriv");
   rb_define_method(cgsl_cheb, "calc_integ", rb_gsl_cheb_calc_integ, -1);
   rb_define_alias(cgsl_cheb, "integ", "calc_integ");
+  rb_define_method(cgsl_cheb, "eval_deriv", rb_gsl_cheb_eval_deriv, 1);
+  rb_define_method(cgsl_cheb, "eval_integ", rb_gsl_cheb_eval_integ, 1);
+  rb_define_method(cgsl_cheb, "eval_fdf", rb_gsl_cheb_eval_fdf, 1);
 
   rb_define_singleton_method(cgsl_cheb, "calc_deriv", rb_gsl_cheb_calc_deriv, -1);
   rb_define_singleton_method(cgsl_cheb, "calc_integ", rb_gsl_cheb_calc_integ, -1);
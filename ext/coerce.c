@@ -0,0 +1,160 @@
+/*
+  coerce.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Numeric-first operators on GSL objects, without touching Integer or
+  Float: the coerce of Vector, Matrix, Tensor and Poly (and their Int and
+  Complex kinds) answers an Integer or Float x with a GSL::Oper::Scalar
+  holding x, whose operators do what the GSL object means,
+
+    2*v      # v.scale(2)
+    2/p      # GSL::Rational of the Poly p
+    1.0/c    # c.scale(1/|c|^2) for a Vector::Col, Vector::Int::Col
+    3 - m    # as before: the class's coerce fills a Matrix with 3
+
+  while Integer#* and Float#/ between numbers never leave their C
+  paths.  An operator the Scalar does not know is applied to the pair
+  the class's own coerce makes of x.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_poly.h"
+
+static VALUE cgsl_oper_scalar;
+
+#define COERCE_MAX 16
+
+/* The coerce of each class given to rb_gsl_define_coerce() */
+static struct {
+  VALUE klass;
+  rb_gsl_coerce_func fill;
+} coerce_table[COERCE_MAX];
+static int coerce_count = 0;
+
+typedef struct {
+  VALUE x;
+  rb_gsl_coerce_func fill;
+} gsl_oper_scalar;
+
+static ID id_scale, id_dnrm2, id_to_f, id_new, id_aref, id_aset;
+
+static void gsl_oper_scalar_mark(gsl_oper_scalar *s)
+{
+  rb_gc_mark(s->x);
+}
+
+static rb_gsl_coerce_func coerce_lookup(VALUE obj)
+{
+  int i;
+  for (i = coerce_count - 1; i >= 0; i--)
+    if (rb_obj_is_kind_of(obj, coerce_table[i].klass)) return coerce_table[i].fill;
+  rb_raise(rb_eTypeError, "cannot coerce with %s", rb_class2name(CLASS_OF(obj)));
+  return NULL;
+}
+
+static VALUE rb_gsl_coerce(VALUE obj, VALUE other)
+{
+  rb_gsl_coerce_func fill = coerce_lookup(obj);
+  gsl_oper_scalar *s;
+  VALUE vs;
+  if (RB_INTEGER_TYPE_P(other) || RB_FLOAT_TYPE_P(other)) {
+    vs = Data_Make_Struct(cgsl_oper_scalar, gsl_oper_scalar, gsl_oper_scalar_mark,
+			  RUBY_DEFAULT_FREE, s);
+    s->x = other;
+    s->fill = fill;
+    return rb_ary_new3(2, vs, obj);
+  }
+  return (*fill)(obj, other);
+}
+
+/*
+  Defines klass#coerce: fill(obj, other) makes the pair, as a coerce
+  method does; an Integer or Float is answered with a GSL::Oper::Scalar.
+  Subclasses registered later take precedence.
+*/
+void rb_gsl_define_coerce(VALUE klass, rb_gsl_coerce_func fill)
+{
+  if (coerce_count == COERCE_MAX)
+    rb_raise(rb_eRuntimeError, "too many coerce functions");
+  coerce_table[coerce_count].klass = klass;
+  coerce_table[coerce_count].fill = fill;
+  coerce_count++;
+  rb_define_method(klass, "coerce", rb_gsl_coerce, 1);
+}
+
+/* x op obj through the pair the class's coerce makes */
+static VALUE gsl_oper_scalar_apply(VALUE self, ID op, VALUE obj)
+{
+  gsl_oper_scalar *s;
+  VALUE pair;
+  Data_Get_Struct(self, gsl_oper_scalar, s);
+  pair = (*s->fill)(obj, s->x);
+  Check_Type(pair, T_ARRAY);
+  return rb_funcall(rb_ary_entry(pair, 0), op, 1, rb_ary_entry(pair, 1));
+}
+
+static VALUE gsl_oper_scalar_mul(VALUE self, VALUE obj)
+{
+  gsl_oper_scalar *s;
+  Data_Get_Struct(self, gsl_oper_scalar, s);
+  return rb_funcall(obj, id_scale, 1, s->x);
+}
+
+static VALUE gsl_oper_scalar_div(VALUE self, VALUE obj)
+{
+  gsl_oper_scalar *s;
+  VALUE a, v;
+  double nrm;
+  Data_Get_Struct(self, gsl_oper_scalar, s);
+  if (rb_obj_is_kind_of(obj, cgsl_poly) || rb_obj_is_kind_of(obj, cgsl_poly_int)) {
+    a = rb_funcall(cgsl_poly, id_aref, 1, INT2FIX(1));
+    rb_funcall(a, id_aset, 2, INT2FIX(0), s->x);
+    return rb_funcall(cgsl_rational, id_new, 2, a, obj);
+  }
+  if (rb_obj_is_kind_of(obj, cgsl_vector_col) || rb_obj_is_kind_of(obj, cgsl_vector_int_col)) {
+    v = rb_obj_is_kind_of(obj, cgsl_vector_col) ? obj : rb_funcall(obj, id_to_f, 0);
+    nrm = NUM2DBL(rb_funcall(v, id_dnrm2, 0));
+    return rb_funcall(v, id_scale, 1, rb_float_new(1.0/(nrm*nrm)));
+  }
+  return gsl_oper_scalar_apply(self, '/', obj);
+}
+
+/* Object#<=> would answer nil */
+static VALUE gsl_oper_scalar_cmp(VALUE self, VALUE obj)
+{
+  return gsl_oper_scalar_apply(self, rb_intern("<=>"), obj);
+}
+
+static VALUE gsl_oper_scalar_method_missing(int argc, VALUE *argv, VALUE self)
+{
+  if (argc != 2) return rb_call_super(argc, argv);
+  return gsl_oper_scalar_apply(self, SYM2ID(argv[0]), argv[1]);
+}
+
+void Init_gsl_coerce(VALUE module)
+{
+  VALUE mgsl_oper;
+  mgsl_oper = rb_define_module_under(module, "Oper");
+  cgsl_oper_scalar = rb_define_class_under(mgsl_oper, "Scalar", rb_cObject);
+  rb_undef_alloc_func(cgsl_oper_scalar);
+  rb_define_method(cgsl_oper_scalar, "*", gsl_oper_scalar_mul, 1);
+  rb_define_method(cgsl_oper_scalar, "/", gsl_oper_scalar_div, 1);
+  rb_define_method(cgsl_oper_scalar, "<=>", gsl_oper_scalar_cmp, 1);
+  rb_define_method(cgsl_oper_scalar, "method_missing", gsl_oper_scalar_method_missing, -1);
+
+  id_scale = rb_intern("scale");
+  id_dnrm2 = rb_intern("dnrm2");
+  id_to_f = rb_intern("to_f");
+  id_new = rb_intern("new");
+  id_aref = rb_intern("[]");
+  id_aset = rb_intern("[]=");
+}
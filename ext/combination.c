@@ -14,7 +14,7 @@
 #include "rb_gsl_common.h"
 #include "rb_gsl_array.h"
 
-static VALUE cgsl_combination_data;
+static VALUE cgsl_combination, cgsl_combination_data;
 
 static VALUE rb_gsl_combination_new(VALUE klass, VALUE n, VALUE k)
 {
@@ -243,9 +243,66 @@ static VALUE rb_gsl_combination_equal(VALUE obj, VALUE other)
   return Qtrue;
 }
 
+/*
+  Traversal without an object per step.
+
+    c = GSL::Combination.alloc(n, k)
+    c.each_combination { |v| ... }     # v is overwritten at every step
+    m, more = c.batch(1000)            # GSL::Matrix::Int, one per row
+
+  each_combination yields the combinations from the current one of c to
+  the last in lexicographic order, c being left as it is.  The object
+  yielded is the same Combination throughout, rewritten in place: clone
+  it to keep one.  Without a block an Enumerator is returned.  batch(n)
+  writes the current combination of c and the following ones, n at most,
+  into the rows of a GSL::Matrix::Int and advances c past them; more is
+  false when the last combination is in the matrix, which then may have
+  fewer than n rows.
+*/
+static VALUE rb_gsl_combination_each_combination(VALUE obj)
+{
+  gsl_combination *c, *state, *view;
+  VALUE vstate, vview;
+  RETURN_ENUMERATOR(obj, 0, 0);
+  Data_Get_Struct(obj, gsl_combination, c);
+  state = gsl_combination_alloc(c->n, c->k);
+  vstate = Data_Wrap_Struct(cgsl_combination, 0, gsl_combination_free, state);
+  view = gsl_combination_alloc(c->n, c->k);
+  vview = Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_combination_free, view);
+  memcpy(state->data, c->data, sizeof(size_t)*c->k);
+  do {
+    memcpy(view->data, state->data, sizeof(size_t)*state->k);
+    rb_yield(vview);
+  } while (gsl_combination_next(state) == GSL_SUCCESS);
+  RB_GC_GUARD(vstate);
+  return obj;
+}
+
+static VALUE rb_gsl_combination_batch(VALUE obj, VALUE nn)
+{
+  gsl_combination *c;
+  gsl_matrix_int *m;
+  size_t n, i, j;
+  int more = 1;
+  VALUE vm;
+  Data_Get_Struct(obj, gsl_combination, c);
+  n = NUM2SIZET(nn);
+  if (n == 0) rb_raise(rb_eArgError, "batch size must be positive");
+  if (c->k == 0) rb_raise(rb_eArgError, "empty combination");
+  m = gsl_matrix_int_alloc(n, c->k);
+  vm = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, m);
+  for (i = 0; i < n && more; ) {
+    for (j = 0; j < c->k; j++) m->data[i*m->tda + j] = (int) c->data[j];
+    i++;
+    more = (gsl_combination_next(c) == GSL_SUCCESS);
+  }
+  /* the last batch: the rows past i are never looked at */
+  m->size1 = i;
+  return rb_ary_new3(2, vm, more ? Qtrue : Qfalse);
+}
+
 void Init_gsl_combination(VALUE module)
 {
-  VALUE cgsl_combination;
   cgsl_combination = rb_define_class_under(module, "Combination", cGSL_Object);
   cgsl_combination_data = rb_define_class_under(cgsl_combination, "Data", 
 						cgsl_permutation);
@@ -270,6 +327,8 @@ void Init_gsl_combination(VALUE module)
   rb_define_method(cgsl_combination, "valid?", rb_gsl_combination_valid2, 0);
   rb_define_method(cgsl_combination, "next", rb_gsl_combination_next, 0);
   rb_define_method(cgsl_combination, "prev", rb_gsl_combination_prev, 0);
+  rb_define_method(cgsl_combination, "each_combination", rb_gsl_combination_each_combination, 0);
+  rb_define_method(cgsl_combination, "batch", rb_gsl_combination_batch, 1);
 
   rb_define_method(cgsl_combination, "fwrite", rb_gsl_combination_fwrite, 1);
   rb_define_method(cgsl_combination, "fread", rb_gsl_combination_fread, 1);
@@ -234,6 +234,12 @@ double* get_ptr_double3(VALUE obj, size_t *size, size_t *stride, int *flag)
     *flag = 1;
     return ptr;
   }
+#endif
+#ifdef HAVE_NUMO_NARRAY_H
+  if (rb_gsl_numo_p(obj)) {
+    *flag = 0;
+    return rb_gsl_numo_vector_ptr(obj, stride, size);
+  }
 #endif
   CHECK_VECTOR(obj);
   Data_Get_Struct(obj, gsl_vector, v);
@@ -291,6 +297,111 @@ VALUE matrix_eval_create(VALUE obj, double (*func)(double))
   return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
 }
 
+/* Writes func(x) for every element of obj into out, a vector of the same
+   size (it may be obj itself). Returns out. */
+VALUE vector_eval_into(VALUE obj, VALUE out, double (*func)(double))
+{
+  gsl_vector *vout;
+  size_t i, size, stride;
+  double *ptr;
+  ptr = get_vector_ptr(obj, &stride, &size);
+  CHECK_VECTOR(out);
+  Data_Get_Struct(out, gsl_vector, vout);
+  if (vout->size != size) 
+    rb_raise(rb_eArgError, "output vector size must be %d", (int) size);
+  for (i = 0; i < size; i++) 
+    vout->data[i*vout->stride] = (*func)(ptr[i*stride]);
+  return out;
+}
+
+VALUE matrix_eval_into(VALUE obj, VALUE out, double (*func)(double))
+{
+  gsl_matrix *m, *mout;
+  size_t i, j;
+  Data_Get_Struct(obj, gsl_matrix, m);
+  CHECK_MATRIX(out);
+  Data_Get_Struct(out, gsl_matrix, mout);
+  if (mout->size1 != m->size1 || mout->size2 != m->size2)
+    rb_raise(rb_eArgError, "output matrix must be %d x %d", 
+	     (int) m->size1, (int) m->size2);
+  for (i = 0; i < m->size1; i++) {
+    for (j = 0; j < m->size2; j++) {
+      mout->data[i*mout->tda + j] = (*func)(m->data[i*m->tda + j]);
+    }
+  }
+  return out;
+}
+
+/* Optional output buffer of elementwise methods, given either directly
+   or as {:out => buf}. Returns Qnil if none. */
+VALUE rb_gsl_out_arg(VALUE arg)
+{
+  if (TYPE(arg) == T_HASH) return rb_hash_aref(arg, ID2SYM(rb_intern("out")));
+  return arg;
+}
+
+/*
+  View objects handed to the Ruby procs of the solvers (multimin,
+  multiroots, multifit).  The object is created once, kept at ary[i] of
+  the function's params Array, and repointed at GSL's vector or matrix
+  for each call; *saved receives the previous header, which the
+  _restore functions put back afterwards so that a nested call of the
+  same function leaves the outer views intact.
+*/
+VALUE rb_gsl_callback_vector(VALUE ary, long i, VALUE klass, const gsl_vector *v,
+			     gsl_vector *saved)
+{
+  VALUE vv;
+  gsl_vector_view *view = NULL;
+  vv = rb_ary_entry(ary, i);
+  if (NIL_P(vv)) {
+    view = gsl_vector_view_alloc();
+    memset(&view->vector, 0, sizeof(gsl_vector));
+    vv = Data_Wrap_Struct(klass, 0, gsl_vector_view_free, view);
+    rb_ary_store(ary, i, vv);
+  } else {
+    Data_Get_Struct(vv, gsl_vector_view, view);
+  }
+  *saved = view->vector;
+  view->vector = *v;
+  view->vector.owner = 0;
+  return vv;
+}
+
+void rb_gsl_callback_vector_restore(VALUE vv, const gsl_vector *saved)
+{
+  gsl_vector_view *view = NULL;
+  Data_Get_Struct(vv, gsl_vector_view, view);
+  view->vector = *saved;
+}
+
+VALUE rb_gsl_callback_matrix(VALUE ary, long i, VALUE klass, const gsl_matrix *m,
+			     gsl_matrix *saved)
+{
+  VALUE vm;
+  gsl_matrix_view *view = NULL;
+  vm = rb_ary_entry(ary, i);
+  if (NIL_P(vm)) {
+    view = gsl_matrix_view_alloc();
+    memset(&view->matrix, 0, sizeof(gsl_matrix));
+    vm = Data_Wrap_Struct(klass, 0, gsl_matrix_view_free, view);
+    rb_ary_store(ary, i, vm);
+  } else {
+    Data_Get_Struct(vm, gsl_matrix_view, view);
+  }
+  *saved = view->matrix;
+  view->matrix = *m;
+  view->matrix.owner = 0;
+  return vm;
+}
+
+void rb_gsl_callback_matrix_restore(VALUE vm, const gsl_matrix *saved)
+{
+  gsl_matrix_view *view = NULL;
+  Data_Get_Struct(vm, gsl_matrix_view, view);
+  view->matrix = *saved;
+}
+
 VALUE rb_gsl_ary_eval1(VALUE ary, double (*f)(double))
 {
   VALUE ary2;
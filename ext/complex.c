@@ -48,13 +48,17 @@ gsl_complex rb_gsl_obj_to_gsl_complex(VALUE obj, gsl_complex *z)
   case T_BIGNUM:
     *z = gsl_complex_rect(NUM2DBL(obj), 0.0);
     break;
+  case T_COMPLEX:
+    *z = gsl_complex_rect(NUM2DBL(rb_funcall(obj, rb_intern("real"), 0)),
+			  NUM2DBL(rb_funcall(obj, rb_intern("imaginary"), 0)));
+    break;
   default:
     if (rb_obj_is_kind_of(obj, cgsl_complex)) {
       Data_Get_Struct(obj, gsl_complex, zz);
       *z = *zz;
     } else {
       rb_raise(rb_eTypeError,
-          "wrong type %s, (nil, Array, Float, Integer, or GSL::Complex expected)",
+          "wrong type %s, (nil, Array, Float, Integer, Complex or GSL::Complex expected)",
           rb_class2name(CLASS_OF(obj)));
     }
     break;
@@ -62,6 +66,12 @@ gsl_complex rb_gsl_obj_to_gsl_complex(VALUE obj, gsl_complex *z)
   return *z;
 }
 
+/* z as a Ruby Complex, whose Float parts need no allocation */
+VALUE rb_gsl_complex_to_c(gsl_complex z)
+{
+  return rb_Complex(rb_float_new(GSL_REAL(z)), rb_float_new(GSL_IMAG(z)));
+}
+
 static VALUE rb_gsl_complex_new(int argc, VALUE *argv, VALUE klass)
 {
   gsl_complex *c = NULL;
@@ -79,6 +89,9 @@ static VALUE rb_gsl_complex_new(int argc, VALUE *argv, VALUE klass)
       Need_Float(argv[0]);
       *c = gsl_complex_rect(NUM2DBL(argv[0]), 0.0);
       break;
+    case T_COMPLEX:
+      *c = rb_gsl_obj_to_gsl_complex(argv[0], NULL);
+      break;
     default:
       rb_raise(rb_eTypeError, "wrong argument type %s", 
 	       rb_class2name(CLASS_OF(argv[0])));
@@ -253,6 +266,68 @@ static VALUE rb_gsl_complex_div_imag(VALUE obj, VALUE xx)
   return rb_gsl_complex_arithmetics2(gsl_complex_div_imag, obj, xx);
 }
 
+/*
+  In place: z.add!(w), z.sub!(w), z.mul!(w), z.div!(w) set z to z op w
+  (w a GSL::Complex, Complex, Float, Integer or [re, im]) and return z,
+  so that an accumulation does not allocate a GSL::Complex per step
+*/
+static VALUE rb_gsl_complex_arithmetics_bang(gsl_complex (*func)(gsl_complex, gsl_complex),
+					     VALUE obj, VALUE bb)
+{
+  gsl_complex *a = NULL, b;
+  rb_check_frozen(obj);
+  Data_Get_Struct(obj, gsl_complex, a);
+  b = rb_gsl_obj_to_gsl_complex(bb, NULL);
+  *a = (*func)(*a, b);
+  return obj;
+}
+
+static VALUE rb_gsl_complex_add_bang(VALUE obj, VALUE bb)
+{
+  return rb_gsl_complex_arithmetics_bang(gsl_complex_add, obj, bb);
+}
+
+static VALUE rb_gsl_complex_sub_bang(VALUE obj, VALUE bb)
+{
+  return rb_gsl_complex_arithmetics_bang(gsl_complex_sub, obj, bb);
+}
+
+static VALUE rb_gsl_complex_mul_bang(VALUE obj, VALUE bb)
+{
+  return rb_gsl_complex_arithmetics_bang(gsl_complex_mul, obj, bb);
+}
+
+static VALUE rb_gsl_complex_div_bang(VALUE obj, VALUE bb)
+{
+  return rb_gsl_complex_arithmetics_bang(gsl_complex_div, obj, bb);
+}
+
+/* z.set(re, im), z.set(w): overwrites z */
+static VALUE rb_gsl_complex_set(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_complex *c = NULL;
+  rb_check_frozen(obj);
+  Data_Get_Struct(obj, gsl_complex, c);
+  switch (argc) {
+  case 1:
+    *c = rb_gsl_obj_to_gsl_complex(argv[0], NULL);
+    break;
+  case 2:
+    *c = gsl_complex_rect(NUM2DBL(argv[0]), NUM2DBL(argv[1]));
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_complex_to_c_method(VALUE obj)
+{
+  gsl_complex *c = NULL;
+  Data_Get_Struct(obj, gsl_complex, c);
+  return rb_gsl_complex_to_c(*c);
+}
+
 static VALUE rb_gsl_complex_operate(gsl_complex (*func)(gsl_complex), VALUE obj);
 static VALUE rb_gsl_complex_operate2(gsl_complex (*func)(gsl_complex), int argc, VALUE *argv, VALUE obj);
 
@@ -912,6 +987,13 @@ void Init_gsl_complex(VALUE module)
   rb_define_method(cgsl_complex, "mul_imag", rb_gsl_complex_mul_imag, 1);
   rb_define_method(cgsl_complex, "div_imag", rb_gsl_complex_div_imag, 1);
 
+  rb_define_method(cgsl_complex, "add!", rb_gsl_complex_add_bang, 1);
+  rb_define_method(cgsl_complex, "sub!", rb_gsl_complex_sub_bang, 1);
+  rb_define_method(cgsl_complex, "mul!", rb_gsl_complex_mul_bang, 1);
+  rb_define_method(cgsl_complex, "div!", rb_gsl_complex_div_bang, 1);
+  rb_define_method(cgsl_complex, "set", rb_gsl_complex_set, -1);
+  rb_define_method(cgsl_complex, "to_c", rb_gsl_complex_to_c_method, 0);
+
   rb_define_method(cgsl_complex, "conjugate", rb_gsl_complex_conjugate, 0);
   rb_define_alias(cgsl_complex, "conj", "conjugate");
   rb_define_method(cgsl_complex, "inverse", rb_gsl_complex_inverse, 0);
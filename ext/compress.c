@@ -0,0 +1,342 @@
+/*
+  compress.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Compressed binary I/O behind Histogram#fwrite, #fwrite2 and
+  Matrix#fwrite given :compress (GSL::COMPRESS_CODECS lists the codecs
+  this library was built with):
+
+    h.fwrite("h.dat", :compress => :zstd, :level => 3)
+    m.fwrite(file, :compress => :lz4)
+    h2.fread("h.dat")
+
+  The elements are cut in chunks of RB_GSL_ZCHUNK bytes, each
+  byte-shuffled (the first bytes of all its elements, then the second
+  bytes ...), which turns runs of zeros and the slowly varying
+  exponents into long runs, then compressed on its own:
+
+    "\211GZ\032"  magic
+    version, codec, element size, 0
+    per chunk: raw length, stored length (little-endian uint32), data
+    a raw length of 0 ends the stream
+
+  A chunk that does not shrink is stored as is.  The readers detect the
+  magic and decompress one chunk at a time into the destination, in a
+  single pass with three chunk-sized buffers; anything else is read as
+  the raw elements GSL writes.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_common.h"
+#include <string.h>
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+#define RB_GSL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#if defined(HAVE_LZ4_H) && defined(HAVE_LIBLZ4)
+#define RB_GSL_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#define RB_GSL_ZCHUNK (1 << 20)
+#define RB_GSL_ZVERSION 1
+
+static const unsigned char zmagic[4] = {0x89, 'G', 'Z', 0x1a};
+
+/* A position in the segments of a read or a write */
+struct zcursor {
+  void *const *seg;
+  const size_t *len;            /* in bytes */
+  size_t nseg, i, off;
+};
+
+static size_t zcursor_copy(struct zcursor *c, char *buf, size_t n, int in)
+{
+  size_t m, done = 0;
+  while (done < n && c->i < c->nseg) {
+    m = GSL_MIN(n - done, c->len[c->i] - c->off);
+    if (in) memcpy((char *) c->seg[c->i] + c->off, buf + done, m);
+    else memcpy(buf + done, (char *) c->seg[c->i] + c->off, m);
+    done += m;
+    c->off += m;
+    if (c->off == c->len[c->i]) { c->i++; c->off = 0; }
+  }
+  return done;
+}
+
+/* Expanded for the element sizes of doubles and ints, where the
+   constant stride lets the compiler unroll the inner loop */
+#define ZSHUFFLE(src, dst, k, esize, dir) do {			\
+    size_t i_, b_;						\
+    for (i_ = 0; i_ < (k); i_++)				\
+      for (b_ = 0; b_ < (esize); b_++) {			\
+	if (dir) (dst)[b_*(k) + i_] = (src)[i_*(esize) + b_];	\
+	else (dst)[i_*(esize) + b_] = (src)[b_*(k) + i_];	\
+      }								\
+  } while (0)
+
+static void zshuffle(const unsigned char *src, unsigned char *dst, size_t n, size_t esize)
+{
+  size_t k = n/esize;
+  if (esize == 8) ZSHUFFLE(src, dst, k, 8, 1);
+  else if (esize == 4) ZSHUFFLE(src, dst, k, 4, 1);
+  else ZSHUFFLE(src, dst, k, esize, 1);
+}
+
+static void zunshuffle(const unsigned char *src, unsigned char *dst, size_t n, size_t esize)
+{
+  size_t k = n/esize;
+  if (esize == 8) ZSHUFFLE(src, dst, k, 8, 0);
+  else if (esize == 4) ZSHUFFLE(src, dst, k, 4, 0);
+  else ZSHUFFLE(src, dst, k, esize, 0);
+}
+
+static void zput32(unsigned char *p, size_t v)
+{
+  p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = (v >> 24) & 0xff;
+}
+
+static size_t zget32(const unsigned char *p)
+{
+  return (size_t) p[0] | ((size_t) p[1] << 8) | ((size_t) p[2] << 16) | ((size_t) p[3] << 24);
+}
+
+static size_t zbound(int codec, size_t n)
+{
+  switch (codec) {
+#ifdef RB_GSL_HAVE_ZSTD
+  case RB_GSL_CODEC_ZSTD: return ZSTD_compressBound(n);
+#endif
+#ifdef RB_GSL_HAVE_LZ4
+  case RB_GSL_CODEC_LZ4: return (size_t) LZ4_compressBound((int) n);
+#endif
+  default: return n;
+  }
+}
+
+/* Compressed length, 0 where the chunk is to be stored as is */
+static size_t zcompress(int codec, int level, const char *src, size_t n, char *dst, size_t cap)
+{
+  switch (codec) {
+#ifdef RB_GSL_HAVE_ZSTD
+  case RB_GSL_CODEC_ZSTD: {
+    size_t m = ZSTD_compress(dst, cap, src, n, level);
+    return ZSTD_isError(m) || m >= n ? 0 : m;
+  }
+#endif
+#ifdef RB_GSL_HAVE_LZ4
+  case RB_GSL_CODEC_LZ4: {
+    int m = LZ4_compress_fast(src, dst, (int) n, (int) cap, GSL_MAX(level, 1));
+    return m <= 0 || (size_t) m >= n ? 0 : (size_t) m;
+  }
+#endif
+  default: return 0;
+  }
+}
+
+static int zdecompress(int codec, const char *src, size_t m, char *dst, size_t n)
+{
+  switch (codec) {
+#ifdef RB_GSL_HAVE_ZSTD
+  case RB_GSL_CODEC_ZSTD:
+    return ZSTD_decompress(dst, n, src, m) == n;
+#endif
+#ifdef RB_GSL_HAVE_LZ4
+  case RB_GSL_CODEC_LZ4:
+    return LZ4_decompress_safe(src, dst, (int) m, (int) n) == (int) n;
+#endif
+  default: return 0;
+  }
+}
+
+static int zcodec_available(int codec)
+{
+  switch (codec) {
+#ifdef RB_GSL_HAVE_ZSTD
+  case RB_GSL_CODEC_ZSTD: return 1;
+#endif
+#ifdef RB_GSL_HAVE_LZ4
+  case RB_GSL_CODEC_LZ4: return 1;
+#endif
+  default: return 0;
+  }
+}
+
+/*
+  Writes the nseg segments seg[i] of len[i] elements of esize bytes,
+  compressed with codec, raw as GSL does for RB_GSL_CODEC_NONE.
+  Returns a GSL status.
+*/
+int rb_gsl_zfwrite(FILE *f, int codec, int level, size_t esize,
+		   void *const *seg, const size_t *len, size_t nseg)
+{
+  struct zcursor c;
+  size_t *bytes, i, n, m, cap;
+  unsigned char hdr[8];
+  char *raw = NULL, *shuf = NULL, *out = NULL;
+  int status = GSL_SUCCESS;
+  if (codec == RB_GSL_CODEC_NONE) {
+    for (i = 0; i < nseg; i++)
+      if (len[i] && fwrite(seg[i], esize, len[i], f) != len[i])
+	GSL_ERROR("fwrite failed", GSL_EFAILED);
+    return GSL_SUCCESS;
+  }
+  bytes = ALLOC_N(size_t, nseg);
+  for (i = 0; i < nseg; i++) bytes[i] = len[i]*esize;
+  c.seg = seg; c.len = bytes; c.nseg = nseg; c.i = 0; c.off = 0;
+  memcpy(hdr, zmagic, 4);
+  hdr[4] = RB_GSL_ZVERSION; hdr[5] = (unsigned char) codec;
+  hdr[6] = (unsigned char) esize; hdr[7] = 0;
+  cap = zbound(codec, RB_GSL_ZCHUNK);
+  raw = ALLOC_N(char, RB_GSL_ZCHUNK);
+  shuf = ALLOC_N(char, RB_GSL_ZCHUNK);
+  out = ALLOC_N(char, cap);
+  if (fwrite(hdr, 1, 8, f) != 8) status = GSL_EFAILED;
+  while (status == GSL_SUCCESS) {
+    n = zcursor_copy(&c, raw, RB_GSL_ZCHUNK, 0);
+    zput32(hdr, n);
+    if (n == 0) {
+      if (fwrite(hdr, 1, 4, f) != 4) status = GSL_EFAILED;
+      break;
+    }
+    zshuffle((unsigned char *) raw, (unsigned char *) shuf, n, esize);
+    m = zcompress(codec, level, shuf, n, out, cap);
+    zput32(hdr + 4, m ? m : n);
+    if (fwrite(hdr, 1, 8, f) != 8 || fwrite(m ? out : shuf, 1, m ? m : n, f) != (m ? m : n))
+      status = GSL_EFAILED;
+  }
+  xfree(out);
+  xfree(shuf);
+  xfree(raw);
+  xfree(bytes);
+  if (status) GSL_ERROR("fwrite failed", status);
+  return GSL_SUCCESS;
+}
+
+/*
+  Reads what rb_gsl_zfwrite wrote, compressed or raw, into the nseg
+  segments seg[i] of len[i] elements of esize bytes.  Returns a GSL
+  status.
+*/
+int rb_gsl_zfread(FILE *f, size_t esize, void *const *seg, const size_t *len, size_t nseg)
+{
+  struct zcursor c;
+  size_t *bytes, i, n, m, total = 0;
+  unsigned char hdr[8];
+  char *in = NULL, *shuf = NULL, *raw = NULL;
+  int codec = RB_GSL_CODEC_NONE, status = GSL_SUCCESS;
+  const char *reason = "fread failed";
+  bytes = ALLOC_N(size_t, nseg);
+  for (i = 0; i < nseg; i++) total += (bytes[i] = len[i]*esize);
+  c.seg = seg; c.len = bytes; c.nseg = nseg; c.i = 0; c.off = 0;
+  m = fread(hdr, 1, GSL_MIN(4, total), f);
+  if (m < GSL_MIN(4, total)) {
+    xfree(bytes);
+    GSL_ERROR("fread failed", GSL_EFAILED);
+  }
+  if (m < 4 || memcmp(hdr, zmagic, 4) != 0) {
+    /* raw elements: the 4 bytes read are their first */
+    zcursor_copy(&c, (char *) hdr, m, 1);
+    for (; c.i < c.nseg; c.i++, c.off = 0) {
+      n = c.len[c.i] - c.off;
+      if (fread((char *) c.seg[c.i] + c.off, 1, n, f) != n) { status = GSL_EFAILED; break; }
+    }
+    xfree(bytes);
+    if (status) GSL_ERROR("fread failed", status);
+    return GSL_SUCCESS;
+  }
+  if (fread(hdr + 4, 1, 4, f) != 4) status = GSL_EFAILED;
+  else if (hdr[4] != RB_GSL_ZVERSION || !zcodec_available(codec = hdr[5])) {
+    reason = "unknown compressed format or codec not built in";
+    status = GSL_EUNIMPL;
+  } else if (hdr[6] != esize) {
+    reason = "compressed data of another element type";
+    status = GSL_EBADLEN;
+  }
+  if (status == GSL_SUCCESS) {
+    in = ALLOC_N(char, zbound(codec, RB_GSL_ZCHUNK));
+    shuf = ALLOC_N(char, RB_GSL_ZCHUNK);
+    raw = ALLOC_N(char, RB_GSL_ZCHUNK);
+  }
+  while (status == GSL_SUCCESS) {
+    if (fread(hdr, 1, 4, f) != 4) { status = GSL_EFAILED; break; }
+    n = zget32(hdr);
+    if (n == 0) {
+      if (c.i < c.nseg) { reason = "compressed data too short"; status = GSL_EBADLEN; }
+      break;
+    }
+    if (fread(hdr + 4, 1, 4, f) != 4) { status = GSL_EFAILED; break; }
+    m = zget32(hdr + 4);
+    if (n > RB_GSL_ZCHUNK || n % esize || m > zbound(codec, RB_GSL_ZCHUNK) || m > n) {
+      reason = "corrupt compressed chunk";
+      status = GSL_EFAILED;
+      break;
+    }
+    if (fread(m < n ? in : shuf, 1, m, f) != m) { status = GSL_EFAILED; break; }
+    if (m < n && !zdecompress(codec, in, m, shuf, n)) {
+      reason = "corrupt compressed chunk";
+      status = GSL_EFAILED;
+      break;
+    }
+    zunshuffle((unsigned char *) shuf, (unsigned char *) raw, n, esize);
+    if (zcursor_copy(&c, raw, n, 1) != n) {
+      reason = "compressed data too long";
+      status = GSL_EBADLEN;
+    }
+  }
+  if (raw) xfree(raw);
+  if (shuf) xfree(shuf);
+  if (in) xfree(in);
+  xfree(bytes);
+  if (status) GSL_ERROR(reason, status);
+  return GSL_SUCCESS;
+}
+
+/*
+  The codec and level of the options hash of a fwrite: :compress is
+  :zstd, :lz4, true (the first built in) or nil; :level is the zstd
+  level (default 3) or the LZ4 acceleration (default 1)
+*/
+int rb_gsl_compress_options(VALUE opts, int *level)
+{
+  VALUE v;
+  int codec = RB_GSL_CODEC_NONE;
+  const char *name;
+  if (NIL_P(opts)) return codec;
+  Check_Type(opts, T_HASH);
+  v = rb_hash_aref(opts, ID2SYM(rb_intern("compress")));
+  if (NIL_P(v) || v == Qfalse) return codec;
+  if (v == Qtrue) {
+    codec = zcodec_available(RB_GSL_CODEC_ZSTD) ? RB_GSL_CODEC_ZSTD : RB_GSL_CODEC_LZ4;
+    name = "zstd nor lz4";
+  } else {
+    name = rb_id2name(SYM2ID(v = rb_to_symbol(v)));
+    if (strcmp(name, "zstd") == 0) codec = RB_GSL_CODEC_ZSTD;
+    else if (strcmp(name, "lz4") == 0) codec = RB_GSL_CODEC_LZ4;
+    else rb_raise(rb_eArgError, "unknown codec %s (:zstd or :lz4)", name);
+  }
+  if (!zcodec_available(codec))
+    rb_raise(rb_eNotImpError, "Ruby/GSL was built without %s", name);
+  v = rb_hash_aref(opts, ID2SYM(rb_intern("level")));
+  *level = NIL_P(v) ? (codec == RB_GSL_CODEC_ZSTD ? 3 : 1) : NUM2INT(v);
+  return codec;
+}
+
+void Init_gsl_compress(VALUE module)
+{
+  VALUE codecs = rb_ary_new();
+#ifdef RB_GSL_HAVE_ZSTD
+  rb_ary_push(codecs, ID2SYM(rb_intern("zstd")));
+#endif
+#ifdef RB_GSL_HAVE_LZ4
+  rb_ary_push(codecs, ID2SYM(rb_intern("lz4")));
+#endif
+  rb_define_const(module, "COMPRESS_CODECS", rb_ary_freeze(codecs));
+}
@@ -0,0 +1,639 @@
+/*
+  cqp_workspace.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::CQP::Workspace: the convex quadratic program
+
+    minimize 1/2 x^T Q x + q^T x   subject to  A x = b,  C x >= d
+
+  (the problem of GSL::CQP::Data) for sequences of related problems,
+  with Q, A and C dense (GSL::Matrix) or sparse (GSL::SpMatrix).
+
+    ws = GSL::CQP::Workspace.alloc(n, me, mi, :eps_abs => 1e-8)
+    ws.set(Q, q, A, b, C, d)
+    ws.solve                  # GSL::SUCCESS, or GSL::EMAXITER
+    ws.x; ws.lm_eq; ws.lm_ineq; ws.f; ws.iter; ws.residuals
+    ws.update(q2)             # new q (b, d), same matrices
+    ws.solve                  # starts from the previous x and multipliers
+
+  The method is ADMM on the constraints [A; C] x = z, l <= z <= u
+  (OSQP, Stellato et al. 2020), with the linear system of each step,
+  Q + sigma I + K^T R K, solved by Jacobi-preconditioned CG from the
+  previous x, so the matrices are only multiplied, never factorized.
+  rho is adapted every ADAPT_EVERY iterations to balance the residuals.
+  A solve starts from the state the last one left: x, z, the
+  multipliers and rho, unless reset or warm_start says otherwise.  All
+  the vectors are allocated once, by alloc; set converts sparse
+  matrices to compressed rows and keeps dense ones by reference.
+
+  The multipliers follow Q x + q = A^T lm_eq + C^T lm_ineq with
+  lm_ineq >= 0, as GSL::CQP::Minimizer reports them.  A solve runs
+  with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_blas.h>
+
+#define ADAPT_EVERY 25
+#define CHECK_EVERY 5
+#define RHO_EQ_SCALE 1e3
+#define RHO_MIN 1e-6
+#define RHO_MAX 1e6
+
+/* A dense or compressed-rows operand */
+typedef struct {
+  size_t rows, cols;
+  const gsl_matrix *dense;
+  mygsl_csr *csr;
+} cqp_op;
+
+typedef struct {
+  size_t n, me, mi, m;
+  VALUE vQ, vA, vC;          /* the dense operands, kept alive */
+  cqp_op Q, A, C;
+  int ready;
+  /* settings */
+  double rho, sigma, alpha, eps_abs, eps_rel;
+  size_t max_iter, cg_max_iter;
+  /* problem vectors: q (n), l and u (m) */
+  double *q, *l, *u;
+  /* state */
+  double *x, *z, *y, *Kx, *rhov, *dinv;
+  double *xt, *zt, *rhs, *r, *p, *Ap, *s, *tn, *tm;
+  double rho_cur, r_prim, r_dual, f;
+  size_t iter, cg_iter;
+  int status;
+} mygsl_cqp_ws;
+
+/***** Operands *****/
+
+/* y = M x */
+static void cqp_op_mul(const cqp_op *M, const double *x, double *y)
+{
+  size_t r, k;
+  double t;
+  if (M->rows == 0) return;
+  if (M->dense) {
+    gsl_vector_const_view xv = gsl_vector_const_view_array(x, M->cols);
+    gsl_vector_view yv = gsl_vector_view_array(y, M->rows);
+    gsl_blas_dgemv(CblasNoTrans, 1.0, M->dense, &xv.vector, 0.0, &yv.vector);
+    return;
+  }
+  for (r = 0; r < M->rows; r++) {
+    t = 0.0;
+    for (k = M->csr->rowptr[r]; k < M->csr->rowptr[r+1]; k++)
+      t += M->csr->val[k]*x[M->csr->col[k]];
+    y[r] = t;
+  }
+}
+
+/* x += M^T y */
+static void cqp_op_tmul_add(const cqp_op *M, const double *y, double *x)
+{
+  size_t r, k;
+  if (M->rows == 0) return;
+  if (M->dense) {
+    gsl_vector_const_view yv = gsl_vector_const_view_array(y, M->rows);
+    gsl_vector_view xv = gsl_vector_view_array(x, M->cols);
+    gsl_blas_dgemv(CblasTrans, 1.0, M->dense, &yv.vector, 1.0, &xv.vector);
+    return;
+  }
+  for (r = 0; r < M->rows; r++)
+    for (k = M->csr->rowptr[r]; k < M->csr->rowptr[r+1]; k++)
+      x[M->csr->col[k]] += M->csr->val[k]*y[r];
+}
+
+/* d[j] += sum_r w[r] M(r, j)^2, or M(j, j) when w is NULL */
+static void cqp_op_diag_add(const cqp_op *M, const double *w, double *d)
+{
+  size_t r, j, k;
+  double v;
+  if (M->dense) {
+    for (r = 0; r < M->rows; r++)
+      for (j = 0; j < M->cols; j++) {
+	v = gsl_matrix_get(M->dense, r, j);
+	if (w) d[j] += w[r]*v*v;
+	else if (r == j) d[j] += v;
+      }
+    return;
+  }
+  for (r = 0; r < M->rows; r++)
+    for (k = M->csr->rowptr[r]; k < M->csr->rowptr[r+1]; k++) {
+      v = M->csr->val[k];
+      if (w) d[M->csr->col[k]] += w[r]*v*v;
+      else if (M->csr->col[k] == r) d[r] += v;
+    }
+}
+
+static void cqp_op_clear(cqp_op *M)
+{
+  mygsl_csr_free(M->csr);
+  M->csr = NULL;
+  M->dense = NULL;
+}
+
+/***** ADMM *****/
+
+static double cqp_norm_inf(const double *v, size_t n)
+{
+  size_t i;
+  double a = 0.0;
+  for (i = 0; i < n; i++) if (fabs(v[i]) > a) a = fabs(v[i]);
+  return a;
+}
+
+static double cqp_dot(const double *a, const double *b, size_t n)
+{
+  size_t i;
+  double t = 0.0;
+  for (i = 0; i < n; i++) t += a[i]*b[i];
+  return t;
+}
+
+/* y = K x, K = [A; C] */
+static void cqp_K_mul(mygsl_cqp_ws *w, const double *x, double *y)
+{
+  cqp_op_mul(&w->A, x, y);
+  cqp_op_mul(&w->C, x, y + w->me);
+}
+
+/* x += K^T y */
+static void cqp_Kt_mul_add(mygsl_cqp_ws *w, const double *y, double *x)
+{
+  cqp_op_tmul_add(&w->A, y, x);
+  cqp_op_tmul_add(&w->C, y + w->me, x);
+}
+
+/* y = (Q + sigma I + K^T R K) x */
+static void cqp_kkt_mul(mygsl_cqp_ws *w, const double *x, double *y)
+{
+  size_t i;
+  cqp_op_mul(&w->Q, x, y);
+  for (i = 0; i < w->n; i++) y[i] += w->sigma*x[i];
+  if (w->m == 0) return;
+  cqp_K_mul(w, x, w->tm);
+  for (i = 0; i < w->m; i++) w->tm[i] *= w->rhov[i];
+  cqp_Kt_mul_add(w, w->tm, y);
+}
+
+/* rho for each row, and the inverse diagonal of the system */
+static void cqp_set_rho(mygsl_cqp_ws *w, double rho)
+{
+  size_t i;
+  w->rho_cur = rho;
+  for (i = 0; i < w->m; i++)
+    w->rhov[i] = (w->l[i] == w->u[i]) ? RHO_EQ_SCALE*rho : rho;
+  for (i = 0; i < w->n; i++) w->dinv[i] = w->sigma;
+  cqp_op_diag_add(&w->Q, NULL, w->dinv);
+  if (w->me) cqp_op_diag_add(&w->A, w->rhov, w->dinv);
+  if (w->mi) cqp_op_diag_add(&w->C, w->rhov + w->me, w->dinv);
+  for (i = 0; i < w->n; i++) w->dinv[i] = w->dinv[i] > 0.0 ? 1.0/w->dinv[i] : 1.0;
+}
+
+/* Solves the system for xt, starting from xt, to a tenth of the smaller
+   ADMM residual of the last check (as OSQP's indirect solver does), or
+   1e-3 before the first, but not below eps_abs/100; returns the
+   iterations */
+static size_t cqp_cg(mygsl_cqp_ws *w)
+{
+  size_t i, k, n = w->n;
+  double rz, rznew, pAp, a, rnorm, tol;
+  cqp_kkt_mul(w, w->xt, w->r);
+  for (i = 0; i < n; i++) w->r[i] = w->rhs[i] - w->r[i];
+  if (gsl_isnan(w->r_prim) || gsl_isnan(w->r_dual))
+    tol = 1e-3;
+  else
+    tol = 0.1*GSL_MIN(w->r_prim, w->r_dual);
+  if (tol < 1e-2*w->eps_abs) tol = 1e-2*w->eps_abs;
+  for (i = 0; i < n; i++) w->s[i] = w->dinv[i]*w->r[i];
+  memcpy(w->p, w->s, sizeof(double)*n);
+  rz = cqp_dot(w->r, w->s, n);
+  for (k = 0; k < w->cg_max_iter; k++) {
+    rnorm = sqrt(cqp_dot(w->r, w->r, n));
+    if (rnorm <= tol) break;
+    cqp_kkt_mul(w, w->p, w->Ap);
+    pAp = cqp_dot(w->p, w->Ap, n);
+    if (pAp <= 0.0) break;
+    a = rz/pAp;
+    for (i = 0; i < n; i++) {
+      w->xt[i] += a*w->p[i];
+      w->r[i] -= a*w->Ap[i];
+      w->s[i] = w->dinv[i]*w->r[i];
+    }
+    rznew = cqp_dot(w->r, w->s, n);
+    for (i = 0; i < n; i++) w->p[i] = w->s[i] + (rznew/rz)*w->p[i];
+    rz = rznew;
+  }
+  return k;
+}
+
+/* Primal and dual residuals of x, z, y; returns 1 at convergence and
+   sets *ratio to the rho scaling balancing them */
+static int cqp_check(mygsl_cqp_ws *w, double *ratio)
+{
+  size_t i;
+  double nKx, nz, nQx, nKty, nq, ep, ed, pn, dn;
+  for (i = 0; i < w->m; i++) w->tm[i] = w->Kx[i] - w->z[i];
+  w->r_prim = cqp_norm_inf(w->tm, w->m);
+  nKx = cqp_norm_inf(w->Kx, w->m);
+  nz = cqp_norm_inf(w->z, w->m);
+  cqp_op_mul(&w->Q, w->x, w->tn);
+  nQx = cqp_norm_inf(w->tn, w->n);
+  memset(w->rhs, 0, sizeof(double)*w->n);
+  cqp_Kt_mul_add(w, w->y, w->rhs);
+  nKty = cqp_norm_inf(w->rhs, w->n);
+  nq = cqp_norm_inf(w->q, w->n);
+  for (i = 0; i < w->n; i++) w->tn[i] += w->q[i] + w->rhs[i];
+  w->r_dual = cqp_norm_inf(w->tn, w->n);
+  pn = nKx > nz ? nKx : nz;
+  dn = nQx > nKty ? nQx : nKty;
+  if (nq > dn) dn = nq;
+  ep = w->eps_abs + w->eps_rel*pn;
+  ed = w->eps_abs + w->eps_rel*dn;
+  *ratio = sqrt((w->r_prim/(pn + 1e-30))/(w->r_dual/(dn + 1e-30) + 1e-30));
+  return w->r_prim <= ep && w->r_dual <= ed;
+}
+
+static double cqp_objective(mygsl_cqp_ws *w)
+{
+  cqp_op_mul(&w->Q, w->x, w->tn);
+  return 0.5*cqp_dot(w->x, w->tn, w->n) + cqp_dot(w->q, w->x, w->n);
+}
+
+static int cqp_solve(void *data)
+{
+  mygsl_cqp_ws *w = (mygsl_cqp_ws *) data;
+  size_t i, k, n = w->n, m = w->m;
+  double a = w->alpha, v, ratio = 1.0, rho;
+  w->iter = 0;
+  w->cg_iter = 0;
+  w->status = GSL_EMAXITER;
+  cqp_set_rho(w, w->rho_cur);
+  cqp_K_mul(w, w->x, w->Kx);
+  for (k = 1; k <= w->max_iter; k++) {
+    /* x~ from (Q + sigma I + K^T R K) x~ = sigma x - q + K^T (R z - y) */
+    for (i = 0; i < m; i++) w->tm[i] = w->rhov[i]*w->z[i] - w->y[i];
+    for (i = 0; i < n; i++) w->rhs[i] = w->sigma*w->x[i] - w->q[i];
+    cqp_Kt_mul_add(w, w->tm, w->rhs);
+    memcpy(w->xt, w->x, sizeof(double)*n);
+    w->cg_iter += cqp_cg(w);
+    cqp_K_mul(w, w->xt, w->zt);
+    for (i = 0; i < n; i++) w->x[i] = a*w->xt[i] + (1.0 - a)*w->x[i];
+    for (i = 0; i < m; i++) {
+      v = a*w->zt[i] + (1.0 - a)*w->z[i];
+      w->Kx[i] = a*w->zt[i] + (1.0 - a)*w->Kx[i];
+      w->z[i] = v + w->y[i]/w->rhov[i];
+      if (w->z[i] < w->l[i]) w->z[i] = w->l[i];
+      else if (w->z[i] > w->u[i]) w->z[i] = w->u[i];
+      w->y[i] += w->rhov[i]*(v - w->z[i]);
+    }
+    w->iter = k;
+    if (k % CHECK_EVERY == 0 || k == w->max_iter) {
+      if (cqp_check(w, &ratio)) {
+	w->status = GSL_SUCCESS;
+	break;
+      }
+      if (k % ADAPT_EVERY == 0 && m > 0 && (ratio > 5.0 || ratio < 0.2)) {
+	rho = w->rho_cur*ratio;
+	if (rho < RHO_MIN) rho = RHO_MIN;
+	if (rho > RHO_MAX) rho = RHO_MAX;
+	cqp_set_rho(w, rho);
+      }
+    }
+    /* the exact Kx, away from rounding drift */
+    if (k % ADAPT_EVERY == 0) cqp_K_mul(w, w->x, w->Kx);
+  }
+  w->f = cqp_objective(w);
+  return w->status;
+}
+
+/* Cold start: x = 0, z = 0 projected, y = 0, rho as set */
+static void cqp_reset(mygsl_cqp_ws *w)
+{
+  memset(w->x, 0, sizeof(double)*w->n);
+  memset(w->z, 0, sizeof(double)*w->m);
+  memset(w->y, 0, sizeof(double)*w->m);
+  w->rho_cur = w->rho;
+  w->iter = w->cg_iter = 0;
+  w->r_prim = w->r_dual = GSL_NAN;
+  w->f = GSL_NAN;
+  w->status = GSL_CONTINUE;
+}
+
+/***** Ruby interface *****/
+
+static VALUE cgsl_cqp_workspace;
+
+static void mygsl_cqp_ws_mark(mygsl_cqp_ws *w)
+{
+  rb_gc_mark(w->vQ);
+  rb_gc_mark(w->vA);
+  rb_gc_mark(w->vC);
+}
+
+static void mygsl_cqp_ws_free(mygsl_cqp_ws *w)
+{
+  cqp_op_clear(&w->Q);
+  cqp_op_clear(&w->A);
+  cqp_op_clear(&w->C);
+  free(w->q);
+  free(w);
+}
+
+static mygsl_cqp_ws* rb_gsl_cqp_ws_get(VALUE obj)
+{
+  mygsl_cqp_ws *w = NULL;
+  Data_Get_Struct(obj, mygsl_cqp_ws, w);
+  return w;
+}
+
+static double cqp_opt(VALUE opts, const char *key, double def)
+{
+  VALUE v;
+  if (NIL_P(opts)) return def;
+  v = rb_hash_aref(opts, ID2SYM(rb_intern(key)));
+  return NIL_P(v) ? def : NUM2DBL(v);
+}
+
+/*
+  alloc(n, me, mi, opts = {}): opts :rho (0.1), :sigma (1e-6),
+  :alpha (1.6), :eps_abs and :eps_rel (1e-6), :max_iter (4000) and
+  :cg_max_iter (n)
+*/
+static VALUE rb_gsl_cqp_ws_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_cqp_ws *w = NULL;
+  VALUE obj, opts = Qnil;
+  size_t n, me, mi, m;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  if (argc == 4) {
+    opts = argv[3];
+    Check_Type(opts, T_HASH);
+  }
+  n = NUM2SIZET(argv[0]);
+  me = NUM2SIZET(argv[1]);
+  mi = NUM2SIZET(argv[2]);
+  if (n == 0) rb_raise(rb_eArgError, "n must be positive");
+  m = me + mi;
+  obj = Data_Make_Struct(klass, mygsl_cqp_ws, mygsl_cqp_ws_mark, mygsl_cqp_ws_free, w);
+  w->vQ = w->vA = w->vC = Qnil;
+  w->n = n;
+  w->me = me;
+  w->mi = mi;
+  w->m = m;
+  w->rho = cqp_opt(opts, "rho", 0.1);
+  w->sigma = cqp_opt(opts, "sigma", 1e-6);
+  w->alpha = cqp_opt(opts, "alpha", 1.6);
+  w->eps_abs = cqp_opt(opts, "eps_abs", 1e-6);
+  w->eps_rel = cqp_opt(opts, "eps_rel", 1e-6);
+  w->max_iter = (size_t) cqp_opt(opts, "max_iter", 4000);
+  w->cg_max_iter = (size_t) cqp_opt(opts, "cg_max_iter", (double) n);
+  if (w->rho <= 0.0 || w->sigma <= 0.0)
+    rb_raise(rb_eArgError, ":rho and :sigma must be positive");
+  if (w->alpha <= 0.0 || w->alpha >= 2.0)
+    rb_raise(rb_eArgError, ":alpha must be in (0, 2)");
+  /* one block: q, x and the scratch vectors of length n, l, u, z, y,
+     Kx, rho, z~ and a scratch vector of length m */
+  w->q = (double *) calloc(10*n + 8*m, sizeof(double));
+  if (w->q == NULL) rb_raise(rb_eNoMemError, "workspace allocation failed");
+  w->x = w->q + n;
+  w->dinv = w->x + n;
+  w->xt = w->dinv + n;
+  w->rhs = w->xt + n;
+  w->r = w->rhs + n;
+  w->p = w->r + n;
+  w->Ap = w->p + n;
+  w->s = w->Ap + n;
+  w->tn = w->s + n;
+  w->l = w->tn + n;
+  w->u = w->l + m;
+  w->z = w->u + m;
+  w->y = w->z + m;
+  w->Kx = w->y + m;
+  w->rhov = w->Kx + m;
+  w->zt = w->rhov + m;
+  w->tm = w->zt + m;
+  cqp_reset(w);
+  return obj;
+}
+
+static void cqp_set_op(cqp_op *M, VALUE *keep, VALUE vm, size_t rows, size_t cols,
+		       const char *name)
+{
+  cqp_op_clear(M);
+  *keep = Qnil;
+  M->rows = rows;
+  M->cols = cols;
+  if (rows == 0) return;
+  if (MATRIX_P(vm)) {
+    Data_Get_Struct(vm, gsl_matrix, M->dense);
+    if (M->dense->size1 != rows || M->dense->size2 != cols)
+      rb_raise(rb_eArgError, "%s must be %d x %d", name, (int) rows, (int) cols);
+    *keep = vm;
+    return;
+  }
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  if (rb_gsl_spmatrix_p(vm)) {
+    gsl_spmatrix *s = rb_gsl_get_spmatrix(vm);
+    if (s->size1 != rows || s->size2 != cols)
+      rb_raise(rb_eArgError, "%s must be %d x %d", name, (int) rows, (int) cols);
+    M->csr = mygsl_csr_from_spmatrix(s);
+    if (M->csr == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    return;
+  }
+#endif
+  rb_raise(rb_eTypeError, "wrong argument type %s for %s (GSL::Matrix or GSL::SpMatrix"
+	   " expected)", rb_class2name(CLASS_OF(vm)), name);
+}
+
+static void cqp_set_vec(double *dst, VALUE vv, size_t n, const char *name)
+{
+  gsl_vector *v = NULL;
+  size_t i;
+  if (n == 0) return;
+  CHECK_VECTOR(vv);
+  Data_Get_Struct(vv, gsl_vector, v);
+  if (v->size != n) rb_raise(rb_eArgError, "%s must have %d elements", name, (int) n);
+  for (i = 0; i < n; i++) dst[i] = gsl_vector_get(v, i);
+}
+
+/* update(q, b = nil, d = nil): new vectors for the same matrices */
+static VALUE rb_gsl_cqp_ws_update(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  size_t i;
+  if (argc < 1 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-3)", argc);
+  if (!NIL_P(argv[0])) cqp_set_vec(w->q, argv[0], w->n, "q");
+  if (argc > 1 && !NIL_P(argv[1])) {
+    cqp_set_vec(w->l, argv[1], w->me, "b");
+    memcpy(w->u, w->l, sizeof(double)*w->me);
+  }
+  if (argc > 2 && !NIL_P(argv[2])) {
+    cqp_set_vec(w->l + w->me, argv[2], w->mi, "d");
+    for (i = w->me; i < w->m; i++) w->u[i] = HUGE_VAL;
+  }
+  return obj;
+}
+
+/* set(Q, q, A, b, C, d); A, b (C, d) may be nil when me (mi) is 0 */
+static VALUE rb_gsl_cqp_ws_set(VALUE obj, VALUE vQ, VALUE vq, VALUE vA, VALUE vb,
+			       VALUE vC, VALUE vd)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  size_t i;
+  w->ready = 0;
+  cqp_set_op(&w->Q, &w->vQ, vQ, w->n, w->n, "Q");
+  cqp_set_op(&w->A, &w->vA, vA, w->me, w->n, "A");
+  cqp_set_op(&w->C, &w->vC, vC, w->mi, w->n, "C");
+  cqp_set_vec(w->q, vq, w->n, "q");
+  cqp_set_vec(w->l, vb, w->me, "b");
+  memcpy(w->u, w->l, sizeof(double)*w->me);
+  cqp_set_vec(w->l + w->me, vd, w->mi, "d");
+  for (i = w->me; i < w->m; i++) w->u[i] = HUGE_VAL;
+  w->ready = 1;
+  return obj;
+}
+
+static VALUE rb_gsl_cqp_ws_solve(VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  size_t work;
+  if (!w->ready) rb_raise(rb_eRuntimeError, "no problem set (call set first)");
+  work = w->n*(w->n + w->m)*w->max_iter;
+  return INT2FIX(rb_gsl_nogvl_call(cqp_solve, w, work));
+}
+
+static VALUE rb_gsl_cqp_ws_reset(VALUE obj)
+{
+  cqp_reset(rb_gsl_cqp_ws_get(obj));
+  return obj;
+}
+
+/* warm_start(x, lm_eq = nil, lm_ineq = nil) */
+static VALUE rb_gsl_cqp_ws_warm_start(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  size_t i;
+  if (argc < 1 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-3)", argc);
+  cqp_set_vec(w->x, argv[0], w->n, "x");
+  if (argc > 1 && !NIL_P(argv[1])) {
+    cqp_set_vec(w->y, argv[1], w->me, "lm_eq");
+    for (i = 0; i < w->me; i++) w->y[i] = -w->y[i];
+  }
+  if (argc > 2 && !NIL_P(argv[2])) {
+    cqp_set_vec(w->y + w->me, argv[2], w->mi, "lm_ineq");
+    for (i = w->me; i < w->m; i++) w->y[i] = -w->y[i];
+  }
+  /* z at the projection of K x */
+  if (w->ready) {
+    cqp_K_mul(w, w->x, w->z);
+    for (i = 0; i < w->m; i++) {
+      if (w->z[i] < w->l[i]) w->z[i] = w->l[i];
+      else if (w->z[i] > w->u[i]) w->z[i] = w->u[i];
+    }
+  }
+  return obj;
+}
+
+static VALUE cqp_vector(const double *v, size_t n, double sign)
+{
+  gsl_vector *x;
+  size_t i;
+  if (n == 0) return Qnil;
+  x = gsl_vector_alloc(n);
+  for (i = 0; i < n; i++) gsl_vector_set(x, i, sign*v[i]);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+}
+
+static VALUE rb_gsl_cqp_ws_x(VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  return cqp_vector(w->x, w->n, 1.0);
+}
+
+static VALUE rb_gsl_cqp_ws_lm_eq(VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  return cqp_vector(w->y, w->me, -1.0);
+}
+
+static VALUE rb_gsl_cqp_ws_lm_ineq(VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  return cqp_vector(w->y + w->me, w->mi, -1.0);
+}
+
+static VALUE rb_gsl_cqp_ws_f(VALUE obj)
+{
+  return rb_float_new(rb_gsl_cqp_ws_get(obj)->f);
+}
+
+static VALUE rb_gsl_cqp_ws_iter(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_cqp_ws_get(obj)->iter);
+}
+
+static VALUE rb_gsl_cqp_ws_cg_iter(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_cqp_ws_get(obj)->cg_iter);
+}
+
+static VALUE rb_gsl_cqp_ws_rho(VALUE obj)
+{
+  return rb_float_new(rb_gsl_cqp_ws_get(obj)->rho_cur);
+}
+
+/* [primal, dual]: the infinity norms of K x - z and Q x + q + K^T y */
+static VALUE rb_gsl_cqp_ws_residuals(VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  return rb_ary_new3(2, rb_float_new(w->r_prim), rb_float_new(w->r_dual));
+}
+
+static VALUE rb_gsl_cqp_ws_converged(VALUE obj)
+{
+  return rb_gsl_cqp_ws_get(obj)->status == GSL_SUCCESS ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_cqp_ws_size(VALUE obj)
+{
+  mygsl_cqp_ws *w = rb_gsl_cqp_ws_get(obj);
+  return rb_ary_new3(3, SIZET2NUM(w->n), SIZET2NUM(w->me), SIZET2NUM(w->mi));
+}
+
+void Init_gsl_cqp_workspace(VALUE module)
+{
+  VALUE mgsl_cqp;
+  mgsl_cqp = rb_define_module_under(module, "CQP");
+  cgsl_cqp_workspace = rb_define_class_under(mgsl_cqp, "Workspace", cGSL_Object);
+  rb_define_singleton_method(cgsl_cqp_workspace, "alloc", rb_gsl_cqp_ws_new, -1);
+  rb_define_singleton_method(cgsl_cqp_workspace, "new", rb_gsl_cqp_ws_new, -1);
+  rb_define_method(cgsl_cqp_workspace, "set", rb_gsl_cqp_ws_set, 6);
+  rb_define_method(cgsl_cqp_workspace, "update", rb_gsl_cqp_ws_update, -1);
+  rb_define_method(cgsl_cqp_workspace, "solve", rb_gsl_cqp_ws_solve, 0);
+  rb_define_method(cgsl_cqp_workspace, "reset", rb_gsl_cqp_ws_reset, 0);
+  rb_define_method(cgsl_cqp_workspace, "warm_start", rb_gsl_cqp_ws_warm_start, -1);
+  rb_define_method(cgsl_cqp_workspace, "x", rb_gsl_cqp_ws_x, 0);
+  rb_define_method(cgsl_cqp_workspace, "lm_eq", rb_gsl_cqp_ws_lm_eq, 0);
+  rb_define_method(cgsl_cqp_workspace, "lm_ineq", rb_gsl_cqp_ws_lm_ineq, 0);
+  rb_define_method(cgsl_cqp_workspace, "f", rb_gsl_cqp_ws_f, 0);
+  rb_define_method(cgsl_cqp_workspace, "iter", rb_gsl_cqp_ws_iter, 0);
+  rb_define_method(cgsl_cqp_workspace, "cg_iter", rb_gsl_cqp_ws_cg_iter, 0);
+  rb_define_method(cgsl_cqp_workspace, "rho", rb_gsl_cqp_ws_rho, 0);
+  rb_define_method(cgsl_cqp_workspace, "residuals", rb_gsl_cqp_ws_residuals, 0);
+  rb_define_method(cgsl_cqp_workspace, "converged?", rb_gsl_cqp_ws_converged, 0);
+  rb_define_method(cgsl_cqp_workspace, "size", rb_gsl_cqp_ws_size, 0);
+}
@@ -11,6 +11,7 @@
 #include "rb_gsl_config.h"
 #ifdef GSL_1_4_9_LATER
 #include "rb_gsl_common.h"
+#include "rb_gsl_array.h"
 #include "rb_gsl_function.h"
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_deriv.h>
@@ -62,6 +63,147 @@ static int get_func2(int argc, VALUE *argv, VALUE obj, VALUE *ff, VALUE *xx, VAL
 #undef RB_GSL_DERIV_H_DEFAULT
 #endif
 
+/*
+  The rules of gsl_deriv_central() and gsl_deriv_forward() (backward is
+  forward with -h) for n points at once: the 4 stencil points of all of
+  them in one call of rb_gsl_function_eval_array(), then one more call
+  for the points whose step is refined, so that a vectorized Function
+  is called twice whatever n, and a compiled one runs without the GVL.
+*/
+enum { DERIV_CENTRAL, DERIV_FORWARD };
+
+struct deriv_batch {
+  gsl_function *f;
+  int kind;
+  const double *x;
+  size_t stride, n;
+  double h;
+  double *xs, *ys, *hopt, *res, *err;
+};
+
+static void deriv_stencil(int kind, double x, double h, double *xs)
+{
+  if (kind == DERIV_CENTRAL) {
+    xs[0] = x - h;
+    xs[1] = x + h;
+    xs[2] = x - h/2;
+    xs[3] = x + h/2;
+  } else {
+    xs[0] = x + h/4.0;
+    xs[1] = x + h/2.0;
+    xs[2] = x + (3.0/4.0)*h;
+    xs[3] = x + h;
+  }
+}
+
+static void deriv_rule(int kind, double x, double h, const double *fs,
+		       double *result, double *round, double *trunc)
+{
+  double r3, r5, e3, e5, dy;
+  if (kind == DERIV_CENTRAL) {
+    /* fs: f(x-h), f(x+h), f(x-h/2), f(x+h/2) */
+    r3 = 0.5*(fs[1] - fs[0]);
+    r5 = (4.0/3.0)*(fs[3] - fs[2]) - (1.0/3.0)*r3;
+    e3 = (fabs(fs[1]) + fabs(fs[0]))*GSL_DBL_EPSILON;
+    e5 = 2.0*(fabs(fs[3]) + fabs(fs[2]))*GSL_DBL_EPSILON + e3;
+  } else {
+    /* fs: f(x+h/4), f(x+h/2), f(x+3h/4), f(x+h) */
+    r3 = 2.0*(fs[3] - fs[1]);
+    r5 = (22.0/3.0)*(fs[3] - fs[2]) - (62.0/3.0)*(fs[2] - fs[1])
+      + (52.0/3.0)*(fs[1] - fs[0]);
+    e5 = 2*20.67*(fabs(fs[3]) + fabs(fs[2]) + fabs(fs[1]) + fabs(fs[0]))*GSL_DBL_EPSILON;
+  }
+  dy = GSL_MAX(fabs(r3/h), fabs(r5/h))*(fabs(x)/h)*GSL_DBL_EPSILON;
+  *result = r5/h;
+  *trunc = fabs((r5 - r3)/h);
+  *round = fabs(e5/h) + dy;
+}
+
+static int mygsl_deriv_batch(void *data)
+{
+  struct deriv_batch *d = (struct deriv_batch *) data;
+  double x, r, round, trunc, error;
+  size_t i, k;
+  for (i = 0; i < d->n; i++)
+    deriv_stencil(d->kind, d->x[i*d->stride], d->h, d->xs + 4*i);
+  rb_gsl_function_eval_array(d->f, d->xs, d->ys, 4*d->n);
+  for (i = 0, k = 0; i < d->n; i++) {
+    x = d->x[i*d->stride];
+    deriv_rule(d->kind, x, d->h, d->ys + 4*i, &r, &round, &trunc);
+    d->res[i] = r;
+    d->err[i] = error = round + trunc;
+    d->hopt[i] = 0.0;
+    if (round < trunc && (round > 0 && trunc > 0)) {
+      if (d->kind == DERIV_CENTRAL) d->hopt[i] = d->h*pow(round/(2.0*trunc), 1.0/3.0);
+      else d->hopt[i] = d->h*pow(round/trunc, 1.0/2.0);
+      deriv_stencil(d->kind, x, d->hopt[i], d->xs + 4*k++);
+    }
+  }
+  if (k == 0) return GSL_SUCCESS;
+  rb_gsl_function_eval_array(d->f, d->xs, d->ys, 4*k);
+  for (i = 0, k = 0; i < d->n; i++) {
+    if (d->hopt[i] == 0.0) continue;
+    deriv_rule(d->kind, d->x[i*d->stride], d->hopt[i], d->ys + 4*k++, &r, &round, &trunc);
+    error = round + trunc;
+    if (error < d->err[i] && fabs(r - d->res[i]) < 4.0*d->err[i]) {
+      d->res[i] = r;
+      d->err[i] = error;
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/* [result, abserr] of a Vector (or Array) of points for a vectorized or
+   compiled Function, nil when the points are to be taken one by one */
+static VALUE rb_gsl_deriv_eval_batch(VALUE obj, VALUE xx, double h, int kind)
+{
+  struct deriv_batch d;
+  gsl_function *f = NULL;
+  gsl_vector *buf, *res, *err;
+  VALUE keep = Qnil, vbuf, ary, aerr;
+  size_t i;
+  int compiled;
+  Data_Get_Struct(obj, gsl_function, f);
+  compiled = rb_obj_is_kind_of(obj, cgsl_function_compiled);
+  if (!compiled && !rb_gsl_function_vectorized_p(f)) return Qnil;
+  if (TYPE(xx) == T_ARRAY) {
+    keep = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, make_cvector_from_rarray(xx));
+    d.x = get_vector_ptr(keep, &d.stride, &d.n);
+  } else if (VECTOR_P(xx)) {
+    d.x = get_vector_ptr(xx, &d.stride, &d.n);
+  } else {
+    return Qnil;
+  }
+  if (d.n == 0) return Qnil;
+  d.f = f;
+  d.kind = kind;
+  d.h = h;
+  buf = gsl_vector_alloc(9*d.n);
+  vbuf = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, buf);
+  res = gsl_vector_alloc(d.n);
+  ary = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, res);
+  err = gsl_vector_alloc(d.n);
+  aerr = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, err);
+  d.xs = buf->data;
+  d.ys = buf->data + 4*d.n;
+  d.hopt = buf->data + 8*d.n;
+  d.res = res->data;
+  d.err = err->data;
+  if (compiled) rb_gsl_nogvl_call(mygsl_deriv_batch, &d, 8*d.n);
+  else mygsl_deriv_batch(&d);
+  RB_GC_GUARD(keep);
+  RB_GC_GUARD(vbuf);
+  if (TYPE(xx) == T_ARRAY) {
+    ary = rb_ary_new2(d.n);
+    aerr = rb_ary_new2(d.n);
+    for (i = 0; i < d.n; i++) {
+      rb_ary_store(ary, i, rb_float_new(res->data[i]));
+      rb_ary_store(aerr, i, rb_float_new(err->data[i]));
+    }
+  }
+  return rb_ary_new3(2, ary, aerr);
+}
+
 static VALUE rb_gsl_deriv_eval(VALUE obj, VALUE xx, VALUE hh, 
 			       int (*deriv)(const gsl_function *, 
 					    double, double,
@@ -156,24 +298,39 @@ static VALUE rb_gsl_deriv_eval(VALUE obj, VALUE xx, VALUE hh,
   return Qnil; /* never reach here */
 }
 
+/*
+  f.deriv_central(x[, h]), GSL::Deriv.central(f, x[, h]): with x a Vector
+  or an Array, a vectorized Function is called once for the stencils of
+  all the points (and once more for the refined steps), a compiled one
+  evaluated without the GVL.
+*/
 static VALUE rb_gsl_deriv_central(int argc, VALUE *argv, VALUE obj)
 {
-  VALUE ff, xx, hh;
+  VALUE ff, xx, hh, ary;
   get_func2(argc, argv, obj, &ff, &xx, &hh);
+  Need_Float(hh);
+  ary = rb_gsl_deriv_eval_batch(ff, xx, NUM2DBL(hh), DERIV_CENTRAL);
+  if (!NIL_P(ary)) return ary;
   return rb_gsl_deriv_eval(ff, xx, hh, gsl_deriv_central);
 }
 
 static VALUE rb_gsl_deriv_forward(int argc, VALUE *argv, VALUE obj)
 {
-  VALUE ff, xx, hh;
+  VALUE ff, xx, hh, ary;
   get_func2(argc, argv, obj, &ff, &xx, &hh);
+  Need_Float(hh);
+  ary = rb_gsl_deriv_eval_batch(ff, xx, NUM2DBL(hh), DERIV_FORWARD);
+  if (!NIL_P(ary)) return ary;
   return rb_gsl_deriv_eval(ff, xx, hh, gsl_deriv_forward);
 }
 
 static VALUE rb_gsl_deriv_backward(int argc, VALUE *argv, VALUE obj)
 {
-  VALUE ff, xx, hh;
+  VALUE ff, xx, hh, ary;
   get_func2(argc, argv, obj, &ff, &xx, &hh);
+  Need_Float(hh);
+  ary = rb_gsl_deriv_eval_batch(ff, xx, -NUM2DBL(hh), DERIV_FORWARD);
+  if (!NIL_P(ary)) return ary;
   return rb_gsl_deriv_eval(ff, xx, hh, gsl_deriv_backward);
 }
 
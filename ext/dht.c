@@ -17,6 +17,113 @@
 #include "narray.h"
 #endif
 
+/* Per-thread cache of the tables computed by gsl_dht_init (the Bessel
+   zeros j, the kernel Jjj and the norms J2), keyed by (size, nu, xmax)
+   and evicted least-recently-used first.  Dht.alloc(size, nu, xmax) and
+   Dht#init copy the tables of a cached plan, O(size**2), instead of
+   evaluating the size**2 Bessel functions again.  Only used with the
+   GVL held; per thread so that Ractors running at once never share it. */
+#define DHT_CACHE_MAX 32
+#define DHT_CACHE_DEFAULT 8
+
+struct dht_cache_entry {
+  gsl_dht *t;
+  unsigned long used;
+};
+
+static RB_GSL_THREAD_LOCAL struct {
+  size_t len;
+  unsigned long clock, hits, misses;
+  struct dht_cache_entry e[DHT_CACHE_MAX];
+} dht_cache;
+
+static size_t dht_cache_capacity = DHT_CACHE_DEFAULT;
+
+static void dht_copy(gsl_dht *dst, const gsl_dht *src)
+{
+  size_t n = src->size;
+  dst->nu = src->nu;
+  dst->xmax = src->xmax;
+  dst->kmax = src->kmax;
+  memcpy(dst->j, src->j, sizeof(double)*(n + 2));
+  memcpy(dst->Jjj, src->Jjj, sizeof(double)*(n*(n + 1)/2));
+  memcpy(dst->J2, src->J2, sizeof(double)*(n + 1));
+}
+
+static void dht_cache_shrink(size_t max)
+{
+  size_t i, lru;
+  while (dht_cache.len > max) {
+    lru = 0;
+    for (i = 1; i < dht_cache.len; i++)
+      if (dht_cache.e[i].used < dht_cache.e[lru].used) lru = i;
+    gsl_dht_free(dht_cache.e[lru].t);
+    dht_cache.e[lru] = dht_cache.e[--dht_cache.len];
+  }
+}
+
+/* gsl_dht_init(t, nu, xmax) through the cache */
+static int dht_cache_init(gsl_dht *t, double nu, double xmax)
+{
+  struct dht_cache_entry *e;
+  gsl_dht *c;
+  size_t i;
+  int status;
+  for (i = 0; i < dht_cache.len; i++) {
+    e = &dht_cache.e[i];
+    if (e->t->size == t->size && e->t->nu == nu && e->t->xmax == xmax) {
+      dht_copy(t, e->t);
+      e->used = ++dht_cache.clock;
+      dht_cache.hits++;
+      return GSL_SUCCESS;
+    }
+  }
+  dht_cache.misses++;
+  status = gsl_dht_init(t, nu, xmax);
+  if (status != GSL_SUCCESS || dht_cache_capacity == 0) return status;
+  c = gsl_dht_alloc(t->size);
+  if (c == NULL) return status;
+  dht_copy(c, t);
+  dht_cache_shrink(dht_cache_capacity - 1);
+  e = &dht_cache.e[dht_cache.len++];
+  e->t = c;
+  e->used = ++dht_cache.clock;
+  return status;
+}
+
+static VALUE rb_gsl_dht_cache_stats(VALUE klass)
+{
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("hits")), ULONG2NUM(dht_cache.hits));
+  rb_hash_aset(hash, ID2SYM(rb_intern("misses")), ULONG2NUM(dht_cache.misses));
+  rb_hash_aset(hash, ID2SYM(rb_intern("size")), SIZET2NUM(dht_cache.len));
+  rb_hash_aset(hash, ID2SYM(rb_intern("capacity")), SIZET2NUM(dht_cache_capacity));
+  return hash;
+}
+
+static VALUE rb_gsl_dht_cache_clear(VALUE klass)
+{
+  dht_cache_shrink(0);
+  dht_cache.hits = 0;
+  dht_cache.misses = 0;
+  return klass;
+}
+
+static VALUE rb_gsl_dht_cache_capacity(VALUE klass)
+{
+  return SIZET2NUM(dht_cache_capacity);
+}
+
+static VALUE rb_gsl_dht_set_cache_capacity(VALUE klass, VALUE val)
+{
+  long n = NUM2LONG(val);
+  if (n < 0) rb_raise(rb_eArgError, "cache capacity must be non-negative");
+  if (n > DHT_CACHE_MAX) n = DHT_CACHE_MAX;
+  dht_cache_capacity = (size_t) n;
+  dht_cache_shrink(dht_cache_capacity);
+  return val;
+}
+
 static VALUE rb_gsl_dht_alloc(int argc, VALUE *argv, VALUE klass)
 {
   gsl_dht *t = NULL;
@@ -28,7 +135,9 @@ static VALUE rb_gsl_dht_alloc(int argc, VALUE *argv, VALUE klass)
   case 3:
     CHECK_FIXNUM(argv[0]);
     Need_Float(argv[1]); Need_Float(argv[2]);
-    t = gsl_dht_new(FIX2INT(argv[0]), NUM2DBL(argv[1]), NUM2DBL(argv[2]));
+    t = gsl_dht_alloc(FIX2INT(argv[0]));
+    if (t == NULL) rb_raise(rb_eNoMemError, "gsl_dht_alloc failed");
+    dht_cache_init(t, NUM2DBL(argv[1]), NUM2DBL(argv[2]));
    break;
   default:
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 3)", argc);
@@ -42,10 +151,89 @@ static VALUE rb_gsl_dht_init(VALUE obj, VALUE nu, VALUE xmax)
   gsl_dht *t = NULL;
   Need_Float(nu); Need_Float(xmax);
   Data_Get_Struct(obj, gsl_dht, t);
-  gsl_dht_init(t, NUM2DBL(nu), NUM2DBL(xmax));
+  dht_cache_init(t, NUM2DBL(nu), NUM2DBL(xmax));
   return obj;
 }
 
+/* apply over the rows of a matrix.  From DHT_GEMM_MIN rows on, the
+   kernel of gsl_dht_apply is expanded once into a dense size x size
+   matrix K and the batch is out = in K^T by one dgemm. */
+#define DHT_GEMM_MIN 4
+
+struct dht_rows {
+  gsl_dht *t;
+  gsl_matrix *in, *out;
+  double *kernel;
+};
+
+static int dht_rows_run(void *data)
+{
+  struct dht_rows *r = (struct dht_rows *) data;
+  gsl_dht *t = r->t;
+  gsl_matrix_view K;
+  size_t n = t->size, m, i, lo, hi;
+  double c;
+  if (r->kernel == NULL) {
+    for (i = 0; i < r->in->size1; i++)
+      gsl_dht_apply(t, r->in->data + i*r->in->tda, r->out->data + i*r->out->tda);
+    return GSL_SUCCESS;
+  }
+  c = t->xmax/t->j[n + 1];
+  c = 2.0*c*c;
+  for (m = 0; m < n; m++) {
+    for (i = 0; i < n; i++) {
+      lo = GSL_MIN(m, i);
+      hi = GSL_MAX(m, i);
+      r->kernel[m*n + i] = c*t->Jjj[hi*(hi + 1)/2 + lo]/t->J2[i + 1];
+    }
+  }
+  K = gsl_matrix_view_array(r->kernel, n, n);
+  return gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, r->in, &K.matrix, 0.0, r->out);
+}
+
+static int dht_overlap(const gsl_matrix *a, const gsl_matrix *b)
+{
+  const double *a1 = a->data + (a->size1 - 1)*a->tda + a->size2;
+  const double *b1 = b->data + (b->size1 - 1)*b->tda + b->size2;
+  return a->data < b1 && b->data < a1;
+}
+
+static VALUE rb_gsl_dht_apply_rows(gsl_dht *t, VALUE vin, VALUE vout)
+{
+  struct dht_rows r;
+  gsl_matrix *tmp = NULL;
+  VALUE vk;
+  size_t n = t->size;
+  Data_Get_Struct(vin, gsl_matrix, r.in);
+  if (r.in->size2 != n)
+    rb_raise(rb_eRangeError, "matrix rows of size %d for a Dht of size %d",
+	     (int) r.in->size2, (int) n);
+  if (NIL_P(vout)) {
+    r.out = gsl_matrix_alloc(r.in->size1, n);
+    vout = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, r.out);
+  } else {
+    CHECK_MATRIX(vout);
+    Data_Get_Struct(vout, gsl_matrix, r.out);
+    if (r.out->size1 != r.in->size1 || r.out->size2 != n)
+      rb_raise(rb_eRangeError, "output matrix must be %d x %d", (int) r.in->size1, (int) n);
+  }
+  r.t = t;
+  r.kernel = NULL;
+  if (r.in->size1 >= DHT_GEMM_MIN) r.kernel = ALLOCV_N(double, vk, n*n);
+  if (dht_overlap(r.in, r.out)) {
+    tmp = gsl_matrix_alloc(r.in->size1, n);
+    r.out = tmp;
+  }
+  rb_gsl_nogvl_call(dht_rows_run, &r, r.in->size1*n*n);
+  if (r.kernel) ALLOCV_END(vk);
+  if (tmp) {
+    Data_Get_Struct(vout, gsl_matrix, r.out);
+    gsl_matrix_memcpy(r.out, tmp);
+    gsl_matrix_free(tmp);
+  }
+  return vout;
+}
+
 static VALUE rb_gsl_dht_apply(int argc, VALUE *argv, VALUE obj)
 {
   gsl_dht *t = NULL;
@@ -56,6 +244,10 @@ static VALUE rb_gsl_dht_apply(int argc, VALUE *argv, VALUE obj)
   struct NARRAY *na;
 #endif
   VALUE ary;
+  if ((argc == 1 || argc == 2) && MATRIX_P(argv[0])) {
+    Data_Get_Struct(obj, gsl_dht, t);
+    return rb_gsl_dht_apply_rows(t, argv[0], argc == 2 ? argv[1] : Qnil);
+  }
   switch (argc) {
   case 2:
     Data_Get_Struct(obj, gsl_dht, t);
@@ -339,6 +531,10 @@ void Init_gsl_dht(VALUE module)
   cgsl_dht = rb_define_class_under(module, "Dht", cGSL_Object);
   rb_define_singleton_method(cgsl_dht, "alloc", rb_gsl_dht_alloc, -1);
   rb_define_method(cgsl_dht, "init", rb_gsl_dht_init, 2);
+  rb_define_singleton_method(cgsl_dht, "cache_stats", rb_gsl_dht_cache_stats, 0);
+  rb_define_singleton_method(cgsl_dht, "cache_clear", rb_gsl_dht_cache_clear, 0);
+  rb_define_singleton_method(cgsl_dht, "cache_capacity", rb_gsl_dht_cache_capacity, 0);
+  rb_define_singleton_method(cgsl_dht, "cache_capacity=", rb_gsl_dht_set_cache_capacity, 1);
   rb_define_method(cgsl_dht, "apply", rb_gsl_dht_apply, -1);
   rb_define_method(cgsl_dht, "x_sample", rb_gsl_dht_x_sample, 1);
   rb_define_method(cgsl_dht, "k_sample", rb_gsl_dht_k_sample, 1);
@@ -162,5 +162,7 @@ void Init_gsl_diff(VALUE module)
   rb_define_singleton_method(mgsl_diff, "central", rb_gsl_diff_central, -1);
   rb_define_singleton_method(mgsl_diff, "forward", rb_gsl_diff_forward, -1);
   rb_define_singleton_method(mgsl_diff, "backward", rb_gsl_diff_backward, -1);
+
+  Init_gsl_diff_jacobian(mgsl_diff);
 }
 
@@ -0,0 +1,507 @@
+/*
+  diff_jacobian.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Finite difference Jacobians and gradients computed in C.
+
+    fd = GSL::Diff::Jacobian.alloc(:central)      # or :forward
+    J = fd.jacobian(proc { |x| [x[0]*x[1], x[0] + x[1]] }, x)
+    g = fd.gradient(proc { |x| x[0]**2 + x[1]**2 }, x)
+
+  Given in place of the derivative proc, the object makes the solvers
+  differentiate the function themselves:
+
+    GSL::MultiMin::Function_fdf.alloc(my_f, fd, n)
+    GSL::MultiRoot::Function_fdf.alloc(my_f, fd, n)
+    GSL::MultiFit::Function_fdf.alloc(my_f, fd, p)
+
+  Column j of the Jacobian is (f(x + h_j e_j) - f(x))/h_j (forward) or
+  (f(x + h_j e_j) - f(x - h_j e_j))/(2 h_j) (central), with the step
+  h_j = step*max(|x_j|, 1) rounded so that x_j + h_j is exact.  The step
+  defaults to sqrt(DBL_EPSILON) for forward and DBL_EPSILON^(1/3) for
+  central differences.
+
+  With the option :batch, a callable given the Matrix of all the
+  perturbed points (one per row, plus the arguments the function itself
+  gets after x) returns the values at all of them in one call: a Matrix
+  of one row per point, or a Vector or Array for a scalar function.
+  Otherwise the function is evaluated point by point.
+
+  With :threads => k, the points are split over k threads where the
+  solver allows it: compiled models (such as a MultiFit::Function_fdf
+  .compile model) are evaluated in C without the GVL, while Ruby
+  functions are called from k Ruby threads at once, which only pays off
+  for functions that release the GVL themselves (an external solver, a
+  C extension or I/O).
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_function.h"
+
+enum {
+  RB_GSL_FDIFF_FORWARD = 0,
+  RB_GSL_FDIFF_CENTRAL,
+};
+
+typedef struct {
+  int type;
+  double step;                  /* relative step, 0 for the default */
+  size_t threads;
+  VALUE batch;
+} rb_gsl_fdiff;
+
+VALUE cgsl_diff_jacobian;
+
+static void rb_gsl_fdiff_mark(rb_gsl_fdiff *fd)
+{
+  rb_gc_mark(fd->batch);
+}
+
+static int get_fdiff_type(VALUE t)
+{
+  const char *name = NULL;
+  switch (TYPE(t)) {
+  case T_FIXNUM:
+    if (FIX2INT(t) == RB_GSL_FDIFF_FORWARD || FIX2INT(t) == RB_GSL_FDIFF_CENTRAL)
+      return FIX2INT(t);
+    break;
+  case T_SYMBOL:
+    name = rb_id2name(SYM2ID(t));
+    break;
+  case T_STRING:
+    name = StringValueCStr(t);
+    break;
+  }
+  if (name && strcmp(name, "forward") == 0) return RB_GSL_FDIFF_FORWARD;
+  if (name && strcmp(name, "central") == 0) return RB_GSL_FDIFF_CENTRAL;
+  rb_raise(rb_eArgError, "unknown finite difference type (forward or central expected)");
+  return 0;
+}
+
+/* GSL::Diff::Jacobian.alloc(type = :central[, opts]) */
+static VALUE rb_gsl_fdiff_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  rb_gsl_fdiff *fd = NULL;
+  VALUE obj, opts = Qnil, v;
+  if (argc > 0 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  obj = Data_Make_Struct(klass, rb_gsl_fdiff, rb_gsl_fdiff_mark, xfree, fd);
+  fd->type = argc == 1 ? get_fdiff_type(argv[0]) : RB_GSL_FDIFF_CENTRAL;
+  fd->step = 0.0;
+  fd->threads = 1;
+  fd->batch = Qnil;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("step"))))) {
+      fd->step = NUM2DBL(v);
+      if (!(fd->step > 0.0)) rb_raise(rb_eArgError, "step must be positive");
+    }
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("batch"))))) {
+      if (!rb_respond_to(v, RBGSL_ID_call))
+	rb_raise(rb_eTypeError, "wrong argument type %s (callable expected)",
+		 rb_class2name(CLASS_OF(v)));
+      fd->batch = v;
+    }
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("threads"))))) {
+      fd->threads = NUM2SIZET(v);
+      if (fd->threads == 0) rb_raise(rb_eArgError, "threads must be positive");
+    }
+  }
+  return obj;
+}
+
+static double rb_gsl_fdiff_step(const rb_gsl_fdiff *fd)
+{
+  if (fd->step > 0.0) return fd->step;
+  return fd->type == RB_GSL_FDIFF_CENTRAL ? GSL_ROOT3_DBL_EPSILON : GSL_SQRT_DBL_EPSILON;
+}
+
+static VALUE rb_gsl_fdiff_type(VALUE obj)
+{
+  rb_gsl_fdiff *fd = NULL;
+  Data_Get_Struct(obj, rb_gsl_fdiff, fd);
+  return rb_str_new2(fd->type == RB_GSL_FDIFF_CENTRAL ? "central" : "forward");
+}
+
+static VALUE rb_gsl_fdiff_get_step(VALUE obj)
+{
+  rb_gsl_fdiff *fd = NULL;
+  Data_Get_Struct(obj, rb_gsl_fdiff, fd);
+  return rb_float_new(rb_gsl_fdiff_step(fd));
+}
+
+static VALUE rb_gsl_fdiff_batch(VALUE obj)
+{
+  rb_gsl_fdiff *fd = NULL;
+  Data_Get_Struct(obj, rb_gsl_fdiff, fd);
+  return fd->batch;
+}
+
+static VALUE rb_gsl_fdiff_threads(VALUE obj)
+{
+  rb_gsl_fdiff *fd = NULL;
+  Data_Get_Struct(obj, rb_gsl_fdiff, fd);
+  return SIZET2NUM(fd->threads);
+}
+
+/* Whether the points would be evaluated from several threads: the
+   solver then passes rb_gsl_fdiff_jacobian_mt a function safe for it */
+int rb_gsl_fdiff_threaded(VALUE vfd)
+{
+  rb_gsl_fdiff *fd = NULL;
+  Data_Get_Struct(vfd, rb_gsl_fdiff, fd);
+  return fd->threads > 1 && NIL_P(fd->batch);
+}
+
+/*
+  The engine
+*/
+struct fdiff_run {
+  const rb_gsl_fdiff *fd;
+  rb_gsl_fdiff_function f;
+  void *data;
+  int flags;
+  int argc;
+  const VALUE *argv;
+  const gsl_vector *x, *fx;
+  gsl_matrix *J;
+  gsl_matrix *X, *FX;           /* the points and the values there */
+  double *h;
+  gsl_matrix_view *view;        /* X as passed to the batch callable */
+};
+
+/* FX = the values of the batch callable's result v, k points of m values */
+static void fdiff_batch_values(VALUE v, gsl_matrix *FX)
+{
+  gsl_matrix *m = NULL;
+  gsl_vector *vv = NULL;
+  size_t i, j, k = FX->size1;
+  if (rb_obj_is_kind_of(v, cgsl_matrix)) {
+    Data_Get_Struct(v, gsl_matrix, m);
+    if (m->size1 != k || m->size2 != FX->size2)
+      rb_raise(rb_eRuntimeError, "batch returned a %dx%d matrix (%dx%d expected)",
+	       (int) m->size1, (int) m->size2, (int) k, (int) FX->size2);
+    for (i = 0; i < k; i++)
+      for (j = 0; j < FX->size2; j++) gsl_matrix_set(FX, i, j, gsl_matrix_get(m, i, j));
+    return;
+  }
+  if (FX->size2 != 1)
+    rb_raise(rb_eTypeError, "wrong type %s returned by batch (Matrix expected)",
+	     rb_class2name(CLASS_OF(v)));
+  if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vv);
+    if (vv->size != k) goto size_error;
+    for (i = 0; i < k; i++) gsl_matrix_set(FX, i, 0, gsl_vector_get(vv, i));
+    return;
+  }
+  Check_Type(v, T_ARRAY);
+  if ((size_t) RARRAY_LEN(v) != k) goto size_error;
+  for (i = 0; i < k; i++) gsl_matrix_set(FX, i, 0, NUM2DBL(rb_ary_entry(v, i)));
+  return;
+ size_error:
+  rb_raise(rb_eRuntimeError, "batch returned %d values (%d expected)",
+	   (int) (VECTOR_P(v) ? vv->size : (size_t) RARRAY_LEN(v)), (int) k);
+}
+
+/* The points id, id + nthreads, ... */
+struct fdiff_part {
+  struct fdiff_run *r;
+  size_t id, nthreads;
+};
+
+static void fdiff_eval_part(struct fdiff_run *r, size_t id, size_t nthreads)
+{
+  gsl_vector_view xi, fi;
+  size_t i;
+  for (i = id; i < r->X->size1; i += nthreads) {
+    xi = gsl_matrix_row(r->X, i);
+    fi = gsl_matrix_row(r->FX, i);
+    (*r->f)(&xi.vector, r->data, &fi.vector);
+  }
+}
+
+static int fdiff_native_worker(void *data, size_t id)
+{
+  struct fdiff_part *t = (struct fdiff_part *) data;
+  fdiff_eval_part(t->r, id, t->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int fdiff_native_serial(void *data)
+{
+  struct fdiff_part *t = (struct fdiff_part *) data;
+  fdiff_eval_part(t->r, 0, 1);
+  return GSL_SUCCESS;
+}
+
+static VALUE fdiff_thread_body(void *data)
+{
+  struct fdiff_part *t = (struct fdiff_part *) data;
+  fdiff_eval_part(t->r, t->id, t->nthreads);
+  return Qnil;
+}
+
+static VALUE fdiff_thread_join(VALUE th)
+{
+  return rb_funcall(th, rb_intern("join"), 0);
+}
+
+/* Ruby threads over the points; all are joined before an exception of
+   any of them is raised again, so that none outlives X and FX */
+static void fdiff_eval_threads(struct fdiff_run *r, size_t nthreads)
+{
+  struct fdiff_part *parts = ALLOCA_N(struct fdiff_part, nthreads);
+  VALUE ths = rb_ary_new2(nthreads), th;
+  size_t i;
+  int state = 0, st;
+  for (i = 0; i < nthreads; i++) {
+    parts[i].r = r;
+    parts[i].id = i;
+    parts[i].nthreads = nthreads;
+    th = rb_thread_create(fdiff_thread_body, &parts[i]);
+    rb_funcall(th, rb_intern("report_on_exception="), 1, Qfalse);
+    rb_ary_push(ths, th);
+  }
+  for (i = 0; i < nthreads; i++) {
+    st = 0;
+    rb_protect(fdiff_thread_join, rb_ary_entry(ths, i), &st);
+    if (st && !state) state = st;
+  }
+  RB_GC_GUARD(ths);
+  if (state) rb_jump_tag(state);
+}
+
+static void fdiff_eval(struct fdiff_run *r)
+{
+  struct fdiff_part t;
+  VALUE *args;
+  size_t k = r->X->size1, nthreads = GSL_MIN(r->fd->threads, k);
+  int j;
+  if (NIL_P(r->fd->batch)) {
+    if (r->flags & RB_GSL_FDIFF_NATIVE) {
+      t.r = r;
+      t.nthreads = nthreads;
+      if (nthreads > 1) rb_gsl_nogvl_parallel(fdiff_native_worker, &t, nthreads);
+      else rb_gsl_nogvl_call(fdiff_native_serial, &t, k*r->FX->size2);
+    } else if (nthreads > 1 && (r->flags & RB_GSL_FDIFF_REENTRANT)) {
+      fdiff_eval_threads(r, nthreads);
+    } else {
+      fdiff_eval_part(r, 0, 1);
+    }
+    return;
+  }
+  r->view = gsl_matrix_view_alloc();
+  r->view->matrix = *r->X;
+  r->view->matrix.owner = 0;
+  args = ALLOCA_N(VALUE, r->argc + 1);
+  args[0] = Data_Wrap_Struct(cgsl_matrix_view_ro, 0, gsl_matrix_view_free, r->view);
+  for (j = 0; j < r->argc; j++) args[j+1] = r->argv[j];
+  fdiff_batch_values(rb_funcall2(r->fd->batch, RBGSL_ID_call, r->argc + 1, args), r->FX);
+}
+
+static VALUE fdiff_run_body(VALUE arg)
+{
+  struct fdiff_run *r = (struct fdiff_run *) arg;
+  gsl_vector_view row;
+  size_t n = r->x->size, m = r->J->size1, i, j, k;
+  int central = r->fd->type == RB_GSL_FDIFF_CENTRAL;
+  int f0 = !central && r->fx == NULL;   /* f(x) evaluated with the other points */
+  double step = rb_gsl_fdiff_step(r->fd), xj, f0i, d;
+  volatile double t;
+  k = central ? 2*n : n + f0;
+  r->X = gsl_matrix_alloc(k, n);
+  r->FX = gsl_matrix_alloc(k, m);
+  r->h = ALLOC_N(double, n);
+  for (i = 0; i < k; i++) {
+    row = gsl_matrix_row(r->X, i);
+    gsl_vector_memcpy(&row.vector, r->x);
+  }
+  for (j = 0; j < n; j++) {
+    xj = gsl_vector_get(r->x, j);
+    t = xj + step*GSL_MAX(fabs(xj), 1.0);
+    r->h[j] = t - xj;
+    if (central) {
+      gsl_matrix_set(r->X, 2*j, j, xj + r->h[j]);
+      gsl_matrix_set(r->X, 2*j + 1, j, xj - r->h[j]);
+    } else {
+      gsl_matrix_set(r->X, j, j, xj + r->h[j]);
+    }
+  }
+  fdiff_eval(r);
+  for (i = 0; i < m; i++) {
+    f0i = central ? 0.0 : (r->fx ? gsl_vector_get(r->fx, i) : gsl_matrix_get(r->FX, n, i));
+    for (j = 0; j < n; j++) {
+      if (central)
+	d = (gsl_matrix_get(r->FX, 2*j, i) - gsl_matrix_get(r->FX, 2*j + 1, i))/(2.0*r->h[j]);
+      else
+	d = (gsl_matrix_get(r->FX, j, i) - f0i)/r->h[j];
+      gsl_matrix_set(r->J, i, j, d);
+    }
+  }
+  return Qnil;
+}
+
+static VALUE fdiff_run_ensure(VALUE arg)
+{
+  struct fdiff_run *r = (struct fdiff_run *) arg;
+  if (r->view) memset(&r->view->matrix, 0, sizeof(gsl_matrix));
+  if (r->X) gsl_matrix_free(r->X);
+  if (r->FX) gsl_matrix_free(r->FX);
+  if (r->h) xfree(r->h);
+  return Qnil;
+}
+
+/*
+  J (m x n) = the Jacobian at x of f, the function of vfd; fx is f(x)
+  or NULL.  argv are the arguments after the points for the batch
+  callable.  Exceptions raised by f leave no memory behind.  flags
+  RB_GSL_FDIFF_NATIVE: f does not touch Ruby and is thread safe, and is
+  run without the GVL; RB_GSL_FDIFF_REENTRANT: f may be called from
+  several Ruby threads at once.
+*/
+int rb_gsl_fdiff_jacobian_mt(VALUE vfd, rb_gsl_fdiff_function f, void *data, int flags,
+			     int argc, const VALUE *argv, const gsl_vector *x,
+			     const gsl_vector *fx, gsl_matrix *J)
+{
+  struct fdiff_run r;
+  rb_gsl_fdiff *fd = NULL;
+  Data_Get_Struct(vfd, rb_gsl_fdiff, fd);
+  if (J->size2 != x->size)
+    rb_raise(rb_eArgError, "Jacobian of %d columns for %d variables",
+	     (int) J->size2, (int) x->size);
+  memset(&r, 0, sizeof(r));
+  r.fd = fd;
+  r.f = f;
+  r.data = data;
+  r.flags = flags;
+  r.argc = argc;
+  r.argv = argv;
+  r.x = x;
+  r.fx = fx;
+  r.J = J;
+  rb_ensure(fdiff_run_body, (VALUE) &r, fdiff_run_ensure, (VALUE) &r);
+  return GSL_SUCCESS;
+}
+
+int rb_gsl_fdiff_jacobian(VALUE vfd, rb_gsl_fdiff_function f, void *data,
+			  int argc, const VALUE *argv, const gsl_vector *x,
+			  const gsl_vector *fx, gsl_matrix *J)
+{
+  return rb_gsl_fdiff_jacobian_mt(vfd, f, data, 0, argc, argv, x, fx, J);
+}
+
+/*
+  Jacobian#jacobian(f, x) and #gradient(f, x) for a callable f(x)
+  returning a Vector, an Array or a Numeric
+*/
+static void fdiff_proc_values(VALUE v, gsl_vector *f)
+{
+  gsl_vector *vv = NULL;
+  size_t i;
+  if (rb_obj_is_kind_of(v, rb_cNumeric)) {
+    if (f->size != 1) goto size_error;
+    gsl_vector_set(f, 0, NUM2DBL(v));
+  } else if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vv);
+    if (vv->size != f->size) goto size_error;
+    gsl_vector_memcpy(f, vv);
+  } else {
+    Check_Type(v, T_ARRAY);
+    if ((size_t) RARRAY_LEN(v) != f->size) goto size_error;
+    for (i = 0; i < f->size; i++) gsl_vector_set(f, i, NUM2DBL(rb_ary_entry(v, i)));
+  }
+  return;
+ size_error:
+  rb_raise(rb_eRuntimeError, "function returned a different number of values");
+}
+
+/* data is [proc, x view] */
+static int fdiff_proc_f(const gsl_vector *x, void *data, gsl_vector *f)
+{
+  VALUE ary = (VALUE) data, vx, v;
+  gsl_vector saved;
+  vx = rb_gsl_callback_vector(ary, 1, cgsl_vector_view_ro, x, &saved);
+  v = rb_funcall(rb_ary_entry(ary, 0), RBGSL_ID_call, 1, vx);
+  rb_gsl_callback_vector_restore(vx, &saved);
+  fdiff_proc_values(v, f);
+  return GSL_SUCCESS;
+}
+
+static size_t fdiff_proc_size(VALUE v)
+{
+  gsl_vector *vv = NULL;
+  if (rb_obj_is_kind_of(v, rb_cNumeric)) return 1;
+  if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vv);
+    return vv->size;
+  }
+  Check_Type(v, T_ARRAY);
+  return RARRAY_LEN(v);
+}
+
+static VALUE rb_gsl_fdiff_eval(VALUE obj, VALUE proc, VALUE vx, int gradient)
+{
+  gsl_vector *x = NULL, *fx = NULL;
+  gsl_matrix *J = NULL;
+  VALUE ary, vfx, vJ, v;
+  size_t m;
+  if (!rb_respond_to(proc, RBGSL_ID_call))
+    rb_raise(rb_eTypeError, "wrong argument type %s (callable expected)",
+	     rb_class2name(CLASS_OF(proc)));
+  CHECK_VECTOR(vx);
+  Data_Get_Vector(vx, x);
+  v = rb_funcall(proc, RBGSL_ID_call, 1, vx);
+  m = fdiff_proc_size(v);
+  if (gradient && m != 1) rb_raise(rb_eRuntimeError, "gradient of a function of %d values", (int) m);
+  fx = gsl_vector_alloc(m);
+  vfx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, fx);
+  fdiff_proc_values(v, fx);
+  J = gsl_matrix_alloc(m, x->size);
+  vJ = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, J);
+  ary = rb_ary_new3(2, proc, Qnil);
+  rb_gsl_fdiff_jacobian(obj, fdiff_proc_f, (void *) ary, 0, NULL, x, fx, J);
+  RB_GC_GUARD(vfx);
+  RB_GC_GUARD(vJ);
+  RB_GC_GUARD(ary);
+  if (gradient) {
+    gsl_vector_view row = gsl_matrix_row(J, 0);
+    gsl_vector *g = gsl_vector_alloc(x->size);
+    gsl_vector_memcpy(g, &row.vector);
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, g);
+  }
+  return vJ;
+}
+
+static VALUE rb_gsl_fdiff_jacobian_m(VALUE obj, VALUE proc, VALUE vx)
+{
+  return rb_gsl_fdiff_eval(obj, proc, vx, 0);
+}
+
+static VALUE rb_gsl_fdiff_gradient(VALUE obj, VALUE proc, VALUE vx)
+{
+  return rb_gsl_fdiff_eval(obj, proc, vx, 1);
+}
+
+void Init_gsl_diff_jacobian(VALUE mgsl_diff)
+{
+  cgsl_diff_jacobian = rb_define_class_under(mgsl_diff, "Jacobian", cGSL_Object);
+  rb_define_singleton_method(cgsl_diff_jacobian, "alloc", rb_gsl_fdiff_alloc, -1);
+  rb_define_singleton_method(cgsl_diff_jacobian, "new", rb_gsl_fdiff_alloc, -1);
+  rb_define_const(cgsl_diff_jacobian, "FORWARD", INT2FIX(RB_GSL_FDIFF_FORWARD));
+  rb_define_const(cgsl_diff_jacobian, "CENTRAL", INT2FIX(RB_GSL_FDIFF_CENTRAL));
+
+  rb_define_method(cgsl_diff_jacobian, "type", rb_gsl_fdiff_type, 0);
+  rb_define_method(cgsl_diff_jacobian, "step", rb_gsl_fdiff_get_step, 0);
+  rb_define_method(cgsl_diff_jacobian, "batch", rb_gsl_fdiff_batch, 0);
+  rb_define_method(cgsl_diff_jacobian, "threads", rb_gsl_fdiff_threads, 0);
+  rb_define_method(cgsl_diff_jacobian, "jacobian", rb_gsl_fdiff_jacobian_m, 2);
+  rb_define_method(cgsl_diff_jacobian, "gradient", rb_gsl_fdiff_gradient, 2);
+}
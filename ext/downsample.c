@@ -0,0 +1,212 @@
+/*
+  downsample.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Downsampling of long series for plotting, keeping the picture: the
+  Largest-Triangle-Three-Buckets algorithm (Steinarsson 2013) picks the
+  sample of each bucket spanning the largest triangle with its
+  neighbours, min-max decimation keeps the smallest and largest sample
+  of each bucket.  Both return the kept samples in order, x defaulting
+  to the sample index.
+
+    x, y = v.downsample_lttb(1000)
+    x, y = v.downsample_minmax(2000, t)   # t: abscissae of v
+
+  The plotting methods (Vector#graph, Vector#plot, Vector.graph,
+  Vector.plot, GSL::Graph#graph, Array#to_gplot) decimate with min-max
+  a series longer than GSL.plot_max_points (4000, twice the width of a
+  large window in pixels) whose abscissae do not decrease;
+  GSL.plot_max_points = 0 plots every sample.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+size_t rb_gsl_plot_max_points = 4000;
+
+#define DS_X(x, xs, i) ((x) ? (x)[(i)*(xs)] : (double) (i))
+
+/*
+  Indices of the m samples (3 <= m < n) LTTB keeps of y[i*ys], i < n,
+  at x[i*xs] (x NULL for the index)
+*/
+static size_t downsample_lttb(const double *x, size_t xs, const double *y, size_t ys,
+			      size_t n, size_t m, size_t *idx)
+{
+  double every = (double) (n - 2)/(m - 2), ax, ay, avgx, avgy, area, amax;
+  size_t i, j, a = 0, k = 0, lo, hi, alo, ahi;
+  idx[k++] = 0;
+  for (i = 0; i < m - 2; i++) {
+    alo = (size_t) ((i + 1)*every) + 1;
+    ahi = (size_t) ((i + 2)*every) + 1;
+    if (ahi > n) ahi = n;
+    avgx = avgy = 0.0;
+    for (j = alo; j < ahi; j++) {
+      avgx += DS_X(x, xs, j);
+      avgy += y[j*ys];
+    }
+    if (ahi > alo) {
+      avgx /= (double) (ahi - alo);
+      avgy /= (double) (ahi - alo);
+    } else {
+      avgx = DS_X(x, xs, n - 1);
+      avgy = y[(n - 1)*ys];
+    }
+    lo = (size_t) (i*every) + 1;
+    hi = (size_t) ((i + 1)*every) + 1;
+    if (hi > n - 1) hi = n - 1;
+    ax = DS_X(x, xs, a);
+    ay = y[a*ys];
+    amax = -1.0;
+    idx[k] = lo;
+    for (j = lo; j < hi; j++) {
+      area = fabs((ax - avgx)*(y[j*ys] - ay) - (ax - DS_X(x, xs, j))*(avgy - ay));
+      if (area > amax) {
+	amax = area;
+	idx[k] = j;
+      }
+    }
+    a = idx[k++];
+  }
+  idx[k++] = n - 1;
+  return k;
+}
+
+/*
+  Indices of the smallest and largest of y[i*ys] in each of m/2 buckets
+  of consecutive samples, in order; NaNs are passed over
+*/
+static size_t downsample_minmax(const double *y, size_t ys, size_t n, size_t m,
+				size_t *idx)
+{
+  size_t b, nb = m/2, lo, hi, j, imin, imax, k = 0;
+  for (b = 0; b < nb; b++) {
+    lo = (size_t) ((double) b*n/nb);
+    hi = (size_t) ((double) (b + 1)*n/nb);
+    if (hi > n || b == nb - 1) hi = n;
+    if (lo >= hi) continue;
+    for (imin = lo; imin < hi - 1 && isnan(y[imin*ys]); imin++);
+    imax = imin;
+    for (j = imin + 1; j < hi; j++) {
+      if (y[j*ys] < y[imin*ys]) imin = j;
+      if (y[j*ys] > y[imax*ys]) imax = j;
+    }
+    if (imin == imax) {
+      idx[k++] = imin;
+    } else if (imin < imax) {
+      idx[k++] = imin;
+      idx[k++] = imax;
+    } else {
+      idx[k++] = imax;
+      idx[k++] = imin;
+    }
+  }
+  return k;
+}
+
+/*
+  The samples a plot of y (and x, or NULL) keeps: NULL for every sample,
+  or an ALLOC_N'ed array of *m indices, which the caller xfrees
+*/
+size_t* rb_gsl_plot_decimate(const double *x, size_t xs, const double *y, size_t ys,
+			     size_t n, size_t *m)
+{
+  size_t i, *idx;
+  *m = n;
+  if (rb_gsl_plot_max_points < 2 || n <= rb_gsl_plot_max_points) return NULL;
+  if (x) {
+    for (i = 1; i < n; i++) if (!(x[i*xs] >= x[(i - 1)*xs])) return NULL;
+  }
+  idx = ALLOC_N(size_t, rb_gsl_plot_max_points);
+  *m = downsample_minmax(y, ys, n, rb_gsl_plot_max_points, idx);
+  return idx;
+}
+
+static VALUE rb_gsl_vector_downsample(int argc, VALUE *argv, VALUE obj, int lttb)
+{
+  gsl_vector *y = NULL, *x = NULL, *xnew, *ynew;
+  size_t n, m, i, *idx;
+  long lm;
+  VALUE vx, vy;
+  rb_check_arity(argc, 1, 2);
+  Data_Get_Vector(obj, y);
+  n = y->size;
+  lm = NUM2LONG(argv[0]);
+  if (lm < (lttb ? 3 : 2))
+    rb_raise(rb_eArgError, "number of points must be at least %d", lttb ? 3 : 2);
+  m = (size_t) lm;
+  if (argc == 2 && !NIL_P(argv[1])) {
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Vector(argv[1], x);
+    if (x->size != n)
+      rb_raise(rb_eArgError, "abscissae have size %d, %d expected",
+	       (int) x->size, (int) n);
+  }
+  if (m > n) m = n;
+  idx = ALLOC_N(size_t, m);
+  if (m == n) {
+    for (i = 0; i < n; i++) idx[i] = i;
+  } else if (lttb) {
+    m = downsample_lttb(x ? x->data : NULL, x ? x->stride : 1, y->data, y->stride,
+			n, m, idx);
+  } else {
+    m = downsample_minmax(y->data, y->stride, n, m, idx);
+  }
+  xnew = gsl_vector_alloc(m);
+  ynew = gsl_vector_alloc(m);
+  for (i = 0; i < m; i++) {
+    gsl_vector_set(xnew, i, x ? gsl_vector_get(x, idx[i]) : (double) idx[i]);
+    gsl_vector_set(ynew, i, gsl_vector_get(y, idx[i]));
+  }
+  xfree(idx);
+  vx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, xnew);
+  vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, ynew);
+  return rb_ary_new3(2, vx, vy);
+}
+
+/*
+  Vector#downsample_lttb(n, x = nil): [x, y] of the n samples kept by
+  Largest-Triangle-Three-Buckets
+*/
+static VALUE rb_gsl_vector_downsample_lttb(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_downsample(argc, argv, obj, 1);
+}
+
+/*
+  Vector#downsample_minmax(n, x = nil): [x, y] of the minimum and maximum
+  of each of n/2 buckets
+*/
+static VALUE rb_gsl_vector_downsample_minmax(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_downsample(argc, argv, obj, 0);
+}
+
+static VALUE rb_gsl_plot_max_points_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_plot_max_points);
+}
+
+static VALUE rb_gsl_plot_max_points_set(VALUE module, VALUE n)
+{
+  long m = NUM2LONG(n);
+  if (m < 0) rb_raise(rb_eRangeError, "plot_max_points must be non-negative");
+  rb_gsl_plot_max_points = (size_t) m;
+  return n;
+}
+
+void Init_gsl_downsample(VALUE module)
+{
+  rb_define_method(cgsl_vector, "downsample_lttb", rb_gsl_vector_downsample_lttb, -1);
+  rb_define_method(cgsl_vector, "downsample_minmax", rb_gsl_vector_downsample_minmax, -1);
+  rb_define_singleton_method(module, "plot_max_points", rb_gsl_plot_max_points_get, 0);
+  rb_define_singleton_method(module, "plot_max_points=", rb_gsl_plot_max_points_set, 1);
+}
@@ -48,6 +48,191 @@ static VALUE mgen, mgenv;
 static VALUE cgenw, cgenvw;
 #endif
 
+/*
+  The eigensolvers are pure C, so they run with the GVL released
+  (see rb_gsl_nogvl_call()) and other Ruby threads can proceed.
+*/
+struct eigen_nogvl_data {
+  void *A, *eval, *evec, *w;
+};
+
+static int eigen_symm_nogvl(void *data)
+{
+  struct eigen_nogvl_data *d = (struct eigen_nogvl_data *) data;
+#ifdef HAVE_LAPACK
+  if (mygsl_lapack_active())
+    return mygsl_lapack_symmv((gsl_matrix *) d->A, (gsl_vector *) d->eval, NULL);
+#endif
+  return gsl_eigen_symm((gsl_matrix *) d->A, (gsl_vector *) d->eval,
+			(gsl_eigen_symm_workspace *) d->w);
+}
+
+static int eigen_symmv_nogvl(void *data)
+{
+  struct eigen_nogvl_data *d = (struct eigen_nogvl_data *) data;
+#ifdef HAVE_LAPACK
+  if (mygsl_lapack_active())
+    return mygsl_lapack_symmv((gsl_matrix *) d->A, (gsl_vector *) d->eval,
+			      (gsl_matrix *) d->evec);
+#endif
+  return gsl_eigen_symmv((gsl_matrix *) d->A, (gsl_vector *) d->eval,
+			 (gsl_matrix *) d->evec, (gsl_eigen_symmv_workspace *) d->w);
+}
+
+static int eigen_herm_nogvl(void *data)
+{
+  struct eigen_nogvl_data *d = (struct eigen_nogvl_data *) data;
+  return gsl_eigen_herm((gsl_matrix_complex *) d->A, (gsl_vector *) d->eval,
+			(gsl_eigen_herm_workspace *) d->w);
+}
+
+static int eigen_hermv_nogvl(void *data)
+{
+  struct eigen_nogvl_data *d = (struct eigen_nogvl_data *) data;
+  return gsl_eigen_hermv((gsl_matrix_complex *) d->A, (gsl_vector *) d->eval,
+			 (gsl_matrix_complex *) d->evec, (gsl_eigen_hermv_workspace *) d->w);
+}
+
+static int mygsl_eigen_symm(gsl_matrix *A, gsl_vector *eval,
+			    gsl_eigen_symm_workspace *w)
+{
+  struct eigen_nogvl_data d;
+  d.A = A;  d.eval = eval;  d.evec = NULL;  d.w = w;
+  return rb_gsl_nogvl_call(eigen_symm_nogvl, &d, A->size1*A->size2);
+}
+
+static int mygsl_eigen_symmv(gsl_matrix *A, gsl_vector *eval, gsl_matrix *evec,
+			     gsl_eigen_symmv_workspace *w)
+{
+  struct eigen_nogvl_data d;
+  d.A = A;  d.eval = eval;  d.evec = evec;  d.w = w;
+  return rb_gsl_nogvl_call(eigen_symmv_nogvl, &d, A->size1*A->size2);
+}
+
+static int mygsl_eigen_herm(gsl_matrix_complex *A, gsl_vector *eval,
+			    gsl_eigen_herm_workspace *w)
+{
+  struct eigen_nogvl_data d;
+  d.A = A;  d.eval = eval;  d.evec = NULL;  d.w = w;
+  return rb_gsl_nogvl_call(eigen_herm_nogvl, &d, A->size1*A->size2);
+}
+
+static int mygsl_eigen_hermv(gsl_matrix_complex *A, gsl_vector *eval,
+			     gsl_matrix_complex *evec, gsl_eigen_hermv_workspace *w)
+{
+  struct eigen_nogvl_data d;
+  d.A = A;  d.eval = eval;  d.evec = evec;  d.w = w;
+  return rb_gsl_nogvl_call(eigen_hermv_nogvl, &d, A->size1*A->size2);
+}
+
+#ifdef GSL_1_9_LATER
+static int eigen_nonsymm_nogvl(void *data)
+{
+  struct eigen_nogvl_data *d = (struct eigen_nogvl_data *) data;
+  return gsl_eigen_nonsymm((gsl_matrix *) d->A, (gsl_vector_complex *) d->eval,
+			   (gsl_eigen_nonsymm_workspace *) d->w);
+}
+
+static int eigen_nonsymmv_nogvl(void *data)
+{
+  struct eigen_nogvl_data *d = (struct eigen_nogvl_data *) data;
+  return gsl_eigen_nonsymmv((gsl_matrix *) d->A, (gsl_vector_complex *) d->eval,
+			    (gsl_matrix_complex *) d->evec,
+			    (gsl_eigen_nonsymmv_workspace *) d->w);
+}
+
+static int mygsl_eigen_nonsymm(gsl_matrix *A, gsl_vector_complex *eval,
+			       gsl_eigen_nonsymm_workspace *w)
+{
+  struct eigen_nogvl_data d;
+  d.A = A;  d.eval = eval;  d.evec = NULL;  d.w = w;
+  return rb_gsl_nogvl_call(eigen_nonsymm_nogvl, &d, A->size1*A->size2);
+}
+
+static int mygsl_eigen_nonsymmv(gsl_matrix *A, gsl_vector_complex *eval,
+				gsl_matrix_complex *evec, gsl_eigen_nonsymmv_workspace *w)
+{
+  struct eigen_nogvl_data d;
+  d.A = A;  d.eval = eval;  d.evec = evec;  d.w = w;
+  return rb_gsl_nogvl_call(eigen_nonsymmv_nogvl, &d, A->size1*A->size2);
+}
+#endif
+
+/*
+  Calls without an explicit workspace take one from a small pool per
+  kind, keyed by size, instead of allocating and freeing it every
+  time.  A workspace is out of its pool while it is in use (the GVL is
+  released meanwhile), so concurrent calls never share one; the least
+  recently returned is freed when a pool is full.  The pools are per
+  thread, as Ractors may run these at the same time.
+*/
+#define EIGEN_POOL_SIZE 4
+
+struct eigen_pool {
+  void* (*alloc)(size_t n);
+  void (*free)(void *w);
+  size_t count;
+  size_t n[EIGEN_POOL_SIZE];
+  void *w[EIGEN_POOL_SIZE];
+};
+
+#define EIGEN_POOL(kind) \
+  static RB_GSL_THREAD_LOCAL struct eigen_pool eigen_##kind##_pool = { \
+    (void* (*)(size_t)) gsl_eigen_##kind##_alloc, \
+    (void (*)(void *)) gsl_eigen_##kind##_free, 0, {0}, {NULL} }
+
+EIGEN_POOL(symm);
+EIGEN_POOL(symmv);
+EIGEN_POOL(herm);
+EIGEN_POOL(hermv);
+#ifdef GSL_1_9_LATER
+EIGEN_POOL(nonsymm);
+EIGEN_POOL(nonsymmv);
+#endif
+
+static void eigen_pool_remove(struct eigen_pool *p, size_t i)
+{
+  for (; i + 1 < p->count; i++) {
+    p->n[i] = p->n[i+1];
+    p->w[i] = p->w[i+1];
+  }
+  p->count--;
+}
+
+static void* eigen_pool_take(struct eigen_pool *p, size_t n)
+{
+  size_t i;
+  void *w;
+  for (i = p->count; i-- > 0;) {
+    if (p->n[i] == n) {
+      w = p->w[i];
+      eigen_pool_remove(p, i);
+      return w;
+    }
+  }
+  return p->alloc(n);
+}
+
+static void eigen_pool_give(struct eigen_pool *p, size_t n, void *w)
+{
+  if (p->count == EIGEN_POOL_SIZE) {
+    p->free(p->w[0]);
+    eigen_pool_remove(p, 0);
+  }
+  p->n[p->count] = n;
+  p->w[p->count++] = w;
+}
+
+/* A trailing {:overwrite => true} lets symm, symmv, herm and hermv
+   work on the input matrix itself, which is destroyed, instead of on
+   a copy */
+static int eigen_overwrite_opt(int *argc, VALUE *argv)
+{
+  if (*argc == 0 || TYPE(argv[*argc-1]) != T_HASH) return 0;
+  *argc -= 1;
+  return RTEST(rb_hash_aref(argv[*argc], ID2SYM(rb_intern("overwrite"))));
+}
+
 static VALUE rb_gsl_eigen_symm_alloc(VALUE klass, VALUE nn)
 {
   gsl_eigen_symm_workspace *w = NULL;
@@ -92,7 +277,7 @@ static VALUE rb_gsl_eigen_symm(int argc, VALUE *argv, VALUE obj)
   gsl_matrix *Atmp = NULL, *A = NULL;
   gsl_eigen_symm_workspace *w = NULL;
   gsl_vector *v = NULL;
-  int flagw = 0;
+  int flagw = 0, overwrite = eigen_overwrite_opt(&argc, argv);
   switch (TYPE(obj)) {
   case T_MODULE:
   case T_CLASS:
@@ -116,7 +301,7 @@ static VALUE rb_gsl_eigen_symm(int argc, VALUE *argv, VALUE obj)
 #endif
       CHECK_MATRIX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix, Atmp);
-      w = gsl_eigen_symm_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_symm_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -137,19 +322,19 @@ static VALUE rb_gsl_eigen_symm(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_symm_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_symm_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_symm_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
       rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
     }
   }
-  A = make_matrix_clone(Atmp);
+  A = overwrite ? Atmp : make_matrix_clone(Atmp);
   v = gsl_vector_alloc(A->size1);
-  gsl_eigen_symm(A, v, w);
+  mygsl_eigen_symm(A, v, w);
   /*  gsl_sort_vector(v);*/
-  gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symm_free(w);
+  if (flagw == 1) eigen_pool_give(&eigen_symm_pool, A->size1, w);
+  if (!overwrite) gsl_matrix_free(A);
   return Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
 }
 
@@ -191,7 +376,7 @@ static VALUE rb_gsl_eigen_symm_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_symm_alloc(A->size1);
+    w = eigen_pool_take(&eigen_symm_pool, A->size1);
     flagw = 1;
     break;
   default:
@@ -201,10 +386,10 @@ static VALUE rb_gsl_eigen_symm_narray(int argc, VALUE *argv, VALUE obj)
   shape[0] = A->size1;
   nary = na_make_object(NA_DFLOAT, 1, shape, cNVector);
   vv = gsl_vector_view_array(NA_PTR_TYPE(nary,double*), A->size1);
-  gsl_eigen_symm(A, &vv.vector, w);
+  mygsl_eigen_symm(A, &vv.vector, w);
   /*  gsl_sort_vector(v);*/
+  if (flagw == 1) eigen_pool_give(&eigen_symm_pool, A->size1, w);
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symm_free(w);
   return nary;
 }
 #endif
@@ -218,7 +403,7 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
   gsl_matrix *Atmp = NULL, *A = NULL, *em = NULL;
   gsl_eigen_symmv_workspace *w = NULL;
   gsl_vector *v = NULL;
-  int flagw = 0;
+  int flagw = 0, overwrite = eigen_overwrite_opt(&argc, argv);
   VALUE vval, vvec;
   switch (TYPE(obj)) {
   case T_MODULE:
@@ -243,7 +428,7 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
 #endif
       CHECK_MATRIX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix, Atmp);
-      w = gsl_eigen_symmv_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_symmv_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -263,7 +448,7 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_symmv_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_symmv_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_symmv_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -271,13 +456,13 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
       break;
     }
   }
-  A = make_matrix_clone(Atmp);
+  A = overwrite ? Atmp : make_matrix_clone(Atmp);
   em = gsl_matrix_alloc(A->size1, A->size2);
   v = gsl_vector_alloc(A->size1);
-  gsl_eigen_symmv(A, v, em, w);
+  mygsl_eigen_symmv(A, v, em, w);
   /*  gsl_eigen_symmv_sort(v, em, GSL_EIGEN_SORT_VAL_DESC);*/
-  gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symmv_free(w);
+  if (flagw == 1) eigen_pool_give(&eigen_symmv_pool, A->size1, w);
+  if (!overwrite) gsl_matrix_free(A);
   vval = Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
   vvec = Data_Wrap_Struct(cgsl_eigen_vectors, 0, gsl_matrix_free, em);
   return rb_ary_new3(2, vval, vvec);
@@ -322,7 +507,7 @@ static VALUE rb_gsl_eigen_symmv_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_symmv_alloc(A->size1);
+    w = eigen_pool_take(&eigen_symmv_pool, A->size1);
     flagw = 1;
     break;
   default:
@@ -336,10 +521,10 @@ static VALUE rb_gsl_eigen_symmv_narray(int argc, VALUE *argv, VALUE obj)
   evec = na_make_object(NA_DFLOAT, 2, shape2, CLASS_OF(argv[0]));
   vv = gsl_vector_view_array(NA_PTR_TYPE(eval,double*), A->size1);
   mv = gsl_matrix_view_array(NA_PTR_TYPE(evec,double*), A->size1, A->size2);
-  gsl_eigen_symmv(A, &vv.vector, &mv.matrix, w);
+  mygsl_eigen_symmv(A, &vv.vector, &mv.matrix, w);
   /*  gsl_sort_vector(v);*/
+  if (flagw == 1) eigen_pool_give(&eigen_symmv_pool, A->size1, w);
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symmv_free(w);
   return rb_ary_new3(2, eval, evec);
 }
 #endif
@@ -349,7 +534,7 @@ static VALUE rb_gsl_eigen_herm(int argc, VALUE *argv, VALUE obj)
   gsl_matrix_complex *Atmp = NULL, *A = NULL;
   gsl_eigen_herm_workspace *w = NULL;
   gsl_vector *v = NULL;
-  int flagw = 0;
+  int flagw = 0, overwrite = eigen_overwrite_opt(&argc, argv);
 
   switch (TYPE(obj)) {
   case T_MODULE:
@@ -368,7 +553,7 @@ static VALUE rb_gsl_eigen_herm(int argc, VALUE *argv, VALUE obj)
     case 1:
       CHECK_MATRIX_COMPLEX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix_complex, Atmp);
-      w = gsl_eigen_herm_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_herm_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -388,19 +573,19 @@ static VALUE rb_gsl_eigen_herm(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_herm_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_herm_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_herm_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
       rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
     }
   }
-  A = make_matrix_complex_clone(Atmp);
+  A = overwrite ? Atmp : make_matrix_complex_clone(Atmp);
   v = gsl_vector_alloc(A->size1);
-  gsl_eigen_herm(A, v, w);
+  mygsl_eigen_herm(A, v, w);
   /*  gsl_sort_vector(v);*/
-  gsl_matrix_complex_free(A);
-  if (flagw == 1) gsl_eigen_herm_free(w);
+  if (flagw == 1) eigen_pool_give(&eigen_herm_pool, A->size1, w);
+  if (!overwrite) gsl_matrix_complex_free(A);
   return Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
 }
 
@@ -409,7 +594,7 @@ static VALUE rb_gsl_eigen_hermv(int argc, VALUE *argv, VALUE obj)
   gsl_matrix_complex *Atmp = NULL, *A = NULL, *em = NULL;
   gsl_eigen_hermv_workspace *w = NULL;
   gsl_vector *v = NULL;
-  int flagw = 0;
+  int flagw = 0, overwrite = eigen_overwrite_opt(&argc, argv);
   VALUE vval, vvec;
   switch (TYPE(obj)) {
   case T_MODULE:
@@ -428,7 +613,7 @@ static VALUE rb_gsl_eigen_hermv(int argc, VALUE *argv, VALUE obj)
     case 1:
       CHECK_MATRIX_COMPLEX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix_complex, Atmp);
-      w = gsl_eigen_hermv_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_hermv_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -448,20 +633,20 @@ static VALUE rb_gsl_eigen_hermv(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_hermv_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_hermv_alloc(Atmp->size1);
+      w = eigen_pool_take(&eigen_hermv_pool, Atmp->size1);
       flagw = 1;
       break;
     default:
       rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
     }
   }
-  A = make_matrix_complex_clone(Atmp);
+  A = overwrite ? Atmp : make_matrix_complex_clone(Atmp);
   em = gsl_matrix_complex_alloc(A->size1, A->size2);
   v = gsl_vector_alloc(A->size1);
-  gsl_eigen_hermv(A, v, em, w);
+  mygsl_eigen_hermv(A, v, em, w);
   /*  gsl_eigen_hermv_sort(v, em, GSL_EIGEN_SORT_VAL_DESC);*/
-  gsl_matrix_complex_free(A);
-  if (flagw == 1) gsl_eigen_hermv_free(w);
+  if (flagw == 1) eigen_pool_give(&eigen_hermv_pool, A->size1, w);
+  if (!overwrite) gsl_matrix_complex_free(A);
   vval = Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
   vvec = Data_Wrap_Struct(cgsl_eigen_herm_vectors, 0, gsl_matrix_complex_free, em);
   return rb_ary_new3(2, vval, vvec);
@@ -884,14 +1069,14 @@ static VALUE rb_gsl_eigen_nonsymm(int argc, VALUE *argv, VALUE obj)
   switch (argc-istart) {
   case 0:
     v = gsl_vector_complex_alloc(m->size1);
-    w = gsl_eigen_nonsymm_alloc(m->size1);
+    w = eigen_pool_take(&eigen_nonsymm_pool, m->size1);
     vflag = 1;
     wflag = 1;
     break;
   case 1:
     if (CLASS_OF(argv2[0]) == cgsl_vector_complex) {
       Data_Get_Struct(argv2[0], gsl_vector_complex, v);
-      w = gsl_eigen_nonsymm_alloc(m->size1);
+      w = eigen_pool_take(&eigen_nonsymm_pool, m->size1);
       wflag = 1;      
     } else if (CLASS_OF(argv2[0]) == cgsl_eigen_nonsymm_workspace) {
       v = gsl_vector_complex_alloc(m->size1);
@@ -913,9 +1098,9 @@ static VALUE rb_gsl_eigen_nonsymm(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "Wrong number of arguments (%d for 0-2).\n", argc);
   }
 //  mtmp = make_matrix_clone(m);
-  gsl_eigen_nonsymm(m, v, w);
+  mygsl_eigen_nonsymm(m, v, w);
 //  gsl_matrix_free(mtmp);
-  if (wflag == 1) gsl_eigen_nonsymm_free(w);
+  if (wflag == 1) eigen_pool_give(&eigen_nonsymm_pool, m->size1, w);
   if (vflag == 1)
     return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v);
   else
@@ -960,7 +1145,7 @@ static VALUE rb_gsl_eigen_nonsymm_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_nonsymm_alloc(A->size1);
+    w = eigen_pool_take(&eigen_nonsymm_pool, A->size1);
     flagw = 1;
     break;
   default:
@@ -970,10 +1155,10 @@ static VALUE rb_gsl_eigen_nonsymm_narray(int argc, VALUE *argv, VALUE obj)
   shape[0] = A->size1;
   nary = na_make_object(NA_DCOMPLEX, 1, shape, cNVector);
   vv = gsl_vector_complex_view_array(NA_PTR_TYPE(nary,double*), A->size1);
-  gsl_eigen_nonsymm(A, &vv.vector, w);
+  mygsl_eigen_nonsymm(A, &vv.vector, w);
   /*  gsl_sort_vector(v);*/
+  if (flagw == 1) eigen_pool_give(&eigen_nonsymm_pool, A->size1, w);
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_nonsymm_free(w);
   return nary;
 }
 #endif
@@ -1088,7 +1273,7 @@ static VALUE rb_gsl_eigen_nonsymmv(int argc, VALUE *argv, VALUE obj)
   case 0:
     v = gsl_vector_complex_alloc(m->size1);
     evec = gsl_matrix_complex_alloc(m->size1, m->size2);
-    w = gsl_eigen_nonsymmv_alloc(m->size1);
+    w = eigen_pool_take(&eigen_nonsymmv_pool, m->size1);
     vflag = 1;
     wflag = 1;
     break;
@@ -1105,7 +1290,9 @@ static VALUE rb_gsl_eigen_nonsymmv(int argc, VALUE *argv, VALUE obj)
   case 2:
     CHECK_VECTOR_COMPLEX(argv2[0]);
     CHECK_MATRIX_COMPLEX(argv2[1]);
-    w = gsl_eigen_nonsymmv_alloc(m->size1);
+    Data_Get_Struct(argv2[0], gsl_vector_complex, v);
+    Data_Get_Struct(argv2[1], gsl_matrix_complex, evec);
+    w = eigen_pool_take(&eigen_nonsymmv_pool, m->size1);
     wflag = 1;
     break;
   case 3:
@@ -1122,10 +1309,10 @@ static VALUE rb_gsl_eigen_nonsymmv(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "Wrong number of arguments (%d for 0-3).\n", argc);
   }
 //  mtmp = make_matrix_clone(m);
-  gsl_eigen_nonsymmv(m, v, evec, w);
+  mygsl_eigen_nonsymmv(m, v, evec, w);
 //  gsl_matrix_free(mtmp);
 
-  if (wflag == 1) gsl_eigen_nonsymmv_free(w);
+  if (wflag == 1) eigen_pool_give(&eigen_nonsymmv_pool, m->size1, w);
   if (vflag == 1) {
     return rb_ary_new3(2, 
 		       Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v),
@@ -1174,7 +1361,7 @@ static VALUE rb_gsl_eigen_nonsymmv_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_nonsymmv_alloc(A->size1);
+    w = eigen_pool_take(&eigen_nonsymmv_pool, A->size1);
     flagw = 1;
     break;
   default:
@@ -1186,10 +1373,10 @@ static VALUE rb_gsl_eigen_nonsymmv_narray(int argc, VALUE *argv, VALUE obj)
   vv = gsl_vector_complex_view_array(NA_PTR_TYPE(nary,double*), A->size1);
   nvec = na_make_object(NA_DCOMPLEX, 2, shape2, CLASS_OF(argv[0]));
   mm = gsl_matrix_complex_view_array(NA_PTR_TYPE(nvec,double*), A->size1, A->size2);
-  gsl_eigen_nonsymmv(A, &vv.vector, &mm.matrix, w);
+  mygsl_eigen_nonsymmv(A, &vv.vector, &mm.matrix, w);
   /*  gsl_sort_vector(v);*/
+  if (flagw == 1) eigen_pool_give(&eigen_nonsymmv_pool, A->size1, w);
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_nonsymmv_free(w);
   return rb_ary_new3(2, nary, nvec);
 }
 #endif
@@ -2114,6 +2301,9 @@ static VALUE rb_gsl_eigen_genv_sort(int argc, VALUE *argv, VALUE obj)
 }
 #endif
 
+void Init_gsl_eigen_lanczos(VALUE module);
+void Init_gsl_eigen_batch(VALUE module);
+
 void Init_gsl_eigen(VALUE module)
 {
   VALUE mgsl_eigen;
@@ -2369,5 +2559,7 @@ void Init_gsl_eigen(VALUE module)
          rb_gsl_eigen_genv_sort, -1);   
 #endif
 
+  Init_gsl_eigen_lanczos(mgsl_eigen);
+  Init_gsl_eigen_batch(mgsl_eigen);
 }
 
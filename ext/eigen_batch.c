@@ -0,0 +1,306 @@
+/*
+  eigen_batch.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Eigenvalues and eigenvectors of many small symmetric matrices.
+
+    eval = GSL::Eigen::Batch.symm(a)
+    eval, evec = GSL::Eigen::Batch.symmv(a)    # or symmv(a, eval, evec)
+
+  a is a stack of n x n matrices as for GSL::Linalg::Batch: a
+  (batch*n) x n GSL::Matrix, or an Array of matrices.  Only the lower
+  triangles are read.  eval is a batch x n GSL::Matrix, its row k the
+  eigenvalues of matrix k in ascending order, and evec a (batch*n) x n
+  GSL::Matrix whose block k holds the matching eigenvectors in columns,
+  as Eigen.symmv does.  Both may be given to be reused.
+
+  2 x 2 matrices are diagonalized by a single rotation.  For 3 x 3 the
+  eigenvalues have a closed form (Smith, CACM 4, 1961) and the
+  eigenvectors of the two outer ones are cross products of rows of
+  A - lambda I; when two eigenvalues are too close for that to be
+  accurate, the matrix goes through cyclic Jacobi instead, as do the
+  sizes up to EIGEN_BATCH_JACOBI_MAX.  Larger matrices use
+  gsl_eigen_symmv.  The batch is split into contiguous ranges over
+  threads with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include "rb_gsl_eigen.h"
+
+#define EIGEN_BATCH_JACOBI_MAX 10
+
+/* Cyclic Jacobi on the packed symmetric n x n A, eigenvectors to the
+   columns of V, eigenvalues to w, in ascending order */
+static void eigen_batch_jacobi(double *A, double *V, double *w, const size_t n)
+{
+  size_t sweep, p, q, k;
+  double off, norm, apq, theta, t, c, s, x, y;
+  for (p = 0; p < n; p++)
+    for (q = 0; q < n; q++) V[p*n + q] = p == q;
+  for (sweep = 0; sweep < 50; sweep++) {
+    off = norm = 0.0;
+    for (p = 0; p < n; p++) {
+      norm += A[p*n + p]*A[p*n + p];
+      for (q = p + 1; q < n; q++) off += A[p*n + q]*A[p*n + q];
+    }
+    if (off <= GSL_DBL_EPSILON*GSL_DBL_EPSILON*(norm + 2.0*off)) break;
+    for (p = 0; p < n; p++) {
+      for (q = p + 1; q < n; q++) {
+	apq = A[p*n + q];
+	if (apq == 0.0) continue;
+	theta = (A[q*n + q] - A[p*n + p])/(2.0*apq);
+	if (fabs(theta) > 1e150) t = 0.5/theta;
+	else t = (theta >= 0.0 ? 1.0 : -1.0)/(fabs(theta) + sqrt(theta*theta + 1.0));
+	c = 1.0/sqrt(t*t + 1.0);
+	s = t*c;
+	for (k = 0; k < n; k++) {
+	  x = A[k*n + p]; y = A[k*n + q];
+	  A[k*n + p] = c*x - s*y; A[k*n + q] = s*x + c*y;
+	}
+	for (k = 0; k < n; k++) {
+	  x = A[p*n + k]; y = A[q*n + k];
+	  A[p*n + k] = c*x - s*y; A[q*n + k] = s*x + c*y;
+	}
+	for (k = 0; k < n; k++) {
+	  x = V[k*n + p]; y = V[k*n + q];
+	  V[k*n + p] = c*x - s*y; V[k*n + q] = s*x + c*y;
+	}
+      }
+    }
+  }
+  for (p = 0; p < n; p++) w[p] = A[p*n + p];
+  for (p = 0; p < n; p++) {
+    q = p;
+    for (k = p + 1; k < n; k++) if (w[k] < w[q]) q = k;
+    if (q == p) continue;
+    x = w[p]; w[p] = w[q]; w[q] = x;
+    for (k = 0; k < n; k++) {
+      x = V[k*n + p]; V[k*n + p] = V[k*n + q]; V[k*n + q] = x;
+    }
+  }
+}
+
+static void eigen_batch_2(const double *A, double *V, double *w)
+{
+  double a = A[0], b = A[2], c = A[3], m = 0.5*(a + c), d, th;
+  d = gsl_hypot(0.5*(a - c), b);
+  th = 0.5*atan2(2.0*b, a - c);
+  w[0] = m - d;
+  w[1] = m + d;
+  V[0] = -sin(th); V[1] = cos(th);
+  V[2] = cos(th);  V[3] = sin(th);
+}
+
+/* The unit null vector of A - lambda I from the largest cross product
+   of two of its rows; 0 if they are all parallel */
+static int eigen_batch_null3(const double *A, double lambda, double *v)
+{
+  double r[3][3], c[3], best = 0.0, nrm;
+  size_t i, j, k;
+  for (i = 0; i < 3; i++)
+    for (j = 0; j < 3; j++) r[i][j] = A[i*3 + j] - (i == j ? lambda : 0.0);
+  for (i = 0; i < 3; i++) {
+    j = (i + 1) % 3;
+    c[0] = r[i][1]*r[j][2] - r[i][2]*r[j][1];
+    c[1] = r[i][2]*r[j][0] - r[i][0]*r[j][2];
+    c[2] = r[i][0]*r[j][1] - r[i][1]*r[j][0];
+    nrm = c[0]*c[0] + c[1]*c[1] + c[2]*c[2];
+    if (nrm > best) {
+      best = nrm;
+      for (k = 0; k < 3; k++) v[k] = c[k];
+    }
+  }
+  if (best == 0.0) return 0;
+  nrm = sqrt(best);
+  for (k = 0; k < 3; k++) v[k] /= nrm;
+  return 1;
+}
+
+/* Closed form; returns 0 when Jacobi has to be used instead */
+static int eigen_batch_3(const double *A, double *V, double *w)
+{
+  double p1, p2, p, q, r, phi, B[9], scale, va[3], vb[3], vm[3], d;
+  size_t i, j, first, second;
+  p1 = A[1]*A[1] + A[2]*A[2] + A[5]*A[5];
+  if (p1 == 0.0) return 0;
+  q = (A[0] + A[4] + A[8])/3.0;
+  p2 = (A[0] - q)*(A[0] - q) + (A[4] - q)*(A[4] - q) + (A[8] - q)*(A[8] - q) + 2.0*p1;
+  p = sqrt(p2/6.0);
+  for (i = 0; i < 9; i++) B[i] = (A[i] - (i % 4 == 0 ? q : 0.0))/p;
+  r = 0.5*(B[0]*(B[4]*B[8] - B[5]*B[7]) - B[1]*(B[3]*B[8] - B[5]*B[6])
+	   + B[2]*(B[3]*B[7] - B[4]*B[6]));
+  r = GSL_MAX(-1.0, GSL_MIN(1.0, r));
+  phi = acos(r)/3.0;
+  w[2] = q + 2.0*p*cos(phi);
+  w[0] = q + 2.0*p*cos(phi + 2.0*M_PI/3.0);
+  w[1] = 3.0*q - w[0] - w[2];
+  /* the eigenvector error is about eps |A|/gap */
+  scale = GSL_MAX(fabs(w[0]), fabs(w[2]));
+  if (GSL_MIN(w[1] - w[0], w[2] - w[1]) < 1e-3*scale) return 0;
+  if (w[2] - w[1] >= w[1] - w[0]) { first = 2; second = 0; }
+  else { first = 0; second = 2; }
+  if (!eigen_batch_null3(A, w[first], va) || !eigen_batch_null3(A, w[second], vb))
+    return 0;
+  d = va[0]*vb[0] + va[1]*vb[1] + va[2]*vb[2];
+  for (i = 0; i < 3; i++) vb[i] -= d*va[i];
+  d = sqrt(vb[0]*vb[0] + vb[1]*vb[1] + vb[2]*vb[2]);
+  for (i = 0; i < 3; i++) vb[i] /= d;
+  vm[0] = va[1]*vb[2] - va[2]*vb[1];
+  vm[1] = va[2]*vb[0] - va[0]*vb[2];
+  vm[2] = va[0]*vb[1] - va[1]*vb[0];
+  for (j = 0; j < 3; j++) {
+    V[j*3 + first] = va[j];
+    V[j*3 + 1] = vm[j];
+    V[j*3 + second] = vb[j];
+  }
+  return 1;
+}
+
+struct eigen_batch_task {
+  const double *a;      /* matrix k at a + k*n*tda */
+  size_t tda;
+  double *eval;         /* eigenvalues of k at eval + k*etda */
+  size_t etda;
+  double *evec;         /* eigenvectors of k at evec + k*n*vtda, or NULL */
+  size_t vtda;
+  size_t n, batch, nthreads;
+};
+
+static int eigen_batch_range(const struct eigen_batch_task *t, size_t k0, size_t k1)
+{
+  size_t n = t->n, i, j, k;
+  double Abuf[9], Vbuf[9], wbuf[3], *A = Abuf, *V = Vbuf, *w = wbuf, *out;
+  const double *a;
+  gsl_eigen_symmv_workspace *ws = NULL;
+  gsl_matrix_view Av, Vv;
+  gsl_vector_view wv;
+  if (n > 3) {
+    A = (double *) malloc(sizeof(double)*n*(2*n + 1));
+    if (A == NULL) GSL_ERROR("failed to allocate space for the matrices", GSL_ENOMEM);
+    V = A + n*n;
+    w = V + n*n;
+  }
+  if (n > EIGEN_BATCH_JACOBI_MAX) {
+    ws = gsl_eigen_symmv_alloc(n);
+    if (ws == NULL) {
+      free(A);
+      GSL_ERROR("failed to allocate the eigen workspace", GSL_ENOMEM);
+    }
+    Av = gsl_matrix_view_array(A, n, n);
+    Vv = gsl_matrix_view_array(V, n, n);
+    wv = gsl_vector_view_array(w, n);
+  }
+  for (k = k0; k < k1; k++) {
+    a = t->a + k*n*t->tda;
+    for (i = 0; i < n; i++)
+      for (j = 0; j <= i; j++) A[i*n + j] = A[j*n + i] = a[i*t->tda + j];
+    if (n == 1) {
+      w[0] = A[0]; V[0] = 1.0;
+    } else if (n == 2) {
+      eigen_batch_2(A, V, w);
+    } else if (n == 3) {
+      if (!eigen_batch_3(A, V, w)) eigen_batch_jacobi(A, V, w, 3);
+    } else if (ws == NULL) {
+      eigen_batch_jacobi(A, V, w, n);
+    } else {
+      gsl_eigen_symmv(&Av.matrix, &wv.vector, &Vv.matrix, ws);
+      gsl_eigen_symmv_sort(&wv.vector, &Vv.matrix, GSL_EIGEN_SORT_VAL_ASC);
+    }
+    out = t->eval + k*t->etda;
+    for (i = 0; i < n; i++) out[i] = w[i];
+    if (t->evec == NULL) continue;
+    out = t->evec + k*n*t->vtda;
+    for (i = 0; i < n; i++)
+      for (j = 0; j < n; j++) out[i*t->vtda + j] = V[i*n + j];
+  }
+  if (ws) gsl_eigen_symmv_free(ws);
+  if (n > 3) free(A);
+  return GSL_SUCCESS;
+}
+
+static int eigen_batch_worker(void *data, size_t k)
+{
+  struct eigen_batch_task *t = (struct eigen_batch_task *) data;
+  size_t k0 = t->batch*k/t->nthreads, k1 = t->batch*(k + 1)/t->nthreads;
+  return eigen_batch_range(t, k0, k1);
+}
+
+static int eigen_batch_serial(void *data)
+{
+  struct eigen_batch_task *t = (struct eigen_batch_task *) data;
+  return eigen_batch_range(t, 0, t->batch);
+}
+
+static gsl_matrix* eigen_batch_output(VALUE *v, size_t size1, size_t size2,
+				      const char *name)
+{
+  gsl_matrix *m;
+  if (NIL_P(*v)) {
+    m = gsl_matrix_alloc(size1, size2);
+    *v = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+    return m;
+  }
+  CHECK_MATRIX(*v);
+  Data_Get_Struct(*v, gsl_matrix, m);
+  if (m->size1 != size1 || m->size2 != size2)
+    rb_raise(rb_eArgError, "%s must be %d x %d", name, (int) size1, (int) size2);
+  return m;
+}
+
+static VALUE rb_gsl_eigen_batch0(int argc, VALUE *argv, int vectors)
+{
+  struct eigen_batch_task t;
+  gsl_matrix *A, *E, *V = NULL;
+  size_t n, batch, work;
+  VALUE keep, veval = Qnil, vevec = Qnil;
+  if (argc < 1 || argc > 2 + vectors)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 - %d)", argc, 2 + vectors);
+  A = rb_gsl_linalg_batch_systems(argv[0], &batch, &n, &keep);
+  if (argc > 1) veval = argv[1];
+  if (argc > 2) vevec = argv[2];
+  E = eigen_batch_output(&veval, batch, n, "eigenvalue matrix");
+  if (vectors) V = eigen_batch_output(&vevec, batch*n, n, "eigenvector matrix");
+  t.a = A->data;
+  t.tda = A->tda;
+  t.eval = E->data;
+  t.etda = E->tda;
+  t.evec = V ? V->data : NULL;
+  t.vtda = V ? V->tda : 0;
+  t.n = n;
+  t.batch = batch;
+  work = batch*n*n*n*(n > 3 ? 8 : 1);
+  t.nthreads = rb_gsl_parallel_nthreads(work, batch);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(eigen_batch_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(eigen_batch_serial, &t, work);
+  RB_GC_GUARD(keep);
+  if (!vectors) return veval;
+  return rb_ary_new3(2, veval, vevec);
+}
+
+static VALUE rb_gsl_eigen_batch_symm(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_eigen_batch0(argc, argv, 0);
+}
+
+static VALUE rb_gsl_eigen_batch_symmv(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_eigen_batch0(argc, argv, 1);
+}
+
+void Init_gsl_eigen_batch(VALUE module)
+{
+  VALUE mgsl_eigen_batch;
+  mgsl_eigen_batch = rb_define_module_under(module, "Batch");
+  rb_define_module_function(mgsl_eigen_batch, "symm", rb_gsl_eigen_batch_symm, -1);
+  rb_define_module_function(mgsl_eigen_batch, "symmv", rb_gsl_eigen_batch_symmv, -1);
+}
@@ -0,0 +1,324 @@
+/*
+  eigen_lanczos.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  A few eigenpairs of a large symmetric operator by restarted Lanczos.
+
+    eval, evec = GSL::Eigen.lanczos(a, 20, :which => :largest)
+
+  a is a symmetric GSL::Matrix, a GSL::SpMatrix, or anything responding
+  to call (op.call(x) returns A x, or op.call(x, y) stores it in y) with
+  the dimension given by :n or :v0.  The k wanted pairs are returned as
+  EigenValues and EigenVectors (in columns), like Eigen.symmv, sorted
+  by :which: :largest (algebraic, the default), :smallest or :magnitude.
+
+  The basis of :ncv vectors (max(2k + 1, 20) by default) is built with
+  full reorthogonalization (classical Gram-Schmidt twice, by dgemv) and
+  restarted thick, keeping (ncv + k)/2 Ritz vectors, which is the
+  implicitly restarted Lanczos method with exact shifts.  A pair has
+  converged when |A y - theta y| <= tol max(|theta|, eps^(2/3)).  Only
+  O(ncv n) memory is used besides the operator.  When the operator does
+  not call back into Ruby, the iteration runs with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include "rb_gsl_eigen.h"
+#include <gsl/gsl_blas.h>
+
+static VALUE cgsl_eigen_values, cgsl_eigen_vectors;
+
+enum {
+  LANCZOS_OP_MATRIX,
+  LANCZOS_OP_CSR,
+  LANCZOS_OP_CALL,
+};
+
+typedef struct {
+  size_t n, k, m, max_restarts;
+  double tol;
+  gsl_eigen_sort_t which;
+  int op_kind, op_arity;
+  VALUE op, vin, vout;
+  const gsl_matrix *A;
+  const mygsl_csr *csr;
+  const gsl_vector *v0;
+  gsl_matrix *V;        /* (m + 1) x n, rows are the basis */
+  gsl_matrix *T, *Tw;   /* m x m projection, and its copy for symmv */
+  gsl_matrix *Y;        /* m x m Ritz vectors of T */
+  gsl_matrix *tmp;      /* m x n, for the restart */
+  gsl_vector *theta, *h;
+  gsl_eigen_symmv_workspace *ws;
+  gsl_vector *eval;
+  gsl_matrix *evec;
+  unsigned long seed;
+  size_t restarts, nconv;
+} mygsl_lanczos;
+
+static void lanczos_apply(mygsl_lanczos *s, const gsl_vector *x, gsl_vector *y)
+{
+  switch (s->op_kind) {
+  case LANCZOS_OP_MATRIX:
+    gsl_blas_dsymv(CblasUpper, 1.0, s->A, x, 0.0, y);
+    break;
+  case LANCZOS_OP_CSR:
+    mygsl_csr_mul(s->csr, x, y);
+    break;
+  default:
+    rb_gsl_linalg_op_call(s->op, s->op_arity, s->vin, s->vout, x, y);
+  }
+}
+
+/* Deterministic start and breakdown vectors, uniform in [-1/2, 1/2) */
+static void lanczos_random(mygsl_lanczos *s, gsl_vector *v)
+{
+  size_t i;
+  for (i = 0; i < v->size; i++) {
+    s->seed ^= (s->seed << 13) & 0xffffffffUL;
+    s->seed ^= s->seed >> 17;
+    s->seed ^= (s->seed << 5) & 0xffffffffUL;
+    gsl_vector_set(v, i, s->seed/4294967296.0 - 0.5);
+  }
+}
+
+/* w -= V_j V_j^T w twice, with V_j rows 0 ... j of V; the coefficients
+   are accumulated into h */
+static void lanczos_orthogonalize(mygsl_lanczos *s, size_t j, gsl_vector *w,
+				  gsl_vector *h)
+{
+  gsl_matrix_view Vj = gsl_matrix_submatrix(s->V, 0, 0, j + 1, s->n);
+  gsl_vector_view hj = gsl_vector_subvector(s->h, 0, j + 1);
+  int pass;
+  if (h) gsl_vector_set_zero(h);
+  for (pass = 0; pass < 2; pass++) {
+    gsl_blas_dgemv(CblasNoTrans, 1.0, &Vj.matrix, w, 0.0, &hj.vector);
+    gsl_blas_dgemv(CblasTrans, -1.0, &Vj.matrix, &hj.vector, 1.0, w);
+    if (h) gsl_vector_add(h, &hj.vector);
+  }
+}
+
+/* Extends the basis from l to m vectors; returns the norm of the
+   residual, which is row m of V once normalized */
+static double lanczos_extend(mygsl_lanczos *s, size_t l, double *tnorm)
+{
+  gsl_vector_view vj, w, hj;
+  size_t i, j;
+  double beta = 0.0, t;
+  for (j = l; j < s->m; j++) {
+    vj = gsl_matrix_row(s->V, j);
+    w = gsl_matrix_row(s->V, j + 1);
+    lanczos_apply(s, &vj.vector, &w.vector);
+    hj = gsl_vector_subvector(s->theta, 0, j + 1);  /* theta is free here */
+    lanczos_orthogonalize(s, j, &w.vector, &hj.vector);
+    for (i = 0; i <= j; i++) {
+      t = gsl_vector_get(&hj.vector, i);
+      gsl_matrix_set(s->T, i, j, t);
+      gsl_matrix_set(s->T, j, i, t);
+    }
+    beta = gsl_blas_dnrm2(&w.vector);
+    *tnorm = GSL_MAX(*tnorm, fabs(gsl_matrix_get(s->T, j, j)) + beta);
+    if (beta <= GSL_DBL_EPSILON*(*tnorm)) {
+      /* an invariant subspace: carry on from a new direction */
+      beta = 0.0;
+      if (j + 1 == s->m) break;
+      lanczos_random(s, &w.vector);
+      lanczos_orthogonalize(s, j, &w.vector, NULL);
+      gsl_vector_scale(&w.vector, 1.0/gsl_blas_dnrm2(&w.vector));
+    } else {
+      gsl_vector_scale(&w.vector, 1.0/beta);
+    }
+  }
+  return beta;
+}
+
+static int lanczos_run(void *data)
+{
+  mygsl_lanczos *s = (mygsl_lanczos *) data;
+  size_t m = s->m, k = s->k, l = 0, i;
+  double beta, tnorm = 0.0, eps23 = pow(GSL_DBL_EPSILON, 2.0/3.0), r, t;
+  gsl_vector_view v;
+  gsl_matrix_view Yl, Vm, Tl, Yk;
+  v = gsl_matrix_row(s->V, 0);
+  if (s->v0) gsl_vector_memcpy(&v.vector, s->v0);
+  else lanczos_random(s, &v.vector);
+  t = gsl_blas_dnrm2(&v.vector);
+  if (t == 0.0) GSL_ERROR("start vector must not be zero", GSL_EINVAL);
+  gsl_vector_scale(&v.vector, 1.0/t);
+  gsl_matrix_set_zero(s->T);
+  for (s->restarts = 0; ; s->restarts++) {
+    beta = lanczos_extend(s, l, &tnorm);
+    gsl_matrix_memcpy(s->Tw, s->T);
+    gsl_eigen_symmv(s->Tw, s->theta, s->Y, s->ws);
+    gsl_eigen_symmv_sort(s->theta, s->Y, s->which);
+    s->nconv = 0;
+    for (i = 0; i < k; i++) {
+      t = gsl_vector_get(s->theta, i);
+      r = fabs(beta*gsl_matrix_get(s->Y, m - 1, i));
+      if (r <= s->tol*GSL_MAX(fabs(t), eps23)) s->nconv++;
+    }
+    if (s->nconv == k || s->restarts == s->max_restarts) break;
+    /* thick restart: V_l = Y_l^T V_m, then the residual */
+    l = (m + k)/2;
+    Yl = gsl_matrix_submatrix(s->Y, 0, 0, m, l);
+    Vm = gsl_matrix_submatrix(s->V, 0, 0, m, s->n);
+    Tl = gsl_matrix_submatrix(s->tmp, 0, 0, l, s->n);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, &Yl.matrix, &Vm.matrix,
+		   0.0, &Tl.matrix);
+    for (i = 0; i < l; i++) {
+      gsl_vector_view src = gsl_matrix_row(s->tmp, i), dst = gsl_matrix_row(s->V, i);
+      gsl_vector_memcpy(&dst.vector, &src.vector);
+    }
+    {
+      gsl_vector_view src = gsl_matrix_row(s->V, m), dst = gsl_matrix_row(s->V, l);
+      gsl_vector_memcpy(&dst.vector, &src.vector);
+    }
+    gsl_matrix_set_zero(s->T);
+    for (i = 0; i < l; i++) gsl_matrix_set(s->T, i, i, gsl_vector_get(s->theta, i));
+  }
+  for (i = 0; i < k; i++) gsl_vector_set(s->eval, i, gsl_vector_get(s->theta, i));
+  Yk = gsl_matrix_submatrix(s->Y, 0, 0, m, k);
+  Vm = gsl_matrix_submatrix(s->V, 0, 0, m, s->n);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, &Vm.matrix, &Yk.matrix,
+		 0.0, s->evec);
+  if (s->nconv < k) GSL_ERROR("Lanczos iteration did not converge", GSL_EMAXITER);
+  return GSL_SUCCESS;
+}
+
+/* Workspace owned by the GC, so that nothing leaks when a raise
+   interrupts the solve */
+static gsl_matrix* lanczos_matrix(size_t n1, size_t n2, VALUE keep)
+{
+  gsl_matrix *m = gsl_matrix_calloc(n1, n2);
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m));
+  return m;
+}
+
+static gsl_vector* lanczos_vector(size_t n, VALUE keep)
+{
+  gsl_vector *v = gsl_vector_calloc(n);
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v));
+  return v;
+}
+
+static void lanczos_set_operator(mygsl_lanczos *s, VALUE va, VALUE keep)
+{
+  if (MATRIX_P(va)) {
+    Data_Get_Struct(va, gsl_matrix, s->A);
+    if (s->A->size1 != s->A->size2) rb_raise(rb_eArgError, "matrix must be square");
+    s->op_kind = LANCZOS_OP_MATRIX;
+    s->n = s->A->size1;
+    return;
+  }
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  if (rb_gsl_spmatrix_p(va)) {
+    gsl_spmatrix *m = rb_gsl_get_spmatrix(va);
+    mygsl_csr *c;
+    if (m->size1 != m->size2) rb_raise(rb_eArgError, "matrix must be square");
+    c = mygsl_csr_from_spmatrix(m);
+    if (c == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, mygsl_csr_free, c));
+    s->csr = c;
+    s->op_kind = LANCZOS_OP_CSR;
+    s->n = m->size1;
+    return;
+  }
+#endif
+  if (!rb_respond_to(va, rb_intern("call")))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix, GSL::SpMatrix"
+	     " or a callable expected)", rb_class2name(CLASS_OF(va)));
+  s->op = va;
+  s->op_kind = LANCZOS_OP_CALL;
+  s->op_arity = rb_gsl_linalg_op_arity(va);
+  s->n = 0;
+}
+
+/* GSL::Eigen.lanczos(a, k, opts = {}): see the top of the file */
+static VALUE rb_gsl_eigen_lanczos(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_lanczos s;
+  VALUE opts = Qnil, v, keep = rb_ary_new(), vval, vvec;
+  gsl_vector *v0 = NULL;
+  size_t ncv = 0;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  memset(&s, 0, sizeof(s));
+  s.op = s.vin = s.vout = Qnil;
+  s.tol = 1e-10;
+  s.max_restarts = 1000;
+  s.which = GSL_EIGEN_SORT_VAL_DESC;
+  s.seed = 2463534242UL;
+  lanczos_set_operator(&s, argv[0], keep);
+  CHECK_FIXNUM(argv[1]);
+  s.k = FIX2INT(argv[1]);
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("tol"))))) s.tol = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_restarts")))))
+      s.max_restarts = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("ncv"))))) ncv = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("which"))))) {
+      if (v == ID2SYM(rb_intern("largest"))) s.which = GSL_EIGEN_SORT_VAL_DESC;
+      else if (v == ID2SYM(rb_intern("smallest"))) s.which = GSL_EIGEN_SORT_VAL_ASC;
+      else if (v == ID2SYM(rb_intern("magnitude"))) s.which = GSL_EIGEN_SORT_ABS_DESC;
+      else rb_raise(rb_eArgError, ":which must be :largest, :smallest or :magnitude");
+    }
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("v0"))))) {
+      CHECK_VECTOR(v);
+      Data_Get_Struct(v, gsl_vector, v0);
+      if (s.n && v0->size != s.n)
+	rb_raise(rb_eArgError, ":v0 must have %d elements", (int) s.n);
+      s.n = v0->size;
+      s.v0 = v0;
+      rb_ary_push(keep, v);
+    }
+    if (s.n == 0 && !NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("n")))))
+      s.n = NUM2SIZET(v);
+  }
+  if (s.n == 0) rb_raise(rb_eArgError, "the dimension of a callable operator needs :n or :v0");
+  if (s.k == 0 || s.k >= s.n)
+    rb_raise(rb_eArgError, "k must be in 1 ... %d (Eigen.symmv computes them all)",
+	     (int) s.n - 1);
+  if (ncv == 0) ncv = GSL_MAX(2*s.k + 1, 20);
+  s.m = GSL_MIN(GSL_MAX(ncv, s.k + 1), s.n);
+  s.V = lanczos_matrix(s.m + 1, s.n, keep);
+  s.T = lanczos_matrix(s.m, s.m, keep);
+  s.Tw = lanczos_matrix(s.m, s.m, keep);
+  s.Y = lanczos_matrix(s.m, s.m, keep);
+  s.tmp = lanczos_matrix(s.m, s.n, keep);
+  s.theta = lanczos_vector(s.m, keep);
+  s.h = lanczos_vector(s.m, keep);
+  s.ws = gsl_eigen_symmv_alloc(s.m);
+  rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, gsl_eigen_symmv_free, s.ws));
+  s.eval = gsl_vector_alloc(s.k);
+  vval = Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, s.eval);
+  s.evec = gsl_matrix_alloc(s.n, s.k);
+  vvec = Data_Wrap_Struct(cgsl_eigen_vectors, 0, gsl_matrix_free, s.evec);
+  if (s.op_kind == LANCZOS_OP_CALL) {
+    s.vin = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_calloc(s.n));
+    s.vout = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_calloc(s.n));
+    rb_ary_push(keep, s.vin);
+    rb_ary_push(keep, s.vout);
+    lanczos_run(&s);
+  } else {
+    rb_gsl_nogvl_call(lanczos_run, &s, s.m*s.n*(s.m + 1));
+  }
+  RB_GC_GUARD(keep);
+  return rb_ary_new3(2, vval, vvec);
+}
+
+void Init_gsl_eigen_lanczos(VALUE module)
+{
+  cgsl_eigen_values = rb_const_get(module, rb_intern("EigenValues"));
+  cgsl_eigen_vectors = rb_const_get(module, rb_intern("EigenVectors"));
+  rb_define_module_function(module, "lanczos", rb_gsl_eigen_lanczos, -1);
+}
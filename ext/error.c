@@ -13,54 +13,321 @@
 #include "rb_gsl_array.h"
 #include "rb_gsl_common.h"
 #include "rb_gsl_function.h"
+#ifdef HAVE_RUBY_THREAD_H
+#include "ruby/thread.h"
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+#include "ruby/ractor.h"
+#endif
 
-static VALUE eHandler;
 static VALUE cgsl_error[35];
 static VALUE *pgsl_error;
 
 static void Init_rb_gsl_define_GSL_CONST(VALUE module);
 void rb_gsl_error_handler(const char *reason, const char *file,
 			  int line, int gsl_errno);
-static void rb_gsl_my_error_handler(const char *reason, const char *file,
-				    int line, int gsl_errno);
+static void rb_gsl_ruby_error_handler(const char *reason, const char *file,
+				      int line, int gsl_errno);
+
+/*
+  GVL-free execution of numeric kernels.
+
+  While the GVL is released no Ruby API may be called, so the error
+  handlers must not raise. Errors reported by GSL in that state are kept
+  (per thread) and signalled again through gsl_error() once the lock has
+  been reacquired.  rb_gsl_error_defer_begin() and _end() do the same
+  around a kernel run with the GVL, so that the exception leaves only
+  once the kernel has returned and its workspaces are freed.
+*/
+size_t rb_gsl_nogvl_threshold = 4096;
+
+struct rb_gsl_nogvl_error {
+  int active;                   /* errors are recorded, not raised */
+  int nogvl;                    /* the thread runs without the GVL */
+  int gsl_errno;
+  int line;
+  char reason[256];
+  char file[256];
+};
+
+static RB_GSL_THREAD_LOCAL struct rb_gsl_nogvl_error nogvl_error;
+
+/*
+  GSL.error_mode = :status: the errors of the thread are recorded in
+  status_error (the first one until GSL.clear_error) instead of raised,
+  and the methods return what the GSL function returned, its status
+  included.
+*/
+static RB_GSL_THREAD_LOCAL struct rb_gsl_nogvl_error status_error;
+
+static void rb_gsl_error_record(struct rb_gsl_nogvl_error *e, const char *reason,
+				const char *file, int line, int gsl_errno)
+{
+  if (e->gsl_errno != GSL_SUCCESS) return;
+  e->gsl_errno = gsl_errno;
+  e->line = line;
+  strncpy(e->reason, reason ? reason : "", sizeof(e->reason)-1);
+  strncpy(e->file, file ? file : "", sizeof(e->file)-1);
+}
+
+static int rb_gsl_error_defer(const char *reason, const char *file,
+			      int line, int gsl_errno)
+{
+  if (nogvl_error.active) {
+    rb_gsl_error_record(&nogvl_error, reason, file, line, gsl_errno);
+    return 1;
+  }
+  if (status_error.active) {
+    rb_gsl_error_record(&status_error, reason, file, line, gsl_errno);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+  Until rb_gsl_error_defer_end(), the GSL errors of this thread are kept
+  instead of raised; returns the token to give to rb_gsl_error_defer_end
+*/
+int rb_gsl_error_defer_begin(void)
+{
+  if (nogvl_error.active) return 0;
+  nogvl_error.active = 1;
+  nogvl_error.gsl_errno = GSL_SUCCESS;
+  return 1;
+}
+
+/* Signals again the first error kept since rb_gsl_error_defer_begin() */
+void rb_gsl_error_defer_end(int token)
+{
+  if (token == 0) return;
+  nogvl_error.active = 0;
+  if (nogvl_error.gsl_errno != GSL_SUCCESS)
+    gsl_error(nogvl_error.reason, nogvl_error.file, nogvl_error.line,
+	      nogvl_error.gsl_errno);
+}
+
+/*
+  Returns and clears the GSL error deferred so far on this thread, for
+  functions run by rb_gsl_nogvl_call() or rb_gsl_nogvl_parallel() which
+  report the errors of their parts themselves
+*/
+int rb_gsl_error_take(void)
+{
+  int gsl_errno = nogvl_error.gsl_errno;
+  nogvl_error.gsl_errno = GSL_SUCCESS;
+  return nogvl_error.active ? gsl_errno : GSL_SUCCESS;
+}
+
+struct rb_gsl_nogvl_arg {
+  int (*func)(void *);
+  void *data;
+  int status;
+};
+
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+static void* rb_gsl_nogvl_body(void *p)
+{
+  struct rb_gsl_nogvl_arg *a = (struct rb_gsl_nogvl_arg *) p;
+  a->status = (*a->func)(a->data);
+  return NULL;
+}
+#endif
+
+/* Call func(data), releasing the GVL when work (number of elements
+   involved) is at least GSL.nogvl_threshold. func must not touch
+   any Ruby object. Returns the value returned by func. */
+int rb_gsl_nogvl_call(int (*func)(void *), void *data, size_t work)
+{
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+  struct rb_gsl_nogvl_arg a;
+  int token;
+  if (rb_gsl_nogvl_threshold > 0 && work >= rb_gsl_nogvl_threshold 
+      && nogvl_error.nogvl == 0) {
+    a.func = func;
+    a.data = data;
+    a.status = GSL_SUCCESS;
+    token = rb_gsl_error_defer_begin();
+    nogvl_error.nogvl = 1;
+    rb_thread_call_without_gvl(rb_gsl_nogvl_body, &a, NULL, NULL);
+    nogvl_error.nogvl = 0;
+    rb_gsl_error_defer_end(token);
+    return a.status;
+  }
+#endif
+  return (*func)(data);
+}
+
+struct rb_gsl_parallel_arg {
+  int (*func)(void *, size_t);
+  void *data;
+  size_t i;
+  int status;
+  struct rb_gsl_nogvl_error err;
+};
+
+struct rb_gsl_parallel_run {
+  struct rb_gsl_parallel_arg *args;
+  size_t n;
+};
+
+static void* rb_gsl_parallel_worker(void *p)
+{
+  struct rb_gsl_parallel_arg *a = (struct rb_gsl_parallel_arg *) p;
+  struct rb_gsl_nogvl_error saved;
+  saved = nogvl_error;
+  nogvl_error.active = 1;
+  nogvl_error.nogvl = 1;
+  nogvl_error.gsl_errno = GSL_SUCCESS;
+  a->status = (*a->func)(a->data, a->i);
+  a->err = nogvl_error;
+  nogvl_error = saved;
+  return NULL;
+}
+
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL) && defined(HAVE_PTHREAD_H)
+static void rb_gsl_parallel_part(void *p, size_t i)
+{
+  struct rb_gsl_parallel_run *run = (struct rb_gsl_parallel_run *) p;
+  rb_gsl_parallel_worker(&run->args[i]);
+}
+
+static void* rb_gsl_parallel_body(void *p)
+{
+  struct rb_gsl_parallel_run *run = (struct rb_gsl_parallel_run *) p;
+  rb_gsl_thread_pool_run(rb_gsl_parallel_part, run, run->n);
+  return NULL;
+}
+#endif
+
+/*
+  Calls func(data, i) for i = 0 ... n-1 on the threads of GSL::ThreadPool
+  (thread_pool.c) with the GVL released (sequentially if threads are not
+  available). func must not touch Ruby objects. GSL errors raised by any
+  of the calls are re-signalled once all of them have returned. Returns
+  the first non-zero status.
+*/
+int rb_gsl_nogvl_parallel(int (*func)(void *, size_t), void *data, size_t n)
+{
+  struct rb_gsl_parallel_run run;
+  struct rb_gsl_nogvl_error err;
+  size_t i;
+  int status = GSL_SUCCESS;
+  if (n == 0) return GSL_SUCCESS;
+  run.n = n;
+  run.args = ALLOC_N(struct rb_gsl_parallel_arg, n);
+  for (i = 0; i < n; i++) {
+    run.args[i].func = func;
+    run.args[i].data = data;
+    run.args[i].i = i;
+    run.args[i].status = GSL_SUCCESS;
+  }
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL) && defined(HAVE_PTHREAD_H)
+  if (nogvl_error.nogvl == 0 && n > 1) 
+    rb_thread_call_without_gvl(rb_gsl_parallel_body, &run, NULL, NULL);
+  else
+#endif
+  for (i = 0; i < n; i++) rb_gsl_parallel_worker(&run.args[i]);
+  err.gsl_errno = GSL_SUCCESS;
+  for (i = 0; i < n; i++) {
+    if (status == GSL_SUCCESS) status = run.args[i].status;
+    if (err.gsl_errno == GSL_SUCCESS) err = run.args[i].err;
+  }
+  xfree(run.args);
+  if (err.gsl_errno != GSL_SUCCESS)
+    gsl_error(err.reason, err.file, err.line, err.gsl_errno);
+  return status;
+}
+
+static VALUE rb_gsl_nogvl_threshold_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_nogvl_threshold);
+}
+
+static VALUE rb_gsl_nogvl_threshold_set(VALUE module, VALUE n)
+{
+  rb_gsl_nogvl_threshold = NUM2SIZET(n);
+  return n;
+}
 
 void rb_gsl_error_handler(const char *reason, const char *file,
 			  int line, int gsl_errno)
 {
-  const char *emessage = gsl_strerror(gsl_errno);
+  const char *emessage;
+  if (rb_gsl_error_defer(reason, file, line, gsl_errno)) return;
+  emessage = gsl_strerror(gsl_errno);
   rb_raise(pgsl_error[gsl_errno], 
 	   "Ruby/GSL error code %d, %s (file %s, line %d), %s",
 	   gsl_errno, reason, file, line, emessage);
 }
 
-static void rb_gsl_my_error_handler(const char *reason, const char *file,
-				    int line, int gsl_errno)
+/*
+  The handler set from Ruby is kept per Ractor, so that set_error_handler,
+  set_default_error_handler and set_error_handler_off in one Ractor leave
+  the others alone: the handler installed in GSL is always
+  rb_gsl_ruby_error_handler, which looks up the one of the calling
+  Ractor, nil to raise (the default), false when off, or a Proc.
+*/
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+static rb_ractor_local_key_t error_handler_key;
+
+static VALUE rb_gsl_error_handler_get(void)
+{
+  VALUE h;
+  if (!rb_ractor_local_storage_value_lookup(error_handler_key, &h)) return Qnil;
+  return h;
+}
+
+static void rb_gsl_error_handler_put(VALUE h)
+{
+  rb_ractor_local_storage_value_set(error_handler_key, h);
+}
+#else
+static VALUE eHandler = Qnil;
+
+static VALUE rb_gsl_error_handler_get(void)
+{
+  return eHandler;
+}
+
+static void rb_gsl_error_handler_put(VALUE h)
+{
+  eHandler = h;
+}
+#endif
+
+static void rb_gsl_ruby_error_handler(const char *reason, const char *file,
+				      int line, int gsl_errno)
 {
-  VALUE vreason, vfile;
+  VALUE h, vreason, vfile;
   VALUE vline, verrno;
+  if (rb_gsl_error_defer(reason, file, line, gsl_errno)) return;
+  h = rb_gsl_error_handler_get();
+  if (h == Qfalse) return;
+  if (NIL_P(h)) rb_gsl_error_handler(reason, file, line, gsl_errno);
   vreason = rb_str_new2(reason);
   vfile = rb_str_new2(file);
   vline = INT2FIX(line);
   verrno = INT2FIX(gsl_errno);
-  rb_funcall(eHandler, RBGSL_ID_call, 4, vreason, vfile, vline, verrno);
+  rb_funcall(h, RBGSL_ID_call, 4, vreason, vfile, vline, verrno);
 }
 
 static VALUE rb_gsl_set_error_handler(int argc, VALUE *argv, VALUE module)
 {
   if (rb_block_given_p()) {
-    eHandler = RB_GSL_MAKE_PROC;
-    gsl_set_error_handler(&rb_gsl_my_error_handler);
+    rb_gsl_error_handler_put(RB_GSL_MAKE_PROC);
     return Qtrue;
   }
   switch (argc) {
   case 0:
-    gsl_set_error_handler(&rb_gsl_error_handler);
+    rb_gsl_error_handler_put(Qnil);
     return Qtrue;
     break;
   case 1:
     CHECK_PROC(argv[0]);
-    eHandler = argv[0];
-    gsl_set_error_handler(&rb_gsl_my_error_handler);
+    rb_gsl_error_handler_put(argv[0]);
     return Qtrue;
     break;
   default:
@@ -71,7 +338,7 @@ static VALUE rb_gsl_set_error_handler(int argc, VALUE *argv, VALUE module)
 
 static VALUE rb_gsl_set_default_error_handler(VALUE module)
 {
-  gsl_set_error_handler(&rb_gsl_error_handler);
+  rb_gsl_error_handler_put(Qnil);
   return Qtrue;
 }
 
@@ -158,10 +425,79 @@ static void Init_rb_gsl_define_GSL_CONST(VALUE module)
 
 static VALUE rb_gsl_set_error_handler_off(VALUE module)
 {
-  gsl_set_error_handler_off();
+  rb_gsl_error_handler_put(Qfalse);
   return Qtrue;
 }
 
+static VALUE rb_gsl_error_mode(VALUE module)
+{
+  return ID2SYM(rb_intern(status_error.active ? "status" : "raise"));
+}
+
+/* GSL.error_mode = :raise (the default) or :status, for this thread */
+static VALUE rb_gsl_set_error_mode(VALUE module, VALUE mode)
+{
+  if (mode == ID2SYM(rb_intern("status"))) status_error.active = 1;
+  else if (mode == ID2SYM(rb_intern("raise"))) status_error.active = 0;
+  else rb_raise(rb_eArgError, "wrong error mode (:raise or :status expected)");
+  return mode;
+}
+
+static VALUE rb_gsl_error_status(VALUE module)
+{
+  return INT2FIX(status_error.gsl_errno);
+}
+
+/* The exception the recorded error would have raised, not raised */
+static VALUE rb_gsl_last_error(VALUE module)
+{
+  int gsl_errno = status_error.gsl_errno;
+  VALUE klass;
+  if (gsl_errno == GSL_SUCCESS) return Qnil;
+  klass = (gsl_errno >= 1 && gsl_errno <= 32) ? pgsl_error[gsl_errno] : pgsl_error[-1];
+  return rb_exc_new_str(klass,
+     rb_sprintf("Ruby/GSL error code %d, %s (file %s, line %d), %s",
+		gsl_errno, status_error.reason, status_error.file,
+		status_error.line, gsl_strerror(gsl_errno)));
+}
+
+static VALUE rb_gsl_clear_error(VALUE module)
+{
+  int gsl_errno = status_error.gsl_errno;
+  status_error.gsl_errno = GSL_SUCCESS;
+  return INT2FIX(gsl_errno);
+}
+
+struct rb_gsl_error_status_frame {
+  struct rb_gsl_nogvl_error saved;
+  int gsl_errno;
+};
+
+static VALUE rb_gsl_error_status_restore(VALUE data)
+{
+  struct rb_gsl_error_status_frame *f = (struct rb_gsl_error_status_frame *) data;
+  f->gsl_errno = status_error.gsl_errno;
+  status_error = f->saved;
+  return Qnil;
+}
+
+/*
+  GSL.with_error_status { ... } => [value of the block, status]: runs the
+  block in status mode, and restores the mode and error of the caller
+*/
+static VALUE rb_gsl_with_error_status(VALUE module)
+{
+  struct rb_gsl_error_status_frame f;
+  VALUE result;
+  rb_need_block();
+  f.saved = status_error;
+  f.gsl_errno = GSL_SUCCESS;
+  status_error.active = 1;
+  status_error.gsl_errno = GSL_SUCCESS;
+  result = rb_ensure(rb_yield, Qnil, rb_gsl_error_status_restore, (VALUE) &f);
+  return rb_assoc_new(result, INT2FIX(f.gsl_errno));
+}
+
 static void define_module_functions(VALUE module);
 static VALUE rb_gsl_strerror(VALUE obj, VALUE errn);
 static void define_module_functions(VALUE module)
@@ -174,6 +510,16 @@ static void define_module_functions(VALUE module)
 			    rb_gsl_set_error_handler, -1);
   rb_define_module_function(module, "set_default_error_handler",
 			    rb_gsl_set_default_error_handler, 0);
+  rb_define_singleton_method(module, "nogvl_threshold",
+			     rb_gsl_nogvl_threshold_get, 0);
+  rb_define_singleton_method(module, "nogvl_threshold=",
+			     rb_gsl_nogvl_threshold_set, 1);
+  rb_define_module_function(module, "error_mode", rb_gsl_error_mode, 0);
+  rb_define_module_function(module, "error_mode=", rb_gsl_set_error_mode, 1);
+  rb_define_module_function(module, "error_status", rb_gsl_error_status, 0);
+  rb_define_module_function(module, "last_error", rb_gsl_last_error, 0);
+  rb_define_module_function(module, "clear_error", rb_gsl_clear_error, 0);
+  rb_define_module_function(module, "with_error_status", rb_gsl_with_error_status, 0);
 }
 
 static VALUE rb_gsl_strerror(VALUE obj, VALUE errn)
@@ -186,7 +532,12 @@ void Init_gsl_error(VALUE module)
 {
   Init_rb_gsl_define_GSL_CONST(module);
 
-  gsl_set_error_handler(&rb_gsl_error_handler);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  error_handler_key = rb_ractor_local_storage_value_newkey();
+#else
+  rb_global_variable(&eHandler);
+#endif
+  gsl_set_error_handler(&rb_gsl_ruby_error_handler);
 
   define_module_functions(module);
   rb_gsl_define_exceptions(module);
@@ -46,20 +46,64 @@ def gsl_config()
   
   IO.popen("#{GSL_CONFIG} --libs") do |f|
     libs = f.gets.chomp
-    dir_config("cblas")
-    dir_config("atlas")
-    if have_library("cblas") and have_library("atlas")
-      libs.gsub!("-lgslcblas", "-lcblas -latlas")
-      $LOCAL_LIBS += " " + libs.gsub(" -lgslcblas", "")
-      print("checking gsl libs... ")
-      puts(libs)
+    backend, libs = blas_backend(libs)
+    print("checking gsl libs... ")
+    puts(libs)
+    $LOCAL_LIBS += " " + libs
+    blas_thread_funcs(backend)
+  end
+
+end
+
+# CBLAS used in place of GSL's reference -lgslcblas:
+#   --with-blas=openblas|mkl|blis|atlas|gslcblas
+# By default the first of openblas, mkl, blis, atlas found is used.
+# Returns the backend name and the gsl-config libs without -lgslcblas
+# when another CBLAS was linked (have_library already added it).
+def blas_backend(libs)
+  choice = with_config("blas")
+  candidates = choice ? [choice] : %w(openblas mkl blis atlas)
+  candidates.each do |name|
+    case name
+    when "gslcblas"
+      return [name, libs]
+    when "openblas"
+      dir_config("openblas")
+      next unless have_library("openblas", "cblas_dgemm")
+    when "mkl"
+      dir_config("mkl")
+      next unless have_library("mkl_rt", "cblas_dgemm")
+    when "blis"
+      dir_config("blis")
+      next unless have_library("blis", "cblas_dgemm")
+    when "atlas"
+      dir_config("cblas")
+      dir_config("atlas")
+      next unless have_library("cblas") and have_library("atlas")
     else
-      print("checking gsl libs... ")
-      puts(libs)
-      $LOCAL_LIBS += " " + libs
+      raise("unknown BLAS backend \"#{name}\" (openblas, mkl, blis, atlas or gslcblas)")
     end
+    return [name, libs.gsub(/\s*-lgslcblas/, "")]
   end
+  raise("BLAS backend \"#{choice}\" was not found") if choice
+  ["gslcblas", libs]
+end
 
+# GSL::Blas.backend and GSL::Blas.num_threads (ext/blas.c)
+def blas_thread_funcs(backend)
+  $defs.push("-DRB_GSL_BLAS_#{backend.upcase}")
+  case backend
+  when "openblas"
+    have_func("openblas_set_num_threads")
+    have_func("openblas_get_num_threads")
+  when "mkl"
+    have_func("MKL_Set_Num_Threads")
+    have_func("MKL_Get_Max_Threads")
+    have_func("cblas_dgemm_batch_strided")
+  when "blis"
+    have_func("bli_thread_set_num_threads")
+    have_func("bli_thread_get_num_threads")
+  end
 end
 
 def check_version(configfile)
@@ -151,6 +195,96 @@ begin
 
   have_func("round")
 
+# Sparse matrices (GSL >= 2.0); compressed rows from GSL 2.2
+  if have_header("gsl/gsl_spmatrix.h")
+    have_header("gsl/gsl_splinalg.h")
+    have_func("gsl_spmatrix_crs", "gsl/gsl_spmatrix.h") or
+      have_func("gsl_spmatrix_comprow", "gsl/gsl_spmatrix.h")
+  end
+
+# Two-dimensional interpolation (GSL >= 2.1)
+  have_header("gsl/gsl_interp2d.h")
+
+# Driver and implicit steppers for ODEs (GSL >= 1.15)
+  have_header("gsl/gsl_odeiv2.h")
+
+# Trust region nonlinear least squares (GSL >= 2.2)
+  if have_header("gsl/gsl_multifit_nlinear.h")
+    have_header("gsl/gsl_multilarge_nlinear.h")
+  end
+
+# GVL-free execution of numeric kernels
+  if have_header("ruby/thread.h")
+    have_func("rb_thread_call_without_gvl", "ruby/thread.h")
+  end
+  if have_header("pthread.h")
+    have_func("pthread_setaffinity_np", "pthread.h")
+  end
+
+# Ractor-shareable GSL::Spline
+  have_func("rb_ext_ractor_safe", "ruby.h")
+
+# GSL::Vec3, GSL::Mat3, ... stored in the object slot
+  have_const("RUBY_TYPED_EMBEDDABLE", "ruby.h")
+
+# Native memory of vectors and matrices reported to the GC (GSL.memory_usage)
+  have_func("rb_gc_adjust_memory_usage", "ruby.h")
+  have_header("ruby/atomic.h")
+
+# AVX2 and generic builds of the GSL.vmath = :fast kernels, chosen at load time
+  if checking_for("target_clones attribute") {
+      try_link("__attribute__((target_clones(\"avx2\", \"default\"))) int f(int x) { return x + 1; }\nint main(void) { return f(0); }\n")
+    }
+    RB_GSL_CONFIG.printf("#ifndef HAVE_ATTRIBUTE_TARGET_CLONES\n#define HAVE_ATTRIBUTE_TARGET_CLONES\n#endif\n")
+  end
+
+# GSL 2 dropped the workspace of gsl_bspline_deriv_eval_nonzero
+  if checking_for("gsl_bspline_deriv_eval_nonzero without a workspace") {
+      try_link("#include <gsl/gsl_bspline.h>\nint main(void) { size_t i, j; gsl_bspline_workspace *w = gsl_bspline_alloc(4, 10); gsl_matrix *d = gsl_matrix_alloc(4, 2); gsl_bspline_knots_uniform(0.0, 1.0, w); return gsl_bspline_deriv_eval_nonzero(0.5, 1, d, &i, &j, w); }\n")
+    }
+    RB_GSL_CONFIG.printf("#ifndef HAVE_GSL_BSPLINE_DERIV_NOWS\n#define HAVE_GSL_BSPLINE_DERIV_NOWS\n#endif\n")
+  end
+
+# FMA build of the complex kernels under GSL.vmath = :fast
+  if checking_for("target(\"avx2,fma\") attribute") {
+      try_link("__attribute__((target(\"avx2,fma\"))) double f(double x) { return x*x + 1.0; }\nint main(void) { __builtin_cpu_init(); return __builtin_cpu_supports(\"fma\") ? (int) f(0.0) : 0; }\n")
+    }
+    RB_GSL_CONFIG.printf("#ifndef HAVE_ATTRIBUTE_TARGET_FMA\n#define HAVE_ATTRIBUTE_TARGET_FMA\n#endif\n")
+  end
+
+# GSL::Profiler
+  if enable_config("profile", false)
+    RB_GSL_CONFIG.printf("#ifndef RB_GSL_PROFILE\n#define RB_GSL_PROFILE\n#endif\n")
+  end
+
+# USDT probes (rb_gsl_probes.h)
+  if enable_config("probes", true)
+    have_header("sys/sdt.h")
+  end
+
+# GSL::Vector.mmap, GSL::Matrix.mmap
+  have_header("sys/mman.h")
+
+# 64-byte aligned vector and matrix data (GSL::Memory.align)
+  have_func("posix_memalign", "stdlib.h")
+
+# LAPACK engine of GSL::Linalg and GSL::Eigen (ext/linalg_lapack.c): the
+# LAPACK of the BLAS backend, else -llapack
+  if enable_config("lapack", true)
+    if have_func("dgetrf_") or have_library("lapack", "dgetrf_")
+      RB_GSL_CONFIG.printf("#ifndef HAVE_LAPACK\n#define HAVE_LAPACK\n#endif\n")
+    end
+  end
+
+# Vector#to_io_buffer
+  have_header("ruby/io/buffer.h")
+
+# fwrite(io, :compress => :zstd or :lz4) (ext/compress.c)
+  if enable_config("compress", true)
+    have_library("zstd", "ZSTD_compress") if have_header("zstd.h")
+    have_library("lz4", "LZ4_compress_fast") if have_header("lz4.h")
+  end
+
 # Check GSL extensions
 
   if have_header("rngextra/rngextra.h")
@@ -169,6 +303,13 @@ begin
     have_library("tensor")
   end
 
+# GSL::HDF5; distributions that keep hdf5.h in a subdirectory ship hdf5.pc
+  dir_config("hdf5")
+  pkg_config("hdf5")
+  if have_header("hdf5.h")
+    have_library("hdf5", "H5open") unless have_func("H5open", "hdf5.h")
+  end
+
   if have_header("jacobi.h")
     have_library("jacobi")
   end
@@ -242,7 +383,25 @@ rescue
   raise("Check GSL>=0.9.4 is installed, and the command \"gsl-config\" is in search path.")
 end
 
-narray_config = dir_config('narray',$sitearchdir,$sitearchdir)
+# Numo::NArray: only the headers are used, the classes are looked up at
+# run time.  It takes the place of the legacy NArray bridge.
+numo_config = dir_config('numo-narray',$sitearchdir,$sitearchdir)
+begin
+  require 'rubygems'
+  numo_gemspec=Gem::Specification.find_by_path('numo/narray')
+  if numo_gemspec
+    numo_config = File.join(numo_gemspec.full_gem_path, numo_gemspec.require_path, 'numo')
+    $CPPFLAGS = " -I#{numo_config} "+$CPPFLAGS
+  end
+rescue LoadError
+end
+have_numo_narray_h = have_header("numo/narray.h")
+if have_numo_narray_h
+  # narray_data_t can hold memory it does not own (numo-narray >= 0.9.1)
+  have_struct_member("narray_data_t", "owned", ["ruby.h", "numo/narray.h"])
+end
+
+narray_config = have_numo_narray_h ? nil : dir_config('narray',$sitearchdir,$sitearchdir)
 # Try to find narray with RubyGems
 begin
   require 'rubygems'
@@ -253,7 +412,7 @@ begin
   end
 rescue LoadError
 end
-have_narray_h = have_header("narray.h")
+have_narray_h = !have_numo_narray_h && have_header("narray.h")
 if narray_config
   if RUBY_PLATFORM =~ /cygwin|mingw/
 #    have_library("narray") || raise("ERROR: narray import library is not found") 
@@ -293,9 +452,11 @@ File.open("../lib/gsl.rb", "w") do |file|
   elsif have_narray_h
     file.print("require('narray')\n")
   end
+  if have_numo_narray_h
+    file.print("require('numo/narray')\n")
+  end
 #  file.print("require('rb_gsl')\ninclude GSL\n")
   file.print("require('rb_gsl')\n")  
-  file.print("require('gsl/oper.rb')\n")
 end
 
 File.open("../lib/rbgsl.rb", "w") do |file|
@@ -304,11 +465,14 @@ File.open("../lib/rbgsl.rb", "w") do |file|
   elsif have_narray_h
     file.print("require('narray')\n")
   end
+  if have_numo_narray_h
+    file.print("require('numo/narray')\n")
+  end
   file.print("require('rb_gsl')\n")
-  file.print("require('gsl/oper.rb')\n")
 end
 
-srcs = Dir.glob("*.c") - ["vector_source.c", "matrix_source.c", "tensor_source.c", "poly_source.c", "block_source.c"]
+srcs = Dir.glob("*.c") - ["vector_source.c", "matrix_source.c", "tensor_source.c", "poly_source.c", "block_source.c",
+                          "small_source.c"]
 
 $objs = srcs.collect { |f| f.sub(".c", ".o") }
 
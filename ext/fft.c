@@ -11,6 +11,8 @@
 
 #include "rb_gsl_config.h"
 #include "rb_gsl_fft.h"
+#include "rb_gsl_profiler.h"
+#include "rb_gsl_probes.h"
 
 VALUE mgsl_fft;
 VALUE cgsl_fft_wavetable;
@@ -281,6 +283,160 @@ enum {
 static void gsl_fft_free(int flag, GSL_FFT_Wavetable *table,
 			 GSL_FFT_Workspace *space);
 
+/* Per-thread cache of the wavetables and workspaces allocated by the
+   transform methods when none is given, keyed by kind and length and
+   evicted least-recently-used first. */
+enum {
+  FFT_CACHE_COMPLEX_WAVETABLE,
+  FFT_CACHE_COMPLEX_WORKSPACE,
+  FFT_CACHE_REAL_WAVETABLE,
+  FFT_CACHE_HALFCOMPLEX_WAVETABLE,
+  FFT_CACHE_REAL_WORKSPACE,
+};
+
+#define FFT_CACHE_MAX 64
+#define FFT_CACHE_DEFAULT 16
+
+struct fft_cache_entry {
+  int kind;
+  size_t n;
+  void *ptr;
+  unsigned long used;
+};
+
+struct fft_cache {
+  size_t len;
+  unsigned long clock, hits, misses;
+  struct fft_cache_entry e[FFT_CACHE_MAX];
+};
+
+static RB_GSL_THREAD_LOCAL struct fft_cache fft_cache;
+static size_t fft_cache_capacity = FFT_CACHE_DEFAULT;
+
+static void* fft_cache_alloc(int kind, size_t n)
+{
+  switch (kind) {
+  case FFT_CACHE_COMPLEX_WAVETABLE:
+    return gsl_fft_complex_wavetable_alloc(n);
+  case FFT_CACHE_COMPLEX_WORKSPACE:
+    return gsl_fft_complex_workspace_alloc(n);
+  case FFT_CACHE_REAL_WAVETABLE:
+    return gsl_fft_real_wavetable_alloc(n);
+  case FFT_CACHE_HALFCOMPLEX_WAVETABLE:
+    return gsl_fft_halfcomplex_wavetable_alloc(n);
+  case FFT_CACHE_REAL_WORKSPACE:
+    return gsl_fft_real_workspace_alloc(n);
+  }
+  return NULL;
+}
+
+static void fft_cache_release(struct fft_cache_entry *e)
+{
+  switch (e->kind) {
+  case FFT_CACHE_COMPLEX_WAVETABLE:
+    gsl_fft_complex_wavetable_free(e->ptr);
+    break;
+  case FFT_CACHE_COMPLEX_WORKSPACE:
+    gsl_fft_complex_workspace_free(e->ptr);
+    break;
+  case FFT_CACHE_REAL_WAVETABLE:
+    gsl_fft_real_wavetable_free(e->ptr);
+    break;
+  case FFT_CACHE_HALFCOMPLEX_WAVETABLE:
+    gsl_fft_halfcomplex_wavetable_free(e->ptr);
+    break;
+  case FFT_CACHE_REAL_WORKSPACE:
+    gsl_fft_real_workspace_free(e->ptr);
+    break;
+  }
+  e->ptr = NULL;
+}
+
+/* Drop least-recently-used entries until at most max remain */
+static void fft_cache_shrink(struct fft_cache *c, size_t max)
+{
+  size_t i, lru;
+  while (c->len > max) {
+    lru = 0;
+    for (i = 1; i < c->len; i++)
+      if (c->e[i].used < c->e[lru].used) lru = i;
+    fft_cache_release(&c->e[lru]);
+    c->e[lru] = c->e[--c->len];
+  }
+}
+
+RB_GSL_PROF_ENTRY(fft_plan_prof, "GSL::FFT plan")
+
+/* Returns a wavetable or workspace of the given kind and length.  *owned
+   is set to 1 when the cache is disabled, in which case the caller must
+   free the object itself. */
+static void* fft_cache_get(int kind, size_t n, int *owned)
+{
+  struct fft_cache *c = &fft_cache;
+  struct fft_cache_entry *e;
+  size_t i;
+  void *ptr;
+
+  *owned = 0;
+  for (i = 0; i < c->len; i++) {
+    e = &c->e[i];
+    if (e->kind == kind && e->n == n) {
+      e->used = ++c->clock;
+      c->hits++;
+      return e->ptr;
+    }
+  }
+  c->misses++;
+  RB_GSL_PROF_SECTION(fft_plan_prof, ptr = fft_cache_alloc(kind, n));
+  if (ptr == NULL || fft_cache_capacity == 0) {
+    *owned = 1;
+    return ptr;
+  }
+  fft_cache_shrink(c, fft_cache_capacity - 1);
+  e = &c->e[c->len++];
+  e->kind = kind;
+  e->n = n;
+  e->ptr = ptr;
+  e->used = ++c->clock;
+  return ptr;
+}
+
+static VALUE rb_gsl_fft_cache_stats(VALUE module)
+{
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("hits")), ULONG2NUM(fft_cache.hits));
+  rb_hash_aset(hash, ID2SYM(rb_intern("misses")), ULONG2NUM(fft_cache.misses));
+  rb_hash_aset(hash, ID2SYM(rb_intern("size")), SIZET2NUM(fft_cache.len));
+  rb_hash_aset(hash, ID2SYM(rb_intern("capacity")), SIZET2NUM(fft_cache_capacity));
+  return hash;
+}
+
+static VALUE rb_gsl_fft_cache_clear(VALUE module)
+{
+  fft_cache_shrink(&fft_cache, 0);
+  fft_cache.hits = 0;
+  fft_cache.misses = 0;
+  return module;
+}
+
+static VALUE rb_gsl_fft_cache_capacity(VALUE module)
+{
+  return SIZET2NUM(fft_cache_capacity);
+}
+
+/* Entries for a transform come in pairs (wavetable and workspace), so
+   a nonzero capacity is at least 2. */
+static VALUE rb_gsl_fft_set_cache_capacity(VALUE module, VALUE val)
+{
+  long n = NUM2LONG(val);
+  if (n < 0) rb_raise(rb_eArgError, "cache capacity must be non-negative");
+  if (n > FFT_CACHE_MAX) n = FFT_CACHE_MAX;
+  if (n == 1) n = 2;
+  fft_cache_capacity = (size_t) n;
+  fft_cache_shrink(&fft_cache, fft_cache_capacity);
+  return val;
+}
+
 // Parse argc, argv.  obj must be GSL::Vector::Complex.
 // This can be simplified at some point.
 // See comments preceding get_complex_stride_n()
@@ -292,6 +448,7 @@ static int gsl_fft_get_argv_complex(int argc, VALUE *argv, VALUE obj,
 {
   int flag = NONE_OF_TWO, flagtmp, i, itmp = argc, itmp2 = 0, ccc;
   int flagw = 0;
+  int owned;
 
   CHECK_VECTOR_COMPLEX(obj);
 
@@ -319,12 +476,12 @@ static int gsl_fft_get_argv_complex(int argc, VALUE *argv, VALUE obj,
   }
   get_complex_stride_n(obj, vin, data, stride, n);
   if (flagw == 0) {
-    *space = gsl_fft_complex_workspace_alloc(*n);
-    flag += ALLOC_SPACE;
+    *space = fft_cache_get(FFT_CACHE_COMPLEX_WORKSPACE, *n, &owned);
+    if (owned) flag += ALLOC_SPACE;
   }
   if (flagtmp == 0) {
-    *table = gsl_fft_complex_wavetable_alloc(*n);
-    flag += ALLOC_TABLE;
+    *table = fft_cache_get(FFT_CACHE_COMPLEX_WAVETABLE, *n, &owned);
+    if (owned) flag += ALLOC_TABLE;
   }
   if (*table == NULL) {
     rb_raise(rb_eRuntimeError, "something wrong with wavetable");
@@ -343,6 +500,7 @@ static int gsl_fft_get_argv_real(int argc, VALUE *argv, VALUE obj,
 {
   int flag = NONE_OF_TWO, flagtmp, i, itmp = argc, itmp2 = 0, ccc;
   int flagw = 0;
+  int owned;
   *naflag = 0;
 
   *ptr = get_ptr_double3(obj, n, stride, naflag);
@@ -370,12 +528,12 @@ static int gsl_fft_get_argv_real(int argc, VALUE *argv, VALUE obj,
     }
   }
   if (flagw == 0) {
-    *space = gsl_fft_real_workspace_alloc(*n);
-    flag += ALLOC_SPACE;
+    *space = fft_cache_get(FFT_CACHE_REAL_WORKSPACE, *n, &owned);
+    if (owned) flag += ALLOC_SPACE;
   }
   if (flagtmp == 0) {
-    *table = gsl_fft_real_wavetable_alloc(*n);
-    flag += ALLOC_TABLE;
+    *table = fft_cache_get(FFT_CACHE_REAL_WAVETABLE, *n, &owned);
+    if (owned) flag += ALLOC_TABLE;
   }
   if (*table == NULL) {
     rb_raise(rb_eRuntimeError, "something wrong with wavetable");
@@ -394,6 +552,7 @@ static int gsl_fft_get_argv_halfcomplex(int argc, VALUE *argv, VALUE obj,
 {
   int flag = NONE_OF_TWO, flagtmp, i, itmp = argc, itmp2 = 0, ccc;
   int flagw = 0;
+  int owned;
 
   *ptr = get_ptr_double3(obj, n, stride, naflag);
 
@@ -420,12 +579,12 @@ static int gsl_fft_get_argv_halfcomplex(int argc, VALUE *argv, VALUE obj,
     }
   }
   if (flagw == 0) {
-    *space = gsl_fft_real_workspace_alloc(*n);
-    flag += ALLOC_SPACE;
+    *space = fft_cache_get(FFT_CACHE_REAL_WORKSPACE, *n, &owned);
+    if (owned) flag += ALLOC_SPACE;
   }
   if (flagtmp == 0) {
-    *table = gsl_fft_halfcomplex_wavetable_alloc(*n);
-    flag += ALLOC_TABLE;
+    *table = fft_cache_get(FFT_CACHE_HALFCOMPLEX_WAVETABLE, *n, &owned);
+    if (owned) flag += ALLOC_TABLE;
   }
   if (*table == NULL) {
     rb_raise(rb_eRuntimeError, "something wrong with wavetable");
@@ -463,26 +622,34 @@ static VALUE rb_fft_complex_trans(int argc, VALUE *argv, VALUE obj,
 						   gsl_fft_complex_workspace *),
 				  int sss)
 {
-  int flag = 0;
-  // local variable "status" was defined and set, but never used
-  //int status;
+  int flag = 0, token;
+  int status;
   size_t stride, n;
   gsl_complex_packed_array data;
   gsl_vector_complex *vin, *vout;
   gsl_fft_complex_wavetable *table = NULL;
   gsl_fft_complex_workspace *space = NULL;
+  VALUE ary;
   flag = gsl_fft_get_argv_complex(argc, argv, obj, &vin, &data, &stride, &n, &table, &space);
   if (sss == RB_GSL_FFT_COPY) {
     vout = gsl_vector_complex_alloc(n);
     gsl_vector_complex_memcpy(vout, vin);
-    /*status =*/ (*transform)(vout->data, vout->stride /*1*/, vout->size /*n*/, table, space);
-    gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
-    return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vout);
+    ary = Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vout);
+    /* an error of the transform is raised once the tables are freed */
+    token = rb_gsl_error_defer_begin();
+    RB_GSL_KERNEL_ENTRY("fft_complex", vout->size, vout->stride);
+    status = (*transform)(vout->data, vout->stride, vout->size, table, space);
+    RB_GSL_KERNEL_RETURN("fft_complex", vout->size, vout->stride, status);
   } else {    /* in-place */
-    /*status =*/ (*transform)(data, stride, n, table, space);
-    gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
-    return obj;
+    token = rb_gsl_error_defer_begin();
+    RB_GSL_KERNEL_ENTRY("fft_complex", n, stride);
+    status = (*transform)(data, stride, n, table, space);
+    RB_GSL_KERNEL_RETURN("fft_complex", n, stride, status);
+    ary = obj;
   }
+  gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
+  rb_gsl_error_defer_end(token);
+  return ary;
 }
 
 static VALUE rb_gsl_fft_complex_forward(int argc, VALUE *argv, VALUE obj)
@@ -499,31 +666,35 @@ static VALUE rb_gsl_fft_complex_forward2(int argc, VALUE *argv, VALUE obj)
 
 static VALUE rb_gsl_fft_complex_transform(int argc, VALUE *argv, VALUE obj)
 {
-  int flag = 0;
-  // local variable "status" was defined and set, but never used
-  //int status;
+  int flag = 0, token;
+  int status;
   size_t stride, n;
   gsl_vector_complex *vin, *vout;
   gsl_fft_direction sign;
   gsl_complex_packed_array data;
   gsl_fft_complex_wavetable *table = NULL;
   gsl_fft_complex_workspace *space = NULL;
+  VALUE ary;
   CHECK_FIXNUM(argv[argc-1]);
   sign = FIX2INT(argv[argc-1]);
   flag = gsl_fft_get_argv_complex(argc-1, argv, obj, &vin, &data, &stride, &n, &table, &space);
   vout = gsl_vector_complex_alloc(n);
   gsl_vector_complex_memcpy(vout, vin);
-  /*status =*/ gsl_fft_complex_transform(vout->data, stride, n, table, space, sign);
+  ary = Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vout);
+  token = rb_gsl_error_defer_begin();
+  RB_GSL_KERNEL_ENTRY("fft_complex", n, stride);
+  status = gsl_fft_complex_transform(vout->data, stride, n, table, space, sign);
+  RB_GSL_KERNEL_RETURN("fft_complex", n, stride, status);
   gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
-  return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vout);
+  rb_gsl_error_defer_end(token);
+  return ary;
 }
 
 /* in-place */
 static VALUE rb_gsl_fft_complex_transform2(int argc, VALUE *argv, VALUE obj)
 {
-  int flag = 0;
-  // local variable "status" was defined and set, but never used
-  //int status;
+  int flag = 0, token;
+  int status;
   size_t stride, n;
   gsl_fft_direction sign;
   gsl_complex_packed_array data;
@@ -532,8 +703,12 @@ static VALUE rb_gsl_fft_complex_transform2(int argc, VALUE *argv, VALUE obj)
   CHECK_FIXNUM(argv[argc-1]);
   sign = FIX2INT(argv[argc-1]);
   flag = gsl_fft_get_argv_complex(argc-1, argv, obj, NULL, &data, &stride, &n, &table, &space);
-  /*status =*/ gsl_fft_complex_transform(data, stride, n, table, space, sign);
+  token = rb_gsl_error_defer_begin();
+  RB_GSL_KERNEL_ENTRY("fft_complex", n, stride);
+  status = gsl_fft_complex_transform(data, stride, n, table, space, sign);
+  RB_GSL_KERNEL_RETURN("fft_complex", n, stride, status);
   gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
+  rb_gsl_error_defer_end(token);
   return obj;
 }
 
@@ -672,9 +847,8 @@ static VALUE rb_fft_real_trans(int argc, VALUE *argv, VALUE obj,
 					    gsl_fft_real_workspace *),
 			       int sss)
 {
-  int flag = 0, naflag = 0;
-  // local variable "status" was defined and set, but never used
-  //int status;
+  int flag = 0, naflag = 0, token;
+  int status;
   size_t stride, n;
   gsl_vector *vnew;
   gsl_vector_view vv;
@@ -716,8 +890,12 @@ static VALUE rb_fft_real_trans(int argc, VALUE *argv, VALUE obj,
   } else {
     rb_raise(rb_eRuntimeError, "something wrong");
   }
-  /*status =*/ (*trans)(ptr2, stride, n, table, space);
+  token = rb_gsl_error_defer_begin();
+  RB_GSL_KERNEL_ENTRY("fft_real", n, stride);
+  status = (*trans)(ptr2, stride, n, table, space);
+  RB_GSL_KERNEL_RETURN("fft_real", n, stride, status);
   gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
+  rb_gsl_error_defer_end(token);
   return ary;
 }
 
@@ -738,9 +916,8 @@ static VALUE rb_fft_halfcomplex_trans(int argc, VALUE *argv, VALUE obj,
 						   const gsl_fft_halfcomplex_wavetable *, gsl_fft_real_workspace *),
 				      int sss)
 {
-  int flag = 0, naflag = 0;
-  // local variable "status" was defined and set, but never used
-  //int status;
+  int flag = 0, naflag = 0, token;
+  int status;
   size_t stride, n;
   gsl_vector *vnew;
   gsl_vector_view vv;
@@ -783,8 +960,12 @@ static VALUE rb_fft_halfcomplex_trans(int argc, VALUE *argv, VALUE obj,
   } else {
     rb_raise(rb_eRuntimeError, "something wrong");
   }
-  /*status =*/ (*trans)(ptr2, stride, n, table, space);
+  token = rb_gsl_error_defer_begin();
+  RB_GSL_KERNEL_ENTRY("fft_halfcomplex", n, stride);
+  status = (*trans)(ptr2, stride, n, table, space);
+  RB_GSL_KERNEL_RETURN("fft_halfcomplex", n, stride, status);
   gsl_fft_free(flag, (GSL_FFT_Wavetable *) table, (GSL_FFT_Workspace *) space);
+  rb_gsl_error_defer_end(token);
   return ary;
 }
 
@@ -857,6 +1038,659 @@ static VALUE rb_gsl_fft_halfcomplex_unpack(VALUE obj)
 }
 
 /* Convert a halfcomplex data to Numerical Recipes style */
+/*
+  Batched transforms of the rows or columns of a matrix.  All signals
+  share one wavetable; each thread has its own workspace.
+*/
+enum {
+  FFT_BATCH_REAL,
+  FFT_BATCH_HALFCOMPLEX,
+  FFT_BATCH_COMPLEX,
+  FFT_BATCH_COMPLEX_INVERSE,
+};
+
+struct fft_batch {
+  int type;
+  double *data;
+  size_t count, n, stride, dist;  /* in elements (complex for complex data) */
+  void *table;
+  void **space;
+  size_t nthreads;
+};
+
+static int fft_batch_range(struct fft_batch *b, size_t k0, size_t k1, void *space)
+{
+  size_t k;
+  int status = GSL_SUCCESS, st;
+  RB_GSL_KERNEL_ENTRY("fft_batch", b->n, k1 - k0);
+  for (k = k0; k < k1; k++) {
+    switch (b->type) {
+    case FFT_BATCH_REAL:
+      st = gsl_fft_real_transform(b->data + k*b->dist, b->stride, b->n,
+				  b->table, space);
+      break;
+    case FFT_BATCH_HALFCOMPLEX:
+      st = gsl_fft_halfcomplex_inverse(b->data + k*b->dist, b->stride, b->n,
+				       b->table, space);
+      break;
+    case FFT_BATCH_COMPLEX:
+      st = gsl_fft_complex_forward(b->data + 2*k*b->dist, b->stride, b->n,
+				   b->table, space);
+      break;
+    default:
+      st = gsl_fft_complex_inverse(b->data + 2*k*b->dist, b->stride, b->n,
+				   b->table, space);
+      break;
+    }
+    if (status == GSL_SUCCESS) status = st;
+  }
+  RB_GSL_KERNEL_RETURN("fft_batch", b->n, k1 - k0, status);
+  return status;
+}
+
+static int fft_batch_nogvl(void *data)
+{
+  struct fft_batch *b = (struct fft_batch *) data;
+  return fft_batch_range(b, 0, b->count, b->space[0]);
+}
+
+static int fft_batch_thread(void *data, size_t t)
+{
+  struct fft_batch *b = (struct fft_batch *) data;
+  return fft_batch_range(b, t*b->count/b->nthreads, (t+1)*b->count/b->nthreads,
+			 b->space[t]);
+}
+
+static int fft_batch_run(struct fft_batch *b)
+{
+  int tkind, skind, owned_t, owned_s, status, complex;
+  size_t t;
+
+  complex = (b->type == FFT_BATCH_COMPLEX || b->type == FFT_BATCH_COMPLEX_INVERSE);
+  if (b->count == 0 || b->n == 0) return GSL_SUCCESS;
+  if (b->nthreads > b->count) b->nthreads = b->count;
+  if (b->nthreads == 0) b->nthreads = 1;
+  switch (b->type) {
+  case FFT_BATCH_REAL: tkind = FFT_CACHE_REAL_WAVETABLE; break;
+  case FFT_BATCH_HALFCOMPLEX: tkind = FFT_CACHE_HALFCOMPLEX_WAVETABLE; break;
+  default: tkind = FFT_CACHE_COMPLEX_WAVETABLE; break;
+  }
+  skind = complex ? FFT_CACHE_COMPLEX_WORKSPACE : FFT_CACHE_REAL_WORKSPACE;
+  b->space = ALLOC_N(void *, b->nthreads);
+  for (t = 0; t < b->nthreads; t++) b->space[t] = NULL;
+  b->space[0] = fft_cache_get(skind, b->n, &owned_s);
+  b->table = fft_cache_get(tkind, b->n, &owned_t);
+  status = (b->table == NULL || b->space[0] == NULL) ? GSL_ENOMEM : GSL_SUCCESS;
+  for (t = 1; t < b->nthreads; t++) {
+    b->space[t] = fft_cache_alloc(skind, b->n);
+    if (b->space[t] == NULL) status = GSL_ENOMEM;
+  }
+  if (status == GSL_ENOMEM) {
+    /* reported below */
+  } else if (b->nthreads == 1) {
+    status = rb_gsl_nogvl_call(fft_batch_nogvl, b, b->count*b->n);
+  } else {
+    status = rb_gsl_nogvl_parallel(fft_batch_thread, b, b->nthreads);
+  }
+  for (t = 0; t < b->nthreads; t++) {
+    if (b->space[t] == NULL || (t == 0 && !owned_s)) continue;
+    if (complex) gsl_fft_complex_workspace_free(b->space[t]);
+    else gsl_fft_real_workspace_free(b->space[t]);
+  }
+  if (owned_t && b->table) {
+    switch (tkind) {
+    case FFT_CACHE_REAL_WAVETABLE: gsl_fft_real_wavetable_free(b->table); break;
+    case FFT_CACHE_HALFCOMPLEX_WAVETABLE: gsl_fft_halfcomplex_wavetable_free(b->table); break;
+    default: gsl_fft_complex_wavetable_free(b->table); break;
+    }
+  }
+  xfree(b->space);
+  if (status == GSL_ENOMEM) rb_raise(rb_eNoMemError, "fft: wavetable or workspace allocation failed");
+  return status;
+}
+
+/* matrix.fft_rows([nthreads]) etc. Returns the transformed matrix, which
+   is obj itself if inplace is set. */
+static VALUE rb_gsl_fft_matrix_batch(int argc, VALUE *argv, VALUE obj,
+				     int type, int columns, int inplace)
+{
+  struct fft_batch b;
+  gsl_matrix *m = NULL, *mnew;
+  gsl_matrix_complex *mc = NULL, *mcnew;
+  size_t size1, size2, tda;
+  int complex;
+  VALUE vnew;
+
+  if (argc > 1) rb_raise(rb_eArgError, "too many arguments (%d for 0 or 1)", argc);
+  complex = (type == FFT_BATCH_COMPLEX || type == FFT_BATCH_COMPLEX_INVERSE);
+  b.nthreads = 1;
+  if (argc == 1) {
+    if (NUM2INT(argv[0]) < 1) rb_raise(rb_eArgError, "number of threads must be positive");
+    b.nthreads = NUM2INT(argv[0]);
+  }
+  if (complex) {
+    CHECK_MATRIX_COMPLEX(obj);
+    Data_Get_Struct(obj, gsl_matrix_complex, mc);
+    if (inplace) {
+      vnew = obj;
+    } else {
+      mcnew = gsl_matrix_complex_alloc(mc->size1, mc->size2);
+      gsl_matrix_complex_memcpy(mcnew, mc);
+      mc = mcnew;
+      vnew = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, mc);
+    }
+    size1 = mc->size1;  size2 = mc->size2;  tda = mc->tda;
+    b.data = mc->data;
+  } else {
+    CHECK_MATRIX(obj);
+    Data_Get_Struct(obj, gsl_matrix, m);
+    if (inplace) {
+      vnew = obj;
+    } else {
+      mnew = gsl_matrix_alloc(m->size1, m->size2);
+      gsl_matrix_memcpy(mnew, m);
+      m = mnew;
+      vnew = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+    }
+    size1 = m->size1;  size2 = m->size2;  tda = m->tda;
+    b.data = m->data;
+  }
+  b.type = type;
+  if (columns) {
+    b.count = size2;  b.n = size1;  b.stride = tda;  b.dist = 1;
+  } else {
+    b.count = size1;  b.n = size2;  b.stride = 1;  b.dist = tda;
+  }
+  fft_batch_run(&b);
+  return vnew;
+}
+
+static VALUE rb_gsl_matrix_fft_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_REAL, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_fft_rows2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_REAL, 0, 1);
+}
+
+static VALUE rb_gsl_matrix_ifft_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_HALFCOMPLEX, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_ifft_rows2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_HALFCOMPLEX, 0, 1);
+}
+
+static VALUE rb_gsl_matrix_fft_columns(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_REAL, 1, 0);
+}
+
+static VALUE rb_gsl_matrix_fft_columns2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_REAL, 1, 1);
+}
+
+static VALUE rb_gsl_matrix_ifft_columns(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_HALFCOMPLEX, 1, 0);
+}
+
+static VALUE rb_gsl_matrix_ifft_columns2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_HALFCOMPLEX, 1, 1);
+}
+
+static VALUE rb_gsl_matrix_complex_fft_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_complex_fft_rows2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX, 0, 1);
+}
+
+static VALUE rb_gsl_matrix_complex_ifft_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX_INVERSE, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_complex_ifft_rows2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX_INVERSE, 0, 1);
+}
+
+static VALUE rb_gsl_matrix_complex_fft_columns(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX, 1, 0);
+}
+
+static VALUE rb_gsl_matrix_complex_fft_columns2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX, 1, 1);
+}
+
+static VALUE rb_gsl_matrix_complex_ifft_columns(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX_INVERSE, 1, 0);
+}
+
+static VALUE rb_gsl_matrix_complex_ifft_columns2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_fft_matrix_batch(argc, argv, obj, FFT_BATCH_COMPLEX_INVERSE, 1, 1);
+}
+
+/*
+  Multidimensional complex transforms of row-major data.  The last axis
+  is transformed in place; along the other axes blocks of FFT_ND_BLOCK
+  lines are transposed into a contiguous buffer, transformed there and
+  transposed back, so that no transform runs with a large stride.
+*/
+#define FFT_ND_BLOCK 16
+
+struct fft_axis {
+  double *data;
+  size_t outer, n, inner;    /* element (o, k, j) is at */
+  size_t pouter, pn;         /* data + 2*(o*pouter + k*pn + j) */
+  int inverse;
+  gsl_fft_complex_wavetable *table;
+  gsl_fft_complex_workspace *space;
+  double *buf;
+};
+
+static int fft_axis_nogvl(void *data)
+{
+  struct fft_axis *a = (struct fft_axis *) data;
+  size_t o, j, j0, jb, k;
+  int status = GSL_SUCCESS, st;
+  double *line, *p;
+
+  for (o = 0; o < a->outer; o++) {
+    if (a->inner == 1) {
+      line = a->data + 2*o*a->pouter;
+      st = a->inverse ? gsl_fft_complex_inverse(line, a->pn, a->n, a->table, a->space)
+	: gsl_fft_complex_forward(line, a->pn, a->n, a->table, a->space);
+      if (status == GSL_SUCCESS) status = st;
+      continue;
+    }
+    for (j0 = 0; j0 < a->inner; j0 += FFT_ND_BLOCK) {
+      jb = GSL_MIN(FFT_ND_BLOCK, a->inner - j0);
+      for (k = 0; k < a->n; k++) {
+	p = a->data + 2*(o*a->pouter + k*a->pn + j0);
+	for (j = 0; j < jb; j++) {
+	  a->buf[2*(j*a->n + k)] = p[2*j];
+	  a->buf[2*(j*a->n + k) + 1] = p[2*j + 1];
+	}
+      }
+      for (j = 0; j < jb; j++) {
+	line = a->buf + 2*j*a->n;
+	st = a->inverse ? gsl_fft_complex_inverse(line, 1, a->n, a->table, a->space)
+	  : gsl_fft_complex_forward(line, 1, a->n, a->table, a->space);
+	if (status == GSL_SUCCESS) status = st;
+      }
+      for (k = 0; k < a->n; k++) {
+	p = a->data + 2*(o*a->pouter + k*a->pn + j0);
+	for (j = 0; j < jb; j++) {
+	  p[2*j] = a->buf[2*(j*a->n + k)];
+	  p[2*j + 1] = a->buf[2*(j*a->n + k) + 1];
+	}
+      }
+    }
+  }
+  return status;
+}
+
+/* dims[0..rank-1] in row-major order; tda is the distance between
+   consecutive lines of the last axis (dims[rank-1] for packed data). */
+static int fft_complex_nd(double *data, size_t rank, const size_t *dims,
+			  size_t tda, int inverse)
+{
+  struct fft_axis a;
+  size_t d, i, total = 1, *pitch;
+  int owned_t, owned_s, status = GSL_SUCCESS, st;
+
+  for (d = 0; d < rank; d++) total *= dims[d];
+  if (total == 0) return GSL_SUCCESS;
+  pitch = ALLOCA_N(size_t, rank);
+  pitch[rank-1] = 1;
+  if (rank > 1) pitch[rank-2] = tda;
+  if (rank > 2) for (d = rank - 2; d-- > 0;) pitch[d] = pitch[d+1]*dims[d+1];
+  a.data = data;
+  a.inverse = inverse;
+  for (d = rank; d-- > 0;) {
+    if (dims[d] == 1) continue;
+    a.n = dims[d];
+    a.pn = pitch[d];
+    a.outer = 1;
+    for (i = 0; i < d; i++) a.outer *= dims[i];
+    a.pouter = (d > 0) ? pitch[d-1] : 0;
+    if (d == rank - 1) a.inner = 1;
+    else if (d == rank - 2) a.inner = dims[rank-1];
+    else a.inner = pitch[d];
+    a.table = fft_cache_get(FFT_CACHE_COMPLEX_WAVETABLE, a.n, &owned_t);
+    a.space = fft_cache_get(FFT_CACHE_COMPLEX_WORKSPACE, a.n, &owned_s);
+    a.buf = (a.inner > 1) ? ALLOC_N(double, 2*a.n*FFT_ND_BLOCK) : NULL;
+    if (a.table == NULL || a.space == NULL) 
+      rb_raise(rb_eNoMemError, "fft: wavetable or workspace allocation failed");
+    st = rb_gsl_nogvl_call(fft_axis_nogvl, &a, total);
+    if (status == GSL_SUCCESS) status = st;
+    if (a.buf) xfree(a.buf);
+    if (owned_t) gsl_fft_complex_wavetable_free(a.table);
+    if (owned_s) gsl_fft_complex_workspace_free(a.space);
+  }
+  return status;
+}
+
+/* Transforms packed row-major complex data of the given shape in place.
+   Used by Tensor#fft3. */
+int rb_gsl_fft_complex_nd(double *data, size_t rank, const size_t *dims, 
+			  int inverse)
+{
+  if (rank == 0) return GSL_SUCCESS;
+  return fft_complex_nd(data, rank, dims, dims[rank-1], inverse);
+}
+
+/* The smallest length >= n with no prime factor but 2, 3 and 5, which the
+   mixed-radix transforms take without their generic (O(n^2)) pass */
+size_t rb_gsl_fft_good_size(size_t n)
+{
+  size_t m, k;
+  for (m = n > 1 ? n : 1; ; m++) {
+    for (k = m; k % 2 == 0; k /= 2);
+    for (; k % 3 == 0; k /= 3);
+    for (; k % 5 == 0; k /= 5);
+    if (k == 1) return m;
+  }
+}
+
+/* Real transform of data[0..n-1] in place into halfcomplex form, or with
+   inverse the normalized halfcomplex inverse, with the cached wavetables
+   and workspace.  Used by the FFT products of GSL::Poly. */
+int rb_gsl_fft_real_cached(double *data, size_t n, int inverse)
+{
+  gsl_fft_real_workspace *space;
+  void *table;
+  int owned_t, owned_s, status;
+  space = fft_cache_get(FFT_CACHE_REAL_WORKSPACE, n, &owned_s);
+  table = fft_cache_get(inverse ? FFT_CACHE_HALFCOMPLEX_WAVETABLE : FFT_CACHE_REAL_WAVETABLE,
+			n, &owned_t);
+  if (table == NULL || space == NULL)
+    rb_raise(rb_eNoMemError, "fft: wavetable or workspace allocation failed");
+  if (inverse)
+    status = gsl_fft_halfcomplex_inverse(data, 1, n, (gsl_fft_halfcomplex_wavetable *) table, space);
+  else
+    status = gsl_fft_real_transform(data, 1, n, (gsl_fft_real_wavetable *) table, space);
+  if (owned_t) {
+    if (inverse) gsl_fft_halfcomplex_wavetable_free(table);
+    else gsl_fft_real_wavetable_free(table);
+  }
+  if (owned_s) gsl_fft_real_workspace_free(space);
+  return status;
+}
+
+static VALUE rb_gsl_matrix_complex_fft2_common(VALUE obj, int inverse, int inplace)
+{
+  gsl_matrix_complex *m, *mnew;
+  size_t dims[2];
+  VALUE vnew = obj;
+  CHECK_MATRIX_COMPLEX(obj);
+  Data_Get_Struct(obj, gsl_matrix_complex, m);
+  if (!inplace) {
+    mnew = gsl_matrix_complex_alloc(m->size1, m->size2);
+    gsl_matrix_complex_memcpy(mnew, m);
+    m = mnew;
+    vnew = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, m);
+  }
+  dims[0] = m->size1;
+  dims[1] = m->size2;
+  fft_complex_nd(m->data, 2, dims, m->tda, inverse);
+  return vnew;
+}
+
+static VALUE rb_gsl_matrix_complex_fft2(VALUE obj)
+{
+  return rb_gsl_matrix_complex_fft2_common(obj, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_complex_fft2_bang(VALUE obj)
+{
+  return rb_gsl_matrix_complex_fft2_common(obj, 0, 1);
+}
+
+static VALUE rb_gsl_matrix_complex_ifft2(VALUE obj)
+{
+  return rb_gsl_matrix_complex_fft2_common(obj, 1, 0);
+}
+
+static VALUE rb_gsl_matrix_complex_ifft2_bang(VALUE obj)
+{
+  return rb_gsl_matrix_complex_fft2_common(obj, 1, 1);
+}
+
+/* vector.fftn([n1, n2, ...]): the vector holds a row-major array of that
+   shape */
+static VALUE rb_gsl_vector_complex_fftn_common(VALUE obj, VALUE shape, 
+					       int inverse, int inplace)
+{
+  gsl_vector_complex *v, *vnew;
+  size_t *dims, rank, i, total = 1;
+  VALUE ret = obj;
+  CHECK_VECTOR_COMPLEX(obj);
+  Check_Type(shape, T_ARRAY);
+  Data_Get_Struct(obj, gsl_vector_complex, v);
+  rank = RARRAY_LEN(shape);
+  if (rank == 0) rb_raise(rb_eArgError, "empty shape");
+  dims = ALLOCA_N(size_t, rank);
+  for (i = 0; i < rank; i++) {
+    dims[i] = NUM2SIZET(rb_ary_entry(shape, i));
+    total *= dims[i];
+  }
+  if (total != v->size) 
+    rb_raise(rb_eArgError, "shape does not match vector size (%d != %d)",
+	     (int) total, (int) v->size);
+  if (!inplace || v->stride != 1) {
+    vnew = gsl_vector_complex_alloc(v->size);
+    gsl_vector_complex_memcpy(vnew, v);
+    rb_gsl_fft_complex_nd(vnew->data, rank, dims, inverse);
+    if (!inplace) 
+      return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vnew);
+    gsl_vector_complex_memcpy(v, vnew);
+    gsl_vector_complex_free(vnew);
+    return ret;
+  }
+  rb_gsl_fft_complex_nd(v->data, rank, dims, inverse);
+  return ret;
+}
+
+static VALUE rb_gsl_vector_complex_fftn(VALUE obj, VALUE shape)
+{
+  return rb_gsl_vector_complex_fftn_common(obj, shape, 0, 0);
+}
+
+static VALUE rb_gsl_vector_complex_fftn_bang(VALUE obj, VALUE shape)
+{
+  return rb_gsl_vector_complex_fftn_common(obj, shape, 0, 1);
+}
+
+static VALUE rb_gsl_vector_complex_ifftn(VALUE obj, VALUE shape)
+{
+  return rb_gsl_vector_complex_fftn_common(obj, shape, 1, 0);
+}
+
+static VALUE rb_gsl_vector_complex_ifftn_bang(VALUE obj, VALUE shape)
+{
+  return rb_gsl_vector_complex_fftn_common(obj, shape, 1, 1);
+}
+
+/*
+  Short-time Fourier transform.
+
+  vector.stft(window_size, hop[, opts]) returns a matrix with one row per
+  frame and window_size/2 + 1 columns (frequency bins).  opts:
+    :window => :hann (default, periodic), :hamming, :blackman,
+               :rectangular or a GSL::Vector of window_size weights
+    :output => :magnitude (default), :power or :complex
+               (a GSL::Matrix::Complex)
+*/
+enum {
+  STFT_MAGNITUDE,
+  STFT_POWER,
+  STFT_COMPLEX,
+};
+
+struct fft_stft {
+  const double *x;
+  size_t stride, nwin, hop, nframes, nbins, tda;
+  const double *w;
+  double *frame, *out;
+  int output;
+  gsl_fft_real_wavetable *table;
+  gsl_fft_real_workspace *space;
+};
+
+static int fft_stft_nogvl(void *data)
+{
+  struct fft_stft *s = (struct fft_stft *) data;
+  size_t f, i, k;
+  double re, im, *row;
+  int status = GSL_SUCCESS, st;
+
+  for (f = 0; f < s->nframes; f++) {
+    for (i = 0; i < s->nwin; i++) 
+      s->frame[i] = s->x[(f*s->hop + i)*s->stride]*s->w[i];
+    st = gsl_fft_real_transform(s->frame, 1, s->nwin, s->table, s->space);
+    if (status == GSL_SUCCESS) status = st;
+    row = s->out + f*s->tda*(s->output == STFT_COMPLEX ? 2 : 1);
+    for (k = 0; k < s->nbins; k++) {
+      if (k == 0) {
+	re = s->frame[0];  im = 0.0;
+      } else if (2*k == s->nwin) {
+	re = s->frame[s->nwin-1];  im = 0.0;
+      } else {
+	re = s->frame[2*k-1];  im = s->frame[2*k];
+      }
+      switch (s->output) {
+      case STFT_COMPLEX:
+	row[2*k] = re;  row[2*k+1] = im;
+	break;
+      case STFT_POWER:
+	row[k] = re*re + im*im;
+	break;
+      default:
+	row[k] = hypot(re, im);
+	break;
+      }
+    }
+  }
+  return status;
+}
+
+static double* fft_stft_window(VALUE win, size_t n)
+{
+  double *w = ALLOC_N(double, n);
+  gsl_vector *v;
+  const char *name;
+  size_t i;
+  double t;
+  if (rb_obj_is_kind_of(win, cgsl_vector)) {
+    Data_Get_Struct(win, gsl_vector, v);
+    if (v->size != n) {
+      xfree(w);
+      rb_raise(rb_eArgError, "window length must be %d", (int) n);
+    }
+    for (i = 0; i < n; i++) w[i] = gsl_vector_get(v, i);
+    return w;
+  }
+  name = NIL_P(win) ? "hann" : rb_id2name(SYM2ID(win));
+  for (i = 0; i < n; i++) {
+    t = 2.0*M_PI*i/n;
+    if (strcmp(name, "hann") == 0 || strcmp(name, "hanning") == 0) 
+      w[i] = 0.5 - 0.5*cos(t);
+    else if (strcmp(name, "hamming") == 0) 
+      w[i] = 0.54 - 0.46*cos(t);
+    else if (strcmp(name, "blackman") == 0)
+      w[i] = 0.42 - 0.5*cos(t) + 0.08*cos(2.0*t);
+    else if (strcmp(name, "rectangular") == 0 || strcmp(name, "boxcar") == 0)
+      w[i] = 1.0;
+    else {
+      xfree(w);
+      rb_raise(rb_eArgError, "unknown window %s", name);
+    }
+  }
+  return w;
+}
+
+static VALUE rb_gsl_vector_stft(int argc, VALUE *argv, VALUE obj)
+{
+  struct fft_stft s;
+  gsl_vector *v;
+  gsl_matrix *m;
+  gsl_matrix_complex *mc;
+  VALUE opts = Qnil, win = Qnil, out = Qnil, ret;
+  long nwin, hop;
+  int owned_t, owned_s;
+
+  if (argc < 2 || argc > 3) 
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  CHECK_VECTOR(obj);
+  Data_Get_Struct(obj, gsl_vector, v);
+  nwin = NUM2LONG(argv[0]);
+  hop = NUM2LONG(argv[1]);
+  if (nwin < 2) rb_raise(rb_eArgError, "window size must be at least 2");
+  if (hop < 1) rb_raise(rb_eArgError, "hop must be positive");
+  if ((size_t) nwin > v->size) 
+    rb_raise(rb_eArgError, "window size %d exceeds vector size %d", 
+	     (int) nwin, (int) v->size);
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+    win = rb_hash_aref(opts, ID2SYM(rb_intern("window")));
+    out = rb_hash_aref(opts, ID2SYM(rb_intern("output")));
+  }
+  s.output = STFT_MAGNITUDE;
+  if (!NIL_P(out)) {
+    if (SYM2ID(out) == rb_intern("power")) s.output = STFT_POWER;
+    else if (SYM2ID(out) == rb_intern("complex")) s.output = STFT_COMPLEX;
+    else if (SYM2ID(out) != rb_intern("magnitude"))
+      rb_raise(rb_eArgError, "unknown output %s", rb_id2name(SYM2ID(out)));
+  }
+  s.x = v->data;
+  s.stride = v->stride;
+  s.nwin = (size_t) nwin;
+  s.hop = (size_t) hop;
+  s.nframes = (v->size - s.nwin)/s.hop + 1;
+  s.nbins = s.nwin/2 + 1;
+  if (s.output == STFT_COMPLEX) {
+    mc = gsl_matrix_complex_alloc(s.nframes, s.nbins);
+    ret = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, mc);
+    s.out = mc->data;
+    s.tda = mc->tda;
+  } else {
+    m = gsl_matrix_alloc(s.nframes, s.nbins);
+    ret = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+    s.out = m->data;
+    s.tda = m->tda;
+  }
+  s.w = fft_stft_window(win, s.nwin);
+  s.frame = ALLOC_N(double, s.nwin);
+  s.table = fft_cache_get(FFT_CACHE_REAL_WAVETABLE, s.nwin, &owned_t);
+  s.space = fft_cache_get(FFT_CACHE_REAL_WORKSPACE, s.nwin, &owned_s);
+  if (s.table && s.space)
+    rb_gsl_nogvl_call(fft_stft_nogvl, &s, s.nframes*s.nwin);
+  xfree((double *) s.w);
+  xfree(s.frame);
+  if (owned_t && s.table) gsl_fft_real_wavetable_free(s.table);
+  if (owned_s && s.space) gsl_fft_real_workspace_free(s.space);
+  if (s.table == NULL || s.space == NULL)
+    rb_raise(rb_eNoMemError, "fft: wavetable or workspace allocation failed");
+  return ret;
+}
+
 static VALUE rb_gsl_fft_halfcomplex_to_nrc(VALUE obj)
 {
   gsl_vector *v, *vnew;
@@ -901,10 +1735,32 @@ static VALUE rb_gsl_fft_halfcomplex_amp_phase(VALUE obj)
   return rb_ary_new3(2, vamp, vphase);
 }
 
+RB_GSL_PROFILED(rb_gsl_fft_complex_forward, "GSL::Vector::Complex#forward")
+RB_GSL_PROFILED(rb_gsl_fft_complex_transform, "GSL::Vector::Complex#transform")
+RB_GSL_PROFILED(rb_gsl_fft_complex_backward, "GSL::Vector::Complex#backward")
+RB_GSL_PROFILED(rb_gsl_fft_complex_inverse, "GSL::Vector::Complex#inverse")
+RB_GSL_PROFILED(rb_gsl_fft_complex_forward2, "GSL::Vector::Complex#forward!")
+RB_GSL_PROFILED(rb_gsl_fft_complex_transform2, "GSL::Vector::Complex#transform!")
+RB_GSL_PROFILED(rb_gsl_fft_complex_backward2, "GSL::Vector::Complex#backward!")
+RB_GSL_PROFILED(rb_gsl_fft_complex_inverse2, "GSL::Vector::Complex#inverse!")
+RB_GSL_PROFILED(rb_gsl_fft_real_transform, "GSL::Vector#real_transform")
+RB_GSL_PROFILED(rb_gsl_fft_halfcomplex_transform, "GSL::Vector#halfcomplex_transform")
+RB_GSL_PROFILED(rb_gsl_fft_halfcomplex_backward, "GSL::Vector#halfcomplex_backward")
+RB_GSL_PROFILED(rb_gsl_fft_halfcomplex_inverse, "GSL::Vector#halfcomplex_inverse")
+RB_GSL_PROFILED(rb_gsl_fft_real_transform2, "GSL::Vector#real_transform!")
+RB_GSL_PROFILED(rb_gsl_fft_halfcomplex_transform2, "GSL::Vector#halfcomplex_transform!")
+RB_GSL_PROFILED(rb_gsl_fft_halfcomplex_backward2, "GSL::Vector#halfcomplex_backward!")
+RB_GSL_PROFILED(rb_gsl_fft_halfcomplex_inverse2, "GSL::Vector#halfcomplex_inverse!")
+
 void Init_gsl_fft(VALUE module)
 {
   mgsl_fft = rb_define_module_under(module, "FFT");
 
+  rb_define_module_function(mgsl_fft, "cache_stats", rb_gsl_fft_cache_stats, 0);
+  rb_define_module_function(mgsl_fft, "cache_clear", rb_gsl_fft_cache_clear, 0);
+  rb_define_module_function(mgsl_fft, "cache_capacity", rb_gsl_fft_cache_capacity, 0);
+  rb_define_module_function(mgsl_fft, "cache_capacity=", rb_gsl_fft_set_cache_capacity, 1);
+
   /*****/
 
   rb_define_const(mgsl_fft, "Forward", INT2FIX(gsl_fft_forward));
@@ -976,15 +1832,23 @@ void Init_gsl_fft(VALUE module)
   rb_define_singleton_method(cgsl_fft_complex_workspace, "alloc",
 			     rb_gsl_fft_complex_workspace_new, 1);
 
-  rb_define_method(cgsl_vector_complex, "forward", rb_gsl_fft_complex_forward, -1);
-  rb_define_method(cgsl_vector_complex, "transform", rb_gsl_fft_complex_transform, -1);
-  rb_define_method(cgsl_vector_complex, "backward", rb_gsl_fft_complex_backward, -1);
-  rb_define_method(cgsl_vector_complex, "inverse", rb_gsl_fft_complex_inverse, -1);
-
-  rb_define_method(cgsl_vector_complex, "forward!", rb_gsl_fft_complex_forward2, -1);
-  rb_define_method(cgsl_vector_complex, "transform!", rb_gsl_fft_complex_transform2, -1);
-  rb_define_method(cgsl_vector_complex, "backward!", rb_gsl_fft_complex_backward2, -1);
-  rb_define_method(cgsl_vector_complex, "inverse!", rb_gsl_fft_complex_inverse2, -1);
+  rb_define_method(cgsl_vector_complex, "forward",
+		   RB_GSL_PROF(rb_gsl_fft_complex_forward), -1);
+  rb_define_method(cgsl_vector_complex, "transform",
+		   RB_GSL_PROF(rb_gsl_fft_complex_transform), -1);
+  rb_define_method(cgsl_vector_complex, "backward",
+		   RB_GSL_PROF(rb_gsl_fft_complex_backward), -1);
+  rb_define_method(cgsl_vector_complex, "inverse",
+		   RB_GSL_PROF(rb_gsl_fft_complex_inverse), -1);
+
+  rb_define_method(cgsl_vector_complex, "forward!",
+		   RB_GSL_PROF(rb_gsl_fft_complex_forward2), -1);
+  rb_define_method(cgsl_vector_complex, "transform!",
+		   RB_GSL_PROF(rb_gsl_fft_complex_transform2), -1);
+  rb_define_method(cgsl_vector_complex, "backward!",
+		   RB_GSL_PROF(rb_gsl_fft_complex_backward2), -1);
+  rb_define_method(cgsl_vector_complex, "inverse!",
+		   RB_GSL_PROF(rb_gsl_fft_complex_inverse2), -1);
 
   /*****/
 
@@ -1045,36 +1909,38 @@ void Init_gsl_fft(VALUE module)
   /*****/
 
   // TODO Do these method names need the "real_" and "halfcomplex_" prefixes?
-  rb_define_method(cgsl_vector, "real_transform", rb_gsl_fft_real_transform, -1);
+  rb_define_method(cgsl_vector, "real_transform",
+		   RB_GSL_PROF(rb_gsl_fft_real_transform), -1);
   rb_define_alias(cgsl_vector, "transform", "real_transform");
   rb_define_alias(cgsl_vector, "forward", "real_transform");
   rb_define_alias(cgsl_vector, "fft_forward", "real_transform");
   rb_define_alias(cgsl_vector, "fft", "real_transform");
   rb_define_method(cgsl_vector, "halfcomplex_transform", 
-		   rb_gsl_fft_halfcomplex_transform, -1);
+		   RB_GSL_PROF(rb_gsl_fft_halfcomplex_transform), -1);
   rb_define_method(cgsl_vector, "halfcomplex_backward", 
-		   rb_gsl_fft_halfcomplex_backward, -1);
+		   RB_GSL_PROF(rb_gsl_fft_halfcomplex_backward), -1);
   rb_define_alias(cgsl_vector, "backward", "halfcomplex_backward");
   rb_define_alias(cgsl_vector, "fft_backward", "halfcomplex_backward");
   rb_define_method(cgsl_vector, "halfcomplex_inverse", 
-		   rb_gsl_fft_halfcomplex_inverse, -1); 
+		   RB_GSL_PROF(rb_gsl_fft_halfcomplex_inverse), -1); 
   rb_define_alias(cgsl_vector, "fft_inverse", "halfcomplex_inverse");
   rb_define_alias(cgsl_vector, "ifft", "halfcomplex_inverse");
   rb_define_alias(cgsl_vector, "inverse", "halfcomplex_inverse");
 
-  rb_define_method(cgsl_vector, "real_transform!", rb_gsl_fft_real_transform2, -1);
+  rb_define_method(cgsl_vector, "real_transform!",
+		   RB_GSL_PROF(rb_gsl_fft_real_transform2), -1);
   rb_define_alias(cgsl_vector, "transform!", "real_transform!");
   rb_define_alias(cgsl_vector, "forward!", "real_transform!");
   rb_define_alias(cgsl_vector, "fft_forward!", "real_transform!");
   rb_define_alias(cgsl_vector, "fft!", "real_transform!");
   rb_define_method(cgsl_vector, "halfcomplex_transform!", 
-		   rb_gsl_fft_halfcomplex_transform2, -1);
+		   RB_GSL_PROF(rb_gsl_fft_halfcomplex_transform2), -1);
   rb_define_method(cgsl_vector, "halfcomplex_backward!",
-		   rb_gsl_fft_halfcomplex_backward2, -1);
+		   RB_GSL_PROF(rb_gsl_fft_halfcomplex_backward2), -1);
   rb_define_alias(cgsl_vector, "backward!", "halfcomplex_backward!");
   rb_define_alias(cgsl_vector, "fft_backward!", "halfcomplex_backward!");
   rb_define_method(cgsl_vector, "halfcomplex_inverse!", 
-		   rb_gsl_fft_halfcomplex_inverse2, -1); 
+		   RB_GSL_PROF(rb_gsl_fft_halfcomplex_inverse2), -1); 
   rb_define_alias(cgsl_vector, "fft_inverse!", "halfcomplex_inverse!");
   rb_define_alias(cgsl_vector, "ifft!", "halfcomplex_inverse!");
   rb_define_alias(cgsl_vector, "inverse!", "halfcomplex_inverse!");
@@ -1099,4 +1965,40 @@ void Init_gsl_fft(VALUE module)
   rb_define_method(cgsl_vector, "halfcomplex_amp_phase",
 			     rb_gsl_fft_halfcomplex_amp_phase, 0);
   rb_define_alias(cgsl_vector, "hc_amp_phase", "halfcomplex_amp_phase");
+
+  /*****/
+
+  rb_define_method(cgsl_matrix, "fft_rows", rb_gsl_matrix_fft_rows, -1);
+  rb_define_method(cgsl_matrix, "fft_rows!", rb_gsl_matrix_fft_rows2, -1);
+  rb_define_method(cgsl_matrix, "ifft_rows", rb_gsl_matrix_ifft_rows, -1);
+  rb_define_method(cgsl_matrix, "ifft_rows!", rb_gsl_matrix_ifft_rows2, -1);
+  rb_define_method(cgsl_matrix, "fft_columns", rb_gsl_matrix_fft_columns, -1);
+  rb_define_method(cgsl_matrix, "fft_columns!", rb_gsl_matrix_fft_columns2, -1);
+  rb_define_method(cgsl_matrix, "ifft_columns", rb_gsl_matrix_ifft_columns, -1);
+  rb_define_method(cgsl_matrix, "ifft_columns!", rb_gsl_matrix_ifft_columns2, -1);
+
+  rb_define_method(cgsl_matrix_complex, "fft_rows", rb_gsl_matrix_complex_fft_rows, -1);
+  rb_define_method(cgsl_matrix_complex, "fft_rows!", rb_gsl_matrix_complex_fft_rows2, -1);
+  rb_define_method(cgsl_matrix_complex, "ifft_rows", rb_gsl_matrix_complex_ifft_rows, -1);
+  rb_define_method(cgsl_matrix_complex, "ifft_rows!", rb_gsl_matrix_complex_ifft_rows2, -1);
+  rb_define_method(cgsl_matrix_complex, "fft_columns", 
+		   rb_gsl_matrix_complex_fft_columns, -1);
+  rb_define_method(cgsl_matrix_complex, "fft_columns!", 
+		   rb_gsl_matrix_complex_fft_columns2, -1);
+  rb_define_method(cgsl_matrix_complex, "ifft_columns", 
+		   rb_gsl_matrix_complex_ifft_columns, -1);
+  rb_define_method(cgsl_matrix_complex, "ifft_columns!", 
+		   rb_gsl_matrix_complex_ifft_columns2, -1);
+
+  rb_define_method(cgsl_matrix_complex, "fft2", rb_gsl_matrix_complex_fft2, 0);
+  rb_define_method(cgsl_matrix_complex, "fft2!", rb_gsl_matrix_complex_fft2_bang, 0);
+  rb_define_method(cgsl_matrix_complex, "ifft2", rb_gsl_matrix_complex_ifft2, 0);
+  rb_define_method(cgsl_matrix_complex, "ifft2!", rb_gsl_matrix_complex_ifft2_bang, 0);
+
+  rb_define_method(cgsl_vector_complex, "fftn", rb_gsl_vector_complex_fftn, 1);
+  rb_define_method(cgsl_vector_complex, "fftn!", rb_gsl_vector_complex_fftn_bang, 1);
+  rb_define_method(cgsl_vector_complex, "ifftn", rb_gsl_vector_complex_ifftn, 1);
+  rb_define_method(cgsl_vector_complex, "ifftn!", rb_gsl_vector_complex_ifftn_bang, 1);
+
+  rb_define_method(cgsl_vector, "stft", rb_gsl_vector_stft, -1);
 }
@@ -12,6 +12,8 @@
 #include "rb_gsl_config.h"
 #include "rb_gsl_fit.h"
 
+void Init_gsl_fit_rolling(VALUE mgsl_fit);
+
 /* linear fit without weights: y = c0 + c1 x */
 /* This returns 7 elements array */
 static VALUE rb_gsl_fit_linear(int argc, VALUE *argv, VALUE obj)
@@ -192,6 +194,129 @@ static VALUE rb_gsl_fit_mul_est(int argc, VALUE *argv, VALUE obj)
   return rb_ary_new3(3, rb_float_new(y), rb_float_new(yerr), INT2FIX(status));
 }
 
+/*
+  Batched fits y = c0 + c1 x of the columns of a matrix Y, all over the
+  same x (and weights): the x statistics are computed once, then two
+  passes over the rows of Y accumulate the column sums and the
+  residuals, each thread doing a range of columns. The results are
+  those of Fit.linear / wlinear, one per column.
+*/
+typedef struct {
+  const gsl_matrix *Y;
+  double *dx, *w;               /* x - mean(x), the weights (NULL for 1) */
+  double mx, dx2, W;
+  gsl_vector *c0, *c1, *cov00, *cov01, *cov11, *sumsq;
+  size_t nthreads;
+} fit_batch;
+
+static int fit_batch_worker(void *data, size_t id)
+{
+  fit_batch *d = (fit_batch *) data;
+  const gsl_matrix *Y = d->Y;
+  size_t n = Y->size1, k = Y->size2, j0 = id*k/d->nthreads, j1 = (id + 1)*k/d->nthreads;
+  size_t i, j;
+  double *my = d->c0->data, *b = d->c1->data, *d2 = d->sumsq->data, *y, wi, e, s2, sdx = 0.0;
+  for (j = j0; j < j1; j++) my[j] = b[j] = d2[j] = 0.0;
+  for (i = 0; i < n; i++) {
+    wi = d->w ? d->w[i] : 1.0;
+    if (wi <= 0.0) continue;
+    sdx += wi*d->dx[i];
+    y = Y->data + i*Y->tda;
+    for (j = j0; j < j1; j++) {
+      my[j] += wi*y[j];
+      b[j] += wi*d->dx[i]*y[j];
+    }
+  }
+  for (j = j0; j < j1; j++) {
+    my[j] /= d->W;
+    b[j] = (b[j] - my[j]*sdx)/d->W/d->dx2;
+  }
+  for (i = 0; i < n; i++) {
+    wi = d->w ? d->w[i] : 1.0;
+    if (wi <= 0.0) continue;
+    y = Y->data + i*Y->tda;
+    for (j = j0; j < j1; j++) {
+      e = y[j] - my[j] - b[j]*d->dx[i];
+      d2[j] += wi*e*e;
+    }
+  }
+  for (j = j0; j < j1; j++) {
+    s2 = d->w ? 1.0 : d2[j]/(n - 2.0);
+    my[j] -= d->mx*b[j];                      /* c0 */
+    d->cov00->data[j] = s2*(1.0/d->W)*(1.0 + d->mx*d->mx/d->dx2);
+    d->cov11->data[j] = s2/(d->W*d->dx2);
+    d->cov01->data[j] = -s2*d->mx/(d->W*d->dx2);
+  }
+  return GSL_SUCCESS;
+}
+
+static int fit_batch_serial(void *data)
+{
+  return fit_batch_worker(data, 0);
+}
+
+static VALUE rb_gsl_fit_batch(VALUE vx, VALUE vw, VALUE vY)
+{
+  fit_batch d;
+  double *ptrx, *ptrw = NULL, wi;
+  size_t n, nw, stridex, stridew = 1, i, k;
+  gsl_vector **v[6];
+  VALUE ary, tmp;
+  ptrx = get_vector_ptr(vx, &stridex, &n);
+  if (!NIL_P(vw)) {
+    ptrw = get_vector_ptr(vw, &stridew, &nw);
+    if (nw != n) rb_raise(rb_eArgError, "x of %d elements, w of %d", (int) n, (int) nw);
+  }
+  Data_Get_Matrix(vY, d.Y);
+  if (d.Y->size1 != n)
+    rb_raise(rb_eArgError, "x of %d elements, Y of %d rows", (int) n, (int) d.Y->size1);
+  k = d.Y->size2;
+  d.dx = ALLOCV_N(double, tmp, 2*n);
+  d.w = ptrw ? d.dx + n : NULL;
+  d.W = 0.0;
+  d.mx = 0.0;
+  for (i = 0; i < n; i++) {
+    wi = ptrw ? ptrw[i*stridew] : 1.0;
+    if (d.w) d.w[i] = wi;
+    if (wi <= 0.0) continue;
+    d.W += wi;
+    d.mx += (ptrx[i*stridex] - d.mx)*(wi/d.W);
+  }
+  d.dx2 = 0.0;
+  for (i = 0; i < n; i++) {
+    d.dx[i] = ptrx[i*stridex] - d.mx;
+    wi = ptrw ? d.w[i] : 1.0;
+    if (wi > 0.0) d.dx2 += wi*d.dx[i]*d.dx[i];
+  }
+  d.dx2 /= d.W;
+  v[0] = &d.c0;  v[1] = &d.c1;  v[2] = &d.cov00;
+  v[3] = &d.cov01;  v[4] = &d.cov11;  v[5] = &d.sumsq;
+  ary = rb_ary_new2(7);
+  for (i = 0; i < 6; i++) {
+    *v[i] = gsl_vector_alloc(k);
+    rb_ary_push(ary, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, *v[i]));
+  }
+  rb_ary_push(ary, INT2FIX(GSL_SUCCESS));
+  d.nthreads = rb_gsl_parallel_nthreads(n*k, k);
+  if (d.nthreads > 1) rb_gsl_nogvl_parallel(fit_batch_worker, &d, d.nthreads);
+  else rb_gsl_nogvl_call(fit_batch_serial, &d, n*k);
+  ALLOCV_END(tmp);
+  return ary;
+}
+
+/* Fit.linear_batch(x, Y): Fit.linear(x, Y.col(j)) for all j, as
+   [c0, c1, cov00, cov01, cov11, sumsq] Vectors and the status */
+static VALUE rb_gsl_fit_linear_batch(VALUE obj, VALUE vx, VALUE vY)
+{
+  return rb_gsl_fit_batch(vx, Qnil, vY);
+}
+
+/* Fit.wlinear_batch(x, w, Y) */
+static VALUE rb_gsl_fit_wlinear_batch(VALUE obj, VALUE vx, VALUE vw, VALUE vY)
+{
+  return rb_gsl_fit_batch(vx, vw, vY);
+}
+
 void Init_gsl_fit(VALUE module)
 {
   VALUE mgsl_fit;
@@ -202,4 +327,8 @@ void Init_gsl_fit(VALUE module)
   rb_define_module_function(mgsl_fit, "mul", rb_gsl_fit_mul, -1);
   rb_define_module_function(mgsl_fit, "wmul", rb_gsl_fit_wmul, -1);
   rb_define_module_function(mgsl_fit, "mul_est", rb_gsl_fit_mul_est, -1);
+  rb_define_module_function(mgsl_fit, "linear_batch", rb_gsl_fit_linear_batch, 2);
+  rb_define_module_function(mgsl_fit, "wlinear_batch", rb_gsl_fit_wlinear_batch, 3);
+
+  Init_gsl_fit_rolling(mgsl_fit);
 }
@@ -0,0 +1,382 @@
+/*
+  fit_rolling.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Least squares over a moving window of samples, or over all of them
+  with exponentially decaying weights, updated sample by sample.
+
+    r = GSL::Fit::Rolling.alloc(p, :window => 60)      # or :decay => 0.97
+    r.add(x, y[, w])                # x a Float (p = 1) or a Vector of p
+    c = r.roll(X, y[, w])           # X n x p (or a Vector for p = 1)
+    r.coef; r.cov; r.rss; r.n
+
+  The model is y = c0 + c1 x1 + ... + cp xp, or without c0 with
+  :intercept => false.  roll adds the n samples in turn and returns the
+  n x k matrix of the coefficients after each of them (NaN while fewer
+  than k samples are in), k being the number of coefficients; with one
+  regressor and the intercept a row is [c0, c1] of Fit.wlinear over the
+  window.  :window and :decay may be combined: the weight of a sample
+  age steps old is then decay**age within the window.
+
+  The state is the lower Cholesky factor L of [X y]^T W [X y], (k + 1)
+  x (k + 1): L L^T = X^T W X times c = X^T W y come out of its first k
+  rows and the residual sum of squares is the square of its last
+  diagonal element, as for Linalg::QR::Incremental.  A sample is a
+  rank-1 update of L by sqrt(w)[x y], the sample leaving the window a
+  downdate, and the decay a scaling of L by sqrt(decay), so that a step
+  costs O(k^2) whatever the window.  The window is kept in a ring of
+  its rows and L is factored again from it at every window-th step, so
+  that rounding does not drift, and whenever a downdate would lose
+  positive definiteness.  roll runs without the GVL.
+
+  With the weights w, the covariance is (X^T W X)^-1 as for
+  Fit.wlinear; without, it is scaled by rss/(n - k).  The samples of one
+  Rolling are either all weighted or none.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_fit.h"
+#include "rb_gsl_linalg.h"
+
+typedef struct {
+  size_t p, k;                  /* regressors, coefficients */
+  int intercept;
+  int weighted;                 /* -1 until the first sample */
+  size_t window;                /* 0 for none */
+  double decay;                 /* 1 for none */
+  double sdw;                   /* sqrt(decay)^window, for the sample leaving */
+  size_t n, head, since;        /* samples in, oldest in the ring, steps since the refactoring */
+  gsl_matrix *L;                /* (k + 1) x (k + 1) */
+  gsl_vector *row, *old, *work; /* k + 1, k + 1, 3(k + 1) */
+  double *ring;                 /* window rows sqrt(w)[x y] */
+} mygsl_fit_rolling;
+
+static VALUE cgsl_fit_rolling;
+
+static void mygsl_fit_rolling_free(mygsl_fit_rolling *r)
+{
+  if (r->L) gsl_matrix_free(r->L);
+  if (r->row) gsl_vector_free(r->row);
+  if (r->old) gsl_vector_free(r->old);
+  if (r->work) gsl_vector_free(r->work);
+  xfree(r->ring);
+  xfree(r);
+}
+
+static void fit_rolling_reset(mygsl_fit_rolling *r)
+{
+  gsl_matrix_set_zero(r->L);
+  r->n = r->head = r->since = 0;
+  r->weighted = -1;
+}
+
+/* L of the rows in the ring, the oldest first, each scaled for its age */
+static void fit_rolling_refactor(mygsl_fit_rolling *r)
+{
+  size_t a, j, q = r->k + 1;
+  double s;
+  const double *x;
+  gsl_matrix_set_zero(r->L);
+  for (a = 0; a < r->n; a++) {
+    x = r->ring + ((r->head + a) % r->window)*q;
+    s = r->decay == 1.0 ? 1.0 : pow(r->decay, 0.5*(r->n - 1 - a));
+    for (j = 0; j < q; j++) gsl_vector_set(r->row, j, s*x[j]);
+    mygsl_linalg_cholesky_update(r->L, r->row);
+  }
+  r->since = 0;
+}
+
+/*
+  Adds the sample whose row sqrt(w)[x y] is in r->row, which is
+  overwritten.  A downdate that fails reports it by GSL_ERROR, which
+  the caller defers (fit_rolling_add); it is dropped here.
+*/
+static void fit_rolling_step(mygsl_fit_rolling *r)
+{
+  size_t j, q = r->k + 1;
+  double *slot;
+  int full = r->window > 0 && r->n == r->window;
+  if (r->decay != 1.0) gsl_matrix_scale(r->L, sqrt(r->decay));
+  if (r->window > 0) {
+    slot = r->ring + ((r->head + r->n) % r->window)*q;
+    if (full) {
+      for (j = 0; j < q; j++) gsl_vector_set(r->old, j, r->sdw*slot[j]);
+      r->head = (r->head + 1) % r->window;
+    } else {
+      r->n++;
+    }
+    for (j = 0; j < q; j++) slot[j] = gsl_vector_get(r->row, j);
+  } else {
+    r->n++;
+  }
+  mygsl_linalg_cholesky_update(r->L, r->row);
+  if (!full) return;
+  if (++r->since >= r->window
+      || mygsl_linalg_cholesky_downdate(r->L, r->old, r->work) != GSL_SUCCESS) {
+    rb_gsl_error_take();
+    fit_rolling_refactor(r);
+  }
+}
+
+/* The coefficients from L^T c = z, NaN while the system is singular */
+static void fit_rolling_coef(const mygsl_fit_rolling *r, double *c, size_t stride)
+{
+  size_t i, j, k = r->k;
+  double s, d;
+  for (i = k; i-- > 0;) {
+    d = gsl_matrix_get(r->L, i, i);
+    if (r->n < k || d == 0.0) {
+      for (j = 0; j < k; j++) c[j*stride] = GSL_NAN;
+      return;
+    }
+    s = gsl_matrix_get(r->L, k, i);
+    for (j = i + 1; j < k; j++) s -= gsl_matrix_get(r->L, j, i)*c[j*stride];
+    c[i*stride] = s/d;
+  }
+}
+
+/* Fills r->row with sqrt(w)[1 x y] */
+static void fit_rolling_row(mygsl_fit_rolling *r, const double *x, size_t stride, double y,
+			    double w)
+{
+  size_t j, o = r->intercept ? 1 : 0;
+  double sw = sqrt(w);
+  if (o) gsl_vector_set(r->row, 0, sw);
+  for (j = 0; j < r->p; j++) gsl_vector_set(r->row, o + j, sw*x[j*stride]);
+  gsl_vector_set(r->row, r->k, sw*y);
+}
+
+struct fit_rolling_task {
+  mygsl_fit_rolling *r;
+  const double *x, *y, *w;
+  size_t n, sxi, sxj, sy, sw;   /* x[i*sxi + j*sxj] */
+  gsl_matrix *out;
+};
+
+static int fit_rolling_run(void *data)
+{
+  struct fit_rolling_task *t = (struct fit_rolling_task *) data;
+  size_t i;
+  for (i = 0; i < t->n; i++) {
+    fit_rolling_row(t->r, t->x + i*t->sxi, t->sxj, t->y[i*t->sy], t->w ? t->w[i*t->sw] : 1.0);
+    fit_rolling_step(t->r);
+    if (t->out) fit_rolling_coef(t->r, t->out->data + i*t->out->tda, 1);
+  }
+  return GSL_SUCCESS;
+}
+
+static mygsl_fit_rolling* fit_rolling_get(VALUE obj)
+{
+  mygsl_fit_rolling *r = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_fit_rolling))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Fit::Rolling expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_fit_rolling, r);
+  return r;
+}
+
+/* Rolling.alloc(p, :window => w, :decay => d, :intercept => true) */
+static VALUE rb_gsl_fit_rolling_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_fit_rolling *r = NULL;
+  VALUE obj, vp, opts, v;
+  long p, window = 0;
+  double decay = 1.0;
+  int intercept = 1;
+  rb_scan_args(argc, argv, "11", &vp, &opts);
+  p = NUM2LONG(vp);
+  if (p < 0) rb_raise(rb_eArgError, "p must not be negative");
+  if (!NIL_P(opts)) {
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("window"))))) window = NUM2LONG(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("decay"))))) decay = NUM2DBL(v);
+    intercept = RTEST(rb_hash_lookup2(opts, ID2SYM(rb_intern("intercept")), Qtrue));
+  }
+  if (window < 0) rb_raise(rb_eArgError, "window must not be negative");
+  if (!(decay > 0.0 && decay <= 1.0)) rb_raise(rb_eArgError, "decay must be in (0, 1]");
+  if (p + intercept == 0) rb_raise(rb_eArgError, "no coefficient to fit");
+  obj = Data_Make_Struct(klass, mygsl_fit_rolling, 0, mygsl_fit_rolling_free, r);
+  r->p = p;
+  r->k = p + intercept;
+  r->intercept = intercept;
+  r->window = window;
+  r->decay = decay;
+  r->sdw = pow(decay, 0.5*window);
+  r->L = gsl_matrix_alloc(r->k + 1, r->k + 1);
+  r->row = gsl_vector_alloc(r->k + 1);
+  r->old = gsl_vector_alloc(r->k + 1);
+  r->work = gsl_vector_alloc(3*(r->k + 1));
+  if (window > 0) r->ring = ALLOC_N(double, window*(r->k + 1));
+  fit_rolling_reset(r);
+  return obj;
+}
+
+static void fit_rolling_weighting(mygsl_fit_rolling *r, int weighted)
+{
+  if (r->weighted >= 0 && r->weighted != weighted)
+    rb_raise(rb_eArgError, "weighted and unweighted samples in the same Rolling");
+  r->weighted = weighted;
+}
+
+/* Adds the n samples of (X, y[, w]) to r; the coefficients after each go
+   to out unless NULL */
+static void fit_rolling_add(mygsl_fit_rolling *r, int argc, VALUE *argv, gsl_matrix **out,
+			    VALUE *vout)
+{
+  struct fit_rolling_task t;
+  gsl_matrix *X;
+  size_t i, ny, nw;
+  double x0, y0, w0;
+  int token;
+  if (argc != 2 && argc != 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  memset(&t, 0, sizeof(t));
+  t.r = r;
+  if (MATRIX_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_matrix, X);
+    if (X->size2 != r->p)
+      rb_raise(rb_eArgError, "samples of %d regressors for %d", (int) X->size2, (int) r->p);
+    t.x = X->data;
+    t.n = X->size1;
+    t.sxi = X->tda;
+    t.sxj = 1;
+  } else if (VECTOR_P(argv[0])) {
+    t.x = get_vector_ptr(argv[0], &t.sxj, &t.n);
+    if (out) {
+      if (r->p != 1) rb_raise(rb_eArgError, "a Vector of samples for %d regressors", (int) r->p);
+      t.sxi = t.sxj;
+    } else {
+      if (t.n != r->p) rb_raise(rb_eArgError, "%d regressors for %d", (int) t.n, (int) r->p);
+      t.n = 1;
+    }
+  } else {
+    if (r->p != 1) rb_raise(rb_eTypeError, "a Vector of %d regressors expected", (int) r->p);
+    x0 = NUM2DBL(argv[0]);
+    t.x = &x0;
+    t.n = 1;
+  }
+  if (rb_obj_is_kind_of(argv[1], rb_cNumeric)) {
+    if (t.n != 1) rb_raise(rb_eArgError, "%d samples but one y", (int) t.n);
+    y0 = NUM2DBL(argv[1]);
+    t.y = &y0;
+    if (argc == 3) {
+      w0 = NUM2DBL(argv[2]);
+      t.w = &w0;
+    }
+  } else {
+    t.y = get_vector_ptr(argv[1], &t.sy, &ny);
+    if (ny != t.n) rb_raise(rb_eArgError, "%d samples but %d y", (int) t.n, (int) ny);
+    if (argc == 3) {
+      t.w = get_vector_ptr(argv[2], &t.sw, &nw);
+      if (nw != t.n) rb_raise(rb_eArgError, "%d samples but %d weights", (int) t.n, (int) nw);
+    }
+  }
+  if (t.w) {
+    for (i = 0; i < t.n; i++)
+      if (!(t.w[i*t.sw] >= 0.0)) rb_raise(rb_eArgError, "negative weight");
+  }
+  fit_rolling_weighting(r, t.w != NULL);
+  if (out) {
+    *out = t.out = gsl_matrix_alloc(t.n, r->k);
+    *vout = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, t.out);
+  }
+  /* the downdates which fail are dealt with by fit_rolling_step */
+  token = rb_gsl_error_defer_begin();
+  rb_gsl_nogvl_call(fit_rolling_run, &t, t.n*(r->k + 1)*(r->k + 1));
+  rb_gsl_error_take();
+  rb_gsl_error_defer_end(token);
+}
+
+/* add(x, y[, w]): one sample */
+static VALUE rb_gsl_fit_rolling_add(int argc, VALUE *argv, VALUE obj)
+{
+  fit_rolling_add(fit_rolling_get(obj), argc, argv, NULL, NULL);
+  return obj;
+}
+
+/* roll(X, y[, w]): the n samples, and the coefficients after each */
+static VALUE rb_gsl_fit_rolling_roll(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *out;
+  VALUE vout;
+  fit_rolling_add(fit_rolling_get(obj), argc, argv, &out, &vout);
+  return vout;
+}
+
+static VALUE rb_gsl_fit_rolling_coef(VALUE obj)
+{
+  mygsl_fit_rolling *r = fit_rolling_get(obj);
+  gsl_vector *c = gsl_vector_alloc(r->k);
+  fit_rolling_coef(r, c->data, c->stride);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, c);
+}
+
+/* (X^T W X)^-1 = L^-T L^-1, scaled by rss/(n - k) without weights */
+static VALUE rb_gsl_fit_rolling_cov(VALUE obj)
+{
+  mygsl_fit_rolling *r = fit_rolling_get(obj);
+  gsl_matrix_view Lxx = gsl_matrix_submatrix(r->L, 0, 0, r->k, r->k);
+  gsl_matrix *Li, *cov;
+  double rho = gsl_matrix_get(r->L, r->k, r->k);
+  size_t i;
+  for (i = 0; i < r->k; i++)
+    if (gsl_matrix_get(r->L, i, i) == 0.0 || r->n < r->k)
+      rb_raise(rb_eRuntimeError, "too few samples for %d coefficients", (int) r->k);
+  Li = gsl_matrix_alloc(r->k, r->k);
+  gsl_matrix_set_identity(Li);
+  gsl_blas_dtrsm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit, 1.0, &Lxx.matrix, Li);
+  cov = gsl_matrix_alloc(r->k, r->k);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans,
+		 r->weighted == 1 || r->n == r->k ? 1.0 : rho*rho/(r->n - r->k),
+		 Li, Li, 0.0, cov);
+  gsl_matrix_free(Li);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, cov);
+}
+
+static VALUE rb_gsl_fit_rolling_rss(VALUE obj)
+{
+  mygsl_fit_rolling *r = fit_rolling_get(obj);
+  double rho = gsl_matrix_get(r->L, r->k, r->k);
+  return rb_float_new(rho*rho);
+}
+
+static VALUE rb_gsl_fit_rolling_n(VALUE obj)
+{
+  return SIZET2NUM(fit_rolling_get(obj)->n);
+}
+
+static VALUE rb_gsl_fit_rolling_size(VALUE obj)
+{
+  return SIZET2NUM(fit_rolling_get(obj)->k);
+}
+
+static VALUE rb_gsl_fit_rolling_reset(VALUE obj)
+{
+  fit_rolling_reset(fit_rolling_get(obj));
+  return obj;
+}
+
+void Init_gsl_fit_rolling(VALUE mgsl_fit)
+{
+  cgsl_fit_rolling = rb_define_class_under(mgsl_fit, "Rolling", cGSL_Object);
+  rb_define_singleton_method(cgsl_fit_rolling, "alloc", rb_gsl_fit_rolling_alloc, -1);
+  rb_define_singleton_method(cgsl_fit_rolling, "new", rb_gsl_fit_rolling_alloc, -1);
+
+  rb_define_method(cgsl_fit_rolling, "add", rb_gsl_fit_rolling_add, -1);
+  rb_define_method(cgsl_fit_rolling, "roll", rb_gsl_fit_rolling_roll, -1);
+  rb_define_method(cgsl_fit_rolling, "coef", rb_gsl_fit_rolling_coef, 0);
+  rb_define_method(cgsl_fit_rolling, "cov", rb_gsl_fit_rolling_cov, 0);
+  rb_define_method(cgsl_fit_rolling, "rss", rb_gsl_fit_rolling_rss, 0);
+  rb_define_method(cgsl_fit_rolling, "n", rb_gsl_fit_rolling_n, 0);
+  rb_define_method(cgsl_fit_rolling, "size", rb_gsl_fit_rolling_size, 0);
+  rb_define_method(cgsl_fit_rolling, "reset", rb_gsl_fit_rolling_reset, 0);
+}
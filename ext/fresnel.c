@@ -270,34 +270,34 @@ double fresnel_s1(double x)
   return fresnel_s(x*sqrt_2_pi);
 }
 
-static VALUE rb_fresnel_c(VALUE obj, VALUE x)
+static VALUE rb_fresnel_c(int argc, VALUE *argv, VALUE obj)
 {
-	return rb_gsl_sf_eval1(fresnel_c, x);
+	return rb_gsl_sf_eval1_argv(fresnel_c, argc, argv);
 }
-static VALUE rb_fresnel_s(VALUE obj, VALUE x)
+static VALUE rb_fresnel_s(int argc, VALUE *argv, VALUE obj)
 {
-	return rb_gsl_sf_eval1(fresnel_s, x);
+	return rb_gsl_sf_eval1_argv(fresnel_s, argc, argv);
 }
-static VALUE rb_fresnel_c1(VALUE obj, VALUE x)
+static VALUE rb_fresnel_c1(int argc, VALUE *argv, VALUE obj)
 {
-	return rb_gsl_sf_eval1(fresnel_c1, x);
+	return rb_gsl_sf_eval1_argv(fresnel_c1, argc, argv);
 }
-static VALUE rb_fresnel_s1(VALUE obj, VALUE x)
+static VALUE rb_fresnel_s1(int argc, VALUE *argv, VALUE obj)
 {
-	return rb_gsl_sf_eval1(fresnel_s1, x);
+	return rb_gsl_sf_eval1_argv(fresnel_s1, argc, argv);
 }
 void Init_fresnel(VALUE module)
 {
 	VALUE mfresnel;
 	mfresnel = rb_define_module_under(module, "Fresnel");
-	rb_define_module_function(module, "fresnel_c", rb_fresnel_c, 1);
-	rb_define_module_function(module, "fresnel_s", rb_fresnel_s, 1);	
-	rb_define_module_function(module, "fresnel_c1", rb_fresnel_c1, 1);	
-	rb_define_module_function(module, "fresnel_s1", rb_fresnel_s1, 1);		
-	rb_define_module_function(mfresnel, "c", rb_fresnel_c, 1);
-	rb_define_module_function(mfresnel, "s", rb_fresnel_s, 1);	
-	rb_define_module_function(mfresnel, "c1", rb_fresnel_c1, 1);	
-	rb_define_module_function(mfresnel, "s1", rb_fresnel_s1, 1);	
+	rb_define_module_function(module, "fresnel_c", rb_fresnel_c, -1);
+	rb_define_module_function(module, "fresnel_s", rb_fresnel_s, -1);	
+	rb_define_module_function(module, "fresnel_c1", rb_fresnel_c1, -1);	
+	rb_define_module_function(module, "fresnel_s1", rb_fresnel_s1, -1);		
+	rb_define_module_function(mfresnel, "c", rb_fresnel_c, -1);
+	rb_define_module_function(mfresnel, "s", rb_fresnel_s, -1);	
+	rb_define_module_function(mfresnel, "c1", rb_fresnel_c1, -1);	
+	rb_define_module_function(mfresnel, "s1", rb_fresnel_s1, -1);	
 }
 
 
@@ -10,6 +10,8 @@
 */
 #include "rb_gsl_config.h"
 #include "rb_gsl_function.h"
+#include "rb_gsl_profiler.h"
+#include "rb_gsl_probes.h"
 #ifdef HAVE_NARRAY_H
 #include "narray.h"
 #endif
@@ -19,6 +21,7 @@ VALUE cgsl_function_fdf;
 
 void gsl_function_free(gsl_function *f);
 double rb_gsl_function_f(double x, void *p); 
+double rb_gsl_function_vectorized_f(double x, void *p);
 ID RBGSL_ID_call, RBGSL_ID_arity;
 
 static VALUE rb_gsl_function_set_f(int argc, VALUE *argv, VALUE obj)
@@ -87,17 +90,166 @@ static VALUE rb_gsl_function_alloc(int argc, VALUE *argv, VALUE klass)
   return obj;
 }			    
 
+/*
+ * GSL::Function.vectorized { |x, y| ... }
+ * Create a Function whose proc evaluates many points in one call.
+ */
+static VALUE rb_gsl_function_vectorized_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_function *F = NULL;
+  VALUE obj;
+  obj = rb_gsl_function_alloc(argc, argv, klass);
+  Data_Get_Struct(obj, gsl_function, F);
+  F->function = &rb_gsl_function_vectorized_f;
+  return obj;
+}
+
+static VALUE rb_gsl_function_is_vectorized(VALUE obj)
+{
+  gsl_function *F = NULL;
+  Data_Get_Struct(obj, gsl_function, F);
+  return rb_gsl_function_vectorized_p(F) ? Qtrue : Qfalse;
+}
+
 double rb_gsl_function_f(double x, void *p)
 {
   VALUE result, ary, proc, params;
   ary = (VALUE) p;
   proc = rb_ary_entry(ary, 0);
   params = rb_ary_entry(ary, 1);
-  if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x));
-  else result = rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params);
+  RB_GSL_CALLBACK_ENTRY("function", 1);
+  RB_GSL_PROF_CALLBACK(
+    if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x));
+    else result = rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params));
+  RB_GSL_CALLBACK_RETURN("function", 1);
   return NUM2DBL(result);
 }
 
+/*
+ * Vectorized functions: the proc is called once per set of points as
+ * proc.call(x, y) or proc.call(x, y, params), with x and y GSL::Vector
+ * objects of the same length; it fills y (or returns a new Vector).
+ */
+static void rb_gsl_function_vectorized_call(VALUE ary, const double *x, double *y,
+					    size_t n)
+{
+  gsl_vector *vx = NULL, *vy = NULL, *vr = NULL;
+  VALUE proc, params, ox, oy, result;
+  proc = rb_ary_entry(ary, 0);
+  params = rb_ary_entry(ary, 1);
+  vx = gsl_vector_alloc(n);
+  vy = gsl_vector_calloc(n);
+  memcpy(vx->data, x, sizeof(double)*n);
+  ox = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vx);
+  oy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vy);
+  RB_GSL_CALLBACK_ENTRY("function", n);
+  RB_GSL_PROF_CALLBACK(
+    if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 2, ox, oy);
+    else result = rb_funcall(proc, RBGSL_ID_call, 3, ox, oy, params));
+  RB_GSL_CALLBACK_RETURN("function", n);
+  if (result != oy && VECTOR_P(result)) {
+    Data_Get_Struct(result, gsl_vector, vr);
+    if (vr->size != n) 
+      rb_raise(rb_eRuntimeError, "vectorized function returned a vector of length %d (%d expected)",
+	       (int) vr->size, (int) n);
+    vy = vr;
+  }
+  if (vy->stride == 1) {
+    memcpy(y, vy->data, sizeof(double)*n);
+  } else {
+    gsl_vector_view yv = gsl_vector_view_array(y, n);
+    gsl_vector_memcpy(&yv.vector, vy);
+  }
+}
+
+double rb_gsl_function_vectorized_f(double x, void *p)
+{
+  double y;
+  rb_gsl_function_vectorized_call((VALUE) p, &x, &y, 1);
+  return y;
+}
+
+int rb_gsl_function_vectorized_p(const gsl_function *F)
+{
+  return F->function == &rb_gsl_function_vectorized_f;
+}
+
+/*
+ * y[i] = F(x[i]), i = 0...n. x and y can be the same array.
+ * Vectorized functions are called only once.
+ */
+void rb_gsl_function_eval_array(gsl_function *F, const double *x, double *y, size_t n)
+{
+  size_t i;
+  if (n == 0) return;
+  if (rb_gsl_function_vectorized_p(F)) {
+    rb_gsl_function_vectorized_call((VALUE) F->params, x, y, n);
+    return;
+  }
+  for (i = 0; i < n; i++) y[i] = GSL_FN_EVAL(F, x[i]);
+}
+
+/*
+ * Evaluation of a Function whose gsl_function is implemented in C
+ * (e.g. GSL::Function::Compiled) or vectorized: no Ruby call per point.
+ */
+static VALUE rb_gsl_function_eval_native(gsl_function *F, VALUE x)
+{
+  VALUE arynew;
+  gsl_vector *v = NULL, *vnew = NULL;
+  gsl_matrix *m = NULL, *mnew = NULL;
+  double *buf;
+  size_t i, n;
+#ifdef HAVE_NARRAY_H
+  struct NARRAY *na;
+#endif
+  if (CLASS_OF(x) == rb_cRange) x = rb_gsl_range2ary(x);
+  switch (TYPE(x)) {
+  case T_FIXNUM:
+  case T_BIGNUM:
+  case T_FLOAT:
+    return rb_float_new(GSL_FN_EVAL(F, NUM2DBL(x)));
+    break;
+  case T_ARRAY:
+    n = RARRAY_LEN(x);
+    buf = ALLOC_N(double, n);
+    for (i = 0; i < n; i++) buf[i] = NUM2DBL(rb_ary_entry(x, i));
+    rb_gsl_function_eval_array(F, buf, buf, n);
+    arynew = rb_ary_new2(n);
+    for (i = 0; i < n; i++) rb_ary_store(arynew, i, rb_float_new(buf[i]));
+    xfree(buf);
+    return arynew;
+    break;
+  default:
+#ifdef HAVE_NARRAY_H
+    if (NA_IsNArray(x)) {
+      x = na_change_type(x, NA_DFLOAT);
+      GetNArray(x, na);
+      arynew = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(x));
+      rb_gsl_function_eval_array(F, (double *) na->ptr, NA_PTR_TYPE(arynew, double*),
+				 na->total);
+      return arynew;
+    }
+#endif
+    if (VECTOR_P(x)) {
+      Data_Get_Struct(x, gsl_vector, v);
+      vnew = make_vector_clone(v);
+      rb_gsl_function_eval_array(F, vnew->data, vnew->data, vnew->size);
+      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
+    } else if (MATRIX_P(x)) {
+      Data_Get_Struct(x, gsl_matrix, m);
+      mnew = make_matrix_clone(m);
+      rb_gsl_function_eval_array(F, mnew->data, mnew->data, mnew->size1*mnew->size2);
+      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+    } else {
+      rb_raise(rb_eTypeError, "wrong argument type");
+    }
+    break;
+  }
+  /* never reach here */
+  return Qnil;
+}
+
 /*
  * Calculates a function at x, and returns the rusult.
  */
@@ -113,6 +265,7 @@ static VALUE rb_gsl_function_eval(VALUE obj, VALUE x)
   struct NARRAY *na;
 #endif
   Data_Get_Struct(obj, gsl_function, F);
+  if (F->function != &rb_gsl_function_f) return rb_gsl_function_eval_native(F, x);
   ary = (VALUE) F->params;
   proc = rb_ary_entry(ary, 0);
   params = rb_ary_entry(ary, 1);
@@ -231,13 +384,12 @@ static VALUE rb_gsl_function_graph(int argc, VALUE *argv, VALUE obj)
 {
 #ifdef HAVE_GNU_GRAPH
   gsl_function *F = NULL;
-  gsl_vector *v = NULL;
-  double x, y;
+  gsl_vector *v = NULL, *y = NULL;
   char opt[256] = "", command[1024];
   size_t i, n;
   int flag = 0;
-  FILE *fp = NULL;
-  VALUE ary, params, proc;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
   switch (argc) {
   case 2:
     Check_Type(argv[1], T_STRING);
@@ -267,23 +419,15 @@ static VALUE rb_gsl_function_graph(int argc, VALUE *argv, VALUE obj)
     break;
   }
   Data_Get_Struct(obj, gsl_function, F);
-  ary = (VALUE) F->params;
-  proc = rb_ary_entry(ary, 0);
-  params = rb_ary_entry(ary, 1);
   sprintf(command, "graph -T X -g 3 %s", opt);
-  fp = popen(command, "w");
-  if (fp == NULL)
-    rb_raise(rb_eIOError, "GNU graph not found.");
-  for (i = 0; i < n; i++) {
-    x = gsl_vector_get(v, i);
-    if (NIL_P(params)) y = NUM2DBL(rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x)));
-    else y = NUM2DBL(rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params));
-    fprintf(fp, "%e %e\n", x, y);
-  }
-  fflush(fp);
- pclose(fp);
-  fp = NULL;
+  y = make_vector_clone(v);
+  rb_gsl_function_eval_array(F, y->data, y->data, n);
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
+  for (i = 0; i < n; i++)
+    rb_gsl_pipe_point(fp, gsl_vector_get(v, i), y->data[i]);
+  gsl_vector_free(y);
   if (flag == 1) gsl_vector_free(v);
+  rb_gsl_pipe_send(pipe, command, "GNU graph");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "not implemented");
@@ -311,7 +455,12 @@ static void setfunc(int i, VALUE *argv, gsl_function_fdf *F)
     ary = (VALUE) F->params;
   }
 
-  if (rb_obj_is_kind_of(argv[i], rb_cProc)) {
+  if (rb_obj_is_kind_of(argv[i], rb_cProc)
+      || rb_obj_is_kind_of(argv[i], cgsl_function_compiled)) {
+    if (i > 1) CHECK_PROC(argv[i]);
+    if (!rb_obj_is_kind_of(argv[i], rb_cProc)
+	&& rb_gsl_function_compiled_dim(rb_gsl_function_compiled_ptr(argv[i])) != 0)
+      rb_raise(rb_eTypeError, "compiled function of x expected");
     rb_ary_store(ary, i, argv[i]);
   } else if (TYPE(argv[i]) == T_ARRAY || rb_obj_is_kind_of(argv[i], cgsl_vector) 
 	     || TYPE(argv[i]) == T_FIXNUM || TYPE(argv[i]) == T_FLOAT) {
@@ -433,25 +582,48 @@ static VALUE rb_gsl_function_fdf_set_params(int argc, VALUE *argv, VALUE obj)
   return obj;
 }
 
+/*
+  F->params is an Array [f, df, fdf, params]. f and df may be
+  GSL::Function::Compiled, evaluated in C; a compiled f without df is
+  differentiated exactly with dual numbers (see function_compile.c)
+*/
 static double rb_gsl_function_fdf_f(double x, void *p)
 {
   VALUE result, params, proc, ary;
   ary = (VALUE) p;
   proc = rb_ary_entry(ary, 0);
+  if (rb_obj_is_kind_of(proc, cgsl_function_compiled))
+    return rb_gsl_function_compiled_eval_multi(rb_gsl_function_compiled_ptr(proc), &x);
   params = rb_ary_entry(ary, 3);
-  if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x));
-  else result = rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params);
+  RB_GSL_CALLBACK_ENTRY("function", 1);
+  RB_GSL_PROF_CALLBACK(
+    if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x));
+    else result = rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params));
+  RB_GSL_CALLBACK_RETURN("function", 1);
   return NUM2DBL(result);
 }
 
 static double rb_gsl_function_fdf_df(double x, void *p)
 {
   VALUE result, params, proc, ary;
+  double df;
   ary = (VALUE) p;
   proc = rb_ary_entry(ary, 1);
+  if (NIL_P(proc)) {
+    proc = rb_ary_entry(ary, 0);
+    if (rb_obj_is_kind_of(proc, cgsl_function_compiled)) {
+      rb_gsl_function_compiled_eval_grad(rb_gsl_function_compiled_ptr(proc), &x, NULL, &df);
+      return df;
+    }
+  } else if (rb_obj_is_kind_of(proc, cgsl_function_compiled)) {
+    return rb_gsl_function_compiled_eval_multi(rb_gsl_function_compiled_ptr(proc), &x);
+  }
   params = rb_ary_entry(ary, 3);
-  if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x));
-  else result = rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params);
+  RB_GSL_CALLBACK_ENTRY("function", 1);
+  RB_GSL_PROF_CALLBACK(
+    if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 1, rb_float_new(x));
+    else result = rb_funcall(proc, RBGSL_ID_call, 2, rb_float_new(x), params));
+  RB_GSL_CALLBACK_RETURN("function", 1);
   return NUM2DBL(result);
 }
 
@@ -463,21 +635,38 @@ static void rb_gsl_function_fdf_fdf(double x, void *p, double *f, double *df)
   proc_df = rb_ary_entry(ary, 1);
   proc_fdf = rb_ary_entry(ary, 2);
   params = rb_ary_entry(ary, 3);
-  if (NIL_P(proc_fdf)) {
-    if (NIL_P(params)) {
-      result = rb_funcall(proc_f, RBGSL_ID_call, 1, rb_float_new(x));
+  if (NIL_P(proc_fdf) && NIL_P(proc_df)
+      && rb_obj_is_kind_of(proc_f, cgsl_function_compiled)) {
+    *f = rb_gsl_function_compiled_eval_grad(rb_gsl_function_compiled_ptr(proc_f), &x,
+					    NULL, df);
+  } else if (NIL_P(proc_fdf)) {
+    if (rb_obj_is_kind_of(proc_f, cgsl_function_compiled)
+	|| rb_obj_is_kind_of(proc_df, cgsl_function_compiled)) {
+      *f = rb_gsl_function_fdf_f(x, p);
+      *df = rb_gsl_function_fdf_df(x, p);
+    } else if (NIL_P(params)) {
+      RB_GSL_CALLBACK_ENTRY("function", 1);
+      RB_GSL_PROF_CALLBACK(result = rb_funcall(proc_f, RBGSL_ID_call, 1, rb_float_new(x)));
       *f = NUM2DBL(result);
-      result = rb_funcall(proc_df, RBGSL_ID_call, 1, rb_float_new(x));
+      RB_GSL_PROF_CALLBACK(result = rb_funcall(proc_df, RBGSL_ID_call, 1, rb_float_new(x)));
       *df = NUM2DBL(result);
+      RB_GSL_CALLBACK_RETURN("function", 1);
     } else {
-      result = rb_funcall(proc_f, RBGSL_ID_call, 2, rb_float_new(x), params);
+      RB_GSL_CALLBACK_ENTRY("function", 1);
+      RB_GSL_PROF_CALLBACK(result = rb_funcall(proc_f, RBGSL_ID_call, 2, rb_float_new(x),
+					       params));
       *f = NUM2DBL(result);
-      result = rb_funcall(proc_df, RBGSL_ID_call, 2, rb_float_new(x), params);
+      RB_GSL_PROF_CALLBACK(result = rb_funcall(proc_df, RBGSL_ID_call, 2, rb_float_new(x),
+					       params));
       *df = NUM2DBL(result);
+      RB_GSL_CALLBACK_RETURN("function", 1);
     }
   } else {
-    if (NIL_P(params)) result = rb_funcall(proc_fdf, RBGSL_ID_call, 1, rb_float_new(x));
-    else result = rb_funcall(proc_fdf, RBGSL_ID_call, 2, rb_float_new(x), params);
+    RB_GSL_CALLBACK_ENTRY("function", 1);
+    RB_GSL_PROF_CALLBACK(
+      if (NIL_P(params)) result = rb_funcall(proc_fdf, RBGSL_ID_call, 1, rb_float_new(x));
+      else result = rb_funcall(proc_fdf, RBGSL_ID_call, 2, rb_float_new(x), params));
+    RB_GSL_CALLBACK_RETURN("function", 1);
     *f = NUM2DBL(rb_ary_entry(result, 0));
     *df = NUM2DBL(rb_ary_entry(result, 1));
   }
@@ -496,6 +685,8 @@ void Init_gsl_function(VALUE module)
 
   /*  rb_define_singleton_method(cgsl_function, "new", rb_gsl_function_new, -1);*/
   rb_define_singleton_method(cgsl_function, "alloc", rb_gsl_function_alloc, -1);
+  rb_define_singleton_method(cgsl_function, "vectorized", rb_gsl_function_vectorized_new, -1);
+  rb_define_method(cgsl_function, "vectorized?", rb_gsl_function_is_vectorized, 0);
 
   rb_define_method(cgsl_function, "eval", rb_gsl_function_eval, 1);
   rb_define_alias(cgsl_function, "call", "eval");
@@ -513,6 +704,8 @@ void Init_gsl_function(VALUE module)
   rb_define_alias(cgsl_function, "param=", "set_params");
 
   rb_define_method(cgsl_function, "graph", rb_gsl_function_graph, -1);
+
+  Init_gsl_function_compile(module);
   /*****/
   rb_define_singleton_method(cgsl_function_fdf, "new", rb_gsl_function_fdf_new, -1);
   rb_define_singleton_method(cgsl_function_fdf, "alloc", rb_gsl_function_fdf_new, -1);
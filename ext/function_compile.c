@@ -0,0 +1,818 @@
+/*
+  function_compile.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Function::Compiled
+
+    f = GSL::Function.compile("x**2*sin(a*x)", "a" => 2.0)
+
+  The expression is translated once into a postfix program which is
+  run by a small stack machine, so evaluating the function from
+  integration, root finding or minimization does not call back into Ruby.
+
+  Functions of several variables (see GSL::Monte::Function.compile) are
+  compiled with dim > 0 and refer to their arguments as x[0], x[1], ...
+
+  The same program can be run on dual numbers, a value and its
+  derivatives with respect to x (or x[0] ... x[dim-1]) carried together
+  through every operation, which gives the exact derivative, or gradient,
+  in one pass (forward mode automatic differentiation):
+
+    f.eval_fdf(1.0)                      # => [f(1), f'(1)]
+    GSL::Root::FdfSolver.alloc("newton").set(f.fdf, 1.0)
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_function.h"
+#include <gsl/gsl_sf.h>
+
+VALUE cgsl_function_compiled;
+
+#define FEXPR_STACK_MAX 64
+#define FEXPR_PARAM_MAX 32
+#define FEXPR_NAME_MAX 32
+#define FEXPR_DUAL_MAX 1024  /* derivatives kept on the C stack */
+
+enum {
+  FEXPR_CONST,
+  FEXPR_X,
+  FEXPR_XI,
+  FEXPR_PARAM,
+  FEXPR_ADD,
+  FEXPR_SUB,
+  FEXPR_MUL,
+  FEXPR_DIV,
+  FEXPR_POW,
+  FEXPR_POWI,
+  FEXPR_NEG,
+  FEXPR_FUNC1,
+  FEXPR_FUNC2,
+};
+
+/* Derivatives: d1(x, f(x)) = f'(x), d2(a, b, f(a, b), &df/da, &df/db) */
+typedef double (*fexpr_d1)(double, double);
+typedef void (*fexpr_d2)(double, double, double, double *, double *);
+
+typedef struct {
+  int op;
+  int n;
+  double val;
+  double (*f1)(double);
+  double (*f2)(double, double);
+  fexpr_d1 d1;
+  fexpr_d2 d2;
+} fexpr_code;
+
+typedef struct {
+  gsl_function F;   /* must be the first member, see Data_Get_Struct() */
+  fexpr_code *code;
+  size_t ncode, nalloc;
+  size_t nparam;
+  size_t dim;       /* 0: function of x only */
+  size_t maxdepth;  /* of the stack */
+  char names[FEXPR_PARAM_MAX][FEXPR_NAME_MAX];
+  double param[FEXPR_PARAM_MAX];
+  VALUE expr;
+} rb_gsl_function_compiled;
+
+static double fexpr_abs(double x) { return fabs(x); }
+static double fexpr_sign(double x) { return GSL_SIGN(x); }
+static double fexpr_min(double x, double y) { return GSL_MIN(x, y); }
+static double fexpr_max(double x, double y) { return GSL_MAX(x, y); }
+static double fexpr_step(double x) { return x >= 0.0 ? 1.0 : 0.0; }
+
+static double fexpr_d_sin(double x, double f) { return cos(x); }
+static double fexpr_d_cos(double x, double f) { return -sin(x); }
+static double fexpr_d_tan(double x, double f) { return 1.0 + f*f; }
+static double fexpr_d_asin(double x, double f) { return 1.0/sqrt(1.0 - x*x); }
+static double fexpr_d_acos(double x, double f) { return -1.0/sqrt(1.0 - x*x); }
+static double fexpr_d_atan(double x, double f) { return 1.0/(1.0 + x*x); }
+static double fexpr_d_sinh(double x, double f) { return cosh(x); }
+static double fexpr_d_cosh(double x, double f) { return sinh(x); }
+static double fexpr_d_tanh(double x, double f) { return 1.0 - f*f; }
+static double fexpr_d_asinh(double x, double f) { return 1.0/sqrt(x*x + 1.0); }
+static double fexpr_d_acosh(double x, double f) { return 1.0/(sqrt(x - 1.0)*sqrt(x + 1.0)); }
+static double fexpr_d_atanh(double x, double f) { return 1.0/(1.0 - x*x); }
+static double fexpr_d_exp(double x, double f) { return f; }
+static double fexpr_d_expm1(double x, double f) { return f + 1.0; }
+static double fexpr_d_log(double x, double f) { return 1.0/x; }
+static double fexpr_d_log1p(double x, double f) { return 1.0/(1.0 + x); }
+static double fexpr_d_log10(double x, double f) { return 1.0/(M_LN10*x); }
+static double fexpr_d_sqrt(double x, double f) { return 0.5/f; }
+static double fexpr_d_abs(double x, double f) { return x == 0.0 ? 0.0 : GSL_SIGN(x); }
+static double fexpr_d_zero(double x, double f) { return 0.0; }
+static double fexpr_d_gamma(double x, double f) { return f*gsl_sf_psi(x); }
+static double fexpr_d_lngamma(double x, double f) { return gsl_sf_psi(x); }
+static double fexpr_d_erf(double x, double f) { return M_2_SQRTPI*exp(-x*x); }
+static double fexpr_d_erfc(double x, double f) { return -M_2_SQRTPI*exp(-x*x); }
+static double fexpr_d_J0(double x, double f) { return -gsl_sf_bessel_J1(x); }
+static double fexpr_d_J1(double x, double f)
+{
+  return x == 0.0 ? 0.5 : gsl_sf_bessel_J0(x) - f/x;
+}
+static double fexpr_d_Y0(double x, double f) { return -gsl_sf_bessel_Y1(x); }
+static double fexpr_d_Y1(double x, double f) { return gsl_sf_bessel_Y0(x) - f/x; }
+static double fexpr_d_I0(double x, double f) { return gsl_sf_bessel_I1(x); }
+static double fexpr_d_K0(double x, double f) { return -gsl_sf_bessel_K1(x); }
+static double fexpr_d_dilog(double x, double f)
+{
+  return x == 0.0 ? 1.0 : -log(fabs(1.0 - x))/x;
+}
+
+static void fexpr_d_atan2(double a, double b, double f, double *da, double *db)
+{
+  double r2 = a*a + b*b;
+  *da = b/r2;
+  *db = -a/r2;
+}
+static void fexpr_d_pow(double a, double b, double f, double *da, double *db)
+{
+  *da = b*pow(a, b - 1.0);
+  *db = f*log(a);
+}
+static void fexpr_d_hypot(double a, double b, double f, double *da, double *db)
+{
+  *da = f == 0.0 ? 0.0 : a/f;
+  *db = f == 0.0 ? 0.0 : b/f;
+}
+static void fexpr_d_min(double a, double b, double f, double *da, double *db)
+{
+  *da = a <= b ? 1.0 : 0.0;
+  *db = 1.0 - *da;
+}
+static void fexpr_d_max(double a, double b, double f, double *da, double *db)
+{
+  *da = a >= b ? 1.0 : 0.0;
+  *db = 1.0 - *da;
+}
+static void fexpr_d_beta(double a, double b, double f, double *da, double *db)
+{
+  double psi = gsl_sf_psi(a + b);
+  *da = f*(gsl_sf_psi(a) - psi);
+  *db = f*(gsl_sf_psi(b) - psi);
+}
+
+static const struct {
+  const char *name;
+  double (*f1)(double);
+  double (*f2)(double, double);
+  fexpr_d1 d1;
+  fexpr_d2 d2;
+} fexpr_functions[] = {
+  {"sin", sin, NULL, fexpr_d_sin, NULL},
+  {"cos", cos, NULL, fexpr_d_cos, NULL},
+  {"tan", tan, NULL, fexpr_d_tan, NULL},
+  {"asin", asin, NULL, fexpr_d_asin, NULL},
+  {"acos", acos, NULL, fexpr_d_acos, NULL},
+  {"atan", atan, NULL, fexpr_d_atan, NULL},
+  {"sinh", sinh, NULL, fexpr_d_sinh, NULL},
+  {"cosh", cosh, NULL, fexpr_d_cosh, NULL},
+  {"tanh", tanh, NULL, fexpr_d_tanh, NULL},
+  {"asinh", gsl_asinh, NULL, fexpr_d_asinh, NULL},
+  {"acosh", gsl_acosh, NULL, fexpr_d_acosh, NULL},
+  {"atanh", gsl_atanh, NULL, fexpr_d_atanh, NULL},
+  {"exp", exp, NULL, fexpr_d_exp, NULL},
+  {"expm1", gsl_expm1, NULL, fexpr_d_expm1, NULL},
+  {"log", log, NULL, fexpr_d_log, NULL},
+  {"log1p", gsl_log1p, NULL, fexpr_d_log1p, NULL},
+  {"log10", log10, NULL, fexpr_d_log10, NULL},
+  {"sqrt", sqrt, NULL, fexpr_d_sqrt, NULL},
+  {"abs", fexpr_abs, NULL, fexpr_d_abs, NULL},
+  {"sign", fexpr_sign, NULL, fexpr_d_zero, NULL},
+  {"step", fexpr_step, NULL, fexpr_d_zero, NULL},
+  {"floor", floor, NULL, fexpr_d_zero, NULL},
+  {"ceil", ceil, NULL, fexpr_d_zero, NULL},
+  {"gamma", gsl_sf_gamma, NULL, fexpr_d_gamma, NULL},
+  {"lngamma", gsl_sf_lngamma, NULL, fexpr_d_lngamma, NULL},
+  {"erf", gsl_sf_erf, NULL, fexpr_d_erf, NULL},
+  {"erfc", gsl_sf_erfc, NULL, fexpr_d_erfc, NULL},
+  {"bessel_J0", gsl_sf_bessel_J0, NULL, fexpr_d_J0, NULL},
+  {"bessel_J1", gsl_sf_bessel_J1, NULL, fexpr_d_J1, NULL},
+  {"bessel_Y0", gsl_sf_bessel_Y0, NULL, fexpr_d_Y0, NULL},
+  {"bessel_Y1", gsl_sf_bessel_Y1, NULL, fexpr_d_Y1, NULL},
+  {"bessel_I0", gsl_sf_bessel_I0, NULL, fexpr_d_I0, NULL},
+  {"bessel_K0", gsl_sf_bessel_K0, NULL, fexpr_d_K0, NULL},
+  {"dilog", gsl_sf_dilog, NULL, fexpr_d_dilog, NULL},
+  {"atan2", NULL, atan2, NULL, fexpr_d_atan2},
+  {"pow", NULL, pow, NULL, fexpr_d_pow},
+  {"hypot", NULL, gsl_hypot, NULL, fexpr_d_hypot},
+  {"min", NULL, fexpr_min, NULL, fexpr_d_min},
+  {"max", NULL, fexpr_max, NULL, fexpr_d_max},
+  {"beta", NULL, gsl_sf_beta, NULL, fexpr_d_beta},
+  {NULL, NULL, NULL, NULL, NULL}
+};
+
+/*****/
+
+typedef struct {
+  const char *src, *p;
+  rb_gsl_function_compiled *c;
+  int depth, maxdepth;
+} fexpr_parser;
+
+static void fexpr_error(fexpr_parser *ps, const char *msg)
+{
+  rb_raise(rb_eSyntaxError, "%s at column %d in \"%s\"", msg,
+	   (int) (ps->p - ps->src) + 1, ps->src);
+}
+
+static void fexpr_emit(fexpr_parser *ps, int op, double val, int n)
+{
+  rb_gsl_function_compiled *c = ps->c;
+  fexpr_code *code;
+  if (c->ncode == c->nalloc) {
+    c->nalloc = c->nalloc ? c->nalloc*2 : 16;
+    REALLOC_N(c->code, fexpr_code, c->nalloc);
+  }
+  code = &c->code[c->ncode++];
+  code->op = op;
+  code->val = val;
+  code->n = n;
+  code->f1 = NULL;
+  code->f2 = NULL;
+  code->d1 = NULL;
+  code->d2 = NULL;
+  switch (op) {
+  case FEXPR_CONST: case FEXPR_X: case FEXPR_XI: case FEXPR_PARAM:
+    ps->depth++;
+    if (ps->depth > ps->maxdepth) ps->maxdepth = ps->depth;
+    if (ps->depth > FEXPR_STACK_MAX) fexpr_error(ps, "expression too complex");
+    break;
+  case FEXPR_ADD: case FEXPR_SUB: case FEXPR_MUL: case FEXPR_DIV:
+  case FEXPR_POW: case FEXPR_FUNC2:
+    ps->depth--;
+    break;
+  default:
+    break;
+  }
+}
+
+static void fexpr_skip_space(fexpr_parser *ps)
+{
+  while (isspace((unsigned char) *ps->p)) ps->p++;
+}
+
+static void fexpr_expr(fexpr_parser *ps);
+static void fexpr_unary(fexpr_parser *ps);
+
+static int fexpr_param_index(rb_gsl_function_compiled *c, const char *name)
+{
+  size_t i;
+  for (i = 0; i < c->nparam; i++)
+    if (strcmp(c->names[i], name) == 0) return (int) i;
+  return -1;
+}
+
+static void fexpr_call(fexpr_parser *ps, const char *name)
+{
+  size_t i;
+  int nargs = 0;
+  for (i = 0; fexpr_functions[i].name; i++) {
+    if (strcmp(fexpr_functions[i].name, name) == 0) break;
+  }
+  if (fexpr_functions[i].name == NULL
+      || (fexpr_functions[i].f1 == NULL && fexpr_functions[i].f2 == NULL))
+    fexpr_error(ps, "unknown function");
+  ps->p++;  /* '(' */
+  fexpr_skip_space(ps);
+  if (*ps->p != ')') {
+    for (;;) {
+      fexpr_expr(ps);
+      nargs++;
+      fexpr_skip_space(ps);
+      if (*ps->p != ',') break;
+      ps->p++;
+    }
+  }
+  if (*ps->p != ')') fexpr_error(ps, "')' expected");
+  ps->p++;
+  if (fexpr_functions[i].f1) {
+    if (nargs != 1) fexpr_error(ps, "wrong number of arguments (1 expected)");
+    fexpr_emit(ps, FEXPR_FUNC1, 0.0, 0);
+    ps->c->code[ps->c->ncode-1].f1 = fexpr_functions[i].f1;
+    ps->c->code[ps->c->ncode-1].d1 = fexpr_functions[i].d1;
+  } else {
+    if (nargs != 2) fexpr_error(ps, "wrong number of arguments (2 expected)");
+    fexpr_emit(ps, FEXPR_FUNC2, 0.0, 0);
+    ps->c->code[ps->c->ncode-1].f2 = fexpr_functions[i].f2;
+    ps->c->code[ps->c->ncode-1].d2 = fexpr_functions[i].d2;
+  }
+}
+
+static void fexpr_primary(fexpr_parser *ps)
+{
+  char name[FEXPR_NAME_MAX], *end;
+  size_t len;
+  int idx;
+  double val;
+  fexpr_skip_space(ps);
+  if (*ps->p == '(') {
+    ps->p++;
+    fexpr_expr(ps);
+    fexpr_skip_space(ps);
+    if (*ps->p != ')') fexpr_error(ps, "')' expected");
+    ps->p++;
+  } else if (isdigit((unsigned char) *ps->p) || *ps->p == '.') {
+    val = strtod(ps->p, &end);
+    if (end == ps->p) fexpr_error(ps, "invalid number");
+    ps->p = end;
+    fexpr_emit(ps, FEXPR_CONST, val, 0);
+  } else if (isalpha((unsigned char) *ps->p) || *ps->p == '_') {
+    len = 0;
+    while (isalnum((unsigned char) *ps->p) || *ps->p == '_') {
+      if (len == FEXPR_NAME_MAX-1) fexpr_error(ps, "name too long");
+      name[len++] = *ps->p++;
+    }
+    name[len] = '\0';
+    fexpr_skip_space(ps);
+    if (*ps->p == '(') {
+      fexpr_call(ps, name);
+    } else if (strcmp(name, "x") == 0 && *ps->p == '[') {
+      if (ps->c->dim == 0) fexpr_error(ps, "x is not a vector");
+      ps->p++;
+      fexpr_skip_space(ps);
+      if (!isdigit((unsigned char) *ps->p)) fexpr_error(ps, "index expected");
+      idx = (int) strtol(ps->p, &end, 10);
+      ps->p = end;
+      fexpr_skip_space(ps);
+      if (*ps->p != ']') fexpr_error(ps, "']' expected");
+      if ((size_t) idx >= ps->c->dim) fexpr_error(ps, "index out of range");
+      ps->p++;
+      fexpr_emit(ps, FEXPR_XI, 0.0, idx);
+    } else if (strcmp(name, "x") == 0) {
+      fexpr_emit(ps, FEXPR_X, 0.0, 0);
+    } else if ((idx = fexpr_param_index(ps->c, name)) >= 0) {
+      fexpr_emit(ps, FEXPR_PARAM, 0.0, idx);
+    } else if (strcmp(name, "pi") == 0 || strcmp(name, "PI") == 0) {
+      fexpr_emit(ps, FEXPR_CONST, M_PI, 0);
+    } else if (strcmp(name, "e") == 0 || strcmp(name, "E") == 0) {
+      fexpr_emit(ps, FEXPR_CONST, M_E, 0);
+    } else {
+      fexpr_error(ps, "unknown variable");
+    }
+  } else {
+    fexpr_error(ps, "unexpected character");
+  }
+}
+
+/* power := primary ('**' | '^') unary, right associative */
+static void fexpr_power(fexpr_parser *ps)
+{
+  fexpr_code *last;
+  fexpr_primary(ps);
+  fexpr_skip_space(ps);
+  if (*ps->p == '^' || (ps->p[0] == '*' && ps->p[1] == '*')) {
+    ps->p += (*ps->p == '^') ? 1 : 2;
+    fexpr_unary(ps);
+    last = &ps->c->code[ps->c->ncode-1];
+    /* x**n with a small integer constant n: use gsl_pow_int() */
+    if (last->op == FEXPR_CONST && last->val == floor(last->val)
+	&& fabs(last->val) <= 64) {
+      last->op = FEXPR_POWI;
+      last->n = (int) last->val;
+      ps->depth--;
+    } else {
+      fexpr_emit(ps, FEXPR_POW, 0.0, 0);
+    }
+  }
+}
+
+static void fexpr_unary(fexpr_parser *ps)
+{
+  fexpr_skip_space(ps);
+  if (*ps->p == '-') {
+    ps->p++;
+    fexpr_unary(ps);
+    fexpr_emit(ps, FEXPR_NEG, 0.0, 0);
+  } else if (*ps->p == '+') {
+    ps->p++;
+    fexpr_unary(ps);
+  } else {
+    fexpr_power(ps);
+  }
+}
+
+static void fexpr_term(fexpr_parser *ps)
+{
+  char op;
+  fexpr_unary(ps);
+  for (;;) {
+    fexpr_skip_space(ps);
+    op = *ps->p;
+    if (op != '*' && op != '/') break;
+    ps->p++;
+    fexpr_unary(ps);
+    fexpr_emit(ps, op == '*' ? FEXPR_MUL : FEXPR_DIV, 0.0, 0);
+  }
+}
+
+static void fexpr_expr(fexpr_parser *ps)
+{
+  char op;
+  fexpr_term(ps);
+  for (;;) {
+    fexpr_skip_space(ps);
+    op = *ps->p;
+    if (op != '+' && op != '-') break;
+    ps->p++;
+    fexpr_term(ps);
+    fexpr_emit(ps, op == '+' ? FEXPR_ADD : FEXPR_SUB, 0.0, 0);
+  }
+}
+
+/*****/
+
+static double fexpr_run_params(const rb_gsl_function_compiled *c, const double *x,
+			       const double *param)
+{
+  double stack[FEXPR_STACK_MAX];
+  const fexpr_code *code = c->code, *end = c->code + c->ncode;
+  int sp = -1;
+  for (; code < end; code++) {
+    switch (code->op) {
+    case FEXPR_CONST: stack[++sp] = code->val; break;
+    case FEXPR_X: stack[++sp] = x[0]; break;
+    case FEXPR_XI: stack[++sp] = x[code->n]; break;
+    case FEXPR_PARAM: stack[++sp] = param[code->n]; break;
+    case FEXPR_ADD: sp--; stack[sp] += stack[sp+1]; break;
+    case FEXPR_SUB: sp--; stack[sp] -= stack[sp+1]; break;
+    case FEXPR_MUL: sp--; stack[sp] *= stack[sp+1]; break;
+    case FEXPR_DIV: sp--; stack[sp] /= stack[sp+1]; break;
+    case FEXPR_POW: sp--; stack[sp] = pow(stack[sp], stack[sp+1]); break;
+    case FEXPR_POWI: stack[sp] = gsl_pow_int(stack[sp], code->n); break;
+    case FEXPR_NEG: stack[sp] = -stack[sp]; break;
+    case FEXPR_FUNC1: stack[sp] = (*code->f1)(stack[sp]); break;
+    case FEXPR_FUNC2: sp--; stack[sp] = (*code->f2)(stack[sp], stack[sp+1]); break;
+    }
+  }
+  return stack[0];
+}
+
+static double fexpr_run(const rb_gsl_function_compiled *c, const double *x)
+{
+  return fexpr_run_params(c, x, c->param);
+}
+
+/*
+  Dual numbers: each stack entry carries its nd derivatives in dv, with
+  nd = dim (1 for a function of x only). The derivatives of constant
+  operands are skipped, so that sqrt(0), pow(-1, 2) ... do not spoil the
+  result with 0*inf.
+*/
+static void fexpr_dual1(double *da, double d, size_t nd)
+{
+  size_t k;
+  for (k = 0; k < nd; k++) if (da[k] != 0.0) da[k] *= d;
+}
+
+static void fexpr_dual2(double *da, const double *db, double pa, double pb, size_t nd)
+{
+  size_t k;
+  double t;
+  for (k = 0; k < nd; k++) {
+    t = da[k] != 0.0 ? pa*da[k] : 0.0;
+    if (db[k] != 0.0) t += pb*db[k];
+    da[k] = t;
+  }
+}
+
+static double fexpr_run_dual(const rb_gsl_function_compiled *c, const double *x,
+			     const double *param, double *grad)
+{
+  double stack[FEXPR_STACK_MAX], buf[FEXPR_DUAL_MAX], *dv, *da, *db;
+  double a, b, f, pa, pb;
+  const fexpr_code *code = c->code, *end = c->code + c->ncode;
+  size_t nd = c->dim ? c->dim : 1, k;
+  int sp = -1;
+  if (c->maxdepth*nd <= FEXPR_DUAL_MAX) {
+    dv = buf;
+  } else if ((dv = (double *) malloc(sizeof(double)*c->maxdepth*nd)) == NULL) {
+    for (k = 0; k < nd; k++) grad[k] = GSL_NAN;
+    return GSL_NAN;
+  }
+  for (; code < end; code++) {
+    switch (code->op) {
+    case FEXPR_CONST: case FEXPR_X: case FEXPR_XI: case FEXPR_PARAM:
+      sp++;
+      da = dv + sp*nd;
+      memset(da, 0, sizeof(double)*nd);
+      switch (code->op) {
+      case FEXPR_CONST: stack[sp] = code->val; break;
+      case FEXPR_X: stack[sp] = x[0]; da[0] = 1.0; break;
+      case FEXPR_XI: stack[sp] = x[code->n]; da[code->n] = 1.0; break;
+      default: stack[sp] = param[code->n]; break;
+      }
+      break;
+    case FEXPR_NEG:
+      stack[sp] = -stack[sp];
+      da = dv + sp*nd;
+      for (k = 0; k < nd; k++) da[k] = -da[k];
+      break;
+    case FEXPR_POWI:
+      a = stack[sp];
+      stack[sp] = gsl_pow_int(a, code->n);
+      fexpr_dual1(dv + sp*nd, code->n == 0 ? 0.0 : code->n*gsl_pow_int(a, code->n - 1), nd);
+      break;
+    case FEXPR_FUNC1:
+      a = stack[sp];
+      stack[sp] = f = (*code->f1)(a);
+      fexpr_dual1(dv + sp*nd, (*code->d1)(a, f), nd);
+      break;
+    default:
+      /* binary operators */
+      sp--;
+      a = stack[sp];
+      b = stack[sp+1];
+      da = dv + sp*nd;
+      db = da + nd;
+      switch (code->op) {
+      case FEXPR_ADD:
+	stack[sp] = a + b;
+	for (k = 0; k < nd; k++) da[k] += db[k];
+	break;
+      case FEXPR_SUB:
+	stack[sp] = a - b;
+	for (k = 0; k < nd; k++) da[k] -= db[k];
+	break;
+      case FEXPR_MUL:
+	stack[sp] = a*b;
+	for (k = 0; k < nd; k++) da[k] = da[k]*b + a*db[k];
+	break;
+      case FEXPR_DIV:
+	stack[sp] = f = a/b;
+	for (k = 0; k < nd; k++) da[k] = (da[k] - f*db[k])/b;
+	break;
+      case FEXPR_POW:
+	stack[sp] = f = pow(a, b);
+	fexpr_d_pow(a, b, f, &pa, &pb);
+	fexpr_dual2(da, db, pa, pb, nd);
+	break;
+      case FEXPR_FUNC2:
+	stack[sp] = f = (*code->f2)(a, b);
+	(*code->d2)(a, b, f, &pa, &pb);
+	fexpr_dual2(da, db, pa, pb, nd);
+	break;
+      }
+      break;
+    }
+  }
+  memcpy(grad, dv, sizeof(double)*nd);
+  if (dv != buf) free(dv);
+  return stack[0];
+}
+
+static double rb_gsl_function_compiled_f(double x, void *p)
+{
+  return fexpr_run((const rb_gsl_function_compiled *) p, &x);
+}
+
+/* Evaluates a function compiled with dim > 0; thread safe */
+double rb_gsl_function_compiled_eval_multi(void *p, const double *x)
+{
+  return fexpr_run((const rb_gsl_function_compiled *) p, x);
+}
+
+/* Evaluates with the values param[0 ... nparam-1] of the parameters, in
+   the order they were given to compile, in place of those of the
+   function; thread safe */
+double rb_gsl_function_compiled_eval_params(void *p, const double *x, const double *param)
+{
+  return fexpr_run_params((const rb_gsl_function_compiled *) p, x, param);
+}
+
+/* Returns f(x) and sets grad[0 ... dim-1] (grad[0] if dim is 0) to its
+   derivatives with respect to x; param may be NULL, else as for
+   rb_gsl_function_compiled_eval_params(); thread safe */
+double rb_gsl_function_compiled_eval_grad(void *p, const double *x, const double *param,
+					  double *grad)
+{
+  const rb_gsl_function_compiled *c = (const rb_gsl_function_compiled *) p;
+  return fexpr_run_dual(c, x, param ? param : c->param, grad);
+}
+
+size_t rb_gsl_function_compiled_nparam(void *p)
+{
+  return ((const rb_gsl_function_compiled *) p)->nparam;
+}
+
+size_t rb_gsl_function_compiled_dim(void *p)
+{
+  return ((const rb_gsl_function_compiled *) p)->dim;
+}
+
+/* Copies the values of the parameters into param[0 ... nparam-1] */
+void rb_gsl_function_compiled_get_params(void *p, double *param)
+{
+  const rb_gsl_function_compiled *c = (const rb_gsl_function_compiled *) p;
+  memcpy(param, c->param, sizeof(double)*c->nparam);
+}
+
+static void rb_gsl_function_compiled_mark(rb_gsl_function_compiled *c)
+{
+  rb_gc_mark(c->expr);
+}
+
+static void rb_gsl_function_compiled_free(rb_gsl_function_compiled *c)
+{
+  if (c == NULL) return;
+  if (c->code) xfree(c->code);
+  xfree(c);
+}
+
+static int fexpr_set_param_i(VALUE key, VALUE val, VALUE obj)
+{
+  rb_gsl_function_compiled *c = NULL;
+  VALUE name;
+  int idx;
+  Data_Get_Struct(obj, rb_gsl_function_compiled, c);
+  name = rb_obj_as_string(key);
+  idx = fexpr_param_index(c, RSTRING_PTR(name));
+  if (idx < 0)
+    rb_raise(rb_eArgError, "unknown parameter %s", RSTRING_PTR(name));
+  c->param[idx] = NUM2DBL(val);
+  return ST_CONTINUE;
+}
+
+static int fexpr_add_param_i(VALUE key, VALUE val, VALUE obj)
+{
+  rb_gsl_function_compiled *c = NULL;
+  VALUE name;
+  Data_Get_Struct(obj, rb_gsl_function_compiled, c);
+  name = rb_obj_as_string(key);
+  if (c->nparam == FEXPR_PARAM_MAX)
+    rb_raise(rb_eArgError, "too many parameters (max %d)", FEXPR_PARAM_MAX);
+  if (RSTRING_LEN(name) == 0 || RSTRING_LEN(name) >= FEXPR_NAME_MAX)
+    rb_raise(rb_eArgError, "invalid parameter name %s", RSTRING_PTR(name));
+  if (strcmp(RSTRING_PTR(name), "x") == 0)
+    rb_raise(rb_eArgError, "x is the function variable");
+  strcpy(c->names[c->nparam], RSTRING_PTR(name));
+  c->param[c->nparam] = NUM2DBL(val);
+  c->nparam++;
+  return ST_CONTINUE;
+}
+
+/*
+ * GSL::Function.compile(expr, params = {})
+ *
+ * Compiles expr, an arithmetic expression of x and the parameters
+ * given as a Hash of name => value, into a GSL::Function::Compiled.
+ * Available are + - * / ** (or ^), unary minus, the constants pi and e,
+ * and the functions sin cos tan asin acos atan sinh cosh tanh asinh
+ * acosh atanh exp expm1 log log1p log10 sqrt abs sign step floor ceil
+ * gamma lngamma erf erfc bessel_J0 bessel_J1 bessel_Y0 bessel_Y1
+ * bessel_I0 bessel_K0 dilog atan2 pow hypot min max beta.
+ */
+static VALUE rb_gsl_function_compile(int argc, VALUE *argv, VALUE klass)
+{
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  return rb_gsl_function_compile_multi(argv[0], argc == 2 ? argv[1] : Qnil, 0);
+}
+
+/*
+  Compiles expr with the parameters of the Hash params. If dim > 0, the
+  expression may use x[0] ... x[dim-1] and is evaluated with
+  rb_gsl_function_compiled_eval_multi().
+*/
+VALUE rb_gsl_function_compile_multi(VALUE vexpr, VALUE params, size_t dim)
+{
+  rb_gsl_function_compiled *c = NULL;
+  fexpr_parser ps;
+  VALUE obj, expr;
+  expr = rb_str_new4(StringValue(vexpr));
+  c = ALLOC(rb_gsl_function_compiled);
+  memset(c, 0, sizeof(rb_gsl_function_compiled));
+  c->F.function = &rb_gsl_function_compiled_f;
+  c->F.params = (void *) c;
+  c->dim = dim;
+  c->expr = expr;
+  obj = Data_Wrap_Struct(cgsl_function_compiled, rb_gsl_function_compiled_mark,
+			 rb_gsl_function_compiled_free, c);
+  if (!NIL_P(params)) {
+    Check_Type(params, T_HASH);
+    rb_hash_foreach(params, fexpr_add_param_i, obj);
+  }
+  ps.src = ps.p = RSTRING_PTR(expr);
+  ps.c = c;
+  ps.depth = ps.maxdepth = 0;
+  fexpr_expr(&ps);
+  fexpr_skip_space(&ps);
+  if (*ps.p != '\0') fexpr_error(&ps, "unexpected character");
+  c->maxdepth = ps.maxdepth;
+  return obj;
+}
+
+void* rb_gsl_function_compiled_ptr(VALUE obj)
+{
+  rb_gsl_function_compiled *c = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_function_compiled))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Function::Compiled expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, rb_gsl_function_compiled, c);
+  return (void *) c;
+}
+
+static VALUE rb_gsl_function_compiled_params(VALUE obj)
+{
+  rb_gsl_function_compiled *c = NULL;
+  VALUE hash;
+  size_t i;
+  Data_Get_Struct(obj, rb_gsl_function_compiled, c);
+  hash = rb_hash_new();
+  for (i = 0; i < c->nparam; i++)
+    rb_hash_aset(hash, rb_str_new2(c->names[i]), rb_float_new(c->param[i]));
+  return hash;
+}
+
+static VALUE rb_gsl_function_compiled_set_params(VALUE obj, VALUE hash)
+{
+  Check_Type(hash, T_HASH);
+  rb_hash_foreach(hash, fexpr_set_param_i, obj);
+  return obj;
+}
+
+static VALUE rb_gsl_function_compiled_expression(VALUE obj)
+{
+  rb_gsl_function_compiled *c = NULL;
+  Data_Get_Struct(obj, rb_gsl_function_compiled, c);
+  return c->expr;
+}
+
+static VALUE rb_gsl_function_compiled_arity(VALUE obj)
+{
+  return INT2FIX(1);
+}
+
+static VALUE rb_gsl_function_compiled_proc(VALUE obj)
+{
+  return Qnil;
+}
+
+/*
+  Compiled#eval_fdf(x): [f(x), f'(x)], the derivative evaluated exactly;
+  for dim > 0, x is an Array of dim numbers and the gradient an Array
+*/
+static VALUE rb_gsl_function_compiled_eval_fdf(VALUE obj, VALUE vx)
+{
+  rb_gsl_function_compiled *c = NULL;
+  double x[2], *xp, *grad, f;
+  VALUE vgrad, vtmp;
+  size_t i, nd;
+  Data_Get_Struct(obj, rb_gsl_function_compiled, c);
+  if (c->dim == 0) {
+    x[0] = NUM2DBL(vx);
+    f = fexpr_run_dual(c, x, c->param, x + 1);
+    return rb_ary_new3(2, rb_float_new(f), rb_float_new(x[1]));
+  }
+  Check_Type(vx, T_ARRAY);
+  nd = c->dim;
+  if ((size_t) RARRAY_LEN(vx) != nd)
+    rb_raise(rb_eArgError, "%d values of x (%d expected)", (int) RARRAY_LEN(vx), (int) nd);
+  xp = ALLOCV_N(double, vtmp, 2*nd);
+  for (i = 0; i < nd; i++) xp[i] = NUM2DBL(rb_ary_entry(vx, i));
+  grad = xp + nd;
+  f = fexpr_run_dual(c, xp, c->param, grad);
+  vgrad = rb_ary_new2(nd);
+  for (i = 0; i < nd; i++) rb_ary_store(vgrad, i, rb_float_new(grad[i]));
+  ALLOCV_END(vtmp);
+  return rb_ary_new3(2, rb_float_new(f), vgrad);
+}
+
+/* Compiled#fdf: a GSL::Function_fdf evaluating f and f' in C */
+static VALUE rb_gsl_function_compiled_fdf(VALUE obj)
+{
+  return rb_funcall(cgsl_function_fdf, rb_intern("alloc"), 1, obj);
+}
+
+void Init_gsl_function_compile(VALUE module)
+{
+  cgsl_function_compiled = rb_define_class_under(cgsl_function, "Compiled",
+						 cgsl_function);
+  rb_define_singleton_method(cgsl_function, "compile", rb_gsl_function_compile, -1);
+  rb_undef_alloc_func(cgsl_function_compiled);
+  rb_undef_method(CLASS_OF(cgsl_function_compiled), "alloc");
+  rb_undef_method(CLASS_OF(cgsl_function_compiled), "compile");
+  rb_undef_method(CLASS_OF(cgsl_function_compiled), "vectorized");
+
+  rb_define_method(cgsl_function_compiled, "params", rb_gsl_function_compiled_params, 0);
+  rb_define_alias(cgsl_function_compiled, "param", "params");
+  rb_define_method(cgsl_function_compiled, "set_params", rb_gsl_function_compiled_set_params, 1);
+  rb_define_alias(cgsl_function_compiled, "set_param", "set_params");
+  rb_define_alias(cgsl_function_compiled, "params=", "set_params");
+  rb_define_alias(cgsl_function_compiled, "param=", "set_params");
+  rb_define_method(cgsl_function_compiled, "expression", rb_gsl_function_compiled_expression, 0);
+  rb_define_alias(cgsl_function_compiled, "to_s", "expression");
+  rb_define_method(cgsl_function_compiled, "arity", rb_gsl_function_compiled_arity, 0);
+  rb_define_method(cgsl_function_compiled, "proc", rb_gsl_function_compiled_proc, 0);
+  rb_define_alias(cgsl_function_compiled, "f", "proc");
+  rb_define_method(cgsl_function_compiled, "eval_fdf", rb_gsl_function_compiled_eval_fdf, 1);
+  rb_define_method(cgsl_function_compiled, "fdf", rb_gsl_function_compiled_fdf, 0);
+  rb_undef_method(cgsl_function_compiled, "set");
+}
@@ -0,0 +1,90 @@
+/*
+  future.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL.async(*args) { |*args| ... } runs the block in a thread of its own
+  and returns at once a GSL::Future, that thread, whose value is the
+  value of the block:
+
+    f = GSL.async(m) { |a| GSL::Eigen.symmv(a) }
+    ...                    # runs on meanwhile
+    eval, evec = f.value   # or f.wait(0.1), f.done?
+
+  The decompositions, eigensolvers, FFTs and fits release the GVL for
+  operands of at least GSL.nogvl_threshold elements, and their parallel
+  parts run on GSL::ThreadPool, so that the caller keeps the GVL while
+  the kernel runs.  Future#value and #wait wait as Thread#join does:
+  under a fiber scheduler (Fiber.set_scheduler) through its block and
+  unblock hooks, only the waiting fiber being suspended.  An exception
+  of the block is raised again by #value instead of being reported when
+  the thread ends.
+*/
+
+#include "rb_gsl.h"
+
+static VALUE cgsl_future;
+static ID id_join, id_status, id_alive;
+
+/* GSL.async(*args) { |*args| ... } */
+static VALUE rb_gsl_async(int argc, VALUE *argv, VALUE module)
+{
+  VALUE th;
+  th = rb_funcall_with_block(cgsl_future, rb_intern("new"), argc, argv, rb_block_proc());
+  rb_funcall(th, rb_intern("report_on_exception="), 1, Qfalse);
+  return th;
+}
+
+struct future_join {
+  VALUE th, timeout;
+};
+
+static VALUE future_join(VALUE data)
+{
+  struct future_join *j = (struct future_join *) data;
+  return rb_funcall(j->th, id_join, 1, j->timeout);
+}
+
+/* Future#wait(timeout = nil): true once the block has returned or
+   raised, false if it still runs after timeout seconds */
+static VALUE rb_gsl_future_wait(int argc, VALUE *argv, VALUE obj)
+{
+  struct future_join j;
+  VALUE r;
+  int state = 0;
+  rb_check_arity(argc, 0, 1);
+  j.th = obj;
+  j.timeout = argc == 1 ? argv[0] : Qnil;
+  r = rb_protect(future_join, (VALUE) &j, &state);
+  if (state) {
+    /* An exception of the block is left to #value, one raised in the
+       waiting thread is not */
+    if (!NIL_P(rb_funcall(obj, id_status, 0))) rb_jump_tag(state);
+    rb_set_errinfo(Qnil);
+    return Qtrue;
+  }
+  return NIL_P(r) ? Qfalse : Qtrue;
+}
+
+static VALUE rb_gsl_future_done(VALUE obj)
+{
+  return RTEST(rb_funcall(obj, id_alive, 0)) ? Qfalse : Qtrue;
+}
+
+void Init_gsl_future(VALUE module)
+{
+  id_join = rb_intern("join");
+  id_status = rb_intern("status");
+  id_alive = rb_intern("alive?");
+
+  cgsl_future = rb_define_class_under(module, "Future", rb_cThread);
+  rb_define_module_function(module, "async", rb_gsl_async, -1);
+  rb_define_method(cgsl_future, "wait", rb_gsl_future_wait, -1);
+  rb_define_method(cgsl_future, "done?", rb_gsl_future_done, 0);
+}
@@ -1209,8 +1209,9 @@ static VALUE rb_gsl_graph_graph(int argc, VALUE *argv, VALUE obj)
   gsl_graph *g = NULL;
   gsl_histogram *h = NULL;
   gsl_vector *x = NULL, *y = NULL;
-  size_t i, size;
-  FILE *fp;
+  size_t i, k, m, size, *idx;
+  rb_gsl_pipe *fp;
+  VALUE pipe;
   char command[1024];
   Data_Get_Struct(obj, gsl_graph, g);
 
@@ -1255,19 +1256,23 @@ static VALUE rb_gsl_graph_graph(int argc, VALUE *argv, VALUE obj)
   if (h) size = h->n;
   else size = x->size;
 
-  fp = popen(command, "w");
-  if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
-  for (i = 0; i < size; i++) {
-    if (h) 
-      fprintf(fp, "%g %g\n%g %g\n", h->range[i], h->bin[i], h->range[i+1], h->bin[i]);
-    else if (y == NULL) 
-      fprintf(fp, "%d %g\n", (int) i, gsl_vector_get(x, i));
-    else
-      fprintf(fp, "%g %g\n", gsl_vector_get(x, i), gsl_vector_get(y, i));
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
+  if (h) {
+    for (i = 0; i < size; i++) {
+      rb_gsl_pipe_point(fp, h->range[i], h->bin[i]);
+      rb_gsl_pipe_point(fp, h->range[i+1], h->bin[i]);
+    }
+  } else {
+    if (y == NULL) idx = rb_gsl_plot_decimate(NULL, 1, x->data, x->stride, size, &m);
+    else idx = rb_gsl_plot_decimate(x->data, x->stride, y->data, y->stride, size, &m);
+    for (k = 0; k < m; k++) {
+      i = idx ? idx[k] : k;
+      if (y == NULL) rb_gsl_pipe_point(fp, (double) i, gsl_vector_get(x, i));
+      else rb_gsl_pipe_point(fp, gsl_vector_get(x, i), gsl_vector_get(y, i));
+    }
+    if (idx) xfree(idx);
   }
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  rb_gsl_pipe_send(pipe, command, "GNU graph");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "GNU plotutils required");
@@ -1281,7 +1286,8 @@ static VALUE rb_gsl_graph_step(int argc, VALUE *argv, VALUE obj)
   gsl_graph *g = NULL;
   gsl_vector *x = NULL, *y = NULL;
   size_t i, size;
-  FILE *fp;
+  rb_gsl_pipe *fp;
+  VALUE pipe;
   char command[1024];
   Data_Get_Struct(obj, gsl_graph, g);
 
@@ -1323,24 +1329,21 @@ static VALUE rb_gsl_graph_step(int argc, VALUE *argv, VALUE obj)
 
   size = x->size;
 
-  fp = popen(command, "w");
-  if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
   for (i = 0; i < size; i++) {
     if (y == NULL) {
-      fprintf(fp, "%d %g\n%d %g\n", (int) i, gsl_vector_get(x, i),
-	      (int) (i+1), gsl_vector_get(x, i));
+      rb_gsl_pipe_point(fp, (double) i, gsl_vector_get(x, i));
+      rb_gsl_pipe_point(fp, (double) (i+1), gsl_vector_get(x, i));
     } else {
+      rb_gsl_pipe_point(fp, gsl_vector_get(x, i), gsl_vector_get(y, i));
       if (i != size-1)
-	fprintf(fp, "%g %g\n%g %g\n", gsl_vector_get(x, i), gsl_vector_get(y, i),
-		gsl_vector_get(x, i+1), gsl_vector_get(y, i));
-      else 	
-	fprintf(fp, "%g %g\n%g %g", gsl_vector_get(x, i), gsl_vector_get(y, i),
-		2.0*gsl_vector_get(x, i)-gsl_vector_get(x, i-1), gsl_vector_get(y, i));
+	rb_gsl_pipe_point(fp, gsl_vector_get(x, i+1), gsl_vector_get(y, i));
+      else
+	rb_gsl_pipe_point(fp, 2.0*gsl_vector_get(x, i)-gsl_vector_get(x, i-1),
+			  gsl_vector_get(y, i));
     }
   }
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  rb_gsl_pipe_send(pipe, command, "GNU graph");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "GNU plotutils required");
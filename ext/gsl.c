@@ -11,13 +11,27 @@
 
 #include "rb_gsl.h"
 #include <gsl/gsl_machine.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 static ID rb_gsl_id_name, rb_gsl_id_size;
 VALUE cGSL_Object;
 static void rb_gsl_define_intern(VALUE module);
 static void rb_gsl_define_const(VALUE module);
+static VALUE rb_gsl_have_numo(VALUE module)
+{
+#ifdef HAVE_NUMO_NARRAY_H
+  return Qtrue;
+#else
+  return Qfalse;
+#endif
+}
+
 static void rb_gsl_define_methods(VALUE module);
+static void rb_gsl_define_subsystems(VALUE module);
+static VALUE rb_gsl_load_subsystems(int argc, VALUE *argv, VALUE module);
 
 static VALUE rb_gsl_object_inspect(VALUE obj)
 {
@@ -69,6 +83,17 @@ void Init_rb_gsl()
   VALUE mgsl;
 
   mgsl = rb_define_module("GSL");
+
+  /*
+    The methods defined between rb_ext_ractor_safe(true) and (false)
+    may be called from any Ractor: they share nothing between Ractors
+    but process-wide settings such as GSL.parallel_threads, their caches
+    and workspace pools being per thread, the error handler and the
+    default random number generator per Ractor.
+  */
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
   cGSL_Object = rb_define_class_under(mgsl, "Object", rb_cObject);
   rb_define_method(cGSL_Object, "inspect", rb_gsl_object_inspect, 0);
   rb_define_method(cGSL_Object, "info", rb_gsl_object_info, 0);
@@ -78,13 +103,21 @@ void Init_rb_gsl()
   rb_define_method(cGSL_Object, "dup", rb_gsl_not_implemeted, 0);
 
   rb_gsl_define_intern(mgsl);
+  rb_gsl_define_subsystems(mgsl);
 
   Init_gsl_error(mgsl);
+  Init_gsl_profiler(mgsl);
+  Init_gsl_thread_pool(mgsl);
+  Init_gsl_future(mgsl);
 
   Init_gsl_math(mgsl);
   Init_gsl_complex(mgsl);
 
+  Init_gsl_coerce(mgsl);
   Init_gsl_array(mgsl);
+  Init_gsl_memory(mgsl);
+  Init_gsl_typetag(mgsl);  /* after the Vector, Matrix and Complex classes */
+  Init_gsl_compress(mgsl);
 
   Init_gsl_blas(mgsl);
 
@@ -95,17 +128,25 @@ void Init_rb_gsl()
   Init_gsl_poly2(mgsl);
   Init_gsl_rational(mgsl);
 
-  Init_gsl_sf(mgsl);
-
   Init_gsl_linalg(mgsl); /*  Init_gsl_linalg_complex() is called in Init_gsl_linalg() */
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  Init_gsl_spmatrix(mgsl);
+#endif
+  Init_gsl_cqp_workspace(mgsl);
 
   Init_gsl_eigen(mgsl);
 
   Init_gsl_fft(mgsl);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
     Init_gsl_signal(mgsl);
   Init_gsl_function(mgsl);
   Init_gsl_integration(mgsl);
 
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
   Init_gsl_rng(mgsl);
   Init_gsl_qrng(mgsl);
   Init_gsl_ran(mgsl);
@@ -113,17 +154,30 @@ void Init_rb_gsl()
   Init_gsl_cdf(mgsl);
 #endif
   Init_gsl_stats(mgsl);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
 
   Init_gsl_histogram(mgsl);
   Init_gsl_histogram2d(mgsl);
   Init_gsl_histogram3d(mgsl);
+  Init_gsl_kde(mgsl);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
+  Init_gsl_marshal(mgsl);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
   Init_gsl_ntuple(mgsl);
-  Init_gsl_monte(mgsl);
-  Init_gsl_siman(mgsl);
 
   Init_gsl_odeiv(mgsl);
   Init_gsl_interp(mgsl);
   Init_gsl_spline(mgsl);
+  Init_gsl_seal(mgsl);  /* after the Histogram and Spline classes */
+#ifdef HAVE_GSL_GSL_INTERP2D_H
+  Init_gsl_interp2d(mgsl);
+#endif
   Init_gsl_diff(mgsl);
 #ifdef GSL_1_4_9_LATER
   Init_gsl_deriv(mgsl);
@@ -131,7 +185,6 @@ void Init_rb_gsl()
 
   Init_gsl_cheb(mgsl);
   Init_gsl_sum(mgsl);
-  Init_gsl_dht(mgsl);
 
   Init_gsl_root(mgsl);
   Init_gsl_multiroot(mgsl);
@@ -140,8 +193,6 @@ void Init_rb_gsl()
   Init_gsl_fit(mgsl);
   Init_gsl_multifit(mgsl);
 
-  Init_gsl_const(mgsl);
-
   Init_gsl_ieee(mgsl);
 
 #ifdef HAVE_NMATRIX_H
@@ -151,8 +202,17 @@ void Init_rb_gsl()
   Init_gsl_narray(mgsl);
 # endif
 #endif
+#ifdef HAVE_NUMO_NARRAY_H
+  Init_gsl_numo(mgsl);
+#endif
 
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
   Init_wavelet(mgsl);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
 
   rb_gsl_define_const(mgsl);
 
@@ -160,8 +220,16 @@ void Init_rb_gsl()
   Init_tensor_init(mgsl);
   Init_tensor_int_init(mgsl);
 #endif
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
+  Init_gsl_npy(mgsl);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
 
-  Init_gsl_graph(mgsl);
+  Init_gsl_plot_pipe(mgsl);
+  Init_gsl_downsample(mgsl);
   Init_gsl_dirac(mgsl);
 
 #ifdef HAVE_TAMU_ANOVA_TAMU_ANOVA_H
@@ -176,6 +244,10 @@ void Init_rb_gsl()
 	Init_jacobi(mgsl);
 #endif
 
+#ifdef HAVE_HDF5_H
+  Init_gsl_hdf5(mgsl);
+#endif
+
 #ifdef HAVE_GSL_GSL_CQP_H
 	Init_cqp(mgsl);
 #endif
@@ -191,12 +263,17 @@ void Init_rb_gsl()
 #endif
 
 	Init_geometry(mgsl);
+	Init_gsl_small(mgsl);
 
 #ifdef GSL_1_14_LATER
 	Init_multiset(mgsl);
 #endif
 
   rb_gsl_define_methods(mgsl);
+
+  /* GSL::Sf, GSL::Monte, ... are defined on first use, see below */
+  if (getenv("RB_GSL_EAGER") && strcmp(getenv("RB_GSL_EAGER"), "0") != 0)
+    rb_gsl_load_subsystems(0, NULL, mgsl);
 }
 
 /**********/
@@ -291,4 +368,154 @@ static void rb_gsl_define_methods(VALUE module)
   rb_define_singleton_method(module, "have_tensor?", rb_gsl_have_tensor, 0);
   rb_define_singleton_method(module, "have_narray?", rb_gsl_have_narray, 0);
   rb_define_singleton_method(module, "have_nmatrix?", rb_gsl_have_narray, 0);
+  rb_define_singleton_method(module, "have_numo?", rb_gsl_have_numo, 0);
+}
+
+/**********/
+
+/*
+  Subsystems defined on first use.  GSL::Sf, GSL::CONST, GSL::Monte,
+  GSL::Siman, GSL::Dht and GSL::Graph make up a quarter of the methods
+  and constants of the library, and a script seldom needs them all:
+  Init_rb_gsl only registers them, and the first reference to one of
+  the constants, GSL::Sf or Sf within a module including GSL, runs its
+  Init function.  Only the constant itself is hidden until then, so
+  defined?(GSL::Sf) and GSL.const_defined?(:Sf) are false before its
+  first use: GSL.load_subsystems, or RB_GSL_EAGER=1 in the environment,
+  defines them all at once.
+
+  The Init functions are run under a lock, as the reference may come
+  from any Ractor, and those of the ractor safe subsystems with
+  rb_ext_ractor_safe(true) as in Init_rb_gsl.  They take their parent
+  module as an argument and look nothing up in GSL, which lets the
+  subsystem be built aside and set in GSL only when it is complete.
+*/
+typedef struct {
+  const char *name;
+  void (*init)(VALUE);
+  int ractor_safe;
+  volatile int loaded;
+} rb_gsl_subsystem_t;
+
+static rb_gsl_subsystem_t rb_gsl_subsystems[] = {
+  { "Sf", Init_gsl_sf, 1, 0 },
+  { "Monte", Init_gsl_monte, 0, 0 },
+  { "Siman", Init_gsl_siman, 0, 0 },
+  { "Dht", Init_gsl_dht, 1, 0 },
+  { "CONST", Init_gsl_const, 0, 0 },
+  { "Graph", Init_gsl_graph, 0, 0 },
+  { NULL, NULL, 0, 0 }
+};
+
+static VALUE mgsl_subsystem_loader;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t rb_gsl_subsystem_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static rb_gsl_subsystem_t* rb_gsl_subsystem_find(VALUE name)
+{
+  rb_gsl_subsystem_t *s;
+  const char *str;
+  str = SYMBOL_P(name) ? rb_id2name(SYM2ID(name)) : StringValueCStr(name);
+  for (s = rb_gsl_subsystems; s->name; s++)
+    if (strcmp(s->name, str) == 0) return s;
+  return NULL;
+}
+
+static VALUE rb_gsl_subsystem_init(VALUE data)
+{
+  rb_gsl_subsystem_t *s = (rb_gsl_subsystem_t *) data;
+  VALUE stage;
+  ID id;
+  if (s->loaded) return Qnil;
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  if (s->ractor_safe) rb_ext_ractor_safe(true);
+#endif
+  /* Defined under a module of its own first, and set in GSL complete:
+     the other Ractors would else see GSL::Sf without its methods */
+  stage = rb_module_new();
+  (*s->init)(stage);
+  id = rb_intern(s->name);
+  rb_const_set(rb_path2class("GSL"), id, rb_const_get_at(stage, id));
+  s->loaded = 1;
+  return Qnil;
+}
+
+static VALUE rb_gsl_subsystem_unlock(VALUE data)
+{
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&rb_gsl_subsystem_lock);
+#endif
+  return Qnil;
+}
+
+static void rb_gsl_subsystem_load(rb_gsl_subsystem_t *s)
+{
+  if (s->loaded) return;
+#ifdef HAVE_PTHREAD_H
+  /* Not blocking with the GVL held: the thread running the Init
+     function may be another one of this Ractor */
+  while (pthread_mutex_trylock(&rb_gsl_subsystem_lock) != 0) rb_thread_schedule();
+#endif
+  rb_ensure(rb_gsl_subsystem_init, (VALUE) s, rb_gsl_subsystem_unlock, (VALUE) s);
+}
+
+/* const_missing of GSL and of the modules including it */
+static VALUE rb_gsl_subsystem_const_missing(VALUE module, VALUE name)
+{
+  rb_gsl_subsystem_t *s;
+  VALUE mgsl;
+  s = rb_gsl_subsystem_find(name);
+  if (s == NULL) return rb_call_super(1, &name);
+  rb_gsl_subsystem_load(s);
+  mgsl = rb_path2class("GSL");
+  return rb_const_get_at(mgsl, SYM2ID(name));
+}
+
+static VALUE rb_gsl_subsystem_included(VALUE module, VALUE base)
+{
+  rb_extend_object(base, mgsl_subsystem_loader);
+  return Qnil;
+}
+
+/* GSL.subsystems: {"Sf" => defined?, ...} */
+static VALUE rb_gsl_subsystems_status(VALUE module)
+{
+  rb_gsl_subsystem_t *s;
+  VALUE h = rb_hash_new();
+  for (s = rb_gsl_subsystems; s->name; s++)
+    rb_hash_aset(h, rb_str_new2(s->name), s->loaded ? Qtrue : Qfalse);
+  return h;
+}
+
+/* GSL.load_subsystems(*names): all of them without names */
+static VALUE rb_gsl_load_subsystems(int argc, VALUE *argv, VALUE module)
+{
+  rb_gsl_subsystem_t *s;
+  int i;
+  if (argc == 0) {
+    for (s = rb_gsl_subsystems; s->name; s++) rb_gsl_subsystem_load(s);
+    return module;
+  }
+  for (i = 0; i < argc; i++) {
+    if ((s = rb_gsl_subsystem_find(argv[i])) == NULL)
+      rb_raise(rb_eArgError, "unknown subsystem %s", RSTRING_PTR(rb_inspect(argv[i])));
+    rb_gsl_subsystem_load(s);
+  }
+  return module;
+}
+
+static void rb_gsl_define_subsystems(VALUE module)
+{
+  mgsl_subsystem_loader = rb_module_new();
+  rb_gc_register_mark_object(mgsl_subsystem_loader);
+  rb_define_method(mgsl_subsystem_loader, "const_missing", rb_gsl_subsystem_const_missing, 1);
+  rb_define_singleton_method(module, "included", rb_gsl_subsystem_included, 1);
+  rb_define_singleton_method(module, "subsystems", rb_gsl_subsystems_status, 0);
+  rb_define_singleton_method(module, "load_subsystems", rb_gsl_load_subsystems, -1);
+  rb_extend_object(module, mgsl_subsystem_loader);
 }
@@ -127,10 +127,190 @@ extern VALUE rb_nvector_dense_create(nm_dtype_t dtype, void* elements, size_t le
 
 extern VALUE nm_eDataTypeError, nm_eStorageTypeError;
 
+/*
+  Views.  GSL::Matrix.nm_view (and the Vector, Complex forms) wrap the
+  dense storage of an NMatrix, slices included, as a GSL view without
+  copying: the view points at the NMatrix elements with the storage
+  stride as tda, and keeps the NMatrix alive.  #to_nm on such a view
+  returns that NMatrix, so a round trip through GSL::Linalg copies
+  nothing.
+*/
+
+typedef struct {
+  union {
+    gsl_vector vector;
+    gsl_matrix matrix;
+    gsl_vector_complex vector_complex;
+    gsl_matrix_complex matrix_complex;
+  } v;
+  union {
+    gsl_block block;
+    gsl_block_complex block_complex;
+  } b;
+  VALUE owner;
+} nm_view;
+
+struct nm_layout {
+  char *ptr;
+  size_t size1, size2, tda;
+};
+
+static void nm_view_mark(nm_view *p)
+{
+  rb_gc_mark(p->owner);
+}
+
+/* The NMatrix a view made by nm_view was taken from, or Qnil */
+static VALUE nm_view_owner(VALUE obj)
+{
+  if (RDATA(obj)->dmark != (RUBY_DATA_FUNC) nm_view_mark) return Qnil;
+  return ((nm_view*) DATA_PTR(obj))->owner;
+}
+
+/* First element, shape and row stride (in elements) of a dense rank-2
+   NMatrix of the given dtype with contiguous rows */
+static void nm_get_layout(VALUE nm, nm_dtype_t dtype, size_t esize,
+			  struct nm_layout *l)
+{
+  DENSE_STORAGE *s;
+  if (!rb_obj_is_kind_of(nm, cNMatrix))
+    rb_raise(rb_eTypeError, "wrong argument type %s (NMatrix expected)",
+	     rb_class2name(CLASS_OF(nm)));
+  if (NM_STYPE(nm) != NM_DENSE_STORE)
+    rb_raise(nm_eStorageTypeError, "requires dense storage for a GSL view");
+  s = NM_DENSE_STORAGE(nm);
+  if (s->dtype != dtype)
+    rb_raise(nm_eDataTypeError, "wrong dtype for a GSL view");
+  if (s->rank != 2)
+    rb_raise(rb_eArgError, "rank %d NMatrix (2 expected)", (int) s->rank);
+  if (s->shape[0] == 0 || s->shape[1] == 0)
+    rb_raise(rb_eArgError, "empty NMatrix");
+  if (s->stride[1] != 1 && s->shape[1] > 1)
+    rb_raise(rb_eArgError, "rows of the NMatrix are not contiguous");
+  l->size1 = s->shape[0];
+  l->size2 = s->shape[1];
+  l->tda = s->shape[0] > 1 ? s->stride[0] : s->shape[1];
+  l->ptr = (char*) s->elements + (s->offset[0]*s->stride[0] + s->offset[1]*s->stride[1])*esize;
+}
+
+static nm_view* nm_view_alloc(VALUE owner)
+{
+  nm_view *p = (nm_view*) malloc(sizeof(nm_view));
+  if (p == NULL) rb_raise(rb_eNoMemError, "malloc failed");
+  p->owner = owner;
+  return p;
+}
+
+static VALUE rb_gsl_nm_to_gsl_matrix_view(VALUE obj, VALUE nm)
+{
+  struct nm_layout l;
+  nm_view *p;
+  nm_get_layout(nm, NM_FLOAT64, sizeof(double), &l);
+  p = nm_view_alloc(nm);
+  p->v.matrix.size1 = l.size1;
+  p->v.matrix.size2 = l.size2;
+  p->v.matrix.tda = l.tda;
+  p->v.matrix.data = (double*) l.ptr;
+  p->b.block.size = (l.size1 - 1)*l.tda + l.size2;
+  p->b.block.data = (double*) l.ptr;
+  p->v.matrix.block = &p->b.block;
+  p->v.matrix.owner = 0;
+  return Data_Wrap_Struct(cgsl_matrix_view, nm_view_mark, free, &p->v.matrix);
+}
+
+static VALUE rb_gsl_nm_to_gsl_matrix_complex_view(VALUE obj, VALUE nm)
+{
+  struct nm_layout l;
+  nm_view *p;
+  nm_get_layout(nm, NM_COMPLEX128, 2*sizeof(double), &l);
+  p = nm_view_alloc(nm);
+  p->v.matrix_complex.size1 = l.size1;
+  p->v.matrix_complex.size2 = l.size2;
+  p->v.matrix_complex.tda = l.tda;
+  p->v.matrix_complex.data = (double*) l.ptr;
+  p->b.block_complex.size = (l.size1 - 1)*l.tda + l.size2;
+  p->b.block_complex.data = (double*) l.ptr;
+  p->v.matrix_complex.block = &p->b.block_complex;
+  p->v.matrix_complex.owner = 0;
+  return Data_Wrap_Struct(cgsl_matrix_complex_view, nm_view_mark, free,
+			  &p->v.matrix_complex);
+}
+
+/* A row (1 x n) or column (n x 1) NMatrix as a vector view */
+static void nm_vector_layout(VALUE nv, nm_dtype_t dtype, size_t esize,
+			     size_t *size, size_t *stride, char **ptr)
+{
+  struct nm_layout l;
+  DENSE_STORAGE *s;
+  if (rb_obj_is_kind_of(nv, cNMatrix) && NM_STYPE(nv) == NM_DENSE_STORE
+      && NM_RANK(nv) == 2 && NM_SHAPE1(nv) == 1 && NM_SHAPE0(nv) > 1) {
+    s = NM_DENSE_STORAGE(nv);
+    if (s->dtype != dtype) rb_raise(nm_eDataTypeError, "wrong dtype for a GSL view");
+    *size = s->shape[0];
+    *stride = s->stride[0];
+    *ptr = (char*) s->elements + (s->offset[0]*s->stride[0] + s->offset[1]*s->stride[1])*esize;
+    return;
+  }
+  nm_get_layout(nv, dtype, esize, &l);
+  if (l.size1 != 1) rb_raise(rb_eArgError, "NMatrix is not a row or column vector");
+  *size = l.size2;
+  *stride = 1;
+  *ptr = l.ptr;
+}
+
+static VALUE rb_gsl_nv_to_gsl_vector_view(VALUE obj, VALUE nv)
+{
+  nm_view *p;
+  size_t size, stride;
+  char *ptr;
+  nm_vector_layout(nv, NM_FLOAT64, sizeof(double), &size, &stride, &ptr);
+  p = nm_view_alloc(nv);
+  p->v.vector.size = size;
+  p->v.vector.stride = stride;
+  p->v.vector.data = (double*) ptr;
+  p->b.block.size = (size - 1)*stride + 1;
+  p->b.block.data = (double*) ptr;
+  p->v.vector.block = &p->b.block;
+  p->v.vector.owner = 0;
+  return Data_Wrap_Struct(cgsl_vector_view, nm_view_mark, free, &p->v.vector);
+}
+
+static VALUE rb_gsl_nv_to_gsl_vector_complex_view(VALUE obj, VALUE nv)
+{
+  nm_view *p;
+  size_t size, stride;
+  char *ptr;
+  nm_vector_layout(nv, NM_COMPLEX128, 2*sizeof(double), &size, &stride, &ptr);
+  p = nm_view_alloc(nv);
+  p->v.vector_complex.size = size;
+  p->v.vector_complex.stride = stride;
+  p->v.vector_complex.data = (double*) ptr;
+  p->b.block_complex.size = (size - 1)*stride + 1;
+  p->b.block_complex.data = (double*) ptr;
+  p->v.vector_complex.block = &p->b.block_complex;
+  p->v.vector_complex.owner = 0;
+  return Data_Wrap_Struct(cgsl_vector_complex_view, nm_view_mark, free,
+			  &p->v.vector_complex);
+}
+
+/* NMatrix#gsl_view */
+static VALUE rb_gsl_nm_gsl_view(VALUE nm)
+{
+  int cplx = NM_DTYPE(nm) == NM_COMPLEX128;
+  if (NM_RANK(nm) == 2 && (NM_SHAPE0(nm) == 1 || NM_SHAPE1(nm) == 1)) {
+    return cplx ? rb_gsl_nv_to_gsl_vector_complex_view(cgsl_vector_complex, nm)
+      : rb_gsl_nv_to_gsl_vector_view(cgsl_vector, nm);
+  }
+  return cplx ? rb_gsl_nm_to_gsl_matrix_complex_view(cgsl_matrix_complex, nm)
+    : rb_gsl_nm_to_gsl_matrix_view(cgsl_matrix, nm);
+}
+
 /* GSL::Vector -> NMatrix */
 
 static VALUE rb_gsl_vector_to_nvector(VALUE obj, VALUE klass) {
   gsl_vector *v = NULL;
+  VALUE owner = nm_view_owner(obj);
+  if (!NIL_P(owner)) return owner;
   Data_Get_Struct(obj, gsl_vector, v);
 
   return rb_nvector_dense_create(NM_FLOAT64, v->data, v->size);
@@ -155,6 +335,8 @@ static VALUE rb_gsl_vector_int_to_nvector(VALUE obj, VALUE klass) {
 
 static VALUE rb_gsl_matrix_to_nmatrix(VALUE obj, VALUE klass) {
   gsl_matrix *m = NULL;
+  VALUE owner = nm_view_owner(obj);
+  if (!NIL_P(owner)) return owner;
   Data_Get_Struct(obj, gsl_matrix, m);
 
   return rb_nmatrix_dense_create(NM_FLOAT64, &(m->size1), 2, m->data, m->size1 * m->size2);
@@ -163,6 +345,8 @@ static VALUE rb_gsl_matrix_to_nmatrix(VALUE obj, VALUE klass) {
 
 static VALUE rb_gsl_matrix_complex_to_nmatrix(VALUE obj, VALUE klass) {
   gsl_matrix *m = NULL;
+  VALUE owner = nm_view_owner(obj);
+  if (!NIL_P(owner)) return owner;
   Data_Get_Struct(obj, gsl_matrix, m);
 
   return rb_nmatrix_dense_create(NM_COMPLEX128, &(m->size1), 2, m->data, m->size1 * m->size2);
@@ -331,6 +515,14 @@ void Init_gsl_nmatrix(VALUE module) {
 
   rb_define_method(cNMatrix, "to_gslv",    rb_gsl_nv_to_gsl_vector_method, 0);
   rb_define_alias(cNMatrix, "to_gv", "to_gslv");
+
+  rb_define_singleton_method(cgsl_vector, "nv_view", rb_gsl_nv_to_gsl_vector_view, 1);
+  rb_define_singleton_method(cgsl_vector_complex, "nv_view",
+			     rb_gsl_nv_to_gsl_vector_complex_view, 1);
+  rb_define_singleton_method(cgsl_matrix, "nm_view", rb_gsl_nm_to_gsl_matrix_view, 1);
+  rb_define_singleton_method(cgsl_matrix_complex, "nm_view",
+			     rb_gsl_nm_to_gsl_matrix_complex_view, 1);
+  rb_define_method(cNMatrix, "gsl_view", rb_gsl_nm_gsl_view, 0);
 }
 
 //#endif // HAVE_NMATRIX_H
@@ -0,0 +1,399 @@
+/*
+  gsl_numo.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Numo::NArray bridge.  Both directions share the data instead of
+  copying it whenever the layout allows:
+
+    v = GSL::Vector.from_numo(na)       # view of a 1-D Numo::DFloat
+    m = GSL::Matrix.from_numo(na)       # view of a 2-D Numo::DFloat
+    z = GSL::Vector::Complex.from_numo(nz)
+    x = GSL::Matrix::Complex.from_numo(nz)
+    na.to_gsl                           # one of the above, copying only
+                                        # a layout that cannot be shared
+    na = v.to_numo                      # Numo::DFloat on the GSL data
+    na = v.to_numo(:copy => true)
+
+  A view keeps its Numo array alive, and a Numo array made by #to_numo
+  keeps its GSL object alive.  Numo views with positive strides share
+  their data (for a matrix, the last dimension must be contiguous);
+  index-array views, reversed or broadcast dimensions raise ArgumentError
+  in .from_numo.  #to_numo shares vectors of any stride and packed
+  matrices; it copies when the installed Numo::NArray cannot hold foreign
+  memory (narray_data_t without the owned flag).
+
+  A 1-D Numo::DFloat is also accepted, without a copy, wherever a
+  GSL::Vector is read through a data pointer (GSL::Stats, GSL::Fft,
+  GSL::Blas.dnrm2 ...).
+
+  The Numo classes are looked up by name at run time, so the extension
+  does not link against Numo; only the struct layouts of numo/narray.h
+  are used.
+*/
+
+#include "rb_gsl_config.h"
+#ifdef HAVE_NUMO_NARRAY_H
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "numo/narray.h"
+
+typedef struct {
+  union {
+    gsl_vector vector;
+    gsl_matrix matrix;
+    gsl_vector_complex vector_complex;
+    gsl_matrix_complex matrix_complex;
+  } v;
+  union {
+    gsl_block block;
+    gsl_block_complex block_complex;
+  } b;
+  VALUE owner;
+} numo_view;
+
+struct numo_layout {
+  char *ptr;                  /* address of the first element */
+  size_t ndim, shape[2];
+  ssize_t stride[2];          /* in bytes */
+};
+
+static VALUE numo_class(const char *name)
+{
+  if (!rb_const_defined(rb_cObject, rb_intern("Numo")))
+    rb_raise(rb_eRuntimeError, "Numo::NArray is not loaded");
+  return rb_path2class(name);
+}
+
+int rb_gsl_numo_p(VALUE obj)
+{
+  if (!rb_const_defined(rb_cObject, rb_intern("Numo"))) return 0;
+  return RTEST(rb_obj_is_kind_of(obj, rb_path2class("Numo::NArray")));
+}
+
+static char* numo_data_ptr(VALUE obj)
+{
+  narray_data_t *d = (narray_data_t*) RNARRAY(obj);
+  if (d->ptr == NULL) {
+    rb_funcall(obj, rb_intern("allocate"), 0);
+    d = (narray_data_t*) RNARRAY(obj);
+  }
+  return d->ptr;
+}
+
+/* Element address and byte strides of obj, an array of at most two
+   dimensions and esize-byte elements; returns why the data cannot be
+   shared, or NULL */
+static const char* numo_layout_of(VALUE obj, size_t esize, struct numo_layout *l)
+{
+  narray_t *na = RNARRAY(obj);
+  narray_view_t *nv;
+  size_t k;
+  if (NA_NDIM(na) < 1 || NA_NDIM(na) > 2) return "array of more than 2 dimensions";
+  if (NA_SIZE(na) == 0) return "empty array";
+  if (TEST_BYTE_SWAPPED(obj)) return "byte-swapped array";
+  l->ndim = NA_NDIM(na);
+  for (k = 0; k < l->ndim; k++) l->shape[k] = NA_SHAPE(na)[k];
+  switch (NA_TYPE(na)) {
+  case NARRAY_DATA_T:
+  case NARRAY_FILEMAP_T:
+    l->ptr = numo_data_ptr(obj);
+    l->stride[l->ndim - 1] = esize;
+    if (l->ndim == 2) l->stride[0] = esize*l->shape[1];
+    return NULL;
+  case NARRAY_VIEW_T:
+    nv = (narray_view_t*) na;
+    for (k = 0; k < l->ndim; k++) {
+      if (SDX_IS_INDEX(nv->stridx[k])) return "index-array view";
+      l->stride[k] = SDX_GET_STRIDE(nv->stridx[k]);
+      /* the stride of a dimension of length 1 is arbitrary */
+      if (l->shape[k] == 1)
+	l->stride[k] = (k == 0 && l->ndim == 2) ? esize*l->shape[1] : esize;
+      if (l->stride[k] <= 0) return "reversed or broadcast dimension";
+      if (l->stride[k] % (ssize_t) esize) return "unaligned stride";
+    }
+    if (l->ndim == 2 && (l->stride[1] != (ssize_t) esize
+			 || l->stride[0] < (ssize_t) (esize*l->shape[1])))
+      return "view with non-contiguous rows";
+    l->ptr = numo_data_ptr(nv->data) + nv->offset;
+    return NULL;
+  default:
+    return "unknown Numo::NArray storage";
+  }
+}
+
+static void numo_get_layout(VALUE obj, const char *klass, size_t ndim,
+			    size_t esize, struct numo_layout *l)
+{
+  const char *err;
+  if (!rb_obj_is_kind_of(obj, numo_class(klass)))
+    rb_raise(rb_eTypeError, "wrong argument type %s (%s expected)",
+	     rb_class2name(CLASS_OF(obj)), klass);
+  if (NA_NDIM(RNARRAY(obj)) != ndim)
+    rb_raise(rb_eArgError, "%d-dimensional array (%d expected)",
+	     (int) NA_NDIM(RNARRAY(obj)), (int) ndim);
+  err = numo_layout_of(obj, esize, l);
+  if (err) rb_raise(rb_eArgError, "%s cannot be shared", err);
+}
+
+static void numo_view_mark(numo_view *p)
+{
+  rb_gc_mark(p->owner);
+}
+
+static numo_view* numo_view_alloc(VALUE owner)
+{
+  numo_view *p = (numo_view*) malloc(sizeof(numo_view));
+  if (p == NULL) rb_raise(rb_eNoMemError, "malloc failed");
+  p->owner = owner;
+  return p;
+}
+
+static VALUE rb_gsl_vector_from_numo(VALUE klass, VALUE obj)
+{
+  struct numo_layout l;
+  numo_view *p;
+  numo_get_layout(obj, "Numo::DFloat", 1, sizeof(double), &l);
+  p = numo_view_alloc(obj);
+  p->v.vector.size = l.shape[0];
+  p->v.vector.stride = l.stride[0]/sizeof(double);
+  p->v.vector.data = (double*) l.ptr;
+  p->b.block.size = (l.shape[0] - 1)*p->v.vector.stride + 1;
+  p->b.block.data = (double*) l.ptr;
+  p->v.vector.block = &p->b.block;
+  p->v.vector.owner = 0;
+  return Data_Wrap_Struct(cgsl_vector_view, numo_view_mark, free, &p->v.vector);
+}
+
+static VALUE rb_gsl_matrix_from_numo(VALUE klass, VALUE obj)
+{
+  struct numo_layout l;
+  numo_view *p;
+  numo_get_layout(obj, "Numo::DFloat", 2, sizeof(double), &l);
+  p = numo_view_alloc(obj);
+  p->v.matrix.size1 = l.shape[0];
+  p->v.matrix.size2 = l.shape[1];
+  p->v.matrix.tda = l.stride[0]/sizeof(double);
+  p->v.matrix.data = (double*) l.ptr;
+  p->b.block.size = (l.shape[0] - 1)*p->v.matrix.tda + l.shape[1];
+  p->b.block.data = (double*) l.ptr;
+  p->v.matrix.block = &p->b.block;
+  p->v.matrix.owner = 0;
+  return Data_Wrap_Struct(cgsl_matrix_view, numo_view_mark, free, &p->v.matrix);
+}
+
+static VALUE rb_gsl_vector_complex_from_numo(VALUE klass, VALUE obj)
+{
+  struct numo_layout l;
+  numo_view *p;
+  numo_get_layout(obj, "Numo::DComplex", 1, 2*sizeof(double), &l);
+  p = numo_view_alloc(obj);
+  p->v.vector_complex.size = l.shape[0];
+  p->v.vector_complex.stride = l.stride[0]/(2*sizeof(double));
+  p->v.vector_complex.data = (double*) l.ptr;
+  p->b.block_complex.size = (l.shape[0] - 1)*p->v.vector_complex.stride + 1;
+  p->b.block_complex.data = (double*) l.ptr;
+  p->v.vector_complex.block = &p->b.block_complex;
+  p->v.vector_complex.owner = 0;
+  return Data_Wrap_Struct(cgsl_vector_complex_view, numo_view_mark, free,
+			  &p->v.vector_complex);
+}
+
+static VALUE rb_gsl_matrix_complex_from_numo(VALUE klass, VALUE obj)
+{
+  struct numo_layout l;
+  numo_view *p;
+  numo_get_layout(obj, "Numo::DComplex", 2, 2*sizeof(double), &l);
+  p = numo_view_alloc(obj);
+  p->v.matrix_complex.size1 = l.shape[0];
+  p->v.matrix_complex.size2 = l.shape[1];
+  p->v.matrix_complex.tda = l.stride[0]/(2*sizeof(double));
+  p->v.matrix_complex.data = (double*) l.ptr;
+  p->b.block_complex.size = (l.shape[0] - 1)*p->v.matrix_complex.tda + l.shape[1];
+  p->b.block_complex.data = (double*) l.ptr;
+  p->v.matrix_complex.block = &p->b.block_complex;
+  p->v.matrix_complex.owner = 0;
+  return Data_Wrap_Struct(cgsl_matrix_complex_view, numo_view_mark, free,
+			  &p->v.matrix_complex);
+}
+
+/* Numo::NArray#to_gsl: shares when possible, else copies through a
+   contiguous Numo::DFloat or Numo::DComplex */
+static VALUE rb_gsl_numo_to_gsl(VALUE obj)
+{
+  VALUE dcomplex = numo_class("Numo::DComplex"), klass;
+  int cplx = RTEST(rb_obj_is_kind_of(obj, dcomplex));
+  int ndim = NA_NDIM(RNARRAY(obj));
+  struct numo_layout l;
+  klass = cplx ? dcomplex : numo_class("Numo::DFloat");
+  if (ndim < 1 || ndim > 2)
+    rb_raise(rb_eArgError, "%d-dimensional array (1 or 2 expected)", ndim);
+  if (!rb_obj_is_kind_of(obj, klass))
+    obj = rb_funcall(klass, rb_intern("cast"), 1, obj);
+  else if (NA_SIZE(RNARRAY(obj)) > 0
+	   && numo_layout_of(obj, (cplx ? 2 : 1)*sizeof(double), &l) != NULL)
+    obj = rb_funcall(obj, rb_intern("dup"), 0);
+  if (ndim == 1) {
+    return cplx ? rb_gsl_vector_complex_from_numo(cgsl_vector_complex, obj)
+      : rb_gsl_vector_from_numo(cgsl_vector, obj);
+  }
+  return cplx ? rb_gsl_matrix_complex_from_numo(cgsl_matrix_complex, obj)
+    : rb_gsl_matrix_from_numo(cgsl_matrix, obj);
+}
+
+/* A 1-D Numo::DFloat as a data pointer, for get_vector_ptr() and
+   get_ptr_double3() */
+double* rb_gsl_numo_vector_ptr(VALUE obj, size_t *stride, size_t *n)
+{
+  struct numo_layout l;
+  numo_get_layout(obj, "Numo::DFloat", 1, sizeof(double), &l);
+  *n = l.shape[0];
+  *stride = l.stride[0]/sizeof(double);
+  return (double*) l.ptr;
+}
+
+static VALUE numo_new(const char *name, int ndim, size_t size1, size_t size2)
+{
+  VALUE argv[2];
+  argv[0] = SIZET2NUM(size1);
+  argv[1] = SIZET2NUM(size2);
+  return rb_funcall2(numo_class(name), rb_intern("new"), ndim, argv);
+}
+
+static int numo_copy_p(int argc, VALUE *argv)
+{
+  VALUE opts;
+  switch (argc) {
+  case 0: return 0;
+  case 1:
+    opts = argv[0];
+    Check_Type(opts, T_HASH);
+    return RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("copy"))));
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  }
+  return 0;
+}
+
+/* Points the fresh Numo array nary at data, returns 0 if it cannot */
+static int numo_adopt(VALUE nary, double *data, VALUE obj)
+{
+#ifdef HAVE_NARRAY_DATA_T_OWNED
+  narray_data_t *d = (narray_data_t*) RNARRAY(nary);
+  if (d->ptr != NULL) return 0;
+  d->ptr = (char*) data;
+  d->owned = 0;
+  rb_ivar_set(nary, rb_intern("@gsl"), obj);
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* The span of a strided vector as a Numo array, sliced with the stride */
+static VALUE numo_share_strided(const char *name, double *data, size_t n,
+				size_t stride, VALUE obj)
+{
+  size_t span = (n - 1)*stride + 1;
+  VALUE nary = numo_new(name, 1, span, 0), step;
+  if (!numo_adopt(nary, data, obj)) return Qnil;
+  if (stride == 1) return nary;
+  step = rb_funcall(rb_range_new(INT2FIX(0), SIZET2NUM(span), 1),
+		    rb_intern("step"), 1, SIZET2NUM(stride));
+  return rb_funcall(nary, rb_intern("[]"), 1, step);
+}
+
+static VALUE rb_gsl_vector_to_numo(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector *v = NULL;
+  VALUE nary;
+  double *p;
+  size_t i;
+  Data_Get_Struct(obj, gsl_vector, v);
+  if (!numo_copy_p(argc, argv)) {
+    nary = numo_share_strided("Numo::DFloat", v->data, v->size, v->stride, obj);
+    if (!NIL_P(nary)) return nary;
+  }
+  nary = numo_new("Numo::DFloat", 1, v->size, 0);
+  p = (double*) numo_data_ptr(nary);
+  for (i = 0; i < v->size; i++) p[i] = v->data[i*v->stride];
+  return nary;
+}
+
+static VALUE rb_gsl_vector_complex_to_numo(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector_complex *v = NULL;
+  VALUE nary;
+  double *p;
+  size_t i;
+  Data_Get_Struct(obj, gsl_vector_complex, v);
+  if (!numo_copy_p(argc, argv)) {
+    nary = numo_share_strided("Numo::DComplex", v->data, v->size, v->stride, obj);
+    if (!NIL_P(nary)) return nary;
+  }
+  nary = numo_new("Numo::DComplex", 1, v->size, 0);
+  p = (double*) numo_data_ptr(nary);
+  for (i = 0; i < v->size; i++) {
+    p[2*i] = v->data[2*i*v->stride];
+    p[2*i+1] = v->data[2*i*v->stride+1];
+  }
+  return nary;
+}
+
+static VALUE rb_gsl_matrix_to_numo(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *m = NULL;
+  VALUE nary;
+  double *p;
+  size_t i;
+  Data_Get_Struct(obj, gsl_matrix, m);
+  nary = numo_new("Numo::DFloat", 2, m->size1, m->size2);
+  if (!numo_copy_p(argc, argv) && m->tda == m->size2
+      && numo_adopt(nary, m->data, obj)) return nary;
+  p = (double*) numo_data_ptr(nary);
+  for (i = 0; i < m->size1; i++)
+    memcpy(p + i*m->size2, m->data + i*m->tda, m->size2*sizeof(double));
+  return nary;
+}
+
+static VALUE rb_gsl_matrix_complex_to_numo(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix_complex *m = NULL;
+  VALUE nary;
+  double *p;
+  size_t i;
+  Data_Get_Struct(obj, gsl_matrix_complex, m);
+  nary = numo_new("Numo::DComplex", 2, m->size1, m->size2);
+  if (!numo_copy_p(argc, argv) && m->tda == m->size2
+      && numo_adopt(nary, m->data, obj)) return nary;
+  p = (double*) numo_data_ptr(nary);
+  for (i = 0; i < m->size1; i++)
+    memcpy(p + 2*i*m->size2, m->data + 2*i*m->tda, 2*m->size2*sizeof(double));
+  return nary;
+}
+
+void Init_gsl_numo(VALUE module)
+{
+  rb_define_singleton_method(cgsl_vector, "from_numo", rb_gsl_vector_from_numo, 1);
+  rb_define_singleton_method(cgsl_matrix, "from_numo", rb_gsl_matrix_from_numo, 1);
+  rb_define_singleton_method(cgsl_vector_complex, "from_numo",
+			     rb_gsl_vector_complex_from_numo, 1);
+  rb_define_singleton_method(cgsl_matrix_complex, "from_numo",
+			     rb_gsl_matrix_complex_from_numo, 1);
+
+  rb_define_method(cgsl_vector, "to_numo", rb_gsl_vector_to_numo, -1);
+  rb_define_method(cgsl_matrix, "to_numo", rb_gsl_matrix_to_numo, -1);
+  rb_define_method(cgsl_vector_complex, "to_numo", rb_gsl_vector_complex_to_numo, -1);
+  rb_define_method(cgsl_matrix_complex, "to_numo", rb_gsl_matrix_complex_to_numo, -1);
+
+  /* lib/gsl.rb requires numo/narray before the extension */
+  if (rb_const_defined(rb_cObject, rb_intern("Numo")))
+    rb_define_method(rb_path2class("Numo::NArray"), "to_gsl", rb_gsl_numo_to_gsl, 0);
+}
+#endif
@@ -0,0 +1,735 @@
+/*
+  hdf5.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::HDF5: Vector, Matrix, Tensor and Histogram datasets of HDF5
+  files, read whole or by hyperslab, so that only the rows needed are
+  read from a large archive:
+
+    GSL::HDF5::File.open("run.h5", "w") do |f|
+      f.write("grid", m, :compress => 6)
+      f.write("hist", h)
+    end
+    GSL::HDF5::File.open("run.h5") do |f|
+      f.shape("grid")                                 # [100000, 512]
+      rows = f.read("grid", :offset => [5000, 0], :count => [100, 512])
+      f.read_into("grid", m.row(7), :offset => [42, 0])
+    end
+    v = GSL::HDF5.read("run.h5", "series")
+
+  Modes of File.open: "r" (default), "r+" read and write, "w" create or
+  truncate, "a" read and write, created if absent.
+
+  File#read(name[, opts]) returns a Vector (1-d), Matrix (2-d) or Tensor
+  (more dimensions, all equal) of the element type of the dataset:
+  floating point datasets read as doubles, integer ones as
+  Vector::Int/Matrix::Int/Tensor::Int, and compound datasets of members
+  "r" and "i" (the h5py layout of complex numbers) as Vector::Complex or
+  Matrix::Complex.  A 1-d dataset with a "range" attribute of one more
+  element is a Histogram.  Options :offset and :count (Arrays of one
+  entry per dimension) select the hyperslab read.
+
+  File#read_into(name, obj[, opts]) reads into an existing object or view
+  the hyperslab at :offset of its shape; a dataset of more dimensions
+  than obj is read with the leading ones of extent 1, so a matrix row is
+  read into a vector.  Strided vectors and matrix views are filled in
+  place through the memory dataspace, without a temporary.
+
+  File#write(name, obj[, opts]) creates the dataset, replacing one of the
+  same name; groups in the name are created.  :chunk is an Array of
+  chunk dimensions, or true for chunks of about 1 MiB, and :compress a
+  deflate level (1-9) that implies chunking.  With :offset, obj is
+  written into the hyperslab of an existing dataset instead.
+
+  HDF5 failures raise IOError; the library's error stack printing is
+  turned off.
+*/
+
+#include "rb_gsl_config.h"
+
+#ifdef HAVE_HDF5_H
+
+#include "rb_gsl_array.h"
+#include "rb_gsl_histogram.h"
+#include "rb_gsl_common.h"
+#ifdef HAVE_TENSOR_TENSOR_H
+#include "rb_gsl_tensor.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <hdf5.h>
+
+#define H5_MAXRANK 32
+#define H5_MAXIDS 8
+#define H5_CHUNK_BYTES (1 << 20)
+
+/* Element types on the GSL side */
+enum { H5_DOUBLE, H5_INT, H5_COMPLEX };
+
+static VALUE cgsl_hdf5_file;
+static hid_t h5_complex_type = -1;
+
+typedef struct {
+  hid_t id;
+} rb_gsl_hdf5_file;
+
+static void h5_file_free(rb_gsl_hdf5_file *f)
+{
+  if (f->id >= 0) H5Fclose(f->id);
+  free(f);
+}
+
+static hid_t h5_file_id(VALUE obj)
+{
+  rb_gsl_hdf5_file *f;
+  Data_Get_Struct(obj, rb_gsl_hdf5_file, f);
+  if (f->id < 0) rb_raise(rb_eIOError, "closed HDF5 file");
+  return f->id;
+}
+
+/* The HDF5 identifiers of one operation, released however it ends */
+struct h5_ids {
+  hid_t id[H5_MAXIDS];
+  int n;
+};
+
+static hid_t h5_keep(struct h5_ids *k, hid_t id, const char *what, const char *name)
+{
+  if (id < 0) rb_raise(rb_eIOError, "HDF5: can not %s %s", what, name);
+  k->id[k->n++] = id;
+  return id;
+}
+
+static VALUE h5_release(VALUE arg)
+{
+  struct h5_ids *k = (struct h5_ids *) arg;
+  while (k->n > 0) H5Idec_ref(k->id[--k->n]);
+  return Qnil;
+}
+
+static hid_t h5_mem_type(int type)
+{
+  switch (type) {
+  case H5_DOUBLE: return H5T_NATIVE_DOUBLE;
+  case H5_INT: return H5T_NATIVE_INT;
+  }
+  return h5_complex_type;
+}
+
+/* The element type for a dataset of file type t */
+static int h5_type_of(hid_t t, const char *name)
+{
+  switch (H5Tget_class(t)) {
+  case H5T_FLOAT:
+    return H5_DOUBLE;
+  case H5T_INTEGER:
+    return H5_INT;
+  case H5T_COMPOUND:
+    if (H5Tget_nmembers(t) == 2 && H5Tget_member_index(t, "r") >= 0
+        && H5Tget_member_index(t, "i") >= 0)
+      return H5_COMPLEX;
+    break;
+  default:
+    break;
+  }
+  rb_raise(rb_eTypeError, "%s: dataset of a type other than float, integer or complex", name);
+  return -1;
+}
+
+/*
+  An object as HDF5 sees it in memory: rank dims selected out of an
+  array of extent span, every stride-th element along the first
+  dimension (vectors) or the first dims[1] of rows of span[1] (matrices)
+*/
+struct h5_mem {
+  int type;
+  int rank;
+  hsize_t dims[H5_MAXRANK], span[H5_MAXRANK], stride;
+  void *data;
+  gsl_histogram *h;
+};
+
+static void h5_mem_get(VALUE obj, struct h5_mem *m)
+{
+  m->rank = 1;
+  m->stride = 1;
+  m->h = NULL;
+  if (rb_obj_is_kind_of(obj, cgsl_vector)) {
+    gsl_vector *v;
+    Data_Get_Struct(obj, gsl_vector, v);
+    m->type = H5_DOUBLE;
+    m->dims[0] = v->size;
+    m->stride = v->stride;
+    m->data = v->data;
+  } else if (rb_obj_is_kind_of(obj, cgsl_vector_int)) {
+    gsl_vector_int *v;
+    Data_Get_Struct(obj, gsl_vector_int, v);
+    m->type = H5_INT;
+    m->dims[0] = v->size;
+    m->stride = v->stride;
+    m->data = v->data;
+  } else if (rb_obj_is_kind_of(obj, cgsl_vector_complex)) {
+    gsl_vector_complex *v;
+    Data_Get_Struct(obj, gsl_vector_complex, v);
+    m->type = H5_COMPLEX;
+    m->dims[0] = v->size;
+    m->stride = v->stride;
+    m->data = v->data;
+  } else if (rb_obj_is_kind_of(obj, cgsl_histogram)) {
+    Data_Get_Struct(obj, gsl_histogram, m->h);
+    m->type = H5_DOUBLE;
+    m->dims[0] = m->h->n;
+    m->data = m->h->bin;
+  } else if (rb_obj_is_kind_of(obj, cgsl_matrix)) {
+    gsl_matrix *a;
+    Data_Get_Struct(obj, gsl_matrix, a);
+    m->type = H5_DOUBLE;
+    m->rank = 2;
+    m->dims[0] = a->size1;
+    m->dims[1] = a->size2;
+    m->span[1] = a->tda;
+    m->data = a->data;
+  } else if (rb_obj_is_kind_of(obj, cgsl_matrix_int)) {
+    gsl_matrix_int *a;
+    Data_Get_Struct(obj, gsl_matrix_int, a);
+    m->type = H5_INT;
+    m->rank = 2;
+    m->dims[0] = a->size1;
+    m->dims[1] = a->size2;
+    m->span[1] = a->tda;
+    m->data = a->data;
+  } else if (rb_obj_is_kind_of(obj, cgsl_matrix_complex)) {
+    gsl_matrix_complex *a;
+    Data_Get_Struct(obj, gsl_matrix_complex, a);
+    m->type = H5_COMPLEX;
+    m->rank = 2;
+    m->dims[0] = a->size1;
+    m->dims[1] = a->size2;
+    m->span[1] = a->tda;
+    m->data = a->data;
+#ifdef HAVE_TENSOR_TENSOR_H
+  } else if (rb_obj_is_kind_of(obj, cgsl_tensor) || rb_obj_is_kind_of(obj, cgsl_tensor_int)) {
+    unsigned int j, rank;
+    size_t dim;
+    if (rb_obj_is_kind_of(obj, cgsl_tensor)) {
+      rbgsl_tensor *t;
+      Data_Get_Struct(obj, rbgsl_tensor, t);
+      rank = t->tensor->rank;
+      dim = t->tensor->dimension;
+      m->type = H5_DOUBLE;
+      m->data = t->tensor->data;
+    } else {
+      rbgsl_tensor_int *t;
+      Data_Get_Struct(obj, rbgsl_tensor_int, t);
+      rank = t->tensor->rank;
+      dim = t->tensor->dimension;
+      m->type = H5_INT;
+      m->data = t->tensor->data;
+    }
+    if (rank == 0 || rank > H5_MAXRANK) rb_raise(rb_eRangeError, "tensor of rank %u", rank);
+    m->rank = (int) rank;
+    for (j = 0; j < rank; j++) m->dims[j] = m->span[j] = dim;
+    return;
+#endif
+  } else {
+    rb_raise(rb_eTypeError, "%s can not be stored in HDF5", rb_obj_classname(obj));
+  }
+  if (m->rank == 1) m->span[0] = m->dims[0] == 0 ? 0 : (m->dims[0] - 1)*m->stride + 1;
+  else m->span[0] = m->dims[0];
+}
+
+/* The dataspace of m, with its elements selected */
+static hid_t h5_mem_space(const struct h5_mem *m)
+{
+  hsize_t start[H5_MAXRANK], stride[H5_MAXRANK];
+  hid_t s = H5Screate_simple(m->rank, m->span, NULL);
+  int j;
+  if (s < 0) return s;
+  for (j = 0; j < m->rank; j++) {
+    start[j] = 0;
+    stride[j] = j == 0 ? m->stride : 1;
+  }
+  if (H5Sselect_hyperslab(s, H5S_SELECT_SET, start, stride, m->dims, NULL) < 0) {
+    H5Sclose(s);
+    return -1;
+  }
+  return s;
+}
+
+static VALUE h5_opt(VALUE opts, const char *key)
+{
+  if (NIL_P(opts)) return Qnil;
+  return rb_hash_aref(opts, ID2SYM(rb_intern(key)));
+}
+
+static void h5_dims_opt(VALUE opts, const char *key, int rank, hsize_t *d)
+{
+  VALUE a = h5_opt(opts, key);
+  int j;
+  if (NIL_P(a)) return;
+  Check_Type(a, T_ARRAY);
+  if (RARRAY_LEN(a) != rank)
+    rb_raise(rb_eArgError, ":%s of %d entries for a dataset of rank %d", key,
+             (int) RARRAY_LEN(a), rank);
+  for (j = 0; j < rank; j++) d[j] = NUM2SIZET(rb_ary_entry(a, j));
+}
+
+/* The hyperslab at offset of extent count must lie in dims */
+static void h5_check_slab(int rank, const hsize_t *dims, const hsize_t *offset,
+                          const hsize_t *count, const char *name)
+{
+  int j;
+  for (j = 0; j < rank; j++)
+    if (offset[j] > dims[j] || count[j] > dims[j] - offset[j])
+      rb_raise(rb_eIndexError, "%s: hyperslab out of the dataset in dimension %d", name, j);
+}
+
+/* count for writing or reading m at a dataset of rank dimensions */
+static void h5_mem_count(const struct h5_mem *m, int rank, hsize_t *count, const char *name)
+{
+  int j;
+  if (rank < m->rank)
+    rb_raise(rb_eArgError, "%s: dataset of rank %d for an object of rank %d", name, rank, m->rank);
+  for (j = 0; j < rank - m->rank; j++) count[j] = 1;
+  for (j = 0; j < m->rank; j++) count[rank - m->rank + j] = m->dims[j];
+}
+
+static void h5_check_type(int file, int mem, const char *name)
+{
+  if (file == mem || (file == H5_INT && mem == H5_DOUBLE)) return;
+  rb_raise(rb_eTypeError, "%s: %s dataset for a%s object", name,
+           file == H5_COMPLEX ? "complex" : file == H5_INT ? "integer" : "real",
+           mem == H5_COMPLEX ? " complex" : mem == H5_INT ? "n integer" : " real");
+}
+
+/* A new object of rank and dims for dataset type, described into m */
+static VALUE h5_new(int type, int rank, const hsize_t *dims, struct h5_mem *m,
+                    const char *name)
+{
+  VALUE obj = Qnil;
+  int j;
+  for (j = 0; j < rank; j++)
+    if (dims[j] == 0) rb_raise(rb_eArgError, "%s: empty hyperslab", name);
+  if (rank == 1) {
+    if (type == H5_DOUBLE) {
+      gsl_vector *v = gsl_vector_alloc(dims[0]);
+      obj = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    } else if (type == H5_INT) {
+      gsl_vector_int *v = gsl_vector_int_alloc(dims[0]);
+      obj = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, v);
+    } else {
+      gsl_vector_complex *v = gsl_vector_complex_alloc(dims[0]);
+      obj = Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v);
+    }
+  } else if (rank == 2) {
+    if (type == H5_DOUBLE) {
+      gsl_matrix *a = gsl_matrix_alloc(dims[0], dims[1]);
+      obj = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, a);
+    } else if (type == H5_INT) {
+      gsl_matrix_int *a = gsl_matrix_int_alloc(dims[0], dims[1]);
+      obj = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, a);
+    } else {
+      gsl_matrix_complex *a = gsl_matrix_complex_alloc(dims[0], dims[1]);
+      obj = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, a);
+    }
+  } else {
+#ifdef HAVE_TENSOR_TENSOR_H
+    for (j = 1; j < rank; j++)
+      if (dims[j] != dims[0])
+        rb_raise(rb_eArgError, "%s: a Tensor has equal dimensions", name);
+    if (type == H5_DOUBLE) {
+      rbgsl_tensor *t = rbgsl_tensor_alloc(rank, dims[0]);
+      obj = Data_Wrap_Struct(cgsl_tensor, 0, rbgsl_tensor_free, t);
+    } else if (type == H5_INT) {
+      rbgsl_tensor_int *t = rbgsl_tensor_int_alloc(rank, dims[0]);
+      obj = Data_Wrap_Struct(cgsl_tensor_int, 0, rbgsl_tensor_int_free, t);
+    } else
+#endif
+    rb_raise(rb_eArgError, "%s: no GSL class for a %s dataset of rank %d", name,
+             type == H5_COMPLEX ? "complex" : "real", rank);
+  }
+  h5_mem_get(obj, m);
+  return obj;
+}
+
+struct h5_op {
+  hid_t fid;
+  VALUE name, obj, opts;
+  int into;
+  struct h5_ids k;
+};
+
+/* File#read and File#read_into */
+static VALUE h5_read_body(VALUE arg)
+{
+  struct h5_op *op = (struct h5_op *) arg;
+  struct h5_ids *k = &op->k;
+  const char *name = StringValueCStr(op->name);
+  hsize_t dims[H5_MAXRANK], offset[H5_MAXRANK], count[H5_MAXRANK];
+  struct h5_mem m;
+  hid_t dset, fspace, ftype, mspace, attr, aspace;
+  int rank, type, j, hist;
+  dset = h5_keep(k, H5Dopen2(op->fid, name, H5P_DEFAULT), "open dataset", name);
+  fspace = h5_keep(k, H5Dget_space(dset), "get the dataspace of", name);
+  ftype = h5_keep(k, H5Dget_type(dset), "get the type of", name);
+  type = h5_type_of(ftype, name);
+  rank = H5Sget_simple_extent_ndims(fspace);
+  if (rank < 1 || rank > H5_MAXRANK)
+    rb_raise(rb_eArgError, "%s: dataset of rank %d", name, rank);
+  H5Sget_simple_extent_dims(fspace, dims, NULL);
+  for (j = 0; j < rank; j++) offset[j] = 0;
+  h5_dims_opt(op->opts, "offset", rank, offset);
+  hist = rank == 1 && type == H5_DOUBLE && H5Aexists(dset, "range") > 0;
+  if (op->into) {
+    h5_mem_get(op->obj, &m);
+    h5_check_type(type, m.type, name);
+    h5_mem_count(&m, rank, count, name);
+  } else {
+    for (j = 0; j < rank; j++) count[j] = offset[j] <= dims[j] ? dims[j] - offset[j] : 0;
+    h5_dims_opt(op->opts, "count", rank, count);
+  }
+  h5_check_slab(rank, dims, offset, count, name);
+  if (!op->into) {
+    if (hist) {
+      if (count[0] == 0) rb_raise(rb_eArgError, "%s: empty hyperslab", name);
+      m.h = gsl_histogram_alloc(count[0]);
+      op->obj = Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, m.h);
+      h5_mem_get(op->obj, &m);
+    } else {
+      op->obj = h5_new(type, rank, count, &m, name);
+    }
+  }
+  if (H5Sselect_hyperslab(fspace, H5S_SELECT_SET, offset, NULL, count, NULL) < 0)
+    rb_raise(rb_eIOError, "HDF5: can not select the hyperslab of %s", name);
+  mspace = h5_keep(k, h5_mem_space(&m), "make the memory dataspace for", name);
+  if (H5Dread(dset, h5_mem_type(m.type), mspace, fspace, H5P_DEFAULT, m.data) < 0)
+    rb_raise(rb_eIOError, "HDF5: can not read %s", name);
+  if (hist && m.h) {
+    /* The ranges of the bins read, out of the n+1 of the dataset */
+    hsize_t n1 = dims[0] + 1, r0 = offset[0], rn = m.h->n + 1;
+    attr = h5_keep(k, H5Aopen(dset, "range", H5P_DEFAULT), "open the range of", name);
+    aspace = h5_keep(k, H5Aget_space(attr), "get the range dataspace of", name);
+    if (H5Sget_simple_extent_npoints(aspace) != (hssize_t) n1)
+      rb_raise(rb_eArgError, "%s: range of a wrong size", name);
+    if (r0 == 0 && rn == n1) {
+      if (H5Aread(attr, H5T_NATIVE_DOUBLE, m.h->range) < 0)
+        rb_raise(rb_eIOError, "HDF5: can not read the range of %s", name);
+    } else {
+      VALUE tmp;
+      double *r = ALLOCV_N(double, tmp, n1);
+      if (H5Aread(attr, H5T_NATIVE_DOUBLE, r) < 0)
+        rb_raise(rb_eIOError, "HDF5: can not read the range of %s", name);
+      memcpy(m.h->range, r + r0, rn*sizeof(double));
+      ALLOCV_END(tmp);
+    }
+  }
+  return op->obj;
+}
+
+/* Chunk dimensions of about H5_CHUNK_BYTES, the last dimensions first */
+static void h5_auto_chunk(int rank, const hsize_t *dims, size_t esize, hsize_t *chunk)
+{
+  hsize_t budget = H5_CHUNK_BYTES/esize;
+  int j;
+  for (j = rank - 1; j >= 0; j--) {
+    chunk[j] = dims[j] < budget ? dims[j] : budget;
+    if (chunk[j] == 0) chunk[j] = 1;
+    budget /= chunk[j];
+    if (budget == 0) budget = 1;
+  }
+}
+
+static hid_t h5_create_plist(struct h5_ids *k, const struct h5_mem *m, VALUE opts,
+                             const char *name)
+{
+  hsize_t chunk[H5_MAXRANK];
+  VALUE vchunk = h5_opt(opts, "chunk"), vlevel = h5_opt(opts, "compress");
+  hid_t dcpl = h5_keep(k, H5Pcreate(H5P_DATASET_CREATE), "create the properties of", name);
+  int j, level = NIL_P(vlevel) ? 0 : NUM2INT(vlevel);
+  if (level < 0 || level > 9) rb_raise(rb_eArgError, ":compress must be 0-9");
+  if (RTEST(vchunk) || level > 0) {
+    if (TYPE(vchunk) == T_ARRAY) {
+      h5_dims_opt(opts, "chunk", m->rank, chunk);
+      for (j = 0; j < m->rank; j++)
+        if (chunk[j] == 0 || chunk[j] > m->dims[j])
+          rb_raise(rb_eArgError, ":chunk must be within the dimensions of the dataset");
+    } else {
+      h5_auto_chunk(m->rank, m->dims, H5Tget_size(h5_mem_type(m->type)), chunk);
+    }
+    if (H5Pset_chunk(dcpl, m->rank, chunk) < 0)
+      rb_raise(rb_eIOError, "HDF5: can not set the chunks of %s", name);
+    if (level > 0 && H5Pset_deflate(dcpl, level) < 0)
+      rb_raise(rb_eIOError, "HDF5: can not set the compression of %s", name);
+  }
+  return dcpl;
+}
+
+/* File#write */
+static VALUE h5_write_body(VALUE arg)
+{
+  struct h5_op *op = (struct h5_op *) arg;
+  struct h5_ids *k = &op->k;
+  const char *name = StringValueCStr(op->name);
+  hsize_t dims[H5_MAXRANK], offset[H5_MAXRANK], count[H5_MAXRANK];
+  struct h5_mem m;
+  hid_t dset, fspace, ftype, mspace, dcpl, lcpl, attr, aspace;
+  int rank, j;
+  h5_mem_get(op->obj, &m);
+  for (j = 0; j < m.rank; j++)
+    if (m.dims[j] == 0) rb_raise(rb_eArgError, "%s: empty object", name);
+  if (!NIL_P(h5_opt(op->opts, "offset"))) {
+    dset = h5_keep(k, H5Dopen2(op->fid, name, H5P_DEFAULT), "open dataset", name);
+    fspace = h5_keep(k, H5Dget_space(dset), "get the dataspace of", name);
+    ftype = h5_keep(k, H5Dget_type(dset), "get the type of", name);
+    h5_check_type(m.type, h5_type_of(ftype, name), name);
+    rank = H5Sget_simple_extent_ndims(fspace);
+    if (rank < 1 || rank > H5_MAXRANK)
+      rb_raise(rb_eArgError, "%s: dataset of rank %d", name, rank);
+    H5Sget_simple_extent_dims(fspace, dims, NULL);
+    h5_dims_opt(op->opts, "offset", rank, offset);
+    h5_mem_count(&m, rank, count, name);
+    h5_check_slab(rank, dims, offset, count, name);
+    if (H5Sselect_hyperslab(fspace, H5S_SELECT_SET, offset, NULL, count, NULL) < 0)
+      rb_raise(rb_eIOError, "HDF5: can not select the hyperslab of %s", name);
+  } else {
+    if (H5Lexists(op->fid, name, H5P_DEFAULT) > 0 && H5Ldelete(op->fid, name, H5P_DEFAULT) < 0)
+      rb_raise(rb_eIOError, "HDF5: can not replace %s", name);
+    dcpl = h5_create_plist(k, &m, op->opts, name);
+    lcpl = h5_keep(k, H5Pcreate(H5P_LINK_CREATE), "create the link properties of", name);
+    H5Pset_create_intermediate_group(lcpl, 1);
+    fspace = h5_keep(k, H5Screate_simple(m.rank, m.dims, NULL), "create the dataspace of", name);
+    dset = h5_keep(k, H5Dcreate2(op->fid, name, h5_mem_type(m.type), fspace, lcpl, dcpl,
+                                 H5P_DEFAULT), "create dataset", name);
+  }
+  mspace = h5_keep(k, h5_mem_space(&m), "make the memory dataspace for", name);
+  if (H5Dwrite(dset, h5_mem_type(m.type), mspace, fspace, H5P_DEFAULT, m.data) < 0)
+    rb_raise(rb_eIOError, "HDF5: can not write %s", name);
+  if (m.h && NIL_P(h5_opt(op->opts, "offset"))) {
+    hsize_t n1 = m.h->n + 1;
+    aspace = h5_keep(k, H5Screate_simple(1, &n1, NULL), "create the range dataspace of", name);
+    attr = h5_keep(k, H5Acreate2(dset, "range", H5T_NATIVE_DOUBLE, aspace, H5P_DEFAULT,
+                                 H5P_DEFAULT), "create the range of", name);
+    if (H5Awrite(attr, H5T_NATIVE_DOUBLE, m.h->range) < 0)
+      rb_raise(rb_eIOError, "HDF5: can not write the range of %s", name);
+  }
+  return op->obj;
+}
+
+static VALUE h5_run(VALUE (*body)(VALUE), VALUE file, VALUE name, VALUE obj,
+                    VALUE opts, int into)
+{
+  struct h5_op op;
+  op.fid = h5_file_id(file);
+  op.name = name;
+  op.obj = obj;
+  op.opts = opts;
+  op.into = into;
+  op.k.n = 0;
+  if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+  return rb_ensure(body, (VALUE) &op, h5_release, (VALUE) &op.k);
+}
+
+/* File#read(name[, opts]) */
+static VALUE rb_gsl_hdf5_file_read(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE name, opts;
+  rb_scan_args(argc, argv, "11", &name, &opts);
+  return h5_run(h5_read_body, obj, name, Qnil, opts, 0);
+}
+
+/* File#read_into(name, obj[, opts]) */
+static VALUE rb_gsl_hdf5_file_read_into(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE name, dst, opts;
+  rb_scan_args(argc, argv, "21", &name, &dst, &opts);
+  return h5_run(h5_read_body, obj, name, dst, opts, 1);
+}
+
+/* File#write(name, obj[, opts]) */
+static VALUE rb_gsl_hdf5_file_write(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE name, src, opts;
+  rb_scan_args(argc, argv, "21", &name, &src, &opts);
+  h5_run(h5_write_body, obj, name, src, opts, 0);
+  return obj;
+}
+
+/* File#shape(name): the dimensions of a dataset */
+static VALUE rb_gsl_hdf5_file_shape(VALUE obj, VALUE name)
+{
+  hid_t fid = h5_file_id(obj), dset, space;
+  hsize_t dims[H5_MAXRANK];
+  VALUE ary;
+  int rank, j;
+  dset = H5Dopen2(fid, StringValueCStr(name), H5P_DEFAULT);
+  if (dset < 0) rb_raise(rb_eIOError, "HDF5: can not open dataset %s", RSTRING_PTR(name));
+  space = H5Dget_space(dset);
+  rank = space < 0 ? -1 : H5Sget_simple_extent_ndims(space);
+  if (rank > H5_MAXRANK) rank = -1;
+  if (rank >= 0) H5Sget_simple_extent_dims(space, dims, NULL);
+  if (space >= 0) H5Sclose(space);
+  H5Dclose(dset);
+  if (rank < 0) rb_raise(rb_eIOError, "HDF5: can not get the dataspace of %s", RSTRING_PTR(name));
+  ary = rb_ary_new2(rank);
+  for (j = 0; j < rank; j++) rb_ary_push(ary, SIZET2NUM(dims[j]));
+  return ary;
+}
+
+/* File#exist?(name) */
+static VALUE rb_gsl_hdf5_file_exist(VALUE obj, VALUE name)
+{
+  return H5Lexists(h5_file_id(obj), StringValueCStr(name), H5P_DEFAULT) > 0 ? Qtrue : Qfalse;
+}
+
+/* File#names([group]): the names of the links of a group, "/" by default */
+static VALUE rb_gsl_hdf5_file_names(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE group, ary, str;
+  H5G_info_t info;
+  hid_t g;
+  hsize_t i;
+  ssize_t len;
+  rb_scan_args(argc, argv, "01", &group);
+  g = H5Gopen2(h5_file_id(obj), NIL_P(group) ? "/" : StringValueCStr(group), H5P_DEFAULT);
+  if (g < 0) rb_raise(rb_eIOError, "HDF5: can not open group %s", NIL_P(group) ? "/" : RSTRING_PTR(group));
+  if (H5Gget_info(g, &info) < 0) {
+    H5Gclose(g);
+    rb_raise(rb_eIOError, "HDF5: can not get the group information");
+  }
+  ary = rb_ary_new2(info.nlinks);
+  for (i = 0; i < info.nlinks; i++) {
+    len = H5Lget_name_by_idx(g, ".", H5_INDEX_NAME, H5_ITER_INC, i, NULL, 0, H5P_DEFAULT);
+    if (len < 0) continue;
+    str = rb_str_new(NULL, len + 1);
+    H5Lget_name_by_idx(g, ".", H5_INDEX_NAME, H5_ITER_INC, i, RSTRING_PTR(str), len + 1, H5P_DEFAULT);
+    rb_str_set_len(str, len);
+    rb_ary_push(ary, str);
+  }
+  H5Gclose(g);
+  return ary;
+}
+
+static VALUE rb_gsl_hdf5_file_close(VALUE obj)
+{
+  rb_gsl_hdf5_file *f;
+  Data_Get_Struct(obj, rb_gsl_hdf5_file, f);
+  if (f->id >= 0) {
+    herr_t r = H5Fclose(f->id);
+    f->id = -1;
+    if (r < 0) rb_raise(rb_eIOError, "HDF5: can not close the file");
+  }
+  return Qnil;
+}
+
+static VALUE rb_gsl_hdf5_file_closed(VALUE obj)
+{
+  rb_gsl_hdf5_file *f;
+  Data_Get_Struct(obj, rb_gsl_hdf5_file, f);
+  return f->id < 0 ? Qtrue : Qfalse;
+}
+
+static VALUE h5_open(VALUE path, const char *mode)
+{
+  rb_gsl_hdf5_file *f;
+  VALUE obj;
+  const char *name;
+  struct stat st;
+  int exists;
+  FilePathValue(path);
+  name = StringValueCStr(path);
+  exists = stat(name, &st) == 0;
+  if (!exists && (strcmp(mode, "r") == 0 || strcmp(mode, "r+") == 0)) rb_sys_fail(name);
+  obj = Data_Make_Struct(cgsl_hdf5_file, rb_gsl_hdf5_file, 0, h5_file_free, f);
+  if (strcmp(mode, "r") == 0)
+    f->id = H5Fopen(name, H5F_ACC_RDONLY, H5P_DEFAULT);
+  else if (strcmp(mode, "r+") == 0 || (strcmp(mode, "a") == 0 && exists))
+    f->id = H5Fopen(name, H5F_ACC_RDWR, H5P_DEFAULT);
+  else if (strcmp(mode, "w") == 0 || strcmp(mode, "a") == 0)
+    f->id = H5Fcreate(name, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  else
+    rb_raise(rb_eArgError, "mode must be \"r\", \"r+\", \"w\" or \"a\"");
+  if (f->id < 0) rb_raise(rb_eIOError, "HDF5: can not open %s", name);
+  return obj;
+}
+
+/* GSL::HDF5::File.open(path[, mode]) [{ |f| ... }] */
+static VALUE rb_gsl_hdf5_file_open(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE path, mode, obj;
+  rb_scan_args(argc, argv, "11", &path, &mode);
+  obj = h5_open(path, NIL_P(mode) ? "r" : StringValueCStr(mode));
+  if (!rb_block_given_p()) return obj;
+  return rb_ensure(rb_yield, obj, rb_gsl_hdf5_file_close, obj);
+}
+
+struct h5_call {
+  VALUE file;
+  int argc;
+  VALUE *argv;
+  VALUE (*func)(int, VALUE *, VALUE);
+};
+
+static VALUE h5_call_body(VALUE arg)
+{
+  struct h5_call *c = (struct h5_call *) arg;
+  return c->func(c->argc, c->argv, c->file);
+}
+
+/* GSL::HDF5.read(path, name[, opts]) */
+static VALUE rb_gsl_hdf5_read(int argc, VALUE *argv, VALUE module)
+{
+  struct h5_call c;
+  rb_check_arity(argc, 2, 3);
+  c.file = h5_open(argv[0], "r");
+  c.argc = argc - 1;
+  c.argv = argv + 1;
+  c.func = rb_gsl_hdf5_file_read;
+  return rb_ensure(h5_call_body, (VALUE) &c, rb_gsl_hdf5_file_close, c.file);
+}
+
+/* GSL::HDF5.write(path, name, obj[, opts]): the file is created if absent */
+static VALUE rb_gsl_hdf5_write(int argc, VALUE *argv, VALUE module)
+{
+  struct h5_call c;
+  rb_check_arity(argc, 3, 4);
+  c.file = h5_open(argv[0], "a");
+  c.argc = argc - 1;
+  c.argv = argv + 1;
+  c.func = rb_gsl_hdf5_file_write;
+  rb_ensure(h5_call_body, (VALUE) &c, rb_gsl_hdf5_file_close, c.file);
+  return argv[2];
+}
+
+void Init_gsl_hdf5(VALUE module)
+{
+  VALUE mhdf5 = rb_define_module_under(module, "HDF5");
+  H5open();
+  H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+  h5_complex_type = H5Tcreate(H5T_COMPOUND, 2*sizeof(double));
+  H5Tinsert(h5_complex_type, "r", 0, H5T_NATIVE_DOUBLE);
+  H5Tinsert(h5_complex_type, "i", sizeof(double), H5T_NATIVE_DOUBLE);
+
+  cgsl_hdf5_file = rb_define_class_under(mhdf5, "File", cGSL_Object);
+  rb_undef_alloc_func(cgsl_hdf5_file);
+  rb_define_singleton_method(cgsl_hdf5_file, "open", rb_gsl_hdf5_file_open, -1);
+  rb_define_method(cgsl_hdf5_file, "close", rb_gsl_hdf5_file_close, 0);
+  rb_define_method(cgsl_hdf5_file, "closed?", rb_gsl_hdf5_file_closed, 0);
+  rb_define_method(cgsl_hdf5_file, "read", rb_gsl_hdf5_file_read, -1);
+  rb_define_method(cgsl_hdf5_file, "read_into", rb_gsl_hdf5_file_read_into, -1);
+  rb_define_method(cgsl_hdf5_file, "write", rb_gsl_hdf5_file_write, -1);
+  rb_define_method(cgsl_hdf5_file, "shape", rb_gsl_hdf5_file_shape, 1);
+  rb_define_method(cgsl_hdf5_file, "exist?", rb_gsl_hdf5_file_exist, 1);
+  rb_define_method(cgsl_hdf5_file, "names", rb_gsl_hdf5_file_names, -1);
+
+  rb_define_module_function(mhdf5, "read", rb_gsl_hdf5_read, -1);
+  rb_define_module_function(mhdf5, "write", rb_gsl_hdf5_write, -1);
+}
+
+#endif
@@ -20,6 +20,7 @@ VALUE cgsl_histogram;
 VALUE cgsl_histogram_range;
 VALUE cgsl_histogram_bin;
 static VALUE cgsl_histogram_integ;
+static VALUE cgsl_histogram_pdf;
 
 static VALUE rb_gsl_histogram_alloc_from_file(VALUE klass, VALUE name);
 #ifdef GSL_0_9_4_LATER
@@ -243,6 +244,7 @@ static VALUE rb_gsl_histogram_set_ranges(int argc, VALUE *argv, VALUE obj)
   gsl_histogram *h = NULL;
   gsl_vector *v = NULL;
   size_t size;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   if (argc != 1 && argc != 2) 
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
@@ -266,24 +268,30 @@ static VALUE rb_gsl_histogram_range(VALUE obj)
 {
   gsl_histogram *h = NULL;
   gsl_vector_view *v = NULL;
+  VALUE vv;
   Data_Get_Struct(obj, gsl_histogram, h);
   v = gsl_vector_view_alloc();
   v->vector.data = h->range;
   v->vector.size = h->n + 1;
   v->vector.stride = 1;
-  return Data_Wrap_Struct(cgsl_histogram_range, 0, gsl_vector_view_free, v);
+  vv = Data_Wrap_Struct(cgsl_histogram_range, 0, gsl_vector_view_free, v);
+  if (OBJ_FROZEN(obj)) rb_obj_freeze(vv);
+  return vv;
 }
 
 static VALUE rb_gsl_histogram_bin(VALUE obj)
 {
   gsl_histogram *h = NULL;
   gsl_vector_view *v = NULL;
+  VALUE vv;
   Data_Get_Struct(obj, gsl_histogram, h);
   v = gsl_vector_view_alloc();
   v->vector.data = h->bin;
   v->vector.size = h->n;
   v->vector.stride = 1;
-  return Data_Wrap_Struct(cgsl_histogram_bin, 0, gsl_vector_view_free, v);
+  vv = Data_Wrap_Struct(cgsl_histogram_bin, 0, gsl_vector_view_free, v);
+  if (OBJ_FROZEN(obj)) rb_obj_freeze(vv);
+  return vv;
 }
 
 static VALUE rb_gsl_histogram_set_ranges_uniform(int argc, VALUE *argv, VALUE obj)
@@ -304,6 +312,7 @@ static VALUE rb_gsl_histogram_set_ranges_uniform(int argc, VALUE *argv, VALUE ob
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
     break;
   }
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   gsl_histogram_set_ranges_uniform(h, xmin, xmax);
   return obj;
@@ -315,6 +324,7 @@ static VALUE rb_gsl_histogram_memcpy(VALUE obj, VALUE vhdest, VALUE vhsrc)
   gsl_histogram *hdest = NULL, *hsrc = NULL;
   CHECK_HISTOGRAM(vhdest);
   CHECK_HISTOGRAM(vhsrc);
+  rb_check_frozen(vhdest);
   Data_Get_Struct(vhdest, gsl_histogram, hdest);
   Data_Get_Struct(vhsrc, gsl_histogram, hsrc);
   gsl_histogram_memcpy(hdest, hsrc);
@@ -329,21 +339,247 @@ static VALUE rb_gsl_histogram_clone(VALUE obj)
   return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_histogram_free, hnew);
 }
 
+/*
+  Bulk fill of a histogram of 1 to 3 dimensions, bins in row-major
+  order.  Ranges set by set_ranges_uniform (every edge equal to
+  range[0] + (i/n)*(range[n] - range[0]), as GSL computes them) take
+  the bin arithmetically over a block of values, in a branch-free loop
+  the compiler vectorizes, then check it against the two edges so the
+  result is the bin GSL's find would give; other ranges fall back to a
+  bisection.  Points outside the ranges and NaNs are skipped, as by
+  gsl_histogram_accumulate.
+
+  Large fills are cut in up to HISTOGRAM_FILL_PARTS parts, each filling
+  private bins which are then added to the histogram in part order.
+  The number of parts depends only on the sizes, so the sums do not
+  depend on the number of threads.
+*/
+#define HISTOGRAM_FILL_BLOCK 256
+#define HISTOGRAM_FILL_PARTS 16
+#define HISTOGRAM_FILL_PART_MIN 65536
+
+struct histogram_fill_task {
+  mygsl_histogram_axis *axes;
+  size_t naxes, nbins;
+  int uniform[3];
+  double scale[3];
+  const double *w;
+  size_t wstride, n;
+  double weight;
+  double *bins;          /* nparts*nbins private bins, or the histogram's */
+  size_t nparts, nthreads;
+};
+
+static int histogram_ranges_uniform(const double *range, size_t n)
+{
+  size_t i;
+  double xmin = range[0], xmax = range[n];
+  if (!(xmax > xmin)) return 0;
+  for (i = 1; i < n; i++)
+    if (range[i] != xmin + ((double) i / (double) n) * (xmax - xmin)) return 0;
+  return 1;
+}
+
+static size_t histogram_bisect(const double *range, size_t n, double x)
+{
+  size_t lower = 0, upper = n, mid;
+  while (upper - lower > 1) {
+    mid = (upper + lower)/2;
+    if (x >= range[mid]) lower = mid;
+    else upper = mid;
+  }
+  return lower;
+}
+
+/* Bins along axis a of the m points from i, -1 where outside the range */
+static void histogram_fill_index(const struct histogram_fill_task *t, size_t a,
+				 size_t i, size_t m, long *idx)
+{
+  const mygsl_histogram_axis *ax = t->axes + a;
+  const double *range = ax->range, *x = ax->x + i*ax->stride;
+  double lo = range[0], hi = range[ax->n], scale = t->scale[a], v;
+  size_t k, s = ax->stride;
+  if (t->uniform[a]) {
+    for (k = 0; k < m; k++) {
+      v = x[k*s];
+      idx[k] = (v >= lo && v < hi) ? (long) ((v - lo)*scale) : -1;
+    }
+  } else {
+    for (k = 0; k < m; k++) {
+      v = x[k*s];
+      idx[k] = (v >= lo && v < hi) ? (long) histogram_bisect(range, ax->n, v) : -1;
+    }
+  }
+  /* the arithmetic bin may be off by one near an edge */
+  for (k = 0; k < m; k++) {
+    if (idx[k] < 0) continue;
+    v = x[k*s];
+    if ((size_t) idx[k] >= ax->n) idx[k] = (long) ax->n - 1;
+    while (v < range[idx[k]]) idx[k]--;
+    while (v >= range[idx[k] + 1]) idx[k]++;
+  }
+}
+
+static void histogram_fill_range(const struct histogram_fill_task *t,
+				 size_t i0, size_t i1, double *bin)
+{
+  long idx[3][HISTOGRAM_FILL_BLOCK];
+  size_t i, k, m, a, j;
+  for (i = i0; i < i1; i += m) {
+    m = GSL_MIN(HISTOGRAM_FILL_BLOCK, i1 - i);
+    for (a = 0; a < t->naxes; a++) histogram_fill_index(t, a, i, m, idx[a]);
+    for (k = 0; k < m; k++) {
+      for (a = 0, j = 0; a < t->naxes; a++) {
+	if (idx[a][k] < 0) break;
+	j = j*t->axes[a].n + (size_t) idx[a][k];
+      }
+      if (a < t->naxes) continue;
+      bin[j] += t->w ? t->w[(i + k)*t->wstride] : t->weight;
+    }
+  }
+}
+
+static int histogram_fill_worker(void *data, size_t i)
+{
+  struct histogram_fill_task *t = (struct histogram_fill_task *) data;
+  size_t p, p0 = i*t->nparts/t->nthreads, p1 = (i + 1)*t->nparts/t->nthreads;
+  for (p = p0; p < p1; p++)
+    histogram_fill_range(t, p*t->n/t->nparts, (p + 1)*t->n/t->nparts,
+			 t->bins + p*t->nbins);
+  return GSL_SUCCESS;
+}
+
+static int histogram_fill_serial(void *data)
+{
+  return histogram_fill_worker(data, 0);
+}
+
+static void histogram_fill_setup(struct histogram_fill_task *t, mygsl_histogram_axis *axes,
+				 size_t naxes, const double *w, size_t wstride, double weight,
+				 size_t n)
+{
+  size_t a;
+  t->axes = axes; t->naxes = naxes;
+  for (a = 0, t->nbins = 1; a < naxes; a++) {
+    t->nbins *= axes[a].n;
+    t->uniform[a] = histogram_ranges_uniform(axes[a].range, axes[a].n);
+    t->scale[a] = t->uniform[a] ?
+      (double) axes[a].n/(axes[a].range[axes[a].n] - axes[a].range[0]) : 0.0;
+  }
+  t->w = w; t->wstride = wstride; t->n = n;
+  t->weight = weight;
+}
+
+/*
+  Adds n points with coordinates axes[a].x to the naxes-dimensional
+  histogram of bins bin.  w may be NULL for the constant weight.  Must
+  be called with the GVL held.
+*/
+void mygsl_histogram_fill_nd(double *bin, mygsl_histogram_axis *axes, size_t naxes,
+			     const double *w, size_t wstride, double weight, size_t n)
+{
+  struct histogram_fill_task t;
+  size_t p, j;
+  if (n == 0) return;
+  histogram_fill_setup(&t, axes, naxes, w, wstride, weight, n);
+  t.nparts = GSL_MIN(HISTOGRAM_FILL_PARTS,
+		     n/GSL_MAX(HISTOGRAM_FILL_PART_MIN, 4*t.nbins));
+  if (t.nparts <= 1) {
+    t.nparts = t.nthreads = 1;
+    t.bins = bin;
+    rb_gsl_nogvl_call(histogram_fill_serial, &t, n*naxes);
+    return;
+  }
+  t.bins = ALLOC_N(double, t.nparts*t.nbins);
+  for (j = 0; j < t.nparts*t.nbins; j++) t.bins[j] = 0.0;
+  t.nthreads = rb_gsl_parallel_nthreads(n*naxes, t.nparts);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(histogram_fill_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(histogram_fill_serial, &t, n*naxes);
+  for (p = 0; p < t.nparts; p++)
+    for (j = 0; j < t.nbins; j++) bin[j] += t.bins[p*t.nbins + j];
+  xfree(t.bins);
+}
+
+/* The same on the calling thread, which may run without the GVL: for
+   kernels binning from their own workers */
+void mygsl_histogram_fill_nd_serial(double *bin, mygsl_histogram_axis *axes, size_t naxes,
+				    const double *w, size_t wstride, double weight, size_t n)
+{
+  struct histogram_fill_task t;
+  if (n == 0) return;
+  histogram_fill_setup(&t, axes, naxes, w, wstride, weight, n);
+  histogram_fill_range(&t, 0, n, bin);
+}
+
+void mygsl_histogram_fill(gsl_histogram *h, const double *x, size_t xstride,
+			  const double *w, size_t wstride, double weight, size_t n)
+{
+  mygsl_histogram_axis ax;
+  ax.range = h->range; ax.n = h->n; ax.x = x; ax.stride = xstride;
+  mygsl_histogram_fill_nd(h->bin, &ax, 1, w, wstride, weight, n);
+}
+
+/* Array or vector argument as a pointer and stride; an Array is copied
+   into a Vector returned through *keep */
+const double* rb_gsl_histogram_fill_data(VALUE a, size_t *stride, size_t *n, VALUE *keep)
+{
+  gsl_vector *v = NULL;
+  *keep = a;
+  if (TYPE(a) == T_ARRAY) {
+    v = make_cvector_from_rarray(a);
+    *keep = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  } else if (VECTOR_COMPLEX_P(a)) {
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(a)));
+  }
+  return get_vector_ptr(*keep, stride, n);
+}
+
+/* A weight argument: a number, stored in *weight (NULL is returned), or
+   an Array or vector of one weight per point */
+const double* rb_gsl_histogram_fill_weights(VALUE a, double *weight, size_t *stride,
+					    size_t *n, VALUE *keep)
+{
+  if (rb_obj_is_kind_of(a, rb_cNumeric) || TYPE(a) == T_STRING) {
+    Need_Float(a);
+    *weight = NUM2DBL(a);
+    *keep = Qnil;
+    return NULL;
+  }
+  return rb_gsl_histogram_fill_data(a, stride, n, keep);
+}
+
+/* The columns of an n x naxes Matrix as the coordinates of ax; returns n */
+size_t rb_gsl_histogram_fill_columns(VALUE vm, mygsl_histogram_axis *ax, size_t naxes)
+{
+  gsl_matrix *m = NULL;
+  size_t a;
+  CHECK_MATRIX(vm);
+  Data_Get_Struct(vm, gsl_matrix, m);
+  if (m->size2 != naxes)
+    rb_raise(rb_eArgError, "matrix has %d columns, %d expected", (int) m->size2, (int) naxes);
+  for (a = 0; a < naxes; a++) {
+    ax[a].x = m->data + a;
+    ax[a].stride = m->tda;
+  }
+  return m->size1;
+}
+
+/*
+  increment(x[, weight]): x is a number, an Array, a Vector, a
+  Vector::Int or an NArray; weight is a number, or an Array or Vector
+  with one weight per value.
+*/
 static VALUE rb_gsl_histogram_accumulate(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h = NULL;
-  gsl_vector *v;
   gsl_vector_int *vi;
-  size_t i;
+  VALUE kx = Qnil, kw = Qnil;
+  const double *x, *w = NULL;
+  size_t i, n, stride, nw = 0, wstride = 0;
   double weight = 1;
-#ifdef HAVE_NARRAY_H
-  double *ptr;
-  size_t size, stride;
-#endif
   switch (argc) {
   case 2:
-    Need_Float(argv[1]);
-    weight = NUM2DBL(argv[1]);
+    w = rb_gsl_histogram_fill_weights(argv[1], &weight, &wstride, &nw, &kw);
     break;
   case 1:
     weight = 1;
@@ -352,28 +588,26 @@ static VALUE rb_gsl_histogram_accumulate(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
     break;
   }
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
-  if (TYPE(argv[0]) == T_ARRAY) {
-    //    for (i = 0; i < RARRAY(argv[0])->len; i++)
-    for (i = 0; i < RARRAY_LEN(argv[0]); i++)
-      gsl_histogram_accumulate(h, NUM2DBL(rb_ary_entry(argv[0], i)), weight);
-  } else if (VECTOR_P(argv[0])) {
-    Data_Get_Struct(argv[0], gsl_vector, v);
-    for (i = 0; i < v->size; i++)
-      gsl_histogram_accumulate(h, gsl_vector_get(v, i), weight);
-  } else if (VECTOR_INT_P(argv[0])) {
+  if (VECTOR_INT_P(argv[0])) {
     Data_Get_Struct(argv[0], gsl_vector_int, vi);
+    if (w && nw != vi->size)
+      rb_raise(rb_eArgError, "%d values but %d weights", (int) vi->size, (int) nw);
     for (i = 0; i < vi->size; i++)
-      gsl_histogram_accumulate(h, (double)gsl_vector_int_get(vi, i), weight);
-#ifdef HAVE_NARRAY_H
-  } else if (NA_IsNArray(argv[0])) {
-    ptr = get_vector_ptr(argv[0], &stride, &size);
-    for (i = 0; i < size; i++) 
-      gsl_histogram_accumulate(h, ptr[i], weight);
-#endif
+      gsl_histogram_accumulate(h, (double)gsl_vector_int_get(vi, i),
+			       w ? w[i*wstride] : weight);
+  } else if (TYPE(argv[0]) == T_ARRAY || TYPE(argv[0]) == T_DATA) {
+    x = rb_gsl_histogram_fill_data(argv[0], &stride, &n, &kx);
+    if (w && nw != n)
+      rb_raise(rb_eArgError, "%d values but %d weights", (int) n, (int) nw);
+    mygsl_histogram_fill(h, x, stride, w, wstride, weight, n);
   } else {
+    if (w) rb_raise(rb_eArgError, "weights given for a single value");
     gsl_histogram_accumulate(h, NUM2DBL(argv[0]), weight);
   }
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(kw);
   return argv[0];
 }
 
@@ -395,6 +629,7 @@ static VALUE rb_gsl_histogram_accumulate2(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
     break;
   }
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   if (x < h->range[0]) x = h->range[0] + 4*GSL_DBL_EPSILON;
   if (x > h->range[h->n]) x = h->range[h->n] - 4*GSL_DBL_EPSILON;
@@ -437,6 +672,7 @@ static VALUE rb_gsl_histogram_min(VALUE obj)
 static VALUE rb_gsl_histogram_reset(VALUE obj)
 {
   gsl_histogram *h = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   gsl_histogram_reset(h);
   return obj;
@@ -519,6 +755,7 @@ static VALUE rb_gsl_histogram_normalize_bang(VALUE obj)
 {
   gsl_histogram *h = NULL;
   double scale;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   if (CLASS_OF(obj) == cgsl_histogram_integ)
     scale = 1.0/gsl_histogram_get(h, h->n-1);
@@ -634,6 +871,7 @@ static VALUE rb_gsl_histogram_add(VALUE obj, VALUE hh2)
 static VALUE rb_gsl_histogram_add2(VALUE obj, VALUE hh2)
 {
   gsl_histogram *h1 = NULL, *h2 = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h1);
   if (HISTOGRAM_P(hh2)) {
     Data_Get_Struct(hh2, gsl_histogram, h2);
@@ -663,6 +901,7 @@ static VALUE rb_gsl_histogram_sub(VALUE obj, VALUE hh2)
 static VALUE rb_gsl_histogram_sub2(VALUE obj, VALUE hh2)
 {
   gsl_histogram *h1 = NULL, *h2 = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h1);
   if (HISTOGRAM_P(hh2)) {
     Data_Get_Struct(hh2, gsl_histogram, h2);
@@ -692,6 +931,7 @@ static VALUE rb_gsl_histogram_mul(VALUE obj, VALUE hh2)
 static VALUE rb_gsl_histogram_mul2(VALUE obj, VALUE hh2)
 {
   gsl_histogram *h1 = NULL, *h2 = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h1);
   if (HISTOGRAM_P(hh2)) {
     Data_Get_Struct(hh2, gsl_histogram, h2);
@@ -721,6 +961,7 @@ static VALUE rb_gsl_histogram_div(VALUE obj, VALUE hh2)
 static VALUE rb_gsl_histogram_div2(VALUE obj, VALUE hh2)
 {
   gsl_histogram *h1 = NULL, *h2 = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h1);
   if (HISTOGRAM_P(hh2)) {
     Data_Get_Struct(hh2, gsl_histogram, h2);
@@ -736,6 +977,7 @@ static VALUE rb_gsl_histogram_scale_bang(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h = NULL;
   double scale;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   switch (argc) {
   case 0:
@@ -783,6 +1025,7 @@ static VALUE rb_gsl_histogram_shift(VALUE obj, VALUE shift)
 {
   gsl_histogram *h = NULL;
   Need_Float(shift);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   gsl_histogram_shift(h, NUM2DBL(shift));
   return obj;
@@ -798,26 +1041,40 @@ static VALUE rb_gsl_histogram_shift2(VALUE obj, VALUE shift)
   return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_histogram_free, hnew);
 }
 
-static VALUE rb_gsl_histogram_fwrite(VALUE obj, VALUE io)
+/* fwrite(io[, :compress => :zstd, :level => 3]): see compress.c */
+static VALUE rb_gsl_histogram_fwrite(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h = NULL;
   FILE *f;
-  int status, flag = 0;
+  VALUE io, opts;
+  void *seg[2];
+  size_t len[2];
+  int status, flag = 0, codec, level = 0;
+  rb_scan_args(argc, argv, "11", &io, &opts);
+  codec = rb_gsl_compress_options(opts, &level);
   Data_Get_Struct(obj, gsl_histogram, h);
   f = rb_gsl_open_writefile(io, &flag);
-  status = gsl_histogram_fwrite(f, h);
+  seg[0] = h->range; len[0] = h->n + 1;
+  seg[1] = h->bin; len[1] = h->n;
+  status = rb_gsl_zfwrite(f, codec, level, sizeof(double), seg, len, 2);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
 
+/* Reads raw or compressed data */
 static VALUE rb_gsl_histogram_fread(VALUE obj, VALUE io)
 {
   gsl_histogram *h = NULL;
   FILE *f;
+  void *seg[2];
+  size_t len[2];
   int status, flag = 0;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   f = rb_gsl_open_readfile(io, &flag);
-  status = gsl_histogram_fread(f, h);
+  seg[0] = h->range; len[0] = h->n + 1;
+  seg[1] = h->bin; len[1] = h->n;
+  status = rb_gsl_zfread(f, sizeof(double), seg, len, 2);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
@@ -864,6 +1121,7 @@ static VALUE rb_gsl_histogram_fscanf(VALUE obj, VALUE io)
   gsl_histogram *h = NULL;
   FILE *fp;
   int status, flag = 0;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   fp = rb_gsl_open_readfile(io, &flag);
   status = gsl_histogram_fscanf(fp, h);
@@ -914,12 +1172,34 @@ static VALUE rb_gsl_histogram_pdf_init(VALUE obj, VALUE hh)
 }
 #endif
 
-static VALUE rb_gsl_histogram_pdf_sample(VALUE obj, VALUE r)
+/* One draw from p, or a Vector of vn draws, with the uniforms of r */
+static VALUE histogram_pdf_draw(const gsl_histogram_pdf *p, gsl_rng *r, VALUE vn)
+{
+  gsl_vector *v;
+  size_t i, n;
+  if (NIL_P(vn)) return rb_float_new(gsl_histogram_pdf_sample(p, gsl_rng_uniform(r)));
+  n = NUM2SIZET(vn);
+  v = gsl_vector_alloc(n);
+  for (i = 0; i < n; i++)
+    gsl_vector_set(v, i, gsl_histogram_pdf_sample(p, gsl_rng_uniform(r)));
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+/* Pdf#sample(u) for a uniform u in [0, 1), or Pdf#sample(rng, n = nil) */
+static VALUE rb_gsl_histogram_pdf_sample(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram_pdf *p = NULL;
-  Need_Float(r);
+  gsl_rng *r;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
   Data_Get_Struct(obj, gsl_histogram_pdf, p);
-  return rb_float_new(gsl_histogram_pdf_sample(p, NUM2DBL(r)));
+  if (argc == 1 && !rb_obj_is_kind_of(argv[0], cgsl_rng)) {
+    Need_Float(argv[0]);
+    return rb_float_new(gsl_histogram_pdf_sample(p, NUM2DBL(argv[0])));
+  }
+  CHECK_RNG(argv[0]);
+  Data_Get_Struct(argv[0], gsl_rng, r);
+  return histogram_pdf_draw(p, r, argc == 2 ? argv[1] : Qnil);
 }
 
 static VALUE rb_gsl_histogram_pdf_range(VALUE obj)
@@ -950,7 +1230,8 @@ static VALUE rb_gsl_histogram_graph(int argc, VALUE *argv, VALUE obj)
 {
 #ifdef HAVE_GNU_GRAPH
   gsl_histogram *v = NULL;
-  FILE *fp = NULL;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
   size_t i;
   char command[1024];
   Data_Get_Struct(obj, gsl_histogram, v);
@@ -965,14 +1246,12 @@ static VALUE rb_gsl_histogram_graph(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
     break;
   }
-  fp = popen(command, "w");
-  if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
   for (i = 0; i < v->n; i++) {
-    fprintf(fp, "%e %e\n%e %e\n", v->range[i], v->bin[i], v->range[i+1], v->bin[i]);
+    rb_gsl_pipe_point(fp, v->range[i], v->bin[i]);
+    rb_gsl_pipe_point(fp, v->range[i+1], v->bin[i]);
   }
-  fflush(fp);
- pclose(fp);
-  fp = NULL;
+  rb_gsl_pipe_send(pipe, command, "GNU graph");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "not implemented");
@@ -984,34 +1263,26 @@ static VALUE rb_gsl_histogram_plot(int argc, VALUE *argv, VALUE obj)
 {
 #ifdef HAVE_GNU_GRAPH
   gsl_histogram *v = NULL;
-  FILE *fp = NULL;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
+  const char *opts = "with fsteps";
   size_t i;
   Data_Get_Struct(obj, gsl_histogram, v);
   switch (argc) {
   case 0:
-    fp = popen("gnuplot -persist", "w");
-    if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
-    fprintf(fp, "plot '-' with fsteps\n");
     break;
   case 1:
-    fp = popen("gnuplot -persist", "w");
-    if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
-    if (TYPE(argv[0]) == T_STRING) 
-      fprintf(fp, "plot '-' %s\n", STR2CSTR(argv[0]));    
-    else
-      fprintf(fp, "plot '-' with fsteps\n");
+    if (TYPE(argv[0]) == T_STRING) opts = STR2CSTR(argv[0]);
     break;
   default:
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
     break;
   }
-  for (i = 0; i < v->n; i++) {
-    fprintf(fp, "%e %e\n", v->range[i], v->bin[i]);
-  }
-  fprintf(fp, "e\n");
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  pipe = rb_gsl_pipe_new(1, &fp);
+  rb_gsl_pipe_gnuplot(fp, v->n, 2, opts);
+  for (i = 0; i < v->n; i++)
+    rb_gsl_pipe_point(fp, v->range[i], v->bin[i]);
+  rb_gsl_pipe_send(pipe, "gnuplot -persist", "gnuplot");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "not implemented");
@@ -1694,36 +1965,38 @@ static VALUE rb_gsl_histogram_rebin(int argc, VALUE *argv, VALUE obj)
 static int mygsl_histogram_fread2(FILE * stream, gsl_histogram * h)
 {  
   double min, max;
+  void *seg[3];
+  size_t len[3] = {1, 1, 0};
   int status;
-  status = gsl_block_raw_fread(stream, &min, 1, 1);
-  if (status)    return status;  
-  status = gsl_block_raw_fread(stream, &max, 1, 1);
+  seg[0] = &min; seg[1] = &max;
+  seg[2] = h->bin; len[2] = h->n;
+  status = rb_gsl_zfread(stream, sizeof(double), seg, len, 3);
   if (status)    return status;  
   gsl_histogram_set_ranges_uniform(h, min, max);
-  status = gsl_block_raw_fread (stream, h->bin, h->n, 1);  
-  if (status)    return status;  
   return status;
 }
 
-static int mygsl_histogram_fwrite2(FILE * stream, const gsl_histogram * h)
+static int mygsl_histogram_fwrite2(FILE * stream, const gsl_histogram * h,
+				   int codec, int level)
 {  
-  int status;
-  status = gsl_block_raw_fwrite (stream, h->range, 1, 1);
-  if (status)    return status;  
-  status = gsl_block_raw_fwrite (stream, h->range+h->n, 1, 1);
-  if (status)    return status;  
-  status = gsl_block_raw_fwrite (stream, h->bin, h->n, 1);  
-  return status;
+  void *seg[3];
+  size_t len[3] = {1, 1, 0};
+  seg[0] = h->range; seg[1] = h->range + h->n;
+  seg[2] = h->bin; len[2] = h->n;
+  return rb_gsl_zfwrite(stream, codec, level, sizeof(double), seg, len, 3);
 }
 
-static VALUE rb_gsl_histogram_fwrite2(VALUE obj, VALUE io)
+static VALUE rb_gsl_histogram_fwrite2(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h = NULL;
   FILE *f;
-  int status, flag = 0;
+  VALUE io, opts;
+  int status, flag = 0, codec, level = 0;
+  rb_scan_args(argc, argv, "11", &io, &opts);
+  codec = rb_gsl_compress_options(opts, &level);
   Data_Get_Struct(obj, gsl_histogram, h);
   f = rb_gsl_open_writefile(io, &flag);
-  status = mygsl_histogram_fwrite2(f, h);
+  status = mygsl_histogram_fwrite2(f, h, codec, level);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
@@ -1733,6 +2006,7 @@ static VALUE rb_gsl_histogram_fread2(VALUE obj, VALUE io)
   gsl_histogram *h = NULL;
   FILE *f;
   int status, flag = 0;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_histogram, h);
   f = rb_gsl_open_readfile(io, &flag);
   status = mygsl_histogram_fread2(f, h);
@@ -1761,46 +2035,120 @@ static VALUE rb_gsl_histogram_reverse(VALUE obj)
 
 /* The functions below are not included in GSL */
 /*
- * Returns an x value at which the histogram integration
- * reaches the given percentile. The x value is calculated
- * by an interpolation between the ranges in which the percentile
- * is found.
+ * Returns an x value at which the cumulative sums c (c[0] = 0,
+ * c[i+1] = c[i] + bin[i]) over the n bins of range reach sf. The
+ * bin is found by bisection, and x by an interpolation between its
+ * ranges; past the total, x is the end of the last nonempty bin.
  */
-static double histogram_percentile(const gsl_histogram *h, double f)
+static double histogram_cdf_x(const double *range, const double *c, size_t n,
+			      double sf)
+{
+  size_t lo = 0, hi = n - 1, mid;
+  if (sf >= c[n]) {
+    while (lo < hi) {
+      mid = (lo + hi)/2;
+      if (c[mid+1] >= c[n]) hi = mid; else lo = mid + 1;
+    }
+    return range[lo+1];
+  }
+  while (lo < hi) {
+    mid = (lo + hi)/2;
+    if (c[mid+1] > sf) hi = mid; else lo = mid + 1;
+  }
+  return range[lo] + (sf - c[lo])*(range[lo+1] - range[lo])/(c[lo+1] - c[lo]);
+}
+
+static double* histogram_cumsum(const gsl_histogram *h)
 {
-  double sum = gsl_histogram_sum(h), sf;
-  double val, s = 0, x;
-  double ri, ri1;
+  double *c = ALLOC_N(double, h->n + 1);
   size_t i;
-  sf = sum * f;
-  for (i = 0; i < h->n; i++) {
-    val = gsl_histogram_get(h, i);
-    if ((s+val) > sf) break;
-    s += val;
-  }
-  ri = h->range[i];
-  ri1 = h->range[i+1];
-  x = (sf - s)*(ri1 - ri)/val + ri;
-  return x;
+  c[0] = 0.0;
+  for (i = 0; i < h->n; i++) c[i+1] = c[i] + h->bin[i];
+  return c;
 }
 
-static double histogram_median(const gsl_histogram *h)
+/* The percentiles of f, a fraction or an Array or vector of them, by
+   the cumulative sums at range and c */
+static VALUE histogram_percentiles(const double *range, const double *c, size_t n,
+				   VALUE f, gsl_vector *v, const double *pf,
+				   size_t stride)
 {
-  return histogram_percentile(h, 0.5);
+  size_t i;
+  if (v == NULL) return rb_float_new(histogram_cdf_x(range, c, n, c[n]*NUM2DBL(f)));
+  for (i = 0; i < v->size; i++)
+    gsl_vector_set(v, i, histogram_cdf_x(range, c, n, c[n]*pf[i*stride]));
+  return Qnil;
 }
 
+/* Histogram#percentile(f): f is a fraction, or an Array or vector of
+   fractions (a Vector is returned) for which the cumulative sums are
+   computed once */
 static VALUE rb_gsl_histogram_percentile(VALUE obj, VALUE f)
 {
   gsl_histogram *h;
+  gsl_vector *v = NULL;
+  const double *pf = NULL;
+  double *c;
+  size_t stride = 1, n;
+  VALUE keep = Qnil, vv = Qnil, x;
   Data_Get_Struct(obj, gsl_histogram, h);
-  return rb_float_new(histogram_percentile(h, NUM2DBL(f)));
+  if (!rb_obj_is_kind_of(f, rb_cNumeric)) {
+    pf = rb_gsl_histogram_fill_data(f, &stride, &n, &keep);
+    v = gsl_vector_alloc(n);
+    vv = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  }
+  c = histogram_cumsum(h);
+  x = histogram_percentiles(h->range, c, h->n, f, v, pf, stride);
+  xfree(c);
+  RB_GC_GUARD(keep);
+  return v ? vv : x;
 }
 
 static VALUE rb_gsl_histogram_median(VALUE obj)
+{
+  return rb_gsl_histogram_percentile(obj, rb_float_new(0.5));
+}
+
+/* Histogram#sample(rng, n = nil): one value, or a Vector of n, drawn
+   from the distribution of the bins.  The Pdf is built once per call;
+   keep a Histogram::Pdf.alloc(h) to draw repeatedly. */
+static VALUE rb_gsl_histogram_sample(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h;
+  gsl_histogram_pdf *p;
+  gsl_rng *r;
+  VALUE vp, x;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_RNG(argv[0]);
   Data_Get_Struct(obj, gsl_histogram, h);
-  return rb_float_new(histogram_median(h));
+  Data_Get_Struct(argv[0], gsl_rng, r);
+  p = gsl_histogram_pdf_alloc(h->n);
+  vp = Data_Wrap_Struct(cgsl_histogram_pdf, 0, gsl_histogram_pdf_free, p);
+  gsl_histogram_pdf_init(p, h);
+  x = histogram_pdf_draw(p, r, argc == 2 ? argv[1] : Qnil);
+  RB_GC_GUARD(vp);
+  return x;
+}
+
+/* Pdf#percentile(f), as Histogram#percentile on the cumulative sums
+   kept by the Pdf */
+static VALUE rb_gsl_histogram_pdf_percentile(VALUE obj, VALUE f)
+{
+  gsl_histogram_pdf *p;
+  gsl_vector *v = NULL;
+  const double *pf = NULL;
+  size_t stride = 1, n;
+  VALUE keep = Qnil, vv = Qnil, x;
+  Data_Get_Struct(obj, gsl_histogram_pdf, p);
+  if (!rb_obj_is_kind_of(f, rb_cNumeric)) {
+    pf = rb_gsl_histogram_fill_data(f, &stride, &n, &keep);
+    v = gsl_vector_alloc(n);
+    vv = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  }
+  x = histogram_percentiles(p->range, p->sum, p->n, f, v, pf, stride);
+  RB_GC_GUARD(keep);
+  return v ? vv : x;
 }
 
 static double histogram_percentile_inv(const gsl_histogram *h, double x)
@@ -1828,9 +2176,9 @@ static VALUE rb_gsl_histogram_percentile_inv(VALUE obj, VALUE x)
   return rb_float_new(histogram_percentile_inv(h, NUM2DBL(x)));
 }
 
+void Init_gsl_histogram_sparse(VALUE module);
 void Init_gsl_histogram(VALUE module)
 {
-  VALUE cgsl_histogram_pdf;
 
   cgsl_histogram = rb_define_class_under(module, "Histogram", cGSL_Object);
   cgsl_histogram_range = rb_define_class_under(cgsl_histogram, "Range", 
@@ -1930,9 +2278,9 @@ void Init_gsl_histogram(VALUE module)
   rb_define_method(cgsl_histogram, "shift!", rb_gsl_histogram_shift, 1);
   rb_define_method(cgsl_histogram, "shift", rb_gsl_histogram_shift2, 1);
 
-  rb_define_method(cgsl_histogram, "fwrite", rb_gsl_histogram_fwrite, 1);
+  rb_define_method(cgsl_histogram, "fwrite", rb_gsl_histogram_fwrite, -1);
   rb_define_method(cgsl_histogram, "fread", rb_gsl_histogram_fread, 1);
-  rb_define_method(cgsl_histogram, "fwrite2", rb_gsl_histogram_fwrite2, 1);
+  rb_define_method(cgsl_histogram, "fwrite2", rb_gsl_histogram_fwrite2, -1);
   rb_define_method(cgsl_histogram, "fread2", rb_gsl_histogram_fread2, 1);
   rb_define_method(cgsl_histogram, "fprintf", rb_gsl_histogram_fprintf, -1);
   rb_define_method(cgsl_histogram, "printf", rb_gsl_histogram_printf, -1);
@@ -1947,7 +2295,8 @@ void Init_gsl_histogram(VALUE module)
 #ifdef GSL_0_9_4_LATER
   rb_define_method(cgsl_histogram_pdf, "init", rb_gsl_histogram_pdf_init, 1);
 #endif
-  rb_define_method(cgsl_histogram_pdf, "sample", rb_gsl_histogram_pdf_sample, 1);
+  rb_define_method(cgsl_histogram_pdf, "sample", rb_gsl_histogram_pdf_sample, -1);
+  rb_define_method(cgsl_histogram_pdf, "percentile", rb_gsl_histogram_pdf_percentile, 1);
 
   rb_define_method(cgsl_histogram_pdf, "range", rb_gsl_histogram_pdf_range, 0);
   rb_define_method(cgsl_histogram_pdf, "sum", rb_gsl_histogram_pdf_sum, 0);
@@ -1987,5 +2336,8 @@ void Init_gsl_histogram(VALUE module)
 
   rb_define_method(cgsl_histogram, "percentile", rb_gsl_histogram_percentile, 1);
   rb_define_method(cgsl_histogram, "median", rb_gsl_histogram_median, 0);
+  rb_define_method(cgsl_histogram, "sample", rb_gsl_histogram_sample, -1);
   rb_define_method(cgsl_histogram, "percentile_inv", rb_gsl_histogram_percentile_inv, 1);
+
+  Init_gsl_histogram_sparse(cgsl_histogram);
 }
@@ -18,6 +18,143 @@ VALUE cgsl_histogram2d;
 VALUE cgsl_histogram2d_view;
 static VALUE cgsl_histogram2d_integ;
 
+/*
+  Marginal sums of Histogram2d and Histogram3d.  The projections over
+  the whole of the other axes, the sums of the positive bins along each
+  axis (from which xmean, xsigma ... are computed) and the total are
+  filled in one pass over the bins the first time one is asked for,
+  then kept on the object until a method changes the bins: increment,
+  scale!, reset, fread ... call rb_gsl_histogram_modified().  Each sum
+  adds the bins in the order the direct computation does, so that the
+  results are the same to the last bit.
+
+  Bins reachable from outside, through #bin or the row views of #get,
+  may change unseen: rb_gsl_histogram_shared() turns the cache off for
+  good on the histogram, and views never cache.
+*/
+typedef struct {
+  int valid, shared;
+  size_t n;
+  double *v;
+} mygsl_histogram_marginals;
+
+static ID id_marginals;
+
+static void histogram_marginals_free(void *p)
+{
+  mygsl_histogram_marginals *m = (mygsl_histogram_marginals *) p;
+  if (m->v) xfree(m->v);
+  xfree(m);
+}
+
+static mygsl_histogram_marginals* histogram_marginals_of(VALUE obj, int create, VALUE *keep)
+{
+  mygsl_histogram_marginals *m = NULL;
+  VALUE c = rb_attr_get(obj, id_marginals);
+  if (NIL_P(c)) {
+    if (!create) return NULL;
+    c = Data_Make_Struct(0, mygsl_histogram_marginals, 0, histogram_marginals_free, m);
+    m->valid = m->shared = 0;
+    m->n = 0;
+    m->v = NULL;
+    /* a frozen histogram recomputes every time */
+    if (!OBJ_FROZEN(obj)) rb_ivar_set(obj, id_marginals, c);
+  }
+  Data_Get_Struct(c, mygsl_histogram_marginals, m);
+  if (keep) *keep = c;
+  return m;
+}
+
+/* The n marginal sums of obj, filled by fill(h, v) from zeros when not
+   up to date; valid while *keep is alive and the bins do not change */
+double* rb_gsl_histogram_marginals(VALUE obj, size_t n, void (*fill)(const void *, double *),
+				   const void *h, VALUE *keep)
+{
+  mygsl_histogram_marginals *m = histogram_marginals_of(obj, 1, keep);
+  size_t i;
+  if (m->valid && m->n == n) return m->v;
+  if (m->n != n) {
+    if (m->v) xfree(m->v);
+    m->v = ALLOC_N(double, n);
+    m->n = n;
+  }
+  for (i = 0; i < n; i++) m->v[i] = 0.0;
+  (*fill)(h, m->v);
+  m->valid = !m->shared;
+  return m->v;
+}
+
+void rb_gsl_histogram_modified(VALUE obj)
+{
+  mygsl_histogram_marginals *m = histogram_marginals_of(obj, 0, NULL);
+  if (m) m->valid = 0;
+}
+
+void rb_gsl_histogram_shared(VALUE obj)
+{
+  mygsl_histogram_marginals *m = histogram_marginals_of(obj, 1, NULL);
+  m->shared = 1;
+  m->valid = 0;
+}
+
+/* The weighted mean of the bin centres of range with the positive bin
+   sums w, as gsl_histogram2d_xmean computes it */
+double mygsl_histogram_marginal_mean(const double *range, const double *w, size_t n)
+{
+  double wmean = 0, W = 0, xi;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    xi = (range[i + 1] + range[i]) / 2.0;
+    if (w[i] > 0) {
+      W += w[i];
+      wmean += (xi - wmean) * (w[i] / W);
+    }
+  }
+  return wmean;
+}
+
+double mygsl_histogram_marginal_sigma(const double *range, const double *w, size_t n)
+{
+  const double mean = mygsl_histogram_marginal_mean(range, w, n);
+  double wvariance = 0, W = 0, xi;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    xi = (range[i + 1] + range[i]) / 2 - mean;
+    if (w[i] > 0) {
+      W += w[i];
+      wvariance += ((xi * xi) - wvariance) * (w[i] / W);
+    }
+  }
+  return sqrt(wvariance);
+}
+
+/* [x projection nx | y projection ny | positive sums along x nx, along
+   y ny | sum] */
+static void histogram2d_marginals_fill(const void *hh, double *v)
+{
+  const gsl_histogram2d *h = (const gsl_histogram2d *) hh;
+  const size_t nx = h->nx, ny = h->ny;
+  double *xp = v, *yp = v + nx, *xw = yp + ny, *yw = xw + nx, b, sum = 0;
+  size_t i, j;
+  for (i = 0; i < nx; i++) {
+    for (j = 0; j < ny; j++) {
+      b = h->bin[i*ny + j];
+      xp[i] += b;
+      yp[j] += b;
+      if (b > 0) { xw[i] += b; yw[j] += b; }
+      sum += b;
+    }
+  }
+  yw[ny] = sum;
+}
+
+static double* histogram2d_marginals(VALUE obj, gsl_histogram2d **h, VALUE *keep)
+{
+  Data_Get_Struct(obj, gsl_histogram2d, *h);
+  return rb_gsl_histogram_marginals(obj, 2*((*h)->nx + (*h)->ny) + 1,
+				    histogram2d_marginals_fill, *h, keep);
+}
+
 #ifdef GSL_0_9_4_LATER
 static VALUE rb_gsl_histogram2d_alloc_uniform(int argc, VALUE *argv, VALUE klass);
 static VALUE rb_gsl_histogram2d_alloc(int argc, VALUE *argv, VALUE klass)
@@ -134,6 +271,7 @@ static VALUE rb_gsl_histogram2d_set_ranges(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 4)", argc);
   }
   gsl_histogram2d_set_ranges(h, vx->data, xsize, vy->data, ysize);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -159,6 +297,7 @@ static VALUE rb_gsl_histogram2d_set_ranges_uniform(int argc, VALUE *argv, VALUE
   }
   Data_Get_Struct(obj, gsl_histogram2d, h);
   gsl_histogram2d_set_ranges_uniform(h, xmin, xmax, ymin, ymax);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -178,38 +317,61 @@ static VALUE rb_gsl_histogram2d_memcpy(VALUE obj, VALUE vhdest, VALUE vhsrc)
   Data_Get_Struct(vhdest, gsl_histogram2d, hdest);
   Data_Get_Struct(vhsrc, gsl_histogram2d, hsrc);
   gsl_histogram2d_memcpy(hdest, hsrc);
+  rb_gsl_histogram_modified(vhdest);
   return vhdest;
 }
 
+/*
+  increment(x, y[, weight]): x and y are numbers, or Arrays, Vectors
+  or NArrays filled in bulk (up to the shorter of the two).
+  increment(m[, weight]): the rows of an n x 2 Matrix as the points.
+  weight is a number, or an Array or Vector with one weight per point.
+*/
 static VALUE rb_gsl_histogram2d_accumulate(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  gsl_vector *vx, *vy;
-  size_t n, i;
+  mygsl_histogram_axis ax[2];
+  VALUE kx = Qnil, ky = Qnil, kw = Qnil;
+  const double *w = NULL;
+  size_t n, nx, ny, nw = 0, wstride = 0;
   double weight = 1;
-  switch (argc) {
-  case 3:
-    Need_Float(argv[2]);
-    weight = NUM2DBL(argv[2]);
-    break;
-  case 2:
-    weight = 1;
-    break;
-  default:
-    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
-    break;
-  }
-  Data_Get_Struct(obj, gsl_histogram2d, h);
-  if (VECTOR_P(argv[0]) && VECTOR_P(argv[1])) {
-    Data_Get_Struct(argv[0], gsl_vector, vx);
-    Data_Get_Struct(argv[1], gsl_vector, vy);
-    n = (size_t) GSL_MIN_INT((int) vx->size, (int) vy->size);
-    for (i = 0; i < n; i++)
-      gsl_histogram2d_accumulate(h, gsl_vector_get(vx, i), gsl_vector_get(vy, i),
-				 weight);
+  if (argc >= 1 && argc <= 2 && MATRIX_P(argv[0]) && (argc == 1 || !MATRIX_P(argv[1]))) {
+    n = rb_gsl_histogram_fill_columns(argv[0], ax, 2);
+    if (argc == 2) w = rb_gsl_histogram_fill_weights(argv[1], &weight, &wstride, &nw, &kw);
   } else {
-    gsl_histogram2d_accumulate(h, NUM2DBL(argv[0]), NUM2DBL(argv[1]), weight);
+    switch (argc) {
+    case 3:
+      w = rb_gsl_histogram_fill_weights(argv[2], &weight, &wstride, &nw, &kw);
+      break;
+    case 2:
+      weight = 1;
+      break;
+    default:
+      rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+      break;
+    }
+    if (!(TYPE(argv[0]) == T_ARRAY || TYPE(argv[0]) == T_DATA)
+	|| !(TYPE(argv[1]) == T_ARRAY || TYPE(argv[1]) == T_DATA)) {
+      if (w) rb_raise(rb_eArgError, "weights given for a single point");
+      Data_Get_Struct(obj, gsl_histogram2d, h);
+      gsl_histogram2d_accumulate(h, NUM2DBL(argv[0]), NUM2DBL(argv[1]), weight);
+      rb_gsl_histogram_modified(obj);
+      return obj;
+    }
+    ax[0].x = rb_gsl_histogram_fill_data(argv[0], &ax[0].stride, &nx, &kx);
+    ax[1].x = rb_gsl_histogram_fill_data(argv[1], &ax[1].stride, &ny, &ky);
+    n = GSL_MIN(nx, ny);
   }
+  if (w && nw != n)
+    rb_raise(rb_eArgError, "%d points but %d weights", (int) n, (int) nw);
+  Data_Get_Struct(obj, gsl_histogram2d, h);
+  ax[0].range = h->xrange; ax[0].n = h->nx;
+  ax[1].range = h->yrange; ax[1].n = h->ny;
+  mygsl_histogram_fill_nd(h->bin, ax, 2, w, wstride, weight, n);
+  rb_gsl_histogram_modified(obj);
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(ky);
+  RB_GC_GUARD(kw);
   return obj;
 }
 
@@ -236,6 +398,7 @@ static VALUE rb_gsl_histogram2d_accumulate2(int argc, VALUE *argv, VALUE obj)
   if (y < h->yrange[0]) y = h->yrange[0] + 4*GSL_DBL_EPSILON;
   if (y > h->yrange[h->ny]) y = h->yrange[h->ny] - 4*GSL_DBL_EPSILON;
   gsl_histogram2d_accumulate(h, x, y, weight);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -266,6 +429,7 @@ static VALUE rb_gsl_histogram2d_get(int argc, VALUE *argv, VALUE obj)
       h1->h.n = h2->ny;
       h1->h.range = h2->yrange;
       h1->h.bin = h2->bin + i*h2->ny;
+      rb_gsl_histogram_shared(obj);
       return Data_Wrap_Struct(cgsl_histogram2d_view, 0, free, h1);
       break;
     default:
@@ -388,29 +552,41 @@ static VALUE rb_gsl_histogram2d_min_bin(VALUE obj)
 static VALUE rb_gsl_histogram2d_xmean(VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  Data_Get_Struct(obj, gsl_histogram2d, h);
-  return rb_float_new(gsl_histogram2d_xmean(h));
+  VALUE keep;
+  double *v = histogram2d_marginals(obj, &h, &keep), r;
+  r = mygsl_histogram_marginal_mean(h->xrange, v + h->nx + h->ny, h->nx);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram2d_ymean(VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  Data_Get_Struct(obj, gsl_histogram2d, h);
-  return rb_float_new(gsl_histogram2d_ymean(h));
+  VALUE keep;
+  double *v = histogram2d_marginals(obj, &h, &keep), r;
+  r = mygsl_histogram_marginal_mean(h->yrange, v + 2*h->nx + h->ny, h->ny);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram2d_xsigma(VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  Data_Get_Struct(obj, gsl_histogram2d, h);
-  return rb_float_new(gsl_histogram2d_xsigma(h));
+  VALUE keep;
+  double *v = histogram2d_marginals(obj, &h, &keep), r;
+  r = mygsl_histogram_marginal_sigma(h->xrange, v + h->nx + h->ny, h->nx);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram2d_ysigma(VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  Data_Get_Struct(obj, gsl_histogram2d, h);
-  return rb_float_new(gsl_histogram2d_ysigma(h));
+  VALUE keep;
+  double *v = histogram2d_marginals(obj, &h, &keep), r;
+  r = mygsl_histogram_marginal_sigma(h->yrange, v + 2*h->nx + h->ny, h->ny);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram2d_cov(VALUE obj)
@@ -423,8 +599,11 @@ static VALUE rb_gsl_histogram2d_cov(VALUE obj)
 static VALUE rb_gsl_histogram2d_sum(VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  Data_Get_Struct(obj, gsl_histogram2d, h);
-  return rb_float_new(gsl_histogram2d_sum(h));
+  VALUE keep;
+  double *v = histogram2d_marginals(obj, &h, &keep), r;
+  r = v[2*(h->nx + h->ny)];
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 #endif
 
@@ -454,6 +633,7 @@ static VALUE rb_gsl_histogram2d_scale(VALUE obj, VALUE s)
   Need_Float(s);
   Data_Get_Struct(obj, gsl_histogram2d, h);
   gsl_histogram2d_scale(h, NUM2DBL(s));
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -463,6 +643,7 @@ static VALUE rb_gsl_histogram2d_shift(VALUE obj, VALUE s)
   Need_Float(s);
   Data_Get_Struct(obj, gsl_histogram2d, h);
   gsl_histogram2d_shift(h, NUM2DBL(s));
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -567,6 +748,7 @@ static VALUE rb_gsl_histogram2d_fread(VALUE obj, VALUE io)
   Data_Get_Struct(obj, gsl_histogram2d, h);
   f = rb_gsl_open_readfile(io, &flag);
   status = gsl_histogram2d_fread(f, h);
+  rb_gsl_histogram_modified(obj);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
@@ -600,6 +782,7 @@ static VALUE rb_gsl_histogram2d_fscanf(VALUE obj, VALUE io)
   Data_Get_Struct(obj, gsl_histogram2d, h);
   fp = rb_gsl_open_readfile(io, &flag);
   status = gsl_histogram2d_fscanf(fp, h);
+  rb_gsl_histogram_modified(obj);
   if (flag == 1) fclose(fp);
   return INT2FIX(status);
 }
@@ -609,6 +792,7 @@ static VALUE rb_gsl_histogram2d_reset(VALUE obj)
   gsl_histogram2d *h = NULL;
   Data_Get_Struct(obj, gsl_histogram2d, h);
   gsl_histogram2d_reset(h);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -686,6 +870,7 @@ static VALUE rb_gsl_histogram2d_bin(VALUE obj)
   v->vector.data = h->bin;
   v->vector.size = h->nx*h->ny;
   v->vector.stride = 1;
+  rb_gsl_histogram_shared(obj);
   return Data_Wrap_Struct(cgsl_histogram_bin, 0, gsl_vector_view_free, v);
 }
 
@@ -742,6 +927,8 @@ static VALUE rb_gsl_histogram2d_xproject(int argc, VALUE *argv, VALUE obj)
   gsl_histogram2d *h2 = NULL;
   gsl_histogram *h = NULL;
   size_t jstart = 0, jend;
+  double *v;
+  VALUE keep;
   Data_Get_Struct(obj, gsl_histogram2d, h2);
   switch (argc) {
   case 2:
@@ -759,7 +946,14 @@ static VALUE rb_gsl_histogram2d_xproject(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0-2)", argc);
     break;
   }
-  h = mygsl_histogram2d_calloc_xproject(h2, jstart, jend);
+  if (jstart == 0 && jend + 1 >= h2->ny) {
+    v = histogram2d_marginals(obj, &h2, &keep);
+    h = gsl_histogram_calloc_range(h2->nx, h2->xrange);
+    memcpy(h->bin, v, h2->nx*sizeof(double));
+    RB_GC_GUARD(keep);
+  } else {
+    h = mygsl_histogram2d_calloc_xproject(h2, jstart, jend);
+  }
   return Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, h);
 }
 
@@ -768,6 +962,8 @@ static VALUE rb_gsl_histogram2d_yproject(int argc, VALUE *argv, VALUE obj)
   gsl_histogram2d *h2 = NULL;
   gsl_histogram *h = NULL;
   size_t istart = 0, iend;
+  double *v;
+  VALUE keep;
   Data_Get_Struct(obj, gsl_histogram2d, h2);
   switch (argc) {
   case 2:
@@ -776,16 +972,23 @@ static VALUE rb_gsl_histogram2d_yproject(int argc, VALUE *argv, VALUE obj)
     break;
   case 1:
     istart = (size_t) FIX2INT(argv[0]);
-    iend = h2->ny;
+    iend = h2->nx;
     break;
   case 0:
-    iend = h2->ny;
+    iend = h2->nx;
     break;
   default:
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0-2)", argc);
     break;
   }
-  h = mygsl_histogram2d_calloc_yproject(h2, istart, iend);
+  if (istart == 0 && iend + 1 >= h2->nx) {
+    v = histogram2d_marginals(obj, &h2, &keep);
+    h = gsl_histogram_calloc_range(h2->ny, h2->yrange);
+    memcpy(h->bin, v + h2->nx, h2->ny*sizeof(double));
+    RB_GC_GUARD(keep);
+  } else {
+    h = mygsl_histogram2d_calloc_yproject(h2, istart, iend);
+  }
   return Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, h);
 }
 
@@ -842,6 +1045,7 @@ static VALUE rb_gsl_histogram2d_fread2(VALUE obj, VALUE io)
   Data_Get_Struct(obj, gsl_histogram2d, h);
   f = rb_gsl_open_readfile(io, &flag);
   status = mygsl_histogram2d_fread2(f, h);
+  rb_gsl_histogram_modified(obj);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
@@ -924,6 +1128,7 @@ static VALUE rb_gsl_histogram2d_normalize_bang(VALUE obj)
   else
     scale = 1.0/gsl_histogram2d_sum(h);
   gsl_histogram2d_scale(h, scale);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -939,6 +1144,7 @@ void Init_gsl_histogram2d(VALUE module)
 {
   VALUE cgsl_histogram2d_pdf;
 
+  id_marginals = rb_intern("__marginals__");
   cgsl_histogram2d = rb_define_class_under(module, "Histogram2d", cGSL_Object);
   cgsl_histogram2d_view = rb_define_class_under(cgsl_histogram2d, "View",
 						cgsl_histogram);
@@ -13,9 +13,53 @@
 #include "rb_gsl_common.h"
 #include "rb_gsl_array.h"
 
-static VALUE cgsl_histogram3d;
+VALUE cgsl_histogram3d;
 static VALUE cgsl_histogram3d_view;
 
+/* Marginal sums cached as for Histogram2d (see histogram2d.c):
+   [xy projection nx*ny | xz nx*nz | yz ny*nz | positive sums along x
+   nx, y ny, z nz | sum] */
+static void histogram3d_marginals_fill(const void *hh, double *v)
+{
+  const mygsl_histogram3d *h = (const mygsl_histogram3d *) hh;
+  const size_t nx = h->nx, ny = h->ny, nz = h->nz;
+  double *xy = v, *xz = xy + nx*ny, *yz = xz + nx*nz;
+  double *xw = yz + ny*nz, *yw = xw + nx, *zw = yw + ny, b, sum = 0;
+  size_t i, j, k;
+  for (i = 0; i < nx; i++) {
+    for (j = 0; j < ny; j++) {
+      for (k = 0; k < nz; k++) {
+	b = h->bin[(i*ny + j)*nz + k];
+	xy[i*ny + j] += b;
+	xz[i*nz + k] += b;
+	yz[j*nz + k] += b;
+	if (b > 0) { xw[i] += b; yw[j] += b; zw[k] += b; }
+	sum += b;
+      }
+    }
+  }
+  zw[nz] = sum;
+}
+
+static double* histogram3d_marginals(VALUE obj, mygsl_histogram3d **h, VALUE *keep)
+{
+  size_t nx, ny, nz;
+  Data_Get_Struct(obj, mygsl_histogram3d, *h);
+  nx = (*h)->nx; ny = (*h)->ny; nz = (*h)->nz;
+  return rb_gsl_histogram_marginals(obj, nx*ny + nx*nz + ny*nz + nx + ny + nz + 1,
+				    histogram3d_marginals_fill, *h, keep);
+}
+
+/* A projection from the cached marginals: the n1 x n2 sums at v */
+static VALUE histogram3d_projection(const double *v, const double *r1, size_t n1,
+				    const double *r2, size_t n2)
+{
+  gsl_histogram2d *h2 = gsl_histogram2d_calloc(n1, n2);
+  gsl_histogram2d_set_ranges(h2, r1, n1 + 1, r2, n2 + 1);
+  memcpy(h2->bin, v, n1*n2*sizeof(double));
+  return Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, h2);
+}
+
 static VALUE rb_gsl_histogram3d_new(int argc, VALUE *argv, VALUE klass)
 {
   mygsl_histogram3d *h = NULL;
@@ -155,9 +199,11 @@ static VALUE rb_gsl_histogram3d_zrange(VALUE obj)
 static VALUE rb_gsl_histogram3d_bin(VALUE obj)
 {
   mygsl_histogram3d *h = NULL;
-  size_t n = h->nx*h->ny*h->nz;
+  size_t n;
   gsl_vector_view *v = NULL;
   Data_Get_Struct(obj, mygsl_histogram3d, h);
+  n = h->nx*h->ny*h->nz;
+  rb_gsl_histogram_shared(obj);
   v = gsl_vector_view_alloc(n);
   v->vector.data = h->bin;
   v->vector.size = n;
@@ -165,6 +211,14 @@ static VALUE rb_gsl_histogram3d_bin(VALUE obj)
   return Data_Wrap_Struct(cgsl_vector_view, 0, gsl_vector_view_free, v);
 }
 
+/* A Histogram3d::View shares the bins of obj: neither caches */
+static VALUE histogram3d_view(VALUE obj, VALUE view)
+{
+  rb_gsl_histogram_shared(obj);
+  rb_gsl_histogram_shared(view);
+  return view;
+}
+
 static VALUE rb_gsl_histogram3d_get(int argc, VALUE *argv, VALUE obj)
 {
   mygsl_histogram3d *h = NULL;
@@ -183,7 +237,7 @@ static VALUE rb_gsl_histogram3d_get(int argc, VALUE *argv, VALUE obj)
       h2->h.xrange = h->yrange;
       h2->h.yrange = h->zrange;
       h2->h.bin = h->bin + i*h->ny*h->nz;
-      return Data_Wrap_Struct(cgsl_histogram3d_view, 0, free, h2);
+      return histogram3d_view(obj, Data_Wrap_Struct(cgsl_histogram3d_view, 0, free, h2));
       break;
     case T_ARRAY:
       //      switch (RARRAY(argv[0])->len) {
@@ -196,7 +250,7 @@ static VALUE rb_gsl_histogram3d_get(int argc, VALUE *argv, VALUE obj)
 	h2->h.xrange = h->yrange;
 	h2->h.yrange = h->zrange;
 	h2->h.bin = h->bin + i*h->ny*h->nz;
-	return Data_Wrap_Struct(cgsl_histogram3d_view, 0, free, h2);
+	return histogram3d_view(obj, Data_Wrap_Struct(cgsl_histogram3d_view, 0, free, h2));
 	break;
       case 2:
 	i = FIX2INT(rb_ary_entry(argv[0], 0));
@@ -205,6 +259,7 @@ static VALUE rb_gsl_histogram3d_get(int argc, VALUE *argv, VALUE obj)
 	h1->h.n = h->nz;
 	h1->h.range = h->zrange;
 	h1->h.bin = h->bin + i*h->ny*h->nz + j*h->nz;
+	rb_gsl_histogram_shared(obj);
 	return Data_Wrap_Struct(cgsl_histogram2d_view, 0, free, h1);    
 	break;
       case 3:
@@ -230,6 +285,7 @@ static VALUE rb_gsl_histogram3d_get(int argc, VALUE *argv, VALUE obj)
     h1->h.n = h->nz;
     h1->h.range = h->zrange;
     h1->h.bin = h->bin + i*h->ny*h->nz + j*h->nz;
+    rb_gsl_histogram_shared(obj);
     return Data_Wrap_Struct(cgsl_histogram2d_view, 0, free, h1);    
     break;
   case 3:
@@ -243,25 +299,60 @@ static VALUE rb_gsl_histogram3d_get(int argc, VALUE *argv, VALUE obj)
   return rb_float_new(mygsl_histogram3d_get(h, i, j, k));
 }
 
+/*
+  increment(x, y, z[, weight]): the coordinates are numbers, or Arrays,
+  Vectors or NArrays filled in bulk (up to the shortest).
+  increment(m[, weight]): the rows of an n x 3 Matrix as the points.
+  weight is a number, or an Array or Vector with one weight per point.
+*/
 static VALUE rb_gsl_histogram3d_increment(int argc, VALUE *argv, VALUE obj)
 {
   mygsl_histogram3d *h = NULL;
+  mygsl_histogram_axis ax[3];
+  VALUE kx = Qnil, ky = Qnil, kz = Qnil, kw = Qnil;
+  const double *w = NULL;
+  size_t n, nx, ny, nz, nw = 0, wstride = 0;
   double x, y, z, weight = 1;
-  switch (argc) {
-  case 4:
-    Need_Float(argv[3]);
-    weight = NUM2DBL(argv[3]);
-    /* no break */
-  case 3:
-    Need_Float(argv[0]); Need_Float(argv[1]); Need_Float(argv[2]);
-    x = NUM2DBL(argv[0]); y = NUM2DBL(argv[1]); z = NUM2DBL(argv[2]);
-    break;
-  default:
-    rb_raise(rb_eArgError, "wrong number of arugments (%d for 3 or 4", argc);
-    break;
+  if (argc >= 1 && argc <= 2 && MATRIX_P(argv[0])) {
+    n = rb_gsl_histogram_fill_columns(argv[0], ax, 3);
+    if (argc == 2) w = rb_gsl_histogram_fill_weights(argv[1], &weight, &wstride, &nw, &kw);
+  } else {
+    switch (argc) {
+    case 4:
+      w = rb_gsl_histogram_fill_weights(argv[3], &weight, &wstride, &nw, &kw);
+      /* no break */
+    case 3:
+      break;
+    default:
+      rb_raise(rb_eArgError, "wrong number of arugments (%d for 3 or 4", argc);
+      break;
+    }
+    if (!(TYPE(argv[0]) == T_ARRAY || TYPE(argv[0]) == T_DATA)) {
+      if (w) rb_raise(rb_eArgError, "weights given for a single point");
+      Need_Float(argv[0]); Need_Float(argv[1]); Need_Float(argv[2]);
+      x = NUM2DBL(argv[0]); y = NUM2DBL(argv[1]); z = NUM2DBL(argv[2]);
+      Data_Get_Struct(obj, mygsl_histogram3d, h);
+      mygsl_histogram3d_accumulate(h, x, y, z, weight);
+      rb_gsl_histogram_modified(obj);
+      return obj;
+    }
+    ax[0].x = rb_gsl_histogram_fill_data(argv[0], &ax[0].stride, &nx, &kx);
+    ax[1].x = rb_gsl_histogram_fill_data(argv[1], &ax[1].stride, &ny, &ky);
+    ax[2].x = rb_gsl_histogram_fill_data(argv[2], &ax[2].stride, &nz, &kz);
+    n = GSL_MIN(nx, GSL_MIN(ny, nz));
   }
+  if (w && nw != n)
+    rb_raise(rb_eArgError, "%d points but %d weights", (int) n, (int) nw);
   Data_Get_Struct(obj, mygsl_histogram3d, h);
-  mygsl_histogram3d_accumulate(h, x, y, z, weight);
+  ax[0].range = h->xrange; ax[0].n = h->nx;
+  ax[1].range = h->yrange; ax[1].n = h->ny;
+  ax[2].range = h->zrange; ax[2].n = h->nz;
+  mygsl_histogram_fill_nd(h->bin, ax, 3, w, wstride, weight, n);
+  rb_gsl_histogram_modified(obj);
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(ky);
+  RB_GC_GUARD(kz);
+  RB_GC_GUARD(kw);
   return obj;
 }
 
@@ -284,6 +375,7 @@ static VALUE rb_gsl_histogram3d_increment2(int argc, VALUE *argv, VALUE obj)
   }
   Data_Get_Struct(obj, mygsl_histogram3d, h);
   mygsl_histogram3d_accumulate2(h, x, y, z, weight);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -378,6 +470,7 @@ static VALUE rb_gsl_histogram3d_set_ranges(VALUE obj, VALUE xx, VALUE yy, VALUE
   if (flagz == 1) gsl_vector_free(zrange);
   if (flagy == 1) gsl_vector_free(yrange);
   if (flagx == 1) gsl_vector_free(xrange);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -407,6 +500,7 @@ static VALUE rb_gsl_histogram3d_set_ranges_uniform(int argc, VALUE *argv, VALUE
   }
   Data_Get_Struct(obj, mygsl_histogram3d, h);
   mygsl_histogram3d_set_ranges_uniform(h, xmin, xmax, ymin, ymax, zmin, zmax);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -416,6 +510,7 @@ static VALUE rb_gsl_histogram3d_memcpy(VALUE obj, VALUE a, VALUE b)
   Data_Get_Struct(a, mygsl_histogram3d, dst);
   Data_Get_Struct(b, mygsl_histogram3d, src);
   mygsl_histogram3d_memcpy(dst, src);
+  rb_gsl_histogram_modified(a);
   return a;
 }
 
@@ -432,6 +527,8 @@ static VALUE rb_gsl_histogram3d_xyproject(int argc, VALUE *argv, VALUE obj)
   mygsl_histogram3d *h3;
   gsl_histogram2d *h2;
   size_t kstart = 0, kend;
+  double *v;
+  VALUE keep, r;
   Data_Get_Struct(obj, mygsl_histogram3d, h3);
   switch (argc) {
   case 2:
@@ -449,6 +546,13 @@ static VALUE rb_gsl_histogram3d_xyproject(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0-2)", argc);
     break;
   }
+  if (kstart == 0 && kend + 1 >= h3->nz) {
+    v = histogram3d_marginals(obj, &h3, &keep);
+    r = histogram3d_projection(v, h3->xrange, h3->nx,
+			       h3->yrange, h3->ny);
+    RB_GC_GUARD(keep);
+    return r;
+  }
   h2 = mygsl_histogram3d_xyproject(h3, kstart, kend);
   return Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, h2);
 }
@@ -458,6 +562,8 @@ static VALUE rb_gsl_histogram3d_xzproject(int argc, VALUE *argv, VALUE obj)
   mygsl_histogram3d *h3;
   gsl_histogram2d *h2;
   size_t jstart = 0, jend;
+  double *v;
+  VALUE keep, r;
   Data_Get_Struct(obj, mygsl_histogram3d, h3);
   switch (argc) {
   case 2:
@@ -475,6 +581,13 @@ static VALUE rb_gsl_histogram3d_xzproject(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0-2)", argc);
     break;
   }
+  if (jstart == 0 && jend + 1 >= h3->ny) {
+    v = histogram3d_marginals(obj, &h3, &keep);
+    r = histogram3d_projection(v + h3->nx*h3->ny, h3->xrange, h3->nx,
+			       h3->zrange, h3->nz);
+    RB_GC_GUARD(keep);
+    return r;
+  }
   h2 = mygsl_histogram3d_xzproject(h3, jstart, jend);
   return Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, h2);
 }
@@ -484,6 +597,8 @@ static VALUE rb_gsl_histogram3d_yzproject(int argc, VALUE *argv, VALUE obj)
   mygsl_histogram3d *h3;
   gsl_histogram2d *h2;
   size_t istart = 0, iend;
+  double *v;
+  VALUE keep, r;
   Data_Get_Struct(obj, mygsl_histogram3d, h3);
   switch (argc) {
   case 2:
@@ -501,6 +616,13 @@ static VALUE rb_gsl_histogram3d_yzproject(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 0-2)", argc);
     break;
   }
+  if (istart == 0 && iend + 1 >= h3->nx) {
+    v = histogram3d_marginals(obj, &h3, &keep);
+    r = histogram3d_projection(v + h3->nx*(h3->ny + h3->nz), h3->yrange, h3->ny,
+			       h3->zrange, h3->nz);
+    RB_GC_GUARD(keep);
+    return r;
+  }
   h2 = mygsl_histogram3d_yzproject(h3, istart, iend);
   return Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, h2);
 }
@@ -510,6 +632,7 @@ static VALUE rb_gsl_histogram3d_scale_bang(VALUE obj, VALUE s)
   mygsl_histogram3d *h;
   Data_Get_Struct(obj, mygsl_histogram3d, h);
   mygsl_histogram3d_scale(h, NUM2DBL(s));
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -527,6 +650,7 @@ static VALUE rb_gsl_histogram3d_shift_bang(VALUE obj, VALUE s)
   mygsl_histogram3d *h;
   Data_Get_Struct(obj, mygsl_histogram3d, h);
   mygsl_histogram3d_shift(h, NUM2DBL(s));
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -601,6 +725,7 @@ static VALUE rb_gsl_histogram3d_fread(VALUE obj, VALUE io)
   Data_Get_Struct(obj, mygsl_histogram3d, h);
   f = rb_gsl_open_readfile(io, &flag);
   status = mygsl_histogram3d_fread(f, h);
+  rb_gsl_histogram_modified(obj);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
@@ -640,50 +765,78 @@ static VALUE rb_gsl_histogram3d_min_bin(VALUE obj)
 static VALUE rb_gsl_histogram3d_sum(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_sum(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = w[h->nx + h->ny + h->nz];
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_xmean(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_xmean(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = mygsl_histogram_marginal_mean(h->xrange, w, h->nx);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_ymean(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_ymean(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = mygsl_histogram_marginal_mean(h->yrange, w + h->nx, h->ny);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_zmean(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_zmean(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = mygsl_histogram_marginal_mean(h->zrange, w + h->nx + h->ny, h->nz);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_xsigma(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_xsigma(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = mygsl_histogram_marginal_sigma(h->xrange, w, h->nx);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_ysigma(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_ysigma(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = mygsl_histogram_marginal_sigma(h->yrange, w + h->nx, h->ny);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_zsigma(VALUE obj)
 {
   mygsl_histogram3d *h;
-  Data_Get_Struct(obj, mygsl_histogram3d, h);
-  return rb_float_new(mygsl_histogram3d_zsigma(h));
+  VALUE keep;
+  double *v = histogram3d_marginals(obj, &h, &keep), *w, r;
+  w = v + h->nx*h->ny + h->nx*h->nz + h->ny*h->nz;
+  r = mygsl_histogram_marginal_sigma(h->zrange, w + h->nx + h->ny, h->nz);
+  RB_GC_GUARD(keep);
+  return rb_float_new(r);
 }
 
 static VALUE rb_gsl_histogram3d_reset(VALUE obj)
@@ -691,6 +844,7 @@ static VALUE rb_gsl_histogram3d_reset(VALUE obj)
   mygsl_histogram3d *h;
   Data_Get_Struct(obj, mygsl_histogram3d, h);
   mygsl_histogram3d_reset(h);
+  rb_gsl_histogram_modified(obj);
   return obj;
 }
 
@@ -0,0 +1,517 @@
+/*
+  histogram_sparse.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  A histogram of bins of a fixed width over an unbounded range, holding
+  only the bins that were filled.
+
+    h = GSL::Histogram::Sparse.new(1e-6)   # width[, origin]
+    h.increment(x[, w]); h.increment(v[, weights])
+    h.mean; h.sigma; h.sum; h.percentile(0.99)
+    h.to_histogram                         # dense GSL::Histogram
+
+  Bin i is [origin + i*width, origin + (i + 1)*width), i a 63-bit
+  integer, kept in an open-addressing hash table.  to_histogram gives a
+  GSL::Histogram from the lowest to the highest filled bin with the same
+  edges, so the statistics of the two agree to the last bit.  NaNs and
+  infinities are skipped.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_histogram.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+static VALUE cgsl_histogram_sparse;
+
+#define SPARSE_EMPTY INT64_MIN
+#define SPARSE_MAXBIN 4.0e18
+
+typedef struct {
+  double width, origin;
+  size_t n, cap;                /* bins in use, table size (a power of 2) */
+  int64_t *key;
+  double *val;
+  int64_t kmin, kmax;
+} mygsl_histogram_sparse;
+
+typedef struct {
+  int64_t k;
+  double w;
+} mygsl_sparse_bin;
+
+static void mygsl_histogram_sparse_init(mygsl_histogram_sparse *h, size_t cap)
+{
+  size_t i;
+  h->n = 0;
+  h->cap = cap;
+  REALLOC_N(h->key, int64_t, cap);
+  REALLOC_N(h->val, double, cap);
+  for (i = 0; i < cap; i++) h->key[i] = SPARSE_EMPTY;
+  h->kmin = INT64_MAX;
+  h->kmax = INT64_MIN;
+}
+
+static void mygsl_histogram_sparse_free(mygsl_histogram_sparse *h)
+{
+  xfree(h->key);
+  xfree(h->val);
+  xfree(h);
+}
+
+static size_t sparse_hash(int64_t k, size_t cap)
+{
+  uint64_t z = (uint64_t) k;
+  z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (size_t) z & (cap - 1);
+}
+
+static double sparse_edge(const mygsl_histogram_sparse *h, int64_t k)
+{
+  return h->origin + (double) k*h->width;
+}
+
+/* The bin of x, whose edges are as given by sparse_edge */
+static int64_t sparse_bin(const mygsl_histogram_sparse *h, double x)
+{
+  double u = floor((x - h->origin)/h->width);
+  int64_t k;
+  if (!(fabs(u) < SPARSE_MAXBIN))
+    rb_raise(rb_eRangeError, "%g is too far from the origin for bins of width %g",
+	     x, h->width);
+  k = (int64_t) u;
+  while (sparse_edge(h, k) > x) k--;
+  while (sparse_edge(h, k + 1) <= x) k++;
+  return k;
+}
+
+static size_t sparse_slot(const mygsl_histogram_sparse *h, int64_t k)
+{
+  size_t i = sparse_hash(k, h->cap);
+  while (h->key[i] != k && h->key[i] != SPARSE_EMPTY) i = (i + 1) & (h->cap - 1);
+  return i;
+}
+
+static void sparse_grow(mygsl_histogram_sparse *h)
+{
+  int64_t *key = h->key, kmin = h->kmin, kmax = h->kmax;
+  double *val = h->val;
+  size_t cap = h->cap, n = h->n, i, j;
+  h->key = NULL; h->val = NULL;
+  mygsl_histogram_sparse_init(h, 2*cap);
+  for (i = 0; i < cap; i++) {
+    if (key[i] == SPARSE_EMPTY) continue;
+    j = sparse_slot(h, key[i]);
+    h->key[j] = key[i];
+    h->val[j] = val[i];
+  }
+  h->n = n; h->kmin = kmin; h->kmax = kmax;
+  xfree(key);
+  xfree(val);
+}
+
+static void mygsl_histogram_sparse_add_bin(mygsl_histogram_sparse *h, int64_t k, double w)
+{
+  size_t i;
+  if (2*(h->n + 1) > h->cap) sparse_grow(h);
+  i = sparse_slot(h, k);
+  if (h->key[i] == SPARSE_EMPTY) {
+    h->key[i] = k;
+    h->val[i] = 0.0;
+    h->n++;
+    if (k < h->kmin) h->kmin = k;
+    if (k > h->kmax) h->kmax = k;
+  }
+  h->val[i] += w;
+}
+
+static void mygsl_histogram_sparse_accumulate(mygsl_histogram_sparse *h, double x, double w)
+{
+  if (!gsl_finite(x)) return;
+  mygsl_histogram_sparse_add_bin(h, sparse_bin(h, x), w);
+}
+
+static double mygsl_histogram_sparse_get(const mygsl_histogram_sparse *h, int64_t k)
+{
+  size_t i = sparse_slot(h, k);
+  return h->key[i] == k ? h->val[i] : 0.0;
+}
+
+static int sparse_bin_cmp(const void *a, const void *b)
+{
+  int64_t ka = ((const mygsl_sparse_bin *) a)->k, kb = ((const mygsl_sparse_bin *) b)->k;
+  return ka < kb ? -1 : (ka > kb);
+}
+
+/* The bins in use in increasing order; the caller frees them */
+static mygsl_sparse_bin* mygsl_histogram_sparse_sorted(const mygsl_histogram_sparse *h)
+{
+  mygsl_sparse_bin *b = ALLOC_N(mygsl_sparse_bin, h->n + 1);
+  size_t i, m = 0;
+  for (i = 0; i < h->cap; i++) {
+    if (h->key[i] == SPARSE_EMPTY) continue;
+    b[m].k = h->key[i];
+    b[m].w = h->val[i];
+    m++;
+  }
+  qsort(b, m, sizeof(mygsl_sparse_bin), sparse_bin_cmp);
+  return b;
+}
+
+/* As gsl_histogram_sum, mean and sigma, over the bins in order */
+static double sparse_sum(const mygsl_sparse_bin *b, size_t m)
+{
+  double sum = 0;
+  size_t i;
+  for (i = 0; i < m; i++) sum += b[i].w;
+  return sum;
+}
+
+static long double sparse_mean(const mygsl_histogram_sparse *h,
+			       const mygsl_sparse_bin *b, size_t m)
+{
+  long double wmean = 0, W = 0;
+  double xi, wi;
+  size_t i;
+  for (i = 0; i < m; i++) {
+    xi = (sparse_edge(h, b[i].k + 1) + sparse_edge(h, b[i].k))/2;
+    wi = b[i].w;
+    if (wi > 0) {
+      W += wi;
+      wmean += (xi - wmean)*(wi/W);
+    }
+  }
+  return wmean;
+}
+
+static double sparse_sigma(const mygsl_histogram_sparse *h,
+			   const mygsl_sparse_bin *b, size_t m)
+{
+  long double wmean = sparse_mean(h, b, m), wvariance = 0, W = 0, delta;
+  double xi, wi;
+  size_t i;
+  for (i = 0; i < m; i++) {
+    xi = (sparse_edge(h, b[i].k + 1) + sparse_edge(h, b[i].k))/2;
+    wi = b[i].w;
+    if (wi > 0) {
+      delta = xi - wmean;
+      W += wi;
+      wvariance += (delta*delta - wvariance)*(wi/W);
+    }
+  }
+  return sqrt(wvariance);
+}
+
+/* As Histogram#percentile: x where the integral reaches the fraction f */
+static double sparse_percentile(const mygsl_histogram_sparse *h,
+				const mygsl_sparse_bin *b, size_t m, double f)
+{
+  double sf = sparse_sum(b, m)*f, s = 0;
+  size_t i;
+  if (m == 0) return GSL_NAN;
+  for (i = 0; i < m; i++) {
+    if (s + b[i].w > sf) break;
+    s += b[i].w;
+  }
+  if (i == m) return sparse_edge(h, b[m-1].k + 1);
+  return (sf - s)*h->width/b[i].w + sparse_edge(h, b[i].k);
+}
+
+static double sparse_percentile_inv(const mygsl_histogram_sparse *h,
+				    const mygsl_sparse_bin *b, size_t m, double x)
+{
+  double sum = sparse_sum(b, m), s = 0;
+  int64_t k;
+  size_t i;
+  if (m == 0 || gsl_isnan(x)) return GSL_NAN;
+  if (x < sparse_edge(h, b[0].k)) return 0.0;
+  if (x >= sparse_edge(h, b[m-1].k + 1)) return 1.0;
+  k = sparse_bin(h, x);
+  for (i = 0; i < m && b[i].k < k; i++) s += b[i].w;
+  if (i < m && b[i].k == k) s += b[i].w/h->width*(x - sparse_edge(h, k));
+  return s/sum;
+}
+
+/*****/
+
+static mygsl_histogram_sparse* get_sparse(VALUE obj)
+{
+  mygsl_histogram_sparse *h = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_histogram_sparse))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Histogram::Sparse expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  return h;
+}
+
+static VALUE rb_gsl_histogram_sparse_alloc(VALUE klass)
+{
+  mygsl_histogram_sparse *h = NULL;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_histogram_sparse, 0, mygsl_histogram_sparse_free, h);
+  h->key = NULL; h->val = NULL;
+  h->width = 1.0; h->origin = 0.0;
+  mygsl_histogram_sparse_init(h, 64);
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_initialize(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  double width, origin = 0.0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  width = NUM2DBL(argv[0]);
+  if (argc == 2) origin = NUM2DBL(argv[1]);
+  if (!(width > 0.0) || !gsl_finite(width) || !gsl_finite(origin))
+    rb_raise(rb_eArgError, "width must be positive and finite");
+  h->width = width;
+  h->origin = origin;
+  mygsl_histogram_sparse_init(h, 64);
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_init_copy(VALUE obj, VALUE orig)
+{
+  mygsl_histogram_sparse *h, *o;
+  if (obj == orig) return obj;
+  h = get_sparse(obj);
+  o = get_sparse(orig);
+  mygsl_histogram_sparse_init(h, o->cap);
+  memcpy(h->key, o->key, o->cap*sizeof(int64_t));
+  memcpy(h->val, o->val, o->cap*sizeof(double));
+  h->n = o->n; h->kmin = o->kmin; h->kmax = o->kmax;
+  h->width = o->width; h->origin = o->origin;
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_reset(VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  mygsl_histogram_sparse_init(h, 64);
+  return obj;
+}
+
+/* increment(x[, weight]): x a number, an Array, a Vector or an NArray,
+   weight a number or one weight per value */
+static VALUE rb_gsl_histogram_sparse_increment(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  VALUE kx = Qnil, kw = Qnil;
+  const double *x, *w = NULL;
+  size_t i, n, stride, nw = 0, wstride = 0;
+  double weight = 1.0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  if (argc == 2) w = rb_gsl_histogram_fill_weights(argv[1], &weight, &wstride, &nw, &kw);
+  if (rb_obj_is_kind_of(argv[0], rb_cNumeric)) {
+    if (w) rb_raise(rb_eArgError, "weights given for a single value");
+    mygsl_histogram_sparse_accumulate(h, NUM2DBL(argv[0]), weight);
+    return obj;
+  }
+  x = rb_gsl_histogram_fill_data(argv[0], &stride, &n, &kx);
+  if (w && nw != n)
+    rb_raise(rb_eArgError, "%d values but %d weights", (int) n, (int) nw);
+  for (i = 0; i < n; i++)
+    mygsl_histogram_sparse_accumulate(h, x[i*stride], w ? w[i*wstride] : weight);
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(kw);
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_add_bang(VALUE obj, VALUE other)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj), *o = get_sparse(other);
+  mygsl_sparse_bin *b;
+  size_t i, m;
+  if (h->width != o->width || h->origin != o->origin)
+    rb_raise(rb_eArgError, "histograms have different bins");
+  /* o may be h itself */
+  b = mygsl_histogram_sparse_sorted(o);
+  m = o->n;
+  for (i = 0; i < m; i++) mygsl_histogram_sparse_add_bin(h, b[i].k, b[i].w);
+  xfree(b);
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_add(VALUE obj, VALUE other)
+{
+  return rb_gsl_histogram_sparse_add_bang(rb_obj_dup(obj), other);
+}
+
+static VALUE rb_gsl_histogram_sparse_find(VALUE obj, VALUE x)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  double v = NUM2DBL(x);
+  if (!gsl_finite(v)) rb_raise(rb_eArgError, "x must be finite");
+  return LL2NUM(sparse_bin(h, v));
+}
+
+static VALUE rb_gsl_histogram_sparse_get(VALUE obj, VALUE i)
+{
+  return rb_float_new(mygsl_histogram_sparse_get(get_sparse(obj), NUM2LL(i)));
+}
+
+static VALUE rb_gsl_histogram_sparse_get_range(VALUE obj, VALUE i)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  int64_t k = NUM2LL(i);
+  return rb_ary_new3(2, rb_float_new(sparse_edge(h, k)), rb_float_new(sparse_edge(h, k + 1)));
+}
+
+static VALUE rb_gsl_histogram_sparse_bins(VALUE obj)
+{
+  return SIZET2NUM(get_sparse(obj)->n);
+}
+
+static VALUE rb_gsl_histogram_sparse_width(VALUE obj)
+{
+  return rb_float_new(get_sparse(obj)->width);
+}
+
+static VALUE rb_gsl_histogram_sparse_origin(VALUE obj)
+{
+  return rb_float_new(get_sparse(obj)->origin);
+}
+
+static VALUE rb_gsl_histogram_sparse_min(VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  if (h->n == 0) return rb_float_new(GSL_NAN);
+  return rb_float_new(sparse_edge(h, h->kmin));
+}
+
+static VALUE rb_gsl_histogram_sparse_max(VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  if (h->n == 0) return rb_float_new(GSL_NAN);
+  return rb_float_new(sparse_edge(h, h->kmax + 1));
+}
+
+/* One of the statistics above, over the sorted bins */
+static VALUE rb_gsl_histogram_sparse_eval(VALUE obj, int what, double arg)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  mygsl_sparse_bin *b = mygsl_histogram_sparse_sorted(h);
+  double r = 0.0;
+  switch (what) {
+  case 0: r = sparse_sum(b, h->n); break;
+  case 1: r = (double) sparse_mean(h, b, h->n); break;
+  case 2: r = sparse_sigma(h, b, h->n); break;
+  case 3: r = sparse_percentile(h, b, h->n, arg); break;
+  case 4: r = sparse_percentile_inv(h, b, h->n, arg); break;
+  }
+  xfree(b);
+  return rb_float_new(r);
+}
+
+static VALUE rb_gsl_histogram_sparse_sum(VALUE obj)
+{
+  return rb_gsl_histogram_sparse_eval(obj, 0, 0.0);
+}
+
+static VALUE rb_gsl_histogram_sparse_mean(VALUE obj)
+{
+  return rb_gsl_histogram_sparse_eval(obj, 1, 0.0);
+}
+
+static VALUE rb_gsl_histogram_sparse_sigma(VALUE obj)
+{
+  return rb_gsl_histogram_sparse_eval(obj, 2, 0.0);
+}
+
+static VALUE rb_gsl_histogram_sparse_percentile(VALUE obj, VALUE f)
+{
+  return rb_gsl_histogram_sparse_eval(obj, 3, NUM2DBL(f));
+}
+
+static VALUE rb_gsl_histogram_sparse_median(VALUE obj)
+{
+  return rb_gsl_histogram_sparse_eval(obj, 3, 0.5);
+}
+
+static VALUE rb_gsl_histogram_sparse_percentile_inv(VALUE obj, VALUE x)
+{
+  return rb_gsl_histogram_sparse_eval(obj, 4, NUM2DBL(x));
+}
+
+/* [[i, weight], ...] for the bins in use, in increasing order */
+static VALUE rb_gsl_histogram_sparse_to_a(VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  mygsl_sparse_bin *b = mygsl_histogram_sparse_sorted(h);
+  VALUE ary = rb_ary_new2(h->n);
+  size_t i;
+  for (i = 0; i < h->n; i++)
+    rb_ary_store(ary, i, rb_ary_new3(2, LL2NUM(b[i].k), rb_float_new(b[i].w)));
+  xfree(b);
+  return ary;
+}
+
+/* The dense histogram from the lowest to the highest bin in use */
+static VALUE rb_gsl_histogram_sparse_to_histogram(VALUE obj)
+{
+  mygsl_histogram_sparse *h = get_sparse(obj);
+  gsl_histogram *d = NULL;
+  double span;
+  size_t n, i, j;
+  if (h->n == 0) rb_raise(rb_eRuntimeError, "histogram is empty");
+  span = (double) h->kmax - (double) h->kmin + 1.0;
+  if (span > (double) (SIZE_MAX/sizeof(double)) - 1.0)
+    rb_raise(rb_eRangeError, "%g bins are too many for a dense histogram", span);
+  n = (size_t) (h->kmax - h->kmin) + 1;
+  d = gsl_histogram_calloc(n);
+  if (d == NULL) rb_raise(rb_eNoMemError, "gsl_histogram_calloc failed");
+  for (i = 0; i <= n; i++) d->range[i] = sparse_edge(h, h->kmin + (int64_t) i);
+  for (i = 0; i < h->cap; i++) {
+    if (h->key[i] == SPARSE_EMPTY) continue;
+    j = (size_t) (h->key[i] - h->kmin);
+    d->bin[j] = h->val[i];
+  }
+  return Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, d);
+}
+
+void Init_gsl_histogram_sparse(VALUE module)
+{
+  cgsl_histogram_sparse = rb_define_class_under(module, "Sparse", cGSL_Object);
+  rb_define_alloc_func(cgsl_histogram_sparse, rb_gsl_histogram_sparse_alloc);
+  rb_define_method(cgsl_histogram_sparse, "initialize", rb_gsl_histogram_sparse_initialize, -1);
+  rb_define_method(cgsl_histogram_sparse, "initialize_copy", rb_gsl_histogram_sparse_init_copy, 1);
+  rb_define_method(cgsl_histogram_sparse, "reset", rb_gsl_histogram_sparse_reset, 0);
+  rb_define_method(cgsl_histogram_sparse, "increment", rb_gsl_histogram_sparse_increment, -1);
+  rb_define_alias(cgsl_histogram_sparse, "fill", "increment");
+  rb_define_alias(cgsl_histogram_sparse, "accumulate", "increment");
+  rb_define_method(cgsl_histogram_sparse, "add!", rb_gsl_histogram_sparse_add_bang, 1);
+  rb_define_method(cgsl_histogram_sparse, "add", rb_gsl_histogram_sparse_add, 1);
+  rb_define_alias(cgsl_histogram_sparse, "+", "add");
+  rb_define_method(cgsl_histogram_sparse, "find", rb_gsl_histogram_sparse_find, 1);
+  rb_define_method(cgsl_histogram_sparse, "get", rb_gsl_histogram_sparse_get, 1);
+  rb_define_alias(cgsl_histogram_sparse, "[]", "get");
+  rb_define_method(cgsl_histogram_sparse, "get_range", rb_gsl_histogram_sparse_get_range, 1);
+  rb_define_method(cgsl_histogram_sparse, "bins", rb_gsl_histogram_sparse_bins, 0);
+  rb_define_alias(cgsl_histogram_sparse, "n", "bins");
+  rb_define_alias(cgsl_histogram_sparse, "size", "bins");
+  rb_define_method(cgsl_histogram_sparse, "width", rb_gsl_histogram_sparse_width, 0);
+  rb_define_method(cgsl_histogram_sparse, "origin", rb_gsl_histogram_sparse_origin, 0);
+  rb_define_method(cgsl_histogram_sparse, "min", rb_gsl_histogram_sparse_min, 0);
+  rb_define_method(cgsl_histogram_sparse, "max", rb_gsl_histogram_sparse_max, 0);
+  rb_define_method(cgsl_histogram_sparse, "sum", rb_gsl_histogram_sparse_sum, 0);
+  rb_define_alias(cgsl_histogram_sparse, "integral", "sum");
+  rb_define_method(cgsl_histogram_sparse, "mean", rb_gsl_histogram_sparse_mean, 0);
+  rb_define_method(cgsl_histogram_sparse, "sigma", rb_gsl_histogram_sparse_sigma, 0);
+  rb_define_method(cgsl_histogram_sparse, "percentile", rb_gsl_histogram_sparse_percentile, 1);
+  rb_define_method(cgsl_histogram_sparse, "median", rb_gsl_histogram_sparse_median, 0);
+  rb_define_method(cgsl_histogram_sparse, "percentile_inv", rb_gsl_histogram_sparse_percentile_inv, 1);
+  rb_define_method(cgsl_histogram_sparse, "to_a", rb_gsl_histogram_sparse_to_a, 0);
+  rb_define_method(cgsl_histogram_sparse, "to_histogram", rb_gsl_histogram_sparse_to_histogram, 0);
+  rb_define_alias(cgsl_histogram_sparse, "to_dense", "to_histogram");
+}
@@ -15,6 +15,7 @@
 #include "rb_gsl_function.h"
 #include "rb_gsl_integration.h"
 #include "rb_gsl_common.h"
+#include "rb_gsl_profiler.h"
 
 #ifndef CHECK_WORKSPACE
 #define CHECK_WORKSPACE(x) if(CLASS_OF(x)!=cgsl_integration_workspace)\
@@ -53,6 +54,250 @@ static int get_epsabs_epsrel_limit_workspace(int argc, VALUE *argv, int argstart
 					     size_t *limit,
 					     gsl_integration_workspace **w);
 
+/* Per-thread pool of the workspaces and QAWS/QAWO tables allocated by
+   the integration methods when none is given, keyed by the workspace
+   limit or the table parameters and evicted least-recently-used first.
+   An entry stays busy while its integral runs, so that an integrand
+   integrating in turn gets another one: the methods run under
+   integ_guarded, which gives back what a call at its depth took even
+   when an exception (a GSL error, say) leaves the call. */
+enum {
+  INTEG_POOL_WORKSPACE,
+  INTEG_POOL_QAWS,
+  INTEG_POOL_QAWO,
+};
+
+/* The owner of a workspace or table: the caller, the method (which frees
+   it), or the pool */
+enum {
+  INTEG_GIVEN,
+  INTEG_OWNED,
+  INTEG_POOLED,
+};
+
+#define INTEG_POOL_MAX 64
+#define INTEG_POOL_DEFAULT 16
+
+struct integ_pool_entry {
+  int kind, busy;               /* busy: the depth of the call using it */
+  size_t n;                     /* limit, or QAWO levels */
+  double p[2];                  /* alpha, beta or omega, L */
+  int i[2];                     /* mu, nu or sine */
+  void *ptr;
+  unsigned long used;
+};
+
+struct integ_pool {
+  size_t len;
+  int depth;
+  unsigned long clock, hits, misses;
+  struct integ_pool_entry e[INTEG_POOL_MAX];
+};
+
+static RB_GSL_THREAD_LOCAL struct integ_pool integ_pool;
+static size_t integ_pool_capacity = INTEG_POOL_DEFAULT;
+
+static void* integ_pool_alloc(int kind, size_t n, const double p[2], const int i[2])
+{
+  switch (kind) {
+  case INTEG_POOL_WORKSPACE:
+    return gsl_integration_workspace_alloc(n);
+  case INTEG_POOL_QAWS:
+    return gsl_integration_qaws_table_alloc(p[0], p[1], i[0], i[1]);
+  case INTEG_POOL_QAWO:
+    return gsl_integration_qawo_table_alloc(p[0], p[1], i[0], n);
+  }
+  return NULL;
+}
+
+static void integ_pool_free(int kind, void *ptr)
+{
+  switch (kind) {
+  case INTEG_POOL_WORKSPACE:
+    gsl_integration_workspace_free(ptr);
+    break;
+  case INTEG_POOL_QAWS:
+    gsl_integration_qaws_table_free(ptr);
+    break;
+  case INTEG_POOL_QAWO:
+    gsl_integration_qawo_table_free(ptr);
+    break;
+  }
+}
+
+/* Drop idle least-recently-used entries until at most max remain */
+static void integ_pool_shrink(struct integ_pool *c, size_t max)
+{
+  size_t i, lru;
+  while (c->len > max) {
+    lru = c->len;
+    for (i = 0; i < c->len; i++)
+      if (!c->e[i].busy && (lru == c->len || c->e[i].used < c->e[lru].used)) lru = i;
+    if (lru == c->len) break;
+    integ_pool_free(c->e[lru].kind, c->e[lru].ptr);
+    c->e[lru] = c->e[--c->len];
+  }
+}
+
+RB_GSL_PROF_ENTRY(integ_alloc_prof, "GSL::Integration workspace")
+
+/* Returns an idle workspace or table of the given kind and parameters
+   (a QAWO table of any length for L = NaN), busy until integ_pool_put.
+   *owner is INTEG_OWNED when the pool is disabled or full of busy
+   entries.  Only to be called under integ_guarded. */
+static void* integ_pool_get(int kind, size_t n, double p0, double p1, int i0, int i1,
+			    int *owner)
+{
+  struct integ_pool *c = &integ_pool;
+  struct integ_pool_entry *e;
+  double p[2];
+  int iv[2];
+  size_t k;
+  void *ptr;
+  p[0] = p0; p[1] = p1; iv[0] = i0; iv[1] = i1;
+  if (c->depth == 0) rb_raise(rb_eRuntimeError, "integration pool used outside a guard");
+  for (k = 0; k < c->len; k++) {
+    e = &c->e[k];
+    if (e->busy || e->kind != kind || e->n != n) continue;
+    if (kind != INTEG_POOL_WORKSPACE
+	&& (e->p[0] != p[0] || (e->p[1] != p[1] && !gsl_isnan(p[1]))
+	    || e->i[0] != iv[0] || e->i[1] != iv[1]))
+      continue;
+    e->used = ++c->clock;
+    e->busy = c->depth;
+    c->hits++;
+    *owner = INTEG_POOLED;
+    return e->ptr;
+  }
+  c->misses++;
+  if (gsl_isnan(p[1])) p[1] = 1.0;
+  RB_GSL_PROF_SECTION(integ_alloc_prof, ptr = integ_pool_alloc(kind, n, p, iv));
+  *owner = INTEG_OWNED;
+  if (ptr == NULL || integ_pool_capacity == 0) return ptr;
+  integ_pool_shrink(c, integ_pool_capacity - 1);
+  if (c->len >= integ_pool_capacity) return ptr;
+  e = &c->e[c->len++];
+  e->kind = kind;
+  e->n = n;
+  e->p[0] = p[0]; e->p[1] = p[1];
+  e->i[0] = iv[0]; e->i[1] = iv[1];
+  e->ptr = ptr;
+  e->busy = c->depth;
+  e->used = ++c->clock;
+  *owner = INTEG_POOLED;
+  return ptr;
+}
+
+/* Gives back what integ_pool_get (or the caller) provided */
+static void integ_pool_put(int kind, void *ptr, int owner)
+{
+  struct integ_pool *c = &integ_pool;
+  size_t k;
+  if (ptr == NULL) return;
+  if (owner == INTEG_OWNED) {
+    integ_pool_free(kind, ptr);
+  } else if (owner == INTEG_POOLED) {
+    for (k = 0; k < c->len; k++) {
+      if (c->e[k].ptr == ptr) {
+	c->e[k].busy = 0;
+	/* qawf changes the length of its table */
+	if (kind == INTEG_POOL_QAWO) c->e[k].p[1] = ((gsl_integration_qawo_table *) ptr)->L;
+	break;
+      }
+    }
+  }
+}
+
+static gsl_integration_workspace* integ_workspace(size_t limit, int *owner)
+{
+  return integ_pool_get(INTEG_POOL_WORKSPACE, limit, 0, 0, 0, 0, owner);
+}
+
+static void integ_workspace_put(gsl_integration_workspace *w, int owner)
+{
+  integ_pool_put(INTEG_POOL_WORKSPACE, w, owner);
+}
+
+struct integ_guard_arg {
+  VALUE (*func)(int, VALUE *, VALUE);
+  int argc;
+  VALUE *argv, obj;
+};
+
+static VALUE integ_guard_body(VALUE p)
+{
+  struct integ_guard_arg *a = (struct integ_guard_arg *) p;
+  return (*a->func)(a->argc, a->argv, a->obj);
+}
+
+/* Gives back the entries still held at this depth, left by an exception */
+static VALUE integ_guard_ensure(VALUE p)
+{
+  struct integ_pool *c = &integ_pool;
+  size_t k;
+  for (k = 0; k < c->len; k++)
+    if (c->e[k].busy == c->depth) c->e[k].busy = 0;
+  c->depth--;
+  return Qnil;
+}
+
+/* func(argc, argv, obj), which may take pool entries */
+static VALUE integ_guarded(VALUE (*func)(int, VALUE *, VALUE), int argc, VALUE *argv,
+			   VALUE obj)
+{
+  struct integ_guard_arg a;
+  a.func = func;
+  a.argc = argc;
+  a.argv = argv;
+  a.obj = obj;
+  integ_pool.depth++;
+  return rb_ensure(integ_guard_body, (VALUE) &a, integ_guard_ensure, Qnil);
+}
+
+/* The guarded method, counted by GSL::Profiler as label */
+#define INTEG_GUARDED(name, label) \
+  static VALUE name##_guarded(int argc, VALUE *argv, VALUE obj) \
+  { return integ_guarded(name, argc, argv, obj); } \
+  RB_GSL_PROFILED(name##_guarded, label)
+
+static VALUE rb_gsl_integration_cache_stats(VALUE module)
+{
+  VALUE hash = rb_hash_new();
+  size_t k, busy = 0;
+  for (k = 0; k < integ_pool.len; k++) busy += integ_pool.e[k].busy;
+  rb_hash_aset(hash, ID2SYM(rb_intern("hits")), ULONG2NUM(integ_pool.hits));
+  rb_hash_aset(hash, ID2SYM(rb_intern("misses")), ULONG2NUM(integ_pool.misses));
+  rb_hash_aset(hash, ID2SYM(rb_intern("size")), SIZET2NUM(integ_pool.len));
+  rb_hash_aset(hash, ID2SYM(rb_intern("busy")), SIZET2NUM(busy));
+  rb_hash_aset(hash, ID2SYM(rb_intern("capacity")), SIZET2NUM(integ_pool_capacity));
+  return hash;
+}
+
+/* Frees the idle entries of this thread (all of them, unless called
+   from an integrand) */
+static VALUE rb_gsl_integration_cache_clear(VALUE module)
+{
+  integ_pool_shrink(&integ_pool, 0);
+  integ_pool.hits = 0;
+  integ_pool.misses = 0;
+  return module;
+}
+
+static VALUE rb_gsl_integration_cache_capacity(VALUE module)
+{
+  return SIZET2NUM(integ_pool_capacity);
+}
+
+static VALUE rb_gsl_integration_set_cache_capacity(VALUE module, VALUE val)
+{
+  long n = NUM2LONG(val);
+  if (n < 0) rb_raise(rb_eArgError, "cache capacity must be non-negative");
+  if (n > INTEG_POOL_MAX) n = INTEG_POOL_MAX;
+  integ_pool_capacity = (size_t) n;
+  integ_pool_shrink(&integ_pool, integ_pool_capacity);
+  return val;
+}
+
 static int get_a_b(int argc, VALUE *argv, int argstart, double *a, double *b)
 {
   int itmp;
@@ -131,16 +376,14 @@ static int get_limit_key_workspace(int argc, VALUE *argv, int argstart,
     CHECK_FIXNUM(argv[argstart]);
     *key = FIX2INT(argv[argstart]);
     *limit = LIMIT_DEFAULT;
-    *w = gsl_integration_workspace_alloc(*limit);
-    flag = 1;
+    *w = integ_workspace(*limit, &flag);
     break;
   case 2:
     if (TYPE(argv[argc-1]) == T_FIXNUM) {
       CHECK_FIXNUM(argv[argc-2]);
       *limit = FIX2INT(argv[argc-2]);
       *key = FIX2INT(argv[argc-1]);
-      *w = gsl_integration_workspace_alloc(*limit);
-      flag = 1;
+      *w = integ_workspace(*limit, &flag);
     } else {
       CHECK_FIXNUM(argv[argc-2]);
       CHECK_WORKSPACE(argv[argc-1]);
@@ -153,8 +396,7 @@ static int get_limit_key_workspace(int argc, VALUE *argv, int argstart,
   case 0:
     *key = KEY_DEFAULT;
     *limit = LIMIT_DEFAULT;
-    *w = gsl_integration_workspace_alloc(*limit);
-    flag = 1;
+    *w = integ_workspace(*limit, &flag);
     break;
   default:
     rb_raise(rb_eArgError, "wrong number of arguments");
@@ -180,8 +422,7 @@ static int get_limit_workspace(int argc, VALUE *argv, int argstart,
     break;
   case 0:
     *limit = LIMIT_DEFAULT;
-    *w = gsl_integration_workspace_alloc(*limit);
-    flag = 1;
+    *w = integ_workspace(*limit, &flag);
     break;
   case 1:
     switch (TYPE(argv[argstart])) {
@@ -189,8 +430,7 @@ static int get_limit_workspace(int argc, VALUE *argv, int argstart,
     case T_BIGNUM:
       CHECK_FIXNUM(argv[argstart]);
       *limit = FIX2INT(argv[argstart]);
-      *w = gsl_integration_workspace_alloc(*limit);
-      flag = 1;
+      *w = integ_workspace(*limit, &flag);
       break;
     default:
       CHECK_WORKSPACE(argv[argc-1]);
@@ -220,14 +460,12 @@ static int get_epsabs_epsrel_limit_workspace(int argc, VALUE *argv, int argstart
   *limit = LIMIT_DEFAULT;
   switch (argc-itmp) {
   case 0:
-    *w = gsl_integration_workspace_alloc(*limit);
-    flag = 1;
+    *w = integ_workspace(*limit, &flag);
     break;
   case 1:
     if (TYPE(argv[itmp]) == T_ARRAY) {
       get_epsabs_epsrel(argc, argv, itmp, epsabs, epsrel);
-      *w = gsl_integration_workspace_alloc(*limit);
-      flag = 1;
+      *w = integ_workspace(*limit, &flag);
     } else {
       flag = get_limit_workspace(argc, argv, itmp, limit, w);
     }
@@ -241,8 +479,7 @@ static int get_epsabs_epsrel_limit_workspace(int argc, VALUE *argv, int argstart
       break;
     case T_FLOAT:
       get_epsabs_epsrel(argc, argv, itmp, epsabs, epsrel);
-      *w = gsl_integration_workspace_alloc(*limit);
-      flag = 1;
+      *w = integ_workspace(*limit, &flag);
       break;
     default:
       flag = get_limit_workspace(argc, argv, itmp, limit, w);
@@ -311,14 +548,12 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
       CHECK_FIXNUM(argv[2]);
       get_a_b(argc, argv, 1, &a, &b);
       key = FIX2INT(argv[2]);
-      w = gsl_integration_workspace_alloc(limit);
-      flag = 1;
+      w = integ_workspace(limit, &flag);
     } else if (argc == 4) {
       CHECK_FIXNUM(argv[3]);
       get_a_b(argc, argv, 1, &a, &b);
       key = FIX2INT(argv[3]);
-      w = gsl_integration_workspace_alloc(limit);
-      flag = 1;
+      w = integ_workspace(limit, &flag);
     } else {
       itmp = get_a_b_epsabs_epsrel(argc, argv, 1, &a, &b, &epsabs, &epsrel);
       flag = get_limit_key_workspace(argc, argv, itmp, &limit, &key, &w);
@@ -328,8 +563,7 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
     if (argc == 2) {
       if (FIXNUM_P(argv[1])) {
 	key = FIX2INT(argv[1]);
-	w = gsl_integration_workspace_alloc(limit);
-	flag = 1;
+	w = integ_workspace(limit, &flag);
       } else if (rb_obj_is_kind_of(argv[1], cgsl_integration_workspace)) {
 	Data_Get_Struct(argv[1], gsl_integration_workspace, w);
 	flag = 0;
@@ -340,8 +574,7 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
     } else if (argc == 3) {
       if (FIXNUM_P(argv[2])) {
 	key = FIX2INT(argv[2]);
-	w = gsl_integration_workspace_alloc(limit);
-	flag = 1;
+	w = integ_workspace(limit, &flag);
       } else if (rb_obj_is_kind_of(argv[2], cgsl_integration_workspace)) {
 	Data_Get_Struct(argv[2], gsl_integration_workspace, w);
 	flag = 0;
@@ -359,7 +592,7 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qag(F, a, b, epsabs, epsrel, limit, key, w, 
 			       &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
 		     INT2FIX(intervals), INT2FIX(status));
@@ -390,7 +623,7 @@ static VALUE rb_gsl_integration_qags(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qags(F, a, b, epsabs, epsrel, limit, w, 
 				&result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
       INT2FIX(intervals), INT2FIX(status));
@@ -430,7 +663,7 @@ static VALUE rb_gsl_integration_qagp(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagp(F, v->data, v->size, epsabs, epsrel, limit, w, 
 				&result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
   if (flag2 == 1) gsl_vector_free(v);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
@@ -462,7 +695,7 @@ static VALUE rb_gsl_integration_qagi(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagi(F, epsabs, epsrel, limit, w, 
 				&result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
 		    INT2FIX(intervals), INT2FIX(status));
@@ -496,7 +729,7 @@ static VALUE rb_gsl_integration_qagiu(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagiu(F, a, epsabs, epsrel, limit, w, 
 				&result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
 		     INT2FIX(intervals), INT2FIX(status));
@@ -531,7 +764,7 @@ static VALUE rb_gsl_integration_qagil(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagil(F, b, epsabs, epsrel, limit, w, 
 				&result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
 		     INT2FIX(intervals), INT2FIX(status));
@@ -564,7 +797,7 @@ static VALUE rb_gsl_integration_qawc(int argc, VALUE *argv, VALUE obj)
 					   &limit, &w);
   status = gsl_integration_qawc(F, a, b, c, epsabs, epsrel, limit, w, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  integ_workspace_put(w, flag);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), INT2FIX(intervals),
 		     INT2FIX(status));
@@ -654,6 +887,14 @@ static gsl_integration_qaws_table* make_qaws_table(VALUE ary)
   return gsl_integration_qaws_table_alloc(alpha, beta, mu, nu);
 }
 
+/* The table for [alpha, beta, mu, nu], from the pool */
+static gsl_integration_qaws_table* pooled_qaws_table(VALUE ary, int *owner)
+{
+  return integ_pool_get(INTEG_POOL_QAWS, 0, NUM2DBL(rb_ary_entry(ary, 0)),
+			NUM2DBL(rb_ary_entry(ary, 1)), FIX2INT(rb_ary_entry(ary, 2)),
+			FIX2INT(rb_ary_entry(ary, 3)), owner);
+}
+
 static VALUE rb_gsl_integration_qaws(int argc, VALUE *argv, VALUE obj)
 {
   double a, b, epsabs, epsrel;
@@ -679,8 +920,7 @@ static VALUE rb_gsl_integration_qaws(int argc, VALUE *argv, VALUE obj)
   itmp = get_a_b(argc, argv, itmp, &a, &b);
 
   if (TYPE(argv[itmp]) == T_ARRAY) {
-    flagt = 1;
-    t = make_qaws_table(argv[itmp]);
+    t = pooled_qaws_table(argv[itmp], &flagt);
   } else {
     flagt = 0;
     if (!rb_obj_is_kind_of(argv[itmp], cgsl_integration_qaws_table))
@@ -692,8 +932,8 @@ static VALUE rb_gsl_integration_qaws(int argc, VALUE *argv, VALUE obj)
 					   &limit, &w);
   status = gsl_integration_qaws(F, a, b, t, epsabs, epsrel, limit, w, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
-  if (flagt == 1) gsl_integration_qaws_table_free(t);
+  integ_workspace_put(w, flag);
+  integ_pool_put(INTEG_POOL_QAWS, t, flagt);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), INT2FIX(intervals),
 		     INT2FIX(status));
@@ -826,8 +1066,8 @@ static VALUE rb_gsl_integration_qawo(int argc, VALUE *argv, VALUE obj)
 					   &limit, &w);
   status = gsl_integration_qawo(F, a, epsabs, epsrel, limit, w, t, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
-  if (flagt == 1) gsl_integration_qawo_table_free(t);
+  integ_workspace_put(w, flag);
+  integ_pool_put(INTEG_POOL_QAWO, t, flagt);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), INT2FIX(intervals),
 		     INT2FIX(status));
@@ -839,8 +1079,9 @@ static int get_qawo_table(VALUE tt,
   int flagt;
 
   if (TYPE(tt) == T_ARRAY) {
-    flagt = 1;
-    *t = make_qawo_table(tt);
+    *t = integ_pool_get(INTEG_POOL_QAWO, FIX2INT(rb_ary_entry(tt, 3)),
+			NUM2DBL(rb_ary_entry(tt, 0)), NUM2DBL(rb_ary_entry(tt, 1)),
+			FIX2INT(rb_ary_entry(tt, 2)), 0, &flagt);
   } else {
     flagt = 0;
     if (!rb_obj_is_kind_of(tt, cgsl_integration_qawo_table))
@@ -858,7 +1099,7 @@ static VALUE rb_gsl_integration_qawf(int argc, VALUE *argv, VALUE obj)
   gsl_function *F = NULL;
   gsl_integration_workspace *w = NULL, *cw = NULL;
   gsl_integration_qawo_table *t = NULL;
-  int status, intervals, flag = 0, flagt = 0, itmp;
+  int status, intervals, flag = 0, flagc = 0, flagt = 0, itmp;
   VALUE *vtmp;
   switch (TYPE(obj)) {
   case T_MODULE:  case T_CLASS:  case T_OBJECT:
@@ -885,16 +1126,14 @@ static VALUE rb_gsl_integration_qawf(int argc, VALUE *argv, VALUE obj)
 
   switch (argc - 1 - itmp) {
   case 0:
-    w = gsl_integration_workspace_alloc(limit);
-    cw = gsl_integration_workspace_alloc(limit);
-    flag = 1;
+    w = integ_workspace(limit, &flag);
+    cw = integ_workspace(limit, &flagc);
     break;
   case 1:
     CHECK_FIXNUM(vtmp[0]);
     limit = FIX2INT(vtmp[0]);
-    w = gsl_integration_workspace_alloc(limit);
-    cw = gsl_integration_workspace_alloc(limit);
-    flag = 1;
+    w = integ_workspace(limit, &flag);
+    cw = integ_workspace(limit, &flagc);
     break;
   case 2:
     CHECK_WORKSPACE(vtmp[0]); CHECK_WORKSPACE(vtmp[1]);
@@ -917,16 +1156,366 @@ static VALUE rb_gsl_integration_qawf(int argc, VALUE *argv, VALUE obj)
 
   status = gsl_integration_qawf(F, a, epsabs, limit, w, cw, t, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) {
-    gsl_integration_workspace_free(w);
-    gsl_integration_workspace_free(cw);
-  }
-  if (flagt == 1) gsl_integration_qawo_table_free(t);
+  integ_workspace_put(w, flag);
+  integ_workspace_put(cw, flagc);
+  integ_pool_put(INTEG_POOL_QAWO, t, flagt);
 
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), 
 		     INT2FIX(intervals), INT2FIX(status));
 }			    
 
+INTEG_GUARDED(rb_gsl_integration_qag, "GSL::Integration.qag")
+INTEG_GUARDED(rb_gsl_integration_qags, "GSL::Integration.qags")
+INTEG_GUARDED(rb_gsl_integration_qagp, "GSL::Integration.qagp")
+INTEG_GUARDED(rb_gsl_integration_qagi, "GSL::Integration.qagi")
+INTEG_GUARDED(rb_gsl_integration_qagiu, "GSL::Integration.qagiu")
+INTEG_GUARDED(rb_gsl_integration_qagil, "GSL::Integration.qagil")
+INTEG_GUARDED(rb_gsl_integration_qawc, "GSL::Integration.qawc")
+INTEG_GUARDED(rb_gsl_integration_qaws, "GSL::Integration.qaws")
+INTEG_GUARDED(rb_gsl_integration_qawo, "GSL::Integration.qawo")
+INTEG_GUARDED(rb_gsl_integration_qawf, "GSL::Integration.qawf")
+
+/*
+  GSL::Integration::Integrator: the tolerances, limit and rule of the
+  adaptive routines fixed once, the workspaces and tables taken from the
+  pool of the calling thread.  An integrator holds nothing that a call
+  changes, so one can serve all threads.
+
+    q = GSL::Integration::Integrator.alloc(200, :epsrel => 1e-8)
+    q.qags(f, 0, 1)                     # [result, abserr, intervals, status]
+    q.qawo(f, 0, omega, 2*PI, GSL::Integration::SINE)
+*/
+static VALUE cgsl_integration_integrator;
+
+#define INTEG_QAWO_LEVELS 25
+
+typedef struct {
+  size_t limit, levels;
+  int key;
+  double epsabs, epsrel;
+} mygsl_integrator;
+
+/* alloc([limit,] opts): opts :key, :epsabs, :epsrel and :levels (QAWO) */
+static VALUE rb_gsl_integrator_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_integrator *q = NULL;
+  VALUE obj, opts = Qnil, v;
+  if (argc > 0 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  obj = Data_Make_Struct(klass, mygsl_integrator, 0, free, q);
+  q->limit = argc == 1 ? NUM2SIZET(argv[0]) : LIMIT_DEFAULT;
+  q->key = KEY_DEFAULT;
+  q->epsabs = EPSABS_DEFAULT;
+  q->epsrel = EPSREL_DEFAULT;
+  q->levels = INTEG_QAWO_LEVELS;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("key"))))) q->key = NUM2INT(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsabs"))))) q->epsabs = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsrel"))))) q->epsrel = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("levels"))))) q->levels = NUM2SIZET(v);
+  }
+  if (q->limit == 0) rb_raise(rb_eArgError, "limit must be positive");
+  if (q->key < GSL_INTEG_GAUSS15 || q->key > GSL_INTEG_GAUSS61)
+    rb_raise(rb_eArgError, "unknown key %d", q->key);
+  return obj;
+}
+
+static mygsl_integrator* get_integrator(VALUE obj)
+{
+  mygsl_integrator *q = NULL;
+  Data_Get_Struct(obj, mygsl_integrator, q);
+  return q;
+}
+
+static gsl_function* integrator_function(int argc, VALUE *argv, int nargs)
+{
+  gsl_function *F = NULL;
+  if (argc != nargs)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for %d)", argc, nargs);
+  CHECK_FUNCTION(argv[0]);
+  Data_Get_Struct(argv[0], gsl_function, F);
+  return F;
+}
+
+static VALUE integrator_result(double result, double abserr, size_t intervals, int status)
+{
+  return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
+		     INT2FIX(intervals), INT2FIX(status));
+}
+
+/* The common end of the integrator methods: w and t given back */
+#define INTEGRATOR_RETURN(kind, t, towner) do { \
+    intervals = w->size; \
+    integ_workspace_put(w, owner); \
+    integ_pool_put(kind, t, towner); \
+    return integrator_result(result, abserr, intervals, status); \
+  } while (0)
+
+/* qag(f, a, b) */
+static VALUE rb_gsl_integrator_qag(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 3);
+  double a = NUM2DBL(argv[1]), b = NUM2DBL(argv[2]), result, abserr;
+  gsl_integration_workspace *w;
+  size_t intervals;
+  int status, owner;
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qag(F, a, b, q->epsabs, q->epsrel, q->limit, q->key, w,
+			       &result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qags(f, a, b) */
+static VALUE rb_gsl_integrator_qags(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 3);
+  double a = NUM2DBL(argv[1]), b = NUM2DBL(argv[2]), result, abserr;
+  gsl_integration_workspace *w;
+  size_t intervals;
+  int status, owner;
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qags(F, a, b, q->epsabs, q->epsrel, q->limit, w,
+				&result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qagp(f, pts): pts a Vector or an Array of the end points and singularities */
+static VALUE rb_gsl_integrator_qagp(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 2);
+  gsl_vector *v = NULL;
+  gsl_integration_workspace *w;
+  double result, abserr;
+  size_t intervals;
+  int status, owner;
+  VALUE pts = argv[1];
+  if (TYPE(pts) == T_ARRAY) {
+    v = make_cvector_from_rarray(pts);
+    pts = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  }
+  Data_Get_Vector(pts, v);
+  if (v->stride != 1) {
+    v = make_vector_clone(v);
+    pts = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  }
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qagp(F, v->data, v->size, q->epsabs, q->epsrel, q->limit, w,
+				&result, &abserr);
+  RB_GC_GUARD(pts);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qagi(f): over (-inf, +inf) */
+static VALUE rb_gsl_integrator_qagi(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 1);
+  gsl_integration_workspace *w;
+  double result, abserr;
+  size_t intervals;
+  int status, owner;
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qagi(F, q->epsabs, q->epsrel, q->limit, w, &result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qagiu(f, a): over (a, +inf) */
+static VALUE rb_gsl_integrator_qagiu(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 2);
+  double a = NUM2DBL(argv[1]), result, abserr;
+  gsl_integration_workspace *w;
+  size_t intervals;
+  int status, owner;
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qagiu(F, a, q->epsabs, q->epsrel, q->limit, w,
+				 &result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qagil(f, b): over (-inf, b) */
+static VALUE rb_gsl_integrator_qagil(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 2);
+  double b = NUM2DBL(argv[1]), result, abserr;
+  gsl_integration_workspace *w;
+  size_t intervals;
+  int status, owner;
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qagil(F, b, q->epsabs, q->epsrel, q->limit, w,
+				 &result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qawc(f, a, b, c): the Cauchy principal value of f/(x - c) */
+static VALUE rb_gsl_integrator_qawc(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 4);
+  double a = NUM2DBL(argv[1]), b = NUM2DBL(argv[2]), c = NUM2DBL(argv[3]);
+  double result, abserr;
+  gsl_integration_workspace *w;
+  size_t intervals;
+  int status, owner;
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qawc(F, a, b, c, q->epsabs, q->epsrel, q->limit, w,
+				&result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_WORKSPACE, NULL, INTEG_GIVEN);
+}
+
+/* qaws(f, a, b, [alpha, beta, mu, nu]) or qaws(f, a, b, table) */
+static VALUE rb_gsl_integrator_qaws(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 4);
+  double a = NUM2DBL(argv[1]), b = NUM2DBL(argv[2]), result, abserr;
+  gsl_integration_workspace *w;
+  gsl_integration_qaws_table *t = NULL;
+  size_t intervals;
+  int status, owner, towner = INTEG_GIVEN;
+  if (TYPE(argv[3]) == T_ARRAY) {
+    t = pooled_qaws_table(argv[3], &towner);
+  } else {
+    if (!rb_obj_is_kind_of(argv[3], cgsl_integration_qaws_table))
+      rb_raise(rb_eTypeError, "Integration::QAWS_Table expected");
+    Data_Get_Struct(argv[3], gsl_integration_qaws_table, t);
+  }
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qaws(F, a, b, t, q->epsabs, q->epsrel, q->limit, w,
+				&result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_QAWS, t, towner);
+}
+
+/* qawo(f, a, omega, L, sine): f(x) sin(omega x) (or cos) over (a, a + L) */
+static VALUE rb_gsl_integrator_qawo(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 5);
+  double a = NUM2DBL(argv[1]), result, abserr;
+  gsl_integration_workspace *w;
+  gsl_integration_qawo_table *t;
+  size_t intervals;
+  int status, owner, towner;
+  t = integ_pool_get(INTEG_POOL_QAWO, q->levels, NUM2DBL(argv[2]), NUM2DBL(argv[3]),
+		     NUM2INT(argv[4]), 0, &towner);
+  w = integ_workspace(q->limit, &owner);
+  status = gsl_integration_qawo(F, a, q->epsabs, q->epsrel, q->limit, w, t,
+				&result, &abserr);
+  INTEGRATOR_RETURN(INTEG_POOL_QAWO, t, towner);
+}
+
+/* qawf(f, a, omega, sine): f(x) sin(omega x) (or cos) over (a, +inf), to epsabs */
+static VALUE rb_gsl_integrator_qawf(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  gsl_function *F = integrator_function(argc, argv, 4);
+  double a = NUM2DBL(argv[1]), result, abserr;
+  gsl_integration_workspace *w, *cw;
+  gsl_integration_qawo_table *t;
+  size_t intervals;
+  int status, owner, cowner, towner;
+  t = integ_pool_get(INTEG_POOL_QAWO, q->levels, NUM2DBL(argv[2]), GSL_NAN,
+		     NUM2INT(argv[3]), 0, &towner);
+  w = integ_workspace(q->limit, &owner);
+  cw = integ_workspace(q->limit, &cowner);
+  status = gsl_integration_qawf(F, a, q->epsabs, q->limit, w, cw, t, &result, &abserr);
+  integ_workspace_put(cw, cowner);
+  INTEGRATOR_RETURN(INTEG_POOL_QAWO, t, towner);
+}
+
+/* qag_vector(f, a, b[, opts]): GSL::Integration.qag_vector with the
+   tolerances and limit of the integrator */
+static VALUE rb_gsl_integrator_qag_vector(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_integrator *q = get_integrator(obj);
+  VALUE opts = Qnil;
+  if (argc == 4) opts = argv[3];
+  else if (argc != 3) rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+  return rb_gsl_integration_qag_vector_run(argv[0], NUM2DBL(argv[1]), NUM2DBL(argv[2]),
+					   q->epsabs, q->epsrel, q->limit, opts);
+}
+
+INTEG_GUARDED(rb_gsl_integrator_qag, "GSL::Integration::Integrator#qag")
+INTEG_GUARDED(rb_gsl_integrator_qags, "GSL::Integration::Integrator#qags")
+INTEG_GUARDED(rb_gsl_integrator_qagp, "GSL::Integration::Integrator#qagp")
+INTEG_GUARDED(rb_gsl_integrator_qagi, "GSL::Integration::Integrator#qagi")
+INTEG_GUARDED(rb_gsl_integrator_qagiu, "GSL::Integration::Integrator#qagiu")
+INTEG_GUARDED(rb_gsl_integrator_qagil, "GSL::Integration::Integrator#qagil")
+INTEG_GUARDED(rb_gsl_integrator_qawc, "GSL::Integration::Integrator#qawc")
+INTEG_GUARDED(rb_gsl_integrator_qaws, "GSL::Integration::Integrator#qaws")
+INTEG_GUARDED(rb_gsl_integrator_qawo, "GSL::Integration::Integrator#qawo")
+INTEG_GUARDED(rb_gsl_integrator_qawf, "GSL::Integration::Integrator#qawf")
+
+#undef INTEGRATOR_RETURN
+
+static VALUE rb_gsl_integrator_limit(VALUE obj)
+{
+  return SIZET2NUM(get_integrator(obj)->limit);
+}
+
+static VALUE rb_gsl_integrator_key(VALUE obj)
+{
+  return INT2FIX(get_integrator(obj)->key);
+}
+
+static VALUE rb_gsl_integrator_epsabs(VALUE obj)
+{
+  return rb_float_new(get_integrator(obj)->epsabs);
+}
+
+static VALUE rb_gsl_integrator_epsrel(VALUE obj)
+{
+  return rb_float_new(get_integrator(obj)->epsrel);
+}
+
+static VALUE rb_gsl_integrator_levels(VALUE obj)
+{
+  return SIZET2NUM(get_integrator(obj)->levels);
+}
+
+static void Init_gsl_integration_integrator(VALUE mgsl_integ)
+{
+  cgsl_integration_integrator = rb_define_class_under(mgsl_integ, "Integrator", cGSL_Object);
+  rb_define_singleton_method(cgsl_integration_integrator, "alloc", rb_gsl_integrator_alloc, -1);
+  rb_define_method(cgsl_integration_integrator, "qag",
+		   RB_GSL_PROF(rb_gsl_integrator_qag_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qags",
+		   RB_GSL_PROF(rb_gsl_integrator_qags_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qagp",
+		   RB_GSL_PROF(rb_gsl_integrator_qagp_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qagi",
+		   RB_GSL_PROF(rb_gsl_integrator_qagi_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qagiu",
+		   RB_GSL_PROF(rb_gsl_integrator_qagiu_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qagil",
+		   RB_GSL_PROF(rb_gsl_integrator_qagil_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qawc",
+		   RB_GSL_PROF(rb_gsl_integrator_qawc_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qaws",
+		   RB_GSL_PROF(rb_gsl_integrator_qaws_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qawo",
+		   RB_GSL_PROF(rb_gsl_integrator_qawo_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qawf",
+		   RB_GSL_PROF(rb_gsl_integrator_qawf_guarded), -1);
+  rb_define_method(cgsl_integration_integrator, "qag_vector", rb_gsl_integrator_qag_vector, -1);
+  rb_define_method(cgsl_integration_integrator, "limit", rb_gsl_integrator_limit, 0);
+  rb_define_method(cgsl_integration_integrator, "key", rb_gsl_integrator_key, 0);
+  rb_define_method(cgsl_integration_integrator, "epsabs", rb_gsl_integrator_epsabs, 0);
+  rb_define_method(cgsl_integration_integrator, "epsrel", rb_gsl_integrator_epsrel, 0);
+  rb_define_method(cgsl_integration_integrator, "levels", rb_gsl_integrator_levels, 0);
+
+  rb_define_module_function(mgsl_integ, "cache_stats", rb_gsl_integration_cache_stats, 0);
+  rb_define_module_function(mgsl_integ, "cache_clear", rb_gsl_integration_cache_clear, 0);
+  rb_define_module_function(mgsl_integ, "cache_capacity", rb_gsl_integration_cache_capacity, 0);
+  rb_define_module_function(mgsl_integ, "cache_capacity=",
+			    rb_gsl_integration_set_cache_capacity, 1);
+}
 
 static void rb_gsl_integration_define_symbols(VALUE module)
 {
@@ -1039,22 +1628,161 @@ static VALUE rb_gsl_integration_glfixed_table_alloc(VALUE klass, VALUE n)
   return Data_Wrap_Struct(cgsl_integration_glfixed_table, 0, gsl_integration_glfixed_table_free, t);
 }
 
-static VALUE rb_gsl_integration_glfixed(VALUE obj, VALUE aa, VALUE bb, VALUE tt)
+/*
+  Tables shared by order: Glfixed_table.cache(n) returns the same frozen
+  table for every call, and glfixed accepts the order in place of a table.
+*/
+static VALUE glfixed_cache = Qnil;
+
+static VALUE rb_gsl_integration_glfixed_table_cache(VALUE klass, VALUE nn)
+{
+  VALUE t;
+  int n = NUM2INT(nn);
+  if (n <= 0) rb_raise(rb_eArgError, "order must be positive");
+  t = rb_hash_aref(glfixed_cache, INT2FIX(n));
+  if (NIL_P(t)) {
+    t = rb_gsl_integration_glfixed_table_alloc(klass, INT2FIX(n));
+    rb_obj_freeze(t);
+    rb_hash_aset(glfixed_cache, INT2FIX(n), t);
+  }
+  return t;
+}
+
+static VALUE rb_gsl_integration_glfixed_table_cache_size(VALUE klass)
+{
+  return INT2FIX(RHASH_SIZE(glfixed_cache));
+}
+
+static VALUE rb_gsl_integration_glfixed_table_cache_clear(VALUE klass)
+{
+  rb_hash_clear(glfixed_cache);
+  return klass;
+}
+
+static VALUE rb_gsl_integration_glfixed_table_n(VALUE obj)
 {
-  gsl_function *f;
-  double a, b;
   gsl_integration_glfixed_table *t;
-  double res;
+  Data_Get_Struct(obj, gsl_integration_glfixed_table, t);
+  return INT2FIX(t->n);
+}
+
+static gsl_integration_glfixed_table* get_glfixed_table(VALUE tt)
+{
+  gsl_integration_glfixed_table *t;
+  if (FIXNUM_P(tt)) tt = rb_gsl_integration_glfixed_table_cache(cgsl_integration_glfixed_table, tt);
   if (!rb_obj_is_kind_of(tt, cgsl_integration_glfixed_table)) {
     rb_raise(rb_eTypeError, "Wrong arugment type (%s for GSL::Integration::Glfixed_table)",
 	     rb_class2name(CLASS_OF(tt)));
   }
   Data_Get_Struct(tt, gsl_integration_glfixed_table, t);
-  a = NUM2DBL(aa);
-  b = NUM2DBL(bb);
+  return t;
+}
+
+/* Same rule as gsl_integration_glfixed() on each of the nint intervals
+   [a[i], b[i]], with all the abscissae evaluated by a single call of a
+   vectorized function; x and y have room for nint*t->n points. */
+struct glfixed_batch {
+  gsl_function *f;
+  const double *a, *b;
+  size_t sa, sb, nint;
+  const gsl_integration_glfixed_table *t;
+  double *x, *y, *res;
+};
+
+static int mygsl_integration_glfixed_batch(void *data)
+{
+  struct glfixed_batch *g = (struct glfixed_batch *) data;
+  const gsl_integration_glfixed_table *t = g->t;
+  const size_t n = t->n, m = (n + 1) >> 1, k0 = n & 1;
+  double A, B, r;
+  size_t i, k, np = 0;
+  for (i = 0; i < g->nint; i++) {
+    A = 0.5*(g->b[i*g->sb] - g->a[i*g->sa]);
+    B = 0.5*(g->b[i*g->sb] + g->a[i*g->sa]);
+    if (k0) g->x[np++] = B;
+    for (k = k0; k < m; k++) {
+      g->x[np++] = B + A*t->x[k];
+      g->x[np++] = B - A*t->x[k];
+    }
+  }
+  rb_gsl_function_eval_array(g->f, g->x, g->y, np);
+  np = 0;
+  for (i = 0; i < g->nint; i++) {
+    r = k0 ? t->w[0]*g->y[np++] : 0.0;
+    for (k = k0; k < m; k++, np += 2) r += t->w[k]*(g->y[np] + g->y[np+1]);
+    g->res[i] = 0.5*(g->b[i*g->sb] - g->a[i*g->sa])*r;
+  }
+  return GSL_SUCCESS;
+}
+
+static double* glfixed_bounds(VALUE v, size_t *stride, size_t *n, VALUE *keep)
+{
+  if (TYPE(v) == T_ARRAY) {
+    *keep = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, make_cvector_from_rarray(v));
+    v = *keep;
+  }
+  return get_vector_ptr(v, stride, n);
+}
+
+/*
+  f.glfixed(a, b, t): t a Glfixed_table or the order n of a cached one.
+  With Vectors (or Arrays) a and b, the Vector of the integrals over the
+  intervals [a[i], b[i]], a vectorized function being called once for all
+  of them, and a compiled one evaluated without the GVL.
+*/
+static VALUE rb_gsl_integration_glfixed(VALUE obj, VALUE aa, VALUE bb, VALUE tt)
+{
+  struct glfixed_batch g;
+  gsl_function *f;
+  gsl_integration_glfixed_table *t;
+  gsl_vector *buf, *res;
+  double a, b, r;
+  size_t nb;
+  VALUE ka = Qnil, kb = Qnil, vbuf;
+  t = get_glfixed_table(tt);
   Data_Get_Struct(obj, gsl_function, f);
-  res = gsl_integration_glfixed(f, a, b, t);
-  return rb_float_new(res);
+  if (rb_obj_is_kind_of(aa, rb_cNumeric) && rb_obj_is_kind_of(bb, rb_cNumeric)) {
+    a = NUM2DBL(aa);
+    b = NUM2DBL(bb);
+    if (!rb_gsl_function_vectorized_p(f)) return rb_float_new(gsl_integration_glfixed(f, a, b, t));
+    g.a = &a;
+    g.b = &b;
+    g.sa = g.sb = 1;
+    g.nint = 1;
+  } else {
+    g.a = glfixed_bounds(aa, &g.sa, &g.nint, &ka);
+    g.b = glfixed_bounds(bb, &g.sb, &nb, &kb);
+    if (nb != g.nint) rb_raise(rb_eArgError, "a and b must have the same length");
+    if (nb == 0) rb_raise(rb_eArgError, "no intervals");
+  }
+  g.f = f;
+  g.t = t;
+  buf = gsl_vector_alloc(2*g.nint*t->n + 1);
+  vbuf = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, buf);
+  res = gsl_vector_alloc(g.nint);
+  g.x = buf->data;
+  g.y = buf->data + g.nint*t->n;
+  g.res = res->data;
+  if (rb_obj_is_kind_of(obj, cgsl_function_compiled))
+    rb_gsl_nogvl_call(mygsl_integration_glfixed_batch, &g, g.nint*t->n);
+  else
+    mygsl_integration_glfixed_batch(&g);
+  RB_GC_GUARD(ka);
+  RB_GC_GUARD(kb);
+  RB_GC_GUARD(vbuf);
+  if (g.a == &a) {
+    r = res->data[0];
+    gsl_vector_free(res);
+    return rb_float_new(r);
+  }
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, res);
+}
+
+/* GSL::Integration.glfixed(f, a, b, t) */
+static VALUE rb_gsl_integration_glfixed2(VALUE module, VALUE ff, VALUE aa, VALUE bb, VALUE tt)
+{
+  CHECK_FUNCTION(ff);
+  return rb_gsl_integration_glfixed(ff, aa, bb, tt);
 }
 #endif
 
@@ -1064,15 +1792,24 @@ void Init_gsl_integration(VALUE module)
 
   mgsl_integ = rb_define_module_under(module, "Integration");
   rb_gsl_integration_define_symbols(mgsl_integ);
+  Init_gsl_integration_integrator(mgsl_integ);
+  Init_gsl_integration_vector(mgsl_integ);
 
   rb_define_method(cgsl_function, "integration_qng", rb_gsl_integration_qng, -1);
-  rb_define_method(cgsl_function, "integration_qag", rb_gsl_integration_qag, -1);
-  rb_define_method(cgsl_function, "integration_qags", rb_gsl_integration_qags, -1);
-  rb_define_method(cgsl_function, "integration_qagp", rb_gsl_integration_qagp, -1);
-  rb_define_method(cgsl_function, "integration_qagi", rb_gsl_integration_qagi, -1);
-  rb_define_method(cgsl_function, "integration_qagiu", rb_gsl_integration_qagiu, -1);
-  rb_define_method(cgsl_function, "integration_qagil", rb_gsl_integration_qagil, -1);
-  rb_define_method(cgsl_function, "integration_qawc", rb_gsl_integration_qawc, -1);
+  rb_define_method(cgsl_function, "integration_qag",
+		   RB_GSL_PROF(rb_gsl_integration_qag_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qags",
+		   RB_GSL_PROF(rb_gsl_integration_qags_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qagp",
+		   RB_GSL_PROF(rb_gsl_integration_qagp_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qagi",
+		   RB_GSL_PROF(rb_gsl_integration_qagi_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qagiu",
+		   RB_GSL_PROF(rb_gsl_integration_qagiu_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qagil",
+		   RB_GSL_PROF(rb_gsl_integration_qagil_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qawc",
+		   RB_GSL_PROF(rb_gsl_integration_qawc_guarded), -1);
   rb_define_alias(cgsl_function, "qng", "integration_qng");
   rb_define_alias(cgsl_function, "qag", "integration_qag");
   rb_define_alias(cgsl_function, "qags", "integration_qags");
@@ -1095,7 +1832,8 @@ void Init_gsl_integration(VALUE module)
   rb_define_method(rb_cArray, "to_gsl_integration_qaws_table", 
 		   rb_gsl_ary_to_integration_qaws_table, 0);
   rb_define_alias(rb_cArray, "to_qaws_table", "to_gsl_integration_qaws_table");
-  rb_define_method(cgsl_function, "integration_qaws", rb_gsl_integration_qaws, -1);
+  rb_define_method(cgsl_function, "integration_qaws",
+		   RB_GSL_PROF(rb_gsl_integration_qaws_guarded), -1);
   rb_define_alias(cgsl_function, "qaws", "integration_qaws");
 
   cgsl_integration_qawo_table = rb_define_class_under(mgsl_integ, "QAWO_Table", 
@@ -1112,8 +1850,10 @@ void Init_gsl_integration(VALUE module)
 		   rb_gsl_integration_qawo_table_set, -1);
   rb_define_method(cgsl_integration_qawo_table, "set_length", 
 		   rb_gsl_integration_qawo_table_set_length, 1);
-  rb_define_method(cgsl_function, "integration_qawo", rb_gsl_integration_qawo, -1);
-  rb_define_method(cgsl_function, "integration_qawf", rb_gsl_integration_qawf, -1);
+  rb_define_method(cgsl_function, "integration_qawo",
+		   RB_GSL_PROF(rb_gsl_integration_qawo_guarded), -1);
+  rb_define_method(cgsl_function, "integration_qawf",
+		   RB_GSL_PROF(rb_gsl_integration_qawf_guarded), -1);
   rb_define_alias(cgsl_function, "qawo", "integration_qawo");
   rb_define_alias(cgsl_function, "qawf", "integration_qawf");
 
@@ -1148,22 +1888,43 @@ void Init_gsl_integration(VALUE module)
 
   /*****/
   rb_define_module_function(mgsl_integ, "qng", rb_gsl_integration_qng, -1);
-  rb_define_module_function(mgsl_integ, "qag", rb_gsl_integration_qag, -1);
-  rb_define_module_function(mgsl_integ, "qags", rb_gsl_integration_qags, -1);
-  rb_define_module_function(mgsl_integ, "qagp", rb_gsl_integration_qagp, -1);
-  rb_define_module_function(mgsl_integ, "qagi", rb_gsl_integration_qagi, -1);
-  rb_define_module_function(mgsl_integ, "qagiu", rb_gsl_integration_qagiu, -1);
-  rb_define_module_function(mgsl_integ, "qagil", rb_gsl_integration_qagil, -1);
-  rb_define_module_function(mgsl_integ, "qawc", rb_gsl_integration_qawc, -1);
-  rb_define_module_function(mgsl_integ, "qaws", rb_gsl_integration_qaws, -1);
-  rb_define_module_function(mgsl_integ, "qawo", rb_gsl_integration_qawo, -1);
-  rb_define_module_function(mgsl_integ, "qawf", rb_gsl_integration_qawf, -1);
+  rb_define_module_function(mgsl_integ, "qag",
+			    RB_GSL_PROF(rb_gsl_integration_qag_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qags",
+			    RB_GSL_PROF(rb_gsl_integration_qags_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qagp",
+			    RB_GSL_PROF(rb_gsl_integration_qagp_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qagi",
+			    RB_GSL_PROF(rb_gsl_integration_qagi_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qagiu",
+			    RB_GSL_PROF(rb_gsl_integration_qagiu_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qagil",
+			    RB_GSL_PROF(rb_gsl_integration_qagil_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qawc",
+			    RB_GSL_PROF(rb_gsl_integration_qawc_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qaws",
+			    RB_GSL_PROF(rb_gsl_integration_qaws_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qawo",
+			    RB_GSL_PROF(rb_gsl_integration_qawo_guarded), -1);
+  rb_define_module_function(mgsl_integ, "qawf",
+			    RB_GSL_PROF(rb_gsl_integration_qawf_guarded), -1);
 
 #ifdef GSL_1_14_LATER
   cgsl_integration_glfixed_table = rb_define_class_under(mgsl_integ, "Glfixed_table", cGSL_Object);
   rb_define_singleton_method(cgsl_integration_glfixed_table, "alloc",
 			     rb_gsl_integration_glfixed_table_alloc, 1);
+  rb_define_singleton_method(cgsl_integration_glfixed_table, "cache",
+			     rb_gsl_integration_glfixed_table_cache, 1);
+  rb_define_singleton_method(cgsl_integration_glfixed_table, "cache_size",
+			     rb_gsl_integration_glfixed_table_cache_size, 0);
+  rb_define_singleton_method(cgsl_integration_glfixed_table, "cache_clear",
+			     rb_gsl_integration_glfixed_table_cache_clear, 0);
+  rb_define_method(cgsl_integration_glfixed_table, "n", rb_gsl_integration_glfixed_table_n, 0);
+  rb_define_alias(cgsl_integration_glfixed_table, "size", "n");
+  glfixed_cache = rb_hash_new();
+  rb_global_variable(&glfixed_cache);
   rb_define_method(cgsl_function, "glfixed", rb_gsl_integration_glfixed, 3);
+  rb_define_module_function(mgsl_integ, "glfixed", rb_gsl_integration_glfixed2, 4);
 #endif
 
 }
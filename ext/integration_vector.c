@@ -0,0 +1,510 @@
+/*
+  integration_vector.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Adaptive integration of a vector-valued function: one subdivision of
+  [a, b] shared by all the components, the interval with the largest
+  error (in norm) bisected first, until
+  |abserr| <= max(epsabs, epsrel |result|) in that norm.  Each interval
+  is integrated by the 21-point Gauss-Kronrod rule, with the error
+  estimates of QUADPACK (gsl_integration_qk21) for each component.
+
+    fs = [GSL::Function.compile("sin(x)"), GSL::Function.compile("x^2")]
+    res, err, intervals, status = GSL::Integration.qag_vector(fs, 0, 1)
+
+    f = lambda { |x| GSL::Vector[sin(x), x*x] }        # per point
+    GSL::Integration.qag_vector(f, 0, 1, :epsrel => 1e-10)
+
+    f = lambda { |x| ... }    # x: Vector of points, an x.size x n Matrix back
+    GSL::Integration.qag_vector(f, 0, 1, :batch => true, :norm => :l2)
+
+  The integrand is an Array of GSL::Function (evaluated without the GVL
+  when all are GSL::Function::Compiled, a vectorized Function called once
+  per bisection), or anything responding to call.  Options :epsabs,
+  :epsrel, :limit and :norm (:max, :l1 or :l2).
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_function.h"
+#include "rb_gsl_integration.h"
+#include "rb_gsl_common.h"
+#include <float.h>
+
+#define VINTEG_NODES 21
+
+/* The nodes and weights of gsl_integration_qk21: xgk[1], xgk[3], ...
+   are the 10-point Gauss nodes */
+static const double vinteg_xgk[11] = {
+  0.995657163025808080735527280689003,
+  0.973906528517171720077964012084452,
+  0.930157491355708226001207180059508,
+  0.865063366688984510732096688423493,
+  0.780817726586416897063717578345042,
+  0.679409568299024406234327365114874,
+  0.562757134668604683339000099272694,
+  0.433395394129247190799265943165784,
+  0.294392862701460198131126603103866,
+  0.148874338981631210884826001129720,
+  0.000000000000000000000000000000000
+};
+
+static const double vinteg_wg[5] = {
+  0.066671344308688137593568809893332,
+  0.149451349150580593145776339657697,
+  0.219086362515982043995534934228163,
+  0.269266719309996355091226921569469,
+  0.295524224714752870173892994651338
+};
+
+static const double vinteg_wgk[11] = {
+  0.011694638867371874278064396062192,
+  0.032558162307964727478818972459390,
+  0.054755896574351996031381300244580,
+  0.075039674810919952767043140916190,
+  0.093125454583697605535065465083366,
+  0.109387158802297641899210590325805,
+  0.123491976262065851077600025351925,
+  0.134709217311473325928054001771707,
+  0.142775938577060080797094273138717,
+  0.147739104901338491374841515972068,
+  0.149445554002916905664936468389821
+};
+
+enum {
+  VINTEG_FUNCTIONS,
+  VINTEG_CALL,
+  VINTEG_BATCH,
+};
+
+enum {
+  VINTEG_NORM_MAX,
+  VINTEG_NORM_L1,
+  VINTEG_NORM_L2,
+};
+
+typedef struct {
+  int kind, norm;
+  size_t n, limit, nint;
+  double epsabs, epsrel;
+  VALUE f;                      /* the callable, or the Array of Functions */
+  gsl_function **fs;
+  double *x, *y;                /* the nodes of two intervals, y[node*n + k] */
+  double *a, *b, *enorm;        /* the intervals */
+  double *r, *e;                /* their results and errors, limit x n */
+  size_t *heap;                 /* intervals by enorm, largest first */
+  double *res, *err;
+} mygsl_vinteg;
+
+static void mygsl_vinteg_mark(mygsl_vinteg *w)
+{
+  rb_gc_mark(w->f);
+}
+
+static void mygsl_vinteg_free(mygsl_vinteg *w)
+{
+  xfree(w->fs);
+  xfree(w->x);
+  xfree(w->y);
+  xfree(w->a);
+  xfree(w->r);
+  xfree(w->e);
+  xfree(w->heap);
+  xfree(w->res);
+  xfree(w);
+}
+
+static double vinteg_norm(const mygsl_vinteg *w, const double *v)
+{
+  double s = 0.0;
+  size_t k;
+  switch (w->norm) {
+  case VINTEG_NORM_L1:
+    for (k = 0; k < w->n; k++) s += fabs(v[k]);
+    return s;
+  case VINTEG_NORM_L2:
+    for (k = 0; k < w->n; k++) s += v[k]*v[k];
+    return sqrt(s);
+  default:
+    for (k = 0; k < w->n; k++) if (fabs(v[k]) > s) s = fabs(v[k]);
+    return s;
+  }
+}
+
+/* As rescale_error() in GSL's integration/err.c */
+static double vinteg_rescale_error(double err, double result_abs, double result_asc)
+{
+  double scale, min_err;
+  err = fabs(err);
+  if (result_asc != 0 && err != 0) {
+    scale = pow((200*err/result_asc), 1.5);
+    if (scale < 1) err = result_asc*scale;
+    else err = result_asc;
+  }
+  if (result_abs > GSL_DBL_MIN/(50*GSL_DBL_EPSILON)) {
+    min_err = 50*GSL_DBL_EPSILON*result_abs;
+    if (min_err > err) err = min_err;
+  }
+  return err;
+}
+
+static void vinteg_nodes(double a, double b, double *x)
+{
+  const double c = 0.5*(a + b), h = 0.5*(b - a);
+  size_t j;
+  x[0] = c;
+  for (j = 0; j < 10; j++) {
+    x[2*j+1] = c - h*vinteg_xgk[j];
+    x[2*j+2] = c + h*vinteg_xgk[j];
+  }
+}
+
+/* The 21-point rule on [a, b] for each component, from the values y at
+   the nodes of vinteg_nodes */
+static void vinteg_rule(const mygsl_vinteg *w, double a, double b, const double *y,
+			double *r, double *e)
+{
+  const double h = 0.5*(b - a), absh = fabs(h);
+  const size_t n = w->n;
+  double fc, f1, f2, rk, rg, resabs, resasc, mean;
+  size_t j, k;
+  for (k = 0; k < n; k++) {
+    fc = y[k];
+    rk = fc*vinteg_wgk[10];
+    rg = 0.0;
+    resabs = fabs(rk);
+    for (j = 0; j < 10; j++) {
+      f1 = y[(2*j+1)*n + k];
+      f2 = y[(2*j+2)*n + k];
+      rk += vinteg_wgk[j]*(f1 + f2);
+      resabs += vinteg_wgk[j]*(fabs(f1) + fabs(f2));
+      if (j & 1) rg += vinteg_wg[j/2]*(f1 + f2);
+    }
+    mean = 0.5*rk;
+    resasc = vinteg_wgk[10]*fabs(fc - mean);
+    for (j = 0; j < 10; j++)
+      resasc += vinteg_wgk[j]*(fabs(y[(2*j+1)*n + k] - mean) + fabs(y[(2*j+2)*n + k] - mean));
+    r[k] = rk*h;
+    e[k] = vinteg_rescale_error((rk - rg)*h, resabs*absh, resasc*absh);
+  }
+}
+
+/* Copies a Vector, an Array or (n = 1) a Numeric returned by the
+   integrand into y[0..n-1] */
+static void vinteg_row(VALUE v, double *y, size_t n)
+{
+  gsl_vector *vv = NULL;
+  size_t k;
+  if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vv);
+    if (vv->size != n) goto size_error;
+    for (k = 0; k < n; k++) y[k] = gsl_vector_get(vv, k);
+  } else if (TYPE(v) == T_ARRAY) {
+    if ((size_t) RARRAY_LEN(v) != n) goto size_error;
+    for (k = 0; k < n; k++) y[k] = NUM2DBL(rb_ary_entry(v, k));
+  } else if (n == 1 && rb_obj_is_kind_of(v, rb_cNumeric)) {
+    y[0] = NUM2DBL(v);
+  } else {
+    rb_raise(rb_eTypeError, "integrand returned %s (Vector or Array expected)",
+	     rb_class2name(CLASS_OF(v)));
+  }
+  return;
+ size_error:
+  rb_raise(rb_eRuntimeError, "integrand returned a value of the wrong size (%d expected)",
+	   (int) n);
+}
+
+static size_t vinteg_row_size(VALUE v)
+{
+  gsl_vector *vv = NULL;
+  if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vv);
+    return vv->size;
+  }
+  if (TYPE(v) == T_ARRAY) return RARRAY_LEN(v);
+  return 1;
+}
+
+/* y = f(x) at the np points x */
+static void vinteg_eval(mygsl_vinteg *w, const double *x, size_t np)
+{
+  gsl_vector *vx = NULL;
+  gsl_matrix *m = NULL;
+  double *col;
+  size_t i, k, n = w->n;
+  VALUE v, ox;
+  switch (w->kind) {
+  case VINTEG_FUNCTIONS:
+    col = w->y + 2*VINTEG_NODES*n;    /* scratch */
+    for (k = 0; k < n; k++) {
+      rb_gsl_function_eval_array(w->fs[k], x, col, np);
+      for (i = 0; i < np; i++) w->y[i*n + k] = col[i];
+    }
+    break;
+  case VINTEG_CALL:
+    for (i = 0; i < np; i++)
+      vinteg_row(rb_funcall(w->f, RBGSL_ID_call, 1, rb_float_new(x[i])), w->y + i*n, n);
+    break;
+  case VINTEG_BATCH:
+    vx = gsl_vector_alloc(np);
+    memcpy(vx->data, x, sizeof(double)*np);
+    ox = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vx);
+    v = rb_funcall(w->f, RBGSL_ID_call, 1, ox);
+    if (MATRIX_P(v)) {
+      Data_Get_Struct(v, gsl_matrix, m);
+      if (m->size1 != np || m->size2 != n)
+	rb_raise(rb_eRuntimeError, "integrand returned a %dx%d matrix (%dx%d expected)",
+		 (int) m->size1, (int) m->size2, (int) np, (int) n);
+      for (i = 0; i < np; i++) memcpy(w->y + i*n, m->data + i*m->tda, sizeof(double)*n);
+    } else {
+      Check_Type(v, T_ARRAY);
+      if ((size_t) RARRAY_LEN(v) != np)
+	rb_raise(rb_eRuntimeError, "integrand returned %d rows (%d expected)",
+		 (int) RARRAY_LEN(v), (int) np);
+      for (i = 0; i < np; i++) vinteg_row(rb_ary_entry(v, i), w->y + i*n, n);
+    }
+    RB_GC_GUARD(ox);
+    break;
+  }
+}
+
+/* The number of components, from a first call of a Ruby integrand */
+static size_t vinteg_probe(mygsl_vinteg *w, double x)
+{
+  gsl_vector *vx = NULL;
+  gsl_matrix *m = NULL;
+  VALUE v;
+  if (w->kind == VINTEG_CALL) return vinteg_row_size(rb_funcall(w->f, RBGSL_ID_call, 1,
+							       rb_float_new(x)));
+  vx = gsl_vector_alloc(1);
+  vx->data[0] = x;
+  v = rb_funcall(w->f, RBGSL_ID_call, 1, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vx));
+  if (MATRIX_P(v)) {
+    Data_Get_Struct(v, gsl_matrix, m);
+    return m->size2;
+  }
+  Check_Type(v, T_ARRAY);
+  if (RARRAY_LEN(v) != 1) rb_raise(rb_eRuntimeError, "integrand returned %d rows (1 expected)",
+				   (int) RARRAY_LEN(v));
+  return vinteg_row_size(rb_ary_entry(v, 0));
+}
+
+static void vinteg_heap_push(mygsl_vinteg *w, size_t len, size_t iv)
+{
+  size_t i = len, p;
+  while (i > 0) {
+    p = (i - 1)/2;
+    if (w->enorm[w->heap[p]] >= w->enorm[iv]) break;
+    w->heap[i] = w->heap[p];
+    i = p;
+  }
+  w->heap[i] = iv;
+}
+
+static size_t vinteg_heap_pop(mygsl_vinteg *w, size_t len)
+{
+  size_t top = w->heap[0], last = w->heap[len-1], i = 0, c;
+  len--;
+  while ((c = 2*i + 1) < len) {
+    if (c + 1 < len && w->enorm[w->heap[c+1]] > w->enorm[w->heap[c]]) c++;
+    if (w->enorm[last] >= w->enorm[w->heap[c]]) break;
+    w->heap[i] = w->heap[c];
+    i = c;
+  }
+  if (len > 0) w->heap[i] = last;
+  return top;
+}
+
+/* Sums the results and errors of the intervals */
+static void vinteg_total(mygsl_vinteg *w)
+{
+  size_t i, k, n = w->n;
+  for (k = 0; k < n; k++) w->res[k] = w->err[k] = 0.0;
+  for (i = 0; i < w->nint; i++) {
+    for (k = 0; k < n; k++) {
+      w->res[k] += w->r[i*n + k];
+      w->err[k] += w->e[i*n + k];
+    }
+  }
+}
+
+static int vinteg_converged(const mygsl_vinteg *w)
+{
+  return vinteg_norm(w, w->err) <= GSL_MAX(w->epsabs, w->epsrel*vinteg_norm(w, w->res));
+}
+
+/* The adaptive loop on [w->a[0], w->b[0]], whose rule is in r[0], e[0] */
+static int vinteg_run(void *data)
+{
+  mygsl_vinteg *w = (mygsl_vinteg *) data;
+  const size_t n = w->n;
+  size_t i, i1, i2, k;
+  double a, b, m;
+  int status = GSL_SUCCESS;
+  w->nint = 1;
+  w->enorm[0] = vinteg_norm(w, w->e);
+  w->heap[0] = 0;
+  vinteg_total(w);
+  while (!vinteg_converged(w)) {
+    if (w->nint >= w->limit) {
+      status = GSL_EMAXITER;
+      break;
+    }
+    i = vinteg_heap_pop(w, w->nint);
+    a = w->a[i];
+    b = w->b[i];
+    m = 0.5*(a + b);
+    if (!(m > GSL_MIN(a, b) && m < GSL_MAX(a, b))
+	|| fabs(b - a) <= 1000*GSL_DBL_EPSILON*GSL_MAX(fabs(a), fabs(b))) {
+      vinteg_heap_push(w, w->nint - 1, i);
+      status = GSL_EROUND;
+      break;
+    }
+    vinteg_nodes(a, m, w->x);
+    vinteg_nodes(m, b, w->x + VINTEG_NODES);
+    vinteg_eval(w, w->x, 2*VINTEG_NODES);
+    for (k = 0; k < n; k++) {
+      w->res[k] -= w->r[i*n + k];
+      w->err[k] -= w->e[i*n + k];
+    }
+    i1 = i;
+    i2 = w->nint++;
+    w->b[i1] = m;
+    w->a[i2] = m;
+    w->b[i2] = b;
+    vinteg_rule(w, a, m, w->y, w->r + i1*n, w->e + i1*n);
+    vinteg_rule(w, m, b, w->y + VINTEG_NODES*n, w->r + i2*n, w->e + i2*n);
+    for (k = 0; k < n; k++) {
+      w->res[k] += w->r[i1*n + k] + w->r[i2*n + k];
+      w->err[k] += w->e[i1*n + k] + w->e[i2*n + k];
+    }
+    w->enorm[i1] = vinteg_norm(w, w->e + i1*n);
+    w->enorm[i2] = vinteg_norm(w, w->e + i2*n);
+    vinteg_heap_push(w, w->nint - 2, i1);
+    vinteg_heap_push(w, w->nint - 1, i2);
+    /* the running sums drift; check against the exact ones */
+    if (vinteg_converged(w)) vinteg_total(w);
+  }
+  vinteg_total(w);
+  return status;
+}
+
+static int vinteg_norm_id(VALUE v)
+{
+  const char *name;
+  if (NIL_P(v)) return VINTEG_NORM_MAX;
+  if (SYMBOL_P(v)) v = rb_sym2str(v);
+  name = StringValuePtr(v);
+  if (strcmp(name, "max") == 0 || strcmp(name, "linf") == 0) return VINTEG_NORM_MAX;
+  if (strcmp(name, "l1") == 0) return VINTEG_NORM_L1;
+  if (strcmp(name, "l2") == 0) return VINTEG_NORM_L2;
+  rb_raise(rb_eArgError, "unknown norm %s (max, l1 or l2)", name);
+  return VINTEG_NORM_MAX;
+}
+
+/*
+  Integrates f over [a, b] with the given tolerances and limit; opts as
+  for GSL::Integration.qag_vector (:batch, :norm).  Returns [result,
+  abserr, intervals, status], result and abserr Vectors.
+*/
+VALUE rb_gsl_integration_qag_vector_run(VALUE f, double a, double b, double epsabs,
+					double epsrel, size_t limit, VALUE opts)
+{
+  mygsl_vinteg *w = NULL;
+  gsl_vector *res, *err;
+  size_t k, n;
+  int status, native = 1;
+  VALUE obj, v;
+  if (limit == 0) rb_raise(rb_eArgError, "limit must be positive");
+  obj = Data_Make_Struct(0, mygsl_vinteg, mygsl_vinteg_mark, mygsl_vinteg_free, w);
+  w->f = f;
+  w->epsabs = epsabs;
+  w->epsrel = epsrel;
+  w->limit = limit;
+  w->norm = VINTEG_NORM_MAX;
+  w->kind = VINTEG_CALL;
+  if (!NIL_P(opts)) {
+    w->norm = vinteg_norm_id(rb_hash_aref(opts, ID2SYM(rb_intern("norm"))));
+    v = rb_hash_aref(opts, ID2SYM(rb_intern("batch")));
+    if (RTEST(v)) w->kind = VINTEG_BATCH;
+  }
+  if (TYPE(f) == T_ARRAY) {
+    w->kind = VINTEG_FUNCTIONS;
+    n = RARRAY_LEN(f);
+    if (n == 0) rb_raise(rb_eArgError, "no integrands");
+    w->fs = ALLOC_N(gsl_function*, n);
+    for (k = 0; k < n; k++) {
+      v = rb_ary_entry(f, k);
+      CHECK_FUNCTION(v);
+      Data_Get_Struct(v, gsl_function, w->fs[k]);
+      if (!rb_obj_is_kind_of(v, cgsl_function_compiled)) native = 0;
+    }
+  } else {
+    if (!rb_respond_to(f, RBGSL_ID_call))
+      rb_raise(rb_eTypeError, "wrong argument type %s (Array of Functions or callable expected)",
+	       rb_class2name(CLASS_OF(f)));
+    native = 0;
+    n = vinteg_probe(w, 0.5*(a + b));
+    if (n == 0) rb_raise(rb_eArgError, "no integrands");
+  }
+  w->n = n;
+  w->x = ALLOC_N(double, 2*VINTEG_NODES);
+  w->y = ALLOC_N(double, 2*VINTEG_NODES*n + 2*VINTEG_NODES);
+  w->a = ALLOC_N(double, 3*limit);
+  w->b = w->a + limit;
+  w->enorm = w->b + limit;
+  w->r = ALLOC_N(double, limit*n);
+  w->e = ALLOC_N(double, limit*n);
+  w->heap = ALLOC_N(size_t, limit);
+  w->res = ALLOC_N(double, 2*n);
+  w->err = w->res + n;
+
+  w->a[0] = a;
+  w->b[0] = b;
+  vinteg_nodes(a, b, w->x);
+  vinteg_eval(w, w->x, VINTEG_NODES);
+  vinteg_rule(w, a, b, w->y, w->r, w->e);
+  if (native) status = rb_gsl_nogvl_call(vinteg_run, w, limit*n);
+  else status = vinteg_run(w);
+
+  res = gsl_vector_alloc(n);
+  err = gsl_vector_alloc(n);
+  memcpy(res->data, w->res, sizeof(double)*n);
+  memcpy(err->data, w->err, sizeof(double)*n);
+  v = rb_ary_new3(4, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, res),
+		  Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, err),
+		  SIZET2NUM(w->nint), INT2FIX(status));
+  RB_GC_GUARD(obj);
+  return v;
+}
+
+/* qag_vector(f, a, b[, opts]): opts :epsabs, :epsrel, :limit, :norm, :batch */
+static VALUE rb_gsl_integration_qag_vector(int argc, VALUE *argv, VALUE module)
+{
+  double epsabs = 0.0, epsrel = 1e-10;
+  size_t limit = 1000;
+  VALUE opts = Qnil, v;
+  if (argc == 4) {
+    opts = argv[3];
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsabs"))))) epsabs = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsrel"))))) epsrel = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("limit"))))) limit = NUM2SIZET(v);
+  } else if (argc != 3) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  }
+  return rb_gsl_integration_qag_vector_run(argv[0], NUM2DBL(argv[1]), NUM2DBL(argv[2]),
+					   epsabs, epsrel, limit, opts);
+}
+
+void Init_gsl_integration_vector(VALUE mgsl_integ)
+{
+  rb_define_module_function(mgsl_integ, "qag_vector", rb_gsl_integration_qag_vector, -1);
+}
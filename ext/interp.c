@@ -170,92 +170,211 @@ static VALUE rb_gsl_interp_accel_find(VALUE obj, VALUE vv, VALUE xx)
   return INT2FIX(gsl_interp_accel_find(a, ptr, size, x));
 }
 
-static VALUE rb_gsl_interp_evaluate(VALUE obj, VALUE xxa, VALUE yya, VALUE xx,
-				    double (*eval)(const gsl_interp *, const double [], 
-						   const double [], double, 
-						   gsl_interp_accel *))
+/* An accelerator of its own, e.g. one per thread for a shared Spline */
+static VALUE rb_gsl_interp_accel_new(VALUE klass)
 {
-  rb_gsl_interp *rgi = NULL;
-  double *ptrx = NULL, *ptry = NULL;
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
-  VALUE ary, x;
-  double val;
-  size_t n, i, j, size, stridex, stridey;
+  return Data_Wrap_Struct(klass, 0, gsl_interp_accel_free, gsl_interp_accel_alloc());
+}
+
+static VALUE rb_gsl_interp_accel_reset(VALUE obj)
+{
+  gsl_interp_accel *a = NULL;
+  Data_Get_Struct(obj, gsl_interp_accel, a);
+  gsl_interp_accel_reset(a);
+  return obj;
+}
+
+/* The interval of x, hunting a few knots from j before bisecting */
+size_t mygsl_interp_hunt(const double xa[], size_t last, size_t j, double x)
+{
+  size_t k;
+  if (x >= xa[j+1]) {
+    for (k = 0; k < 4 && j + 1 < last && x >= xa[j+1]; k++) j++;
+    if (j + 1 < last && x >= xa[j+1]) j = gsl_interp_bsearch(xa, x, j, last);
+  } else if (x < xa[j]) {
+    for (k = 0; k < 4 && j > 0 && x < xa[j]; k++) j--;
+    if (x < xa[j]) j = gsl_interp_bsearch(xa, x, 0, j);
+  }
+  return j;
+}
+
+/*
+  Evaluates p at the n points x[i*xstride] into out[k][i*ostride[k]],
+  k = 0, 1, 2 for the value and the first and second derivatives
+  (out[k] NULL if not wanted).  The interval of each point is found
+  here and left in the accelerator, so that the gsl_interp_eval calls
+  hit its cache: for monotone input by walking the knots, otherwise by
+  a hunt from the previous interval.  The results are those of calling
+  gsl_interp_eval point by point.
+*/
+void mygsl_interp_eval_bulk(const gsl_interp *p, const double xa[], const double ya[],
+			    gsl_interp_accel *a, const double *x, size_t xstride,
+			    size_t n, double *out[3], const size_t ostride[3])
+{
+  size_t i, j, last = p->size - 1;
+  int up = 1, down = 1;
+  double xi;
+  if (n == 0) return;
+  for (i = 1; i < n && (up || down); i++) {
+    if (!(x[i*xstride] >= x[(i-1)*xstride])) up = 0;
+    if (!(x[i*xstride] <= x[(i-1)*xstride])) down = 0;
+  }
+  j = a->cache < last ? a->cache : last - 1;
+  j = mygsl_interp_hunt(xa, last, j, x[0]);
+  for (i = 0; i < n; i++) {
+    xi = x[i*xstride];
+    if (up) while (j + 1 < last && xi >= xa[j+1]) j++;
+    else if (down) while (j > 0 && xi < xa[j]) j--;
+    else j = mygsl_interp_hunt(xa, last, j, xi);
+    a->cache = j;
+    if (out[0]) out[0][i*ostride[0]] = gsl_interp_eval(p, xa, ya, xi, a);
+    if (out[1]) out[1][i*ostride[1]] = gsl_interp_eval_deriv(p, xa, ya, xi, a);
+    if (out[2]) out[2][i*ostride[2]] = gsl_interp_eval_deriv2(p, xa, ya, xi, a);
+  }
+}
+
+/* Output k of mygsl_interp_evaluate: the given Vector or Matrix, or a new one */
+VALUE mygsl_interp_output(VALUE out, VALUE xx, size_t n1, size_t n2,
+			  double **ptr, size_t *stride, size_t *tda)
+{
+  gsl_vector *v = NULL;
+  gsl_matrix *m = NULL;
+  if (NIL_P(out)) {
+    if (MATRIX_P(xx)) out = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+					     gsl_matrix_alloc(n1, n2));
+    else out = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_alloc(n2));
+  }
+  if (MATRIX_P(xx)) {
+    CHECK_MATRIX(out);
+    Data_Get_Struct(out, gsl_matrix, m);
+    if (m->size1 != n1 || m->size2 != n2)
+      rb_raise(rb_eArgError, "output matrix is %dx%d, %dx%d expected",
+	       (int) m->size1, (int) m->size2, (int) n1, (int) n2);
+    *ptr = m->data; *stride = 1; *tda = m->tda;
+  } else {
+    CHECK_VECTOR(out);
+    Data_Get_Struct(out, gsl_vector, v);
+    if (v->size != n2)
+      rb_raise(rb_eArgError, "output vector has %d elements, %d expected", (int) v->size, (int) n2);
+    *ptr = v->data; *stride = v->stride; *tda = 0;
+  }
+  return out;
+}
+
+/*
+  Evaluates p at xx (a Numeric, Range, Array, Vector, Matrix or NArray);
+  mask selects the value (1), the first (2) and second (4) derivatives.
+  out[k] is Qnil or the Vector (Matrix for a Matrix xx) receiving
+  output k.  Returns the single output selected, or an Array of them.
+*/
+VALUE mygsl_interp_evaluate(const gsl_interp *p, const double xa[], const double ya[],
+			    gsl_interp_accel *a, VALUE xx, int mask, VALUE *out)
+{
+  double (*eval[3])(const gsl_interp *, const double [], const double [], double,
+		    gsl_interp_accel *) = { gsl_interp_eval, gsl_interp_eval_deriv,
+					    gsl_interp_eval_deriv2 };
+  gsl_vector *v = NULL;
+  gsl_matrix *m = NULL;
+  VALUE res[3] = { Qnil, Qnil, Qnil }, ary;
+  double *x = NULL, *optr[3] = { NULL, NULL, NULL }, *rowptr[3];
+  size_t n1 = 1, n2 = 0, xstride = 1, xtda = 0, ostride[3] = { 1, 1, 1 }, otda[3] = { 0, 0, 0 };
+  size_t i, k, nout = 0;
+  int is_ary = 0;
 #ifdef HAVE_NARRAY_H
   struct NARRAY *na = NULL;
-  double *ptrz = NULL, *ptr = NULL;
 #endif
-  Data_Get_Struct(obj, rb_gsl_interp, rgi);
-  ptrx = get_vector_ptr(xxa, &stridex, &size);
-  if (size != rgi->p->size ){
-    rb_raise(rb_eTypeError, "size mismatch (xa:%d != %d)",  (int) size, (int) rgi->p->size);
-  }
-  ptry = get_vector_ptr(yya, &stridey, &size);
-  if (size != rgi->p->size ){
-    rb_raise(rb_eTypeError, "size mismatch (ya:%d != %d)", (int) size, (int) rgi->p->size);
-  }
   if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
   switch (TYPE(xx)) {
   case T_FIXNUM:  case T_BIGNUM:  case T_FLOAT:
     Need_Float(xx);
-    return rb_float_new((*eval)(rgi->p, ptrx, ptry, NUM2DBL(xx), rgi->a));
-    break;
-  case T_ARRAY:
-    //    n = RARRAY(xx)->len;
-    n = RARRAY_LEN(xx);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      x = rb_ary_entry(xx, i);
-      Need_Float(x);
-      val = (*eval)(rgi->p, ptrx, ptry, NUM2DBL(x), rgi->a);
-      rb_ary_store(ary, i, rb_float_new(val));
+    for (k = 0; k < 3; k++) {
+      if (!(mask & (1 << k))) continue;
+      if (!NIL_P(out[k])) rb_raise(rb_eArgError, "output given for a single value");
+      res[k] = rb_float_new((*eval[k])(p, xa, ya, NUM2DBL(xx), a));
     }
-    return ary;
     break;
   default:
+    if (TYPE(xx) == T_ARRAY) {
+      v = make_cvector_from_rarray(xx);
+      xx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+      is_ary = 1;
+    }
 #ifdef HAVE_NARRAY_H
     if (NA_IsNArray(xx)) {
       GetNArray(xx, na);
-      ptrz = (double*) na->ptr;
-      ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
-      ptr = NA_PTR_TYPE(ary, double*);
-      for (i = 0; i < na->total; i++)
-	ptr[i] = (*eval)(rgi->p, ptrx, ptry, ptrz[i], rgi->a);
-      return ary;
-    }
+      x = (double *) na->ptr;
+      n2 = na->total;
+    } else
 #endif
     if (VECTOR_P(xx)) {
       Data_Get_Struct(xx, gsl_vector, v);
-      vnew = gsl_vector_alloc(v->size);
-      for (i = 0; i < v->size; i++) {
-	val = (*eval)(rgi->p, ptrx, ptry, gsl_vector_get(v, i), rgi->a);
-	gsl_vector_set(vnew, i, val);
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
+      x = v->data; n2 = v->size; xstride = v->stride;
     } else if (MATRIX_P(xx)) {
       Data_Get_Struct(xx, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (j = 0; j < m->size2; j++) {
-	  val = (*eval)(rgi->p, ptrx, ptry, gsl_matrix_get(m, i, j), rgi->a);
-	  gsl_matrix_set(mnew, i, j, val);
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+      x = m->data; n1 = m->size1; n2 = m->size2; xtda = m->tda;
     } else {
       rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(xx)));
     }
+    for (k = 0; k < 3; k++) {
+      if (!(mask & (1 << k))) continue;
+#ifdef HAVE_NARRAY_H
+      if (na && NIL_P(out[k])) {
+	res[k] = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
+	optr[k] = NA_PTR_TYPE(res[k], double*);
+	continue;
+      }
+#endif
+      res[k] = mygsl_interp_output(out[k], xx, n1, n2, &optr[k], &ostride[k], &otda[k]);
+    }
+    for (i = 0; i < n1; i++) {
+      for (k = 0; k < 3; k++) rowptr[k] = optr[k] ? optr[k] + i*otda[k] : NULL;
+      mygsl_interp_eval_bulk(p, xa, ya, a, x + i*xtda, xstride, n2, rowptr, ostride);
+    }
+    if (is_ary) {
+      for (k = 0; k < 3; k++) {
+	if (!optr[k] || !NIL_P(out[k])) continue;
+	ary = rb_ary_new2(n2);
+	for (i = 0; i < n2; i++) rb_ary_store(ary, i, rb_float_new(optr[k][i]));
+	res[k] = ary;
+      }
+    }
     break;
   }
+  for (k = 0; k < 3; k++) if (mask & (1 << k)) nout++;
+  if (nout == 1) return res[mask == 1 ? 0 : (mask == 2 ? 1 : 2)];
+  ary = rb_ary_new();
+  for (k = 0; k < 3; k++) if (mask & (1 << k)) rb_ary_push(ary, res[k]);
+  return ary;
+}
 
-  /* never reach here */
-  return Qnil;
+/* Checks xa and ya against the interp, and evaluates argv[2] */
+static VALUE rb_gsl_interp_evaluate(int argc, VALUE *argv, VALUE obj, int mask)
+{
+  rb_gsl_interp *rgi = NULL;
+  double *ptrx = NULL, *ptry = NULL;
+  VALUE out[3] = { Qnil, Qnil, Qnil };
+  size_t size, stridex, stridey, k, nout = 0;
+  int i;
+  for (k = 0; k < 3; k++) if (mask & (1 << k)) nout++;
+  if (argc < 3 || (size_t) argc > 3 + nout)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 to %d)", argc, (int) (3 + nout));
+  Data_Get_Struct(obj, rb_gsl_interp, rgi);
+  ptrx = get_vector_ptr(argv[0], &stridex, &size);
+  if (size != rgi->p->size ){
+    rb_raise(rb_eTypeError, "size mismatch (xa:%d != %d)",  (int) size, (int) rgi->p->size);
+  }
+  ptry = get_vector_ptr(argv[1], &stridey, &size);
+  if (size != rgi->p->size ){
+    rb_raise(rb_eTypeError, "size mismatch (ya:%d != %d)", (int) size, (int) rgi->p->size);
+  }
+  for (k = 0, i = 3; k < 3 && i < argc; k++) if (mask & (1 << k)) out[k] = argv[i++];
+  return mygsl_interp_evaluate(rgi->p, ptrx, ptry, rgi->a, argv[2], mask, out);
 }
 
-static VALUE rb_gsl_interp_eval(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
+/* eval(xa, ya, x[, out]) */
+static VALUE rb_gsl_interp_eval(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_interp_evaluate(obj, xxa, yya, xx, gsl_interp_eval);
+  return rb_gsl_interp_evaluate(argc, argv, obj, 1);
 }
 
 static VALUE rb_gsl_interp_eval_e(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
@@ -282,9 +401,9 @@ static VALUE rb_gsl_interp_eval_e(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
   return Qnil;
 }
 
-static VALUE rb_gsl_interp_eval_deriv(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
+static VALUE rb_gsl_interp_eval_deriv(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_interp_evaluate(obj, xxa, yya, xx, gsl_interp_eval_deriv);
+  return rb_gsl_interp_evaluate(argc, argv, obj, 2);
 }
 
 static VALUE rb_gsl_interp_eval_deriv_e(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
@@ -311,9 +430,18 @@ static VALUE rb_gsl_interp_eval_deriv_e(VALUE obj, VALUE xxa, VALUE yya, VALUE x
   return Qnil;
 }
 
-static VALUE rb_gsl_interp_eval_deriv2(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
+static VALUE rb_gsl_interp_eval_deriv2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_interp_evaluate(obj, xxa, yya, xx, gsl_interp_eval_deriv2);
+  return rb_gsl_interp_evaluate(argc, argv, obj, 4);
+}
+
+/*
+  eval_derivs(xa, ya, x[, y, dy, d2y]): [value, first, second
+  derivative] in one pass over x
+*/
+static VALUE rb_gsl_interp_eval_derivs(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp_evaluate(argc, argv, obj, 7);
 }
 
 static VALUE rb_gsl_interp_eval_deriv2_e(VALUE obj, VALUE xxa, VALUE yya, VALUE xx)
@@ -488,14 +616,15 @@ void Init_gsl_interp(VALUE module)
   rb_define_method(cgsl_interp, "min_size", rb_gsl_interp_min_size, 0);
   rb_define_method(cgsl_interp, "init", rb_gsl_interp_init, 2);
   rb_define_method(cgsl_interp, "accel", rb_gsl_interp_accel, 0);
-  rb_define_method(cgsl_interp, "eval", rb_gsl_interp_eval, 3);
+  rb_define_method(cgsl_interp, "eval", rb_gsl_interp_eval, -1);
   rb_define_alias(cgsl_interp, "[]", "eval");
   rb_define_method(cgsl_interp, "eval_e", rb_gsl_interp_eval_e, 3);
-  rb_define_method(cgsl_interp, "eval_deriv", rb_gsl_interp_eval_deriv, 3);
+  rb_define_method(cgsl_interp, "eval_deriv", rb_gsl_interp_eval_deriv, -1);
   rb_define_alias(cgsl_interp, "deriv", "eval_deriv");
   rb_define_method(cgsl_interp, "eval_deriv_e", rb_gsl_interp_eval_deriv_e, 3);
-  rb_define_method(cgsl_interp, "eval_deriv2", rb_gsl_interp_eval_deriv2, 3);
+  rb_define_method(cgsl_interp, "eval_deriv2", rb_gsl_interp_eval_deriv2, -1);
   rb_define_alias(cgsl_interp, "deriv2", "eval_deriv2");
+  rb_define_method(cgsl_interp, "eval_derivs", rb_gsl_interp_eval_derivs, -1);
   rb_define_method(cgsl_interp, "eval_deriv2_e", rb_gsl_interp_eval_deriv2_e, 3);
   rb_define_method(cgsl_interp, "eval_integ", rb_gsl_interp_eval_integ, 4);
   rb_define_alias(cgsl_interp, "integ", "eval_integ");
@@ -504,9 +633,19 @@ void Init_gsl_interp(VALUE module)
 
   /*****/
   rb_define_method(cgsl_interp_accel, "find", rb_gsl_interp_accel_find, 2);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
+  rb_define_singleton_method(cgsl_interp_accel, "alloc", rb_gsl_interp_accel_new, 0);
+  rb_define_method(cgsl_interp_accel, "reset", rb_gsl_interp_accel_reset, 0);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
 
   rb_define_method(cgsl_interp, "find", rb_gsl_interp_find, 2);
   rb_define_alias(cgsl_interp, "accel_find", "find");
 
   rb_define_method(cgsl_interp, "info", rb_gsl_interp_info, 0);
+
+  Init_gsl_interp_uniform(cgsl_interp);
 }
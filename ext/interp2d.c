@@ -0,0 +1,601 @@
+/*
+  interp2d.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Spline2d and GSL::Interp2d (gsl_spline2d, gsl_interp2d, GSL >=
+  2.1), bilinear and bicubic.  Surfaces are ysize x xsize Matrices,
+  z[j, i] = f(xa[i], ya[j]), as GSL stores them.
+
+    sp = GSL::Spline2d.alloc("bicubic", xa, ya, z)
+    sp.eval(0.5, 1.5)                   # a Float
+    sp.eval(x, y)                       # Vectors (or Arrays) of points
+    sp.eval_deriv_x(x, y)               # also deriv_y, deriv_xx, ...
+    m = sp.grid(GSL::Vector.linspace(0, 1, 200),
+                GSL::Vector.linspace(0, 2, 100))   # 100 x 200 Matrix
+    m = sp.grid(x, y, :deriv_xy)
+
+    ip = GSL::Interp2d.alloc("bilinear", xa.size, ya.size)
+    ip.init(xa, ya, z)
+    ip.eval(xa, ya, z, x, y); ip.grid(xa, ya, z, x, y)
+
+  Evaluation uses accelerators of its own, so that a spline can be
+  shared.  grid finds the interval of each x and each y once, and
+  splits the rows over GSL.parallel_threads threads for large grids.
+*/
+
+#include "rb_gsl_config.h"
+#ifdef HAVE_GSL_GSL_INTERP2D_H
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_interp.h"
+#include <gsl/gsl_interp2d.h>
+#include <gsl/gsl_spline2d.h>
+
+static VALUE cgsl_interp2d, cgsl_spline2d;
+
+enum {
+  INTERP2D_EVAL,
+  INTERP2D_DERIV_X,
+  INTERP2D_DERIV_Y,
+  INTERP2D_DERIV_XX,
+  INTERP2D_DERIV_YY,
+  INTERP2D_DERIV_XY,
+};
+
+typedef double (*mygsl_interp2d_fn)(const gsl_interp2d *, const double [],
+				    const double [], const double [], const double,
+				    const double, gsl_interp_accel *, gsl_interp_accel *);
+
+static const mygsl_interp2d_fn interp2d_fn[] = {
+  gsl_interp2d_eval,
+  gsl_interp2d_eval_deriv_x,
+  gsl_interp2d_eval_deriv_y,
+  gsl_interp2d_eval_deriv_xx,
+  gsl_interp2d_eval_deriv_yy,
+  gsl_interp2d_eval_deriv_xy,
+};
+
+static const char *interp2d_fn_names[] = {
+  "eval", "deriv_x", "deriv_y", "deriv_xx", "deriv_yy", "deriv_xy", NULL
+};
+
+typedef struct {
+  gsl_interp2d *p;
+} rb_gsl_interp2d;
+
+static const gsl_interp2d_type* get_interp2d_type(VALUE t)
+{
+  const char *name;
+  if (NIL_P(t)) return gsl_interp2d_bicubic;
+  if (SYMBOL_P(t)) t = rb_sym2str(t);
+  name = StringValuePtr(t);
+  if (str_tail_grep(name, "bilinear") == 0) return gsl_interp2d_bilinear;
+  if (str_tail_grep(name, "bicubic") == 0) return gsl_interp2d_bicubic;
+  rb_raise(rb_eArgError, "unknown 2d interpolation type %s (bilinear or bicubic)", name);
+  return NULL;
+}
+
+/* Vector, Array or NArray coordinates; an Array is copied into *keep */
+static const double* interp2d_coords(VALUE a, size_t *stride, size_t *n, VALUE *keep)
+{
+  gsl_vector *v = NULL;
+  *keep = a;
+  if (TYPE(a) == T_ARRAY) {
+    v = make_cvector_from_rarray(a);
+    *keep = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  }
+  if (VECTOR_P(*keep)) {
+    Data_Get_Struct(*keep, gsl_vector, v);
+    *stride = v->stride;
+    *n = v->size;
+    return v->data;
+  }
+  return get_vector_ptr(*keep, stride, n);
+}
+
+/* The knots of a ysize x xsize surface, contiguous x ascending first */
+static const double* interp2d_surface(VALUE z, size_t xsize, size_t ysize, VALUE *keep)
+{
+  gsl_matrix *m = NULL, *c = NULL;
+  CHECK_MATRIX(z);
+  Data_Get_Struct(z, gsl_matrix, m);
+  if (m->size1 != ysize || m->size2 != xsize)
+    rb_raise(rb_eArgError, "surface is %dx%d, %dx%d (ysize x xsize) expected",
+	     (int) m->size1, (int) m->size2, (int) ysize, (int) xsize);
+  *keep = z;
+  if (m->tda == m->size2) return m->data;
+  c = gsl_matrix_alloc(m->size1, m->size2);
+  gsl_matrix_memcpy(c, m);
+  *keep = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, c);
+  return c->data;
+}
+
+static int interp2d_fn_index(VALUE kind)
+{
+  const char *name;
+  int k;
+  if (NIL_P(kind)) return INTERP2D_EVAL;
+  if (SYMBOL_P(kind)) kind = rb_sym2str(kind);
+  name = StringValuePtr(kind);
+  for (k = 0; interp2d_fn_names[k]; k++)
+    if (strcmp(name, interp2d_fn_names[k]) == 0) return k;
+  rb_raise(rb_eArgError, "unknown derivative %s", name);
+  return 0;
+}
+
+/* Raises GSL's EDOM unless all n points lie in [lo, hi] */
+static void interp2d_check_range(const double *x, size_t stride, size_t n,
+				 double lo, double hi)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    if (x[i*stride] < lo || x[i*stride] > hi)
+      rb_gsl_error_handler("interpolation error", __FILE__, __LINE__, GSL_EDOM);
+}
+
+/*
+  f at the points (x, y), or on the grid x times y: a Float for two
+  Numerics, a Vector for coordinate vectors, a Matrix for grid
+*/
+static VALUE interp2d_eval_points(const gsl_interp2d *p, const double xa[], const double ya[],
+				  const double za[], VALUE xx, VALUE yy, int k)
+{
+  gsl_interp_accel xacc, yacc;
+  gsl_vector *v = NULL;
+  const double *x, *y;
+  size_t xs, ys, nx, ny, n, i;
+  VALUE kx, ky, out;
+  gsl_interp_accel_reset(&xacc);
+  gsl_interp_accel_reset(&yacc);
+  if (rb_obj_is_kind_of(xx, rb_cNumeric) && rb_obj_is_kind_of(yy, rb_cNumeric))
+    return rb_float_new((*interp2d_fn[k])(p, xa, ya, za, NUM2DBL(xx), NUM2DBL(yy),
+					  &xacc, &yacc));
+  x = interp2d_coords(xx, &xs, &nx, &kx);
+  y = interp2d_coords(yy, &ys, &ny, &ky);
+  if (nx != ny) rb_raise(rb_eArgError, "%d x but %d y coordinates", (int) nx, (int) ny);
+  n = nx;
+  v = gsl_vector_alloc(n);
+  out = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  for (i = 0; i < n; i++)
+    v->data[i] = (*interp2d_fn[k])(p, xa, ya, za, x[i*xs], y[i*ys], &xacc, &yacc);
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(ky);
+  return out;
+}
+
+#define INTERP2D_GRID_ROWS 16
+
+struct interp2d_grid_task {
+  const gsl_interp2d *p;
+  const double *xa, *ya, *za;
+  mygsl_interp2d_fn fn;
+  const double *x, *y;
+  size_t xs, ys, nx, ny;
+  const size_t *ix, *iy;        /* the interval of each x and y */
+  double *out;
+  size_t tda;
+  size_t nparts, nthreads;
+};
+
+static int interp2d_grid_worker(void *data, size_t id)
+{
+  struct interp2d_grid_task *t = (struct interp2d_grid_task *) data;
+  gsl_interp_accel xacc, yacc;
+  size_t part, i, j, j0, j1, rows = (t->ny + t->nparts - 1)/t->nparts;
+  double yj;
+  gsl_interp_accel_reset(&xacc);
+  gsl_interp_accel_reset(&yacc);
+  for (part = id; part < t->nparts; part += t->nthreads) {
+    j0 = part*rows;
+    j1 = GSL_MIN(t->ny, j0 + rows);
+    for (j = j0; j < j1; j++) {
+      yj = t->y[j*t->ys];
+      for (i = 0; i < t->nx; i++) {
+	xacc.cache = t->ix[i];
+	yacc.cache = t->iy[j];
+	t->out[j*t->tda + i] = (*t->fn)(t->p, t->xa, t->ya, t->za, t->x[i*t->xs], yj,
+					&xacc, &yacc);
+      }
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static int interp2d_grid_serial(void *data)
+{
+  return interp2d_grid_worker(data, 0);
+}
+
+/* The interval of each of the n points x among the knots xa[0..size-1] */
+static void interp2d_intervals(const double xa[], size_t size, const double *x,
+			       size_t stride, size_t n, size_t *idx)
+{
+  size_t i, j = 0;
+  for (i = 0; i < n; i++) idx[i] = j = mygsl_interp_hunt(xa, size - 1, j, x[i*stride]);
+}
+
+static VALUE interp2d_grid(const gsl_interp2d *p, const double xa[], const double ya[],
+			   const double za[], VALUE xx, VALUE yy, int k)
+{
+  struct interp2d_grid_task t;
+  gsl_matrix *m = NULL;
+  size_t *ix, *iy;
+  VALUE kx, ky, out;
+  t.p = p; t.xa = xa; t.ya = ya; t.za = za;
+  t.fn = interp2d_fn[k];
+  t.x = interp2d_coords(xx, &t.xs, &t.nx, &kx);
+  t.y = interp2d_coords(yy, &t.ys, &t.ny, &ky);
+  if (t.nx == 0 || t.ny == 0) rb_raise(rb_eArgError, "empty grid");
+  interp2d_check_range(t.x, t.xs, t.nx, p->xmin, p->xmax);
+  interp2d_check_range(t.y, t.ys, t.ny, p->ymin, p->ymax);
+  m = gsl_matrix_alloc(t.ny, t.nx);
+  out = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  t.out = m->data;
+  t.tda = m->tda;
+  ix = ALLOC_N(size_t, t.nx + t.ny);
+  iy = ix + t.nx;
+  interp2d_intervals(xa, p->xsize, t.x, t.xs, t.nx, ix);
+  interp2d_intervals(ya, p->ysize, t.y, t.ys, t.ny, iy);
+  t.ix = ix; t.iy = iy;
+  t.nparts = GSL_MIN(INTERP2D_GRID_ROWS, t.ny);
+  t.nthreads = rb_gsl_parallel_nthreads(t.nx*t.ny, t.nparts);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(interp2d_grid_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(interp2d_grid_serial, &t, t.nx*t.ny);
+  xfree(ix);
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(ky);
+  return out;
+}
+
+/*****/
+
+static void rb_gsl_spline2d_free(gsl_spline2d *sp)
+{
+  gsl_spline2d_free(sp);
+}
+
+static gsl_spline2d* get_spline2d(VALUE obj)
+{
+  gsl_spline2d *sp = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_spline2d))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Spline2d expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, gsl_spline2d, sp);
+  return sp;
+}
+
+static VALUE rb_gsl_spline2d_init(VALUE obj, VALUE xxa, VALUE yya, VALUE zza)
+{
+  gsl_spline2d *sp = get_spline2d(obj);
+  const double *xa, *ya, *za;
+  size_t xs, ys, nx, ny;
+  VALUE kx, ky, kz;
+  xa = interp2d_coords(xxa, &xs, &nx, &kx);
+  ya = interp2d_coords(yya, &ys, &ny, &ky);
+  if (xs != 1 || ys != 1) rb_raise(rb_eArgError, "knots must be contiguous");
+  if (nx != sp->interp_object.xsize || ny != sp->interp_object.ysize)
+    rb_raise(rb_eArgError, "%d x %d knots, %d x %d expected", (int) nx, (int) ny,
+	     (int) sp->interp_object.xsize, (int) sp->interp_object.ysize);
+  za = interp2d_surface(zza, nx, ny, &kz);
+  gsl_spline2d_init(sp, xa, ya, za, nx, ny);
+  RB_GC_GUARD(kx);
+  RB_GC_GUARD(ky);
+  RB_GC_GUARD(kz);
+  return obj;
+}
+
+/* alloc([type,] xa, ya, z) or alloc([type,] xsize, ysize) */
+static VALUE rb_gsl_spline2d_new(int argc, VALUE *argv, VALUE klass)
+{
+  const gsl_interp2d_type *T = NULL;
+  gsl_spline2d *sp = NULL;
+  size_t nx, ny, stride;
+  VALUE obj, keep, type = Qnil;
+  if (argc > 0 && (TYPE(argv[0]) == T_STRING || SYMBOL_P(argv[0]))) {
+    type = argv[0];
+    argc--; argv++;
+  }
+  T = get_interp2d_type(type);
+  switch (argc) {
+  case 2:
+    nx = NUM2SIZET(argv[0]);
+    ny = NUM2SIZET(argv[1]);
+    break;
+  case 3:
+    interp2d_coords(argv[0], &stride, &nx, &keep);
+    interp2d_coords(argv[1], &stride, &ny, &keep);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (xsize, ysize or xa, ya, z expected)");
+  }
+  if (nx < T->min_size || ny < T->min_size)
+    rb_raise(rb_eArgError, "%s needs at least %d knots along each axis",
+	     T->name, (int) T->min_size);
+  sp = gsl_spline2d_alloc(T, nx, ny);
+  obj = Data_Wrap_Struct(klass, 0, rb_gsl_spline2d_free, sp);
+  if (argc == 3) rb_gsl_spline2d_init(obj, argv[0], argv[1], argv[2]);
+  return obj;
+}
+
+static VALUE rb_gsl_spline2d_evaluate(VALUE obj, VALUE xx, VALUE yy, int k)
+{
+  gsl_spline2d *sp = get_spline2d(obj);
+  return interp2d_eval_points(&sp->interp_object, sp->xarr, sp->yarr, sp->zarr, xx, yy, k);
+}
+
+static VALUE rb_gsl_spline2d_eval(VALUE obj, VALUE xx, VALUE yy)
+{
+  return rb_gsl_spline2d_evaluate(obj, xx, yy, INTERP2D_EVAL);
+}
+
+static VALUE rb_gsl_spline2d_eval_deriv_x(VALUE obj, VALUE xx, VALUE yy)
+{
+  return rb_gsl_spline2d_evaluate(obj, xx, yy, INTERP2D_DERIV_X);
+}
+
+static VALUE rb_gsl_spline2d_eval_deriv_y(VALUE obj, VALUE xx, VALUE yy)
+{
+  return rb_gsl_spline2d_evaluate(obj, xx, yy, INTERP2D_DERIV_Y);
+}
+
+static VALUE rb_gsl_spline2d_eval_deriv_xx(VALUE obj, VALUE xx, VALUE yy)
+{
+  return rb_gsl_spline2d_evaluate(obj, xx, yy, INTERP2D_DERIV_XX);
+}
+
+static VALUE rb_gsl_spline2d_eval_deriv_yy(VALUE obj, VALUE xx, VALUE yy)
+{
+  return rb_gsl_spline2d_evaluate(obj, xx, yy, INTERP2D_DERIV_YY);
+}
+
+static VALUE rb_gsl_spline2d_eval_deriv_xy(VALUE obj, VALUE xx, VALUE yy)
+{
+  return rb_gsl_spline2d_evaluate(obj, xx, yy, INTERP2D_DERIV_XY);
+}
+
+/* grid(x, y[, kind]): the ny x nx Matrix of f (or a derivative) on x times y */
+static VALUE rb_gsl_spline2d_grid(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_spline2d *sp = get_spline2d(obj);
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  return interp2d_grid(&sp->interp_object, sp->xarr, sp->yarr, sp->zarr, argv[0], argv[1],
+		       interp2d_fn_index(argc == 3 ? argv[2] : Qnil));
+}
+
+static VALUE rb_gsl_spline2d_name(VALUE obj)
+{
+  return rb_str_new2(gsl_spline2d_name(get_spline2d(obj)));
+}
+
+static VALUE rb_gsl_spline2d_min_size(VALUE obj)
+{
+  return SIZET2NUM(gsl_spline2d_min_size(get_spline2d(obj)));
+}
+
+static VALUE rb_gsl_spline2d_size(VALUE obj)
+{
+  gsl_spline2d *sp = get_spline2d(obj);
+  return rb_ary_new3(2, SIZET2NUM(sp->interp_object.xsize), SIZET2NUM(sp->interp_object.ysize));
+}
+
+/* The knots: [xa, ya, z], copies */
+static VALUE rb_gsl_spline2d_knots(VALUE obj)
+{
+  gsl_spline2d *sp = get_spline2d(obj);
+  size_t nx = sp->interp_object.xsize, ny = sp->interp_object.ysize;
+  gsl_vector *x = gsl_vector_alloc(nx), *y = gsl_vector_alloc(ny);
+  gsl_matrix *z = gsl_matrix_alloc(ny, nx);
+  memcpy(x->data, sp->xarr, sizeof(double)*nx);
+  memcpy(y->data, sp->yarr, sizeof(double)*ny);
+  memcpy(z->data, sp->zarr, sizeof(double)*nx*ny);
+  return rb_ary_new3(3, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x),
+		     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y),
+		     Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, z));
+}
+
+/*****/
+
+static void rb_gsl_interp2d_free(rb_gsl_interp2d *ip)
+{
+  gsl_interp2d_free(ip->p);
+  free(ip);
+}
+
+static gsl_interp2d* get_interp2d(VALUE obj)
+{
+  rb_gsl_interp2d *ip = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_interp2d))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Interp2d expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, rb_gsl_interp2d, ip);
+  return ip->p;
+}
+
+/* alloc([type,] xsize, ysize) */
+static VALUE rb_gsl_interp2d_new(int argc, VALUE *argv, VALUE klass)
+{
+  const gsl_interp2d_type *T = NULL;
+  rb_gsl_interp2d *ip = NULL;
+  size_t nx, ny;
+  VALUE type = Qnil;
+  if (argc == 3) {
+    type = argv[0];
+    argv++;
+  } else if (argc != 2) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  }
+  T = get_interp2d_type(type);
+  nx = NUM2SIZET(argv[0]);
+  ny = NUM2SIZET(argv[1]);
+  if (nx < T->min_size || ny < T->min_size)
+    rb_raise(rb_eArgError, "%s needs at least %d knots along each axis",
+	     T->name, (int) T->min_size);
+  ip = ALLOC(rb_gsl_interp2d);
+  ip->p = gsl_interp2d_alloc(T, nx, ny);
+  return Data_Wrap_Struct(klass, 0, rb_gsl_interp2d_free, ip);
+}
+
+/* The knots xa, ya, z given to an Interp2d method, checked against it */
+static void interp2d_args(gsl_interp2d *p, VALUE *argv, const double **xa,
+			  const double **ya, const double **za, VALUE *keep)
+{
+  size_t xs, ys, nx, ny;
+  *xa = interp2d_coords(argv[0], &xs, &nx, &keep[0]);
+  *ya = interp2d_coords(argv[1], &ys, &ny, &keep[1]);
+  if (xs != 1 || ys != 1) rb_raise(rb_eArgError, "knots must be contiguous");
+  if (nx != p->xsize || ny != p->ysize)
+    rb_raise(rb_eArgError, "%d x %d knots, %d x %d expected", (int) nx, (int) ny,
+	     (int) p->xsize, (int) p->ysize);
+  *za = interp2d_surface(argv[2], nx, ny, &keep[2]);
+}
+
+static VALUE rb_gsl_interp2d_init(VALUE obj, VALUE xxa, VALUE yya, VALUE zza)
+{
+  gsl_interp2d *p = get_interp2d(obj);
+  const double *xa, *ya, *za;
+  VALUE argv[3], keep[3];
+  argv[0] = xxa; argv[1] = yya; argv[2] = zza;
+  interp2d_args(p, argv, &xa, &ya, &za, keep);
+  gsl_interp2d_init(p, xa, ya, za, p->xsize, p->ysize);
+  RB_GC_GUARD(keep[0]);
+  RB_GC_GUARD(keep[1]);
+  RB_GC_GUARD(keep[2]);
+  return obj;
+}
+
+static VALUE rb_gsl_interp2d_evaluate(int argc, VALUE *argv, VALUE obj, int k)
+{
+  gsl_interp2d *p = get_interp2d(obj);
+  const double *xa, *ya, *za;
+  VALUE keep[3], res;
+  if (argc != 5) rb_raise(rb_eArgError, "wrong number of arguments (%d for 5)", argc);
+  interp2d_args(p, argv, &xa, &ya, &za, keep);
+  res = interp2d_eval_points(p, xa, ya, za, argv[3], argv[4], k);
+  RB_GC_GUARD(keep[0]);
+  RB_GC_GUARD(keep[1]);
+  RB_GC_GUARD(keep[2]);
+  return res;
+}
+
+/* eval(xa, ya, z, x, y) */
+static VALUE rb_gsl_interp2d_eval(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp2d_evaluate(argc, argv, obj, INTERP2D_EVAL);
+}
+
+static VALUE rb_gsl_interp2d_eval_deriv_x(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp2d_evaluate(argc, argv, obj, INTERP2D_DERIV_X);
+}
+
+static VALUE rb_gsl_interp2d_eval_deriv_y(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp2d_evaluate(argc, argv, obj, INTERP2D_DERIV_Y);
+}
+
+static VALUE rb_gsl_interp2d_eval_deriv_xx(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp2d_evaluate(argc, argv, obj, INTERP2D_DERIV_XX);
+}
+
+static VALUE rb_gsl_interp2d_eval_deriv_yy(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp2d_evaluate(argc, argv, obj, INTERP2D_DERIV_YY);
+}
+
+static VALUE rb_gsl_interp2d_eval_deriv_xy(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp2d_evaluate(argc, argv, obj, INTERP2D_DERIV_XY);
+}
+
+/* grid(xa, ya, z, x, y[, kind]) */
+static VALUE rb_gsl_interp2d_grid(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_interp2d *p = get_interp2d(obj);
+  const double *xa, *ya, *za;
+  VALUE keep[3], res;
+  if (argc < 5 || argc > 6)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 5 or 6)", argc);
+  interp2d_args(p, argv, &xa, &ya, &za, keep);
+  res = interp2d_grid(p, xa, ya, za, argv[3], argv[4],
+		      interp2d_fn_index(argc == 6 ? argv[5] : Qnil));
+  RB_GC_GUARD(keep[0]);
+  RB_GC_GUARD(keep[1]);
+  RB_GC_GUARD(keep[2]);
+  return res;
+}
+
+static VALUE rb_gsl_interp2d_name(VALUE obj)
+{
+  return rb_str_new2(gsl_interp2d_name(get_interp2d(obj)));
+}
+
+static VALUE rb_gsl_interp2d_min_size(VALUE obj)
+{
+  return SIZET2NUM(gsl_interp2d_min_size(get_interp2d(obj)));
+}
+
+static VALUE rb_gsl_interp2d_size(VALUE obj)
+{
+  gsl_interp2d *p = get_interp2d(obj);
+  return rb_ary_new3(2, SIZET2NUM(p->xsize), SIZET2NUM(p->ysize));
+}
+
+void Init_gsl_interp2d(VALUE module)
+{
+  cgsl_interp2d = rb_define_class_under(module, "Interp2d", cGSL_Object);
+  cgsl_spline2d = rb_define_class_under(module, "Spline2d", cGSL_Object);
+  rb_define_const(cgsl_interp2d, "BILINEAR", rb_str_new2("bilinear"));
+  rb_define_const(cgsl_interp2d, "BICUBIC", rb_str_new2("bicubic"));
+
+  rb_define_singleton_method(cgsl_interp2d, "alloc", rb_gsl_interp2d_new, -1);
+  rb_define_method(cgsl_interp2d, "init", rb_gsl_interp2d_init, 3);
+  rb_define_method(cgsl_interp2d, "eval", rb_gsl_interp2d_eval, -1);
+  rb_define_alias(cgsl_interp2d, "[]", "eval");
+  rb_define_method(cgsl_interp2d, "eval_deriv_x", rb_gsl_interp2d_eval_deriv_x, -1);
+  rb_define_alias(cgsl_interp2d, "deriv_x", "eval_deriv_x");
+  rb_define_method(cgsl_interp2d, "eval_deriv_y", rb_gsl_interp2d_eval_deriv_y, -1);
+  rb_define_alias(cgsl_interp2d, "deriv_y", "eval_deriv_y");
+  rb_define_method(cgsl_interp2d, "eval_deriv_xx", rb_gsl_interp2d_eval_deriv_xx, -1);
+  rb_define_alias(cgsl_interp2d, "deriv_xx", "eval_deriv_xx");
+  rb_define_method(cgsl_interp2d, "eval_deriv_yy", rb_gsl_interp2d_eval_deriv_yy, -1);
+  rb_define_alias(cgsl_interp2d, "deriv_yy", "eval_deriv_yy");
+  rb_define_method(cgsl_interp2d, "eval_deriv_xy", rb_gsl_interp2d_eval_deriv_xy, -1);
+  rb_define_alias(cgsl_interp2d, "deriv_xy", "eval_deriv_xy");
+  rb_define_method(cgsl_interp2d, "grid", rb_gsl_interp2d_grid, -1);
+  rb_define_method(cgsl_interp2d, "name", rb_gsl_interp2d_name, 0);
+  rb_define_alias(cgsl_interp2d, "type", "name");
+  rb_define_method(cgsl_interp2d, "min_size", rb_gsl_interp2d_min_size, 0);
+  rb_define_method(cgsl_interp2d, "size", rb_gsl_interp2d_size, 0);
+
+  rb_define_singleton_method(cgsl_spline2d, "alloc", rb_gsl_spline2d_new, -1);
+  rb_define_method(cgsl_spline2d, "init", rb_gsl_spline2d_init, 3);
+  rb_define_method(cgsl_spline2d, "eval", rb_gsl_spline2d_eval, 2);
+  rb_define_alias(cgsl_spline2d, "[]", "eval");
+  rb_define_method(cgsl_spline2d, "eval_deriv_x", rb_gsl_spline2d_eval_deriv_x, 2);
+  rb_define_alias(cgsl_spline2d, "deriv_x", "eval_deriv_x");
+  rb_define_method(cgsl_spline2d, "eval_deriv_y", rb_gsl_spline2d_eval_deriv_y, 2);
+  rb_define_alias(cgsl_spline2d, "deriv_y", "eval_deriv_y");
+  rb_define_method(cgsl_spline2d, "eval_deriv_xx", rb_gsl_spline2d_eval_deriv_xx, 2);
+  rb_define_alias(cgsl_spline2d, "deriv_xx", "eval_deriv_xx");
+  rb_define_method(cgsl_spline2d, "eval_deriv_yy", rb_gsl_spline2d_eval_deriv_yy, 2);
+  rb_define_alias(cgsl_spline2d, "deriv_yy", "eval_deriv_yy");
+  rb_define_method(cgsl_spline2d, "eval_deriv_xy", rb_gsl_spline2d_eval_deriv_xy, 2);
+  rb_define_alias(cgsl_spline2d, "deriv_xy", "eval_deriv_xy");
+  rb_define_method(cgsl_spline2d, "grid", rb_gsl_spline2d_grid, -1);
+  rb_define_method(cgsl_spline2d, "name", rb_gsl_spline2d_name, 0);
+  rb_define_alias(cgsl_spline2d, "type", "name");
+  rb_define_method(cgsl_spline2d, "min_size", rb_gsl_spline2d_min_size, 0);
+  rb_define_method(cgsl_spline2d, "size", rb_gsl_spline2d_size, 0);
+  rb_define_method(cgsl_spline2d, "knots", rb_gsl_spline2d_knots, 0);
+}
+
+#endif
@@ -0,0 +1,420 @@
+/*
+  interp_uniform.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Interpolation of data tabulated on a uniform grid x[i] = x0 + i*dx.
+
+    u = GSL::Interp::Uniform.alloc("cspline", x0, dx, ya)
+    u = GSL::Interp::Uniform.alloc("akima", xa, ya)   # xa checked uniform
+    u.eval(x)            # also [], eval_deriv, eval_deriv2 and eval_integ
+
+  The interval of x is (x - x0)/dx, in O(1) instead of the search of
+  gsl_interp_accel_find, and each interval keeps the coefficients of its
+  cubic y[i] + b t + c t^2 + d t^3, t = x - x[i].  The types are linear,
+  cspline (natural) and akima, with the coefficients of GSL's own
+  gsl_interp types, so that the values agree with GSL::Interp on the
+  same data to rounding.  ya is copied.
+
+  x is a Numeric, a Range, an Array, a Vector or a Matrix; a Vector or Matrix can
+  be given for the result.  Bulk input runs without the GVL, split over
+  GSL.parallel_threads above GSL.parallel_threshold points.  Points
+  outside [x0, x0 + (n - 1) dx] (xa[n-1] when xa is given) raise GSL::ERROR::EDOM, as for
+  GSL::Interp, after the others have been evaluated (NaN there).
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_interp.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+static VALUE cgsl_interp_uniform;
+
+#define INTERP_UNIFORM_BLOCK 4096
+
+typedef struct {
+  const gsl_interp_type *T;
+  size_t n;                     /* knots */
+  double x0, dx, xmax;          /* xmax = xa[n-1] or x0 + (n - 1) dx */
+  double *coef;                 /* (n - 1) x 4: y[i], b, c, d */
+} mygsl_interp_uniform;
+
+static void mygsl_interp_uniform_free(mygsl_interp_uniform *u)
+{
+  xfree(u->coef);
+  xfree(u);
+}
+
+static void interp_uniform_linear(mygsl_interp_uniform *u, const double *y)
+{
+  size_t i;
+  double *a;
+  for (i = 0; i + 1 < u->n; i++) {
+    a = u->coef + 4*i;
+    a[0] = y[i];
+    a[1] = (y[i+1] - y[i])/u->dx;
+    a[2] = a[3] = 0.0;
+  }
+}
+
+/* The natural cubic spline of gsl_interp_cspline: c = y''/2 from
+   c[i-1] + 4 c[i] + c[i+1] = 3 (y[i+1] - 2 y[i] + y[i-1])/h^2 */
+static void interp_uniform_cspline(mygsl_interp_uniform *u, const double *y)
+{
+  size_t n = u->n, i;
+  double h = u->dx, *c, *w, *a, m;
+  c = ALLOC_N(double, 2*n);
+  w = c + n;
+  c[0] = c[n-1] = 0.0;
+  /* forward elimination, w the modified superdiagonal */
+  for (i = 1; i + 1 < n; i++) {
+    c[i] = 3.0*(y[i+1] - 2.0*y[i] + y[i-1])/(h*h);
+    m = 4.0 - (i > 1 ? w[i-1] : 0.0);
+    w[i] = 1.0/m;
+    c[i] = (c[i] - (i > 1 ? c[i-1] : 0.0))/m;
+  }
+  for (i = n - 2; i > 1; i--) c[i-1] -= w[i-1]*c[i];
+  for (i = 0; i + 1 < n; i++) {
+    a = u->coef + 4*i;
+    a[0] = y[i];
+    a[1] = (y[i+1] - y[i])/h - h*(c[i+1] + 2.0*c[i])/3.0;
+    a[2] = c[i];
+    a[3] = (c[i+1] - c[i])/(3.0*h);
+  }
+  xfree(c);
+}
+
+/* gsl_interp_akima: slopes m[-2 .. n] with the end extensions of Akima */
+static void interp_uniform_akima(mygsl_interp_uniform *u, const double *y)
+{
+  size_t n = u->n, i;
+  double h = u->dx, *mm, *m, *a, ne, ne_next, alpha, alpha_next, tl_next, b;
+  mm = ALLOC_N(double, n + 3);
+  m = mm + 2;
+  for (i = 0; i + 1 < n; i++) m[i] = (y[i+1] - y[i])/h;
+  m[-2] = 3.0*m[0] - 2.0*m[1];
+  m[-1] = 2.0*m[0] - m[1];
+  m[n-1] = 2.0*m[n-2] - m[n-3];
+  m[n] = 3.0*m[n-2] - 2.0*m[n-3];
+  for (i = 0; i + 1 < n; i++) {
+    a = u->coef + 4*i;
+    a[0] = y[i];
+    ne = fabs(m[i+1] - m[i]) + fabs(m[(long) i - 1] - m[(long) i - 2]);
+    if (ne == 0.0) {
+      a[1] = m[i];
+      a[2] = a[3] = 0.0;
+      continue;
+    }
+    ne_next = fabs(m[i+2] - m[i+1]) + fabs(m[i] - m[(long) i - 1]);
+    alpha = fabs(m[(long) i - 1] - m[(long) i - 2])/ne;
+    if (ne_next == 0.0) {
+      tl_next = m[i];
+    } else {
+      alpha_next = fabs(m[i] - m[(long) i - 1])/ne_next;
+      tl_next = (1.0 - alpha_next)*m[i] + alpha_next*m[i+1];
+    }
+    b = (1.0 - alpha)*m[(long) i - 1] + alpha*m[i];
+    a[1] = b;
+    a[2] = (3.0*m[i] - 2.0*b - tl_next)/h;
+    a[3] = (b + tl_next - 2.0*m[i])/(h*h);
+  }
+  xfree(mm);
+}
+
+/* The interval of x and the offset t in it; 0 outside the grid */
+static int interp_uniform_find(const mygsl_interp_uniform *u, double x, size_t *i,
+			       double *t)
+{
+  double s;
+  size_t k;
+  if (!(x >= u->x0 && x <= u->xmax)) return 0;
+  s = (x - u->x0)/u->dx;
+  k = s < (double) (u->n - 2) ? (size_t) s : u->n - 2;
+  *i = k;
+  *t = x - (u->x0 + k*u->dx);
+  return 1;
+}
+
+/* k = 0, 1, 2: the value, first and second derivatives at x */
+static double interp_uniform_eval1(const mygsl_interp_uniform *u, double x, int k)
+{
+  const double *a;
+  size_t i;
+  double t;
+  if (!interp_uniform_find(u, x, &i, &t)) return GSL_NAN;
+  a = u->coef + 4*i;
+  switch (k) {
+  case 0: return a[0] + t*(a[1] + t*(a[2] + t*a[3]));
+  case 1: return a[1] + t*(2.0*a[2] + 3.0*t*a[3]);
+  default: return 2.0*a[2] + 6.0*t*a[3];
+  }
+}
+
+struct interp_uniform_task {
+  const mygsl_interp_uniform *u;
+  const double *x;
+  size_t n1, n2, xstride, xtda;
+  double *out[3];
+  size_t ostride[3], otda[3];
+  size_t nper, nblocks, nthreads;
+};
+
+/* Block b: the rows of n2 points are cut into nper blocks each */
+static int interp_uniform_block(struct interp_uniform_task *t, size_t b)
+{
+  size_t r = b/t->nper, j0 = (b % t->nper)*INTERP_UNIFORM_BLOCK, j1, j, k, i;
+  const double *x = t->x + r*t->xtda;
+  double dt;
+  int bad = 0;
+  j1 = GSL_MIN(j0 + INTERP_UNIFORM_BLOCK, t->n2);
+  for (j = j0; j < j1; j++) {
+    for (k = 0; k < 3; k++) {
+      if (!t->out[k]) continue;
+      t->out[k][r*t->otda[k] + j*t->ostride[k]]
+	= interp_uniform_eval1(t->u, x[j*t->xstride], (int) k);
+    }
+    if (!interp_uniform_find(t->u, x[j*t->xstride], &i, &dt)) bad = 1;
+  }
+  if (bad) GSL_ERROR("interpolation error", GSL_EDOM);
+  return GSL_SUCCESS;
+}
+
+static int interp_uniform_worker(void *data, size_t id)
+{
+  struct interp_uniform_task *t = (struct interp_uniform_task *) data;
+  size_t b;
+  for (b = id; b < t->nblocks; b += t->nthreads) interp_uniform_block(t, b);
+  return GSL_SUCCESS;
+}
+
+static int interp_uniform_serial(void *data)
+{
+  return interp_uniform_worker(data, 0);
+}
+
+/* The integral of the cubic of interval i over [t0, t1] */
+static double interp_uniform_integ1(const double *a, double t0, double t1)
+{
+  double F0, F1;
+  F0 = t0*(a[0] + t0*(a[1]/2.0 + t0*(a[2]/3.0 + t0*a[3]/4.0)));
+  F1 = t1*(a[0] + t1*(a[1]/2.0 + t1*(a[2]/3.0 + t1*a[3]/4.0)));
+  return F1 - F0;
+}
+
+static double interp_uniform_integ(const mygsl_interp_uniform *u, double a, double b)
+{
+  size_t i0, i1, i;
+  double t0, t1, s = 0.0;
+  if (a > b) GSL_ERROR_VAL("a must be less than or equal to b", GSL_EINVAL, GSL_NAN);
+  if (!interp_uniform_find(u, a, &i0, &t0) || !interp_uniform_find(u, b, &i1, &t1))
+    GSL_ERROR_VAL("interpolation error", GSL_EDOM, GSL_NAN);
+  if (i0 == i1) return interp_uniform_integ1(u->coef + 4*i0, t0, t1);
+  s = interp_uniform_integ1(u->coef + 4*i0, t0, u->dx);
+  for (i = i0 + 1; i < i1; i++) s += interp_uniform_integ1(u->coef + 4*i, 0.0, u->dx);
+  return s + interp_uniform_integ1(u->coef + 4*i1, 0.0, t1);
+}
+
+/* x0, dx and the number of knots of a grid given as xa, checked uniform */
+static void interp_uniform_grid(VALUE vx, size_t ny, double *x0, double *dx, double *xmax)
+{
+  double *xa, h, tol;
+  size_t stride, n, i;
+  xa = get_vector_ptr(vx, &stride, &n);
+  if (n != ny) rb_raise(rb_eArgError, "size mismatch (xa:%d != ya:%d)", (int) n, (int) ny);
+  if (n < 2) rb_raise(rb_eArgError, "at least 2 knots are needed");
+  *x0 = xa[0];
+  h = (xa[(n-1)*stride] - xa[0])/(n - 1);
+  tol = 64.0*GSL_DBL_EPSILON*GSL_MAX(fabs(xa[0]), fabs(xa[(n-1)*stride]));
+  for (i = 1; i < n; i++)
+    if (fabs(xa[i*stride] - (xa[0] + i*h)) > tol + 64.0*GSL_DBL_EPSILON*fabs(h)*i)
+      rb_raise(rb_eArgError, "xa is not uniformly spaced (xa[%d] = %g, %g expected)",
+	       (int) i, xa[i*stride], xa[0] + i*h);
+  *dx = h;
+  *xmax = xa[(n-1)*stride];
+}
+
+/*
+  GSL::Interp::Uniform.alloc(type, x0, dx, ya)
+  GSL::Interp::Uniform.alloc(type, xa, ya)
+*/
+static VALUE rb_gsl_interp_uniform_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_interp_uniform *u = NULL;
+  const gsl_interp_type *T;
+  double *ya, *y, x0, dx, xmax;
+  size_t stride, n, i, nmin;
+  VALUE vy;
+  if (argc != 3 && argc != 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  T = get_interp_type(argv[0]);
+  if (T == gsl_interp_linear) nmin = 2;
+  else if (T == gsl_interp_cspline) nmin = 3;
+  else if (T == gsl_interp_akima) nmin = 5;
+  else rb_raise(rb_eArgError, "%s is not available on a uniform grid (linear, cspline, akima)",
+		T->name);
+  vy = argv[argc-1];
+  ya = get_vector_ptr(vy, &stride, &n);
+  if (argc == 3) {
+    interp_uniform_grid(argv[1], n, &x0, &dx, &xmax);
+  } else {
+    x0 = NUM2DBL(rb_Float(argv[1]));
+    dx = NUM2DBL(rb_Float(argv[2]));
+    xmax = x0 + (n - 1)*dx;
+  }
+  if (!(dx > 0.0) || !gsl_finite(x0) || !gsl_finite(dx))
+    rb_raise(rb_eArgError, "the grid must be increasing (dx = %g)", dx);
+  if (n < nmin)
+    rb_raise(rb_eArgError, "%s needs at least %d knots, %d given", T->name, (int) nmin, (int) n);
+  y = ALLOC_N(double, n);
+  for (i = 0; i < n; i++) y[i] = ya[i*stride];
+  u = ALLOC(mygsl_interp_uniform);
+  u->T = T;
+  u->n = n;
+  u->x0 = x0;
+  u->dx = dx;
+  u->xmax = xmax;
+  u->coef = ALLOC_N(double, 4*(n - 1));
+  if (T == gsl_interp_linear) interp_uniform_linear(u, y);
+  else if (T == gsl_interp_cspline) interp_uniform_cspline(u, y);
+  else interp_uniform_akima(u, y);
+  xfree(y);
+  return Data_Wrap_Struct(klass, 0, mygsl_interp_uniform_free, u);
+}
+
+/* As mygsl_interp_evaluate, for a Numeric, Array, Vector or Matrix xx */
+static VALUE rb_gsl_interp_uniform_evaluate(int argc, VALUE *argv, VALUE obj, int mask)
+{
+  struct interp_uniform_task t;
+  mygsl_interp_uniform *u = NULL;
+  gsl_vector *v = NULL;
+  gsl_matrix *m = NULL;
+  VALUE xx, out[3] = { Qnil, Qnil, Qnil }, res[3] = { Qnil, Qnil, Qnil }, ary;
+  size_t i, k, kk = 0;
+  int is_ary = 0, nout = 0;
+  double y, t0;
+  for (k = 0; k < 3; k++) if (mask & (1 << k)) { kk = k; nout++; }
+  if (argc < 1 || argc > 1 + nout)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 to %d)", argc, 1 + nout);
+  Data_Get_Struct(obj, mygsl_interp_uniform, u);
+  xx = argv[0];
+  if (argc > 1) out[kk] = argv[1];
+  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+  switch (TYPE(xx)) {
+  case T_FIXNUM:  case T_BIGNUM:  case T_FLOAT:
+    if (!NIL_P(out[kk])) rb_raise(rb_eArgError, "output given for a single value");
+    y = NUM2DBL(xx);
+    if (!interp_uniform_find(u, y, &i, &t0))
+      GSL_ERROR_VAL("interpolation error", GSL_EDOM, rb_float_new(GSL_NAN));
+    return rb_float_new(interp_uniform_eval1(u, y, (int) kk));
+  default:
+    break;
+  }
+  if (TYPE(xx) == T_ARRAY) {
+    v = make_cvector_from_rarray(xx);
+    xx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    is_ary = 1;
+  }
+  memset(&t, 0, sizeof(t));
+  t.u = u;
+  t.n1 = 1;
+  t.xstride = 1;
+  if (VECTOR_P(xx)) {
+    Data_Get_Struct(xx, gsl_vector, v);
+    t.x = v->data; t.n2 = v->size; t.xstride = v->stride;
+  } else if (MATRIX_P(xx)) {
+    Data_Get_Struct(xx, gsl_matrix, m);
+    t.x = m->data; t.n1 = m->size1; t.n2 = m->size2; t.xtda = m->tda;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(xx)));
+  }
+  res[kk] = mygsl_interp_output(out[kk], xx, t.n1, t.n2, &t.out[kk], &t.ostride[kk],
+				&t.otda[kk]);
+  t.nper = (t.n2 + INTERP_UNIFORM_BLOCK - 1)/INTERP_UNIFORM_BLOCK;
+  t.nblocks = t.n1*t.nper;
+  t.nthreads = rb_gsl_parallel_nthreads(t.n1*t.n2, t.nblocks);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(interp_uniform_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(interp_uniform_serial, &t, t.n1*t.n2);
+  if (is_ary && NIL_P(out[kk])) {
+    ary = rb_ary_new2(t.n2);
+    for (i = 0; i < t.n2; i++) rb_ary_store(ary, i, rb_float_new(t.out[kk][i]));
+    res[kk] = ary;
+  }
+  RB_GC_GUARD(xx);
+  return res[kk];
+}
+
+/* eval(x[, out]) */
+static VALUE rb_gsl_interp_uniform_eval(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp_uniform_evaluate(argc, argv, obj, 1);
+}
+
+static VALUE rb_gsl_interp_uniform_eval_deriv(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp_uniform_evaluate(argc, argv, obj, 2);
+}
+
+static VALUE rb_gsl_interp_uniform_eval_deriv2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_interp_uniform_evaluate(argc, argv, obj, 4);
+}
+
+static VALUE rb_gsl_interp_uniform_eval_integ(VALUE obj, VALUE aa, VALUE bb)
+{
+  mygsl_interp_uniform *u = NULL;
+  Data_Get_Struct(obj, mygsl_interp_uniform, u);
+  return rb_float_new(interp_uniform_integ(u, NUM2DBL(rb_Float(aa)), NUM2DBL(rb_Float(bb))));
+}
+
+static VALUE rb_gsl_interp_uniform_name(VALUE obj)
+{
+  mygsl_interp_uniform *u = NULL;
+  Data_Get_Struct(obj, mygsl_interp_uniform, u);
+  return rb_str_new2(u->T->name);
+}
+
+static VALUE rb_gsl_interp_uniform_x0(VALUE obj)
+{
+  mygsl_interp_uniform *u = NULL;
+  Data_Get_Struct(obj, mygsl_interp_uniform, u);
+  return rb_float_new(u->x0);
+}
+
+static VALUE rb_gsl_interp_uniform_dx(VALUE obj)
+{
+  mygsl_interp_uniform *u = NULL;
+  Data_Get_Struct(obj, mygsl_interp_uniform, u);
+  return rb_float_new(u->dx);
+}
+
+static VALUE rb_gsl_interp_uniform_size(VALUE obj)
+{
+  mygsl_interp_uniform *u = NULL;
+  Data_Get_Struct(obj, mygsl_interp_uniform, u);
+  return SIZET2NUM(u->n);
+}
+
+void Init_gsl_interp_uniform(VALUE cgsl_interp)
+{
+  cgsl_interp_uniform = rb_define_class_under(cgsl_interp, "Uniform", cGSL_Object);
+  rb_define_singleton_method(cgsl_interp_uniform, "alloc", rb_gsl_interp_uniform_new, -1);
+  rb_define_method(cgsl_interp_uniform, "eval", rb_gsl_interp_uniform_eval, -1);
+  rb_define_alias(cgsl_interp_uniform, "[]", "eval");
+  rb_define_method(cgsl_interp_uniform, "eval_deriv", rb_gsl_interp_uniform_eval_deriv, -1);
+  rb_define_alias(cgsl_interp_uniform, "deriv", "eval_deriv");
+  rb_define_method(cgsl_interp_uniform, "eval_deriv2", rb_gsl_interp_uniform_eval_deriv2, -1);
+  rb_define_alias(cgsl_interp_uniform, "deriv2", "eval_deriv2");
+  rb_define_method(cgsl_interp_uniform, "eval_integ", rb_gsl_interp_uniform_eval_integ, 2);
+  rb_define_alias(cgsl_interp_uniform, "integ", "eval_integ");
+  rb_define_method(cgsl_interp_uniform, "name", rb_gsl_interp_uniform_name, 0);
+  rb_define_alias(cgsl_interp_uniform, "type", "name");
+  rb_define_method(cgsl_interp_uniform, "x0", rb_gsl_interp_uniform_x0, 0);
+  rb_define_method(cgsl_interp_uniform, "dx", rb_gsl_interp_uniform_dx, 0);
+  rb_define_method(cgsl_interp_uniform, "size", rb_gsl_interp_uniform_size, 0);
+}
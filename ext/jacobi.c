@@ -1,6 +1,7 @@
 #ifdef HAVE_JACOBI_H
 #include "rb_gsl.h"
 #include "jacobi.h"
+#include <gsl/gsl_blas.h>
 
 static VALUE jac_eval3_e(VALUE x, VALUE a, VALUE b,
 										int (*f)(double, double, double, gsl_sf_result*))
@@ -254,14 +255,14 @@ static VALUE rb_jac_quadrature_alpha(VALUE obj)
 {
 	jac_quadrature *q;
 	Data_Get_Struct(obj, jac_quadrature, q);
-	return NUM2DBL(q->alpha);
+	return rb_float_new(q->alpha);
 }
 
 static VALUE rb_jac_quadrature_beta(VALUE obj)
 {
 	jac_quadrature *q;
 	Data_Get_Struct(obj, jac_quadrature, q);
-	return NUM2DBL(q->beta);
+	return rb_float_new(q->beta);
 }
 
 static VALUE rb_jac_quadrature_x(VALUE obj)
@@ -306,7 +307,7 @@ static VALUE rb_jac_quadrature_xp(VALUE obj)
 	gsl_vector_view *v;
 	Data_Get_Struct(obj, jac_quadrature, q);
 	v = gsl_vector_view_alloc();
-	v->vector.data = q->w;
+	v->vector.data = q->xp;
 	v->vector.size = q->np;
 	v->vector.stride = 1;
 	return Data_Wrap_Struct(cgsl_vector_view, 0, gsl_vector_view_free, v);
@@ -318,6 +319,7 @@ static VALUE rb_jac_interpmat_alloc(int argc, VALUE *argv, VALUE obj)
 	jac_quadrature *q;
 	gsl_vector *xp;
 	int np;
+	rb_check_frozen(obj);
 	Data_Get_Struct(obj, jac_quadrature, q);	
 	switch (argc) {
 	case 1:
@@ -334,12 +336,13 @@ static VALUE rb_jac_interpmat_alloc(int argc, VALUE *argv, VALUE obj)
 		rb_raise(rb_eArgError, "Wrong number of arguments (%d for 1 or 2)", argc);
 	}
 	err = jac_interpmat_alloc(q, np, xp->data);
-	return FIX2INT(err);
+	return INT2FIX(err);
 }
 
 static VALUE rb_jac_interpmat_free(VALUE obj)
 {
 	jac_quadrature *q;	
+	rb_check_frozen(obj);
 	Data_Get_Struct(obj, jac_quadrature, q);		
 	jac_interpmat_free(q);
 	return Qtrue;
@@ -351,6 +354,7 @@ static VALUE rb_jac_quadrature_zwd(int argc, VALUE *argv, VALUE obj)
 	gsl_vector *ws;
 	int flag = 0, type, status;
 	double a, b;
+	rb_check_frozen(obj);
 	Data_Get_Struct(obj, jac_quadrature, q);			
 	switch (argc) {
 	case 3:
@@ -374,26 +378,111 @@ static VALUE rb_jac_quadrature_zwd(int argc, VALUE *argv, VALUE obj)
 	return INT2FIX(status);
 }
 
+/*
+  Rules shared by (type, Q, alpha, beta): Quadrature.cache(type, Q, a, b)
+  returns the same frozen quadrature, zeros, weights and differentiation
+  matrix computed once, for every call.
+*/
+static VALUE jac_quadrature_cache = Qnil;
+
+static VALUE rb_jac_quadrature_cache(VALUE klass, VALUE vtype, VALUE vQ,
+				     VALUE va, VALUE vb)
+{
+	jac_quadrature *q;
+	gsl_vector *ws;
+	VALUE key, obj;
+	int Q, status;
+	Q = FIX2INT(vQ);
+	if (Q <= 0) rb_raise(rb_eArgError, "Q must be positive");
+	key = rb_ary_new3(4, INT2FIX(FIX2INT(vtype)), INT2FIX(Q),
+			  rb_float_new(NUM2DBL(va)), rb_float_new(NUM2DBL(vb)));
+	obj = rb_hash_aref(jac_quadrature_cache, key);
+	if (NIL_P(obj)) {
+		obj = rb_jac_quadrature_alloc(klass, INT2FIX(Q));
+		Data_Get_Struct(obj, jac_quadrature, q);
+		ws = gsl_vector_alloc(Q);
+		status = jac_quadrature_zwd(q, FIX2INT(vtype), NUM2DBL(va), NUM2DBL(vb), ws->data);
+		gsl_vector_free(ws);
+		if (status != GSL_SUCCESS)
+			rb_raise(rb_eRuntimeError, "Something wrong. (error code %d)", status);
+		rb_obj_freeze(obj);
+		rb_hash_aset(jac_quadrature_cache, rb_obj_freeze(key), obj);
+	}
+	return obj;
+}
+
+static VALUE rb_jac_quadrature_cache_size(VALUE klass)
+{
+	return INT2FIX(RHASH_SIZE(jac_quadrature_cache));
+}
+
+static VALUE rb_jac_quadrature_cache_clear(VALUE klass)
+{
+	rb_hash_clear(jac_quadrature_cache);
+	return klass;
+}
+
+/* out = f op(A)^T for the rows of f, given at the Q nodes: A is the
+   m x Q row-major matrix D (m = Q) or imat (m = np) */
+static VALUE jac_rows_apply(VALUE ff, VALUE vout, const double *A, size_t m, size_t Q)
+{
+	gsl_matrix *f, *out;
+	gsl_matrix_const_view Av = gsl_matrix_const_view_array(A, m, Q);
+	Data_Get_Struct(ff, gsl_matrix, f);
+	if (f->size2 != Q)
+		rb_raise(rb_eArgError, "matrix with %d columns (Q = %d expected)", (int) f->size2, (int) Q);
+	if (NIL_P(vout)) {
+		out = gsl_matrix_alloc(f->size1, m);
+		vout = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, out);
+	} else {
+		CHECK_MATRIX(vout);
+		Data_Get_Struct(vout, gsl_matrix, out);
+		if (out->size1 != f->size1 || out->size2 != m)
+			rb_raise(rb_eArgError, "output matrix must be %d x %d", (int) f->size1, (int) m);
+	}
+	gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, f, &Av.matrix, 0.0, out);
+	return vout;
+}
+
+/* q.integrate(f): f a Vector of values at the nodes, or a Matrix of one
+   function per row for the Vector of the integrals */
 static VALUE rb_jac_integrate(VALUE obj, VALUE ff)
 {
 	jac_quadrature *q;
-	gsl_vector *f;
-	CHECK_VECTOR(ff);
+	gsl_vector *f, *r;
+	gsl_matrix *m;
+	gsl_vector_const_view w;
 	Data_Get_Struct(obj, jac_quadrature, q);
+	if (MATRIX_P(ff)) {
+		Data_Get_Struct(ff, gsl_matrix, m);
+		if (m->size2 != (size_t) q->Q)
+			rb_raise(rb_eArgError, "matrix with %d columns (Q = %d expected)", (int) m->size2, q->Q);
+		w = gsl_vector_const_view_array(q->w, q->Q);
+		r = gsl_vector_alloc(m->size1);
+		gsl_blas_dgemv(CblasNoTrans, 1.0, m, &w.vector, 0.0, r);
+		return Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, r);
+	}
+	CHECK_VECTOR(ff);
 	Data_Get_Struct(ff, gsl_vector, f);
 	return rb_float_new(jac_integrate(q, f->data));
 }
 
+/* q.interpolate(f[, out]): f a Vector, or a Matrix interpolated row by
+   row in a single dgemm */
 static VALUE rb_jac_interpolate(int argc, VALUE *argv, VALUE obj)
 {
 	jac_quadrature *q;
 	gsl_vector *f, *fout;
 	VALUE vfout;
+	Data_Get_Struct(obj, jac_quadrature, q);
+	if (q->imat == NULL) rb_raise(rb_eRuntimeError, "no interpolation matrix (call interpmat_alloc)");
+	if (argc >= 1 && argc <= 2 && MATRIX_P(argv[0]))
+		return jac_rows_apply(argv[0], argc == 2 ? argv[1] : Qnil, q->imat, q->np, q->Q);
 	switch (argc) {
 	case 1:
 		CHECK_VECTOR(argv[0]);
 		Data_Get_Struct(argv[0], gsl_vector, f);
-		fout = gsl_vector_alloc(f->size);
+		fout = gsl_vector_alloc(q->np);
 		vfout = Data_Wrap_Struct(VECTOR_ROW_COL(CLASS_OF(argv[0])), 0, gsl_vector_free, fout);
 		break;
 	case 2:
@@ -406,16 +495,20 @@ static VALUE rb_jac_interpolate(int argc, VALUE *argv, VALUE obj)
 	default:
 		rb_raise(rb_eArgError, "Wrong number of arguments (%d for 1 or 2)", argc);
 	}
-	Data_Get_Struct(obj, jac_quadrature, q);
 	jac_interpolate(q, f->data, fout->data);
 	return vfout;
 }
 
+/* q.differentiate(f[, out]): f a Vector, or a Matrix differentiated row
+   by row in a single dgemm */
 static VALUE rb_jac_differentiate(int argc, VALUE *argv, VALUE obj)
 {
 	jac_quadrature *q;
 	gsl_vector *f, *fout;
 	VALUE vfout;
+	Data_Get_Struct(obj, jac_quadrature, q);
+	if (argc >= 1 && argc <= 2 && MATRIX_P(argv[0]))
+		return jac_rows_apply(argv[0], argc == 2 ? argv[1] : Qnil, q->D, q->Q, q->Q);
 	switch (argc) {
 	case 1:
 		CHECK_VECTOR(argv[0]);
@@ -433,7 +526,6 @@ static VALUE rb_jac_differentiate(int argc, VALUE *argv, VALUE obj)
 	default:
 		rb_raise(rb_eArgError, "Wrong number of arguments (%d for 1 or 2)", argc);
 	}
-	Data_Get_Struct(obj, jac_quadrature, q);
 	jac_differentiate(q, f->data, fout->data);
 	return vfout;
 }
@@ -674,6 +766,8 @@ void Init_jacobi(VALUE module)
 {
 	VALUE mjac, cjacq;
 	
+	/* The results are GSL::Sf::Result, defined on first use */
+	rb_const_get(module, rb_intern("Sf"));
 	mjac = rb_define_module("Jac");
 	jac_define_const(mjac);
 	cjacq = rb_define_class_under(mjac, "Quadrature", cGSL_Object);
@@ -693,6 +787,11 @@ void Init_jacobi(VALUE module)
 
 	/*****/
 	rb_define_singleton_method(cjacq, "alloc", rb_jac_quadrature_alloc, 1);
+	jac_quadrature_cache = rb_hash_new();
+	rb_global_variable(&jac_quadrature_cache);
+	rb_define_singleton_method(cjacq, "cache", rb_jac_quadrature_cache, 4);
+	rb_define_singleton_method(cjacq, "cache_size", rb_jac_quadrature_cache_size, 0);
+	rb_define_singleton_method(cjacq, "cache_clear", rb_jac_quadrature_cache_clear, 0);
 	rb_define_method(cjacq, "Q", rb_jac_quadrature_Q, 0);
 	rb_define_method(cjacq, "type", rb_jac_quadrature_type, 0);	
 	rb_define_method(cjacq, "alpha", rb_jac_quadrature_alpha, 0);	
@@ -0,0 +1,677 @@
+/*
+  kde.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Gaussian kernel density estimates on a grid, by linear binning and
+  FFT convolution (Wand, J. Comput. Graph. Stat. 3, 1994; R's
+  KernSmooth::bkde):
+
+    grid, f = GSL::KDE.density(x)                   # 512 points
+    grid, f = GSL::KDE.density(x, :n => 1024, :bandwidth => :scott)
+    h2 = GSL::KDE.density2d(x, y, :n => [128, 96])  # a Histogram2d
+    GSL::KDE.bandwidth(x)                           # Silverman's rule
+
+  Each point is split between the two grid points around it (four in
+  2-D) in proportion to its distance to them, and the grid counts are
+  convolved with the kernel sampled at the grid spacing out to
+  KDE_TAU bandwidths, along each axis in 2-D.  That is O(n) for the
+  points, spread over threads with the GVL released in parts summed in
+  a fixed order, plus O(m log m) for the m grid points, instead of
+  O(n m) for direct sums; the binning error is O(delta^2) in the grid
+  spacing.  NaNs are skipped.
+
+  x is a Vector, an Array or an NArray; density2d takes x and y or an
+  n x 2 Matrix.  Options:
+    :n          grid points, 512 (density2d: 128, or [nx, ny])
+    :range      [a, b] (density2d: [[xa, xb], [ya, yb]]), by default
+                the range of the data widened by :cut bandwidths
+    :cut        3
+    :bandwidth  a number ([hx, hy] in 2-D), :silverman (default) or :scott
+    :weights    one weight per point
+  density returns the grid and the density as Vectors, density2d a
+  Histogram2d with the density at the grid points, the centres of its
+  bins.  Both also take a Histogram or Histogram2d with uniform ranges
+  instead of the data, as filled by Histogram#increment: the bin
+  contents are then the counts at the bin centres, which are the grid.
+
+  The rules are those of R's bw.nrd0 (:silverman, 0.9 s n^-1/5) and
+  bw.nrd (:scott, 1.06 s n^-1/5), s = min(sd, IQR/1.34); in 2-D s
+  n^-1/6 along each axis for :silverman and sd n^-1/6 for :scott.  n is
+  the effective number of points (sum w)^2/sum w^2, and the quartiles
+  are interpolated in a histogram of KDE_QBINS bins.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_histogram.h"
+#include "rb_gsl_fft.h"
+#include "rb_gsl_common.h"
+
+#define KDE_PARTS 16
+#define KDE_PART_MIN 65536
+#define KDE_QBINS 4096
+#define KDE_TAU 4.0
+
+static VALUE mgsl_kde;
+
+enum {
+  KDE_SILVERMAN,
+  KDE_SCOTT,
+};
+
+/* weighted moments of the points of one part, by axis */
+struct kde_moments {
+  double sw, sw2;
+  double min[2], max[2], mean[2], m2[2];
+};
+
+struct kde_task {
+  mygsl_histogram_axis *axes;
+  size_t naxes, n;
+  const double *w;
+  size_t wstride;
+  double weight;
+  size_t nparts, nthreads;
+  struct kde_moments *mom;     /* nparts */
+  double lo[2], delta[2];      /* the grid */
+  size_t m[2], ncells;
+  double *counts;              /* nparts*ncells */
+};
+
+#define KDE_W(t, i) ((t)->w ? (t)->w[(i)*(t)->wstride] : (t)->weight)
+
+static int kde_point_nan(const struct kde_task *t, size_t i)
+{
+  size_t a;
+  double v;
+  for (a = 0; a < t->naxes; a++) {
+    v = t->axes[a].x[i*t->axes[a].stride];
+    if (v != v) return 1;
+  }
+  return 0;
+}
+
+static void kde_moments_range(const struct kde_task *t, size_t i0, size_t i1,
+			      struct kde_moments *s)
+{
+  size_t i, a;
+  double w, v, d;
+  s->sw = s->sw2 = 0.0;
+  for (a = 0; a < t->naxes; a++) {
+    s->min[a] = GSL_POSINF;
+    s->max[a] = GSL_NEGINF;
+    s->mean[a] = s->m2[a] = 0.0;
+  }
+  for (i = i0; i < i1; i++) {
+    if (kde_point_nan(t, i)) continue;
+    w = KDE_W(t, i);
+    s->sw += w;
+    s->sw2 += w*w;
+    for (a = 0; a < t->naxes; a++) {
+      v = t->axes[a].x[i*t->axes[a].stride];
+      s->mean[a] += w*v;
+      if (v < s->min[a]) s->min[a] = v;
+      if (v > s->max[a]) s->max[a] = v;
+    }
+  }
+  if (s->sw == 0.0) return;
+  for (a = 0; a < t->naxes; a++) s->mean[a] /= s->sw;
+  for (i = i0; i < i1; i++) {
+    if (kde_point_nan(t, i)) continue;
+    w = KDE_W(t, i);
+    for (a = 0; a < t->naxes; a++) {
+      d = t->axes[a].x[i*t->axes[a].stride] - s->mean[a];
+      s->m2[a] += w*d*d;
+    }
+  }
+}
+
+/* Linear binning of the points from i0 to i1 into counts */
+static void kde_bin_range(const struct kde_task *t, size_t i0, size_t i1, double *counts)
+{
+  size_t i, a, j[2];
+  double w, u, f[2];
+  for (i = i0; i < i1; i++) {
+    for (a = 0; a < t->naxes; a++) {
+      u = (t->axes[a].x[i*t->axes[a].stride] - t->lo[a])/t->delta[a];
+      if (!(u >= 0.0 && u <= (double) (t->m[a] - 1))) break;
+      j[a] = (size_t) u;
+      if (j[a] >= t->m[a] - 1) j[a] = t->m[a] - 2;
+      f[a] = u - (double) j[a];
+    }
+    if (a < t->naxes) continue;
+    w = KDE_W(t, i);
+    if (t->naxes == 1) {
+      counts[j[0]] += w*(1.0 - f[0]);
+      counts[j[0] + 1] += w*f[0];
+    } else {
+      double *c = counts + j[0]*t->m[1] + j[1];
+      c[0] += w*(1.0 - f[0])*(1.0 - f[1]);
+      c[1] += w*(1.0 - f[0])*f[1];
+      c[t->m[1]] += w*f[0]*(1.0 - f[1]);
+      c[t->m[1] + 1] += w*f[0]*f[1];
+    }
+  }
+}
+
+static int kde_moments_worker(void *data, size_t id)
+{
+  struct kde_task *t = (struct kde_task *) data;
+  size_t p, p0 = id*t->nparts/t->nthreads, p1 = (id + 1)*t->nparts/t->nthreads;
+  for (p = p0; p < p1; p++)
+    kde_moments_range(t, p*t->n/t->nparts, (p + 1)*t->n/t->nparts, t->mom + p);
+  return GSL_SUCCESS;
+}
+
+static int kde_moments_serial(void *data)
+{
+  return kde_moments_worker(data, 0);
+}
+
+static int kde_bin_worker(void *data, size_t id)
+{
+  struct kde_task *t = (struct kde_task *) data;
+  size_t p, p0 = id*t->nparts/t->nthreads, p1 = (id + 1)*t->nparts/t->nthreads;
+  for (p = p0; p < p1; p++)
+    kde_bin_range(t, p*t->n/t->nparts, (p + 1)*t->n/t->nparts,
+		  t->counts + p*t->ncells);
+  return GSL_SUCCESS;
+}
+
+static int kde_bin_serial(void *data)
+{
+  return kde_bin_worker(data, 0);
+}
+
+static void kde_run(struct kde_task *t, int (*worker)(void *, size_t),
+		    int (*serial)(void *))
+{
+  size_t work = t->n*t->naxes;
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(serial, t, work);
+}
+
+/* The moments of all the points, the parts combined in order (Chan et al.) */
+static void kde_moments(struct kde_task *t, struct kde_moments *s)
+{
+  struct kde_moments *b;
+  size_t p, a;
+  double sw, d;
+  kde_run(t, kde_moments_worker, kde_moments_serial);
+  *s = t->mom[0];
+  for (p = 1; p < t->nparts; p++) {
+    b = t->mom + p;
+    if (b->sw == 0.0) continue;
+    sw = s->sw + b->sw;
+    for (a = 0; a < t->naxes; a++) {
+      d = b->mean[a] - s->mean[a];
+      s->mean[a] += d*b->sw/sw;
+      s->m2[a] += b->m2[a] + d*d*s->sw*b->sw/sw;
+      if (b->min[a] < s->min[a]) s->min[a] = b->min[a];
+      if (b->max[a] > s->max[a]) s->max[a] = b->max[a];
+    }
+    s->sw = sw;
+    s->sw2 += b->sw2;
+  }
+}
+
+/* The q-quantile of counts in nbins uniform bins from lo of width dx */
+static double kde_bins_quantile(const double *bin, size_t nbins, size_t stride,
+				double lo, double dx, double q)
+{
+  double total = 0.0, target, cum = 0.0, c;
+  size_t i;
+  for (i = 0; i < nbins; i++) total += bin[i*stride];
+  target = q*total;
+  for (i = 0; i < nbins; i++) {
+    c = bin[i*stride];
+    if (c > 0.0 && cum + c >= target) return lo + dx*((double) i + (target - cum)/c);
+    cum += c;
+  }
+  return lo + dx*(double) nbins;
+}
+
+/* IQR of the coordinates along axis a, from a histogram of KDE_QBINS bins */
+static double kde_iqr(struct kde_task *t, size_t a, const struct kde_moments *s)
+{
+  mygsl_histogram_axis ax;
+  double *range, *bin, lo = s->min[a], hi, dx;
+  size_t i;
+  VALUE tmp;
+  if (!(s->max[a] > s->min[a])) return 0.0;
+  /* the top edge is open: widen it a little so that max is counted */
+  hi = s->max[a] + 1e-9*(s->max[a] - s->min[a]);
+  range = ALLOCV_N(double, tmp, 2*KDE_QBINS + 1);
+  bin = range + KDE_QBINS + 1;
+  for (i = 0; i <= KDE_QBINS; i++)
+    range[i] = lo + ((double) i/(double) KDE_QBINS)*(hi - lo);
+  for (i = 0; i < KDE_QBINS; i++) bin[i] = 0.0;
+  ax = t->axes[a];
+  ax.range = range;
+  ax.n = KDE_QBINS;
+  mygsl_histogram_fill_nd(bin, &ax, 1, t->w, t->wstride, t->weight, t->n);
+  dx = (hi - lo)/KDE_QBINS;
+  dx = kde_bins_quantile(bin, KDE_QBINS, 1, lo, dx, 0.75)
+    - kde_bins_quantile(bin, KDE_QBINS, 1, lo, dx, 0.25);
+  ALLOCV_END(tmp);
+  return dx;
+}
+
+static int kde_rule(VALUE v)
+{
+  ID id;
+  if (NIL_P(v)) return KDE_SILVERMAN;
+  if (!SYMBOL_P(v)) rb_raise(rb_eTypeError, "bandwidth must be a number or a Symbol");
+  id = SYM2ID(v);
+  if (id == rb_intern("silverman") || id == rb_intern("nrd0")) return KDE_SILVERMAN;
+  if (id == rb_intern("scott") || id == rb_intern("nrd")) return KDE_SCOTT;
+  rb_raise(rb_eArgError, "unknown bandwidth rule :%s", rb_id2name(id));
+  return KDE_SILVERMAN;
+}
+
+/* The bandwidth by the rule for naxes dimensions, from sd, IQR and the
+   effective number of points */
+static double kde_rule_bandwidth(int rule, size_t naxes, double sd, double iqr, double neff)
+{
+  double s = GSL_MIN(sd, iqr/1.34), h;
+  if (!(s > 0.0) || (naxes == 2 && rule == KDE_SCOTT)) s = sd;
+  if (naxes == 1) h = (rule == KDE_SCOTT ? 1.06 : 0.9)*s*pow(neff, -0.2);
+  else h = s*pow(neff, -1.0/6.0);
+  if (!(h > 0.0) || !gsl_finite(h))
+    rb_raise(rb_eArgError, "cannot choose a bandwidth (too few or identical points?)");
+  return h;
+}
+
+static double kde_bandwidth_value(VALUE v)
+{
+  double h = NUM2DBL(v);
+  if (!(h > 0.0) || !gsl_finite(h)) rb_raise(rb_eArgError, "bandwidth must be positive");
+  return h;
+}
+
+/* The kernel sampled at the grid spacing delta out to KDE_TAU bandwidths,
+   at most m - 1 points each side, into k; returns its length */
+static size_t kde_kernel(double h, double delta, size_t m, double *k)
+{
+  size_t L = (size_t) floor(KDE_TAU*h/delta), l;
+  double u;
+  if (L > m - 1) L = m - 1;
+  for (l = 0; l <= L; l++) {
+    u = (double) l*delta/h;
+    k[L + l] = k[L - l] = exp(-0.5*u*u)/(M_SQRT2*M_SQRTPI*h);
+  }
+  return 2*L + 1;
+}
+
+/* Convolves the m[0] (x m[1]) counts with the kernels and divides by sw */
+static void kde_smooth(double *c, const size_t *m, const double *delta, const double *h,
+		       size_t naxes, double sw)
+{
+  size_t nk, i, ncells = naxes == 1 ? m[0] : m[0]*m[1];
+  double *k;
+  VALUE tmp;
+  k = ALLOCV_N(double, tmp, 2*GSL_MAX(m[0], naxes == 2 ? m[1] : 0) - 1);
+  nk = kde_kernel(h[0], delta[0], m[0], k);
+  if (naxes == 1) {
+    rb_gsl_fft_convolve_same(c, m[0], 1, 0, 1, k, nk);
+  } else {
+    rb_gsl_fft_convolve_same(c, m[0], m[1], 1, m[1], k, nk);
+    nk = kde_kernel(h[1], delta[1], m[1], k);
+    rb_gsl_fft_convolve_same(c, m[1], 1, m[1], m[0], k, nk);
+  }
+  ALLOCV_END(tmp);
+  for (i = 0; i < ncells; i++) c[i] /= sw;
+}
+
+struct kde_opts {
+  VALUE n, range, cut, bandwidth, weights;
+};
+
+static void kde_get_opts(VALUE opts, struct kde_opts *o)
+{
+  o->n = o->range = o->cut = o->bandwidth = o->weights = Qnil;
+  if (NIL_P(opts)) return;
+  Check_Type(opts, T_HASH);
+  o->n = rb_hash_aref(opts, ID2SYM(rb_intern("n")));
+  o->range = rb_hash_aref(opts, ID2SYM(rb_intern("range")));
+  o->cut = rb_hash_aref(opts, ID2SYM(rb_intern("cut")));
+  o->bandwidth = rb_hash_aref(opts, ID2SYM(rb_intern("bandwidth")));
+  o->weights = rb_hash_aref(opts, ID2SYM(rb_intern("weights")));
+}
+
+/* The bandwidths of the data of t along its axes into h */
+static void kde_data_bandwidth(struct kde_task *t, VALUE vh, struct kde_moments *s,
+			       double *h)
+{
+  size_t a;
+  double neff;
+  int rule;
+  if (rb_obj_is_kind_of(vh, rb_cNumeric)) {
+    for (a = 0; a < t->naxes; a++) h[a] = kde_bandwidth_value(vh);
+    return;
+  }
+  if (TYPE(vh) == T_ARRAY) {
+    if (t->naxes == 1 || RARRAY_LEN(vh) != 2)
+      rb_raise(rb_eArgError, "bandwidth must be a number, [hx, hy] or a Symbol");
+    for (a = 0; a < 2; a++) h[a] = kde_bandwidth_value(rb_ary_entry(vh, a));
+    return;
+  }
+  rule = kde_rule(vh);
+  if (!(s->sw > 0.0)) rb_raise(rb_eArgError, "no points");
+  neff = s->sw*s->sw/s->sw2;
+  for (a = 0; a < t->naxes; a++)
+    h[a] = kde_rule_bandwidth(rule, t->naxes, sqrt(s->m2[a]/s->sw*neff/(neff - 1.0)),
+			      kde_iqr(t, a, s), neff);
+}
+
+/* Sets up t for the points of the naxes axes ax, weights from o */
+static void kde_task_init(struct kde_task *t, mygsl_histogram_axis *ax, size_t naxes,
+			  size_t n, struct kde_opts *o, VALUE *kw)
+{
+  size_t nw;
+  t->axes = ax;
+  t->naxes = naxes;
+  t->n = n;
+  t->w = NULL;
+  t->wstride = 0;
+  t->weight = 1.0;
+  *kw = Qnil;
+  if (!NIL_P(o->weights)) {
+    t->w = rb_gsl_histogram_fill_weights(o->weights, &t->weight, &t->wstride, &nw, kw);
+    if (t->w && nw < n) rb_raise(rb_eArgError, "%d weights for %d points", (int) nw, (int) n);
+  }
+  if (n == 0) rb_raise(rb_eArgError, "no points");
+}
+
+static size_t kde_grid_size(VALUE v, size_t a, size_t ndef)
+{
+  long m;
+  if (NIL_P(v)) return ndef;
+  if (TYPE(v) == T_ARRAY) v = rb_ary_entry(v, a);
+  m = NUM2LONG(v);
+  if (m < 2) rb_raise(rb_eArgError, "at least 2 grid points are needed");
+  return (size_t) m;
+}
+
+/* The grid along axis a: the range o->range, or that of the data widened */
+static void kde_grid_range(struct kde_opts *o, size_t a, size_t naxes,
+			   const struct kde_moments *s, double h, double *lo, double *hi)
+{
+  VALUE r = o->range;
+  double cut = NIL_P(o->cut) ? 3.0 : NUM2DBL(o->cut);
+  if (!NIL_P(r)) {
+    Check_Type(r, T_ARRAY);
+    if (naxes == 2) {
+      r = rb_ary_entry(r, a);
+      Check_Type(r, T_ARRAY);
+    }
+    if (RARRAY_LEN(r) != 2) rb_raise(rb_eArgError, "range must be [a, b]");
+    *lo = NUM2DBL(rb_ary_entry(r, 0));
+    *hi = NUM2DBL(rb_ary_entry(r, 1));
+  } else {
+    *lo = s->min[a] - cut*h;
+    *hi = s->max[a] + cut*h;
+  }
+  if (!(*hi > *lo)) rb_raise(rb_eArgError, "empty range");
+}
+
+/* The density of the n points of ax at the grid points lo[a] + i*delta[a],
+   i < m[a], into a new Vector *keep; returns its data */
+static double* kde_points(mygsl_histogram_axis *ax, size_t naxes, size_t n,
+			  struct kde_opts *o, size_t ndef, size_t *m, double *lo,
+			  double *delta, double *h, VALUE *keep)
+{
+  struct kde_task t;
+  struct kde_moments s;
+  gsl_vector *c;
+  double hi;
+  size_t a, p, j;
+  VALUE kw;
+  kde_task_init(&t, ax, naxes, n, o, &kw);
+  for (a = 0, t.ncells = 1; a < naxes; a++) {
+    t.m[a] = m[a] = kde_grid_size(o->n, a, ndef);
+    t.ncells *= m[a];
+  }
+  t.nparts = GSL_MAX(1, GSL_MIN(KDE_PARTS, n/GSL_MAX(KDE_PART_MIN, 4*t.ncells)));
+  t.nthreads = t.nparts > 1 ? rb_gsl_parallel_nthreads(n*naxes, t.nparts) : 1;
+  t.mom = ALLOC_N(struct kde_moments, t.nparts);
+  kde_moments(&t, &s);
+  xfree(t.mom);
+  kde_data_bandwidth(&t, o->bandwidth, &s, h);
+  for (a = 0; a < naxes; a++) {
+    kde_grid_range(o, a, naxes, &s, h[a], lo + a, &hi);
+    t.lo[a] = lo[a];
+    t.delta[a] = delta[a] = (hi - lo[a])/(double) (m[a] - 1);
+  }
+  c = gsl_vector_calloc(t.ncells);
+  *keep = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, c);
+  if (t.nparts == 1) {
+    t.counts = c->data;
+    kde_run(&t, kde_bin_worker, kde_bin_serial);
+  } else {
+    t.counts = ALLOC_N(double, t.nparts*t.ncells);
+    for (j = 0; j < t.nparts*t.ncells; j++) t.counts[j] = 0.0;
+    kde_run(&t, kde_bin_worker, kde_bin_serial);
+    for (p = 0; p < t.nparts; p++)
+      for (j = 0; j < t.ncells; j++) c->data[j] += t.counts[p*t.ncells + j];
+    xfree(t.counts);
+  }
+  kde_smooth(c->data, m, delta, h, naxes, s.sw);
+  RB_GC_GUARD(kw);
+  return c->data;
+}
+
+static int kde_ranges_uniform(const double *range, size_t n)
+{
+  size_t i;
+  double lo = range[0], dx = (range[n] - range[0])/(double) n;
+  if (!(dx > 0.0)) return 0;
+  for (i = 1; i < n; i++)
+    if (fabs(range[i] - (lo + (double) i*dx)) > 1e-9*dx*(double) n) return 0;
+  return 1;
+}
+
+/* Moments and IQR along an axis of binned counts at the bin centres;
+   the counts of bin i are bin[i*stride + j*jstride], j < nj */
+static void kde_bins_stats(const double *range, size_t nbins, const double *bin,
+			   size_t stride, size_t jstride, size_t nj,
+			   double *sw, double *sd, double *iqr)
+{
+  double *marg, dx = (range[nbins] - range[0])/(double) nbins, x, mean = 0.0, m2 = 0.0;
+  size_t i, j;
+  VALUE tmp;
+  marg = ALLOCV_N(double, tmp, nbins);
+  *sw = 0.0;
+  for (i = 0; i < nbins; i++) {
+    for (j = 0, marg[i] = 0.0; j < nj; j++) marg[i] += bin[i*stride + j*jstride];
+    *sw += marg[i];
+    mean += marg[i]*(range[0] + ((double) i + 0.5)*dx);
+  }
+  if (!(*sw > 0.0)) rb_raise(rb_eArgError, "empty histogram");
+  mean /= *sw;
+  for (i = 0; i < nbins; i++) {
+    x = range[0] + ((double) i + 0.5)*dx - mean;
+    m2 += marg[i]*x*x;
+  }
+  *sd = *sw > 1.0 ? sqrt(m2/(*sw - 1.0)) : 0.0;
+  *iqr = kde_bins_quantile(marg, nbins, 1, range[0], dx, 0.75)
+    - kde_bins_quantile(marg, nbins, 1, range[0], dx, 0.25);
+  ALLOCV_END(tmp);
+}
+
+/* The bandwidth along an axis of a histogram */
+static double kde_bins_bandwidth(VALUE vh, size_t a, size_t naxes, const double *range,
+				 size_t nbins, const double *bin, size_t stride,
+				 size_t jstride, size_t nj)
+{
+  double sw, sd, iqr;
+  int rule;
+  if (rb_obj_is_kind_of(vh, rb_cNumeric)) return kde_bandwidth_value(vh);
+  if (TYPE(vh) == T_ARRAY) {
+    if (naxes == 1 || RARRAY_LEN(vh) != 2)
+      rb_raise(rb_eArgError, "bandwidth must be a number, [hx, hy] or a Symbol");
+    return kde_bandwidth_value(rb_ary_entry(vh, a));
+  }
+  rule = kde_rule(vh);
+  kde_bins_stats(range, nbins, bin, stride, jstride, nj, &sw, &sd, &iqr);
+  return kde_rule_bandwidth(rule, naxes, sd, iqr, sw);
+}
+
+static double kde_bins_sum(const double *bin, size_t n)
+{
+  double sw = 0.0;
+  size_t i;
+  for (i = 0; i < n; i++) sw += bin[i];
+  if (!(sw > 0.0)) rb_raise(rb_eArgError, "empty histogram");
+  return sw;
+}
+
+static void kde_check_histogram_ranges(const double *range, size_t n)
+{
+  if (n < 2) rb_raise(rb_eArgError, "at least 2 bins are needed");
+  if (!kde_ranges_uniform(range, n))
+    rb_raise(rb_eArgError, "histogram ranges must be uniform");
+}
+
+static int kde_parse_args(int argc, VALUE *argv, int nmax, struct kde_opts *o)
+{
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1 || argc > nmax)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for %d)", argc, nmax);
+  kde_get_opts(opts, o);
+  return argc;
+}
+
+/* GSL::KDE.density(x, opts = {}) or (histogram, opts): [grid, density] */
+static VALUE rb_gsl_kde_density(int argc, VALUE *argv, VALUE module)
+{
+  struct kde_opts o;
+  mygsl_histogram_axis ax;
+  gsl_histogram *hist = NULL;
+  gsl_vector *grid, *f;
+  size_t m, n, i;
+  double lo, delta, h;
+  VALUE vf, vx;
+  kde_parse_args(argc, argv, 1, &o);
+  if (rb_obj_is_kind_of(argv[0], cgsl_histogram)) {
+    Data_Get_Struct(argv[0], gsl_histogram, hist);
+    kde_check_histogram_ranges(hist->range, hist->n);
+    m = hist->n;
+    delta = (hist->range[m] - hist->range[0])/(double) m;
+    lo = hist->range[0] + 0.5*delta;
+    h = kde_bins_bandwidth(o.bandwidth, 0, 1, hist->range, m, hist->bin, 1, 0, 1);
+    f = gsl_vector_alloc(m);
+    vf = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, f);
+    memcpy(f->data, hist->bin, sizeof(double)*m);
+    kde_smooth(f->data, &m, &delta, &h, 1, kde_bins_sum(hist->bin, m));
+  } else {
+    ax.x = rb_gsl_histogram_fill_data(argv[0], &ax.stride, &n, &vx);
+    kde_points(&ax, 1, n, &o, 512, &m, &lo, &delta, &h, &vf);
+    RB_GC_GUARD(vx);
+  }
+  grid = gsl_vector_alloc(m);
+  for (i = 0; i < m; i++) gsl_vector_set(grid, i, lo + (double) i*delta);
+  return rb_ary_new3(2, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, grid), vf);
+}
+
+/* GSL::KDE.density2d(x, y, opts = {}), (xy, opts) or (histogram2d, opts) */
+static VALUE rb_gsl_kde_density2d(int argc, VALUE *argv, VALUE module)
+{
+  struct kde_opts o;
+  mygsl_histogram_axis ax[2];
+  gsl_histogram2d *hist = NULL, *out;
+  size_t m[2], n, ny;
+  double lo[2], delta[2], h[2], *c;
+  VALUE vf = Qnil, vx = Qnil, vy = Qnil;
+  int nargs;
+  nargs = kde_parse_args(argc, argv, 2, &o);
+  if (nargs == 1 && HISTOGRAM2D_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_histogram2d, hist);
+    kde_check_histogram_ranges(hist->xrange, hist->nx);
+    kde_check_histogram_ranges(hist->yrange, hist->ny);
+    m[0] = hist->nx;
+    m[1] = hist->ny;
+    out = gsl_histogram2d_alloc(m[0], m[1]);
+    memcpy(out->xrange, hist->xrange, sizeof(double)*(m[0] + 1));
+    memcpy(out->yrange, hist->yrange, sizeof(double)*(m[1] + 1));
+    memcpy(out->bin, hist->bin, sizeof(double)*m[0]*m[1]);
+    vf = Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, out);
+    delta[0] = (hist->xrange[m[0]] - hist->xrange[0])/(double) m[0];
+    delta[1] = (hist->yrange[m[1]] - hist->yrange[0])/(double) m[1];
+    h[0] = kde_bins_bandwidth(o.bandwidth, 0, 2, hist->xrange, m[0], hist->bin,
+			      m[1], 1, m[1]);
+    h[1] = kde_bins_bandwidth(o.bandwidth, 1, 2, hist->yrange, m[1], hist->bin,
+			      1, m[1], m[0]);
+    kde_smooth(out->bin, m, delta, h, 2, kde_bins_sum(hist->bin, m[0]*m[1]));
+    return vf;
+  }
+  if (nargs == 1) {
+    n = rb_gsl_histogram_fill_columns(argv[0], ax, 2);
+    vx = argv[0];
+  } else {
+    ax[0].x = rb_gsl_histogram_fill_data(argv[0], &ax[0].stride, &n, &vx);
+    ax[1].x = rb_gsl_histogram_fill_data(argv[1], &ax[1].stride, &ny, &vy);
+    if (ny < n) n = ny;
+  }
+  c = kde_points(ax, 2, n, &o, 128, m, lo, delta, h, &vf);
+  out = gsl_histogram2d_alloc(m[0], m[1]);
+  gsl_histogram2d_set_ranges_uniform(out, lo[0] - 0.5*delta[0],
+				     lo[0] + ((double) m[0] - 0.5)*delta[0],
+				     lo[1] - 0.5*delta[1],
+				     lo[1] + ((double) m[1] - 0.5)*delta[1]);
+  memcpy(out->bin, c, sizeof(double)*m[0]*m[1]);
+  RB_GC_GUARD(vf);
+  RB_GC_GUARD(vx);
+  RB_GC_GUARD(vy);
+  return Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, out);
+}
+
+/* GSL::KDE.bandwidth(x, rule = :silverman, opts = {}) or (histogram, rule) */
+static VALUE rb_gsl_kde_bandwidth(int argc, VALUE *argv, VALUE module)
+{
+  struct kde_opts o;
+  struct kde_task t;
+  struct kde_moments s;
+  mygsl_histogram_axis ax;
+  gsl_histogram *hist = NULL;
+  size_t n;
+  double h;
+  VALUE vx, kw, rule;
+  int nargs;
+  nargs = kde_parse_args(argc, argv, 2, &o);
+  rule = nargs == 2 ? argv[1] : Qnil;
+  kde_rule(rule);
+  if (rb_obj_is_kind_of(argv[0], cgsl_histogram)) {
+    Data_Get_Struct(argv[0], gsl_histogram, hist);
+    kde_check_histogram_ranges(hist->range, hist->n);
+    return rb_float_new(kde_bins_bandwidth(rule, 0, 1, hist->range, hist->n,
+					   hist->bin, 1, 0, 1));
+  }
+  ax.x = rb_gsl_histogram_fill_data(argv[0], &ax.stride, &n, &vx);
+  kde_task_init(&t, &ax, 1, n, &o, &kw);
+  t.nparts = GSL_MAX(1, GSL_MIN(KDE_PARTS, n/KDE_PART_MIN));
+  t.nthreads = t.nparts > 1 ? rb_gsl_parallel_nthreads(n, t.nparts) : 1;
+  t.mom = ALLOC_N(struct kde_moments, t.nparts);
+  kde_moments(&t, &s);
+  xfree(t.mom);
+  kde_data_bandwidth(&t, rule, &s, &h);
+  RB_GC_GUARD(vx);
+  RB_GC_GUARD(kw);
+  return rb_float_new(h);
+}
+
+void Init_gsl_kde(VALUE module)
+{
+  mgsl_kde = rb_define_module_under(module, "KDE");
+  rb_define_module_function(mgsl_kde, "density", rb_gsl_kde_density, -1);
+  rb_define_module_function(mgsl_kde, "density2d", rb_gsl_kde_density2d, -1);
+  rb_define_module_function(mgsl_kde, "bandwidth", rb_gsl_kde_bandwidth, -1);
+}
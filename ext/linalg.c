@@ -14,6 +14,7 @@
 #include "rb_gsl_array.h"
 #include "rb_gsl_common.h"
 #include "rb_gsl_linalg.h"
+#include "rb_gsl_probes.h"
 #include "porting.h"
 
 static VALUE cgsl_matrix_LU;
@@ -38,6 +39,152 @@ enum {
   LINALG_DECOMP_BANG,
 };
 
+/*
+  The decompositions below are pure C and do not touch Ruby objects,
+  so they run with the GVL released (see rb_gsl_nogvl_call()).
+*/
+struct linalg_nogvl_data {
+  gsl_matrix *A, *B;
+  gsl_vector *v, *w;
+  gsl_permutation *p;
+  int signum;
+  int (*fqr)(gsl_matrix *, gsl_vector *);
+  int (*fqrpt)(gsl_matrix *, gsl_vector *, gsl_permutation *, int *, gsl_vector *);
+};
+
+static int linalg_LU_decomp_nogvl(void *data)
+{
+  struct linalg_nogvl_data *d = (struct linalg_nogvl_data *) data;
+  int status;
+  RB_GSL_KERNEL_ENTRY("LU_decomp", d->A->size1, d->A->size2);
+#ifdef HAVE_LAPACK
+  if (mygsl_lapack_active())
+    status = mygsl_lapack_LU_decomp(d->A, d->p, &d->signum);
+  else
+#endif
+  status = gsl_linalg_LU_decomp(d->A, d->p, &d->signum);
+  RB_GSL_KERNEL_RETURN("LU_decomp", d->A->size1, d->A->size2, status);
+  return status;
+}
+
+static int linalg_QR_decomp_nogvl(void *data)
+{
+  struct linalg_nogvl_data *d = (struct linalg_nogvl_data *) data;
+  int status;
+  RB_GSL_KERNEL_ENTRY("QR_decomp", d->A->size1, d->A->size2);
+#ifdef HAVE_LAPACK
+  if (mygsl_lapack_active() && d->fqr == gsl_linalg_QR_decomp)
+    status = mygsl_lapack_QR_decomp(d->A, d->v);
+  else
+#endif
+  status = (*d->fqr)(d->A, d->v);
+  RB_GSL_KERNEL_RETURN("QR_decomp", d->A->size1, d->A->size2, status);
+  return status;
+}
+
+static int linalg_QRPT_decomp_nogvl(void *data)
+{
+  struct linalg_nogvl_data *d = (struct linalg_nogvl_data *) data;
+  int status;
+  RB_GSL_KERNEL_ENTRY("QRPT_decomp", d->A->size1, d->A->size2);
+  status = (*d->fqrpt)(d->A, d->v, d->p, &d->signum, d->w);
+  RB_GSL_KERNEL_RETURN("QRPT_decomp", d->A->size1, d->A->size2, status);
+  return status;
+}
+
+static int linalg_SV_decomp_nogvl(void *data)
+{
+  struct linalg_nogvl_data *d = (struct linalg_nogvl_data *) data;
+  int status;
+  RB_GSL_KERNEL_ENTRY("SV_decomp", d->A->size1, d->A->size2);
+#ifdef HAVE_LAPACK
+  if (mygsl_lapack_active() && d->A->size1 >= d->A->size2)
+    status = mygsl_lapack_SV_decomp(d->A, d->B, d->v);
+  else
+#endif
+  status = gsl_linalg_SV_decomp(d->A, d->B, d->v, d->w);
+  RB_GSL_KERNEL_RETURN("SV_decomp", d->A->size1, d->A->size2, status);
+  return status;
+}
+
+static int linalg_SV_decomp_jacobi_nogvl(void *data)
+{
+  struct linalg_nogvl_data *d = (struct linalg_nogvl_data *) data;
+  int status;
+  RB_GSL_KERNEL_ENTRY("SV_decomp_jacobi", d->A->size1, d->A->size2);
+  status = gsl_linalg_SV_decomp_jacobi(d->A, d->B, d->v);
+  RB_GSL_KERNEL_RETURN("SV_decomp_jacobi", d->A->size1, d->A->size2, status);
+  return status;
+}
+
+static int linalg_cholesky_decomp_nogvl(void *data)
+{
+  struct linalg_nogvl_data *d = (struct linalg_nogvl_data *) data;
+  int status;
+  RB_GSL_KERNEL_ENTRY("cholesky_decomp", d->A->size1, d->A->size2);
+#ifdef HAVE_LAPACK
+  if (mygsl_lapack_active())
+    status = mygsl_lapack_cholesky_decomp(d->A);
+  else
+#endif
+  status = gsl_linalg_cholesky_decomp(d->A);
+  RB_GSL_KERNEL_RETURN("cholesky_decomp", d->A->size1, d->A->size2, status);
+  return status;
+}
+
+static int mygsl_linalg_LU_decomp(gsl_matrix *A, gsl_permutation *p, int *signum)
+{
+  struct linalg_nogvl_data d;
+  int status;
+  d.A = A;  d.p = p;  d.signum = 1;
+  status = rb_gsl_nogvl_call(linalg_LU_decomp_nogvl, &d, A->size1*A->size2);
+  *signum = d.signum;
+  return status;
+}
+
+static int mygsl_linalg_QR_decomp(int (*fdecomp)(gsl_matrix *, gsl_vector *),
+				  gsl_matrix *A, gsl_vector *tau)
+{
+  struct linalg_nogvl_data d;
+  d.fqr = fdecomp;  d.A = A;  d.v = tau;
+  return rb_gsl_nogvl_call(linalg_QR_decomp_nogvl, &d, A->size1*A->size2);
+}
+
+static int mygsl_linalg_QRPT_decomp(int (*fdecomp)(gsl_matrix *, gsl_vector *, gsl_permutation *, int *, gsl_vector *),
+				    gsl_matrix *A, gsl_vector *tau, gsl_permutation *p,
+				    int *signum, gsl_vector *norm)
+{
+  struct linalg_nogvl_data d;
+  int status;
+  d.fqrpt = fdecomp;  d.A = A;  d.v = tau;  d.p = p;  d.w = norm;
+  d.signum = 1;
+  status = rb_gsl_nogvl_call(linalg_QRPT_decomp_nogvl, &d, A->size1*A->size2);
+  *signum = d.signum;
+  return status;
+}
+
+static int mygsl_linalg_SV_decomp(gsl_matrix *U, gsl_matrix *V, gsl_vector *S,
+				  gsl_vector *work)
+{
+  struct linalg_nogvl_data d;
+  d.A = U;  d.B = V;  d.v = S;  d.w = work;
+  return rb_gsl_nogvl_call(linalg_SV_decomp_nogvl, &d, U->size1*U->size2);
+}
+
+static int mygsl_linalg_SV_decomp_jacobi(gsl_matrix *U, gsl_matrix *V, gsl_vector *S)
+{
+  struct linalg_nogvl_data d;
+  d.A = U;  d.B = V;  d.v = S;
+  return rb_gsl_nogvl_call(linalg_SV_decomp_jacobi_nogvl, &d, U->size1*U->size2);
+}
+
+static int mygsl_linalg_cholesky_decomp(gsl_matrix *A)
+{
+  struct linalg_nogvl_data d;
+  d.A = A;
+  return rb_gsl_nogvl_call(linalg_cholesky_decomp_nogvl, &d, A->size1*A->size2);
+}
+
 #ifdef HAVE_NARRAY_H
 static VALUE rb_gsl_linalg_LU_decomp_narray(int argc, VALUE *argv, VALUE obj,
 					    int flag);
@@ -82,7 +229,7 @@ static VALUE rb_gsl_linalg_LU_decomposition(int argc, VALUE *argv, VALUE obj, in
   switch (argc-itmp) {
   case 0:
     p = gsl_permutation_alloc(size);
-    gsl_linalg_LU_decomp(m, p, &signum);
+    mygsl_linalg_LU_decomp(m, p, &signum);
     objp = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
     if (flag == LINALG_DECOMP_BANG) return rb_ary_new3(2, objp, INT2FIX(signum));
     else return rb_ary_new3(3, objm, objp, INT2FIX(signum));
@@ -90,7 +237,7 @@ static VALUE rb_gsl_linalg_LU_decomposition(int argc, VALUE *argv, VALUE obj, in
   case 1:
     CHECK_PERMUTATION(argv[itmp]);
     Data_Get_Struct(argv[itmp], gsl_permutation, p);
-    gsl_linalg_LU_decomp(m, p, &signum);
+    mygsl_linalg_LU_decomp(m, p, &signum);
     if (flag == LINALG_DECOMP_BANG) return INT2FIX(signum);
     else return rb_ary_new3(2, objm, INT2FIX(signum));
     break;
@@ -136,7 +283,7 @@ static VALUE rb_gsl_linalg_LU_decomp_narray(int argc, VALUE *argv, VALUE obj,
     mv = gsl_matrix_view_array((double*)na->ptr, na->shape[1], na->shape[0]);
   }
   p = gsl_permutation_alloc(mv.matrix.size1);
-  gsl_linalg_LU_decomp(&mv.matrix, p, &signum);
+  mygsl_linalg_LU_decomp(&mv.matrix, p, &signum);
   if (flag == LINALG_DECOMP) {
     return rb_ary_new3(3, m, 
 		       Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p),
@@ -266,7 +413,7 @@ VALUE rb_gsl_linalg_LU_solve(int argc, VALUE *argv, VALUE obj)
     CHECK_VECTOR(argv[itmp]);
     Data_Get_Struct(argv[itmp], gsl_vector, x);
   }
-  if (flagm == 1) gsl_linalg_LU_decomp(m, p, &signum);
+  if (flagm == 1) mygsl_linalg_LU_decomp(m, p, &signum);
   gsl_linalg_LU_solve(m, p, b, x);
   if (flagm == 1) gsl_matrix_free(m);
   if (flagp == 1) gsl_permutation_free(p);
@@ -345,7 +492,7 @@ static VALUE rb_gsl_linalg_LU_svx(int argc, VALUE *argv, VALUE obj)
   if (flagp == 0) itmp++;
   CHECK_VECTOR(argv[itmp]);
   b = get_vector2(argv[itmp], &flagb);
-  if (flagm == 1) gsl_linalg_LU_decomp(m, p, &signum);
+  if (flagm == 1) mygsl_linalg_LU_decomp(m, p, &signum);
   gsl_linalg_LU_svx(m, p, b);
   if (flagm == 1) gsl_matrix_free(m);
   if (flagp == 1) gsl_permutation_free(p);
@@ -440,7 +587,7 @@ static VALUE rb_gsl_linalg_LU_invert(int argc, VALUE *argv, VALUE obj)
   if (flagp == 0) itmp++;
 
   if (flagm == 1 || flagp == 1) {
-    gsl_linalg_LU_decomp(m, p, &signum);  
+    mygsl_linalg_LU_decomp(m, p, &signum);  
   }
 
   if (argc-1 == itmp) {
@@ -550,7 +697,7 @@ static VALUE rb_gsl_linalg_LU_det(int argc, VALUE *argv, VALUE obj)
       flagp = 1;
     }
   } 
-  if (flagm == 1) gsl_linalg_LU_decomp(m, p, &sign);  
+  if (flagm == 1) mygsl_linalg_LU_decomp(m, p, &sign);  
   det = gsl_linalg_LU_det(m, sign);
   if (flagm == 1) gsl_matrix_free(m);
   if (flagp == 1) gsl_permutation_free(p);
@@ -581,7 +728,7 @@ static VALUE rb_gsl_linalg_LU_lndet(int argc, VALUE *argv, VALUE obj)
   }
   if (flagm == 1) {
     p = gsl_permutation_alloc(m->size1);
-    gsl_linalg_LU_decomp(m, p, &sign);  
+    mygsl_linalg_LU_decomp(m, p, &sign);  
   }
   lndet = gsl_linalg_LU_lndet(m);
   if (flagm == 1) {
@@ -608,7 +755,7 @@ static VALUE rb_gsl_linalg_LU_sgndet(int argc, VALUE *argv, VALUE obj)
   }
   if (flagm == 1) {
     p = gsl_permutation_alloc(m->size1);
-    gsl_linalg_LU_decomp(m, p, &sign);  
+    mygsl_linalg_LU_decomp(m, p, &sign);  
   } else {
     if (argc-itmp != 1) rb_raise(rb_eArgError, "sign must be given");
     sign = FIX2INT(argv[itmp]);
@@ -724,7 +871,7 @@ static VALUE rb_gsl_linalg_QR_LQ_decomposition(int argc, VALUE *argv, VALUE obj,
     rb_raise(rb_eArgError, "wrong number of arguments");
     break;
   }
-  status = (*fdecomp)(m, tau);
+  status = mygsl_linalg_QR_decomp(fdecomp, m, tau);
   switch (flag) {
   case LINALG_QR_DECOMP:
   case LINALG_LQ_DECOMP:
@@ -850,7 +997,7 @@ static VALUE rb_gsl_linalg_QR_LQ_solve(int argc, VALUE *argv, VALUE obj, int fla
     Data_Get_Struct(argv[itmp], gsl_vector, x);
     flagx = 0;
   }
-  if (flagm == 1) (*fdecomp)(m, tau);
+  if (flagm == 1) mygsl_linalg_QR_decomp(fdecomp, m, tau);
   (*fsolve)(m, tau, b, x);
   if (flagm == 1) gsl_matrix_free(m);
   if (flagt == 1) gsl_vector_free(tau);
@@ -918,7 +1065,7 @@ static VALUE rb_gsl_linalg_QR_LQ_svx(int argc, VALUE *argv, VALUE obj, int flag)
     }
   }
   b = get_vector2(argv[itmp], &flagb);
-  if (flagm == 1 && flagt == 1) (*fdecomp)(m, tau);
+  if (flagm == 1 && flagt == 1) mygsl_linalg_QR_decomp(fdecomp, m, tau);
   (*fsvx)(m, tau, b);
   if (flagm == 1) gsl_matrix_free(m);
   if (flagt == 1) gsl_vector_free(tau);
@@ -1006,7 +1153,7 @@ static VALUE rb_gsl_linalg_QR_LQ_lssolve(int argc, VALUE *argv, VALUE obj, int f
     rb_raise(rb_eArgError, "wrong number of arguments");
     break;
   }
-  if (flagm == 1) (*fdecomp)(m, tau);
+  if (flagm == 1) mygsl_linalg_QR_decomp(fdecomp, m, tau);
   status = (*flssolve)(m, tau, b, x, r);
   if (flagm == 1) gsl_matrix_free(m);
   if (flagt == 1) gsl_vector_free(tau);
@@ -1326,7 +1473,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsolve(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_QR) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_QR_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_QR_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_QR_Rsolve;
@@ -1335,7 +1482,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsolve(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_QR) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_QR_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_QR_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_R_solve;
@@ -1345,7 +1492,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsolve(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_LQ) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_LQ_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_LQ_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_LQ_Lsolve_T;
@@ -1354,7 +1501,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsolve(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_LQ) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_LQ_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_LQ_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_L_solve_T;
@@ -1421,7 +1568,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsvx(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_QR) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_QR_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_QR_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_QR_Rsvx;
@@ -1431,7 +1578,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsvx(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_QR) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_QR_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_QR_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_R_svx;
@@ -1442,7 +1589,7 @@ static VALUE rb_gsl_linalg_QRLQ_RLsvx(int argc, VALUE *argv, VALUE obj,
     if (CLASS_OF(omatrix) != cgsl_matrix_LQ) {
       QR = make_matrix_clone(mtmp);
       tau = gsl_vector_alloc(QR->size1);
-      gsl_linalg_LQ_decomp(QR, tau);
+      mygsl_linalg_QR_decomp(gsl_linalg_LQ_decomp, QR, tau);
       flagq = 1;
     }
     fsolve = &gsl_linalg_LQ_Lsvx_T;
@@ -1585,14 +1732,14 @@ static VALUE rb_gsl_linalg_QRLQPT_decomp(int argc, VALUE *argv, VALUE obj, int f
     vQR = Data_Wrap_Struct(cgsl_matrix_QRPT, 0, gsl_matrix_free, QR);
     vtau = Data_Wrap_Struct(cgsl_vector_tau, 0, gsl_vector_free, tau);
     vp = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
-    gsl_linalg_QRPT_decomp(QR, tau, p, &signum, norm);
+    mygsl_linalg_QRPT_decomp(gsl_linalg_QRPT_decomp, QR, tau, p, &signum, norm);
     break;
 #ifdef GSL_1_6_LATER
   case LINALG_PTLQ:
     vQR = Data_Wrap_Struct(cgsl_matrix_PTLQ, 0, gsl_matrix_free, QR);
     vtau = Data_Wrap_Struct(cgsl_vector_tau, 0, gsl_vector_free, tau);
     vp = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
-    gsl_linalg_PTLQ_decomp(QR, tau, p, &signum, norm);
+    mygsl_linalg_QRPT_decomp(gsl_linalg_PTLQ_decomp, QR, tau, p, &signum, norm);
     break;
 #endif
   default:
@@ -1632,14 +1779,14 @@ static VALUE rb_gsl_linalg_QRLQPT_decomp_bang(int argc, VALUE *argv, VALUE obj,
     rb_obj_reveal(vA, cgsl_matrix_QRPT);
     vtau = Data_Wrap_Struct(cgsl_vector_tau, 0, gsl_vector_free, tau);
     vp = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
-    gsl_linalg_QRPT_decomp(A, tau, p, &signum, norm);
+    mygsl_linalg_QRPT_decomp(gsl_linalg_QRPT_decomp, A, tau, p, &signum, norm);
     break;
 #ifdef GSL_1_6_LATER
   case LINALG_PTLQ:
     rb_obj_reveal(vA, cgsl_matrix_PTLQ);
     vtau = Data_Wrap_Struct(cgsl_vector_tau, 0, gsl_vector_free, tau);
     vp = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
-    gsl_linalg_PTLQ_decomp(A, tau, p, &signum, norm);
+    mygsl_linalg_QRPT_decomp(gsl_linalg_PTLQ_decomp, A, tau, p, &signum, norm);
     break;
 #endif
   default:
@@ -1827,7 +1974,7 @@ static VALUE rb_gsl_linalg_QRLQPT_solve(int argc, VALUE *argv, VALUE obj, int fl
     Data_Get_Struct(argv[itmp], gsl_vector, b);
   }
   x = gsl_vector_alloc(b->size);
-  if (flagq == 1) (*fdecomp)(QR, tau, p, &signum, norm);
+  if (flagq == 1) mygsl_linalg_QRPT_decomp(fdecomp, QR, tau, p, &signum, norm);
   (*fsolve)(QR, tau, p, b, x);
   if (flagb == 1) gsl_vector_free(b);
   if (flagq == 1) {
@@ -1919,7 +2066,7 @@ static VALUE rb_gsl_linalg_QRLQPT_svx(int argc, VALUE *argv, VALUE obj, int flag
   norm = gsl_vector_alloc(size0);
   CHECK_VECTOR(argv[itmp]);
   Data_Get_Struct(argv[itmp], gsl_vector, b);
-  if (flagq == 1) (*fdecomp)(QR, tau, p, &signum, norm);
+  if (flagq == 1) mygsl_linalg_QRPT_decomp(fdecomp, QR, tau, p, &signum, norm);
   (*fsvx)(QR, tau, p, b);
   if (flagq == 1) {
     gsl_matrix_free(QR);
@@ -2208,7 +2355,7 @@ static VALUE rb_gsl_linalg_SV_decomp_narray(int argc, VALUE *argv, VALUE obj)
   sv = gsl_vector_view_array(NA_PTR_TYPE(s,double*), shape[0]);
   work = gsl_vector_alloc(shape[0]);
   memcpy(NA_PTR_TYPE(u,double*), (double*)A->ptr, sizeof(double)*A->total);
-  gsl_linalg_SV_decomp(&uv.matrix, &vv.matrix, &sv.vector, work);
+  mygsl_linalg_SV_decomp(&uv.matrix, &vv.matrix, &sv.vector, work);
   gsl_vector_free(work);
   return rb_ary_new3(3, u, v, s);
 }
@@ -2230,7 +2377,7 @@ static VALUE rb_gsl_linalg_SV_decomp_jacobi_narray(int argc, VALUE *argv, VALUE
   vv = gsl_matrix_view_array(NA_PTR_TYPE(v,double*), shape[1], shape[0]);
   sv = gsl_vector_view_array(NA_PTR_TYPE(s,double*), shape[0]);
   memcpy(NA_PTR_TYPE(u,double*), (double*)A->ptr, sizeof(double)*A->total);
-  gsl_linalg_SV_decomp_jacobi(&uv.matrix, &vv.matrix, &sv.vector);
+  mygsl_linalg_SV_decomp_jacobi(&uv.matrix, &vv.matrix, &sv.vector);
   return rb_ary_new3(3, u, v, s);
 }
 
@@ -2303,7 +2450,7 @@ static VALUE rb_gsl_linalg_SV_decomp(int argc, VALUE *argv, VALUE obj)
   S = gsl_vector_alloc(A->size2);   /* see manual p 123 */
   V = gsl_matrix_alloc(A->size2, A->size2);
   if (flag == 1) w = gsl_vector_alloc(A->size2);
-  gsl_linalg_SV_decomp(U, V, S, w);
+  mygsl_linalg_SV_decomp(U, V, S, w);
   if (flag == 1) gsl_vector_free(w);
   vu = Data_Wrap_Struct(cgsl_matrix_U, 0, gsl_matrix_free, U);
   vv = Data_Wrap_Struct(cgsl_matrix_V, 0, gsl_matrix_free, V);
@@ -2364,7 +2511,7 @@ static VALUE rb_gsl_linalg_SV_decomp_jacobi(int argc, VALUE *argv, VALUE obj)
   U = make_matrix_clone(A);
   S = gsl_vector_alloc(A->size2);   /* see manual p 123 */
   V = gsl_matrix_alloc(A->size2, A->size2);
-  gsl_linalg_SV_decomp_jacobi(U, V, S);
+  mygsl_linalg_SV_decomp_jacobi(U, V, S);
   vu = Data_Wrap_Struct(cgsl_matrix_U, 0, gsl_matrix_free, U);
   vv = Data_Wrap_Struct(cgsl_matrix_V, 0, gsl_matrix_free, V);
   vs = Data_Wrap_Struct(cgsl_vector_S, 0, gsl_vector_free, S);
@@ -2419,7 +2566,7 @@ static VALUE rb_gsl_linalg_SV_solve(int argc, VALUE *argv, VALUE obj)
       }
       S = gsl_vector_alloc(A->size2);   /* see manual p 123 */
       V = gsl_matrix_alloc(A->size2, A->size2);
-      gsl_linalg_SV_decomp_jacobi(U, V, S);
+      mygsl_linalg_SV_decomp_jacobi(U, V, S);
       flagv = 1;
     }
     break;
@@ -2437,7 +2584,7 @@ static VALUE rb_gsl_linalg_SV_solve(int argc, VALUE *argv, VALUE obj)
     }
     S = gsl_vector_alloc(A->size2);   /* see manual p 123 */
     V = gsl_matrix_alloc(A->size2, A->size2);
-    gsl_linalg_SV_decomp_jacobi(U, V, S);
+    mygsl_linalg_SV_decomp_jacobi(U, V, S);
     flagv = 1;
     break;
   }
@@ -2466,7 +2613,7 @@ static VALUE rb_gsl_linalg_cholesky_decomp_narray(int argc, VALUE *argv, VALUE o
   chol = na_make_object(NA_DFLOAT, 2, na->shape, CLASS_OF(argv[0]));
   memcpy(NA_PTR_TYPE(chol,double*), (double*)na->ptr, sizeof(double)*na->total);
   mv = gsl_matrix_view_array(NA_PTR_TYPE(chol,double*), na->shape[1], na->shape[0]);
-  gsl_linalg_cholesky_decomp(&mv.matrix);
+  mygsl_linalg_cholesky_decomp(&mv.matrix);
   return chol;
 }
 
@@ -2533,7 +2680,7 @@ static VALUE rb_gsl_linalg_cholesky_decomp(int argc, VALUE *argv, VALUE obj)
     break;
   }
   A = make_matrix_clone(Atmp);
-  gsl_linalg_cholesky_decomp(A);
+  mygsl_linalg_cholesky_decomp(A);
   return Data_Wrap_Struct(cgsl_matrix_C, 0, gsl_matrix_free, A);
 }
 
@@ -2575,7 +2722,7 @@ static VALUE rb_gsl_linalg_cholesky_solve(int argc, VALUE *argv, VALUE obj)
   } else {
     A = make_matrix_clone(Atmp);
     flaga = 1;
-    gsl_linalg_cholesky_decomp(A);
+    mygsl_linalg_cholesky_decomp(A);
   }
   x = gsl_vector_alloc(b->size);
   gsl_linalg_cholesky_solve(A, b, x);
@@ -2618,7 +2765,7 @@ static VALUE rb_gsl_linalg_cholesky_svx(int argc, VALUE *argv, VALUE obj)
   } else {
     A = make_matrix_clone(Atmp);
     flaga = 1;
-    gsl_linalg_cholesky_decomp(A);
+    mygsl_linalg_cholesky_decomp(A);
   }
   gsl_linalg_cholesky_svx(A, b);
   if (flaga == 1) gsl_matrix_free(A);
@@ -3650,6 +3797,13 @@ static VALUE rb_gsl_linalg_balance_matrix2(int argc, VALUE *argv, VALUE module)
 #endif
 
 void Init_gsl_linalg_complex(VALUE module);
+void Init_gsl_linalg_band(VALUE module);
+void Init_gsl_linalg_factor(VALUE module);
+void Init_gsl_linalg_batch(VALUE module);
+void Init_gsl_linalg_iterative(VALUE module);
+void Init_gsl_linalg_rsvd(VALUE module);
+void Init_gsl_linalg_expm(VALUE module);
+void Init_gsl_linalg_lapack(VALUE module);
 void Init_gsl_linalg(VALUE module)
 {
   VALUE mgsl_linalg;
@@ -3947,6 +4101,13 @@ void Init_gsl_linalg(VALUE module)
   /*****/
 
   Init_gsl_linalg_complex(mgsl_linalg);			     
+  Init_gsl_linalg_band(mgsl_linalg);
+  Init_gsl_linalg_factor(mgsl_linalg);
+  Init_gsl_linalg_batch(mgsl_linalg);
+  Init_gsl_linalg_iterative(mgsl_linalg);
+  Init_gsl_linalg_rsvd(mgsl_linalg);
+  Init_gsl_linalg_expm(mgsl_linalg);
+  Init_gsl_linalg_lapack(mgsl_linalg);
 
   /** GSL-1.6 **/
 #ifdef GSL_1_6_LATER
@@ -0,0 +1,748 @@
+/*
+  linalg_band.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Compact storage for tridiagonal and banded matrices, with O(n) and
+  O(n*kl*(kl+ku)) solvers.
+
+    t = GSL::Matrix::Tridiag.new(diag, upper, lower)  # or (diag, offdiag)
+    x = t.solve(b)                                     # gsl_linalg_solve_*tridiag
+
+    a = GSL::Matrix::Band.alloc(n, kl, ku)
+    a[i, j] = v                                        # |i - j| within the band
+    lu = a.LU_decomp                                   # partial pivoting
+    x = lu.solve(b)
+    x = a.cholesky_decomp.solve(b)                     # symmetric, kl == ku
+
+  A Tridiag is symmetric when it is given a single off-diagonal, and
+  cyclic when the off-diagonals have as many elements as the diagonal,
+  following the conventions of gsl_linalg_solve_cyc_tridiag.  A Band
+  keeps row i of A in row i of an n x (kl + ku + 1) GSL::Matrix
+  (Band#data), with A(i, j) at column j - i + kl.
+
+  Every solve accepts a GSL::Vector or a GSL::Matrix whose columns are
+  right-hand sides.  Columns are split over GSL.parallel_threads threads
+  from GSL.parallel_threshold elements of work on, with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+
+static VALUE cgsl_matrix_tridiag, cgsl_matrix_band;
+static VALUE cgsl_matrix_band_LU, cgsl_matrix_band_cholesky;
+
+typedef struct {
+  VALUE d, e, f;    /* diagonal, upper and lower; f is Qnil if symmetric */
+  int cyclic;
+} mygsl_tridiag;
+
+typedef struct {
+  size_t kl, ku;
+  VALUE ab;         /* n x (kl + ku + 1) */
+} mygsl_band;
+
+typedef struct {
+  size_t kl, ku;
+  gsl_matrix *lu;   /* n x (2*kl + ku + 1), U fills in up to kl + ku */
+  size_t *piv;      /* row interchanges */
+} mygsl_band_LU;
+
+typedef struct {
+  size_t k;
+  gsl_matrix *l;    /* n x (k + 1), L(i, j) at column j - i + k */
+} mygsl_band_cholesky;
+
+/*****/
+
+/***** Tridiagonal *****/
+
+static void rb_gsl_tridiag_mark(mygsl_tridiag *t)
+{
+  rb_gc_mark(t->d);
+  rb_gc_mark(t->e);
+  rb_gc_mark(t->f);
+}
+
+static mygsl_tridiag* rb_gsl_get_tridiag(VALUE obj)
+{
+  mygsl_tridiag *t = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_matrix_tridiag))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix::Tridiag expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_tridiag, t);
+  return t;
+}
+
+struct tridiag_fac {
+  const gsl_vector *d, *e, *f;
+  int cyclic;
+};
+
+static void tridiag_fac_get(const mygsl_tridiag *t, struct tridiag_fac *fac)
+{
+  gsl_vector *v;
+  Data_Get_Struct(t->d, gsl_vector, v); fac->d = v;
+  Data_Get_Struct(t->e, gsl_vector, v); fac->e = v;
+  if (NIL_P(t->f)) fac->f = NULL;
+  else { Data_Get_Struct(t->f, gsl_vector, v); fac->f = v; }
+  fac->cyclic = t->cyclic;
+}
+
+static int tridiag_solve1(const void *p, const gsl_vector *b, gsl_vector *x)
+{
+  const struct tridiag_fac *t = (const struct tridiag_fac *) p;
+  if (t->f == NULL) {
+    if (t->cyclic) return gsl_linalg_solve_symm_cyc_tridiag(t->d, t->e, b, x);
+    return gsl_linalg_solve_symm_tridiag(t->d, t->e, b, x);
+  }
+  if (t->cyclic) return gsl_linalg_solve_cyc_tridiag(t->d, t->e, t->f, b, x);
+  return gsl_linalg_solve_tridiag(t->d, t->e, t->f, b, x);
+}
+
+static double tridiag_get(const struct tridiag_fac *t, size_t i, size_t j)
+{
+  const gsl_vector *f = t->f ? t->f : t->e;
+  size_t n = t->d->size;
+  if (i == j) return gsl_vector_get(t->d, i);
+  if (j == i + 1) return gsl_vector_get(t->e, i);
+  if (i == j + 1) return gsl_vector_get(f, j);
+  if (t->cyclic && n > 2) {
+    if (i == n - 1 && j == 0) return gsl_vector_get(t->e, n - 1);
+    if (i == 0 && j == n - 1) return gsl_vector_get(f, n - 1);
+  }
+  return 0.0;
+}
+
+static VALUE rb_gsl_tridiag_wrap(VALUE klass, VALUE d, VALUE e, VALUE f, int cyclic)
+{
+  mygsl_tridiag *t;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_tridiag, rb_gsl_tridiag_mark, free, t);
+  t->d = d;
+  t->e = e;
+  t->f = f;
+  t->cyclic = cyclic;
+  return obj;
+}
+
+static VALUE rb_gsl_vector_new_zero(size_t n)
+{
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_calloc(n));
+}
+
+static VALUE rb_gsl_vector_new_copy(VALUE vv)
+{
+  gsl_vector *v;
+  CHECK_VECTOR(vv);
+  Data_Get_Struct(vv, gsl_vector, v);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, make_vector_clone(v));
+}
+
+/* GSL::Matrix::Tridiag.alloc(n[, {:symmetric => true, :cyclic => true}]) */
+static VALUE rb_gsl_tridiag_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = Qnil, f;
+  size_t n, noff;
+  int symm = 0, cyclic = 0;
+  if (argc == 2 && TYPE(argv[1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  n = NUM2SIZET(argv[0]);
+  if (n < 2) rb_raise(rb_eArgError, "matrix must be at least 2 x 2");
+  if (!NIL_P(opts)) {
+    symm = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("symmetric"))));
+    cyclic = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("cyclic"))));
+  }
+  if (cyclic && n < 3) rb_raise(rb_eArgError, "a cyclic matrix must be at least 3 x 3");
+  noff = cyclic ? n : n - 1;
+  f = symm ? Qnil : rb_gsl_vector_new_zero(noff);
+  return rb_gsl_tridiag_wrap(klass, rb_gsl_vector_new_zero(n),
+			     rb_gsl_vector_new_zero(noff), f, cyclic);
+}
+
+/* GSL::Matrix::Tridiag.new(diag, offdiag) or .new(diag, upper, lower);
+   the vectors are copied */
+static VALUE rb_gsl_tridiag_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_vector *d, *e, *f;
+  int cyclic;
+  if (argc != 2 && argc != 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  CHECK_VECTOR(argv[0]);
+  CHECK_VECTOR(argv[1]);
+  Data_Get_Struct(argv[0], gsl_vector, d);
+  Data_Get_Struct(argv[1], gsl_vector, e);
+  if (e->size == d->size) cyclic = 1;
+  else if (e->size + 1 == d->size) cyclic = 0;
+  else rb_raise(rb_eArgError, "off-diagonal must have %d or %d elements (%d given)",
+		(int) d->size - 1, (int) d->size, (int) e->size);
+  if (argc == 3) {
+    CHECK_VECTOR(argv[2]);
+    Data_Get_Struct(argv[2], gsl_vector, f);
+    if (f->size != e->size)
+      rb_raise(rb_eArgError, "upper and lower diagonals differ in length (%d and %d)",
+	       (int) e->size, (int) f->size);
+  }
+  return rb_gsl_tridiag_wrap(klass, rb_gsl_vector_new_copy(argv[0]),
+			     rb_gsl_vector_new_copy(argv[1]),
+			     argc == 3 ? rb_gsl_vector_new_copy(argv[2]) : Qnil,
+			     cyclic);
+}
+
+/* Matrix#to_tridiag([{:cyclic => true, :symmetric => true}]) */
+static VALUE rb_gsl_matrix_to_tridiag(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *m;
+  gsl_vector *d, *e, *f = NULL;
+  VALUE vd, ve, vf = Qnil;
+  size_t n, i, noff;
+  int cyclic = 0, symm = 0;
+  if (argc == 1) {
+    Check_Type(argv[0], T_HASH);
+    symm = RTEST(rb_hash_aref(argv[0], ID2SYM(rb_intern("symmetric"))));
+    cyclic = RTEST(rb_hash_aref(argv[0], ID2SYM(rb_intern("cyclic"))));
+  } else if (argc != 0) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  }
+  Data_Get_Struct(obj, gsl_matrix, m);
+  if (m->size1 != m->size2) rb_raise(rb_eArgError, "matrix must be square");
+  n = m->size1;
+  if (n < 2) rb_raise(rb_eArgError, "matrix must be at least 2 x 2");
+  if (cyclic && n < 3) rb_raise(rb_eArgError, "a cyclic matrix must be at least 3 x 3");
+  noff = cyclic ? n : n - 1;
+  vd = rb_gsl_vector_new_zero(n);
+  ve = rb_gsl_vector_new_zero(noff);
+  if (!symm) vf = rb_gsl_vector_new_zero(noff);
+  Data_Get_Struct(vd, gsl_vector, d);
+  Data_Get_Struct(ve, gsl_vector, e);
+  if (!symm) Data_Get_Struct(vf, gsl_vector, f);
+  for (i = 0; i < n; i++) {
+    gsl_vector_set(d, i, gsl_matrix_get(m, i, i));
+    if (i + 1 < n) {
+      gsl_vector_set(e, i, gsl_matrix_get(m, i, i + 1));
+      if (f) gsl_vector_set(f, i, gsl_matrix_get(m, i + 1, i));
+    }
+  }
+  if (cyclic) {
+    gsl_vector_set(e, n - 1, gsl_matrix_get(m, n - 1, 0));
+    if (f) gsl_vector_set(f, n - 1, gsl_matrix_get(m, 0, n - 1));
+  }
+  return rb_gsl_tridiag_wrap(cgsl_matrix_tridiag, vd, ve, vf, cyclic);
+}
+
+static VALUE rb_gsl_tridiag_size(VALUE obj)
+{
+  struct tridiag_fac t;
+  tridiag_fac_get(rb_gsl_get_tridiag(obj), &t);
+  return SIZET2NUM(t.d->size);
+}
+
+static VALUE rb_gsl_tridiag_diag(VALUE obj)
+{
+  return rb_gsl_get_tridiag(obj)->d;
+}
+
+static VALUE rb_gsl_tridiag_upper(VALUE obj)
+{
+  return rb_gsl_get_tridiag(obj)->e;
+}
+
+static VALUE rb_gsl_tridiag_lower(VALUE obj)
+{
+  mygsl_tridiag *t = rb_gsl_get_tridiag(obj);
+  return NIL_P(t->f) ? t->e : t->f;
+}
+
+static VALUE rb_gsl_tridiag_symmetric_p(VALUE obj)
+{
+  return NIL_P(rb_gsl_get_tridiag(obj)->f) ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_tridiag_cyclic_p(VALUE obj)
+{
+  return rb_gsl_get_tridiag(obj)->cyclic ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_tridiag_get(VALUE obj, VALUE ii, VALUE jj)
+{
+  struct tridiag_fac t;
+  size_t i, j;
+  tridiag_fac_get(rb_gsl_get_tridiag(obj), &t);
+  i = NUM2SIZET(ii);
+  j = NUM2SIZET(jj);
+  if (i >= t.d->size || j >= t.d->size) rb_raise(rb_eIndexError, "index out of range");
+  return rb_float_new(tridiag_get(&t, i, j));
+}
+
+static VALUE rb_gsl_tridiag_to_m(VALUE obj)
+{
+  struct tridiag_fac t;
+  gsl_matrix *m;
+  size_t n, i, j;
+  tridiag_fac_get(rb_gsl_get_tridiag(obj), &t);
+  n = t.d->size;
+  m = gsl_matrix_calloc(n, n);
+  for (i = 0; i < n; i++)
+    for (j = (i > 0 ? i - 1 : 0); j <= i + 1 && j < n; j++)
+      gsl_matrix_set(m, i, j, tridiag_get(&t, i, j));
+  if (t.cyclic && n > 2) {
+    gsl_matrix_set(m, n - 1, 0, tridiag_get(&t, n - 1, 0));
+    gsl_matrix_set(m, 0, n - 1, tridiag_get(&t, 0, n - 1));
+  }
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+/* Tridiag * Vector */
+static VALUE rb_gsl_tridiag_mul(VALUE obj, VALUE vx)
+{
+  struct tridiag_fac t;
+  gsl_vector *x, *y;
+  size_t n, i;
+  double s;
+  tridiag_fac_get(rb_gsl_get_tridiag(obj), &t);
+  CHECK_VECTOR(vx);
+  Data_Get_Struct(vx, gsl_vector, x);
+  n = t.d->size;
+  if (x->size != n) rb_raise(rb_eArgError, "vector length %d does not match %d x %d",
+			     (int) x->size, (int) n, (int) n);
+  y = gsl_vector_alloc(n);
+  for (i = 0; i < n; i++) {
+    s = tridiag_get(&t, i, i)*gsl_vector_get(x, i);
+    if (i > 0) s += tridiag_get(&t, i, i - 1)*gsl_vector_get(x, i - 1);
+    if (i + 1 < n) s += tridiag_get(&t, i, i + 1)*gsl_vector_get(x, i + 1);
+    if (t.cyclic && n > 2) {
+      if (i == 0) s += tridiag_get(&t, 0, n - 1)*gsl_vector_get(x, n - 1);
+      if (i == n - 1) s += tridiag_get(&t, n - 1, 0)*gsl_vector_get(x, 0);
+    }
+    gsl_vector_set(y, i, s);
+  }
+  return Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, y);
+}
+
+static VALUE rb_gsl_tridiag_solve(VALUE obj, VALUE vb)
+{
+  struct tridiag_fac t;
+  tridiag_fac_get(rb_gsl_get_tridiag(obj), &t);
+  return rb_gsl_linalg_solve_rhs(tridiag_solve1, &t, t.d->size, 8*t.d->size, vb, Qnil);
+}
+
+/***** Banded *****/
+
+static void rb_gsl_band_mark(mygsl_band *b)
+{
+  rb_gc_mark(b->ab);
+}
+
+static mygsl_band* rb_gsl_get_band(VALUE obj, gsl_matrix **ab)
+{
+  mygsl_band *b = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_matrix_band))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix::Band expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_band, b);
+  Data_Get_Struct(b->ab, gsl_matrix, *ab);
+  return b;
+}
+
+#define BAND_IN(i, j, kl, ku) ((j) + (kl) >= (i) && (j) <= (i) + (ku))
+
+static double band_get(const gsl_matrix *ab, size_t kl, size_t ku, size_t i, size_t j)
+{
+  if (!BAND_IN(i, j, kl, ku)) return 0.0;
+  return gsl_matrix_get(ab, i, j + kl - i);
+}
+
+static VALUE rb_gsl_band_wrap(VALUE klass, size_t n, size_t kl, size_t ku)
+{
+  mygsl_band *b;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_band, rb_gsl_band_mark, free, b);
+  b->kl = kl;
+  b->ku = ku;
+  b->ab = Qnil;
+  b->ab = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+			   gsl_matrix_calloc(n, kl + ku + 1));
+  return obj;
+}
+
+/* GSL::Matrix::Band.alloc(n, kl, ku) */
+static VALUE rb_gsl_band_alloc(VALUE klass, VALUE nn, VALUE kkl, VALUE kku)
+{
+  size_t n = NUM2SIZET(nn), kl = NUM2SIZET(kkl), ku = NUM2SIZET(kku);
+  if (n == 0) rb_raise(rb_eArgError, "matrix size must be positive");
+  if (kl >= n || ku >= n) rb_raise(rb_eArgError, "bandwidths must be less than %d",
+				    (int) n);
+  return rb_gsl_band_wrap(klass, n, kl, ku);
+}
+
+/* Matrix#to_band(kl, ku): entries outside the band are dropped */
+static VALUE rb_gsl_matrix_to_band(VALUE obj, VALUE kkl, VALUE kku)
+{
+  gsl_matrix *m, *ab;
+  size_t kl = NUM2SIZET(kkl), ku = NUM2SIZET(kku), n, i, j;
+  VALUE vb;
+  Data_Get_Struct(obj, gsl_matrix, m);
+  if (m->size1 != m->size2) rb_raise(rb_eArgError, "matrix must be square");
+  n = m->size1;
+  if (kl >= n || ku >= n) rb_raise(rb_eArgError, "bandwidths must be less than %d",
+				    (int) n);
+  vb = rb_gsl_band_wrap(cgsl_matrix_band, n, kl, ku);
+  rb_gsl_get_band(vb, &ab);
+  for (i = 0; i < n; i++)
+    for (j = (i > kl ? i - kl : 0); j <= i + ku && j < n; j++)
+      gsl_matrix_set(ab, i, j + kl - i, gsl_matrix_get(m, i, j));
+  return vb;
+}
+
+static VALUE rb_gsl_band_size(VALUE obj)
+{
+  gsl_matrix *ab;
+  rb_gsl_get_band(obj, &ab);
+  return SIZET2NUM(ab->size1);
+}
+
+static VALUE rb_gsl_band_kl(VALUE obj)
+{
+  gsl_matrix *ab;
+  return SIZET2NUM(rb_gsl_get_band(obj, &ab)->kl);
+}
+
+static VALUE rb_gsl_band_ku(VALUE obj)
+{
+  gsl_matrix *ab;
+  return SIZET2NUM(rb_gsl_get_band(obj, &ab)->ku);
+}
+
+static VALUE rb_gsl_band_data(VALUE obj)
+{
+  gsl_matrix *ab;
+  return rb_gsl_get_band(obj, &ab)->ab;
+}
+
+static VALUE rb_gsl_band_get(VALUE obj, VALUE ii, VALUE jj)
+{
+  gsl_matrix *ab;
+  mygsl_band *b = rb_gsl_get_band(obj, &ab);
+  size_t i = NUM2SIZET(ii), j = NUM2SIZET(jj);
+  if (i >= ab->size1 || j >= ab->size1) rb_raise(rb_eIndexError, "index out of range");
+  return rb_float_new(band_get(ab, b->kl, b->ku, i, j));
+}
+
+static VALUE rb_gsl_band_set(VALUE obj, VALUE ii, VALUE jj, VALUE xx)
+{
+  gsl_matrix *ab;
+  mygsl_band *b = rb_gsl_get_band(obj, &ab);
+  size_t i = NUM2SIZET(ii), j = NUM2SIZET(jj);
+  if (i >= ab->size1 || j >= ab->size1) rb_raise(rb_eIndexError, "index out of range");
+  if (!BAND_IN(i, j, b->kl, b->ku))
+    rb_raise(rb_eIndexError, "(%d, %d) is outside the band", (int) i, (int) j);
+  gsl_matrix_set(ab, i, j + b->kl - i, NUM2DBL(xx));
+  return xx;
+}
+
+static VALUE rb_gsl_band_to_m(VALUE obj)
+{
+  gsl_matrix *ab, *m;
+  mygsl_band *b = rb_gsl_get_band(obj, &ab);
+  size_t n = ab->size1, i, j;
+  m = gsl_matrix_calloc(n, n);
+  for (i = 0; i < n; i++)
+    for (j = (i > b->kl ? i - b->kl : 0); j <= i + b->ku && j < n; j++)
+      gsl_matrix_set(m, i, j, gsl_matrix_get(ab, i, j + b->kl - i));
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+/* Band * Vector */
+static VALUE rb_gsl_band_mul(VALUE obj, VALUE vx)
+{
+  gsl_matrix *ab;
+  gsl_vector *x, *y;
+  mygsl_band *b = rb_gsl_get_band(obj, &ab);
+  size_t n = ab->size1, i, j;
+  double s;
+  CHECK_VECTOR(vx);
+  Data_Get_Struct(vx, gsl_vector, x);
+  if (x->size != n) rb_raise(rb_eArgError, "vector length %d does not match %d x %d",
+			     (int) x->size, (int) n, (int) n);
+  y = gsl_vector_alloc(n);
+  for (i = 0; i < n; i++) {
+    s = 0.0;
+    for (j = (i > b->kl ? i - b->kl : 0); j <= i + b->ku && j < n; j++)
+      s += gsl_matrix_get(ab, i, j + b->kl - i)*gsl_vector_get(x, j);
+    gsl_vector_set(y, i, s);
+  }
+  return Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, y);
+}
+
+/*****/
+
+struct band_decomp {
+  const gsl_matrix *ab;
+  size_t kl, ku;
+  gsl_matrix *f;
+  size_t *piv;
+};
+
+/* Gaussian elimination with partial pivoting, as LAPACK dgbtrf, on rows:
+   A(i, j) is at lu(i, j - i + kl) and row interchanges widen U to
+   kl + ku superdiagonals.  A zero pivot is left in place and reported
+   by the solve. */
+static int band_LU_decomp(void *data)
+{
+  struct band_decomp *d = (struct band_decomp *) data;
+  gsl_matrix *lu = d->f;
+  size_t n = d->ab->size1, kl = d->kl, ku = d->ku, i, j, k, p, last, jmax;
+  double *a = lu->data, piv, l, tmp;
+  size_t tda = lu->tda;
+#define LU(i, j) a[(i)*tda + (j) + kl - (i)]
+  gsl_matrix_set_zero(lu);
+  for (i = 0; i < n; i++)
+    for (j = 0; j <= kl + ku; j++) a[i*tda + j] = gsl_matrix_get(d->ab, i, j);
+  for (k = 0; k < n; k++) {
+    last = GSL_MIN(n - 1, k + kl);
+    jmax = GSL_MIN(n - 1, k + kl + ku);
+    p = k;
+    piv = fabs(LU(k, k));
+    for (i = k + 1; i <= last; i++)
+      if (fabs(LU(i, k)) > piv) { piv = fabs(LU(i, k)); p = i; }
+    d->piv[k] = p;
+    if (p != k)
+      for (j = k; j <= jmax; j++) {
+	tmp = LU(k, j); LU(k, j) = LU(p, j); LU(p, j) = tmp;
+      }
+    if (LU(k, k) == 0.0) continue;
+    for (i = k + 1; i <= last; i++) {
+      l = LU(i, k) / LU(k, k);
+      LU(i, k) = l;
+      if (l != 0.0)
+	for (j = k + 1; j <= jmax; j++) LU(i, j) -= l*LU(k, j);
+    }
+  }
+#undef LU
+  return GSL_SUCCESS;
+}
+
+static int band_LU_solve1(const void *p, const gsl_vector *b, gsl_vector *x)
+{
+  const mygsl_band_LU *f = (const mygsl_band_LU *) p;
+  const gsl_matrix *lu = f->lu;
+  size_t n = lu->size1, kl = f->kl, ku = f->ku, i, j, k, last;
+  const double *a = lu->data;
+  size_t tda = lu->tda;
+  double s, tmp;
+#define LU(i, j) a[(i)*tda + (j) + kl - (i)]
+  for (i = 0; i < n; i++)
+    if (LU(i, i) == 0.0) GSL_ERROR("matrix is singular", GSL_EDOM);
+  gsl_vector_memcpy(x, b);
+  for (k = 0; k < n; k++) {
+    if (f->piv[k] != k) {
+      tmp = gsl_vector_get(x, k);
+      gsl_vector_set(x, k, gsl_vector_get(x, f->piv[k]));
+      gsl_vector_set(x, f->piv[k], tmp);
+    }
+    last = GSL_MIN(n - 1, k + kl);
+    tmp = gsl_vector_get(x, k);
+    for (i = k + 1; i <= last; i++)
+      gsl_vector_set(x, i, gsl_vector_get(x, i) - LU(i, k)*tmp);
+  }
+  for (i = n; i-- > 0;) {
+    s = gsl_vector_get(x, i);
+    last = GSL_MIN(n - 1, i + kl + ku);
+    for (j = i + 1; j <= last; j++) s -= LU(i, j)*gsl_vector_get(x, j);
+    gsl_vector_set(x, i, s / LU(i, i));
+  }
+#undef LU
+  return GSL_SUCCESS;
+}
+
+/* Banded Cholesky A = L L^T from the lower band of A */
+static int band_cholesky_decomp(void *data)
+{
+  struct band_decomp *d = (struct band_decomp *) data;
+  gsl_matrix *lm = d->f;
+  size_t n = d->ab->size1, k = d->kl, i, j, m, last;
+  double s;
+#define A(i, j) gsl_matrix_get(d->ab, (i), (j) + k - (i))
+#define L(i, j) lm->data[(i)*lm->tda + (j) + k - (i)]
+  gsl_matrix_set_zero(lm);
+  for (j = 0; j < n; j++) {
+    s = A(j, j);
+    for (m = (j > k ? j - k : 0); m < j; m++) s -= L(j, m)*L(j, m);
+    if (s <= 0.0) GSL_ERROR("matrix is not positive definite", GSL_EDOM);
+    L(j, j) = sqrt(s);
+    last = GSL_MIN(n - 1, j + k);
+    for (i = j + 1; i <= last; i++) {
+      s = A(i, j);
+      for (m = (i > k ? i - k : 0); m < j; m++) s -= L(i, m)*L(j, m);
+      L(i, j) = s / L(j, j);
+    }
+  }
+#undef A
+#undef L
+  return GSL_SUCCESS;
+}
+
+static int band_cholesky_solve1(const void *p, const gsl_vector *b, gsl_vector *x)
+{
+  const mygsl_band_cholesky *f = (const mygsl_band_cholesky *) p;
+  const gsl_matrix *lm = f->l;
+  size_t n = lm->size1, k = f->k, i, m, last;
+  double s;
+#define L(i, j) lm->data[(i)*lm->tda + (j) + k - (i)]
+  for (i = 0; i < n; i++) {
+    s = gsl_vector_get(b, i);
+    for (m = (i > k ? i - k : 0); m < i; m++) s -= L(i, m)*gsl_vector_get(x, m);
+    gsl_vector_set(x, i, s / L(i, i));
+  }
+  for (i = n; i-- > 0;) {
+    s = gsl_vector_get(x, i);
+    last = GSL_MIN(n - 1, i + k);
+    for (m = i + 1; m <= last; m++) s -= L(m, i)*gsl_vector_get(x, m);
+    gsl_vector_set(x, i, s / L(i, i));
+  }
+#undef L
+  return GSL_SUCCESS;
+}
+
+static void rb_gsl_band_LU_free(mygsl_band_LU *f)
+{
+  if (f->lu) gsl_matrix_free(f->lu);
+  free(f->piv);
+  free(f);
+}
+
+static void rb_gsl_band_cholesky_free(mygsl_band_cholesky *f)
+{
+  if (f->l) gsl_matrix_free(f->l);
+  free(f);
+}
+
+/* Band#LU_decomp -> GSL::Matrix::Band::LU */
+static VALUE rb_gsl_band_LU_decomp(VALUE obj)
+{
+  gsl_matrix *ab;
+  mygsl_band *b = rb_gsl_get_band(obj, &ab);
+  mygsl_band_LU *f;
+  struct band_decomp d;
+  VALUE vf;
+  size_t n = ab->size1;
+  vf = Data_Make_Struct(cgsl_matrix_band_LU, mygsl_band_LU, 0, rb_gsl_band_LU_free, f);
+  f->kl = b->kl;
+  f->ku = b->ku;
+  f->lu = gsl_matrix_alloc(n, 2*b->kl + b->ku + 1);
+  f->piv = (size_t *) malloc(sizeof(size_t)*n);
+  if (f->piv == NULL) rb_raise(rb_eNoMemError, "malloc failed");
+  d.ab = ab;
+  d.kl = b->kl;
+  d.ku = b->ku;
+  d.f = f->lu;
+  d.piv = f->piv;
+  rb_gsl_nogvl_call(band_LU_decomp, &d, n*(b->kl + 1)*(b->kl + b->ku + 1));
+  return vf;
+}
+
+/* Band#cholesky_decomp -> GSL::Matrix::Band::Cholesky */
+static VALUE rb_gsl_band_cholesky_decomp(VALUE obj)
+{
+  gsl_matrix *ab;
+  mygsl_band *b = rb_gsl_get_band(obj, &ab);
+  mygsl_band_cholesky *f;
+  struct band_decomp d;
+  VALUE vf;
+  size_t n = ab->size1;
+  if (b->kl != b->ku)
+    rb_raise(rb_eArgError, "a symmetric band (kl == ku) is required");
+  vf = Data_Make_Struct(cgsl_matrix_band_cholesky, mygsl_band_cholesky, 0,
+			rb_gsl_band_cholesky_free, f);
+  f->k = b->kl;
+  f->l = gsl_matrix_alloc(n, b->kl + 1);
+  d.ab = ab;
+  d.kl = b->kl;
+  d.ku = b->ku;
+  d.f = f->l;
+  d.piv = NULL;
+  rb_gsl_nogvl_call(band_cholesky_decomp, &d, n*(b->kl + 1)*(b->kl + 1));
+  return vf;
+}
+
+static VALUE rb_gsl_band_LU_solve(VALUE obj, VALUE vb)
+{
+  mygsl_band_LU *f;
+  Data_Get_Struct(obj, mygsl_band_LU, f);
+  return rb_gsl_linalg_solve_rhs(band_LU_solve1, f, f->lu->size1,
+			       f->lu->size1*(2*f->kl + f->ku + 1), vb, Qnil);
+}
+
+static VALUE rb_gsl_band_cholesky_solve(VALUE obj, VALUE vb)
+{
+  mygsl_band_cholesky *f;
+  Data_Get_Struct(obj, mygsl_band_cholesky, f);
+  return rb_gsl_linalg_solve_rhs(band_cholesky_solve1, f, f->l->size1,
+			       f->l->size1*(2*f->k + 1), vb, Qnil);
+}
+
+/* Band#solve(b) and Band#cholesky_solve(b) factorize and solve at once */
+static VALUE rb_gsl_band_solve(VALUE obj, VALUE vb)
+{
+  return rb_gsl_band_LU_solve(rb_gsl_band_LU_decomp(obj), vb);
+}
+
+static VALUE rb_gsl_band_cholesky_solve_at_once(VALUE obj, VALUE vb)
+{
+  return rb_gsl_band_cholesky_solve(rb_gsl_band_cholesky_decomp(obj), vb);
+}
+
+void Init_gsl_linalg_band(VALUE module)
+{
+  cgsl_matrix_tridiag = rb_define_class_under(cgsl_matrix, "Tridiag", cGSL_Object);
+  rb_define_singleton_method(cgsl_matrix_tridiag, "alloc", rb_gsl_tridiag_alloc, -1);
+  rb_define_singleton_method(cgsl_matrix_tridiag, "new", rb_gsl_tridiag_new, -1);
+  rb_define_method(cgsl_matrix_tridiag, "size", rb_gsl_tridiag_size, 0);
+  rb_define_method(cgsl_matrix_tridiag, "diag", rb_gsl_tridiag_diag, 0);
+  rb_define_method(cgsl_matrix_tridiag, "upper", rb_gsl_tridiag_upper, 0);
+  rb_define_alias(cgsl_matrix_tridiag, "superdiag", "upper");
+  rb_define_method(cgsl_matrix_tridiag, "lower", rb_gsl_tridiag_lower, 0);
+  rb_define_alias(cgsl_matrix_tridiag, "subdiag", "lower");
+  rb_define_method(cgsl_matrix_tridiag, "symmetric?", rb_gsl_tridiag_symmetric_p, 0);
+  rb_define_method(cgsl_matrix_tridiag, "cyclic?", rb_gsl_tridiag_cyclic_p, 0);
+  rb_define_method(cgsl_matrix_tridiag, "get", rb_gsl_tridiag_get, 2);
+  rb_define_alias(cgsl_matrix_tridiag, "[]", "get");
+  rb_define_method(cgsl_matrix_tridiag, "to_m", rb_gsl_tridiag_to_m, 0);
+  rb_define_method(cgsl_matrix_tridiag, "*", rb_gsl_tridiag_mul, 1);
+  rb_define_method(cgsl_matrix_tridiag, "solve", rb_gsl_tridiag_solve, 1);
+  rb_define_method(cgsl_matrix, "to_tridiag", rb_gsl_matrix_to_tridiag, -1);
+
+  cgsl_matrix_band = rb_define_class_under(cgsl_matrix, "Band", cGSL_Object);
+  rb_define_singleton_method(cgsl_matrix_band, "alloc", rb_gsl_band_alloc, 3);
+  rb_define_singleton_method(cgsl_matrix_band, "new", rb_gsl_band_alloc, 3);
+  rb_define_method(cgsl_matrix_band, "size", rb_gsl_band_size, 0);
+  rb_define_method(cgsl_matrix_band, "kl", rb_gsl_band_kl, 0);
+  rb_define_method(cgsl_matrix_band, "ku", rb_gsl_band_ku, 0);
+  rb_define_method(cgsl_matrix_band, "data", rb_gsl_band_data, 0);
+  rb_define_method(cgsl_matrix_band, "get", rb_gsl_band_get, 2);
+  rb_define_alias(cgsl_matrix_band, "[]", "get");
+  rb_define_method(cgsl_matrix_band, "set", rb_gsl_band_set, 3);
+  rb_define_alias(cgsl_matrix_band, "[]=", "set");
+  rb_define_method(cgsl_matrix_band, "to_m", rb_gsl_band_to_m, 0);
+  rb_define_method(cgsl_matrix_band, "*", rb_gsl_band_mul, 1);
+  rb_define_method(cgsl_matrix_band, "LU_decomp", rb_gsl_band_LU_decomp, 0);
+  rb_define_method(cgsl_matrix_band, "cholesky_decomp", rb_gsl_band_cholesky_decomp, 0);
+  rb_define_method(cgsl_matrix_band, "solve", rb_gsl_band_solve, 1);
+  rb_define_alias(cgsl_matrix_band, "LU_solve", "solve");
+  rb_define_method(cgsl_matrix_band, "cholesky_solve", rb_gsl_band_cholesky_solve_at_once, 1);
+  rb_define_method(cgsl_matrix, "to_band", rb_gsl_matrix_to_band, 2);
+
+  cgsl_matrix_band_LU = rb_define_class_under(cgsl_matrix_band, "LU", cGSL_Object);
+  rb_define_method(cgsl_matrix_band_LU, "solve", rb_gsl_band_LU_solve, 1);
+  cgsl_matrix_band_cholesky = rb_define_class_under(cgsl_matrix_band, "Cholesky",
+						    cGSL_Object);
+  rb_define_method(cgsl_matrix_band_cholesky, "solve", rb_gsl_band_cholesky_solve, 1);
+}
@@ -0,0 +1,365 @@
+/*
+  linalg_batch.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Many small independent n x n systems in one call.
+
+    x = GSL::Linalg::Batch.solve(a, b)           # LU, partial pivoting
+    x = GSL::Linalg::Batch.cholesky_solve(a, b)  # symmetric positive definite
+    d = GSL::Linalg::Batch.det(a)
+
+  a holds the systems stacked as a (batch*n) x n GSL::Matrix, system k
+  in rows k*n ... k*n + n - 1, or is an Array of n x n matrices.  b is
+  a batch x n GSL::Matrix whose row k is the right-hand side of system
+  k, or a Vector of batch*n elements; the solution has the shape of b,
+  and may be given as a third argument.  A is never modified.
+
+  Each system is copied to a packed local block and eliminated there.
+  For n = 2, 3, 4, 6 and 8 the kernels are instantiated with n a
+  compile-time constant, so the compiler unrolls them completely; other
+  sizes go through the same code with n a variable.  The batch is split
+  into contiguous ranges over GSL.parallel_threads threads from
+  GSL.parallel_threshold elements of work on, with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+
+enum {
+  BATCH_LU,
+  BATCH_CHOLESKY,
+  BATCH_DET,
+};
+
+/* Gaussian elimination with partial pivoting of the packed n x n
+   A, applied to x as well when x is not NULL; returns the determinant
+   in *det.  A singular system is an error only when solving. */
+static inline int batch_lu(double *A, double *x, const size_t n, double *det)
+{
+  size_t i, j, k, p;
+  double piv, l, tmp, d = 1.0;
+  for (k = 0; k < n; k++) {
+    p = k;
+    for (i = k + 1; i < n; i++)
+      if (fabs(A[i*n + k]) > fabs(A[p*n + k])) p = i;
+    if (A[p*n + k] == 0.0) {
+      *det = 0.0;
+      if (x) GSL_ERROR("matrix is singular", GSL_ESING);
+      return GSL_SUCCESS;
+    }
+    if (p != k) {
+      for (j = k; j < n; j++) {
+	tmp = A[k*n + j]; A[k*n + j] = A[p*n + j]; A[p*n + j] = tmp;
+      }
+      if (x) { tmp = x[k]; x[k] = x[p]; x[p] = tmp; }
+      d = -d;
+    }
+    piv = A[k*n + k];
+    d *= piv;
+    for (i = k + 1; i < n; i++) {
+      l = A[i*n + k]/piv;
+      for (j = k + 1; j < n; j++) A[i*n + j] -= l*A[k*n + j];
+      if (x) x[i] -= l*x[k];
+    }
+  }
+  *det = d;
+  if (x == NULL) return GSL_SUCCESS;
+  for (k = n; k-- > 0;) {
+    tmp = x[k];
+    for (j = k + 1; j < n; j++) tmp -= A[k*n + j]*x[j];
+    x[k] = tmp/A[k*n + k];
+  }
+  return GSL_SUCCESS;
+}
+
+/* A = L L^T on the lower triangle, then L L^T x = b */
+static inline int batch_cholesky(double *A, double *x, const size_t n)
+{
+  size_t i, j, k;
+  double s;
+  for (j = 0; j < n; j++) {
+    s = A[j*n + j];
+    for (k = 0; k < j; k++) s -= A[j*n + k]*A[j*n + k];
+    if (s <= 0.0) GSL_ERROR("matrix is not positive definite", GSL_EDOM);
+    A[j*n + j] = sqrt(s);
+    for (i = j + 1; i < n; i++) {
+      s = A[i*n + j];
+      for (k = 0; k < j; k++) s -= A[i*n + k]*A[j*n + k];
+      A[i*n + j] = s/A[j*n + j];
+    }
+  }
+  for (i = 0; i < n; i++) {
+    s = x[i];
+    for (k = 0; k < i; k++) s -= A[i*n + k]*x[k];
+    x[i] = s/A[i*n + i];
+  }
+  for (i = n; i-- > 0;) {
+    s = x[i];
+    for (k = i + 1; k < n; k++) s -= A[k*n + i]*x[k];
+    x[i] = s/A[i*n + i];
+  }
+  return GSL_SUCCESS;
+}
+
+struct batch_task {
+  int kind;
+  const double *a;      /* system k at a + k*n*tda */
+  size_t tda;
+  const double *b;      /* right-hand side k at b + k*bstride */
+  size_t bstride;
+  double *x;            /* solution k at x + k*xstride; det k at x[k] */
+  size_t xstride;
+  size_t n, batch, nthreads;
+};
+
+/* Copies A (and b) of system k to the packed A and x */
+static inline void batch_load(const struct batch_task *t, size_t k, double *A,
+			      double *x, const size_t n)
+{
+  const double *a = t->a + k*n*t->tda, *b;
+  size_t i, j;
+  for (i = 0; i < n; i++)
+    for (j = 0; j < n; j++) A[i*n + j] = a[i*t->tda + j];
+  if (x == NULL) return;
+  b = t->b + k*t->bstride;
+  for (i = 0; i < n; i++) x[i] = b[i];
+}
+
+static inline int batch_one(const struct batch_task *t, size_t k, double *A,
+			    double *x, const size_t n)
+{
+  double det, *xk;
+  size_t i;
+  int status;
+  if (t->kind == BATCH_DET) {
+    batch_load(t, k, A, NULL, n);
+    batch_lu(A, NULL, n, &det);
+    t->x[k] = det;
+    return GSL_SUCCESS;
+  }
+  batch_load(t, k, A, x, n);
+  if (t->kind == BATCH_CHOLESKY) status = batch_cholesky(A, x, n);
+  else status = batch_lu(A, x, n, &det);
+  if (status) return status;
+  xk = t->x + k*t->xstride;
+  for (i = 0; i < n; i++) xk[i] = x[i];
+  return GSL_SUCCESS;
+}
+
+#define BATCH_FIXED_RANGE(N)						\
+  static int batch_range_##N(const struct batch_task *t, size_t k0, size_t k1) \
+  {									\
+    double A[N*N], x[N];						\
+    size_t k;								\
+    int status;								\
+    for (k = k0; k < k1; k++) {						\
+      status = batch_one(t, k, A, x, N);				\
+      if (status) return status;					\
+    }									\
+    return GSL_SUCCESS;							\
+  }
+
+BATCH_FIXED_RANGE(2)
+BATCH_FIXED_RANGE(3)
+BATCH_FIXED_RANGE(4)
+BATCH_FIXED_RANGE(6)
+BATCH_FIXED_RANGE(8)
+
+static int batch_range_any(const struct batch_task *t, size_t k0, size_t k1)
+{
+  double *A, *x;
+  size_t k, n = t->n;
+  int status = GSL_SUCCESS;
+  A = (double *) malloc(sizeof(double)*n*(n + 1));
+  if (A == NULL) GSL_ERROR("failed to allocate space for the systems", GSL_ENOMEM);
+  x = A + n*n;
+  for (k = k0; k < k1; k++) {
+    status = batch_one(t, k, A, x, n);
+    if (status) break;
+  }
+  free(A);
+  return status;
+}
+
+static int batch_range(const struct batch_task *t, size_t k0, size_t k1)
+{
+  switch (t->n) {
+  case 2: return batch_range_2(t, k0, k1);
+  case 3: return batch_range_3(t, k0, k1);
+  case 4: return batch_range_4(t, k0, k1);
+  case 6: return batch_range_6(t, k0, k1);
+  case 8: return batch_range_8(t, k0, k1);
+  default: return batch_range_any(t, k0, k1);
+  }
+}
+
+static int batch_worker(void *data, size_t k)
+{
+  struct batch_task *t = (struct batch_task *) data;
+  size_t k0 = t->batch*k/t->nthreads, k1 = t->batch*(k + 1)/t->nthreads;
+  return batch_range(t, k0, k1);
+}
+
+static int batch_serial(void *data)
+{
+  struct batch_task *t = (struct batch_task *) data;
+  return batch_range(t, 0, t->batch);
+}
+
+static void batch_run(struct batch_task *t)
+{
+  size_t work = t->batch*t->n*t->n*t->n;
+  t->nthreads = rb_gsl_parallel_nthreads(work, t->batch);
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(batch_worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(batch_serial, t, work);
+}
+
+/* Returns the stacked (batch*n) x n matrix of the systems; an Array of
+   matrices is packed into a new one, kept alive through *keep */
+gsl_matrix* rb_gsl_linalg_batch_systems(VALUE va, size_t *batch, size_t *n, VALUE *keep)
+{
+  gsl_matrix *A = NULL, *m = NULL;
+  size_t k, i;
+  *keep = va;
+  if (TYPE(va) == T_ARRAY) {
+    *batch = RARRAY_LEN(va);
+    if (*batch == 0) rb_raise(rb_eArgError, "no systems given");
+    for (k = 0; k < *batch; k++) {
+      CHECK_MATRIX(rb_ary_entry(va, k));
+      Data_Get_Struct(rb_ary_entry(va, k), gsl_matrix, m);
+      if (k == 0) *n = m->size1;
+      if (m->size1 != *n || m->size2 != *n)
+	rb_raise(rb_eArgError, "system %d is %d x %d, not %d x %d", (int) k,
+		 (int) m->size1, (int) m->size2, (int) *n, (int) *n);
+    }
+    A = gsl_matrix_alloc(*batch*(*n), *n);
+    *keep = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, A);
+    for (k = 0; k < *batch; k++) {
+      Data_Get_Struct(rb_ary_entry(va, k), gsl_matrix, m);
+      for (i = 0; i < *n; i++)
+	memcpy(A->data + (k*(*n) + i)*A->tda, m->data + i*m->tda,
+	       sizeof(double)*(*n));
+    }
+    return A;
+  }
+  CHECK_MATRIX(va);
+  Data_Get_Struct(va, gsl_matrix, A);
+  *n = A->size2;
+  if (*n == 0 || A->size1 % *n != 0)
+    rb_raise(rb_eArgError, "a %d x %d matrix is not a stack of %d x %d systems",
+	     (int) A->size1, (int) A->size2, (int) *n, (int) *n);
+  *batch = A->size1/(*n);
+  return A;
+}
+
+static VALUE rb_gsl_linalg_batch_solve0(int argc, VALUE *argv, int kind)
+{
+  struct batch_task t;
+  gsl_matrix *A, *B = NULL, *X = NULL;
+  gsl_vector *b = NULL, *x = NULL;
+  size_t n, batch;
+  VALUE keep, keepb = Qnil, vx;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  A = rb_gsl_linalg_batch_systems(argv[0], &batch, &n, &keep);
+  vx = argc == 3 ? argv[2] : Qnil;
+  t.kind = kind;
+  t.a = A->data;
+  t.tda = A->tda;
+  t.n = n;
+  t.batch = batch;
+  if (MATRIX_P(argv[1])) {
+    Data_Get_Struct(argv[1], gsl_matrix, B);
+    if (B->size1 != batch || B->size2 != n)
+      rb_raise(rb_eArgError, "right-hand sides must be %d x %d", (int) batch, (int) n);
+    if (NIL_P(vx)) {
+      X = gsl_matrix_alloc(batch, n);
+      vx = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, X);
+    } else {
+      CHECK_MATRIX(vx);
+      Data_Get_Struct(vx, gsl_matrix, X);
+      if (X->size1 != batch || X->size2 != n)
+	rb_raise(rb_eArgError, "solution matrix must be %d x %d", (int) batch, (int) n);
+    }
+    t.b = B->data; t.bstride = B->tda;
+    t.x = X->data; t.xstride = X->tda;
+  } else {
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Struct(argv[1], gsl_vector, b);
+    if (b->size != batch*n)
+      rb_raise(rb_eArgError, "right-hand sides must have %d elements", (int) (batch*n));
+    if (b->stride != 1) {
+      b = make_vector_clone(b);
+      keepb = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, b);
+    }
+    if (NIL_P(vx)) {
+      x = gsl_vector_alloc(batch*n);
+      vx = Data_Wrap_Struct(VECTOR_COL_P(argv[1]) ? cgsl_vector_col : cgsl_vector,
+			    0, gsl_vector_free, x);
+    } else {
+      CHECK_VECTOR(vx);
+      Data_Get_Struct(vx, gsl_vector, x);
+      if (x->size != batch*n || x->stride != 1)
+	rb_raise(rb_eArgError, "solution vector must have %d contiguous elements",
+		 (int) (batch*n));
+    }
+    t.b = b->data; t.bstride = n;
+    t.x = x->data; t.xstride = n;
+  }
+  batch_run(&t);
+  RB_GC_GUARD(keep);
+  RB_GC_GUARD(keepb);
+  return vx;
+}
+
+static VALUE rb_gsl_linalg_batch_solve(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_linalg_batch_solve0(argc, argv, BATCH_LU);
+}
+
+static VALUE rb_gsl_linalg_batch_cholesky_solve(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_linalg_batch_solve0(argc, argv, BATCH_CHOLESKY);
+}
+
+static VALUE rb_gsl_linalg_batch_det(VALUE module, VALUE va)
+{
+  struct batch_task t;
+  gsl_matrix *A;
+  gsl_vector *d;
+  size_t n, batch;
+  VALUE keep, vd;
+  A = rb_gsl_linalg_batch_systems(va, &batch, &n, &keep);
+  d = gsl_vector_alloc(batch);
+  vd = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, d);
+  t.kind = BATCH_DET;
+  t.a = A->data;
+  t.tda = A->tda;
+  t.b = NULL; t.bstride = 0;
+  t.x = d->data; t.xstride = 1;
+  t.n = n;
+  t.batch = batch;
+  batch_run(&t);
+  RB_GC_GUARD(keep);
+  return vd;
+}
+
+void Init_gsl_linalg_batch(VALUE module)
+{
+  VALUE mgsl_linalg_batch;
+  mgsl_linalg_batch = rb_define_module_under(module, "Batch");
+  rb_define_module_function(mgsl_linalg_batch, "solve", rb_gsl_linalg_batch_solve, -1);
+  rb_define_module_function(mgsl_linalg_batch, "LU_solve", rb_gsl_linalg_batch_solve, -1);
+  rb_define_module_function(mgsl_linalg_batch, "cholesky_solve",
+			    rb_gsl_linalg_batch_cholesky_solve, -1);
+  rb_define_module_function(mgsl_linalg_batch, "det", rb_gsl_linalg_batch_det, 1);
+}
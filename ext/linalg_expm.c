@@ -0,0 +1,389 @@
+/*
+  linalg_expm.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The matrix exponential, and its action on a vector.
+
+    e = a.expm              # or GSL::Linalg.expm(a, t) for exp(a t)
+    p = q.expm(0.5)         # transition probabilities of a generator q
+    y = GSL::Linalg.expmv(a, v, t)   # exp(a t) v, a Matrix or SpMatrix
+
+  expm is the scaling and squaring method with the [m/m] Pade
+  approximants, m = 3, 5, 7, 9 or 13 chosen from the 1-norm (Higham,
+  SIAM J. Matrix Anal. Appl. 26, 2005): A is first shifted by mu =
+  trace(A)/n when that lowers its norm, scaled by 2^-s until the norm
+  is under theta_13, and the approximant is squared s times.  That is
+  about (m/2 + s + 4/3) n^3 flops through dgemm, and an LU solve.
+
+  expmv never forms exp(A t): with B = t(A - mu I), s = ceil(|B|_1/2)
+  steps of truncated Taylor series of exp(B/s) applied to v, each
+  stopped when two terms are under the unit roundoff relative to the
+  sum (Al-Mohy and Higham, SIAM J. Sci. Comput. 33, 2011, with a fixed
+  step norm of at most 2 instead of their table of m and theta_m).
+  Each step costs a few tens of products with A, O(nnz) for a sparse A.
+
+  Both run with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_blas.h>
+
+#define EXPMV_STEP_NORM 2.0
+#define EXPMV_MAX_TERMS 60
+
+static const double expm_b3[] = {120.0, 60.0, 12.0, 1.0};
+static const double expm_b5[] = {30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0};
+static const double expm_b7[] = {17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0,
+				 1512.0, 56.0, 1.0};
+static const double expm_b9[] = {17643225600.0, 8821612800.0, 2075673600.0, 302702400.0,
+				 30270240.0, 2162160.0, 110880.0, 3960.0, 90.0, 1.0};
+static const double expm_b13[] = {64764752532480000.0, 32382376266240000.0,
+				  7771770303897600.0, 1187353796428800.0,
+				  129060195264000.0, 10559470521600.0, 670442572800.0,
+				  33522128640.0, 1323241920.0, 40840800.0, 960960.0,
+				  16380.0, 182.0, 1.0};
+static const double expm_theta[] = {1.495585217958292e-2, 2.539398330063230e-1,
+				    9.504178996162932e-1, 2.097847961257068e0,
+				    5.371920351148152e0};
+
+typedef struct {
+  const gsl_matrix *A;
+  double t;
+  gsl_matrix *E;                   /* the result */
+  gsl_matrix *X, *A2, *A4, *A6, *A8, *U, *V, *T;
+  gsl_permutation *p;
+} mygsl_expm;
+
+static double expm_norm1(const gsl_matrix *A)
+{
+  size_t i, j;
+  double s, norm = 0.0;
+  for (j = 0; j < A->size2; j++) {
+    for (i = 0, s = 0.0; i < A->size1; i++) s += fabs(A->data[i*A->tda + j]);
+    if (s > norm) norm = s;
+  }
+  return norm;
+}
+
+/* C = A B */
+static void expm_mul(const gsl_matrix *A, const gsl_matrix *B, gsl_matrix *C)
+{
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A, B, 0.0, C);
+}
+
+/* M = sum_k c[k] P[k] + c0 I over the given powers */
+static void expm_combine(gsl_matrix *M, double c0, const double *c, gsl_matrix **P, size_t np)
+{
+  size_t k, i, j, n = M->size1;
+  double *m;
+  for (i = 0; i < n; i++) {
+    m = M->data + i*M->tda;
+    for (j = 0; j < n; j++) m[j] = 0.0;
+    for (k = 0; k < np; k++) {
+      const double *p = P[k]->data + i*P[k]->tda;
+      for (j = 0; j < n; j++) m[j] += c[k]*p[j];
+    }
+    m[i] += c0;
+  }
+}
+
+static int expm_run(void *data)
+{
+  mygsl_expm *e = (mygsl_expm *) data;
+  gsl_matrix *X = e->X, *U = e->U, *V = e->V, *T = e->T, *P[4], *sw;
+  size_t n = X->size1, i, k, s = 0;
+  const double *b = expm_b13;
+  double mu = 0.0, norm, c[4];
+  int m = 13, signum;
+  gsl_matrix_memcpy(X, e->A);
+  gsl_matrix_scale(X, e->t);
+  norm = expm_norm1(X);
+  for (i = 0; i < n; i++) mu += X->data[i*X->tda + i];
+  mu /= (double) n;
+  for (i = 0; i < n; i++) X->data[i*X->tda + i] -= mu;
+  if (expm_norm1(X) < norm) {
+    norm = expm_norm1(X);
+  } else {
+    for (i = 0; i < n; i++) X->data[i*X->tda + i] += mu;
+    mu = 0.0;
+  }
+  if (!gsl_finite(norm)) GSL_ERROR("matrix has non-finite elements", GSL_EDOM);
+  if (norm <= expm_theta[0]) { m = 3; b = expm_b3; }
+  else if (norm <= expm_theta[1]) { m = 5; b = expm_b5; }
+  else if (norm <= expm_theta[2]) { m = 7; b = expm_b7; }
+  else if (norm <= expm_theta[3]) { m = 9; b = expm_b9; }
+  else if (norm > expm_theta[4]) {
+    s = (size_t) ceil(log2(norm/expm_theta[4]));
+    gsl_matrix_scale(X, ldexp(1.0, -(int) s));
+  }
+  expm_mul(X, X, e->A2);
+  if (m >= 5) expm_mul(e->A2, e->A2, e->A4);
+  if (m >= 7) expm_mul(e->A2, e->A4, e->A6);
+  if (m == 9) expm_mul(e->A4, e->A4, e->A8);
+  P[0] = e->A2; P[1] = e->A4; P[2] = e->A6; P[3] = e->A8;
+  if (m < 13) {
+    /* U = X sum b[2k+1] X^2k, V = sum b[2k] X^2k */
+    for (k = 0; k < (size_t) m/2; k++) c[k] = b[2*k + 3];
+    expm_combine(T, b[1], c, P, m/2);
+    expm_mul(X, T, U);
+    for (k = 0; k < (size_t) m/2; k++) c[k] = b[2*k + 2];
+    expm_combine(V, b[0], c, P, m/2);
+  } else {
+    /* U = X [A6 (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I] */
+    c[0] = b[9]; c[1] = b[11]; c[2] = b[13];
+    expm_combine(T, 0.0, c, P, 3);
+    expm_mul(e->A6, T, V);
+    c[0] = b[3]; c[1] = b[5]; c[2] = b[7];
+    expm_combine(T, b[1], c, P, 3);
+    gsl_matrix_add(T, V);
+    expm_mul(X, T, U);
+    /* V = A6 (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I */
+    c[0] = b[8]; c[1] = b[10]; c[2] = b[12];
+    expm_combine(T, 0.0, c, P, 3);
+    expm_mul(e->A6, T, X);
+    c[0] = b[2]; c[1] = b[4]; c[2] = b[6];
+    expm_combine(V, b[0], c, P, 3);
+    gsl_matrix_add(V, X);
+  }
+  /* (V - U) E = V + U */
+  gsl_matrix_memcpy(T, V);
+  gsl_matrix_sub(T, U);
+  gsl_matrix_add(V, U);
+  gsl_linalg_LU_decomp(T, e->p, &signum);
+  for (i = 0; i < n; i++)
+    if (T->data[i*T->tda + i] == 0.0) GSL_ERROR("singular Pade denominator", GSL_ESING);
+  for (k = 0; k < n; k++) {
+    gsl_vector_view col = gsl_matrix_column(V, k);
+    gsl_linalg_LU_svx(T, e->p, &col.vector);
+  }
+  /* square s times */
+  for (k = 0; k < s; k++) {
+    expm_mul(V, V, U);
+    sw = V; V = U; U = sw;
+  }
+  gsl_matrix_memcpy(e->E, V);
+  if (mu != 0.0) gsl_matrix_scale(e->E, exp(mu));
+  return GSL_SUCCESS;
+}
+
+static gsl_matrix* expm_matrix(size_t n, VALUE keep)
+{
+  gsl_matrix *m = gsl_matrix_alloc(n, n);
+  if (m == NULL) rb_raise(rb_eNoMemError, "gsl_matrix_alloc failed");
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m));
+  return m;
+}
+
+static double expm_time(int argc, VALUE *argv, int i)
+{
+  return argc > i ? NUM2DBL(argv[i]) : 1.0;
+}
+
+/* GSL::Linalg.expm(a, t = 1): exp(a t) */
+static VALUE rb_gsl_linalg_expm(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_expm e;
+  VALUE keep = rb_ary_new(), ve;
+  size_t n;
+  rb_check_arity(argc, 1, 2);
+  CHECK_MATRIX(argv[0]);
+  Data_Get_Struct(argv[0], gsl_matrix, e.A);
+  n = e.A->size1;
+  if (n != e.A->size2) rb_raise(rb_eArgError, "matrix must be square");
+  if (n == 0) rb_raise(rb_eArgError, "empty matrix");
+  e.t = expm_time(argc, argv, 1);
+  e.X = expm_matrix(n, keep);
+  e.A2 = expm_matrix(n, keep);
+  e.A4 = expm_matrix(n, keep);
+  e.A6 = expm_matrix(n, keep);
+  e.A8 = expm_matrix(n, keep);
+  e.U = expm_matrix(n, keep);
+  e.V = expm_matrix(n, keep);
+  e.T = expm_matrix(n, keep);
+  e.p = gsl_permutation_alloc(n);
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, e.p));
+  e.E = gsl_matrix_alloc(n, n);
+  ve = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, e.E);
+  rb_gsl_nogvl_call(expm_run, &e, 20*n*n*n);
+  RB_GC_GUARD(keep);
+  return ve;
+}
+
+static VALUE rb_gsl_matrix_expm(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE args[2];
+  rb_check_arity(argc, 0, 1);
+  args[0] = obj;
+  if (argc == 1) args[1] = argv[0];
+  return rb_gsl_linalg_expm(argc + 1, args, rb_mGSL);
+}
+
+/*
+  exp(A t) v
+*/
+typedef struct {
+  const gsl_matrix *A;          /* dense A, or NULL */
+  const mygsl_csr *csr;         /* or sparse A */
+  size_t n;
+  double t;
+  const gsl_vector *v;
+  gsl_vector *F, *b, *y;
+} mygsl_expmv;
+
+static double expmv_norm_inf(const gsl_vector *x)
+{
+  size_t i;
+  double m = 0.0, a;
+  for (i = 0; i < x->size; i++) {
+    a = fabs(x->data[i*x->stride]);
+    if (a > m) m = a;
+  }
+  return m;
+}
+
+/* y = A x */
+static void expmv_apply(const mygsl_expmv *e, const gsl_vector *x, gsl_vector *y)
+{
+  if (e->A) gsl_blas_dgemv(CblasNoTrans, 1.0, e->A, x, 0.0, y);
+  else mygsl_csr_mul(e->csr, x, y);
+}
+
+/* The trace of A and the 1-norm of A - mu I for mu = trace/n */
+static int expmv_trace_norm(const mygsl_expmv *e, double *mu, double *norm)
+{
+  size_t n = e->n, i, j, k;
+  double *col, tr = 0.0;
+  col = (double *) calloc(n, sizeof(double));
+  if (col == NULL) return GSL_ENOMEM;
+  if (e->A) {
+    for (i = 0; i < n; i++) tr += e->A->data[i*e->A->tda + i];
+    *mu = tr/(double) n;
+    for (i = 0; i < n; i++)
+      for (j = 0; j < n; j++)
+	col[j] += fabs(e->A->data[i*e->A->tda + j] - (i == j ? *mu : 0.0));
+  } else {
+    const mygsl_csr *c = e->csr;
+    for (i = 0; i < n; i++)
+      if (c->diag[i] < c->rowptr[i+1]) tr += c->val[c->diag[i]];
+    *mu = tr/(double) n;
+    for (i = 0; i < n; i++) {
+      for (k = c->rowptr[i]; k < c->rowptr[i+1]; k++)
+	col[c->col[k]] += fabs(c->val[k] - (c->col[k] == i ? *mu : 0.0));
+      if (c->diag[i] == c->rowptr[i+1]) col[i] += fabs(*mu);
+    }
+  }
+  for (j = 0, *norm = 0.0; j < n; j++) if (col[j] > *norm) *norm = col[j];
+  free(col);
+  return GSL_SUCCESS;
+}
+
+static int expmv_run(void *data)
+{
+  mygsl_expmv *e = (mygsl_expmv *) data;
+  gsl_vector *F = e->F, *b = e->b, *y = e->y, *sw;
+  double mu, norm, eta, c1, c2, scale;
+  size_t s, i, j;
+  if (expmv_trace_norm(e, &mu, &norm)) GSL_ERROR("out of memory", GSL_ENOMEM);
+  norm *= fabs(e->t);
+  if (!gsl_finite(norm)) GSL_ERROR("matrix has non-finite elements", GSL_EDOM);
+  s = norm > EXPMV_STEP_NORM ? (size_t) ceil(norm/EXPMV_STEP_NORM) : 1;
+  eta = exp(mu*e->t/(double) s);
+  gsl_vector_memcpy(F, e->v);
+  for (i = 0; i < s; i++) {
+    gsl_vector_memcpy(b, F);
+    c1 = expmv_norm_inf(b);
+    for (j = 1; j <= EXPMV_MAX_TERMS; j++) {
+      /* b = t (A - mu I) b / (s j) */
+      expmv_apply(e, b, y);
+      gsl_blas_daxpy(-mu, b, y);
+      scale = e->t/((double) s*(double) j);
+      gsl_vector_scale(y, scale);
+      sw = b; b = y; y = sw;
+      c2 = expmv_norm_inf(b);
+      gsl_vector_add(F, b);
+      if (c1 + c2 <= GSL_DBL_EPSILON*0.5*expmv_norm_inf(F)) break;
+      c1 = c2;
+    }
+    gsl_vector_scale(F, eta);
+  }
+  return GSL_SUCCESS;
+}
+
+static gsl_vector* expmv_vector(size_t n, VALUE keep)
+{
+  gsl_vector *v = gsl_vector_alloc(n);
+  if (v == NULL) rb_raise(rb_eNoMemError, "gsl_vector_alloc failed");
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v));
+  return v;
+}
+
+/* GSL::Linalg.expmv(a, v, t = 1): exp(a t) v, a a Matrix or SpMatrix */
+static VALUE rb_gsl_linalg_expmv(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_expmv e;
+  VALUE keep = rb_ary_new(), vf;
+  size_t size2;
+  rb_check_arity(argc, 2, 3);
+  memset(&e, 0, sizeof(e));
+  if (MATRIX_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_matrix, e.A);
+    e.n = e.A->size1;
+    size2 = e.A->size2;
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  } else if (rb_gsl_spmatrix_p(argv[0])) {
+    gsl_spmatrix *m = rb_gsl_get_spmatrix(argv[0]);
+    mygsl_csr *c = mygsl_csr_from_spmatrix(m);
+    if (c == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, mygsl_csr_free, c));
+    e.csr = c;
+    e.n = m->size1;
+    size2 = m->size2;
+#endif
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix or GSL::SpMatrix expected)",
+	     rb_class2name(CLASS_OF(argv[0])));
+  }
+  if (e.n != size2) rb_raise(rb_eArgError, "matrix must be square");
+  if (e.n == 0) rb_raise(rb_eArgError, "empty matrix");
+  CHECK_VECTOR(argv[1]);
+  Data_Get_Struct(argv[1], gsl_vector, e.v);
+  if (e.v->size != e.n)
+    rb_raise(rb_eArgError, "vector of size %d for a %d x %d matrix",
+	     (int) e.v->size, (int) e.n, (int) e.n);
+  e.t = expm_time(argc, argv, 2);
+  e.b = expmv_vector(e.n, keep);
+  e.y = expmv_vector(e.n, keep);
+  e.F = gsl_vector_alloc(e.n);
+  vf = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, e.F);
+  rb_gsl_nogvl_call(expmv_run, &e, 30*e.n*(e.A ? e.n : 1));
+  RB_GC_GUARD(keep);
+  return vf;
+}
+
+static VALUE rb_gsl_matrix_expmv(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE args[3];
+  rb_check_arity(argc, 1, 2);
+  args[0] = obj;
+  args[1] = argv[0];
+  if (argc == 2) args[2] = argv[1];
+  return rb_gsl_linalg_expmv(argc + 1, args, rb_mGSL);
+}
+
+void Init_gsl_linalg_expm(VALUE module)
+{
+  rb_define_module_function(module, "expm", rb_gsl_linalg_expm, -1);
+  rb_define_module_function(module, "expmv", rb_gsl_linalg_expmv, -1);
+  rb_define_method(cgsl_matrix, "expm", rb_gsl_matrix_expm, -1);
+  rb_define_method(cgsl_matrix, "expmv", rb_gsl_matrix_expmv, -1);
+}
@@ -0,0 +1,1211 @@
+/*
+  linalg_factor.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Factorization objects that decompose a matrix once and solve against
+  it any number of times.
+
+    lu = GSL::Linalg::LU::Factorization.new(a)    # a is not modified
+    x = lu.solve(b)                                # b: Vector or Matrix
+    lu.solve(b2, x)                                # into an existing x
+
+    qr = GSL::Linalg::QR::Factorization.new(a)
+    x = qr.lssolve(b)                              # least squares, M >= N
+    ch = GSL::Linalg::Cholesky::Factorization.new(a)
+
+  Each object owns its factors, permutation and scratch vectors, so a
+  solve allocates at most its result, and nothing when the result is
+  given.  The decomposition runs with the GVL released.  A GSL::Matrix
+  right-hand side is solved column by column, the columns split over
+  GSL.parallel_threads threads from GSL.parallel_threshold elements of
+  work on; rb_gsl_linalg_solve_rhs() is shared with linalg_band.c.
+
+  A Cholesky::Factorization is updated in O(n^2) for A + v v^T
+  (#update!) and A - v v^T (#downdate!).  QR::Incremental keeps the
+  triangular factor R of a least-squares problem with the right-hand
+  side appended as a last column, [R z; 0 rho], so that adding or
+  removing an observation row is the same rank-1 update or downdate of
+  R^T, and #solve is a triangular solve.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_blas.h>
+
+static VALUE cgsl_linalg_LU_factor, cgsl_linalg_QR_factor;
+static VALUE cgsl_linalg_cholesky_factor, cgsl_linalg_QR_incremental;
+
+/***** Right-hand sides *****/
+
+struct linalg_rhs {
+  mygsl_solve_func solve1;
+  const void *fac;
+  const gsl_vector *b;
+  gsl_vector *x;
+  const gsl_matrix *B;
+  gsl_matrix *X;
+  size_t nthreads;
+};
+
+static int linalg_rhs_vector(void *data)
+{
+  struct linalg_rhs *r = (struct linalg_rhs *) data;
+  return (*r->solve1)(r->fac, r->b, r->x);
+}
+
+/* Columns k, k + nthreads, ... */
+static int linalg_rhs_worker(void *data, size_t k)
+{
+  struct linalg_rhs *r = (struct linalg_rhs *) data;
+  size_t j;
+  int status;
+  for (j = k; j < r->B->size2; j += r->nthreads) {
+    gsl_vector_const_view b = gsl_matrix_const_column(r->B, j);
+    gsl_vector_view x = gsl_matrix_column(r->X, j);
+    status = (*r->solve1)(r->fac, &b.vector, &x.vector);
+    if (status) return status;
+  }
+  return GSL_SUCCESS;
+}
+
+static int linalg_rhs_serial(void *data)
+{
+  return linalg_rhs_worker(data, 0);
+}
+
+/* Solves the n x n system for the vector or for each column of the
+   matrix vb, into vx or into a new object when vx is nil; work is the
+   cost of one right-hand side.  solve1 must not write to fac. */
+VALUE rb_gsl_linalg_solve_rhs(mygsl_solve_func solve1, const void *fac,
+			      size_t n, size_t work, VALUE vb, VALUE vx)
+{
+  struct linalg_rhs r;
+  gsl_vector *b = NULL, *x = NULL;
+  gsl_matrix *B = NULL, *X = NULL;
+  r.solve1 = solve1;
+  r.fac = fac;
+  if (MATRIX_P(vb)) {
+    Data_Get_Struct(vb, gsl_matrix, B);
+    if (B->size1 != n)
+      rb_raise(rb_eArgError, "right-hand sides have %d rows, system is %d x %d",
+	       (int) B->size1, (int) n, (int) n);
+    if (NIL_P(vx)) {
+      X = gsl_matrix_alloc(n, B->size2);
+      vx = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, X);
+    } else {
+      CHECK_MATRIX(vx);
+      Data_Get_Struct(vx, gsl_matrix, X);
+      if (X->size1 != n || X->size2 != B->size2)
+	rb_raise(rb_eArgError, "solution matrix must be %d x %d",
+		 (int) n, (int) B->size2);
+      if (X == B) rb_raise(rb_eArgError, "solution matrix must differ from b");
+    }
+    r.B = B;
+    r.X = X;
+    r.nthreads = rb_gsl_parallel_nthreads(work*B->size2, B->size2);
+    if (r.nthreads > 1) rb_gsl_nogvl_parallel(linalg_rhs_worker, &r, r.nthreads);
+    else rb_gsl_nogvl_call(linalg_rhs_serial, &r, work*B->size2);
+    return vx;
+  }
+  CHECK_VECTOR(vb);
+  Data_Get_Struct(vb, gsl_vector, b);
+  if (b->size != n)
+    rb_raise(rb_eArgError, "right-hand side has %d elements, system is %d x %d",
+	     (int) b->size, (int) n, (int) n);
+  if (NIL_P(vx)) {
+    x = gsl_vector_alloc(n);
+    vx = Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, x);
+  } else {
+    CHECK_VECTOR(vx);
+    Data_Get_Struct(vx, gsl_vector, x);
+    if (x->size != n)
+      rb_raise(rb_eArgError, "solution vector must have %d elements", (int) n);
+    if (x == b) rb_raise(rb_eArgError, "solution vector must differ from b");
+  }
+  r.b = b;
+  r.x = x;
+  rb_gsl_nogvl_call(linalg_rhs_vector, &r, work);
+  return vx;
+}
+
+static VALUE rb_gsl_factor_check_square(VALUE vm, gsl_matrix **A)
+{
+  CHECK_MATRIX(vm);
+  Data_Get_Struct(vm, gsl_matrix, *A);
+  if ((*A)->size1 != (*A)->size2)
+    rb_raise(rb_eArgError, "matrix must be square (%d x %d)",
+	     (int) (*A)->size1, (int) (*A)->size2);
+  return vm;
+}
+
+/***** LU *****/
+
+/*
+  With :precision => :mixed, A is factorized in single precision
+  (gsl_matrix_float, blocked right-looking LU, the trailing updates
+  split by rows over threads), and each solve is refined to double
+  accuracy against the original A as in LAPACK dsgesv:
+
+    x = LU32 \ b;  repeat r = b - A x; x += LU32 \ r
+    until |r|inf <= |x|inf |A|inf eps sqrt(n)
+
+  A is kept by reference for the residuals and must not be changed.
+  When refinement does not converge in :max_refine steps (30), or A
+  does not fit in single precision, the factorization falls back to
+  double for good.
+*/
+
+#define LU32_BLOCK 64
+
+typedef struct {
+  gsl_matrix *lu;           /* double factors, NULL while mixed */
+  gsl_permutation *p;
+  int signum;
+  gsl_vector *work;         /* residual for refine */
+  gsl_matrix_float *lu32;   /* single factors, NULL unless mixed */
+  VALUE vA;                 /* the original A, while mixed */
+  const gsl_matrix *A;
+  double anrm;              /* |A|inf */
+  size_t n, max_refine, iter;
+  int singular32, failed, record;
+} mygsl_LU_factor;
+
+static void mygsl_LU_factor_mark(mygsl_LU_factor *f)
+{
+  rb_gc_mark(f->vA);
+}
+
+static void mygsl_LU_factor_free(mygsl_LU_factor *f)
+{
+  if (f->lu) gsl_matrix_free(f->lu);
+  if (f->p) gsl_permutation_free(f->p);
+  if (f->work) gsl_vector_free(f->work);
+  if (f->lu32) gsl_matrix_float_free(f->lu32);
+  free(f);
+}
+
+static int LU_factor_decomp(void *data)
+{
+  mygsl_LU_factor *f = (mygsl_LU_factor *) data;
+  return gsl_linalg_LU_decomp(f->lu, f->p, &f->signum);
+}
+
+static int LU_factor_solve1(const void *fac, const gsl_vector *b, gsl_vector *x)
+{
+  const mygsl_LU_factor *f = (const mygsl_LU_factor *) fac;
+  return gsl_linalg_LU_solve(f->lu, f->p, b, x);
+}
+
+struct LU32_task {
+  mygsl_LU_factor *f;
+  size_t kb, ke;            /* the panel columns */
+  size_t nthreads;
+};
+
+/* Panel kb ... ke - 1: pivoting with whole-row swaps, then
+   U12 = L11^-1 A12 */
+static int LU32_panel(void *data)
+{
+  struct LU32_task *t = (struct LU32_task *) data;
+  gsl_matrix_float *A = t->f->lu32;
+  size_t n = A->size1, tda = A->tda, i, j, k, p;
+  float *a = A->data, *ri, *rk, piv, l, tmp;
+  for (k = t->kb; k < t->ke; k++) {
+    p = k;
+    for (i = k + 1; i < n; i++)
+      if (fabsf(a[i*tda + k]) > fabsf(a[p*tda + k])) p = i;
+    if (p != k) {
+      ri = a + p*tda; rk = a + k*tda;
+      for (j = 0; j < n; j++) { tmp = ri[j]; ri[j] = rk[j]; rk[j] = tmp; }
+      gsl_permutation_swap(t->f->p, k, p);
+      t->f->signum = -t->f->signum;
+    }
+    piv = a[k*tda + k];
+    if (piv == 0.0f) {
+      t->f->singular32 = 1;
+      continue;
+    }
+    rk = a + k*tda;
+    for (i = k + 1; i < n; i++) {
+      ri = a + i*tda;
+      l = ri[k] /= piv;
+      for (j = k + 1; j < t->ke; j++) ri[j] -= l*rk[j];
+    }
+  }
+  for (i = t->kb + 1; i < t->ke; i++) {
+    ri = a + i*tda;
+    for (k = t->kb; k < i; k++) {
+      l = ri[k];
+      rk = a + k*tda;
+      for (j = t->ke; j < n; j++) ri[j] -= l*rk[j];
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/* A22 -= L21 U12, rows split in contiguous ranges */
+static int LU32_update(void *data, size_t w)
+{
+  struct LU32_task *t = (struct LU32_task *) data;
+  gsl_matrix_float *A = t->f->lu32;
+  size_t n = A->size1, tda = A->tda, m = n - t->ke, i, j, k;
+  size_t i0 = t->ke + m*w/t->nthreads, i1 = t->ke + m*(w + 1)/t->nthreads;
+  float *a = A->data, *ri, *rk, l;
+  for (i = i0; i < i1; i++) {
+    ri = a + i*tda;
+    for (k = t->kb; k < t->ke; k++) {
+      l = ri[k];
+      rk = a + k*tda;
+      for (j = t->ke; j < n; j++) ri[j] -= l*rk[j];
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static int LU32_update_serial(void *data)
+{
+  return LU32_update(data, 0);
+}
+
+static void LU32_decomp(mygsl_LU_factor *f)
+{
+  struct LU32_task t;
+  size_t n = f->n, m;
+  t.f = f;
+  for (t.kb = 0; t.kb < n; t.kb += LU32_BLOCK) {
+    t.ke = GSL_MIN(t.kb + LU32_BLOCK, n);
+    rb_gsl_nogvl_call(LU32_panel, &t, (n - t.kb)*LU32_BLOCK*LU32_BLOCK);
+    m = n - t.ke;
+    if (m == 0) break;
+    t.nthreads = rb_gsl_parallel_nthreads(m*m*LU32_BLOCK, m);
+    if (t.nthreads > 1) rb_gsl_nogvl_parallel(LU32_update, &t, t.nthreads);
+    else {
+      t.nthreads = 1;
+      rb_gsl_nogvl_call(LU32_update_serial, &t, m*m*LU32_BLOCK);
+    }
+  }
+}
+
+/* x = LU32 \ b, accumulating in double */
+static void LU32_solve(const mygsl_LU_factor *f, const gsl_vector *b, gsl_vector *x)
+{
+  const gsl_matrix_float *A = f->lu32;
+  size_t n = f->n, i, j;
+  const float *ri;
+  double s;
+  for (i = 0; i < n; i++) {
+    s = gsl_vector_get(b, gsl_permutation_get(f->p, i));
+    ri = A->data + i*A->tda;
+    for (j = 0; j < i; j++) s -= ri[j]*gsl_vector_get(x, j);
+    gsl_vector_set(x, i, s);
+  }
+  for (i = n; i-- > 0;) {
+    s = gsl_vector_get(x, i);
+    ri = A->data + i*A->tda;
+    for (j = i + 1; j < n; j++) s -= ri[j]*gsl_vector_get(x, j);
+    gsl_vector_set(x, i, s/ri[i]);
+  }
+}
+
+/* Refined solve.  fac is written to: f->failed is set, rather than
+   raising in the middle of a multi-column solve, when refinement does
+   not converge, and f->iter is recorded for a single right-hand side. */
+static int LU_factor_solve1_mixed(const void *fac, const gsl_vector *b, gsl_vector *x)
+{
+  mygsl_LU_factor *f = (mygsl_LU_factor *) fac;
+  gsl_vector *r, *d;
+  size_t it, n = f->n;
+  double cte = f->anrm*GSL_DBL_EPSILON*sqrt((double) n), rn, xn;
+  int converged = 0;
+  r = gsl_vector_alloc(n);
+  d = gsl_vector_alloc(n);
+  if (r == NULL || d == NULL) {
+    if (r) gsl_vector_free(r);
+    GSL_ERROR("failed to allocate refinement vectors", GSL_ENOMEM);
+  }
+  LU32_solve(f, b, x);
+  for (it = 0; ; it++) {
+    gsl_vector_memcpy(r, b);
+    gsl_blas_dgemv(CblasNoTrans, -1.0, f->A, x, 1.0, r);
+    rn = fabs(gsl_vector_get(r, gsl_blas_idamax(r)));
+    xn = fabs(gsl_vector_get(x, gsl_blas_idamax(x)));
+    if (rn <= xn*cte) {
+      converged = 1;
+      break;
+    }
+    if (it == f->max_refine || gsl_isnan(rn)) break;
+    LU32_solve(f, r, d);
+    gsl_vector_add(x, d);
+  }
+  if (f->record) f->iter = it;
+  if (!converged) f->failed = 1;
+  gsl_vector_free(r);
+  gsl_vector_free(d);
+  return GSL_SUCCESS;
+}
+
+/* Gives up single precision: factorizes the original A in double */
+static void LU_factor_to_double(mygsl_LU_factor *f)
+{
+  f->lu = make_matrix_clone(f->A);
+  rb_gsl_nogvl_call(LU_factor_decomp, f, f->n*f->n*f->n);
+  if (f->lu32) gsl_matrix_float_free(f->lu32);
+  f->lu32 = NULL;
+  f->A = NULL;
+  f->vA = Qnil;
+}
+
+static VALUE LU_factor_solve_rhs(mygsl_LU_factor *f, VALUE vb, VALUE vx)
+{
+  size_t n = f->n;
+  if (f->lu32) {
+    f->failed = 0;
+    f->record = !MATRIX_P(vb);
+    vx = rb_gsl_linalg_solve_rhs(LU_factor_solve1_mixed, f, n, 4*n*n, vb, vx);
+    f->record = 0;
+    if (!f->failed) return vx;
+    LU_factor_to_double(f);
+  }
+  return rb_gsl_linalg_solve_rhs(LU_factor_solve1, f, n, n*n, vb, vx);
+}
+
+/* new(a[, opts]); opts :precision => :double (default) or :mixed, and
+   :max_refine */
+static VALUE rb_gsl_LU_factor_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_LU_factor *f = NULL;
+  gsl_matrix *A = NULL;
+  VALUE obj, opts = Qnil, v;
+  size_t i, j, n;
+  double s, amax = 0.0;
+  int mixed = 0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  rb_gsl_factor_check_square(argv[0], &A);
+  obj = Data_Make_Struct(klass, mygsl_LU_factor, mygsl_LU_factor_mark,
+			 mygsl_LU_factor_free, f);
+  n = A->size1;
+  f->n = n;
+  f->vA = Qnil;
+  f->max_refine = 30;
+  if (argc == 2) {
+    opts = argv[1];
+    Check_Type(opts, T_HASH);
+    v = rb_hash_aref(opts, ID2SYM(rb_intern("precision")));
+    if (!NIL_P(v)) {
+      if (v == ID2SYM(rb_intern("mixed"))) mixed = 1;
+      else if (v != ID2SYM(rb_intern("double")))
+	rb_raise(rb_eArgError, "precision must be :double or :mixed");
+    }
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_refine")))))
+      f->max_refine = NUM2SIZET(v);
+  }
+  f->p = gsl_permutation_alloc(n);
+  f->work = gsl_vector_alloc(n);
+  if (!mixed) {
+    f->lu = make_matrix_clone(A);
+    rb_gsl_nogvl_call(LU_factor_decomp, f, n*n*n);
+    return obj;
+  }
+  f->vA = argv[0];
+  f->A = A;
+  for (i = 0; i < n; i++) {
+    s = 0.0;
+    for (j = 0; j < n; j++) {
+      s += fabs(gsl_matrix_get(A, i, j));
+      amax = GSL_MAX(amax, fabs(gsl_matrix_get(A, i, j)));
+    }
+    f->anrm = GSL_MAX(f->anrm, s);
+  }
+  if (amax > GSL_FLT_MAX) {
+    LU_factor_to_double(f);
+    return obj;
+  }
+  f->lu32 = gsl_matrix_float_alloc(n, n);
+  for (i = 0; i < n; i++)
+    for (j = 0; j < n; j++)
+      gsl_matrix_float_set(f->lu32, i, j, (float) gsl_matrix_get(A, i, j));
+  gsl_permutation_init(f->p);
+  f->signum = 1;
+  LU32_decomp(f);
+  if (f->singular32) LU_factor_to_double(f);
+  return obj;
+}
+
+static mygsl_LU_factor* rb_gsl_LU_factor_get(VALUE obj)
+{
+  mygsl_LU_factor *f = NULL;
+  Data_Get_Struct(obj, mygsl_LU_factor, f);
+  return f;
+}
+
+static VALUE rb_gsl_LU_factor_size(VALUE obj)
+{
+  return INT2FIX(rb_gsl_LU_factor_get(obj)->n);
+}
+
+/* :mixed until a solve has fallen back to :double */
+static VALUE rb_gsl_LU_factor_precision(VALUE obj)
+{
+  return ID2SYM(rb_intern(rb_gsl_LU_factor_get(obj)->lu32 ? "mixed" : "double"));
+}
+
+/* Refinement steps of the last mixed solve of a Vector */
+static VALUE rb_gsl_LU_factor_refine_iter(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_LU_factor_get(obj)->iter);
+}
+
+/* Copies, so that the cached factors cannot be changed from Ruby */
+static VALUE rb_gsl_LU_factor_matrix(VALUE obj)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  gsl_matrix *m;
+  size_t i, j;
+  if (f->lu) return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+				     make_matrix_clone(f->lu));
+  m = gsl_matrix_alloc(f->n, f->n);
+  for (i = 0; i < f->n; i++)
+    for (j = 0; j < f->n; j++) gsl_matrix_set(m, i, j, gsl_matrix_float_get(f->lu32, i, j));
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static VALUE rb_gsl_LU_factor_perm(VALUE obj)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  gsl_permutation *p = gsl_permutation_alloc(f->p->size);
+  gsl_permutation_memcpy(p, f->p);
+  return Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
+}
+
+static VALUE rb_gsl_LU_factor_signum(VALUE obj)
+{
+  return INT2FIX(rb_gsl_LU_factor_get(obj)->signum);
+}
+
+static VALUE rb_gsl_LU_factor_solve(int argc, VALUE *argv, VALUE obj)
+{
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  return LU_factor_solve_rhs(rb_gsl_LU_factor_get(obj), argv[0],
+			     argc == 2 ? argv[1] : Qnil);
+}
+
+/* refine(a, b, x): one step of iterative refinement of x, in place */
+static VALUE rb_gsl_LU_factor_refine(VALUE obj, VALUE vm, VALUE vb, VALUE vx)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  gsl_matrix *A = NULL;
+  gsl_vector *b = NULL, *x = NULL, *d;
+  CHECK_MATRIX(vm); CHECK_VECTOR(vb); CHECK_VECTOR(vx);
+  Data_Get_Struct(vm, gsl_matrix, A);
+  Data_Get_Struct(vb, gsl_vector, b);
+  Data_Get_Struct(vx, gsl_vector, x);
+  if (A->size1 != f->n || A->size2 != f->n)
+    rb_raise(rb_eArgError, "matrix must be %d x %d", (int) f->n, (int) f->n);
+  if (b->size != f->n || x->size != f->n)
+    rb_raise(rb_eArgError, "b and x must have %d elements", (int) f->n);
+  if (f->lu) {
+    gsl_linalg_LU_refine(A, f->lu, f->p, b, x, f->work);
+    return vx;
+  }
+  gsl_vector_memcpy(f->work, b);
+  gsl_blas_dgemv(CblasNoTrans, -1.0, A, x, 1.0, f->work);
+  d = gsl_vector_alloc(f->n);
+  LU32_solve(f, f->work, d);
+  gsl_vector_add(x, d);
+  gsl_vector_free(d);
+  return vx;
+}
+
+static VALUE rb_gsl_LU_factor_invert(VALUE obj)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  gsl_matrix *inv, *id;
+  VALUE vinv, vid;
+  if (f->lu32) {
+    id = gsl_matrix_alloc(f->n, f->n);
+    gsl_matrix_set_identity(id);
+    vid = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, id);
+    vinv = LU_factor_solve_rhs(f, vid, Qnil);
+    RB_GC_GUARD(vid);
+    return vinv;
+  }
+  inv = gsl_matrix_alloc(f->n, f->n);
+  vinv = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, inv);
+  gsl_linalg_LU_invert(f->lu, f->p, inv);
+  return vinv;
+}
+
+static double LU_factor_diag(const mygsl_LU_factor *f, size_t i)
+{
+  return f->lu ? gsl_matrix_get(f->lu, i, i) : gsl_matrix_float_get(f->lu32, i, i);
+}
+
+static VALUE rb_gsl_LU_factor_det(VALUE obj)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  double d = f->signum;
+  size_t i;
+  if (f->lu) return rb_float_new(gsl_linalg_LU_det(f->lu, f->signum));
+  for (i = 0; i < f->n; i++) d *= LU_factor_diag(f, i);
+  return rb_float_new(d);
+}
+
+static VALUE rb_gsl_LU_factor_lndet(VALUE obj)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  double s = 0.0;
+  size_t i;
+  if (f->lu) return rb_float_new(gsl_linalg_LU_lndet(f->lu));
+  for (i = 0; i < f->n; i++) s += log(fabs(LU_factor_diag(f, i)));
+  return rb_float_new(s);
+}
+
+static VALUE rb_gsl_LU_factor_sgndet(VALUE obj)
+{
+  mygsl_LU_factor *f = rb_gsl_LU_factor_get(obj);
+  int sgn = f->signum;
+  size_t i;
+  if (f->lu) return INT2FIX(gsl_linalg_LU_sgndet(f->lu, f->signum));
+  for (i = 0; i < f->n; i++) {
+    if (LU_factor_diag(f, i) < 0.0) sgn = -sgn;
+    else if (LU_factor_diag(f, i) == 0.0) return INT2FIX(0);
+  }
+  return INT2FIX(sgn);
+}
+
+/***** QR *****/
+
+typedef struct {
+  gsl_matrix *qr;          /* M x N, M >= N */
+  gsl_vector *tau;
+  gsl_vector *residual;    /* of the last lssolve of a vector */
+} mygsl_QR_factor;
+
+static void mygsl_QR_factor_free(mygsl_QR_factor *f)
+{
+  if (f->qr) gsl_matrix_free(f->qr);
+  if (f->tau) gsl_vector_free(f->tau);
+  if (f->residual) gsl_vector_free(f->residual);
+  free(f);
+}
+
+static int QR_factor_decomp(void *data)
+{
+  mygsl_QR_factor *f = (mygsl_QR_factor *) data;
+  return gsl_linalg_QR_decomp(f->qr, f->tau);
+}
+
+static int QR_factor_solve1(const void *fac, const gsl_vector *b, gsl_vector *x)
+{
+  const mygsl_QR_factor *f = (const mygsl_QR_factor *) fac;
+  return gsl_linalg_QR_solve(f->qr, f->tau, b, x);
+}
+
+struct QR_lssolve_data {
+  mygsl_QR_factor *f;
+  const gsl_vector *b;
+  gsl_vector *x;
+  const gsl_matrix *B;
+  gsl_matrix *X;
+};
+
+/* Serial: every column goes through the one cached residual */
+static int QR_factor_lssolve_run(void *data)
+{
+  struct QR_lssolve_data *d = (struct QR_lssolve_data *) data;
+  size_t j;
+  int status;
+  if (d->B == NULL)
+    return gsl_linalg_QR_lssolve(d->f->qr, d->f->tau, d->b, d->x, d->f->residual);
+  for (j = 0; j < d->B->size2; j++) {
+    gsl_vector_const_view b = gsl_matrix_const_column(d->B, j);
+    gsl_vector_view x = gsl_matrix_column(d->X, j);
+    status = gsl_linalg_QR_lssolve(d->f->qr, d->f->tau, &b.vector, &x.vector,
+				   d->f->residual);
+    if (status) return status;
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_QR_factor_new(VALUE klass, VALUE vm)
+{
+  mygsl_QR_factor *f = NULL;
+  gsl_matrix *A = NULL;
+  VALUE obj;
+  CHECK_MATRIX(vm);
+  Data_Get_Struct(vm, gsl_matrix, A);
+  if (A->size1 < A->size2)
+    rb_raise(rb_eArgError, "matrix must have at least as many rows as columns"
+	     " (%d x %d)", (int) A->size1, (int) A->size2);
+  obj = Data_Make_Struct(klass, mygsl_QR_factor, 0, mygsl_QR_factor_free, f);
+  f->qr = make_matrix_clone(A);
+  f->tau = gsl_vector_alloc(A->size2);
+  f->residual = gsl_vector_calloc(A->size1);
+  rb_gsl_nogvl_call(QR_factor_decomp, f, A->size1*A->size2*A->size2);
+  return obj;
+}
+
+static mygsl_QR_factor* rb_gsl_QR_factor_get(VALUE obj)
+{
+  mygsl_QR_factor *f = NULL;
+  Data_Get_Struct(obj, mygsl_QR_factor, f);
+  return f;
+}
+
+static VALUE rb_gsl_QR_factor_shape(VALUE obj)
+{
+  mygsl_QR_factor *f = rb_gsl_QR_factor_get(obj);
+  return rb_ary_new3(2, INT2FIX(f->qr->size1), INT2FIX(f->qr->size2));
+}
+
+static VALUE rb_gsl_QR_factor_matrix(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+			  make_matrix_clone(rb_gsl_QR_factor_get(obj)->qr));
+}
+
+static VALUE rb_gsl_QR_factor_tau(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free,
+			  make_vector_clone(rb_gsl_QR_factor_get(obj)->tau));
+}
+
+static VALUE rb_gsl_QR_factor_residual(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free,
+			  make_vector_clone(rb_gsl_QR_factor_get(obj)->residual));
+}
+
+static VALUE rb_gsl_QR_factor_solve(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_QR_factor *f = rb_gsl_QR_factor_get(obj);
+  size_t n = f->qr->size2;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  if (f->qr->size1 != n)
+    rb_raise(rb_eArgError, "solve needs a square system, use lssolve");
+  return rb_gsl_linalg_solve_rhs(QR_factor_solve1, f, n, 2*n*n, argv[0],
+				 argc == 2 ? argv[1] : Qnil);
+}
+
+/* lssolve(b[, x]): least-squares solution; the residual of a vector
+   right-hand side is kept and returned by #residual */
+static VALUE rb_gsl_QR_factor_lssolve(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_QR_factor *f = rb_gsl_QR_factor_get(obj);
+  struct QR_lssolve_data d;
+  size_t m = f->qr->size1, n = f->qr->size2, ncols = 1;
+  gsl_vector *b = NULL, *x = NULL;
+  gsl_matrix *B = NULL, *X = NULL;
+  VALUE vx;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  vx = argc == 2 ? argv[1] : Qnil;
+  d.f = f;
+  d.b = NULL; d.x = NULL; d.B = NULL; d.X = NULL;
+  if (MATRIX_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_matrix, B);
+    if (B->size1 != m)
+      rb_raise(rb_eArgError, "right-hand sides have %d rows, system is %d x %d",
+	       (int) B->size1, (int) m, (int) n);
+    if (NIL_P(vx)) {
+      X = gsl_matrix_alloc(n, B->size2);
+      vx = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, X);
+    } else {
+      CHECK_MATRIX(vx);
+      Data_Get_Struct(vx, gsl_matrix, X);
+      if (X->size1 != n || X->size2 != B->size2)
+	rb_raise(rb_eArgError, "solution matrix must be %d x %d",
+		 (int) n, (int) B->size2);
+    }
+    d.B = B; d.X = X;
+    ncols = B->size2;
+  } else {
+    CHECK_VECTOR(argv[0]);
+    Data_Get_Struct(argv[0], gsl_vector, b);
+    if (b->size != m)
+      rb_raise(rb_eArgError, "right-hand side has %d elements, system is %d x %d",
+	       (int) b->size, (int) m, (int) n);
+    if (NIL_P(vx)) {
+      x = gsl_vector_alloc(n);
+      vx = Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, x);
+    } else {
+      CHECK_VECTOR(vx);
+      Data_Get_Struct(vx, gsl_vector, x);
+      if (x->size != n)
+	rb_raise(rb_eArgError, "solution vector must have %d elements", (int) n);
+    }
+    d.b = b; d.x = x;
+  }
+  rb_gsl_nogvl_call(QR_factor_lssolve_run, &d, 2*m*n*ncols);
+  return vx;
+}
+
+/***** Rank-1 updates *****/
+
+/* L L^T + v v^T, on the lower triangle of L, by Givens rotations; v is
+   overwritten.  L may start out zero. */
+int mygsl_linalg_cholesky_update(gsl_matrix *L, gsl_vector *v)
+{
+  size_t n = L->size1, i, k;
+  double a, b, r, c, s, t;
+  if (v->size != n) GSL_ERROR("vector length must match the factor", GSL_EBADLEN);
+  for (k = 0; k < n; k++) {
+    a = gsl_matrix_get(L, k, k);
+    b = gsl_vector_get(v, k);
+    r = hypot(a, b);
+    if (r == 0.0) continue;
+    c = a/r;
+    s = b/r;
+    gsl_matrix_set(L, k, k, r);
+    for (i = k + 1; i < n; i++) {
+      t = gsl_matrix_get(L, i, k);
+      gsl_matrix_set(L, i, k, c*t + s*gsl_vector_get(v, i));
+      gsl_vector_set(v, i, c*gsl_vector_get(v, i) - s*t);
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/* L L^T - v v^T as in LINPACK dchdd: p = L^-1 v must have norm below
+   1, otherwise L is left untouched and GSL_EDOM is returned.  work
+   holds 3n elements. */
+int mygsl_linalg_cholesky_downdate(gsl_matrix *L, const gsl_vector *v,
+				   gsl_vector *work)
+{
+  size_t n = L->size1, i, j, k;
+  double *p, *c, *s, t, xx, nrm2 = 0.0, alpha, scale, a, b, h;
+  if (v->size != n) GSL_ERROR("vector length must match the factor", GSL_EBADLEN);
+  if (work->size < 3*n || work->stride != 1)
+    GSL_ERROR("workspace must hold 3n contiguous elements", GSL_EBADLEN);
+  p = work->data;
+  c = p + n;
+  s = c + n;
+  for (k = 0; k < n; k++) {
+    t = gsl_vector_get(v, k);
+    for (j = 0; j < k; j++) t -= gsl_matrix_get(L, k, j)*p[j];
+    if (gsl_matrix_get(L, k, k) == 0.0)
+      GSL_ERROR("factor is singular", GSL_EDOM);
+    p[k] = t/gsl_matrix_get(L, k, k);
+    nrm2 += p[k]*p[k];
+  }
+  if (nrm2 >= 1.0)
+    GSL_ERROR("downdated matrix is not positive definite", GSL_EDOM);
+  alpha = sqrt(1.0 - nrm2);
+  for (i = n; i-- > 0;) {
+    scale = alpha + fabs(p[i]);
+    a = alpha/scale;
+    b = p[i]/scale;
+    h = hypot(a, b);
+    c[i] = a/h;
+    s[i] = b/h;
+    alpha = scale*h;
+  }
+  for (j = 0; j < n; j++) {
+    xx = 0.0;
+    for (i = j + 1; i-- > 0;) {
+      t = c[i]*xx + s[i]*gsl_matrix_get(L, j, i);
+      gsl_matrix_set(L, j, i, c[i]*gsl_matrix_get(L, j, i) - s[i]*xx);
+      xx = t;
+    }
+  }
+  for (j = 0; j < n; j++) {
+    if (gsl_matrix_get(L, j, j) >= 0.0) continue;
+    for (i = j; i < n; i++) gsl_matrix_set(L, i, j, -gsl_matrix_get(L, i, j));
+  }
+  return GSL_SUCCESS;
+}
+
+/***** Cholesky *****/
+
+typedef struct {
+  gsl_matrix *llt;
+  gsl_vector *v;      /* copy of the update vector */
+  gsl_vector *work;   /* 3n, for downdates */
+} mygsl_cholesky_factor;
+
+static void mygsl_cholesky_factor_free(mygsl_cholesky_factor *f)
+{
+  if (f->llt) gsl_matrix_free(f->llt);
+  if (f->v) gsl_vector_free(f->v);
+  if (f->work) gsl_vector_free(f->work);
+  free(f);
+}
+
+/* gsl_linalg_cholesky_decomp() leaves L^T in the upper triangle, which
+   older cholesky_solve()s read; keep it so after an update */
+static void cholesky_factor_mirror(gsl_matrix *llt)
+{
+  size_t i, j;
+  for (i = 0; i < llt->size1; i++)
+    for (j = 0; j < i; j++) gsl_matrix_set(llt, j, i, gsl_matrix_get(llt, i, j));
+}
+
+static int cholesky_factor_update(void *data)
+{
+  mygsl_cholesky_factor *f = (mygsl_cholesky_factor *) data;
+  int status = mygsl_linalg_cholesky_update(f->llt, f->v);
+  cholesky_factor_mirror(f->llt);
+  return status;
+}
+
+static int cholesky_factor_downdate(void *data)
+{
+  mygsl_cholesky_factor *f = (mygsl_cholesky_factor *) data;
+  int status = mygsl_linalg_cholesky_downdate(f->llt, f->v, f->work);
+  if (status) return status;
+  cholesky_factor_mirror(f->llt);
+  return GSL_SUCCESS;
+}
+
+static int cholesky_factor_decomp(void *data)
+{
+  mygsl_cholesky_factor *f = (mygsl_cholesky_factor *) data;
+  return gsl_linalg_cholesky_decomp(f->llt);
+}
+
+static int cholesky_factor_solve1(const void *fac, const gsl_vector *b, gsl_vector *x)
+{
+  const mygsl_cholesky_factor *f = (const mygsl_cholesky_factor *) fac;
+  return gsl_linalg_cholesky_solve(f->llt, b, x);
+}
+
+static VALUE rb_gsl_cholesky_factor_new(VALUE klass, VALUE vm)
+{
+  mygsl_cholesky_factor *f = NULL;
+  gsl_matrix *A = NULL;
+  VALUE obj;
+  rb_gsl_factor_check_square(vm, &A);
+  obj = Data_Make_Struct(klass, mygsl_cholesky_factor, 0,
+			 mygsl_cholesky_factor_free, f);
+  f->llt = make_matrix_clone(A);
+  f->v = gsl_vector_alloc(A->size1);
+  f->work = gsl_vector_alloc(3*A->size1);
+  rb_gsl_nogvl_call(cholesky_factor_decomp, f, A->size1*A->size1*A->size1/3);
+  return obj;
+}
+
+static mygsl_cholesky_factor* rb_gsl_cholesky_factor_get(VALUE obj)
+{
+  mygsl_cholesky_factor *f = NULL;
+  Data_Get_Struct(obj, mygsl_cholesky_factor, f);
+  return f;
+}
+
+static VALUE rb_gsl_cholesky_factor_size(VALUE obj)
+{
+  return INT2FIX(rb_gsl_cholesky_factor_get(obj)->llt->size1);
+}
+
+static VALUE rb_gsl_cholesky_factor_matrix(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+			  make_matrix_clone(rb_gsl_cholesky_factor_get(obj)->llt));
+}
+
+static VALUE rb_gsl_cholesky_factor_solve(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_cholesky_factor *f = rb_gsl_cholesky_factor_get(obj);
+  size_t n = f->llt->size1;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  return rb_gsl_linalg_solve_rhs(cholesky_factor_solve1, f, n, 2*n*n, argv[0],
+				 argc == 2 ? argv[1] : Qnil);
+}
+
+static VALUE rb_gsl_cholesky_factor_rank1(VALUE obj, VALUE vv, int (*func)(void *))
+{
+  mygsl_cholesky_factor *f = rb_gsl_cholesky_factor_get(obj);
+  gsl_vector *v = NULL;
+  size_t n = f->llt->size1;
+  CHECK_VECTOR(vv);
+  Data_Get_Struct(vv, gsl_vector, v);
+  if (v->size != n)
+    rb_raise(rb_eArgError, "vector must have %d elements", (int) n);
+  gsl_vector_memcpy(f->v, v);
+  rb_gsl_nogvl_call(func, f, 2*n*n);
+  return obj;
+}
+
+/* update!(v): the factorization of A + v v^T */
+static VALUE rb_gsl_cholesky_factor_update(VALUE obj, VALUE vv)
+{
+  return rb_gsl_cholesky_factor_rank1(obj, vv, cholesky_factor_update);
+}
+
+/* downdate!(v): the factorization of A - v v^T, which must stay
+   positive definite; the factorization is unchanged when it does not */
+static VALUE rb_gsl_cholesky_factor_downdate(VALUE obj, VALUE vv)
+{
+  return rb_gsl_cholesky_factor_rank1(obj, vv, cholesky_factor_downdate);
+}
+
+/* log(det A) = 2 sum log L(i, i) */
+static VALUE rb_gsl_cholesky_factor_lndet(VALUE obj)
+{
+  mygsl_cholesky_factor *f = rb_gsl_cholesky_factor_get(obj);
+  size_t i;
+  double s = 0.0;
+  for (i = 0; i < f->llt->size1; i++) s += log(gsl_matrix_get(f->llt, i, i));
+  return rb_float_new(2.0*s);
+}
+
+static VALUE rb_gsl_cholesky_factor_det(VALUE obj)
+{
+  return rb_float_new(exp(NUM2DBL(rb_gsl_cholesky_factor_lndet(obj))));
+}
+
+/***** Incremental QR *****/
+
+typedef struct {
+  size_t n, nrows;
+  gsl_matrix *l;      /* (n + 1) x (n + 1), [R z; 0 rho]^T on the lower triangle */
+  gsl_vector *row;    /* [a; y] */
+  gsl_vector *work;   /* 3(n + 1), for deletions */
+} mygsl_QR_incremental;
+
+static void mygsl_QR_incremental_free(mygsl_QR_incremental *q)
+{
+  if (q->l) gsl_matrix_free(q->l);
+  if (q->row) gsl_vector_free(q->row);
+  if (q->work) gsl_vector_free(q->work);
+  free(q);
+}
+
+static VALUE rb_gsl_QR_incremental_new(VALUE klass, VALUE nn)
+{
+  mygsl_QR_incremental *q = NULL;
+  VALUE obj;
+  size_t n;
+  CHECK_FIXNUM(nn);
+  if (FIX2INT(nn) <= 0) rb_raise(rb_eArgError, "number of unknowns must be positive");
+  n = FIX2INT(nn);
+  obj = Data_Make_Struct(klass, mygsl_QR_incremental, 0, mygsl_QR_incremental_free, q);
+  q->n = n;
+  q->nrows = 0;
+  q->l = gsl_matrix_calloc(n + 1, n + 1);
+  q->row = gsl_vector_alloc(n + 1);
+  q->work = gsl_vector_alloc(3*(n + 1));
+  return obj;
+}
+
+static mygsl_QR_incremental* rb_gsl_QR_incremental_get(VALUE obj)
+{
+  mygsl_QR_incremental *q = NULL;
+  Data_Get_Struct(obj, mygsl_QR_incremental, q);
+  return q;
+}
+
+static int QR_incremental_add(void *data)
+{
+  mygsl_QR_incremental *q = (mygsl_QR_incremental *) data;
+  return mygsl_linalg_cholesky_update(q->l, q->row);
+}
+
+static int QR_incremental_delete(void *data)
+{
+  mygsl_QR_incremental *q = (mygsl_QR_incremental *) data;
+  return mygsl_linalg_cholesky_downdate(q->l, q->row, q->work);
+}
+
+static void rb_gsl_QR_incremental_row(mygsl_QR_incremental *q, VALUE va, VALUE vy)
+{
+  gsl_vector *a = NULL;
+  gsl_vector_view r;
+  CHECK_VECTOR(va);
+  Data_Get_Struct(va, gsl_vector, a);
+  if (a->size != q->n)
+    rb_raise(rb_eArgError, "row must have %d elements", (int) q->n);
+  r = gsl_vector_subvector(q->row, 0, q->n);
+  gsl_vector_memcpy(&r.vector, a);
+  gsl_vector_set(q->row, q->n, NIL_P(vy) ? 0.0 : NUM2DBL(vy));
+}
+
+/* add_row(a[, y]): append the observation a^T x = y */
+static VALUE rb_gsl_QR_incremental_add_row(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  rb_gsl_QR_incremental_row(q, argv[0], argc == 2 ? argv[1] : Qnil);
+  rb_gsl_nogvl_call(QR_incremental_add, q, 2*(q->n + 1)*(q->n + 1));
+  q->nrows++;
+  return obj;
+}
+
+/* add_rows(A[, y]): append every row of A */
+static VALUE rb_gsl_QR_incremental_add_rows(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  gsl_matrix *A = NULL;
+  gsl_vector *y = NULL;
+  size_t i;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_MATRIX(argv[0]);
+  Data_Get_Struct(argv[0], gsl_matrix, A);
+  if (A->size2 != q->n)
+    rb_raise(rb_eArgError, "rows must have %d elements", (int) q->n);
+  if (argc == 2) {
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Struct(argv[1], gsl_vector, y);
+    if (y->size != A->size1)
+      rb_raise(rb_eArgError, "y must have %d elements", (int) A->size1);
+  }
+  for (i = 0; i < A->size1; i++) {
+    gsl_vector_const_view a = gsl_matrix_const_row(A, i);
+    gsl_vector_view r = gsl_vector_subvector(q->row, 0, q->n);
+    gsl_vector_memcpy(&r.vector, &a.vector);
+    gsl_vector_set(q->row, q->n, y ? gsl_vector_get(y, i) : 0.0);
+    rb_gsl_nogvl_call(QR_incremental_add, q, 2*(q->n + 1)*(q->n + 1));
+    q->nrows++;
+  }
+  return obj;
+}
+
+/* delete_row(a[, y]): remove an observation added before */
+static VALUE rb_gsl_QR_incremental_delete_row(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  if (q->nrows == 0) rb_raise(rb_eRuntimeError, "no rows to delete");
+  rb_gsl_QR_incremental_row(q, argv[0], argc == 2 ? argv[1] : Qnil);
+  rb_gsl_nogvl_call(QR_incremental_delete, q, 2*(q->n + 1)*(q->n + 1));
+  q->nrows--;
+  return obj;
+}
+
+static VALUE rb_gsl_QR_incremental_size(VALUE obj)
+{
+  return INT2FIX(rb_gsl_QR_incremental_get(obj)->n);
+}
+
+static VALUE rb_gsl_QR_incremental_nrows(VALUE obj)
+{
+  return INT2FIX(rb_gsl_QR_incremental_get(obj)->nrows);
+}
+
+static VALUE rb_gsl_QR_incremental_R(VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  gsl_matrix *R = gsl_matrix_calloc(q->n, q->n);
+  size_t i, j;
+  for (i = 0; i < q->n; i++)
+    for (j = i; j < q->n; j++) gsl_matrix_set(R, i, j, gsl_matrix_get(q->l, j, i));
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, R);
+}
+
+/* Q^T y, the first n elements */
+static VALUE rb_gsl_QR_incremental_qty(VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  gsl_vector_view z = gsl_matrix_subrow(q->l, q->n, 0, q->n);
+  return Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free,
+			  make_vector_clone(&z.vector));
+}
+
+/* Residual sum of squares of the least-squares solution */
+static VALUE rb_gsl_QR_incremental_rss(VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  double rho = gsl_matrix_get(q->l, q->n, q->n);
+  return rb_float_new(rho*rho);
+}
+
+/* R x = z */
+static VALUE rb_gsl_QR_incremental_solve(VALUE obj)
+{
+  mygsl_QR_incremental *q = rb_gsl_QR_incremental_get(obj);
+  gsl_vector *x;
+  size_t i, k, n = q->n;
+  double t;
+  for (i = 0; i < n; i++)
+    if (gsl_matrix_get(q->l, i, i) == 0.0)
+      rb_raise(rb_eRuntimeError, "R is singular, add more rows");
+  x = gsl_vector_alloc(n);
+  for (i = n; i-- > 0;) {
+    t = gsl_matrix_get(q->l, n, i);
+    for (k = i + 1; k < n; k++) t -= gsl_matrix_get(q->l, k, i)*gsl_vector_get(x, k);
+    gsl_vector_set(x, i, t/gsl_matrix_get(q->l, i, i));
+  }
+  return Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, x);
+}
+
+void Init_gsl_linalg_factor(VALUE module)
+{
+  VALUE mgsl_linalg_LU, mgsl_linalg_QR, mgsl_linalg_cholesky;
+
+  mgsl_linalg_LU = rb_define_module_under(module, "LU");
+  cgsl_linalg_LU_factor = rb_define_class_under(mgsl_linalg_LU, "Factorization",
+						cGSL_Object);
+  rb_define_singleton_method(cgsl_linalg_LU_factor, "new", rb_gsl_LU_factor_new, -1);
+  rb_define_method(cgsl_linalg_LU_factor, "size", rb_gsl_LU_factor_size, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "precision", rb_gsl_LU_factor_precision, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "refine_iter", rb_gsl_LU_factor_refine_iter, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "LU", rb_gsl_LU_factor_matrix, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "perm", rb_gsl_LU_factor_perm, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "signum", rb_gsl_LU_factor_signum, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "solve", rb_gsl_LU_factor_solve, -1);
+  rb_define_method(cgsl_linalg_LU_factor, "refine", rb_gsl_LU_factor_refine, 3);
+  rb_define_method(cgsl_linalg_LU_factor, "invert", rb_gsl_LU_factor_invert, 0);
+  rb_define_alias(cgsl_linalg_LU_factor, "inv", "invert");
+  rb_define_method(cgsl_linalg_LU_factor, "det", rb_gsl_LU_factor_det, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "lndet", rb_gsl_LU_factor_lndet, 0);
+  rb_define_method(cgsl_linalg_LU_factor, "sgndet", rb_gsl_LU_factor_sgndet, 0);
+
+  mgsl_linalg_QR = rb_define_module_under(module, "QR");
+  cgsl_linalg_QR_factor = rb_define_class_under(mgsl_linalg_QR, "Factorization",
+						cGSL_Object);
+  rb_define_singleton_method(cgsl_linalg_QR_factor, "new", rb_gsl_QR_factor_new, 1);
+  rb_define_method(cgsl_linalg_QR_factor, "shape", rb_gsl_QR_factor_shape, 0);
+  rb_define_method(cgsl_linalg_QR_factor, "QR", rb_gsl_QR_factor_matrix, 0);
+  rb_define_method(cgsl_linalg_QR_factor, "tau", rb_gsl_QR_factor_tau, 0);
+  rb_define_method(cgsl_linalg_QR_factor, "solve", rb_gsl_QR_factor_solve, -1);
+  rb_define_method(cgsl_linalg_QR_factor, "lssolve", rb_gsl_QR_factor_lssolve, -1);
+  rb_define_method(cgsl_linalg_QR_factor, "residual", rb_gsl_QR_factor_residual, 0);
+
+  cgsl_linalg_QR_incremental = rb_define_class_under(mgsl_linalg_QR, "Incremental",
+						     cGSL_Object);
+  rb_define_singleton_method(cgsl_linalg_QR_incremental, "new",
+			     rb_gsl_QR_incremental_new, 1);
+  rb_define_method(cgsl_linalg_QR_incremental, "size", rb_gsl_QR_incremental_size, 0);
+  rb_define_method(cgsl_linalg_QR_incremental, "nrows", rb_gsl_QR_incremental_nrows, 0);
+  rb_define_method(cgsl_linalg_QR_incremental, "add_row",
+		   rb_gsl_QR_incremental_add_row, -1);
+  rb_define_alias(cgsl_linalg_QR_incremental, "append", "add_row");
+  rb_define_method(cgsl_linalg_QR_incremental, "add_rows",
+		   rb_gsl_QR_incremental_add_rows, -1);
+  rb_define_method(cgsl_linalg_QR_incremental, "delete_row",
+		   rb_gsl_QR_incremental_delete_row, -1);
+  rb_define_method(cgsl_linalg_QR_incremental, "R", rb_gsl_QR_incremental_R, 0);
+  rb_define_method(cgsl_linalg_QR_incremental, "qty", rb_gsl_QR_incremental_qty, 0);
+  rb_define_method(cgsl_linalg_QR_incremental, "rss", rb_gsl_QR_incremental_rss, 0);
+  rb_define_method(cgsl_linalg_QR_incremental, "solve", rb_gsl_QR_incremental_solve, 0);
+
+  mgsl_linalg_cholesky = rb_define_module_under(module, "Cholesky");
+  cgsl_linalg_cholesky_factor = rb_define_class_under(mgsl_linalg_cholesky,
+						      "Factorization", cGSL_Object);
+  rb_define_singleton_method(cgsl_linalg_cholesky_factor, "new",
+			     rb_gsl_cholesky_factor_new, 1);
+  rb_define_method(cgsl_linalg_cholesky_factor, "size", rb_gsl_cholesky_factor_size, 0);
+  rb_define_method(cgsl_linalg_cholesky_factor, "LLT", rb_gsl_cholesky_factor_matrix, 0);
+  rb_define_method(cgsl_linalg_cholesky_factor, "solve", rb_gsl_cholesky_factor_solve, -1);
+  rb_define_method(cgsl_linalg_cholesky_factor, "update!",
+		   rb_gsl_cholesky_factor_update, 1);
+  rb_define_method(cgsl_linalg_cholesky_factor, "downdate!",
+		   rb_gsl_cholesky_factor_downdate, 1);
+  rb_define_method(cgsl_linalg_cholesky_factor, "det", rb_gsl_cholesky_factor_det, 0);
+  rb_define_method(cgsl_linalg_cholesky_factor, "lndet", rb_gsl_cholesky_factor_lndet, 0);
+}
@@ -0,0 +1,850 @@
+/*
+  linalg_iterative.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Krylov solvers for A x = b that only need products with A.
+
+    cg = GSL::Linalg::Iterative::CG.new(a, :tol => 1e-10, :precond => :jacobi)
+    x = cg.solve(b)                   # or cg.solve(b, x0), cg.solve!(b, x)
+    cg.iter; cg.normr; cg.converged?; cg.history
+    x, iter, normr = GSL::Linalg::Iterative.bicgstab(a, b, :precond => :ilu0)
+
+  CG (symmetric positive definite A), BiCGSTAB and restarted GMRES
+  (:restart, 30 by default) are preconditioned on the left (CG) or on
+  the right.  The operator a is a GSL::Matrix, a GSL::SpMatrix, or
+  anything responding to call: op.call(x) returns A x as a GSL::Vector,
+  or op.call(x, y) stores it in y when the callable takes two
+  arguments.  :precond is :jacobi (the diagonal, or :diag for a
+  callable operator), :ilu0 (incomplete LU on the pattern of a
+  SpMatrix), or a callable applying M^-1 the same way.  The
+  preconditioner is set up once, by new, and reused by every solve.
+
+  The iteration is relative to |b|: it stops when |r| <= tol |b|.  When
+  neither the operator nor the preconditioner calls back into Ruby, the
+  whole solve runs with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_blas.h>
+
+static VALUE cgsl_linalg_iter_cg, cgsl_linalg_iter_bicgstab, cgsl_linalg_iter_gmres;
+
+enum {
+  ITER_CG,
+  ITER_BICGSTAB,
+  ITER_GMRES,
+};
+
+enum {
+  ITER_OP_MATRIX,
+  ITER_OP_CSR,
+  ITER_OP_CALL,
+};
+
+enum {
+  ITER_PC_NONE,
+  ITER_PC_JACOBI,
+  ITER_PC_ILU0,
+  ITER_PC_CALL,
+};
+
+typedef struct {
+  int method;
+  size_t n, restart, max_iter;
+  double tol;
+  int op_kind, op_arity;
+  VALUE vA, op;
+  const gsl_matrix *A;
+  mygsl_csr *csr;
+  int pc_kind, pc_arity;
+  VALUE pc;
+  gsl_vector *dinv;
+  mygsl_csr *ilu;
+  VALUE vin, vout;      /* GSL::Vectors passed to Ruby callables */
+  gsl_matrix *work;     /* rows are scratch vectors */
+  gsl_matrix *H;        /* GMRES Hessenberg, (restart + 1) x restart */
+  gsl_vector *givens;   /* GMRES rotations and g, 3 restart + 1 */
+  gsl_vector *history;  /* relative residuals, or NULL */
+  /* current solve */
+  const gsl_vector *b;
+  gsl_vector *x;
+  size_t iter, nmatvec;
+  double normr;
+  int converged;
+} mygsl_iter;
+
+/***** Compressed rows *****/
+
+void mygsl_csr_free(mygsl_csr *c)
+{
+  if (c == NULL) return;
+  free(c->rowptr); free(c->col); free(c->diag); free(c->val);
+  free(c);
+}
+
+mygsl_csr* mygsl_csr_alloc(size_t n, size_t nz)
+{
+  mygsl_csr *c = (mygsl_csr *) calloc(1, sizeof(mygsl_csr));
+  if (c == NULL) return NULL;
+  c->n = n;
+  c->rowptr = (size_t *) calloc(n + 1, sizeof(size_t));
+  c->diag = (size_t *) malloc(sizeof(size_t)*(n + 1));
+  c->col = (size_t *) malloc(sizeof(size_t)*(nz + 1));
+  c->val = (double *) malloc(sizeof(double)*(nz + 1));
+  if (!c->rowptr || !c->diag || !c->col || !c->val) {
+    mygsl_csr_free(c);
+    return NULL;
+  }
+  return c;
+}
+
+static mygsl_csr* mygsl_csr_copy(const mygsl_csr *a)
+{
+  mygsl_csr *c = mygsl_csr_alloc(a->n, a->rowptr[a->n]);
+  if (c == NULL) return NULL;
+  memcpy(c->rowptr, a->rowptr, sizeof(size_t)*(a->n + 1));
+  memcpy(c->diag, a->diag, sizeof(size_t)*(a->n + 1));
+  memcpy(c->col, a->col, sizeof(size_t)*a->rowptr[a->n]);
+  memcpy(c->val, a->val, sizeof(double)*a->rowptr[a->n]);
+  return c;
+}
+
+/* Sorts the columns of each row, sums duplicates and finds the
+   diagonal (diag[r] = rowptr[r + 1] if it is missing).  Rows are
+   packed down as they go; rowptr[r + 1] still holds the end of the
+   unpacked row r while row r is processed. */
+static void mygsl_csr_finish(mygsl_csr *c)
+{
+  size_t r, k, m, out = 0, start, ck;
+  double vk;
+  for (r = 0; r < c->n; r++) {
+    start = c->rowptr[r];
+    for (k = start + 1; k < c->rowptr[r+1]; k++) {
+      ck = c->col[k]; vk = c->val[k];
+      for (m = k; m > start && c->col[m-1] > ck; m--) {
+	c->col[m] = c->col[m-1]; c->val[m] = c->val[m-1];
+      }
+      c->col[m] = ck; c->val[m] = vk;
+    }
+    c->rowptr[r] = out;
+    for (k = start; k < c->rowptr[r+1]; k++) {
+      if (out > c->rowptr[r] && c->col[out-1] == c->col[k]) c->val[out-1] += c->val[k];
+      else { c->col[out] = c->col[k]; c->val[out] = c->val[k]; out++; }
+    }
+  }
+  c->rowptr[c->n] = out;
+  for (r = 0; r < c->n; r++) {
+    c->diag[r] = c->rowptr[r+1];
+    for (k = c->rowptr[r]; k < c->rowptr[r+1]; k++)
+      if (c->col[k] == r) { c->diag[r] = k; break; }
+  }
+}
+
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+/* Compressed rows of any gsl_spmatrix; NULL when out of memory */
+mygsl_csr* mygsl_csr_from_spmatrix(const gsl_spmatrix *m)
+{
+  mygsl_csr *c;
+  size_t *count, *next, k, j, r, nz = m->nz;
+  if (m->sptype == GSL_SPMATRIX_CCS) nz = m->p[m->size2];
+  c = mygsl_csr_alloc(m->size1, nz);
+  if (c == NULL) return NULL;
+  count = c->rowptr;
+  if (m->sptype == GSL_SPMATRIX_TRIPLET) {
+    for (k = 0; k < nz; k++) count[m->i[k] + 1]++;
+  } else if (m->sptype == GSL_SPMATRIX_CCS) {
+    for (k = 0; k < nz; k++) count[m->i[k] + 1]++;
+#ifdef GSL_SPMATRIX_CRS
+  } else if (m->sptype == GSL_SPMATRIX_CRS) {
+    nz = m->p[m->size1];
+    for (r = 0; r < m->size1; r++) count[r + 1] = m->p[r+1] - m->p[r];
+#endif
+  }
+  for (r = 0; r < m->size1; r++) count[r + 1] += count[r];
+  next = c->diag;   /* as scratch, rebuilt by mygsl_csr_finish() */
+  memcpy(next, c->rowptr, sizeof(size_t)*m->size1);
+  if (m->sptype == GSL_SPMATRIX_TRIPLET) {
+    for (k = 0; k < nz; k++) {
+      r = m->i[k];
+      c->col[next[r]] = m->p[k];
+      c->val[next[r]++] = m->data[k];
+    }
+  } else if (m->sptype == GSL_SPMATRIX_CCS) {
+    for (j = 0; j < m->size2; j++)
+      for (k = m->p[j]; k < (size_t) m->p[j+1]; k++) {
+	r = m->i[k];
+	c->col[next[r]] = j;
+	c->val[next[r]++] = m->data[k];
+      }
+#ifdef GSL_SPMATRIX_CRS
+  } else {
+    for (k = 0; k < nz; k++) { c->col[k] = m->i[k]; c->val[k] = m->data[k]; }
+#endif
+  }
+  mygsl_csr_finish(c);
+  return c;
+}
+#endif
+
+void mygsl_csr_mul(const mygsl_csr *c, const gsl_vector *x, gsl_vector *y)
+{
+  size_t r, k;
+  double s;
+  for (r = 0; r < c->n; r++) {
+    s = 0.0;
+    for (k = c->rowptr[r]; k < c->rowptr[r+1]; k++)
+      s += c->val[k]*gsl_vector_get(x, c->col[k]);
+    gsl_vector_set(y, r, s);
+  }
+}
+
+/* ILU(0) in place (Saad, Algorithm 10.4): L unit lower, U upper, on
+   the pattern of A */
+static int mygsl_csr_ilu0(mygsl_csr *c)
+{
+  size_t *pos, i, k, j, kk, jj;
+  double l;
+  for (i = 0; i < c->n; i++)
+    if (c->diag[i] == c->rowptr[i+1])
+      GSL_ERROR("ILU0 needs every diagonal element in the pattern", GSL_EDOM);
+  pos = (size_t *) malloc(sizeof(size_t)*c->n);
+  if (pos == NULL) GSL_ERROR("failed to allocate ILU0 workspace", GSL_ENOMEM);
+  for (j = 0; j < c->n; j++) pos[j] = (size_t) -1;
+  for (i = 1; i < c->n; i++) {
+    for (k = c->rowptr[i]; k < c->rowptr[i+1]; k++) pos[c->col[k]] = k;
+    for (k = c->rowptr[i]; k < c->diag[i]; k++) {
+      kk = c->col[k];
+      if (c->val[c->diag[kk]] == 0.0) {
+	free(pos);
+	GSL_ERROR("zero pivot in ILU0", GSL_EZERODIV);
+      }
+      l = c->val[k] /= c->val[c->diag[kk]];
+      for (jj = c->diag[kk] + 1; jj < c->rowptr[kk+1]; jj++)
+	if (pos[c->col[jj]] != (size_t) -1) c->val[pos[c->col[jj]]] -= l*c->val[jj];
+    }
+    for (k = c->rowptr[i]; k < c->rowptr[i+1]; k++) pos[c->col[k]] = (size_t) -1;
+  }
+  free(pos);
+  if (c->val[c->diag[c->n-1]] == 0.0) GSL_ERROR("zero pivot in ILU0", GSL_EZERODIV);
+  return GSL_SUCCESS;
+}
+
+/* z = U^-1 L^-1 r */
+static void mygsl_csr_ilu0_solve(const mygsl_csr *c, const gsl_vector *r, gsl_vector *z)
+{
+  size_t i, k;
+  double s;
+  for (i = 0; i < c->n; i++) {
+    s = gsl_vector_get(r, i);
+    for (k = c->rowptr[i]; k < c->diag[i]; k++) s -= c->val[k]*gsl_vector_get(z, c->col[k]);
+    gsl_vector_set(z, i, s);
+  }
+  for (i = c->n; i-- > 0;) {
+    s = gsl_vector_get(z, i);
+    for (k = c->diag[i] + 1; k < c->rowptr[i+1]; k++)
+      s -= c->val[k]*gsl_vector_get(z, c->col[k]);
+    gsl_vector_set(z, i, s/c->val[c->diag[i]]);
+  }
+}
+
+/***** Operator and preconditioner *****/
+
+/* y = proc.call(x), passing x through the persistent Vector vin; a
+   callable of arity 2 stores into vout instead */
+void rb_gsl_linalg_op_call(VALUE proc, int arity, VALUE vin, VALUE vout,
+			    const gsl_vector *x, gsl_vector *y)
+{
+  gsl_vector *in, *out;
+  VALUE ret;
+  Data_Get_Struct(vin, gsl_vector, in);
+  gsl_vector_memcpy(in, x);
+  if (arity == 2) {
+    rb_funcall(proc, rb_intern("call"), 2, vin, vout);
+    Data_Get_Struct(vout, gsl_vector, out);
+  } else {
+    ret = rb_funcall(proc, rb_intern("call"), 1, vin);
+    CHECK_VECTOR(ret);
+    Data_Get_Struct(ret, gsl_vector, out);
+    if (out->size != y->size)
+      rb_raise(rb_eArgError, "operator returned %d elements, expected %d",
+	       (int) out->size, (int) y->size);
+  }
+  gsl_vector_memcpy(y, out);
+}
+
+static int iter_apply(mygsl_iter *s, const gsl_vector *x, gsl_vector *y)
+{
+  s->nmatvec++;
+  switch (s->op_kind) {
+  case ITER_OP_MATRIX:
+    return gsl_blas_dgemv(CblasNoTrans, 1.0, s->A, x, 0.0, y);
+  case ITER_OP_CSR:
+    mygsl_csr_mul(s->csr, x, y);
+    return GSL_SUCCESS;
+  default:
+    rb_gsl_linalg_op_call(s->op, s->op_arity, s->vin, s->vout, x, y);
+    return GSL_SUCCESS;
+  }
+}
+
+/* z = M^-1 r */
+static int iter_precond(mygsl_iter *s, const gsl_vector *r, gsl_vector *z)
+{
+  switch (s->pc_kind) {
+  case ITER_PC_NONE:
+    return gsl_vector_memcpy(z, r);
+  case ITER_PC_JACOBI:
+    gsl_vector_memcpy(z, r);
+    return gsl_vector_mul(z, s->dinv);
+  case ITER_PC_ILU0:
+    mygsl_csr_ilu0_solve(s->ilu, r, z);
+    return GSL_SUCCESS;
+  default:
+    rb_gsl_linalg_op_call(s->pc, s->pc_arity, s->vin, s->vout, r, z);
+    return GSL_SUCCESS;
+  }
+}
+
+/* Records |r|, and whether it is below tol |b| */
+static int iter_check(mygsl_iter *s, double normr, double normb)
+{
+  s->normr = normr;
+  if (s->history && s->iter < s->history->size)
+    gsl_vector_set(s->history, s->iter, normr/normb);
+  s->converged = normr <= s->tol*normb;
+  return s->converged;
+}
+
+/***** Solvers *****/
+
+static int iter_cg(mygsl_iter *s, double normb)
+{
+  gsl_vector_view rv = gsl_matrix_row(s->work, 0), zv = gsl_matrix_row(s->work, 1);
+  gsl_vector_view pv = gsl_matrix_row(s->work, 2), qv = gsl_matrix_row(s->work, 3);
+  gsl_vector *r = &rv.vector, *z = &zv.vector, *p = &pv.vector, *q = &qv.vector;
+  double rz, rznew, pq, alpha;
+  iter_apply(s, s->x, r);
+  gsl_vector_scale(r, -1.0);
+  gsl_vector_add(r, s->b);
+  if (iter_check(s, gsl_blas_dnrm2(r), normb)) return GSL_SUCCESS;
+  iter_precond(s, r, z);
+  gsl_vector_memcpy(p, z);
+  gsl_blas_ddot(r, z, &rz);
+  while (s->iter < s->max_iter) {
+    iter_apply(s, p, q);
+    gsl_blas_ddot(p, q, &pq);
+    if (pq <= 0.0) GSL_ERROR("CG: operator is not positive definite", GSL_EDOM);
+    alpha = rz/pq;
+    gsl_blas_daxpy(alpha, p, s->x);
+    gsl_blas_daxpy(-alpha, q, r);
+    s->iter++;
+    if (iter_check(s, gsl_blas_dnrm2(r), normb)) break;
+    iter_precond(s, r, z);
+    gsl_blas_ddot(r, z, &rznew);
+    gsl_vector_scale(p, rznew/rz);
+    gsl_vector_add(p, z);
+    rz = rznew;
+  }
+  return GSL_SUCCESS;
+}
+
+static int iter_bicgstab(mygsl_iter *s, double normb)
+{
+  gsl_vector_view v0 = gsl_matrix_row(s->work, 0), v1 = gsl_matrix_row(s->work, 1);
+  gsl_vector_view v2 = gsl_matrix_row(s->work, 2), v3 = gsl_matrix_row(s->work, 3);
+  gsl_vector_view v4 = gsl_matrix_row(s->work, 4), v5 = gsl_matrix_row(s->work, 5);
+  gsl_vector *r = &v0.vector, *rhat = &v1.vector, *p = &v2.vector, *v = &v3.vector;
+  gsl_vector *phat = &v4.vector, *t = &v5.vector;
+  double rho = 1.0, rhonew, alpha = 1.0, omega = 1.0, beta, tmp, ts, tt;
+  iter_apply(s, s->x, r);
+  gsl_vector_scale(r, -1.0);
+  gsl_vector_add(r, s->b);
+  if (iter_check(s, gsl_blas_dnrm2(r), normb)) return GSL_SUCCESS;
+  gsl_vector_memcpy(rhat, r);
+  gsl_vector_set_zero(p);
+  gsl_vector_set_zero(v);
+  while (s->iter < s->max_iter) {
+    gsl_blas_ddot(rhat, r, &rhonew);
+    if (rhonew == 0.0) GSL_ERROR("BiCGSTAB breakdown (rho = 0)", GSL_EFAILED);
+    beta = (rhonew/rho)*(alpha/omega);
+    /* p = r + beta (p - omega v) */
+    gsl_blas_daxpy(-omega, v, p);
+    gsl_vector_scale(p, beta);
+    gsl_vector_add(p, r);
+    iter_precond(s, p, phat);
+    iter_apply(s, phat, v);
+    gsl_blas_ddot(rhat, v, &tmp);
+    if (tmp == 0.0) GSL_ERROR("BiCGSTAB breakdown (rhat.v = 0)", GSL_EFAILED);
+    alpha = rhonew/tmp;
+    /* s = r - alpha v, kept in r */
+    gsl_blas_daxpy(-alpha, v, r);
+    gsl_blas_daxpy(alpha, phat, s->x);
+    s->iter++;
+    if (iter_check(s, gsl_blas_dnrm2(r), normb)) break;
+    /* shat in phat, t = A shat */
+    iter_precond(s, r, phat);
+    iter_apply(s, phat, t);
+    gsl_blas_ddot(t, r, &ts);
+    gsl_blas_ddot(t, t, &tt);
+    if (tt == 0.0) GSL_ERROR("BiCGSTAB breakdown (t = 0)", GSL_EFAILED);
+    omega = ts/tt;
+    gsl_blas_daxpy(omega, phat, s->x);
+    gsl_blas_daxpy(-omega, t, r);
+    rho = rhonew;
+    if (iter_check(s, gsl_blas_dnrm2(r), normb)) break;
+    if (omega == 0.0) GSL_ERROR("BiCGSTAB breakdown (omega = 0)", GSL_EFAILED);
+  }
+  return GSL_SUCCESS;
+}
+
+/* GMRES(m), right preconditioned: rows 0 ... m of work are the Krylov
+   basis, m + 1 and m + 2 scratch */
+static int iter_gmres(mygsl_iter *s, double normb)
+{
+  size_t m = s->restart, j, i, k;
+  gsl_vector_view wv = gsl_matrix_row(s->work, m + 1), uv = gsl_matrix_row(s->work, m + 2);
+  gsl_vector *w = &wv.vector, *u = &uv.vector;
+  double *cs = s->givens->data, *sn = cs + m, *g = sn + m;
+  double beta, h, t, hjj, hj1;
+  while (1) {
+    gsl_vector_view v0 = gsl_matrix_row(s->work, 0);
+    iter_apply(s, s->x, &v0.vector);
+    gsl_vector_scale(&v0.vector, -1.0);
+    gsl_vector_add(&v0.vector, s->b);
+    beta = gsl_blas_dnrm2(&v0.vector);
+    if (iter_check(s, beta, normb) || s->iter >= s->max_iter) return GSL_SUCCESS;
+    gsl_vector_scale(&v0.vector, 1.0/beta);
+    for (i = 0; i <= m; i++) g[i] = 0.0;
+    g[0] = beta;
+    for (j = 0; j < m && s->iter < s->max_iter; j++) {
+      gsl_vector_view vj = gsl_matrix_row(s->work, j), vj1 = gsl_matrix_row(s->work, j + 1);
+      iter_precond(s, &vj.vector, u);
+      iter_apply(s, u, w);
+      /* modified Gram-Schmidt */
+      for (i = 0; i <= j; i++) {
+	gsl_vector_view vi = gsl_matrix_row(s->work, i);
+	gsl_blas_ddot(w, &vi.vector, &h);
+	gsl_matrix_set(s->H, i, j, h);
+	gsl_blas_daxpy(-h, &vi.vector, w);
+      }
+      h = gsl_blas_dnrm2(w);
+      gsl_matrix_set(s->H, j + 1, j, h);
+      if (h != 0.0) {
+	gsl_vector_memcpy(&vj1.vector, w);
+	gsl_vector_scale(&vj1.vector, 1.0/h);
+      }
+      for (i = 0; i < j; i++) {
+	t = cs[i]*gsl_matrix_get(s->H, i, j) + sn[i]*gsl_matrix_get(s->H, i + 1, j);
+	gsl_matrix_set(s->H, i + 1, j, -sn[i]*gsl_matrix_get(s->H, i, j)
+		       + cs[i]*gsl_matrix_get(s->H, i + 1, j));
+	gsl_matrix_set(s->H, i, j, t);
+      }
+      hjj = gsl_matrix_get(s->H, j, j);
+      hj1 = gsl_matrix_get(s->H, j + 1, j);
+      t = hypot(hjj, hj1);
+      if (t == 0.0) GSL_ERROR("GMRES breakdown", GSL_EFAILED);
+      cs[j] = hjj/t;
+      sn[j] = hj1/t;
+      gsl_matrix_set(s->H, j, j, t);
+      gsl_matrix_set(s->H, j + 1, j, 0.0);
+      g[j + 1] = -sn[j]*g[j];
+      g[j] = cs[j]*g[j];
+      s->iter++;
+      if (iter_check(s, fabs(g[j + 1]), normb) || h == 0.0) { j++; break; }
+    }
+    /* y = H^-1 g in g, then x += M^-1 V y */
+    for (i = j; i-- > 0;) {
+      t = g[i];
+      for (k = i + 1; k < j; k++) t -= gsl_matrix_get(s->H, i, k)*g[k];
+      g[i] = t/gsl_matrix_get(s->H, i, i);
+    }
+    gsl_vector_set_zero(w);
+    for (i = 0; i < j; i++) {
+      gsl_vector_view vi = gsl_matrix_row(s->work, i);
+      gsl_blas_daxpy(g[i], &vi.vector, w);
+    }
+    iter_precond(s, w, u);
+    gsl_vector_add(s->x, u);
+    /* the true residual at the top of the loop decides */
+  }
+}
+
+static int iter_run(void *data)
+{
+  mygsl_iter *s = (mygsl_iter *) data;
+  double normb = gsl_blas_dnrm2(s->b);
+  s->iter = 0;
+  s->nmatvec = 0;
+  s->converged = 0;
+  if (s->history) gsl_vector_set_all(s->history, GSL_NAN);
+  if (normb == 0.0) {
+    gsl_vector_set_zero(s->x);
+    s->normr = 0.0;
+    s->converged = 1;
+    return GSL_SUCCESS;
+  }
+  switch (s->method) {
+  case ITER_CG: return iter_cg(s, normb);
+  case ITER_BICGSTAB: return iter_bicgstab(s, normb);
+  default: return iter_gmres(s, normb);
+  }
+}
+
+/***** Ruby interface *****/
+
+static void mygsl_iter_mark(mygsl_iter *s)
+{
+  rb_gc_mark(s->vA);
+  rb_gc_mark(s->op);
+  rb_gc_mark(s->pc);
+  rb_gc_mark(s->vin);
+  rb_gc_mark(s->vout);
+}
+
+static void mygsl_iter_free(mygsl_iter *s)
+{
+  mygsl_csr_free(s->csr);
+  mygsl_csr_free(s->ilu);
+  if (s->dinv) gsl_vector_free(s->dinv);
+  if (s->work) gsl_matrix_free(s->work);
+  if (s->H) gsl_matrix_free(s->H);
+  if (s->givens) gsl_vector_free(s->givens);
+  if (s->history) gsl_vector_free(s->history);
+  free(s);
+}
+
+int rb_gsl_linalg_op_arity(VALUE proc)
+{
+  return NUM2INT(rb_funcall(proc, rb_intern("arity"), 0)) == 2 ? 2 : 1;
+}
+
+static void iter_set_operator(mygsl_iter *s, VALUE va)
+{
+  s->vA = va;
+  if (MATRIX_P(va)) {
+    Data_Get_Struct(va, gsl_matrix, s->A);
+    if (s->A->size1 != s->A->size2) rb_raise(rb_eArgError, "matrix must be square");
+    s->op_kind = ITER_OP_MATRIX;
+    s->n = s->A->size1;
+    return;
+  }
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  if (rb_gsl_spmatrix_p(va)) {
+    gsl_spmatrix *m = rb_gsl_get_spmatrix(va);
+    if (m->size1 != m->size2) rb_raise(rb_eArgError, "matrix must be square");
+    s->csr = mygsl_csr_from_spmatrix(m);
+    if (s->csr == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    s->op_kind = ITER_OP_CSR;
+    s->n = m->size1;
+    return;
+  }
+#endif
+  if (!rb_respond_to(va, rb_intern("call")))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix, GSL::SpMatrix"
+	     " or a callable expected)", rb_class2name(CLASS_OF(va)));
+  s->op = va;
+  s->op_kind = ITER_OP_CALL;
+  s->op_arity = rb_gsl_linalg_op_arity(va);
+  s->n = 0;   /* from the first right-hand side */
+}
+
+static void iter_set_precond(mygsl_iter *s, VALUE vpc, VALUE vdiag)
+{
+  size_t i;
+  double d;
+  if (NIL_P(vpc) || vpc == Qfalse) {
+    s->pc_kind = ITER_PC_NONE;
+    return;
+  }
+  if (SYMBOL_P(vpc) && SYM2ID(vpc) == rb_intern("jacobi")) {
+    gsl_vector *diag = NULL;
+    if (!NIL_P(vdiag)) {
+      CHECK_VECTOR(vdiag);
+      Data_Get_Struct(vdiag, gsl_vector, diag);
+      if (s->n && diag->size != s->n)
+	rb_raise(rb_eArgError, ":diag must have %d elements", (int) s->n);
+      s->n = diag->size;
+    } else if (s->op_kind == ITER_OP_CALL) {
+      rb_raise(rb_eArgError, ":jacobi with a callable operator needs :diag");
+    }
+    s->dinv = gsl_vector_alloc(s->n);
+    for (i = 0; i < s->n; i++) {
+      if (diag) d = gsl_vector_get(diag, i);
+      else if (s->op_kind == ITER_OP_MATRIX) d = gsl_matrix_get(s->A, i, i);
+      else d = s->csr->diag[i] < s->csr->rowptr[i+1] ? s->csr->val[s->csr->diag[i]] : 0.0;
+      if (d == 0.0) rb_raise(rb_eZeroDivError, "zero diagonal element %d", (int) i);
+      gsl_vector_set(s->dinv, i, 1.0/d);
+    }
+    s->pc_kind = ITER_PC_JACOBI;
+    return;
+  }
+  if (SYMBOL_P(vpc) && SYM2ID(vpc) == rb_intern("ilu0")) {
+    if (s->op_kind != ITER_OP_CSR)
+      rb_raise(rb_eArgError, ":ilu0 needs a GSL::SpMatrix operator");
+    s->ilu = mygsl_csr_copy(s->csr);
+    if (s->ilu == NULL) rb_raise(rb_eNoMemError, "failed to allocate the ILU0 factor");
+    mygsl_csr_ilu0(s->ilu);
+    s->pc_kind = ITER_PC_ILU0;
+    return;
+  }
+  if (!rb_respond_to(vpc, rb_intern("call")))
+    rb_raise(rb_eArgError, "unknown preconditioner (:jacobi, :ilu0 or a callable)");
+  s->pc = vpc;
+  s->pc_kind = ITER_PC_CALL;
+  s->pc_arity = rb_gsl_linalg_op_arity(vpc);
+}
+
+static void iter_alloc_work(mygsl_iter *s, size_t n)
+{
+  size_t rows;
+  if (s->work && s->n == n) return;
+  s->n = n;
+  if (s->work) gsl_matrix_free(s->work);
+  s->work = NULL;
+  if (s->method == ITER_CG) rows = 4;
+  else if (s->method == ITER_BICGSTAB) rows = 6;
+  else {
+    rows = s->restart + 3;
+    if (s->H == NULL) {
+      s->H = gsl_matrix_calloc(s->restart + 1, s->restart);
+      s->givens = gsl_vector_calloc(3*s->restart + 1);
+    }
+  }
+  s->work = gsl_matrix_calloc(rows, n);
+  if (s->op_kind == ITER_OP_CALL || s->pc_kind == ITER_PC_CALL) {
+    s->vin = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_calloc(s->n));
+    s->vout = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_calloc(s->n));
+  }
+}
+
+/* new(a, opts = {}): see the top of the file for a and the options */
+static VALUE rb_gsl_iter_new0(int argc, VALUE *argv, VALUE klass, int method)
+{
+  mygsl_iter *s = NULL;
+  VALUE obj, opts = Qnil, v, vpc = Qnil, vdiag = Qnil;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  if (argc == 2) {
+    opts = argv[1];
+    Check_Type(opts, T_HASH);
+  }
+  obj = Data_Make_Struct(klass, mygsl_iter, mygsl_iter_mark, mygsl_iter_free, s);
+  s->method = method;
+  s->vA = s->op = s->pc = s->vin = s->vout = Qnil;
+  s->tol = 1e-10;
+  s->max_iter = 1000;
+  s->restart = 30;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("tol"))))) s->tol = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_iter")))))
+      s->max_iter = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("restart"))))) {
+      s->restart = NUM2SIZET(v);
+      if (s->restart == 0) rb_raise(rb_eArgError, ":restart must be positive");
+    }
+    vpc = rb_hash_aref(opts, ID2SYM(rb_intern("precond")));
+    vdiag = rb_hash_aref(opts, ID2SYM(rb_intern("diag")));
+    if (RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("history")))))
+      s->history = gsl_vector_alloc(s->max_iter + 1);
+  }
+  iter_set_operator(s, argv[0]);
+  iter_set_precond(s, vpc, vdiag);
+  if (s->n) iter_alloc_work(s, s->n);
+  return obj;
+}
+
+static VALUE rb_gsl_iter_cg_new(int argc, VALUE *argv, VALUE klass)
+{
+  return rb_gsl_iter_new0(argc, argv, klass, ITER_CG);
+}
+
+static VALUE rb_gsl_iter_bicgstab_new(int argc, VALUE *argv, VALUE klass)
+{
+  return rb_gsl_iter_new0(argc, argv, klass, ITER_BICGSTAB);
+}
+
+static VALUE rb_gsl_iter_gmres_new(int argc, VALUE *argv, VALUE klass)
+{
+  return rb_gsl_iter_new0(argc, argv, klass, ITER_GMRES);
+}
+
+static mygsl_iter* rb_gsl_iter_get(VALUE obj)
+{
+  mygsl_iter *s = NULL;
+  Data_Get_Struct(obj, mygsl_iter, s);
+  return s;
+}
+
+/* Solves into x, which holds the initial guess */
+static void rb_gsl_iter_solve0(mygsl_iter *s, VALUE vb, VALUE vx)
+{
+  gsl_vector *b = NULL, *x = NULL;
+  size_t work;
+  CHECK_VECTOR(vb);
+  Data_Get_Struct(vb, gsl_vector, b);
+  Data_Get_Struct(vx, gsl_vector, x);
+  if (s->op_kind == ITER_OP_CALL && (s->work == NULL || s->n != b->size)) {
+    if (s->dinv && s->dinv->size != b->size)
+      rb_raise(rb_eArgError, "b must have %d elements", (int) s->dinv->size);
+    iter_alloc_work(s, b->size);
+  }
+  if (b->size != s->n || x->size != s->n)
+    rb_raise(rb_eArgError, "b and x must have %d elements", (int) s->n);
+  s->b = b;
+  s->x = x;
+  if (s->op_kind == ITER_OP_CALL || s->pc_kind == ITER_PC_CALL) {
+    iter_run(s);
+  } else {
+    work = s->op_kind == ITER_OP_MATRIX ? s->n*s->n : s->csr->rowptr[s->n];
+    rb_gsl_nogvl_call(iter_run, s, work*s->max_iter);
+  }
+  s->b = NULL;
+  s->x = NULL;
+}
+
+/* solve(b[, x0]): a new solution vector, starting from x0 or zero */
+static VALUE rb_gsl_iter_solve(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_iter *s = rb_gsl_iter_get(obj);
+  gsl_vector *b = NULL, *x, *x0 = NULL;
+  VALUE vx;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_VECTOR(argv[0]);
+  Data_Get_Struct(argv[0], gsl_vector, b);
+  x = gsl_vector_calloc(b->size);
+  vx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+  if (argc == 2 && !NIL_P(argv[1])) {
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Struct(argv[1], gsl_vector, x0);
+    if (x0->size != b->size)
+      rb_raise(rb_eArgError, "x0 must have %d elements", (int) b->size);
+    gsl_vector_memcpy(x, x0);
+  }
+  rb_gsl_iter_solve0(s, argv[0], vx);
+  return vx;
+}
+
+/* solve!(b, x): in place, warm started from x */
+static VALUE rb_gsl_iter_solve_bang(VALUE obj, VALUE vb, VALUE vx)
+{
+  CHECK_VECTOR(vx);
+  rb_gsl_iter_solve0(rb_gsl_iter_get(obj), vb, vx);
+  return vx;
+}
+
+static VALUE rb_gsl_iter_iter(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_iter_get(obj)->iter);
+}
+
+static VALUE rb_gsl_iter_normr(VALUE obj)
+{
+  return rb_float_new(rb_gsl_iter_get(obj)->normr);
+}
+
+static VALUE rb_gsl_iter_converged(VALUE obj)
+{
+  return rb_gsl_iter_get(obj)->converged ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_iter_nmatvec(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_iter_get(obj)->nmatvec);
+}
+
+/* Relative residuals |r_k|/|b| of the last solve, k = 0 ... iter */
+static VALUE rb_gsl_iter_history(VALUE obj)
+{
+  mygsl_iter *s = rb_gsl_iter_get(obj);
+  gsl_vector *h;
+  size_t n;
+  if (s->history == NULL) return Qnil;
+  n = GSL_MIN(s->iter + 1, s->history->size);
+  h = gsl_vector_alloc(n);
+  memcpy(h->data, s->history->data, sizeof(double)*n);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, h);
+}
+
+static VALUE rb_gsl_iter_name(VALUE obj)
+{
+  static const char *names[] = { "cg", "bicgstab", "gmres" };
+  return rb_str_new2(names[rb_gsl_iter_get(obj)->method]);
+}
+
+/* GSL::Linalg::Iterative.cg(a, b, opts = {}) => [x, iter, normr]; opts
+   as for new, and :x0 */
+static VALUE rb_gsl_iter_module_solve(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE solver, x0 = Qnil, vx, args[2];
+  mygsl_iter *s;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  args[0] = argv[0];
+  args[1] = argc == 3 ? argv[2] : rb_hash_new();
+  Check_Type(args[1], T_HASH);
+  x0 = rb_hash_aref(args[1], ID2SYM(rb_intern("x0")));
+  solver = rb_funcall2(klass, rb_intern("new"), 2, args);
+  args[0] = argv[1];
+  args[1] = x0;
+  vx = rb_gsl_iter_solve(2, args, solver);
+  s = rb_gsl_iter_get(solver);
+  return rb_ary_new3(3, vx, SIZET2NUM(s->iter), rb_float_new(s->normr));
+}
+
+static VALUE rb_gsl_iter_cg(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_iter_module_solve(argc, argv, cgsl_linalg_iter_cg);
+}
+
+static VALUE rb_gsl_iter_bicgstab(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_iter_module_solve(argc, argv, cgsl_linalg_iter_bicgstab);
+}
+
+static VALUE rb_gsl_iter_gmres(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_iter_module_solve(argc, argv, cgsl_linalg_iter_gmres);
+}
+
+static void rb_gsl_iter_define(VALUE klass, VALUE (*fnew)(int, VALUE *, VALUE))
+{
+  rb_define_singleton_method(klass, "new", fnew, -1);
+  rb_define_singleton_method(klass, "alloc", fnew, -1);
+  rb_define_method(klass, "solve", rb_gsl_iter_solve, -1);
+  rb_define_method(klass, "solve!", rb_gsl_iter_solve_bang, 2);
+  rb_define_method(klass, "iter", rb_gsl_iter_iter, 0);
+  rb_define_method(klass, "normr", rb_gsl_iter_normr, 0);
+  rb_define_method(klass, "converged?", rb_gsl_iter_converged, 0);
+  rb_define_method(klass, "nmatvec", rb_gsl_iter_nmatvec, 0);
+  rb_define_method(klass, "history", rb_gsl_iter_history, 0);
+  rb_define_method(klass, "name", rb_gsl_iter_name, 0);
+}
+
+void Init_gsl_linalg_iterative(VALUE module)
+{
+  VALUE mgsl_linalg_iter;
+  mgsl_linalg_iter = rb_define_module_under(module, "Iterative");
+
+  cgsl_linalg_iter_cg = rb_define_class_under(mgsl_linalg_iter, "CG", cGSL_Object);
+  rb_gsl_iter_define(cgsl_linalg_iter_cg, rb_gsl_iter_cg_new);
+  cgsl_linalg_iter_bicgstab = rb_define_class_under(mgsl_linalg_iter, "BiCGSTAB",
+						    cGSL_Object);
+  rb_gsl_iter_define(cgsl_linalg_iter_bicgstab, rb_gsl_iter_bicgstab_new);
+  cgsl_linalg_iter_gmres = rb_define_class_under(mgsl_linalg_iter, "GMRES", cGSL_Object);
+  rb_gsl_iter_define(cgsl_linalg_iter_gmres, rb_gsl_iter_gmres_new);
+
+  rb_define_module_function(mgsl_linalg_iter, "cg", rb_gsl_iter_cg, -1);
+  rb_define_module_function(mgsl_linalg_iter, "bicgstab", rb_gsl_iter_bicgstab, -1);
+  rb_define_module_function(mgsl_linalg_iter, "gmres", rb_gsl_iter_gmres, -1);
+}
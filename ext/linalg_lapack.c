@@ -0,0 +1,275 @@
+/*
+  linalg_lapack.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The LAPACK engine.  When extconf.rb finds LAPACK (in the BLAS backend,
+  else -llapack; --disable-lapack to go without), the decompositions of
+  GSL::Linalg and GSL::Eigen are done by its blocked routines instead
+  of the level-2 algorithms of GSL:
+
+    LU_decomp        dgetrf
+    QR_decomp        dgeqrf
+    SV_decomp        dgesdd (M >= N, as GSL)
+    cholesky_decomp  dpotrf
+    Eigen.symm(v)    dsyevd
+
+  The methods and the layout of their results are those of GSL: the
+  same permutations and signs for LU, the same Householder vectors and
+  tau for QR (dgeqrf and GSL use one convention), L and L^T in the two
+  triangles for Cholesky.  Singular and eigenvectors are determined up
+  to sign only, and may come with other signs; Eigen.symmv gives the
+  eigenvalues in ascending order, which GSL leaves unordered.
+
+    GSL::Linalg.engine           #=> :lapack (or :gsl without LAPACK)
+    GSL::Linalg.engine = :gsl    # GSL's own routines
+
+  The engine is read by the decompositions with the GVL released; set
+  it between computations.  LAPACK is column-major: the routines work
+  on a transposed copy, except Cholesky and symmetric eigensystems,
+  whose matrices are their own transposes.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+
+#ifdef HAVE_LAPACK
+void dgetrf_(const int *m, const int *n, double *a, const int *lda, int *ipiv,
+	     int *info);
+void dgeqrf_(const int *m, const int *n, double *a, const int *lda, double *tau,
+	     double *work, const int *lwork, int *info);
+void dgesdd_(const char *jobz, const int *m, const int *n, double *a,
+	     const int *lda, double *s, double *u, const int *ldu, double *vt,
+	     const int *ldvt, double *work, const int *lwork, int *iwork, int *info);
+void dpotrf_(const char *uplo, const int *n, double *a, const int *lda, int *info);
+void dsyevd_(const char *jobz, const char *uplo, const int *n, double *a,
+	     const int *lda, double *w, double *work, const int *lwork, int *iwork,
+	     const int *liwork, int *info);
+
+static int lapack_engine = 1;
+
+int mygsl_lapack_active(void)
+{
+  return lapack_engine;
+}
+
+/* A (rows x cols, row-major with tda) to and from a column-major copy */
+static double* lapack_colmajor(const gsl_matrix *A)
+{
+  size_t i, j, m = A->size1;
+  double *c = (double *) malloc(sizeof(double)*A->size1*A->size2);
+  if (c == NULL) return NULL;
+  for (i = 0; i < A->size1; i++)
+    for (j = 0; j < A->size2; j++) c[i + j*m] = A->data[i*A->tda + j];
+  return c;
+}
+
+static void lapack_rowmajor(const double *c, gsl_matrix *A)
+{
+  size_t i, j, m = A->size1;
+  for (i = 0; i < A->size1; i++)
+    for (j = 0; j < A->size2; j++) A->data[i*A->tda + j] = c[i + j*m];
+}
+
+/* PA = LU: ipiv holds the row interchanges in GSL's order, so that p is
+   the one of gsl_linalg_LU_decomp */
+int mygsl_lapack_LU_decomp(gsl_matrix *A, gsl_permutation *p, int *signum)
+{
+  int m = (int) A->size1, n = (int) A->size2, k = GSL_MIN(m, n), info, i;
+  int *ipiv;
+  double *c;
+  if (p->size != A->size1)
+    GSL_ERROR("permutation length must match matrix size", GSL_EBADLEN);
+  c = lapack_colmajor(A);
+  ipiv = (int *) malloc(sizeof(int)*(k > 0 ? k : 1));
+  if (c == NULL || ipiv == NULL) {
+    free(c);
+    free(ipiv);
+    GSL_ERROR("failed to allocate LAPACK workspace", GSL_ENOMEM);
+  }
+  dgetrf_(&m, &n, c, &m, ipiv, &info);
+  lapack_rowmajor(c, A);
+  gsl_permutation_init(p);
+  *signum = 1;
+  for (i = 0; i < k; i++) {
+    if (ipiv[i] - 1 != i) {
+      gsl_permutation_swap(p, i, ipiv[i] - 1);
+      *signum = -(*signum);
+    }
+  }
+  free(c);
+  free(ipiv);
+  /* info > 0 is a zero pivot: the factorization is still complete, and
+     GSL reports the singularity at the solve */
+  return info < 0 ? GSL_EINVAL : GSL_SUCCESS;
+}
+
+int mygsl_lapack_QR_decomp(gsl_matrix *A, gsl_vector *tau)
+{
+  int m = (int) A->size1, n = (int) A->size2, k = GSL_MIN(m, n), lwork = -1, info, i;
+  double *c, *t, *work, wq;
+  if (tau->size != (size_t) k)
+    GSL_ERROR("size of tau must be MIN(M,N)", GSL_EBADLEN);
+  c = lapack_colmajor(A);
+  t = (double *) malloc(sizeof(double)*(k > 0 ? k : 1));
+  if (c == NULL || t == NULL) goto nomem;
+  dgeqrf_(&m, &n, c, &m, t, &wq, &lwork, &info);
+  lwork = (int) wq;
+  if (lwork < 1) lwork = 1;
+  if ((work = (double *) malloc(sizeof(double)*lwork)) == NULL) goto nomem;
+  dgeqrf_(&m, &n, c, &m, t, work, &lwork, &info);
+  free(work);
+  lapack_rowmajor(c, A);
+  for (i = 0; i < k; i++) gsl_vector_set(tau, i, t[i]);
+  free(c);
+  free(t);
+  return GSL_SUCCESS;
+ nomem:
+  free(c);
+  free(t);
+  GSL_ERROR("failed to allocate LAPACK workspace", GSL_ENOMEM);
+}
+
+/* A = U S V^T with U in A, M >= N; work is unused */
+int mygsl_lapack_SV_decomp(gsl_matrix *A, gsl_matrix *V, gsl_vector *S)
+{
+  int m = (int) A->size1, n = (int) A->size2, lwork = -1, info, *iwork = NULL;
+  size_t i, j;
+  double *c, *u = NULL, *vt = NULL, *s = NULL, *work = NULL, wq;
+  if (V->size1 != A->size2 || V->size2 != A->size2)
+    GSL_ERROR("square matrix V must match second dimension of matrix A", GSL_EBADLEN);
+  if (S->size != A->size2)
+    GSL_ERROR("length of vector S must match second dimension of matrix A", GSL_EBADLEN);
+  c = lapack_colmajor(A);
+  u = (double *) malloc(sizeof(double)*m*n);
+  vt = (double *) malloc(sizeof(double)*n*n);
+  s = (double *) malloc(sizeof(double)*n);
+  iwork = (int *) malloc(sizeof(int)*8*n);
+  if (c == NULL || u == NULL || vt == NULL || s == NULL || iwork == NULL) goto nomem;
+  dgesdd_("S", &m, &n, c, &m, s, u, &m, vt, &n, &wq, &lwork, iwork, &info);
+  lwork = (int) wq;
+  if (lwork < 1) lwork = 1;
+  if ((work = (double *) malloc(sizeof(double)*lwork)) == NULL) goto nomem;
+  dgesdd_("S", &m, &n, c, &m, s, u, &m, vt, &n, work, &lwork, iwork, &info);
+  if (info == 0) {
+    lapack_rowmajor(u, A);
+    for (i = 0; i < (size_t) n; i++) {
+      gsl_vector_set(S, i, s[i]);
+      for (j = 0; j < (size_t) n; j++) gsl_matrix_set(V, i, j, vt[j + i*n]);
+    }
+  }
+  free(c); free(u); free(vt); free(s); free(iwork); free(work);
+  if (info > 0) GSL_ERROR("dgesdd did not converge", GSL_EMAXITER);
+  return info < 0 ? GSL_EINVAL : GSL_SUCCESS;
+ nomem:
+  free(c); free(u); free(vt); free(s); free(iwork); free(work);
+  GSL_ERROR("failed to allocate LAPACK workspace", GSL_ENOMEM);
+}
+
+/* Row-major L is column-major U: dpotrf works in place.  L^T is then
+   copied to the upper triangle, as gsl_linalg_cholesky_decomp does. */
+int mygsl_lapack_cholesky_decomp(gsl_matrix *A)
+{
+  int n = (int) A->size1, lda = (int) A->tda, info;
+  size_t i, j;
+  if (A->size1 != A->size2) GSL_ERROR("cholesky decomposition requires square matrix", GSL_ENOTSQR);
+  dpotrf_("U", &n, A->data, &lda, &info);
+  if (info > 0) GSL_ERROR("matrix is not positive definite", GSL_EDOM);
+  for (i = 0; i < A->size1; i++)
+    for (j = 0; j < i; j++) A->data[j*A->tda + i] = A->data[i*A->tda + j];
+  return info < 0 ? GSL_EINVAL : GSL_SUCCESS;
+}
+
+/* Eigenvalues (ascending) of symmetric A, and its eigenvectors in the
+   columns of evec when evec is not NULL.  Only the lower triangle is
+   read, as by gsl_eigen_symmv; A is destroyed when evec is NULL. */
+int mygsl_lapack_symmv(gsl_matrix *A, gsl_vector *eval, gsl_matrix *evec)
+{
+  int n = (int) A->size1, lda, lwork = -1, liwork = -1, info, iwq;
+  size_t i, j;
+  double *a, *w, *work = NULL, wq, t;
+  int *iwork = NULL;
+  const char *jobz = evec ? "V" : "N";
+  if (A->size1 != A->size2) GSL_ERROR("matrix must be square to compute eigenvalues", GSL_ENOTSQR);
+  if (eval->size != A->size1) GSL_ERROR("eigenvalue vector must match matrix size", GSL_EBADLEN);
+  if (evec) {
+    if (evec->size1 != A->size1 || evec->size2 != A->size1)
+      GSL_ERROR("eigenvector matrix must match matrix size", GSL_EBADLEN);
+    gsl_matrix_memcpy(evec, A);
+    a = evec->data;
+    lda = (int) evec->tda;
+  } else {
+    a = A->data;
+    lda = (int) A->tda;
+  }
+  if ((w = (double *) malloc(sizeof(double)*(n > 0 ? n : 1))) == NULL)
+    GSL_ERROR("failed to allocate LAPACK workspace", GSL_ENOMEM);
+  dsyevd_(jobz, "U", &n, a, &lda, w, &wq, &lwork, &iwq, &liwork, &info);
+  lwork = GSL_MAX((int) wq, 1);
+  liwork = GSL_MAX(iwq, 1);
+  work = (double *) malloc(sizeof(double)*lwork);
+  iwork = (int *) malloc(sizeof(int)*liwork);
+  if (work == NULL || iwork == NULL) {
+    free(w); free(work); free(iwork);
+    GSL_ERROR("failed to allocate LAPACK workspace", GSL_ENOMEM);
+  }
+  dsyevd_(jobz, "U", &n, a, &lda, w, work, &lwork, iwork, &liwork, &info);
+  free(work);
+  free(iwork);
+  if (info == 0) {
+    for (i = 0; i < (size_t) n; i++) gsl_vector_set(eval, i, w[i]);
+    /* the eigenvectors are the columns of the column-major result */
+    if (evec) {
+      for (i = 0; i < evec->size1; i++)
+	for (j = 0; j < i; j++) {
+	  t = evec->data[i*evec->tda + j];
+	  evec->data[i*evec->tda + j] = evec->data[j*evec->tda + i];
+	  evec->data[j*evec->tda + i] = t;
+	}
+    }
+  }
+  free(w);
+  if (info > 0) GSL_ERROR("dsyevd did not converge", GSL_EMAXITER);
+  return info < 0 ? GSL_EINVAL : GSL_SUCCESS;
+}
+#endif
+
+static VALUE rb_gsl_linalg_engine(VALUE module)
+{
+#ifdef HAVE_LAPACK
+  if (lapack_engine) return ID2SYM(rb_intern("lapack"));
+#endif
+  return ID2SYM(rb_intern("gsl"));
+}
+
+static VALUE rb_gsl_linalg_set_engine(VALUE module, VALUE engine)
+{
+  if (engine == ID2SYM(rb_intern("gsl"))) {
+#ifdef HAVE_LAPACK
+    lapack_engine = 0;
+#endif
+  } else if (engine == ID2SYM(rb_intern("lapack"))) {
+#ifdef HAVE_LAPACK
+    lapack_engine = 1;
+#else
+    rb_raise(rb_eNotImpError, "Ruby/GSL was built without LAPACK");
+#endif
+  } else {
+    rb_raise(rb_eArgError, "engine must be :gsl or :lapack");
+  }
+  return engine;
+}
+
+void Init_gsl_linalg_lapack(VALUE module)
+{
+  rb_define_module_function(module, "engine", rb_gsl_linalg_engine, 0);
+  rb_define_module_function(module, "engine=", rb_gsl_linalg_set_engine, 1);
+}
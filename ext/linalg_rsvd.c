@@ -0,0 +1,232 @@
+/*
+  linalg_rsvd.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The k largest singular triplets of an m x n matrix by randomized
+  range finding (Halko, Martinsson and Tropp, SIAM Review 53, 2011).
+
+    u, v, s = GSL::Linalg::SV.randomized(a, 100, :power => 2)
+
+  a is a GSL::Matrix (including one from Matrix.mmap) or a
+  GSL::SpMatrix.  The result has the layout of SV.decomp, truncated to
+  rank k: U (m x k), V (n x k) and the k singular values in decreasing
+  order, with a ~ U diag(S) V^T.
+
+  The range of a is sampled by Y = A Omega, for a Gaussian Omega of
+  l = k + :oversample (10) columns, and Q is an orthonormal basis of Y.
+  :power (2) passes of Y = A (A^T Q), each product followed by a
+  Householder QR, sharpen the basis when the singular values decay
+  slowly.  The small SVD of B^T = A^T Q (n x l) gives the triplets.
+  The cost is O((2 :power + 2) (mn or nnz) l) for the products, plus
+  O((m + n) l^2); only O((m + n) l) memory is used besides a.  :seed
+  selects the Gaussian sample (0 by default, so results are
+  reproducible).  The iteration runs with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_randist.h>
+
+static VALUE cgsl_matrix_U, cgsl_matrix_V, cgsl_vector_S;
+
+typedef struct {
+  size_t m, n, k, l, power;
+  const gsl_matrix *A;
+  const mygsl_csr *csr, *csrt;  /* or sparse A, and A^T */
+  gsl_matrix *Om;               /* n x l: Omega, then the basis of A^T Q */
+  gsl_matrix *Y, *Q;            /* m x l */
+  gsl_matrix *Z;                /* n x l: A^T Q */
+  gsl_matrix *Vs;               /* l x l */
+  gsl_vector *S, *tau_m, *tau_n, *work;
+  gsl_matrix *U, *V;            /* results, m x k and n x k */
+  gsl_vector *Sk;
+} mygsl_rsvd;
+
+/* C = A B for compressed rows A: row r of C is a combination of the
+   rows of B */
+static void rsvd_csr_mul(const mygsl_csr *a, const gsl_matrix *B, gsl_matrix *C)
+{
+  size_t r, k, j, l = B->size2;
+  double v, *c;
+  const double *b;
+  for (r = 0; r < a->n; r++) {
+    c = C->data + r*C->tda;
+    for (j = 0; j < l; j++) c[j] = 0.0;
+    for (k = a->rowptr[r]; k < a->rowptr[r+1]; k++) {
+      v = a->val[k];
+      b = B->data + a->col[k]*B->tda;
+      for (j = 0; j < l; j++) c[j] += v*b[j];
+    }
+  }
+}
+
+/* Y = A X (m x l), or Z = A^T X (n x l) when trans */
+static void rsvd_apply(const mygsl_rsvd *s, int trans, const gsl_matrix *X,
+		       gsl_matrix *Y)
+{
+  if (s->A) {
+    gsl_blas_dgemm(trans ? CblasTrans : CblasNoTrans, CblasNoTrans, 1.0, s->A,
+		   X, 0.0, Y);
+  } else {
+    rsvd_csr_mul(trans ? s->csrt : s->csr, X, Y);
+  }
+}
+
+/* Q: an orthonormal basis of the columns of X (r x l, r >= l), by
+   Householder QR of X in place: Q = H_1 ... H_l [I; 0] */
+static int rsvd_orth(gsl_matrix *X, gsl_vector *tau, gsl_matrix *Q)
+{
+  size_t j;
+  int status = gsl_linalg_QR_decomp(X, tau);
+  if (status) return status;
+  gsl_matrix_set_zero(Q);
+  for (j = 0; j < Q->size2; j++) {
+    gsl_vector_view q = gsl_matrix_column(Q, j);
+    gsl_vector_set(&q.vector, j, 1.0);
+    gsl_linalg_QR_Qvec(X, tau, &q.vector);
+  }
+  return GSL_SUCCESS;
+}
+
+static int rsvd_run(void *data)
+{
+  mygsl_rsvd *s = (mygsl_rsvd *) data;
+  gsl_matrix_view Vk, Wk;
+  gsl_vector_view Sl;
+  size_t i;
+  int status;
+  rsvd_apply(s, 0, s->Om, s->Y);
+  if ((status = rsvd_orth(s->Y, s->tau_m, s->Q))) return status;
+  for (i = 0; i < s->power; i++) {
+    rsvd_apply(s, 1, s->Q, s->Z);
+    if ((status = rsvd_orth(s->Z, s->tau_n, s->Om))) return status;
+    rsvd_apply(s, 0, s->Om, s->Y);
+    if ((status = rsvd_orth(s->Y, s->tau_m, s->Q))) return status;
+  }
+  /* B^T = A^T Q = W S Vs^T, so that A ~ Q B = (Q Vs) S W^T */
+  rsvd_apply(s, 1, s->Q, s->Z);
+  if ((status = gsl_linalg_SV_decomp(s->Z, s->Vs, s->S, s->work))) return status;
+  Vk = gsl_matrix_submatrix(s->Vs, 0, 0, s->l, s->k);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, s->Q, &Vk.matrix, 0.0, s->U);
+  Wk = gsl_matrix_submatrix(s->Z, 0, 0, s->n, s->k);
+  gsl_matrix_memcpy(s->V, &Wk.matrix);
+  Sl = gsl_vector_subvector(s->S, 0, s->k);
+  gsl_vector_memcpy(s->Sk, &Sl.vector);
+  return GSL_SUCCESS;
+}
+
+/* Workspace owned by the GC, so that nothing leaks when a raise
+   interrupts the solve */
+static gsl_matrix* rsvd_matrix(size_t n1, size_t n2, VALUE keep)
+{
+  gsl_matrix *m = gsl_matrix_alloc(n1, n2);
+  if (m == NULL) rb_raise(rb_eNoMemError, "gsl_matrix_alloc failed");
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m));
+  return m;
+}
+
+static gsl_vector* rsvd_vector(size_t n, VALUE keep)
+{
+  gsl_vector *v = gsl_vector_alloc(n);
+  if (v == NULL) rb_raise(rb_eNoMemError, "gsl_vector_alloc failed");
+  rb_ary_push(keep, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v));
+  return v;
+}
+
+static void rsvd_set_matrix(mygsl_rsvd *s, VALUE va, VALUE keep)
+{
+  if (MATRIX_P(va)) {
+    Data_Get_Struct(va, gsl_matrix, s->A);
+    s->m = s->A->size1;
+    s->n = s->A->size2;
+    return;
+  }
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  if (rb_gsl_spmatrix_p(va)) {
+    gsl_spmatrix *m = rb_gsl_get_spmatrix(va);
+    mygsl_csr *c, *ct;
+    c = mygsl_csr_from_spmatrix(m);
+    if (c == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, mygsl_csr_free, c));
+    ct = mygsl_csr_transpose(c, m->size2);
+    if (ct == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, mygsl_csr_free, ct));
+    s->csr = c;
+    s->csrt = ct;
+    s->m = m->size1;
+    s->n = m->size2;
+    return;
+  }
+#endif
+  rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix or GSL::SpMatrix expected)",
+	   rb_class2name(CLASS_OF(va)));
+}
+
+/* GSL::Linalg::SV.randomized(a, k, opts = {}): see the top of the file */
+static VALUE rb_gsl_linalg_SV_randomized(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_rsvd s;
+  VALUE opts, v, keep = rb_ary_new(), vu, vv, vs;
+  size_t oversample = 10, i, j;
+  unsigned long seed = 0;
+  gsl_rng *r;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  memset(&s, 0, sizeof(s));
+  s.power = 2;
+  rsvd_set_matrix(&s, argv[0], keep);
+  s.k = NUM2SIZET(argv[1]);
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("oversample")))))
+      oversample = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("power"))))) s.power = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("seed"))))) seed = NUM2ULONG(v);
+  }
+  if (s.k == 0 || s.k > GSL_MIN(s.m, s.n))
+    rb_raise(rb_eArgError, "k must be in 1 ... %d", (int) GSL_MIN(s.m, s.n));
+  s.l = GSL_MIN(s.k + oversample, GSL_MIN(s.m, s.n));
+  s.Om = rsvd_matrix(s.n, s.l, keep);
+  s.Y = rsvd_matrix(s.m, s.l, keep);
+  s.Q = rsvd_matrix(s.m, s.l, keep);
+  s.Z = rsvd_matrix(s.n, s.l, keep);
+  s.Vs = rsvd_matrix(s.l, s.l, keep);
+  s.S = rsvd_vector(s.l, keep);
+  s.tau_m = rsvd_vector(s.l, keep);
+  s.tau_n = rsvd_vector(s.l, keep);
+  s.work = rsvd_vector(s.l, keep);
+  r = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(r, seed);
+  for (i = 0; i < s.n; i++)
+    for (j = 0; j < s.l; j++) gsl_matrix_set(s.Om, i, j, gsl_ran_ugaussian(r));
+  gsl_rng_free(r);
+  s.U = gsl_matrix_alloc(s.m, s.k);
+  vu = Data_Wrap_Struct(cgsl_matrix_U, 0, gsl_matrix_free, s.U);
+  s.V = gsl_matrix_alloc(s.n, s.k);
+  vv = Data_Wrap_Struct(cgsl_matrix_V, 0, gsl_matrix_free, s.V);
+  s.Sk = gsl_vector_alloc(s.k);
+  vs = Data_Wrap_Struct(cgsl_vector_S, 0, gsl_vector_free, s.Sk);
+  rb_gsl_nogvl_call(rsvd_run, &s, (s.m*s.n + s.m*s.l)*s.l);
+  RB_GC_GUARD(keep);
+  return rb_ary_new3(3, vu, vv, vs);
+}
+
+void Init_gsl_linalg_rsvd(VALUE module)
+{
+  VALUE mgsl_linalg_SV = rb_const_get(module, rb_intern("SV"));
+  cgsl_matrix_U = rb_const_get(mgsl_linalg_SV, rb_intern("UMatrix"));
+  cgsl_matrix_V = rb_const_get(mgsl_linalg_SV, rb_intern("VMatrix"));
+  cgsl_vector_S = rb_const_get(mgsl_linalg_SV, rb_intern("SingularValues"));
+  rb_define_module_function(mgsl_linalg_SV, "randomized", rb_gsl_linalg_SV_randomized, -1);
+}
@@ -0,0 +1,292 @@
+/*
+  marshal.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Marshal support: _dump and _load of GSL::Vector, Vector::Int,
+  Vector::Complex, Matrix, Matrix::Int, Matrix::Complex, Histogram and
+  Permutation, as a binary string holding the shape and a contiguous
+  copy of the elements, so that
+
+    s = Marshal.dump(GSL::Matrix.alloc(1000, 1000))
+    m = Marshal.load(s)
+
+  costs a memcpy each way instead of a conversion through Arrays.
+
+  The string is an 8-byte header, "RGSL", the format version (1), the
+  kind of object ('v', 'i', 'z' vectors, 'V', 'I', 'Z' matrices, 'h'
+  histogram, 'p' permutation), the byte order of the writer ('l' or 'b')
+  and the size of the elements, followed by the dimensions as 64-bit
+  integers and the elements in the byte order of the writer: strided
+  vectors and matrix views are compacted.  A dump read on a machine of
+  the other byte order is swapped on load.
+
+  Views load as the vector or matrix they are views of (a column vector
+  as a column vector), since what they looked into is not dumped.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_histogram.h"
+#include "rb_gsl_common.h"
+#include <stdint.h>
+#include <string.h>
+
+#define MARSHAL_VERSION 1
+#define MARSHAL_HEADER 8
+
+static char marshal_byte_order(void)
+{
+  const uint32_t one = 1;
+  return *(const char *) &one ? 'l' : 'b';
+}
+
+static void marshal_swap(char *p, size_t n, size_t esize)
+{
+  size_t i, j;
+  char t;
+  for (i = 0; i < n; i++, p += esize)
+    for (j = 0; j < esize/2; j++) {
+      t = p[j];
+      p[j] = p[esize - 1 - j];
+      p[esize - 1 - j] = t;
+    }
+}
+
+/* A string for ndims dimensions and n elements of esize bytes, with
+   its header and dimensions written; *data points to the elements */
+static VALUE marshal_new(char kind, const size_t *dims, int ndims,
+                         size_t n, size_t esize, char **data)
+{
+  VALUE str;
+  char *p;
+  uint64_t d;
+  int i;
+  if (n > (LONG_MAX - MARSHAL_HEADER - 8*ndims)/esize)
+    rb_raise(rb_eRangeError, "too large to dump");
+  str = rb_str_new(NULL, MARSHAL_HEADER + 8*ndims + n*esize);
+  p = RSTRING_PTR(str);
+  memcpy(p, "RGSL", 4);
+  p[4] = MARSHAL_VERSION;
+  p[5] = kind;
+  p[6] = marshal_byte_order();
+  p[7] = (char) esize;
+  p += MARSHAL_HEADER;
+  for (i = 0; i < ndims; i++, p += 8) {
+    d = dims[i];
+    memcpy(p, &d, 8);
+  }
+  *data = p;
+  return str;
+}
+
+/* The dimensions of a dump of the given kind; *swap is set when it was
+   written in the other byte order */
+static const char* marshal_parse(VALUE str, char kind, size_t esize,
+                                 size_t *dims, int ndims, int *swap)
+{
+  const char *p;
+  uint64_t d;
+  int i;
+  StringValue(str);
+  p = RSTRING_PTR(str);
+  if (RSTRING_LEN(str) < MARSHAL_HEADER + 8*ndims || memcmp(p, "RGSL", 4) != 0)
+    rb_raise(rb_eArgError, "not a dump of a GSL object");
+  if (p[4] != MARSHAL_VERSION)
+    rb_raise(rb_eArgError, "unknown dump format version %d", (int) p[4]);
+  if (p[5] != kind)
+    rb_raise(rb_eTypeError, "dump of the wrong kind ('%c' for '%c')", p[5], kind);
+  if ((size_t) (unsigned char) p[7] != esize)
+    rb_raise(rb_eArgError, "dump with elements of %d bytes (%d expected)",
+             (int) (unsigned char) p[7], (int) esize);
+  *swap = (p[6] != marshal_byte_order());
+  p += MARSHAL_HEADER;
+  for (i = 0; i < ndims; i++, p += 8) {
+    memcpy(&d, p, 8);
+    if (*swap) marshal_swap((char *) &d, 1, 8);
+    if (d > (uint64_t) LONG_MAX) rb_raise(rb_eArgError, "bad dimension in dump");
+    dims[i] = (size_t) d;
+  }
+  return p;
+}
+
+/* n elements of esize bytes must remain after data */
+static void marshal_check_size(VALUE str, const char *data, size_t n, size_t esize)
+{
+  size_t left = RSTRING_LEN(str) - (data - RSTRING_PTR(str));
+  if (n > left/esize || n*esize != left)
+    rb_raise(rb_eArgError, "dump of a wrong size");
+}
+
+static void marshal_get(void *dst, const char *src, size_t n, size_t esize, int swap)
+{
+  memcpy(dst, src, n*esize);
+  if (swap) marshal_swap(dst, n, esize);
+}
+
+/*
+  Vectors: the strided elements are copied one by one, the contiguous
+  ones at once.  e is the element size, c the number of scalars per
+  element (2 for complex).
+*/
+#define MARSHAL_VECTOR(name, t, kind, e, c, cls, col)                   \
+  static VALUE rb_gsl_##name##_dump(int argc, VALUE *argv, VALUE obj)   \
+  {                                                                     \
+    t *v;                                                               \
+    char *p;                                                            \
+    VALUE str;                                                          \
+    size_t i;                                                           \
+    Data_Get_Struct(obj, t, v);                                         \
+    str = marshal_new(kind, &v->size, 1, c*v->size, e, &p);             \
+    if (v->stride == 1) memcpy(p, v->data, c*e*v->size);                \
+    else for (i = 0; i < v->size; i++)                                  \
+      memcpy(p + c*e*i, v->data + c*i*v->stride, c*e);                  \
+    return str;                                                         \
+  }                                                                     \
+  static VALUE rb_gsl_##name##_load(VALUE klass, VALUE str)             \
+  {                                                                     \
+    t *v;                                                               \
+    size_t n;                                                           \
+    int swap;                                                           \
+    const char *p = marshal_parse(str, kind, e, &n, 1, &swap);          \
+    marshal_check_size(str, p, c*n, e);                                 \
+    if (n == 0) rb_raise(rb_eArgError, "dump of an empty vector");      \
+    v = t##_alloc(n);                                                   \
+    marshal_get(v->data, p, c*n, e, swap);                              \
+    return Data_Wrap_Struct(RTEST(rb_class_inherited_p(klass, col)) ? col : cls, \
+                            0, t##_free, v);                            \
+  }
+
+#define MARSHAL_MATRIX(name, t, kind, e, c, cls)                        \
+  static VALUE rb_gsl_##name##_dump(int argc, VALUE *argv, VALUE obj)   \
+  {                                                                     \
+    t *m;                                                               \
+    char *p;                                                            \
+    VALUE str;                                                          \
+    size_t i, dims[2];                                                  \
+    Data_Get_Struct(obj, t, m);                                         \
+    dims[0] = m->size1;                                                 \
+    dims[1] = m->size2;                                                 \
+    str = marshal_new(kind, dims, 2, c*m->size1*m->size2, e, &p);       \
+    if (m->tda == m->size2) memcpy(p, m->data, c*e*m->size1*m->size2);  \
+    else for (i = 0; i < m->size1; i++)                                 \
+      memcpy(p + c*e*i*m->size2, m->data + c*i*m->tda, c*e*m->size2);   \
+    return str;                                                         \
+  }                                                                     \
+  static VALUE rb_gsl_##name##_load(VALUE klass, VALUE str)             \
+  {                                                                     \
+    t *m;                                                               \
+    size_t dims[2];                                                     \
+    int swap;                                                           \
+    const char *p = marshal_parse(str, kind, e, dims, 2, &swap);        \
+    if (dims[0] == 0 || dims[1] == 0)                                   \
+      rb_raise(rb_eArgError, "dump of an empty matrix");                \
+    if (dims[0] > LONG_MAX/dims[1]) rb_raise(rb_eArgError, "bad dimension in dump"); \
+    marshal_check_size(str, p, c*dims[0]*dims[1], e);                   \
+    m = t##_alloc(dims[0], dims[1]);                                    \
+    marshal_get(m->data, p, c*dims[0]*dims[1], e, swap);                \
+    return Data_Wrap_Struct(cls, 0, t##_free, m);                       \
+  }
+
+MARSHAL_VECTOR(vector, gsl_vector, 'v', sizeof(double), 1, cgsl_vector,
+               cgsl_vector_col)
+MARSHAL_VECTOR(vector_int, gsl_vector_int, 'i', sizeof(int), 1, cgsl_vector_int,
+               cgsl_vector_int_col)
+MARSHAL_VECTOR(vector_complex, gsl_vector_complex, 'z', sizeof(double), 2,
+               cgsl_vector_complex, cgsl_vector_complex_col)
+MARSHAL_MATRIX(matrix, gsl_matrix, 'V', sizeof(double), 1, cgsl_matrix)
+MARSHAL_MATRIX(matrix_int, gsl_matrix_int, 'I', sizeof(int), 1, cgsl_matrix_int)
+MARSHAL_MATRIX(matrix_complex, gsl_matrix_complex, 'Z', sizeof(double), 2,
+               cgsl_matrix_complex)
+
+/* Histogram: n, then the n+1 ranges and the n bins */
+static VALUE rb_gsl_histogram_dump(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_histogram *h;
+  char *p;
+  Data_Get_Struct(obj, gsl_histogram, h);
+  obj = marshal_new('h', &h->n, 1, 2*h->n + 1, sizeof(double), &p);
+  memcpy(p, h->range, (h->n + 1)*sizeof(double));
+  memcpy(p + (h->n + 1)*sizeof(double), h->bin, h->n*sizeof(double));
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_load(VALUE klass, VALUE str)
+{
+  gsl_histogram *h;
+  size_t n;
+  int swap;
+  const char *p = marshal_parse(str, 'h', sizeof(double), &n, 1, &swap);
+  if (n == 0 || n > LONG_MAX/2) rb_raise(rb_eArgError, "bad histogram size in dump");
+  marshal_check_size(str, p, 2*n + 1, sizeof(double));
+  h = gsl_histogram_alloc(n);
+  marshal_get(h->range, p, n + 1, sizeof(double), swap);
+  marshal_get(h->bin, p + (n + 1)*sizeof(double), n, sizeof(double), swap);
+  return Data_Wrap_Struct(klass, 0, gsl_histogram_free, h);
+}
+
+/* Permutation: the elements as 64-bit integers, whatever size_t is */
+static VALUE rb_gsl_permutation_dump(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_permutation *perm;
+  char *p;
+  uint64_t d;
+  size_t i;
+  Data_Get_Struct(obj, gsl_permutation, perm);
+  obj = marshal_new('p', &perm->size, 1, perm->size, 8, &p);
+  for (i = 0; i < perm->size; i++, p += 8) {
+    d = perm->data[i];
+    memcpy(p, &d, 8);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_permutation_load(VALUE klass, VALUE str)
+{
+  gsl_permutation *perm;
+  size_t n, i;
+  uint64_t d;
+  int swap;
+  const char *p = marshal_parse(str, 'p', 8, &n, 1, &swap);
+  marshal_check_size(str, p, n, 8);
+  if (n == 0) rb_raise(rb_eArgError, "dump of an empty permutation");
+  perm = gsl_permutation_alloc(n);
+  for (i = 0; i < n; i++, p += 8) {
+    memcpy(&d, p, 8);
+    if (swap) marshal_swap((char *) &d, 1, 8);
+    perm->data[i] = (size_t) d;
+  }
+  if (gsl_permutation_valid(perm) != GSL_SUCCESS) {
+    gsl_permutation_free(perm);
+    rb_raise(rb_eArgError, "dump of an invalid permutation");
+  }
+  return Data_Wrap_Struct(klass, 0, gsl_permutation_free, perm);
+}
+
+void Init_gsl_marshal(VALUE module)
+{
+  rb_define_method(cgsl_vector, "_dump", rb_gsl_vector_dump, -1);
+  rb_define_singleton_method(cgsl_vector, "_load", rb_gsl_vector_load, 1);
+  rb_define_method(cgsl_vector_int, "_dump", rb_gsl_vector_int_dump, -1);
+  rb_define_singleton_method(cgsl_vector_int, "_load", rb_gsl_vector_int_load, 1);
+  rb_define_method(cgsl_vector_complex, "_dump", rb_gsl_vector_complex_dump, -1);
+  rb_define_singleton_method(cgsl_vector_complex, "_load", rb_gsl_vector_complex_load, 1);
+
+  rb_define_method(cgsl_matrix, "_dump", rb_gsl_matrix_dump, -1);
+  rb_define_singleton_method(cgsl_matrix, "_load", rb_gsl_matrix_load, 1);
+  rb_define_method(cgsl_matrix_int, "_dump", rb_gsl_matrix_int_dump, -1);
+  rb_define_singleton_method(cgsl_matrix_int, "_load", rb_gsl_matrix_int_load, 1);
+  rb_define_method(cgsl_matrix_complex, "_dump", rb_gsl_matrix_complex_dump, -1);
+  rb_define_singleton_method(cgsl_matrix_complex, "_load", rb_gsl_matrix_complex_load, 1);
+
+  rb_define_method(cgsl_histogram, "_dump", rb_gsl_histogram_dump, -1);
+  rb_define_singleton_method(cgsl_histogram, "_load", rb_gsl_histogram_load, 1);
+  rb_define_method(cgsl_permutation, "_dump", rb_gsl_permutation_dump, -1);
+  rb_define_singleton_method(cgsl_permutation, "_load", rb_gsl_permutation_load, 1);
+}
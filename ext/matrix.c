@@ -19,6 +19,7 @@
 #include "rb_gsl_histogram.h"
 #include "rb_gsl_complex.h"
 #include "rb_gsl_poly.h"
+#include "rb_gsl_sf.h"
 #ifdef HAVE_NARRAY_H
 #include "rb_gsl_with_narray.h"
 #endif
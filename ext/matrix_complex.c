@@ -85,7 +85,7 @@ static VALUE rb_gsl_matrix_complex_arithmetics(int flag, VALUE obj, VALUE bb)
 	break;
       case GSL_MATRIX_COMPLEX_MUL:
 	cmnew = make_matrix_complex_clone(cm);
-	gsl_matrix_complex_mul_elements(cmnew, cmb);
+	mygsl_matrix_complex_mul_elements(cmnew, cmb);
 	return Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, cmnew);
 	break;
       case GSL_MATRIX_COMPLEX_DIV:
@@ -109,7 +109,7 @@ static VALUE rb_gsl_matrix_complex_arithmetics(int flag, VALUE obj, VALUE bb)
 	gsl_matrix_complex_sub(cmnew,cmb);
 	break;
       case GSL_MATRIX_COMPLEX_MUL:
-	gsl_matrix_complex_mul_elements(cmnew, cmb);
+	mygsl_matrix_complex_mul_elements(cmnew, cmb);
 	break;
       case GSL_MATRIX_COMPLEX_DIV:
 	gsl_matrix_complex_div_elements(cmnew, cmb);
@@ -282,6 +282,7 @@ static VALUE rb_gsl_matrix_complex_set_all(VALUE obj, VALUE s)
 {
   gsl_matrix_complex *m = NULL;
   gsl_complex c, *z = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_matrix_complex, m);
   switch (TYPE(s)) {
   case T_FLOAT:
@@ -325,6 +326,7 @@ static VALUE rb_gsl_matrix_complex_set(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-5)", argc);
   }
 
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_matrix_complex, m);
   other = argv[argc-1];
 
@@ -740,7 +742,7 @@ static VALUE rb_gsl_matrix_complex_memcpy(VALUE obj, VALUE dst, VALUE src)
   return dst;
 }
 
-static VALUE rb_gsl_matrix_complex_clone(VALUE obj)
+static VALUE rb_gsl_matrix_complex_dup(VALUE obj)
 {
   gsl_matrix_complex *m, *mnew = NULL;
   Data_Get_Struct(obj, gsl_matrix_complex, m);
@@ -750,6 +752,12 @@ static VALUE rb_gsl_matrix_complex_clone(VALUE obj)
   return Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, mnew);
 }
 
+/* shares the data of a frozen matrix, see rb_gsl_array_clone in array.c */
+static VALUE rb_gsl_matrix_complex_clone(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_array_clone(argc, argv, obj, rb_gsl_matrix_complex_dup);
+}
+
 static VALUE rb_gsl_matrix_complex_swap_rows(VALUE obj, VALUE i, VALUE j)
 {
   gsl_matrix_complex *m = NULL;
@@ -1100,26 +1108,12 @@ static VALUE rb_gsl_matrix_complex_imag(VALUE obj)
 
 static void gsl_matrix_complex_conjugate(gsl_matrix_complex *cm)
 {
-  gsl_complex z;
-  size_t i, j;
-  for (i = 0; i < cm->size1; i++) {
-    for (j = 0; j < cm->size2; j++) {
-      z = gsl_matrix_complex_get(cm, i, j);
-      gsl_matrix_complex_set(cm, i, j, gsl_complex_conjugate(z));
-    }
-  }
+  mygsl_matrix_complex_conjugate(cm, cm);
 }
 
 static void gsl_matrix_complex_conjugate2(gsl_matrix_complex *cmnew, gsl_matrix_complex *cm)
 {
-  gsl_complex z;
-  size_t i, j;
-  for (i = 0; i < cm->size1; i++) {
-    for (j = 0; j < cm->size2; j++) {
-      z = gsl_matrix_complex_get(cm, i, j);
-      gsl_matrix_complex_set(cmnew, i, j, gsl_complex_conjugate(z));
-    }
-  }
+  mygsl_matrix_complex_conjugate(cmnew, cm);
 }
 
 static VALUE rb_gsl_matrix_complex_conjugate(VALUE obj)
@@ -1254,19 +1248,31 @@ static VALUE rb_gsl_matrix_complex_XXX(VALUE obj, double (*f)(gsl_complex))
   return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
 }
 
+/* arg, abs and abs2 through the kernels of vecmath.c */
+static VALUE rb_gsl_matrix_complex_cmath(VALUE obj, int fn)
+{
+  gsl_matrix_complex *m;
+  gsl_matrix *mnew;
+  Data_Get_Struct(obj, gsl_matrix_complex, m);
+  mnew = gsl_matrix_alloc(m->size1, m->size2);
+  if (mnew == NULL) rb_raise(rb_eNoMemError, "gsl_matrix_alloc failed");
+  mygsl_matrix_complex_cmath(mnew, m, fn);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+}
+
 static VALUE rb_gsl_matrix_complex_arg(VALUE obj)
 {
-  return rb_gsl_matrix_complex_XXX(obj, gsl_complex_arg);
+  return rb_gsl_matrix_complex_cmath(obj, MYGSL_CMATH_ARG);
 }
 
 static VALUE rb_gsl_matrix_complex_abs(VALUE obj)
 {
-  return rb_gsl_matrix_complex_XXX(obj, gsl_complex_abs);
+  return rb_gsl_matrix_complex_cmath(obj, MYGSL_CMATH_ABS);
 }
 
 static VALUE rb_gsl_matrix_complex_abs2(VALUE obj)
 {
-  return rb_gsl_matrix_complex_XXX(obj, gsl_complex_abs2);
+  return rb_gsl_matrix_complex_cmath(obj, MYGSL_CMATH_ABS2);
 }
 
 static VALUE rb_gsl_matrix_complex_logabs(VALUE obj)
@@ -1605,9 +1611,9 @@ void Init_gsl_matrix_complex(VALUE module)
   rb_define_method(cgsl_matrix_complex, "fscanf", rb_gsl_matrix_complex_fscanf, 1);
   
   rb_define_singleton_method(cgsl_matrix_complex, "memcpy", rb_gsl_matrix_complex_memcpy, 2);
-  rb_define_method(cgsl_matrix_complex, "clone", rb_gsl_matrix_complex_clone, 0);
-  rb_define_alias(cgsl_matrix_complex, "duplicate", "clone");
-  rb_define_alias(cgsl_matrix_complex, "dup", "clone");
+  rb_define_method(cgsl_matrix_complex, "clone", rb_gsl_matrix_complex_clone, -1);
+  rb_define_method(cgsl_matrix_complex, "dup", rb_gsl_matrix_complex_dup, 0);
+  rb_define_alias(cgsl_matrix_complex, "duplicate", "dup");
   rb_define_method(cgsl_matrix_complex, "swap_rows", rb_gsl_matrix_complex_swap_rows, 2);
   rb_define_method(cgsl_matrix_complex, "swap_columns", rb_gsl_matrix_complex_swap_columns, 2);
   rb_define_method(cgsl_matrix_complex, "swap_rowcol", rb_gsl_matrix_complex_swap_rowcol, 2);
@@ -1644,7 +1650,7 @@ void Init_gsl_matrix_complex(VALUE module)
   rb_define_method(cgsl_matrix_complex, "subdiagonal", rb_gsl_matrix_complex_subdiagonal, 1);
   rb_define_method(cgsl_matrix_complex, "superdiagonal", rb_gsl_matrix_complex_superdiagonal, 1);
   
-  rb_define_method(cgsl_matrix_complex, "coerce", rb_gsl_matrix_complex_coerce, 1);
+  rb_gsl_define_coerce(cgsl_matrix_complex, rb_gsl_matrix_complex_coerce);
   
   rb_define_method(cgsl_matrix_complex, "mul", rb_gsl_matrix_complex_mul, 1);
   rb_define_alias(cgsl_matrix_complex, "*", "mul");
@@ -22,6 +22,16 @@ enum {
   GSL_MATRIX_DIV,
 };
 
+static int matrix_kernel_op(int flag)
+{
+  switch (flag) {
+  case GSL_MATRIX_ADD: return MYGSL_KERNEL_ADD;
+  case GSL_MATRIX_SUB: return MYGSL_KERNEL_SUB;
+  case GSL_MATRIX_MUL: return MYGSL_KERNEL_MUL;
+  default: return MYGSL_KERNEL_DIV;
+  }
+}
+
 static VALUE rb_gsl_matrix_arithmetics(int flag, VALUE obj, VALUE bb);
 VALUE rb_gsl_linalg_LU_solve(int argc, VALUE *argv, VALUE obj);
 
@@ -38,20 +48,12 @@ static VALUE rb_gsl_matrix_arithmetics(int flag, VALUE obj, VALUE bb)
   case T_FIXNUM:
     switch (flag) {
     case GSL_MATRIX_ADD:
-      mnew = make_matrix_clone(m);
-      gsl_matrix_add_constant(mnew, NUM2DBL(bb));
-      break;
     case GSL_MATRIX_SUB:
-      mnew = make_matrix_clone(m);
-      gsl_matrix_add_constant(mnew, -NUM2DBL(bb));
-      break;
     case GSL_MATRIX_MUL:
-      mnew = make_matrix_clone(m);
-      gsl_matrix_scale(mnew, NUM2DBL(bb));
-      break;
     case GSL_MATRIX_DIV:
-      mnew = make_matrix_clone(m);
-      gsl_matrix_scale(mnew, 1.0/NUM2DBL(bb));
+      mnew = gsl_matrix_alloc(m->size1, m->size2);
+      if (mnew == NULL) rb_raise(rb_eNoMemError, "gsl_matrix_alloc failed");
+      mygsl_matrix_binop_const(mnew, m, NUM2DBL(bb), matrix_kernel_op(flag));
       break;
     default:
       rb_raise(rb_eRuntimeError, "operation not defined");
@@ -67,20 +69,12 @@ static VALUE rb_gsl_matrix_arithmetics(int flag, VALUE obj, VALUE bb)
       Data_Get_Struct(bb, gsl_matrix, mb);
       switch (flag) {
       case GSL_MATRIX_ADD:
-	mnew = make_matrix_clone(m);
-	gsl_matrix_add(mnew, mb);
-	break;
       case GSL_MATRIX_SUB:
-	mnew = make_matrix_clone(m);
-	gsl_matrix_sub(mnew,mb);
-	break;
       case GSL_MATRIX_MUL:
-	mnew = make_matrix_clone(m);
-	gsl_matrix_mul_elements(mnew, mb);
-	break;
       case GSL_MATRIX_DIV:
-	mnew = make_matrix_clone(m);
-	gsl_matrix_div_elements(mnew, mb);
+	mnew = gsl_matrix_alloc(m->size1, m->size2);
+	if (mnew == NULL) rb_raise(rb_eNoMemError, "gsl_matrix_alloc failed");
+	mygsl_matrix_binop(mnew, m, mb, matrix_kernel_op(flag));
 	break;
       default:
 	rb_raise(rb_eRuntimeError, "operation not defined");
@@ -199,13 +193,20 @@ static VALUE rb_gsl_matrix_mul(VALUE obj, VALUE bb)
   gsl_matrix_complex *mc, *mcb, *mcnew;
   gsl_vector_complex *vc, *vcnew;
   gsl_complex za, zb;
+  VALUE vnew_obj;
   Data_Get_Struct(obj, gsl_matrix, m);
   if (VECTOR_INT_P(bb)) bb = rb_gsl_vector_int_to_f(bb);
+  if (rb_obj_is_kind_of(bb, cgsl_matrix_lazy))
+    return rb_gsl_matrix_lazy_mul(rb_gsl_matrix_lazy_operand(obj), bb);
   if (MATRIX_P(bb)) {
     Data_Get_Struct(bb, gsl_matrix, b);
+    if (m->size2 != b->size1)
+      rb_raise(rb_eRangeError, "matrix sizes do not match (%d x %d) * (%d x %d)",
+	       (int) m->size1, (int) m->size2, (int) b->size1, (int) b->size2);
     mnew = gsl_matrix_alloc(m->size1, b->size2);
-    gsl_linalg_matmult(m, b, mnew);
-    return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+    vnew_obj = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, m, b, 0.0, mnew);
+    return vnew_obj;
   } else if (VECTOR_P(bb)) {
     Data_Get_Struct(bb, gsl_vector, v);
     //    vnew = gsl_vector_alloc(v->size);
@@ -283,6 +284,60 @@ static VALUE rb_gsl_matrix_div_elements(VALUE obj, VALUE bb)
   return rb_gsl_matrix_arithmetics(GSL_MATRIX_DIV, obj, bb);
 }
 
+/* m.add(b[, out]), m.mul_elements(b, :out => out) etc. */
+static VALUE rb_gsl_matrix_arithmetics_out(int argc, VALUE *argv, VALUE obj,
+					   int flag, VALUE (*f)(VALUE, VALUE))
+{
+  gsl_matrix *m = NULL, *mout = NULL, *mb = NULL;
+  VALUE out, bb;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  out = (argc == 2) ? rb_gsl_out_arg(argv[1]) : Qnil;
+  if (NIL_P(out)) return (*f)(obj, argv[0]);
+  bb = argv[0];
+  CHECK_MATRIX(out);
+  Data_Get_Struct(obj, gsl_matrix, m);
+  Data_Get_Struct(out, gsl_matrix, mout);
+  switch (TYPE(bb)) {
+  case T_FLOAT:
+  case T_FIXNUM:
+  case T_BIGNUM:
+    mygsl_matrix_binop_const(mout, m, NUM2DBL(bb), matrix_kernel_op(flag));
+    break;
+  default:
+    if (MATRIX_INT_P(bb)) bb = rb_gsl_matrix_int_to_f(bb);
+    if (!MATRIX_P(bb))
+      rb_raise(rb_eTypeError, "wrong argument type %s (Matrix or Numeric expected)",
+	       rb_class2name(CLASS_OF(bb)));
+    Data_Get_Struct(bb, gsl_matrix, mb);
+    mygsl_matrix_binop(mout, m, mb, matrix_kernel_op(flag));
+    break;
+  }
+  return out;
+}
+
+static VALUE rb_gsl_matrix_add_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_arithmetics_out(argc, argv, obj, GSL_MATRIX_ADD, rb_gsl_matrix_add);
+}
+
+static VALUE rb_gsl_matrix_sub_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_arithmetics_out(argc, argv, obj, GSL_MATRIX_SUB, rb_gsl_matrix_sub);
+}
+
+static VALUE rb_gsl_matrix_mul_elements_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_arithmetics_out(argc, argv, obj, GSL_MATRIX_MUL, 
+				       rb_gsl_matrix_mul_elements);
+}
+
+static VALUE rb_gsl_matrix_div_elements_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_arithmetics_out(argc, argv, obj, GSL_MATRIX_DIV,
+				       rb_gsl_matrix_div_elements);
+}
+
 static VALUE rb_gsl_matrix_to_complex(VALUE obj)
 {
   gsl_matrix *m = NULL;
@@ -432,35 +487,52 @@ static VALUE rb_gsl_matrix_sub_inplace(VALUE mm1, VALUE mm2)
 }
 
 VALUE rb_gsl_sf_eval1(double (*func)(double), VALUE argv);
+VALUE rb_gsl_sf_eval1_out(double (*func)(double), VALUE x, VALUE out);
+
+/* Elementwise functions take an optional output buffer: obj.sin(out)
+   or obj.sin(:out => out) */
+static VALUE rb_gsl_matrix_eval1(int argc, VALUE *argv, VALUE obj, 
+			      double (*func)(double))
+{
+  switch (argc) {
+  case 0:
+    return rb_gsl_sf_eval1(func, obj);
+  case 1:
+    return rb_gsl_sf_eval1_out(func, obj, rb_gsl_out_arg(argv[0]));
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  }
+  return Qnil;
+}
 
-static VALUE rb_gsl_matrix_sin(VALUE obj)
+static VALUE rb_gsl_matrix_sin(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(sin, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_SIN, sin);
 }
 
-static VALUE rb_gsl_matrix_cos(VALUE obj)
+static VALUE rb_gsl_matrix_cos(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(cos, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_COS, cos);
 }
 
-static VALUE rb_gsl_matrix_tan(VALUE obj)
+static VALUE rb_gsl_matrix_tan(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(tan, obj);
+  return rb_gsl_matrix_eval1(argc, argv, obj, tan);
 }
 
-static VALUE rb_gsl_matrix_exp(VALUE obj)
+static VALUE rb_gsl_matrix_exp(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(exp, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_EXP, exp);
 }
 
-static VALUE rb_gsl_matrix_log(VALUE obj)
+static VALUE rb_gsl_matrix_log(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(log, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_LOG, log);
 }
 
-static VALUE rb_gsl_matrix_log10(VALUE obj)
+static VALUE rb_gsl_matrix_log10(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(log10, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_LOG10, log10);
 }
 
 #include <gsl/gsl_rng.h>
@@ -518,12 +590,12 @@ void Init_gsl_matrix(VALUE module)
 {
   Init_gsl_matrix_init(module);
 
-  rb_define_method(cgsl_matrix, "add", rb_gsl_matrix_add, 1);
+  rb_define_method(cgsl_matrix, "add", rb_gsl_matrix_add_out, -1);
   rb_define_alias(cgsl_matrix, "+", "add");
-  rb_define_method(cgsl_matrix, "sub", rb_gsl_matrix_sub, 1);
+  rb_define_method(cgsl_matrix, "sub", rb_gsl_matrix_sub_out, -1);
   rb_define_alias(cgsl_matrix, "-", "sub");
-  rb_define_method(cgsl_matrix, "mul_elements", rb_gsl_matrix_mul_elements, 1);
-  rb_define_method(cgsl_matrix, "div_elements", rb_gsl_matrix_div_elements, 1);
+  rb_define_method(cgsl_matrix, "mul_elements", rb_gsl_matrix_mul_elements_out, -1);
+  rb_define_method(cgsl_matrix, "div_elements", rb_gsl_matrix_div_elements_out, -1);
   rb_define_alias(cgsl_matrix, "/", "div_elements");
 
   rb_define_method(cgsl_matrix, "mul", rb_gsl_matrix_mul, 1);
@@ -533,7 +605,7 @@ void Init_gsl_matrix(VALUE module)
  
   rb_define_method(cgsl_matrix, "to_complex", rb_gsl_matrix_to_complex, 0);
 
-  rb_define_method(cgsl_matrix, "coerce", rb_gsl_matrix_coerce, 1);
+  rb_gsl_define_coerce(cgsl_matrix, rb_gsl_matrix_coerce);
 
   rb_undef_method(cgsl_matrix_view_ro, "set");
 
@@ -547,12 +619,12 @@ void Init_gsl_matrix(VALUE module)
   rb_define_method(cgsl_matrix, "add!", rb_gsl_matrix_add_inplace, 1);
   rb_define_method(cgsl_matrix, "sub!", rb_gsl_matrix_sub_inplace, 1);
 
-  rb_define_method(cgsl_matrix, "sin", rb_gsl_matrix_sin, 0);
-  rb_define_method(cgsl_matrix, "cos", rb_gsl_matrix_cos, 0);
-  rb_define_method(cgsl_matrix, "tan", rb_gsl_matrix_tan, 0);
-  rb_define_method(cgsl_matrix, "exp", rb_gsl_matrix_exp, 0);
-  rb_define_method(cgsl_matrix, "log", rb_gsl_matrix_log, 0);
-  rb_define_method(cgsl_matrix, "log10", rb_gsl_matrix_log10, 0);
+  rb_define_method(cgsl_matrix, "sin", rb_gsl_matrix_sin, -1);
+  rb_define_method(cgsl_matrix, "cos", rb_gsl_matrix_cos, -1);
+  rb_define_method(cgsl_matrix, "tan", rb_gsl_matrix_tan, -1);
+  rb_define_method(cgsl_matrix, "exp", rb_gsl_matrix_exp, -1);
+  rb_define_method(cgsl_matrix, "log", rb_gsl_matrix_log, -1);
+  rb_define_method(cgsl_matrix, "log10", rb_gsl_matrix_log10, -1);
 
   rb_define_singleton_method(cgsl_matrix, "rand", rb_gsl_matrix_rand, -1);
   rb_define_singleton_method(cgsl_matrix, "randn", rb_gsl_matrix_randn, -1);
@@ -0,0 +1,499 @@
+/*
+  matrix_float.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Matrix::Float: single precision matrices (gsl_matrix_float), and
+  the single precision BLAS bindings GSL::Blas.sgemv and sgemm.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include <gsl/gsl_blas.h>
+
+static VALUE rb_gsl_matrix_float_wrap(gsl_matrix_float *m)
+{
+  return Data_Wrap_Struct(cgsl_matrix_float, 0, gsl_matrix_float_free, m);
+}
+
+static gsl_matrix_float* get_matrix_float(VALUE obj)
+{
+  gsl_matrix_float *m = NULL;
+  CHECK_MATRIX_FLOAT(obj);
+  Data_Get_Struct(obj, gsl_matrix_float, m);
+  return m;
+}
+
+static gsl_matrix_float* matrix_float_from_matrix(const gsl_matrix *x)
+{
+  gsl_matrix_float *m;
+  size_t i, j;
+  m = gsl_matrix_float_alloc(x->size1, x->size2);
+  for (i = 0; i < x->size1; i++)
+    for (j = 0; j < x->size2; j++)
+      m->data[i*m->tda + j] = (float) x->data[i*x->tda + j];
+  return m;
+}
+
+/* Matrix::Float.alloc(size1, size2), alloc([[...], ...]), alloc(matrix) */
+static VALUE rb_gsl_matrix_float_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_matrix_float *m = NULL, *x;
+  gsl_matrix *md;
+  VALUE row;
+  size_t i, j, n2;
+  switch (argc) {
+  case 2:
+    m = gsl_matrix_float_calloc(NUM2SIZET(argv[0]), NUM2SIZET(argv[1]));
+    break;
+  case 1:
+    if (TYPE(argv[0]) == T_ARRAY && RARRAY_LEN(argv[0]) > 0) {
+      n2 = RARRAY_LEN(rb_Array(rb_ary_entry(argv[0], 0)));
+      m = gsl_matrix_float_alloc(RARRAY_LEN(argv[0]), n2);
+      for (i = 0; i < m->size1; i++) {
+	row = rb_Array(rb_ary_entry(argv[0], i));
+	if ((size_t) RARRAY_LEN(row) != n2)
+	  rb_raise(rb_eArgError, "rows must have same length");
+	for (j = 0; j < n2; j++)
+	  gsl_matrix_float_set(m, i, j, (float) NUM2DBL(rb_ary_entry(row, j)));
+      }
+    } else if (MATRIX_FLOAT_P(argv[0])) {
+      Data_Get_Struct(argv[0], gsl_matrix_float, x);
+      m = gsl_matrix_float_alloc(x->size1, x->size2);
+      gsl_matrix_float_memcpy(m, x);
+    } else if (MATRIX_P(argv[0])) {
+      Data_Get_Struct(argv[0], gsl_matrix, md);
+      m = matrix_float_from_matrix(md);
+    } else {
+      rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(argv[0])));
+    }
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  return Data_Wrap_Struct(klass, 0, gsl_matrix_float_free, m);
+}
+
+static VALUE rb_gsl_matrix_float_size1(VALUE obj)
+{
+  return SIZET2NUM(get_matrix_float(obj)->size1);
+}
+
+static VALUE rb_gsl_matrix_float_size2(VALUE obj)
+{
+  return SIZET2NUM(get_matrix_float(obj)->size2);
+}
+
+static VALUE rb_gsl_matrix_float_shape(VALUE obj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  return rb_ary_new3(2, SIZET2NUM(m->size1), SIZET2NUM(m->size2));
+}
+
+static void matrix_float_index(const gsl_matrix_float *m, VALUE ii, VALUE jj,
+			       size_t *i, size_t *j)
+{
+  int a = NUM2INT(ii), b = NUM2INT(jj);
+  if (a < 0) a += m->size1;
+  if (b < 0) b += m->size2;
+  if (a < 0 || b < 0 || (size_t) a >= m->size1 || (size_t) b >= m->size2)
+    rb_raise(rb_eIndexError, "index (%d, %d) out of range", NUM2INT(ii), NUM2INT(jj));
+  *i = a; *j = b;
+}
+
+static VALUE rb_gsl_matrix_float_get(VALUE obj, VALUE ii, VALUE jj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  size_t i, j;
+  matrix_float_index(m, ii, jj, &i, &j);
+  return rb_float_new(gsl_matrix_float_get(m, i, j));
+}
+
+static VALUE rb_gsl_matrix_float_set(VALUE obj, VALUE ii, VALUE jj, VALUE x)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  size_t i, j;
+  matrix_float_index(m, ii, jj, &i, &j);
+  gsl_matrix_float_set(m, i, j, (float) NUM2DBL(x));
+  return x;
+}
+
+static VALUE rb_gsl_matrix_float_set_all(VALUE obj, VALUE x)
+{
+  gsl_matrix_float_set_all(get_matrix_float(obj), (float) NUM2DBL(x));
+  return obj;
+}
+
+static VALUE rb_gsl_matrix_float_set_zero(VALUE obj)
+{
+  gsl_matrix_float_set_zero(get_matrix_float(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_matrix_float_set_identity(VALUE obj)
+{
+  gsl_matrix_float_set_identity(get_matrix_float(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_matrix_float_to_a(VALUE obj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  VALUE ary, row;
+  size_t i, j;
+  ary = rb_ary_new2(m->size1);
+  for (i = 0; i < m->size1; i++) {
+    row = rb_ary_new2(m->size2);
+    for (j = 0; j < m->size2; j++)
+      rb_ary_store(row, j, rb_float_new(gsl_matrix_float_get(m, i, j)));
+    rb_ary_store(ary, i, row);
+  }
+  return ary;
+}
+
+/* Matrix::Float#to_m: a double precision GSL::Matrix */
+static VALUE rb_gsl_matrix_float_to_m(VALUE obj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  gsl_matrix *mnew;
+  size_t i, j;
+  mnew = gsl_matrix_alloc(m->size1, m->size2);
+  for (i = 0; i < m->size1; i++)
+    for (j = 0; j < m->size2; j++)
+      mnew->data[i*mnew->tda + j] = m->data[i*m->tda + j];
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+}
+
+/* Matrix#to_float */
+static VALUE rb_gsl_matrix_to_float(VALUE obj)
+{
+  gsl_matrix *m = NULL;
+  Data_Get_Struct(obj, gsl_matrix, m);
+  return rb_gsl_matrix_float_wrap(matrix_float_from_matrix(m));
+}
+
+static VALUE rb_gsl_matrix_float_to_s(VALUE obj)
+{
+  return rb_funcall(rb_gsl_matrix_float_to_m(obj), rb_intern("to_s"), 0);
+}
+
+static VALUE rb_gsl_matrix_float_inspect(VALUE obj)
+{
+  VALUE str;
+  char buf[64];
+  sprintf(buf, "%s\n", rb_class2name(CLASS_OF(obj)));
+  str = rb_str_new2(buf);
+  return rb_str_concat(str, rb_gsl_matrix_float_to_s(obj));
+}
+
+static VALUE rb_gsl_matrix_float_clone(VALUE obj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj), *mnew;
+  mnew = gsl_matrix_float_alloc(m->size1, m->size2);
+  gsl_matrix_float_memcpy(mnew, m);
+  return rb_gsl_matrix_float_wrap(mnew);
+}
+
+static VALUE rb_gsl_matrix_float_transpose(VALUE obj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj), *mnew;
+  mnew = gsl_matrix_float_alloc(m->size2, m->size1);
+  gsl_matrix_float_transpose_memcpy(mnew, m);
+  return rb_gsl_matrix_float_wrap(mnew);
+}
+
+static VALUE rb_gsl_matrix_float_row(VALUE obj, VALUE ii)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  gsl_vector_float_view *vv;
+  size_t i, j;
+  matrix_float_index(m, ii, INT2FIX(0), &i, &j);
+  vv = ALLOC(gsl_vector_float_view);
+  *vv = gsl_matrix_float_row(m, i);
+  return Data_Wrap_Struct(cgsl_vector_float_view, 0, free, vv);
+}
+
+static VALUE rb_gsl_matrix_float_column(VALUE obj, VALUE jj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  gsl_vector_float_view *vv;
+  size_t i, j;
+  matrix_float_index(m, INT2FIX(0), jj, &i, &j);
+  vv = ALLOC(gsl_vector_float_view);
+  *vv = gsl_matrix_float_column(m, j);
+  return Data_Wrap_Struct(cgsl_vector_float_view, 0, free, vv);
+}
+
+/* submatrix(i, j, n1, n2) */
+static VALUE rb_gsl_matrix_float_submatrix(VALUE obj, VALUE ii, VALUE jj,
+					   VALUE nn1, VALUE nn2)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  gsl_matrix_float_view *mv;
+  size_t i = NUM2SIZET(ii), j = NUM2SIZET(jj), n1 = NUM2SIZET(nn1), n2 = NUM2SIZET(nn2);
+  if (n1 == 0 || n2 == 0 || i + n1 > m->size1 || j + n2 > m->size2)
+    rb_raise(rb_eRangeError, "submatrix out of range");
+  mv = ALLOC(gsl_matrix_float_view);
+  *mv = gsl_matrix_float_submatrix(m, i, j, n1, n2);
+  return Data_Wrap_Struct(cgsl_matrix_float_view, 0, free, mv);
+}
+
+/* Elementwise out = a op b, or a op c when b is NULL */
+static void matrix_float_op(gsl_matrix_float *out, const gsl_matrix_float *a,
+			    const gsl_matrix_float *b, float c, int op)
+{
+  size_t i, j;
+  float x, y;
+  for (i = 0; i < a->size1; i++) {
+    for (j = 0; j < a->size2; j++) {
+      x = a->data[i*a->tda + j];
+      y = b ? b->data[i*b->tda + j] : c;
+      switch (op) {
+      case MYGSL_KERNEL_ADD: x += y; break;
+      case MYGSL_KERNEL_SUB: x -= y; break;
+      case MYGSL_KERNEL_MUL: x *= y; break;
+      default: x /= y; break;
+      }
+      out->data[i*out->tda + j] = x;
+    }
+  }
+}
+
+static VALUE matrix_float_arith(VALUE obj, VALUE other, int op, int inplace)
+{
+  gsl_matrix_float *a = get_matrix_float(obj), *b = NULL, *out;
+  float c = 0.0;
+  if (MATRIX_FLOAT_P(other)) {
+    Data_Get_Struct(other, gsl_matrix_float, b);
+    if (b->size1 != a->size1 || b->size2 != a->size2)
+      rb_raise(rb_eArgError, "matrices must have same dimensions");
+  } else {
+    c = (float) NUM2DBL(other);
+  }
+  if (inplace) {
+    matrix_float_op(a, a, b, c, op);
+    return obj;
+  }
+  out = gsl_matrix_float_alloc(a->size1, a->size2);
+  matrix_float_op(out, a, b, c, op);
+  return rb_gsl_matrix_float_wrap(out);
+}
+
+static VALUE rb_gsl_matrix_float_add(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_ADD, 0);
+}
+
+static VALUE rb_gsl_matrix_float_sub(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_SUB, 0);
+}
+
+static VALUE rb_gsl_matrix_float_mul_elements(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_MUL, 0);
+}
+
+static VALUE rb_gsl_matrix_float_div_elements(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_DIV, 0);
+}
+
+static VALUE rb_gsl_matrix_float_add_bang(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_ADD, 1);
+}
+
+static VALUE rb_gsl_matrix_float_sub_bang(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_SUB, 1);
+}
+
+static VALUE rb_gsl_matrix_float_scale_bang(VALUE obj, VALUE b)
+{
+  return matrix_float_arith(obj, b, MYGSL_KERNEL_MUL, 1);
+}
+
+/* Matrix::Float * Vector::Float (sgemv), * Matrix::Float (sgemm),
+   * Numeric (scaling) */
+static VALUE rb_gsl_matrix_float_mul(VALUE obj, VALUE other)
+{
+  gsl_matrix_float *A = get_matrix_float(obj), *B, *C;
+  gsl_vector_float *x, *y;
+  if (VECTOR_FLOAT_P(other)) {
+    Data_Get_Struct(other, gsl_vector_float, x);
+    y = gsl_vector_float_calloc(A->size1);
+    gsl_blas_sgemv(CblasNoTrans, 1.0, A, x, 0.0, y);
+    return rb_gsl_vector_float_wrap(y);
+  }
+  if (MATRIX_FLOAT_P(other)) {
+    Data_Get_Struct(other, gsl_matrix_float, B);
+    C = gsl_matrix_float_calloc(A->size1, B->size2);
+    gsl_blas_sgemm(CblasNoTrans, CblasNoTrans, 1.0, A, B, 0.0, C);
+    return rb_gsl_matrix_float_wrap(C);
+  }
+  return matrix_float_arith(obj, other, MYGSL_KERNEL_MUL, 0);
+}
+
+static VALUE rb_gsl_matrix_float_to_binary(VALUE obj)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  VALUE str;
+  char *p;
+  size_t i, row = m->size2*sizeof(float);
+  if (m->tda == m->size2) return rb_str_new((char*) m->data, m->size1*row);
+  str = rb_str_new(NULL, m->size1*row);
+  p = RSTRING_PTR(str);
+  for (i = 0; i < m->size1; i++) memcpy(p + i*row, m->data + i*m->tda, row);
+  return str;
+}
+
+/* io is a file name or an object responding to write / read */
+static VALUE rb_gsl_matrix_float_fwrite(VALUE obj, VALUE io)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  FILE *f;
+  int status, flag = 0;
+  if (TYPE(io) != T_STRING) {
+    rb_funcall(io, rb_intern("write"), 1, rb_gsl_matrix_float_to_binary(obj));
+    return INT2FIX(GSL_SUCCESS);
+  }
+  f = rb_gsl_open_writefile(io, &flag);
+  status = gsl_matrix_float_fwrite(f, m);
+  if (flag == 1) fclose(f);
+  return INT2FIX(status);
+}
+
+static VALUE rb_gsl_matrix_float_fread(VALUE obj, VALUE io)
+{
+  gsl_matrix_float *m = get_matrix_float(obj);
+  FILE *f;
+  VALUE str;
+  size_t i, row = m->size2*sizeof(float);
+  int status, flag = 0;
+  if (TYPE(io) != T_STRING) {
+    str = rb_funcall(io, rb_intern("read"), 1, SIZET2NUM(m->size1*row));
+    if (NIL_P(str) || (size_t) RSTRING_LEN(str) != m->size1*row)
+      rb_raise(rb_eIOError, "end of input before %d rows were read", (int) m->size1);
+    for (i = 0; i < m->size1; i++)
+      memcpy(m->data + i*m->tda, RSTRING_PTR(str) + i*row, row);
+    return INT2FIX(GSL_SUCCESS);
+  }
+  f = rb_gsl_open_readfile(io, &flag);
+  status = gsl_matrix_float_fread(f, m);
+  if (flag == 1) fclose(f);
+  return INT2FIX(status);
+}
+
+/* GSL::Blas.sgemv(trans, alpha, A, x[, beta, y]): y = alpha*op(A)*x + beta*y,
+   y is modified if given, allocated otherwise */
+static VALUE rb_gsl_blas_sgemv(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix_float *A;
+  gsl_vector_float *x, *y;
+  CBLAS_TRANSPOSE_t trans;
+  float beta = 0.0;
+  VALUE vy;
+  if (argc != 4 && argc != 6)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 4 or 6)", argc);
+  CHECK_FIXNUM(argv[0]);
+  trans = FIX2INT(argv[0]);
+  A = get_matrix_float(argv[2]);
+  x = rb_gsl_get_vector_float(argv[3]);
+  if (argc == 6) {
+    beta = (float) NUM2DBL(argv[4]);
+    vy = argv[5];
+    y = rb_gsl_get_vector_float(vy);
+  } else {
+    y = gsl_vector_float_calloc(trans == CblasNoTrans ? A->size1 : A->size2);
+    vy = rb_gsl_vector_float_wrap(y);
+  }
+  gsl_blas_sgemv(trans, (float) NUM2DBL(argv[1]), A, x, beta, y);
+  return vy;
+}
+
+/* GSL::Blas.sgemm(transA, transB, alpha, A, B[, beta, C]) */
+static VALUE rb_gsl_blas_sgemm(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix_float *A, *B, *C;
+  CBLAS_TRANSPOSE_t transA, transB;
+  float beta = 0.0;
+  VALUE vc;
+  if (argc != 5 && argc != 7)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 5 or 7)", argc);
+  CHECK_FIXNUM(argv[0]);
+  CHECK_FIXNUM(argv[1]);
+  transA = FIX2INT(argv[0]);
+  transB = FIX2INT(argv[1]);
+  A = get_matrix_float(argv[3]);
+  B = get_matrix_float(argv[4]);
+  if (argc == 7) {
+    beta = (float) NUM2DBL(argv[5]);
+    vc = argv[6];
+    C = get_matrix_float(vc);
+  } else {
+    C = gsl_matrix_float_calloc(transA == CblasNoTrans ? A->size1 : A->size2,
+				transB == CblasNoTrans ? B->size2 : B->size1);
+    vc = rb_gsl_matrix_float_wrap(C);
+  }
+  gsl_blas_sgemm(transA, transB, (float) NUM2DBL(argv[2]), A, B, beta, C);
+  return vc;
+}
+
+void Init_gsl_matrix_float(VALUE module)
+{
+  VALUE mgsl_blas;
+  rb_define_singleton_method(cgsl_matrix_float, "new", rb_gsl_matrix_float_new, -1);
+  rb_define_singleton_method(cgsl_matrix_float, "alloc", rb_gsl_matrix_float_new, -1);
+  rb_define_singleton_method(cgsl_matrix_float, "[]", rb_gsl_matrix_float_new, -1);
+
+  rb_define_method(cgsl_matrix_float, "size1", rb_gsl_matrix_float_size1, 0);
+  rb_define_method(cgsl_matrix_float, "size2", rb_gsl_matrix_float_size2, 0);
+  rb_define_method(cgsl_matrix_float, "shape", rb_gsl_matrix_float_shape, 0);
+  rb_define_alias(cgsl_matrix_float, "size", "shape");
+  rb_define_method(cgsl_matrix_float, "get", rb_gsl_matrix_float_get, 2);
+  rb_define_alias(cgsl_matrix_float, "[]", "get");
+  rb_define_method(cgsl_matrix_float, "set", rb_gsl_matrix_float_set, 3);
+  rb_define_alias(cgsl_matrix_float, "[]=", "set");
+  rb_define_method(cgsl_matrix_float, "set_all", rb_gsl_matrix_float_set_all, 1);
+  rb_define_method(cgsl_matrix_float, "set_zero", rb_gsl_matrix_float_set_zero, 0);
+  rb_define_method(cgsl_matrix_float, "set_identity", rb_gsl_matrix_float_set_identity, 0);
+  rb_define_method(cgsl_matrix_float, "to_a", rb_gsl_matrix_float_to_a, 0);
+  rb_define_method(cgsl_matrix_float, "to_m", rb_gsl_matrix_float_to_m, 0);
+  rb_define_alias(cgsl_matrix_float, "to_double", "to_m");
+  rb_define_method(cgsl_matrix, "to_float", rb_gsl_matrix_to_float, 0);
+  rb_define_method(cgsl_matrix_float, "to_s", rb_gsl_matrix_float_to_s, 0);
+  rb_define_method(cgsl_matrix_float, "inspect", rb_gsl_matrix_float_inspect, 0);
+  rb_define_method(cgsl_matrix_float, "clone", rb_gsl_matrix_float_clone, 0);
+  rb_define_alias(cgsl_matrix_float, "dup", "clone");
+  rb_define_method(cgsl_matrix_float, "transpose", rb_gsl_matrix_float_transpose, 0);
+  rb_define_method(cgsl_matrix_float, "row", rb_gsl_matrix_float_row, 1);
+  rb_define_method(cgsl_matrix_float, "column", rb_gsl_matrix_float_column, 1);
+  rb_define_alias(cgsl_matrix_float, "col", "column");
+  rb_define_method(cgsl_matrix_float, "submatrix", rb_gsl_matrix_float_submatrix, 4);
+
+  rb_define_method(cgsl_matrix_float, "+", rb_gsl_matrix_float_add, 1);
+  rb_define_method(cgsl_matrix_float, "-", rb_gsl_matrix_float_sub, 1);
+  rb_define_method(cgsl_matrix_float, "*", rb_gsl_matrix_float_mul, 1);
+  rb_define_method(cgsl_matrix_float, "mul_elements", rb_gsl_matrix_float_mul_elements, 1);
+  rb_define_method(cgsl_matrix_float, "div_elements", rb_gsl_matrix_float_div_elements, 1);
+  rb_define_alias(cgsl_matrix_float, "/", "div_elements");
+  rb_define_method(cgsl_matrix_float, "add!", rb_gsl_matrix_float_add_bang, 1);
+  rb_define_method(cgsl_matrix_float, "sub!", rb_gsl_matrix_float_sub_bang, 1);
+  rb_define_method(cgsl_matrix_float, "scale!", rb_gsl_matrix_float_scale_bang, 1);
+
+  rb_define_method(cgsl_matrix_float, "to_binary", rb_gsl_matrix_float_to_binary, 0);
+  rb_define_method(cgsl_matrix_float, "fwrite", rb_gsl_matrix_float_fwrite, 1);
+  rb_define_method(cgsl_matrix_float, "fread", rb_gsl_matrix_float_fread, 1);
+
+  mgsl_blas = rb_define_module_under(module, "Blas");
+  rb_define_module_function(mgsl_blas, "sgemv", rb_gsl_blas_sgemv, -1);
+  rb_define_module_function(mgsl_blas, "sgemm", rb_gsl_blas_sgemm, -1);
+}
@@ -11,13 +11,255 @@
 #include "rb_gsl_config.h"
 #include "rb_gsl_array.h"
 #include "rb_gsl_complex.h"
+#include "rb_gsl_common.h"
 #ifdef HAVE_NARRAY_H
 #include "rb_gsl_with_narray.h"
 #endif
+#include <stdint.h>
+#include <limits.h>
 
 int gsl_linalg_matmult_int(const gsl_matrix_int *A, 
 			   const gsl_matrix_int *B, gsl_matrix_int *C);
 
+/*
+  Products of Matrix::Int, by blocks of MATINT_MC rows of C, MATINT_KC
+  terms and MATINT_NC columns, accumulated in 64-bit integers.  The
+  blocks of rows are shared among threads (GSL.parallel_threads) without
+  the GVL, and the inner loop is cloned for AVX2 where the compiler
+  supports it.  overflow says what to do with the sums out of the range
+  of int:
+
+    MATINT_WRAP      keep the low 32 bits (two's complement), as int
+                     arithmetic does; exact whatever the sizes
+    MATINT_SATURATE  clamp to INT_MIN..INT_MAX
+    MATINT_RAISE     fail with GSL_EOVRFLW
+
+  The last two need the exact sums, hence an accumulator which cannot
+  overflow: max|a| max|b| k must stay below 2^63.
+*/
+#define MATINT_MC 64
+#define MATINT_KC 256
+#define MATINT_NC 256
+
+#ifdef HAVE_ATTRIBUTE_TARGET_CLONES
+#define MATINT_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define MATINT_CLONES
+#endif
+
+enum {
+  MATINT_WRAP,
+  MATINT_SATURATE,
+  MATINT_RAISE,
+};
+
+struct matint_task {
+  const gsl_matrix_int *a, *b;
+  const int *x;                 /* matrix-vector product when b is NULL */
+  gsl_matrix_int *c;
+  gsl_vector_int *y;
+  int overflow;
+  size_t nblocks, nthreads;
+};
+
+/* acc[i][j] += sum_l a[i][l] b[l][j] over an mc x kc x nc block; the
+   products are exact in int64_t, and the sums wrap modulo 2^64 */
+MATINT_CLONES
+static void matint_block(const int *a, size_t lda, const int *b, size_t ldb,
+			 uint64_t *acc, size_t mc, size_t kc, size_t nc)
+{
+  size_t i, l, j;
+  for (i = 0; i < mc; i++) {
+    const int *ai = a + i*lda;
+    uint64_t *ci = acc + i*nc;
+    for (l = 0; l < kc; l++) {
+      const int *bl = b + l*ldb;
+      int x = ai[l];
+      if (x == 0) continue;
+      for (j = 0; j < nc; j++) ci[j] += (uint64_t) ((int64_t) x*bl[j]);
+    }
+  }
+}
+
+MATINT_CLONES
+static uint64_t matint_dot(const int *a, const int *x, size_t n)
+{
+  uint64_t s = 0;
+  size_t j;
+  for (j = 0; j < n; j++) s += (uint64_t) ((int64_t) a[j]*x[j]);
+  return s;
+}
+
+static int matint_store(uint64_t acc, int overflow, int *dest)
+{
+  int64_t v = (int64_t) acc;
+  if (overflow == MATINT_WRAP) {
+    *dest = (int) (uint32_t) acc;
+  } else if (v >= INT_MIN && v <= INT_MAX) {
+    *dest = (int) v;
+  } else if (overflow == MATINT_SATURATE) {
+    *dest = v < 0 ? INT_MIN : INT_MAX;
+  } else {
+    return GSL_EOVRFLW;
+  }
+  return GSL_SUCCESS;
+}
+
+/* rows i0 <= i < i1 of C (of y), at most MATINT_MC of them */
+static int matint_rows(const struct matint_task *t, size_t i0, size_t i1)
+{
+  const gsl_matrix_int *a = t->a, *b = t->b;
+  uint64_t *acc;
+  size_t k = a->size2, i, j, jc, pc, nc, kc;
+  int status = GSL_SUCCESS;
+  if (b == NULL) {
+    for (i = i0; i < i1; i++) {
+      if (matint_store(matint_dot(a->data + i*a->tda, t->x, k), t->overflow,
+		       t->y->data + i*t->y->stride))
+	status = GSL_EOVRFLW;
+    }
+    return status;
+  }
+  acc = (uint64_t *) malloc(sizeof(uint64_t)*MATINT_MC*MATINT_NC);
+  if (acc == NULL) return GSL_ENOMEM;
+  for (jc = 0; jc < b->size2; jc += MATINT_NC) {
+    nc = GSL_MIN(MATINT_NC, b->size2 - jc);
+    memset(acc, 0, sizeof(uint64_t)*(i1 - i0)*nc);
+    for (pc = 0; pc < k; pc += MATINT_KC) {
+      kc = GSL_MIN(MATINT_KC, k - pc);
+      matint_block(a->data + i0*a->tda + pc, a->tda, b->data + pc*b->tda + jc,
+		   b->tda, acc, i1 - i0, kc, nc);
+    }
+    for (i = i0; i < i1; i++) {
+      for (j = 0; j < nc; j++) {
+	if (matint_store(acc[(i - i0)*nc + j], t->overflow,
+			 t->c->data + i*t->c->tda + jc + j))
+	  status = GSL_EOVRFLW;
+      }
+    }
+  }
+  free(acc);
+  return status;
+}
+
+static int matint_worker(void *data, size_t id)
+{
+  struct matint_task *t = (struct matint_task *) data;
+  size_t chunk = (t->nblocks + t->nthreads - 1)/t->nthreads, ib;
+  size_t n = t->a->size1;
+  int status = GSL_SUCCESS, s;
+  for (ib = id*chunk; ib < GSL_MIN((id + 1)*chunk, t->nblocks); ib++) {
+    s = matint_rows(t, ib*MATINT_MC, GSL_MIN((ib + 1)*MATINT_MC, n));
+    if (status == GSL_SUCCESS) status = s;
+  }
+  return status;
+}
+
+static int matint_serial(void *data)
+{
+  struct matint_task *t = (struct matint_task *) data;
+  size_t ib;
+  int status = GSL_SUCCESS, s;
+  for (ib = 0; ib < t->nblocks; ib++) {
+    s = matint_rows(t, ib*MATINT_MC, GSL_MIN((ib + 1)*MATINT_MC, t->a->size1));
+    if (status == GSL_SUCCESS) status = s;
+  }
+  return status;
+}
+
+static double matint_max_abs(const int *p, size_t n1, size_t n2, size_t tda)
+{
+  size_t i, j;
+  double m = 0.0, v;
+  for (i = 0; i < n1; i++) {
+    for (j = 0; j < n2; j++) {
+      v = p[i*tda + j];
+      if (v < 0) v = -v;
+      if (v > m) m = v;
+    }
+  }
+  return m;
+}
+
+/* C = A B, or y = A x when B is NULL; must be called with the GVL held.
+   Returns GSL_EOVRFLW when overflow is MATINT_RAISE and a sum is out of
+   range, GSL_ENOMEM when a block buffer could not be allocated. */
+static int matint_run(const gsl_matrix_int *A, const gsl_matrix_int *B,
+		      const gsl_vector_int *x, gsl_matrix_int *C,
+		      gsl_vector_int *y, int overflow)
+{
+  struct matint_task t;
+  int *xc = NULL, status;
+  size_t n2 = B ? B->size2 : 1, work = A->size1*A->size2*n2, j;
+  double ma, mb;
+  if (A->size1 == 0 || n2 == 0) return GSL_SUCCESS;
+  if (overflow != MATINT_WRAP) {
+    ma = matint_max_abs(A->data, A->size1, A->size2, A->tda);
+    mb = B ? matint_max_abs(B->data, B->size1, B->size2, B->tda)
+      : matint_max_abs(x->data, x->size, 1, x->stride);
+    if (ma*mb*(double) A->size2 >= 9.2e18)
+      rb_raise(rb_eRangeError, "the sums may overflow the 64-bit accumulator");
+  }
+  if (B == NULL && x->stride != 1) {
+    xc = ALLOC_N(int, x->size);
+    for (j = 0; j < x->size; j++) xc[j] = x->data[j*x->stride];
+  }
+  t.a = A;
+  t.b = B;
+  t.x = B ? NULL : (xc ? xc : x->data);
+  t.c = C;
+  t.y = y;
+  t.overflow = overflow;
+  t.nblocks = (A->size1 + MATINT_MC - 1)/MATINT_MC;
+  t.nthreads = rb_gsl_parallel_nthreads(work, t.nblocks);
+  if (t.nthreads > 1) {
+    status = rb_gsl_nogvl_parallel(matint_worker, &t, t.nthreads);
+  } else {
+    status = rb_gsl_nogvl_call(matint_serial, &t, work);
+  }
+  if (xc) xfree(xc);
+  return status;
+}
+
+static int matint_overflow_opt(VALUE opts)
+{
+  VALUE v;
+  ID id;
+  if (NIL_P(opts)) return MATINT_WRAP;
+  Check_Type(opts, T_HASH);
+  v = rb_hash_aref(opts, ID2SYM(rb_intern("overflow")));
+  if (NIL_P(v)) return MATINT_WRAP;
+  if (!SYMBOL_P(v)) rb_raise(rb_eTypeError, ":overflow must be a Symbol");
+  id = SYM2ID(v);
+  if (id == rb_intern("wrap")) return MATINT_WRAP;
+  if (id == rb_intern("saturate")) return MATINT_SATURATE;
+  if (id == rb_intern("raise")) return MATINT_RAISE;
+  rb_raise(rb_eArgError, "unknown overflow mode (:wrap, :saturate or :raise expected)");
+  return MATINT_WRAP;
+}
+
+static void matint_raise(int status)
+{
+  if (status == GSL_ENOMEM) rb_raise(rb_eNoMemError, "malloc failed");
+  if (status == GSL_EOVRFLW) rb_raise(rb_eRangeError, "integer overflow in Matrix::Int product");
+}
+
+static VALUE matint_mul_vector(const gsl_matrix_int *m, VALUE vv, int overflow)
+{
+  gsl_vector_int *v, *vnew;
+  int status;
+  Data_Get_Struct(vv, gsl_vector_int, v);
+  if (m->size2 != v->size)
+    rb_raise(rb_eRangeError, "matrix and vector sizes are not conformant (%d and %d)",
+	     (int) m->size2, (int) v->size);
+  vnew = gsl_vector_int_alloc(m->size1);
+  if ((status = matint_run(m, NULL, v, NULL, vnew, overflow))) {
+    gsl_vector_int_free(vnew);
+    matint_raise(status);
+  }
+  return Data_Wrap_Struct(cgsl_vector_int_col, 0, gsl_vector_int_free, vnew);
+}
+
 
 VALUE rb_gsl_matrix_to_i(VALUE obj);
 
@@ -74,7 +316,6 @@ enum {
 static VALUE rb_gsl_matrix_int_operation1(VALUE obj, VALUE other, int flag)
 {
   gsl_matrix_int *a, *anew, *b;
-  gsl_vector_int *vi, *vinew;
   double bval;
   // local variable "result" declared and set, but never used
   //int result;
@@ -126,10 +367,7 @@ static VALUE rb_gsl_matrix_int_operation1(VALUE obj, VALUE other, int flag)
     } else if (VECTOR_INT_COL_P(other)) {
       switch (flag) {
       case GSL_MATRIX_INT_MUL:
-	Data_Get_Struct(other, gsl_vector_int, vi);
-	vinew = gsl_vector_int_alloc(vi->size);
-	gsl_matrix_int_mul_vector(vinew, a, vi);
-	return Data_Wrap_Struct(cgsl_vector_int_col, 0, gsl_vector_int_free, vinew);
+	return matint_mul_vector(a, other, MATINT_WRAP);
 	break;
       default:
 	rb_raise(rb_eRuntimeError, "Operation not defined");
@@ -163,23 +401,30 @@ static VALUE rb_gsl_matrix_int_div(VALUE obj, VALUE other)
   return rb_gsl_matrix_int_operation1(obj, other, GSL_MATRIX_INT_DIV);
 }
 
-static VALUE rb_gsl_matrix_int_matrix_mul(VALUE obj, VALUE bb)
+/* matrix_mul(b, :overflow => :wrap, :saturate or :raise) */
+static VALUE rb_gsl_matrix_int_matrix_mul(int argc, VALUE *argv, VALUE obj)
 {
   gsl_matrix_int *m = NULL, *b = NULL, *mnew = NULL;
-  gsl_vector_int *vi, *vinew;
+  VALUE bb;
+  int overflow, status;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  bb = argv[0];
+  overflow = matint_overflow_opt(argc > 1 ? argv[1] : Qnil);
   Data_Get_Struct(obj, gsl_matrix_int, m);
   if (MATRIX_INT_P(bb)) {
     Data_Get_Struct(bb, gsl_matrix_int, b);
+    if (m->size2 != b->size1)
+      rb_raise(rb_eRangeError, "matrix sizes are not conformant (%dx%d and %dx%d)",
+	       (int) m->size1, (int) m->size2, (int) b->size1, (int) b->size2);
     mnew = gsl_matrix_int_alloc(m->size1, b->size2);
-    gsl_linalg_matmult_int(m, b, mnew);
+    if ((status = matint_run(m, b, NULL, mnew, NULL, overflow))) {
+      gsl_matrix_int_free(mnew);
+      matint_raise(status);
+    }
     return Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, mnew);
   } else {
-    if (VECTOR_INT_COL_P(bb)) {
-      Data_Get_Struct(bb, gsl_vector_int, vi);
-      vinew = gsl_vector_int_alloc(vi->size);
-      gsl_matrix_int_mul_vector(vinew, m, vi);
-      return Data_Wrap_Struct(cgsl_vector_int_col, 0, gsl_vector_int_free, vinew);
-    }
+    if (VECTOR_INT_COL_P(bb)) return matint_mul_vector(m, bb, overflow);
     switch (TYPE(bb)) {
     case T_FIXNUM:
       return rb_gsl_matrix_int_mul(obj, bb);
@@ -193,6 +438,7 @@ static VALUE rb_gsl_matrix_int_matrix_mul(VALUE obj, VALUE bb)
   }
 }
 
+/* must be called with the GVL held */
 int gsl_linalg_matmult_int(const gsl_matrix_int *A, 
 			   const gsl_matrix_int *B, gsl_matrix_int *C)
 {
@@ -200,31 +446,7 @@ int gsl_linalg_matmult_int(const gsl_matrix_int *A,
     {
       GSL_ERROR ("matrix sizes are not conformant", GSL_EBADLEN);
     }
-  else
-    {
-      int a, b;
-      int temp;
-      size_t i, j, k;
-      
-      for (i = 0; i < C->size1; i++)
-        {
-          for (j = 0; j < C->size2; j++)
-            {
-              a = gsl_matrix_int_get(A, i, 0);
-              b = gsl_matrix_int_get(B, 0, j);
-              temp = a * b;
-              for (k = 1; k < A->size2; k++)
-                {
-                  a = gsl_matrix_int_get(A, i, k);
-                  b = gsl_matrix_int_get(B, k, j);
-                  temp += a * b;
-                }
-              gsl_matrix_int_set(C, i, j, temp);
-            }
-        }
-
-      return GSL_SUCCESS;
-    }
+  return matint_run(A, B, NULL, C, NULL, MATINT_WRAP);
 }
 
 void Init_gsl_matrix_int_init(VALUE module);
@@ -238,7 +460,7 @@ void Init_gsl_matrix_int(VALUE module)
   rb_define_method(cgsl_matrix_int, "to_complex", rb_gsl_matrix_int_to_complex, 0);
 
   /*****/
-  rb_define_method(cgsl_matrix_int, "coerce", rb_gsl_matrix_int_coerce, 1);
+  rb_gsl_define_coerce(cgsl_matrix_int, rb_gsl_matrix_int_coerce);
   /*****/
   rb_define_method(cgsl_matrix_int, "add", rb_gsl_matrix_int_add, 1);
   rb_define_alias(cgsl_matrix_int, "+", "add");
@@ -249,7 +471,7 @@ void Init_gsl_matrix_int(VALUE module)
   rb_define_method(cgsl_matrix_int, "div", rb_gsl_matrix_int_div, 1);
   rb_define_alias(cgsl_matrix_int, "/", "div");
 
-  rb_define_method(cgsl_matrix_int, "matrix_mul", rb_gsl_matrix_int_matrix_mul, 1);
+  rb_define_method(cgsl_matrix_int, "matrix_mul", rb_gsl_matrix_int_matrix_mul, -1);
   rb_define_alias(cgsl_matrix_int, "*", "matrix_mul");
   /*****/
 
@@ -0,0 +1,499 @@
+/*
+  matrix_lazy.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Matrix::Lazy: deferred matrix products.
+
+    p = a.lazy.t * b * c * v       # nothing is computed yet
+    x = p.eval                     # a.trans*b*c*v
+
+  a.lazy is the chain of the single factor a, and multiplying a chain
+  by a Matrix, a Lazy, or a Vector as the last factor appends to it;
+  Matrix * Lazy is a Lazy as well.  Lazy#t transposes the chain without
+  copying anything: the transposed factors are handed to dgemm and
+  dgemv as CblasTrans.  a.t is a.lazy.t, a transpose view that
+  GSL::Blas.dgemm and dgemv also take for a matrix operand, flipping
+  its Trans argument.  eval (to_m, materialize) computes the product
+  in the order of least multiply-adds, found by the matrix chain
+  dynamic program, with dgemv once the trailing vector is reached and
+  dsyrk for a.t * a and a * a.t of the same matrix.  The intermediate
+  products share one buffer and the whole evaluation runs with the GVL
+  released from GSL.nogvl_threshold multiply-adds on.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+VALUE cgsl_matrix_lazy;
+
+struct mlazy_factor {
+  VALUE v;                      /* GSL::Matrix, or a GSL::Vector as the last factor */
+  CBLAS_TRANSPOSE_t trans;
+};
+
+typedef struct {
+  size_t n;
+  struct mlazy_factor *f;
+} rb_gsl_mlazy;
+
+static void rb_gsl_mlazy_mark(rb_gsl_mlazy *e)
+{
+  size_t i;
+  for (i = 0; i < e->n; i++) rb_gc_mark(e->f[i].v);
+}
+
+static void rb_gsl_mlazy_free(rb_gsl_mlazy *e)
+{
+  xfree(e->f);
+  xfree(e);
+}
+
+static VALUE rb_gsl_mlazy_wrap(rb_gsl_mlazy **pe, size_t n)
+{
+  rb_gsl_mlazy *e = ALLOC(rb_gsl_mlazy);
+  e->n = 0;
+  e->f = ALLOC_N(struct mlazy_factor, n);
+  *pe = e;
+  return Data_Wrap_Struct(cgsl_matrix_lazy, rb_gsl_mlazy_mark, rb_gsl_mlazy_free, e);
+}
+
+/* The shape of op(factor): rows x cols, a vector being a column */
+static void mlazy_shape(const struct mlazy_factor *f, size_t *rows, size_t *cols)
+{
+  gsl_matrix *m;
+  gsl_vector *v;
+  if (MATRIX_P(f->v)) {
+    Data_Get_Struct(f->v, gsl_matrix, m);
+    *rows = f->trans == CblasNoTrans ? m->size1 : m->size2;
+    *cols = f->trans == CblasNoTrans ? m->size2 : m->size1;
+  } else {
+    Data_Get_Struct(f->v, gsl_vector, v);
+    *rows = v->size;
+    *cols = 1;
+  }
+}
+
+static int mlazy_vector_p(const rb_gsl_mlazy *e)
+{
+  return e->n > 0 && !MATRIX_P(e->f[e->n-1].v);
+}
+
+/* The chain of a for a Matrix, a itself for a Lazy */
+VALUE rb_gsl_matrix_lazy_operand(VALUE x)
+{
+  rb_gsl_mlazy *e;
+  VALUE obj;
+  if (rb_obj_is_kind_of(x, cgsl_matrix_lazy)) return x;
+  if (!MATRIX_P(x) && !VECTOR_P(x))
+    rb_raise(rb_eTypeError, "wrong argument type %s (Matrix, Vector or Matrix::Lazy expected)",
+	     rb_class2name(CLASS_OF(x)));
+  obj = rb_gsl_mlazy_wrap(&e, 1);
+  e->f[0].v = x;
+  e->f[0].trans = CblasNoTrans;
+  e->n = 1;
+  return obj;
+}
+
+VALUE rb_gsl_matrix_lazy_mul(VALUE obj, VALUE other)
+{
+  rb_gsl_mlazy *a, *b, *e;
+  size_t r1, c1, r2, c2;
+  VALUE vnew;
+  other = rb_gsl_matrix_lazy_operand(other);
+  Data_Get_Struct(obj, rb_gsl_mlazy, a);
+  Data_Get_Struct(other, rb_gsl_mlazy, b);
+  if (mlazy_vector_p(a))
+    rb_raise(rb_eTypeError, "the product already ends with a vector");
+  mlazy_shape(&a->f[a->n-1], &r1, &c1);
+  mlazy_shape(&b->f[0], &r2, &c2);
+  if (c1 != r2)
+    rb_raise(rb_eRangeError, "matrix sizes do not match (%d x %d) * (%d x %d)",
+	     (int) r1, (int) c1, (int) r2, (int) c2);
+  vnew = rb_gsl_mlazy_wrap(&e, a->n + b->n);
+  memcpy(e->f, a->f, sizeof(struct mlazy_factor)*a->n);
+  memcpy(e->f + a->n, b->f, sizeof(struct mlazy_factor)*b->n);
+  e->n = a->n + b->n;
+  return vnew;
+}
+
+static VALUE rb_gsl_matrix_lazy(VALUE obj)
+{
+  return rb_gsl_matrix_lazy_operand(obj);
+}
+
+/* (a b c)^T = c^T b^T a^T */
+static VALUE rb_gsl_mlazy_t(VALUE obj)
+{
+  rb_gsl_mlazy *a, *e;
+  size_t i;
+  VALUE vnew;
+  Data_Get_Struct(obj, rb_gsl_mlazy, a);
+  if (mlazy_vector_p(a))
+    rb_raise(rb_eTypeError, "transpose of a matrix-vector product");
+  vnew = rb_gsl_mlazy_wrap(&e, a->n);
+  for (i = 0; i < a->n; i++) {
+    e->f[i].v = a->f[a->n-1-i].v;
+    e->f[i].trans = a->f[a->n-1-i].trans == CblasNoTrans ? CblasTrans : CblasNoTrans;
+  }
+  e->n = a->n;
+  return vnew;
+}
+
+/* a.t: the transpose view a.lazy.t */
+static VALUE rb_gsl_matrix_t(VALUE obj)
+{
+  return rb_gsl_mlazy_t(rb_gsl_matrix_lazy_operand(obj));
+}
+
+/* The gsl_matrix of a Matrix, or of a Lazy of one matrix factor such
+   as a.t, whose transposition is combined into *trans */
+gsl_matrix* rb_gsl_matrix_op(VALUE x, CBLAS_TRANSPOSE_t *trans)
+{
+  rb_gsl_mlazy *e;
+  gsl_matrix *m;
+  if (rb_obj_is_kind_of(x, cgsl_matrix_lazy)) {
+    Data_Get_Struct(x, rb_gsl_mlazy, e);
+    if (e->n != 1 || !MATRIX_P(e->f[0].v))
+      rb_raise(rb_eTypeError, "a product of %d factors for a matrix operand", (int) e->n);
+    if (e->f[0].trans != CblasNoTrans)
+      *trans = *trans == CblasNoTrans ? CblasTrans : CblasNoTrans;
+    x = e->f[0].v;
+  }
+  CHECK_MATRIX(x);
+  Data_Get_Struct(x, gsl_matrix, m);
+  return m;
+}
+
+static VALUE rb_gsl_mlazy_size(VALUE obj)
+{
+  rb_gsl_mlazy *e;
+  Data_Get_Struct(obj, rb_gsl_mlazy, e);
+  return SIZET2NUM(e->n);
+}
+
+static VALUE rb_gsl_mlazy_shape(VALUE obj)
+{
+  rb_gsl_mlazy *e;
+  size_t r, c, r2, c2;
+  Data_Get_Struct(obj, rb_gsl_mlazy, e);
+  mlazy_shape(&e->f[0], &r, &c);
+  mlazy_shape(&e->f[e->n-1], &r2, &c2);
+  return rb_ary_new3(2, SIZET2NUM(r), SIZET2NUM(c2));
+}
+
+/*
+  Evaluation.  A node of the product tree is an operand of dgemm,
+  dgemv or dsyrk: a factor as stored with its transposition, or an
+  intermediate product in the shared buffer.
+*/
+struct mlazy_op {
+  double *data;
+  size_t size1, size2, tda;     /* size2 = 1 and tda the stride for a vector */
+  CBLAS_TRANSPOSE_t trans;
+  int vector;
+};
+
+struct mlazy_eval {
+  size_t n;
+  const size_t *dim;            /* n + 1: op(factor i) is dim[i] x dim[i+1] */
+  struct mlazy_op *leaf;
+  const size_t *split;          /* n x n */
+  double **dst;                 /* n x n, the buffer of each product */
+  double *copy;                 /* root computed apart when out overlaps a factor */
+  struct mlazy_op out;
+};
+
+/* A factor of the pair a b is the same data as the other, transposed */
+static int mlazy_syrk_p(const struct mlazy_op *a, const struct mlazy_op *b)
+{
+  return !a->vector && !b->vector && a->data == b->data && a->size1 == b->size1
+    && a->size2 == b->size2 && a->tda == b->tda && a->trans != b->trans;
+}
+
+/* Multiply-adds of the dim[i] x dim[k+1] by dim[k+1] x dim[j+1] product */
+static double mlazy_cost(const struct mlazy_eval *e, size_t i, size_t k, size_t j)
+{
+  double c = (double) e->dim[i]*(double) e->dim[k+1]*(double) e->dim[j+1];
+  if (j == i + 1 && mlazy_syrk_p(&e->leaf[i], &e->leaf[j])) c *= 0.5;
+  return c;
+}
+
+static double mlazy_order(const struct mlazy_eval *e, size_t *split, double *cost)
+{
+  size_t n = e->n, len, i, j, k;
+  double c;
+  for (i = 0; i < n; i++) cost[i*n + i] = 0.0;
+  for (len = 1; len < n; len++) {
+    for (i = 0; i + len < n; i++) {
+      j = i + len;
+      cost[i*n + j] = GSL_POSINF;
+      for (k = i; k < j; k++) {
+	c = cost[i*n + k] + cost[(k + 1)*n + j] + mlazy_cost(e, i, k, j);
+	if (c < cost[i*n + j]) {
+	  cost[i*n + j] = c;
+	  split[i*n + j] = k;
+	}
+      }
+    }
+  }
+  return cost[n - 1];
+}
+
+static void mlazy_mul(const struct mlazy_op *a, const struct mlazy_op *b, struct mlazy_op *c)
+{
+  gsl_matrix_view A, B, C;
+  gsl_vector_view x, y;
+  size_t i, j;
+  A = gsl_matrix_view_array_with_tda(a->data, a->size1, a->size2, a->tda);
+  if (b->vector) {
+    x = gsl_vector_view_array_with_stride(b->data, b->tda, b->size1);
+    y = gsl_vector_view_array_with_stride(c->data, c->tda, c->size1);
+    gsl_blas_dgemv(a->trans, 1.0, &A.matrix, &x.vector, 0.0, &y.vector);
+    return;
+  }
+  C = gsl_matrix_view_array_with_tda(c->data, c->size1, c->size2, c->tda);
+  if (mlazy_syrk_p(a, b)) {
+    gsl_blas_dsyrk(CblasUpper, a->trans, 1.0, &A.matrix, 0.0, &C.matrix);
+    for (i = 0; i < c->size1; i++)
+      for (j = 0; j < i; j++) c->data[i*c->tda + j] = c->data[j*c->tda + i];
+    return;
+  }
+  B = gsl_matrix_view_array_with_tda(b->data, b->size1, b->size2, b->tda);
+  gsl_blas_dgemm(a->trans, b->trans, 1.0, &A.matrix, &B.matrix, 0.0, &C.matrix);
+}
+
+/* op(a) copied into c, for a chain of a single factor */
+static void mlazy_copy(const struct mlazy_op *a, struct mlazy_op *c)
+{
+  size_t i, j;
+  if (a->vector) {
+    for (i = 0; i < a->size1; i++) c->data[i*c->tda] = a->data[i*a->tda];
+  } else if (a->trans == CblasNoTrans) {
+    for (i = 0; i < a->size1; i++)
+      memcpy(c->data + i*c->tda, a->data + i*a->tda, sizeof(double)*a->size2);
+  } else {
+    for (i = 0; i < a->size2; i++)
+      for (j = 0; j < a->size1; j++) c->data[i*c->tda + j] = a->data[j*a->tda + i];
+  }
+}
+
+static void mlazy_node(const struct mlazy_eval *e, size_t i, size_t j, struct mlazy_op *r)
+{
+  struct mlazy_op a, b;
+  size_t k;
+  if (i == j) {
+    *r = e->leaf[i];
+    return;
+  }
+  k = e->split[i*e->n + j];
+  mlazy_node(e, i, k, &a);
+  mlazy_node(e, k + 1, j, &b);
+  r->data = e->dst[i*e->n + j];
+  r->size1 = e->dim[i];
+  r->vector = b.vector;
+  r->size2 = b.vector ? 1 : e->dim[j+1];
+  if (i == 0 && j == e->n - 1 && !e->copy) r->tda = e->out.tda;
+  else r->tda = b.vector ? 1 : r->size2;
+  r->trans = CblasNoTrans;
+  mlazy_mul(&a, &b, r);
+}
+
+static int mlazy_run(void *data)
+{
+  struct mlazy_eval *e = (struct mlazy_eval *) data;
+  struct mlazy_op r;
+  if (e->n == 1) {
+    mlazy_copy(&e->leaf[0], &e->out);
+    return GSL_SUCCESS;
+  }
+  mlazy_node(e, 0, e->n - 1, &r);
+  if (e->copy) mlazy_copy(&r, &e->out);
+  return GSL_SUCCESS;
+}
+
+/* Offsets of the intermediate products in the shared buffer, the root
+   excepted; returns the buffer size */
+static size_t mlazy_plan(const struct mlazy_eval *e, size_t i, size_t j, size_t *off,
+			 size_t used)
+{
+  size_t k;
+  if (i == j) return used;
+  k = e->split[i*e->n + j];
+  if (i > 0 || j < e->n - 1) {
+    off[i*e->n + j] = used;
+    used += e->dim[i]*e->dim[j+1];
+  }
+  used = mlazy_plan(e, i, k, off, used);
+  return mlazy_plan(e, k + 1, j, off, used);
+}
+
+static int mlazy_overlap(const struct mlazy_op *a, const struct mlazy_op *b)
+{
+  const double *a1 = a->data + (a->size1 - 1)*a->tda + a->size2;
+  const double *b1 = b->data + (b->size1 - 1)*b->tda + b->size2;
+  return a->data < b1 && b->data < a1;
+}
+
+static void mlazy_leaf(VALUE v, CBLAS_TRANSPOSE_t trans, struct mlazy_op *op)
+{
+  gsl_matrix *m;
+  gsl_vector *x;
+  if (MATRIX_P(v)) {
+    Data_Get_Struct(v, gsl_matrix, m);
+    op->data = m->data;
+    op->size1 = m->size1;
+    op->size2 = m->size2;
+    op->tda = m->tda;
+    op->vector = 0;
+  } else {
+    Data_Get_Struct(v, gsl_vector, x);
+    op->data = x->data;
+    op->size1 = x->size;
+    op->size2 = 1;
+    op->tda = x->stride;
+    op->vector = 1;
+  }
+  op->trans = trans;
+}
+
+static void mlazy_prepare(rb_gsl_mlazy *c, struct mlazy_eval *e, size_t *dim, double *cost,
+			  size_t *split)
+{
+  size_t i, r, cols;
+  e->n = c->n;
+  e->dim = dim;
+  e->split = split;
+  for (i = 0; i < c->n; i++) {
+    mlazy_leaf(c->f[i].v, c->f[i].trans, &e->leaf[i]);
+    mlazy_shape(&c->f[i], &r, &cols);
+    dim[i] = r;
+    dim[i+1] = cols;
+  }
+  mlazy_order(e, split, cost);
+}
+
+/* lazy.eval([out]): the product into out or a new Matrix (Vector) */
+static VALUE rb_gsl_mlazy_eval(int argc, VALUE *argv, VALUE obj)
+{
+  rb_gsl_mlazy *c;
+  struct mlazy_eval e;
+  gsl_matrix *M;
+  gsl_vector *V;
+  size_t n, i, total, *dim, *split, *off;
+  double *cost, *buf, work;
+  VALUE vout, vdim, vsplit, voff, vcost, vleaf, vdst, vbuf;
+  Data_Get_Struct(obj, rb_gsl_mlazy, c);
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  n = c->n;
+  dim = ALLOCV_N(size_t, vdim, n + 1);
+  split = ALLOCV_N(size_t, vsplit, n*n);
+  off = ALLOCV_N(size_t, voff, n*n);
+  cost = ALLOCV_N(double, vcost, n*n);
+  e.leaf = ALLOCV_N(struct mlazy_op, vleaf, n);
+  e.dst = ALLOCV_N(double*, vdst, n*n);
+  mlazy_prepare(c, &e, dim, cost, split);
+  work = n > 1 ? cost[n - 1] : (double) dim[0]*dim[n];
+  if (argc == 1) {
+    vout = argv[0];
+  } else if (mlazy_vector_p(c)) {
+    V = gsl_vector_alloc(dim[0]);
+    vout = Data_Wrap_Struct(VECTOR_ROW_COL(c->f[n-1].v), 0, gsl_vector_free, V);
+  } else {
+    M = gsl_matrix_alloc(dim[0], dim[n]);
+    vout = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, M);
+  }
+  if (mlazy_vector_p(c)) {
+    CHECK_VECTOR(vout);
+    Data_Get_Struct(vout, gsl_vector, V);
+    if (V->size != dim[0])
+      rb_raise(rb_eRangeError, "output vector size must be %d", (int) dim[0]);
+  } else {
+    CHECK_MATRIX(vout);
+    Data_Get_Struct(vout, gsl_matrix, M);
+    if (M->size1 != dim[0] || M->size2 != dim[n])
+      rb_raise(rb_eRangeError, "output matrix must be %d x %d", (int) dim[0], (int) dim[n]);
+  }
+  mlazy_leaf(vout, CblasNoTrans, &e.out);
+  e.copy = NULL;
+  for (i = 0; i < n; i++) {
+    if (!mlazy_overlap(&e.out, &e.leaf[i])) continue;
+    if (n == 1 && e.leaf[0].trans != CblasNoTrans)
+      rb_raise(rb_eArgError, "cannot transpose into the matrix itself (use transpose!)");
+    if (n > 1) e.copy = e.out.data;
+  }
+  MEMZERO(off, size_t, n*n);
+  total = n > 1 ? mlazy_plan(&e, 0, n - 1, off, 0) : 0;
+  if (e.copy) total += dim[0]*dim[n];
+  buf = ALLOCV_N(double, vbuf, GSL_MAX(total, 1));
+  for (i = 0; i < n*n; i++) e.dst[i] = buf + off[i];
+  if (n > 1) e.dst[n - 1] = e.copy ? buf + total - dim[0]*dim[n] : e.out.data;
+  rb_gsl_nogvl_call(mlazy_run, &e, (size_t) GSL_MIN(work, (double) SIZE_MAX));
+  ALLOCV_END(vbuf);
+  ALLOCV_END(vdst);
+  ALLOCV_END(vleaf);
+  ALLOCV_END(vcost);
+  ALLOCV_END(voff);
+  ALLOCV_END(vsplit);
+  ALLOCV_END(vdim);
+  RB_GC_GUARD(obj);
+  return vout;
+}
+
+static VALUE mlazy_tree(const struct mlazy_eval *e, size_t i, size_t j)
+{
+  size_t k;
+  if (i == j) return SIZET2NUM(i);
+  k = e->split[i*e->n + j];
+  return rb_ary_new3(2, mlazy_tree(e, i, k), mlazy_tree(e, k + 1, j));
+}
+
+/* The evaluation order as nested pairs of factor indices, [[0, 1], 2]
+   for (a*b)*c */
+static VALUE rb_gsl_mlazy_order(VALUE obj)
+{
+  rb_gsl_mlazy *c;
+  struct mlazy_eval e;
+  size_t n, *dim, *split;
+  double *cost;
+  VALUE vdim, vsplit, vcost, vleaf, vtree;
+  Data_Get_Struct(obj, rb_gsl_mlazy, c);
+  n = c->n;
+  dim = ALLOCV_N(size_t, vdim, n + 1);
+  split = ALLOCV_N(size_t, vsplit, n*n);
+  cost = ALLOCV_N(double, vcost, n*n);
+  e.leaf = ALLOCV_N(struct mlazy_op, vleaf, n);
+  mlazy_prepare(c, &e, dim, cost, split);
+  vtree = mlazy_tree(&e, 0, n - 1);
+  ALLOCV_END(vleaf);
+  ALLOCV_END(vcost);
+  ALLOCV_END(vsplit);
+  ALLOCV_END(vdim);
+  return vtree;
+}
+
+void Init_gsl_matrix_lazy(VALUE module)
+{
+  cgsl_matrix_lazy = rb_define_class_under(cgsl_matrix, "Lazy", cGSL_Object);
+  rb_define_method(cgsl_matrix, "lazy", rb_gsl_matrix_lazy, 0);
+  rb_define_method(cgsl_matrix, "t", rb_gsl_matrix_t, 0);
+
+  rb_define_method(cgsl_matrix_lazy, "*", rb_gsl_matrix_lazy_mul, 1);
+  rb_define_method(cgsl_matrix_lazy, "t", rb_gsl_mlazy_t, 0);
+  rb_define_alias(cgsl_matrix_lazy, "trans", "t");
+  rb_define_alias(cgsl_matrix_lazy, "transpose", "t");
+  rb_define_method(cgsl_matrix_lazy, "size", rb_gsl_mlazy_size, 0);
+  rb_define_method(cgsl_matrix_lazy, "shape", rb_gsl_mlazy_shape, 0);
+  rb_define_method(cgsl_matrix_lazy, "order", rb_gsl_mlazy_order, 0);
+
+  rb_define_method(cgsl_matrix_lazy, "eval", rb_gsl_mlazy_eval, -1);
+  rb_define_alias(cgsl_matrix_lazy, "to_m", "eval");
+  rb_define_alias(cgsl_matrix_lazy, "materialize", "eval");
+}
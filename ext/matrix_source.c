@@ -244,6 +244,7 @@ void parse_submatrix_args(int argc, VALUE *argv, size_t size1, size_t size2,
 VALUE FUNCTION(rb_gsl_matrix,do_something)(VALUE obj, void (*f)(GSL_TYPE(gsl_matrix) *))
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   (*f)(m);
   return obj;
@@ -730,6 +731,7 @@ static VALUE FUNCTION(rb_gsl_matrix,set)(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-5)", argc);
   }
 
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   other = argv[argc-1];
 
@@ -831,6 +833,7 @@ static VALUE FUNCTION(rb_gsl_matrix,set)(int argc, VALUE *argv, VALUE obj)
 static VALUE FUNCTION(rb_gsl_matrix,set_all)(VALUE obj, VALUE x)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   FUNCTION(gsl_matrix,set_all)(m, NUMCONV2(x));
   return obj;
@@ -998,6 +1001,7 @@ static VALUE FUNCTION(rb_gsl_matrix,set_diagonal)(VALUE obj, VALUE diag)
   GSL_TYPE(gsl_vector) *v;
   size_t i, len;
   BASE x;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   switch (TYPE(diag)) {
   case T_FIXNUM: case T_BIGNUM: case T_FLOAT:
@@ -1070,6 +1074,7 @@ static VALUE FUNCTION(rb_gsl_matrix,set_row)(VALUE obj, VALUE i, VALUE vv)
     CHECK_VEC(vv);
     Data_Get_Struct(vv, GSL_TYPE(gsl_vector), v);
   }
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   FUNCTION(gsl_matrix,set_row)(m, FIX2INT(i), v);
   if (flag == 1) FUNCTION(gsl_vector,free)(v);
@@ -1094,13 +1099,14 @@ static VALUE FUNCTION(rb_gsl_matrix,set_col)(VALUE obj, VALUE j, VALUE vv)
     CHECK_VECTOR(vv);
     Data_Get_Struct(vv, GSL_TYPE(gsl_vector), v);
   }
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   FUNCTION(gsl_matrix,set_col)(m, FIX2INT(j), v);
   if (flag == 1) FUNCTION(gsl_vector,free)(v);
   return obj;
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,clone)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_matrix,dup)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL, *mnew = NULL;
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
@@ -1109,6 +1115,12 @@ static VALUE FUNCTION(rb_gsl_matrix,clone)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
+/* shares the data of a frozen matrix, see rb_gsl_array_clone in array.c */
+static VALUE FUNCTION(rb_gsl_matrix,clone)(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_array_clone(argc, argv, obj, FUNCTION(rb_gsl_matrix,dup));
+}
+
 static VALUE FUNCTION(rb_gsl_matrix,memcpy)(VALUE obj, VALUE mm1, VALUE mm2)
 {
   GSL_TYPE(gsl_matrix) *m1 = NULL, *m2 = NULL;
@@ -1150,6 +1162,7 @@ static VALUE FUNCTION(rb_gsl_matrix,swap_rows_bang)(VALUE obj, VALUE i, VALUE j)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
   CHECK_FIXNUM(i);   CHECK_FIXNUM(j);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   FUNCTION(gsl_matrix,swap_rows)(m, FIX2INT(i), FIX2INT(j));
   return obj;
@@ -1169,6 +1182,7 @@ static VALUE FUNCTION(rb_gsl_matrix,swap_columns_bang)(VALUE obj, VALUE i, VALUE
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
   CHECK_FIXNUM(i);   CHECK_FIXNUM(j);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   FUNCTION(gsl_matrix,swap_columns)(m, FIX2INT(i), FIX2INT(j));
   return obj;
@@ -1188,6 +1202,7 @@ static VALUE FUNCTION(rb_gsl_matrix,swap_rowcol_bang)(VALUE obj, VALUE i, VALUE
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
   CHECK_FIXNUM(i);   CHECK_FIXNUM(j);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   FUNCTION(gsl_matrix,swap_rowcol)(m, FIX2INT(i), FIX2INT(j));
   return obj;
@@ -1203,7 +1218,18 @@ static VALUE FUNCTION(rb_gsl_matrix,swap_rowcol)(VALUE obj, VALUE i, VALUE j)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
+/* Tiled, threaded for large matrices (transpose.c) */
 static VALUE FUNCTION(rb_gsl_matrix,transpose_memcpy)(VALUE obj)
+{
+  GSL_TYPE(gsl_matrix) *m = NULL, *mnew = NULL;
+  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
+  mnew = FUNCTION(gsl_matrix,alloc)(m->size2, m->size1);
+  FUNCTION(mygsl_matrix,transpose_memcpy)(mnew, m);
+  return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
+}
+
+/* The element-by-element GSL transpose, kept for comparison */
+static VALUE FUNCTION(rb_gsl_matrix,transpose_naive)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL, *mnew = NULL;
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
@@ -1212,85 +1238,214 @@ static VALUE FUNCTION(rb_gsl_matrix,transpose_memcpy)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
+/* Square matrices, or packed rectangular ones, which change shape */
 static VALUE FUNCTION(rb_gsl_matrix,transpose_bang)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  FUNCTION(gsl_matrix,transpose)(m);
+  FUNCTION(mygsl_matrix,transpose)(m);
   return obj;
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,max)(VALUE obj)
+/* Packed double matrices go through the blocked, possibly threaded
+   reduction of reduce.c */
+static void FUNCTION(mygsl_matrix,minmax_all)(const GSL_TYPE(gsl_matrix) *m,
+					       BASE *min, BASE *max,
+					       size_t *imin, size_t *jmin,
+					       size_t *imax, size_t *jmax)
+{
+#ifdef BASE_DOUBLE
+  size_t kmin, kmax;
+  if (m->tda == m->size2 && m->size1*m->size2 > 0) {
+    mygsl_reduce_minmax(m->data, 1, m->size1*m->size2, min, max, &kmin, &kmax);
+    *imin = kmin/m->size2; *jmin = kmin%m->size2;
+    *imax = kmax/m->size2; *jmax = kmax%m->size2;
+    return;
+  }
+#endif
+  FUNCTION(gsl_matrix,minmax)(m, min, max);
+  FUNCTION(gsl_matrix,minmax_index)(m, imin, jmin, imax, jmax);
+}
+
+/*
+  Extrema of each column (axis 0) or row (axis 1), as a vector (or a
+  column vector for rows), or the index of each in the line, as a
+  Vector::Int.  op is MYGSL_REDUCE_MIN or MYGSL_REDUCE_MAX.
+*/
+static VALUE FUNCTION(rb_gsl_matrix,minmax_axis)(VALUE obj, int axis, int op,
+						  int index)
+{
+  GSL_TYPE(gsl_matrix) *m = NULL;
+  GSL_TYPE(gsl_vector) *v = NULL;
+  gsl_vector_int *vi = NULL;
+  size_t n, k, *ir = NULL;
+#ifndef BASE_DOUBLE
+  size_t i, j;
+  BASE x;
+#endif
+  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
+  if (m->size1 == 0 || m->size2 == 0) rb_raise(rb_eArgError, "empty matrix");
+  n = axis == 0 ? m->size2 : m->size1;
+  v = FUNCTION(gsl_vector,alloc)(n);
+  ir = ALLOC_N(size_t, n);
+#ifdef BASE_DOUBLE
+  mygsl_reduce_axis(m, axis, op, NULL, v->data, v->stride, ir);
+#else
+  for (k = 0; k < n; k++) {
+    FUNCTION(gsl_vector,set)(v, k, axis == 0 ? FUNCTION(gsl_matrix,get)(m, 0, k)
+			     : FUNCTION(gsl_matrix,get)(m, k, 0));
+    ir[k] = 0;
+  }
+  for (i = 0; i < m->size1; i++) {
+    for (j = 0; j < m->size2; j++) {
+      x = FUNCTION(gsl_matrix,get)(m, i, j);
+      k = axis == 0 ? j : i;
+      if (op == MYGSL_REDUCE_MAX ? x > FUNCTION(gsl_vector,get)(v, k)
+	  : x < FUNCTION(gsl_vector,get)(v, k)) {
+	FUNCTION(gsl_vector,set)(v, k, x);
+	ir[k] = axis == 0 ? i : j;
+      }
+    }
+  }
+#endif
+  if (index) {
+    vi = gsl_vector_int_alloc(n);
+    for (k = 0; k < n; k++) gsl_vector_int_set(vi, k, (int) ir[k]);
+    xfree(ir);
+    FUNCTION(gsl_vector,free)(v);
+    return Data_Wrap_Struct(axis == 0 ? cgsl_vector_int : cgsl_vector_int_col, 0,
+			    gsl_vector_int_free, vi);
+  }
+  xfree(ir);
+  if (axis == 0)
+    return Data_Wrap_Struct(GSL_TYPE(cgsl_vector), 0, FUNCTION(gsl_vector,free), v);
+  return Data_Wrap_Struct(QUALIFIED_VIEW(cgsl_vector,col), 0, FUNCTION(gsl_vector,free), v);
+}
+
+static VALUE FUNCTION(rb_gsl_matrix,max)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
+  BASE min, max;
+  size_t imin, jmin, imax, jmax;
+  int axis = rb_gsl_axis_opts(argc, argv, NULL);
+  if (axis >= 0) return FUNCTION(rb_gsl_matrix,minmax_axis)(obj, axis, MYGSL_REDUCE_MAX, 0);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  return C_TO_VALUE2(FUNCTION(gsl_matrix,max)(m));
+  FUNCTION(mygsl_matrix,minmax_all)(m, &min, &max, &imin, &jmin, &imax, &jmax);
+  return C_TO_VALUE2(max);
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,min)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_matrix,min)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
+  BASE min, max;
+  size_t imin, jmin, imax, jmax;
+  int axis = rb_gsl_axis_opts(argc, argv, NULL);
+  if (axis >= 0) return FUNCTION(rb_gsl_matrix,minmax_axis)(obj, axis, MYGSL_REDUCE_MIN, 0);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  return C_TO_VALUE2(FUNCTION(gsl_matrix,min)(m));
+  FUNCTION(mygsl_matrix,minmax_all)(m, &min, &max, &imin, &jmin, &imax, &jmax);
+  return C_TO_VALUE2(min);
 }
 
 static VALUE FUNCTION(rb_gsl_matrix,minmax)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
   BASE min, max;
+  size_t imin, jmin, imax, jmax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  FUNCTION(gsl_matrix,minmax)(m, &min, &max);
+  FUNCTION(mygsl_matrix,minmax_all)(m, &min, &max, &imin, &jmin, &imax, &jmax);
   return rb_ary_new3(2, C_TO_VALUE2(min), C_TO_VALUE2(max));
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,max_index)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_matrix,max_index)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
-  size_t imax, jmax;
+  BASE min, max;
+  size_t imin, jmin, imax, jmax;
+  int axis = rb_gsl_axis_opts(argc, argv, NULL);
+  if (axis >= 0) return FUNCTION(rb_gsl_matrix,minmax_axis)(obj, axis, MYGSL_REDUCE_MAX, 1);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  FUNCTION(gsl_matrix,max_index)(m, &imax, &jmax);
+  FUNCTION(mygsl_matrix,minmax_all)(m, &min, &max, &imin, &jmin, &imax, &jmax);
   return rb_ary_new3(2, INT2FIX(imax), INT2FIX(jmax));
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,min_index)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_matrix,min_index)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
-  size_t imin, jmin;
+  BASE min, max;
+  size_t imin, jmin, imax, jmax;
+  int axis = rb_gsl_axis_opts(argc, argv, NULL);
+  if (axis >= 0) return FUNCTION(rb_gsl_matrix,minmax_axis)(obj, axis, MYGSL_REDUCE_MIN, 1);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  FUNCTION(gsl_matrix,min_index)(m, &imin, &jmin);
+  FUNCTION(mygsl_matrix,minmax_all)(m, &min, &max, &imin, &jmin, &imax, &jmax);
   return rb_ary_new3(2, INT2FIX(imin), INT2FIX(jmin));
 }
 
 static VALUE FUNCTION(rb_gsl_matrix,minmax_index)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
+  BASE min, max;
   size_t imin, jmin, imax, jmax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  FUNCTION(gsl_matrix,minmax_index)(m, &imin, &jmin, &imax, &jmax);
+  FUNCTION(mygsl_matrix,minmax_all)(m, &min, &max, &imin, &jmin, &imax, &jmax);
   return rb_ary_new3(2, rb_ary_new3(2, INT2FIX(imin), INT2FIX(jmin)),
 		     rb_ary_new3(2, INT2FIX(imax), INT2FIX(jmax)));
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,fwrite)(VALUE obj, VALUE io)
+/* The rows of h as the segments of rb_gsl_zfwrite and rb_gsl_zfread:
+   one when they are contiguous */
+static size_t FUNCTION(mygsl_matrix,segments)(GSL_TYPE(gsl_matrix) *h, void ***seg,
+					      size_t **len)
+{
+  size_t i, n = h->tda == h->size2 ? 1 : h->size1;
+  *seg = ALLOC_N(void*, n);
+  *len = ALLOC_N(size_t, n);
+  for (i = 0; i < n; i++) {
+    (*seg)[i] = h->data + i*h->tda;
+    (*len)[i] = n == 1 ? h->size1*h->size2 : h->size2;
+  }
+  return n;
+}
+
+/* fwrite(io[, :compress => :zstd, :level => 3]): see compress.c */
+static VALUE FUNCTION(rb_gsl_matrix,fwrite)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *h = NULL;
   FILE *f = NULL;
-  int status, flag = 0;
+  VALUE io, opts;
+  void **seg;
+  size_t *len, n;
+  int status, flag = 0, codec, level = 0;
+  rb_scan_args(argc, argv, "11", &io, &opts);
+  codec = rb_gsl_compress_options(opts, &level);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), h);
   f = rb_gsl_open_writefile(io, &flag);
-  status = FUNCTION(gsl_matrix,fwrite)(f, h);
+  if (codec == RB_GSL_CODEC_NONE) {
+    status = FUNCTION(gsl_matrix,fwrite)(f, h);
+  } else {
+    n = FUNCTION(mygsl_matrix,segments)(h, &seg, &len);
+    status = rb_gsl_zfwrite(f, codec, level, sizeof(BASE), seg, len, n);
+    xfree(len);
+    xfree(seg);
+  }
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
 
+/* Reads raw or compressed data */
 static VALUE FUNCTION(rb_gsl_matrix,fread)(VALUE obj, VALUE io)
 {
   GSL_TYPE(gsl_matrix) *h = NULL;
   FILE *f = NULL;
+  void **seg;
+  size_t *len, n;
   int status, flag = 0;
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), h);
   f = rb_gsl_open_readfile(io, &flag);
-  status = FUNCTION(gsl_matrix,fread)(f, h);
+  n = FUNCTION(mygsl_matrix,segments)(h, &seg, &len);
+  status = rb_gsl_zfread(f, sizeof(BASE), seg, len, n);
+  xfree(len);
+  xfree(seg);
   if (flag == 1) fclose(f);
   return INT2FIX(status);
 }
@@ -1327,26 +1482,54 @@ static VALUE FUNCTION(rb_gsl_matrix,uminus)(VALUE obj)
   return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
 }
 
-VALUE FUNCTION(rb_gsl_matrix,power)(VALUE obj, VALUE bb)
+/* c = a b, by dgemm for double matrices */
+static void FUNCTION(rb_gsl_matrix,power_mul)(const GSL_TYPE(gsl_matrix) *a,
+					   const GSL_TYPE(gsl_matrix) *b,
+					   GSL_TYPE(gsl_matrix) *c)
 {
-  GSL_TYPE(gsl_matrix) *m = NULL, *mtmp = NULL, *mnew = NULL;
-  size_t i, b;
-  CHECK_FIXNUM(bb);
-  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  b = FIX2INT(bb); 
-  mtmp = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
-  mnew = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
-  FUNCTION(gsl_matrix,memcpy)(mnew, m);
-  for (i = 1; i < b; i++) {
-    FUNCTION(gsl_matrix,memcpy)(mtmp, mnew);
 #ifdef BASE_DOUBLE
-    gsl_linalg_matmult(mtmp, m, mnew);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, a, b, 0.0, c);
 #else
-    gsl_linalg_matmult_int(mtmp, m, mnew);
+  gsl_linalg_matmult_int(a, b, c);
 #endif
+}
+
+/* m**b for b >= 0 by repeated squaring: at most 2 log2(b) products,
+   in three buffers */
+VALUE FUNCTION(rb_gsl_matrix,power)(VALUE obj, VALUE bb)
+{
+  GSL_TYPE(gsl_matrix) *m = NULL, *x, *r, *t, *s;
+  long b;
+  int started = 0;
+  CHECK_FIXNUM(bb);
+  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
+  b = FIX2LONG(bb);
+  if (m->size1 != m->size2) rb_raise(rb_eArgError, "matrix must be square");
+  if (b < 0) rb_raise(rb_eArgError, "negative exponent %ld", b);
+  x = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
+  r = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
+  t = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
+  /* r is the product of the squares x = m^(2^k) of the one bits of b */
+  FUNCTION(gsl_matrix,memcpy)(x, m);
+  for (; b > 0; b >>= 1) {
+    if (b & 1) {
+      if (started) {
+	FUNCTION(rb_gsl_matrix,power_mul)(r, x, t);
+	s = r; r = t; t = s;
+      } else {
+	FUNCTION(gsl_matrix,memcpy)(r, x);
+	started = 1;
+      }
+    }
+    if (b > 1) {
+      FUNCTION(rb_gsl_matrix,power_mul)(x, x, t);
+      s = x; x = t; t = s;
+    }
   }
-  FUNCTION(gsl_matrix,free)(mtmp);
-  return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
+  if (!started) FUNCTION(gsl_matrix,set_identity)(r);
+  FUNCTION(gsl_matrix,free)(x);
+  FUNCTION(gsl_matrix,free)(t);
+  return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), r);
 }
 
 static VALUE FUNCTION(rb_gsl_matrix,submatrix)(int argc, VALUE *argv, VALUE obj)
@@ -1459,42 +1642,63 @@ static VALUE FUNCTION(rb_gsl_matrix,vector_view)(VALUE obj)
 }
 
 
-static VALUE FUNCTION(rb_gsl_matrix,each_row)(VALUE obj)
+/*
+  m.each_row { |row| ... }, m.each_col { |col| ... } yield a new view of
+  each row (column).  With :cursor => true one view object is yielded
+  for all of them, moved to the next row before each yield, so that
+  iterating allocates nothing per row: the view is valid only until the
+  next iteration, and must be cloned to be kept.  With :index => true
+  the index is yielded too, |row, i|.
+*/
+static void FUNCTION(rb_gsl_matrix,each_opts)(int argc, VALUE *argv, int *cursor, int *index)
 {
-  GSL_TYPE(gsl_matrix) *m = NULL;
-  QUALIFIED_VIEW(gsl_vector,view) *vv;
-  size_t i;
-  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  for (i = 0; i < m->size1; i++) {
-    vv = ALLOC(QUALIFIED_VIEW(gsl_vector,view));
-    *vv = FUNCTION(gsl_matrix,row)(m, i);
-#ifdef BASE_DOUBLE
-    rb_yield(Data_Wrap_Struct(cgsl_vector_view, 0, free, vv));
-#else
-    rb_yield(Data_Wrap_Struct(cgsl_vector_int_view, 0, free, vv));
-#endif
-  }
-  return obj;
+  VALUE opts;
+  *cursor = *index = 0;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 0) return;
+  opts = argv[0];
+  Check_Type(opts, T_HASH);
+  *cursor = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("cursor"))));
+  *index = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("index"))));
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,each_col)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_matrix,each_vector)(int argc, VALUE *argv, VALUE obj, int col)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
-  QUALIFIED_VIEW(gsl_vector,view) *vv;
-  size_t i;
+  QUALIFIED_VIEW(gsl_vector,view) *vv = NULL;
+  VALUE klass, vview = Qnil;
+  size_t i, n;
+  int cursor, index;
+  FUNCTION(rb_gsl_matrix,each_opts)(argc, argv, &cursor, &index);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  for (i = 0; i < m->size2; i++) {
-    vv = ALLOC(QUALIFIED_VIEW(gsl_vector,view));
-    *vv = FUNCTION(gsl_matrix,column)(m, i);
 #ifdef BASE_DOUBLE
-    rb_yield(Data_Wrap_Struct(cgsl_vector_col_view, 0, free, vv));
+  klass = col ? cgsl_vector_col_view : cgsl_vector_view;
 #else
-    rb_yield(Data_Wrap_Struct(cgsl_vector_int_col_view, 0, free, vv));
+  klass = col ? cgsl_vector_int_col_view : cgsl_vector_int_view;
 #endif
+  n = col ? m->size2 : m->size1;
+  for (i = 0; i < n; i++) {
+    if (!cursor || NIL_P(vview)) {
+      vv = ALLOC(QUALIFIED_VIEW(gsl_vector,view));
+      vview = Data_Wrap_Struct(klass, 0, free, vv);
+    }
+    *vv = col ? FUNCTION(gsl_matrix,column)(m, i) : FUNCTION(gsl_matrix,row)(m, i);
+    if (index) rb_yield_values(2, vview, SIZET2NUM(i));
+    else rb_yield(vview);
   }
   return obj;
 }
 
+static VALUE FUNCTION(rb_gsl_matrix,each_row)(int argc, VALUE *argv, VALUE obj)
+{
+  return FUNCTION(rb_gsl_matrix,each_vector)(argc, argv, obj, 0);
+}
+
+static VALUE FUNCTION(rb_gsl_matrix,each_col)(int argc, VALUE *argv, VALUE obj)
+{
+  return FUNCTION(rb_gsl_matrix,each_vector)(argc, argv, obj, 1);
+}
+
 static VALUE FUNCTION(rb_gsl_matrix,scale_bang)(VALUE obj, VALUE x)
 {
   GSL_TYPE(gsl_matrix) *m;
@@ -1643,10 +1847,19 @@ static VALUE FUNCTION(rb_gsl_matrix,to_tensor)(VALUE obj)
 }
 #endif
 
-static VALUE FUNCTION(rb_gsl_matrix,collect)(VALUE obj)
+/* Matrix#collect(f = nil): f as for Vector#collect(f) */
+static VALUE FUNCTION(rb_gsl_matrix,collect)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL, *mnew;
   size_t i, j;
+  rb_check_arity(argc, 0, 1);
+  if (argc == 1) {
+#ifdef BASE_DOUBLE
+    return rb_gsl_sf_collect(argv[0], obj, Qnil);
+#else
+    rb_raise(rb_eNotImpError, "%s#collect(f) is not implemented", rb_class2name(CLASS_OF(obj)));
+#endif
+  }
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   mnew = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
   for (i = 0; i < m->size1; i++) {
@@ -1657,10 +1870,18 @@ static VALUE FUNCTION(rb_gsl_matrix,collect)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,collect_bang)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_matrix,collect_bang)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m = NULL;
   size_t i, j;
+  rb_check_arity(argc, 0, 1);
+  if (argc == 1) {
+#ifdef BASE_DOUBLE
+    return rb_gsl_sf_collect(argv[0], obj, obj);
+#else
+    rb_raise(rb_eNotImpError, "%s#collect!(f) is not implemented", rb_class2name(CLASS_OF(obj)));
+#endif
+  }
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   for (i = 0; i < m->size1; i++) {
     for (j = 0; j < m->size2; j++) {
@@ -2033,6 +2254,7 @@ static VALUE FUNCTION(rb_gsl_matrix,reverse_columns)(VALUE obj)
 static VALUE FUNCTION(rb_gsl_matrix,reverse_columns_bang)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m, *mnew;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   mnew = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
   FUNCTION(mygsl_matrix,reverse_columns)(mnew, m);
@@ -2053,6 +2275,7 @@ static VALUE FUNCTION(rb_gsl_matrix,reverse_rows)(VALUE obj)
 static VALUE FUNCTION(rb_gsl_matrix,reverse_rows_bang)(VALUE obj)
 {
   GSL_TYPE(gsl_matrix) *m, *mnew;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
   mnew = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2);
   FUNCTION(mygsl_matrix,reverse_rows)(mnew, m);
@@ -2156,7 +2379,7 @@ static VALUE FUNCTION(rb_gsl_matrix,rot90)(int argc, VALUE *argv, VALUE obj)
   case 1:
   case -3:
     mtmp = FUNCTION(gsl_matrix,alloc)(m->size2, m->size1);
-    FUNCTION(gsl_matrix,transpose_memcpy(mtmp, m));
+    FUNCTION(mygsl_matrix,transpose_memcpy)(mtmp, m);
     mnew = FUNCTION(gsl_matrix,alloc)(m->size2, m->size1);
     FUNCTION(mygsl_matrix,reverse_rows)(mnew, mtmp);
     FUNCTION(gsl_matrix,free)(mtmp);
@@ -2172,7 +2395,7 @@ static VALUE FUNCTION(rb_gsl_matrix,rot90)(int argc, VALUE *argv, VALUE obj)
   case 3:
   case -1:
     mtmp = FUNCTION(gsl_matrix,alloc)(m->size2, m->size1);
-    FUNCTION(gsl_matrix,transpose_memcpy(mtmp, m));
+    FUNCTION(mygsl_matrix,transpose_memcpy)(mtmp, m);
     mnew = FUNCTION(gsl_matrix,alloc)(m->size2, m->size1);
     FUNCTION(mygsl_matrix,reverse_columns)(mnew, mtmp);
     FUNCTION(gsl_matrix,free)(mtmp);
@@ -2277,63 +2500,318 @@ static VALUE FUNCTION(rb_gsl_matrix,abs)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,horzcat)(VALUE obj, VALUE mm2)
+/* Copies src into dst at (i0, j0), a row at a time */
+static void FUNCTION(mygsl_matrix,put_block)(GSL_TYPE(gsl_matrix) *dst, size_t i0, size_t j0,
+					      const GSL_TYPE(gsl_matrix) *src)
 {
-  GSL_TYPE(gsl_matrix) *m, *m2, *mnew;
-  QUALIFIED_VIEW(gsl_vector,view) v;
-  size_t j, k;
-  CHECK_MAT(mm2);
-  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  Data_Get_Struct(mm2, GSL_TYPE(gsl_matrix), m2);
-  if (m->size1 != m2->size1) 
-    rb_raise(rb_eRuntimeError, "Different number of rows (%d and %d).",
-	     (int) m->size1, (int) m2->size1);
-  mnew = FUNCTION(gsl_matrix,alloc)(m->size1, m->size2 + m2->size2);
-  for (j = 0, k = 0; j < m->size2; j++, k++) {
-    v = FUNCTION(gsl_matrix,column)(m, j);
-    FUNCTION(gsl_matrix,set_col)(mnew, k, &v.vector);
-  }
-  for (j = 0; j < m2->size2; j++, k++) {
-    v = FUNCTION(gsl_matrix,column)(m2, j);
-    FUNCTION(gsl_matrix,set_col)(mnew, k, &v.vector);
+  size_t i;
+  if (src->size2 == 0) return;
+  for (i = 0; i < src->size1; i++)
+    memcpy(dst->data + (i0 + i)*dst->tda + j0, src->data + i*src->tda,
+	   src->size2*sizeof(BASE));
+}
+
+/*
+  The n matrices of mm side by side (axis 1) or stacked (axis 0), in
+  a matrix sized once: the copies are linear in the total size.
+*/
+static VALUE FUNCTION(mygsl_matrix,concat)(const VALUE *mm, long n, int axis)
+{
+  GSL_TYPE(gsl_matrix) *m, *mnew;
+  size_t size1 = 0, size2 = 0, k;
+  long i;
+  if (n == 0) rb_raise(rb_eArgError, "no matrices to concatenate");
+  for (i = 0; i < n; i++) {
+    CHECK_MAT(mm[i]);
+    Data_Get_Struct(mm[i], GSL_TYPE(gsl_matrix), m);
+    if (axis == 1) {
+      if (i > 0 && m->size1 != size1)
+	rb_raise(rb_eRuntimeError, "Different number of rows (%d and %d).",
+		 (int) size1, (int) m->size1);
+      size1 = m->size1;
+      size2 += m->size2;
+    } else {
+      if (i > 0 && m->size2 != size2)
+	rb_raise(rb_eRuntimeError, "Different number of columns (%d and %d).",
+		 (int) size2, (int) m->size2);
+      size2 = m->size2;
+      size1 += m->size1;
+    }
+  }
+  mnew = FUNCTION(gsl_matrix,alloc)(size1, size2);
+  for (i = 0, k = 0; i < n; i++) {
+    Data_Get_Struct(mm[i], GSL_TYPE(gsl_matrix), m);
+    if (axis == 1) {
+      FUNCTION(mygsl_matrix,put_block)(mnew, 0, k, m);
+      k += m->size2;
+    } else {
+      FUNCTION(mygsl_matrix,put_block)(mnew, k, 0, m);
+      k += m->size1;
+    }
   }
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,horzcat_singleton)(VALUE klass, VALUE mm, VALUE mm2)
+/* m.horzcat(m2, ...) */
+static VALUE FUNCTION(rb_gsl_matrix,horzcat)(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE *mm = ALLOCA_N(VALUE, argc + 1);
+  mm[0] = obj;
+  MEMCPY(mm + 1, argv, VALUE, argc);
+  return FUNCTION(mygsl_matrix,concat)(mm, argc + 1, 1);
+}
+
+/* Matrix.horzcat(m1, m2, ...) */
+static VALUE FUNCTION(rb_gsl_matrix,horzcat_singleton)(int argc, VALUE *argv, VALUE klass)
 {
-  CHECK_MAT(mm);
-  return FUNCTION(rb_gsl_matrix,horzcat)(mm, mm2);
+  return FUNCTION(mygsl_matrix,concat)(argv, argc, 1);
 }
 
+static VALUE FUNCTION(rb_gsl_matrix,vertcat)(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE *mm = ALLOCA_N(VALUE, argc + 1);
+  mm[0] = obj;
+  MEMCPY(mm + 1, argv, VALUE, argc);
+  return FUNCTION(mygsl_matrix,concat)(mm, argc + 1, 0);
+}
 
-static VALUE FUNCTION(rb_gsl_matrix,vertcat)(VALUE obj, VALUE mm2)
+static VALUE FUNCTION(rb_gsl_matrix,vertcat_singleton)(int argc, VALUE *argv, VALUE klass)
 {
-  GSL_TYPE(gsl_matrix) *m, *m2, *mnew;
-  QUALIFIED_VIEW(gsl_vector,view) v;
-  size_t i, k;
-  CHECK_MAT(mm2);
-  Data_Get_Struct(obj, GSL_TYPE(gsl_matrix), m);
-  Data_Get_Struct(mm2, GSL_TYPE(gsl_matrix), m2);
-  if (m->size2 != m2->size2) 
-    rb_raise(rb_eRuntimeError, "Different number of columns (%d and %d).",
-	     (int) m->size2, (int) m2->size2);
-  mnew = FUNCTION(gsl_matrix,alloc)(m->size1 + m2->size1, m->size2);
-  for (i = 0, k = 0; i < m->size1; i++, k++) {
-    v = FUNCTION(gsl_matrix,row)(m, i);
-    FUNCTION(gsl_matrix,set_row)(mnew, k, &v.vector);
+  return FUNCTION(mygsl_matrix,concat)(argv, argc, 0);
+}
+
+/* Matrix.concat([m1, m2, ...], :axis => 0): stacked, or side by side for 1 */
+static VALUE FUNCTION(rb_gsl_matrix,concat_singleton)(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE list, v;
+  int axis = 0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  list = argv[0];
+  Check_Type(list, T_ARRAY);
+  if (argc == 2) {
+    Check_Type(argv[1], T_HASH);
+    v = rb_hash_aref(argv[1], ID2SYM(rb_intern("axis")));
+    if (!NIL_P(v)) axis = NUM2INT(v);
+    if (axis != 0 && axis != 1) rb_raise(rb_eArgError, "axis must be 0 or 1");
+  }
+  return FUNCTION(mygsl_matrix,concat)(RARRAY_CONST_PTR(list), RARRAY_LEN(list), axis);
+}
+
+/*
+  Matrix.block([[a, b], [c, d]]): the block matrix of rows of matrices,
+  nil for a zero block whose size the others of its row and column give
+*/
+static VALUE FUNCTION(rb_gsl_matrix,block_singleton)(VALUE klass, VALUE rows)
+{
+  GSL_TYPE(gsl_matrix) *m, *mnew;
+  size_t *h, *w, size1 = 0, size2 = 0, i0, j0;
+  long nr, nc, r, c;
+  int zero = 0;
+  VALUE row, e, vbuf;
+  Check_Type(rows, T_ARRAY);
+  nr = RARRAY_LEN(rows);
+  if (nr == 0) rb_raise(rb_eArgError, "no blocks");
+  row = rb_ary_entry(rows, 0);
+  Check_Type(row, T_ARRAY);
+  nc = RARRAY_LEN(row);
+  if (nc == 0) rb_raise(rb_eArgError, "no blocks");
+  h = ALLOCV_N(size_t, vbuf, nr + nc);
+  w = h + nr;
+  for (r = 0; r < nr; r++) h[r] = (size_t) -1;
+  for (c = 0; c < nc; c++) w[c] = (size_t) -1;
+  for (r = 0; r < nr; r++) {
+    row = rb_ary_entry(rows, r);
+    Check_Type(row, T_ARRAY);
+    if (RARRAY_LEN(row) != nc)
+      rb_raise(rb_eArgError, "row %d has %d blocks, %d expected", (int) r,
+	       (int) RARRAY_LEN(row), (int) nc);
+    for (c = 0; c < nc; c++) {
+      e = rb_ary_entry(row, c);
+      if (NIL_P(e)) {
+	zero = 1;
+	continue;
+      }
+      CHECK_MAT(e);
+      Data_Get_Struct(e, GSL_TYPE(gsl_matrix), m);
+      if (h[r] != (size_t) -1 && h[r] != m->size1)
+	rb_raise(rb_eRuntimeError, "Different number of rows in block row %d (%d and %d).",
+		 (int) r, (int) h[r], (int) m->size1);
+      if (w[c] != (size_t) -1 && w[c] != m->size2)
+	rb_raise(rb_eRuntimeError, "Different number of columns in block column %d (%d and %d).",
+		 (int) c, (int) w[c], (int) m->size2);
+      h[r] = m->size1;
+      w[c] = m->size2;
+    }
+  }
+  for (r = 0; r < nr; r++) {
+    if (h[r] == (size_t) -1) rb_raise(rb_eArgError, "block row %d has no matrix", (int) r);
+    size1 += h[r];
+  }
+  for (c = 0; c < nc; c++) {
+    if (w[c] == (size_t) -1) rb_raise(rb_eArgError, "block column %d has no matrix", (int) c);
+    size2 += w[c];
+  }
+  mnew = zero ? FUNCTION(gsl_matrix,calloc)(size1, size2) : FUNCTION(gsl_matrix,alloc)(size1, size2);
+  for (r = 0, i0 = 0; r < nr; i0 += h[r], r++) {
+    row = rb_ary_entry(rows, r);
+    for (c = 0, j0 = 0; c < nc; j0 += w[c], c++) {
+      e = rb_ary_entry(row, c);
+      if (NIL_P(e)) continue;
+      Data_Get_Struct(e, GSL_TYPE(gsl_matrix), m);
+      FUNCTION(mygsl_matrix,put_block)(mnew, i0, j0, m);
+    }
+  }
+  ALLOCV_END(vbuf);
+  return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
+}
+
+/*
+  Matrix::Builder: rows appended to a matrix of growing capacity (doubled
+  when full), so that n rows cost O(n) copies in all; to_m gives the
+  rows so far as a matrix of their own.
+*/
+typedef struct {
+  GSL_TYPE(gsl_matrix) *m;      /* capacity x ncol, m->size1 the capacity */
+  size_t n, ncol;
+} GSL_TYPE(mygsl_matrix_builder);
+
+static VALUE GSL_TYPE(cgsl_matrix_builder);
+
+static void FUNCTION(mygsl_matrix_builder,free)(GSL_TYPE(mygsl_matrix_builder) *b)
+{
+  if (b->m) FUNCTION(gsl_matrix,free)(b->m);
+  xfree(b);
+}
+
+/* Room for n more rows */
+static void FUNCTION(mygsl_matrix_builder,reserve)(GSL_TYPE(mygsl_matrix_builder) *b, size_t n)
+{
+  GSL_TYPE(gsl_matrix) *mnew;
+  size_t cap = b->m ? b->m->size1 : 0;
+  if (b->n + n <= cap) return;
+  cap = GSL_MAX(GSL_MAX(2*cap, b->n + n), 16);
+  mnew = FUNCTION(gsl_matrix,alloc)(cap, b->ncol);
+  if (b->m) {
+    memcpy(mnew->data, b->m->data, b->n*b->ncol*sizeof(BASE));
+    FUNCTION(gsl_matrix,free)(b->m);
+  }
+  b->m = mnew;
+}
+
+/* The number of columns, fixed by the first rows when not given */
+static void FUNCTION(mygsl_matrix_builder,width)(GSL_TYPE(mygsl_matrix_builder) *b, size_t ncol)
+{
+  if (b->ncol == 0 && b->n == 0) {
+    if (ncol == 0) rb_raise(rb_eArgError, "rows must not be empty");
+    b->ncol = ncol;
+    return;
   }
-  for (i = 0; i < m2->size1; i++, k++) {
-    v = FUNCTION(gsl_matrix,row)(m2, i);
-    FUNCTION(gsl_matrix,set_row)(mnew, k, &v.vector);
+  if (ncol != b->ncol)
+    rb_raise(rb_eRuntimeError, "Different number of columns (%d and %d).",
+	     (int) b->ncol, (int) ncol);
+}
+
+/* Matrix::Builder.alloc(ncol = nil, capacity = 0) */
+static VALUE FUNCTION(rb_gsl_matrix_builder,new)(int argc, VALUE *argv, VALUE klass)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  VALUE obj;
+  size_t cap = 0;
+  if (argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 to 2)", argc);
+  b = ALLOC(GSL_TYPE(mygsl_matrix_builder));
+  b->m = NULL;
+  b->n = 0;
+  b->ncol = 0;
+  obj = Data_Wrap_Struct(klass, 0, FUNCTION(mygsl_matrix_builder,free), b);
+  if (argc > 0 && !NIL_P(argv[0])) b->ncol = NUM2SIZET(argv[0]);
+  if (argc > 1) cap = NUM2SIZET(argv[1]);
+  if (cap > 0 && b->ncol > 0) FUNCTION(mygsl_matrix_builder,reserve)(b, cap);
+  return obj;
+}
+
+/* b << row: a Vector or an Array for one row, a Matrix for its rows */
+static VALUE FUNCTION(rb_gsl_matrix_builder,push)(VALUE obj, VALUE x)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  GSL_TYPE(gsl_matrix) *m;
+  GSL_TYPE(gsl_vector) *v;
+  BASE *row;
+  size_t j;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  if (TYPE(x) == T_ARRAY) {
+    FUNCTION(mygsl_matrix_builder,width)(b, RARRAY_LEN(x));
+    FUNCTION(mygsl_matrix_builder,reserve)(b, 1);
+    row = b->m->data + b->n*b->ncol;
+    for (j = 0; j < b->ncol; j++) row[j] = (BASE) NUMCONV2(rb_ary_entry(x, j));
+    b->n++;
+  } else if (rb_obj_is_kind_of(x, GSL_TYPE(cgsl_matrix))) {
+    Data_Get_Struct(x, GSL_TYPE(gsl_matrix), m);
+    if (m->size1 == 0) return obj;
+    FUNCTION(mygsl_matrix_builder,width)(b, m->size2);
+    FUNCTION(mygsl_matrix_builder,reserve)(b, m->size1);
+    FUNCTION(mygsl_matrix,put_block)(b->m, b->n, 0, m);
+    b->n += m->size1;
+  } else {
+    CHECK_VEC(x);
+    Data_Get_Struct(x, GSL_TYPE(gsl_vector), v);
+    FUNCTION(mygsl_matrix_builder,width)(b, v->size);
+    FUNCTION(mygsl_matrix_builder,reserve)(b, 1);
+    row = b->m->data + b->n*b->ncol;
+    for (j = 0; j < b->ncol; j++) row[j] = v->data[j*v->stride];
+    b->n++;
   }
+  return obj;
+}
+
+/* The rows appended so far, as a new size1 x ncol Matrix */
+static VALUE FUNCTION(rb_gsl_matrix_builder,to_m)(VALUE obj)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  GSL_TYPE(gsl_matrix) *mnew;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  if (b->n == 0) rb_raise(rb_eRuntimeError, "no rows appended");
+  mnew = FUNCTION(gsl_matrix,alloc)(b->n, b->ncol);
+  memcpy(mnew->data, b->m->data, b->n*b->ncol*sizeof(BASE));
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), mnew);
 }
 
-static VALUE FUNCTION(rb_gsl_matrix,vertcat_singleton)(VALUE klass, VALUE mm, VALUE mm2)
+static VALUE FUNCTION(rb_gsl_matrix_builder,size1)(VALUE obj)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  return SIZET2NUM(b->n);
+}
+
+static VALUE FUNCTION(rb_gsl_matrix_builder,size2)(VALUE obj)
 {
-  CHECK_MAT(mm);
-  return FUNCTION(rb_gsl_matrix,vertcat)(mm, mm2);
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  return b->ncol == 0 ? Qnil : SIZET2NUM(b->ncol);
+}
+
+static VALUE FUNCTION(rb_gsl_matrix_builder,capacity)(VALUE obj)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  return SIZET2NUM(b->m ? b->m->size1 : 0);
+}
+
+static VALUE FUNCTION(rb_gsl_matrix_builder,reserve)(VALUE obj, VALUE nn)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  if (b->ncol == 0) rb_raise(rb_eRuntimeError, "number of columns not known yet");
+  FUNCTION(mygsl_matrix_builder,reserve)(b, NUM2SIZET(nn));
+  return obj;
+}
+
+static VALUE FUNCTION(rb_gsl_matrix_builder,clear)(VALUE obj)
+{
+  GSL_TYPE(mygsl_matrix_builder) *b;
+  Data_Get_Struct(obj, GSL_TYPE(mygsl_matrix_builder), b);
+  b->n = 0;
+  return obj;
 }
 
 #ifdef GSL_1_9_LATER
@@ -2479,9 +2957,9 @@ void FUNCTION(Init_gsl_matrix,init)(VALUE module)
 		   FUNCTION(rb_gsl_matrix,set_row), 2);
   
   rb_define_method(GSL_TYPE(cgsl_matrix), "clone", 
-		   FUNCTION(rb_gsl_matrix,clone), 0);
-  rb_define_alias(GSL_TYPE(cgsl_matrix), "duplicate", "clone");
-  rb_define_alias(GSL_TYPE(cgsl_matrix), "dup", "clone");
+		   FUNCTION(rb_gsl_matrix,clone), -1);
+  rb_define_method(GSL_TYPE(cgsl_matrix), "dup", FUNCTION(rb_gsl_matrix,dup), 0);
+  rb_define_alias(GSL_TYPE(cgsl_matrix), "duplicate", "dup");
   rb_define_method(GSL_TYPE(cgsl_matrix), "isnull", 
 		   FUNCTION(rb_gsl_matrix,isnull), 0);
   rb_define_method(GSL_TYPE(cgsl_matrix), "isnull?", 
@@ -2508,6 +2986,8 @@ void FUNCTION(Init_gsl_matrix,init)(VALUE module)
 		   FUNCTION(rb_gsl_matrix,transpose_memcpy), 0);
   rb_define_alias(GSL_TYPE(cgsl_matrix), "transpose", "transpose_memcpy");
   rb_define_alias(GSL_TYPE(cgsl_matrix), "trans", "transpose_memcpy");
+  rb_define_method(GSL_TYPE(cgsl_matrix), "transpose_naive",
+		   FUNCTION(rb_gsl_matrix,transpose_naive), 0);
   rb_define_method(GSL_TYPE(cgsl_matrix), "transpose!", 
 		   FUNCTION(rb_gsl_matrix,transpose_bang), 0);
   rb_define_alias(GSL_TYPE(cgsl_matrix), "trans!", "transpose!");
@@ -2525,19 +3005,21 @@ void FUNCTION(Init_gsl_matrix,init)(VALUE module)
   rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "swap", 
 			     FUNCTION(rb_gsl_matrix,swap), 2);
 
-  rb_define_method(GSL_TYPE(cgsl_matrix), "max", FUNCTION(rb_gsl_matrix,max), 0);
-  rb_define_method(GSL_TYPE(cgsl_matrix), "min", FUNCTION(rb_gsl_matrix,min), 0);
+  rb_define_method(GSL_TYPE(cgsl_matrix), "max", FUNCTION(rb_gsl_matrix,max), -1);
+  rb_define_method(GSL_TYPE(cgsl_matrix), "min", FUNCTION(rb_gsl_matrix,min), -1);
   rb_define_method(GSL_TYPE(cgsl_matrix), "minmax",
 		   FUNCTION(rb_gsl_matrix,minmax), 0);
   rb_define_method(GSL_TYPE(cgsl_matrix), "max_index",
-		   FUNCTION(rb_gsl_matrix,max_index), 0);
+		   FUNCTION(rb_gsl_matrix,max_index), -1);
+  rb_define_alias(GSL_TYPE(cgsl_matrix), "argmax", "max_index");
   rb_define_method(GSL_TYPE(cgsl_matrix), "min_index", 
-		   FUNCTION(rb_gsl_matrix,min_index), 0);
+		   FUNCTION(rb_gsl_matrix,min_index), -1);
+  rb_define_alias(GSL_TYPE(cgsl_matrix), "argmin", "min_index");
   rb_define_method(GSL_TYPE(cgsl_matrix), "minmax_index",
 		   FUNCTION(rb_gsl_matrix,minmax_index), 0);
 
   rb_define_method(GSL_TYPE(cgsl_matrix), "fwrite", 
-		   FUNCTION(rb_gsl_matrix,fwrite), 1);
+		   FUNCTION(rb_gsl_matrix,fwrite), -1);
   rb_define_method(GSL_TYPE(cgsl_matrix), "fread", 
 		   FUNCTION(rb_gsl_matrix,fread), 1);
   rb_define_method(GSL_TYPE(cgsl_matrix), "fprintf",
@@ -2587,9 +3069,9 @@ void FUNCTION(Init_gsl_matrix,init)(VALUE module)
 		   FUNCTION(rb_gsl_matrix,vector_view), 0);
 
   rb_define_method(GSL_TYPE(cgsl_matrix), "each_row", 
-		   FUNCTION(rb_gsl_matrix,each_row), 0);
+		   FUNCTION(rb_gsl_matrix,each_row), -1);
   rb_define_method(GSL_TYPE(cgsl_matrix), "each_col",
-		   FUNCTION(rb_gsl_matrix,each_col), 0);
+		   FUNCTION(rb_gsl_matrix,each_col), -1);
   rb_define_alias(GSL_TYPE(cgsl_matrix), "each_column", "each_col");
 
   rb_define_method(GSL_TYPE(cgsl_matrix), "scale", 
@@ -2613,9 +3095,9 @@ void FUNCTION(Init_gsl_matrix,init)(VALUE module)
   rb_define_alias(GSL_TYPE(cgsl_matrix), "^", "power");
 
   rb_define_method(GSL_TYPE(cgsl_matrix), "collect", 
-		   FUNCTION(rb_gsl_matrix,collect), 0);
+		   FUNCTION(rb_gsl_matrix,collect), -1);
   rb_define_method(GSL_TYPE(cgsl_matrix), "collect!", 
-		   FUNCTION(rb_gsl_matrix,collect_bang), 0);
+		   FUNCTION(rb_gsl_matrix,collect_bang), -1);
   rb_define_alias(GSL_TYPE(cgsl_matrix), "map", "collect");
   rb_define_alias(GSL_TYPE(cgsl_matrix), "map!", "collect!");
 #ifdef HAVE_TENSOR_TENSOR_H
@@ -2691,12 +3173,27 @@ void FUNCTION(Init_gsl_matrix,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_matrix), "abs", FUNCTION(rb_gsl_matrix,abs), 0);
   rb_define_alias(GSL_TYPE(cgsl_matrix), "fabs", "abs");
 
-  rb_define_method(GSL_TYPE(cgsl_matrix), "horzcat", FUNCTION(rb_gsl_matrix,horzcat), 1);
+  rb_define_method(GSL_TYPE(cgsl_matrix), "horzcat", FUNCTION(rb_gsl_matrix,horzcat), -1);
   rb_define_alias(GSL_TYPE(cgsl_matrix), "cat", "horzcat");
-  rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "horzcat", FUNCTION(rb_gsl_matrix,horzcat_singleton), 2);
-
-  rb_define_method(GSL_TYPE(cgsl_matrix), "vertcat", FUNCTION(rb_gsl_matrix,vertcat), 1);
-  rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "vertcat", FUNCTION(rb_gsl_matrix,vertcat_singleton), 2);
+  rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "horzcat", FUNCTION(rb_gsl_matrix,horzcat_singleton), -1);
+
+  rb_define_method(GSL_TYPE(cgsl_matrix), "vertcat", FUNCTION(rb_gsl_matrix,vertcat), -1);
+  rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "vertcat", FUNCTION(rb_gsl_matrix,vertcat_singleton), -1);
+  rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "concat", FUNCTION(rb_gsl_matrix,concat_singleton), -1);
+  rb_define_singleton_method(GSL_TYPE(cgsl_matrix), "block", FUNCTION(rb_gsl_matrix,block_singleton), 1);
+
+  GSL_TYPE(cgsl_matrix_builder) = rb_define_class_under(GSL_TYPE(cgsl_matrix), "Builder", cGSL_Object);
+  rb_define_singleton_method(GSL_TYPE(cgsl_matrix_builder), "alloc", FUNCTION(rb_gsl_matrix_builder,new), -1);
+  rb_define_singleton_method(GSL_TYPE(cgsl_matrix_builder), "new", FUNCTION(rb_gsl_matrix_builder,new), -1);
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "<<", FUNCTION(rb_gsl_matrix_builder,push), 1);
+  rb_define_alias(GSL_TYPE(cgsl_matrix_builder), "push", "<<");
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "to_m", FUNCTION(rb_gsl_matrix_builder,to_m), 0);
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "size1", FUNCTION(rb_gsl_matrix_builder,size1), 0);
+  rb_define_alias(GSL_TYPE(cgsl_matrix_builder), "rows", "size1");
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "size2", FUNCTION(rb_gsl_matrix_builder,size2), 0);
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "capacity", FUNCTION(rb_gsl_matrix_builder,capacity), 0);
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "reserve", FUNCTION(rb_gsl_matrix_builder,reserve), 1);
+  rb_define_method(GSL_TYPE(cgsl_matrix_builder), "clear", FUNCTION(rb_gsl_matrix_builder,clear), 0);
 
 #ifdef GSL_1_9_LATER
   rb_define_method(GSL_TYPE(cgsl_matrix), "ispos", FUNCTION(rb_gsl_matrix,ispos), 0);
@@ -0,0 +1,988 @@
+/*
+  memory.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Native memory accounting.  The data of a GSL::Vector or GSL::Matrix
+  lives in a gsl_block allocated by GSL, which the garbage collector does
+  not see: only the few bytes of the Ruby object count toward the GC
+  thresholds, and a loop creating large temporaries could grow the heap
+  by gigabytes before a GC ran.  rb_gsl_array.h redirects the
+  gsl_{vector,matrix}{,_int,_complex}_{alloc,calloc,free} calls of the
+  extension to the wrappers below, which tell the collector the size of
+  the blocks they allocate and free with rb_gc_adjust_memory_usage.  The
+  bytes currently held are also counted:
+
+    GSL.memory_usage            #=> 0
+    m = GSL::Matrix.alloc(1000, 1000)
+    GSL.memory_usage            #=> 8000000
+
+  Only the vectors and matrices owning their block are counted; views,
+  and the workspaces GSL allocates internally, are not.  The wrappers
+  may be called from the worker threads of GVL-free kernels: the
+  adjustment is an atomic update of the collector counters which never
+  starts a GC itself.
+
+  GSL.with_arena { ... } bump-allocates the vectors and matrices created
+  by the block on the calling thread, records and data together, from
+  chunks of :chunk_size bytes (1 MiB by default).  Freeing such an
+  object only drops a reference on its chunk, and a chunk is released
+  in one piece when its last object is freed after the block returned:
+  thousands of short-lived temporaries then cost a few free() calls
+  instead of one per object.  Blocks larger than a quarter of a chunk
+  are allocated as usual.
+
+    y = GSL.with_arena {
+      a = x*x               # temporaries from the arena
+      (a + x).sum
+    }
+
+  Objects which escape the block stay valid: they keep their chunk
+  alive until they are collected.  They are not copied out, since the
+  views (rows, columns, subvectors) taken of them point into their data.
+  Nested calls share the arena of the outermost one.
+
+  Outside an arena, blocks of up to GSL::Memory.pool_max_size bytes
+  (256 KiB by default) are taken from size-class free lists: a freed
+  vector or matrix goes back to the list of its class on the thread
+  which frees it, and the next allocation of the class on that thread
+  reuses it, so that a loop allocating the same few shapes again and
+  again no longer goes to malloc.  The classes are spaced by a quarter
+  of a power of two.  A thread keeps at most GSL::Memory.pool_cache_size
+  bytes (8 MiB by default) in its lists, which are freed when it exits
+  or on GSL::Memory.trim.
+
+    GSL::Memory.stats
+    #=> {:usage=>..., :pool_hits=>..., :pool_misses=>...,
+    #    :pool_cached=>..., :arena_objects=>...}
+    GSL::Memory.pool = false    # malloc every block
+
+  Blocks of at least GSL::Memory.large_size bytes (8 MiB by default) can
+  be given a placement on NUMA machines and transparent huge pages.  They
+  are then mapped on their own, with the policy of the calling thread:
+
+    GSL::Memory.numa_policy = :first_touch  # or :interleave, a node, :default
+    GSL::Memory.hugepages = true            # madvise(MADV_HUGEPAGE)
+    m = GSL::Memory.with_policy(:interleave, :hugepages => true) {
+      GSL::Matrix.alloc(50000, 50000)       # this allocation only
+    }
+
+  :first_touch writes the pages at allocation, cut as the parallel
+  kernels cut the data, over the threads of GSL::ThreadPool: with
+  GSL::ThreadPool.affinity = true each part lands on the node of the
+  worker which will process it.  :interleave spreads the pages round
+  robin over the nodes the process may use, and a node number binds them
+  to that node; both leave the pages to be faulted in on first use.  A
+  placement the kernel refuses (a node out of reach, no NUMA support)
+  leaves the block with the default one, counted as :numa_failures in
+  GSL::Memory.stats.  With :default and no huge pages, large blocks are
+  allocated as any other.
+
+  The data of pooled and mapped blocks starts on a 64-byte boundary, a
+  cache line and an AVX-512 register.  GSL::Memory.align = 32 or 64
+  extends this to the arena objects and to the blocks above
+  pool_max_size, which are then records of their own instead of GSL
+  allocations; 16 (the default) leaves these to GSL and packs the arena
+  chunks.  The elementwise kernels of array_kernels.c take an aligned
+  path when all their operands are aligned.
+
+    GSL::Memory.align = 64
+    GSL::Memory.alignment(GSL::Vector.alloc(100000))   #=> 64 (or more)
+
+  Rows are not padded: a matrix allocated here keeps tda = size2, which
+  many kernels rely on to treat it as one contiguous array; the rows are
+  aligned when size2 times the element size is a multiple of the
+  boundary.
+*/
+
+#define RB_GSL_MEMORY_C
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_profiler.h"
+#ifdef HAVE_RUBY_ATOMIC_H
+#include "ruby/atomic.h"
+#define MEMORY_INC(x) RUBY_ATOMIC_SIZE_INC(x)
+#define MEMORY_DEC(x) RUBY_ATOMIC_SIZE_DEC(x)
+#define MEMORY_ADD(x, n) RUBY_ATOMIC_SIZE_ADD(x, n)
+#define MEMORY_SUB(x, n) RUBY_ATOMIC_SIZE_SUB(x, n)
+#else
+#define MEMORY_INC(x) ((x)++)
+#define MEMORY_DEC(x) ((x)--)
+#define MEMORY_ADD(x, n) ((x) += (n))
+#define MEMORY_SUB(x, n) ((x) -= (n))
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+static size_t rb_gsl_memory_bytes = 0;
+size_t rb_gsl_memory_align = 16;
+
+static void memory_add(size_t bytes)
+{
+  MEMORY_ADD(rb_gsl_memory_bytes, bytes);
+  RB_GSL_PROF_BYTES(bytes);
+#ifdef HAVE_RB_GC_ADJUST_MEMORY_USAGE
+  rb_gc_adjust_memory_usage((ssize_t) bytes);
+#endif
+}
+
+/* gc is 0 on the exit of a thread, which may come late in the shutdown */
+static void memory_sub(size_t bytes, int gc)
+{
+  MEMORY_SUB(rb_gsl_memory_bytes, bytes);
+#ifdef HAVE_RB_GC_ADJUST_MEMORY_USAGE
+  if (gc) rb_gc_adjust_memory_usage(-(ssize_t) bytes);
+#endif
+}
+
+/* A block allocated by GSL itself and freed here would take the count
+   below zero */
+size_t rb_gsl_memory_usage(void)
+{
+  size_t bytes = rb_gsl_memory_bytes;
+  return (ssize_t) bytes < 0 ? 0 : bytes;
+}
+
+#define ARENA_CHUNK_SIZE (1 << 20)
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+#define ARENA_CACHE 4
+
+/* refs counts the objects allocated in the chunk, plus one while it is
+   the chunk being filled.  Objects are freed by the GC on any thread,
+   hence the atomic count; the other fields belong to the thread which
+   holds the chunk. */
+typedef struct arena_chunk {
+  struct arena_chunk *next;
+  size_t size, used;
+#ifdef HAVE_RUBY_ATOMIC_H
+  rb_atomic_t refs;
+#else
+  unsigned int refs;
+#endif
+} arena_chunk;
+
+#define ARENA_HEADER ARENA_ROUND(sizeof(arena_chunk))
+
+#define POOL_NCLASS 64
+#define POOL_MAX_SIZE (256 << 10)
+#define POOL_CACHE_SIZE (8 << 20)
+
+/* The caches of a thread: empty arena chunks kept for its next arena,
+   and the free lists of the pool, linked through their first word */
+typedef struct {
+  arena_chunk *chunks;
+  int nchunks;
+  void *pool[POOL_NCLASS];
+  size_t pooled;
+} memory_cache;
+
+static RB_GSL_THREAD_LOCAL memory_cache *memory_local = NULL;
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t memory_key;
+#endif
+
+static RB_GSL_THREAD_LOCAL arena_chunk *arena_current = NULL;
+static RB_GSL_THREAD_LOCAL int arena_depth = 0;
+static RB_GSL_THREAD_LOCAL size_t arena_chunk_size;
+
+/* process-wide settings and statistics of GSL::Memory */
+static int pool_enabled = 1;
+static size_t pool_max_size = POOL_MAX_SIZE;
+static size_t pool_cache_size = POOL_CACHE_SIZE;
+static size_t pool_hits = 0, pool_misses = 0, pool_cached = 0;
+static size_t arena_live = 0;
+
+static memory_cache* memory_cache_get(void)
+{
+  if (memory_local == NULL) {
+    if ((memory_local = calloc(1, sizeof(memory_cache))) == NULL) return NULL;
+#ifdef HAVE_PTHREAD_H
+    pthread_setspecific(memory_key, memory_local);
+#endif
+  }
+  return memory_local;
+}
+
+static void pool_free_lists(memory_cache *c, int gc);
+
+static void memory_cache_trim(memory_cache *c, int gc)
+{
+  arena_chunk *k;
+  while ((k = c->chunks) != NULL) {
+    c->chunks = k->next;
+    memory_sub(ARENA_HEADER + k->size, gc);
+    free(k);
+  }
+  c->nchunks = 0;
+  pool_free_lists(c, gc);
+}
+
+#ifdef HAVE_PTHREAD_H
+static void memory_cache_exit(void *p)
+{
+  memory_cache_trim((memory_cache *) p, 0);
+  free(p);
+}
+#endif
+
+static void arena_chunk_release(arena_chunk *k)
+{
+  memory_cache *c = memory_cache_get();
+  if (c && c->nchunks < ARENA_CACHE) {
+    k->next = c->chunks;
+    c->chunks = k;
+    c->nchunks++;
+    return;
+  }
+  memory_sub(ARENA_HEADER + k->size, 1);
+  free(k);
+}
+
+static void arena_chunk_unref(arena_chunk *k)
+{
+#ifdef HAVE_RUBY_ATOMIC_H
+  if (RUBY_ATOMIC_FETCH_SUB(k->refs, 1) == 1) arena_chunk_release(k);
+#else
+  if (--k->refs == 0) arena_chunk_release(k);
+#endif
+}
+
+static arena_chunk* arena_chunk_get(size_t size)
+{
+  memory_cache *c = memory_cache_get();
+  arena_chunk *k = NULL;
+  while (c && (k = c->chunks) != NULL) {
+    c->chunks = k->next;
+    c->nchunks--;
+    if (k->size >= size) break;
+    memory_sub(ARENA_HEADER + k->size, 1);
+    free(k);
+    k = NULL;
+  }
+  if (k == NULL) {
+    if ((k = malloc(ARENA_HEADER + size)) == NULL) return NULL;
+    k->size = size;
+    memory_add(ARENA_HEADER + size);
+  }
+  k->used = 0;
+  k->refs = 1;
+  return k;
+}
+
+/* The padding which puts the data, head bytes into the next object of
+   k, on GSL::Memory.align */
+static size_t arena_pad(arena_chunk *k, size_t head)
+{
+  size_t a = (size_t) ((char *) k + ARENA_HEADER + k->used + head);
+  return (rb_gsl_memory_align - a % rb_gsl_memory_align) % rb_gsl_memory_align;
+}
+
+/* NULL, for the caller to try the pool, outside an arena or for large
+   blocks */
+static void* arena_alloc(size_t bytes, size_t head, arena_chunk **chunk)
+{
+  arena_chunk *k = arena_current, *k2;
+  size_t pad;
+  void *p;
+  if (k == NULL) return NULL;
+  bytes = ARENA_ROUND(bytes);
+  if (bytes > arena_chunk_size/4) return NULL;
+  pad = arena_pad(k, head);
+  if (k->size - k->used < pad + bytes) {
+    if ((k2 = arena_chunk_get(arena_chunk_size)) == NULL) return NULL;
+    arena_chunk_unref(k);
+    arena_current = k = k2;
+    pad = arena_pad(k, head);
+  }
+  p = (char *) k + ARENA_HEADER + k->used + pad;
+  k->used += pad + bytes;
+#ifdef HAVE_RUBY_ATOMIC_H
+  RUBY_ATOMIC_INC(k->refs);
+#else
+  k->refs++;
+#endif
+  MEMORY_INC(arena_live);
+  *chunk = k;
+  return p;
+}
+
+static void arena_free(arena_chunk *k)
+{
+  MEMORY_DEC(arena_live);
+  arena_chunk_unref(k);
+}
+
+/* Size classes: 64 bytes, then four per power of two; 2 MiB, the
+   largest pool_max_size, is class 60.  *size is the upper bound of the
+   class, which falls in the same class. */
+static int pool_class(size_t bytes, size_t *size)
+{
+  size_t b = 64, step;
+  int k = 1;
+  if (bytes <= 64) {
+    *size = 64;
+    return 0;
+  }
+  while (bytes > 2*b) {
+    b *= 2;
+    k += 4;
+  }
+  step = b/4;
+  *size = b + step*((bytes - b + step - 1)/step);
+  return k + (int) ((*size - b)/step) - 1;
+}
+
+/* An arena or pooled object is a record of the vector (matrix), its
+   block, and its chunk or pool size, followed by the data.  It does not
+   own its block, so that nothing but the wrappers would free it, and is
+   recognized by its block being the one of the record. */
+#define RB_GSL_RECORD(t, bt)                    \
+  typedef struct {                              \
+    t x;                                        \
+    bt b;                                       \
+    arena_chunk *chunk;                         \
+    size_t pooled;                              \
+    size_t mapped;                              \
+    size_t heap;                                \
+  } t##_record;
+
+RB_GSL_RECORD(gsl_vector, gsl_block)
+RB_GSL_RECORD(gsl_vector_int, gsl_block_int)
+RB_GSL_RECORD(gsl_vector_complex, gsl_block_complex)
+RB_GSL_RECORD(gsl_matrix, gsl_block)
+RB_GSL_RECORD(gsl_matrix_int, gsl_block_int)
+RB_GSL_RECORD(gsl_matrix_complex, gsl_block_complex)
+
+/* one header size for all, so that a pooled record of any type can be
+   reused by another */
+typedef union {
+  gsl_vector_record v;
+  gsl_vector_int_record vi;
+  gsl_vector_complex_record vz;
+  gsl_matrix_record m;
+  gsl_matrix_int_record mi;
+  gsl_matrix_complex_record mz;
+} memory_record;
+
+/* The records of the pool and the heap start on RECORD_ALIGN, and so
+   does their data, whatever GSL::Memory.align */
+#define RECORD_ALIGN 64
+#define RECORD_HEADER \
+  ((sizeof(memory_record) + RECORD_ALIGN - 1) & ~((size_t) RECORD_ALIGN - 1))
+
+static void* record_malloc(size_t bytes)
+{
+#ifdef HAVE_POSIX_MEMALIGN
+  void *p;
+  return posix_memalign(&p, RECORD_ALIGN, bytes) == 0 ? p : NULL;
+#else
+  return malloc(bytes);
+#endif
+}
+
+static void pool_free_lists(memory_cache *c, int gc)
+{
+  void *p;
+  int k;
+  for (k = 0; k < POOL_NCLASS; k++) {
+    while ((p = c->pool[k]) != NULL) {
+      c->pool[k] = *(void **) p;
+      free(p);
+    }
+  }
+  MEMORY_SUB(pool_cached, c->pooled);
+  memory_sub(c->pooled, gc);
+  c->pooled = 0;
+}
+
+static void* pool_get(size_t bytes, size_t *size)
+{
+  memory_cache *c;
+  void *p;
+  int k;
+  if (!pool_enabled || bytes == 0 || bytes > pool_max_size) return NULL;
+  k = pool_class(bytes, size);
+  if ((c = memory_cache_get()) != NULL && (p = c->pool[k]) != NULL) {
+    c->pool[k] = *(void **) p;
+    c->pooled -= RECORD_HEADER + *size;
+    MEMORY_SUB(pool_cached, RECORD_HEADER + *size);
+    MEMORY_INC(pool_hits);
+    return p;
+  }
+  if ((p = record_malloc(RECORD_HEADER + *size)) == NULL) return NULL;
+  memory_add(RECORD_HEADER + *size);
+  MEMORY_INC(pool_misses);
+  return p;
+}
+
+static void pool_put(void *p, size_t size)
+{
+  memory_cache *c = memory_cache_get();
+  size_t dummy;
+  int k = pool_class(size, &dummy);
+  if (c && pool_enabled && c->pooled + RECORD_HEADER + size <= pool_cache_size) {
+    *(void **) p = c->pool[k];
+    c->pool[k] = p;
+    c->pooled += RECORD_HEADER + size;
+    MEMORY_ADD(pool_cached, RECORD_HEADER + size);
+    return;
+  }
+  memory_sub(RECORD_HEADER + size, 1);
+  free(p);
+}
+
+#define LARGE_SIZE (8 << 20)
+#define LARGE_HUGE_ALIGN (2 << 20)
+#define LARGE_NODES 1024
+#define LARGE_MPOL_BIND 2
+#define LARGE_MPOL_INTERLEAVE 3
+#define LARGE_MPOL_F_MEMS_ALLOWED (1 << 2)
+
+#if defined(HAVE_SYS_MMAN_H) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+#define LARGE_NUMA
+#endif
+
+/* policy is LARGE_NODE for a binding to node */
+enum { LARGE_DEFAULT, LARGE_FIRST_TOUCH, LARGE_INTERLEAVE, LARGE_NODE };
+
+typedef struct {
+  int policy, node, huge;
+} large_policy;
+
+static large_policy large_global = { LARGE_DEFAULT, 0, 0 };
+static RB_GSL_THREAD_LOCAL large_policy *large_local = NULL;
+static size_t large_size = LARGE_SIZE;
+static size_t large_live = 0, numa_failures = 0;
+
+#ifdef HAVE_SYS_MMAN_H
+static size_t large_page(void)
+{
+  long n = sysconf(_SC_PAGESIZE);
+  return n > 0 ? (size_t) n : 4096;
+}
+
+static int large_mbind(void *p, size_t len, const large_policy *lp)
+{
+#ifdef LARGE_NUMA
+  unsigned long mask[LARGE_NODES/(8*sizeof(unsigned long))];
+  size_t w = 8*sizeof(unsigned long);
+  int mode = LARGE_MPOL_BIND;
+  memset(mask, 0, sizeof(mask));
+  if (lp->policy == LARGE_NODE) {
+    mask[lp->node/w] |= 1UL << (lp->node % w);
+  } else {
+    if (syscall(SYS_get_mempolicy, NULL, mask, (unsigned long) LARGE_NODES, NULL,
+                LARGE_MPOL_F_MEMS_ALLOWED) != 0) return -1;
+    mode = LARGE_MPOL_INTERLEAVE;
+  }
+  return (int) syscall(SYS_mbind, p, len, mode, mask, (unsigned long) LARGE_NODES, 0);
+#else
+  return -1;
+#endif
+}
+
+struct large_touch {
+  char *p;
+  size_t len, page, nparts;
+};
+
+static void large_touch_part(void *data, size_t k)
+{
+  struct large_touch *t = (struct large_touch *) data;
+  size_t np = t->len/t->page;
+  size_t a = k*np/t->nparts*t->page, b = (k + 1)*np/t->nparts*t->page;
+  if (k + 1 == t->nparts) b = t->len;
+  memset(t->p + a, 0, b - a);
+}
+
+/* A mapping of its own for a block of bytes, record included, in the
+   policy of the thread; NULL if none is asked for.  With huge pages the
+   mapping is aligned on LARGE_HUGE_ALIGN, its unused ends unmapped. */
+static void* large_alloc(size_t bytes, size_t *mapped)
+{
+  const large_policy *lp = large_local ? large_local : &large_global;
+  struct large_touch t;
+  size_t page = large_page(), len, extra = 0, head;
+  char *p;
+  if (lp->policy == LARGE_DEFAULT && !lp->huge) return NULL;
+  len = (bytes + page - 1)/page*page;
+  if (lp->huge) extra = LARGE_HUGE_ALIGN;
+  p = mmap(NULL, len + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  if (extra) {
+    head = (LARGE_HUGE_ALIGN - (size_t) p % LARGE_HUGE_ALIGN) % LARGE_HUGE_ALIGN;
+    if (head) munmap(p, head);
+    if (extra - head) munmap(p + head + len, extra - head);
+    p += head;
+#ifdef MADV_HUGEPAGE
+    madvise(p, len, MADV_HUGEPAGE);
+#endif
+  }
+  if ((lp->policy == LARGE_INTERLEAVE || lp->policy == LARGE_NODE)
+      && large_mbind(p, len, lp) != 0) MEMORY_INC(numa_failures);
+  if (lp->policy == LARGE_FIRST_TOUCH) {
+    t.p = p;
+    t.len = len;
+    t.page = page;
+    t.nparts = rb_gsl_thread_pool_size();
+    if (t.nparts > len/page) t.nparts = 1;
+    rb_gsl_thread_pool_run(large_touch_part, &t, t.nparts);
+  }
+  memory_add(len);
+  MEMORY_INC(large_live);
+  *mapped = len;
+  return p;
+}
+
+static void large_free(void *p, size_t len)
+{
+  munmap(p, len);
+  memory_sub(len, 1);
+  MEMORY_DEC(large_live);
+}
+#else
+static void* large_alloc(size_t bytes, size_t *mapped) { return NULL; }
+static void large_free(void *p, size_t len) { }
+#endif
+
+/* With GSL::Memory.align above 16, the blocks the pool does not take
+   are records of their own instead of GSL allocations */
+static void* heap_alloc(size_t bytes, size_t *heap)
+{
+  void *p;
+  if (rb_gsl_memory_align <= 16 || (p = record_malloc(bytes)) == NULL) return NULL;
+  memory_add(bytes);
+  *heap = bytes;
+  return p;
+}
+
+/* A record for n elements of e bytes mapped for a large block, from the
+   arena, else from the pool or the heap, else NULL.  Mapped pages are
+   already zero. */
+static void* record_alloc(size_t n, size_t e, int zero, arena_chunk **chunk,
+                          size_t *pooled, size_t *mapped, size_t *heap)
+{
+  void *r;
+  if (n == 0) return NULL;
+  *pooled = 0;
+  *mapped = 0;
+  *heap = 0;
+  if (n*e >= large_size && (r = large_alloc(RECORD_HEADER + n*e, mapped)) != NULL) {
+    *chunk = NULL;
+    return r;
+  }
+  if ((r = arena_alloc(RECORD_HEADER + n*e, RECORD_HEADER, chunk)) == NULL) {
+    *chunk = NULL;
+    if ((r = pool_get(n*e, pooled)) == NULL
+        && (r = heap_alloc(RECORD_HEADER + n*e, heap)) == NULL) return NULL;
+  }
+  if (zero) memset((char *) r + RECORD_HEADER, 0, n*e);
+  return r;
+}
+
+static void heap_free(void *p, size_t bytes)
+{
+  memory_sub(bytes, 1);
+  free(p);
+}
+
+#define RB_GSL_RECORD_ALLOC(t, n, e, zero, r)                   \
+  do {                                                          \
+    arena_chunk *chunk;                                         \
+    size_t pooled, mapped, heap;                                \
+    if ((r = record_alloc(n, e, zero, &chunk, &pooled, &mapped, &heap))) { \
+      r->b.size = n;                                            \
+      r->b.data = (void *) ((char *) r + RECORD_HEADER);        \
+      r->chunk = chunk;                                         \
+      r->pooled = pooled;                                       \
+      r->mapped = mapped;                                       \
+      r->heap = heap;                                           \
+      r->x.data = r->b.data;                                    \
+      r->x.block = &r->b;                                       \
+      r->x.owner = 0;                                           \
+    }                                                           \
+  } while (0)
+
+#define RB_GSL_RECORD_FREE(t, x)                                \
+  do {                                                          \
+    t##_record *r = (t##_record *) x;                           \
+    if (!x->owner && x->block == &r->b) {                       \
+      if (r->mapped) large_free(r, r->mapped);                  \
+      else if (r->heap) heap_free(r, r->heap);                  \
+      else if (r->chunk) arena_free(r->chunk);                  \
+      else pool_put(r, r->pooled);                              \
+      return;                                                   \
+    }                                                           \
+  } while (0)
+
+/* The block size is fixed at allocation, while the size of a vector
+   may be shrunk in place (GSL::Root::Batch does), hence block->size */
+#define RB_GSL_MEMORY_VECTOR(t, e)                                      \
+  static t* rb_##t##_alloc2(size_t n, int zero)                         \
+  {                                                                     \
+    t##_record *r;                                                      \
+    t *v;                                                               \
+    RB_GSL_RECORD_ALLOC(t, n, e, zero, r);                              \
+    if (r) {                                                            \
+      r->x.size = n;                                                    \
+      r->x.stride = 1;                                                  \
+      return &r->x;                                                     \
+    }                                                                   \
+    v = zero ? t##_calloc(n) : t##_alloc(n);                            \
+    if (v && v->block) memory_add(v->block->size*(e));                  \
+    return v;                                                           \
+  }                                                                     \
+  t* rb_##t##_alloc(size_t n) { return rb_##t##_alloc2(n, 0); }         \
+  t* rb_##t##_calloc(size_t n) { return rb_##t##_alloc2(n, 1); }        \
+  void rb_##t##_free(t *v)                                              \
+  {                                                                     \
+    if (v == NULL) return;                                              \
+    RB_GSL_RECORD_FREE(t, v);                                           \
+    if (v->owner && v->block) memory_sub(v->block->size*(e), 1);        \
+    t##_free(v);                                                        \
+  }
+
+#define RB_GSL_MEMORY_MATRIX(t, e)                                      \
+  static t* rb_##t##_alloc2(size_t n1, size_t n2, int zero)             \
+  {                                                                     \
+    t##_record *r;                                                      \
+    t *m;                                                               \
+    RB_GSL_RECORD_ALLOC(t, n1*n2, e, zero, r);                          \
+    if (r) {                                                            \
+      r->x.size1 = n1;                                                  \
+      r->x.size2 = n2;                                                  \
+      r->x.tda = n2;                                                    \
+      return &r->x;                                                     \
+    }                                                                   \
+    m = zero ? t##_calloc(n1, n2) : t##_alloc(n1, n2);                  \
+    if (m && m->block) memory_add(m->block->size*(e));                  \
+    return m;                                                           \
+  }                                                                     \
+  t* rb_##t##_alloc(size_t n1, size_t n2)                               \
+  {                                                                     \
+    return rb_##t##_alloc2(n1, n2, 0);                                  \
+  }                                                                     \
+  t* rb_##t##_calloc(size_t n1, size_t n2)                              \
+  {                                                                     \
+    return rb_##t##_alloc2(n1, n2, 1);                                  \
+  }                                                                     \
+  void rb_##t##_free(t *m)                                              \
+  {                                                                     \
+    if (m == NULL) return;                                              \
+    RB_GSL_RECORD_FREE(t, m);                                           \
+    if (m->owner && m->block) memory_sub(m->block->size*(e), 1);        \
+    t##_free(m);                                                        \
+  }
+
+/* Whether v (m) owns its data, as a vector allocated by GSL or a
+   record: the vector and matrix types of all elements share one layout */
+int rb_gsl_vector_owns_data(const gsl_vector *v)
+{
+  return v->owner || v->block == &((const gsl_vector_record *) v)->b;
+}
+
+int rb_gsl_matrix_owns_data(const gsl_matrix *m)
+{
+  return m->owner || m->block == &((const gsl_matrix_record *) m)->b;
+}
+
+RB_GSL_MEMORY_VECTOR(gsl_vector, sizeof(double))
+RB_GSL_MEMORY_VECTOR(gsl_vector_int, sizeof(int))
+RB_GSL_MEMORY_VECTOR(gsl_vector_complex, 2*sizeof(double))
+RB_GSL_MEMORY_MATRIX(gsl_matrix, sizeof(double))
+RB_GSL_MEMORY_MATRIX(gsl_matrix_int, sizeof(int))
+RB_GSL_MEMORY_MATRIX(gsl_matrix_complex, 2*sizeof(double))
+
+/* GSL.memory_usage: bytes held by the data blocks of the vectors and
+   matrices allocated by the extension, with the arena chunks and the
+   pool lists */
+static VALUE rb_gsl_memory_usage_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_memory_usage());
+}
+
+static VALUE rb_gsl_arena_ensure(VALUE unused)
+{
+  arena_chunk *k = arena_current;
+  if (--arena_depth > 0) return Qnil;
+  arena_current = NULL;
+  arena_chunk_unref(k);
+  return Qnil;
+}
+
+/* GSL.with_arena([:chunk_size => bytes]) { ... }: the value of the block */
+static VALUE rb_gsl_with_arena(int argc, VALUE *argv, VALUE module)
+{
+  VALUE opts = Qnil, v;
+  size_t size = ARENA_CHUNK_SIZE;
+  if (!rb_block_given_p()) rb_raise(rb_eRuntimeError, "block is not given");
+  rb_scan_args(argc, argv, "01", &opts);
+  if (!NIL_P(opts)) {
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("chunk_size"))))) {
+      if (NUM2LONG(v) < 1024)
+        rb_raise(rb_eArgError, "chunk_size must be at least 1024 (%ld given)", NUM2LONG(v));
+      size = NUM2SIZET(v);
+    }
+  }
+  if (arena_depth > 0) {
+    arena_depth++;
+    return rb_ensure(rb_yield, Qnil, rb_gsl_arena_ensure, Qnil);
+  }
+  if ((arena_current = arena_chunk_get(size)) == NULL)
+    rb_raise(rb_eNoMemError, "failed to allocate an arena chunk of %lu bytes",
+             (unsigned long) size);
+  arena_chunk_size = size;
+  arena_depth = 1;
+  return rb_ensure(rb_yield, Qnil, rb_gsl_arena_ensure, Qnil);
+}
+
+static VALUE rb_gsl_memory_stats(VALUE module)
+{
+  VALUE h = rb_hash_new();
+  rb_hash_aset(h, ID2SYM(rb_intern("usage")), SIZET2NUM(rb_gsl_memory_usage()));
+  rb_hash_aset(h, ID2SYM(rb_intern("pool_hits")), SIZET2NUM(pool_hits));
+  rb_hash_aset(h, ID2SYM(rb_intern("pool_misses")), SIZET2NUM(pool_misses));
+  rb_hash_aset(h, ID2SYM(rb_intern("pool_cached")), SIZET2NUM(pool_cached));
+  rb_hash_aset(h, ID2SYM(rb_intern("arena_objects")), SIZET2NUM(arena_live));
+  rb_hash_aset(h, ID2SYM(rb_intern("large_objects")), SIZET2NUM(large_live));
+  rb_hash_aset(h, ID2SYM(rb_intern("numa_failures")), SIZET2NUM(numa_failures));
+  return h;
+}
+
+static VALUE rb_gsl_memory_pool_p(VALUE module)
+{
+  return pool_enabled ? Qtrue : Qfalse;
+}
+
+/* Disabling the pool frees the lists of the calling thread; the other
+   threads empty theirs as they allocate */
+static VALUE rb_gsl_memory_set_pool(VALUE module, VALUE flag)
+{
+  memory_cache *c;
+  pool_enabled = RTEST(flag);
+  if (!pool_enabled && (c = memory_local) != NULL) pool_free_lists(c, 1);
+  return flag;
+}
+
+static VALUE rb_gsl_memory_pool_max_size(VALUE module)
+{
+  return SIZET2NUM(pool_max_size);
+}
+
+static VALUE rb_gsl_memory_set_pool_max_size(VALUE module, VALUE n)
+{
+  if (NUM2LONG(n) < 0 || (size_t) NUM2LONG(n) > ((size_t) 1 << 21))
+    rb_raise(rb_eArgError, "pool_max_size must be in 0..%lu (%ld given)",
+             (unsigned long) 1 << 21, NUM2LONG(n));
+  pool_max_size = NUM2SIZET(n);
+  return n;
+}
+
+static VALUE rb_gsl_memory_pool_cache_size(VALUE module)
+{
+  return SIZET2NUM(pool_cache_size);
+}
+
+static VALUE rb_gsl_memory_set_pool_cache_size(VALUE module, VALUE n)
+{
+  if (NUM2LONG(n) < 0)
+    rb_raise(rb_eArgError, "pool_cache_size must not be negative (%ld given)", NUM2LONG(n));
+  pool_cache_size = NUM2SIZET(n);
+  return n;
+}
+
+/* GSL::Memory.trim: frees the arena chunks and pool lists kept by the
+   calling thread */
+static VALUE rb_gsl_memory_trim(VALUE module)
+{
+  if (memory_local) memory_cache_trim(memory_local, 1);
+  return Qnil;
+}
+
+static VALUE rb_gsl_memory_align_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_memory_align);
+}
+
+static VALUE rb_gsl_memory_set_align(VALUE module, VALUE n)
+{
+  long a = NUM2LONG(n);
+  if (a != 16 && a != 32 && a != 64)
+    rb_raise(rb_eArgError, "align must be 16, 32 or 64 (%ld given)", a);
+  rb_gsl_memory_align = (size_t) a;
+  return n;
+}
+
+/* GSL::Memory.alignment(obj): the largest power of two up to 4096 which
+   divides the address of the data of a vector or matrix */
+static VALUE rb_gsl_memory_alignment(VALUE module, VALUE obj)
+{
+  size_t a, p;
+  if (VECTOR_P(obj) || VECTOR_INT_P(obj) || VECTOR_COMPLEX_P(obj))
+    p = (size_t) ((gsl_vector *) DATA_PTR(obj))->data;
+  else if (MATRIX_P(obj) || MATRIX_INT_P(obj) || MATRIX_COMPLEX_P(obj))
+    p = (size_t) ((gsl_matrix *) DATA_PTR(obj))->data;
+  else
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Vector or GSL::Matrix expected)",
+             rb_class2name(CLASS_OF(obj)));
+  for (a = 1; a < 4096 && p % (2*a) == 0; a *= 2);
+  return SIZET2NUM(a);
+}
+
+static void large_policy_parse(VALUE v, large_policy *lp)
+{
+  ID id = SYMBOL_P(v) ? SYM2ID(v) : 0;
+  if (FIXNUM_P(v)) {
+    if (FIX2LONG(v) < 0 || FIX2LONG(v) >= LARGE_NODES)
+      rb_raise(rb_eArgError, "node must be in 0...%d (%ld given)", LARGE_NODES, FIX2LONG(v));
+    lp->policy = LARGE_NODE;
+    lp->node = FIX2INT(v);
+  } else if (id == rb_intern("default")) {
+    lp->policy = LARGE_DEFAULT;
+  } else if (id == rb_intern("first_touch")) {
+    lp->policy = LARGE_FIRST_TOUCH;
+  } else if (id == rb_intern("interleave")) {
+    lp->policy = LARGE_INTERLEAVE;
+  } else {
+    rb_raise(rb_eArgError,
+             "NUMA policy must be :default, :first_touch, :interleave or a node number");
+  }
+#ifndef HAVE_SYS_MMAN_H
+  if (lp->policy != LARGE_DEFAULT)
+    rb_raise(rb_eNotImpError, "large block policies need mmap");
+#endif
+#ifndef LARGE_NUMA
+  if (lp->policy == LARGE_INTERLEAVE || lp->policy == LARGE_NODE)
+    rb_raise(rb_eNotImpError, "NUMA placement is not supported on this platform");
+#endif
+}
+
+static VALUE large_policy_value(const large_policy *lp)
+{
+  switch (lp->policy) {
+  case LARGE_FIRST_TOUCH: return ID2SYM(rb_intern("first_touch"));
+  case LARGE_INTERLEAVE: return ID2SYM(rb_intern("interleave"));
+  case LARGE_NODE: return INT2FIX(lp->node);
+  default: return ID2SYM(rb_intern("default"));
+  }
+}
+
+static int large_huge_parse(VALUE flag)
+{
+#ifndef MADV_HUGEPAGE
+  if (RTEST(flag))
+    rb_raise(rb_eNotImpError, "transparent huge pages are not supported on this platform");
+#endif
+  return RTEST(flag) ? 1 : 0;
+}
+
+static VALUE rb_gsl_memory_numa_policy(VALUE module)
+{
+  return large_policy_value(large_local ? large_local : &large_global);
+}
+
+static VALUE rb_gsl_memory_set_numa_policy(VALUE module, VALUE v)
+{
+  large_policy lp = large_global;
+  large_policy_parse(v, &lp);
+  large_global = lp;
+  return v;
+}
+
+static VALUE rb_gsl_memory_hugepages(VALUE module)
+{
+  return (large_local ? large_local : &large_global)->huge ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_memory_set_hugepages(VALUE module, VALUE flag)
+{
+  large_global.huge = large_huge_parse(flag);
+  return flag;
+}
+
+static VALUE rb_gsl_memory_large_size(VALUE module)
+{
+  return SIZET2NUM(large_size);
+}
+
+static VALUE rb_gsl_memory_set_large_size(VALUE module, VALUE n)
+{
+  if (NUM2LONG(n) < 0)
+    rb_raise(rb_eArgError, "large_size must not be negative (%ld given)", NUM2LONG(n));
+  large_size = NUM2SIZET(n);
+  return n;
+}
+
+static VALUE rb_gsl_large_ensure(VALUE saved)
+{
+  large_local = (large_policy *) saved;
+  return Qnil;
+}
+
+/* GSL::Memory.with_policy(policy[, :hugepages => flag]) { ... }: the
+   large blocks allocated by the block on the calling thread follow
+   policy (nil: the current one); the value of the block */
+static VALUE rb_gsl_memory_with_policy(int argc, VALUE *argv, VALUE module)
+{
+  VALUE vpolicy, opts = Qnil, v;
+  large_policy lp, *saved = large_local;
+  if (!rb_block_given_p()) rb_raise(rb_eRuntimeError, "block is not given");
+  rb_scan_args(argc, argv, "11", &vpolicy, &opts);
+  lp = saved ? *saved : large_global;
+  if (!NIL_P(vpolicy)) large_policy_parse(vpolicy, &lp);
+  if (!NIL_P(opts)) {
+    Check_Type(opts, T_HASH);
+    v = rb_hash_lookup2(opts, ID2SYM(rb_intern("hugepages")), Qundef);
+    if (v != Qundef) lp.huge = large_huge_parse(v);
+  }
+  large_local = &lp;
+  return rb_ensure(rb_yield, Qnil, rb_gsl_large_ensure, (VALUE) saved);
+}
+
+void Init_gsl_memory(VALUE module)
+{
+  VALUE mMemory;
+#ifdef HAVE_PTHREAD_H
+  pthread_key_create(&memory_key, memory_cache_exit);
+#endif
+  rb_define_module_function(module, "with_arena", rb_gsl_with_arena, -1);
+  rb_define_module_function(module, "memory_usage", rb_gsl_memory_usage_get, 0);
+
+  mMemory = rb_define_module_under(module, "Memory");
+  rb_define_module_function(mMemory, "usage", rb_gsl_memory_usage_get, 0);
+  rb_define_module_function(mMemory, "stats", rb_gsl_memory_stats, 0);
+  rb_define_module_function(mMemory, "pool?", rb_gsl_memory_pool_p, 0);
+  rb_define_module_function(mMemory, "pool=", rb_gsl_memory_set_pool, 1);
+  rb_define_module_function(mMemory, "pool_max_size", rb_gsl_memory_pool_max_size, 0);
+  rb_define_module_function(mMemory, "pool_max_size=", rb_gsl_memory_set_pool_max_size, 1);
+  rb_define_module_function(mMemory, "pool_cache_size", rb_gsl_memory_pool_cache_size, 0);
+  rb_define_module_function(mMemory, "pool_cache_size=", rb_gsl_memory_set_pool_cache_size, 1);
+  rb_define_module_function(mMemory, "trim", rb_gsl_memory_trim, 0);
+  rb_define_module_function(mMemory, "align", rb_gsl_memory_align_get, 0);
+  rb_define_module_function(mMemory, "align=", rb_gsl_memory_set_align, 1);
+  rb_define_module_function(mMemory, "alignment", rb_gsl_memory_alignment, 1);
+  rb_define_module_function(mMemory, "numa_policy", rb_gsl_memory_numa_policy, 0);
+  rb_define_module_function(mMemory, "numa_policy=", rb_gsl_memory_set_numa_policy, 1);
+  rb_define_module_function(mMemory, "hugepages", rb_gsl_memory_hugepages, 0);
+  rb_define_module_function(mMemory, "hugepages=", rb_gsl_memory_set_hugepages, 1);
+  rb_define_module_function(mMemory, "large_size", rb_gsl_memory_large_size, 0);
+  rb_define_module_function(mMemory, "large_size=", rb_gsl_memory_set_large_size, 1);
+  rb_define_module_function(mMemory, "with_policy", rb_gsl_memory_with_policy, -1);
+}
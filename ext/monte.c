@@ -11,6 +11,7 @@
 
 #include "rb_gsl.h"
 #include "rb_gsl_rng.h"
+#include "rb_gsl_function.h"
 #include <gsl/gsl_monte_plain.h>
 #include <gsl/gsl_monte_miser.h>
 #include <gsl/gsl_monte_vegas.h>
@@ -24,6 +25,7 @@ static VALUE cgsl_monte_plain;
 static VALUE cgsl_monte_miser;
 static VALUE cgsl_monte_vegas;
 static VALUE cgsl_monte_function;
+static VALUE cgsl_monte_function_compiled;
 #ifdef GSL_1_13_LATER
 static VALUE cgsl_monte_miser_params, cgsl_monte_vegas_params;
 #endif
@@ -38,6 +40,7 @@ enum {
 static void gsl_monte_function_mark(gsl_monte_function *f);
 static void gsl_monte_function_free(gsl_monte_function *f);
 static double rb_gsl_monte_function_f(double *x, size_t dim, void *p);
+static double rb_gsl_monte_function_vectorized_f(double *x, size_t dim, void *p);
 
 static VALUE rb_gsl_monte_function_set_f(int argc, VALUE *argv, VALUE obj)
 {
@@ -123,6 +126,171 @@ static double rb_gsl_monte_function_f(double *x, size_t dim, void *p)
 }
 
 
+/*
+  Vectorized integrands:
+    GSL::Monte::Function.vectorized(dim[, params]) { |x, y| ... }
+  x is a (n x dim) GSL::Matrix of sample points, one per row; the proc
+  fills the GSL::Vector y of length n (or returns a new Vector).
+  Plain integration draws the points in batches of batch_size; Miser and
+  Vegas still ask for one point at a time.
+*/
+#define RB_GSL_MONTE_BATCH_SIZE 1024
+
+static VALUE rb_gsl_monte_function_vectorized_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_monte_function *F = NULL;
+  VALUE obj;
+  obj = rb_gsl_monte_function_new(argc, argv, klass);
+  Data_Get_Struct(obj, gsl_monte_function, F);
+  F->f = &rb_gsl_monte_function_vectorized_f;
+  rb_ary_store((VALUE) F->params, 2, INT2FIX(RB_GSL_MONTE_BATCH_SIZE));
+  return obj;
+}
+
+int rb_gsl_monte_function_vectorized_p(const gsl_monte_function *F)
+{
+  return F->f == &rb_gsl_monte_function_vectorized_f;
+}
+
+static VALUE rb_gsl_monte_function_is_vectorized(VALUE obj)
+{
+  gsl_monte_function *F = NULL;
+  Data_Get_Struct(obj, gsl_monte_function, F);
+  return rb_gsl_monte_function_vectorized_p(F) ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_monte_function_batch_size(VALUE obj)
+{
+  gsl_monte_function *F = NULL;
+  Data_Get_Struct(obj, gsl_monte_function, F);
+  if (!rb_gsl_monte_function_vectorized_p(F)) return INT2FIX(1);
+  return rb_ary_entry((VALUE) F->params, 2);
+}
+
+static VALUE rb_gsl_monte_function_set_batch_size(VALUE obj, VALUE nn)
+{
+  gsl_monte_function *F = NULL;
+  Data_Get_Struct(obj, gsl_monte_function, F);
+  if (!rb_gsl_monte_function_vectorized_p(F)) 
+    rb_raise(rb_eRuntimeError, "not a vectorized function");
+  if (NUM2INT(nn) <= 0) rb_raise(rb_eArgError, "batch size must be positive");
+  rb_ary_store((VALUE) F->params, 2, INT2FIX(NUM2INT(nn)));
+  return nn;
+}
+
+/* y[i] = f(row i of x) for the n first rows of x */
+static void rb_gsl_monte_function_vectorized_call(VALUE ary, VALUE vx, gsl_matrix *x,
+						  size_t n, double *y)
+{
+  gsl_vector *vy = NULL, *vr = NULL;
+  VALUE proc, params, oy, result;
+  size_t size1, i;
+  proc = rb_ary_entry(ary, 0);
+  params = rb_ary_entry(ary, 1);
+  size1 = x->size1;
+  x->size1 = n;
+  vy = gsl_vector_calloc(n);
+  oy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vy);
+  if (NIL_P(params)) result = rb_funcall(proc, RBGSL_ID_call, 2, vx, oy);
+  else result = rb_funcall(proc, RBGSL_ID_call, 3, vx, oy, params);
+  x->size1 = size1;
+  if (result != oy && VECTOR_P(result)) {
+    Data_Get_Struct(result, gsl_vector, vr);
+    if (vr->size != n) 
+      rb_raise(rb_eRuntimeError, "vectorized function returned a vector of length %d (%d expected)",
+	       (int) vr->size, (int) n);
+    vy = vr;
+  }
+  for (i = 0; i < n; i++) y[i] = gsl_vector_get(vy, i);
+}
+
+/*
+  y[i] = F(row i of x), i = 0...n, x an (n x dim) array of points.
+  Vectorized functions are called only once.
+*/
+void rb_gsl_monte_function_eval_array(gsl_monte_function *F, double *x, double *y, size_t n)
+{
+  gsl_matrix *m = NULL;
+  VALUE vm;
+  size_t i;
+  if (n == 0) return;
+  if (rb_gsl_monte_function_vectorized_p(F)) {
+    m = gsl_matrix_alloc(n, F->dim);
+    memcpy(m->data, x, sizeof(double)*n*F->dim);
+    vm = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+    rb_gsl_monte_function_vectorized_call((VALUE) F->params, vm, m, n, y);
+    RB_GC_GUARD(vm);
+    return;
+  }
+  for (i = 0; i < n; i++) y[i] = GSL_MONTE_FN_EVAL(F, x + i*F->dim);
+}
+
+static double rb_gsl_monte_function_vectorized_f(double *x, size_t dim, void *p)
+{
+  gsl_matrix *m = NULL;
+  VALUE vm;
+  double y;
+  m = gsl_matrix_alloc(1, dim);
+  memcpy(m->data, x, sizeof(double)*dim);
+  vm = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  rb_gsl_monte_function_vectorized_call((VALUE) p, vm, m, 1, &y);
+  return y;
+}
+
+/* Same algorithm and random number sequence as gsl_monte_plain_integrate() */
+static int mygsl_monte_plain_integrate_batched(gsl_monte_function *F, 
+					       const double xl[], const double xu[],
+					       size_t dim, size_t calls, gsl_rng *r,
+					       double *result, double *abserr)
+{
+  gsl_matrix *x = NULL;
+  gsl_vector *y = NULL;
+  VALUE vx, vy;
+  double vol = 1.0, m = 0.0, q = 0.0, d;
+  size_t i, j, k, n, batch, count = 0;
+  if (dim != F->dim) GSL_ERROR("number of dimensions must match", GSL_EINVAL);
+  for (i = 0; i < dim; i++) {
+    if (xu[i] <= xl[i]) GSL_ERROR("xu must be greater than xl", GSL_EINVAL);
+    if (xu[i] - xl[i] > GSL_DBL_MAX) GSL_ERROR("Range of integration is too large, please rescale", GSL_EINVAL);
+    vol *= xu[i] - xl[i];
+  }
+  batch = FIX2INT(rb_ary_entry((VALUE) F->params, 2));
+  if (batch > calls) batch = calls;
+  x = gsl_matrix_alloc(batch, dim);
+  vx = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, x);
+  y = gsl_vector_alloc(batch);
+  vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+  for (k = 0; k < calls; k += n) {
+    n = GSL_MIN(batch, calls - k);
+    for (j = 0; j < n; j++) {
+      for (i = 0; i < dim; i++) 
+	gsl_matrix_set(x, j, i, xl[i] + gsl_rng_uniform_pos(r)*(xu[i] - xl[i]));
+    }
+    rb_gsl_monte_function_vectorized_call((VALUE) F->params, vx, x, n, y->data);
+    for (j = 0; j < n; j++, count++) {
+      d = y->data[j] - m;
+      m += d/(count + 1.0);
+      q += d*d*(count/(count + 1.0));
+    }
+  }
+  *result = vol*m;
+  if (calls < 2) *abserr = GSL_POSINF;
+  else *abserr = vol*sqrt(q/(calls*(calls - 1.0)));
+  RB_GC_GUARD(vx);
+  RB_GC_GUARD(vy);
+  return GSL_SUCCESS;
+}
+
+static int mygsl_monte_plain_integrate(gsl_monte_function *F, const double xl[], 
+				       const double xu[], size_t dim, size_t calls, 
+				       gsl_rng *r, gsl_monte_plain_state *s,
+				       double *result, double *abserr)
+{
+  if (rb_gsl_monte_function_vectorized_p(F))
+    return mygsl_monte_plain_integrate_batched(F, xl, xu, dim, calls, r, result, abserr);
+  return gsl_monte_plain_integrate(F, xl, xu, dim, calls, r, s, result, abserr);
+}
+
 static VALUE rb_gsl_monte_function_eval(VALUE obj, VALUE vx)
 {
   gsl_monte_function *F = NULL;
@@ -289,7 +457,7 @@ static VALUE rb_gsl_monte_integrate(int argc, VALUE *argv, VALUE obj)
 		 rb_class2name(CLASS_OF(argv[argc-1])));
       Data_Get_Struct(argv[argc-1], gsl_monte_plain_state, plain);
     }
-    gsl_monte_plain_integrate(F, xl->data, xu->data, dim, calls, r, plain, &result, &abserr);
+    mygsl_monte_plain_integrate(F, xl->data, xu->data, dim, calls, r, plain, &result, &abserr);
     if (type > 100) gsl_monte_plain_free(plain);
     break;
   case GSL_MONTE_MISER_STATE:
@@ -356,8 +524,8 @@ static VALUE rb_gsl_monte_plain_integrate(int argc, VALUE *argv, VALUE obj)
     r = gsl_rng_alloc(gsl_rng_default);
     flagr = 1;
   }
-  gsl_monte_plain_integrate(F, xl->data, xu->data, dim, calls, r, plain, 
-			    &result, &abserr);
+  mygsl_monte_plain_integrate(F, xl->data, xu->data, dim, calls, r, plain, 
+			      &result, &abserr);
   if (flagr == 1) gsl_rng_free(r);
   return rb_ary_new3(2, rb_float_new(result), rb_float_new(abserr));
 }
@@ -438,6 +606,269 @@ static VALUE rb_gsl_monte_vegas_integrate(int argc, VALUE *argv, VALUE obj)
   return rb_ary_new3(2, rb_float_new(result), rb_float_new(abserr));
 }
 
+/*
+  GSL::Monte::Function::Compiled
+
+    f = GSL::Monte::Function.compile("exp(-a*(x[0]**2 + x[1]**2))", 2, "a" => 1.0)
+
+  The integrand is a GSL::Function::Compiled of dim variables, evaluated
+  without calling back into Ruby, so it can be sampled from several
+  threads at once (see #integrate_parallel).
+*/
+typedef struct {
+  gsl_monte_function F;   /* must be the first member */
+  VALUE compiled;
+} rb_gsl_monte_function_compiled;
+
+static double rb_gsl_monte_function_compiled_f(double *x, size_t dim, void *p)
+{
+  return rb_gsl_function_compiled_eval_multi(p, x);
+}
+
+static void rb_gsl_monte_function_compiled_mark(rb_gsl_monte_function_compiled *f)
+{
+  rb_gc_mark(f->compiled);
+}
+
+static VALUE rb_gsl_monte_function_compile(int argc, VALUE *argv, VALUE klass)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  VALUE obj;
+  size_t dim;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  dim = NUM2INT(argv[1]);
+  if (dim == 0) rb_raise(rb_eArgError, "dimension must be positive");
+  f = ALLOC(rb_gsl_monte_function_compiled);
+  f->compiled = Qnil;
+  f->F.f = &rb_gsl_monte_function_compiled_f;
+  f->F.dim = dim;
+  f->F.params = NULL;
+  obj = Data_Wrap_Struct(cgsl_monte_function_compiled, 
+			 rb_gsl_monte_function_compiled_mark, free, f);
+  f->compiled = rb_gsl_function_compile_multi(argv[0], argc == 3 ? argv[2] : Qnil, dim);
+  f->F.params = rb_gsl_function_compiled_ptr(f->compiled);
+  return obj;
+}
+
+static VALUE rb_gsl_monte_function_compiled_eval(VALUE obj, VALUE vx)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  gsl_vector *x = NULL;
+  CHECK_VECTOR(vx);
+  Data_Get_Struct(obj, rb_gsl_monte_function_compiled, f);
+  Data_Get_Struct(vx, gsl_vector, x);
+  if (x->size != f->F.dim || x->stride != 1)
+    rb_raise(rb_eArgError, "contiguous vector of length %d expected", (int) f->F.dim);
+  return rb_float_new((*f->F.f)(x->data, f->F.dim, f->F.params));
+}
+
+static VALUE rb_gsl_monte_function_compiled_params(VALUE obj)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  Data_Get_Struct(obj, rb_gsl_monte_function_compiled, f);
+  return rb_funcall(f->compiled, rb_intern("params"), 0);
+}
+
+static VALUE rb_gsl_monte_function_compiled_set_params(VALUE obj, VALUE hash)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  Data_Get_Struct(obj, rb_gsl_monte_function_compiled, f);
+  rb_funcall(f->compiled, rb_intern("set_params"), 1, hash);
+  return obj;
+}
+
+static VALUE rb_gsl_monte_function_compiled_expression(VALUE obj)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  Data_Get_Struct(obj, rb_gsl_monte_function_compiled, f);
+  return rb_funcall(f->compiled, rb_intern("expression"), 0);
+}
+
+static VALUE rb_gsl_monte_function_compiled_dim(VALUE obj)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  Data_Get_Struct(obj, rb_gsl_monte_function_compiled, f);
+  return INT2FIX(f->F.dim);
+}
+
+static VALUE rb_gsl_monte_function_compiled_proc(VALUE obj)
+{
+  return Qnil;
+}
+
+/*
+  Parallel sampling: the calls are split over the streams of a
+  GSL::Rng::Pool, each thread integrating with its own state of the same
+  algorithm and parameters. The estimates are combined with inverse
+  variance weights.
+*/
+struct monte_parallel_data {
+  int type;
+  gsl_monte_function *F;
+  double *xl, *xu;
+  size_t dim, calls, n;
+  gsl_rng **r;
+  void **state;
+  double *result, *abserr;
+};
+
+static int monte_parallel_run(void *p, size_t i)
+{
+  struct monte_parallel_data *d = (struct monte_parallel_data *) p;
+  size_t calls;
+  calls = d->calls/d->n + (i < d->calls % d->n ? 1 : 0);
+  switch (d->type) {
+  case GSL_MONTE_PLAIN_STATE:
+    return gsl_monte_plain_integrate(d->F, d->xl, d->xu, d->dim, calls, d->r[i],
+				     (gsl_monte_plain_state *) d->state[i],
+				     &d->result[i], &d->abserr[i]);
+  case GSL_MONTE_MISER_STATE:
+    return gsl_monte_miser_integrate(d->F, d->xl, d->xu, d->dim, calls, d->r[i],
+				     (gsl_monte_miser_state *) d->state[i],
+				     &d->result[i], &d->abserr[i]);
+  default:
+    return gsl_monte_vegas_integrate(d->F, d->xl, d->xu, d->dim, calls, d->r[i],
+				     (gsl_monte_vegas_state *) d->state[i],
+				     &d->result[i], &d->abserr[i]);
+  }
+}
+
+static void* monte_parallel_state_alloc(int type, void *s0, size_t dim)
+{
+  gsl_monte_plain_state *p = NULL;
+  gsl_monte_miser_state *m = NULL, *m0 = (gsl_monte_miser_state *) s0;
+  gsl_monte_vegas_state *v = NULL, *v0 = (gsl_monte_vegas_state *) s0;
+  switch (type) {
+  case GSL_MONTE_PLAIN_STATE:
+    p = gsl_monte_plain_alloc(dim);
+    gsl_monte_plain_init(p);
+    return p;
+  case GSL_MONTE_MISER_STATE:
+    m = gsl_monte_miser_alloc(dim);
+    gsl_monte_miser_init(m);
+    m->estimate_frac = m0->estimate_frac;
+    m->min_calls = m0->min_calls;
+    m->min_calls_per_bisection = m0->min_calls_per_bisection;
+    m->alpha = m0->alpha;
+    m->dither = m0->dither;
+    return m;
+  default:
+    v = gsl_monte_vegas_alloc(dim);
+    gsl_monte_vegas_init(v);
+    v->alpha = v0->alpha;
+    v->iterations = v0->iterations;
+    v->mode = v0->mode;
+    v->verbose = -1;
+    return v;
+  }
+}
+
+static void monte_parallel_state_free(int type, void *s)
+{
+  if (s == NULL) return;
+  switch (type) {
+  case GSL_MONTE_PLAIN_STATE: gsl_monte_plain_free(s); break;
+  case GSL_MONTE_MISER_STATE: gsl_monte_miser_free(s); break;
+  default: gsl_monte_vegas_free(s); break;
+  }
+}
+
+/*
+  state.integrate_parallel(f, xl, xu, [dim,] calls, pool)
+*/
+static VALUE rb_gsl_monte_integrate_parallel(int argc, VALUE *argv, VALUE obj, int type)
+{
+  rb_gsl_monte_function_compiled *f = NULL;
+  gsl_vector *xl = NULL, *xu = NULL;
+  struct monte_parallel_data d;
+  gsl_monte_vegas_state *vegas = NULL;
+  double w, sumw = 0.0, sum = 0.0, sum2 = 0.0, result, abserr, chisq = 0.0;
+  size_t i, npos = 0;
+  int status;
+  void *s0 = NULL;
+
+  if (argc < 5 || argc > 6)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 5 or 6)", argc);
+  if (!rb_obj_is_kind_of(argv[0], cgsl_monte_function_compiled))
+    rb_raise(rb_eTypeError, 
+	     "wrong argument type %s (GSL::Monte::Function::Compiled expected)",
+	     rb_class2name(CLASS_OF(argv[0])));
+  CHECK_VECTOR(argv[1]);  CHECK_VECTOR(argv[2]);
+  Data_Get_Struct(argv[0], rb_gsl_monte_function_compiled, f);
+  Data_Get_Struct(argv[1], gsl_vector, xl);
+  Data_Get_Struct(argv[2], gsl_vector, xu);
+  Data_Get_Struct(obj, void, s0);
+  d.type = type;
+  d.F = &f->F;
+  if (argc == 6) {
+    d.dim = FIX2INT(argv[3]);
+    d.calls = NUM2INT(argv[4]);
+  } else {
+    d.dim = f->F.dim;
+    d.calls = NUM2INT(argv[3]);
+  }
+  if (d.dim != f->F.dim || xl->size < d.dim || xu->size < d.dim)
+    rb_raise(rb_eArgError, "dimension mismatch");
+  d.xl = xl->data;
+  d.xu = xu->data;
+  d.n = rb_gsl_rng_pool_get(argv[argc-1], &d.r);
+  if (d.calls < d.n) d.n = d.calls;
+  if (d.n == 0) rb_raise(rb_eArgError, "number of calls must be positive");
+  d.state = ALLOCA_N(void*, d.n);
+  d.result = ALLOCA_N(double, d.n);
+  d.abserr = ALLOCA_N(double, d.n);
+  for (i = 0; i < d.n; i++) d.state[i] = NULL;
+  for (i = 0; i < d.n; i++) d.state[i] = monte_parallel_state_alloc(type, s0, d.dim);
+
+  status = rb_gsl_nogvl_parallel(monte_parallel_run, &d, d.n);
+
+  for (i = 0; i < d.n; i++) monte_parallel_state_free(type, d.state[i]);
+  for (i = 0; i < d.n; i++) {
+    if (d.abserr[i] > 0.0) {
+      w = 1.0/(d.abserr[i]*d.abserr[i]);
+      sumw += w;
+      sum += w*d.result[i];
+      sum2 += w*d.result[i]*d.result[i];
+      npos++;
+    }
+  }
+  if (npos == d.n) {
+    result = sum/sumw;
+    abserr = 1.0/sqrt(sumw);
+    if (d.n > 1) chisq = (sum2 - sum*result)/(d.n - 1);
+  } else {
+    for (i = 0, result = 0.0, abserr = 0.0; i < d.n; i++) {
+      result += d.result[i];
+      abserr += d.abserr[i]*d.abserr[i];
+    }
+    result /= d.n;
+    abserr = sqrt(abserr)/d.n;
+  }
+  if (type == GSL_MONTE_VEGAS_STATE) {
+    vegas = (gsl_monte_vegas_state *) s0;
+    vegas->result = result;
+    vegas->sigma = abserr;
+    vegas->chisq = chisq;
+  }
+  return rb_ary_new3(3, rb_float_new(result), rb_float_new(abserr), INT2FIX(status));
+}
+
+static VALUE rb_gsl_monte_plain_integrate_parallel(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_monte_integrate_parallel(argc, argv, obj, GSL_MONTE_PLAIN_STATE);
+}
+
+static VALUE rb_gsl_monte_miser_integrate_parallel(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_monte_integrate_parallel(argc, argv, obj, GSL_MONTE_MISER_STATE);
+}
+
+static VALUE rb_gsl_monte_vegas_integrate_parallel(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_monte_integrate_parallel(argc, argv, obj, GSL_MONTE_VEGAS_STATE);
+}
+
 static int get_monte_type(VALUE vt)
 {
   char name[32];
@@ -843,6 +1274,9 @@ static VALUE rb_gsl_monte_vegas_runval(VALUE obj)
 }
 #endif
 
+void Init_gsl_monte_cubature(VALUE mgsl_monte, VALUE cfunction, VALUE ccompiled);
+void Init_gsl_monte_qmc(VALUE mgsl_monte, VALUE cfunction, VALUE ccompiled);
+
 void Init_gsl_monte(VALUE module)
 {
   VALUE mgsl_monte;
@@ -871,6 +1305,31 @@ void Init_gsl_monte(VALUE module)
   rb_define_method(cgsl_monte_function, "set_params", rb_gsl_monte_function_set_params, -1);
 
   rb_define_method(cgsl_monte_function, "integrate", rb_gsl_monte_integrate, -1);
+  rb_define_singleton_method(cgsl_monte_function, "vectorized", rb_gsl_monte_function_vectorized_new, -1);
+  rb_define_method(cgsl_monte_function, "vectorized?", rb_gsl_monte_function_is_vectorized, 0);
+  rb_define_method(cgsl_monte_function, "batch_size", rb_gsl_monte_function_batch_size, 0);
+  rb_define_method(cgsl_monte_function, "batch_size=", rb_gsl_monte_function_set_batch_size, 1);
+
+  cgsl_monte_function_compiled = rb_define_class_under(cgsl_monte_function, "Compiled",
+						       cgsl_monte_function);
+  rb_define_singleton_method(cgsl_monte_function, "compile", rb_gsl_monte_function_compile, -1);
+  rb_undef_alloc_func(cgsl_monte_function_compiled);
+  rb_undef_method(CLASS_OF(cgsl_monte_function_compiled), "new");
+  rb_undef_method(CLASS_OF(cgsl_monte_function_compiled), "alloc");
+  rb_undef_method(CLASS_OF(cgsl_monte_function_compiled), "vectorized");
+  rb_define_method(cgsl_monte_function_compiled, "eval", rb_gsl_monte_function_compiled_eval, 1);
+  rb_define_alias(cgsl_monte_function_compiled, "call", "eval");
+  rb_define_method(cgsl_monte_function_compiled, "params", rb_gsl_monte_function_compiled_params, 0);
+  rb_define_method(cgsl_monte_function_compiled, "set_params", rb_gsl_monte_function_compiled_set_params, 1);
+  rb_define_alias(cgsl_monte_function_compiled, "params=", "set_params");
+  rb_define_method(cgsl_monte_function_compiled, "expression", rb_gsl_monte_function_compiled_expression, 0);
+  rb_define_alias(cgsl_monte_function_compiled, "to_s", "expression");
+  rb_define_method(cgsl_monte_function_compiled, "dim", rb_gsl_monte_function_compiled_dim, 0);
+  rb_define_method(cgsl_monte_function_compiled, "proc", rb_gsl_monte_function_compiled_proc, 0);
+  rb_undef_method(cgsl_monte_function_compiled, "set");
+  rb_undef_method(cgsl_monte_function_compiled, "set_proc");
+  Init_gsl_monte_cubature(mgsl_monte, cgsl_monte_function, cgsl_monte_function_compiled);
+  Init_gsl_monte_qmc(mgsl_monte, cgsl_monte_function, cgsl_monte_function_compiled);
 
   /*****/
   rb_define_singleton_method(cgsl_monte_plain, "new", rb_gsl_monte_plain_new, 1);
@@ -938,6 +1397,12 @@ void Init_gsl_monte(VALUE module)
 			     rb_gsl_monte_integrate, -1);
   rb_define_method(cgsl_monte_vegas, "integrate", 
 		   rb_gsl_monte_vegas_integrate, -1);
+  rb_define_method(cgsl_monte_plain, "integrate_parallel", 
+		   rb_gsl_monte_plain_integrate_parallel, -1);
+  rb_define_method(cgsl_monte_miser, "integrate_parallel", 
+		   rb_gsl_monte_miser_integrate_parallel, -1);
+  rb_define_method(cgsl_monte_vegas, "integrate_parallel", 
+		   rb_gsl_monte_vegas_integrate_parallel, -1);
 
 #ifdef GSL_1_13_LATER
   cgsl_monte_miser_params = rb_define_class_under(cgsl_monte_miser, "Params", cGSL_Object);
@@ -0,0 +1,981 @@
+/*
+  monte_cubature.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Deterministic adaptive cubature over a box xl <= x <= xu, for the smooth
+  low dimensional integrals where Monte Carlo converges too slowly.
+
+    f = GSL::Monte::Function.compile("exp(-x[0]**2 - x[1]**2 - x[2]**2)", 3)
+    res, err, neval, status = GSL::Monte.hcubature(f, [0, 0, 0], [1, 1, 1])
+
+    fs = [f, GSL::Monte::Function.compile("x[0]*x[1]*x[2]", 3)]
+    res, err, = GSL::Monte.pcubature(fs, xl, xu, :epsrel => 1e-10)   # Vectors
+
+    g = lambda { |x| ... }     # x: (points x dim) Matrix, a (points x n) Matrix back
+    GSL::Monte.hcubature(g, xl, xu, :batch => true, :norm => :l2)
+
+  hcubature bisects the subregion with the largest error, each one
+  integrated by the degree 7 rule of Genz and Malik with an embedded
+  degree 5 rule for the error (the 15-point Gauss-Kronrod rule in one
+  dimension).  pcubature refines a tensor product of nested Clenshaw-Curtis
+  rules on the whole box, doubling the order along the dimension with the
+  largest error until it converges: far fewer points for integrands
+  analytic on the box, but no local adaptivity.
+
+  The integrand is a GSL::Monte::Function (vectorized ones see all the
+  points of a step in one call), an Array of them for a vector integrand,
+  or anything responding to call, with a Vector of coordinates (a Matrix
+  of points with :batch) and returning a Numeric, Vector or Array.  When
+  every function is a GSL::Monte::Function::Compiled the points are
+  evaluated without the GVL, split over GSL.parallel_threads for large
+  steps; hcubature then divides all the subregions whose errors are
+  needed to reach the tolerance at once.
+
+  Options :epsabs (0), :epsrel (1e-8), :maxeval (1000000 points) and
+  :norm (:max, :l1 or :l2) for the error of a vector integrand.  Returns
+  [result, abserr, neval, status], Floats for a scalar integrand and
+  Vectors otherwise; status is GSL::EMAXITER when maxeval would be
+  exceeded, GSL::EROUND when the regions cannot be divided further.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_function.h"
+#include "rb_gsl_common.h"
+#include <float.h>
+
+static VALUE cgsl_cuba_function;
+static VALUE cgsl_cuba_function_compiled;
+
+#define CUBA_BLOCK 256
+#define CUBA_MAXBATCH 64
+#define CUBA_MAXDIM 20
+#define CUBA_MAXLEVEL 20
+
+enum {
+  CUBA_FUNCTIONS,
+  CUBA_CALL,
+  CUBA_BATCH,
+};
+
+enum {
+  CUBA_NORM_MAX,
+  CUBA_NORM_L1,
+  CUBA_NORM_L2,
+};
+
+typedef struct {
+  int kind, norm, native, scalar;
+  size_t dim, n, maxeval, neval;
+  double epsabs, epsrel;
+  double *xl, *xu;
+  VALUE f;                      /* the callable, or the Array of Functions */
+  gsl_monte_function **fs;
+  double *x, *y, *col;          /* points (np x dim), values (np x n) */
+  size_t cap;                   /* of x, y and col, in points */
+  double *res, *err, *tmp;      /* n each */
+  /* hcubature: the regions */
+  size_t nreg, rcap, nbatch;
+  double *c, *h;                /* centers and half widths, rcap x dim */
+  double *r, *e;                /* results and errors, rcap x n */
+  double *enorm;
+  size_t *split, *heap, *batch;
+  /* pcubature: the grid, 2^level[d] + 1 points along d */
+  size_t *level, *ipt;
+  double *g;                    /* the values on the grid, the last axis fastest */
+  double **ccw;                 /* Clenshaw-Curtis weights by level */
+  double *q;                    /* (dim + 1) x n */
+} mygsl_cuba;
+
+static void mygsl_cuba_mark(mygsl_cuba *w)
+{
+  rb_gc_mark(w->f);
+}
+
+static void mygsl_cuba_free(mygsl_cuba *w)
+{
+  size_t l;
+  xfree(w->xl);
+  xfree(w->fs);
+  xfree(w->x);
+  xfree(w->y);
+  xfree(w->col);
+  xfree(w->res);
+  xfree(w->c);
+  xfree(w->r);
+  xfree(w->enorm);
+  xfree(w->split);
+  xfree(w->level);
+  xfree(w->g);
+  if (w->ccw) {
+    for (l = 0; l <= CUBA_MAXLEVEL; l++) xfree(w->ccw[l]);
+    xfree(w->ccw);
+  }
+  xfree(w->q);
+  xfree(w);
+}
+
+static double cuba_norm(const mygsl_cuba *w, const double *v)
+{
+  double s = 0.0;
+  size_t k;
+  switch (w->norm) {
+  case CUBA_NORM_L1:
+    for (k = 0; k < w->n; k++) s += fabs(v[k]);
+    return s;
+  case CUBA_NORM_L2:
+    for (k = 0; k < w->n; k++) s += v[k]*v[k];
+    return sqrt(s);
+  default:
+    for (k = 0; k < w->n; k++) if (fabs(v[k]) > s) s = fabs(v[k]);
+    return s;
+  }
+}
+
+static double cuba_tolerance(const mygsl_cuba *w)
+{
+  return GSL_MAX(w->epsabs, w->epsrel*cuba_norm(w, w->res));
+}
+
+/* Room for np points in x and y */
+static void cuba_reserve(mygsl_cuba *w, size_t np)
+{
+  if (np <= w->cap) return;
+  w->cap = GSL_MAX(np, 2*w->cap);
+  REALLOC_N(w->x, double, w->cap*w->dim);
+  REALLOC_N(w->y, double, w->cap*w->n);
+  REALLOC_N(w->col, double, w->cap);
+}
+
+/* Copies a Vector, an Array or (n = 1) a Numeric returned by the
+   integrand into y[0..n-1] */
+static void cuba_row(VALUE v, double *y, size_t n)
+{
+  gsl_vector *vv = NULL;
+  size_t k;
+  if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vv);
+    if (vv->size != n) goto size_error;
+    for (k = 0; k < n; k++) y[k] = gsl_vector_get(vv, k);
+  } else if (TYPE(v) == T_ARRAY) {
+    if ((size_t) RARRAY_LEN(v) != n) goto size_error;
+    for (k = 0; k < n; k++) y[k] = NUM2DBL(rb_ary_entry(v, k));
+  } else if (n == 1 && rb_obj_is_kind_of(v, rb_cNumeric)) {
+    y[0] = NUM2DBL(v);
+  } else {
+    rb_raise(rb_eTypeError, "integrand returned %s (Numeric, Vector or Array expected)",
+	     rb_class2name(CLASS_OF(v)));
+  }
+  return;
+ size_error:
+  rb_raise(rb_eRuntimeError, "integrand returned a value of the wrong size (%d expected)",
+	   (int) n);
+}
+
+static VALUE cuba_points(const mygsl_cuba *w, const double *x, size_t np)
+{
+  gsl_matrix *m = NULL;
+  m = gsl_matrix_alloc(np, w->dim);
+  memcpy(m->data, x, sizeof(double)*np*w->dim);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static VALUE cuba_point(const mygsl_cuba *w, const double *x)
+{
+  gsl_vector *v = NULL;
+  v = gsl_vector_alloc(w->dim);
+  memcpy(v->data, x, sizeof(double)*w->dim);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+/* The number of components from a first call of a Ruby integrand at x;
+   sets w->scalar when it returned numbers */
+static size_t cuba_probe(mygsl_cuba *w, const double *x)
+{
+  gsl_matrix *m = NULL;
+  VALUE v;
+  if (w->kind == CUBA_CALL) {
+    v = rb_funcall(w->f, RBGSL_ID_call, 1, cuba_point(w, x));
+  } else {
+    v = rb_funcall(w->f, RBGSL_ID_call, 1, cuba_points(w, x, 1));
+    if (MATRIX_P(v)) {
+      Data_Get_Struct(v, gsl_matrix, m);
+      return m->size2;
+    }
+    if (VECTOR_P(v)) {
+      w->scalar = 1;
+      return 1;
+    }
+    Check_Type(v, T_ARRAY);
+    if (RARRAY_LEN(v) != 1) rb_raise(rb_eRuntimeError, "integrand returned %d rows (1 expected)",
+				     (int) RARRAY_LEN(v));
+    v = rb_ary_entry(v, 0);
+  }
+  if (VECTOR_P(v)) return ((gsl_vector *) DATA_PTR(v))->size;
+  if (TYPE(v) == T_ARRAY) return RARRAY_LEN(v);
+  w->scalar = 1;
+  return 1;
+}
+
+struct cuba_eval_task {
+  mygsl_cuba *w;
+  double *x, *y;
+  size_t np, nthreads;
+};
+
+static void cuba_eval_block(struct cuba_eval_task *t, size_t i0, size_t i1)
+{
+  mygsl_cuba *w = t->w;
+  gsl_monte_function *F;
+  size_t i, k;
+  for (i = i0; i < i1; i++) {
+    for (k = 0; k < w->n; k++) {
+      F = w->fs[k];
+      t->y[i*w->n + k] = (*F->f)(t->x + i*w->dim, w->dim, F->params);
+    }
+  }
+}
+
+static int cuba_eval_worker(void *data, size_t id)
+{
+  struct cuba_eval_task *t = (struct cuba_eval_task *) data;
+  size_t b;
+  for (b = id*CUBA_BLOCK; b < t->np; b += t->nthreads*CUBA_BLOCK)
+    cuba_eval_block(t, b, GSL_MIN(b + CUBA_BLOCK, t->np));
+  return GSL_SUCCESS;
+}
+
+static int cuba_eval_serial(void *data)
+{
+  struct cuba_eval_task *t = (struct cuba_eval_task *) data;
+  cuba_eval_block(t, 0, t->np);
+  return GSL_SUCCESS;
+}
+
+/* y = f(x) at the np points x */
+static void cuba_eval(mygsl_cuba *w, double *x, double *y, size_t np)
+{
+  struct cuba_eval_task t;
+  gsl_matrix *m = NULL;
+  gsl_vector *vv = NULL;
+  size_t i, k, n = w->n;
+  VALUE v, ox;
+  w->neval += np;
+  switch (w->kind) {
+  case CUBA_FUNCTIONS:
+    if (w->native) {
+      t.w = w;
+      t.x = x;
+      t.y = y;
+      t.np = np;
+      t.nthreads = rb_gsl_parallel_nthreads(np*n, (np + CUBA_BLOCK - 1)/CUBA_BLOCK);
+      if (t.nthreads > 1) rb_gsl_nogvl_parallel(cuba_eval_worker, &t, t.nthreads);
+      else rb_gsl_nogvl_call(cuba_eval_serial, &t, np*n);
+      break;
+    }
+    for (k = 0; k < n; k++) {
+      rb_gsl_monte_function_eval_array(w->fs[k], x, w->col, np);
+      for (i = 0; i < np; i++) y[i*n + k] = w->col[i];
+    }
+    break;
+  case CUBA_CALL:
+    for (i = 0; i < np; i++)
+      cuba_row(rb_funcall(w->f, RBGSL_ID_call, 1, cuba_point(w, x + i*w->dim)), y + i*n, n);
+    break;
+  case CUBA_BATCH:
+    ox = cuba_points(w, x, np);
+    v = rb_funcall(w->f, RBGSL_ID_call, 1, ox);
+    if (MATRIX_P(v)) {
+      Data_Get_Struct(v, gsl_matrix, m);
+      if (m->size1 != np || m->size2 != n)
+	rb_raise(rb_eRuntimeError, "integrand returned a %dx%d matrix (%dx%d expected)",
+		 (int) m->size1, (int) m->size2, (int) np, (int) n);
+      for (i = 0; i < np; i++) memcpy(y + i*n, m->data + i*m->tda, sizeof(double)*n);
+    } else if (n == 1 && VECTOR_P(v)) {
+      Data_Get_Vector(v, vv);
+      if (vv->size != np)
+	rb_raise(rb_eRuntimeError, "integrand returned a vector of length %d (%d expected)",
+		 (int) vv->size, (int) np);
+      for (i = 0; i < np; i++) y[i] = gsl_vector_get(vv, i);
+    } else {
+      Check_Type(v, T_ARRAY);
+      if ((size_t) RARRAY_LEN(v) != np)
+	rb_raise(rb_eRuntimeError, "integrand returned %d rows (%d expected)",
+		 (int) RARRAY_LEN(v), (int) np);
+      for (i = 0; i < np; i++) cuba_row(rb_ary_entry(v, i), y + i*n, n);
+    }
+    RB_GC_GUARD(ox);
+    break;
+  }
+}
+
+/*
+  hcubature
+*/
+
+/* The 15-point Gauss-Kronrod rule of gsl_integration_qk15: xgk[1], xgk[3],
+   ... are the 7-point Gauss nodes */
+static const double cuba_xgk[8] = {
+  0.991455371120812639206854697526329,
+  0.949107912342758524526189684047851,
+  0.864864423359769072789712788640926,
+  0.741531185599394439863864773280788,
+  0.586087235467691130294144845693013,
+  0.405845151377397166906606412076961,
+  0.207784955007898467600689403773245,
+  0.000000000000000000000000000000000
+};
+
+static const double cuba_wg[4] = {
+  0.129484966168869693270611432679082,
+  0.279705391489276667901467771423780,
+  0.381830050505118944950369775488975,
+  0.417959183673469387755102040816327
+};
+
+static const double cuba_wgk[8] = {
+  0.022935322010529224963732008058970,
+  0.063092092629978553290700663189204,
+  0.104790010322250183839876322541518,
+  0.140653259715525918745189590510238,
+  0.169004726639267902826583426598550,
+  0.190350578064785409913256402421014,
+  0.204432940075298892414161999234649,
+  0.209482141084727828012999174891714
+};
+
+/* The number of points of the rule in dim dimensions */
+static size_t cuba_h_npoints(size_t dim)
+{
+  if (dim == 1) return 15;
+  return 1 + 4*dim + 2*dim*(dim - 1) + ((size_t) 1 << dim);
+}
+
+/* The points of the rule for region j: for the Genz-Malik rule the
+   center, +-l2 and +-l3 along each axis, (+-l4, +-l4) in each plane and
+   the 2^dim (+-l5, ..., +-l5) */
+static void cuba_h_fill(const mygsl_cuba *w, size_t j, double *x)
+{
+  const size_t dim = w->dim;
+  const double *c = w->c + j*dim, *h = w->h + j*dim;
+  const double l2 = sqrt(9.0/70.0), l4 = sqrt(9.0/10.0), l5 = sqrt(9.0/19.0);
+  size_t i, k, p, q;
+  double *px;
+  if (dim == 1) {
+    x[0] = c[0];
+    for (p = 0; p < 7; p++) {
+      x[2*p+1] = c[0] - h[0]*cuba_xgk[p];
+      x[2*p+2] = c[0] + h[0]*cuba_xgk[p];
+    }
+    return;
+  }
+  p = cuba_h_npoints(dim);
+  for (k = 0; k < p; k++) memcpy(x + k*dim, c, sizeof(double)*dim);
+  px = x + dim;
+  for (i = 0; i < dim; i++, px += 2*dim) {
+    px[i] -= l2*h[i];
+    px[dim + i] += l2*h[i];
+  }
+  for (i = 0; i < dim; i++, px += 2*dim) {
+    px[i] -= l4*h[i];
+    px[dim + i] += l4*h[i];
+  }
+  for (i = 0; i < dim; i++) {
+    for (k = i + 1; k < dim; k++, px += 4*dim) {
+      for (q = 0; q < 4; q++) {
+	px[q*dim + i] += (q & 1 ? l4 : -l4)*h[i];
+	px[q*dim + k] += (q & 2 ? l4 : -l4)*h[k];
+      }
+    }
+  }
+  for (q = 0; q < ((size_t) 1 << dim); q++, px += dim) {
+    for (i = 0; i < dim; i++) px[i] += (q >> i & 1 ? l5 : -l5)*h[i];
+  }
+}
+
+/* As rescale_error() in GSL's integration/err.c */
+static double cuba_rescale_error(double err, double result_abs, double result_asc)
+{
+  double scale, min_err;
+  err = fabs(err);
+  if (result_asc != 0 && err != 0) {
+    scale = pow((200*err/result_asc), 1.5);
+    if (scale < 1) err = result_asc*scale;
+    else err = result_asc;
+  }
+  if (result_abs > GSL_DBL_MIN/(50*GSL_DBL_EPSILON)) {
+    min_err = 50*GSL_DBL_EPSILON*result_abs;
+    if (min_err > err) err = min_err;
+  }
+  return err;
+}
+
+static void cuba_h_rule1(mygsl_cuba *w, size_t j, const double *y)
+{
+  const size_t n = w->n;
+  const double h = w->h[j], absh = fabs(h);
+  double fc, f1, f2, rk, rg, resabs, resasc, mean;
+  size_t p, k;
+  for (k = 0; k < n; k++) {
+    fc = y[k];
+    rk = fc*cuba_wgk[7];
+    rg = fc*cuba_wg[3];
+    resabs = fabs(rk);
+    for (p = 0; p < 7; p++) {
+      f1 = y[(2*p+1)*n + k];
+      f2 = y[(2*p+2)*n + k];
+      rk += cuba_wgk[p]*(f1 + f2);
+      resabs += cuba_wgk[p]*(fabs(f1) + fabs(f2));
+      if (p & 1) rg += cuba_wg[p/2]*(f1 + f2);
+    }
+    mean = 0.5*rk;
+    resasc = cuba_wgk[7]*fabs(fc - mean);
+    for (p = 0; p < 7; p++)
+      resasc += cuba_wgk[p]*(fabs(y[(2*p+1)*n + k] - mean) + fabs(y[(2*p+2)*n + k] - mean));
+    w->r[j*n + k] = rk*h;
+    w->e[j*n + k] = cuba_rescale_error((rk - rg)*h, resabs*absh, resasc*absh);
+  }
+  w->split[j] = 0;
+}
+
+/* The results and errors of region j from the values y at its points,
+   and the axis along which it is to be divided: the one with the largest
+   fourth difference */
+static void cuba_h_rule(mygsl_cuba *w, size_t j, const double *y)
+{
+  const size_t dim = w->dim, n = w->n, p5 = (size_t) 1 << dim;
+  const double d = (double) dim;
+  const double w1 = (12824.0 - 9120.0*d + 400.0*d*d)/19683.0, w2 = 980.0/6561.0;
+  const double w3 = (1820.0 - 400.0*d)/19683.0, w4 = 200.0/19683.0;
+  const double w5 = 6859.0/19683.0/p5;
+  const double e1 = (729.0 - 950.0*d + 50.0*d*d)/729.0, e2 = 245.0/486.0;
+  const double e3 = (265.0 - 100.0*d)/1458.0, e4 = 25.0/729.0;
+  const double ratio = (9.0/70.0)/(9.0/10.0);
+  const double *h = w->h + j*dim, *f2, *f3, *f4, *f5;
+  double vol = 1.0, f0, s2, s3, s4, s5, diff, dmax = -1.0, *df = w->tmp;
+  size_t i, k, p, np4 = 2*dim*(dim - 1);
+  if (dim == 1) {
+    cuba_h_rule1(w, j, y);
+    return;
+  }
+  for (i = 0; i < dim; i++) {
+    vol *= 2.0*h[i];
+    df[i] = 0.0;
+  }
+  for (k = 0; k < n; k++) {
+    f0 = y[k];
+    f2 = y + n + k;
+    f3 = f2 + 2*dim*n;
+    f4 = f3 + 2*dim*n;
+    f5 = f4 + np4*n;
+    s2 = s3 = s4 = s5 = 0.0;
+    for (i = 0; i < dim; i++) {
+      s2 += f2[2*i*n] + f2[(2*i+1)*n];
+      s3 += f3[2*i*n] + f3[(2*i+1)*n];
+      df[i] += fabs(f2[2*i*n] + f2[(2*i+1)*n] - 2.0*f0
+		    - ratio*(f3[2*i*n] + f3[(2*i+1)*n] - 2.0*f0));
+    }
+    for (p = 0; p < np4; p++) s4 += f4[p*n];
+    for (p = 0; p < p5; p++) s5 += f5[p*n];
+    w->r[j*n + k] = vol*(w1*f0 + w2*s2 + w3*s3 + w4*s4 + w5*s5);
+    w->e[j*n + k] = fabs(w->r[j*n + k] - vol*(e1*f0 + e2*s2 + e3*s3 + e4*s4));
+  }
+  /* ties go to the widest axis */
+  w->split[j] = 0;
+  for (i = 0; i < dim; i++) {
+    diff = df[i];
+    if (diff > dmax*(1.0 + 1e-10)) {
+      dmax = diff;
+      w->split[j] = i;
+    } else if (diff >= dmax*(1.0 - 1e-10) && h[i] > h[w->split[j]]) {
+      w->split[j] = i;
+    }
+  }
+}
+
+static void cuba_h_reserve(mygsl_cuba *w, size_t nreg)
+{
+  size_t cap;
+  if (nreg <= w->rcap) return;
+  cap = GSL_MAX(nreg, 2*w->rcap);
+  REALLOC_N(w->c, double, 2*cap*w->dim);
+  memmove(w->c + cap*w->dim, w->c + w->rcap*w->dim, sizeof(double)*w->nreg*w->dim);
+  w->h = w->c + cap*w->dim;
+  REALLOC_N(w->r, double, 2*cap*w->n);
+  memmove(w->r + cap*w->n, w->r + w->rcap*w->n, sizeof(double)*w->nreg*w->n);
+  w->e = w->r + cap*w->n;
+  REALLOC_N(w->enorm, double, cap);
+  REALLOC_N(w->split, size_t, 3*cap);
+  memmove(w->split + 2*cap, w->split + 2*w->rcap, sizeof(size_t)*w->nbatch);
+  memmove(w->split + cap, w->split + w->rcap, sizeof(size_t)*w->nreg);
+  w->heap = w->split + cap;
+  w->batch = w->heap + cap;
+  w->rcap = cap;
+}
+
+static void cuba_heap_push(mygsl_cuba *w, size_t len, size_t iv)
+{
+  size_t i = len, p;
+  while (i > 0) {
+    p = (i - 1)/2;
+    if (w->enorm[w->heap[p]] >= w->enorm[iv]) break;
+    w->heap[i] = w->heap[p];
+    i = p;
+  }
+  w->heap[i] = iv;
+}
+
+static size_t cuba_heap_pop(mygsl_cuba *w, size_t len)
+{
+  size_t top = w->heap[0], last = w->heap[len-1], i = 0, c;
+  len--;
+  while ((c = 2*i + 1) < len) {
+    if (c + 1 < len && w->enorm[w->heap[c+1]] > w->enorm[w->heap[c]]) c++;
+    if (w->enorm[last] >= w->enorm[w->heap[c]]) break;
+    w->heap[i] = w->heap[c];
+    i = c;
+  }
+  if (len > 0) w->heap[i] = last;
+  return top;
+}
+
+/* Sums the results and errors of the regions */
+static void cuba_h_total(mygsl_cuba *w)
+{
+  size_t i, k, n = w->n;
+  for (k = 0; k < n; k++) w->res[k] = w->err[k] = 0.0;
+  for (i = 0; i < w->nreg; i++) {
+    for (k = 0; k < n; k++) {
+      w->res[k] += w->r[i*n + k];
+      w->err[k] += w->e[i*n + k];
+    }
+  }
+}
+
+/* Integrates the nbatch regions of batch, then adds them to the heap and
+   to the sums */
+static void cuba_h_eval(mygsl_cuba *w)
+{
+  const size_t np = cuba_h_npoints(w->dim);
+  size_t b, j, k;
+  cuba_reserve(w, w->nbatch*np);
+  for (b = 0; b < w->nbatch; b++) cuba_h_fill(w, w->batch[b], w->x + b*np*w->dim);
+  cuba_eval(w, w->x, w->y, w->nbatch*np);
+  for (b = 0; b < w->nbatch; b++) {
+    j = w->batch[b];
+    cuba_h_rule(w, j, w->y + b*np*w->n);
+    w->enorm[j] = cuba_norm(w, w->e + j*w->n);
+    for (k = 0; k < w->n; k++) {
+      w->res[k] += w->r[j*w->n + k];
+      w->err[k] += w->e[j*w->n + k];
+    }
+  }
+  for (b = 0; b < w->nbatch; b++) cuba_heap_push(w, w->nreg - w->nbatch + b, w->batch[b]);
+}
+
+static int cuba_h_run(mygsl_cuba *w)
+{
+  const size_t dim = w->dim, n = w->n, np = cuba_h_npoints(dim);
+  size_t i, j, k, s, npop, maxbatch;
+  double hs, *rem = w->tmp + dim;
+  int status = GSL_SUCCESS;
+  maxbatch = (w->native || w->kind == CUBA_BATCH
+	      || (w->kind == CUBA_FUNCTIONS && rb_gsl_monte_function_vectorized_p(w->fs[0])))
+    ? CUBA_MAXBATCH : 1;
+  cuba_h_reserve(w, 16);
+  w->nreg = w->nbatch = 1;
+  for (i = 0; i < dim; i++) {
+    w->c[i] = 0.5*(w->xl[i] + w->xu[i]);
+    w->h[i] = 0.5*(w->xu[i] - w->xl[i]);
+  }
+  w->batch[0] = 0;
+  for (k = 0; k < n; k++) w->res[k] = w->err[k] = 0.0;
+  cuba_h_eval(w);
+  while (cuba_norm(w, w->err) > cuba_tolerance(w)) {
+    /* the running sums drift; check against the exact ones */
+    cuba_h_total(w);
+    if (cuba_norm(w, w->err) <= cuba_tolerance(w)) break;
+    if (w->maxeval < w->neval + 2*np) {
+      status = GSL_EMAXITER;
+      break;
+    }
+    /* pop the worst regions, as many as needed to get below the tolerance */
+    memcpy(rem, w->err, sizeof(double)*n);
+    npop = 0;
+    while (npop < w->nreg && npop < maxbatch && w->neval + 2*(npop + 1)*np <= w->maxeval
+	   && (npop == 0 || cuba_norm(w, rem) > cuba_tolerance(w))) {
+      j = w->heap[0];
+      s = w->split[j];
+      hs = 0.5*w->h[j*dim + s];
+      if (!(w->c[j*dim + s] - hs < w->c[j*dim + s] && w->c[j*dim + s] + hs > w->c[j*dim + s]))
+	break;
+      cuba_heap_pop(w, w->nreg - npop);
+      w->batch[npop++] = j;
+      for (k = 0; k < n; k++) {
+	rem[k] -= w->e[j*n + k];
+	w->res[k] -= w->r[j*n + k];
+	w->err[k] -= w->e[j*n + k];
+      }
+    }
+    if (npop == 0) {
+      status = GSL_EROUND;
+      break;
+    }
+    w->nbatch = npop;
+    /* each region gives its half on the low side to itself, the other to a new one */
+    cuba_h_reserve(w, w->nreg + npop);
+    for (i = 0; i < npop; i++) {
+      j = w->batch[i];
+      s = w->split[j];
+      hs = 0.5*w->h[j*dim + s];
+      k = w->nreg + i;
+      memcpy(w->c + k*dim, w->c + j*dim, sizeof(double)*dim);
+      memcpy(w->h + k*dim, w->h + j*dim, sizeof(double)*dim);
+      w->h[j*dim + s] = w->h[k*dim + s] = hs;
+      w->c[j*dim + s] -= hs;
+      w->c[k*dim + s] += hs;
+      w->batch[npop + i] = k;
+    }
+    w->nreg += npop;
+    w->nbatch = 2*npop;
+    cuba_h_eval(w);
+  }
+  cuba_h_total(w);
+  return status;
+}
+
+/*
+  pcubature
+*/
+
+/* The weights of the 2^l + 1 point Clenshaw-Curtis rule on [-1, 1] with
+   the nodes cos(pi j/2^l) */
+static double* cuba_p_weights(mygsl_cuba *w, size_t l)
+{
+  size_t nn, j, k;
+  double s, b, *wt;
+  if (w->ccw[l]) return w->ccw[l];
+  wt = w->ccw[l] = ALLOC_N(double, ((size_t) 1 << l) + 1);
+  if (l == 0) {
+    wt[0] = 2.0;
+    return wt;
+  }
+  nn = (size_t) 1 << l;
+  for (j = 0; j <= nn; j++) {
+    s = 0.0;
+    for (k = 1; k <= nn/2; k++) {
+      b = (2*k == nn) ? 1.0 : 2.0;
+      s += b/(4.0*k*k - 1.0)*cos(2.0*M_PI*k*j/nn);
+    }
+    wt[j] = (j == 0 || j == nn ? 1.0 : 2.0)/nn*(1.0 - s);
+  }
+  return wt;
+}
+
+/* The weight of index j of the level l grid in the rule of level l0 <= l
+   (0 off the level l0 nodes) */
+static double cuba_p_weight(mygsl_cuba *w, size_t l0, size_t l, size_t j)
+{
+  size_t step;
+  if (l0 == 0) return j == ((size_t) 1 << (l - 1)) ? 2.0 : 0.0;
+  step = (size_t) 1 << (l - l0);
+  if (j % step) return 0.0;
+  return cuba_p_weights(w, l0)[j/step];
+}
+
+static size_t cuba_p_size(const mygsl_cuba *w)
+{
+  size_t d, np = 1;
+  for (d = 0; d < w->dim; d++) np *= ((size_t) 1 << w->level[d]) + 1;
+  return np;
+}
+
+/* The rule on the grid, q[0..n-1], and with one order less along each
+   axis d, q[(d+1)*n ...] */
+static void cuba_p_rules(mygsl_cuba *w, const double *y, size_t np)
+{
+  const size_t dim = w->dim, n = w->n;
+  size_t i, d, k, j, e, *ipt = w->ipt;
+  double vol = 1.0, wt, wd, *wl = w->tmp;
+  for (d = 0; d < dim; d++) {
+    vol *= 0.5*(w->xu[d] - w->xl[d]);
+    ipt[d] = 0;
+  }
+  for (k = 0; k < (dim + 1)*n; k++) w->q[k] = 0.0;
+  for (i = 0; i < np; i++) {
+    wt = 1.0;
+    for (d = 0; d < dim; d++) {
+      wl[d] = cuba_p_weight(w, w->level[d], w->level[d], ipt[d]);
+      wt *= wl[d];
+    }
+    for (k = 0; k < n; k++) w->q[k] += wt*y[i*n + k];
+    for (d = 0; d < dim; d++) {
+      wd = cuba_p_weight(w, w->level[d] - 1, w->level[d], ipt[d]);
+      if (wd == 0.0) continue;
+      for (e = 0, wt = wd; e < dim; e++) if (e != d) wt *= wl[e];
+      for (k = 0; k < n; k++) w->q[(d+1)*n + k] += wt*y[i*n + k];
+    }
+    /* the next multi-index, the last axis fastest */
+    for (j = dim; j-- > 0; ) {
+      if (++ipt[j] <= ((size_t) 1 << w->level[j])) break;
+      ipt[j] = 0;
+    }
+  }
+  for (k = 0; k < (dim + 1)*n; k++) w->q[k] *= vol;
+}
+
+/* The node of index j along axis d */
+static double cuba_p_node(const mygsl_cuba *w, size_t d, size_t j)
+{
+  const double t = cos(M_PI*j/((double) ((size_t) 1 << w->level[d])));
+  return w->xl[d] + 0.5*(w->xu[d] - w->xl[d])*(1.0 + t);
+}
+
+/* The next multi-index of the grid, the last axis fastest */
+static void cuba_p_next(const mygsl_cuba *w, size_t *ipt)
+{
+  size_t d;
+  for (d = w->dim; d-- > 0; ) {
+    if (++ipt[d] <= ((size_t) 1 << w->level[d])) break;
+    ipt[d] = 0;
+  }
+}
+
+/* Evaluates the grid points with odd indices along axis s (all of them
+   when s == dim) in x, y, and merges them with the values of the grid of
+   one order less along s in g */
+static void cuba_p_eval(mygsl_cuba *w, size_t s, size_t np)
+{
+  const size_t dim = w->dim, n = w->n;
+  size_t i, d, j, nnew = 0, old, *ipt = w->ipt;
+  double *g;
+  cuba_reserve(w, np);
+  for (d = 0; d < dim; d++) ipt[d] = 0;
+  for (i = 0; i < np; i++, cuba_p_next(w, ipt)) {
+    if (s < dim && ipt[s] % 2 == 0) continue;
+    for (d = 0; d < dim; d++) w->x[nnew*dim + d] = cuba_p_node(w, d, ipt[d]);
+    nnew++;
+  }
+  cuba_eval(w, w->x, w->y, nnew);
+  g = ALLOC_N(double, np*n);
+  for (d = 0; d < dim; d++) ipt[d] = 0;
+  for (i = 0, j = 0; i < np; i++, cuba_p_next(w, ipt)) {
+    if (s == dim || ipt[s] % 2) {
+      memcpy(g + i*n, w->y + (j++)*n, sizeof(double)*n);
+      continue;
+    }
+    for (d = 0, old = 0; d < dim; d++) {
+      if (d == s) old = old*(((size_t) 1 << (w->level[d] - 1)) + 1) + ipt[d]/2;
+      else old = old*(((size_t) 1 << w->level[d]) + 1) + ipt[d];
+    }
+    memcpy(g + i*n, w->g + old*n, sizeof(double)*n);
+  }
+  xfree(w->g);
+  w->g = g;
+}
+
+static int cuba_p_run(mygsl_cuba *w)
+{
+  const size_t dim = w->dim, n = w->n;
+  size_t d, k, s, np, np1;
+  double en, emax, *ed = w->tmp + dim;
+  int status = GSL_SUCCESS;
+  w->ccw = ALLOC_N(double*, CUBA_MAXLEVEL + 1);
+  for (k = 0; k <= CUBA_MAXLEVEL; k++) w->ccw[k] = NULL;
+  w->level = ALLOC_N(size_t, 2*dim);
+  w->ipt = w->level + dim;
+  w->q = ALLOC_N(double, (dim + 1)*n);
+  for (d = 0; d < dim; d++) w->level[d] = 1;
+  np = cuba_p_size(w);
+  if (w->maxeval < np) rb_raise(rb_eArgError, "maxeval must be at least %d", (int) np);
+  cuba_p_eval(w, dim, np);
+  for (;;) {
+    cuba_p_rules(w, w->g, np);
+    /* the error of each component: the largest change along an axis */
+    memcpy(w->res, w->q, sizeof(double)*n);
+    for (k = 0; k < n; k++) w->err[k] = 0.0;
+    emax = -1.0;
+    s = dim;
+    for (d = 0; d < dim; d++) {
+      for (k = 0; k < n; k++) {
+	ed[k] = fabs(w->q[k] - w->q[(d+1)*n + k]);
+	if (ed[k] > w->err[k]) w->err[k] = ed[k];
+      }
+      en = cuba_norm(w, ed);
+      if (w->level[d] < CUBA_MAXLEVEL && en > emax) {
+	emax = en;
+	s = d;
+      }
+    }
+    if (cuba_norm(w, w->err) <= cuba_tolerance(w)) break;
+    if (s == dim) {
+      status = GSL_EROUND;
+      break;
+    }
+    np1 = np/(((size_t) 1 << w->level[s]) + 1)*(((size_t) 1 << (w->level[s] + 1)) + 1);
+    if (w->maxeval < w->neval + (np1 - np)) {
+      status = GSL_EMAXITER;
+      break;
+    }
+    w->level[s]++;
+    np = np1;
+    cuba_p_eval(w, s, np);
+  }
+  return status;
+}
+
+static int cuba_norm_id(VALUE v)
+{
+  const char *name;
+  if (NIL_P(v)) return CUBA_NORM_MAX;
+  if (SYMBOL_P(v)) v = rb_sym2str(v);
+  name = StringValuePtr(v);
+  if (strcmp(name, "max") == 0 || strcmp(name, "linf") == 0) return CUBA_NORM_MAX;
+  if (strcmp(name, "l1") == 0) return CUBA_NORM_L1;
+  if (strcmp(name, "l2") == 0) return CUBA_NORM_L2;
+  rb_raise(rb_eArgError, "unknown norm %s (max, l1 or l2)", name);
+  return CUBA_NORM_MAX;
+}
+
+static size_t cuba_bounds_size(VALUE v)
+{
+  if (TYPE(v) == T_ARRAY) return RARRAY_LEN(v);
+  CHECK_VECTOR(v);
+  return ((gsl_vector *) DATA_PTR(v))->size;
+}
+
+static void cuba_bounds(VALUE v, double *x, size_t n)
+{
+  gsl_vector *vv = NULL;
+  size_t i;
+  if (TYPE(v) == T_ARRAY) {
+    for (i = 0; i < n; i++) x[i] = NUM2DBL(rb_ary_entry(v, i));
+    return;
+  }
+  Data_Get_Vector(v, vv);
+  for (i = 0; i < n; i++) x[i] = gsl_vector_get(vv, i);
+}
+
+static VALUE cuba_value(const mygsl_cuba *w, const double *v)
+{
+  gsl_vector *r = NULL;
+  if (w->scalar) return rb_float_new(v[0]);
+  r = gsl_vector_alloc(w->n);
+  memcpy(r->data, v, sizeof(double)*w->n);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, r);
+}
+
+/* hcubature(f, xl, xu[, opts]) and pcubature(...) */
+static VALUE rb_gsl_monte_cubature(int argc, VALUE *argv, int p)
+{
+  mygsl_cuba *w = NULL;
+  gsl_monte_function *F = NULL;
+  size_t dim, i, k, n;
+  double *x0;
+  int status;
+  VALUE obj, opts = Qnil, f, v;
+  if (argc == 4) {
+    opts = argv[3];
+    Check_Type(opts, T_HASH);
+  } else if (argc != 3) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  }
+  f = argv[0];
+  obj = Data_Make_Struct(0, mygsl_cuba, mygsl_cuba_mark, mygsl_cuba_free, w);
+  w->f = f;
+  w->epsabs = 0.0;
+  w->epsrel = 1e-8;
+  w->maxeval = 1000000;
+  w->norm = CUBA_NORM_MAX;
+  w->kind = CUBA_CALL;
+  dim = cuba_bounds_size(argv[1]);
+  if (cuba_bounds_size(argv[2]) != dim)
+    rb_raise(rb_eArgError, "xl and xu must have the same size");
+  if (dim == 0) rb_raise(rb_eArgError, "dimension must be positive");
+  w->xl = ALLOC_N(double, 2*dim);
+  w->xu = w->xl + dim;
+  cuba_bounds(argv[1], w->xl, dim);
+  cuba_bounds(argv[2], w->xu, dim);
+  if (!p && dim > CUBA_MAXDIM)
+    rb_raise(rb_eArgError, "too many dimensions (%d, at most %d)", (int) dim, CUBA_MAXDIM);
+  for (i = 0; i < dim; i++) {
+    if (!(w->xu[i] > w->xl[i])) rb_raise(rb_eArgError, "xu must be greater than xl");
+  }
+  w->dim = dim;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsabs"))))) w->epsabs = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsrel"))))) w->epsrel = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("maxeval"))))) w->maxeval = NUM2SIZET(v);
+    w->norm = cuba_norm_id(rb_hash_aref(opts, ID2SYM(rb_intern("norm"))));
+    if (RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("batch"))))) w->kind = CUBA_BATCH;
+  }
+  if (rb_obj_is_kind_of(f, cgsl_cuba_function) || TYPE(f) == T_ARRAY) {
+    if (TYPE(f) != T_ARRAY) {
+      f = rb_ary_new3(1, f);
+      w->scalar = 1;
+    }
+    w->f = f;
+    w->kind = CUBA_FUNCTIONS;
+    w->native = 1;
+    n = RARRAY_LEN(f);
+    if (n == 0) rb_raise(rb_eArgError, "no integrands");
+    w->fs = ALLOC_N(gsl_monte_function*, n);
+    for (k = 0; k < n; k++) {
+      v = rb_ary_entry(f, k);
+      if (!rb_obj_is_kind_of(v, cgsl_cuba_function))
+	rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Monte::Function expected)",
+		 rb_class2name(CLASS_OF(v)));
+      Data_Get_Struct(v, gsl_monte_function, F);
+      if (F->dim != dim)
+	rb_raise(rb_eArgError, "function of %d variables for a region of dimension %d",
+		 (int) F->dim, (int) dim);
+      w->fs[k] = F;
+      if (!rb_obj_is_kind_of(v, cgsl_cuba_function_compiled)) w->native = 0;
+    }
+  } else {
+    if (!rb_respond_to(f, RBGSL_ID_call))
+      rb_raise(rb_eTypeError, "wrong argument type %s (Monte::Function or callable expected)",
+	       rb_class2name(CLASS_OF(f)));
+    x0 = ALLOCA_N(double, dim);
+    for (i = 0; i < dim; i++) x0[i] = 0.5*(w->xl[i] + w->xu[i]);
+    n = cuba_probe(w, x0);
+    if (n == 0) rb_raise(rb_eArgError, "no integrands");
+  }
+  w->n = n;
+  w->res = ALLOC_N(double, 4*n + 2*dim);
+  w->err = w->res + n;
+  w->tmp = w->err + n;
+
+  if (p) status = cuba_p_run(w);
+  else status = cuba_h_run(w);
+
+  v = rb_ary_new3(4, cuba_value(w, w->res), cuba_value(w, w->err),
+		  SIZET2NUM(w->neval), INT2FIX(status));
+  RB_GC_GUARD(obj);
+  return v;
+}
+
+static VALUE rb_gsl_monte_hcubature(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_monte_cubature(argc, argv, 0);
+}
+
+static VALUE rb_gsl_monte_pcubature(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_monte_cubature(argc, argv, 1);
+}
+
+void Init_gsl_monte_cubature(VALUE mgsl_monte, VALUE cfunction, VALUE ccompiled)
+{
+  cgsl_cuba_function = cfunction;
+  cgsl_cuba_function_compiled = ccompiled;
+  rb_define_module_function(mgsl_monte, "hcubature", rb_gsl_monte_hcubature, -1);
+  rb_define_module_function(mgsl_monte, "pcubature", rb_gsl_monte_pcubature, -1);
+}
@@ -0,0 +1,243 @@
+/*
+  monte_qmc.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Randomized quasi-Monte Carlo integration over a box xl <= x <= xu.
+
+    f = GSL::Monte::Function.compile("exp(-x[0]*x[1]*x[2]*x[3])", 4)
+    res, err, neval = GSL::Monte.qmc(f, [0, 0, 0, 0], [1, 1, 1, 1], 100000)
+    GSL::Monte.qmc(f, xl, xu, 100000, :qrng => "niederreiter_2", :shifts => 16)
+
+  The first calls/:shifts points of a low discrepancy sequence are taken
+  :shifts (10) times, each time translated modulo 1 by a uniform random
+  vector (Cranley and Patterson, SIAM J. Numer. Anal. 13, 1976).  Every
+  shifted set gives an unbiased estimate of the integral; the result is
+  their mean and abserr the standard error of the mean.  For smooth
+  integrands the error falls nearly as 1/calls instead of 1/sqrt(calls).
+
+  :qrng is a type as for GSL::QRng.alloc ("sobol" by default), or a
+  GSL::QRng of dimension dim whose clone gives the points, so that the
+  generator itself is not advanced.  The shifts are drawn from :rng, a
+  GSL::Rng, or else from a mt19937 seeded with :seed (0).
+
+  The integrand is a GSL::Monte::Function.  The points are drawn in
+  blocks of up to QMC_BLOCK, and all the shifted copies of a block are
+  evaluated together: in one call for vectorized functions, and without
+  the GVL, split over GSL.parallel_threads, for Compiled ones.  Returns
+  [result, abserr, neval], with neval = :shifts*(calls/:shifts).
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_rng.h"
+#include "rb_gsl_function.h"
+#include "rb_gsl_common.h"
+#include <gsl/gsl_qrng.h>
+
+static VALUE cgsl_qmc_function;
+static VALUE cgsl_qmc_function_compiled;
+static VALUE cgsl_qmc_qrng;
+
+#define QMC_BLOCK 1024
+#define QMC_EVALS 16384
+#define QMC_EVAL_BLOCK 256
+
+struct qmc_eval_task {
+  gsl_monte_function *F;
+  double *x, *y;
+  size_t dim, np, nthreads;
+};
+
+static void qmc_eval_block(struct qmc_eval_task *t, size_t i0, size_t i1)
+{
+  gsl_monte_function *F = t->F;
+  size_t i;
+  for (i = i0; i < i1; i++) t->y[i] = (*F->f)(t->x + i*t->dim, t->dim, F->params);
+}
+
+static int qmc_eval_worker(void *data, size_t id)
+{
+  struct qmc_eval_task *t = (struct qmc_eval_task *) data;
+  size_t b;
+  for (b = id*QMC_EVAL_BLOCK; b < t->np; b += t->nthreads*QMC_EVAL_BLOCK)
+    qmc_eval_block(t, b, GSL_MIN(b + QMC_EVAL_BLOCK, t->np));
+  return GSL_SUCCESS;
+}
+
+static int qmc_eval_serial(void *data)
+{
+  struct qmc_eval_task *t = (struct qmc_eval_task *) data;
+  qmc_eval_block(t, 0, t->np);
+  return GSL_SUCCESS;
+}
+
+/* y = f(x) at the np points x, natively when the function is compiled */
+static void qmc_eval(gsl_monte_function *F, int native, double *x, double *y, size_t np)
+{
+  struct qmc_eval_task t;
+  if (!native) {
+    rb_gsl_monte_function_eval_array(F, x, y, np);
+    return;
+  }
+  t.F = F;
+  t.x = x;
+  t.y = y;
+  t.dim = F->dim;
+  t.np = np;
+  t.nthreads = rb_gsl_parallel_nthreads(np, (np + QMC_EVAL_BLOCK - 1)/QMC_EVAL_BLOCK);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(qmc_eval_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(qmc_eval_serial, &t, np);
+}
+
+static size_t qmc_bounds_size(VALUE v)
+{
+  if (TYPE(v) == T_ARRAY) return RARRAY_LEN(v);
+  CHECK_VECTOR(v);
+  return ((gsl_vector *) DATA_PTR(v))->size;
+}
+
+static void qmc_bounds(VALUE v, double *x, size_t n)
+{
+  gsl_vector *vv = NULL;
+  size_t i;
+  if (TYPE(v) == T_ARRAY) {
+    for (i = 0; i < n; i++) x[i] = NUM2DBL(rb_ary_entry(v, i));
+    return;
+  }
+  Data_Get_Vector(v, vv);
+  for (i = 0; i < n; i++) x[i] = gsl_vector_get(vv, i);
+}
+
+/* A generator of its own for the points: a clone of a QRng, or new */
+static VALUE qmc_qrng(VALUE t, size_t dim)
+{
+  gsl_qrng *q = NULL;
+  if (NIL_P(t)) t = rb_str_new2("sobol");
+  if (rb_obj_is_kind_of(t, cgsl_qmc_qrng)) {
+    Data_Get_Struct(t, gsl_qrng, q);
+    if (q->dimension != dim)
+      rb_raise(rb_eArgError, "generator of dimension %d for a region of dimension %d",
+	       (int) q->dimension, (int) dim);
+    return rb_funcall(t, rb_intern("clone"), 0);
+  }
+  return rb_funcall(cgsl_qmc_qrng, rb_intern("alloc"), 2, t, SIZET2NUM(dim));
+}
+
+/* GSL::Monte.qmc(f, xl, xu, calls, opts = {}): see the top of the file */
+static VALUE rb_gsl_monte_qmc(int argc, VALUE *argv, VALUE module)
+{
+  gsl_monte_function *F = NULL;
+  gsl_qrng *q = NULL;
+  gsl_rng *r = NULL, *rown = NULL;
+  size_t dim, npt, nshift = 10, blk, i, j, k, b, nb;
+  unsigned long seed = 0;
+  double *xl, *w, *u, *p, *x, *y, *sum, vol = 1.0, mean, var, z;
+  int native;
+  VALUE opts = Qnil, vq, vr = Qnil, vt = Qnil, v, vbuf;
+  if (argc == 5) {
+    opts = argv[4];
+    Check_Type(opts, T_HASH);
+  } else if (argc != 4) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 4 or 5)", argc);
+  }
+  if (!rb_obj_is_kind_of(argv[0], cgsl_qmc_function))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Monte::Function expected)",
+	     rb_class2name(CLASS_OF(argv[0])));
+  Data_Get_Struct(argv[0], gsl_monte_function, F);
+  native = rb_obj_is_kind_of(argv[0], cgsl_qmc_function_compiled) ? 1 : 0;
+  dim = qmc_bounds_size(argv[1]);
+  if (qmc_bounds_size(argv[2]) != dim)
+    rb_raise(rb_eArgError, "xl and xu must have the same size");
+  if (dim == 0) rb_raise(rb_eArgError, "dimension must be positive");
+  if (F->dim != dim)
+    rb_raise(rb_eArgError, "function of %d variables for a region of dimension %d",
+	     (int) F->dim, (int) dim);
+  if (!NIL_P(opts)) {
+    vt = rb_hash_aref(opts, ID2SYM(rb_intern("qrng")));
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("shifts"))))) nshift = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("seed"))))) seed = NUM2ULONG(v);
+    if (!NIL_P(vr = rb_hash_aref(opts, ID2SYM(rb_intern("rng"))))) {
+      CHECK_RNG(vr);
+      Data_Get_Struct(vr, gsl_rng, r);
+    }
+  }
+  if (nshift < 2) rb_raise(rb_eArgError, "at least 2 shifts are needed for the error");
+  npt = NUM2SIZET(argv[3])/nshift;
+  if (npt == 0) rb_raise(rb_eArgError, "calls must be at least the number of shifts");
+  vq = qmc_qrng(vt, dim);
+  Data_Get_Struct(vq, gsl_qrng, q);
+
+  /* xl, widths and shifts (dim each, nshift for u); the points of a
+     block (blk x dim), their shifted copies (nshift*blk x dim), the
+     values and the sums by shift.  Up to QMC_EVALS values a block. */
+  blk = GSL_MIN(QMC_BLOCK, GSL_MAX(1, QMC_EVALS/nshift));
+  xl = ALLOCV_N(double, vbuf, 2*dim + nshift*dim + blk*dim
+		+ nshift*blk*(dim + 1) + nshift);
+  w = xl + dim;
+  u = w + dim;
+  p = u + nshift*dim;
+  x = p + blk*dim;
+  y = x + nshift*blk*dim;
+  sum = y + nshift*blk;
+  qmc_bounds(argv[1], xl, dim);
+  qmc_bounds(argv[2], w, dim);
+  for (j = 0; j < dim; j++) {
+    w[j] -= xl[j];
+    vol *= w[j];
+  }
+  if (r == NULL) {
+    rown = r = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(r, seed);
+  }
+  for (k = 0; k < nshift*dim; k++) u[k] = gsl_rng_uniform(r);
+  if (rown) gsl_rng_free(rown);
+  for (k = 0; k < nshift; k++) sum[k] = 0.0;
+
+  for (b = 0; b < npt; b += nb) {
+    nb = GSL_MIN(blk, npt - b);
+    for (i = 0; i < nb; i++) gsl_qrng_get(q, p + i*dim);
+    for (k = 0; k < nshift; k++) {
+      for (i = 0; i < nb; i++) {
+	for (j = 0; j < dim; j++) {
+	  z = p[i*dim + j] + u[k*dim + j];
+	  if (z >= 1.0) z -= 1.0;
+	  x[(k*nb + i)*dim + j] = xl[j] + w[j]*z;
+	}
+      }
+    }
+    qmc_eval(F, native, x, y, nshift*nb);
+    for (k = 0; k < nshift; k++)
+      for (i = 0; i < nb; i++) sum[k] += y[k*nb + i];
+  }
+
+  mean = 0.0;
+  for (k = 0; k < nshift; k++) {
+    sum[k] *= vol/npt;
+    mean += sum[k];
+  }
+  mean /= nshift;
+  var = 0.0;
+  for (k = 0; k < nshift; k++) var += (sum[k] - mean)*(sum[k] - mean);
+  var /= (double) nshift*(nshift - 1);
+  v = rb_ary_new3(3, rb_float_new(mean), rb_float_new(sqrt(var)),
+		  SIZET2NUM(npt*nshift));
+  ALLOCV_END(vbuf);
+  RB_GC_GUARD(vq);
+  RB_GC_GUARD(vr);
+  return v;
+}
+
+void Init_gsl_monte_qmc(VALUE mgsl_monte, VALUE cfunction, VALUE ccompiled)
+{
+  cgsl_qmc_function = cfunction;
+  cgsl_qmc_function_compiled = ccompiled;
+  cgsl_qmc_qrng = rb_path2class("GSL::QRng");
+  rb_define_module_function(mgsl_monte, "qmc", rb_gsl_monte_qmc, -1);
+}
@@ -32,6 +32,11 @@ void Init_ndlinear(VALUE module);
       rb_class2name(CLASS_OF(x)));
 #endif
 
+void Init_gsl_multifit_accumulate(VALUE mgsl_multifit);
+#ifdef HAVE_GSL_GSL_MULTIFIT_NLINEAR_H
+void Init_gsl_multifit_nlinear(VALUE module, VALUE mgsl_multifit);
+#endif
+
 static VALUE cgsl_multifit_workspace;
 static VALUE cgsl_multifit_function_fdf;
 
@@ -620,15 +625,318 @@ static VALUE rb_gsl_multifit_function_fdf_set_data(int argc, VALUE *argv, VALUE
   return obj;
 }
 
+/*
+  func->params is an Array [f, df, fdf, [t, y(, sigma)], x view, f view,
+  J view]; the views passed to the procs are kept there and repointed at
+  GSL's vectors and matrices on each call (see rb_gsl_callback_vector).
+*/
+enum {
+  MULTIFIT_FDF_F = 0,
+  MULTIFIT_FDF_DF,
+  MULTIFIT_FDF_FDF,
+  MULTIFIT_FDF_DATA,
+  MULTIFIT_FDF_VX,
+  MULTIFIT_FDF_VF,
+  MULTIFIT_FDF_VJ,
+};
+
+/*
+  f as a GSL::Function::Compiled model y(t; x[0] ... x[p-1]) (see
+  Function_fdf.compile): the residuals (y(t[i]) - y[i])/sigma[i], and
+  their Jacobian by dual numbers, in C.  The model and its data are
+  taken from ary first, so that the rows can then be evaluated without
+  the GVL: in blocks of MULTIFIT_ROW_BLOCK over GSL.parallel_threads for
+  long data.
+*/
+#define MULTIFIT_PARAM_MAX 32
+#define MULTIFIT_ROW_BLOCK 256
+
+typedef struct {
+  void *c;
+  const gsl_vector *t, *y, *sigma;
+  size_t n, p, nparam;
+  double param[MULTIFIT_PARAM_MAX];
+} mygsl_multifit_model;
+
+static void multifit_model_get(VALUE ary, size_t n, size_t p, mygsl_multifit_model *md)
+{
+  VALUE vt_y_sigma;
+  gsl_vector *t = NULL, *y = NULL, *sigma = NULL;
+  md->c = rb_gsl_function_compiled_ptr(rb_ary_entry(ary, MULTIFIT_FDF_F));
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  Check_Type(vt_y_sigma, T_ARRAY);
+  Data_Get_Vector(rb_ary_entry(vt_y_sigma, 0), t);
+  Data_Get_Vector(rb_ary_entry(vt_y_sigma, 1), y);
+  if (RARRAY_LEN(vt_y_sigma) > 2) Data_Get_Vector(rb_ary_entry(vt_y_sigma, 2), sigma);
+  if (t->size < n || y->size < n || (sigma && sigma->size < n))
+    rb_raise(rb_eArgError, "%d data points expected", (int) n);
+  if (rb_gsl_function_compiled_dim(md->c) != p)
+    rb_raise(rb_eArgError, "model of %d parameters, %d given",
+	     (int) rb_gsl_function_compiled_dim(md->c), (int) p);
+  md->t = t;
+  md->y = y;
+  md->sigma = sigma;
+  md->n = n;
+  md->p = p;
+  md->nparam = rb_gsl_function_compiled_nparam(md->c);
+  rb_gsl_function_compiled_get_params(md->c, md->param);
+}
+
+/* Rows i0 ... i1 - 1 of f and J (either may be NULL) at xp */
+static void multifit_model_rows(const mygsl_multifit_model *md, const double *xp,
+				gsl_vector *f, gsl_matrix *J, size_t i0, size_t i1)
+{
+  double param[MULTIFIT_PARAM_MAX], *grad, v, s;
+  size_t i, j;
+  memcpy(param, md->param, sizeof(double)*md->nparam);
+  for (i = i0; i < i1; i++) {
+    param[0] = gsl_vector_get(md->t, i);
+    s = md->sigma ? gsl_vector_get(md->sigma, i) : 1.0;
+    if (J) {
+      grad = J->data + i*J->tda;
+      v = rb_gsl_function_compiled_eval_grad(md->c, xp, param, grad);
+      for (j = 0; j < md->p; j++) grad[j] /= s;
+    } else {
+      v = rb_gsl_function_compiled_eval_params(md->c, xp, param);
+    }
+    if (f) gsl_vector_set(f, i, (v - gsl_vector_get(md->y, i))/s);
+  }
+}
+
+struct multifit_model_task {
+  const mygsl_multifit_model *md;
+  const double *xp;
+  gsl_vector *f;
+  gsl_matrix *J;
+  size_t nthreads;
+};
+
+static int multifit_model_worker(void *data, size_t id)
+{
+  struct multifit_model_task *t = (struct multifit_model_task *) data;
+  size_t b, n = t->md->n;
+  for (b = id*MULTIFIT_ROW_BLOCK; b < n; b += t->nthreads*MULTIFIT_ROW_BLOCK)
+    multifit_model_rows(t->md, t->xp, t->f, t->J, b, GSL_MIN(b + MULTIFIT_ROW_BLOCK, n));
+  return GSL_SUCCESS;
+}
+
+static int multifit_model_serial(void *data)
+{
+  struct multifit_model_task *t = (struct multifit_model_task *) data;
+  multifit_model_rows(t->md, t->xp, t->f, t->J, 0, t->md->n);
+  return GSL_SUCCESS;
+}
+
+static int multifit_compiled_fdf(VALUE ary, const gsl_vector *x, gsl_vector *f,
+				 gsl_matrix *J)
+{
+  mygsl_multifit_model md;
+  struct multifit_model_task t;
+  VALUE vtmp;
+  double *xp;
+  size_t j, n = f ? f->size : J->size1, p = x->size;
+  multifit_model_get(ary, n, p, &md);
+  xp = ALLOCV_N(double, vtmp, p);
+  for (j = 0; j < p; j++) xp[j] = gsl_vector_get(x, j);
+  t.md = &md;
+  t.xp = xp;
+  t.f = f;
+  t.J = J;
+  t.nthreads = rb_gsl_parallel_nthreads(n*(J ? p : 1),
+					(n + MULTIFIT_ROW_BLOCK - 1)/MULTIFIT_ROW_BLOCK);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(multifit_model_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(multifit_model_serial, &t, n*(J ? p : 1));
+  ALLOCV_END(vtmp);
+  return GSL_SUCCESS;
+}
+
+/* The residuals of a compiled model at a point of a finite difference
+   Jacobian (a row of its matrix of points, so contiguous): no Ruby */
+static int multifit_model_f(const gsl_vector *x, void *data, gsl_vector *f)
+{
+  const mygsl_multifit_model *md = (const mygsl_multifit_model *) data;
+  multifit_model_rows(md, x->data, f, NULL, 0, md->n);
+  return GSL_SUCCESS;
+}
+
+static int gsl_multifit_function_fdf_f(const gsl_vector *x, void *params,
+				       gsl_vector *f);
+static int gsl_multifit_function_fdf_df(const gsl_vector *x, void *params,
+					gsl_matrix *J);
+static int gsl_multifit_function_fdf_fdf(const gsl_vector *x, void *params,
+					 gsl_vector *f, gsl_matrix *J);
+
+static VALUE rb_gsl_multifit_function_fdf_set_procs(int argc, VALUE *argv, VALUE obj);
+
+static VALUE rb_gsl_multifit_function_fdf_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_multifit_function_fdf *func = NULL;
+  VALUE obj;
+  func = ALLOC(gsl_multifit_function_fdf);
+  func->f = &gsl_multifit_function_fdf_f;
+  func->df = &gsl_multifit_function_fdf_df;
+  func->fdf = &gsl_multifit_function_fdf_fdf;
+  func->params = NULL;
+  obj = Data_Wrap_Struct(klass, gsl_multifit_function_fdf_mark, gsl_multifit_function_fdf_free, func);
+  switch (argc) {
+  case 0:
+  case 1:
+    break;
+  case 2:
+  case 3:
+    rb_gsl_multifit_function_fdf_set_procs(argc, argv, obj);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0-3)", argc);
+    break;
+  }
+  return obj;
+}			    
+
+static VALUE rb_gsl_multifit_function_fdf_set_procs(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_multifit_function_fdf *func = NULL;
+  VALUE ary;
+  Data_Get_Struct(obj, gsl_multifit_function_fdf, func);
+  if (func->params == NULL) {
+    ary = rb_ary_new2(4);
+    /*    (VALUE) func->params = ary;*/
+    func->params = (void *) ary;
+  } else {
+    ary = (VALUE) func->params;
+  }
+  rb_ary_store(ary, 0, argv[0]);
+  rb_ary_store(ary, 1, argv[1]);
+  switch (argc) {
+	case 2:
+		break;
+  case 3:
+    if (TYPE(argv[2]) == T_FIXNUM) {
+      func->p = FIX2INT(argv[2]);
+      rb_ary_store(ary, 2, Qnil);
+    } else rb_ary_store(ary, 2, argv[2]);
+    break;
+  case 4:
+    if (TYPE(argv[2]) == T_FIXNUM) {
+      func->p = FIX2INT(argv[2]);
+      rb_ary_store(ary, 2, argv[3]);
+    } else {
+      func->p = FIX2INT(argv[3]);
+      rb_ary_store(ary, 2, argv[2]);
+    }
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+    break;
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_multifit_function_fdf_set_data(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE ary, ary2;
+  gsl_multifit_function_fdf *func = NULL;
+  Data_Get_Struct(obj, gsl_multifit_function_fdf, func);
+  if (func->params == NULL) {
+    ary = rb_ary_new2(4);
+    /*    (VALUE) func->params = ary;*/
+    func->params = (void *) ary;
+  } else {
+    ary = (VALUE) func->params;
+  }
+  switch (argc) {
+  case 2:
+    ary2 = rb_ary_new3(2, argv[0], argv[1]);  /* t, y */
+    break;
+  case 3:
+    ary2 = rb_ary_new3(3, argv[0], argv[1], argv[2]);  /* t, y, sigma */
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+    break;
+  }
+  func->n = NUM2INT(rb_funcall(argv[0], rb_intern("size"), 0));
+  rb_ary_store(ary, 3, ary2);
+  return obj;
+}
+
+/*
+  func->params is an Array [f, df, fdf, [t, y(, sigma)], x view, f view,
+  J view]; the views passed to the procs are kept there and repointed at
+  GSL's vectors and matrices on each call (see rb_gsl_callback_vector).
+*/
+enum {
+  MULTIFIT_FDF_F = 0,
+  MULTIFIT_FDF_DF,
+  MULTIFIT_FDF_FDF,
+  MULTIFIT_FDF_DATA,
+  MULTIFIT_FDF_VX,
+  MULTIFIT_FDF_VF,
+  MULTIFIT_FDF_VJ,
+};
+
+/*
+  f as a GSL::Function::Compiled model y(t; x[0] ... x[p-1]) (see
+  Function_fdf.compile): the residuals (y(t[i]) - y[i])/sigma[i], and
+  their Jacobian by dual numbers, in C
+*/
+static int multifit_compiled_fdf(VALUE ary, const gsl_vector *x, gsl_vector *f,
+				 gsl_matrix *J)
+{
+  VALUE vt_y_sigma, vt, vy, vsigma, vtmp;
+  gsl_vector *t = NULL, *y = NULL, *sigma = NULL;
+  double *xp, *param, *grad, v, s;
+  void *c;
+  size_t i, j, n, p = x->size;
+  c = rb_gsl_function_compiled_ptr(rb_ary_entry(ary, MULTIFIT_FDF_F));
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  Check_Type(vt_y_sigma, T_ARRAY);
+  vt = rb_ary_entry(vt_y_sigma, 0);
+  vy = rb_ary_entry(vt_y_sigma, 1);
+  Data_Get_Vector(vt, t);
+  Data_Get_Vector(vy, y);
+  if (RARRAY_LEN(vt_y_sigma) > 2) {
+    vsigma = rb_ary_entry(vt_y_sigma, 2);
+    Data_Get_Vector(vsigma, sigma);
+  }
+  n = f ? f->size : J->size1;
+  if (t->size < n || y->size < n || (sigma && sigma->size < n))
+    rb_raise(rb_eArgError, "%d data points expected", (int) n);
+  if (rb_gsl_function_compiled_dim(c) != p)
+    rb_raise(rb_eArgError, "model of %d parameters, %d given",
+	     (int) rb_gsl_function_compiled_dim(c), (int) p);
+  xp = ALLOCV_N(double, vtmp, p + rb_gsl_function_compiled_nparam(c));
+  param = xp + p;
+  for (j = 0; j < p; j++) xp[j] = gsl_vector_get(x, j);
+  rb_gsl_function_compiled_get_params(c, param);
+  for (i = 0; i < n; i++) {
+    param[0] = gsl_vector_get(t, i);
+    s = sigma ? gsl_vector_get(sigma, i) : 1.0;
+    if (J) {
+      grad = J->data + i*J->tda;
+      v = rb_gsl_function_compiled_eval_grad(c, xp, param, grad);
+      for (j = 0; j < p; j++) grad[j] /= s;
+    } else {
+      v = rb_gsl_function_compiled_eval_params(c, xp, param);
+    }
+    if (f) gsl_vector_set(f, i, (v - gsl_vector_get(y, i))/s);
+  }
+  ALLOCV_END(vtmp);
+  return GSL_SUCCESS;
+}
+
 static int gsl_multifit_function_fdf_f(const gsl_vector *x, void *params,
 				       gsl_vector *f)
 {
   VALUE vt_y_sigma, vt, vy, vsigma, vf, vx, proc, ary;
+  gsl_vector xsaved, fsaved;
   ary = (VALUE) params;
-  vt_y_sigma = rb_ary_entry(ary, 3);
-  proc = rb_ary_entry(ary, 0);
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vf = Data_Wrap_Struct(cgsl_vector, 0, NULL, f);
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  proc = rb_ary_entry(ary, MULTIFIT_FDF_F);
+  if (rb_obj_is_kind_of(proc, cgsl_function_compiled))
+    return multifit_compiled_fdf(ary, x, f, NULL);
+  vx = rb_gsl_callback_vector(ary, MULTIFIT_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vf = rb_gsl_callback_vector(ary, MULTIFIT_FDF_VF, cgsl_vector_view, f, &fsaved);
   switch (RARRAY_LEN(vt_y_sigma)) {
   case 2:
     vt = rb_ary_entry(vt_y_sigma, 0);
@@ -645,18 +953,77 @@ static int gsl_multifit_function_fdf_f(const gsl_vector *x, void *params,
     rb_raise(rb_eArgError, "bad argument");
     break;    
   }
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
   return GSL_SUCCESS;
 }
 
+/*
+  f for several Ruby threads at once: x and f are passed in views of
+  their own instead of the recycled ones of ary
+*/
+static int multifit_fdf_f_reentrant(const gsl_vector *x, void *params, gsl_vector *f)
+{
+  VALUE ary = (VALUE) params, vt_y_sigma, vx, vf, args[5];
+  int i, k;
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  k = RARRAY_LEN(vt_y_sigma);
+  vx = Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL, (gsl_vector *) x);
+  vf = Data_Wrap_Struct(cgsl_vector_view, 0, NULL, f);
+  args[0] = vx;
+  for (i = 0; i < k; i++) args[i+1] = rb_ary_entry(vt_y_sigma, i);
+  args[k+1] = vf;
+  rb_funcall2(rb_ary_entry(ary, MULTIFIT_FDF_F), RBGSL_ID_call, k + 2, args);
+  RB_GC_GUARD(vx);
+  RB_GC_GUARD(vf);
+  return GSL_SUCCESS;
+}
+
+/*
+  A GSL::Diff::Jacobian given as df: J by finite differences of f, with
+  the batch callable (if any) called as batch(X, t, y[, sigma]).  A
+  compiled model is evaluated without the GVL, over the :threads of the
+  Jacobian; a Ruby model from that many Ruby threads.
+*/
+static int multifit_fdiff_jacobian(VALUE fd, VALUE ary, const gsl_vector *x,
+				   const gsl_vector *f, gsl_matrix *J)
+{
+  mygsl_multifit_model md;
+  VALUE vt_y_sigma;
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  Check_Type(vt_y_sigma, T_ARRAY);
+  if (rb_obj_is_kind_of(rb_ary_entry(ary, MULTIFIT_FDF_F), cgsl_function_compiled)) {
+    multifit_model_get(ary, J->size1, x->size, &md);
+    return rb_gsl_fdiff_jacobian_mt(fd, multifit_model_f, &md, RB_GSL_FDIFF_NATIVE,
+				    RARRAY_LEN(vt_y_sigma), RARRAY_PTR(vt_y_sigma), x, f, J);
+  }
+  if (rb_gsl_fdiff_threaded(fd)) {
+    if (RARRAY_LEN(vt_y_sigma) < 2 || RARRAY_LEN(vt_y_sigma) > 3)
+      rb_raise(rb_eArgError, "bad argument");
+    return rb_gsl_fdiff_jacobian_mt(fd, multifit_fdf_f_reentrant, (void *) ary,
+				    RB_GSL_FDIFF_REENTRANT, RARRAY_LEN(vt_y_sigma),
+				    RARRAY_PTR(vt_y_sigma), x, f, J);
+  }
+  return rb_gsl_fdiff_jacobian(fd, gsl_multifit_function_fdf_f, (void *) ary,
+			       RARRAY_LEN(vt_y_sigma), RARRAY_PTR(vt_y_sigma), x, f, J);
+}
+
 static int gsl_multifit_function_fdf_df(const gsl_vector *x, void *params,
 					gsl_matrix *J)
 {
   VALUE vt_y_sigma, vt, vy, vsigma, vJ, vx, proc, ary;
+  gsl_vector xsaved;
+  gsl_matrix Jsaved;
   ary = (VALUE) params;
-  vt_y_sigma = rb_ary_entry(ary, 3);
-  proc = rb_ary_entry(ary, 1);
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vJ = Data_Wrap_Struct(cgsl_matrix, 0, NULL, J);
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  proc = rb_ary_entry(ary, MULTIFIT_FDF_DF);
+  if (NIL_P(proc) && rb_obj_is_kind_of(rb_ary_entry(ary, MULTIFIT_FDF_F),
+				       cgsl_function_compiled))
+    return multifit_compiled_fdf(ary, x, NULL, J);
+  if (rb_obj_is_kind_of(proc, cgsl_diff_jacobian))
+    return multifit_fdiff_jacobian(proc, ary, x, NULL, J);
+  vx = rb_gsl_callback_vector(ary, MULTIFIT_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vJ = rb_gsl_callback_matrix(ary, MULTIFIT_FDF_VJ, cgsl_matrix_view, J, &Jsaved);
   switch (RARRAY_LEN(vt_y_sigma)) {
   case 2:
     vt = rb_ary_entry(vt_y_sigma, 0);
@@ -673,6 +1040,8 @@ static int gsl_multifit_function_fdf_df(const gsl_vector *x, void *params,
     rb_raise(rb_eArgError, "bad argument");
     break;    
   }
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_matrix_restore(vJ, &Jsaved);
   return GSL_SUCCESS;
 }
 
@@ -681,14 +1050,22 @@ static int gsl_multifit_function_fdf_fdf(const gsl_vector *x, void *params,
 {
   VALUE vt_y_sigma, vt, vy, vsigma, vf, vJ, vx, proc_f, proc_df, proc_fdf;
   VALUE ary;
+  gsl_vector xsaved, fsaved;
+  gsl_matrix Jsaved;
   ary = (VALUE) params;
-  vt_y_sigma = rb_ary_entry(ary, 3);
-  proc_f = rb_ary_entry(ary, 0);
-  proc_df = rb_ary_entry(ary, 1);
-  proc_fdf = rb_ary_entry(ary, 2);
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vf = Data_Wrap_Struct(cgsl_vector, 0, NULL, f);
-  vJ = Data_Wrap_Struct(cgsl_matrix, 0, NULL, J);
+  vt_y_sigma = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  proc_f = rb_ary_entry(ary, MULTIFIT_FDF_F);
+  proc_df = rb_ary_entry(ary, MULTIFIT_FDF_DF);
+  proc_fdf = rb_ary_entry(ary, MULTIFIT_FDF_FDF);
+  if (NIL_P(proc_fdf) && NIL_P(proc_df) && rb_obj_is_kind_of(proc_f, cgsl_function_compiled))
+    return multifit_compiled_fdf(ary, x, f, J);
+  if (NIL_P(proc_fdf) && rb_obj_is_kind_of(proc_df, cgsl_diff_jacobian)) {
+    gsl_multifit_function_fdf_f(x, params, f);
+    return multifit_fdiff_jacobian(proc_df, ary, x, f, J);
+  }
+  vx = rb_gsl_callback_vector(ary, MULTIFIT_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vf = rb_gsl_callback_vector(ary, MULTIFIT_FDF_VF, cgsl_vector_view, f, &fsaved);
+  vJ = rb_gsl_callback_matrix(ary, MULTIFIT_FDF_VJ, cgsl_matrix_view, J, &Jsaved);
   switch (RARRAY_LEN(vt_y_sigma)) {
   case 2:
     vt = rb_ary_entry(vt_y_sigma, 0);
@@ -713,9 +1090,35 @@ static int gsl_multifit_function_fdf_fdf(const gsl_vector *x, void *params,
     rb_raise(rb_eArgError, "bad argument");
     break;    
   }
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
+  rb_gsl_callback_matrix_restore(vJ, &Jsaved);
   return GSL_SUCCESS;
 }
 
+/*
+  Used also in multifit_nlinear.c: the function of a Function_fdf, with
+  whether it gives J itself (a df, or a compiled model) and its data
+  [t, y(, sigma)]
+*/
+gsl_multifit_function_fdf* rb_gsl_multifit_function_fdf_get(VALUE obj, int *has_df,
+							     VALUE *data)
+{
+  gsl_multifit_function_fdf *F = NULL;
+  VALUE ary;
+  if (!rb_obj_is_kind_of(obj, cgsl_multifit_function_fdf))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::MultiFit::Function_fdf expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, gsl_multifit_function_fdf, F);
+  if (F->params == NULL) rb_raise(rb_eArgError, "function not set");
+  ary = (VALUE) F->params;
+  *has_df = !NIL_P(rb_ary_entry(ary, MULTIFIT_FDF_DF))
+    || rb_obj_is_kind_of(rb_ary_entry(ary, MULTIFIT_FDF_F), cgsl_function_compiled);
+  *data = rb_ary_entry(ary, MULTIFIT_FDF_DATA);
+  if (TYPE(*data) != T_ARRAY) rb_raise(rb_eArgError, "data not set (see set_data)");
+  return F;
+}
+
 static VALUE rb_gsl_multifit_function_fdf_params(VALUE obj)
 {
   gsl_multifit_function_fdf *f = NULL;
@@ -745,6 +1148,38 @@ static VALUE rb_gsl_multifit_function_fdf_p(VALUE obj)
   return INT2FIX(f->p);
 }
 
+/*
+  GSL::MultiFit::Function_fdf.compile(model, p, params = {})
+
+    f = GSL::MultiFit::Function_fdf.compile("x[0]*exp(-x[1]*t) + x[2]", 3)
+    f.set_data(t, y, sigma)
+
+  The model is an expression in t, the fit parameters x[0] ... x[p-1]
+  and the parameters of params (see GSL::Function.compile); the
+  residuals and their Jacobian are evaluated in C, the Jacobian exactly
+  with dual numbers.
+*/
+static VALUE rb_gsl_multifit_function_fdf_compile(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE params, obj, args[3];
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  CHECK_FIXNUM(argv[1]);
+  if (FIX2INT(argv[1]) <= 0) rb_raise(rb_eArgError, "p must be positive");
+  params = rb_hash_new();
+  rb_hash_aset(params, rb_str_new2("t"), rb_float_new(0.0));  /* params[0] */
+  if (argc == 3) {
+    Check_Type(argv[2], T_HASH);
+    rb_funcall(params, rb_intern("update"), 1, argv[2]);
+  }
+  obj = rb_gsl_multifit_function_fdf_new(0, NULL, klass);
+  args[0] = rb_gsl_function_compile_multi(argv[0], params, FIX2INT(argv[1]));
+  args[1] = Qnil;
+  args[2] = argv[1];
+  rb_gsl_multifit_function_fdf_set_procs(3, args, obj);
+  return obj;
+}
+
 /*****/
 struct fitting_xydata {
   gsl_vector *x, *y, *w;
@@ -1793,6 +2228,8 @@ void Init_gsl_multifit(VALUE module)
 			     rb_gsl_multifit_function_fdf_new, -1);
   rb_define_singleton_method(cgsl_multifit_function_fdf, "alloc", 
 			     rb_gsl_multifit_function_fdf_new, -1);
+  rb_define_singleton_method(cgsl_multifit_function_fdf, "compile", 
+			     rb_gsl_multifit_function_fdf_compile, -1);
 
   /*****/
 
@@ -1860,6 +2297,10 @@ void Init_gsl_multifit(VALUE module)
 #ifdef HAVE_NDLINEAR_GSL_MULTIFIT_NDLINEAR_H
   Init_ndlinear(mgsl_multifit);
 #endif
+  Init_gsl_multifit_accumulate(mgsl_multifit);
+#ifdef HAVE_GSL_GSL_MULTIFIT_NLINEAR_H
+  Init_gsl_multifit_nlinear(module, mgsl_multifit);
+#endif
 
 }
 
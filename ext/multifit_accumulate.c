@@ -0,0 +1,404 @@
+/*
+  multifit_accumulate.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Linear least squares over data too large for one design matrix: the
+  rows are given block by block and only the p x p triangular factor
+  of the QR decomposition is kept.
+
+    acc = GSL::MultiFit::Accumulator.alloc(p)
+    file.each_block { |X, y| acc.push_rows(X, y) }     # X m x p, y m
+    c, cov, chisq, status = acc.solve
+
+  Each block [X y] is folded into [R Q^T y] by Householder reflections
+  which leave R upper triangular (a streaming TSQR), in chunks of at
+  most MULTIFIT_ACCUM_CHUNK rows copied aside, so the memory used is
+  O(p^2) whatever the number of rows. The update runs without the GVL
+  for large blocks; a block of many rows is cut in row ranges folded
+  on GSL.parallel_threads threads into factors of their own, which
+  are then merged as merge! does (TSQR).
+
+  With the weights w, push_rows(X, y, w) scales the rows by sqrt(w)
+  and solve is that of MultiFit.wlinear, the covariance (X^T W X)^-1;
+  without, that of MultiFit.linear, the covariance scaled by
+  chisq/(n - p). The rows of one accumulator are either all weighted
+  or none.
+
+  Accumulators of the same p combine with merge!, so that blocks can be
+  ingested by several threads, each into its own accumulator:
+
+    accs = blocks.each_slice(k).map { |bs|
+      Thread.new { a = GSL::MultiFit::Accumulator.alloc(p); bs.each { |X, y| a.push_rows(X, y) }; a }
+    }.map(&:value)
+    accs.each { |a| accs[0].merge!(a) unless a.equal?(accs[0]) }
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_fit.h"
+#include <gsl/gsl_blas.h>
+
+#define MULTIFIT_ACCUM_CHUNK 256
+
+typedef struct {
+  size_t p, n;                  /* columns, rows seen */
+  int weighted;                 /* -1 until the first rows */
+  int busy;
+  double rss;                   /* residual sum of squares */
+  double *R;                    /* p x (p + 1): R, then Q^T y */
+  double *work;                 /* max(CHUNK, p) x (p + 1) */
+  double *s;
+} mygsl_multifit_accum;
+
+static VALUE cgsl_multifit_accum;
+
+static void mygsl_multifit_accum_free(mygsl_multifit_accum *a)
+{
+  xfree(a->R);
+  xfree(a->work);
+  xfree(a->s);
+  xfree(a);
+}
+
+static void multifit_accum_init(mygsl_multifit_accum *a, size_t p)
+{
+  a->p = p;
+  a->R = ALLOC_N(double, p*(p + 1));
+  a->work = ALLOC_N(double, GSL_MAX(MULTIFIT_ACCUM_CHUNK, p)*(p + 1));
+  a->s = ALLOC_N(double, p + 1);
+}
+
+static void multifit_accum_reset(mygsl_multifit_accum *a)
+{
+  memset(a->R, 0, sizeof(double)*a->p*(a->p + 1));
+  a->n = 0;
+  a->rss = 0.0;
+  a->weighted = -1;
+}
+
+static VALUE rb_gsl_multifit_accum_alloc(VALUE klass, VALUE pp)
+{
+  mygsl_multifit_accum *a = NULL;
+  VALUE obj;
+  size_t p = NUM2SIZET(pp);
+  if (p == 0) rb_raise(rb_eArgError, "p must be positive");
+  obj = Data_Make_Struct(klass, mygsl_multifit_accum, 0, mygsl_multifit_accum_free, a);
+  multifit_accum_init(a, p);
+  multifit_accum_reset(a);
+  return obj;
+}
+
+/*
+  Folds the m rows B (m x (p + 1), each [x y]) into a, B destroyed.
+  Column j is zeroed below R[j][j] by the reflection I - beta v v^T,
+  v = (R[j][j] - alpha, B[0][j] ... B[m-1][j]), which only touches row
+  j of R since the rows under it are zero there.
+*/
+static void multifit_accum_update(mygsl_multifit_accum *a, double *B, size_t m)
+{
+  size_t p = a->p, q = p + 1, i, j, k;
+  double *R = a->R, *s = a->s, *row, norm2, rjj, alpha, v0, beta, xij;
+  for (j = 0; j < p; j++) {
+    norm2 = 0.0;
+    for (i = 0; i < m; i++) norm2 += B[i*q + j]*B[i*q + j];
+    if (norm2 == 0.0) continue;
+    rjj = R[j*q + j];
+    alpha = sqrt(rjj*rjj + norm2);
+    if (rjj > 0) alpha = -alpha;
+    v0 = rjj - alpha;
+    beta = 2.0/(v0*v0 + norm2);
+    R[j*q + j] = alpha;
+    for (k = j + 1; k < q; k++) s[k] = v0*R[j*q + k];
+    for (i = 0; i < m; i++) {
+      row = B + i*q;
+      if ((xij = row[j]) == 0.0) continue;
+      for (k = j + 1; k < q; k++) s[k] += xij*row[k];
+    }
+    for (k = j + 1; k < q; k++) {
+      s[k] *= beta;
+      R[j*q + k] -= s[k]*v0;
+    }
+    for (i = 0; i < m; i++) {
+      row = B + i*q;
+      if ((xij = row[j]) == 0.0) continue;
+      for (k = j + 1; k < q; k++) row[k] -= s[k]*xij;
+    }
+  }
+  for (i = 0; i < m; i++) a->rss += B[i*q + p]*B[i*q + p];
+}
+
+struct multifit_accum_push {
+  mygsl_multifit_accum *a;
+  const gsl_matrix *X;
+  const gsl_vector *y, *w;
+  const mygsl_multifit_accum *other;
+  mygsl_multifit_accum *parts;  /* one per thread */
+  size_t nthreads;
+};
+
+/* Folds the rows i0 ... i1-1 of X, y (and w) into a */
+static void multifit_accum_fold(mygsl_multifit_accum *a, const struct multifit_accum_push *d,
+				size_t i0, size_t i1)
+{
+  size_t p = a->p, q = p + 1, i, j, mi;
+  double *row, sw;
+  for (; i0 < i1; i0 += mi) {
+    mi = GSL_MIN(MULTIFIT_ACCUM_CHUNK, i1 - i0);
+    for (i = 0; i < mi; i++) {
+      row = a->work + i*q;
+      sw = d->w ? sqrt(gsl_vector_get(d->w, i0 + i)) : 1.0;
+      for (j = 0; j < p; j++) row[j] = sw*gsl_matrix_get(d->X, i0 + i, j);
+      row[p] = sw*gsl_vector_get(d->y, i0 + i);
+    }
+    multifit_accum_update(a, a->work, mi);
+  }
+}
+
+/* Folds the factor and residual of b into a; b may be a itself */
+static void multifit_accum_merge0(mygsl_multifit_accum *a, const mygsl_multifit_accum *b)
+{
+  double rss = b->rss;
+  memcpy(a->work, b->R, sizeof(double)*b->p*(b->p + 1));
+  multifit_accum_update(a, a->work, a->p);
+  a->rss += rss;
+}
+
+static int multifit_accum_push_nogvl(void *data)
+{
+  struct multifit_accum_push *d = (struct multifit_accum_push *) data;
+  multifit_accum_fold(d->a, d, 0, d->X->size1);
+  d->a->n += d->X->size1;
+  return GSL_SUCCESS;
+}
+
+static int multifit_accum_part_worker(void *data, size_t t)
+{
+  struct multifit_accum_push *d = (struct multifit_accum_push *) data;
+  size_t m = d->X->size1;
+  multifit_accum_fold(d->parts + t, d, t*m/d->nthreads, (t + 1)*m/d->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int multifit_accum_merge_parts_nogvl(void *data)
+{
+  struct multifit_accum_push *d = (struct multifit_accum_push *) data;
+  size_t t;
+  for (t = 0; t < d->nthreads; t++) multifit_accum_merge0(d->a, d->parts + t);
+  d->a->n += d->X->size1;
+  return GSL_SUCCESS;
+}
+
+static int multifit_accum_merge_nogvl(void *data)
+{
+  struct multifit_accum_push *d = (struct multifit_accum_push *) data;
+  size_t n = d->other->n;
+  multifit_accum_merge0(d->a, d->other);
+  d->a->n += n;
+  return GSL_SUCCESS;
+}
+
+/* Threads for m rows: each folds a range of at least 4p rows, so that
+   the p^3 of its merge stays small next to its m p^2/nthreads */
+static void multifit_accum_push0(struct multifit_accum_push *d)
+{
+  mygsl_multifit_accum *a = d->a;
+  size_t p = a->p, m = d->X->size1, t;
+  d->nthreads = rb_gsl_parallel_nthreads(m*p*p, m/(4*p) > 0 ? m/(4*p) : 1);
+  if (d->nthreads <= 1) {
+    rb_gsl_nogvl_call(multifit_accum_push_nogvl, d, m*p*p);
+    return;
+  }
+  d->parts = ALLOC_N(mygsl_multifit_accum, d->nthreads);
+  for (t = 0; t < d->nthreads; t++) {
+    multifit_accum_init(d->parts + t, p);
+    multifit_accum_reset(d->parts + t);
+  }
+  rb_gsl_nogvl_parallel(multifit_accum_part_worker, d, d->nthreads);
+  rb_gsl_nogvl_call(multifit_accum_merge_parts_nogvl, d, d->nthreads*p*p*p);
+  for (t = 0; t < d->nthreads; t++) {
+    xfree(d->parts[t].R);
+    xfree(d->parts[t].work);
+    xfree(d->parts[t].s);
+  }
+  xfree(d->parts);
+}
+
+static mygsl_multifit_accum* multifit_accum_get(VALUE obj)
+{
+  mygsl_multifit_accum *a = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_multifit_accum))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::MultiFit::Accumulator expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_multifit_accum, a);
+  if (a->busy) rb_raise(rb_eRuntimeError, "accumulator in use by another thread");
+  return a;
+}
+
+static void multifit_accum_weighting(mygsl_multifit_accum *a, int weighted)
+{
+  if (a->weighted >= 0 && a->weighted != weighted)
+    rb_raise(rb_eArgError, "weighted and unweighted rows in the same accumulator");
+}
+
+/* Folds the rows X, y (w may be NULL) into the accumulator acc */
+void rb_gsl_multifit_accum_push(VALUE acc, const gsl_matrix *X, const gsl_vector *y,
+				const gsl_vector *w)
+{
+  mygsl_multifit_accum *a = multifit_accum_get(acc);
+  struct multifit_accum_push d;
+  size_t i;
+  if (X->size2 != a->p)
+    rb_raise(rb_eArgError, "rows of %d columns for an accumulator of %d",
+	     (int) X->size2, (int) a->p);
+  if (y->size != X->size1 || (w && w->size != X->size1))
+    rb_raise(rb_eArgError, "%d rows but %d observations", (int) X->size1,
+	     (int) (y->size != X->size1 ? y->size : w->size));
+  multifit_accum_weighting(a, w != NULL);
+  if (w) {
+    for (i = 0; i < w->size; i++)
+      if (!(gsl_vector_get(w, i) >= 0.0)) rb_raise(rb_eArgError, "negative weight");
+  }
+  if (X->size1 == 0) return;
+  a->weighted = w != NULL;
+  memset(&d, 0, sizeof(d));
+  d.a = a;  d.X = X;  d.y = y;  d.w = w;
+  a->busy = 1;
+  multifit_accum_push0(&d);
+  a->busy = 0;
+}
+
+/* push_rows(X, y[, w]) */
+static VALUE rb_gsl_multifit_accum_push_rows(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *X = NULL;
+  gsl_vector *y = NULL, *w = NULL;
+  if (argc != 2 && argc != 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  Data_Get_Matrix(argv[0], X);
+  Data_Get_Vector(argv[1], y);
+  if (argc == 3) Data_Get_Vector(argv[2], w);
+  rb_gsl_multifit_accum_push(obj, X, y, w);
+  return obj;
+}
+
+static VALUE rb_gsl_multifit_accum_merge(VALUE obj, VALUE other)
+{
+  mygsl_multifit_accum *a = multifit_accum_get(obj), *b = multifit_accum_get(other);
+  struct multifit_accum_push d;
+  if (b->p != a->p)
+    rb_raise(rb_eArgError, "accumulators of %d and %d columns", (int) a->p, (int) b->p);
+  if (b->n == 0) return obj;
+  multifit_accum_weighting(a, b->weighted);
+  a->weighted = b->weighted;
+  memset(&d, 0, sizeof(d));
+  d.a = a;  d.other = b;
+  a->busy = 1;
+  b->busy = 1;
+  rb_gsl_nogvl_call(multifit_accum_merge_nogvl, &d, a->p*a->p*a->p);
+  a->busy = 0;
+  b->busy = 0;
+  return obj;
+}
+
+static int multifit_accum_check(const mygsl_multifit_accum *a)
+{
+  size_t j, p = a->p;
+  double rmax = 0.0;
+  if (a->n < p) GSL_ERROR("fewer observations than parameters", GSL_EINVAL);
+  for (j = 0; j < p; j++) rmax = GSL_MAX(rmax, fabs(a->R[j*(p + 1) + j]));
+  for (j = 0; j < p; j++)
+    if (fabs(a->R[j*(p + 1) + j]) <= GSL_DBL_EPSILON*p*rmax)
+      GSL_ERROR("design matrix is rank deficient", GSL_ESING);
+  return GSL_SUCCESS;
+}
+
+/* Returns [c, cov, chisq, status] as MultiFit.linear or wlinear */
+static VALUE rb_gsl_multifit_accum_solve(VALUE obj)
+{
+  mygsl_multifit_accum *a = multifit_accum_get(obj);
+  gsl_matrix_view R;
+  gsl_vector_view qty;
+  gsl_matrix *cov, *Ri;
+  gsl_vector *c;
+  size_t p = a->p;
+  int status;
+  VALUE vc, vcov;
+  if ((status = multifit_accum_check(a)) != GSL_SUCCESS)
+    return rb_ary_new3(4, Qnil, Qnil, rb_float_new(a->rss), INT2FIX(status));
+  R = gsl_matrix_view_array_with_tda(a->R, p, p, p + 1);
+  qty = gsl_vector_view_array_with_stride(a->R + p, p + 1, p);
+  c = gsl_vector_alloc(p);
+  gsl_vector_memcpy(c, &qty.vector);
+  gsl_blas_dtrsv(CblasUpper, CblasNoTrans, CblasNonUnit, &R.matrix, c);
+  Ri = gsl_matrix_alloc(p, p);
+  gsl_matrix_set_identity(Ri);
+  gsl_blas_dtrsm(CblasLeft, CblasUpper, CblasNoTrans, CblasNonUnit, 1.0, &R.matrix, Ri);
+  cov = gsl_matrix_alloc(p, p);
+  gsl_blas_dgemm(CblasNoTrans, CblasTrans, a->weighted == 1 ? 1.0 : a->rss/(a->n - p),
+		 Ri, Ri, 0.0, cov);
+  gsl_matrix_free(Ri);
+  vc = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, c);
+  vcov = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, cov);
+  return rb_ary_new3(4, vc, vcov, rb_float_new(a->rss), INT2FIX(status));
+}
+
+static VALUE rb_gsl_multifit_accum_reset(VALUE obj)
+{
+  multifit_accum_reset(multifit_accum_get(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_multifit_accum_p(VALUE obj)
+{
+  mygsl_multifit_accum *a = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_accum, a);
+  return SIZET2NUM(a->p);
+}
+
+static VALUE rb_gsl_multifit_accum_n(VALUE obj)
+{
+  mygsl_multifit_accum *a = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_accum, a);
+  return SIZET2NUM(a->n);
+}
+
+static VALUE rb_gsl_multifit_accum_chisq(VALUE obj)
+{
+  mygsl_multifit_accum *a = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_accum, a);
+  return rb_float_new(a->rss);
+}
+
+/* The triangular factor R, X = QR */
+static VALUE rb_gsl_multifit_accum_R(VALUE obj)
+{
+  mygsl_multifit_accum *a = multifit_accum_get(obj);
+  gsl_matrix_view R = gsl_matrix_view_array_with_tda(a->R, a->p, a->p, a->p + 1);
+  gsl_matrix *m = gsl_matrix_alloc(a->p, a->p);
+  gsl_matrix_memcpy(m, &R.matrix);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+void Init_gsl_multifit_accumulate(VALUE mgsl_multifit)
+{
+  cgsl_multifit_accum = rb_define_class_under(mgsl_multifit, "Accumulator", cGSL_Object);
+  rb_define_singleton_method(cgsl_multifit_accum, "alloc", rb_gsl_multifit_accum_alloc, 1);
+  rb_define_singleton_method(cgsl_multifit_accum, "new", rb_gsl_multifit_accum_alloc, 1);
+
+  rb_define_method(cgsl_multifit_accum, "push_rows", rb_gsl_multifit_accum_push_rows, -1);
+  rb_define_method(cgsl_multifit_accum, "merge!", rb_gsl_multifit_accum_merge, 1);
+  rb_define_method(cgsl_multifit_accum, "solve", rb_gsl_multifit_accum_solve, 0);
+  rb_define_method(cgsl_multifit_accum, "reset", rb_gsl_multifit_accum_reset, 0);
+  rb_define_method(cgsl_multifit_accum, "p", rb_gsl_multifit_accum_p, 0);
+  rb_define_method(cgsl_multifit_accum, "n", rb_gsl_multifit_accum_n, 0);
+  rb_define_method(cgsl_multifit_accum, "chisq", rb_gsl_multifit_accum_chisq, 0);
+  rb_define_method(cgsl_multifit_accum, "R", rb_gsl_multifit_accum_R, 0);
+}
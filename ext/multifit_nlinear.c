@@ -0,0 +1,671 @@
+/*
+  multifit_nlinear.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The trust region nonlinear least squares solvers of GSL >= 2.2,
+  gsl_multifit_nlinear (dense Jacobian) and gsl_multilarge_nlinear
+  (the Jacobian only through products J u, J^T u and J^T J).
+
+    f = GSL::MultiFit::Function_fdf.alloc(my_f, my_df, p)   # or compile
+    f.set_data(t, y, sigma)
+    w = GSL::MultiFit::Nlinear.alloc(n, p, :trs => :lmaccel, :scale => :more)
+    w.set(f, x0)                              # also :weights, :fvv
+    status, info = w.driver(100, 1e-8, 1e-8, 1e-8) { |iter, w| ... }
+    w.position; w.residual; w.covar(0.0); w.niter
+
+  A Function_fdf without df (and not compiled) gets its Jacobian by
+  finite differences (:fdtype, :h_df). The second directional
+  derivative for geodesic acceleration (:lmaccel, :avmax) is given by
+  :fvv => proc { |x, v, t, y[, sigma], fvv| }, or else estimated from f.
+
+    w = GSL::MultiLarge::Nlinear.alloc(n, p, :trs => :cgst)
+    w.set(proc { |x, f| ... }, proc { |trans, x, u, v, jtj| ... }, x0)
+
+  where df sets v = J u (trans :notrans) or v = J^T u (:trans) when u
+  and v are given, and fills J^T J when jtj is given (needed by the
+  :cholesky solver, not by :cgst), so that J itself is never stored.
+
+  Options of alloc: :trs (lm, lmaccel, dogleg, ddogleg, subspace2D, and
+  cgst for MultiLarge), :scale (more, levenberg, marquardt), :solver
+  (qr, cholesky, svd; cholesky for MultiLarge), :fdtype (forward,
+  central), :factor_up, :factor_down, :avmax, :h_df, :h_fvv and, for
+  the cgst subproblem of MultiLarge, :max_iter and :tol.
+*/
+
+#include "rb_gsl_config.h"
+#ifdef HAVE_GSL_GSL_MULTIFIT_NLINEAR_H
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_function.h"
+#include <gsl/gsl_multifit_nlinear.h>
+#ifdef HAVE_GSL_GSL_MULTILARGE_NLINEAR_H
+#include <gsl/gsl_multilarge_nlinear.h>
+#endif
+
+gsl_multifit_function_fdf* rb_gsl_multifit_function_fdf_get(VALUE obj, int *has_df,
+							     VALUE *data);
+
+static VALUE cgsl_multifit_nlinear;
+
+/* Views passed to the Ruby callbacks */
+enum {
+  NLINEAR_VX = 0,
+  NLINEAR_VF,
+  NLINEAR_VU,
+  NLINEAR_VV,
+  NLINEAR_VJTJ,
+  NLINEAR_VFVV,
+  NLINEAR_NVIEWS,
+};
+
+static const char* nlinear_name(VALUE v)
+{
+  if (TYPE(v) == T_SYMBOL) return rb_id2name(SYM2ID(v));
+  return StringValueCStr(v);
+}
+
+static void nlinear_unknown(const char *what, VALUE v)
+{
+  rb_raise(rb_eArgError, "unknown %s %s", what, nlinear_name(v));
+}
+
+static VALUE nlinear_opt(VALUE opts, const char *key)
+{
+  if (NIL_P(opts)) return Qnil;
+  return rb_hash_aref(opts, ID2SYM(rb_intern(key)));
+}
+
+typedef struct {
+  gsl_multifit_nlinear_workspace *w;
+  gsl_multifit_nlinear_fdf fdf;
+  gsl_multifit_function_fdf *F;
+  VALUE func, data, fvv, views;
+} mygsl_nlinear;
+
+static void mygsl_nlinear_mark(mygsl_nlinear *s)
+{
+  rb_gc_mark(s->func);
+  rb_gc_mark(s->data);
+  rb_gc_mark(s->fvv);
+  rb_gc_mark(s->views);
+}
+
+static void mygsl_nlinear_free(mygsl_nlinear *s)
+{
+  if (s->w) gsl_multifit_nlinear_free(s->w);
+  xfree(s);
+}
+
+static mygsl_nlinear* nlinear_get(VALUE obj)
+{
+  mygsl_nlinear *s = NULL;
+  Data_Get_Struct(obj, mygsl_nlinear, s);
+  return s;
+}
+
+static mygsl_nlinear* nlinear_get_set(VALUE obj)
+{
+  mygsl_nlinear *s = nlinear_get(obj);
+  if (NIL_P(s->func)) rb_raise(rb_eRuntimeError, "no function set (see set)");
+  return s;
+}
+
+static int nlinear_f(const gsl_vector *x, void *params, gsl_vector *f)
+{
+  mygsl_nlinear *s = (mygsl_nlinear *) params;
+  return (*s->F->f)(x, s->F->params, f);
+}
+
+static int nlinear_df(const gsl_vector *x, void *params, gsl_matrix *J)
+{
+  mygsl_nlinear *s = (mygsl_nlinear *) params;
+  return (*s->F->df)(x, s->F->params, J);
+}
+
+/* fvv.call(x, v, t, y[, sigma], fvv) */
+static int nlinear_fvv(const gsl_vector *x, const gsl_vector *v, void *params,
+		       gsl_vector *fvv)
+{
+  mygsl_nlinear *s = (mygsl_nlinear *) params;
+  VALUE args[7];
+  gsl_vector xsaved, vsaved, fsaved;
+  long i, nd = RARRAY_LEN(s->data);
+  args[0] = rb_gsl_callback_vector(s->views, NLINEAR_VX, cgsl_vector_view_ro, x, &xsaved);
+  args[1] = rb_gsl_callback_vector(s->views, NLINEAR_VU, cgsl_vector_view_ro, v, &vsaved);
+  for (i = 0; i < nd; i++) args[2 + i] = rb_ary_entry(s->data, i);
+  args[2 + nd] = rb_gsl_callback_vector(s->views, NLINEAR_VFVV, cgsl_vector_view, fvv, &fsaved);
+  rb_funcall2(s->fvv, RBGSL_ID_call, (int) (nd + 3), args);
+  rb_gsl_callback_vector_restore(args[0], &xsaved);
+  rb_gsl_callback_vector_restore(args[1], &vsaved);
+  rb_gsl_callback_vector_restore(args[2 + nd], &fsaved);
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_multifit_nlinear_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_multifit_nlinear_parameters fparams = gsl_multifit_nlinear_default_parameters();
+  mygsl_nlinear *s = NULL;
+  VALUE obj, opts = Qnil, v;
+  const char *name;
+  size_t n, p;
+  if (argc != 2 && argc != 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  n = NUM2SIZET(argv[0]);
+  p = NUM2SIZET(argv[1]);
+  if (p == 0 || n < p) rb_raise(rb_eArgError, "%d observations for %d parameters", (int) n, (int) p);
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "trs"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "lm") == 0) fparams.trs = gsl_multifit_nlinear_trs_lm;
+    else if (strcmp(name, "lmaccel") == 0) fparams.trs = gsl_multifit_nlinear_trs_lmaccel;
+    else if (strcmp(name, "dogleg") == 0) fparams.trs = gsl_multifit_nlinear_trs_dogleg;
+    else if (strcmp(name, "ddogleg") == 0) fparams.trs = gsl_multifit_nlinear_trs_ddogleg;
+    else if (strcmp(name, "subspace2D") == 0) fparams.trs = gsl_multifit_nlinear_trs_subspace2D;
+    else nlinear_unknown("trust region subproblem", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "scale"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "more") == 0) fparams.scale = gsl_multifit_nlinear_scale_more;
+    else if (strcmp(name, "levenberg") == 0) fparams.scale = gsl_multifit_nlinear_scale_levenberg;
+    else if (strcmp(name, "marquardt") == 0) fparams.scale = gsl_multifit_nlinear_scale_marquardt;
+    else nlinear_unknown("scaling", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "solver"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "qr") == 0) fparams.solver = gsl_multifit_nlinear_solver_qr;
+    else if (strcmp(name, "cholesky") == 0) fparams.solver = gsl_multifit_nlinear_solver_cholesky;
+    else if (strcmp(name, "svd") == 0) fparams.solver = gsl_multifit_nlinear_solver_svd;
+    else nlinear_unknown("solver", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "fdtype"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "forward") == 0) fparams.fdtype = GSL_MULTIFIT_NLINEAR_FWDIFF;
+    else if (strcmp(name, "central") == 0) fparams.fdtype = GSL_MULTIFIT_NLINEAR_CTRDIFF;
+    else nlinear_unknown("finite difference type", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "factor_up"))) fparams.factor_up = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "factor_down"))) fparams.factor_down = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "avmax"))) fparams.avmax = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "h_df"))) fparams.h_df = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "h_fvv"))) fparams.h_fvv = NUM2DBL(v);
+  obj = Data_Make_Struct(klass, mygsl_nlinear, mygsl_nlinear_mark, mygsl_nlinear_free, s);
+  s->func = s->data = s->fvv = Qnil;
+  s->views = rb_ary_new2(NLINEAR_NVIEWS);
+  s->w = gsl_multifit_nlinear_alloc(gsl_multifit_nlinear_trust, &fparams, n, p);
+  if (s->w == NULL) rb_raise(rb_eNoMemError, "gsl_multifit_nlinear_alloc failed");
+  return obj;
+}
+
+/* set(fdf, x[, opts]), opts :weights, :fvv */
+static VALUE rb_gsl_multifit_nlinear_set(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_nlinear *s = nlinear_get(obj);
+  gsl_multifit_function_fdf *F;
+  gsl_vector *x = NULL, *wts = NULL;
+  VALUE opts = Qnil, vw, fvv, data;
+  int has_df;
+  if (argc != 2 && argc != 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  F = rb_gsl_multifit_function_fdf_get(argv[0], &has_df, &data);
+  Data_Get_Vector(argv[1], x);
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+  }
+  vw = nlinear_opt(opts, "weights");
+  fvv = nlinear_opt(opts, "fvv");
+  if (!NIL_P(vw)) Data_Get_Vector(vw, wts);
+  if (F->n != s->w->f->size || F->p != s->w->x->size || x->size != F->p)
+    rb_raise(rb_eArgError, "function of %d values and %d parameters, x of %d, for a %d x %d solver",
+	     (int) F->n, (int) F->p, (int) x->size, (int) s->w->f->size, (int) s->w->x->size);
+  if (wts && wts->size != F->n) rb_raise(rb_eArgError, "%d weights for %d values", (int) wts->size, (int) F->n);
+  if (!NIL_P(fvv) && !rb_respond_to(fvv, RBGSL_ID_call))
+    rb_raise(rb_eTypeError, "fvv must be callable");
+  s->F = F;
+  s->func = argv[0];
+  s->data = data;
+  s->fvv = fvv;
+  s->fdf.f = nlinear_f;
+  s->fdf.df = has_df ? nlinear_df : NULL;
+  s->fdf.fvv = NIL_P(fvv) ? NULL : nlinear_fvv;
+  s->fdf.n = F->n;
+  s->fdf.p = F->p;
+  s->fdf.params = s;
+  gsl_multifit_nlinear_winit(x, wts, &s->fdf, s->w);
+  return obj;
+}
+
+static VALUE rb_gsl_multifit_nlinear_iterate(VALUE obj)
+{
+  return INT2FIX(gsl_multifit_nlinear_iterate(nlinear_get_set(obj)->w));
+}
+
+static void nlinear_callback(const size_t iter, void *params,
+			     const gsl_multifit_nlinear_workspace *w)
+{
+  rb_yield_values(2, SIZET2NUM(iter), (VALUE) params);
+}
+
+/* driver(maxiter, xtol, gtol, ftol) { |iter, w| }: [status, info] */
+static VALUE rb_gsl_multifit_nlinear_driver(VALUE obj, VALUE maxiter, VALUE xtol,
+					    VALUE gtol, VALUE ftol)
+{
+  mygsl_nlinear *s = nlinear_get_set(obj);
+  int status, info = 0;
+  status = gsl_multifit_nlinear_driver(NUM2SIZET(maxiter), NUM2DBL(xtol), NUM2DBL(gtol),
+				       NUM2DBL(ftol), rb_block_given_p() ? nlinear_callback : NULL,
+				       (void *) obj, &info, s->w);
+  return rb_ary_new3(2, INT2FIX(status), INT2FIX(info));
+}
+
+/* test(xtol, gtol, ftol): [status, info] */
+static VALUE rb_gsl_multifit_nlinear_test(VALUE obj, VALUE xtol, VALUE gtol, VALUE ftol)
+{
+  mygsl_nlinear *s = nlinear_get_set(obj);
+  int status, info = 0;
+  status = gsl_multifit_nlinear_test(NUM2DBL(xtol), NUM2DBL(gtol), NUM2DBL(ftol), &info, s->w);
+  return rb_ary_new3(2, INT2FIX(status), INT2FIX(info));
+}
+
+static VALUE rb_gsl_multifit_nlinear_position(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL,
+			  gsl_multifit_nlinear_position(nlinear_get(obj)->w));
+}
+
+static VALUE rb_gsl_multifit_nlinear_residual(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL,
+			  gsl_multifit_nlinear_residual(nlinear_get(obj)->w));
+}
+
+static VALUE rb_gsl_multifit_nlinear_jac(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_matrix_view_ro, 0, NULL,
+			  gsl_multifit_nlinear_jac(nlinear_get(obj)->w));
+}
+
+static VALUE rb_gsl_multifit_nlinear_covar(VALUE obj, VALUE epsrel)
+{
+  mygsl_nlinear *s = nlinear_get_set(obj);
+  gsl_matrix *covar;
+  size_t p = s->w->x->size;
+  covar = gsl_matrix_alloc(p, p);
+  gsl_multifit_nlinear_covar(gsl_multifit_nlinear_jac(s->w), NUM2DBL(epsrel), covar);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, covar);
+}
+
+static VALUE rb_gsl_multifit_nlinear_niter(VALUE obj)
+{
+  return SIZET2NUM(gsl_multifit_nlinear_niter(nlinear_get(obj)->w));
+}
+
+static VALUE rb_gsl_multifit_nlinear_rcond(VALUE obj)
+{
+  double rcond;
+  gsl_multifit_nlinear_rcond(&rcond, nlinear_get_set(obj)->w);
+  return rb_float_new(rcond);
+}
+
+static VALUE rb_gsl_multifit_nlinear_avratio(VALUE obj)
+{
+  return rb_float_new(gsl_multifit_nlinear_avratio(nlinear_get(obj)->w));
+}
+
+static VALUE rb_gsl_multifit_nlinear_name(VALUE obj)
+{
+  return rb_str_new2(gsl_multifit_nlinear_name(nlinear_get(obj)->w));
+}
+
+static VALUE rb_gsl_multifit_nlinear_trs_name(VALUE obj)
+{
+  return rb_str_new2(gsl_multifit_nlinear_trs_name(nlinear_get(obj)->w));
+}
+
+/* [nevalf, nevaldf, nevalfvv] */
+static VALUE rb_gsl_multifit_nlinear_neval(VALUE obj)
+{
+  mygsl_nlinear *s = nlinear_get(obj);
+  return rb_ary_new3(3, SIZET2NUM(s->fdf.nevalf), SIZET2NUM(s->fdf.nevaldf),
+		     SIZET2NUM(s->fdf.nevalfvv));
+}
+
+#ifdef HAVE_GSL_GSL_MULTILARGE_NLINEAR_H
+static VALUE cgsl_multilarge_nlinear;
+
+typedef struct {
+  gsl_multilarge_nlinear_workspace *w;
+  gsl_multilarge_nlinear_fdf fdf;
+  VALUE f, df, fvv, views;
+} mygsl_multilarge;
+
+static void mygsl_multilarge_mark(mygsl_multilarge *s)
+{
+  rb_gc_mark(s->f);
+  rb_gc_mark(s->df);
+  rb_gc_mark(s->fvv);
+  rb_gc_mark(s->views);
+}
+
+static void mygsl_multilarge_free(mygsl_multilarge *s)
+{
+  if (s->w) gsl_multilarge_nlinear_free(s->w);
+  xfree(s);
+}
+
+static mygsl_multilarge* multilarge_get(VALUE obj)
+{
+  mygsl_multilarge *s = NULL;
+  Data_Get_Struct(obj, mygsl_multilarge, s);
+  return s;
+}
+
+static mygsl_multilarge* multilarge_get_set(VALUE obj)
+{
+  mygsl_multilarge *s = multilarge_get(obj);
+  if (NIL_P(s->f)) rb_raise(rb_eRuntimeError, "no function set (see set)");
+  return s;
+}
+
+/* f.call(x, f) */
+static int multilarge_f(const gsl_vector *x, void *params, gsl_vector *f)
+{
+  mygsl_multilarge *s = (mygsl_multilarge *) params;
+  VALUE vx, vf;
+  gsl_vector xsaved, fsaved;
+  vx = rb_gsl_callback_vector(s->views, NLINEAR_VX, cgsl_vector_view_ro, x, &xsaved);
+  vf = rb_gsl_callback_vector(s->views, NLINEAR_VF, cgsl_vector_view, f, &fsaved);
+  rb_funcall(s->f, RBGSL_ID_call, 2, vx, vf);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
+  return GSL_SUCCESS;
+}
+
+/* df.call(trans, x, u, v, jtj), u, v and jtj possibly nil */
+static int multilarge_df(CBLAS_TRANSPOSE_t TransJ, const gsl_vector *x, const gsl_vector *u,
+			 void *params, gsl_vector *v, gsl_matrix *JTJ)
+{
+  mygsl_multilarge *s = (mygsl_multilarge *) params;
+  VALUE vx, vu = Qnil, vv = Qnil, vjtj = Qnil, vtrans;
+  gsl_vector xsaved, usaved, vsaved;
+  gsl_matrix jsaved;
+  vtrans = ID2SYM(rb_intern(TransJ == CblasTrans ? "trans" : "notrans"));
+  vx = rb_gsl_callback_vector(s->views, NLINEAR_VX, cgsl_vector_view_ro, x, &xsaved);
+  if (u) vu = rb_gsl_callback_vector(s->views, NLINEAR_VU, cgsl_vector_view_ro, u, &usaved);
+  if (v) vv = rb_gsl_callback_vector(s->views, NLINEAR_VV, cgsl_vector_view, v, &vsaved);
+  if (JTJ) vjtj = rb_gsl_callback_matrix(s->views, NLINEAR_VJTJ, cgsl_matrix_view, JTJ, &jsaved);
+  rb_funcall(s->df, RBGSL_ID_call, 5, vtrans, vx, vu, vv, vjtj);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  if (u) rb_gsl_callback_vector_restore(vu, &usaved);
+  if (v) rb_gsl_callback_vector_restore(vv, &vsaved);
+  if (JTJ) rb_gsl_callback_matrix_restore(vjtj, &jsaved);
+  return GSL_SUCCESS;
+}
+
+/* fvv.call(x, v, fvv) */
+static int multilarge_fvv(const gsl_vector *x, const gsl_vector *v, void *params,
+			  gsl_vector *fvv)
+{
+  mygsl_multilarge *s = (mygsl_multilarge *) params;
+  VALUE vx, vv, vf;
+  gsl_vector xsaved, vsaved, fsaved;
+  vx = rb_gsl_callback_vector(s->views, NLINEAR_VX, cgsl_vector_view_ro, x, &xsaved);
+  vv = rb_gsl_callback_vector(s->views, NLINEAR_VU, cgsl_vector_view_ro, v, &vsaved);
+  vf = rb_gsl_callback_vector(s->views, NLINEAR_VFVV, cgsl_vector_view, fvv, &fsaved);
+  rb_funcall(s->fvv, RBGSL_ID_call, 3, vx, vv, vf);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vv, &vsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_multilarge_nlinear_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_multilarge_nlinear_parameters lparams = gsl_multilarge_nlinear_default_parameters();
+  mygsl_multilarge *s = NULL;
+  VALUE obj, opts = Qnil, v;
+  const char *name;
+  size_t n, p;
+  if (argc != 2 && argc != 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  n = NUM2SIZET(argv[0]);
+  p = NUM2SIZET(argv[1]);
+  if (p == 0 || n < p) rb_raise(rb_eArgError, "%d observations for %d parameters", (int) n, (int) p);
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "trs"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "lm") == 0) lparams.trs = gsl_multilarge_nlinear_trs_lm;
+    else if (strcmp(name, "lmaccel") == 0) lparams.trs = gsl_multilarge_nlinear_trs_lmaccel;
+    else if (strcmp(name, "dogleg") == 0) lparams.trs = gsl_multilarge_nlinear_trs_dogleg;
+    else if (strcmp(name, "ddogleg") == 0) lparams.trs = gsl_multilarge_nlinear_trs_ddogleg;
+    else if (strcmp(name, "subspace2D") == 0) lparams.trs = gsl_multilarge_nlinear_trs_subspace2D;
+    else if (strcmp(name, "cgst") == 0) lparams.trs = gsl_multilarge_nlinear_trs_cgst;
+    else nlinear_unknown("trust region subproblem", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "scale"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "more") == 0) lparams.scale = gsl_multilarge_nlinear_scale_more;
+    else if (strcmp(name, "levenberg") == 0) lparams.scale = gsl_multilarge_nlinear_scale_levenberg;
+    else if (strcmp(name, "marquardt") == 0) lparams.scale = gsl_multilarge_nlinear_scale_marquardt;
+    else nlinear_unknown("scaling", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "solver"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "cholesky") == 0) lparams.solver = gsl_multilarge_nlinear_solver_cholesky;
+    else nlinear_unknown("solver", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "fdtype"))) {
+    name = nlinear_name(v);
+    if (strcmp(name, "forward") == 0) lparams.fdtype = GSL_MULTILARGE_NLINEAR_FWDIFF;
+    else if (strcmp(name, "central") == 0) lparams.fdtype = GSL_MULTILARGE_NLINEAR_CTRDIFF;
+    else nlinear_unknown("finite difference type", v);
+  }
+  if (!NIL_P(v = nlinear_opt(opts, "factor_up"))) lparams.factor_up = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "factor_down"))) lparams.factor_down = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "avmax"))) lparams.avmax = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "h_df"))) lparams.h_df = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "h_fvv"))) lparams.h_fvv = NUM2DBL(v);
+  if (!NIL_P(v = nlinear_opt(opts, "max_iter"))) lparams.max_iter = NUM2SIZET(v);
+  if (!NIL_P(v = nlinear_opt(opts, "tol"))) lparams.tol = NUM2DBL(v);
+  obj = Data_Make_Struct(klass, mygsl_multilarge, mygsl_multilarge_mark, mygsl_multilarge_free, s);
+  s->f = s->df = s->fvv = Qnil;
+  s->views = rb_ary_new2(NLINEAR_NVIEWS);
+  s->w = gsl_multilarge_nlinear_alloc(gsl_multilarge_nlinear_trust, &lparams, n, p);
+  if (s->w == NULL) rb_raise(rb_eNoMemError, "gsl_multilarge_nlinear_alloc failed");
+  return obj;
+}
+
+/* set(f, df, x[, opts]), opts :weights, :fvv */
+static VALUE rb_gsl_multilarge_nlinear_set(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_multilarge *s = multilarge_get(obj);
+  gsl_vector *x = NULL, *wts = NULL;
+  VALUE opts = Qnil, vw, fvv;
+  size_t n = s->w->f->size, p = s->w->x->size;
+  if (argc != 3 && argc != 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  if (!rb_respond_to(argv[0], RBGSL_ID_call) || !rb_respond_to(argv[1], RBGSL_ID_call))
+    rb_raise(rb_eTypeError, "f and df must be callable");
+  Data_Get_Vector(argv[2], x);
+  if (argc == 4) {
+    opts = argv[3];
+    Check_Type(opts, T_HASH);
+  }
+  vw = nlinear_opt(opts, "weights");
+  fvv = nlinear_opt(opts, "fvv");
+  if (!NIL_P(vw)) Data_Get_Vector(vw, wts);
+  if (x->size != p) rb_raise(rb_eArgError, "x of %d elements for %d parameters", (int) x->size, (int) p);
+  if (wts && wts->size != n) rb_raise(rb_eArgError, "%d weights for %d values", (int) wts->size, (int) n);
+  if (!NIL_P(fvv) && !rb_respond_to(fvv, RBGSL_ID_call))
+    rb_raise(rb_eTypeError, "fvv must be callable");
+  s->f = argv[0];
+  s->df = argv[1];
+  s->fvv = fvv;
+  s->fdf.f = multilarge_f;
+  s->fdf.df = multilarge_df;
+  s->fdf.fvv = NIL_P(fvv) ? NULL : multilarge_fvv;
+  s->fdf.n = n;
+  s->fdf.p = p;
+  s->fdf.params = s;
+  gsl_multilarge_nlinear_winit(x, wts, &s->fdf, s->w);
+  return obj;
+}
+
+static VALUE rb_gsl_multilarge_nlinear_iterate(VALUE obj)
+{
+  return INT2FIX(gsl_multilarge_nlinear_iterate(multilarge_get_set(obj)->w));
+}
+
+static void multilarge_callback(const size_t iter, void *params,
+				const gsl_multilarge_nlinear_workspace *w)
+{
+  rb_yield_values(2, SIZET2NUM(iter), (VALUE) params);
+}
+
+static VALUE rb_gsl_multilarge_nlinear_driver(VALUE obj, VALUE maxiter, VALUE xtol,
+					      VALUE gtol, VALUE ftol)
+{
+  mygsl_multilarge *s = multilarge_get_set(obj);
+  int status, info = 0;
+  status = gsl_multilarge_nlinear_driver(NUM2SIZET(maxiter), NUM2DBL(xtol), NUM2DBL(gtol),
+					 NUM2DBL(ftol), rb_block_given_p() ? multilarge_callback : NULL,
+					 (void *) obj, &info, s->w);
+  return rb_ary_new3(2, INT2FIX(status), INT2FIX(info));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_test(VALUE obj, VALUE xtol, VALUE gtol, VALUE ftol)
+{
+  mygsl_multilarge *s = multilarge_get_set(obj);
+  int status, info = 0;
+  status = gsl_multilarge_nlinear_test(NUM2DBL(xtol), NUM2DBL(gtol), NUM2DBL(ftol), &info, s->w);
+  return rb_ary_new3(2, INT2FIX(status), INT2FIX(info));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_position(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL,
+			  gsl_multilarge_nlinear_position(multilarge_get(obj)->w));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_residual(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL,
+			  gsl_multilarge_nlinear_residual(multilarge_get(obj)->w));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_step(VALUE obj)
+{
+  return Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL,
+			  gsl_multilarge_nlinear_step(multilarge_get(obj)->w));
+}
+
+/* (J^T J)^-1, from the J^T J of the last df call with jtj */
+static VALUE rb_gsl_multilarge_nlinear_covar(VALUE obj)
+{
+  mygsl_multilarge *s = multilarge_get_set(obj);
+  gsl_matrix *covar;
+  size_t p = s->w->x->size;
+  covar = gsl_matrix_alloc(p, p);
+  gsl_multilarge_nlinear_covar(covar, s->w);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, covar);
+}
+
+static VALUE rb_gsl_multilarge_nlinear_niter(VALUE obj)
+{
+  return SIZET2NUM(gsl_multilarge_nlinear_niter(multilarge_get(obj)->w));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_rcond(VALUE obj)
+{
+  double rcond;
+  gsl_multilarge_nlinear_rcond(&rcond, multilarge_get_set(obj)->w);
+  return rb_float_new(rcond);
+}
+
+static VALUE rb_gsl_multilarge_nlinear_avratio(VALUE obj)
+{
+  return rb_float_new(gsl_multilarge_nlinear_avratio(multilarge_get(obj)->w));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_name(VALUE obj)
+{
+  return rb_str_new2(gsl_multilarge_nlinear_name(multilarge_get(obj)->w));
+}
+
+static VALUE rb_gsl_multilarge_nlinear_trs_name(VALUE obj)
+{
+  return rb_str_new2(gsl_multilarge_nlinear_trs_name(multilarge_get(obj)->w));
+}
+
+/* [nevalf, nevaldfu, nevaldf2, nevalfvv] */
+static VALUE rb_gsl_multilarge_nlinear_neval(VALUE obj)
+{
+  mygsl_multilarge *s = multilarge_get(obj);
+  return rb_ary_new3(4, SIZET2NUM(s->fdf.nevalf), SIZET2NUM(s->fdf.nevaldfu),
+		     SIZET2NUM(s->fdf.nevaldf2), SIZET2NUM(s->fdf.nevalfvv));
+}
+#endif
+
+void Init_gsl_multifit_nlinear(VALUE module, VALUE mgsl_multifit)
+{
+#ifdef HAVE_GSL_GSL_MULTILARGE_NLINEAR_H
+  VALUE mgsl_multilarge;
+#endif
+  cgsl_multifit_nlinear = rb_define_class_under(mgsl_multifit, "Nlinear", cGSL_Object);
+  rb_define_singleton_method(cgsl_multifit_nlinear, "alloc", rb_gsl_multifit_nlinear_alloc, -1);
+  rb_define_singleton_method(cgsl_multifit_nlinear, "new", rb_gsl_multifit_nlinear_alloc, -1);
+  rb_define_method(cgsl_multifit_nlinear, "set", rb_gsl_multifit_nlinear_set, -1);
+  rb_define_method(cgsl_multifit_nlinear, "iterate", rb_gsl_multifit_nlinear_iterate, 0);
+  rb_define_method(cgsl_multifit_nlinear, "driver", rb_gsl_multifit_nlinear_driver, 4);
+  rb_define_method(cgsl_multifit_nlinear, "test", rb_gsl_multifit_nlinear_test, 3);
+  rb_define_method(cgsl_multifit_nlinear, "position", rb_gsl_multifit_nlinear_position, 0);
+  rb_define_alias(cgsl_multifit_nlinear, "x", "position");
+  rb_define_method(cgsl_multifit_nlinear, "residual", rb_gsl_multifit_nlinear_residual, 0);
+  rb_define_alias(cgsl_multifit_nlinear, "f", "residual");
+  rb_define_method(cgsl_multifit_nlinear, "jac", rb_gsl_multifit_nlinear_jac, 0);
+  rb_define_alias(cgsl_multifit_nlinear, "J", "jac");
+  rb_define_method(cgsl_multifit_nlinear, "covar", rb_gsl_multifit_nlinear_covar, 1);
+  rb_define_method(cgsl_multifit_nlinear, "niter", rb_gsl_multifit_nlinear_niter, 0);
+  rb_define_method(cgsl_multifit_nlinear, "rcond", rb_gsl_multifit_nlinear_rcond, 0);
+  rb_define_method(cgsl_multifit_nlinear, "avratio", rb_gsl_multifit_nlinear_avratio, 0);
+  rb_define_method(cgsl_multifit_nlinear, "name", rb_gsl_multifit_nlinear_name, 0);
+  rb_define_method(cgsl_multifit_nlinear, "trs_name", rb_gsl_multifit_nlinear_trs_name, 0);
+  rb_define_method(cgsl_multifit_nlinear, "neval", rb_gsl_multifit_nlinear_neval, 0);
+
+#ifdef HAVE_GSL_GSL_MULTILARGE_NLINEAR_H
+  mgsl_multilarge = rb_define_module_under(module, "MultiLarge");
+  cgsl_multilarge_nlinear = rb_define_class_under(mgsl_multilarge, "Nlinear", cGSL_Object);
+  rb_define_singleton_method(cgsl_multilarge_nlinear, "alloc", rb_gsl_multilarge_nlinear_alloc, -1);
+  rb_define_singleton_method(cgsl_multilarge_nlinear, "new", rb_gsl_multilarge_nlinear_alloc, -1);
+  rb_define_method(cgsl_multilarge_nlinear, "set", rb_gsl_multilarge_nlinear_set, -1);
+  rb_define_method(cgsl_multilarge_nlinear, "iterate", rb_gsl_multilarge_nlinear_iterate, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "driver", rb_gsl_multilarge_nlinear_driver, 4);
+  rb_define_method(cgsl_multilarge_nlinear, "test", rb_gsl_multilarge_nlinear_test, 3);
+  rb_define_method(cgsl_multilarge_nlinear, "position", rb_gsl_multilarge_nlinear_position, 0);
+  rb_define_alias(cgsl_multilarge_nlinear, "x", "position");
+  rb_define_method(cgsl_multilarge_nlinear, "residual", rb_gsl_multilarge_nlinear_residual, 0);
+  rb_define_alias(cgsl_multilarge_nlinear, "f", "residual");
+  rb_define_method(cgsl_multilarge_nlinear, "step", rb_gsl_multilarge_nlinear_step, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "covar", rb_gsl_multilarge_nlinear_covar, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "niter", rb_gsl_multilarge_nlinear_niter, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "rcond", rb_gsl_multilarge_nlinear_rcond, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "avratio", rb_gsl_multilarge_nlinear_avratio, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "name", rb_gsl_multilarge_nlinear_name, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "trs_name", rb_gsl_multilarge_nlinear_trs_name, 0);
+  rb_define_method(cgsl_multilarge_nlinear, "neval", rb_gsl_multilarge_nlinear_neval, 0);
+#endif
+}
+#endif
@@ -12,6 +12,7 @@
 #include "rb_gsl.h"
 #include "rb_gsl_array.h"
 #include "rb_gsl_function.h"
+#include "rb_gsl_probes.h"
 #include <gsl/gsl_multimin.h>
 
 #ifndef CHECK_MULTIMIN_FUNCTION
@@ -119,14 +120,40 @@ static VALUE rb_gsl_multimin_function_n(VALUE obj)
   return INT2FIX(F->n);
 }
 
+/*
+  F->params is an Array [proc, params, x view] for a Function, and
+  [f, df, fdf, params, x view, gradient view] for a Function_fdf.
+  The views passed to the procs are kept there and repointed at GSL's
+  vectors on each call (see rb_gsl_callback_vector).
+*/
+enum {
+  MULTIMIN_F_PROC = 0,
+  MULTIMIN_F_PARAMS,
+  MULTIMIN_F_VX,
+};
+
+enum {
+  MULTIMIN_FDF_F = 0,
+  MULTIMIN_FDF_DF,
+  MULTIMIN_FDF_FDF,
+  MULTIMIN_FDF_PARAMS,
+  MULTIMIN_FDF_VX,
+  MULTIMIN_FDF_VG,
+};
+
 static double rb_gsl_multimin_function_f(const gsl_vector *x, void *p)
 {
-  VALUE vx, vp, proc, result;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  proc = rb_ary_entry((VALUE) p, 0);
-  vp = rb_ary_entry((VALUE) p, 1);
+  VALUE ary, vx, vp, proc, result;
+  gsl_vector xsaved;
+  ary = (VALUE) p;
+  proc = rb_ary_entry(ary, MULTIMIN_F_PROC);
+  vp = rb_ary_entry(ary, MULTIMIN_F_PARAMS);
+  vx = rb_gsl_callback_vector(ary, MULTIMIN_F_VX, cgsl_vector_view_ro, x, &xsaved);
+  RB_GSL_CALLBACK_ENTRY("multimin_f", x->size);
   if (NIL_P(vp)) result = rb_funcall(proc, RBGSL_ID_call, 1, vx);
   else result = rb_funcall(proc, RBGSL_ID_call, 2, vx, vp);
+  RB_GSL_CALLBACK_RETURN("multimin_f", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
   return NUM2DBL(result);
 }
 
@@ -375,41 +402,86 @@ static VALUE rb_gsl_multimin_function_fdf_set(int argc, VALUE *argv, VALUE obj)
 double rb_gsl_multimin_function_fdf_f(const gsl_vector *x, void *p)
 {
   VALUE vx, proc, vp, result, ary;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
+  gsl_vector xsaved;
   ary = (VALUE) p;
-  proc = rb_ary_entry(ary, 0);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
+  proc = rb_ary_entry(ary, MULTIMIN_FDF_F);
+  vp = rb_ary_entry(ary, MULTIMIN_FDF_PARAMS);
+  vx = rb_gsl_callback_vector(ary, MULTIMIN_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  RB_GSL_CALLBACK_ENTRY("multimin_f", x->size);
   if (NIL_P(vp)) result = rb_funcall(proc, RBGSL_ID_call, 1, vx);
   else result = rb_funcall(proc, RBGSL_ID_call, 2, vx, vp);
+  RB_GSL_CALLBACK_RETURN("multimin_f", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
   return NUM2DBL(result);
 }
 
+/*
+  A GSL::Diff::Jacobian given as df: the gradient by finite differences
+  of f, with the batch callable (if any) called as batch(X[, params])
+*/
+static int multimin_fdiff_f(const gsl_vector *x, void *p, gsl_vector *f)
+{
+  gsl_vector_set(f, 0, rb_gsl_multimin_function_fdf_f(x, p));
+  return GSL_SUCCESS;
+}
+
+static void multimin_fdiff_gradient(VALUE fd, VALUE ary, const gsl_vector *x,
+				    const double *f, gsl_vector *g)
+{
+  gsl_vector_const_view fx;
+  gsl_matrix_view J;
+  VALUE vp;
+  /* the minimizers allocate their gradients contiguous */
+  if (g->stride != 1) rb_raise(rb_eRuntimeError, "non-contiguous gradient");
+  vp = rb_ary_entry(ary, MULTIMIN_FDF_PARAMS);
+  if (f) fx = gsl_vector_const_view_array(f, 1);
+  J = gsl_matrix_view_array(g->data, 1, g->size);
+  rb_gsl_fdiff_jacobian(fd, multimin_fdiff_f, (void *) ary, NIL_P(vp) ? 0 : 1, &vp,
+			x, f ? &fx.vector : NULL, &J.matrix);
+}
+
 void rb_gsl_multimin_function_fdf_df(const gsl_vector *x, void *p, 
 				     gsl_vector *g)
 {
   VALUE vx, vg, proc, vp, ary;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vg = Data_Wrap_Struct(cgsl_vector, 0, NULL, g);
+  gsl_vector xsaved, gsaved;
   ary = (VALUE) p;
-  proc = rb_ary_entry(ary, 1);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
+  proc = rb_ary_entry(ary, MULTIMIN_FDF_DF);
+  if (rb_obj_is_kind_of(proc, cgsl_diff_jacobian)) {
+    multimin_fdiff_gradient(proc, ary, x, NULL, g);
+    return;
+  }
+  vp = rb_ary_entry(ary, MULTIMIN_FDF_PARAMS);
+  vx = rb_gsl_callback_vector(ary, MULTIMIN_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vg = rb_gsl_callback_vector(ary, MULTIMIN_FDF_VG, cgsl_vector_view, g, &gsaved);
+  RB_GSL_CALLBACK_ENTRY("multimin_df", x->size);
   if (NIL_P(vp)) {
     rb_funcall(proc, RBGSL_ID_call, 2, vx, vg);
   } else {
     rb_funcall(proc, RBGSL_ID_call, 3, vx, vp, vg);
   }
+  RB_GSL_CALLBACK_RETURN("multimin_df", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vg, &gsaved);
 }
 
 void rb_gsl_multimin_function_fdf_fdf(const gsl_vector *x, void *p, 
 				      double *f, gsl_vector *g)
 {
   VALUE vx, vg, proc_f, proc_df, vp, ary, result;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vg = Data_Wrap_Struct(cgsl_vector, 0, NULL, g);
+  gsl_vector xsaved, gsaved;
   ary = (VALUE) p;
-  proc_f = rb_ary_entry(ary, 0);
-  proc_df = rb_ary_entry(ary, 1);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
+  proc_f = rb_ary_entry(ary, MULTIMIN_FDF_F);
+  proc_df = rb_ary_entry(ary, MULTIMIN_FDF_DF);
+  if (rb_obj_is_kind_of(proc_df, cgsl_diff_jacobian)) {
+    *f = rb_gsl_multimin_function_fdf_f(x, p);
+    multimin_fdiff_gradient(proc_df, ary, x, f, g);
+    return;
+  }
+  vp = rb_ary_entry(ary, MULTIMIN_FDF_PARAMS);
+  vx = rb_gsl_callback_vector(ary, MULTIMIN_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vg = rb_gsl_callback_vector(ary, MULTIMIN_FDF_VG, cgsl_vector_view, g, &gsaved);
+  RB_GSL_CALLBACK_ENTRY("multimin_fdf", x->size);
   if (NIL_P(vp)) {
     result = rb_funcall(proc_f, RBGSL_ID_call, 1, vx);
     rb_funcall(proc_df, RBGSL_ID_call, 2, vx, vg);
@@ -417,6 +489,9 @@ void rb_gsl_multimin_function_fdf_fdf(const gsl_vector *x, void *p,
     result = rb_funcall(proc_f, RBGSL_ID_call, 2, vx, vp);
     rb_funcall(proc_df, RBGSL_ID_call, 3, vx, vp, vg);
   }
+  RB_GSL_CALLBACK_RETURN("multimin_fdf", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vg, &gsaved);
   *f = NUM2DBL(result);
 }
 
@@ -499,6 +574,12 @@ static const gsl_multimin_fdfminimizer_type* get_fdfminimizer_type(VALUE t)
   }
 }
 
+/* Used also in multimin_multistart.c */
+const gsl_multimin_fdfminimizer_type* rb_gsl_multimin_fdfminimizer_type(VALUE t)
+{
+  return get_fdfminimizer_type(t);
+}
+
 static VALUE rb_gsl_fdfminimizer_new(VALUE klass, VALUE t, VALUE n)
 {
   gsl_multimin_fdfminimizer *gmf = NULL;
@@ -725,6 +806,7 @@ static VALUE rb_gsl_multimin_test_size(VALUE obj, VALUE ss, VALUE ea)
 #ifdef HAVE_GSL_GSL_MULTIMIN_FSDF_H
 void Init_multimin_fsdf(VALUE module);
 #endif
+void Init_gsl_multimin_multistart(VALUE mgsl_multimin);
 
 /*****/
 void Init_gsl_multimin(VALUE module)
@@ -796,6 +878,7 @@ void Init_gsl_multimin(VALUE module)
 #ifdef HAVE_GSL_GSL_MULTIMIN_FSDF_H
 	Init_multimin_fsdf(mgsl_multimin);
 #endif
+  Init_gsl_multimin_multistart(mgsl_multimin);
 }
 #ifdef CHECK_MULTIMIN_FUNCTION
 #undef CHECK_MULTIMIN_FUNCTION
@@ -0,0 +1,335 @@
+/*
+  multimin_multistart.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Multi-start minimization: a gradient minimizer run from many starting
+  points spread over a box, the local minima returned ranked.
+
+    x, f, status, iter = GSL::MultiMin.multistart("x[0]**4 - 3*x[0]**2 + x[0] + x[1]**2",
+                                                  [-2, -2], [2, 2], :starts => 500)
+    xmin = x.row(0)                             # the best minimum, f[0]
+
+  The function is an expression in x[0] ... x[n-1] compiled with the
+  parameters :params (see GSL::Function.compile), its gradient given
+  exactly by dual numbers; the starts are then minimized without the
+  GVL, split over GSL.parallel_threads, each thread with its own
+  minimizer. A GSL::MultiMin::Function_fdf is minimized from the starts
+  in turn with the GVL held.
+
+  The starting points are the :starts (100) first points of the
+  quasi-random GSL::QRng :qrng (Sobol, or Halton above 40 dimensions)
+  scaled to [lower, upper], or the rows of the Matrix :points.
+
+  Options :type (the minimizer, "vector_bfgs2"), :step_size (0.01),
+  :tol (0.1) as for FdfMinimizer#set, :epsabs (1e-6) for
+  MultiMin.test_gradient and :max_iter (200) iterations per start.
+  With :target, no more starts are minimized once a minimum
+  f <= target is found; the starts then run depend on the threads.
+
+  Returns the Matrix of the minima (one per row, from the lowest f up),
+  the Vector of their values, and GSL::Vector::Int of the statuses
+  (GSL::SUCCESS, GSL::EMAXITER, GSL::ENOPROG ...) and iteration counts.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_function.h"
+#include <gsl/gsl_multimin.h>
+#include <gsl/gsl_qrng.h>
+
+const gsl_multimin_fdfminimizer_type* rb_gsl_multimin_fdfminimizer_type(VALUE t);
+extern VALUE cgsl_multimin_function_fdf;
+
+typedef struct {
+  size_t n, dim, nthreads, max_iter;
+  double *x0, *x, *f;           /* n x dim starting points and minima */
+  int *status, *iter;
+  char *done;
+  gsl_multimin_fdfminimizer **s;
+  gsl_multimin_function_fdf F;
+  double step_size, tol, epsabs, target;
+  int has_target;
+  volatile int stop;
+  VALUE func;
+} mygsl_mstart;
+
+static void mygsl_mstart_mark(mygsl_mstart *w)
+{
+  rb_gc_mark(w->func);
+}
+
+static void mygsl_mstart_free(mygsl_mstart *w)
+{
+  size_t i;
+  if (w->s) {
+    for (i = 0; i < w->nthreads; i++)
+      if (w->s[i]) gsl_multimin_fdfminimizer_free(w->s[i]);
+    xfree(w->s);
+  }
+  if (w->x0) xfree(w->x0);
+  if (w->x) xfree(w->x);
+  if (w->f) xfree(w->f);
+  if (w->status) xfree(w->status);
+  if (w->iter) xfree(w->iter);
+  if (w->done) xfree(w->done);
+  xfree(w);
+}
+
+/*
+  A compiled function: GSL's minimizers evaluate at their own vectors,
+  which are contiguous
+*/
+static double mstart_f(const gsl_vector *x, void *p)
+{
+  return rb_gsl_function_compiled_eval_multi(p, x->data);
+}
+
+static void mstart_df(const gsl_vector *x, void *p, gsl_vector *g)
+{
+  rb_gsl_function_compiled_eval_grad(p, x->data, NULL, g->data);
+}
+
+static void mstart_fdf(const gsl_vector *x, void *p, double *f, gsl_vector *g)
+{
+  *f = rb_gsl_function_compiled_eval_grad(p, x->data, NULL, g->data);
+}
+
+/* Minimizes from the start i; leaves it undone if stopped meanwhile */
+static void mstart_run(mygsl_mstart *w, gsl_multimin_fdfminimizer *s, size_t i)
+{
+  gsl_vector_view x0 = gsl_vector_view_array(w->x0 + i*w->dim, w->dim);
+  double *x = w->x + i*w->dim;
+  size_t iter = 0;
+  int status, e;
+  status = gsl_multimin_fdfminimizer_set(s, &w->F, &x0.vector, w->step_size, w->tol);
+  if (status == GSL_SUCCESS) {
+    status = GSL_CONTINUE;
+    while (status == GSL_CONTINUE && iter < w->max_iter) {
+      if (w->stop) return;
+      iter++;
+      if ((e = gsl_multimin_fdfminimizer_iterate(s)) != GSL_SUCCESS) {
+	status = e;
+	break;
+      }
+      status = gsl_multimin_test_gradient(s->gradient, w->epsabs);
+      if (w->has_target && s->f <= w->target) break;
+    }
+    if (status == GSL_CONTINUE && iter == w->max_iter) status = GSL_EMAXITER;
+    memcpy(x, s->x->data, sizeof(double)*w->dim);
+    w->f[i] = s->f;
+  } else {
+    memcpy(x, x0.vector.data, sizeof(double)*w->dim);
+    w->f[i] = GSL_NAN;
+  }
+  if ((e = rb_gsl_error_take()) != GSL_SUCCESS && status == GSL_SUCCESS) status = e;
+  w->status[i] = status;
+  w->iter[i] = (int) iter;
+  w->done[i] = 1;
+  if (w->has_target && w->f[i] <= w->target) w->stop = 1;
+}
+
+static int mstart_worker(void *data, size_t id)
+{
+  mygsl_mstart *w = (mygsl_mstart *) data;
+  size_t i;
+  for (i = id; i < w->n && !w->stop; i += w->nthreads) mstart_run(w, w->s[id], i);
+  return GSL_SUCCESS;
+}
+
+/* The starting points, scaled to [lower, upper] */
+static void mstart_points(mygsl_mstart *w, const double *lo, const double *hi, VALUE vq)
+{
+  gsl_qrng *q = NULL;
+  const gsl_qrng_type *T;
+  size_t i, j;
+  double *u;
+  if (NIL_P(vq)) {
+#ifdef GSL_1_11_LATER
+    T = w->dim <= 40 ? gsl_qrng_sobol : gsl_qrng_halton;
+#else
+    T = gsl_qrng_sobol;
+#endif
+    q = gsl_qrng_alloc(T, w->dim);
+    if (q == NULL) rb_raise(rb_eArgError, "no quasi-random sequence of %d dimensions", (int) w->dim);
+  } else {
+    if (!rb_obj_is_kind_of(vq, rb_path2class("GSL::QRng")))
+      rb_raise(rb_eTypeError, "wrong argument type %s (GSL::QRng expected)",
+	       rb_class2name(CLASS_OF(vq)));
+    Data_Get_Struct(vq, gsl_qrng, q);
+    if (q->dimension != w->dim)
+      rb_raise(rb_eArgError, "QRng of %d dimensions for a function of %d",
+	       (int) q->dimension, (int) w->dim);
+  }
+  for (i = 0; i < w->n; i++) {
+    u = w->x0 + i*w->dim;
+    gsl_qrng_get(q, u);
+    for (j = 0; j < w->dim; j++) u[j] = lo[j] + (hi[j] - lo[j])*u[j];
+  }
+  if (NIL_P(vq)) gsl_qrng_free(q);
+}
+
+typedef struct {
+  double f;
+  size_t i;
+} mstart_rank;
+
+static int mstart_rank_cmp(const void *a, const void *b)
+{
+  const mstart_rank *ra = (const mstart_rank *) a, *rb = (const mstart_rank *) b;
+  if (gsl_isnan(ra->f) != gsl_isnan(rb->f)) return gsl_isnan(ra->f) ? 1 : -1;
+  if (ra->f < rb->f) return -1;
+  if (ra->f > rb->f) return 1;
+  return ra->i < rb->i ? -1 : (ra->i > rb->i);
+}
+
+static VALUE mstart_results(mygsl_mstart *w)
+{
+  mstart_rank *r;
+  gsl_matrix *x;
+  gsl_vector *f;
+  gsl_vector_int *status, *iter;
+  size_t i, k, m = 0;
+  r = ALLOC_N(mstart_rank, w->n);
+  for (i = 0; i < w->n; i++) {
+    if (!w->done[i]) continue;
+    r[m].f = w->f[i];
+    r[m++].i = i;
+  }
+  /* m > 0: the runs only stop once one is done */
+  qsort(r, m, sizeof(mstart_rank), mstart_rank_cmp);
+  x = gsl_matrix_alloc(m, w->dim);
+  f = gsl_vector_alloc(m);
+  status = gsl_vector_int_alloc(m);
+  iter = gsl_vector_int_alloc(m);
+  for (k = 0; k < m; k++) {
+    i = r[k].i;
+    memcpy(x->data + k*x->tda, w->x + i*w->dim, sizeof(double)*w->dim);
+    f->data[k] = w->f[i];
+    status->data[k] = w->status[i];
+    iter->data[k] = w->iter[i];
+  }
+  xfree(r);
+  return rb_ary_new3(4, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, x),
+		     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, f),
+		     Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, status),
+		     Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, iter));
+}
+
+/* GSL::MultiMin.multistart(f, lower, upper[, opts]) */
+static VALUE rb_gsl_multimin_multistart(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_mstart *w = NULL;
+  gsl_multimin_function_fdf *F = NULL;
+  gsl_vector *lo, *hi;
+  gsl_matrix *pts = NULL;
+  const gsl_multimin_fdfminimizer_type *T;
+  VALUE obj, opts = Qnil, v, vq = Qnil, vparams = Qnil, vtype = Qnil, vlo, vhi;
+  size_t i, j, nthreads = 1;
+  int compiled;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  obj = Data_Make_Struct(0, mygsl_mstart, mygsl_mstart_mark, mygsl_mstart_free, w);
+  w->func = argv[0];
+  vlo = argv[1];
+  vhi = argv[2];
+  lo = get_vector(vlo);
+  vlo = Data_Wrap_Struct(cgsl_vector, 0, VECTOR_P(argv[1]) ? NULL : gsl_vector_free, lo);
+  hi = get_vector(vhi);
+  vhi = Data_Wrap_Struct(cgsl_vector, 0, VECTOR_P(argv[2]) ? NULL : gsl_vector_free, hi);
+  w->dim = lo->size;
+  if (w->dim == 0 || hi->size != w->dim)
+    rb_raise(rb_eArgError, "bounds of %d and %d elements", (int) lo->size, (int) hi->size);
+  w->n = 100;
+  w->step_size = 0.01;
+  w->tol = 0.1;
+  w->epsabs = 1e-6;
+  w->max_iter = 200;
+  if (argc == 4) {
+    opts = argv[3];
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("starts"))))) w->n = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("step_size"))))) w->step_size = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("tol"))))) w->tol = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsabs"))))) w->epsabs = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_iter"))))) w->max_iter = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("target"))))) {
+      w->target = NUM2DBL(v);
+      w->has_target = 1;
+    }
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("points"))))) {
+      CHECK_MATRIX(v);
+      Data_Get_Struct(v, gsl_matrix, pts);
+      if (pts->size2 != w->dim)
+	rb_raise(rb_eArgError, "points of %d coordinates for a function of %d",
+		 (int) pts->size2, (int) w->dim);
+      w->n = pts->size1;
+    }
+    vq = rb_hash_aref(opts, ID2SYM(rb_intern("qrng")));
+    vparams = rb_hash_aref(opts, ID2SYM(rb_intern("params")));
+    vtype = rb_hash_aref(opts, ID2SYM(rb_intern("type")));
+  }
+  if (w->n == 0) rb_raise(rb_eArgError, "no starting points");
+  if (w->max_iter == 0) rb_raise(rb_eArgError, "max_iter must be positive");
+#ifdef GSL_1_9_LATER
+  T = rb_gsl_multimin_fdfminimizer_type(NIL_P(vtype) ? rb_str_new2("vector_bfgs2") : vtype);
+#else
+  T = rb_gsl_multimin_fdfminimizer_type(NIL_P(vtype) ? rb_str_new2("vector_bfgs") : vtype);
+#endif
+  compiled = TYPE(w->func) == T_STRING;
+  if (compiled) {
+    w->func = rb_gsl_function_compile_multi(w->func, vparams, w->dim);
+    w->F.f = &mstart_f;
+    w->F.df = &mstart_df;
+    w->F.fdf = &mstart_fdf;
+    w->F.n = w->dim;
+    w->F.params = rb_gsl_function_compiled_ptr(w->func);
+  } else if (rb_obj_is_kind_of(w->func, cgsl_multimin_function_fdf)) {
+    if (!NIL_P(vparams)) rb_raise(rb_eArgError, "params are for compiled functions");
+    Data_Get_Struct(w->func, gsl_multimin_function_fdf, F);
+    if (F->n != w->dim)
+      rb_raise(rb_eArgError, "bounds of %d elements for a function of %d",
+	       (int) w->dim, (int) F->n);
+    w->F = *F;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (String or MultiMin::Function_fdf expected)",
+	     rb_class2name(CLASS_OF(w->func)));
+  }
+  w->x0 = ALLOC_N(double, w->n*w->dim);
+  w->x = ALLOC_N(double, w->n*w->dim);
+  w->f = ALLOC_N(double, w->n);
+  w->status = ALLOC_N(int, w->n);
+  w->iter = ALLOC_N(int, w->n);
+  w->done = ALLOC_N(char, w->n);
+  memset(w->done, 0, w->n);
+  if (pts) {
+    for (i = 0; i < w->n; i++)
+      for (j = 0; j < w->dim; j++) w->x0[i*w->dim + j] = gsl_matrix_get(pts, i, j);
+  } else {
+    mstart_points(w, lo->data, hi->data, vq);
+  }
+  if (compiled) nthreads = rb_gsl_parallel_nthreads(w->n*w->max_iter*w->dim, w->n);
+  w->s = ALLOC_N(gsl_multimin_fdfminimizer *, nthreads);
+  memset(w->s, 0, sizeof(gsl_multimin_fdfminimizer *)*nthreads);
+  w->nthreads = nthreads;
+  for (i = 0; i < nthreads; i++) w->s[i] = gsl_multimin_fdfminimizer_alloc(T, w->dim);
+  if (compiled) rb_gsl_nogvl_parallel(mstart_worker, w, nthreads);
+  else mstart_worker(w, 0);
+  v = mstart_results(w);
+  RB_GC_GUARD(obj);
+  RB_GC_GUARD(vlo);
+  RB_GC_GUARD(vhi);
+  return v;
+}
+
+void Init_gsl_multimin_multistart(VALUE mgsl_multimin)
+{
+  rb_define_module_function(mgsl_multimin, "multistart", rb_gsl_multimin_multistart, -1);
+}
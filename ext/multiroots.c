@@ -12,6 +12,7 @@
 #include "rb_gsl_common.h"
 #include "rb_gsl_array.h"
 #include "rb_gsl_function.h"
+#include "rb_gsl_probes.h"
 #include <gsl/gsl_multiroots.h>
 
 #ifndef CHECK_MULTIROOT_FUNCTION
@@ -103,16 +104,45 @@ static void gsl_multiroot_function_mark(gsl_multiroot_function *f)
     rb_gc_mark(rb_ary_entry((VALUE) f->params, i));
 }
 
+/*
+  F->params is an Array [proc, params, x view, f view] for a Function,
+  and [f, df, fdf, params, x view, f view, J view] for a Function_fdf.
+  The views passed to the procs are kept there and repointed at GSL's
+  vectors and matrices on each call (see rb_gsl_callback_vector).
+*/
+enum {
+  MULTIROOT_F_PROC = 0,
+  MULTIROOT_F_PARAMS,
+  MULTIROOT_F_VX,
+  MULTIROOT_F_VF,
+};
+
+enum {
+  MULTIROOT_FDF_F = 0,
+  MULTIROOT_FDF_DF,
+  MULTIROOT_FDF_FDF,
+  MULTIROOT_FDF_PARAMS,
+  MULTIROOT_FDF_VX,
+  MULTIROOT_FDF_VF,
+  MULTIROOT_FDF_VJ,
+};
+
 static int rb_gsl_multiroot_function_f(const gsl_vector *x, void *p, gsl_vector *f)
 {
-  VALUE vx, vf;
+  VALUE vx, vf, ary;
   VALUE vp, proc;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vf = Data_Wrap_Struct(cgsl_vector, 0, NULL, f);
-  proc = rb_ary_entry((VALUE) p, 0);
-  vp = rb_ary_entry((VALUE) p, 1);
+  gsl_vector xsaved, fsaved;
+  ary = (VALUE) p;
+  proc = rb_ary_entry(ary, MULTIROOT_F_PROC);
+  vp = rb_ary_entry(ary, MULTIROOT_F_PARAMS);
+  vx = rb_gsl_callback_vector(ary, MULTIROOT_F_VX, cgsl_vector_view_ro, x, &xsaved);
+  vf = rb_gsl_callback_vector(ary, MULTIROOT_F_VF, cgsl_vector_view, f, &fsaved);
+  RB_GSL_CALLBACK_ENTRY("multiroot_f", x->size);
   if (NIL_P(vp)) rb_funcall(proc, RBGSL_ID_call, 2, vx, vf);
   else rb_funcall(proc, RBGSL_ID_call, 3, vx, vp, vf);
+  RB_GSL_CALLBACK_RETURN("multiroot_f", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
   return GSL_SUCCESS;
 }
 
@@ -336,18 +366,51 @@ static VALUE rb_gsl_multiroot_function_fdf_set(int argc, VALUE *argv, VALUE obj)
   return obj;
 }
 
+/*
+  f as an Array of GSL::Function::Compiled in x[0] ... x[n-1] (see
+  Function_fdf.compile): f, and the rows of J by dual numbers, in C
+*/
+static int multiroot_compiled_fdf(VALUE fs, const gsl_vector *x, gsl_vector *f,
+				  gsl_matrix *J)
+{
+  VALUE vtmp = 0;
+  const double *xp = x->data;
+  double *xc, v;
+  void *c;
+  size_t i;
+  if (x->stride != 1) {
+    xc = ALLOCV_N(double, vtmp, x->size);
+    for (i = 0; i < x->size; i++) xc[i] = gsl_vector_get(x, i);
+    xp = xc;
+  }
+  for (i = 0; i < (size_t) RARRAY_LEN(fs); i++) {
+    c = rb_gsl_function_compiled_ptr(rb_ary_entry(fs, i));
+    if (J) v = rb_gsl_function_compiled_eval_grad(c, xp, NULL, J->data + i*J->tda);
+    else v = rb_gsl_function_compiled_eval_multi(c, xp);
+    if (f) gsl_vector_set(f, i, v);
+  }
+  if (vtmp) ALLOCV_END(vtmp);
+  return GSL_SUCCESS;
+}
+
 static int rb_gsl_multiroot_function_fdf_f(const gsl_vector *x, void *p, 
 					   gsl_vector *f)
 {
   VALUE vx, vf, ary;
   VALUE proc, vp;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vf = Data_Wrap_Struct(cgsl_vector, 0, NULL, f);
+  gsl_vector xsaved, fsaved;
   ary = (VALUE) p;
-  proc = rb_ary_entry(ary, 0);
-  vp = rb_ary_entry(ary, 3);
+  proc = rb_ary_entry(ary, MULTIROOT_FDF_F);
+  if (TYPE(proc) == T_ARRAY) return multiroot_compiled_fdf(proc, x, f, NULL);
+  vp = rb_ary_entry(ary, MULTIROOT_FDF_PARAMS);
+  vx = rb_gsl_callback_vector(ary, MULTIROOT_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vf = rb_gsl_callback_vector(ary, MULTIROOT_FDF_VF, cgsl_vector_view, f, &fsaved);
+  RB_GSL_CALLBACK_ENTRY("multiroot_f", x->size);
   if (NIL_P(vp)) rb_funcall(proc, RBGSL_ID_call, 2, vx, vf);
   else rb_funcall(proc, RBGSL_ID_call, 3, vx, vp, vf);
+  RB_GSL_CALLBACK_RETURN("multiroot_f", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
   return GSL_SUCCESS;
 }
 
@@ -356,13 +419,24 @@ static int rb_gsl_multiroot_function_fdf_df(const gsl_vector *x, void *p,
 {
   VALUE vx, vJ, ary;
   VALUE proc, vp;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vJ = Data_Wrap_Struct(cgsl_matrix, 0, NULL, J);
+  gsl_vector xsaved;
+  gsl_matrix Jsaved;
   ary = (VALUE) p;
-  proc = rb_ary_entry(ary, 1);
-  vp = rb_ary_entry(ary, 3);
+  proc = rb_ary_entry(ary, MULTIROOT_FDF_DF);
+  vp = rb_ary_entry(ary, MULTIROOT_FDF_PARAMS);
+  if (NIL_P(proc) && TYPE(rb_ary_entry(ary, MULTIROOT_FDF_F)) == T_ARRAY)
+    return multiroot_compiled_fdf(rb_ary_entry(ary, MULTIROOT_FDF_F), x, NULL, J);
+  if (rb_obj_is_kind_of(proc, cgsl_diff_jacobian))
+    return rb_gsl_fdiff_jacobian(proc, rb_gsl_multiroot_function_fdf_f, p,
+				 NIL_P(vp) ? 0 : 1, &vp, x, NULL, J);
+  vx = rb_gsl_callback_vector(ary, MULTIROOT_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vJ = rb_gsl_callback_matrix(ary, MULTIROOT_FDF_VJ, cgsl_matrix_view, J, &Jsaved);
+  RB_GSL_CALLBACK_ENTRY("multiroot_df", x->size);
   if (NIL_P(vp)) rb_funcall(proc, RBGSL_ID_call, 2, vx, vJ);
   else rb_funcall(proc, RBGSL_ID_call, 3, vx, vp, vJ);
+  RB_GSL_CALLBACK_RETURN("multiroot_df", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_matrix_restore(vJ, &Jsaved);
   return GSL_SUCCESS;
 }
 
@@ -371,14 +445,24 @@ static int rb_gsl_multiroot_function_fdf_fdf(const gsl_vector *x, void *p,
 {
   VALUE vx, vf, vJ, ary;
   VALUE proc_f, proc_df, proc_fdf, vp;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vf = Data_Wrap_Struct(cgsl_vector, 0, NULL, f);
-  vJ = Data_Wrap_Struct(cgsl_matrix, 0, NULL, J);
+  gsl_vector xsaved, fsaved;
+  gsl_matrix Jsaved;
   ary = (VALUE) p;
-  proc_f = rb_ary_entry(ary, 0);
-  proc_df = rb_ary_entry(ary, 1);
-  proc_fdf = rb_ary_entry(ary, 2);
-  vp = rb_ary_entry(ary, 3);
+  proc_f = rb_ary_entry(ary, MULTIROOT_FDF_F);
+  proc_df = rb_ary_entry(ary, MULTIROOT_FDF_DF);
+  proc_fdf = rb_ary_entry(ary, MULTIROOT_FDF_FDF);
+  vp = rb_ary_entry(ary, MULTIROOT_FDF_PARAMS);
+  if (NIL_P(proc_fdf) && NIL_P(proc_df) && TYPE(proc_f) == T_ARRAY)
+    return multiroot_compiled_fdf(proc_f, x, f, J);
+  if (NIL_P(proc_fdf) && rb_obj_is_kind_of(proc_df, cgsl_diff_jacobian)) {
+    rb_gsl_multiroot_function_fdf_f(x, p, f);
+    return rb_gsl_fdiff_jacobian(proc_df, rb_gsl_multiroot_function_fdf_f, p,
+				 NIL_P(vp) ? 0 : 1, &vp, x, f, J);
+  }
+  vx = rb_gsl_callback_vector(ary, MULTIROOT_FDF_VX, cgsl_vector_view_ro, x, &xsaved);
+  vf = rb_gsl_callback_vector(ary, MULTIROOT_FDF_VF, cgsl_vector_view, f, &fsaved);
+  vJ = rb_gsl_callback_matrix(ary, MULTIROOT_FDF_VJ, cgsl_matrix_view, J, &Jsaved);
+  RB_GSL_CALLBACK_ENTRY("multiroot_fdf", x->size);
   if (NIL_P(proc_fdf)) {
     if (NIL_P(vp)) {
       rb_funcall(proc_f, RBGSL_ID_call, 2, vx, vf);
@@ -391,6 +475,10 @@ static int rb_gsl_multiroot_function_fdf_fdf(const gsl_vector *x, void *p,
     if (NIL_P(vp)) rb_funcall(proc_fdf, RBGSL_ID_call, 3, vx,  vf, vJ);
     else rb_funcall(proc_fdf, RBGSL_ID_call, 4, vx, vp, vf, vJ);
   }
+  RB_GSL_CALLBACK_RETURN("multiroot_fdf", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vf, &fsaved);
+  rb_gsl_callback_matrix_restore(vJ, &Jsaved);
   return GSL_SUCCESS;
 }
 
@@ -408,6 +496,334 @@ static VALUE rb_gsl_multiroot_function_fdf_n(VALUE obj)
   return INT2FIX(F->n);
 }
 
+/*
+  GSL::MultiRoot::Function_fdf.compile(exprs, params = {})
+
+    f = GSL::MultiRoot::Function_fdf.compile(["a*(1 - x[0])",
+                                              "b*(x[1] - x[0]**2)"],
+                                             "a" => 1, "b" => 10)
+
+  The n expressions of exprs, in x[0] ... x[n-1] and the parameters
+  (see GSL::Function.compile), are the components of f; f and its
+  Jacobian are evaluated in C, the Jacobian exactly with dual numbers.
+*/
+static VALUE rb_gsl_multiroot_function_fdf_compile(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE exprs, fs, args[3];
+  size_t i;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  exprs = argv[0];
+  Check_Type(exprs, T_ARRAY);
+  if (RARRAY_LEN(exprs) == 0) rb_raise(rb_eArgError, "no expressions");
+  fs = rb_ary_new2(RARRAY_LEN(exprs));
+  for (i = 0; i < (size_t) RARRAY_LEN(exprs); i++)
+    rb_ary_store(fs, i, rb_gsl_function_compile_multi(rb_ary_entry(exprs, i),
+						     argc == 2 ? argv[1] : Qnil,
+						     RARRAY_LEN(exprs)));
+  args[0] = fs;
+  args[1] = Qnil;
+  args[2] = INT2FIX(RARRAY_LEN(exprs));
+  return rb_gsl_multiroot_function_fdf_new(3, args, klass);
+}
+
+/*
+  GSL::MultiRoot.solve_batch(f, x0, p = nil, opts = {})
+
+    f = GSL::MultiRoot::Function_fdf.compile(["x[0]**2 + x[1]**2 - r",
+                                              "x[0] - a*x[1]"], "r" => 1, "a" => 1)
+    x, status, iter = GSL::MultiRoot.solve_batch(f, x0, p)
+
+  Solves m independent systems of n equations at once: row s of the
+  (m x n) Matrix x0 is the initial guess of system s, and row s of the
+  (m x np) Matrix p its parameters.  Each system takes damped Newton
+  steps, halved until the sum of squares of f decreases enough (the
+  Armijo test), and stops on its own when every |dx_i| < epsabs +
+  epsrel |x_i| or sum |f_i| < :residual.
+
+  f is a Function_fdf.compile system, whose parameters are the columns
+  of p in the order of its Hash (or its own when p is nil): the systems
+  are then evaluated in C without the GVL, split over
+  GSL.parallel_threads.  Otherwise f is called once per iteration for
+  all the k systems still running, as f.call(x, p, fx, jac) (p omitted
+  when nil), with x and p their (k x n) and (k x np) rows, to fill the
+  (k x n) residuals fx and the (k n x n) Jacobians jac, rows s n ...
+  s n + n - 1 for system s.
+
+  Options :epsabs (1e-10), :epsrel (1e-10), :residual (0, no test) and
+  :maxiter (100).  Returns [x, status, iter]: the roots as a Matrix, and
+  by system a Vector::Int of GSL::SUCCESS, GSL::EMAXITER, GSL::ESING
+  (singular Jacobian), GSL::ENOPROG (no decrease along the step) or
+  GSL::EBADFUNC (f not finite at x0), and one of the numbers of
+  evaluations.
+*/
+#define MULTIROOT_BATCH_BLOCK 64
+
+typedef struct {
+  size_t m, n, np, k;
+  size_t *idx;                  /* the k systems still running */
+  const double *t, *p;          /* trial points (m x n) and parameters (m x np) */
+  double *f, *J;                /* k x n and k x n*n, by position in idx */
+  void **fs;                    /* the compiled functions, or NULL */
+  size_t nthreads;
+} mygsl_multiroot_batch;
+
+static void multiroot_batch_eval_one(mygsl_multiroot_batch *b, size_t j)
+{
+  size_t s = b->idx[j], i;
+  const double *x = b->t + s*b->n, *p = b->p ? b->p + s*b->np : NULL;
+  for (i = 0; i < b->n; i++)
+    b->f[j*b->n + i] = rb_gsl_function_compiled_eval_grad(b->fs[i], x, p,
+							   b->J + (j*b->n + i)*b->n);
+}
+
+static int multiroot_batch_worker(void *data, size_t id)
+{
+  mygsl_multiroot_batch *b = (mygsl_multiroot_batch *) data;
+  size_t j0, j;
+  for (j0 = id*MULTIROOT_BATCH_BLOCK; j0 < b->k; j0 += b->nthreads*MULTIROOT_BATCH_BLOCK)
+    for (j = j0; j < GSL_MIN(j0 + MULTIROOT_BATCH_BLOCK, b->k); j++)
+      multiroot_batch_eval_one(b, j);
+  return GSL_SUCCESS;
+}
+
+static int multiroot_batch_serial(void *data)
+{
+  mygsl_multiroot_batch *b = (mygsl_multiroot_batch *) data;
+  size_t j;
+  for (j = 0; j < b->k; j++) multiroot_batch_eval_one(b, j);
+  return GSL_SUCCESS;
+}
+
+static VALUE multiroot_batch_rows(const double *a, size_t ncol, const size_t *idx,
+				  size_t k)
+{
+  gsl_matrix *m = gsl_matrix_alloc(k, ncol);
+  size_t j;
+  for (j = 0; j < k; j++) memcpy(m->data + j*m->tda, a + idx[j]*ncol, sizeof(double)*ncol);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static void multiroot_batch_copy(VALUE v, double *a, size_t size1, size_t size2,
+				 const char *name)
+{
+  gsl_matrix *m = NULL;
+  size_t i;
+  Data_Get_Struct(v, gsl_matrix, m);
+  if (m->size1 != size1 || m->size2 != size2)
+    rb_raise(rb_eRuntimeError, "%s was resized", name);
+  for (i = 0; i < size1; i++) memcpy(a + i*size2, m->data + i*m->tda, sizeof(double)*size2);
+}
+
+/* f and J at the trial points of the k running systems */
+static void multiroot_batch_eval(mygsl_multiroot_batch *b, VALUE proc)
+{
+  VALUE vx, vp = Qnil, vf, vJ;
+  gsl_matrix *m = NULL;
+  if (b->fs) {
+    b->nthreads = rb_gsl_parallel_nthreads(b->k*b->n*b->n,
+					   (b->k + MULTIROOT_BATCH_BLOCK - 1)/MULTIROOT_BATCH_BLOCK);
+    if (b->nthreads > 1) rb_gsl_nogvl_parallel(multiroot_batch_worker, b, b->nthreads);
+    else rb_gsl_nogvl_call(multiroot_batch_serial, b, b->k*b->n*b->n);
+    return;
+  }
+  vx = multiroot_batch_rows(b->t, b->n, b->idx, b->k);
+  if (b->p) vp = multiroot_batch_rows(b->p, b->np, b->idx, b->k);
+  m = gsl_matrix_calloc(b->k, b->n);
+  vf = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  m = gsl_matrix_calloc(b->k*b->n, b->n);
+  vJ = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  RB_GSL_CALLBACK_ENTRY("multiroot_batch", b->k*b->n);
+  if (NIL_P(vp)) rb_funcall(proc, RBGSL_ID_call, 3, vx, vf, vJ);
+  else rb_funcall(proc, RBGSL_ID_call, 4, vx, vp, vf, vJ);
+  RB_GSL_CALLBACK_RETURN("multiroot_batch", b->k*b->n);
+  multiroot_batch_copy(vf, b->f, b->k, b->n, "fx");
+  multiroot_batch_copy(vJ, b->J, b->k*b->n, b->n, "jac");
+  RB_GC_GUARD(vx);
+  RB_GC_GUARD(vp);
+}
+
+/* dx = -J^{-1} f by Gaussian elimination with partial pivoting; J is
+   destroyed */
+static int multiroot_batch_newton(size_t n, double *J, const double *f, double *dx)
+{
+  size_t i, j, k, piv;
+  double a, t;
+  for (i = 0; i < n; i++) dx[i] = -f[i];
+  for (k = 0; k < n; k++) {
+    piv = k;
+    for (i = k + 1; i < n; i++) if (fabs(J[i*n + k]) > fabs(J[piv*n + k])) piv = i;
+    a = J[piv*n + k];
+    if (a == 0.0 || !gsl_finite(a)) return GSL_ESING;
+    if (piv != k) {
+      for (j = k; j < n; j++) {
+	t = J[k*n + j]; J[k*n + j] = J[piv*n + j]; J[piv*n + j] = t;
+      }
+      t = dx[k]; dx[k] = dx[piv]; dx[piv] = t;
+    }
+    for (i = k + 1; i < n; i++) {
+      t = J[i*n + k]/a;
+      if (t == 0.0) continue;
+      for (j = k + 1; j < n; j++) J[i*n + j] -= t*J[k*n + j];
+      dx[i] -= t*dx[k];
+    }
+  }
+  for (k = n; k-- > 0;) {
+    t = dx[k];
+    for (j = k + 1; j < n; j++) t -= J[k*n + j]*dx[j];
+    dx[k] = t/J[k*n + k];
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_multiroot_solve_batch(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_multiroot_batch b;
+  gsl_matrix *x0 = NULL, *mp = NULL, *xr = NULL;
+  gsl_vector_int *vstatus = NULL, *viter = NULL;
+  gsl_multiroot_function_fdf *F = NULL;
+  VALUE f, opts = Qnil, v, vbuf, vidx, vfs = Qnil, vxr, vst, vit, proc = Qnil;
+  double epsabs = 1e-10, epsrel = 1e-10, epsres = 0.0, *x, *dx, *t, *lam, *nrm, *P = NULL;
+  double fn, r, step;
+  size_t maxiter = 100, m, n, s, i, j, k, nrun;
+  int conv;
+  memset(&b, 0, sizeof(b));
+  if (argc < 2 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 to 4)", argc);
+  if (argc == 4 || (argc == 3 && TYPE(argv[2]) == T_HASH)) {
+    opts = argv[argc-1];
+    Check_Type(opts, T_HASH);
+  }
+  f = argv[0];
+  CHECK_MATRIX(argv[1]);
+  Data_Get_Struct(argv[1], gsl_matrix, x0);
+  m = x0->size1;
+  n = x0->size2;
+  if (argc >= 3 && !NIL_P(argv[2]) && TYPE(argv[2]) != T_HASH) {
+    CHECK_MATRIX(argv[2]);
+    Data_Get_Struct(argv[2], gsl_matrix, mp);
+    if (mp->size1 != m)
+      rb_raise(rb_eArgError, "%d rows of parameters for %d systems", (int) mp->size1, (int) m);
+    b.np = mp->size2;
+  }
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsabs"))))) epsabs = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsrel"))))) epsrel = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("residual"))))) epsres = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("maxiter"))))) maxiter = NUM2SIZET(v);
+  }
+  if (rb_obj_is_kind_of(f, cgsl_multiroot_function_fdf)) {
+    Data_Get_Struct(f, gsl_multiroot_function_fdf, F);
+    vfs = rb_ary_entry((VALUE) F->params, MULTIROOT_FDF_F);
+    if (TYPE(vfs) != T_ARRAY || !NIL_P(rb_ary_entry((VALUE) F->params, MULTIROOT_FDF_DF)))
+      rb_raise(rb_eTypeError, "Function_fdf.compile system or callable expected");
+    if (F->n != n)
+      rb_raise(rb_eArgError, "system of %d equations for %d unknowns", (int) F->n, (int) n);
+    b.fs = ALLOCA_N(void*, n);
+    for (i = 0; i < n; i++) b.fs[i] = rb_gsl_function_compiled_ptr(rb_ary_entry(vfs, i));
+    if (mp && rb_gsl_function_compiled_nparam(b.fs[0]) != b.np)
+      rb_raise(rb_eArgError, "%d columns of parameters for a system of %d",
+	       (int) b.np, (int) rb_gsl_function_compiled_nparam(b.fs[0]));
+  } else if (rb_respond_to(f, RBGSL_ID_call)) {
+    proc = f;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Function_fdf.compile system or callable expected)",
+	     rb_class2name(CLASS_OF(f)));
+  }
+  b.m = m;
+  b.n = n;
+
+  /* x, dx and the trial points (m x n each), the step lengths and the
+     sums of squares of f (m each), the parameters (m x np), f and J of
+     the running systems (m x n and m x n*n) */
+  x = ALLOCV_N(double, vbuf, 3*m*n + 2*m + m*b.np + m*n + m*n*n);
+  dx = x + m*n;
+  t = dx + m*n;
+  lam = t + m*n;
+  nrm = lam + m;
+  if (mp) {
+    P = nrm + m;
+    for (s = 0; s < m; s++) memcpy(P + s*b.np, mp->data + s*mp->tda, sizeof(double)*b.np);
+  }
+  b.f = nrm + m + m*b.np;
+  b.J = b.f + m*n;
+  b.t = t;
+  b.p = P;
+  b.idx = ALLOCV_N(size_t, vidx, m);
+  xr = gsl_matrix_alloc(m, n);
+  vxr = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, xr);
+  vstatus = gsl_vector_int_calloc(m);
+  vst = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vstatus);
+  viter = gsl_vector_int_calloc(m);
+  vit = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, viter);
+  for (s = 0; s < m; s++) {
+    memcpy(t + s*n, x0->data + s*x0->tda, sizeof(double)*n);
+    memcpy(x + s*n, t + s*n, sizeof(double)*n);
+    nrm[s] = GSL_POSINF;        /* the first evaluation is always taken */
+    lam[s] = 1.0;
+    vstatus->data[s] = GSL_CONTINUE;
+    b.idx[s] = s;
+  }
+  nrun = m;
+  while (nrun > 0) {
+    b.k = nrun;
+    multiroot_batch_eval(&b, proc);
+    for (j = 0, k = 0; j < b.k; j++) {
+      s = b.idx[j];
+      viter->data[s]++;
+      fn = 0.0;
+      r = 0.0;
+      for (i = 0; i < n; i++) {
+	fn += b.f[j*n + i]*b.f[j*n + i];
+	r += fabs(b.f[j*n + i]);
+      }
+      if (gsl_isinf(nrm[s]) || (gsl_finite(fn) && fn <= (1.0 - 2e-4*lam[s])*nrm[s])) {
+	/* accepted: x = t */
+	conv = !gsl_isinf(nrm[s]) || fn == 0.0;
+	for (i = 0; i < n; i++) {
+	  step = t[s*n + i] - x[s*n + i];
+	  if (fabs(step) >= epsabs + epsrel*fabs(t[s*n + i])) conv = 0;
+	  x[s*n + i] = t[s*n + i];
+	}
+	if (fn == 0.0 || r < epsres) conv = 1;
+	nrm[s] = fn;
+	if (conv) {
+	  vstatus->data[s] = GSL_SUCCESS;
+	  continue;
+	}
+	if (!gsl_finite(fn)) {
+	  vstatus->data[s] = GSL_EBADFUNC;
+	  continue;
+	}
+	if (multiroot_batch_newton(n, b.J + j*n*n, b.f + j*n, dx + s*n)) {
+	  vstatus->data[s] = GSL_ESING;
+	  continue;
+	}
+	lam[s] = 1.0;
+      } else {
+	lam[s] *= 0.5;
+	if (lam[s] < GSL_SQRT_DBL_EPSILON) {
+	  vstatus->data[s] = GSL_ENOPROG;
+	  continue;
+	}
+      }
+      if ((size_t) viter->data[s] >= maxiter) {
+	vstatus->data[s] = GSL_EMAXITER;
+	continue;
+      }
+      for (i = 0; i < n; i++) t[s*n + i] = x[s*n + i] + lam[s]*dx[s*n + i];
+      b.idx[k++] = s;
+    }
+    nrun = k;
+  }
+  for (s = 0; s < m; s++) memcpy(xr->data + s*xr->tda, x + s*n, sizeof(double)*n);
+  ALLOCV_END(vidx);
+  ALLOCV_END(vbuf);
+  RB_GC_GUARD(f);
+  RB_GC_GUARD(vfs);
+  return rb_ary_new3(3, vxr, vst, vit);
+}
+
 /**********/
 
 static void multiroot_define_const(VALUE klass1, VALUE klass2);
@@ -875,6 +1291,8 @@ void Init_gsl_multiroot(VALUE module)
 
   rb_define_singleton_method(mgsl_multiroot, "fdjacobian", 
 			     rb_gsl_multiroot_fdjacobian, -1);
+  rb_define_singleton_method(mgsl_multiroot, "solve_batch",
+			     rb_gsl_multiroot_solve_batch, -1);
 
   /* multiroot_function */
   cgsl_multiroot_function = rb_define_class_under(mgsl_multiroot, "Function",
@@ -894,6 +1312,8 @@ void Init_gsl_multiroot(VALUE module)
 						  cgsl_multiroot_function);
   rb_define_singleton_method(cgsl_multiroot_function_fdf, "alloc",
 			     rb_gsl_multiroot_function_fdf_new, -1);
+  rb_define_singleton_method(cgsl_multiroot_function_fdf, "compile",
+			     rb_gsl_multiroot_function_fdf_compile, -1);
   rb_define_method(cgsl_multiroot_function_fdf, "set", rb_gsl_multiroot_function_fdf_set, -1);
   rb_define_method(cgsl_multiroot_function_fdf, "set_params", rb_gsl_multiroot_function_fdf_set_params, -1);
   rb_define_method(cgsl_multiroot_function_fdf, "params", rb_gsl_multiroot_function_fdf_params, 0);
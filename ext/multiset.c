@@ -181,6 +181,55 @@ VALUE rb_gsl_multiset_data2(VALUE mm, VALUE i)
   return INT2FIX(p[i]);
 }
 		  
+/*
+  m.each_multiset { |v| ... } yields the multisets from the current one
+  of m to the last, v being a single Multiset rewritten at every step
+  (copy it with Multiset.memcpy to keep one); m is left as it is.
+  m.batch(n) returns [rows, more]: the current multiset and the
+  following ones, n at most, in the rows of a GSL::Matrix::Int, m being
+  advanced past them; more is false on the last batch.
+*/
+VALUE rb_gsl_multiset_each_multiset(VALUE mm)
+{
+  gsl_multiset *m, *state, *view;
+  VALUE vstate, vview;
+  RETURN_ENUMERATOR(mm, 0, 0);
+  Data_Get_Struct(mm, gsl_multiset, m);
+  state = gsl_multiset_alloc(m->n, m->k);
+  vstate = Data_Wrap_Struct(cMultiset, 0, gsl_multiset_free, state);
+  view = gsl_multiset_alloc(m->n, m->k);
+  vview = Data_Wrap_Struct(CLASS_OF(mm), 0, gsl_multiset_free, view);
+  memcpy(state->data, m->data, sizeof(size_t)*m->k);
+  do {
+    memcpy(view->data, state->data, sizeof(size_t)*state->k);
+    rb_yield(vview);
+  } while (gsl_multiset_next(state) == GSL_SUCCESS);
+  RB_GC_GUARD(vstate);
+  return mm;
+}
+
+VALUE rb_gsl_multiset_batch(VALUE mm, VALUE nn)
+{
+  gsl_multiset *m;
+  gsl_matrix_int *rows;
+  size_t n, i, j;
+  int more = 1;
+  VALUE vrows;
+  Data_Get_Struct(mm, gsl_multiset, m);
+  n = NUM2SIZET(nn);
+  if (n == 0) rb_raise(rb_eArgError, "batch size must be positive");
+  if (m->k == 0) rb_raise(rb_eArgError, "empty multiset");
+  rows = gsl_matrix_int_alloc(n, m->k);
+  vrows = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, rows);
+  for (i = 0; i < n && more; ) {
+    for (j = 0; j < m->k; j++) rows->data[i*rows->tda + j] = (int) m->data[j];
+    i++;
+    more = (gsl_multiset_next(m) == GSL_SUCCESS);
+  }
+  rows->size1 = i;
+  return rb_ary_new3(2, vrows, more ? Qtrue : Qfalse);
+}
+
 void Init_multiset(VALUE module)
 {
   cMultiset = rb_define_class_under(module, "Multiset", cGSL_Object);
@@ -203,6 +252,8 @@ void Init_multiset(VALUE module)
 
   rb_define_method(cMultiset, "next", rb_gsl_multiset_next, 0);
   rb_define_method(cMultiset, "prev", rb_gsl_multiset_prev, 0);
+  rb_define_method(cMultiset, "each_multiset", rb_gsl_multiset_each_multiset, 0);
+  rb_define_method(cMultiset, "batch", rb_gsl_multiset_batch, 1);
 
   rb_define_method(cMultiset, "fwrite", rb_gsl_multiset_fwrite, 1);
   rb_define_method(cMultiset, "fread", rb_gsl_multiset_fread, 1);
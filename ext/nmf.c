@@ -5,167 +5,361 @@
  * (Slightly modified by Y.Tsunesada: just added "const" qualifiers etc.)
  */
 
-#include <math.h>
-#include <time.h>
-#include <gsl/gsl_matrix.h>
-#include <gsl/gsl_blas.h> /* for multiplication */
+/*
+  V (m x n) ~ W H, W (m x k) and H (k x n) non-negative, minimizing the
+  cost |V - W H|_F^2 by one of
 
-#define THRESH 0.000001
-#define MAXITER 1000
+    MYGSL_NMF_MU    the multiplicative updates of Lee and Seung
+    MYGSL_NMF_HALS  hierarchical ALS: exact coordinate steps, one column
+                    of W (row of H) after the other (Cichocki et al.)
+    MYGSL_NMF_ALS   least squares for H, then W, clipped at 0
 
-#undef DEBUG
+  V enters only through V H^T and V^T W, by dgemm or, for a sparse V,
+  by its compressed rows and those of V^T; H is kept transposed, so
+  that both half-steps are the same row-wise update of a factor F
+  (p x k) from P = V^T W or V H^T (p x k) and the Gram matrix G (k x k)
+  of the other factor.  The rows are updated in parallel
+  (GSL.parallel_threads), the products are as threaded as the BLAS
+  backend (GSL::Blas.num_threads).  The cost of each iteration comes
+  from these products, without forming W H:
 
-#define mm(a, b) gsl_matrix_mult(a, b)
-//gsl_matrix * gsl_matrix_mult(gsl_matrix *a, gsl_matrix *b)
-gsl_matrix * gsl_matrix_mult(const gsl_matrix *a, const gsl_matrix *b)
-{
-  gsl_matrix *c;
-  c = gsl_matrix_alloc(a->size1, b->size2);
+    |V - W H|^2 = |V|^2 - 2 sum(W .* V H^T) + sum(W^T W .* H H^T)
 
-  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, a, b, 0.0, c);
-  return c;
-}
+  mygsl_nmf_iterate must be called with the GVL held; it releases it
+  for each of the stages.
+*/
 
-// pretty print
-//void pp(gsl_matrix *m)
-void pp(const gsl_matrix *m)
-{
-  int r, c;
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_rng.h>
 
-  for(r=0; r<m->size1; r++) {
-    for(c=0; c<m->size2; c++) {
-      printf(" %.2f", gsl_matrix_get(m, r, c));
-    }
-    printf("\n");
-  }
-}
+#define NMF_EPS 1e-16   /* floor of the MU denominators and HALS entries */
 
 /* Returns a distance cost */
-//double difcost(gsl_matrix *a, gsl_matrix *b)
 double difcost(const gsl_matrix *a, const gsl_matrix *b)
 {
-  int i, j;
-  double dif=0, d;
+  size_t i, j;
+  double dif = 0, d;
 
-  for (i=0; i < a->size1; i++)
-  {
-    for (j=0; j < a->size2; j++)
-    {
+  for (i = 0; i < a->size1; i++) {
+    for (j = 0; j < a->size2; j++) {
       d = gsl_matrix_get(a, i, j) - gsl_matrix_get(b, i, j);
       dif += d*d;
-	//      dif += pow(gsl_matrix_get(a, i, j) - gsl_matrix_get(b, i, j), 2);
     }
   }
   return dif;
 }
 
-static void initmatrix(gsl_matrix *m, double min, double max)
+/* V^T as compressed rows, of an n-column V */
+mygsl_csr* mygsl_csr_transpose(const mygsl_csr *a, size_t n)
+{
+  mygsl_csr *t;
+  size_t r, k, *next, nz = a->rowptr[a->n];
+  t = mygsl_csr_alloc(n, nz);
+  if (t == NULL) return NULL;
+  for (k = 0; k < nz; k++) t->rowptr[a->col[k] + 1]++;
+  for (r = 0; r < n; r++) t->rowptr[r + 1] += t->rowptr[r];
+  next = t->diag;
+  memcpy(next, t->rowptr, sizeof(size_t)*n);
+  for (r = 0; r < a->n; r++)
+    for (k = a->rowptr[r]; k < a->rowptr[r+1]; k++) {
+      t->col[next[a->col[k]]] = r;
+      t->val[next[a->col[k]]++] = a->val[k];
+    }
+  for (r = 0; r < n; r++) t->diag[r] = t->rowptr[r+1];
+  return t;
+}
+
+mygsl_nmf* mygsl_nmf_alloc(const gsl_matrix *V, const mygsl_csr *csr, size_t n,
+			   size_t k, int method)
+{
+  mygsl_nmf *w;
+  size_t i, j, p;
+  w = (mygsl_nmf *) calloc(1, sizeof(mygsl_nmf));
+  if (w == NULL) return NULL;
+  w->m = V ? V->size1 : csr->n;
+  w->n = V ? V->size2 : n;
+  w->k = k;
+  w->method = method;
+  w->V = V;
+  w->csr = csr;
+  w->cost = GSL_NAN;
+  if (csr) {
+    w->csrt = mygsl_csr_transpose(csr, w->n);
+    if (w->csrt == NULL) goto fail;
+    for (j = 0; j < csr->rowptr[csr->n]; j++) {
+      w->vsum += csr->val[j];
+      w->vnorm2 += csr->val[j]*csr->val[j];
+    }
+  } else {
+    for (i = 0; i < w->m; i++)
+      for (j = 0; j < w->n; j++) {
+	w->vsum += gsl_matrix_get(V, i, j);
+	w->vnorm2 += gsl_matrix_get(V, i, j)*gsl_matrix_get(V, i, j);
+      }
+  }
+  p = GSL_MAX(w->m, w->n);
+  w->W = gsl_matrix_alloc(w->m, k);
+  w->Ht = gsl_matrix_alloc(w->n, k);
+  w->VHt = gsl_matrix_alloc(w->m, k);
+  w->VtW = gsl_matrix_alloc(w->n, k);
+  w->WtW = gsl_matrix_alloc(k, k);
+  w->HHt = gsl_matrix_alloc(k, k);
+  w->chol = gsl_matrix_alloc(k, k);
+  w->scratch = (double *) malloc(sizeof(double)*p*k);
+  if (!w->W || !w->Ht || !w->VHt || !w->VtW || !w->WtW || !w->HHt || !w->chol
+      || !w->scratch) goto fail;
+  return w;
+ fail:
+  mygsl_nmf_free(w);
+  return NULL;
+}
+
+void mygsl_nmf_free(mygsl_nmf *w)
+{
+  if (w == NULL) return;
+  if (w->csrt) mygsl_csr_free(w->csrt);
+  if (w->W) gsl_matrix_free(w->W);
+  if (w->Ht) gsl_matrix_free(w->Ht);
+  if (w->VHt) gsl_matrix_free(w->VHt);
+  if (w->VtW) gsl_matrix_free(w->VtW);
+  if (w->WtW) gsl_matrix_free(w->WtW);
+  if (w->HHt) gsl_matrix_free(w->HHt);
+  if (w->chol) gsl_matrix_free(w->chol);
+  free(w->scratch);
+  free(w);
+}
+
+/* W and H uniform in (0, 2 sqrt(mean(V)/k)), so that W H has the mean of V */
+void mygsl_nmf_init(mygsl_nmf *w, const gsl_rng *r)
 {
-  int i,j;
-  double val;
+  double s = 2.0*sqrt(w->vsum/((double) w->m*w->n*w->k));
+  size_t i, j;
+  if (!(s > 0.0)) s = 1.0;
+  for (i = 0; i < w->m; i++)
+    for (j = 0; j < w->k; j++) gsl_matrix_set(w->W, i, j, s*gsl_rng_uniform_pos(r));
+  for (i = 0; i < w->n; i++)
+    for (j = 0; j < w->k; j++) gsl_matrix_set(w->Ht, i, j, s*gsl_rng_uniform_pos(r));
+  w->gram = 0;
+  w->iter = 0;
+  w->cost = GSL_NAN;
+}
+
+/***** Stages *****/
 
-  srand(time(NULL));
+enum {
+  NMF_STAGE_PRODUCT,   /* P = A B, A sparse */
+  NMF_STAGE_UPDATE,    /* F from P and G */
+};
 
-  for(i=0; i < m->size1; i++)
-  {
-    for(j=0; j < m->size2; j++)
-    {
-      val = min + (int) (max * (rand() / (RAND_MAX + min)));
-      gsl_matrix_set(m, i, j, val);
+struct nmf_task {
+  mygsl_nmf *w;
+  int stage;
+  const mygsl_csr *A;
+  const gsl_matrix *B, *P, *G;
+  gsl_matrix *F, *out;
+  const double *S;       /* F G, for MU */
+  size_t rows, nthreads;
+};
+
+/* out[i,:] = sum over the entries (i, j) of A of A(i, j) B[j,:] */
+static void nmf_product_rows(struct nmf_task *t, size_t r0, size_t r1)
+{
+  const mygsl_csr *A = t->A;
+  size_t i, j, q, k = t->B->size2;
+  double a, *o;
+  const double *b;
+  for (i = r0; i < r1; i++) {
+    o = t->out->data + i*t->out->tda;
+    for (j = 0; j < k; j++) o[j] = 0.0;
+    for (q = A->rowptr[i]; q < A->rowptr[i+1]; q++) {
+      a = A->val[q];
+      b = t->B->data + A->col[q]*t->B->tda;
+      for (j = 0; j < k; j++) o[j] += a*b[j];
     }
   }
 }
 
-static double update(gsl_matrix *v, gsl_matrix *w, gsl_matrix *h)
-{
-  double dist = 0;
-  gsl_matrix *wt=NULL, *ht=NULL, *wh=NULL;
-  gsl_matrix *w_h=NULL, *wt_w=NULL;
-  gsl_matrix *wt_v = NULL;
-  gsl_matrix *v_ht=NULL, *wt_w_h=NULL, *w_h_ht=NULL;
-
-  wt = gsl_matrix_alloc(w->size2, w->size1);
-  gsl_matrix_transpose_memcpy(wt, w);
-  ht = gsl_matrix_alloc(h->size2, h->size1);
-  gsl_matrix_transpose_memcpy(ht, h);
-
-  // wt * v
-  wt_v = mm(wt, v);
-
-  // wt * w * h
-  wt_w = mm(wt, w);
-  wt_w_h = mm(wt_w, h);
-  gsl_matrix_free(wt_w);
-
-  // h = h.mul_elements(wt * v).div_elements(wt * w * h)
-  gsl_matrix_mul_elements(h, wt_v);
-  gsl_matrix_div_elements(h, wt_w_h);
-  gsl_matrix_free(wt_v);
-  gsl_matrix_free(wt_w_h);
-
-  // v * ht
-  v_ht = mm(v, ht);
-
-  // w * h * ht
-  w_h = mm(w, h);
-  w_h_ht = mm(w_h, ht);
-  gsl_matrix_free(w_h);
-
-  // w = w.mul_elements(v * ht).div_elements(w * h * ht)
-  gsl_matrix_mul_elements(w, v_ht);
-  gsl_matrix_div_elements(w, w_h_ht);
-  gsl_matrix_free(v_ht);
-  gsl_matrix_free(w_h_ht);
-
-  gsl_matrix_free(wt);
-  gsl_matrix_free(ht);
-
-  wh = mm(w, h);
-  dist = difcost(v, wh);
-  gsl_matrix_free(wh);
-
-  // w and h were modified in place
-  return dist;
-}
-
-/* The main thing - compute the nmf */
-int gsl_matrix_nmf(gsl_matrix *v, int cols, gsl_matrix **w, gsl_matrix **h)
-{
-  double dist = 1;
-  int iter = 1;
-  double min, max;
-
-#ifdef DEBUG
-  printf("\nCols: %d\nv:\n", cols);
-  pp(v);
-#endif
-
-  gsl_matrix_minmax(v, &min, &max);
-
-#ifdef DEBUG
-  printf("Min: %f, Max: %f\n", min, max);
-#endif
-  *w = gsl_matrix_alloc(v->size1, cols);
-  initmatrix(*w, min, max/2); // the multiplicative rules tend to increase w
-
-  *h = gsl_matrix_alloc(cols, v->size2);
-  initmatrix(*h, min, max);
-
-  while(dist >= THRESH && iter < MAXITER)
-  {
-    dist = update(v, *w, *h);
-#ifdef DEBUG
-    printf("Iteration: %d, distance: %f\n", iter, dist);
-    printf("\nw:\n");
-    pp(*w);
-    printf("\nh:\n");
-    pp(*h);
-    printf("\n");
-#endif
-    iter++;
+static void nmf_update_rows(struct nmf_task *t, size_t r0, size_t r1)
+{
+  const gsl_matrix *G = t->G, *L = t->w->chol;
+  size_t i, j, s, k = G->size1;
+  double *f, d;
+  const double *pr, *sr;
+  for (i = r0; i < r1; i++) {
+    f = t->F->data + i*t->F->tda;
+    pr = t->P->data + i*t->P->tda;
+    switch (t->w->method) {
+    case MYGSL_NMF_MU:
+      sr = t->S + i*k;
+      for (j = 0; j < k; j++) f[j] *= pr[j]/(sr[j] + NMF_EPS);
+      break;
+    case MYGSL_NMF_HALS:
+      /* f_j += (p_j - (f G)_j)/G_jj, with the entries before j new */
+      for (j = 0; j < k; j++) {
+	d = pr[j];
+	for (s = 0; s < k; s++) d -= f[s]*G->data[s*G->tda + j];
+	d = f[j] + d/G->data[j*G->tda + j];
+	f[j] = d > NMF_EPS ? d : NMF_EPS;
+      }
+      break;
+    default:
+      /* f = P G^{-1}: L y = p, L^T f = y, then clipped */
+      for (j = 0; j < k; j++) {
+	d = pr[j];
+	for (s = 0; s < j; s++) d -= L->data[j*L->tda + s]*f[s];
+	f[j] = d/L->data[j*L->tda + j];
+      }
+      for (j = k; j-- > 0;) {
+	d = f[j];
+	for (s = j + 1; s < k; s++) d -= L->data[s*L->tda + j]*f[s];
+	f[j] = d/L->data[j*L->tda + j];
+      }
+      for (j = 0; j < k; j++) if (f[j] < 0.0) f[j] = 0.0;
+      break;
+    }
   }
-#ifdef DEBUG
-  printf("Ended\n");
-#endif
+}
+
+static int nmf_worker(void *data, size_t c)
+{
+  struct nmf_task *t = (struct nmf_task *) data;
+  size_t r0 = c*t->rows/t->nthreads, r1 = (c + 1)*t->rows/t->nthreads;
+  if (t->stage == NMF_STAGE_PRODUCT) nmf_product_rows(t, r0, r1);
+  else nmf_update_rows(t, r0, r1);
   return GSL_SUCCESS;
 }
+
+static int nmf_serial(void *data)
+{
+  return nmf_worker(data, 0);
+}
+
+static void nmf_run(struct nmf_task *t, size_t work)
+{
+  t->nthreads = rb_gsl_parallel_nthreads(work, t->rows);
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(nmf_worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(nmf_serial, t, work);
+}
+
+struct nmf_blas {
+  const gsl_matrix *A, *B;
+  gsl_matrix *C;
+};
+
+static int nmf_gemm_tn(void *data)
+{
+  struct nmf_blas *b = (struct nmf_blas *) data;
+  return gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, b->A, b->B, 0.0, b->C);
+}
+
+static int nmf_gemm_nn(void *data)
+{
+  struct nmf_blas *b = (struct nmf_blas *) data;
+  return gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, b->A, b->B, 0.0, b->C);
+}
+
+/* C = V^T B (trans) or V B */
+static void nmf_vmul(mygsl_nmf *w, int trans, const gsl_matrix *B, gsl_matrix *C)
+{
+  struct nmf_task t;
+  struct nmf_blas b;
+  if (w->V) {
+    b.A = w->V; b.B = B; b.C = C;
+    rb_gsl_nogvl_call(trans ? nmf_gemm_tn : nmf_gemm_nn, &b, w->m*w->n*w->k);
+    return;
+  }
+  memset(&t, 0, sizeof(t));
+  t.w = w;
+  t.stage = NMF_STAGE_PRODUCT;
+  t.A = trans ? w->csrt : w->csr;
+  t.B = B;
+  t.out = C;
+  t.rows = C->size1;
+  nmf_run(&t, t.A->rowptr[t.A->n]*w->k);
+}
+
+/* G = F^T F */
+static void nmf_gram(const gsl_matrix *F, gsl_matrix *G)
+{
+  size_t i, j;
+  gsl_blas_dsyrk(CblasLower, CblasTrans, 1.0, F, 0.0, G);
+  for (i = 0; i < G->size1; i++)
+    for (j = 0; j < i; j++) gsl_matrix_set(G, j, i, gsl_matrix_get(G, i, j));
+}
+
+/* Cholesky factor of G + ridge I in w->chol, for ALS */
+static void nmf_cholesky(mygsl_nmf *w, const gsl_matrix *G)
+{
+  gsl_matrix *L = w->chol;
+  size_t i, j, s, k = w->k;
+  double d, tr = 0.0, ridge;
+  for (i = 0; i < k; i++) tr += gsl_matrix_get(G, i, i);
+  ridge = 1e-12*(tr > 0.0 ? tr/k : 1.0);
+  for (j = 0; j < k; j++) {
+    d = gsl_matrix_get(G, j, j) + ridge;
+    for (s = 0; s < j; s++) d -= gsl_matrix_get(L, j, s)*gsl_matrix_get(L, j, s);
+    d = sqrt(d > ridge ? d : ridge);
+    gsl_matrix_set(L, j, j, d);
+    for (i = j + 1; i < k; i++) {
+      double e = gsl_matrix_get(G, i, j);
+      for (s = 0; s < j; s++) e -= gsl_matrix_get(L, i, s)*gsl_matrix_get(L, j, s);
+      gsl_matrix_set(L, i, j, e/d);
+    }
+  }
+}
+
+/* One half-step: F (p x k) from P = V^T W or V H^T and the Gram matrix G */
+static void nmf_update(mygsl_nmf *w, gsl_matrix *F, const gsl_matrix *P,
+		       const gsl_matrix *G)
+{
+  struct nmf_task t;
+  struct nmf_blas b;
+  gsl_matrix_view S;
+  size_t p = F->size1, k = w->k;
+  memset(&t, 0, sizeof(t));
+  t.w = w;
+  t.stage = NMF_STAGE_UPDATE;
+  t.F = F; t.P = P; t.G = G;
+  t.rows = p;
+  if (w->method == MYGSL_NMF_MU) {
+    S = gsl_matrix_view_array(w->scratch, p, k);
+    b.A = F; b.B = G; b.C = &S.matrix;
+    rb_gsl_nogvl_call(nmf_gemm_nn, &b, p*k*k);
+    t.S = w->scratch;
+  } else if (w->method == MYGSL_NMF_ALS) {
+    nmf_cholesky(w, G);
+  }
+  nmf_run(&t, p*k*(w->method == MYGSL_NMF_MU ? 1 : k));
+}
+
+static double nmf_sum_prod(const gsl_matrix *a, const gsl_matrix *b)
+{
+  size_t i, j;
+  double s = 0.0;
+  for (i = 0; i < a->size1; i++)
+    for (j = 0; j < a->size2; j++)
+      s += a->data[i*a->tda + j]*b->data[i*b->tda + j];
+  return s;
+}
+
+/* One iteration, H then W; returns the cost |V - W H|_F^2 */
+double mygsl_nmf_iterate(mygsl_nmf *w)
+{
+  double c;
+  if (!w->gram) {
+    nmf_gram(w->W, w->WtW);
+    w->gram = 1;
+  }
+  nmf_vmul(w, 1, w->W, w->VtW);
+  nmf_update(w, w->Ht, w->VtW, w->WtW);
+  nmf_vmul(w, 0, w->Ht, w->VHt);
+  nmf_gram(w->Ht, w->HHt);
+  nmf_update(w, w->W, w->VHt, w->HHt);
+  nmf_gram(w->W, w->WtW);
+  c = w->vnorm2 - 2.0*nmf_sum_prod(w->W, w->VHt) + nmf_sum_prod(w->WtW, w->HHt);
+  w->cost = c > 0.0 ? c : 0.0;
+  w->iter++;
+  return w->cost;
+}
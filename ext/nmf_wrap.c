@@ -5,42 +5,253 @@
  *
  */
 
-#include <ruby.h>
-#include <gsl/gsl_matrix.h>
+/*
+  GSL::Matrix::NMF.nmf(v, k, opts = {}) and GSL::Matrix#nmf(k, opts)
+  return [W, H]; GSL::Matrix::NMF::Solver keeps the factorization
+  between calls and reports the cost of each iteration:
 
-int gsl_matrix_nmf(gsl_matrix *v, int cols, gsl_matrix **w, gsl_matrix **h);
-//double difcost(gsl_matrix *a, gsl_matrix *b);
-double difcost(const gsl_matrix *a, const gsl_matrix *b);
+    s = GSL::Matrix::NMF::Solver.new(v, k, :method => :hals, :tol => 1e-5)
+    s.solve { |iter, cost| cost > target }   # false stops (so does break)
+    s.w; s.h; s.cost; s.iter; s.converged?; s.history; s.name
 
-//VALUE mNMF;
-static VALUE mNMF;
-extern VALUE cgsl_matrix;
+  v is a GSL::Matrix or a GSL::SpMatrix (its non-zeros only are read).
+  The options are :method (:mu, :hals or :als; :mu for nmf, :hals for
+  Solver), :max_iter (1000), :tol (1e-6: stops when the cost decreases
+  by less than tol times itself), :cost (1e-6: stops below this cost),
+  :seed (of the random initial W and H), :w and :h (initial W and H),
+  and :history (keep the costs of a solve).  The cost is difcost(v, W*H).
+*/
 
-/*
- * call-seq:
- *   nmf(GSL::Matrix, columns) -> [GSL::Matrix, GSL::Matrix]
- *
- * Calculates the NMF of the given +matrix+, returns the W and H matrices
- */
-static VALUE nmf_wrap(VALUE obj, VALUE matrix, VALUE cols)
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_linalg.h"
+
+#define NMF_THRESH 0.000001
+#define NMF_MAXITER 1000
+
+static VALUE mNMF, cgsl_nmf_solver;
+
+typedef struct {
+  mygsl_nmf *w;
+  mygsl_csr *csr;      /* a sparse v, owned */
+  VALUE vv;            /* v, kept alive */
+  size_t max_iter;
+  double tol, cost_tol;
+  gsl_vector *history;
+  size_t nhistory;
+  int converged;
+} rb_gsl_nmf;
+
+static void rb_gsl_nmf_mark(rb_gsl_nmf *s)
+{
+  rb_gc_mark(s->vv);
+}
+
+static void rb_gsl_nmf_free(rb_gsl_nmf *s)
+{
+  mygsl_nmf_free(s->w);
+  mygsl_csr_free(s->csr);
+  if (s->history) gsl_vector_free(s->history);
+  free(s);
+}
+
+static rb_gsl_nmf* rb_gsl_nmf_get(VALUE obj)
 {
-  gsl_matrix *w, *h, *m;
-  unsigned int c;
-  VALUE arr;
+  rb_gsl_nmf *s = NULL;
+  Data_Get_Struct(obj, rb_gsl_nmf, s);
+  return s;
+}
+
+static int nmf_method(VALUE v, int def)
+{
+  const char *name;
+  if (NIL_P(v)) return def;
+  name = SYMBOL_P(v) ? rb_id2name(SYM2ID(v)) : StringValuePtr(v);
+  if (strcmp(name, "mu") == 0) return MYGSL_NMF_MU;
+  if (strcmp(name, "hals") == 0) return MYGSL_NMF_HALS;
+  if (strcmp(name, "als") == 0) return MYGSL_NMF_ALS;
+  rb_raise(rb_eArgError, "unknown NMF method %s (:mu, :hals or :als)", name);
+  return def;
+}
 
-  if ( ! FIXNUM_P(cols) || (c=NUM2INT(cols)) <= 0 ) {
+/* F (p x k) = the initial factor vf, p x k (transposed: k x p) */
+static void nmf_set_factor(gsl_matrix *F, VALUE vf, int trans, const char *name)
+{
+  gsl_matrix *m = NULL;
+  size_t i, j;
+  CHECK_MATRIX(vf);
+  Data_Get_Struct(vf, gsl_matrix, m);
+  if ((trans ? m->size2 : m->size1) != F->size1
+      || (trans ? m->size1 : m->size2) != F->size2)
+    rb_raise(rb_eArgError, "%s must be %d x %d", name,
+	     (int) (trans ? F->size2 : F->size1), (int) (trans ? F->size1 : F->size2));
+  for (i = 0; i < F->size1; i++)
+    for (j = 0; j < F->size2; j++)
+      gsl_matrix_set(F, i, j, trans ? gsl_matrix_get(m, j, i) : gsl_matrix_get(m, i, j));
+}
+
+static VALUE nmf_solver_new0(VALUE klass, VALUE vv, VALUE vk, VALUE opts,
+			     int method)
+{
+  rb_gsl_nmf *s = NULL;
+  gsl_matrix *V = NULL;
+  gsl_rng *r;
+  VALUE obj, v;
+  size_t n = 0;
+  long k;
+  unsigned long seed = 0;
+  if (!FIXNUM_P(vk) || (k = FIX2LONG(vk)) <= 0)
     rb_raise(rb_eArgError, "Number of columns should be a positive integer.");
+  if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+  obj = Data_Make_Struct(klass, rb_gsl_nmf, rb_gsl_nmf_mark, rb_gsl_nmf_free, s);
+  s->vv = vv;
+  s->max_iter = NMF_MAXITER;
+  s->tol = 1e-6;
+  s->cost_tol = NMF_THRESH;
+  if (!NIL_P(opts)) {
+    method = nmf_method(rb_hash_aref(opts, ID2SYM(rb_intern("method"))), method);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_iter")))))
+      s->max_iter = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("tol"))))) s->tol = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("cost"))))) s->cost_tol = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("seed"))))) seed = NUM2ULONG(v);
+    if (RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("history")))))
+      s->history = gsl_vector_alloc(s->max_iter > 0 ? s->max_iter : 1);
+  }
+  if (MATRIX_P(vv)) {
+    Data_Get_Struct(vv, gsl_matrix, V);
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+  } else if (rb_gsl_spmatrix_p(vv)) {
+    gsl_spmatrix *sp = rb_gsl_get_spmatrix(vv);
+    s->csr = mygsl_csr_from_spmatrix(sp);
+    if (s->csr == NULL) rb_raise(rb_eNoMemError, "failed to copy the sparse matrix");
+    n = sp->size2;
+#endif
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Matrix or GSL::SpMatrix"
+	     " expected)", rb_class2name(CLASS_OF(vv)));
+  }
+  s->w = mygsl_nmf_alloc(V, s->csr, n, (size_t) k, method);
+  if (s->w == NULL) rb_raise(rb_eNoMemError, "NMF workspace allocation failed");
+  r = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(r, seed);
+  mygsl_nmf_init(s->w, r);
+  gsl_rng_free(r);
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("w")))))
+      nmf_set_factor(s->w->W, v, 0, "W");
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("h")))))
+      nmf_set_factor(s->w->Ht, v, 1, "H");
+  }
+  return obj;
+}
+
+/* Solver.new(v, k, opts = {}) */
+static VALUE rb_gsl_nmf_solver_new(int argc, VALUE *argv, VALUE klass)
+{
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  return nmf_solver_new0(klass, argv[0], argv[1], argc == 3 ? argv[2] : Qnil,
+			 MYGSL_NMF_HALS);
+}
+
+/*
+  Iterates from the current W and H until converged or max_iter more
+  iterations, yielding (iter, cost) after each; GSL::SUCCESS,
+  GSL::EMAXITER, or GSL::CONTINUE when the block returned false
+*/
+static VALUE rb_gsl_nmf_solver_solve(VALUE obj)
+{
+  rb_gsl_nmf *s = rb_gsl_nmf_get(obj);
+  double cost, prev = s->w->cost;
+  size_t i;
+  int block = rb_block_given_p();
+  s->converged = 0;
+  s->nhistory = 0;
+  for (i = 0; i < s->max_iter; i++) {
+    cost = mygsl_nmf_iterate(s->w);
+    if (s->history && s->nhistory < s->history->size)
+      gsl_vector_set(s->history, s->nhistory++, cost);
+    if (block && rb_yield_values(2, SIZET2NUM(s->w->iter), rb_float_new(cost)) == Qfalse)
+      return INT2FIX(GSL_CONTINUE);
+    if (cost <= s->cost_tol || (!gsl_isnan(prev) && prev - cost <= s->tol*prev)) {
+      s->converged = 1;
+      break;
+    }
+    prev = cost;
   }
-  arr = rb_ary_new2(2);
-  Data_Get_Struct(matrix, gsl_matrix, m);
+  return INT2FIX(s->converged ? GSL_SUCCESS : GSL_EMAXITER);
+}
+
+/* One iteration; returns the cost */
+static VALUE rb_gsl_nmf_solver_step(VALUE obj)
+{
+  return rb_float_new(mygsl_nmf_iterate(rb_gsl_nmf_get(obj)->w));
+}
+
+static VALUE rb_gsl_nmf_solver_w(VALUE obj)
+{
+  rb_gsl_nmf *s = rb_gsl_nmf_get(obj);
+  gsl_matrix *W = gsl_matrix_alloc(s->w->m, s->w->k);
+  gsl_matrix_memcpy(W, s->w->W);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, W);
+}
+
+static VALUE rb_gsl_nmf_solver_h(VALUE obj)
+{
+  rb_gsl_nmf *s = rb_gsl_nmf_get(obj);
+  gsl_matrix *H = gsl_matrix_alloc(s->w->k, s->w->n);
+  gsl_matrix_transpose_memcpy(H, s->w->Ht);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, H);
+}
+
+static VALUE rb_gsl_nmf_solver_cost(VALUE obj)
+{
+  return rb_float_new(rb_gsl_nmf_get(obj)->w->cost);
+}
+
+static VALUE rb_gsl_nmf_solver_iter(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_nmf_get(obj)->w->iter);
+}
+
+static VALUE rb_gsl_nmf_solver_converged(VALUE obj)
+{
+  return rb_gsl_nmf_get(obj)->converged ? Qtrue : Qfalse;
+}
 
-  /* compute the NMF */
-  gsl_matrix_nmf(m, c, &w, &h);
+/* The costs of the iterations of the last solve */
+static VALUE rb_gsl_nmf_solver_history(VALUE obj)
+{
+  rb_gsl_nmf *s = rb_gsl_nmf_get(obj);
+  gsl_vector *h;
+  if (s->history == NULL || s->nhistory == 0) return Qnil;
+  h = gsl_vector_alloc(s->nhistory);
+  memcpy(h->data, s->history->data, sizeof(double)*s->nhistory);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, h);
+}
 
-  rb_ary_push(arr, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, w));
-  rb_ary_push(arr, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, h));
+static VALUE rb_gsl_nmf_solver_name(VALUE obj)
+{
+  static const char *names[] = { "mu", "hals", "als" };
+  return rb_str_new2(names[rb_gsl_nmf_get(obj)->w->method]);
+}
 
-  return arr;
+/*
+ * call-seq:
+ *   nmf(GSL::Matrix, columns, opts = {}) -> [GSL::Matrix, GSL::Matrix]
+ *
+ * Calculates the NMF of the given +matrix+, returns the W and H matrices
+ */
+static VALUE nmf_wrap(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE solver;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  solver = nmf_solver_new0(cgsl_nmf_solver, argv[0], argv[1],
+			   argc == 3 ? argv[2] : Qnil, MYGSL_NMF_MU);
+  rb_gsl_nmf_solver_solve(solver);
+  return rb_ary_new3(2, rb_gsl_nmf_solver_w(solver), rb_gsl_nmf_solver_h(solver));
 }
 
 /*
@@ -58,18 +269,36 @@ static VALUE difcost_wrap(VALUE obj, VALUE matrix1, VALUE matrix2)
 }
 
 /* call-seq:
- *   nmf(cols) -> [GSL::Matrix, GSL::Matrix]
+ *   nmf(cols, opts = {}) -> [GSL::Matrix, GSL::Matrix]
  */
-static VALUE matrix_nmf(VALUE obj, VALUE cols)
+static VALUE matrix_nmf(int argc, VALUE *argv, VALUE obj)
 {
-  //  nmf_wrap(cgsl_matrix, obj, cols);
-  return nmf_wrap(cgsl_matrix, obj, cols);
+  VALUE args[3];
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  args[0] = obj;
+  args[1] = argv[0];
+  args[2] = argc == 2 ? argv[1] : Qnil;
+  return nmf_wrap(3, args, obj);
 }
 
 void Init_gsl_matrix_nmf(void) {
   mNMF = rb_define_module_under(cgsl_matrix, "NMF");
 
-  rb_define_singleton_method(mNMF, "nmf", nmf_wrap, 2);
+  rb_define_singleton_method(mNMF, "nmf", nmf_wrap, -1);
   rb_define_singleton_method(mNMF, "difcost", difcost_wrap, 2);
-  rb_define_method(cgsl_matrix, "nmf", matrix_nmf, 1);
+  rb_define_method(cgsl_matrix, "nmf", matrix_nmf, -1);
+
+  cgsl_nmf_solver = rb_define_class_under(mNMF, "Solver", cGSL_Object);
+  rb_define_singleton_method(cgsl_nmf_solver, "new", rb_gsl_nmf_solver_new, -1);
+  rb_define_singleton_method(cgsl_nmf_solver, "alloc", rb_gsl_nmf_solver_new, -1);
+  rb_define_method(cgsl_nmf_solver, "solve", rb_gsl_nmf_solver_solve, 0);
+  rb_define_method(cgsl_nmf_solver, "step", rb_gsl_nmf_solver_step, 0);
+  rb_define_method(cgsl_nmf_solver, "w", rb_gsl_nmf_solver_w, 0);
+  rb_define_method(cgsl_nmf_solver, "h", rb_gsl_nmf_solver_h, 0);
+  rb_define_method(cgsl_nmf_solver, "cost", rb_gsl_nmf_solver_cost, 0);
+  rb_define_method(cgsl_nmf_solver, "iter", rb_gsl_nmf_solver_iter, 0);
+  rb_define_method(cgsl_nmf_solver, "converged?", rb_gsl_nmf_solver_converged, 0);
+  rb_define_method(cgsl_nmf_solver, "history", rb_gsl_nmf_solver_history, 0);
+  rb_define_method(cgsl_nmf_solver, "name", rb_gsl_nmf_solver_name, 0);
 }
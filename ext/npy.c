@@ -0,0 +1,968 @@
+/*
+  npy.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  NumPy .npy and .npz files, for exchanging arrays with Python without
+  going through text:
+
+    m.save_npy("grid.npy")               # numpy.load("grid.npy")
+    m = GSL::Matrix.load_npy("grid.npy") # numpy.save("grid.npy", a)
+    a = GSL.load_npy("any.npy")          # class chosen from the file
+    GSL.save_npz("run.npz", "x" => x, "y" => y)
+    h = GSL.load_npz("run.npz")          # {"x" => ..., "y" => ...}
+
+  The file is mapped and its elements are copied straight into the
+  block of the new object, with the GVL released; a file of the native
+  dtype in C order costs a single memcpy.  Other byte orders, Fortran
+  order and other dtypes (float32, the integer widths, bool) are
+  converted on the way.
+
+  Classes for GSL.load_npy and GSL.load_npz (a 0-d array is a Float,
+  Integer or Complex):
+
+    dtype          1-d                2-d                more
+    f4, f8         Vector             Matrix             Tensor
+    i*, u*, b1     Vector::Int        Matrix::Int        Tensor::Int
+    c8, c16        Vector::Complex    Matrix::Complex    -
+
+  A Tensor has equal dimensions, and needs the tensor add-on.  The class
+  methods (GSL::Vector.load_npy, GSL::Matrix::Complex.load_npy, ...)
+  read into their own class, from a real dtype for the real classes, an
+  integer one for the Int classes (RangeError for values out of the C
+  int range) and any numeric dtype for the Complex ones.
+
+  #save_npy writes the native byte order in C order: doubles as f8,
+  Int elements as i4 and complex as c16; views are compacted.
+  GSL.save_npz stores its members uncompressed, like numpy.savez, and
+  archives of 4 GiB or more are refused.  GSL.load_npz also reads the
+  deflated members of numpy.savez_compressed, through Zlib, and Zip64
+  archives.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#ifdef HAVE_TENSOR_TENSOR_H
+#include "rb_gsl_tensor.h"
+#endif
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#define NPY_MAXDIMS 32
+#define NPY_MAGIC "\x93NUMPY"
+#define NPY_HEADER_MAX 1024
+
+/* Element types on the GSL side */
+enum { NPY_DOUBLE, NPY_INT, NPY_COMPLEX };
+
+struct npy_array {
+  char kind;                    /* 'f', 'i', 'u', 'b' or 'c' */
+  size_t esize;
+  int swap;
+  int fortran;
+  int ndim;
+  size_t dims[NPY_MAXDIMS];
+  size_t n;
+  const char *data;
+};
+
+static int npy_little(void)
+{
+  const uint32_t one = 1;
+  return *(const char *) &one;
+}
+
+static uint32_t npy_u16(const char *p)
+{
+  const unsigned char *u = (const unsigned char *) p;
+  return u[0] | (u[1] << 8);
+}
+
+static uint32_t npy_u32(const char *p)
+{
+  const unsigned char *u = (const unsigned char *) p;
+  return u[0] | (u[1] << 8) | (u[2] << 16) | ((uint32_t) u[3] << 24);
+}
+
+static uint64_t npy_u64(const char *p)
+{
+  return npy_u32(p) | ((uint64_t) npy_u32(p + 4) << 32);
+}
+
+static void npy_put16(char *p, uint32_t x)
+{
+  p[0] = (char) x;
+  p[1] = (char) (x >> 8);
+}
+
+static void npy_put32(char *p, uint32_t x)
+{
+  npy_put16(p, x);
+  npy_put16(p + 2, x >> 16);
+}
+
+/* The value of 'key' in the header dictionary [h, e), or NULL */
+static const char* npy_key(const char *h, const char *e, const char *key)
+{
+  size_t k = strlen(key);
+  const char *p;
+  for (p = h; p + k + 2 <= e; p++) {
+    if ((*p != '\'' && *p != '"') || p[k + 1] != *p || memcmp(p + 1, key, k) != 0)
+      continue;
+    p += k + 2;
+    while (p < e && (*p == ' ' || *p == ':')) p++;
+    return p;
+  }
+  return NULL;
+}
+
+static void npy_parse(const char *buf, size_t len, const char *name,
+                      struct npy_array *a)
+{
+  const char *h, *e, *p;
+  size_t off, hlen, d;
+  char q;
+  if (len < 10 || memcmp(buf, NPY_MAGIC, 6) != 0)
+    rb_raise(rb_eArgError, "%s: not a .npy file", name);
+  if (buf[6] == 1) {
+    hlen = npy_u16(buf + 8);
+    off = 10;
+  } else if ((buf[6] == 2 || buf[6] == 3) && len >= 12) {
+    hlen = npy_u32(buf + 8);
+    off = 12;
+  } else {
+    rb_raise(rb_eArgError, "%s: .npy format version %d.%d is not supported",
+             name, (int) buf[6], (int) buf[7]);
+  }
+  if (hlen > len - off) rb_raise(rb_eArgError, "%s: truncated .npy header", name);
+  h = buf + off;
+  e = h + hlen;
+
+  p = npy_key(h, e, "descr");
+  if (p == NULL || p + 4 > e) rb_raise(rb_eArgError, "%s: no descr in .npy header", name);
+  if (*p != '\'' && *p != '"')
+    rb_raise(rb_eArgError, "%s: structured dtypes are not supported", name);
+  q = *p++;
+  switch (*p++) {
+  case '<': a->swap = !npy_little(); break;
+  case '>': a->swap = npy_little(); break;
+  case '|': case '=': a->swap = 0; break;
+  default: p--; a->swap = 0; break;
+  }
+  a->kind = *p++;
+  for (a->esize = 0; p < e && *p >= '0' && *p <= '9'; p++) a->esize = 10*a->esize + (*p - '0');
+  if (p >= e || *p != q) a->esize = 0;
+  switch (a->kind) {
+  case 'f': d = a->esize == 4 || a->esize == 8; break;
+  case 'i': case 'u': d = a->esize == 1 || a->esize == 2 || a->esize == 4 || a->esize == 8; break;
+  case 'b': d = a->esize == 1; break;
+  case 'c': d = a->esize == 8 || a->esize == 16; break;
+  default: d = 0;
+  }
+  if (!d) rb_raise(rb_eArgError, "%s: dtype '%c%d' is not supported", name,
+                   a->kind, (int) a->esize);
+  if (a->esize == 1) a->swap = 0;
+
+  p = npy_key(h, e, "fortran_order");
+  a->fortran = p != NULL && p < e && *p == 'T';
+
+  p = npy_key(h, e, "shape");
+  if (p == NULL || p >= e || *p != '(')
+    rb_raise(rb_eArgError, "%s: no shape in .npy header", name);
+  a->ndim = 0;
+  a->n = 1;
+  for (p++; ; ) {
+    while (p < e && (*p == ' ' || *p == ',')) p++;
+    if (p >= e) rb_raise(rb_eArgError, "%s: bad shape in .npy header", name);
+    if (*p == ')') break;
+    if (*p < '0' || *p > '9' || a->ndim == NPY_MAXDIMS)
+      rb_raise(rb_eArgError, "%s: bad shape in .npy header", name);
+    for (d = 0; p < e && *p >= '0' && *p <= '9'; p++) {
+      if (d > (LONG_MAX - 9)/10) rb_raise(rb_eArgError, "%s: bad shape in .npy header", name);
+      d = 10*d + (*p - '0');
+    }
+    if (d != 0 && a->n > LONG_MAX/d) rb_raise(rb_eArgError, "%s: array too large", name);
+    a->dims[a->ndim++] = d;
+    a->n *= d;
+  }
+  if (a->n > (len - off - hlen)/a->esize)
+    rb_raise(rb_eArgError, "%s: truncated .npy data", name);
+  a->data = e;
+}
+
+/* Element i of an integer file, sign extended (the bits of a u8) */
+static int64_t npy_integer(const struct npy_array *a, size_t i)
+{
+  char b[8];
+  const char *p = a->data + i*a->esize;
+  size_t j;
+  uint64_t u;
+  if (a->swap) {
+    for (j = 0; j < a->esize; j++) b[j] = p[a->esize - 1 - j];
+    p = b;
+  }
+  switch (a->esize) {
+  case 1: return a->kind == 'i' ? (int64_t) *(const signed char *) p : (int64_t) *(const unsigned char *) p;
+  case 2: { uint16_t v; memcpy(&v, p, 2); return a->kind == 'i' ? (int64_t) (int16_t) v : (int64_t) v; }
+  case 4: { uint32_t v; memcpy(&v, p, 4); return a->kind == 'i' ? (int64_t) (int32_t) v : (int64_t) v; }
+  }
+  memcpy(&u, p, 8);
+  return (int64_t) u;
+}
+
+/* Element i of the file as a real part, or for 'c' with part 1 as the
+   imaginary part */
+static double npy_real(const struct npy_array *a, size_t i, int part)
+{
+  char b[8];
+  size_t s = a->kind == 'c' ? a->esize/2 : a->esize;
+  const char *p = a->data + i*a->esize + part*s;
+  size_t j;
+  float f;
+  double x;
+  int64_t k;
+  if (a->kind != 'f' && a->kind != 'c') {
+    k = npy_integer(a, i);
+    return a->kind == 'u' && a->esize == 8 ? (double) (uint64_t) k : (double) k;
+  }
+  if (a->swap) {
+    for (j = 0; j < s; j++) b[j] = p[s - 1 - j];
+    p = b;
+  }
+  if (s == 4) {
+    memcpy(&f, p, 4);
+    return f;
+  }
+  memcpy(&x, p, 8);
+  return x;
+}
+
+struct npy_copy {
+  const struct npy_array *a;
+  int type;
+  void *dst;
+  int overflow;
+};
+
+static int npy_copy_run(void *data)
+{
+  struct npy_copy *c = (struct npy_copy *) data;
+  const struct npy_array *a = c->a;
+  size_t idx[NPY_MAXDIMS], fstride[NPY_MAXDIMS];
+  size_t i, src = 0;
+  int j, k = a->ndim, fortran = a->fortran && k > 1;
+  int64_t x;
+  if (!a->swap && !fortran
+      && ((c->type == NPY_DOUBLE && a->kind == 'f' && a->esize == sizeof(double))
+          || (c->type == NPY_INT && a->kind == 'i' && a->esize == sizeof(int))
+          || (c->type == NPY_COMPLEX && a->kind == 'c' && a->esize == 2*sizeof(double)))) {
+    memcpy(c->dst, a->data, a->n*a->esize);
+    return GSL_SUCCESS;
+  }
+  if (fortran) {
+    for (j = 0; j < k; j++) {
+      idx[j] = 0;
+      fstride[j] = j == 0 ? 1 : fstride[j - 1]*a->dims[j - 1];
+    }
+  }
+  for (i = 0; i < a->n; i++) {
+    if (!fortran) src = i;
+    switch (c->type) {
+    case NPY_DOUBLE:
+      ((double *) c->dst)[i] = npy_real(a, src, 0);
+      break;
+    case NPY_COMPLEX:
+      ((double *) c->dst)[2*i] = npy_real(a, src, 0);
+      ((double *) c->dst)[2*i + 1] = a->kind == 'c' ? npy_real(a, src, 1) : 0.0;
+      break;
+    default:
+      x = npy_integer(a, src);
+      if (a->kind == 'u' && a->esize == 8 ? (uint64_t) x > INT_MAX : x < INT_MIN || x > INT_MAX)
+        c->overflow = 1;
+      ((int *) c->dst)[i] = (int) x;
+    }
+    if (fortran) {
+      for (j = k - 1; j >= 0; j--) {
+        src += fstride[j];
+        if (++idx[j] < a->dims[j]) break;
+        src -= idx[j]*fstride[j];
+        idx[j] = 0;
+      }
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE npy_scalar(const struct npy_array *a)
+{
+  switch (a->kind) {
+  case 'f':
+    return rb_float_new(npy_real(a, 0, 0));
+  case 'c':
+    return rb_complex_new(rb_float_new(npy_real(a, 0, 0)), rb_float_new(npy_real(a, 0, 1)));
+  case 'b':
+    return *a->data ? Qtrue : Qfalse;
+  }
+  if (a->kind == 'u' && a->esize == 8) return ULL2NUM((uint64_t) npy_integer(a, 0));
+  return LL2NUM(npy_integer(a, 0));
+}
+
+/* The class an array of type and ndim dimensions goes to in GSL.load_npy */
+static VALUE npy_auto_class(int type, int ndim)
+{
+  if (ndim == 1)
+    return type == NPY_DOUBLE ? cgsl_vector : type == NPY_INT ? cgsl_vector_int : cgsl_vector_complex;
+  if (ndim == 2)
+    return type == NPY_DOUBLE ? cgsl_matrix : type == NPY_INT ? cgsl_matrix_int : cgsl_matrix_complex;
+#ifdef HAVE_TENSOR_TENSOR_H
+  if (type == NPY_DOUBLE) return cgsl_tensor;
+  if (type == NPY_INT) return cgsl_tensor_int;
+#endif
+  return Qnil;
+}
+
+/*
+  The array in [buf, buf + len) as an object of klass, or of the class
+  its dtype and shape go to for klass nil
+*/
+static VALUE npy_load(const char *buf, size_t len, const char *name, VALUE klass)
+{
+  struct npy_array a;
+  struct npy_copy c;
+  VALUE obj = Qnil;
+  int type, ndim = -1;
+  npy_parse(buf, len, name, &a);
+  if (NIL_P(klass)) {
+    if (a.ndim == 0) return npy_scalar(&a);
+    type = a.kind == 'f' ? NPY_DOUBLE : a.kind == 'c' ? NPY_COMPLEX : NPY_INT;
+    klass = npy_auto_class(type, a.ndim);
+    if (NIL_P(klass))
+      rb_raise(rb_eArgError, "%s: no GSL class for a %s array of %d dimensions",
+               name, a.kind == 'c' ? "complex" : "real", a.ndim);
+  }
+  if (RTEST(rb_class_inherited_p(klass, cgsl_vector))) {
+    type = NPY_DOUBLE; ndim = 1;
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_vector_int))) {
+    type = NPY_INT; ndim = 1;
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_vector_complex))) {
+    type = NPY_COMPLEX; ndim = 1;
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_matrix))) {
+    type = NPY_DOUBLE; ndim = 2;
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_matrix_int))) {
+    type = NPY_INT; ndim = 2;
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_matrix_complex))) {
+    type = NPY_COMPLEX; ndim = 2;
+#ifdef HAVE_TENSOR_TENSOR_H
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_tensor))) {
+    type = NPY_DOUBLE;
+  } else if (RTEST(rb_class_inherited_p(klass, cgsl_tensor_int))) {
+    type = NPY_INT;
+#endif
+  } else {
+    rb_raise(rb_eTypeError, "%s can not be loaded from .npy", rb_class2name(klass));
+  }
+  if ((type == NPY_DOUBLE && a.kind == 'c') || (type == NPY_INT && (a.kind == 'f' || a.kind == 'c')))
+    rb_raise(rb_eTypeError, "%s: dtype '%c%d' can not be read into %s", name,
+             a.kind, (int) a.esize, rb_class2name(klass));
+  if (ndim > 0 ? a.ndim != ndim : a.ndim == 0)
+    rb_raise(rb_eArgError, "%s: array of %d dimensions for %s", name, a.ndim,
+             rb_class2name(klass));
+  if (a.n == 0) rb_raise(rb_eArgError, "%s: empty array", name);
+
+  c.a = &a;
+  c.type = type;
+  c.overflow = 0;
+  if (ndim == 1) {
+    size_t n = a.dims[0];
+    if (type == NPY_DOUBLE) {
+      gsl_vector *v = gsl_vector_alloc(n);
+      obj = Data_Wrap_Struct(RTEST(rb_class_inherited_p(klass, cgsl_vector_col)) ? cgsl_vector_col : cgsl_vector,
+                             0, gsl_vector_free, v);
+      c.dst = v->data;
+    } else if (type == NPY_INT) {
+      gsl_vector_int *v = gsl_vector_int_alloc(n);
+      obj = Data_Wrap_Struct(RTEST(rb_class_inherited_p(klass, cgsl_vector_int_col)) ? cgsl_vector_int_col : cgsl_vector_int,
+                             0, gsl_vector_int_free, v);
+      c.dst = v->data;
+    } else {
+      gsl_vector_complex *v = gsl_vector_complex_alloc(n);
+      obj = Data_Wrap_Struct(RTEST(rb_class_inherited_p(klass, cgsl_vector_complex_col)) ? cgsl_vector_complex_col : cgsl_vector_complex,
+                             0, gsl_vector_complex_free, v);
+      c.dst = v->data;
+    }
+  } else if (ndim == 2) {
+    if (type == NPY_DOUBLE) {
+      gsl_matrix *m = gsl_matrix_alloc(a.dims[0], a.dims[1]);
+      obj = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+      c.dst = m->data;
+    } else if (type == NPY_INT) {
+      gsl_matrix_int *m = gsl_matrix_int_alloc(a.dims[0], a.dims[1]);
+      obj = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, m);
+      c.dst = m->data;
+    } else {
+      gsl_matrix_complex *m = gsl_matrix_complex_alloc(a.dims[0], a.dims[1]);
+      obj = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, m);
+      c.dst = m->data;
+    }
+  } else {
+#ifdef HAVE_TENSOR_TENSOR_H
+    int j;
+    for (j = 1; j < a.ndim; j++)
+      if (a.dims[j] != a.dims[0])
+        rb_raise(rb_eArgError, "%s: a Tensor has equal dimensions", name);
+    if (type == NPY_DOUBLE) {
+      rbgsl_tensor *t = rbgsl_tensor_alloc(a.ndim, a.dims[0]);
+      obj = Data_Wrap_Struct(cgsl_tensor, 0, rbgsl_tensor_free, t);
+      c.dst = t->tensor->data;
+    } else {
+      rbgsl_tensor_int *t = rbgsl_tensor_int_alloc(a.ndim, a.dims[0]);
+      obj = Data_Wrap_Struct(cgsl_tensor_int, 0, rbgsl_tensor_int_free, t);
+      c.dst = t->tensor->data;
+    }
+#endif
+  }
+  rb_gsl_nogvl_call(npy_copy_run, &c, a.n*a.esize);
+  if (c.overflow) rb_raise(rb_eRangeError, "%s: values out of the range of int", name);
+  return obj;
+}
+
+struct npy_file {
+  char *addr;
+  size_t len;
+  int mapped;
+};
+
+static void npy_open(VALUE path, struct npy_file *f)
+{
+  const char *name = StringValueCStr(path);
+  struct stat st;
+  int fd = open(name, O_RDONLY);
+  if (fd < 0) rb_sys_fail(name);
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    rb_sys_fail(name);
+  }
+  f->len = (size_t) st.st_size;
+  f->mapped = 0;
+  f->addr = NULL;
+  if (f->len == 0) {
+    close(fd);
+    rb_raise(rb_eArgError, "%s: empty file", name);
+  }
+#ifdef HAVE_SYS_MMAN_H
+  f->addr = mmap(NULL, f->len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (f->addr != MAP_FAILED) {
+    f->mapped = 1;
+    close(fd);
+    return;
+  }
+  f->addr = NULL;
+#endif
+  {
+    size_t got = 0;
+    ssize_t r;
+    f->addr = ALLOC_N(char, f->len);
+    while (got < f->len && (r = read(fd, f->addr + got, f->len - got)) > 0) got += r;
+    close(fd);
+    f->len = got;
+  }
+}
+
+static VALUE npy_close(VALUE arg)
+{
+  struct npy_file *f = (struct npy_file *) arg;
+#ifdef HAVE_SYS_MMAN_H
+  if (f->mapped) {
+    munmap(f->addr, f->len);
+    return Qnil;
+  }
+#endif
+  xfree(f->addr);
+  return Qnil;
+}
+
+struct npy_read {
+  VALUE path, klass;
+  struct npy_file f;
+};
+
+static VALUE npy_load_body(VALUE arg)
+{
+  struct npy_read *r = (struct npy_read *) arg;
+  npy_open(r->path, &r->f);
+  return npy_load(r->f.addr, r->f.len, RSTRING_PTR(r->path), r->klass);
+}
+
+static VALUE npy_load_file(VALUE path, VALUE klass)
+{
+  struct npy_read r;
+  FilePathValue(path);
+  r.path = path;
+  r.klass = klass;
+  r.f.addr = NULL;
+  r.f.mapped = 0;
+  return rb_ensure(npy_load_body, (VALUE) &r, npy_close, (VALUE) &r.f);
+}
+
+/* GSL.load_npy(path) */
+static VALUE rb_gsl_load_npy(VALUE module, VALUE path)
+{
+  return npy_load_file(path, Qnil);
+}
+
+/* GSL::Vector.load_npy(path), GSL::Matrix::Int.load_npy(path), ... */
+static VALUE rb_gsl_array_load_npy(VALUE klass, VALUE path)
+{
+  return npy_load_file(path, klass);
+}
+
+/*
+  What #save_npy writes: the header dtype and shape, and the data as
+  rows chunks of cols elements, chunk r at data + r*ld bytes
+*/
+struct npy_src {
+  char kind;
+  size_t esize;
+  int ndim;
+  size_t dims[NPY_MAXDIMS];
+  const char *data;
+  size_t rows, cols, ld;
+};
+
+static void npy_source(VALUE obj, struct npy_src *s)
+{
+  s->ndim = 1;
+  s->rows = 1;
+  s->ld = 0;
+  if (rb_obj_is_kind_of(obj, cgsl_vector)) {
+    gsl_vector *v;
+    Data_Get_Struct(obj, gsl_vector, v);
+    s->kind = 'f';
+    s->esize = sizeof(double);
+    s->dims[0] = v->size;
+    s->data = (const char *) v->data;
+    s->ld = v->stride*s->esize;
+  } else if (rb_obj_is_kind_of(obj, cgsl_vector_int)) {
+    gsl_vector_int *v;
+    Data_Get_Struct(obj, gsl_vector_int, v);
+    s->kind = 'i';
+    s->esize = sizeof(int);
+    s->dims[0] = v->size;
+    s->data = (const char *) v->data;
+    s->ld = v->stride*s->esize;
+  } else if (rb_obj_is_kind_of(obj, cgsl_vector_complex)) {
+    gsl_vector_complex *v;
+    Data_Get_Struct(obj, gsl_vector_complex, v);
+    s->kind = 'c';
+    s->esize = 2*sizeof(double);
+    s->dims[0] = v->size;
+    s->data = (const char *) v->data;
+    s->ld = v->stride*s->esize;
+  } else if (rb_obj_is_kind_of(obj, cgsl_matrix)) {
+    gsl_matrix *m;
+    Data_Get_Struct(obj, gsl_matrix, m);
+    s->kind = 'f';
+    s->esize = sizeof(double);
+    s->ndim = 2;
+    s->dims[0] = m->size1;
+    s->dims[1] = m->size2;
+    s->data = (const char *) m->data;
+    s->ld = m->tda*s->esize;
+  } else if (rb_obj_is_kind_of(obj, cgsl_matrix_int)) {
+    gsl_matrix_int *m;
+    Data_Get_Struct(obj, gsl_matrix_int, m);
+    s->kind = 'i';
+    s->esize = sizeof(int);
+    s->ndim = 2;
+    s->dims[0] = m->size1;
+    s->dims[1] = m->size2;
+    s->data = (const char *) m->data;
+    s->ld = m->tda*s->esize;
+  } else if (rb_obj_is_kind_of(obj, cgsl_matrix_complex)) {
+    gsl_matrix_complex *m;
+    Data_Get_Struct(obj, gsl_matrix_complex, m);
+    s->kind = 'c';
+    s->esize = 2*sizeof(double);
+    s->ndim = 2;
+    s->dims[0] = m->size1;
+    s->dims[1] = m->size2;
+    s->data = (const char *) m->data;
+    s->ld = m->tda*s->esize;
+#ifdef HAVE_TENSOR_TENSOR_H
+  } else if (rb_obj_is_kind_of(obj, cgsl_tensor) || rb_obj_is_kind_of(obj, cgsl_tensor_int)) {
+    unsigned int j, rank;
+    size_t dim, size;
+    if (rb_obj_is_kind_of(obj, cgsl_tensor)) {
+      rbgsl_tensor *t;
+      Data_Get_Struct(obj, rbgsl_tensor, t);
+      rank = t->tensor->rank;
+      dim = t->tensor->dimension;
+      size = t->tensor->size;
+      s->kind = 'f';
+      s->esize = sizeof(double);
+      s->data = (const char *) t->tensor->data;
+    } else {
+      rbgsl_tensor_int *t;
+      Data_Get_Struct(obj, rbgsl_tensor_int, t);
+      rank = t->tensor->rank;
+      dim = t->tensor->dimension;
+      size = t->tensor->size;
+      s->kind = 'i';
+      s->esize = sizeof(int);
+      s->data = (const char *) t->tensor->data;
+    }
+    if (rank > NPY_MAXDIMS) rb_raise(rb_eRangeError, "tensor of rank %u", rank);
+    s->ndim = (int) rank;
+    for (j = 0; j < rank; j++) s->dims[j] = dim;
+    s->cols = size;
+    return;
+#endif
+  } else {
+    rb_raise(rb_eTypeError, "%s can not be saved as .npy", rb_obj_classname(obj));
+  }
+  if (s->ndim == 1) {
+    if (s->ld == s->esize) {
+      s->cols = s->dims[0];
+    } else {
+      s->rows = s->dims[0];
+      s->cols = 1;
+    }
+  } else if (s->ld == s->esize*s->dims[1]) {
+    s->cols = s->dims[0]*s->dims[1];
+  } else {
+    s->rows = s->dims[0];
+    s->cols = s->dims[1];
+  }
+}
+
+/* The .npy header (version 1.0) of s, padded for 64-byte aligned data */
+static size_t npy_header(const struct npy_src *s, char *buf)
+{
+  char *p = buf + 10;
+  size_t hlen;
+  int j;
+  p += sprintf(p, "{'descr': '%c%c%d', 'fortran_order': False, 'shape': (",
+               s->esize == 1 ? '|' : npy_little() ? '<' : '>', s->kind, (int) s->esize);
+  for (j = 0; j < s->ndim; j++)
+    p += sprintf(p, j == 0 ? "%lu" : ", %lu", (unsigned long) s->dims[j]);
+  p += sprintf(p, s->ndim == 1 ? ",), }" : "), }");
+  while ((p - buf + 1) % 64 != 0) *p++ = ' ';
+  *p++ = '\n';
+  memcpy(buf, NPY_MAGIC "\x01\x00", 8);
+  hlen = (p - buf) - 10;
+  npy_put16(buf + 8, (uint32_t) hlen);
+  return p - buf;
+}
+
+static uint32_t npy_crc_table[256];
+
+static void npy_crc_init(void)
+{
+  uint32_t c;
+  int i, k;
+  for (i = 0; i < 256; i++) {
+    for (c = i, k = 0; k < 8; k++) c = c & 1 ? 0xedb88320U ^ (c >> 1) : c >> 1;
+    npy_crc_table[i] = c;
+  }
+}
+
+/* Bytes go to fp, or only into crc and len when fp is NULL */
+struct npy_out {
+  FILE *fp;
+  uint32_t crc;
+  size_t len;
+};
+
+static void npy_put(struct npy_out *o, const char *p, size_t n)
+{
+  size_t i;
+  uint32_t c = o->crc;
+  o->len += n;
+  if (o->fp) {
+    fwrite(p, 1, n, o->fp);
+    return;
+  }
+  for (i = 0; i < n; i++) c = npy_crc_table[(c ^ (unsigned char) p[i]) & 0xff] ^ (c >> 8);
+  o->crc = c;
+}
+
+struct npy_emit {
+  const struct npy_src *s;
+  struct npy_out *o;
+};
+
+static int npy_emit_data(void *data)
+{
+  struct npy_emit *e = (struct npy_emit *) data;
+  const struct npy_src *s = e->s;
+  size_t r;
+  for (r = 0; r < s->rows; r++) npy_put(e->o, s->data + r*s->ld, s->cols*s->esize);
+  return GSL_SUCCESS;
+}
+
+static void npy_emit(const struct npy_src *s, struct npy_out *o)
+{
+  char h[NPY_HEADER_MAX];
+  struct npy_emit e;
+  npy_put(o, h, npy_header(s, h));
+  e.s = s;
+  e.o = o;
+  rb_gsl_nogvl_call(npy_emit_data, &e, s->rows*s->cols*s->esize);
+}
+
+static FILE* npy_create(VALUE path)
+{
+  FILE *fp;
+  FilePathValue(path);
+  fp = fopen(RSTRING_PTR(path), "wb");
+  if (fp == NULL) rb_sys_fail(RSTRING_PTR(path));
+  return fp;
+}
+
+static void npy_finish(FILE *fp, VALUE path)
+{
+  int err = ferror(fp);
+  if (fclose(fp) != 0 || err) {
+    if (errno == 0) errno = EIO;
+    rb_sys_fail(RSTRING_PTR(path));
+  }
+}
+
+/* GSL::Vector#save_npy(path), GSL::Matrix#save_npy(path), ... */
+static VALUE rb_gsl_array_save_npy(VALUE obj, VALUE path)
+{
+  struct npy_src s;
+  struct npy_out o;
+  npy_source(obj, &s);
+  o.fp = npy_create(path);
+  o.len = 0;
+  o.crc = 0;
+  npy_emit(&s, &o);
+  npy_finish(o.fp, path);
+  return obj;
+}
+
+struct npz_entry {
+  struct npy_src s;
+  uint32_t crc;
+  size_t len, off;
+};
+
+/* GSL.save_npz(path, hash): one member name.npy for each pair */
+static VALUE rb_gsl_save_npz(VALUE module, VALUE path, VALUE hash)
+{
+  VALUE pairs, names, tmp, name;
+  struct npz_entry *e;
+  struct npy_out o;
+  char h[46];
+  size_t i, n, local = 0, cd = 0;
+  Check_Type(hash, T_HASH);
+  pairs = rb_funcall(hash, rb_intern("to_a"), 0);
+  n = RARRAY_LEN(pairs);
+  if (n > 0xffff) rb_raise(rb_eRangeError, "too many arrays for an npz archive");
+  names = rb_ary_new2(n);
+  e = ALLOCV_N(struct npz_entry, tmp, n + 1);
+  for (i = 0; i < n; i++) {
+    VALUE pair = rb_ary_entry(pairs, i);
+    name = rb_str_plus(rb_obj_as_string(rb_ary_entry(pair, 0)), rb_str_new2(".npy"));
+    if (RSTRING_LEN(name) > 0xffff) rb_raise(rb_eArgError, "name too long");
+    rb_ary_push(names, name);
+    npy_source(rb_ary_entry(pair, 1), &e[i].s);
+  }
+  for (i = 0; i < n; i++) {
+    o.fp = NULL;
+    o.crc = 0xffffffffU;
+    o.len = 0;
+    npy_emit(&e[i].s, &o);
+    e[i].crc = o.crc ^ 0xffffffffU;
+    e[i].len = o.len;
+    e[i].off = local;
+    local += 30 + RSTRING_LEN(rb_ary_entry(names, i)) + o.len;
+    cd += 46 + RSTRING_LEN(rb_ary_entry(names, i));
+    if (local + cd + 22 >= 0xffffffffU)
+      rb_raise(rb_eRangeError, "npz archive of 4 GiB or more");
+  }
+  o.fp = npy_create(path);
+  for (i = 0; i < n; i++) {
+    name = rb_ary_entry(names, i);
+    memset(h, 0, 30);
+    npy_put32(h, 0x04034b50);
+    npy_put16(h + 4, 20);
+    npy_put16(h + 12, 0x21);
+    npy_put32(h + 14, e[i].crc);
+    npy_put32(h + 18, (uint32_t) e[i].len);
+    npy_put32(h + 22, (uint32_t) e[i].len);
+    npy_put16(h + 26, (uint32_t) RSTRING_LEN(name));
+    fwrite(h, 1, 30, o.fp);
+    fwrite(RSTRING_PTR(name), 1, RSTRING_LEN(name), o.fp);
+    npy_emit(&e[i].s, &o);
+  }
+  for (i = 0; i < n; i++) {
+    name = rb_ary_entry(names, i);
+    memset(h, 0, 46);
+    npy_put32(h, 0x02014b50);
+    npy_put16(h + 4, 20);
+    npy_put16(h + 6, 20);
+    npy_put16(h + 14, 0x21);
+    npy_put32(h + 16, e[i].crc);
+    npy_put32(h + 20, (uint32_t) e[i].len);
+    npy_put32(h + 24, (uint32_t) e[i].len);
+    npy_put16(h + 28, (uint32_t) RSTRING_LEN(name));
+    npy_put32(h + 42, (uint32_t) e[i].off);
+    fwrite(h, 1, 46, o.fp);
+    fwrite(RSTRING_PTR(name), 1, RSTRING_LEN(name), o.fp);
+  }
+  memset(h, 0, 22);
+  npy_put32(h, 0x06054b50);
+  npy_put16(h + 8, (uint32_t) n);
+  npy_put16(h + 10, (uint32_t) n);
+  npy_put32(h + 12, (uint32_t) cd);
+  npy_put32(h + 16, (uint32_t) local);
+  fwrite(h, 1, 22, o.fp);
+  ALLOCV_END(tmp);
+  npy_finish(o.fp, path);
+  RB_GC_GUARD(pairs);
+  RB_GC_GUARD(names);
+  return hash;
+}
+
+#define NPZ_CORRUPT(name) rb_raise(rb_eArgError, "%s: corrupt npz archive", name)
+
+/* A deflated member, inflated through Zlib */
+static VALUE npz_inflate(const char *p, size_t n)
+{
+  VALUE z, str;
+  rb_require("zlib");
+  z = rb_funcall(rb_path2class("Zlib::Inflate"), rb_intern("new"), 1, INT2FIX(-15));
+  str = rb_funcall(z, rb_intern("inflate"), 1, rb_str_new(p, n));
+  rb_funcall(z, rb_intern("close"), 0);
+  return str;
+}
+
+static VALUE npz_load_body(VALUE arg)
+{
+  struct npy_read *r = (struct npy_read *) arg;
+  const char *name, *buf, *end, *p, *x, *xe;
+  VALUE hash = rb_hash_new(), key, str, member;
+  size_t len, i, count, cd, cs, cdend;
+  uint64_t csize, usize, off;
+  uint32_t method, flags, nlen, xlen, clen, llen;
+  npy_open(r->path, &r->f);
+  name = RSTRING_PTR(r->path);
+  buf = r->f.addr;
+  len = r->f.len;
+  end = buf + len;
+  /* The end of central directory record, before a comment of up to 64 KiB */
+  for (i = 22; i <= len && i <= 22 + 0xffff; i++)
+    if (npy_u32(end - i) == 0x06054b50) break;
+  if (i > len || i > 22 + 0xffff)
+    rb_raise(rb_eArgError, "%s: not an npz archive", name);
+  p = end - i;
+  count = npy_u16(p + 10);
+  cs = npy_u32(p + 12);
+  cd = npy_u32(p + 16);
+  if ((count == 0xffff || cd == 0xffffffffU || cs == 0xffffffffU)
+      && p - buf >= 20 && npy_u32(p - 20) == 0x07064b50) {
+    off = npy_u64(p - 12);
+    if (off > len - 56 || npy_u32(buf + off) != 0x06064b50) NPZ_CORRUPT(name);
+    count = (size_t) npy_u64(buf + off + 32);
+    cs = (size_t) npy_u64(buf + off + 40);
+    cd = (size_t) npy_u64(buf + off + 48);
+  }
+  if (cd > len || cs > len - cd) NPZ_CORRUPT(name);
+  cdend = cd + cs;
+  for (i = 0, p = buf + cd; i < count; i++, p += 46 + nlen + xlen + clen) {
+    if ((size_t) (p - buf) + 46 > cdend || npy_u32(p) != 0x02014b50) NPZ_CORRUPT(name);
+    flags = npy_u16(p + 8);
+    method = npy_u16(p + 10);
+    csize = npy_u32(p + 20);
+    usize = npy_u32(p + 24);
+    nlen = npy_u16(p + 28);
+    xlen = npy_u16(p + 30);
+    clen = npy_u16(p + 32);
+    off = npy_u32(p + 42);
+    if ((size_t) (p - buf) + 46 + nlen + xlen > cdend) NPZ_CORRUPT(name);
+    /* Zip64 extended information: the fields saturated above, in order */
+    for (x = p + 46 + nlen, xe = x + xlen; x + 4 <= xe; x += 4 + npy_u16(x + 2)) {
+      const char *f = x + 4, *fe = f + npy_u16(x + 2);
+      if (npy_u16(x) != 0x0001 || fe > xe) continue;
+      if (usize == 0xffffffffU && f + 8 <= fe) { usize = npy_u64(f); f += 8; }
+      if (csize == 0xffffffffU && f + 8 <= fe) { csize = npy_u64(f); f += 8; }
+      if (off == 0xffffffffU && f + 8 <= fe) off = npy_u64(f);
+    }
+    if (nlen < 4 || memcmp(p + 46 + nlen - 4, ".npy", 4) != 0) continue;
+    if (flags & 1) rb_raise(rb_eArgError, "%s: encrypted npz members are not supported", name);
+    if (off > len - 30 || npy_u32(buf + off) != 0x04034b50) NPZ_CORRUPT(name);
+    llen = 30 + npy_u16(buf + off + 26) + npy_u16(buf + off + 28);
+    if (off + llen > len || csize > len - off - llen) NPZ_CORRUPT(name);
+    key = rb_str_new(p + 46, nlen - 4);
+    member = rb_sprintf("%s[%"PRIsVALUE".npy]", name, key);
+    if (method == 0) {
+      if (usize != csize) NPZ_CORRUPT(name);
+      rb_hash_aset(hash, key, npy_load(buf + off + llen, (size_t) usize,
+                                       RSTRING_PTR(member), Qnil));
+    } else if (method == 8) {
+      str = npz_inflate(buf + off + llen, (size_t) csize);
+      rb_hash_aset(hash, key, npy_load(RSTRING_PTR(str), RSTRING_LEN(str),
+                                       RSTRING_PTR(member), Qnil));
+      RB_GC_GUARD(str);
+    } else {
+      rb_raise(rb_eArgError, "%s: compression method %d is not supported",
+               RSTRING_PTR(member), (int) method);
+    }
+  }
+  return hash;
+}
+
+/* GSL.load_npz(path): a Hash of the arrays by name */
+static VALUE rb_gsl_load_npz(VALUE module, VALUE path)
+{
+  struct npy_read r;
+  FilePathValue(path);
+  r.path = path;
+  r.klass = Qnil;
+  r.f.addr = NULL;
+  r.f.mapped = 0;
+  return rb_ensure(npz_load_body, (VALUE) &r, npy_close, (VALUE) &r.f);
+}
+
+void Init_gsl_npy(VALUE module)
+{
+  VALUE classes[8];
+  int i, n = 0;
+  npy_crc_init();
+  classes[n++] = cgsl_vector;
+  classes[n++] = cgsl_vector_int;
+  classes[n++] = cgsl_vector_complex;
+  classes[n++] = cgsl_matrix;
+  classes[n++] = cgsl_matrix_int;
+  classes[n++] = cgsl_matrix_complex;
+#ifdef HAVE_TENSOR_TENSOR_H
+  classes[n++] = cgsl_tensor;
+  classes[n++] = cgsl_tensor_int;
+#endif
+  for (i = 0; i < n; i++) {
+    rb_define_singleton_method(classes[i], "load_npy", rb_gsl_array_load_npy, 1);
+    rb_define_method(classes[i], "save_npy", rb_gsl_array_save_npy, 1);
+  }
+  rb_define_module_function(module, "load_npy", rb_gsl_load_npy, 1);
+  rb_define_module_function(module, "load_npz", rb_gsl_load_npz, 1);
+  rb_define_module_function(module, "save_npz", rb_gsl_save_npz, 2);
+}
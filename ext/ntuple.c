@@ -14,6 +14,11 @@
 #include "rb_gsl_function.h"
 #include "rb_gsl_histogram.h"
 #include <gsl/gsl_ntuple.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 static VALUE cgsl_ntuple;
 static VALUE cgsl_ntuple_select_fn;
@@ -400,31 +405,323 @@ static VALUE rb_gsl_ntuple_project(VALUE obj, VALUE hh, VALUE nn,
   return INT2FIX(status);
 }
 
-/* method */
-static VALUE rb_gsl_ntuple_project2(VALUE obj, VALUE hh, VALUE vvfn, VALUE vsfn)
+/*
+  Native projection: the value is a column index or an expression of
+  the row x[0] ... x[ncols-1] compiled by GSL::Function.compile's
+  parser, optionally [expr, params]; the selection is nil, a Hash of
+  column => [lo, hi] or Range cuts, or such an expression (selected
+  where it is nonzero).  Rows are read NTUPLE_BLOCK at a time and
+  evaluated with the GVL released; the values of each histogram then go
+  through the bulk fill, which skips values outside the range as
+  Histogram#increment does, where gsl_ntuple_project stops with an
+  error.
+
+  Where mmap is available and the rows left are many (NTUPLE_PAR_ROWS
+  per thread at least), the file is mapped instead and its rows split
+  in contiguous ranges, one per thread, each binned into private
+  histograms added to the given ones in thread order at the end; the
+  counts being whole numbers, the result is that of the sequential
+  pass.  The file is left at its end in both cases.
+*/
+#define NTUPLE_BLOCK 4096
+#define NTUPLE_PAR_ROWS 65536
+#define NTUPLE_CUT_MAX 16
+#define NTUPLE_TARGET_MAX 64
+
+typedef struct {
+  size_t col;
+  double lo, hi;
+  int closed;                   /* hi included */
+} ntuple_cut;
+
+typedef struct {
+  gsl_histogram *h;
+  size_t vcol;
+  void *vexpr;                  /* NULL: the value is column vcol */
+  ntuple_cut cut[NTUPLE_CUT_MAX];
+  size_t ncut;
+  void *sexpr;
+  double *vals;
+  size_t nvals;
+} ntuple_target;
+
+struct ntuple_project_task {
+  FILE *fp;
+  size_t rowsize, ncols, nrows;
+  double *buf;
+  ntuple_target *t;
+  size_t nt;
+};
+
+static int ntuple_selected(const ntuple_target *t, const double *x)
+{
+  size_t i;
+  double v;
+  for (i = 0; i < t->ncut; i++) {
+    v = x[t->cut[i].col];
+    if (!(v >= t->cut[i].lo && (t->cut[i].closed ? v <= t->cut[i].hi : v < t->cut[i].hi)))
+      return 0;
+  }
+  if (t->sexpr) {
+    v = rb_gsl_function_compiled_eval_multi(t->sexpr, x);
+    return v != 0.0 && !gsl_isnan(v);
+  }
+  return 1;
+}
+
+static int ntuple_project_block(void *data)
+{
+  struct ntuple_project_task *p = (struct ntuple_project_task *) data;
+  ntuple_target *t;
+  const double *x;
+  size_t i, k;
+  p->nrows = fread(p->buf, p->rowsize, NTUPLE_BLOCK, p->fp);
+  for (k = 0; k < p->nt; k++) {
+    t = p->t + k;
+    t->nvals = 0;
+    for (i = 0; i < p->nrows; i++) {
+      x = p->buf + i*p->ncols;
+      if (!ntuple_selected(t, x)) continue;
+      t->vals[t->nvals++] = t->vexpr ? rb_gsl_function_compiled_eval_multi(t->vexpr, x)
+	: x[t->vcol];
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static size_t ntuple_column(VALUE vc, size_t ncols)
+{
+  long c = NUM2LONG(vc);
+  if (c < 0 || (size_t) c >= ncols)
+    rb_raise(rb_eIndexError, "column %ld out of range 0...%d", c, (int) ncols);
+  return (size_t) c;
+}
+
+/* An expression or [expression, params] compiled for rows of ncols */
+static void* ntuple_compile(VALUE spec, size_t ncols, VALUE keep)
+{
+  VALUE f;
+  if (TYPE(spec) == T_ARRAY)
+    f = rb_gsl_function_compile_multi(rb_ary_entry(spec, 0), rb_ary_entry(spec, 1), ncols);
+  else
+    f = rb_gsl_function_compile_multi(spec, Qnil, ncols);
+  rb_ary_push(keep, f);
+  return rb_gsl_function_compiled_ptr(f);
+}
+
+struct ntuple_cut_arg {
+  ntuple_target *t;
+  size_t ncols;
+};
+
+static int ntuple_cut_i(VALUE key, VALUE val, VALUE data)
+{
+  struct ntuple_cut_arg *a = (struct ntuple_cut_arg *) data;
+  ntuple_target *t = a->t;
+  ntuple_cut *c;
+  if (t->ncut == NTUPLE_CUT_MAX) rb_raise(rb_eArgError, "too many cuts (max %d)", NTUPLE_CUT_MAX);
+  c = t->cut + t->ncut;
+  c->col = ntuple_column(key, a->ncols);
+  if (rb_obj_is_kind_of(val, rb_cRange)) {
+    c->lo = NUM2DBL(rb_funcall(val, rb_intern("begin"), 0));
+    c->hi = NUM2DBL(rb_funcall(val, rb_intern("end"), 0));
+    c->closed = !RTEST(rb_funcall(val, rb_intern("exclude_end?"), 0));
+  } else {
+    Check_Type(val, T_ARRAY);
+    if (RARRAY_LEN(val) != 2) rb_raise(rb_eArgError, "cut must be [lo, hi]");
+    c->lo = NUM2DBL(rb_ary_entry(val, 0));
+    c->hi = NUM2DBL(rb_ary_entry(val, 1));
+    c->closed = 0;
+  }
+  t->ncut++;
+  return ST_CONTINUE;
+}
+
+static void ntuple_target_set(ntuple_target *t, VALUE hh, VALUE value, VALUE select,
+			      size_t ncols, VALUE keep)
+{
+  struct ntuple_cut_arg a;
+  CHECK_HISTOGRAM(hh);
+  Data_Get_Struct(hh, gsl_histogram, t->h);
+  t->vexpr = t->sexpr = NULL;
+  t->ncut = 0;
+  t->vals = NULL;
+  if (FIXNUM_P(value)) t->vcol = ntuple_column(value, ncols);
+  else t->vexpr = ntuple_compile(value, ncols, keep);
+  if (NIL_P(select)) return;
+  if (TYPE(select) == T_HASH) {
+    a.t = t;
+    a.ncols = ncols;
+    rb_hash_foreach(select, ntuple_cut_i, (VALUE) &a);
+  } else {
+    t->sexpr = ntuple_compile(select, ncols, keep);
+  }
+}
+
+#ifdef HAVE_SYS_MMAN_H
+struct ntuple_scan_task {
+  const double *rows;           /* the mapped rows left */
+  size_t ncols, nrows;
+  ntuple_target *t;
+  size_t nt;
+  size_t nbins;                 /* of all the targets */
+  double *bins;                 /* nthreads x nbins */
+  double *vals;                 /* nthreads x NTUPLE_BLOCK */
+  size_t nthreads;
+};
+
+static int ntuple_scan_worker(void *data, size_t id)
+{
+  struct ntuple_scan_task *s = (struct ntuple_scan_task *) data;
+  double *bin, *vals = s->vals + id*NTUPLE_BLOCK;
+  size_t r = id*s->nrows/s->nthreads, r1 = (id + 1)*s->nrows/s->nthreads;
+  size_t m, i, k, nv;
+  const double *x;
+  ntuple_target *t;
+  mygsl_histogram_axis ax;
+  for (; r < r1; r += m) {
+    m = GSL_MIN(NTUPLE_BLOCK, r1 - r);
+    bin = s->bins + id*s->nbins;
+    for (k = 0; k < s->nt; k++) {
+      t = s->t + k;
+      for (i = 0, nv = 0; i < m; i++) {
+	x = s->rows + (r + i)*s->ncols;
+	if (!ntuple_selected(t, x)) continue;
+	vals[nv++] = t->vexpr ? rb_gsl_function_compiled_eval_multi(t->vexpr, x) : x[t->vcol];
+      }
+      ax.range = t->h->range; ax.n = t->h->n; ax.x = vals; ax.stride = 1;
+      mygsl_histogram_fill_nd_serial(bin, &ax, 1, NULL, 0, 1.0, nv);
+      bin += t->h->n;
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/* The parallel pass over the mapped file; 0 if it does not apply */
+static int ntuple_project_mapped(gsl_ntuple *n, ntuple_target *t, size_t nt)
+{
+  struct ntuple_scan_task s;
+  struct stat st;
+  long pos;
+  size_t len, k, j, i, off;
+  void *map;
+  int fd = fileno(n->file);
+  pos = ftell(n->file);
+  if (pos < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return 0;
+  if (n->size == 0 || n->size % sizeof(double) != 0 || pos % sizeof(double) != 0) return 0;
+  if (st.st_size <= (off_t) pos) return 0;
+  len = (size_t) st.st_size;
+  s.ncols = n->size/sizeof(double);
+  s.nrows = (len - (size_t) pos)/n->size;
+  s.nthreads = rb_gsl_parallel_nthreads(s.nrows*s.ncols, s.nrows/NTUPLE_PAR_ROWS);
+  if (s.nthreads <= 1) return 0;
+  map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) return 0;
+#ifdef MADV_SEQUENTIAL
+  madvise(map, len, MADV_SEQUENTIAL);
+#endif
+  s.rows = (const double *) ((const char *) map + pos);
+  s.t = t; s.nt = nt;
+  for (k = 0, s.nbins = 0; k < nt; k++) s.nbins += t[k].h->n;
+  s.bins = ALLOC_N(double, s.nthreads*s.nbins);
+  for (j = 0; j < s.nthreads*s.nbins; j++) s.bins[j] = 0.0;
+  s.vals = ALLOC_N(double, s.nthreads*NTUPLE_BLOCK);
+  rb_gsl_nogvl_parallel(ntuple_scan_worker, &s, s.nthreads);
+  munmap(map, len);
+  for (i = 0; i < s.nthreads; i++) {
+    for (k = 0, off = i*s.nbins; k < nt; off += t[k].h->n, k++)
+      for (j = 0; j < t[k].h->n; j++) t[k].h->bin[j] += s.bins[off + j];
+  }
+  xfree(s.vals);
+  xfree(s.bins);
+  fseek(n->file, 0L, SEEK_END);
+  return 1;
+}
+#endif
+
+/* Fills the nt targets from the rows left in the file of n */
+static void ntuple_project_native(gsl_ntuple *n, ntuple_target *t, size_t nt)
+{
+  struct ntuple_project_task p;
+  size_t k;
+#ifdef HAVE_SYS_MMAN_H
+  if (ntuple_project_mapped(n, t, nt)) return;
+#endif
+  p.fp = n->file;
+  p.rowsize = n->size;
+  p.ncols = n->size/sizeof(double);
+  p.t = t; p.nt = nt;
+  p.buf = ALLOC_N(double, p.ncols*NTUPLE_BLOCK);
+  for (k = 0; k < nt; k++) t[k].vals = ALLOC_N(double, NTUPLE_BLOCK);
+  do {
+    rb_gsl_nogvl_call(ntuple_project_block, &p, p.ncols*NTUPLE_BLOCK);
+    for (k = 0; k < nt; k++)
+      if (t[k].nvals) mygsl_histogram_fill(t[k].h, t[k].vals, 1, NULL, 0, 1.0, t[k].nvals);
+  } while (p.nrows == NTUPLE_BLOCK);
+  for (k = 0; k < nt; k++) xfree(t[k].vals);
+  xfree(p.buf);
+  if (ferror(n->file)) rb_sys_fail("ntuple read");
+}
+
+/*
+  method: project(h, value_fn, select_fn) with Ruby ValueFn / SelectFn,
+  project(h, value[, select]) evaluated natively (see above), or
+  project([[h1, value1, select1], [h2, value2], ...]) filling several
+  histograms in one pass over the file
+*/
+static VALUE rb_gsl_ntuple_project2(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h = NULL;
   gsl_ntuple *n = NULL;
   gsl_ntuple_value_fn *vfn = NULL;
   gsl_ntuple_select_fn *sfn = NULL;
+  ntuple_target *t;
+  VALUE keep, spec;
   int status;
-  size_t size;
-  CHECK_HISTOGRAM(hh);
+  size_t size, nt, k;
   Data_Get_Struct(obj, gsl_ntuple, n);
-  Data_Get_Struct(hh, gsl_histogram, h);
-  if (!rb_obj_is_kind_of(vvfn, cgsl_ntuple_value_fn)) 
-    rb_raise(rb_eTypeError, "argument 2: Ntuple::ValueFn expected");
-  Data_Get_Struct(vvfn, gsl_ntuple_value_fn, vfn);
-  if (!rb_obj_is_kind_of(vsfn, cgsl_ntuple_select_fn)) 
-    rb_raise(rb_eTypeError, "argument 3: Ntuple::SelectFn expected");
-  Data_Get_Struct(vsfn, gsl_ntuple_select_fn, sfn);
   size = n->size/sizeof(double);
-  rb_ary_store((VALUE) vfn->params, 2, INT2FIX(size));
-  rb_ary_store((VALUE) sfn->params, 2, INT2FIX(size));
-  status = gsl_ntuple_project(h, n, vfn, sfn);
-  return INT2FIX(status);
+  if (argc == 3 && rb_obj_is_kind_of(argv[1], cgsl_ntuple_value_fn)) {
+    CHECK_HISTOGRAM(argv[0]);
+    Data_Get_Struct(argv[0], gsl_histogram, h);
+    Data_Get_Struct(argv[1], gsl_ntuple_value_fn, vfn);
+    if (!rb_obj_is_kind_of(argv[2], cgsl_ntuple_select_fn)) 
+      rb_raise(rb_eTypeError, "argument 3: Ntuple::SelectFn expected");
+    Data_Get_Struct(argv[2], gsl_ntuple_select_fn, sfn);
+    rb_ary_store((VALUE) vfn->params, 2, INT2FIX(size));
+    rb_ary_store((VALUE) sfn->params, 2, INT2FIX(size));
+    status = gsl_ntuple_project(h, n, vfn, sfn);
+    return INT2FIX(status);
+  }
+  keep = rb_ary_new();
+  if (argc == 1) {
+    Check_Type(argv[0], T_ARRAY);
+    nt = RARRAY_LEN(argv[0]);
+    if (nt == 0 || nt > NTUPLE_TARGET_MAX)
+      rb_raise(rb_eArgError, "1 to %d histograms expected", NTUPLE_TARGET_MAX);
+    t = ALLOCA_N(ntuple_target, nt);
+    for (k = 0; k < nt; k++) {
+      spec = rb_ary_entry(argv[0], k);
+      Check_Type(spec, T_ARRAY);
+      if (RARRAY_LEN(spec) < 2 || RARRAY_LEN(spec) > 3)
+	rb_raise(rb_eArgError, "[histogram, value[, select]] expected");
+      ntuple_target_set(t + k, rb_ary_entry(spec, 0), rb_ary_entry(spec, 1),
+			rb_ary_entry(spec, 2), size, keep);
+    }
+  } else if (argc == 2 || argc == 3) {
+    nt = 1;
+    t = ALLOCA_N(ntuple_target, 1);
+    ntuple_target_set(t, argv[0], argv[1], argc == 3 ? argv[2] : Qnil, size, keep);
+  } else {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1, 2 or 3)", argc);
+  }
+  ntuple_project_native(n, t, nt);
+  RB_GC_GUARD(keep);
+  return INT2FIX(GSL_SUCCESS);
 }
 
+void Init_gsl_ntuple_columnar(VALUE module);
+void Init_gsl_ntuple_writer(VALUE module);
 void Init_gsl_ntuple(VALUE module)
 {
   cgsl_ntuple = rb_define_class_under(module, "Ntuple", cGSL_Object);
@@ -465,5 +762,8 @@ void Init_gsl_ntuple(VALUE module)
 		   rb_gsl_ntuple_value_fn_params, 0);
 
   rb_define_singleton_method(cgsl_ntuple, "project", rb_gsl_ntuple_project, 4);
-  rb_define_method(cgsl_ntuple, "project", rb_gsl_ntuple_project2, 3);
+  rb_define_method(cgsl_ntuple, "project", rb_gsl_ntuple_project2, -1);
+
+  Init_gsl_ntuple_columnar(cgsl_ntuple);
+  Init_gsl_ntuple_writer(cgsl_ntuple);
 }
@@ -0,0 +1,461 @@
+/*
+  ntuple_columnar.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Ntuple::Columnar: an ntuple file of rows of ncols doubles stored
+  column by column, so that projecting one column reads only that
+  column.  A gsl_ntuple file stores whole rows, and gsl_ntuple_project
+  reads every byte of every row.
+
+    w = GSL::Ntuple::Columnar.create("events.ntc", 3)   # [, chunk_rows]
+    w.write(GSL::Vector[x, y, z]); w.write(m)          # a row, n x 3 rows
+    w.close
+    GSL::Ntuple::Columnar.convert("events.dat", "events.ntc", 3)
+
+    r = GSL::Ntuple::Columnar.open("events.ntc")
+    r.size; r.ncols; r.column(1)                  # a Vector
+    r.project(h, 0)                               # Histogram from column 0
+    r.project(h2, [0, 1], :weight => 2)           # Histogram2d, weighted
+    r.close
+
+  The file is a 64-byte header (magic "GSLNTCOL", version, ncols, nrows,
+  chunk_rows, codec, a byte order mark) and then chunks of chunk_rows
+  rows (the last one possibly short), each holding its columns one
+  after another as native doubles.  Where mmap is available a file
+  opened for reading is mapped, and only the pages of the columns used
+  are read; elsewhere the column blocks are read with fread.  Codec 0
+  (raw doubles) is the only one written; others are rejected.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_histogram.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/mman.h>
+#endif
+
+static VALUE cgsl_ntuple_columnar;
+
+#define COLNT_MAGIC "GSLNTCOL"
+#define COLNT_VERSION 1
+#define COLNT_HEADER 64
+#define COLNT_BOM 0x01020304
+#define COLNT_CHUNK 65536
+
+typedef struct {
+  char magic[8];
+  uint32_t version, ncols;
+  uint64_t nrows, chunk_rows;
+  uint32_t codec, bom;
+  char reserved[24];
+} mygsl_colnt_header;
+
+typedef struct {
+  FILE *fp;
+  int writing;
+  size_t ncols, nrows, chunk_rows;
+  double *buf;                  /* writer: the chunk being filled */
+  size_t nbuf;                  /* its rows */
+  void *map;                    /* reader: the mapping, or NULL */
+  size_t maplen;
+} mygsl_colnt;
+
+static void colnt_write_header(mygsl_colnt *t)
+{
+  mygsl_colnt_header hd;
+  memset(&hd, 0, sizeof(hd));
+  memcpy(hd.magic, COLNT_MAGIC, 8);
+  hd.version = COLNT_VERSION;
+  hd.ncols = (uint32_t) t->ncols;
+  hd.nrows = t->nrows;
+  hd.chunk_rows = t->chunk_rows;
+  hd.codec = 0;
+  hd.bom = COLNT_BOM;
+  fseek(t->fp, 0L, SEEK_SET);
+  fwrite(&hd, sizeof(hd), 1, t->fp);
+  fseek(t->fp, 0L, SEEK_END);
+}
+
+/* Appends the buffered rows as one chunk */
+static int colnt_flush(mygsl_colnt *t)
+{
+  size_t j;
+  if (t->nbuf == 0) return 0;
+  for (j = 0; j < t->ncols; j++)
+    if (fwrite(t->buf + j*t->chunk_rows, sizeof(double), t->nbuf, t->fp) != t->nbuf)
+      return -1;
+  t->nrows += t->nbuf;
+  t->nbuf = 0;
+  return 0;
+}
+
+/* Flushes and closes; the object stays valid but unusable */
+static int colnt_close(mygsl_colnt *t)
+{
+  int status = 0;
+  if (t->fp == NULL) return 0;
+  if (t->writing) {
+    status = colnt_flush(t);
+    colnt_write_header(t);
+  }
+#ifdef HAVE_SYS_MMAN_H
+  if (t->map) munmap(t->map, t->maplen);
+#endif
+  t->map = NULL;
+  if (fclose(t->fp) != 0) status = -1;
+  t->fp = NULL;
+  if (t->buf) xfree(t->buf);
+  t->buf = NULL;
+  return status;
+}
+
+static void colnt_free(mygsl_colnt *t)
+{
+  colnt_close(t);
+  xfree(t);
+}
+
+static int colnt_append(mygsl_colnt *t, const double *x, size_t stride)
+{
+  size_t j;
+  for (j = 0; j < t->ncols; j++) t->buf[j*t->chunk_rows + t->nbuf] = x[j*stride];
+  if (++t->nbuf == t->chunk_rows) return colnt_flush(t);
+  return 0;
+}
+
+/* Rows in chunk k */
+static size_t colnt_chunk_rows(const mygsl_colnt *t, size_t k)
+{
+  return GSL_MIN(t->chunk_rows, t->nrows - k*t->chunk_rows);
+}
+
+/* Column j of chunk k: into the mapping, or read into buf */
+static const double* colnt_block(const mygsl_colnt *t, size_t k, size_t j, double *buf)
+{
+  size_t m = colnt_chunk_rows(t, k);
+  size_t off = COLNT_HEADER + sizeof(double)*(k*t->chunk_rows*t->ncols + j*m);
+  if (t->map) return (const double*) ((const char*) t->map + off);
+  if (fseek(t->fp, (long) off, SEEK_SET) != 0 || fread(buf, sizeof(double), m, t->fp) != m)
+    rb_raise(rb_eIOError, "short read in columnar ntuple");
+  return buf;
+}
+
+/*****/
+
+static mygsl_colnt* get_colnt(VALUE obj, int writing)
+{
+  mygsl_colnt *t = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_ntuple_columnar))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Ntuple::Columnar expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_colnt, t);
+  if (t->fp == NULL) rb_raise(rb_eIOError, "closed ntuple");
+  if (writing >= 0 && t->writing != writing)
+    rb_raise(rb_eIOError, "ntuple not opened for %s", writing ? "writing" : "reading");
+  return t;
+}
+
+static VALUE colnt_new(VALUE klass, FILE *fp, int writing)
+{
+  mygsl_colnt *t = NULL;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_colnt, 0, colnt_free, t);
+  t->fp = fp;
+  t->writing = writing;
+  t->buf = NULL;
+  t->map = NULL;
+  t->nbuf = 0;
+  return obj;
+}
+
+static VALUE colnt_create(VALUE klass, const char *name, size_t ncols, size_t chunk_rows)
+{
+  mygsl_colnt *t = NULL;
+  FILE *fp;
+  VALUE obj;
+  if (ncols == 0 || ncols > 0xffffffffUL) rb_raise(rb_eArgError, "bad number of columns");
+  if (chunk_rows == 0) rb_raise(rb_eArgError, "chunk_rows must be positive");
+  fp = fopen(name, "w+b");
+  if (fp == NULL) rb_sys_fail(name);
+  obj = colnt_new(klass, fp, 1);
+  Data_Get_Struct(obj, mygsl_colnt, t);
+  t->ncols = ncols;
+  t->nrows = 0;
+  t->chunk_rows = chunk_rows;
+  t->buf = ALLOC_N(double, ncols*chunk_rows);
+  colnt_write_header(t);
+  return obj;
+}
+
+/* create(path, ncols[, chunk_rows]) */
+static VALUE rb_gsl_ntuple_columnar_create(int argc, VALUE *argv, VALUE klass)
+{
+  size_t chunk_rows = COLNT_CHUNK;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  if (argc == 3) chunk_rows = NUM2SIZET(argv[2]);
+  return colnt_create(klass, StringValuePtr(argv[0]), NUM2SIZET(argv[1]), chunk_rows);
+}
+
+static VALUE rb_gsl_ntuple_columnar_open(VALUE klass, VALUE path)
+{
+  mygsl_colnt *t = NULL;
+  mygsl_colnt_header hd;
+  const char *name = StringValuePtr(path);
+  FILE *fp;
+  VALUE obj;
+  long len;
+  fp = fopen(name, "rb");
+  if (fp == NULL) rb_sys_fail(name);
+  obj = colnt_new(klass, fp, 0);
+  Data_Get_Struct(obj, mygsl_colnt, t);
+  if (fread(&hd, sizeof(hd), 1, fp) != 1 || memcmp(hd.magic, COLNT_MAGIC, 8) != 0) {
+    colnt_close(t);
+    rb_raise(rb_eIOError, "%s: not a columnar ntuple", name);
+  }
+  if (hd.bom != COLNT_BOM || hd.version != COLNT_VERSION || hd.codec != 0) {
+    colnt_close(t);
+    rb_raise(rb_eIOError, "%s: unsupported byte order, version or codec", name);
+  }
+  t->ncols = hd.ncols;
+  t->nrows = (size_t) hd.nrows;
+  t->chunk_rows = (size_t) hd.chunk_rows;
+  fseek(fp, 0L, SEEK_END);
+  len = ftell(fp);
+  if (t->ncols == 0 || t->chunk_rows == 0
+      || len < 0 || (size_t) len < COLNT_HEADER + sizeof(double)*t->ncols*t->nrows) {
+    colnt_close(t);
+    rb_raise(rb_eIOError, "%s: truncated columnar ntuple", name);
+  }
+#ifdef HAVE_SYS_MMAN_H
+  if (t->nrows > 0) {
+    t->maplen = (size_t) len;
+    t->map = mmap(NULL, t->maplen, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (t->map == MAP_FAILED) t->map = NULL;
+  }
+#endif
+  return obj;
+}
+
+/* write(row): a Vector or Array of ncols values, or an n x ncols Matrix */
+static VALUE rb_gsl_ntuple_columnar_write(VALUE obj, VALUE row)
+{
+  mygsl_colnt *t = get_colnt(obj, 1);
+  gsl_matrix *m = NULL;
+  gsl_vector *v = NULL;
+  size_t i;
+  int status = 0;
+  if (MATRIX_P(row)) {
+    Data_Get_Struct(row, gsl_matrix, m);
+    if (m->size2 != t->ncols)
+      rb_raise(rb_eArgError, "matrix has %d columns, %d expected", (int) m->size2, (int) t->ncols);
+    for (i = 0; i < m->size1 && status == 0; i++)
+      status = colnt_append(t, m->data + i*m->tda, 1);
+  } else {
+    if (TYPE(row) == T_ARRAY) {
+      v = make_cvector_from_rarray(row);
+      row = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    }
+    CHECK_VECTOR(row);
+    Data_Get_Struct(row, gsl_vector, v);
+    if (v->size != t->ncols)
+      rb_raise(rb_eArgError, "row has %d values, %d expected", (int) v->size, (int) t->ncols);
+    status = colnt_append(t, v->data, v->stride);
+  }
+  if (status) rb_sys_fail("columnar ntuple write");
+  return obj;
+}
+
+static VALUE rb_gsl_ntuple_columnar_close(VALUE obj)
+{
+  mygsl_colnt *t = NULL;
+  Data_Get_Struct(obj, mygsl_colnt, t);
+  if (colnt_close(t)) rb_sys_fail("columnar ntuple close");
+  return Qnil;
+}
+
+static VALUE rb_gsl_ntuple_columnar_closed(VALUE obj)
+{
+  mygsl_colnt *t = NULL;
+  Data_Get_Struct(obj, mygsl_colnt, t);
+  return t->fp == NULL ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_ntuple_columnar_size(VALUE obj)
+{
+  mygsl_colnt *t = get_colnt(obj, -1);
+  return SIZET2NUM(t->nrows + t->nbuf);
+}
+
+static VALUE rb_gsl_ntuple_columnar_ncols(VALUE obj)
+{
+  return SIZET2NUM(get_colnt(obj, -1)->ncols);
+}
+
+static VALUE rb_gsl_ntuple_columnar_chunk_rows(VALUE obj)
+{
+  return SIZET2NUM(get_colnt(obj, -1)->chunk_rows);
+}
+
+static VALUE rb_gsl_ntuple_columnar_mapped(VALUE obj)
+{
+  return get_colnt(obj, -1)->map ? Qtrue : Qfalse;
+}
+
+static size_t colnt_column_index(const mygsl_colnt *t, VALUE j)
+{
+  long c = NUM2LONG(j);
+  if (c < 0) c += (long) t->ncols;
+  if (c < 0 || (size_t) c >= t->ncols)
+    rb_raise(rb_eIndexError, "column %ld out of range 0...%d", NUM2LONG(j), (int) t->ncols);
+  return (size_t) c;
+}
+
+static VALUE rb_gsl_ntuple_columnar_column(VALUE obj, VALUE j)
+{
+  mygsl_colnt *t = get_colnt(obj, 0);
+  size_t c = colnt_column_index(t, j), k, nchunks, m;
+  gsl_vector *v;
+  const double *x;
+  if (t->nrows == 0) rb_raise(rb_eRuntimeError, "ntuple is empty");
+  v = gsl_vector_alloc(t->nrows);
+  nchunks = (t->nrows + t->chunk_rows - 1)/t->chunk_rows;
+  for (k = 0; k < nchunks; k++) {
+    m = colnt_chunk_rows(t, k);
+    x = colnt_block(t, k, c, v->data + k*t->chunk_rows);
+    if (x != v->data + k*t->chunk_rows) memcpy(v->data + k*t->chunk_rows, x, m*sizeof(double));
+  }
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+/*
+  project(h, cols[, :weight => col]): fills a Histogram from column
+  cols, or a Histogram2d / Histogram3d from the columns in the Array
+  cols, one chunk at a time; returns h
+*/
+static VALUE rb_gsl_ntuple_columnar_project(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_colnt *t = get_colnt(obj, 0);
+  mygsl_histogram_axis ax[3];
+  gsl_histogram *h1 = NULL;
+  gsl_histogram2d *h2 = NULL;
+  mygsl_histogram3d *h3 = NULL;
+  VALUE hh, cols, opts = Qnil, vw;
+  size_t col[3], naxes, a, k, nchunks, m, wcol = 0;
+  double *bin, *buf[4] = {NULL, NULL, NULL, NULL};
+  const double *w;
+  int weighted;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  hh = argv[0]; cols = argv[1];
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+  }
+  vw = NIL_P(opts) ? Qnil : rb_hash_aref(opts, ID2SYM(rb_intern("weight")));
+  weighted = !NIL_P(vw);
+  if (weighted) wcol = colnt_column_index(t, vw);
+  if (HISTOGRAM_P(hh)) {
+    naxes = 1;
+    Data_Get_Struct(hh, gsl_histogram, h1);
+    ax[0].range = h1->range; ax[0].n = h1->n;
+    bin = h1->bin;
+  } else if (HISTOGRAM2D_P(hh)) {
+    naxes = 2;
+    Data_Get_Struct(hh, gsl_histogram2d, h2);
+    ax[0].range = h2->xrange; ax[0].n = h2->nx;
+    ax[1].range = h2->yrange; ax[1].n = h2->ny;
+    bin = h2->bin;
+  } else if (HISTOGRAM3D_P(hh)) {
+    naxes = 3;
+    Data_Get_Struct(hh, mygsl_histogram3d, h3);
+    ax[0].range = h3->xrange; ax[0].n = h3->nx;
+    ax[1].range = h3->yrange; ax[1].n = h3->ny;
+    ax[2].range = h3->zrange; ax[2].n = h3->nz;
+    bin = h3->bin;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Histogram, Histogram2d or Histogram3d expected)",
+	     rb_class2name(CLASS_OF(hh)));
+  }
+  if (naxes == 1 && TYPE(cols) != T_ARRAY) {
+    col[0] = colnt_column_index(t, cols);
+  } else {
+    Check_Type(cols, T_ARRAY);
+    if ((size_t) RARRAY_LEN(cols) != naxes)
+      rb_raise(rb_eArgError, "%d columns given for a %dd histogram",
+	       (int) RARRAY_LEN(cols), (int) naxes);
+    for (a = 0; a < naxes; a++) col[a] = colnt_column_index(t, rb_ary_entry(cols, a));
+  }
+  if (t->map == NULL)
+    for (a = 0; a <= naxes; a++) buf[a] = ALLOC_N(double, t->chunk_rows);
+  nchunks = (t->nrows + t->chunk_rows - 1)/t->chunk_rows;
+  for (k = 0; k < nchunks; k++) {
+    m = colnt_chunk_rows(t, k);
+    for (a = 0; a < naxes; a++) {
+      ax[a].x = colnt_block(t, k, col[a], buf[a]);
+      ax[a].stride = 1;
+    }
+    w = weighted ? colnt_block(t, k, wcol, buf[naxes]) : NULL;
+    mygsl_histogram_fill_nd(bin, ax, naxes, w, 1, 1.0, m);
+  }
+  for (a = 0; a <= naxes; a++) if (buf[a]) xfree(buf[a]);
+  if (naxes > 1) rb_gsl_histogram_modified(hh);
+  return hh;
+}
+
+/* convert(src, dst, ncols[, chunk_rows]): a gsl_ntuple file of rows of
+   ncols doubles to the columnar format */
+static VALUE rb_gsl_ntuple_columnar_convert(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_colnt *t = NULL;
+  size_t ncols, chunk_rows = COLNT_CHUNK, i, nread;
+  const char *src;
+  double *rows;
+  FILE *fp;
+  VALUE obj;
+  int status = 0;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  src = StringValuePtr(argv[0]);
+  ncols = NUM2SIZET(argv[2]);
+  if (argc == 4) chunk_rows = NUM2SIZET(argv[3]);
+  fp = fopen(src, "rb");
+  if (fp == NULL) rb_sys_fail(src);
+  obj = colnt_create(klass, StringValuePtr(argv[1]), ncols, chunk_rows);
+  Data_Get_Struct(obj, mygsl_colnt, t);
+  rows = ALLOC_N(double, ncols*chunk_rows);
+  while (status == 0 && (nread = fread(rows, ncols*sizeof(double), chunk_rows, fp)) > 0)
+    for (i = 0; i < nread && status == 0; i++) status = colnt_append(t, rows + i*ncols, 1);
+  xfree(rows);
+  fclose(fp);
+  if (colnt_close(t) || status) rb_sys_fail(StringValuePtr(argv[1]));
+  return Qnil;
+}
+
+void Init_gsl_ntuple_columnar(VALUE module)
+{
+  cgsl_ntuple_columnar = rb_define_class_under(module, "Columnar", cGSL_Object);
+  rb_define_singleton_method(cgsl_ntuple_columnar, "create", rb_gsl_ntuple_columnar_create, -1);
+  rb_define_singleton_method(cgsl_ntuple_columnar, "open", rb_gsl_ntuple_columnar_open, 1);
+  rb_define_singleton_method(cgsl_ntuple_columnar, "convert", rb_gsl_ntuple_columnar_convert, -1);
+  rb_define_method(cgsl_ntuple_columnar, "write", rb_gsl_ntuple_columnar_write, 1);
+  rb_define_alias(cgsl_ntuple_columnar, "<<", "write");
+  rb_define_method(cgsl_ntuple_columnar, "close", rb_gsl_ntuple_columnar_close, 0);
+  rb_define_method(cgsl_ntuple_columnar, "closed?", rb_gsl_ntuple_columnar_closed, 0);
+  rb_define_method(cgsl_ntuple_columnar, "size", rb_gsl_ntuple_columnar_size, 0);
+  rb_define_method(cgsl_ntuple_columnar, "ncols", rb_gsl_ntuple_columnar_ncols, 0);
+  rb_define_method(cgsl_ntuple_columnar, "chunk_rows", rb_gsl_ntuple_columnar_chunk_rows, 0);
+  rb_define_method(cgsl_ntuple_columnar, "mapped?", rb_gsl_ntuple_columnar_mapped, 0);
+  rb_define_method(cgsl_ntuple_columnar, "column", rb_gsl_ntuple_columnar_column, 1);
+  rb_define_method(cgsl_ntuple_columnar, "project", rb_gsl_ntuple_columnar_project, -1);
+}
@@ -0,0 +1,450 @@
+/*
+  ntuple_writer.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Ntuple::Writer: writes a gsl_ntuple file (rows of ncols doubles,
+  readable by GSL::Ntuple.open) through a ring buffer of rows drained by
+  a native thread, so that a row costs the caller a copy instead of an
+  fwrite.
+
+    w = GSL::Ntuple::Writer.create("events.dat", 3, :buffer => 65536)
+    w.write(GSL::Vector[x, y, z]); w << [x, y, z]; w.write(m)  # n x 3
+    w.flush                        # every row so far is in the file
+    w.close
+
+    v = GSL::Vector.alloc(3)
+    GSL::Ntuple::Writer.create("events.dat", v) do |w|
+      v[0] = x; v[1] = y; v[2] = z
+      w.bookdata                   # writes v, as Ntuple#bookdata
+    end
+
+  The thread writes once the buffer holds a quarter of its rows, or on
+  flush and close; a writer whose buffer is full waits for room with
+  the GVL released.  A write error is raised by the next write, flush
+  or close.  Without pthreads the buffer is written by the caller when
+  it fills.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#ifdef HAVE_RUBY_THREAD_H
+#include "ruby/thread.h"
+#endif
+#include <errno.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#define NTW_THREAD
+#endif
+
+static VALUE cgsl_ntuple_writer;
+
+#define NTW_BUFFER 65536
+
+typedef struct {
+  FILE *fp;
+  size_t ncols, cap, batch;
+  double *buf;
+  size_t head, tail;            /* rows put, rows written; slot = count % cap */
+  int err;                      /* errno of a failed write */
+  VALUE data;                   /* the Vector for bookdata, or Qnil */
+#ifdef NTW_THREAD
+  pthread_mutex_t lock;
+  pthread_cond_t more, room;
+  pthread_t th;
+  int stop, flush;
+#endif
+} mygsl_ntw;
+
+/* Writes the rows [tail, tail + m) from their slots, m not wrapping */
+static int ntw_write_rows(mygsl_ntw *w, size_t tail, size_t m)
+{
+  if (fwrite(w->buf + (tail % w->cap)*w->ncols, sizeof(double)*w->ncols, m, w->fp) != m)
+    return errno ? errno : EIO;
+  return 0;
+}
+
+#ifdef NTW_THREAD
+static void* ntw_thread(void *p)
+{
+  mygsl_ntw *w = (mygsl_ntw *) p;
+  size_t tail, m;
+  int err;
+  pthread_mutex_lock(&w->lock);
+  for (;;) {
+    while (!w->stop && !w->flush && w->head - w->tail < w->batch)
+      pthread_cond_wait(&w->more, &w->lock);
+    if (w->head == w->tail) {
+      if (w->flush) {
+	if (fflush(w->fp) != 0 && w->err == 0) w->err = errno ? errno : EIO;
+	w->flush = 0;
+	pthread_cond_broadcast(&w->room);
+      }
+      if (w->stop) break;
+      continue;
+    }
+    tail = w->tail;
+    m = GSL_MIN(w->head - tail, w->cap - tail % w->cap);
+    pthread_mutex_unlock(&w->lock);
+    err = w->err ? 0 : ntw_write_rows(w, tail, m);   /* rows after an error are dropped */
+    pthread_mutex_lock(&w->lock);
+    if (err && w->err == 0) w->err = err;
+    w->tail += m;
+    pthread_cond_broadcast(&w->room);
+  }
+  pthread_mutex_unlock(&w->lock);
+  return NULL;
+}
+
+/* Blocks until the buffer has room, or until a requested flush is done */
+static void* ntw_wait_room(void *p)
+{
+  mygsl_ntw *w = (mygsl_ntw *) p;
+  pthread_mutex_lock(&w->lock);
+  while (w->err == 0 && (w->head - w->tail == w->cap || w->flush))
+    pthread_cond_wait(&w->room, &w->lock);
+  pthread_mutex_unlock(&w->lock);
+  return NULL;
+}
+
+static void* ntw_join(void *p)
+{
+  mygsl_ntw *w = (mygsl_ntw *) p;
+  pthread_join(w->th, NULL);
+  return NULL;
+}
+
+static void ntw_blocking(void *(*func)(void *), mygsl_ntw *w)
+{
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+  rb_thread_call_without_gvl(func, w, NULL, NULL);
+#else
+  (*func)(w);
+#endif
+}
+#else
+/* Without a thread the caller writes the buffered rows */
+static void ntw_drain(mygsl_ntw *w)
+{
+  size_t m;
+  while (w->head != w->tail) {
+    m = GSL_MIN(w->head - w->tail, w->cap - w->tail % w->cap);
+    if (w->err == 0) w->err = ntw_write_rows(w, w->tail, m);
+    w->tail += m;
+  }
+}
+#endif
+
+/* Raises a pending write error once */
+static void ntw_raise(mygsl_ntw *w)
+{
+  int err;
+#ifdef NTW_THREAD
+  if (w->fp) pthread_mutex_lock(&w->lock);
+#endif
+  err = w->err;
+  w->err = 0;
+#ifdef NTW_THREAD
+  if (w->fp) pthread_mutex_unlock(&w->lock);
+#endif
+  if (err) rb_syserr_fail(err, "ntuple write");
+}
+
+/* Copies n rows of ncols values, row i at x + i*tda */
+static void ntw_put(mygsl_ntw *w, const double *x, size_t tda, size_t stride, size_t n)
+{
+  size_t k, i, j, slot, before;
+  double *dst;
+  while (n > 0) {
+#ifdef NTW_THREAD
+    pthread_mutex_lock(&w->lock);
+#endif
+    if (w->err) {
+#ifdef NTW_THREAD
+      pthread_mutex_unlock(&w->lock);
+#endif
+      break;
+    }
+    before = w->head - w->tail;
+    k = GSL_MIN(n, w->cap - before);
+    for (i = 0; i < k; i++, x += tda) {
+      slot = (w->head + i) % w->cap;
+      dst = w->buf + slot*w->ncols;
+      if (stride == 1) memcpy(dst, x, sizeof(double)*w->ncols);
+      else for (j = 0; j < w->ncols; j++) dst[j] = x[j*stride];
+    }
+    w->head += k;
+    n -= k;
+#ifdef NTW_THREAD
+    if (before < w->batch && before + k >= w->batch) pthread_cond_signal(&w->more);
+    pthread_mutex_unlock(&w->lock);
+    if (n > 0) ntw_blocking(ntw_wait_room, w);
+#else
+    if (w->head - w->tail == w->cap) ntw_drain(w);
+#endif
+  }
+  ntw_raise(w);
+}
+
+static void ntw_flush(mygsl_ntw *w)
+{
+#ifdef NTW_THREAD
+  pthread_mutex_lock(&w->lock);
+  w->flush = 1;
+  pthread_cond_signal(&w->more);
+  pthread_mutex_unlock(&w->lock);
+  ntw_blocking(ntw_wait_room, w);
+#else
+  ntw_drain(w);
+  if (fflush(w->fp) != 0 && w->err == 0) w->err = errno ? errno : EIO;
+#endif
+}
+
+/* Writes what is buffered, stops the thread and closes the file */
+static int ntw_close(mygsl_ntw *w, int blocking)
+{
+  if (w->fp == NULL) return 0;
+#ifdef NTW_THREAD
+  pthread_mutex_lock(&w->lock);
+  w->stop = 1;
+  pthread_cond_signal(&w->more);
+  pthread_mutex_unlock(&w->lock);
+  if (blocking) ntw_blocking(ntw_join, w);
+  else ntw_join(w);
+  pthread_mutex_destroy(&w->lock);
+  pthread_cond_destroy(&w->more);
+  pthread_cond_destroy(&w->room);
+#else
+  ntw_drain(w);
+#endif
+  if (fclose(w->fp) != 0 && w->err == 0) w->err = errno ? errno : EIO;
+  w->fp = NULL;
+  xfree(w->buf);
+  w->buf = NULL;
+  return w->err;
+}
+
+static void ntw_mark(mygsl_ntw *w)
+{
+  rb_gc_mark(w->data);
+}
+
+static void ntw_free(mygsl_ntw *w)
+{
+  ntw_close(w, 0);
+  xfree(w);
+}
+
+static mygsl_ntw* get_ntw(VALUE obj)
+{
+  mygsl_ntw *w = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_ntuple_writer))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Ntuple::Writer expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_ntw, w);
+  if (w->fp == NULL) rb_raise(rb_eIOError, "closed ntuple writer");
+  return w;
+}
+
+static VALUE rb_gsl_ntuple_writer_close(VALUE obj)
+{
+  mygsl_ntw *w = NULL;
+  Data_Get_Struct(obj, mygsl_ntw, w);
+  if (w->fp == NULL) return Qnil;
+  ntw_close(w, 1);
+  ntw_raise(w);
+  return Qnil;
+}
+
+/*
+  create(path, ncols_or_vector[, opts]) with opts :buffer (rows,
+  default 65536) and :append; with a block, yields the writer and
+  closes it
+*/
+static VALUE rb_gsl_ntuple_writer_create(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_ntw *w = NULL;
+  gsl_vector *v = NULL;
+  VALUE obj, opts = Qnil, val, data = Qnil;
+  size_t ncols, cap = NTW_BUFFER;
+  const char *name;
+  int append = 0;
+  FILE *fp;
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+    val = rb_hash_aref(opts, ID2SYM(rb_intern("buffer")));
+    if (!NIL_P(val)) cap = NUM2SIZET(val);
+    append = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("append"))));
+  } else if (argc != 2) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  }
+  name = StringValuePtr(argv[0]);
+  if (VECTOR_P(argv[1])) {
+    Data_Get_Struct(argv[1], gsl_vector, v);
+    ncols = v->size;
+    data = argv[1];
+  } else {
+    ncols = NUM2SIZET(argv[1]);
+  }
+  if (ncols == 0) rb_raise(rb_eArgError, "bad number of columns");
+  if (cap == 0) rb_raise(rb_eArgError, "buffer must hold at least one row");
+  fp = fopen(name, append ? "ab" : "wb");
+  if (fp == NULL) rb_sys_fail(name);
+  obj = Data_Make_Struct(klass, mygsl_ntw, ntw_mark, ntw_free, w);
+  w->data = data;
+  w->ncols = ncols;
+  w->cap = cap;
+  w->batch = GSL_MAX(cap/4, 1);
+  w->head = w->tail = 0;
+  w->err = 0;
+  w->buf = ALLOC_N(double, ncols*cap);
+  w->fp = fp;
+#ifdef NTW_THREAD
+  w->stop = w->flush = 0;
+  pthread_mutex_init(&w->lock, NULL);
+  pthread_cond_init(&w->more, NULL);
+  pthread_cond_init(&w->room, NULL);
+  if (pthread_create(&w->th, NULL, ntw_thread, w) != 0) {
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->more);
+    pthread_cond_destroy(&w->room);
+    fclose(w->fp);
+    w->fp = NULL;
+    xfree(w->buf);
+    w->buf = NULL;
+    rb_raise(rb_eRuntimeError, "cannot start the ntuple writer thread");
+  }
+#endif
+  if (rb_block_given_p())
+    return rb_ensure(rb_yield, obj, rb_gsl_ntuple_writer_close, obj);
+  return obj;
+}
+
+/*
+  write([row]): a Vector or Array of ncols values, or an n x ncols
+  Matrix; without an argument the Vector given to create
+*/
+static VALUE rb_gsl_ntuple_writer_write(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_ntw *w = get_ntw(obj);
+  gsl_matrix *m = NULL;
+  gsl_vector *v = NULL;
+  VALUE row;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 0) {
+    if (NIL_P(w->data)) rb_raise(rb_eArgError, "no row given and no Vector bound");
+    row = w->data;
+  } else {
+    row = argv[0];
+  }
+  if (MATRIX_P(row)) {
+    Data_Get_Struct(row, gsl_matrix, m);
+    if (m->size2 != w->ncols)
+      rb_raise(rb_eArgError, "matrix has %d columns, %d expected", (int) m->size2, (int) w->ncols);
+    ntw_put(w, m->data, m->tda, 1, m->size1);
+  } else {
+    if (TYPE(row) == T_ARRAY) {
+      v = make_cvector_from_rarray(row);
+      row = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    }
+    CHECK_VECTOR(row);
+    Data_Get_Struct(row, gsl_vector, v);
+    if (v->size != w->ncols)
+      rb_raise(rb_eArgError, "row has %d values, %d expected", (int) v->size, (int) w->ncols);
+    ntw_put(w, v->data, 0, v->stride, 1);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_ntuple_writer_bookdata(VALUE obj)
+{
+  return rb_gsl_ntuple_writer_write(0, NULL, obj);
+}
+
+static VALUE rb_gsl_ntuple_writer_flush(VALUE obj)
+{
+  mygsl_ntw *w = get_ntw(obj);
+  ntw_flush(w);
+  ntw_raise(w);
+  return obj;
+}
+
+static VALUE rb_gsl_ntuple_writer_closed(VALUE obj)
+{
+  mygsl_ntw *w = NULL;
+  Data_Get_Struct(obj, mygsl_ntw, w);
+  return w->fp == NULL ? Qtrue : Qfalse;
+}
+
+/* Rows written so far, including those still buffered */
+static VALUE rb_gsl_ntuple_writer_size(VALUE obj)
+{
+  mygsl_ntw *w = NULL;
+  Data_Get_Struct(obj, mygsl_ntw, w);
+  return SIZET2NUM(w->head);
+}
+
+/* Rows not yet handed to the file */
+static VALUE rb_gsl_ntuple_writer_pending(VALUE obj)
+{
+  mygsl_ntw *w = get_ntw(obj);
+  size_t n;
+#ifdef NTW_THREAD
+  pthread_mutex_lock(&w->lock);
+#endif
+  n = w->head - w->tail;
+#ifdef NTW_THREAD
+  pthread_mutex_unlock(&w->lock);
+#endif
+  return SIZET2NUM(n);
+}
+
+static VALUE rb_gsl_ntuple_writer_ncols(VALUE obj)
+{
+  mygsl_ntw *w = NULL;
+  Data_Get_Struct(obj, mygsl_ntw, w);
+  return SIZET2NUM(w->ncols);
+}
+
+static VALUE rb_gsl_ntuple_writer_buffer(VALUE obj)
+{
+  mygsl_ntw *w = NULL;
+  Data_Get_Struct(obj, mygsl_ntw, w);
+  return SIZET2NUM(w->cap);
+}
+
+static VALUE rb_gsl_ntuple_writer_threaded(VALUE obj)
+{
+#ifdef NTW_THREAD
+  return Qtrue;
+#else
+  return Qfalse;
+#endif
+}
+
+void Init_gsl_ntuple_writer(VALUE module)
+{
+  cgsl_ntuple_writer = rb_define_class_under(module, "Writer", cGSL_Object);
+  rb_define_singleton_method(cgsl_ntuple_writer, "create", rb_gsl_ntuple_writer_create, -1);
+  rb_define_singleton_method(cgsl_ntuple_writer, "open", rb_gsl_ntuple_writer_create, -1);
+  rb_define_method(cgsl_ntuple_writer, "write", rb_gsl_ntuple_writer_write, -1);
+  rb_define_method(cgsl_ntuple_writer, "<<", rb_gsl_ntuple_writer_write, -1);
+  rb_define_method(cgsl_ntuple_writer, "bookdata", rb_gsl_ntuple_writer_bookdata, 0);
+  rb_define_method(cgsl_ntuple_writer, "flush", rb_gsl_ntuple_writer_flush, 0);
+  rb_define_method(cgsl_ntuple_writer, "close", rb_gsl_ntuple_writer_close, 0);
+  rb_define_method(cgsl_ntuple_writer, "closed?", rb_gsl_ntuple_writer_closed, 0);
+  rb_define_method(cgsl_ntuple_writer, "size", rb_gsl_ntuple_writer_size, 0);
+  rb_define_method(cgsl_ntuple_writer, "pending", rb_gsl_ntuple_writer_pending, 0);
+  rb_define_method(cgsl_ntuple_writer, "ncols", rb_gsl_ntuple_writer_ncols, 0);
+  rb_define_method(cgsl_ntuple_writer, "buffer_size", rb_gsl_ntuple_writer_buffer, 0);
+  rb_define_method(cgsl_ntuple_writer, "threaded?", rb_gsl_ntuple_writer_threaded, 0);
+}
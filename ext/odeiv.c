@@ -12,6 +12,7 @@
 #include "rb_gsl_odeiv.h"
 #include "rb_gsl_array.h"
 #include "rb_gsl_function.h"
+#include "rb_gsl_probes.h"
 
 #ifndef CHECK_SYSTEM
 #define CHECK_SYSTEM(x) if(CLASS_OF(x)!=cgsl_odeiv_system)\
@@ -78,71 +79,213 @@ typedef struct __rb_gsl_odeiv_evolve {
 static int calc_func(double t, const double y[], double dydt[], void *data);
 static int calc_jac(double t, const double y[], double *dfdy, double dfdt[], void *data);
 
+/*
+  sys->params is an Array
+    [proc, jacobian proc, dimension, params,
+     y view, dydt view, dfdy view, dfdt view, compiled functions]
+  The view objects passed to the procs are created once per System and
+  repointed at GSL's work arrays on each call, so evaluating the right
+  hand side does not allocate Ruby objects (apart from t, on platforms
+  without flonums). The views are emptied when the call returns.
+*/
+enum {
+  ODEIV_SYS_FUNC = 0,
+  ODEIV_SYS_JAC,
+  ODEIV_SYS_DIM,
+  ODEIV_SYS_PARAMS,
+  ODEIV_SYS_VY,
+  ODEIV_SYS_VDYDT,
+  ODEIV_SYS_VJAC,
+  ODEIV_SYS_VDFDT,
+  ODEIV_SYS_NATIVE,
+};
+
+static VALUE odeiv_sys_vector_view(VALUE ary, int i, VALUE klass, double *data,
+				   size_t dim)
+{
+  VALUE vv;
+  gsl_vector_view *v = NULL;
+  vv = rb_ary_entry(ary, i);
+  if (NIL_P(vv)) {
+    v = gsl_vector_view_alloc();
+    v->vector.stride = 1;
+    v->vector.block = NULL;
+    vv = Data_Wrap_Struct(klass, 0, gsl_vector_view_free, v);
+    rb_ary_store(ary, i, vv);
+  } else {
+    Data_Get_Struct(vv, gsl_vector_view, v);
+  }
+  v->vector.data = data;
+  v->vector.size = dim;
+  return vv;
+}
+
+static VALUE odeiv_sys_matrix_view(VALUE ary, int i, VALUE klass, double *data,
+				   size_t size1, size_t size2)
+{
+  VALUE vm;
+  gsl_matrix_view *m = NULL;
+  vm = rb_ary_entry(ary, i);
+  if (NIL_P(vm)) {
+    m = gsl_matrix_view_alloc();
+    m->matrix.block = NULL;
+    m->matrix.owner = 0;
+    vm = Data_Wrap_Struct(klass, 0, gsl_matrix_view_free, m);
+    rb_ary_store(ary, i, vm);
+  } else {
+    Data_Get_Struct(vm, gsl_matrix_view, m);
+  }
+  m->matrix.data = data;
+  m->matrix.size1 = size1;
+  m->matrix.size2 = size2;
+  m->matrix.tda = size2;
+  return vm;
+}
+
+static void odeiv_sys_vector_release(VALUE vv)
+{
+  gsl_vector_view *v = NULL;
+  Data_Get_Struct(vv, gsl_vector_view, v);
+  v->vector.data = NULL;
+  v->vector.size = 0;
+}
+
+static void odeiv_sys_matrix_release(VALUE vm)
+{
+  gsl_matrix_view *m = NULL;
+  Data_Get_Struct(vm, gsl_matrix_view, m);
+  m->matrix.data = NULL;
+  m->matrix.size1 = 0;
+  m->matrix.size2 = 0;
+}
+
 static int calc_func(double t, const double y[], double dydt[], void *data)
 {
   VALUE ary, params, proc;
-  // local variable "result" declared and set, but never used
-  //VALUE result;
   VALUE vy, vdydt;
-  gsl_vector_view ytmp, dydttmp;
   size_t dim;
 
   ary = (VALUE) data;
-  proc = rb_ary_entry(ary, 0);
-  dim = FIX2INT(rb_ary_entry(ary, 2));
-  params = rb_ary_entry(ary, 3);
-
-  ytmp.vector.data = (double *) y;
-  ytmp.vector.stride = 1;
-  ytmp.vector.size = dim;
-  dydttmp.vector.data = dydt;
-  dydttmp.vector.stride = 1;
-  dydttmp.vector.size = dim;
-  vy = Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL, &ytmp);
-  vdydt = Data_Wrap_Struct(cgsl_vector_view, 0, NULL, &dydttmp);
-
-  if (NIL_P(params)) /*result =*/ rb_funcall((VALUE) proc, RBGSL_ID_call, 3, rb_float_new(t),
-					 vy, vdydt);
-  else /*result =*/ rb_funcall((VALUE) proc, RBGSL_ID_call, 4, rb_float_new(t), vy, vdydt, params);
+  proc = rb_ary_entry(ary, ODEIV_SYS_FUNC);
+  dim = FIX2INT(rb_ary_entry(ary, ODEIV_SYS_DIM));
+  params = rb_ary_entry(ary, ODEIV_SYS_PARAMS);
+
+  vy = odeiv_sys_vector_view(ary, ODEIV_SYS_VY, cgsl_vector_view_ro, (double *) y, dim);
+  vdydt = odeiv_sys_vector_view(ary, ODEIV_SYS_VDYDT, cgsl_vector_view, dydt, dim);
 
+  RB_GSL_CALLBACK_ENTRY("odeiv_func", dim);
+  if (NIL_P(params)) rb_funcall((VALUE) proc, RBGSL_ID_call, 3, rb_float_new(t),
+				vy, vdydt);
+  else rb_funcall((VALUE) proc, RBGSL_ID_call, 4, rb_float_new(t), vy, vdydt, params);
+  RB_GSL_CALLBACK_RETURN("odeiv_func", dim);
+
+  odeiv_sys_vector_release(vy);
+  odeiv_sys_vector_release(vdydt);
   return GSL_SUCCESS;
 }
 
 static int calc_jac(double t, const double y[], double *dfdy, double dfdt[], void *data)
 {
   VALUE params, proc, ary;
-  VALUE vdfdt;
-  // local variable "result" declared and set, but never used
-  //VALUE result;
-  VALUE vy, vmjac;
-  gsl_vector_view ytmp, dfdttmp;
-  gsl_matrix_view mv;
+  VALUE vy, vmjac, vdfdt;
   size_t dim;
   
   ary = (VALUE) data;
-  proc = rb_ary_entry(ary, 1);
+  proc = rb_ary_entry(ary, ODEIV_SYS_JAC);
   if (NIL_P(proc)) rb_raise(rb_eRuntimeError, "df function not given");
 
-  dim = FIX2INT(rb_ary_entry(ary, 2));
-  params = rb_ary_entry(ary, 3);
-
-  ytmp.vector.data = (double *) y;
-  ytmp.vector.size = dim;
-  ytmp.vector.stride = 1;
-  dfdttmp.vector.data = dfdt;
-  dfdttmp.vector.size = dim;
-  dfdttmp.vector.stride = 1;
-  mv = gsl_matrix_view_array(dfdy, dim, dim);
-  vy = Data_Wrap_Struct(cgsl_vector_view_ro, 0, NULL, &ytmp);
-  vmjac = Data_Wrap_Struct(cgsl_matrix_view, 0, NULL, &mv);
-  vdfdt = Data_Wrap_Struct(cgsl_vector_view, 0, NULL, &dfdttmp);
-  if (NIL_P(params)) /*result =*/ rb_funcall((VALUE) proc, RBGSL_ID_call, 4, rb_float_new(t),
-					 vy, vmjac, vdfdt);
-  else /*result =*/ rb_funcall((VALUE) proc, RBGSL_ID_call, 5, rb_float_new(t), 
-			   vy, vmjac, vdfdt, params);
+  dim = FIX2INT(rb_ary_entry(ary, ODEIV_SYS_DIM));
+  params = rb_ary_entry(ary, ODEIV_SYS_PARAMS);
+
+  vy = odeiv_sys_vector_view(ary, ODEIV_SYS_VY, cgsl_vector_view_ro, (double *) y, dim);
+  vmjac = odeiv_sys_matrix_view(ary, ODEIV_SYS_VJAC, cgsl_matrix_view, dfdy, dim, dim);
+  vdfdt = odeiv_sys_vector_view(ary, ODEIV_SYS_VDFDT, cgsl_vector_view, dfdt, dim);
+  RB_GSL_CALLBACK_ENTRY("odeiv_jac", dim);
+  if (NIL_P(params)) rb_funcall((VALUE) proc, RBGSL_ID_call, 4, rb_float_new(t),
+				vy, vmjac, vdfdt);
+  else rb_funcall((VALUE) proc, RBGSL_ID_call, 5, rb_float_new(t), 
+		  vy, vmjac, vdfdt, params);
+  RB_GSL_CALLBACK_RETURN("odeiv_jac", dim);
+  odeiv_sys_vector_release(vy);
+  odeiv_sys_matrix_release(vmjac);
+  odeiv_sys_vector_release(vdfdt);
+  return GSL_SUCCESS;
+}
+
+/*
+  Systems made by System.compile: component i of the right hand side is
+  the compiled function f[i] of x[0] ... x[dim-1], the state, and of the
+  parameters, the first of which is t. The Jacobian is exact (dual
+  numbers), df/dt a central difference. Nothing but the stack is
+  written, so these can run on several threads at once.
+*/
+typedef struct {
+  size_t dim;
+  void **f;
+} mygsl_odeiv_native;
+
+#define ODEIV_NATIVE_PARAM_MAX 32
+
+static void odeiv_native_free(mygsl_odeiv_native *n)
+{
+  if (n->f) xfree(n->f);
+  xfree(n);
+}
+
+static int odeiv_native_func(double t, const double y[], double dydt[], void *data)
+{
+  const mygsl_odeiv_native *n = (const mygsl_odeiv_native *) data;
+  double param[ODEIV_NATIVE_PARAM_MAX];
+  size_t i;
+  for (i = 0; i < n->dim; i++) {
+    rb_gsl_function_compiled_get_params(n->f[i], param);
+    param[0] = t;
+    dydt[i] = rb_gsl_function_compiled_eval_params(n->f[i], y, param);
+  }
+  return GSL_SUCCESS;
+}
+
+static int odeiv_native_jac(double t, const double y[], double *dfdy, double dfdt[],
+			    void *data)
+{
+  const mygsl_odeiv_native *n = (const mygsl_odeiv_native *) data;
+  double param[ODEIV_NATIVE_PARAM_MAX], h, fp, fm;
+  size_t i;
+  h = GSL_ROOT3_DBL_EPSILON*GSL_MAX(1.0, fabs(t));
+  for (i = 0; i < n->dim; i++) {
+    rb_gsl_function_compiled_get_params(n->f[i], param);
+    param[0] = t;
+    rb_gsl_function_compiled_eval_grad(n->f[i], y, param, dfdy + i*n->dim);
+    param[0] = t + h;
+    fp = rb_gsl_function_compiled_eval_params(n->f[i], y, param);
+    param[0] = t - h;
+    fm = rb_gsl_function_compiled_eval_params(n->f[i], y, param);
+    dfdt[i] = (fp - fm)/(2.0*h);
+  }
   return GSL_SUCCESS;
 }
 
+/* NULL unless the System was compiled */
+static mygsl_odeiv_native* odeiv_sys_native(VALUE ary)
+{
+  mygsl_odeiv_native *n = NULL;
+  VALUE vn = rb_ary_entry(ary, ODEIV_SYS_NATIVE);
+  if (NIL_P(vn)) return NULL;
+  Data_Get_Struct(vn, mygsl_odeiv_native, n);
+  return n;
+}
+
+static int calc_func_native(double t, const double y[], double dydt[], void *data)
+{
+  return odeiv_native_func(t, y, dydt, odeiv_sys_native((VALUE) data));
+}
+
+static int calc_jac_native(double t, const double y[], double *dfdy, double dfdt[],
+			   void *data)
+{
+  return odeiv_native_jac(t, y, dfdy, dfdt, odeiv_sys_native((VALUE) data));
+}
+
 static void gsl_odeiv_system_mark(gsl_odeiv_system *sys);
 static void gsl_odeiv_system_mark(gsl_odeiv_system *sys)
 {
@@ -160,6 +303,14 @@ static VALUE rb_gsl_odeiv_system_new(int argc, VALUE *argv, VALUE klass)
   return obj;
 }
 
+gsl_odeiv_system* rb_gsl_odeiv_get_system(VALUE obj)
+{
+  gsl_odeiv_system *sys = NULL;
+  CHECK_SYSTEM(obj);
+  Data_Get_Struct(obj, gsl_odeiv_system, sys);
+  return sys;
+}
+
 static VALUE rb_gsl_odeiv_system_set(int argc, VALUE *argv, VALUE obj)
 {
   gsl_odeiv_system *sys = NULL;
@@ -197,7 +348,7 @@ static void set_sys(int argc, VALUE *argv, gsl_odeiv_system *sys)
   }
 
   if (sys->params == NULL) {
-    ary = rb_ary_new2(4);
+    ary = rb_ary_new2(8);
     /*    (VALUE) sys->params = ary;*/
     sys->params = (void *) ary;
   } else {
@@ -205,6 +356,9 @@ static void set_sys(int argc, VALUE *argv, gsl_odeiv_system *sys)
   }
   rb_ary_store(ary, 1, Qnil);   /* function to calc J */
   rb_ary_store(ary, 3, Qnil);   /* parameters */
+  rb_ary_store(ary, ODEIV_SYS_NATIVE, Qnil);
+  sys->function = &calc_func;
+  sys->jacobian = &calc_jac;
 
   itmp = 1;
   if (rb_obj_is_kind_of(argv[1], rb_cProc)) {
@@ -242,6 +396,18 @@ static VALUE rb_gsl_odeiv_system_set_params(int argc, VALUE *argv, VALUE obj)
   Data_Get_Struct(obj, gsl_odeiv_system, sys);
 
   ary = (VALUE) sys->params;
+  if (odeiv_sys_native(ary)) {
+    VALUE fs = rb_ary_entry(ary, ODEIV_SYS_FUNC);
+    if (argc != 1 || TYPE(argv[0]) != T_HASH)
+      rb_raise(rb_eArgError, "parameters of a compiled system must be given as a Hash");
+    for (i = 0; i < (size_t) RARRAY_LEN(fs); i++)
+      rb_funcall(rb_ary_entry(fs, i), rb_intern("set_params"), 1, argv[0]);
+    vparams = rb_ary_entry(ary, ODEIV_SYS_PARAMS);
+    if (NIL_P(vparams)) vparams = argv[0];
+    else vparams = rb_funcall(vparams, rb_intern("merge"), 1, argv[0]);
+    rb_ary_store(ary, ODEIV_SYS_PARAMS, vparams);
+    return obj;
+  }
   switch (argc) {
   case 0:
     vparams = Qnil;
@@ -292,6 +458,71 @@ static VALUE rb_gsl_odeiv_system_dimension(VALUE obj)
   return INT2FIX(sys->dimension);
 }
 
+/*
+  GSL::Odeiv::System.compile(exprs, params = {})
+
+    sys = GSL::Odeiv::System.compile(["x[1]", "-x[0] - g*x[1]*cos(t)"],
+                                     "g" => 0.1)
+
+  The right hand side dy_i/dt is the i-th expression of exprs, in the
+  state x[0] ... x[n-1], the time t and the parameters (see
+  GSL::Function.compile). Steppers call it without going through Ruby,
+  and Odeiv.ensemble runs the trajectories of such a system on several
+  threads. The Jacobian, for bsimp, comes with it.
+*/
+static VALUE rb_gsl_odeiv_system_compile(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_odeiv_system *sys = NULL;
+  mygsl_odeiv_native *n = NULL;
+  VALUE exprs, params, fs, ary, vn;
+  size_t i, dim;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  exprs = argv[0];
+  Check_Type(exprs, T_ARRAY);
+  dim = RARRAY_LEN(exprs);
+  if (dim == 0) rb_raise(rb_eArgError, "no expressions");
+  /* t comes first, so that it is param[0] of every function */
+  params = rb_hash_new();
+  rb_hash_aset(params, rb_str_new2("t"), rb_float_new(0.0));
+  if (argc == 2 && !NIL_P(argv[1])) {
+    Check_Type(argv[1], T_HASH);
+    if (rb_funcall(argv[1], rb_intern("key?"), 1, rb_str_new2("t")) == Qtrue
+	|| rb_funcall(argv[1], rb_intern("key?"), 1, ID2SYM(rb_intern("t"))) == Qtrue)
+      rb_raise(rb_eArgError, "t is the time variable");
+    rb_funcall(params, rb_intern("update"), 1, argv[1]);
+  }
+  fs = rb_ary_new2(dim);
+  for (i = 0; i < dim; i++)
+    rb_ary_store(fs, i, rb_gsl_function_compile_multi(rb_ary_entry(exprs, i), params, dim));
+  n = ALLOC(mygsl_odeiv_native);
+  n->dim = dim;
+  n->f = NULL;
+  vn = Data_Wrap_Struct(cGSL_Object, 0, odeiv_native_free, n);
+  n->f = ALLOC_N(void *, dim);
+  for (i = 0; i < dim; i++) n->f[i] = rb_gsl_function_compiled_ptr(rb_ary_entry(fs, i));
+  ary = rb_ary_new2(ODEIV_SYS_NATIVE + 1);
+  rb_ary_store(ary, ODEIV_SYS_FUNC, fs);
+  rb_ary_store(ary, ODEIV_SYS_JAC, fs);
+  rb_ary_store(ary, ODEIV_SYS_DIM, INT2FIX(dim));
+  rb_ary_store(ary, ODEIV_SYS_PARAMS, argc == 2 ? argv[1] : Qnil);
+  rb_ary_store(ary, ODEIV_SYS_NATIVE, vn);
+  sys = ALLOC(gsl_odeiv_system);
+  sys->function = &calc_func_native;
+  sys->jacobian = &calc_jac_native;
+  sys->dimension = dim;
+  sys->params = (void *) ary;
+  return Data_Wrap_Struct(klass, gsl_odeiv_system_mark, free, sys);
+}
+
+/* true for a System made by System.compile */
+static VALUE rb_gsl_odeiv_system_compiled(VALUE obj)
+{
+  gsl_odeiv_system *sys = NULL;
+  Data_Get_Struct(obj, gsl_odeiv_system, sys);
+  return odeiv_sys_native((VALUE) sys->params) ? Qtrue : Qfalse;
+}
+
 static const gsl_odeiv_step_type* rb_gsl_odeiv_step_type_get(VALUE tt);
 
 static gsl_odeiv_step* make_step(VALUE tt, VALUE dim);
@@ -674,12 +905,30 @@ static VALUE rb_gsl_odeiv_evolve_apply(VALUE obj, VALUE cc, VALUE ss, VALUE sss,
   return rb_ary_new3(3, rb_float_new(t), rb_float_new(h), INT2FIX(status));
 }
 
+/* [epsabs, epsrel] for the y control, or [epsabs, epsrel, a_y, a_dydt] */
+static gsl_odeiv_control* make_control_ary(VALUE eps)
+{
+  Check_Type(eps, T_ARRAY);
+  switch (RARRAY_LEN(eps)) {
+  case 2:
+    return make_control_y(rb_ary_entry(eps, 0), rb_ary_entry(eps, 1));
+    break;
+  case 4:
+    return make_control_standard(rb_ary_entry(eps, 0), rb_ary_entry(eps, 1),
+				 rb_ary_entry(eps, 2), rb_ary_entry(eps, 3));
+    break;
+  default:
+    rb_raise(rb_eArgError, "size of the argument 1 must be 2 or 4");
+    break;
+  }
+  return NULL;
+}
+
 static void rb_gsl_odeiv_solver_free(gsl_odeiv_solver *gde);
 static void gsl_odeiv_solver_mark(gsl_odeiv_solver *gos);
 static VALUE rb_gsl_odeiv_solver_new(int argc, VALUE *argv, VALUE klass)
 {
   gsl_odeiv_solver *gos = NULL;
-  VALUE epsabs, epsrel, ay, adydt;
   VALUE dim;
   if (argc < 4) rb_raise(rb_eArgError, "too few arguments");
   Check_Type(argv[1], T_ARRAY);
@@ -691,24 +940,7 @@ static VALUE rb_gsl_odeiv_solver_new(int argc, VALUE *argv, VALUE klass)
   }
   gos = ALLOC(gsl_odeiv_solver);
   gos->s = make_step(argv[0], dim);
-  //  switch (RARRAY(argv[1])->len) {
-  switch (RARRAY_LEN(argv[1])) {
-  case 2:
-    epsabs = rb_ary_entry(argv[1], 0);
-    epsrel = rb_ary_entry(argv[1], 1);
-    gos->c = make_control_y(epsabs, epsrel);
-    break;
-  case 4:
-    epsabs = rb_ary_entry(argv[1], 0);
-    epsrel = rb_ary_entry(argv[1], 1);
-    ay = rb_ary_entry(argv[1], 2);
-    adydt = rb_ary_entry(argv[1], 3);
-    gos->c = make_control_standard(epsabs, epsrel, ay, adydt);
-    break;
-  default:
-    rb_raise(rb_eArgError, "size of the argument 1 must be 2 or 4");
-    break;
-  }
+  gos->c = make_control_ary(argv[1]);
   gos->sys = make_sys(argc - 2, argv + 2);
   gos->e = make_evolve(dim);
   return Data_Wrap_Struct(klass,  gsl_odeiv_solver_mark, rb_gsl_odeiv_solver_free, gos);
@@ -815,6 +1047,293 @@ static VALUE rb_gsl_odeiv_solver_apply(VALUE obj, VALUE tt, VALUE tt1, VALUE hh,
   return rb_ary_new3(3, rb_float_new(t), rb_float_new(h), INT2FIX(status));
 }
 
+/*
+  solver.integrate_to_grid(tgrid, h, y[, m])
+
+  Integrates the system from tgrid[0] through every time in tgrid and
+  stores the state at tgrid[i] in the i-th row of a (tgrid.size x dim)
+  matrix. The whole sweep is done in C, the initial state y is left
+  untouched. If m is given, it is used as the output matrix.
+  Returns [m, h, steps, failed_steps], where h is the last step size.
+*/
+static VALUE rb_gsl_odeiv_solver_integrate_to_grid(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_odeiv_solver *gos = NULL;
+  gsl_vector *tgrid = NULL, *y = NULL;
+  gsl_matrix *m = NULL;
+  gsl_vector_view row;
+  VALUE vm;
+  double t, t1, h, *ytmp = NULL;
+  size_t i, dim;
+  unsigned long count, failed;
+  int status = GSL_SUCCESS;
+
+  if (argc != 3 && argc != 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  CHECK_VECTOR(argv[0]);
+  CHECK_VECTOR(argv[2]);
+  Need_Float(argv[1]);
+  Data_Get_Struct(obj, gsl_odeiv_solver, gos);
+  Data_Get_Struct(argv[0], gsl_vector, tgrid);
+  Data_Get_Struct(argv[2], gsl_vector, y);
+  dim = gos->sys->dimension;
+  if (tgrid->size == 0) rb_raise(rb_eArgError, "empty time grid");
+  if (y->size != dim) rb_raise(rb_eArgError, "vector length must be %d", (int) dim);
+  if (argc == 4) {
+    CHECK_MATRIX(argv[3]);
+    Data_Get_Struct(argv[3], gsl_matrix, m);
+    if (m->size1 != tgrid->size || m->size2 != dim)
+      rb_raise(rb_eArgError, "matrix size must be %d x %d", (int) tgrid->size,
+	       (int) dim);
+    vm = argv[3];
+  } else {
+    m = gsl_matrix_alloc(tgrid->size, dim);
+    vm = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  }
+  h = NUM2DBL(argv[1]);
+  if (h == 0.0) rb_raise(rb_eArgError, "step size must be non-zero");
+  t = gsl_vector_get(tgrid, 0);
+  if ((gsl_vector_get(tgrid, tgrid->size-1) - t)*h < 0.0) h = -h;
+  gsl_odeiv_evolve_reset(gos->e);
+  count = gos->e->count;
+  failed = gos->e->failed_steps;
+  /* each row starts from the previous state and is advanced in place */
+  row = gsl_matrix_row(m, 0);
+  gsl_vector_memcpy(&row.vector, y);
+  for (i = 1; i < tgrid->size; i++) {
+    ytmp = gsl_matrix_ptr(m, i, 0);
+    memcpy(ytmp, gsl_matrix_ptr(m, i-1, 0), sizeof(double)*dim);
+    t1 = gsl_vector_get(tgrid, i);
+    while ((t1 - t)*h > 0.0) {
+      status = gsl_odeiv_evolve_apply(gos->e, gos->c, gos->s, gos->sys,
+				      &t, t1, &h, ytmp);
+      if (status != GSL_SUCCESS) break;
+    }
+    if (status != GSL_SUCCESS) 
+      rb_raise(rb_eRuntimeError, "integration failed at t = %g (status %d)", t, status);
+  }
+  return rb_ary_new3(4, vm, rb_float_new(h), 
+		     INT2FIX(gos->e->count - count),
+		     INT2FIX(gos->e->failed_steps - failed));
+}
+
+/*
+  solver.integrate_dense(t0, t1, h, y, opts = {})
+
+  Integrates y in place from t0 to t1 with steps of the size chosen by
+  the control, and uses the cubic Hermite interpolant of each accepted
+  step (through the states and derivatives at both ends) to sample the
+  solution and to locate events in between, without shortening steps.
+  The options are
+    :times    => Vector or Array of output times, from t0 towards t1
+    :events   => Array of event functions g(t, y): Strings, compiled in
+                 x[0] ... x[dim-1] and t (see System.compile), or procs
+                 called as g.call(t, y), y a Vector reused between calls
+    :terminal => true to stop at the first event
+  An event is reported where a g changes sign, located by the Illinois
+  method on the interpolant. Returns [t, h, out, events]: the time
+  reached, the last step size, the (times.size x dim) Matrix of sampled
+  states (nil without :times, NaN rows past a terminal event) and the
+  Array of events [t, i, y] in the order they occur, i the index in
+  :events.
+*/
+typedef struct {
+  gsl_odeiv_system *sys;
+  size_t n, nev;
+  double ta, tb;
+  double *ya, *fa, *yb, *fb;
+  gsl_vector *yt;               /* the state handed to event procs */
+  VALUE events, vyt;
+} mygsl_odeiv_dense;
+
+static void odeiv_dense_eval(const mygsl_odeiv_dense *d, double t, double *y)
+{
+  double hh = d->tb - d->ta, s = (t - d->ta)/hh, s1 = 1.0 - s;
+  double h00 = (1.0 + 2.0*s)*s1*s1, h10 = s*s1*s1*hh, h01 = s*s*(3.0 - 2.0*s);
+  double h11 = -s*s*s1*hh;
+  size_t i;
+  for (i = 0; i < d->n; i++)
+    y[i] = h00*d->ya[i] + h10*d->fa[i] + h01*d->yb[i] + h11*d->fb[i];
+}
+
+static double odeiv_dense_event(mygsl_odeiv_dense *d, size_t k, double t, const double *y)
+{
+  VALUE ev = rb_ary_entry(d->events, k);
+  double param[ODEIV_NATIVE_PARAM_MAX];
+  void *c;
+  if (rb_obj_is_kind_of(ev, cgsl_function_compiled)) {
+    c = rb_gsl_function_compiled_ptr(ev);
+    rb_gsl_function_compiled_get_params(c, param);
+    param[0] = t;
+    return rb_gsl_function_compiled_eval_params(c, y, param);
+  }
+  if (y != d->yt->data) memcpy(d->yt->data, y, sizeof(double)*d->n);
+  return NUM2DBL(rb_funcall(ev, RBGSL_ID_call, 2, rb_float_new(t), d->vyt));
+}
+
+/* The root of event k in (ta, tb], ga and gb its values at the ends */
+static double odeiv_dense_locate(mygsl_odeiv_dense *d, size_t k, double ga, double gb)
+{
+  double a = d->ta, b = d->tb, c = d->tb, gc, tol;
+  int side = 0, iter;
+  if (gb == 0.0) return b;
+  tol = 4.0*GSL_DBL_EPSILON*(1.0 + GSL_MAX(fabs(a), fabs(b)));
+  for (iter = 0; iter < 100 && fabs(b - a) > tol; iter++) {
+    c = (ga*b - gb*a)/(ga - gb);
+    odeiv_dense_eval(d, c, d->yt->data);
+    gc = odeiv_dense_event(d, k, c, d->yt->data);
+    if (gc == 0.0) break;
+    if ((gc > 0.0) == (gb > 0.0)) {
+      b = c; gb = gc;
+      if (side == -1) ga *= 0.5;
+      side = -1;
+    } else {
+      a = c; ga = gc;
+      if (side == 1) gb *= 0.5;
+      side = 1;
+    }
+  }
+  return c;
+}
+
+static VALUE rb_gsl_odeiv_solver_integrate_dense(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_odeiv_solver *gos = NULL;
+  mygsl_odeiv_dense d;
+  gsl_vector *y = NULL, *work, *gw;
+  gsl_matrix *out = NULL;
+  VALUE opts = Qnil, vtimes = Qnil, vout = Qnil, vevents, vwork, vgw, v, keep;
+  double t0, t1, t, h, dir, te, tstop = 0.0, *times = NULL, *ga, *gb, *tmp;
+  size_t i, j, k, ntimes = 0, tstride = 1, first, nkeep;
+  int terminal = 0, stop = 0, status;
+
+  if (argc < 4 || argc > 5)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 4 or 5)", argc);
+  Data_Get_Struct(obj, gsl_odeiv_solver, gos);
+  CHECK_VECTOR(argv[3]);
+  Data_Get_Struct(argv[3], gsl_vector, y);
+  memset(&d, 0, sizeof(d));
+  d.sys = gos->sys;
+  d.n = gos->sys->dimension;
+  if (y->size != d.n) rb_raise(rb_eArgError, "vector length must be %d", (int) d.n);
+  t0 = NUM2DBL(argv[0]);
+  t1 = NUM2DBL(argv[1]);
+  h = NUM2DBL(argv[2]);
+  if (h == 0.0) rb_raise(rb_eArgError, "step size must be non-zero");
+  dir = t1 >= t0 ? 1.0 : -1.0;
+  h = fabs(h)*dir;
+  keep = rb_ary_new();
+  d.events = rb_ary_new();
+  if (argc == 5 && !NIL_P(argv[4])) {
+    opts = argv[4];
+    Check_Type(opts, T_HASH);
+    vtimes = rb_hash_aref(opts, ID2SYM(rb_intern("times")));
+    terminal = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("terminal"))));
+    v = rb_hash_aref(opts, ID2SYM(rb_intern("events")));
+    if (!NIL_P(v)) {
+      VALUE params = rb_hash_new();
+      Check_Type(v, T_ARRAY);
+      rb_hash_aset(params, rb_str_new2("t"), rb_float_new(0.0));
+      for (k = 0; k < (size_t) RARRAY_LEN(v); k++) {
+	VALUE ev = rb_ary_entry(v, k);
+	if (TYPE(ev) == T_STRING) ev = rb_gsl_function_compile_multi(ev, params, d.n);
+	else CHECK_PROC(ev);
+	rb_ary_push(d.events, ev);
+      }
+    }
+  }
+  d.nev = RARRAY_LEN(d.events);
+  if (!NIL_P(vtimes)) {
+    times = get_vector_ptr(vtimes, &tstride, &ntimes);
+    rb_ary_push(keep, vtimes);
+    for (j = 0; j < ntimes; j++) {
+      te = times[j*tstride];
+      if ((te - t0)*dir < 0.0 || (te - t1)*dir > 0.0
+	  || (j > 0 && (te - times[(j-1)*tstride])*dir < 0.0))
+	rb_raise(rb_eArgError, "output times must run from t0 to t1");
+    }
+    out = gsl_matrix_alloc(ntimes, d.n);
+    vout = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, out);
+    gsl_matrix_set_all(out, GSL_NAN);
+  }
+  work = gsl_vector_alloc(4*d.n);
+  vwork = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, work);
+  d.ya = work->data;
+  d.fa = d.ya + d.n;
+  d.yb = d.fa + d.n;
+  d.fb = d.yb + d.n;
+  d.yt = gsl_vector_alloc(d.n);
+  d.vyt = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, d.yt);
+  gw = gsl_vector_alloc(2*d.nev + 1);
+  vgw = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gw);
+  ga = gw->data;
+  gb = ga + d.nev;
+  vevents = rb_ary_new();
+
+  for (i = 0; i < d.n; i++) d.ya[i] = gsl_vector_get(y, i);
+  t = d.ta = t0;
+  GSL_ODEIV_FN_EVAL(d.sys, t, d.ya, d.fa);
+  for (k = 0; k < d.nev; k++) ga[k] = odeiv_dense_event(&d, k, t, d.ya);
+  for (j = 0; j < ntimes && times[j*tstride] == t0; j++)
+    memcpy(gsl_matrix_ptr(out, j, 0), d.ya, sizeof(double)*d.n);
+  gsl_odeiv_step_reset(gos->s);
+  gsl_odeiv_evolve_reset(gos->e);
+  while (!stop && (t1 - t)*dir > 0.0) {
+    memcpy(d.yb, d.ya, sizeof(double)*d.n);
+    status = gsl_odeiv_evolve_apply(gos->e, gos->c, gos->s, d.sys, &t, t1, &h, d.yb);
+    if (status != GSL_SUCCESS)
+      rb_raise(rb_eRuntimeError, "integration failed at t = %g (status %d)", t, status);
+    d.tb = t;
+    GSL_ODEIV_FN_EVAL(d.sys, d.tb, d.yb, d.fb);
+    /* events of this step, in the order they occur */
+    first = RARRAY_LEN(vevents);
+    for (k = 0; k < d.nev; k++) {
+      gb[k] = odeiv_dense_event(&d, k, d.tb, d.yb);
+      if (ga[k] != 0.0 && (gb[k] == 0.0 || (ga[k] > 0.0) != (gb[k] > 0.0))) {
+	VALUE ve, vy;
+	gsl_vector *ye;
+	te = odeiv_dense_locate(&d, k, ga[k], gb[k]);
+	ye = gsl_vector_alloc(d.n);
+	vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, ye);
+	odeiv_dense_eval(&d, te, ye->data);
+	ve = rb_ary_new3(3, rb_float_new(te), INT2FIX(k), vy);
+	for (i = RARRAY_LEN(vevents); i > first; i--)
+	  if ((NUM2DBL(rb_ary_entry(rb_ary_entry(vevents, i-1), 0)) - te)*dir <= 0.0) break;
+	rb_funcall(vevents, rb_intern("insert"), 2, INT2FIX(i), ve);
+	if (terminal && (!stop || (te - tstop)*dir < 0.0)) tstop = te;
+	if (terminal) stop = 1;
+      }
+    }
+    if (stop) {
+      /* drop the events of this step past the first one */
+      for (nkeep = first; nkeep < (size_t) RARRAY_LEN(vevents); nkeep++)
+	if ((NUM2DBL(rb_ary_entry(rb_ary_entry(vevents, nkeep), 0)) - tstop)*dir > 0.0) break;
+      rb_ary_resize(vevents, nkeep);
+    }
+    for (; j < ntimes; j++) {
+      te = times[j*tstride];
+      if ((te - d.tb)*dir > 0.0 || (stop && (te - tstop)*dir > 0.0)) break;
+      odeiv_dense_eval(&d, te, gsl_matrix_ptr(out, j, 0));
+    }
+    if (stop) {
+      odeiv_dense_eval(&d, tstop, d.ya);
+      t = tstop;
+      gsl_odeiv_evolve_reset(gos->e);
+      break;
+    }
+    tmp = d.ya; d.ya = d.yb; d.yb = tmp;
+    tmp = d.fa; d.fa = d.fb; d.fb = tmp;
+    tmp = ga; ga = gb; gb = tmp;
+    d.ta = d.tb;
+  }
+  for (i = 0; i < d.n; i++) gsl_vector_set(y, i, d.ya[i]);
+  RB_GC_GUARD(keep);
+  RB_GC_GUARD(vwork);
+  RB_GC_GUARD(vgw);
+  RB_GC_GUARD(d.vyt);
+  return rb_ary_new3(4, rb_float_new(t), rb_float_new(h), vout, vevents);
+}
+
 static void rb_gsl_odeiv_solver_free(gsl_odeiv_solver *gos)
 {
   free((gsl_odeiv_solver *) gos);
@@ -854,10 +1373,207 @@ static VALUE rb_gsl_odeiv_solver_params(VALUE obj)
   return rb_ary_entry(ary, 3);
 }
 
+/*
+  GSL::Odeiv.ensemble(type, [epsabs, epsrel(, a_y, a_dydt)], sys, t0, t1, h, y0)
+
+  Integrates each row of the m x n Matrix y0 from t0 to t1, with step
+  type, control and initial step h as for Solver.alloc, and returns
+  [y1, steps, failed, status]: the final states (m x n) and, per
+  trajectory, the number of steps, of failed steps and the GSL status
+  (Vector::Int).
+
+  A compiled System (System.compile) is integrated on
+  GSL.parallel_threads threads, each with a stepper, control and
+  evolver of its own, without the GVL; one with Ruby procs row by row.
+  sys may also be a Proc called with all the states at once,
+  sys.call(t, y, dydt) with m x n Matrix views, the ensemble being
+  then stepped together as one system of m*n equations (the step size
+  follows the hardest trajectory, and steps, failed and status are the
+  same for all rows; bsimp is not available).
+*/
+typedef struct {
+  gsl_odeiv_step *s;
+  gsl_odeiv_control *c;
+  gsl_odeiv_evolve *e;
+  gsl_odeiv_system sys;
+} mygsl_odeiv_ensemble_slot;
+
+typedef struct {
+  mygsl_odeiv_ensemble_slot *slot;   /* one per thread */
+  size_t m, dim, nthreads;
+  double t0, t1, h;
+  const gsl_matrix *y0;
+  gsl_matrix *y;
+  gsl_vector_int *steps, *failed, *status;
+} mygsl_odeiv_ensemble;
+
+static int odeiv_ensemble_worker(void *data, size_t id)
+{
+  mygsl_odeiv_ensemble *w = (mygsl_odeiv_ensemble *) data;
+  mygsl_odeiv_ensemble_slot *sl = w->slot + id;
+  double t, h, *y;
+  size_t k;
+  int status;
+  for (k = id; k < w->m; k += w->nthreads) {
+    y = gsl_matrix_ptr(w->y, k, 0);
+    memcpy(y, gsl_matrix_const_ptr(w->y0, k, 0), sizeof(double)*w->dim);
+    gsl_odeiv_step_reset(sl->s);
+    gsl_odeiv_evolve_reset(sl->e);
+    t = w->t0;
+    h = w->h;
+    status = GSL_SUCCESS;
+    while ((w->t1 - t)*h > 0.0) {
+      status = gsl_odeiv_evolve_apply(sl->e, sl->c, sl->s, &sl->sys, &t, w->t1, &h, y);
+      if (status != GSL_SUCCESS) break;
+    }
+    gsl_vector_int_set(w->steps, k, (int) sl->e->count);
+    gsl_vector_int_set(w->failed, k, (int) sl->e->failed_steps);
+    gsl_vector_int_set(w->status, k, status);
+  }
+  return GSL_SUCCESS;
+}
+
+static int odeiv_ensemble_serial(void *data)
+{
+  return odeiv_ensemble_worker(data, 0);
+}
+
+/* The batched right hand side: the state of the stacked system is the
+   m x n matrix of the ensemble */
+enum {
+  ODEIV_BATCH_FUNC = 0,
+  ODEIV_BATCH_M,
+  ODEIV_BATCH_DIM,
+  ODEIV_BATCH_VY,
+  ODEIV_BATCH_VDYDT,
+};
+
+static int calc_func_batch(double t, const double y[], double dydt[], void *data)
+{
+  VALUE ary = (VALUE) data, vy, vdydt;
+  size_t m, dim;
+  m = FIX2INT(rb_ary_entry(ary, ODEIV_BATCH_M));
+  dim = FIX2INT(rb_ary_entry(ary, ODEIV_BATCH_DIM));
+  vy = odeiv_sys_matrix_view(ary, ODEIV_BATCH_VY, cgsl_matrix_view_ro, (double *) y, m, dim);
+  vdydt = odeiv_sys_matrix_view(ary, ODEIV_BATCH_VDYDT, cgsl_matrix_view, dydt, m, dim);
+  RB_GSL_CALLBACK_ENTRY("odeiv_batch", m*dim);
+  rb_funcall(rb_ary_entry(ary, ODEIV_BATCH_FUNC), RBGSL_ID_call, 3, rb_float_new(t), vy, vdydt);
+  RB_GSL_CALLBACK_RETURN("odeiv_batch", m*dim);
+  odeiv_sys_matrix_release(vy);
+  odeiv_sys_matrix_release(vdydt);
+  return GSL_SUCCESS;
+}
+
+/* A stepper, control and evolver for n equations, owned by the GC */
+static void odeiv_ensemble_slot_alloc(mygsl_odeiv_ensemble_slot *sl,
+				      const gsl_odeiv_step_type *T, VALUE eps,
+				      size_t n, VALUE keep)
+{
+  sl->s = gsl_odeiv_step_alloc(T, n);
+  rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, gsl_odeiv_step_free, sl->s));
+  sl->c = make_control_ary(eps);
+  rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, gsl_odeiv_control_free, sl->c));
+  sl->e = gsl_odeiv_evolve_alloc(n);
+  rb_ary_push(keep, Data_Wrap_Struct(cGSL_Object, 0, gsl_odeiv_evolve_free, sl->e));
+}
+
+static VALUE odeiv_vector_int(size_t n, gsl_vector_int **v)
+{
+  *v = gsl_vector_int_calloc(n);
+  return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, *v);
+}
+
+static VALUE rb_gsl_odeiv_ensemble(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_odeiv_ensemble w;
+  mygsl_odeiv_native *native = NULL;
+  const gsl_odeiv_step_type *T;
+  gsl_odeiv_system *sys = NULL;
+  VALUE keep, vslot, vy, vsteps, vfailed, vstatus, vsys, batch;
+  size_t i;
+  int status;
+  if (argc != 7) rb_raise(rb_eArgError, "wrong number of arguments (%d for 7)", argc);
+  T = rb_gsl_odeiv_step_type_get(argv[0]);
+  vsys = argv[2];
+  CHECK_MATRIX(argv[6]);
+  memset(&w, 0, sizeof(w));
+  Data_Get_Struct(argv[6], gsl_matrix, w.y0);
+  w.m = w.y0->size1;
+  w.dim = w.y0->size2;
+  w.t0 = NUM2DBL(argv[3]);
+  w.t1 = NUM2DBL(argv[4]);
+  w.h = NUM2DBL(argv[5]);
+  if (w.h == 0.0) rb_raise(rb_eArgError, "step size must be non-zero");
+  if ((w.t1 - w.t0)*w.h < 0.0) w.h = -w.h;
+  if (rb_obj_is_kind_of(vsys, rb_cProc)) {
+    if (T == gsl_odeiv_step_bsimp)
+      rb_raise(rb_eArgError, "bsimp needs a Jacobian, not available for a batched system");
+  } else {
+    CHECK_SYSTEM(vsys);
+    Data_Get_Struct(vsys, gsl_odeiv_system, sys);
+    if (sys->dimension != w.dim)
+      rb_raise(rb_eArgError, "matrix of %d columns expected", (int) sys->dimension);
+    native = odeiv_sys_native((VALUE) sys->params);
+  }
+  keep = rb_ary_new();
+  w.y = gsl_matrix_alloc(w.m, w.dim);
+  vy = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, w.y);
+  vsteps = odeiv_vector_int(w.m, &w.steps);
+  vfailed = odeiv_vector_int(w.m, &w.failed);
+  vstatus = odeiv_vector_int(w.m, &w.status);
+  if (sys == NULL) {
+    mygsl_odeiv_ensemble_slot sl;
+    double t = w.t0, h = w.h;
+    batch = rb_ary_new2(ODEIV_BATCH_VDYDT + 1);
+    rb_ary_store(batch, ODEIV_BATCH_FUNC, vsys);
+    rb_ary_store(batch, ODEIV_BATCH_M, INT2FIX(w.m));
+    rb_ary_store(batch, ODEIV_BATCH_DIM, INT2FIX(w.dim));
+    odeiv_ensemble_slot_alloc(&sl, T, argv[1], w.m*w.dim, keep);
+    sl.sys.function = &calc_func_batch;
+    sl.sys.jacobian = NULL;
+    sl.sys.dimension = w.m*w.dim;
+    sl.sys.params = (void *) batch;
+    gsl_matrix_memcpy(w.y, w.y0);
+    status = GSL_SUCCESS;
+    while ((w.t1 - t)*h > 0.0) {
+      status = gsl_odeiv_evolve_apply(sl.e, sl.c, sl.s, &sl.sys, &t, w.t1, &h, w.y->data);
+      if (status != GSL_SUCCESS) break;
+    }
+    gsl_vector_int_set_all(w.steps, (int) sl.e->count);
+    gsl_vector_int_set_all(w.failed, (int) sl.e->failed_steps);
+    gsl_vector_int_set_all(w.status, status);
+    RB_GC_GUARD(batch);
+  } else {
+    w.nthreads = native ? rb_gsl_parallel_nthreads(w.m*w.dim, w.m) : 1;
+    if (w.nthreads == 0) w.nthreads = 1;
+    w.slot = ALLOC_N(mygsl_odeiv_ensemble_slot, w.nthreads);
+    vslot = Data_Wrap_Struct(cGSL_Object, 0, xfree, w.slot);
+    rb_ary_push(keep, vslot);
+    for (i = 0; i < w.nthreads; i++) {
+      odeiv_ensemble_slot_alloc(w.slot + i, T, argv[1], w.dim, keep);
+      if (native) {
+	w.slot[i].sys.function = &odeiv_native_func;
+	w.slot[i].sys.jacobian = &odeiv_native_jac;
+	w.slot[i].sys.dimension = w.dim;
+	w.slot[i].sys.params = (void *) native;
+      } else {
+	w.slot[i].sys = *sys;
+      }
+    }
+    if (w.nthreads > 1) rb_gsl_nogvl_parallel(odeiv_ensemble_worker, &w, w.nthreads);
+    else if (native) rb_gsl_nogvl_call(odeiv_ensemble_serial, &w, 100*w.m*w.dim);
+    else odeiv_ensemble_worker(&w, 0);
+  }
+  RB_GC_GUARD(keep);
+  RB_GC_GUARD(vsys);
+  return rb_ary_new3(4, vy, vsteps, vfailed, vstatus);
+}
+
 void Init_gsl_odeiv(VALUE module)
 {
   VALUE mgsl_odeiv;
   mgsl_odeiv = rb_define_module_under(module, "Odeiv");
+  rb_define_module_function(mgsl_odeiv, "ensemble", rb_gsl_odeiv_ensemble, -1);
   rb_define_const(mgsl_odeiv, "HADJ_DEC", INT2FIX(GSL_ODEIV_HADJ_DEC));
   rb_define_const(mgsl_odeiv, "HADJ_INC", INT2FIX(GSL_ODEIV_HADJ_INC));
   rb_define_const(mgsl_odeiv, "HADJ_NIL", INT2FIX(GSL_ODEIV_HADJ_NIL));
@@ -921,6 +1637,8 @@ void Init_gsl_odeiv(VALUE module)
   cgsl_odeiv_system = rb_define_class_under(mgsl_odeiv, "System", 
 					    cGSL_Object);
   rb_define_singleton_method(cgsl_odeiv_system, "alloc", rb_gsl_odeiv_system_new, -1);
+  rb_define_singleton_method(cgsl_odeiv_system, "compile", rb_gsl_odeiv_system_compile, -1);
+  rb_define_method(cgsl_odeiv_system, "compiled?", rb_gsl_odeiv_system_compiled, 0);
   rb_define_method(cgsl_odeiv_system, "set", rb_gsl_odeiv_system_set, -1);
   rb_define_method(cgsl_odeiv_system, "set_params", 
 			     rb_gsl_odeiv_system_set_params, -1);
@@ -943,6 +1661,10 @@ void Init_gsl_odeiv(VALUE module)
   rb_define_method(cgsl_odeiv_solver, "evolve", rb_gsl_odeiv_solver_evolve, 0);
   rb_define_method(cgsl_odeiv_solver, "sys", rb_gsl_odeiv_solver_sys, 0);
   rb_define_method(cgsl_odeiv_solver, "apply", rb_gsl_odeiv_solver_apply, 4);
+  rb_define_method(cgsl_odeiv_solver, "integrate_to_grid", 
+		   rb_gsl_odeiv_solver_integrate_to_grid, -1);
+  rb_define_method(cgsl_odeiv_solver, "integrate_dense",
+		   rb_gsl_odeiv_solver_integrate_dense, -1);
 
   rb_define_method(cgsl_odeiv_solver, "set_evolve", rb_gsl_odeiv_solver_set_evolve, 1);
   rb_define_method(cgsl_odeiv_solver, "set_step", rb_gsl_odeiv_solver_set_step, 1);
@@ -953,6 +1675,10 @@ void Init_gsl_odeiv(VALUE module)
   rb_define_alias(cgsl_odeiv_solver, "dimension", "dim");
   rb_define_method(cgsl_odeiv_solver, "set_params", rb_gsl_odeiv_solver_set_params, -1);
   rb_define_method(cgsl_odeiv_solver, "params", rb_gsl_odeiv_solver_params, 0);
+
+#ifdef HAVE_GSL_GSL_ODEIV2_H
+  Init_gsl_odeiv2(module);
+#endif
 }
 
 #undef CHECK_SOLVER
@@ -0,0 +1,275 @@
+/*
+  odeiv2.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Odeiv2::Driver (gsl_odeiv2_driver, GSL >= 1.15), with the
+  implicit steppers of odeiv2 for stiff problems.
+
+    sys = GSL::Odeiv2::System.alloc(func, jac, 2, mu)
+    d = GSL::Odeiv2::Driver.alloc(sys, :msbdf, 1e-6, 1e-8, 1e-8)
+    y = GSL::Vector.alloc([1.0, 0.0])
+    t, status = d.apply(0.0, 100.0, y)          # y is updated in place
+    t, status = d.apply_fixed_step(t, 1e-3, 1000, y)
+    d.reset
+
+  Odeiv2::System is Odeiv::System: the procs are called as
+  func.call(t, y, dydt[, params]) and jac.call(t, y, dfdy, dfdt[,
+  params]), with Vector and Matrix views that are created once per
+  System and repointed at the stepper's work arrays, so a Jacobian
+  evaluation does not allocate a Matrix.
+
+  The step type is a String or a Symbol: rk2, rk4, rkf45, rkck, rk8pd,
+  rk1imp, rk2imp, rk4imp, bsimp, msadams or msbdf.  The implicit ones
+  (rk*imp, bsimp, msbdf) need the Jacobian proc.  The driver controls
+  the error by epsabs and epsrel on y, or by the standard control when
+  a_y and a_dydt are also given, as in gsl_odeiv2_driver_alloc_y_new
+  and gsl_odeiv2_driver_alloc_standard_new.
+*/
+
+#include "rb_gsl_config.h"
+#ifdef HAVE_GSL_GSL_ODEIV2_H
+#include "rb_gsl_odeiv.h"
+#include "rb_gsl_common.h"
+#include <gsl/gsl_odeiv2.h>
+
+static VALUE cgsl_odeiv2_driver;
+
+typedef struct {
+  gsl_odeiv2_system sys;        /* a copy of the Odeiv::System */
+  gsl_odeiv2_driver *d;
+  VALUE vsys;
+} mygsl_odeiv2_driver;
+
+static const struct {
+  const char *name;
+  const gsl_odeiv2_step_type **T;
+  int implicit;
+} odeiv2_step_types[] = {
+  {"rk2", &gsl_odeiv2_step_rk2, 0},
+  {"rk4", &gsl_odeiv2_step_rk4, 0},
+  {"rkf45", &gsl_odeiv2_step_rkf45, 0},
+  {"rkck", &gsl_odeiv2_step_rkck, 0},
+  {"rk8pd", &gsl_odeiv2_step_rk8pd, 0},
+  {"rk1imp", &gsl_odeiv2_step_rk1imp, 1},
+  {"rk2imp", &gsl_odeiv2_step_rk2imp, 1},
+  {"rk4imp", &gsl_odeiv2_step_rk4imp, 1},
+  {"bsimp", &gsl_odeiv2_step_bsimp, 1},
+  {"msadams", &gsl_odeiv2_step_msadams, 0},
+  {"msbdf", &gsl_odeiv2_step_msbdf, 1},
+  {NULL, NULL, 0}
+};
+
+static int odeiv2_step_type_get(VALUE tt)
+{
+  const char *name;
+  int i;
+  if (SYMBOL_P(tt)) {
+    name = rb_id2name(SYM2ID(tt));
+  } else if (TYPE(tt) == T_STRING) {
+    name = STR2CSTR(tt);
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (String or Symbol expected)",
+	     rb_class2name(CLASS_OF(tt)));
+  }
+  for (i = 0; odeiv2_step_types[i].name; i++)
+    if (strcmp(name, odeiv2_step_types[i].name) == 0) return i;
+  rb_raise(rb_eArgError, "unknown step type %s", name);
+  return -1;
+}
+
+static void mygsl_odeiv2_driver_mark(mygsl_odeiv2_driver *p)
+{
+  rb_gc_mark(p->vsys);
+}
+
+static void mygsl_odeiv2_driver_free(mygsl_odeiv2_driver *p)
+{
+  if (p->d) gsl_odeiv2_driver_free(p->d);
+  free(p);
+}
+
+static mygsl_odeiv2_driver* rb_gsl_get_odeiv2_driver(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_odeiv2_driver))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Odeiv2::Driver expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_odeiv2_driver, p);
+  return p;
+}
+
+/* Driver.alloc(sys, type, hstart, epsabs, epsrel[, a_y, a_dydt]) */
+static VALUE rb_gsl_odeiv2_driver_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_odeiv2_driver *p = NULL;
+  gsl_odeiv_system *src = NULL;
+  VALUE obj;
+  int i;
+  double hstart, epsabs, epsrel;
+  if (argc != 5 && argc != 7)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 5 or 7)", argc);
+  src = rb_gsl_odeiv_get_system(argv[0]);
+  i = odeiv2_step_type_get(argv[1]);
+  if (odeiv2_step_types[i].implicit &&
+      NIL_P(rb_funcall(argv[0], rb_intern("jacobian"), 0)))
+    rb_raise(rb_eArgError, "step type %s needs the Jacobian proc",
+	     odeiv2_step_types[i].name);
+  hstart = NUM2DBL(argv[2]);
+  epsabs = NUM2DBL(argv[3]);
+  epsrel = NUM2DBL(argv[4]);
+  obj = Data_Make_Struct(klass, mygsl_odeiv2_driver, mygsl_odeiv2_driver_mark,
+			 mygsl_odeiv2_driver_free, p);
+  p->vsys = argv[0];
+  p->sys.function = src->function;
+  p->sys.jacobian = src->jacobian;
+  p->sys.dimension = src->dimension;
+  p->sys.params = src->params;
+  if (argc == 5)
+    p->d = gsl_odeiv2_driver_alloc_y_new(&p->sys, *odeiv2_step_types[i].T,
+					 hstart, epsabs, epsrel);
+  else
+    p->d = gsl_odeiv2_driver_alloc_standard_new(&p->sys, *odeiv2_step_types[i].T,
+						hstart, epsabs, epsrel,
+						NUM2DBL(argv[5]), NUM2DBL(argv[6]));
+  if (p->d == NULL) rb_raise(rb_eNoMemError, "gsl_odeiv2_driver_alloc failed");
+  return obj;
+}
+
+/* y must be a contiguous Vector of the dimension the driver was made
+   for; System#set may have changed the dimension since */
+static double* odeiv2_driver_y(mygsl_odeiv2_driver *p, VALUE yy)
+{
+  gsl_vector *y = NULL;
+  gsl_odeiv_system *src = rb_gsl_odeiv_get_system(p->vsys);
+  if (src->dimension != p->sys.dimension)
+    rb_raise(rb_eRuntimeError, "the dimension of the system changed (%d to %d)",
+	     (int) p->sys.dimension, (int) src->dimension);
+  CHECK_VECTOR(yy);
+  Data_Get_Struct(yy, gsl_vector, y);
+  if (y->size != p->sys.dimension)
+    rb_raise(rb_eIndexError, "vector size %d does not match the dimension %d",
+	     (int) y->size, (int) p->sys.dimension);
+  if (y->stride != 1)
+    rb_raise(rb_eArgError, "the vector must be contiguous (stride 1)");
+  return y->data;
+}
+
+/* Driver#apply(t, t1, y): integrates y from t to t1 in place, returns
+   [t, status] */
+static VALUE rb_gsl_odeiv2_driver_apply(VALUE obj, VALUE tt, VALUE tt1, VALUE yy)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  double *y = odeiv2_driver_y(p, yy);
+  double t = NUM2DBL(tt);
+  int status;
+  status = gsl_odeiv2_driver_apply(p->d, &t, NUM2DBL(tt1), y);
+  return rb_ary_new3(2, rb_float_new(t), INT2FIX(status));
+}
+
+/* Driver#apply_fixed_step(t, h, n, y): n steps of size h from t */
+static VALUE rb_gsl_odeiv2_driver_apply_fixed_step(VALUE obj, VALUE tt, VALUE hh,
+						   VALUE nn, VALUE yy)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  double *y = odeiv2_driver_y(p, yy);
+  double t = NUM2DBL(tt);
+  int status;
+  status = gsl_odeiv2_driver_apply_fixed_step(p->d, &t, NUM2DBL(hh), NUM2ULONG(nn), y);
+  return rb_ary_new3(2, rb_float_new(t), INT2FIX(status));
+}
+
+static VALUE rb_gsl_odeiv2_driver_reset(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  gsl_odeiv2_driver_reset(p->d);
+  return obj;
+}
+
+static VALUE rb_gsl_odeiv2_driver_set_hmin(VALUE obj, VALUE hh)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  gsl_odeiv2_driver_set_hmin(p->d, NUM2DBL(hh));
+  return obj;
+}
+
+static VALUE rb_gsl_odeiv2_driver_set_hmax(VALUE obj, VALUE hh)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  gsl_odeiv2_driver_set_hmax(p->d, NUM2DBL(hh));
+  return obj;
+}
+
+static VALUE rb_gsl_odeiv2_driver_set_nmax(VALUE obj, VALUE nn)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  gsl_odeiv2_driver_set_nmax(p->d, NUM2ULONG(nn));
+  return obj;
+}
+
+/* the step size the next apply starts with */
+static VALUE rb_gsl_odeiv2_driver_h(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  return rb_float_new(p->d->h);
+}
+
+/* the number of steps taken by the last apply */
+static VALUE rb_gsl_odeiv2_driver_count(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  return ULONG2NUM(p->d->n);
+}
+
+static VALUE rb_gsl_odeiv2_driver_name(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  return rb_str_new2(gsl_odeiv2_step_name(p->d->s));
+}
+
+static VALUE rb_gsl_odeiv2_driver_dimension(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  return INT2FIX(p->sys.dimension);
+}
+
+static VALUE rb_gsl_odeiv2_driver_sys(VALUE obj)
+{
+  mygsl_odeiv2_driver *p = rb_gsl_get_odeiv2_driver(obj);
+  return p->vsys;
+}
+
+void Init_gsl_odeiv2(VALUE module)
+{
+  VALUE mgsl_odeiv, mgsl_odeiv2;
+  mgsl_odeiv = rb_const_get(module, rb_intern("Odeiv"));
+  mgsl_odeiv2 = rb_define_module_under(module, "Odeiv2");
+  rb_define_const(mgsl_odeiv2, "System", rb_const_get(mgsl_odeiv, rb_intern("System")));
+
+  cgsl_odeiv2_driver = rb_define_class_under(mgsl_odeiv2, "Driver", cGSL_Object);
+  rb_define_singleton_method(cgsl_odeiv2_driver, "alloc", rb_gsl_odeiv2_driver_new, -1);
+  rb_define_method(cgsl_odeiv2_driver, "apply", rb_gsl_odeiv2_driver_apply, 3);
+  rb_define_method(cgsl_odeiv2_driver, "apply_fixed_step",
+		   rb_gsl_odeiv2_driver_apply_fixed_step, 4);
+  rb_define_method(cgsl_odeiv2_driver, "reset", rb_gsl_odeiv2_driver_reset, 0);
+  rb_define_method(cgsl_odeiv2_driver, "set_hmin", rb_gsl_odeiv2_driver_set_hmin, 1);
+  rb_define_alias(cgsl_odeiv2_driver, "hmin=", "set_hmin");
+  rb_define_method(cgsl_odeiv2_driver, "set_hmax", rb_gsl_odeiv2_driver_set_hmax, 1);
+  rb_define_alias(cgsl_odeiv2_driver, "hmax=", "set_hmax");
+  rb_define_method(cgsl_odeiv2_driver, "set_nmax", rb_gsl_odeiv2_driver_set_nmax, 1);
+  rb_define_alias(cgsl_odeiv2_driver, "nmax=", "set_nmax");
+  rb_define_method(cgsl_odeiv2_driver, "h", rb_gsl_odeiv2_driver_h, 0);
+  rb_define_method(cgsl_odeiv2_driver, "count", rb_gsl_odeiv2_driver_count, 0);
+  rb_define_method(cgsl_odeiv2_driver, "name", rb_gsl_odeiv2_driver_name, 0);
+  rb_define_method(cgsl_odeiv2_driver, "dimension", rb_gsl_odeiv2_driver_dimension, 0);
+  rb_define_alias(cgsl_odeiv2_driver, "dim", "dimension");
+  rb_define_method(cgsl_odeiv2_driver, "sys", rb_gsl_odeiv2_driver_sys, 0);
+}
+
+#endif
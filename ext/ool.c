@@ -1,6 +1,7 @@
 #ifdef HAVE_OOL_OOL_VERSION_H
 #include "rb_gsl.h"
 #include "rb_gsl_array.h"
+#include "rb_gsl_probes.h"
 #include <ool/ool_conmin.h>
 #include "porting.h"
 
@@ -439,7 +440,7 @@ static VALUE rb_ool_conmin_function_alloc(int argc, VALUE *argv, VALUE klass)
   F->fdf = &rb_ool_conmin_function_fdf;
   F->Hv = &rb_ool_conmin_function_Hv;
   F->n = 0;
-  ary = rb_ary_new2(5);
+  ary = rb_ary_new2(OOL_FUNCTION_HX + 1);
 
   F->params = (void *) ary;
   rb_ary_store(ary, 0, Qnil);  /* proc f */
@@ -505,70 +506,246 @@ static VALUE rb_ool_conmin_function_n(VALUE obj)
   Data_Get_Struct(obj, ool_conmin_function, F);
   return INT2FIX((int) F->n);
 }
+/*
+  F->params is an Array [f, df, fdf, Hv, params, x view, gradient view,
+  direction view, Hv view, hessian, H]; the views passed to the procs
+  are kept there and repointed at OOL's vectors on each call (see
+  rb_gsl_callback_vector).  f may be a GSL::Function::Compiled in
+  x[0] ... x[n-1]: without df its gradient is evaluated in C by dual
+  numbers, and without Hv or hessian H*v is the difference quotient of
+  that gradient along v.  A hessian proc fills H, allocated once, at
+  each new x; the products gencan asks for at that x are then taken
+  in C, without calling Ruby.
+*/
+enum {
+  OOL_FUNCTION_F = 0,
+  OOL_FUNCTION_DF,
+  OOL_FUNCTION_FDF,
+  OOL_FUNCTION_HV,
+  OOL_FUNCTION_PARAMS,
+  OOL_FUNCTION_VX,
+  OOL_FUNCTION_VG,
+  OOL_FUNCTION_VV,
+  OOL_FUNCTION_VHV,
+  OOL_FUNCTION_HESSIAN,
+  OOL_FUNCTION_H,
+  OOL_FUNCTION_HX,
+};
+
+static int ool_compiled_p(VALUE proc)
+{
+  return rb_obj_is_kind_of(proc, cgsl_function_compiled);
+}
+
+/* x as contiguous doubles, in *tmp when x is strided */
+static const double* ool_contiguous(const gsl_vector *x, VALUE *tmp)
+{
+  double *xc;
+  size_t i;
+  if (x->stride == 1) return x->data;
+  xc = ALLOCV_N(double, *tmp, x->size);
+  for (i = 0; i < x->size; i++) xc[i] = gsl_vector_get(x, i);
+  return xc;
+}
+
+/* f(x) and, if g is given, its gradient, of the compiled f */
+static double ool_compiled_fdf(VALUE proc, const gsl_vector *x, gsl_vector *g)
+{
+  VALUE tmp = 0, gtmp = 0;
+  const double *xp;
+  double *gp, f;
+  size_t i;
+  void *c = rb_gsl_function_compiled_ptr(proc);
+  if (rb_gsl_function_compiled_dim(c) > x->size)
+    rb_raise(rb_eIndexError, "compiled function of %d variables, x has %d",
+	     (int) rb_gsl_function_compiled_dim(c), (int) x->size);
+  xp = ool_contiguous(x, &tmp);
+  if (g == NULL) {
+    f = rb_gsl_function_compiled_eval_multi(c, xp);
+  } else if (g->stride == 1) {
+    f = rb_gsl_function_compiled_eval_grad(c, xp, NULL, g->data);
+  } else {
+    gp = ALLOCV_N(double, gtmp, g->size);
+    f = rb_gsl_function_compiled_eval_grad(c, xp, NULL, gp);
+    for (i = 0; i < g->size; i++) gsl_vector_set(g, i, gp[i]);
+    ALLOCV_END(gtmp);
+  }
+  if (tmp) ALLOCV_END(tmp);
+  return f;
+}
+
 static double rb_ool_conmin_function_f(const gsl_vector *x, void *p)
 {
   VALUE vx, proc, vp, result, ary;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
+  gsl_vector xsaved;
   ary = (VALUE) p;
-  proc = rb_ary_entry(ary, 0);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
+  proc = rb_ary_entry(ary, OOL_FUNCTION_F);
+  if (ool_compiled_p(proc)) return ool_compiled_fdf(proc, x, NULL);
+  vp = rb_ary_entry(ary, OOL_FUNCTION_PARAMS);
+  vx = rb_gsl_callback_vector(ary, OOL_FUNCTION_VX, cgsl_vector_view_ro, x, &xsaved);
+  RB_GSL_CALLBACK_ENTRY("ool_f", x->size);
   if (NIL_P(vp)) result = rb_funcall(proc, RBGSL_ID_call, 1, vx);
   else result = rb_funcall(proc, RBGSL_ID_call, 2, vx, vp);
+  RB_GSL_CALLBACK_RETURN("ool_f", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
   return NUM2DBL(result);
 }
 
 static void rb_ool_conmin_function_df(const gsl_vector *x, void *p, gsl_vector *g)
 {
   VALUE vx, vg, proc, vp, ary;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vg = Data_Wrap_Struct(cgsl_vector, 0, NULL, g);
+  gsl_vector xsaved, gsaved;
   ary = (VALUE) p;
-  proc = rb_ary_entry(ary, 1);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
+  proc = rb_ary_entry(ary, OOL_FUNCTION_DF);
+  if (NIL_P(proc) && ool_compiled_p(rb_ary_entry(ary, OOL_FUNCTION_F))) {
+    ool_compiled_fdf(rb_ary_entry(ary, OOL_FUNCTION_F), x, g);
+    return;
+  }
+  vp = rb_ary_entry(ary, OOL_FUNCTION_PARAMS);
+  vx = rb_gsl_callback_vector(ary, OOL_FUNCTION_VX, cgsl_vector_view_ro, x, &xsaved);
+  vg = rb_gsl_callback_vector(ary, OOL_FUNCTION_VG, cgsl_vector_view, g, &gsaved);
+  RB_GSL_CALLBACK_ENTRY("ool_df", x->size);
   if (NIL_P(vp)) {
     rb_funcall(proc, RBGSL_ID_call, 2, vx, vg);
   } else {
     rb_funcall(proc, RBGSL_ID_call, 3, vx, vp, vg);
   }
+  RB_GSL_CALLBACK_RETURN("ool_df", x->size);
+  rb_gsl_callback_vector_restore(vx, &xsaved);
+  rb_gsl_callback_vector_restore(vg, &gsaved);
 }
 
 static void rb_ool_conmin_function_fdf(const gsl_vector *x, void *p, 
 				      double *f, gsl_vector *g)
 {
-  VALUE vx, vf, vg, proc_fdf, proc_f, proc_df, vp, ary, result;
-  vx = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector *) x);
-  vg = Data_Wrap_Struct(cgsl_vector, 0, NULL, g);
-  vf = rb_float_new(*f);
+  VALUE ary, proc_f;
   ary = (VALUE) p;
-  proc_f = rb_ary_entry(ary, 0);
-  proc_df = rb_ary_entry(ary, 1);
-  proc_fdf = rb_ary_entry(ary, 2);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
-  if (NIL_P(vp)) {
-    result = rb_funcall(proc_f, RBGSL_ID_call, 1, vx);
-    rb_funcall(proc_df, RBGSL_ID_call, 2, vx, vg);
-  } else {
-    result = rb_funcall(proc_f, RBGSL_ID_call, 2, vx, vp);
-    rb_funcall(proc_df, RBGSL_ID_call, 3, vx, vp, vg);
+  proc_f = rb_ary_entry(ary, OOL_FUNCTION_F);
+  if (NIL_P(rb_ary_entry(ary, OOL_FUNCTION_DF)) && ool_compiled_p(proc_f)) {
+    *f = ool_compiled_fdf(proc_f, x, g);
+    return;
+  }
+  *f = rb_ool_conmin_function_f(x, p);
+  rb_ool_conmin_function_df(x, p, g);
+}
+
+/* H is evaluated at Hx, which is NaN until the hessian proc has run */
+static int ool_hessian_at(const gsl_vector *Hx, const gsl_vector *X)
+{
+  size_t i;
+  for (i = 0; i < X->size; i++)
+    if (gsl_vector_get(Hx, i) != gsl_vector_get(X, i)) return 0;
+  return 1;
+}
+
+static void ool_hessian_reset(VALUE ary)
+{
+  VALUE vHx = rb_ary_entry(ary, OOL_FUNCTION_HX);
+  gsl_vector *Hx = NULL;
+  if (NIL_P(vHx)) return;
+  Data_Get_Struct(vHx, gsl_vector, Hx);
+  gsl_vector_set_all(Hx, GSL_NAN);
+}
+
+/* hv = H v, by the hessian proc, evaluated again only when x has moved */
+static void ool_hessian_Hv(VALUE ary, VALUE proc, const gsl_vector *X,
+			   const gsl_vector *V, gsl_vector *hv)
+{
+  VALUE vx, vH, vHx, vp;
+  gsl_matrix *H = NULL;
+  gsl_vector *Hx = NULL;
+  gsl_vector xsaved;
+  size_t n = X->size;
+  vH = rb_ary_entry(ary, OOL_FUNCTION_H);
+  vHx = rb_ary_entry(ary, OOL_FUNCTION_HX);
+  if (!NIL_P(vH)) {
+    Data_Get_Struct(vH, gsl_matrix, H);
+    Data_Get_Struct(vHx, gsl_vector, Hx);
+  }
+  if (H == NULL || H->size1 != n) {
+    H = gsl_matrix_calloc(n, n);
+    Hx = gsl_vector_alloc(n);
+    if (H == NULL || Hx == NULL) rb_raise(rb_eNoMemError, "hessian allocation failed");
+    gsl_vector_set_all(Hx, GSL_NAN);
+    vH = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, H);
+    vHx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, Hx);
+    rb_ary_store(ary, OOL_FUNCTION_H, vH);
+    rb_ary_store(ary, OOL_FUNCTION_HX, vHx);
+  }
+  if (!ool_hessian_at(Hx, X)) {
+    gsl_vector_set_all(Hx, GSL_NAN);
+    vp = rb_ary_entry(ary, OOL_FUNCTION_PARAMS);
+    vx = rb_gsl_callback_vector(ary, OOL_FUNCTION_VX, cgsl_vector_view_ro, X, &xsaved);
+    RB_GSL_CALLBACK_ENTRY("ool_hessian", n);
+    if (NIL_P(vp)) rb_funcall(proc, RBGSL_ID_call, 2, vx, vH);
+    else rb_funcall(proc, RBGSL_ID_call, 3, vx, vp, vH);
+    RB_GSL_CALLBACK_RETURN("ool_hessian", n);
+    rb_gsl_callback_vector_restore(vx, &xsaved);
+    gsl_vector_memcpy(Hx, X);
+  }
+  gsl_blas_dgemv(CblasNoTrans, 1.0, H, V, 0.0, hv);
+}
+
+/* hv = (g(x + h v) - g(x))/h with the exact gradient of the compiled f */
+static void ool_compiled_Hv(VALUE proc, const gsl_vector *X,
+			    const gsl_vector *V, gsl_vector *hv)
+{
+  VALUE tmp = 0;
+  double *xh, *g0, *g1, h, xnrm, vnrm;
+  size_t i, n = X->size;
+  void *c = rb_gsl_function_compiled_ptr(proc);
+  if (rb_gsl_function_compiled_dim(c) > n)
+    rb_raise(rb_eIndexError, "compiled function of %d variables, x has %d",
+	     (int) rb_gsl_function_compiled_dim(c), (int) n);
+  vnrm = gsl_blas_dnrm2(V);
+  if (vnrm == 0.0) {
+    gsl_vector_set_zero(hv);
+    return;
   }
-  *f = NUM2DBL(result);
+  xnrm = gsl_blas_dnrm2(X);
+  h = GSL_SQRT_DBL_EPSILON*(1.0 + xnrm)/vnrm;
+  xh = ALLOCV_N(double, tmp, 3*n);
+  g0 = xh + n;
+  g1 = g0 + n;
+  for (i = 0; i < n; i++) xh[i] = gsl_vector_get(X, i);
+  rb_gsl_function_compiled_eval_grad(c, xh, NULL, g0);
+  for (i = 0; i < n; i++) xh[i] += h*gsl_vector_get(V, i);
+  rb_gsl_function_compiled_eval_grad(c, xh, NULL, g1);
+  for (i = 0; i < n; i++) gsl_vector_set(hv, i, (g1[i] - g0[i])/h);
+  ALLOCV_END(tmp);
 }
 
 static void rb_ool_conmin_function_Hv(const gsl_vector *X, void *params,
 			const gsl_vector *V, gsl_vector *hv)
 {
-	VALUE vX, vV, vHv, ary, proc_Hv, vp;
-	vX = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector*) X);
-	vV = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector*) V);
-	vHv = Data_Wrap_Struct(cgsl_vector, 0, NULL, (gsl_vector*) hv);
-	ary = (VALUE) params;
-	proc_Hv = rb_ary_entry(ary, 3);
-  vp = rb_ary_entry(ary, RARRAY_LEN(ary)-1);
+  VALUE vX, vV, vHv, ary, proc_Hv, vp;
+  gsl_vector xsaved, vsaved, hvsaved;
+  ary = (VALUE) params;
+  proc_Hv = rb_ary_entry(ary, OOL_FUNCTION_HV);
+  if (NIL_P(proc_Hv)) {
+    if (!NIL_P(rb_ary_entry(ary, OOL_FUNCTION_HESSIAN))) {
+      ool_hessian_Hv(ary, rb_ary_entry(ary, OOL_FUNCTION_HESSIAN), X, V, hv);
+      return;
+    }
+    if (ool_compiled_p(rb_ary_entry(ary, OOL_FUNCTION_F))) {
+      ool_compiled_Hv(rb_ary_entry(ary, OOL_FUNCTION_F), X, V, hv);
+      return;
+    }
+  }
+  vp = rb_ary_entry(ary, OOL_FUNCTION_PARAMS);
+  vX = rb_gsl_callback_vector(ary, OOL_FUNCTION_VX, cgsl_vector_view_ro, X, &xsaved);
+  vV = rb_gsl_callback_vector(ary, OOL_FUNCTION_VV, cgsl_vector_view_ro, V, &vsaved);
+  vHv = rb_gsl_callback_vector(ary, OOL_FUNCTION_VHV, cgsl_vector_view, hv, &hvsaved);
+  RB_GSL_CALLBACK_ENTRY("ool_Hv", X->size);
   if (NIL_P(vp)) {
     rb_funcall(proc_Hv, RBGSL_ID_call, 3, vX, vV, vHv);
   } else {
     rb_funcall(proc_Hv, RBGSL_ID_call, 4, vX, vp, vV, vHv);
-  }  	
+  }
+  RB_GSL_CALLBACK_RETURN("ool_Hv", X->size);
+  rb_gsl_callback_vector_restore(vX, &xsaved);
+  rb_gsl_callback_vector_restore(vV, &vsaved);
+  rb_gsl_callback_vector_restore(vHv, &hvsaved);
 }
 
 static VALUE rb_ool_conmin_function_set_functions(int argc, VALUE *argv, VALUE obj)
@@ -677,14 +854,90 @@ static void set_params(ool_conmin_function *F, VALUE p)
   } else {
     ary = (VALUE) F->params;
   }
-  rb_ary_store(ary, 4, p);
+  rb_ary_store(ary, OOL_FUNCTION_PARAMS, p);
+  ool_hessian_reset(ary);
 }
 
 static VALUE rb_ool_conmin_function_params(VALUE obj)
 {
 	ool_conmin_function *F;
 	Data_Get_Struct(obj, ool_conmin_function, F);
-	return rb_ary_entry((VALUE) F->params, 4);;
+	return rb_ary_entry((VALUE) F->params, OOL_FUNCTION_PARAMS);
+}
+
+/*
+  Function#set_hessian(proc), #hessian=: proc.call(x, [params,] H) fills
+  the n x n GSL::Matrix H with the Hessian at x; it is called once per
+  point and the products H*v gencan asks for there are taken in C.
+  An Hv proc, if given, is used instead.
+*/
+static VALUE rb_ool_conmin_function_set_hessian(VALUE obj, VALUE proc)
+{
+	ool_conmin_function *F;
+	VALUE ary;
+	Data_Get_Struct(obj, ool_conmin_function, F);
+	ary = (VALUE) F->params;
+	rb_ary_store(ary, OOL_FUNCTION_HESSIAN, proc);
+	ool_hessian_reset(ary);
+	return proc;
+}
+
+/*
+  Function#Hv(x, v): H*v as the minimizers evaluate it; v may be a
+  GSL::Matrix whose columns are directions, evaluated together (one
+  call of a hessian proc for all of them).
+*/
+static VALUE rb_ool_conmin_function_eval_Hv(VALUE obj, VALUE vx, VALUE vv)
+{
+	ool_conmin_function *F;
+	gsl_vector *x, *v, *hv;
+	gsl_matrix *V, *HV;
+	gsl_vector_view col, hcol;
+	size_t j;
+	CHECK_VECTOR(vx);
+	Data_Get_Struct(obj, ool_conmin_function, F);
+	Data_Get_Struct(vx, gsl_vector, x);
+	if (MATRIX_P(vv)) {
+		Data_Get_Struct(vv, gsl_matrix, V);
+		if (V->size1 != x->size) rb_raise(rb_eArgError, "directions must have length %d",
+						   (int) x->size);
+		HV = gsl_matrix_alloc(V->size1, V->size2);
+		for (j = 0; j < V->size2; j++) {
+			col = gsl_matrix_column(V, j);
+			hcol = gsl_matrix_column(HV, j);
+			rb_ool_conmin_function_Hv(x, F->params, &col.vector, &hcol.vector);
+		}
+		return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, HV);
+	}
+	CHECK_VECTOR(vv);
+	Data_Get_Struct(vv, gsl_vector, v);
+	if (v->size != x->size) rb_raise(rb_eArgError, "direction must have length %d",
+					  (int) x->size);
+	hv = gsl_vector_alloc(x->size);
+	rb_ool_conmin_function_Hv(x, F->params, v, hv);
+	return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, hv);
+}
+
+/*
+  OOL::Conmin::Function.compile(expr, n, params = {})
+
+    f = OOL::Conmin::Function.compile("(x[0] - a)**2 + b*(x[1] - x[0]**2)**2",
+                                      2, "a" => 1, "b" => 100)
+
+  f in x[0] ... x[n-1] (see GSL::Function.compile), evaluated in C with
+  its gradient by dual numbers; df, Hv and hessian procs may still be
+  set.
+*/
+static VALUE rb_ool_conmin_function_compile(int argc, VALUE *argv, VALUE klass)
+{
+	VALUE obj, vn;
+	if (argc < 2 || argc > 3)
+		rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+	vn = argv[1];
+	obj = rb_ool_conmin_function_alloc(1, &vn, klass);
+	rb_ool_conmin_function_set_f(obj, rb_gsl_function_compile_multi(argv[0],
+				     argc == 3 ? argv[2] : Qnil, FIX2INT(vn)));
+	return obj;
 }
 
 static VALUE rb_ool_conmin_constraint_set(int argc, VALUE *argv, VALUE obj);
@@ -850,6 +1103,10 @@ void Init_ool(VALUE module)
 	rb_define_alias(cool_conmin_function, "fdf=", "set_fdf"); 	 	
  	rb_define_method(cool_conmin_function, "set_Hv", rb_ool_conmin_function_set_Hv, 1);
 	rb_define_alias(cool_conmin_function, "Hv=", "set_Hv"); 	 						
+	rb_define_method(cool_conmin_function, "set_hessian", rb_ool_conmin_function_set_hessian, 1);
+	rb_define_alias(cool_conmin_function, "hessian=", "set_hessian");
+	rb_define_method(cool_conmin_function, "Hv", rb_ool_conmin_function_eval_Hv, 2);
+	rb_define_singleton_method(cool_conmin_function, "compile", rb_ool_conmin_function_compile, -1);
 
 	rb_define_singleton_method(cool_conmin_constraint, "alloc", rb_ool_conmin_constraint_alloc,
 		-1);
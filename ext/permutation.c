@@ -525,6 +525,466 @@ static VALUE rb_gsl_permutation_equal(VALUE obj, VALUE other)
   return Qtrue;
 }
 
+/*
+  p.each_permutation { |q| ... } yields the permutations from the current
+  one of p to the last in lexicographic order, q being a single
+  Permutation rewritten at every step (clone it to keep one); p is left
+  as it is.  p.batch(n) returns [m, more]: the current permutation and
+  the following ones, n at most, in the rows of a GSL::Matrix::Int, p
+  being advanced past them; more is false on the last batch.
+*/
+static VALUE rb_gsl_permutation_each_permutation(VALUE obj)
+{
+  gsl_permutation *p, *state, *view;
+  VALUE vstate, vview;
+  RETURN_ENUMERATOR(obj, 0, 0);
+  Data_Get_Struct(obj, gsl_permutation, p);
+  state = gsl_permutation_alloc(p->size);
+  vstate = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, state);
+  view = gsl_permutation_alloc(p->size);
+  vview = Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_permutation_free, view);
+  memcpy(state->data, p->data, sizeof(size_t)*p->size);
+  do {
+    memcpy(view->data, state->data, sizeof(size_t)*state->size);
+    rb_yield(vview);
+  } while (gsl_permutation_next(state) == GSL_SUCCESS);
+  RB_GC_GUARD(vstate);
+  return obj;
+}
+
+static VALUE rb_gsl_permutation_batch(VALUE obj, VALUE nn)
+{
+  gsl_permutation *p;
+  gsl_matrix_int *m;
+  size_t n, i, j;
+  int more = 1;
+  VALUE vm;
+  Data_Get_Struct(obj, gsl_permutation, p);
+  n = NUM2SIZET(nn);
+  if (n == 0) rb_raise(rb_eArgError, "batch size must be positive");
+  m = gsl_matrix_int_alloc(n, p->size);
+  vm = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, m);
+  for (i = 0; i < n && more; ) {
+    for (j = 0; j < p->size; j++) m->data[i*m->tda + j] = (int) p->data[j];
+    i++;
+    more = (gsl_permutation_next(p) == GSL_SUCCESS);
+  }
+  m->size1 = i;
+  return rb_ary_new3(2, vm, more ? Qtrue : Qfalse);
+}
+
+/*
+  In-place permutation of the rows or columns of a matrix.
+
+    m.permute_rows!(p)              # row i becomes the row p[i] of m
+    m.permute_columns!(p)           # column j becomes the column p[j]
+    m.permute_rows_inverse!(p)      # row p[i] becomes the row i of m
+    m.permute_columns_inverse!(p)
+
+  as gsl_permute_vector does for the elements of a vector; for
+  GSL::Matrix, GSL::Matrix::Int and GSL::Matrix::Complex.  Rows are
+  moved whole along the cycles of p, decomposed once, the columns
+  being split in blocks between GSL.parallel_threads threads; for the
+  columns each row is gathered through a copy, the rows being split
+  between the threads.  The GVL is released from
+  GSL.parallel_threshold elements on.
+*/
+#define PERMUTE_BLOCK 512       /* bytes of a row moved by a thread at least */
+
+struct permute_task {
+  char *data;
+  size_t size1, size2, tda, es;  /* tda and es in bytes */
+  const size_t *p;
+  int inverse;
+  size_t *cyc, *start, ncyc;    /* the cycles of length > 1, one after the other */
+  char *tmp;
+  size_t tmpsize;               /* bytes of tmp per thread */
+  size_t nparts, nthreads;
+};
+
+/* The cycles of p as cyc[start[c] ... start[c+1]-1], c < ncyc, each
+   following p from its least element */
+static size_t permute_cycles(const size_t *p, size_t n, size_t *cyc, size_t *start,
+			     unsigned char *seen)
+{
+  size_t i, j, len = 0, ncyc = 0;
+  memset(seen, 0, n);
+  for (i = 0; i < n; i++) {
+    if (seen[i] || p[i] == i) continue;
+    start[ncyc++] = len;
+    for (j = i; !seen[j]; j = p[j]) {
+      seen[j] = 1;
+      cyc[len++] = j;
+    }
+  }
+  start[ncyc] = len;
+  return ncyc;
+}
+
+/* The columns [c0, c1) of the rows moved along the cycles */
+static void permute_rows_block(struct permute_task *t, size_t c0, size_t c1, char *tmp)
+{
+  size_t c, j, len, *cy, w = (c1 - c0)*t->es;
+  char *base = t->data + c0*t->es;
+  for (c = 0; c < t->ncyc; c++) {
+    cy = t->cyc + t->start[c];
+    len = t->start[c+1] - t->start[c];
+    if (!t->inverse) {
+      memcpy(tmp, base + cy[0]*t->tda, w);
+      for (j = 0; j + 1 < len; j++)
+	memcpy(base + cy[j]*t->tda, base + cy[j+1]*t->tda, w);
+      memcpy(base + cy[len-1]*t->tda, tmp, w);
+    } else {
+      memcpy(tmp, base + cy[len-1]*t->tda, w);
+      for (j = len - 1; j > 0; j--)
+	memcpy(base + cy[j]*t->tda, base + cy[j-1]*t->tda, w);
+      memcpy(base + cy[0]*t->tda, tmp, w);
+    }
+  }
+}
+
+static void permute_columns_row(struct permute_task *t, size_t i, char *tmp)
+{
+  char *row = t->data + i*t->tda;
+  const size_t *p = t->p;
+  size_t j, n = t->size2, es = t->es;
+  memcpy(tmp, row, n*es);
+  if (es == sizeof(double)) {
+    double *r = (double *) row, *x = (double *) tmp;
+    if (t->inverse) for (j = 0; j < n; j++) r[p[j]] = x[j];
+    else for (j = 0; j < n; j++) r[j] = x[p[j]];
+  } else if (es == sizeof(int)) {
+    int *r = (int *) row, *x = (int *) tmp;
+    if (t->inverse) for (j = 0; j < n; j++) r[p[j]] = x[j];
+    else for (j = 0; j < n; j++) r[j] = x[p[j]];
+  } else {
+    if (t->inverse) for (j = 0; j < n; j++) memcpy(row + p[j]*es, tmp + j*es, es);
+    else for (j = 0; j < n; j++) memcpy(row + j*es, tmp + p[j]*es, es);
+  }
+}
+
+static void permute_range(struct permute_task *t, size_t b0, size_t b1, char *tmp)
+{
+  size_t i, c0, c1;
+  if (t->cyc) {
+    /* b0 ... b1 are column blocks */
+    for (i = b0; i < b1; i++) {
+      c0 = t->size2*i/t->nparts;
+      c1 = t->size2*(i + 1)/t->nparts;
+      if (c1 > c0) permute_rows_block(t, c0, c1, tmp);
+    }
+  } else {
+    for (i = b0; i < b1; i++) permute_columns_row(t, i, tmp);
+  }
+}
+
+static int permute_worker(void *data, size_t id)
+{
+  struct permute_task *t = (struct permute_task *) data;
+  permute_range(t, t->nparts*id/t->nthreads, t->nparts*(id + 1)/t->nthreads,
+		t->tmp + id*t->tmpsize);
+  return GSL_SUCCESS;
+}
+
+static int permute_serial(void *data)
+{
+  struct permute_task *t = (struct permute_task *) data;
+  permute_range(t, 0, t->nparts, t->tmp);
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_matrix_permute0(VALUE obj, VALUE pp, int columns, int inverse)
+{
+  struct permute_task t;
+  gsl_permutation *p;
+  gsl_matrix *m;
+  gsl_matrix_int *mi;
+  gsl_matrix_complex *mc;
+  unsigned char *seen;
+  size_t n, work;
+  VALUE vcyc = 0, vtmp;
+  CHECK_PERMUTATION(pp);
+  Data_Get_Struct(pp, gsl_permutation, p);
+  if (MATRIX_INT_P(obj)) {
+    Data_Get_Struct(obj, gsl_matrix_int, mi);
+    t.data = (char *) mi->data;
+    t.size1 = mi->size1;
+    t.size2 = mi->size2;
+    t.tda = mi->tda*sizeof(int);
+    t.es = sizeof(int);
+  } else if (MATRIX_COMPLEX_P(obj)) {
+    Data_Get_Struct(obj, gsl_matrix_complex, mc);
+    t.data = (char *) mc->data;
+    t.size1 = mc->size1;
+    t.size2 = mc->size2;
+    t.tda = mc->tda*2*sizeof(double);
+    t.es = 2*sizeof(double);
+  } else {
+    CHECK_MATRIX(obj);
+    Data_Get_Struct(obj, gsl_matrix, m);
+    t.data = (char *) m->data;
+    t.size1 = m->size1;
+    t.size2 = m->size2;
+    t.tda = m->tda*sizeof(double);
+    t.es = sizeof(double);
+  }
+  n = columns ? t.size2 : t.size1;
+  if (p->size != n)
+    rb_raise(rb_eRangeError, "permutation of size %d for %d %s", (int) p->size, (int) n,
+	     columns ? "columns" : "rows");
+  if (gsl_permutation_valid(p) != GSL_SUCCESS)
+    rb_raise(rb_eArgError, "invalid permutation");
+  t.p = p->data;
+  t.inverse = inverse;
+  t.cyc = NULL;
+  if (columns) {
+    t.nparts = t.size1;
+    t.tmpsize = t.size2*t.es;
+  } else {
+    t.cyc = ALLOCV_N(size_t, vcyc, 2*n + 2 + (n + sizeof(size_t) - 1)/sizeof(size_t));
+    t.start = t.cyc + n;
+    seen = (unsigned char *) (t.start + n + 2);
+    t.ncyc = permute_cycles(p->data, n, t.cyc, t.start, seen);
+    if (t.ncyc == 0) {
+      ALLOCV_END(vcyc);
+      return obj;
+    }
+    t.nparts = GSL_MAX(t.size2*t.es/PERMUTE_BLOCK, 1);
+    t.nparts = GSL_MIN(t.nparts, t.size2);
+    t.tmpsize = (t.size2/t.nparts + 1)*t.es;
+  }
+  work = t.size1*t.size2;
+  t.nthreads = rb_gsl_parallel_nthreads(work, t.nparts);
+  if (t.nthreads < 1) t.nthreads = 1;
+  t.tmp = (char *) ALLOCV(vtmp, t.nthreads*t.tmpsize);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(permute_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(permute_serial, &t, work);
+  ALLOCV_END(vtmp);
+  if (vcyc) ALLOCV_END(vcyc);
+  return obj;
+}
+
+static VALUE rb_gsl_matrix_permute_rows(VALUE obj, VALUE pp)
+{
+  return rb_gsl_matrix_permute0(obj, pp, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_permute_rows_inverse(VALUE obj, VALUE pp)
+{
+  return rb_gsl_matrix_permute0(obj, pp, 0, 1);
+}
+
+static VALUE rb_gsl_matrix_permute_columns(VALUE obj, VALUE pp)
+{
+  return rb_gsl_matrix_permute0(obj, pp, 1, 0);
+}
+
+static VALUE rb_gsl_matrix_permute_columns_inverse(VALUE obj, VALUE pp)
+{
+  return rb_gsl_matrix_permute0(obj, pp, 1, 1);
+}
+
+/*
+  Gathering and scattering many arrays through one permutation.
+
+    w = p.gather(v)         # w[i] = v[p[i]], as v.permute(p) into a copy
+    w = p.scatter(v)        # w[p[i]] = v[i], the inverse
+    ws = p.gather([v0, v1, ...])
+    p.gather(m, out)        # the rows of a matrix, into out
+
+  v is a Vector, Vector::Int or Vector::Complex, or a Matrix,
+  Matrix::Int or Matrix::Complex whose rows are permuted; an Array of
+  them gives an Array.  The arrays are new unless out (an array or an
+  Array of them of the same sizes) is given.  Each array is swept
+  through the whole of p in turn: for a random p the reads are what
+  costs, and going through all the arrays block by block of p instead
+  spreads them over the pages of every array at once, which was found
+  twice slower.  The work, GATHER_BLOCK indices of one array a piece, is
+  split between GSL.parallel_threads threads with the GVL released
+  from GSL.parallel_threshold elements on.
+*/
+#define GATHER_BLOCK 65536
+
+struct gather_seg {
+  const char *src;
+  char *dst;
+  size_t ss, ds, es;            /* strides and element size in bytes */
+};
+
+struct gather_task {
+  struct gather_seg *seg;
+  size_t nseg, n, nblocks, nthreads;
+  const size_t *p;
+  int scatter;
+};
+
+#define GATHER_LOOP(type) do {\
+    const char *x = g->src;\
+    char *y = g->dst;\
+    if (t->scatter) for (i = b; i < e; i++)\
+      *(type *) (y + p[i]*g->ds) = *(const type *) (x + i*g->ss);\
+    else for (i = b; i < e; i++)\
+      *(type *) (y + i*g->ds) = *(const type *) (x + p[i]*g->ss);\
+  } while (0)
+
+/* The pieces [q0, q1), piece q being the block q % nblocks of the
+   array q / nblocks */
+static void gather_range(const struct gather_task *t, size_t q0, size_t q1)
+{
+  const size_t *p = t->p;
+  size_t q, b, e, i;
+  for (q = q0; q < q1; q++) {
+    const struct gather_seg *g = t->seg + q/t->nblocks;
+    b = (q % t->nblocks)*GATHER_BLOCK;
+    e = GSL_MIN(b + GATHER_BLOCK, t->n);
+    if (g->es == sizeof(double)) GATHER_LOOP(double);
+    else if (g->es == sizeof(int)) GATHER_LOOP(int);
+    else if (t->scatter)
+      for (i = b; i < e; i++) memcpy(g->dst + p[i]*g->ds, g->src + i*g->ss, g->es);
+    else
+      for (i = b; i < e; i++) memcpy(g->dst + i*g->ds, g->src + p[i]*g->ss, g->es);
+  }
+}
+
+static int gather_worker(void *data, size_t id)
+{
+  struct gather_task *t = (struct gather_task *) data;
+  size_t nq = t->nseg*t->nblocks;
+  gather_range(t, nq*id/t->nthreads, nq*(id + 1)/t->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int gather_serial(void *data)
+{
+  struct gather_task *t = (struct gather_task *) data;
+  gather_range(t, 0, t->nseg*t->nblocks);
+  return GSL_SUCCESS;
+}
+
+/* The elements (the rows of a matrix) of x as n items of es bytes
+   stride bytes apart; kind tells the class of x apart, and size2 is the
+   number of columns of a matrix */
+static char* gather_layout(VALUE x, size_t *n, size_t *stride, size_t *es, size_t *size2,
+			   int *kind)
+{
+  gsl_vector *v;
+  gsl_vector_int *vi;
+  gsl_vector_complex *vc;
+  gsl_matrix *m;
+  gsl_matrix_int *mi;
+  gsl_matrix_complex *mc;
+  *size2 = 1;
+  if (VECTOR_INT_P(x)) {
+    Data_Get_Struct(x, gsl_vector_int, vi);
+    *kind = 1; *n = vi->size; *es = sizeof(int); *stride = vi->stride*sizeof(int);
+    return (char *) vi->data;
+  } else if (VECTOR_COMPLEX_P(x)) {
+    Data_Get_Struct(x, gsl_vector_complex, vc);
+    *kind = 2; *n = vc->size; *es = 2*sizeof(double); *stride = vc->stride*2*sizeof(double);
+    return (char *) vc->data;
+  } else if (MATRIX_INT_P(x)) {
+    Data_Get_Struct(x, gsl_matrix_int, mi);
+    *kind = 4; *n = mi->size1; *size2 = mi->size2;
+    *es = mi->size2*sizeof(int); *stride = mi->tda*sizeof(int);
+    return (char *) mi->data;
+  } else if (MATRIX_COMPLEX_P(x)) {
+    Data_Get_Struct(x, gsl_matrix_complex, mc);
+    *kind = 5; *n = mc->size1; *size2 = mc->size2;
+    *es = mc->size2*2*sizeof(double); *stride = mc->tda*2*sizeof(double);
+    return (char *) mc->data;
+  } else if (MATRIX_P(x)) {
+    Data_Get_Struct(x, gsl_matrix, m);
+    *kind = 3; *n = m->size1; *size2 = m->size2;
+    *es = m->size2*sizeof(double); *stride = m->tda*sizeof(double);
+    return (char *) m->data;
+  }
+  CHECK_VECTOR(x);
+  Data_Get_Struct(x, gsl_vector, v);
+  *kind = 0; *n = v->size; *es = sizeof(double); *stride = v->stride*sizeof(double);
+  return (char *) v->data;
+}
+
+static VALUE gather_alloc(int kind, size_t n, size_t size2)
+{
+  switch (kind) {
+  case 1:
+    return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, gsl_vector_int_alloc(n));
+  case 2:
+    return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free,
+			    gsl_vector_complex_alloc(n));
+  case 3:
+    return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, gsl_matrix_alloc(n, size2));
+  case 4:
+    return Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free,
+			    gsl_matrix_int_alloc(n, size2));
+  case 5:
+    return Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free,
+			    gsl_matrix_complex_alloc(n, size2));
+  default:
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_alloc(n));
+  }
+}
+
+static VALUE rb_gsl_permutation_gather0(int argc, VALUE *argv, VALUE obj, int scatter)
+{
+  struct gather_task t;
+  gsl_permutation *p;
+  VALUE src, out, res, vseg, x, y;
+  size_t i, n, n2, size2, size22, es, es2;
+  int kind, kind2, ary;
+  rb_scan_args(argc, argv, "11", &src, &out);
+  Data_Get_Struct(obj, gsl_permutation, p);
+  if (gsl_permutation_valid(p) != GSL_SUCCESS)
+    rb_raise(rb_eArgError, "invalid permutation");
+  ary = (TYPE(src) == T_ARRAY);
+  if (!ary) {
+    src = rb_ary_new3(1, src);
+    if (!NIL_P(out)) out = rb_ary_new3(1, out);
+  } else if (!NIL_P(out)) {
+    Check_Type(out, T_ARRAY);
+    if (RARRAY_LEN(out) != RARRAY_LEN(src))
+      rb_raise(rb_eArgError, "%d arrays for %d", (int) RARRAY_LEN(out),
+	       (int) RARRAY_LEN(src));
+  }
+  t.nseg = RARRAY_LEN(src);
+  t.seg = ALLOCV_N(struct gather_seg, vseg, t.nseg);
+  res = rb_ary_new2(t.nseg);
+  for (i = 0; i < t.nseg; i++) {
+    x = rb_ary_entry(src, i);
+    t.seg[i].src = gather_layout(x, &n, &t.seg[i].ss, &es, &size2, &kind);
+    if (n != p->size)
+      rb_raise(rb_eRangeError, "permutation of size %d for %d elements", (int) p->size,
+	       (int) n);
+    y = NIL_P(out) ? gather_alloc(kind, n, size2) : rb_ary_entry(out, i);
+    t.seg[i].dst = gather_layout(y, &n2, &t.seg[i].ds, &es2, &size22, &kind2);
+    if (kind2 != kind || n2 != n || size22 != size2)
+      rb_raise(rb_eTypeError, "out does not match the array %d", (int) i);
+    if (t.seg[i].dst == t.seg[i].src) rb_raise(rb_eArgError, "out must be another array");
+    t.seg[i].es = es;
+    rb_ary_store(res, i, y);
+  }
+  t.p = p->data;
+  t.n = p->size;
+  t.scatter = scatter;
+  t.nblocks = (t.n + GATHER_BLOCK - 1)/GATHER_BLOCK;
+  n = t.n*t.nseg;
+  t.nthreads = rb_gsl_parallel_nthreads(n, t.nseg*t.nblocks);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(gather_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(gather_serial, &t, n);
+  ALLOCV_END(vseg);
+  return ary ? res : rb_ary_entry(res, 0);
+}
+
+static VALUE rb_gsl_permutation_gather(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_permutation_gather0(argc, argv, obj, 0);
+}
+
+static VALUE rb_gsl_permutation_scatter(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_permutation_gather0(argc, argv, obj, 1);
+}
+
 void Init_gsl_permutation(VALUE module)
 {
   rb_define_singleton_method(cgsl_permutation, "alloc", rb_gsl_permutation_alloc, 1);
@@ -551,6 +1011,8 @@ void Init_gsl_permutation(VALUE module)
   rb_define_alias(cgsl_permutation, "inv", "inverse");
   rb_define_method(cgsl_permutation, "next", rb_gsl_permutation_next, 0);
   rb_define_method(cgsl_permutation, "prev", rb_gsl_permutation_prev, 0);
+  rb_define_method(cgsl_permutation, "each_permutation", rb_gsl_permutation_each_permutation, 0);
+  rb_define_method(cgsl_permutation, "batch", rb_gsl_permutation_batch, 1);
 
   rb_define_method(cgsl_permutation, "permute_vector", rb_gsl_permutation_permute_vector, 1);
   rb_define_alias(cgsl_permutation, "permute", "permute_vector");
@@ -590,6 +1052,22 @@ void Init_gsl_permutation(VALUE module)
   rb_define_method(cgsl_vector, "permute", rb_gsl_vector_permute, 1);
   rb_define_method(cgsl_vector, "permute_inverse", rb_gsl_vector_permute_inverse, 1);
 
+  rb_define_method(cgsl_matrix, "permute_rows!", rb_gsl_matrix_permute_rows, 1);
+  rb_define_method(cgsl_matrix, "permute_rows_inverse!", rb_gsl_matrix_permute_rows_inverse, 1);
+  rb_define_method(cgsl_matrix, "permute_columns!", rb_gsl_matrix_permute_columns, 1);
+  rb_define_method(cgsl_matrix, "permute_columns_inverse!", rb_gsl_matrix_permute_columns_inverse, 1);
+  rb_define_method(cgsl_matrix_int, "permute_rows!", rb_gsl_matrix_permute_rows, 1);
+  rb_define_method(cgsl_matrix_int, "permute_rows_inverse!", rb_gsl_matrix_permute_rows_inverse, 1);
+  rb_define_method(cgsl_matrix_int, "permute_columns!", rb_gsl_matrix_permute_columns, 1);
+  rb_define_method(cgsl_matrix_int, "permute_columns_inverse!", rb_gsl_matrix_permute_columns_inverse, 1);
+  rb_define_method(cgsl_matrix_complex, "permute_rows!", rb_gsl_matrix_permute_rows, 1);
+  rb_define_method(cgsl_matrix_complex, "permute_rows_inverse!", rb_gsl_matrix_permute_rows_inverse, 1);
+  rb_define_method(cgsl_matrix_complex, "permute_columns!", rb_gsl_matrix_permute_columns, 1);
+  rb_define_method(cgsl_matrix_complex, "permute_columns_inverse!", rb_gsl_matrix_permute_columns_inverse, 1);
+
+  rb_define_method(cgsl_permutation, "gather", rb_gsl_permutation_gather, -1);
+  rb_define_method(cgsl_permutation, "scatter", rb_gsl_permutation_scatter, -1);
+
   rb_define_method(cgsl_permutation, "equal?", rb_gsl_permutation_equal, 1);
   rb_define_alias(cgsl_permutation, "==", "equal?");
 
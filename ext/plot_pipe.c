@@ -0,0 +1,323 @@
+/*
+  plot_pipe.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Data pipes to GNU graph and gnuplot.  The plotting methods (Vector#graph,
+  Vector#plot, Histogram#graph, GSL::Graph#graph, ...) collect their points
+  in a buffer, as raw doubles when the program reads binary input, and
+  hand it to a native thread which writes it to the popen'ed program in
+  large blocks and closes the pipe, so the method returns as soon as the
+  program has been started.
+
+    v.graph("-T png > v.png")
+    w.graph("-T png > w.png")      # both are written concurrently
+    GSL.wait_plots                 # every plotting program has exited
+
+  GNU graph is given "-I d" (binary doubles, datasets separated by one
+  DBL_MAX) unless the command names its own input format; gnuplot reads
+  "plot '-' binary record=N format='%float64...'".  Ruby waits at exit
+  until every buffer has reached its program.  Without pthreads the
+  buffer is written by the caller with the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_common.h"
+#ifdef HAVE_RUBY_THREAD_H
+#include "ruby/thread.h"
+#endif
+#include <float.h>
+#include <stdarg.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#define PIPE_THREAD
+#endif
+
+#define PIPE_BLOCK (1 << 20)
+
+struct rb_gsl_pipe {
+  char *buf;                    /* plain malloc: freed by the writer thread */
+  size_t len, cap;
+  int binary;
+};
+
+typedef struct {
+  FILE *fp;
+  char *buf;
+  size_t len;
+} pipe_job;
+
+#ifdef PIPE_THREAD
+static pthread_mutex_t pipe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pipe_done = PTHREAD_COND_INITIALIZER;
+static size_t pipe_sending = 0, pipe_running = 0;
+#endif
+
+static void rb_gsl_pipe_free(rb_gsl_pipe *p)
+{
+  free(p->buf);
+  free(p);
+}
+
+VALUE rb_gsl_pipe_new(int binary, rb_gsl_pipe **pp)
+{
+  rb_gsl_pipe *p;
+  p = (rb_gsl_pipe *) calloc(1, sizeof(rb_gsl_pipe));
+  if (p == NULL) rb_memerror();
+  p->binary = binary;
+  *pp = p;
+  return Data_Wrap_Struct(rb_cObject, 0, rb_gsl_pipe_free, p);
+}
+
+static char* pipe_reserve(rb_gsl_pipe *p, size_t n)
+{
+  char *buf;
+  size_t cap;
+  if (p->len + n > p->cap) {
+    cap = p->cap ? p->cap : 4096;
+    while (cap < p->len + n) cap *= 2;
+    buf = (char *) realloc(p->buf, cap);
+    if (buf == NULL) rb_memerror();
+    p->buf = buf;
+    p->cap = cap;
+  }
+  return p->buf + p->len;
+}
+
+int rb_gsl_pipe_binary(const rb_gsl_pipe *p)
+{
+  return p->binary;
+}
+
+void rb_gsl_pipe_printf(rb_gsl_pipe *p, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+  va_start(ap, fmt);
+  n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  if (n <= 0) return;
+  va_start(ap, fmt);
+  vsnprintf(pipe_reserve(p, (size_t) n + 1), (size_t) n + 1, fmt, ap);
+  va_end(ap);
+  p->len += n;
+}
+
+/* One record of n columns: "%g %g ...\n", or n raw doubles */
+void rb_gsl_pipe_record(rb_gsl_pipe *p, size_t n, const double *v)
+{
+  size_t i;
+  if (p->binary) {
+    memcpy(pipe_reserve(p, n*sizeof(double)), v, n*sizeof(double));
+    p->len += n*sizeof(double);
+    return;
+  }
+  for (i = 0; i < n; i++)
+    rb_gsl_pipe_printf(p, i + 1 < n ? "%g " : "%g\n", v[i]);
+}
+
+void rb_gsl_pipe_point(rb_gsl_pipe *p, double x, double y)
+{
+  double v[2];
+  v[0] = x; v[1] = y;
+  rb_gsl_pipe_record(p, 2, v);
+}
+
+/* Ends a GNU graph dataset */
+void rb_gsl_pipe_break(rb_gsl_pipe *p)
+{
+  double sep = DBL_MAX;
+  if (p->binary) {
+    memcpy(pipe_reserve(p, sizeof(double)), &sep, sizeof(double));
+    p->len += sizeof(double);
+  } else {
+    rb_gsl_pipe_printf(p, "\n");
+  }
+}
+
+/* Makes a GNU graph command read binary doubles unless it sets -I */
+int rb_gsl_graph_command_binary(char *command)
+{
+  const char *s;
+  for (s = strstr(command, "-I"); s; s = strstr(s + 2, "-I"))
+    if (s == command || s[-1] == ' ') return 0;
+  strcat(command, " -I d");
+  return 1;
+}
+
+/*
+  Starts a gnuplot "plot '-'" of n binary records of ncols doubles, plotted
+  with the "using" and other modifiers of opts (may be NULL)
+*/
+void rb_gsl_pipe_gnuplot(rb_gsl_pipe *p, size_t n, size_t ncols, const char *opts)
+{
+  const char *s;
+  size_t i;
+  int using = 0;
+  if (opts == NULL) opts = "";
+  for (s = opts; *s; s++) {
+    if ((s == opts || s[-1] == ' ')
+	&& (strncmp(s, "using", 5) == 0 || strncmp(s, "u ", 2) == 0)) using = 1;
+  }
+  rb_gsl_pipe_printf(p, "plot '-' binary record=%lu format='", (unsigned long) n);
+  for (i = 0; i < ncols; i++) rb_gsl_pipe_printf(p, "%%float64");
+  rb_gsl_pipe_printf(p, "'");
+  if (using == 0) {
+    rb_gsl_pipe_printf(p, " using 1");
+    for (i = 1; i < ncols; i++) rb_gsl_pipe_printf(p, ":%d", (int) i + 1);
+  }
+  rb_gsl_pipe_printf(p, " %s\n", opts);
+}
+
+static void* pipe_write(void *data)
+{
+  pipe_job *job = (pipe_job *) data;
+  size_t off, n;
+  for (off = 0; off < job->len; off += n) {
+    n = job->len - off < PIPE_BLOCK ? job->len - off : PIPE_BLOCK;
+    if (fwrite(job->buf + off, 1, n, job->fp) != n) break;
+  }
+  fflush(job->fp);
+  free(job->buf);
+  job->buf = NULL;
+  return NULL;
+}
+
+/* The caller's delivery, without a thread */
+static void* pipe_deliver(void *data)
+{
+  pipe_job *job = (pipe_job *) data;
+  pipe_write(job);
+  pclose(job->fp);
+  return NULL;
+}
+
+#ifdef PIPE_THREAD
+static void* pipe_thread(void *data)
+{
+  pipe_job *job = (pipe_job *) data;
+  pipe_write(job);
+  pthread_mutex_lock(&pipe_lock);
+  pipe_sending--;
+  pthread_cond_broadcast(&pipe_done);
+  pthread_mutex_unlock(&pipe_lock);
+  pclose(job->fp);
+  free(job);
+  pthread_mutex_lock(&pipe_lock);
+  pipe_running--;
+  pthread_cond_broadcast(&pipe_done);
+  pthread_mutex_unlock(&pipe_lock);
+  return NULL;
+}
+
+static void* pipe_wait(void *data)
+{
+  size_t *count = (size_t *) data;
+  pthread_mutex_lock(&pipe_lock);
+  while (*count > 0) pthread_cond_wait(&pipe_done, &pipe_lock);
+  pthread_mutex_unlock(&pipe_lock);
+  return NULL;
+}
+
+static void pipe_blocking_wait(size_t *count)
+{
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+  rb_thread_call_without_gvl(pipe_wait, count, NULL, NULL);
+#else
+  pipe_wait(count);
+#endif
+}
+
+/* A forked child has none of the writer threads */
+static void pipe_atfork_prepare(void) { pthread_mutex_lock(&pipe_lock); }
+static void pipe_atfork_parent(void) { pthread_mutex_unlock(&pipe_lock); }
+static void pipe_atfork_child(void)
+{
+  pipe_sending = pipe_running = 0;
+  pthread_mutex_unlock(&pipe_lock);
+}
+
+static void pipe_end_proc(VALUE unused)
+{
+  pipe_blocking_wait(&pipe_sending);
+}
+#endif
+
+/*
+  Starts command and sends it the buffer of pipe; errname names the
+  program in the IOError raised when it cannot be started.
+*/
+void rb_gsl_pipe_send(VALUE pipe, const char *command, const char *errname)
+{
+  rb_gsl_pipe *p;
+  pipe_job *job;
+  FILE *fp;
+  Data_Get_Struct(pipe, rb_gsl_pipe, p);
+  job = (pipe_job *) malloc(sizeof(pipe_job));
+  if (job == NULL) rb_memerror();
+  fp = popen(command, "w");
+  if (fp == NULL) {
+    free(job);
+    rb_raise(rb_eIOError, "%s not found.", errname);
+  }
+  job->fp = fp;
+  job->buf = p->buf;
+  job->len = p->len;
+  p->buf = NULL;
+  p->len = p->cap = 0;
+#ifdef PIPE_THREAD
+  {
+    pthread_t th;
+    pthread_attr_t attr;
+    int status;
+    pthread_mutex_lock(&pipe_lock);
+    pipe_sending++;
+    pipe_running++;
+    pthread_mutex_unlock(&pipe_lock);
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    status = pthread_create(&th, &attr, pipe_thread, job);
+    pthread_attr_destroy(&attr);
+    if (status == 0) return;
+    pthread_mutex_lock(&pipe_lock);
+    pipe_sending--;
+    pipe_running--;
+    pthread_mutex_unlock(&pipe_lock);
+  }
+#endif
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+  rb_thread_call_without_gvl(pipe_deliver, job, NULL, NULL);
+#else
+  pipe_deliver(job);
+#endif
+  free(job);
+  RB_GC_GUARD(pipe);
+}
+
+/*
+  Waits until every program started by a plotting method has read its
+  data and exited.
+*/
+static VALUE rb_gsl_wait_plots(VALUE module)
+{
+#ifdef PIPE_THREAD
+  pipe_blocking_wait(&pipe_running);
+#endif
+  return Qnil;
+}
+
+void Init_gsl_plot_pipe(VALUE module)
+{
+#ifdef PIPE_THREAD
+  pthread_atfork(pipe_atfork_prepare, pipe_atfork_parent, pipe_atfork_child);
+  rb_set_end_proc(pipe_end_proc, Qnil);
+#endif
+  rb_define_module_function(module, "wait_plots", rb_gsl_wait_plots, 0);
+}
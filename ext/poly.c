@@ -12,6 +12,8 @@
 #include "rb_gsl_poly.h"
 #include "rb_gsl_array.h"
 #include "rb_gsl_common.h"
+#include "rb_gsl_fft.h"
+#include <stdint.h>
 #ifdef HAVE_NARARY_H
 #include "narray.h"
 #endif
@@ -27,6 +29,7 @@ void Init_gsl_poly2(VALUE module);
 void Init_gsl_poly(VALUE module)
 {
   Init_gsl_poly_init(module);
+  Init_gsl_poly_batch(cgsl_poly);
 }
 
 #undef  BASE_DOUBLE
@@ -0,0 +1,279 @@
+/*
+  poly_batch.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The roots of many polynomials of one degree in one call.
+
+    c = GSL::Matrix.alloc(batch, 4)              # c0 + c1 x + c2 x**2 + c3 x**3
+    z, n = GSL::Poly::Batch.complex_solve(c)
+    x, n = GSL::Poly::Batch.solve(c)             # real roots, degree <= 4
+
+  Row k of c holds the coefficients of polynomial k in ascending order,
+  as GSL::Poly does.  complex_solve returns a batch x deg
+  GSL::Matrix::Complex of the roots and a GSL::Vector::Int of their
+  numbers; solve returns a batch x deg GSL::Matrix of the real roots in
+  ascending order.  The unused places of a row are NaN.  Rows whose
+  leading coefficients vanish are solved at their actual degree, so
+  their count is smaller; a row whose companion matrix QR does not
+  converge gets a count of -1.  The root matrix may be given as the
+  second argument to be reused.
+
+  Up to degree 4 the closed forms of gsl_poly_complex_solve_quadratic,
+  _cubic and _quartic (gsl_poly_solve_* for solve) are used; higher
+  degrees go through gsl_poly_complex_solve with one workspace per
+  thread.  complex_solve(c, z, :workspace => w) runs on one thread with
+  the GSL::Poly::Complex::Workspace w of size deg+1 instead of
+  allocating one.  The batch is split over GSL.parallel_threads threads
+  from GSL.parallel_threshold elements of work on, with the GVL
+  released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_poly.h"
+
+#define POLYB_BLOCK 256
+
+struct polyb_task {
+  int cmplx;
+  const double *c;              /* batch x (deg+1), tda */
+  size_t tda;
+  size_t batch, deg;
+  double *z;                    /* batch x deg, ztda: complex (re, im) or real */
+  size_t ztda;
+  int *nroots;
+  size_t nstride;
+  gsl_poly_complex_workspace **w;   /* one per thread */
+  size_t nthreads;
+};
+
+/* The degree of c[0 ... deg] once the vanishing leading terms are dropped */
+static size_t polyb_degree(const double *c, size_t deg)
+{
+  while (deg > 0 && c[deg] == 0.0) deg--;
+  return deg;
+}
+
+static int polyb_complex_row(struct polyb_task *t, size_t i, gsl_poly_complex_workspace *w)
+{
+  const double *c = t->c + i*t->tda;
+  double *z = t->z + 2*i*t->ztda;
+  gsl_complex r[4];
+  gsl_poly_complex_workspace *w2;
+  size_t d = polyb_degree(c, t->deg), j;
+  int n, status;
+  for (j = 0; j < 2*t->deg; j++) z[j] = GSL_NAN;
+  switch (d) {
+  case 0:
+    return 0;
+  case 1:
+    z[0] = -c[0]/c[1];
+    z[1] = 0.0;
+    return 1;
+  case 2:
+    n = gsl_poly_complex_solve_quadratic(c[2], c[1], c[0], &r[0], &r[1]);
+    break;
+  case 3:
+    n = gsl_poly_complex_solve_cubic(c[2]/c[3], c[1]/c[3], c[0]/c[3],
+				     &r[0], &r[1], &r[2]);
+    break;
+#ifdef HAVE_POLY_SOLVE_QUARTIC
+  case 4:
+    n = gsl_poly_complex_solve_quartic(c[3]/c[4], c[2]/c[4], c[1]/c[4], c[0]/c[4],
+				       &r[0], &r[1], &r[2], &r[3]);
+    break;
+#endif
+  default:
+    if (d == t->deg) {
+      status = gsl_poly_complex_solve(c, d + 1, w, z);
+    } else {
+      w2 = gsl_poly_complex_workspace_alloc(d + 1);
+      if (w2 == NULL) status = GSL_ENOMEM;
+      else status = gsl_poly_complex_solve(c, d + 1, w2, z);
+      if (w2) gsl_poly_complex_workspace_free(w2);
+    }
+    if (status == GSL_SUCCESS) status = rb_gsl_error_take();
+    else rb_gsl_error_take();
+    if (status != GSL_SUCCESS) {
+      for (j = 0; j < 2*d; j++) z[j] = GSL_NAN;
+      return -1;
+    }
+    return (int) d;
+  }
+  for (j = 0; j < (size_t) n; j++) {
+    z[2*j] = GSL_REAL(r[j]);
+    z[2*j+1] = GSL_IMAG(r[j]);
+  }
+  return n;
+}
+
+static int polyb_real_row(struct polyb_task *t, size_t i)
+{
+  const double *c = t->c + i*t->tda;
+  double *x = t->z + i*t->ztda;
+  size_t d = polyb_degree(c, t->deg), j;
+  int n = 0;
+  for (j = 0; j < t->deg; j++) x[j] = GSL_NAN;
+  switch (d) {
+  case 0:
+    break;
+  case 1:
+    x[0] = -c[0]/c[1];
+    n = 1;
+    break;
+  case 2:
+    n = gsl_poly_solve_quadratic(c[2], c[1], c[0], &x[0], &x[1]);
+    break;
+  case 3:
+    n = gsl_poly_solve_cubic(c[2]/c[3], c[1]/c[3], c[0]/c[3], &x[0], &x[1], &x[2]);
+    break;
+#ifdef HAVE_POLY_SOLVE_QUARTIC
+  case 4:
+    n = gsl_poly_solve_quartic(c[3]/c[4], c[2]/c[4], c[1]/c[4], c[0]/c[4],
+			       &x[0], &x[1], &x[2], &x[3]);
+    break;
+#endif
+  }
+  rb_gsl_error_take();
+  return n;
+}
+
+static void polyb_range(struct polyb_task *t, size_t i0, size_t i1, size_t id)
+{
+  size_t i;
+  for (i = i0; i < i1; i++) {
+    if (t->cmplx) t->nroots[i*t->nstride] = polyb_complex_row(t, i, t->w ? t->w[id] : NULL);
+    else t->nroots[i*t->nstride] = polyb_real_row(t, i);
+  }
+}
+
+static int polyb_worker(void *data, size_t id)
+{
+  struct polyb_task *t = (struct polyb_task *) data;
+  size_t b;
+  for (b = id*POLYB_BLOCK; b < t->batch; b += t->nthreads*POLYB_BLOCK)
+    polyb_range(t, b, GSL_MIN(b + POLYB_BLOCK, t->batch), id);
+  return GSL_SUCCESS;
+}
+
+static gsl_poly_complex_workspace* polyb_workspace(VALUE opts, size_t deg)
+{
+  gsl_poly_complex_workspace *w = NULL;
+  VALUE vw;
+  if (NIL_P(opts)) return NULL;
+  vw = rb_hash_aref(opts, ID2SYM(rb_intern("workspace")));
+  if (NIL_P(vw)) return NULL;
+  if (!rb_obj_is_kind_of(vw, cgsl_poly_complex_workspace)
+      && !rb_obj_is_kind_of(vw, cgsl_poly_workspace))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Poly::Complex::Workspace expected)",
+	     rb_class2name(CLASS_OF(vw)));
+  Data_Get_Struct(vw, gsl_poly_complex_workspace, w);
+  if (w->nc != deg)
+    rb_raise(rb_eArgError, "workspace of size %d for polynomials of degree %d",
+	     (int) w->nc + 1, (int) deg);
+  return w;
+}
+
+static VALUE rb_gsl_poly_batch_solve0(int argc, VALUE *argv, int cmplx)
+{
+  struct polyb_task t;
+  gsl_matrix *C;
+  gsl_matrix *X = NULL;
+  gsl_matrix_complex *Z = NULL;
+  gsl_vector_int *N;
+  gsl_poly_complex_workspace *wuser = NULL;
+  VALUE opts = Qnil, vz = Qnil, vn;
+  size_t work, k, nw = 0;
+  if (argc > 1 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_MATRIX(argv[0]);
+  Data_Get_Struct(argv[0], gsl_matrix, C);
+  if (C->size2 < 2)
+    rb_raise(rb_eArgError, "coefficient matrix needs at least 2 columns");
+  t.cmplx = cmplx;
+  t.c = C->data;
+  t.tda = C->tda;
+  t.batch = C->size1;
+  t.deg = C->size2 - 1;
+#ifdef HAVE_POLY_SOLVE_QUARTIC
+  if (!cmplx && t.deg > 4)
+#else
+  if (!cmplx && t.deg > 3)
+#endif
+    rb_raise(rb_eArgError, "real roots of polynomials of degree %d (use complex_solve)",
+	     (int) t.deg);
+  if (argc > 1) vz = argv[1];
+  if (cmplx) {
+    if (NIL_P(vz)) {
+      Z = gsl_matrix_complex_alloc(t.batch, t.deg);
+      vz = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, Z);
+    } else {
+      CHECK_MATRIX_COMPLEX(vz);
+      Data_Get_Struct(vz, gsl_matrix_complex, Z);
+    }
+    if (Z->size1 != t.batch || Z->size2 != t.deg)
+      rb_raise(rb_eArgError, "root matrix must be %d x %d", (int) t.batch, (int) t.deg);
+    t.z = Z->data;
+    t.ztda = Z->tda;
+    wuser = polyb_workspace(opts, t.deg);
+  } else {
+    if (NIL_P(vz)) {
+      X = gsl_matrix_alloc(t.batch, t.deg);
+      vz = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, X);
+    } else {
+      CHECK_MATRIX(vz);
+      Data_Get_Struct(vz, gsl_matrix, X);
+    }
+    if (X->size1 != t.batch || X->size2 != t.deg)
+      rb_raise(rb_eArgError, "root matrix must be %d x %d", (int) t.batch, (int) t.deg);
+    t.z = X->data;
+    t.ztda = X->tda;
+  }
+  N = gsl_vector_int_alloc(t.batch);
+  vn = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, N);
+  t.nroots = N->data;
+  t.nstride = N->stride;
+  work = t.batch*(t.deg > 4 ? 10*t.deg*t.deg*t.deg : 32);
+  t.nthreads = wuser ? 1 : rb_gsl_parallel_nthreads(work, (t.batch + POLYB_BLOCK - 1)/POLYB_BLOCK);
+  if (t.nthreads < 1) t.nthreads = 1;
+  t.w = NULL;
+  if (cmplx && t.deg > 4) {
+    nw = wuser ? 0 : t.nthreads;
+    t.w = ALLOC_N(gsl_poly_complex_workspace*, GSL_MAX(nw, 1));
+    if (wuser) t.w[0] = wuser;
+    for (k = 0; k < nw; k++) t.w[k] = gsl_poly_complex_workspace_alloc(t.deg + 1);
+  }
+  /* always through the parallel runner, so the failures of single rows
+     are deferred and counted rather than raised */
+  rb_gsl_nogvl_parallel(polyb_worker, &t, t.nthreads);
+  for (k = 0; k < nw; k++) gsl_poly_complex_workspace_free(t.w[k]);
+  if (t.w) xfree(t.w);
+  return rb_ary_new3(2, vz, vn);
+}
+
+static VALUE rb_gsl_poly_batch_complex_solve(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_poly_batch_solve0(argc, argv, 1);
+}
+
+static VALUE rb_gsl_poly_batch_solve(int argc, VALUE *argv, VALUE module)
+{
+  return rb_gsl_poly_batch_solve0(argc, argv, 0);
+}
+
+void Init_gsl_poly_batch(VALUE module)
+{
+  VALUE mbatch;
+  mbatch = rb_define_module_under(module, "Batch");
+  rb_define_module_function(mbatch, "complex_solve", rb_gsl_poly_batch_complex_solve, -1);
+  rb_define_module_function(mbatch, "solve", rb_gsl_poly_batch_solve, -1);
+}
@@ -198,7 +198,7 @@ static VALUE rb_gsl_complex_poly_complex_eval(VALUE a, VALUE b)
     zc = (gsl_complex*) coef->data;
   } else if (TYPE(a) == T_ARRAY) {
     N = RARRAY_LEN(a);
-    zc = (gsl_complex*) malloc(sizeof(gsl_complex));
+    zc = (gsl_complex*) malloc(sizeof(gsl_complex)*N);
     flag = 1;
     for (i = 0; i < N; i++) {
       Data_Get_Struct(rb_ary_entry(a, i), gsl_complex, zx);
@@ -216,7 +216,7 @@ static VALUE rb_gsl_complex_poly_complex_eval(VALUE a, VALUE b)
     ret = Data_Wrap_Struct(cgsl_complex, 0, free, res);
     GSL_SET_REAL(&z, NUM2DBL(b));
     GSL_SET_IMAG(&z, 0.0);
-    *res = gsl_complex_poly_complex_eval(zc, coef->size, z);
+    *res = gsl_complex_poly_complex_eval(zc, N, z);
     break;
   case T_ARRAY:
     ret = rb_ary_new2(RARRAY_LEN(b));
@@ -249,9 +249,333 @@ static VALUE rb_gsl_complex_poly_complex_eval(VALUE a, VALUE b)
   return ret;
 }
 #endif
+
+/*
+  Bulk evaluation of real polynomials over Vectors, Matrices and Arrays,
+  shared by Poly#eval and Poly#eval_derivs.  Points are taken four at a
+  time so that the recurrences of the four lanes run side by side.
+  Estrin's scheme, the default, sums the pairs c[2j] + c[2j+1]*x, then
+  the pairs of those with x^2, x^4, ..., which gives log2(n) dependent
+  steps instead of the n of Horner's scheme; :scheme => :horner (used
+  also for more than RB_GSL_POLY_ESTRIN_MAX coefficients) repeats the
+  arithmetic of gsl_poly_eval exactly.  Complex points run the same
+  schemes in complex arithmetic.  Large arguments are split over
+  GSL.parallel_threads with the GVL released.
+*/
+#define RB_GSL_POLY_BLOCK 1024
+#define RB_GSL_POLY_ESTRIN_MAX 64
+
+typedef struct {
+  const double **c;             /* nsets series, c[s] of len[s] coefficients */
+  const size_t *len;
+  size_t nsets;
+  int complex, estrin;
+  size_t n, ncols, nthreads;
+  const double *x;              /* x[r*xtda + c*xstride], counted in doubles */
+  size_t xtda, xstride;
+  double *y;                    /* series s at y[r*ytda + c*ystride + s*yset] */
+  size_t ytda, ystride, yset;
+} rb_gsl_poly_map;
+
+static void rb_gsl_poly_horner4(const double *c, size_t n, const double *x, double *y)
+{
+  size_t i, k;
+  for (k = 0; k < 4; k++) y[k] = c[n-1];
+  for (i = n - 1; i > 0; i--)
+    for (k = 0; k < 4; k++) y[k] = c[i-1] + x[k]*y[k];
+}
+
+static void rb_gsl_poly_estrin4(const double *c, size_t n, const double *x, double *y)
+{
+  double b[RB_GSL_POLY_ESTRIN_MAX/2][4], p[4];
+  size_t j, k, m = n/2;
+  for (j = 0; j < m; j++)
+    for (k = 0; k < 4; k++) b[j][k] = c[2*j] + c[2*j+1]*x[k];
+  if (n % 2) {
+    for (k = 0; k < 4; k++) b[m][k] = c[n-1];
+    m++;
+  }
+  for (k = 0; k < 4; k++) p[k] = x[k]*x[k];
+  while (m > 1) {
+    for (j = 0; j < m/2; j++)
+      for (k = 0; k < 4; k++) b[j][k] = b[2*j][k] + b[2*j+1][k]*p[k];
+    if (m % 2)
+      for (k = 0; k < 4; k++) b[m/2][k] = b[m-1][k];
+    m = (m + 1)/2;
+    for (k = 0; k < 4; k++) p[k] *= p[k];
+  }
+  for (k = 0; k < 4; k++) y[k] = b[0][k];
+}
+
+/* As gsl_poly_complex_eval */
+static void rb_gsl_poly_complex_horner4(const double *c, size_t n, const double *xr,
+					const double *xi, double *yr, double *yi)
+{
+  double t;
+  size_t i, k;
+  for (k = 0; k < 4; k++) {
+    yr[k] = c[n-1];
+    yi[k] = 0.0;
+  }
+  for (i = n - 1; i > 0; i--) {
+    for (k = 0; k < 4; k++) {
+      t = c[i-1] + xr[k]*yr[k] - xi[k]*yi[k];
+      yi[k] = xi[k]*yr[k] + xr[k]*yi[k];
+      yr[k] = t;
+    }
+  }
+}
+
+static void rb_gsl_poly_complex_estrin4(const double *c, size_t n, const double *xr,
+					const double *xi, double *yr, double *yi)
+{
+  double br[RB_GSL_POLY_ESTRIN_MAX/2][4], bi[RB_GSL_POLY_ESTRIN_MAX/2][4];
+  double pr[4], pi[4], t;
+  size_t j, k, m = n/2;
+  for (j = 0; j < m; j++) {
+    for (k = 0; k < 4; k++) {
+      br[j][k] = c[2*j] + c[2*j+1]*xr[k];
+      bi[j][k] = c[2*j+1]*xi[k];
+    }
+  }
+  if (n % 2) {
+    for (k = 0; k < 4; k++) {
+      br[m][k] = c[n-1];
+      bi[m][k] = 0.0;
+    }
+    m++;
+  }
+  for (k = 0; k < 4; k++) {
+    pr[k] = xr[k]*xr[k] - xi[k]*xi[k];
+    pi[k] = 2.0*xr[k]*xi[k];
+  }
+  while (m > 1) {
+    for (j = 0; j < m/2; j++) {
+      for (k = 0; k < 4; k++) {
+	t = br[2*j][k] + br[2*j+1][k]*pr[k] - bi[2*j+1][k]*pi[k];
+	bi[j][k] = bi[2*j][k] + br[2*j+1][k]*pi[k] + bi[2*j+1][k]*pr[k];
+	br[j][k] = t;
+      }
+    }
+    if (m % 2) {
+      for (k = 0; k < 4; k++) {
+	br[m/2][k] = br[m-1][k];
+	bi[m/2][k] = bi[m-1][k];
+      }
+    }
+    m = (m + 1)/2;
+    for (k = 0; k < 4; k++) {
+      t = pr[k]*pr[k] - pi[k]*pi[k];
+      pi[k] = 2.0*pr[k]*pi[k];
+      pr[k] = t;
+    }
+  }
+  for (k = 0; k < 4; k++) {
+    yr[k] = br[0][k];
+    yi[k] = bi[0][k];
+  }
+}
+
+static void rb_gsl_poly_map_range(const rb_gsl_poly_map *m, size_t lo, size_t hi)
+{
+  double xr[4], xi[4], yr[4], yi[4];
+  size_t idx[4], k, l, nb, r, c, s, len;
+  int estrin;
+  while (lo < hi) {
+    nb = GSL_MIN(hi - lo, 4);
+    for (l = 0; l < 4; l++) {
+      k = lo + (l < nb ? l : 0);
+      r = k/m->ncols;
+      c = k%m->ncols;
+      xr[l] = m->x[r*m->xtda + c*m->xstride];
+      if (m->complex) xi[l] = m->x[r*m->xtda + c*m->xstride + 1];
+      idx[l] = r*m->ytda + c*m->ystride;
+    }
+    for (s = 0; s < m->nsets; s++) {
+      len = m->len[s];
+      estrin = m->estrin && len <= RB_GSL_POLY_ESTRIN_MAX;
+      if (len == 0) {
+	for (l = 0; l < 4; l++) yr[l] = yi[l] = 0.0;
+      } else if (m->complex) {
+	if (estrin) rb_gsl_poly_complex_estrin4(m->c[s], len, xr, xi, yr, yi);
+	else rb_gsl_poly_complex_horner4(m->c[s], len, xr, xi, yr, yi);
+      } else {
+	if (estrin) rb_gsl_poly_estrin4(m->c[s], len, xr, yr);
+	else rb_gsl_poly_horner4(m->c[s], len, xr, yr);
+      }
+      for (l = 0; l < nb; l++) {
+	m->y[idx[l] + s*m->yset] = yr[l];
+	if (m->complex) m->y[idx[l] + s*m->yset + 1] = yi[l];
+      }
+    }
+    lo += nb;
+  }
+}
+
+static int rb_gsl_poly_map_worker(void *data, size_t id)
+{
+  rb_gsl_poly_map *m = (rb_gsl_poly_map *) data;
+  rb_gsl_poly_map_range(m, m->n*id/m->nthreads, m->n*(id + 1)/m->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int rb_gsl_poly_map_serial(void *data)
+{
+  rb_gsl_poly_map *m = (rb_gsl_poly_map *) data;
+  rb_gsl_poly_map_range(m, 0, m->n);
+  return GSL_SUCCESS;
+}
+
+static void rb_gsl_poly_map_run(rb_gsl_poly_map *m)
+{
+  size_t s, work = 0;
+  if (m->n == 0) return;
+  for (s = 0; s < m->nsets; s++) work += m->len[s] + 1;
+  work *= m->n*(m->complex ? 4 : 1);
+  m->nthreads = rb_gsl_parallel_nthreads(work, (m->n + RB_GSL_POLY_BLOCK - 1)/RB_GSL_POLY_BLOCK);
+  if (m->nthreads > 1) rb_gsl_nogvl_parallel(rb_gsl_poly_map_worker, m, m->nthreads);
+  else rb_gsl_nogvl_call(rb_gsl_poly_map_serial, m, work);
+}
+
+/* 1 for Estrin's scheme, 0 for Horner's, from the :scheme option */
+static int rb_gsl_poly_scheme(VALUE opts)
+{
+  VALUE v;
+  if (TYPE(opts) != T_HASH) return 1;
+  v = rb_hash_aref(opts, ID2SYM(rb_intern("scheme")));
+  if (NIL_P(v) || v == ID2SYM(rb_intern("estrin"))) return 1;
+  if (v == ID2SYM(rb_intern("horner"))) return 0;
+  rb_raise(rb_eArgError, "unknown scheme %s (:estrin or :horner expected)",
+	   RSTRING_PTR(rb_inspect(v)));
+  return 1;
+}
+
+static void rb_gsl_poly_check_out(VALUE out, int ok, const char *what)
+{
+  if (!ok) rb_raise(rb_eTypeError, "wrong out %s (%s expected)",
+		    rb_class2name(CLASS_OF(out)), what);
+  rb_check_frozen(out);
+}
+
+/* The polynomials c[0..nsets-1] at xx, an Array (a Range as an Array), a
+   Vector, a Matrix or a Vector::Complex, into out if not nil; Qundef for
+   other types.  The result has the shape of xx, or with columns (xx an
+   Array or a Vector) is the xx.size x nsets Matrix of the values, a
+   column for each series. */
+static VALUE rb_gsl_poly_map_eval(const double **c, const size_t *len, size_t nsets,
+				  int columns, VALUE xx, VALUE out, int estrin)
+{
+  rb_gsl_poly_map m;
+  gsl_vector *v = NULL, *vy;
+  gsl_matrix *mx = NULL, *my;
+  gsl_vector_complex *vz = NULL, *vzy;
+  VALUE y, ary, tmp = 0;
+  double *buf = NULL;
+  size_t i;
+  memset(&m, 0, sizeof(rb_gsl_poly_map));
+  m.c = c;
+  m.len = len;
+  m.nsets = nsets;
+  m.estrin = estrin;
+  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+  if (TYPE(xx) == T_ARRAY) {
+    m.n = RARRAY_LEN(xx);
+    buf = ALLOCV_N(double, tmp, 2*m.n + 1);
+    for (i = 0; i < m.n; i++) buf[i] = NUM2DBL(rb_ary_entry(xx, i));
+    m.x = buf;
+    m.xstride = 1;
+  } else if (VECTOR_P(xx)) {
+    Data_Get_Struct(xx, gsl_vector, v);
+    m.n = v->size;
+    m.x = v->data;
+    m.xstride = v->stride;
+  } else if (!columns && MATRIX_P(xx)) {
+    Data_Get_Struct(xx, gsl_matrix, mx);
+    m.n = mx->size1*mx->size2;
+    m.ncols = mx->size2;
+    m.x = mx->data;
+    m.xtda = mx->tda;
+    m.xstride = 1;
+  } else if (!columns && VECTOR_COMPLEX_P(xx)) {
+    Data_Get_Struct(xx, gsl_vector_complex, vz);
+    m.complex = 1;
+    m.n = vz->size;
+    m.x = vz->data;
+    m.xstride = 2*vz->stride;
+  } else {
+    return Qundef;
+  }
+  if (mx == NULL) m.ncols = GSL_MAX(m.n, 1);
+  if (columns) {
+    if (NIL_P(out)) {
+      my = gsl_matrix_alloc(m.n, nsets);
+      y = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, my);
+    } else {
+      rb_gsl_poly_check_out(out, MATRIX_P(out), "GSL::Matrix");
+      Data_Get_Struct(out, gsl_matrix, my);
+      if (my->size1 != m.n || my->size2 != nsets)
+	rb_raise(rb_eArgError, "out must be %dx%d", (int) m.n, (int) nsets);
+      y = out;
+    }
+    m.y = my->data;
+    m.ystride = my->tda;
+    m.yset = 1;
+  } else if (mx) {
+    if (NIL_P(out)) {
+      my = gsl_matrix_alloc(mx->size1, mx->size2);
+      y = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, my);
+    } else {
+      rb_gsl_poly_check_out(out, MATRIX_P(out), "GSL::Matrix");
+      Data_Get_Struct(out, gsl_matrix, my);
+      if (my->size1 != mx->size1 || my->size2 != mx->size2)
+	rb_raise(rb_eArgError, "matrix sizes are different");
+      y = out;
+    }
+    m.y = my->data;
+    m.ytda = my->tda;
+    m.ystride = 1;
+  } else if (vz) {
+    if (NIL_P(out)) {
+      vzy = gsl_vector_complex_alloc(m.n);
+      y = Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vzy);
+    } else {
+      rb_gsl_poly_check_out(out, VECTOR_COMPLEX_P(out), "GSL::Vector::Complex");
+      Data_Get_Struct(out, gsl_vector_complex, vzy);
+      if (vzy->size != m.n) rb_raise(rb_eArgError, "vector lengths are different");
+      y = out;
+    }
+    m.y = vzy->data;
+    m.ystride = 2*vzy->stride;
+  } else if (v || !NIL_P(out)) {
+    if (NIL_P(out)) {
+      vy = gsl_vector_alloc(m.n);
+      y = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vy);
+    } else {
+      rb_gsl_poly_check_out(out, VECTOR_P(out), "GSL::Vector");
+      Data_Get_Struct(out, gsl_vector, vy);
+      if (vy->size != m.n) rb_raise(rb_eArgError, "vector lengths are different");
+      y = out;
+    }
+    m.y = vy->data;
+    m.ystride = vy->stride;
+  } else {
+    m.y = buf + m.n;
+    m.ystride = 1;
+    y = Qnil;
+  }
+  rb_gsl_poly_map_run(&m);
+  if (NIL_P(y)) {
+    ary = rb_ary_new2(m.n);
+    for (i = 0; i < m.n; i++) rb_ary_store(ary, i, rb_float_new(m.y[i]));
+    y = ary;
+  }
+  if (tmp) ALLOCV_END(tmp);
+  RB_GC_GUARD(xx);
+  return y;
+}
 #endif
 
-static VALUE FUNCTION(rb_gsl_poly,eval)(VALUE obj, VALUE xx)
+static VALUE FUNCTION(rb_gsl_poly,eval)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_poly) *p = NULL;
   GSL_TYPE(gsl_vector) *v = NULL;
@@ -268,12 +592,32 @@ static VALUE FUNCTION(rb_gsl_poly,eval)(VALUE obj, VALUE xx)
 #endif
 #ifdef GSL_1_11_LATER
   gsl_complex *z, zz;
-  gsl_vector_complex *vz, *vznew;
 #endif
+  const double *c[1];
+  size_t len[1];
+  VALUE out = Qnil, opts = Qnil;
+  int estrin;
 #endif
+  VALUE xx;
 
   Data_Get_Struct(obj, GSL_TYPE(gsl_poly), p);
+#ifdef BASE_DOUBLE
+  if (argc > 1 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  rb_scan_args(argc, argv, "11", &xx, &out);
+  estrin = rb_gsl_poly_scheme(opts);
+  if (NIL_P(out)) out = rb_gsl_out_arg(opts);
   if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+  c[0] = p->data;
+  len[0] = p->size;
+  if ((x = rb_gsl_poly_map_eval(c, len, 1, 0, xx, out, estrin)) != Qundef)
+    return x;
+  if (!NIL_P(out))
+    rb_raise(rb_eTypeError, "wrong argument type %s (out needs an Array, Vector, Matrix or Vector::Complex)",
+	     rb_class2name(CLASS_OF(xx)));
+#else
+  rb_scan_args(argc, argv, "1", &xx);
+  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+#endif
   switch (TYPE(xx)) {
   case T_FIXNUM:
   case T_BIGNUM:
@@ -327,14 +671,6 @@ static VALUE FUNCTION(rb_gsl_poly,eval)(VALUE obj, VALUE xx)
       zz = gsl_poly_complex_eval(p->data, p->size, *z);
       z = make_complex(GSL_REAL(zz), GSL_IMAG(zz));
       return Data_Wrap_Struct(cgsl_complex, 0, free, z);
-    } else if (rb_obj_is_kind_of(xx, cgsl_vector_complex)) {
-      Data_Get_Struct(xx, gsl_vector_complex, vz);
-      vznew = gsl_vector_complex_alloc(vz->size);
-      for (i = 0; i < vz->size; i++) {
-	zz = gsl_poly_complex_eval(p->data, p->size, gsl_vector_complex_get(vz, i));
-	gsl_vector_complex_set(vznew, i, zz);
-      }
-      return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vznew);
 #endif
 #endif
     } else {
@@ -1170,12 +1506,111 @@ static VALUE FUNCTION(rb_gsl_poly,order)(VALUE obj)
   return INT2FIX(v->size - 1);
 }
 
+/*
+  Products of long polynomials go through the FFT: both factors are
+  transformed, zero-padded to a 2-3-5 smooth length, with the cached
+  wavetables of GSL::FFT, multiplied and transformed back.  Doubles are
+  convolved directly so; the coefficients of a Poly::Int are split into
+  three 11-bit digits whose products stay far enough below 2^53 for the
+  rounding of the transforms to be undone exactly, which gives the same
+  (wrapping) int results as the direct loop.  The crossover is the
+  length of the shorter factor, GSL::Poly.fft_threshold and
+  GSL::Poly::Int.fft_threshold (0 never uses the FFT).
+*/
+#ifdef BASE_DOUBLE
+static size_t FUNCTION(rb_gsl_poly,fft_min) = 128;
+
+/* z += x*y, spectra in the halfcomplex format of length n */
+static void rb_gsl_poly_hc_mul_add(const double *x, const double *y, double *z, size_t n)
+{
+  size_t i;
+  z[0] += x[0]*y[0];
+  for (i = 1; i + 1 < n; i += 2) {
+    z[i] += x[i]*y[i] - x[i+1]*y[i+1];
+    z[i+1] += x[i]*y[i+1] + x[i+1]*y[i];
+  }
+  if (n % 2 == 0) z[n-1] += x[n-1]*y[n-1];
+}
+
+static void FUNCTION(rb_gsl_poly,fft_conv)(const BASE *a, size_t na, const BASE *b, size_t nb,
+					   BASE *c)
+{
+  size_t nc = na + nb - 1, n = rb_gsl_fft_good_size(nc), i;
+  double *fa, *fb, *fc;
+  VALUE tmp;
+  fa = ALLOCV_N(double, tmp, 3*n);
+  fb = fa + n;
+  fc = fb + n;
+  memset(fa, 0, sizeof(double)*3*n);
+  memcpy(fa, a, sizeof(double)*na);
+  memcpy(fb, b, sizeof(double)*nb);
+  rb_gsl_fft_real_cached(fa, n, 0);
+  rb_gsl_fft_real_cached(fb, n, 0);
+  rb_gsl_poly_hc_mul_add(fa, fb, fc, n);
+  rb_gsl_fft_real_cached(fc, n, 1);
+  for (i = 0; i < nc; i++) c[i] = fc[i];
+  ALLOCV_END(tmp);
+}
+#endif
+
+#ifdef BASE_INT
+#define RB_GSL_POLY_INT_DIGITS 3
+#define RB_GSL_POLY_INT_BITS 11
+/* Beyond this the sums of digit products could come near 2^53 */
+#define RB_GSL_POLY_INT_FFT_MAX (1 << 18)
+
+static size_t FUNCTION(rb_gsl_poly,fft_min) = 512;
+
+static void FUNCTION(rb_gsl_poly,fft_conv)(const BASE *a, size_t na, const BASE *b, size_t nb,
+					   BASE *c)
+{
+  const int nd = RB_GSL_POLY_INT_DIGITS, ng = 2*RB_GSL_POLY_INT_DIGITS - 1;
+  const uint32_t mask = (1u << RB_GSL_POLY_INT_BITS) - 1;
+  size_t nc = na + nb - 1, n = rb_gsl_fft_good_size(nc), i;
+  double *fa, *fb, *fg;
+  uint64_t sum;
+  int d, e, g;
+  VALUE tmp;
+  fa = ALLOCV_N(double, tmp, (2*nd + ng)*n);
+  fb = fa + nd*n;
+  fg = fb + nd*n;
+  memset(fa, 0, sizeof(double)*(2*nd + ng)*n);
+  for (d = 0; d < nd; d++) {
+    for (i = 0; i < na; i++)
+      fa[d*n + i] = (double) (((uint32_t) a[i] >> (d*RB_GSL_POLY_INT_BITS)) & mask);
+    for (i = 0; i < nb; i++)
+      fb[d*n + i] = (double) (((uint32_t) b[i] >> (d*RB_GSL_POLY_INT_BITS)) & mask);
+    rb_gsl_fft_real_cached(fa + d*n, n, 0);
+    rb_gsl_fft_real_cached(fb + d*n, n, 0);
+  }
+  for (d = 0; d < nd; d++)
+    for (e = 0; e < nd; e++)
+      rb_gsl_poly_hc_mul_add(fa + d*n, fb + e*n, fg + (d + e)*n, n);
+  for (g = 0; g < ng; g++) rb_gsl_fft_real_cached(fg + g*n, n, 1);
+  for (i = 0; i < nc; i++) {
+    sum = 0;
+    for (g = 0; g < ng; g++)
+      sum += ((uint64_t) (int64_t) floor(fg[g*n + i] + 0.5)) << (g*RB_GSL_POLY_INT_BITS);
+    c[i] = (BASE) (int32_t) (uint32_t) sum;
+  }
+  ALLOCV_END(tmp);
+}
+#endif
+
 int FUNCTION(gsl_poly,conv)(const BASE *a, size_t na, const BASE *b, size_t nb,
 		  BASE *c, size_t *nc)
 {
   BASE x;
-  size_t i, j;
+  size_t i, j, nmin = GSL_MIN(na, nb);
   *nc = na + nb - 1;
+  if (FUNCTION(rb_gsl_poly,fft_min) > 0 && nmin >= FUNCTION(rb_gsl_poly,fft_min)
+#ifdef BASE_INT
+      && nmin <= RB_GSL_POLY_INT_FFT_MAX
+#endif
+      ) {
+    FUNCTION(rb_gsl_poly,fft_conv)(a, na, b, nb, c);
+    return 0;
+  }
   for (i = 0; i < *nc; i++) c[i] = 0;
   for (i = 0; i < *nc; i++) {
     if (i >= na) break;
@@ -1249,40 +1684,88 @@ GSL_TYPE(gsl_vector)* FUNCTION(gsl_poly,integ)(const GSL_TYPE(gsl_vector) *v)
   return vnew;
 }
 
+#ifdef BASE_DOUBLE
+/* q[0..nc-na], the quotient of c by a, from the reversed series,
+   rev(q) = rev(c)/rev(a) mod x^(nc-na+1), with the inverse of rev(a) by
+   Newton's iteration g <- g (2 - rev(a) g), which doubles the number of
+   correct terms with two products each step */
+static void rb_gsl_poly_newton_quotient(const double *c, size_t nc, const double *a, size_t na,
+					double *q)
+{
+  size_t n = nc - na + 1, len, len2, m, i;
+  double *f, *g, *e, *t;
+  VALUE tmp;
+  f = ALLOCV_N(double, tmp, 5*n);
+  g = f + n;
+  e = g + n;
+  t = e + n;
+  for (i = 0; i < n; i++) f[i] = i < na ? a[na-1-i] : 0.0;
+  g[0] = 1.0/f[0];
+  for (len = 1; len < n; len = len2) {
+    len2 = GSL_MIN(2*len, n);
+    gsl_poly_conv(f, len2, g, len, t, &m);
+    for (i = 0; i < len2; i++) e[i] = -t[i];
+    e[0] += 2.0;
+    gsl_poly_conv(g, len, e, len2, t, &m);
+    for (i = 0; i < len2; i++) g[i] = t[i];
+  }
+  for (i = 0; i < n; i++) e[i] = c[nc-1-i];
+  gsl_poly_conv(e, n, g, n, t, &m);
+  for (i = 0; i < n; i++) q[n-1-i] = t[i];
+  ALLOCV_END(tmp);
+}
+#endif
+
+/* The quotient of c by a, and in *r the remainder c - q*a.  Long
+   division, or for long doubles the Newton quotient */
 GSL_TYPE(gsl_vector)* FUNCTION(gsl_poly,deconv_vector)(const GSL_TYPE(gsl_vector) *c, const GSL_TYPE(gsl_vector) *a, 
 				   GSL_TYPE(gsl_vector) **r)
 {
   GSL_TYPE(gsl_vector) *vnew = NULL, *a2 = NULL, *c2 = NULL, *vtmp = NULL;
   GSL_TYPE(gsl_vector) *rtmp = NULL;
-  BASE x, y, z, aa;
-  size_t n, i, j, k, jj;
+  BASE x, y, aa;
+  size_t n, i, j, na;
   c2 = FUNCTION(gsl_poly,reduce)(c);
   a2 = FUNCTION(gsl_poly,reduce)(a);
-  n = c2->size - a2->size + 1;
+  na = a2->size;
+  if (c2->size < na) {
+    vnew = FUNCTION(gsl_vector,calloc)(1);
+    *r = c2;
+    FUNCTION(gsl_vector,free)(a2);
+    return vnew;
+  }
+  n = c2->size - na + 1;
   vnew = FUNCTION(gsl_vector,calloc)(n);
-  rtmp = FUNCTION(gsl_vector,alloc)(c2->size - 1);
-  aa = FUNCTION(gsl_vector,get)(a2, a2->size - 1);
-  FUNCTION(gsl_vector,set)(vnew, n-1, FUNCTION(gsl_vector,get)(c2, c2->size-1)/aa);
-  for (i = n - 2, k = 1; k < n; i--, k++) {
-    x = FUNCTION(gsl_vector,get)(c2, c2->size-1-k);
-    for (j = n-1; j >= 0; j--) {
-      z = FUNCTION(gsl_vector,get)(vnew, j);
-      jj = c2->size-1-k-j;
-      if (jj > k || jj < 0) continue;
-      y = FUNCTION(gsl_vector,get)(a2, jj);
-      x -= y*z;
+  aa = a2->data[na - 1];
+#ifdef BASE_DOUBLE
+  if (rb_gsl_poly_fft_min > 0 && GSL_MIN(n, na) >= rb_gsl_poly_fft_min) {
+    rb_gsl_poly_newton_quotient(c2->data, c2->size, a2->data, na, vnew->data);
+  } else
+#endif
+  {
+    vtmp = FUNCTION(gsl_vector,alloc)(c2->size);
+    FUNCTION(gsl_vector,memcpy)(vtmp, c2);
+    for (i = n; i-- > 0;) {
+      x = vtmp->data[i + na - 1]/aa;
+      vnew->data[i] = x;
+      for (j = 0; j < na; j++) vtmp->data[i + j] -= x*a2->data[j];
     }
-    FUNCTION(gsl_vector,set)(vnew, i, x/aa);
+    FUNCTION(gsl_vector,free)(vtmp);
   }
-  vtmp = FUNCTION(gsl_poly,conv_vector)(vnew, a2);
-  for (i = 0; i < rtmp->size; i++) {
-    x = FUNCTION(gsl_vector,get)(c2, i);
-    y = FUNCTION(gsl_vector,get)(vtmp, i);
-    FUNCTION(gsl_vector,set)(rtmp, i, x - y);
+  if (c2->size == 1) {
+    rtmp = FUNCTION(gsl_vector,calloc)(1);
+  } else {
+    rtmp = FUNCTION(gsl_vector,alloc)(c2->size - 1);
+    vtmp = FUNCTION(gsl_poly,conv_vector)(vnew, a2);
+    for (i = 0; i < rtmp->size; i++) {
+      x = FUNCTION(gsl_vector,get)(c2, i);
+      y = FUNCTION(gsl_vector,get)(vtmp, i);
+      FUNCTION(gsl_vector,set)(rtmp, i, x - y);
+    }
+    FUNCTION(gsl_vector,free)(vtmp);
   }
   *r = FUNCTION(gsl_poly,reduce)(rtmp);
   FUNCTION(gsl_vector,free)(rtmp);
-  FUNCTION(gsl_vector,free)(vtmp);
   FUNCTION(gsl_vector,free)(c2);
   FUNCTION(gsl_vector,free)(a2);
   return vnew;
@@ -1361,6 +1844,19 @@ VALUE FUNCTION(rb_gsl_poly,deconv)(VALUE obj, VALUE bb)
 		       Data_Wrap_Struct(GSL_TYPE(cgsl_poly), 0, FUNCTION(gsl_vector,free), r));
 }
 
+static VALUE FUNCTION(rb_gsl_poly,fft_threshold)(VALUE klass)
+{
+  return SIZET2NUM(FUNCTION(rb_gsl_poly,fft_min));
+}
+
+static VALUE FUNCTION(rb_gsl_poly,set_fft_threshold)(VALUE klass, VALUE val)
+{
+  long n = NUM2LONG(val);
+  if (n < 0) rb_raise(rb_eArgError, "threshold must be non-negative");
+  FUNCTION(rb_gsl_poly,fft_min) = (size_t) n;
+  return val;
+}
+
 static VALUE FUNCTION(rb_gsl_poly,reduce)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL, *vnew = NULL;
@@ -1711,24 +2207,49 @@ static VALUE rb_gsl_poly_eval_derivs_singleton(int argc, VALUE *argv, VALUE klas
 #endif
   return Qnil;  // Never comes here
 }
+/* Poly#eval_derivs(x[, lenres]): the value and the first lenres - 1
+   derivatives at x, a Poly for a number; the x.size x lenres Matrix of
+   them, a row for each point, for a Vector or an Array of points
+   (into out if given) */
 static VALUE rb_gsl_poly_eval_derivs(int argc, VALUE *argv, VALUE obj)
 {
   gsl_vector *v, *v2;
-  size_t lenc, lenres;
+  size_t lenc, lenres, s, j;
+  VALUE xx, vlen = Qnil, out = Qnil, opts = Qnil, y, tmp = 0;
+  const double **c;
+  size_t *len;
+  double *d;
+  int estrin;
   Data_Get_Struct(obj, gsl_vector, v);
   lenc = v->size;
-  switch (argc) {
-  case 1:
-    lenres = lenc + 1;
-    break;
-  case 2:
-    lenres = FIX2INT(argv[1]);
-    break;
-  default:
+  if (argc > 1 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1 || argc > 3)
     rb_raise(rb_eArgError, "Wrong number of arguments (%d for > 1)", argc);
+  xx = argv[0];
+  if (argc > 1) vlen = argv[1];
+  out = argc > 2 ? argv[2] : rb_gsl_out_arg(opts);
+  lenres = NIL_P(vlen) ? lenc + 1 : FIX2INT(vlen);
+  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+  if (TYPE(xx) == T_ARRAY || VECTOR_P(xx)) {
+    estrin = rb_gsl_poly_scheme(opts);
+    if (lenres < 1) rb_raise(rb_eArgError, "lenres must be positive");
+    /* the coefficients of the s-th derivative, lenc - s of them */
+    d = ALLOCV(tmp, (sizeof(double)*lenc + sizeof(double *) + sizeof(size_t))*lenres);
+    c = (const double **) (d + lenc*lenres);
+    len = (size_t *) (c + lenres);
+    for (j = 0; j < lenc; j++) d[j] = gsl_vector_get(v, j);
+    for (s = 0; s < lenres; s++) {
+      c[s] = d + s*lenc;
+      len[s] = lenc > s ? lenc - s : 0;
+      if (s > 0)
+	for (j = 0; j < len[s]; j++) d[s*lenc + j] = d[(s - 1)*lenc + j + 1]*(j + 1);
+    }
+    y = rb_gsl_poly_map_eval(c, len, lenres, 1, xx, out, estrin);
+    ALLOCV_END(tmp);
+    return y;
   }
   v2 = gsl_vector_alloc(lenres);
-  gsl_poly_eval_derivs(v->data, lenc, NUM2DBL(argv[0]), v2->data, lenres);
+  gsl_poly_eval_derivs(v->data, lenc, NUM2DBL(xx), v2->data, lenres);
   return Data_Wrap_Struct(cgsl_poly, 0, gsl_vector_free, v2);
 }
 #endif
@@ -1793,7 +2314,7 @@ void FUNCTION(Init_gsl_poly,init)(VALUE module)
 			     FUNCTION(rb_gsl_poly,eval2), -1);
 
   rb_define_method(GSL_TYPE(cgsl_poly), "eval",
-		   FUNCTION(rb_gsl_poly,eval), 1);
+		   FUNCTION(rb_gsl_poly,eval), -1);
   rb_define_alias(GSL_TYPE(cgsl_poly), "at", "eval");
 
   rb_define_method(GSL_TYPE(cgsl_poly), "solve_quadratic", 
@@ -1851,6 +2372,10 @@ void FUNCTION(Init_gsl_poly,init)(VALUE module)
 		   FUNCTION(rb_gsl_poly,deconv), 1);
   rb_define_singleton_method(GSL_TYPE(cgsl_poly), "deconv",
 			     FUNCTION(rb_gsl_poly,deconv2), 2);
+  rb_define_singleton_method(GSL_TYPE(cgsl_poly), "fft_threshold",
+			     FUNCTION(rb_gsl_poly,fft_threshold), 0);
+  rb_define_singleton_method(GSL_TYPE(cgsl_poly), "fft_threshold=",
+			     FUNCTION(rb_gsl_poly,set_fft_threshold), 1);
 
   rb_define_method(GSL_TYPE(cgsl_poly), "reduce", 
 		   FUNCTION(rb_gsl_poly,reduce), 1);
@@ -1867,8 +2392,7 @@ void FUNCTION(Init_gsl_poly,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_poly), "-@", FUNCTION(rb_gsl_poly,uminus), 0);
   rb_define_method(GSL_TYPE(cgsl_poly), "+@", FUNCTION(rb_gsl_poly,uplus), 0);
 
-  rb_define_method(GSL_TYPE(cgsl_poly), "coerce", 
-		   FUNCTION(rb_gsl_poly,coerce), 1);
+  rb_gsl_define_coerce(GSL_TYPE(cgsl_poly), FUNCTION(rb_gsl_poly,coerce));
   rb_define_method(GSL_TYPE(cgsl_poly), "to_gv", FUNCTION(rb_gsl_poly,to_gv), 0);
   rb_define_alias(GSL_TYPE(cgsl_poly), "to_v", "to_gv");
 
@@ -0,0 +1,299 @@
+/*
+  profiler.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Profiler: calls, time and allocations per entry point of the
+  extension, for a build configured with --enable-profile
+  (gem install gsl -- --enable-profile).  Counting starts with
+  GSL::Profiler.enable; until then an instrumented method costs one
+  test of a flag, and without --enable-profile nothing is compiled in.
+
+    GSL::Profiler.enable
+    f.integration_qag(0, 1)
+    GSL::Profiler.report
+    #=> {"GSL::Integration.qag"=>{:calls=>1, :time=>0.0021,
+    #      :native_time=>0.0004, :callback_time=>0.0017,
+    #      :callbacks=>21, :bytes=>0},
+    #    "GSL::Integration workspace"=>{:calls=>1, :time=>1.2e-06, ...}}
+    GSL::Profiler.reset
+    GSL::Profiler.profile { v.forward }   # the report of the block
+
+  time is the wall time in seconds spent in the entry, callback_time the
+  part spent in the Ruby procs it called (GSL::Function and
+  GSL::Function_fdf) and native_time the rest; bytes counts the vector
+  and matrix data allocated by the entry itself, not by its callbacks.
+  The sections (FFT plans, integration workspaces) are timed as entries
+  of their own, whose time is also part of the method which ran them.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_profiler.h"
+
+#ifdef RB_GSL_PROFILE
+
+#include <time.h>
+#ifdef HAVE_RUBY_ATOMIC_H
+#include "ruby/atomic.h"
+#define PROF_ADD(x, n) RUBY_ATOMIC_SIZE_ADD(x, n)
+#else
+#define PROF_ADD(x, n) ((x) += (n))
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+static pthread_mutex_t prof_lock = PTHREAD_MUTEX_INITIALIZER;
+#define PROF_LOCK() pthread_mutex_lock(&prof_lock)
+#define PROF_UNLOCK() pthread_mutex_unlock(&prof_lock)
+#else
+#define PROF_LOCK()
+#define PROF_UNLOCK()
+#endif
+
+/* A running method, on the stack of the thread which called it */
+typedef struct prof_frame {
+  rb_gsl_prof_entry *entry;
+  struct prof_frame *parent;
+  size_t t0, callback_t0, callback_time, callbacks, bytes;
+  int in_callback;
+  VALUE (*func)(int, VALUE *, VALUE);
+  int argc;
+  VALUE *argv, obj;
+} prof_frame;
+
+static int prof_enabled = 0;
+static rb_gsl_prof_entry *prof_entries = NULL;
+static RB_GSL_THREAD_LOCAL prof_frame *prof_current = NULL;
+
+static size_t prof_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (size_t) ts.tv_sec*1000000000 + (size_t) ts.tv_nsec;
+#else
+  return (size_t) ((double) clock()*1e9/CLOCKS_PER_SEC);
+#endif
+}
+
+static void prof_list(rb_gsl_prof_entry *e)
+{
+  PROF_LOCK();
+  if (!e->listed) {
+    e->next = prof_entries;
+    prof_entries = e;
+    e->listed = 1;
+  }
+  PROF_UNLOCK();
+}
+
+static VALUE prof_body(VALUE data)
+{
+  prof_frame *f = (prof_frame *) data;
+  return (*f->func)(f->argc, f->argv, f->obj);
+}
+
+/* Also reached by an exception from the method or one of its callbacks */
+static VALUE prof_ensure(VALUE data)
+{
+  prof_frame *f = (prof_frame *) data;
+  rb_gsl_prof_entry *e = f->entry;
+  size_t now = prof_now();
+  if (f->in_callback) f->callback_time += now - f->callback_t0;
+  prof_current = f->parent;
+  if (!e->listed) prof_list(e);
+  PROF_ADD(e->calls, 1);
+  PROF_ADD(e->time, now - f->t0);
+  PROF_ADD(e->callback_time, f->callback_time);
+  PROF_ADD(e->callbacks, f->callbacks);
+  PROF_ADD(e->bytes, f->bytes);
+  return Qnil;
+}
+
+/* func(argc, argv, obj), counted in e */
+VALUE rb_gsl_prof_call(rb_gsl_prof_entry *e, VALUE (*func)(int, VALUE *, VALUE),
+		       int argc, VALUE *argv, VALUE obj)
+{
+  prof_frame f;
+  if (!prof_enabled) return (*func)(argc, argv, obj);
+  memset(&f, 0, sizeof(f));
+  f.entry = e;
+  f.parent = prof_current;
+  f.func = func;
+  f.argc = argc;
+  f.argv = argv;
+  f.obj = obj;
+  f.t0 = prof_now();
+  prof_current = &f;
+  return rb_ensure(prof_body, (VALUE) &f, prof_ensure, (VALUE) &f);
+}
+
+/* Returns the token to give to rb_gsl_prof_callback_end */
+int rb_gsl_prof_callback_begin(void)
+{
+  prof_frame *f = prof_current;
+  if (f == NULL || f->in_callback) return 0;
+  f->in_callback = 1;
+  f->callbacks++;
+  f->callback_t0 = prof_now();
+  return 1;
+}
+
+void rb_gsl_prof_callback_end(int token)
+{
+  prof_frame *f = prof_current;
+  if (token == 0 || f == NULL || !f->in_callback) return;
+  f->callback_time += prof_now() - f->callback_t0;
+  f->in_callback = 0;
+}
+
+/* The start of a section, 0 when the profiler is off */
+size_t rb_gsl_prof_clock(void)
+{
+  return prof_enabled ? prof_now() : 0;
+}
+
+void rb_gsl_prof_section(rb_gsl_prof_entry *e, size_t t0)
+{
+  if (t0 == 0) return;
+  if (!e->listed) prof_list(e);
+  PROF_ADD(e->calls, 1);
+  PROF_ADD(e->time, prof_now() - t0);
+}
+
+/* Vector and matrix data allocated by the method running on this thread */
+void rb_gsl_prof_bytes(size_t bytes)
+{
+  prof_frame *f = prof_current;
+  if (f && !f->in_callback) f->bytes += bytes;
+}
+
+static VALUE rb_gsl_profiler_enable(VALUE module)
+{
+  prof_enabled = 1;
+  return Qtrue;
+}
+
+static VALUE rb_gsl_profiler_disable(VALUE module)
+{
+  prof_enabled = 0;
+  return Qfalse;
+}
+
+static VALUE rb_gsl_profiler_enabled(VALUE module)
+{
+  return prof_enabled ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_profiler_available(VALUE module)
+{
+  return Qtrue;
+}
+
+static VALUE rb_gsl_profiler_report(VALUE module)
+{
+  VALUE report = rb_hash_new(), h;
+  rb_gsl_prof_entry *e;
+  PROF_LOCK();
+  e = prof_entries;
+  PROF_UNLOCK();
+  for (; e; e = e->next) {
+    if (e->calls == 0) continue;
+    h = rb_hash_new();
+    rb_hash_aset(h, ID2SYM(rb_intern("calls")), SIZET2NUM(e->calls));
+    rb_hash_aset(h, ID2SYM(rb_intern("time")), rb_float_new(e->time*1e-9));
+    rb_hash_aset(h, ID2SYM(rb_intern("native_time")),
+		 rb_float_new((e->time - e->callback_time)*1e-9));
+    rb_hash_aset(h, ID2SYM(rb_intern("callback_time")), rb_float_new(e->callback_time*1e-9));
+    rb_hash_aset(h, ID2SYM(rb_intern("callbacks")), SIZET2NUM(e->callbacks));
+    rb_hash_aset(h, ID2SYM(rb_intern("bytes")), SIZET2NUM(e->bytes));
+    rb_hash_aset(report, rb_str_new2(e->name), h);
+  }
+  return report;
+}
+
+static VALUE rb_gsl_profiler_reset(VALUE module)
+{
+  rb_gsl_prof_entry *e;
+  PROF_LOCK();
+  for (e = prof_entries; e; e = e->next)
+    e->calls = e->callbacks = e->bytes = e->time = e->callback_time = 0;
+  PROF_UNLOCK();
+  return Qnil;
+}
+
+static VALUE prof_restore(VALUE was)
+{
+  prof_enabled = RTEST(was);
+  return Qnil;
+}
+
+/* GSL::Profiler.profile { ... }: the report of the block alone */
+static VALUE rb_gsl_profiler_profile(VALUE module)
+{
+  VALUE was = prof_enabled ? Qtrue : Qfalse;
+  rb_need_block();
+  rb_gsl_profiler_reset(module);
+  prof_enabled = 1;
+  rb_ensure(rb_yield, Qnil, prof_restore, was);
+  return rb_gsl_profiler_report(module);
+}
+
+#else
+
+static VALUE rb_gsl_profiler_enable(VALUE module)
+{
+  rb_raise(rb_eNotImpError, "the profiler is not compiled in (build with --enable-profile)");
+  return Qnil;
+}
+
+static VALUE rb_gsl_profiler_disable(VALUE module)
+{
+  return Qfalse;
+}
+
+static VALUE rb_gsl_profiler_enabled(VALUE module)
+{
+  return Qfalse;
+}
+
+static VALUE rb_gsl_profiler_available(VALUE module)
+{
+  return Qfalse;
+}
+
+static VALUE rb_gsl_profiler_report(VALUE module)
+{
+  return rb_hash_new();
+}
+
+static VALUE rb_gsl_profiler_reset(VALUE module)
+{
+  return Qnil;
+}
+
+static VALUE rb_gsl_profiler_profile(VALUE module)
+{
+  return rb_gsl_profiler_enable(module);
+}
+
+#endif
+
+void Init_gsl_profiler(VALUE module)
+{
+  VALUE mgsl_profiler;
+  mgsl_profiler = rb_define_module_under(module, "Profiler");
+  rb_define_module_function(mgsl_profiler, "enable", rb_gsl_profiler_enable, 0);
+  rb_define_module_function(mgsl_profiler, "disable", rb_gsl_profiler_disable, 0);
+  rb_define_module_function(mgsl_profiler, "enabled?", rb_gsl_profiler_enabled, 0);
+  rb_define_module_function(mgsl_profiler, "available?", rb_gsl_profiler_available, 0);
+  rb_define_module_function(mgsl_profiler, "report", rb_gsl_profiler_report, 0);
+  rb_define_module_function(mgsl_profiler, "reset", rb_gsl_profiler_reset, 0);
+  rb_define_module_function(mgsl_profiler, "profile", rb_gsl_profiler_profile, 0);
+}
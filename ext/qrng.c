@@ -141,6 +141,80 @@ static VALUE rb_gsl_qrng_get(int argc, VALUE *argv, VALUE obj)
   }
 }
 
+/*
+  Bulk generation and skip-ahead.
+
+    m = q.fill(n)            # n points, one per row of a new Matrix
+    q.fill(m)                # the next m.size1 points into the rows of m
+    q.skip(n)                # discards the next n points
+
+  The points are generated in C, without the GVL from
+  GSL.nogvl_threshold on, and fill(n) returns the same points as n calls
+  of get.  Disjoint segments of one sequence for parallel runs are
+  clones or new generators of the same type skipped to their offsets:
+
+    q = GSL::QRng.alloc("sobol", 3).skip(rank*n)
+    m = q.fill(n)
+
+  gsl_qrng keeps the state of each type private, so skip draws the
+  points into one scratch point: O(n) but without any object.
+*/
+struct qrng_fill {
+  gsl_qrng *q;
+  double *data;                 /* rows of tda doubles, tda 0 to discard */
+  size_t n, tda;
+};
+
+static int qrng_fill_run(void *data)
+{
+  struct qrng_fill *t = (struct qrng_fill *) data;
+  size_t i;
+  int status = GSL_SUCCESS;
+  for (i = 0; i < t->n && status == GSL_SUCCESS; i++)
+    status = gsl_qrng_get(t->q, t->data + i*t->tda);
+  return status;
+}
+
+static VALUE rb_gsl_qrng_fill(VALUE obj, VALUE mm)
+{
+  struct qrng_fill t;
+  gsl_matrix *m = NULL;
+  VALUE vm = mm;
+  long n;
+  Data_Get_Struct(obj, gsl_qrng, t.q);
+  if (MATRIX_P(mm)) {
+    Data_Get_Struct(mm, gsl_matrix, m);
+    if (m->size2 != t.q->dimension)
+      rb_raise(rb_eRangeError, "matrix has %d columns, the generator %d dimensions",
+	       (int) m->size2, (int) t.q->dimension);
+  } else {
+    n = NUM2LONG(mm);
+    if (n <= 0) rb_raise(rb_eArgError, "number of points must be positive");
+    m = gsl_matrix_alloc((size_t) n, t.q->dimension);
+    vm = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  }
+  t.data = m->data;
+  t.n = m->size1;
+  t.tda = m->tda;
+  rb_gsl_nogvl_call(qrng_fill_run, &t, t.n*t.q->dimension);
+  return vm;
+}
+
+static VALUE rb_gsl_qrng_skip(VALUE obj, VALUE nn)
+{
+  struct qrng_fill t;
+  VALUE vbuf;
+  long n = NUM2LONG(nn);
+  if (n < 0) rb_raise(rb_eArgError, "number of points must be non-negative");
+  Data_Get_Struct(obj, gsl_qrng, t.q);
+  t.data = ALLOCV_N(double, vbuf, t.q->dimension);
+  t.n = (size_t) n;
+  t.tda = 0;
+  rb_gsl_nogvl_call(qrng_fill_run, &t, t.n*t.q->dimension);
+  ALLOCV_END(vbuf);
+  return obj;
+}
+
 void Init_gsl_qrng(VALUE module)
 {
   VALUE cgsl_qrng;
@@ -158,6 +232,8 @@ void Init_gsl_qrng(VALUE module)
   rb_define_singleton_method(cgsl_qrng, "memcpy", rb_gsl_qrng_memcpy, 2);
 
   rb_define_method(cgsl_qrng, "get", rb_gsl_qrng_get, -1);
+  rb_define_method(cgsl_qrng, "fill", rb_gsl_qrng_fill, 1);
+  rb_define_method(cgsl_qrng, "skip", rb_gsl_qrng_skip, 1);
 
   rb_define_const(cgsl_qrng, "NIEDERREITER_2", INT2FIX(GSL_QRNG_NIEDERREITER_2));
   rb_define_const(cgsl_qrng, "SOBOL", INT2FIX(GSL_QRNG_SOBOL));
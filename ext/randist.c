@@ -21,6 +21,8 @@ VALUE rb_gsl_eval_pdf_cdf3(VALUE xx, VALUE aa, VALUE bb,
 VALUE rb_gsl_eval_pdf_cdf2_uint(VALUE xx, VALUE aa, 
 				double (*f)(unsigned int, double));
 
+static VALUE cgsl_ran_discrete;
+
 static VALUE rb_gsl_ran_eval0(int argc, VALUE *argv, VALUE obj,
 			      double (*f)(const gsl_rng*))
 {
@@ -1148,7 +1150,7 @@ static VALUE rb_gsl_ran_choose(int argc, VALUE *argv, VALUE obj)
     k = FIX2INT(argv[1]);
     if (k > n) rb_raise(rb_eArgError, "the argument 1 must be less than or equal to the size of the vector.");
     v2 = gsl_vector_alloc(k);
-    gsl_ran_choose(r, v2->data, k, v->data, n, sizeof(double));
+    mygsl_ran_choose(r, v2, v);
     return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v2);;
     break;
   case 1:
@@ -1158,7 +1160,7 @@ static VALUE rb_gsl_ran_choose(int argc, VALUE *argv, VALUE obj)
     k = v->size;
     if (k > n) rb_raise(rb_eArgError, "the argument 1 must be less than or equal to the size of the vector.");
     v2 = gsl_vector_alloc(k);
-    gsl_ran_choose(r, v2->data, k, v->data, n, sizeof(double));
+    mygsl_ran_choose(r, v2, v);
     return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v2);;
     break;
   default:
@@ -1183,7 +1185,7 @@ static VALUE rb_gsl_ran_choose_singleton(int argc, VALUE *argv, VALUE obj)
     k = FIX2INT(argv[2]);
     if (k > n) rb_raise(rb_eArgError, "the argument 1 must be less than or equal to the size of the vector.");
     v2 = gsl_vector_alloc(k);
-    gsl_ran_choose(r, v2->data, k, v->data, n, sizeof(double));
+    mygsl_ran_choose(r, v2, v);
     return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v2);;
     break;
   case 2:
@@ -1195,7 +1197,7 @@ static VALUE rb_gsl_ran_choose_singleton(int argc, VALUE *argv, VALUE obj)
     k = v->size;
     if (k > n) rb_raise(rb_eArgError, "the argument 1 must be less than or equal to the size of the vector.");
     v2 = gsl_vector_alloc(k);
-    gsl_ran_choose(r, v2->data, k, v->data, n, sizeof(double));
+    mygsl_ran_choose(r, v2, v);
     return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v2);;
     break;
   default:
@@ -1255,31 +1257,203 @@ static VALUE rb_gsl_ran_dirichlet_lnpdf(VALUE obj, VALUE a, VALUE t)
 }
 #endif
 
+/*
+  GSL::Ran::Discrete: the alias table of GSL for the weights w0 it was
+  built from, and the weights w after Discrete#update. A changed weight
+  k is drawn as its base min(w0[k], w[k]), from the table with the
+  rejection of w[k]/w0[k] when it was lowered, plus the excess
+  w[k] - w0[k] of a raised weight, from the list of changes; the two
+  parts are chosen by their totals M and E. The table is rebuilt once
+  the list is longer than sqrt(K), or M is less than half of the weight
+  of the table (more than one rejection in two draws).
+*/
+typedef struct {
+  gsl_ran_discrete_t *g;
+  size_t K;
+  double *w0, *w;
+  double W0, M, E;
+  size_t *changed, nchanged;
+  char *flag;
+} mygsl_ran_discrete;
+
+static void mygsl_ran_discrete_free(mygsl_ran_discrete *d)
+{
+  if (d->g) gsl_ran_discrete_free(d->g);
+  xfree(d->w0);
+  xfree(d->w);
+  xfree(d->changed);
+  xfree(d->flag);
+  xfree(d);
+}
+
+static void mygsl_ran_discrete_build(mygsl_ran_discrete *d)
+{
+  gsl_ran_discrete_t *g;
+  size_t i;
+  g = gsl_ran_discrete_preproc(d->K, d->w);
+  if (d->g) gsl_ran_discrete_free(d->g);
+  d->g = g;
+  memcpy(d->w0, d->w, sizeof(double)*d->K);
+  for (i = 0, d->W0 = 0.0; i < d->K; i++) d->W0 += d->w[i];
+  for (i = 0; i < d->nchanged; i++) d->flag[d->changed[i]] = 0;
+  d->nchanged = 0;
+  d->M = d->W0;
+  d->E = 0.0;
+}
+
+static size_t mygsl_ran_discrete_sample(const gsl_rng *r, const mygsl_ran_discrete *d)
+{
+  size_t i, k;
+  double u, e;
+  if (d->nchanged > 0 && (u = gsl_rng_uniform(r)*(d->M + d->E)) >= d->M) {
+    u -= d->M;
+    for (i = 0, k = d->changed[0]; i < d->nchanged; i++) {
+      e = d->w[d->changed[i]] - d->w0[d->changed[i]];
+      if (e <= 0.0) continue;
+      k = d->changed[i];
+      if (u < e) break;
+      u -= e;
+    }
+    return k;
+  }
+  for (;;) {
+    k = gsl_ran_discrete(r, d->g);
+    if (!d->flag[k] || d->w[k] >= d->w0[k] || gsl_rng_uniform(r)*d->w0[k] < d->w[k])
+      return k;
+  }
+}
+
 static VALUE rb_gsl_ran_discrete_new(VALUE klass, VALUE vv)
 {
   gsl_vector *v = NULL;
-  gsl_ran_discrete_t *g = NULL;
+  mygsl_ran_discrete *d;
+  VALUE obj;
+  size_t i;
+  CHECK_VECTOR(vv);
   Data_Get_Struct(vv, gsl_vector, v);
-  g = gsl_ran_discrete_preproc(v->size, v->data);
-  return Data_Wrap_Struct(klass, 0, gsl_ran_discrete_free, g);
+  d = ALLOC(mygsl_ran_discrete);
+  memset(d, 0, sizeof(mygsl_ran_discrete));
+  obj = Data_Wrap_Struct(klass, 0, mygsl_ran_discrete_free, d);
+  d->K = v->size;
+  d->w0 = ALLOC_N(double, d->K);
+  d->w = ALLOC_N(double, d->K);
+  d->changed = ALLOC_N(size_t, d->K);
+  d->flag = ALLOC_N(char, d->K);
+  memset(d->flag, 0, d->K);
+  for (i = 0; i < d->K; i++) d->w[i] = gsl_vector_get(v, i);
+  mygsl_ran_discrete_build(d);
+  return obj;
 }
 
-static VALUE rb_gsl_ran_discrete(VALUE obj, VALUE gg)
+static mygsl_ran_discrete* rb_gsl_get_ran_discrete(VALUE gg)
+{
+  mygsl_ran_discrete *d;
+  if (!rb_obj_is_kind_of(gg, cgsl_ran_discrete))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Ran::Discrete expected)",
+	     rb_class2name(CLASS_OF(gg)));
+  Data_Get_Struct(gg, mygsl_ran_discrete, d);
+  return d;
+}
+
+/* rng.discrete(g), or rng.discrete(g, n) for a Vector::Int of n samples */
+static VALUE rb_gsl_ran_discrete(int argc, VALUE *argv, VALUE obj)
 {
   gsl_rng *r = NULL;
-  gsl_ran_discrete_t *g = NULL;
+  mygsl_ran_discrete *d;
+  gsl_vector_int *v;
+  size_t i, n;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
   Data_Get_Struct(obj, gsl_rng, r);
-  Data_Get_Struct(gg, gsl_ran_discrete_t, g);
-  return INT2FIX(gsl_ran_discrete(r, g));
+  d = rb_gsl_get_ran_discrete(argv[0]);
+  if (argc == 1) return INT2FIX(mygsl_ran_discrete_sample(r, d));
+  n = NUM2SIZET(argv[1]);
+  v = gsl_vector_int_alloc(n);
+  for (i = 0; i < n; i++) v->data[i*v->stride] = (int) mygsl_ran_discrete_sample(r, d);
+  return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, v);
 }
 
 static VALUE rb_gsl_ran_discrete_pdf(VALUE obj, VALUE k, VALUE gg)
 {
-  gsl_ran_discrete_t *g = NULL;
-  Data_Get_Struct(gg, gsl_ran_discrete_t, g);
-  return rb_float_new(gsl_ran_discrete_pdf(FIX2INT(k), g));
+  mygsl_ran_discrete *d = rb_gsl_get_ran_discrete(gg);
+  size_t i = NUM2SIZET(k);
+  if (i >= d->K) return rb_float_new(0.0);
+  return rb_float_new(d->w[i]/(d->M + d->E));
+}
+
+/*
+  g.update(k, w), g.update([k1, k2, ...], [w1, w2, ...]): sets weights,
+  in O(1) each until the table is due for a rebuild (see above)
+*/
+static VALUE rb_gsl_ran_discrete_update(VALUE obj, VALUE kk, VALUE ww)
+{
+  mygsl_ran_discrete *d = rb_gsl_get_ran_discrete(obj);
+  VALUE ks, ws;
+  size_t i, j, k;
+  double w, b;
+  if (FIXNUM_P(kk)) {
+    ks = rb_ary_new3(1, kk);
+    ws = rb_ary_new3(1, ww);
+  } else {
+    ks = TYPE(kk) == T_ARRAY ? kk : rb_funcall(kk, rb_intern("to_a"), 0);
+    ws = TYPE(ww) == T_ARRAY ? ww : rb_funcall(ww, rb_intern("to_a"), 0);
+    if (RARRAY_LEN(ks) != RARRAY_LEN(ws))
+      rb_raise(rb_eArgError, "indices and weights have different lengths");
+  }
+  for (j = 0; j < (size_t) RARRAY_LEN(ks); j++) {
+    k = NUM2SIZET(rb_ary_entry(ks, j));
+    w = NUM2DBL(rb_ary_entry(ws, j));
+    if (k >= d->K) rb_raise(rb_eIndexError, "index %d out of range", (int) k);
+    if (!(w >= 0.0)) rb_raise(rb_eArgError, "weights must be non-negative");
+    d->w[k] = w;
+    if (!d->flag[k]) {
+      d->flag[k] = 1;
+      d->changed[d->nchanged++] = k;
+    }
+  }
+  /* the totals, recomputed over the changes so that rounding does not
+     accumulate */
+  d->M = d->W0;
+  d->E = 0.0;
+  for (i = 0; i < d->nchanged; i++) {
+    k = d->changed[i];
+    b = GSL_MIN(d->w0[k], d->w[k]);
+    d->M -= d->w0[k] - b;
+    d->E += d->w[k] - b;
+  }
+  if (!(d->M + d->E > 0.0)) rb_raise(rb_eArgError, "weights must not all be zero");
+  if (d->nchanged*d->nchanged > d->K || d->M < 0.5*d->W0) mygsl_ran_discrete_build(d);
+  return obj;
+}
+
+/* g.weights: a Vector of the current weights */
+static VALUE rb_gsl_ran_discrete_weights(VALUE obj)
+{
+  mygsl_ran_discrete *d = rb_gsl_get_ran_discrete(obj);
+  gsl_vector *v = gsl_vector_alloc(d->K);
+  memcpy(v->data, d->w, sizeof(double)*d->K);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
 }
 
+#ifdef GSL_1_3_LATER
+/*
+  g.counts(rng, n): a Vector::Int of the number of times each category
+  comes up in n samples, from one multinomial variate of the weights
+  (K binomial draws rather than n samples)
+*/
+static VALUE rb_gsl_ran_discrete_counts(VALUE obj, VALUE rr, VALUE nn)
+{
+  mygsl_ran_discrete *d = rb_gsl_get_ran_discrete(obj);
+  gsl_rng *r;
+  gsl_vector_int *v;
+  CHECK_RNG(rr);
+  Data_Get_Struct(rr, gsl_rng, r);
+  v = gsl_vector_int_alloc(d->K);
+  gsl_ran_multinomial(r, d->K, NUM2UINT(nn), d->w, (unsigned int *) v->data);
+  return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, v);
+}
+#endif
+
 #ifdef HAVE_NARRAY_H
 #include "narray.h"
 #endif
@@ -1668,10 +1842,377 @@ static VALUE rb_gsl_ran_gamma_mt(int argc, VALUE *argv, VALUE obj)
 }
 #endif
 
+/*
+  Bulk sampling: Rng#fill!(dist, obj, *params) and Rng#draw(dist, n, *params)
+  fill a Vector or Matrix (Vector::Int, Matrix::Int for discrete variates)
+  without going back to Ruby for every sample. Multivariate distributions
+  write one sample per matrix row.
+*/
+typedef void (*mygsl_ran_func)(void);
+
+enum {
+  MYGSL_RAN_D0,      /* double f(r) */
+  MYGSL_RAN_D1,      /* double f(r, a) */
+  MYGSL_RAN_D2,      /* double f(r, a, b) */
+  MYGSL_RAN_D3,      /* double f(r, a, b, c) */
+  MYGSL_RAN_U1,      /* unsigned int f(r, a) */
+  MYGSL_RAN_U_DU,    /* unsigned int f(r, double, unsigned int) */
+  MYGSL_RAN_U_DD,    /* unsigned int f(r, double, double) */
+  MYGSL_RAN_U_UUU,   /* unsigned int f(r, unsigned int x 3) */
+  MYGSL_RAN_DISCRETE,
+  MYGSL_RAN_BIVARIATE,
+  MYGSL_RAN_DIR2,
+  MYGSL_RAN_DIR3,
+  MYGSL_RAN_DIRN,
+  MYGSL_RAN_DIRICHLET,
+};
+
+typedef struct {
+  const char *name;
+  int type;
+  mygsl_ran_func f;
+} mygsl_ran_dist;
+
+static const mygsl_ran_dist mygsl_ran_dists[] = {
+  {"ugaussian", MYGSL_RAN_D0, (mygsl_ran_func) gsl_ran_ugaussian},
+  {"gaussian", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_gaussian},
+  {"ugaussian_ratio_method", MYGSL_RAN_D0, (mygsl_ran_func) gsl_ran_ugaussian_ratio_method},
+  {"gaussian_ratio_method", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_gaussian_ratio_method},
+  {"ugaussian_tail", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_ugaussian_tail},
+  {"gaussian_tail", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_gaussian_tail},
+#ifdef GSL_1_8_LATER
+  {"gaussian_ziggurat", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_gaussian_ziggurat},
+  {"gamma_mt", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_gamma_mt},
+#endif
+  {"exponential", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_exponential},
+  {"laplace", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_laplace},
+  {"exppow", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_exppow},
+  {"cauchy", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_cauchy},
+  {"rayleigh", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_rayleigh},
+  {"rayleigh_tail", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_rayleigh_tail},
+  {"landau", MYGSL_RAN_D0, (mygsl_ran_func) gsl_ran_landau},
+  {"levy", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_levy},
+  {"levy_skew", MYGSL_RAN_D3, (mygsl_ran_func) gsl_ran_levy_skew},
+  {"gamma", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_gamma},
+  {"flat", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_flat},
+  {"lognormal", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_lognormal},
+  {"chisq", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_chisq},
+  {"fdist", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_fdist},
+  {"tdist", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_tdist},
+  {"beta", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_beta},
+  {"logistic", MYGSL_RAN_D1, (mygsl_ran_func) gsl_ran_logistic},
+  {"pareto", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_pareto},
+  {"weibull", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_weibull},
+  {"gumbel1", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_gumbel1},
+  {"gumbel2", MYGSL_RAN_D2, (mygsl_ran_func) gsl_ran_gumbel2},
+  {"poisson", MYGSL_RAN_U1, (mygsl_ran_func) gsl_ran_poisson},
+  {"bernoulli", MYGSL_RAN_U1, (mygsl_ran_func) gsl_ran_bernoulli},
+  {"geometric", MYGSL_RAN_U1, (mygsl_ran_func) gsl_ran_geometric},
+  {"logarithmic", MYGSL_RAN_U1, (mygsl_ran_func) gsl_ran_logarithmic},
+  {"binomial", MYGSL_RAN_U_DU, (mygsl_ran_func) gsl_ran_binomial},
+#ifdef GSL_1_4_LATER
+  {"binomial_tpe", MYGSL_RAN_U_DU, (mygsl_ran_func) gsl_ran_binomial_tpe},
+#endif
+  {"pascal", MYGSL_RAN_U_DU, (mygsl_ran_func) gsl_ran_pascal},
+  {"negative_binomial", MYGSL_RAN_U_DD, (mygsl_ran_func) gsl_ran_negative_binomial},
+  {"hypergeometric", MYGSL_RAN_U_UUU, (mygsl_ran_func) gsl_ran_hypergeometric},
+  {"discrete", MYGSL_RAN_DISCRETE, NULL},
+  {"bivariate_gaussian", MYGSL_RAN_BIVARIATE, NULL},
+  {"dir_2d", MYGSL_RAN_DIR2, (mygsl_ran_func) gsl_ran_dir_2d},
+  {"dir_2d_trig_method", MYGSL_RAN_DIR2, (mygsl_ran_func) gsl_ran_dir_2d_trig_method},
+  {"dir_3d", MYGSL_RAN_DIR3, NULL},
+  {"dir_nd", MYGSL_RAN_DIRN, NULL},
+#ifdef GSL_1_3_LATER
+  {"dirichlet", MYGSL_RAN_DIRICHLET, NULL},
+#endif
+  {NULL, 0, NULL}
+};
+
+static const int mygsl_ran_nparams[] = {0, 1, 2, 3, 1, 2, 2, 3, 1, 3, 0, 0, 1, 1};
+
+static const mygsl_ran_dist* mygsl_ran_dist_find(VALUE name)
+{
+  const mygsl_ran_dist *d;
+  const char *s;
+  if (TYPE(name) == T_SYMBOL) s = rb_id2name(SYM2ID(name));
+  else s = StringValuePtr(name);
+  for (d = mygsl_ran_dists; d->name; d++)
+    if (strcmp(d->name, s) == 0) return d;
+  rb_raise(rb_eArgError, "unknown distribution %s", s);
+  return NULL;
+}
+
+static int mygsl_ran_dist_discrete_p(const mygsl_ran_dist *d)
+{
+  return (d->type >= MYGSL_RAN_U1 && d->type <= MYGSL_RAN_DISCRETE);
+}
+
+static int mygsl_ran_dist_multivariate_p(const mygsl_ran_dist *d)
+{
+  return (d->type >= MYGSL_RAN_BIVARIATE);
+}
+
+/* Number of columns of a multivariate sample */
+static size_t mygsl_ran_dist_dim(const mygsl_ran_dist *d, VALUE *params)
+{
+  gsl_vector *alpha = NULL;
+  switch (d->type) {
+  case MYGSL_RAN_BIVARIATE: case MYGSL_RAN_DIR2: return 2;
+  case MYGSL_RAN_DIR3: return 3;
+  case MYGSL_RAN_DIRN: return FIX2INT(params[0]);
+  case MYGSL_RAN_DIRICHLET:
+    CHECK_VECTOR(params[0]);
+    Data_Get_Struct(params[0], gsl_vector, alpha);
+    return alpha->size;
+  default: return 1;
+  }
+}
+
+/*
+  Fills rows x cols elements at data, with strides rs (between rows) and
+  cs (between columns). Exactly one of data and idata is non-NULL.
+*/
+static void mygsl_ran_dist_fill(const gsl_rng *r, const mygsl_ran_dist *d,
+				VALUE *params, double *data, int *idata,
+				size_t rows, size_t cols, size_t rs, size_t cs)
+{
+  double p[3];
+  unsigned int u[3];
+  mygsl_ran_discrete *g = NULL;
+  gsl_vector *alpha = NULL;
+  double *row;
+  unsigned int k;
+  size_t i, j, pos;
+  switch (d->type) {
+  case MYGSL_RAN_D3:
+    p[2] = NUM2DBL(params[2]);
+    /* no break */
+  case MYGSL_RAN_D2:
+    p[1] = NUM2DBL(params[1]);
+    /* no break */
+  case MYGSL_RAN_D1:
+  case MYGSL_RAN_U1:
+    p[0] = NUM2DBL(params[0]);
+    break;
+  case MYGSL_RAN_U_DU:
+    p[0] = NUM2DBL(params[0]);
+    u[0] = NUM2UINT(params[1]);
+    break;
+  case MYGSL_RAN_U_DD:
+    p[0] = NUM2DBL(params[0]);
+    p[1] = NUM2DBL(params[1]);
+    break;
+  case MYGSL_RAN_U_UUU:
+    u[0] = NUM2UINT(params[0]);
+    u[1] = NUM2UINT(params[1]);
+    u[2] = NUM2UINT(params[2]);
+    break;
+  case MYGSL_RAN_DISCRETE:
+    g = rb_gsl_get_ran_discrete(params[0]);
+    break;
+  case MYGSL_RAN_BIVARIATE:
+    p[0] = NUM2DBL(params[0]);
+    p[1] = NUM2DBL(params[1]);
+    p[2] = NUM2DBL(params[2]);
+    break;
+  case MYGSL_RAN_DIRICHLET:
+    Data_Get_Struct(params[0], gsl_vector, alpha);
+    break;
+  default:
+    break;
+  }
+  if (mygsl_ran_dist_multivariate_p(d)) {
+    /* one sample per row, columns are contiguous (cs == 1) */
+    for (i = 0; i < rows; i++) {
+      row = data + i*rs;
+      switch (d->type) {
+      case MYGSL_RAN_BIVARIATE:
+	gsl_ran_bivariate_gaussian(r, p[0], p[1], p[2], row, row + 1);
+	break;
+      case MYGSL_RAN_DIR2:
+	(*(void (*)(const gsl_rng*, double*, double*)) d->f)(r, row, row + 1);
+	break;
+      case MYGSL_RAN_DIR3:
+	gsl_ran_dir_3d(r, row, row + 1, row + 2);
+	break;
+      case MYGSL_RAN_DIRN:
+	gsl_ran_dir_nd(r, cols, row);
+	break;
+#ifdef GSL_1_3_LATER
+      case MYGSL_RAN_DIRICHLET:
+	gsl_ran_dirichlet(r, cols, alpha->data, row);
+	break;
+#endif
+      }
+    }
+    return;
+  }
+  for (i = 0; i < rows; i++) {
+    for (j = 0; j < cols; j++) {
+      pos = i*rs + j*cs;
+      if (!mygsl_ran_dist_discrete_p(d)) {
+	switch (d->type) {
+	case MYGSL_RAN_D0:
+	  data[pos] = (*(double (*)(const gsl_rng*)) d->f)(r);
+	  break;
+	case MYGSL_RAN_D1:
+	  data[pos] = (*(double (*)(const gsl_rng*, double)) d->f)(r, p[0]);
+	  break;
+	case MYGSL_RAN_D2:
+	  data[pos] = (*(double (*)(const gsl_rng*, double, double)) d->f)(r, p[0], p[1]);
+	  break;
+	case MYGSL_RAN_D3:
+	  data[pos] = (*(double (*)(const gsl_rng*, double, double, double)) d->f)(r, p[0], p[1], p[2]);
+	  break;
+	}
+	continue;
+      }
+      switch (d->type) {
+      case MYGSL_RAN_U1:
+	k = (*(unsigned int (*)(const gsl_rng*, double)) d->f)(r, p[0]);
+	break;
+      case MYGSL_RAN_U_DU:
+	k = (*(unsigned int (*)(const gsl_rng*, double, unsigned int)) d->f)(r, p[0], u[0]);
+	break;
+      case MYGSL_RAN_U_DD:
+	k = (*(unsigned int (*)(const gsl_rng*, double, double)) d->f)(r, p[0], p[1]);
+	break;
+      case MYGSL_RAN_U_UUU:
+	k = (*(unsigned int (*)(const gsl_rng*, unsigned int, unsigned int, unsigned int)) d->f)(r, u[0], u[1], u[2]);
+	break;
+      default:
+	k = (unsigned int) mygsl_ran_discrete_sample(r, g);
+	break;
+      }
+      if (idata) idata[pos] = (int) k;
+      else data[pos] = (double) k;
+    }
+  }
+}
+
+static VALUE rb_gsl_ran_fill_obj(gsl_rng *r, const mygsl_ran_dist *d,
+				 VALUE vv, VALUE *params)
+{
+  gsl_vector *v = NULL;
+  gsl_matrix *m = NULL;
+  gsl_vector_int *vi = NULL;
+  gsl_matrix_int *mi = NULL;
+  size_t dim;
+  if (mygsl_ran_dist_multivariate_p(d)) {
+    CHECK_MATRIX(vv);
+    Data_Get_Struct(vv, gsl_matrix, m);
+    dim = mygsl_ran_dist_dim(d, params);
+    if (m->size2 != dim)
+      rb_raise(rb_eArgError, "%s: matrix must have %d columns", d->name, (int) dim);
+    mygsl_ran_dist_fill(r, d, params, m->data, NULL, m->size1, m->size2, m->tda, 1);
+  } else if (VECTOR_P(vv)) {
+    Data_Get_Struct(vv, gsl_vector, v);
+    mygsl_ran_dist_fill(r, d, params, v->data, NULL, v->size, 1, v->stride, 1);
+  } else if (MATRIX_P(vv)) {
+    Data_Get_Struct(vv, gsl_matrix, m);
+    mygsl_ran_dist_fill(r, d, params, m->data, NULL, m->size1, m->size2, m->tda, 1);
+  } else if (mygsl_ran_dist_discrete_p(d) && VECTOR_INT_P(vv)) {
+    Data_Get_Struct(vv, gsl_vector_int, vi);
+    mygsl_ran_dist_fill(r, d, params, NULL, vi->data, vi->size, 1, vi->stride, 1);
+  } else if (mygsl_ran_dist_discrete_p(d) && MATRIX_INT_P(vv)) {
+    Data_Get_Struct(vv, gsl_matrix_int, mi);
+    mygsl_ran_dist_fill(r, d, params, NULL, mi->data, mi->size1, mi->size2, mi->tda, 1);
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Vector or GSL::Matrix expected)",
+	     rb_class2name(CLASS_OF(vv)));
+  }
+  return vv;
+}
+
+static gsl_rng* rb_gsl_ran_bulk_args(int *argc, VALUE **argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  switch (TYPE(obj)) {
+  case T_MODULE: case T_CLASS: case T_OBJECT:
+    if (*argc < 1) rb_raise(rb_eArgError, "too few arguments");
+    CHECK_RNG((*argv)[0]);
+    Data_Get_Struct((*argv)[0], gsl_rng, r);
+    *argc -= 1;
+    *argv += 1;
+    break;
+  default:
+    Data_Get_Struct(obj, gsl_rng, r);
+    break;
+  }
+  return r;
+}
+
+static void rb_gsl_ran_check_nparams(const mygsl_ran_dist *d, int argc)
+{
+  if (argc != mygsl_ran_nparams[d->type])
+    rb_raise(rb_eArgError, "%s: wrong number of parameters (%d for %d)", d->name,
+	     argc, mygsl_ran_nparams[d->type]);
+}
+
+/*
+  rng.fill!(dist, v, *params)
+  GSL::Ran.fill!(rng, dist, v, *params)
+*/
+static VALUE rb_gsl_ran_fill(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  const mygsl_ran_dist *d = NULL;
+  r = rb_gsl_ran_bulk_args(&argc, &argv, obj);
+  if (argc < 2) rb_raise(rb_eArgError, "too few arguments");
+  d = mygsl_ran_dist_find(argv[0]);
+  rb_gsl_ran_check_nparams(d, argc - 2);
+  return rb_gsl_ran_fill_obj(r, d, argv[1], argv + 2);
+}
+
+/*
+  rng.draw(dist, n, *params)
+  rng.draw(dist, [n1, n2], *params)
+  GSL::Ran.draw(rng, dist, n, *params)
+  Returns a new Vector (Vector::Int for discrete distributions) of n
+  samples, or a n1 x n2 Matrix (Matrix::Int). Multivariate distributions
+  return a Matrix with n rows.
+*/
+static VALUE rb_gsl_ran_draw(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  const mygsl_ran_dist *d = NULL;
+  VALUE vv;
+  size_t n1, n2 = 0;
+  int matrix = 0;
+  r = rb_gsl_ran_bulk_args(&argc, &argv, obj);
+  if (argc < 2) rb_raise(rb_eArgError, "too few arguments");
+  d = mygsl_ran_dist_find(argv[0]);
+  rb_gsl_ran_check_nparams(d, argc - 2);
+  if (TYPE(argv[1]) == T_ARRAY) {
+    if (RARRAY_LEN(argv[1]) != 2) rb_raise(rb_eArgError, "matrix shape [n1, n2] expected");
+    n1 = NUM2INT(rb_ary_entry(argv[1], 0));
+    n2 = NUM2INT(rb_ary_entry(argv[1], 1));
+    matrix = 1;
+  } else {
+    n1 = NUM2INT(argv[1]);
+  }
+  if (mygsl_ran_dist_multivariate_p(d)) {
+    if (matrix) rb_raise(rb_eArgError, "%s: number of samples expected", d->name);
+    n2 = mygsl_ran_dist_dim(d, argv + 2);
+    matrix = 1;
+  }
+  if (mygsl_ran_dist_discrete_p(d)) {
+    if (matrix) vv = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free,
+				      gsl_matrix_int_alloc(n1, n2));
+    else vv = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free,
+			       gsl_vector_int_alloc(n1));
+  } else {
+    if (matrix) vv = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+				      gsl_matrix_alloc(n1, n2));
+    else vv = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, gsl_vector_alloc(n1));
+  }
+  return rb_gsl_ran_fill_obj(r, d, vv, argv + 2);
+}
+
+void Init_gsl_ran_sample(VALUE mgsl_ran);
 void Init_gsl_ran(VALUE module)
 {
   VALUE mgsl_ran;
-  VALUE cgsl_ran_discrete;
 
   mgsl_ran = rb_define_module_under(module, "Ran");
   
@@ -1844,13 +2385,19 @@ void Init_gsl_ran(VALUE module)
   rb_define_method(cgsl_rng, "choose", rb_gsl_ran_choose, -1);
   rb_define_singleton_method(mgsl_ran, "choose", rb_gsl_ran_choose_singleton, -1);
   rb_define_method(cgsl_rng, "sample", rb_gsl_ran_sample, 2);
+  Init_gsl_ran_sample(mgsl_ran);
 
   /*****/
 
   cgsl_ran_discrete = rb_define_class_under(mgsl_ran, "Discrete", cGSL_Object);
   rb_define_singleton_method(cgsl_ran_discrete, "alloc", rb_gsl_ran_discrete_new, 1);
   rb_define_singleton_method(cgsl_ran_discrete, "preproc", rb_gsl_ran_discrete_new, 1);
-  rb_define_method(cgsl_rng, "discrete", rb_gsl_ran_discrete, 1);
+  rb_define_method(cgsl_rng, "discrete", rb_gsl_ran_discrete, -1);
+  rb_define_method(cgsl_ran_discrete, "update", rb_gsl_ran_discrete_update, 2);
+  rb_define_method(cgsl_ran_discrete, "weights", rb_gsl_ran_discrete_weights, 0);
+#ifdef GSL_1_3_LATER
+  rb_define_method(cgsl_ran_discrete, "counts", rb_gsl_ran_discrete_counts, 2);
+#endif
   rb_define_module_function(mgsl_ran,  "discrete_pdf", rb_gsl_ran_discrete_pdf, 2);
 
 #ifdef GSL_1_3_LATER
@@ -1870,4 +2417,9 @@ void Init_gsl_ran(VALUE module)
   rb_define_method(cgsl_rng, "gamma_mt", rb_gsl_ran_gamma_mt, -1);
 #endif
 
+  rb_define_method(cgsl_rng, "fill!", rb_gsl_ran_fill, -1);
+  rb_define_module_function(mgsl_ran, "fill!", rb_gsl_ran_fill, -1);
+  rb_define_method(cgsl_rng, "draw", rb_gsl_ran_draw, -1);
+  rb_define_module_function(mgsl_ran, "draw", rb_gsl_ran_draw, -1);
+
 }
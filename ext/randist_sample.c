@@ -0,0 +1,369 @@
+/*
+  randist_sample.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Shuffling and sampling without replacement on large data.
+
+    rng.shuffle!(obj)          # Vector, Vector::Int, Permutation, or the
+                               # rows of a Matrix or Matrix::Int
+    rng.choose_index(n, k)     # k distinct indices of 0 ... n, sorted
+    rng.choose(v, k)           # by choose_index when k <= n/16
+    res = GSL::Ran::Reservoir.alloc(rng, k)
+    res.push(x)                # a number, or an Array or Vector of them
+    res.sample                 # a uniform k-subset of what was pushed
+
+  Bounded integers come from one 32-bit output and a multiplication
+  (Lemire, ACM TOMACS 2019) when the generator gives the full 32 bits
+  (mt19937, taus2, philox4x32, xoshiro256ss, ...), and from
+  gsl_rng_uniform_int otherwise.  shuffle! is Fisher-Yates, and honours
+  the vector stride; its sequence is not that of Rng#shuffle.
+  choose_index is Floyd's algorithm over a hash set, O(k) in time and
+  memory whatever n, plus the sort.  The reservoir skips over the items
+  that cannot enter (Li's algorithm L), so that a pushed Vector of m
+  values costs O(k log(m/k)) random numbers rather than m.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_rng.h"
+#include <stdint.h>
+
+static VALUE cgsl_ran_reservoir;
+
+/* uniform in 0 ... n-1 */
+size_t mygsl_ran_bounded(const gsl_rng *r, size_t n)
+{
+  uint64_t m;
+  uint32_t l, t;
+  if (r->type->min != 0 || r->type->max != 0xffffffffUL || n > 0xffffffffUL)
+    return gsl_rng_uniform_int(r, n);
+  m = (uint64_t) (uint32_t) gsl_rng_get(r)*n;
+  l = (uint32_t) m;
+  if (l < n) {
+    t = (uint32_t) (-(uint32_t) n) % (uint32_t) n;
+    while (l < t) {
+      m = (uint64_t) (uint32_t) gsl_rng_get(r)*n;
+      l = (uint32_t) m;
+    }
+  }
+  return (size_t) (m >> 32);
+}
+
+/* Fisher-Yates on n items of size bytes, stride bytes apart */
+static void mygsl_ran_shuffle_bytes(const gsl_rng *r, char *base, size_t n, size_t size,
+				    size_t stride, char *tmp)
+{
+  size_t i, j;
+  for (i = n; i > 1; i--) {
+    j = mygsl_ran_bounded(r, i);
+    if (j == i - 1) continue;
+    memcpy(tmp, base + (i - 1)*stride, size);
+    memcpy(base + (i - 1)*stride, base + j*stride, size);
+    memcpy(base + j*stride, tmp, size);
+  }
+}
+
+static int size_t_cmp(const void *a, const void *b)
+{
+  size_t x = *(const size_t *) a, y = *(const size_t *) b;
+  return x < y ? -1 : (x > y);
+}
+
+/* k distinct indices of 0 ... n-1 in increasing order, at idx */
+void mygsl_ran_choose_index(const gsl_rng *r, size_t n, size_t k, size_t *idx)
+{
+  size_t cap = 16, mask, h, j, t, c = 0;
+  size_t *set;
+  while (cap < 2*k) cap <<= 1;
+  mask = cap - 1;
+  /* slots hold index + 1, 0 for empty */
+  set = ALLOC_N(size_t, cap);
+  memset(set, 0, sizeof(size_t)*cap);
+  for (j = n - k; j < n; j++) {
+    t = mygsl_ran_bounded(r, j + 1);
+    for (h = (t*0x9E3779B97F4A7C15ULL) >> 7 & mask; set[h] && set[h] != t + 1;
+	 h = (h + 1) & mask);
+    if (set[h]) {
+      /* t was taken: j is not, being new */
+      t = j;
+      for (h = (t*0x9E3779B97F4A7C15ULL) >> 7 & mask; set[h]; h = (h + 1) & mask);
+    }
+    set[h] = t + 1;
+    idx[c++] = t;
+  }
+  xfree(set);
+  qsort(idx, k, sizeof(size_t), size_t_cmp);
+}
+
+/*
+  k = dest->size elements of src, in their order: by the selection
+  sampling of gsl_ran_choose (the same draws), or by choose_index when k
+  is small against n
+*/
+void mygsl_ran_choose(const gsl_rng *r, gsl_vector *dest, const gsl_vector *src)
+{
+  size_t n = src->size, k = dest->size, i, j = 0, *idx;
+  if (k > 0 && k*16 <= n) {
+    idx = ALLOC_N(size_t, k);
+    mygsl_ran_choose_index(r, n, k, idx);
+    for (i = 0; i < k; i++)
+      dest->data[i*dest->stride] = src->data[idx[i]*src->stride];
+    xfree(idx);
+    return;
+  }
+  for (i = 0; i < n && j < k; i++) {
+    if ((n - i)*gsl_rng_uniform(r) < k - j) {
+      dest->data[j*dest->stride] = src->data[i*src->stride];
+      j++;
+    }
+  }
+}
+
+static gsl_rng* rb_gsl_ran_sample_args(int *argc, VALUE **argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  switch (TYPE(obj)) {
+  case T_MODULE: case T_CLASS: case T_OBJECT:
+    if (*argc < 1) rb_raise(rb_eArgError, "too few arguments");
+    CHECK_RNG((*argv)[0]);
+    Data_Get_Struct((*argv)[0], gsl_rng, r);
+    *argc -= 1;
+    *argv += 1;
+    break;
+  default:
+    Data_Get_Struct(obj, gsl_rng, r);
+    break;
+  }
+  return r;
+}
+
+/*
+  rng.shuffle!(obj), GSL::Ran.shuffle!(rng, obj): obj is shuffled in
+  place and returned
+*/
+static VALUE rb_gsl_ran_shuffle_bang(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = rb_gsl_ran_sample_args(&argc, &argv, obj);
+  gsl_vector *v;
+  gsl_vector_int *vi;
+  gsl_matrix *m;
+  gsl_matrix_int *mi;
+  gsl_permutation *p;
+  char tmp[sizeof(double) > sizeof(size_t) ? sizeof(double) : sizeof(size_t)], *row;
+  VALUE vv;
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  vv = argv[0];
+  rb_check_frozen(vv);
+  if (VECTOR_P(vv)) {
+    Data_Get_Struct(vv, gsl_vector, v);
+    mygsl_ran_shuffle_bytes(r, (char *) v->data, v->size, sizeof(double),
+			    v->stride*sizeof(double), tmp);
+  } else if (VECTOR_INT_P(vv)) {
+    Data_Get_Struct(vv, gsl_vector_int, vi);
+    mygsl_ran_shuffle_bytes(r, (char *) vi->data, vi->size, sizeof(int),
+			    vi->stride*sizeof(int), tmp);
+  } else if (PERMUTATION_P(vv)) {
+    Data_Get_Struct(vv, gsl_permutation, p);
+    mygsl_ran_shuffle_bytes(r, (char *) p->data, p->size, sizeof(size_t),
+			    sizeof(size_t), tmp);
+  } else if (MATRIX_P(vv)) {
+    Data_Get_Struct(vv, gsl_matrix, m);
+    row = ALLOC_N(char, m->size2*sizeof(double));
+    mygsl_ran_shuffle_bytes(r, (char *) m->data, m->size1, m->size2*sizeof(double),
+			    m->tda*sizeof(double), row);
+    xfree(row);
+  } else if (MATRIX_INT_P(vv)) {
+    Data_Get_Struct(vv, gsl_matrix_int, mi);
+    row = ALLOC_N(char, mi->size2*sizeof(int));
+    mygsl_ran_shuffle_bytes(r, (char *) mi->data, mi->size1, mi->size2*sizeof(int),
+			    mi->tda*sizeof(int), row);
+    xfree(row);
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Vector, Matrix or Permutation expected)",
+	     rb_class2name(CLASS_OF(vv)));
+  }
+  return vv;
+}
+
+/* rng.choose_index(n, k), GSL::Ran.choose_index(rng, n, k) -> Vector::Int */
+static VALUE rb_gsl_ran_choose_index(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = rb_gsl_ran_sample_args(&argc, &argv, obj);
+  gsl_vector_int *v;
+  size_t n, k, i, *idx;
+  VALUE vv;
+  if (argc != 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2)", argc);
+  n = NUM2SIZET(argv[0]);
+  k = NUM2SIZET(argv[1]);
+  if (k > n) rb_raise(rb_eArgError, "k must not exceed n");
+  if (n > INT_MAX) rb_raise(rb_eRangeError, "n must be less than 2^31 for Vector::Int");
+  v = gsl_vector_int_alloc(k);
+  vv = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, v);
+  idx = ALLOC_N(size_t, k > 0 ? k : 1);
+  if (k > 0) mygsl_ran_choose_index(r, n, k, idx);
+  for (i = 0; i < k; i++) v->data[i] = (int) idx[i];
+  xfree(idx);
+  return vv;
+}
+
+/* GSL::Ran::Reservoir: k slots, with the state of algorithm L */
+typedef struct {
+  size_t k;
+  double *x;
+  double seen;   /* items pushed */
+  double next;   /* index of the next item that enters */
+  double w;
+  VALUE rng;
+} mygsl_ran_reservoir;
+
+static void mygsl_ran_reservoir_mark(mygsl_ran_reservoir *s)
+{
+  rb_gc_mark(s->rng);
+}
+
+static void mygsl_ran_reservoir_free(mygsl_ran_reservoir *s)
+{
+  xfree(s->x);
+  xfree(s);
+}
+
+static void reservoir_skip(mygsl_ran_reservoir *s, const gsl_rng *r)
+{
+  s->next += floor(log(gsl_rng_uniform_pos(r))/log1p(-s->w)) + 1.0;
+}
+
+static void reservoir_push(mygsl_ran_reservoir *s, const gsl_rng *r, const double *x,
+			   size_t stride, size_t n)
+{
+  size_t i = 0;
+  double end;
+  for (; i < n && s->seen < s->k; i++) {
+    s->x[(size_t) s->seen] = x[i*stride];
+    s->seen += 1.0;
+    if (s->seen == s->k) {
+      s->w = exp(log(gsl_rng_uniform_pos(r))/s->k);
+      s->next = s->k - 1;
+      reservoir_skip(s, r);
+    }
+  }
+  if (i == n) return;
+  /* items seen ... end - 1 are those of x[i ...] */
+  end = s->seen + (n - i);
+  while (s->next < end) {
+    s->x[mygsl_ran_bounded(r, s->k)] = x[(i + (size_t) (s->next - s->seen))*stride];
+    s->w *= exp(log(gsl_rng_uniform_pos(r))/s->k);
+    reservoir_skip(s, r);
+  }
+  s->seen = end;
+}
+
+static VALUE rb_gsl_ran_reservoir_new(VALUE klass, VALUE rr, VALUE kk)
+{
+  mygsl_ran_reservoir *s;
+  VALUE obj;
+  CHECK_RNG(rr);
+  s = ALLOC(mygsl_ran_reservoir);
+  s->k = NUM2SIZET(kk);
+  if (s->k == 0) {
+    xfree(s);
+    rb_raise(rb_eArgError, "reservoir size must be positive");
+  }
+  s->x = NULL;
+  s->rng = rr;
+  s->seen = 0.0;
+  s->next = 0.0;
+  s->w = 0.0;
+  obj = Data_Wrap_Struct(klass, mygsl_ran_reservoir_mark, mygsl_ran_reservoir_free, s);
+  s->x = ALLOC_N(double, s->k);
+  return obj;
+}
+
+/* res.push(x): x a number, or an Array or vector of numbers */
+static VALUE rb_gsl_ran_reservoir_push(VALUE obj, VALUE xx)
+{
+  mygsl_ran_reservoir *s;
+  gsl_rng *r;
+  gsl_vector *v;
+  const double *x;
+  double d;
+  size_t stride = 1, n = 1;
+  VALUE keep = xx;
+  Data_Get_Struct(obj, mygsl_ran_reservoir, s);
+  Data_Get_Struct(s->rng, gsl_rng, r);
+  if (rb_obj_is_kind_of(xx, rb_cNumeric)) {
+    d = NUM2DBL(xx);
+    x = &d;
+  } else {
+    if (TYPE(xx) == T_ARRAY) {
+      v = make_cvector_from_rarray(xx);
+      keep = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    }
+    x = get_vector_ptr(keep, &stride, &n);
+  }
+  reservoir_push(s, r, x, stride, n);
+  RB_GC_GUARD(keep);
+  return obj;
+}
+
+/* res.sample: a Vector of the min(k, count) items kept, nil before any */
+static VALUE rb_gsl_ran_reservoir_sample(VALUE obj)
+{
+  mygsl_ran_reservoir *s;
+  gsl_vector *v;
+  size_t n;
+  Data_Get_Struct(obj, mygsl_ran_reservoir, s);
+  n = s->seen < s->k ? (size_t) s->seen : s->k;
+  if (n == 0) return Qnil;
+  v = gsl_vector_alloc(n);
+  memcpy(v->data, s->x, sizeof(double)*n);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE rb_gsl_ran_reservoir_count(VALUE obj)
+{
+  mygsl_ran_reservoir *s;
+  Data_Get_Struct(obj, mygsl_ran_reservoir, s);
+  return rb_dbl2big(s->seen);
+}
+
+static VALUE rb_gsl_ran_reservoir_size(VALUE obj)
+{
+  mygsl_ran_reservoir *s;
+  Data_Get_Struct(obj, mygsl_ran_reservoir, s);
+  return SIZET2NUM(s->k);
+}
+
+static VALUE rb_gsl_ran_reservoir_reset(VALUE obj)
+{
+  mygsl_ran_reservoir *s;
+  Data_Get_Struct(obj, mygsl_ran_reservoir, s);
+  s->seen = 0.0;
+  s->next = 0.0;
+  return obj;
+}
+
+void Init_gsl_ran_sample(VALUE mgsl_ran)
+{
+  rb_define_method(cgsl_rng, "shuffle!", rb_gsl_ran_shuffle_bang, -1);
+  rb_define_module_function(mgsl_ran, "shuffle!", rb_gsl_ran_shuffle_bang, -1);
+  rb_define_method(cgsl_rng, "choose_index", rb_gsl_ran_choose_index, -1);
+  rb_define_module_function(mgsl_ran, "choose_index", rb_gsl_ran_choose_index, -1);
+
+  cgsl_ran_reservoir = rb_define_class_under(mgsl_ran, "Reservoir", cGSL_Object);
+  rb_define_singleton_method(cgsl_ran_reservoir, "alloc", rb_gsl_ran_reservoir_new, 2);
+  rb_define_singleton_method(cgsl_ran_reservoir, "new", rb_gsl_ran_reservoir_new, 2);
+  rb_define_method(cgsl_ran_reservoir, "push", rb_gsl_ran_reservoir_push, 1);
+  rb_define_alias(cgsl_ran_reservoir, "<<", "push");
+  rb_define_method(cgsl_ran_reservoir, "sample", rb_gsl_ran_reservoir_sample, 0);
+  rb_define_method(cgsl_ran_reservoir, "count", rb_gsl_ran_reservoir_count, 0);
+  rb_define_method(cgsl_ran_reservoir, "size", rb_gsl_ran_reservoir_size, 0);
+  rb_define_method(cgsl_ran_reservoir, "reset", rb_gsl_ran_reservoir_reset, 0);
+}
@@ -0,0 +1,547 @@
+/*
+  reduce.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Reductions (sum, sum of squares, product, norm, min/max) over double
+  arrays, used by Vector#sum, #prod, #max..., the GSL::Stats moments and
+  summary, and the Matrix min/max methods, also along either axis.
+
+  The data is cut in blocks of REDUCE_BLOCK elements. Each block is
+  reduced by pairwise summation, and the block results are combined
+  pairwise in block order, so the result depends neither on the number
+  of threads nor on GSL.parallel_threshold. Arrays of at least
+  GSL.parallel_threshold elements are split over GSL.parallel_threads
+  threads (by default GSL::ThreadPool.size); the GVL is released while
+  the reduction runs.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+#define REDUCE_BLOCK 4096
+#define REDUCE_LEAF 32
+
+size_t rb_gsl_parallel_threshold = 1 << 20;
+static size_t rb_gsl_parallel_threads = 0;
+
+struct reduce_part {
+  double a, b;                /* sum, or norm scale and ssq, or min and max */
+  size_t imin, imax, inan;
+};
+
+struct reduce_task {
+  const double *x;
+  size_t stride, n, nblocks, nthreads;
+  int op;
+  double c;
+  struct reduce_part *parts;
+};
+
+static double reduce_leaf(const double *x, size_t s, size_t n, int op, double c)
+{
+  double r, d;
+  size_t i;
+  switch (op) {
+  case MYGSL_REDUCE_SUM:
+    for (i = 0, r = 0.0; i < n; i++) r += x[i*s];
+    break;
+  case MYGSL_REDUCE_SUMSQ:
+    for (i = 0, r = 0.0; i < n; i++) { d = x[i*s] - c; r += d*d; }
+    break;
+  case MYGSL_REDUCE_ABSDEV:
+    for (i = 0, r = 0.0; i < n; i++) r += fabs(x[i*s] - c);
+    break;
+  default:
+    for (i = 0, r = 1.0; i < n; i++) r *= x[i*s];
+    break;
+  }
+  return r;
+}
+
+static double reduce_pairwise(const double *x, size_t s, size_t n, int op, double c)
+{
+  size_t m;
+  if (n <= REDUCE_LEAF) return reduce_leaf(x, s, n, op, c);
+  m = n/2;
+  if (op == MYGSL_REDUCE_PROD)
+    return reduce_pairwise(x, s, m, op, c)*reduce_pairwise(x + m*s, s, n - m, op, c);
+  return reduce_pairwise(x, s, m, op, c) + reduce_pairwise(x + m*s, s, n - m, op, c);
+}
+
+/* Scaled sum of squares as in the reference dnrm2, result scale*sqrt(ssq) */
+static void nrm2_update(double *scale, double *ssq, double s, double q)
+{
+  double r;
+  if (s == 0.0) return;
+  if (*scale < s) {
+    r = *scale/s;
+    *ssq = q + *ssq*r*r;
+    *scale = s;
+  } else {
+    r = s/(*scale);
+    *ssq += q*r*r;
+  }
+}
+
+static void reduce_block(const struct reduce_task *t, size_t k, struct reduce_part *p)
+{
+  const double *x = t->x + k*REDUCE_BLOCK*t->stride;
+  size_t n = GSL_MIN(REDUCE_BLOCK, t->n - k*REDUCE_BLOCK), i, i0 = k*REDUCE_BLOCK;
+  double v;
+  switch (t->op) {
+  case MYGSL_REDUCE_NRM2:
+    p->a = 0.0; p->b = 1.0;
+    for (i = 0; i < n; i++) nrm2_update(&p->a, &p->b, fabs(x[i*t->stride]), 1.0);
+    break;
+  case MYGSL_REDUCE_MINMAX:
+    p->a = p->b = x[0];
+    p->imin = p->imax = i0;
+    p->inan = t->n;
+    for (i = 0; i < n; i++) {
+      v = x[i*t->stride];
+      if (gsl_isnan(v)) { p->inan = i0 + i; break; }
+      if (v < p->a) { p->a = v; p->imin = i0 + i; }
+      if (v > p->b) { p->b = v; p->imax = i0 + i; }
+    }
+    break;
+  default:
+    p->a = reduce_pairwise(x, t->stride, n, t->op, t->c);
+    break;
+  }
+}
+
+static int reduce_worker(void *data, size_t i)
+{
+  struct reduce_task *t = (struct reduce_task *) data;
+  size_t k, k0 = i*t->nblocks/t->nthreads, k1 = (i + 1)*t->nblocks/t->nthreads;
+  for (k = k0; k < k1; k++) reduce_block(t, k, &t->parts[k]);
+  return GSL_SUCCESS;
+}
+
+static int reduce_serial(void *data)
+{
+  return reduce_worker(data, 0);
+}
+
+static double reduce_combine(const struct reduce_part *p, size_t n, int op)
+{
+  size_t m;
+  if (n == 1) return p[0].a;
+  m = n/2;
+  if (op == MYGSL_REDUCE_PROD)
+    return reduce_combine(p, m, op)*reduce_combine(p + m, n - m, op);
+  return reduce_combine(p, m, op) + reduce_combine(p + m, n - m, op);
+}
+
+/* Threads for n elements cut in nparts independent parts, 1 below
+   GSL.parallel_threshold; also used by transpose.c */
+size_t rb_gsl_parallel_nthreads(size_t n, size_t nparts)
+{
+  size_t nt = rb_gsl_parallel_threads;
+  if (rb_gsl_parallel_threshold == 0 || n < rb_gsl_parallel_threshold) return 1;
+  if (nt == 0) nt = rb_gsl_thread_pool_size();
+  return GSL_MIN(nt, nparts);
+}
+
+/* Fills t->parts, one entry per block; the caller frees them */
+static void reduce_run(struct reduce_task *t)
+{
+  t->nblocks = (t->n + REDUCE_BLOCK - 1)/REDUCE_BLOCK;
+  t->parts = ALLOC_N(struct reduce_part, t->nblocks);
+  t->nthreads = rb_gsl_parallel_nthreads(t->n, t->nblocks);
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(reduce_worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(reduce_serial, t, t->n);
+}
+
+/*
+  op is MYGSL_REDUCE_SUM, _PROD, _NRM2, or _SUMSQ, _ABSDEV (of x - c).
+  Must be called with the GVL held.
+*/
+double mygsl_reduce(const double *x, size_t stride, size_t n, int op, double c)
+{
+  struct reduce_task t;
+  double r, scale = 0.0, ssq = 1.0;
+  size_t k;
+  if (n == 0) return op == MYGSL_REDUCE_PROD ? 1.0 : 0.0;
+  t.x = x; t.stride = stride; t.n = n; t.op = op; t.c = c;
+  reduce_run(&t);
+  if (op == MYGSL_REDUCE_NRM2) {
+    for (k = 0; k < t.nblocks; k++)
+      nrm2_update(&scale, &ssq, t.parts[k].a, t.parts[k].b);
+    r = scale*sqrt(ssq);
+  } else {
+    r = reduce_combine(t.parts, t.nblocks, op);
+  }
+  xfree(t.parts);
+  return r;
+}
+
+/*
+  Minimum and maximum and their lowest indices, as gsl_vector_minmax and
+  gsl_vector_minmax_index: a NaN is returned as both the minimum and the
+  maximum, at the index of the first NaN. n must be positive.
+*/
+void mygsl_reduce_minmax(const double *x, size_t stride, size_t n,
+			 double *min, double *max, size_t *imin, size_t *imax)
+{
+  struct reduce_task t;
+  struct reduce_part r;
+  size_t k;
+  t.x = x; t.stride = stride; t.n = n; t.op = MYGSL_REDUCE_MINMAX; t.c = 0.0;
+  reduce_run(&t);
+  r = t.parts[0];
+  for (k = 1; k < t.nblocks && r.inan == n; k++) {
+    if (t.parts[k].inan != n) r.inan = t.parts[k].inan;
+    if (t.parts[k].a < r.a) { r.a = t.parts[k].a; r.imin = t.parts[k].imin; }
+    if (t.parts[k].b > r.b) { r.b = t.parts[k].b; r.imax = t.parts[k].imax; }
+  }
+  xfree(t.parts);
+  if (r.inan != n) {
+    r.a = r.b = x[r.inan*stride];
+    r.imin = r.imax = r.inan;
+  }
+  if (min) *min = r.a;
+  if (max) *max = r.b;
+  if (imin) *imin = r.imin;
+  if (imax) *imax = r.imax;
+}
+
+/*
+  Weight sums and central moments in one pass over memory: each block
+  is reduced twice while it is in cache (the mean, then the powers of
+  the deviations, in plain loops the compiler can vectorize), and the
+  blocks are merged pairwise with the update formulas of Pebay (Sandia
+  report SAND2008-6212), again independently of the threads.
+*/
+struct moments_task {
+  const double *x, *w;
+  size_t xstride, wstride, n, nblocks, nthreads;
+  mygsl_moments *parts;
+};
+
+static void moments_block(const struct moments_task *t, size_t k, mygsl_moments *p)
+{
+  const double *x = t->x + k*REDUCE_BLOCK*t->xstride, *w = NULL;
+  size_t n = GSL_MIN(REDUCE_BLOCK, t->n - k*REDUCE_BLOCK), i, s = t->xstride, ws;
+  double sw = 0.0, sw2 = 0.0, swx = 0.0, m, d, d2, wd2, m2 = 0.0, m3 = 0.0, m4 = 0.0;
+  double min = x[0], max = x[0];
+  int nan = 0;
+  if (t->w) {
+    w = t->w + k*REDUCE_BLOCK*t->wstride;
+    ws = t->wstride;
+    for (i = 0; i < n; i++) {
+      sw += w[i*ws];
+      sw2 += w[i*ws]*w[i*ws];
+      swx += w[i*ws]*x[i*s];
+    }
+    m = sw > 0.0 ? swx/sw : 0.0;
+    for (i = 0; i < n; i++) {
+      d = x[i*s] - m;
+      d2 = d*d;
+      wd2 = w[i*ws]*d2;
+      m2 += wd2;
+      m3 += wd2*d;
+      m4 += wd2*d2;
+    }
+  } else {
+    for (i = 0; i < n; i++) swx += x[i*s];
+    sw = sw2 = (double) n;
+    m = swx/sw;
+    for (i = 0; i < n; i++) {
+      d = x[i*s] - m;
+      d2 = d*d;
+      m2 += d2;
+      m3 += d2*d;
+      m4 += d2*d2;
+    }
+  }
+  for (i = 0; i < n; i++) {
+    if (x[i*s] < min) min = x[i*s];
+    if (x[i*s] > max) max = x[i*s];
+    if (gsl_isnan(x[i*s])) nan = 1;
+  }
+  p->sw = sw; p->sw2 = sw2;
+  p->mean = m; p->m2 = m2; p->m3 = m3; p->m4 = m4;
+  p->min = nan ? GSL_NAN : min;
+  p->max = nan ? GSL_NAN : max;
+}
+
+static int moments_worker(void *data, size_t i)
+{
+  struct moments_task *t = (struct moments_task *) data;
+  size_t k, k0 = i*t->nblocks/t->nthreads, k1 = (i + 1)*t->nblocks/t->nthreads;
+  for (k = k0; k < k1; k++) moments_block(t, k, &t->parts[k]);
+  return GSL_SUCCESS;
+}
+
+static int moments_serial(void *data)
+{
+  return moments_worker(data, 0);
+}
+
+/*
+  Folds the moments of b into a (Pebay's pairwise update).  Either may
+  be empty (sw == 0); min/max of an empty set are +inf/-inf.
+*/
+void mygsl_moments_merge(mygsl_moments *a, const mygsl_moments *b)
+{
+  double na = a->sw, nb = b->sw, n = na + nb, d, d2;
+  if (na == 0.0) {
+    a->mean = b->mean; a->m2 = b->m2; a->m3 = b->m3; a->m4 = b->m4;
+  } else if (nb != 0.0) {
+    d = b->mean - a->mean;
+    d2 = d*d;
+    a->m4 += b->m4 + d2*d2*na*nb*(na*na - na*nb + nb*nb)/(n*n*n)
+      + 6.0*d2*(na*na*b->m2 + nb*nb*a->m2)/(n*n) + 4.0*d*(na*b->m3 - nb*a->m3)/n;
+    a->m3 += b->m3 + d2*d*na*nb*(na - nb)/(n*n) + 3.0*d*(na*b->m2 - nb*a->m2)/n;
+    a->m2 += b->m2 + d2*na*nb/n;
+    a->mean += d*nb/n;
+  }
+  a->sw = n;
+  a->sw2 += b->sw2;
+  if (gsl_isnan(b->min) || gsl_isnan(a->min)) {
+    a->min = a->max = GSL_NAN;
+  } else {
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+  }
+}
+
+static void moments_combine(mygsl_moments *p, size_t n, mygsl_moments *r)
+{
+  mygsl_moments b;
+  size_t m;
+  if (n == 1) {
+    *r = p[0];
+    return;
+  }
+  m = n/2;
+  moments_combine(p, m, r);
+  moments_combine(p + m, n - m, &b);
+  mygsl_moments_merge(r, &b);
+}
+
+/*
+  Sums of the weights and their squares, the weighted mean, the sums of
+  weighted 2nd to 4th powers of deviations from it, and the extrema of
+  x (NaN if x has a NaN).  w may be NULL for unit weights; n must be
+  positive.  Must be called with the GVL held.
+*/
+void mygsl_reduce_moments(const double *x, size_t xstride, const double *w,
+			  size_t wstride, size_t n, mygsl_moments *r)
+{
+  struct moments_task t;
+  t.x = x; t.xstride = xstride; t.w = w; t.wstride = wstride; t.n = n;
+  t.nblocks = (n + REDUCE_BLOCK - 1)/REDUCE_BLOCK;
+  t.parts = ALLOC_N(mygsl_moments, t.nblocks);
+  t.nthreads = rb_gsl_parallel_nthreads(n, t.nblocks);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(moments_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(moments_serial, &t, n);
+  moments_combine(t.parts, t.nblocks, r);
+  xfree(t.parts);
+}
+
+/*
+  Reductions of a matrix along one axis: axis 0 reduces each column (r
+  has size2 entries), axis 1 each row (size1 entries).  op is
+  MYGSL_REDUCE_SUM, MYGSL_REDUCE_SUMSQ (about c[k] for result k), or
+  MYGSL_REDUCE_MIN/MAX, which also store the row (column) index of the
+  extremum in ir if not NULL; a NaN is returned, with its index, if the
+  line has one.  Rows are reduced pairwise like vectors.  Columns are
+  accumulated row by row over stripes of contiguous columns, the rows
+  taken in blocks of AXIS_BLOCK summed separately, so the matrix is read
+  in memory order.  Rows, or column stripes, are split over threads;
+  the result does not depend on their number.  Must be called with the
+  GVL held.
+*/
+#define AXIS_BLOCK 128
+#define AXIS_STRIPE 8
+
+struct axis_task {
+  const gsl_matrix *m;
+  int axis, op;
+  const double *c;
+  double *r, *part;
+  size_t rstride, *ir, nparts, nthreads;
+};
+
+static void axis_rows(const struct axis_task *t, size_t i0, size_t i1)
+{
+  const gsl_matrix *m = t->m;
+  const double *x;
+  double v, best;
+  size_t i, j, jbest;
+  for (i = i0; i < i1; i++) {
+    x = m->data + i*m->tda;
+    if (t->op == MYGSL_REDUCE_SUM || t->op == MYGSL_REDUCE_SUMSQ) {
+      t->r[i*t->rstride] = reduce_pairwise(x, 1, m->size2, t->op, t->c ? t->c[i] : 0.0);
+      continue;
+    }
+    best = x[0];
+    jbest = 0;
+    for (j = 0; j < m->size2 && !gsl_isnan(best); j++) {
+      v = x[j];
+      if (gsl_isnan(v) || (t->op == MYGSL_REDUCE_MAX ? v > best : v < best)) {
+	best = v;
+	jbest = j;
+      }
+    }
+    t->r[i*t->rstride] = best;
+    if (t->ir) t->ir[i] = jbest;
+  }
+}
+
+static void axis_cols(const struct axis_task *t, size_t j0, size_t j1)
+{
+  const gsl_matrix *m = t->m;
+  const double *x, *c = t->c;
+  double *r = t->r, *part = t->part, v, d;
+  size_t i, ib, i1, j, s = t->rstride, *ir = t->ir;
+  if (t->op == MYGSL_REDUCE_SUM || t->op == MYGSL_REDUCE_SUMSQ) {
+    for (j = j0; j < j1; j++) r[j*s] = 0.0;
+    for (ib = 0; ib < m->size1; ib += AXIS_BLOCK) {
+      i1 = GSL_MIN(ib + AXIS_BLOCK, m->size1);
+      for (j = j0; j < j1; j++) part[j] = 0.0;
+      for (i = ib; i < i1; i++) {
+	x = m->data + i*m->tda;
+	if (t->op == MYGSL_REDUCE_SUM) {
+	  for (j = j0; j < j1; j++) part[j] += x[j];
+	} else {
+	  for (j = j0; j < j1; j++) {
+	    d = x[j] - c[j];
+	    part[j] += d*d;
+	  }
+	}
+      }
+      for (j = j0; j < j1; j++) r[j*s] += part[j];
+    }
+    return;
+  }
+  for (j = j0; j < j1; j++) {
+    r[j*s] = m->data[j];
+    if (ir) ir[j] = 0;
+  }
+  for (i = 1; i < m->size1; i++) {
+    x = m->data + i*m->tda;
+    for (j = j0; j < j1; j++) {
+      v = x[j];
+      if (gsl_isnan(r[j*s])) continue;
+      if (gsl_isnan(v) || (t->op == MYGSL_REDUCE_MAX ? v > r[j*s] : v < r[j*s])) {
+	r[j*s] = v;
+	if (ir) ir[j] = i;
+      }
+    }
+  }
+}
+
+static int axis_worker(void *data, size_t k)
+{
+  struct axis_task *t = (struct axis_task *) data;
+  size_t n = t->axis == 0 ? t->m->size2 : t->m->size1;
+  size_t p0 = k*t->nparts/t->nthreads, p1 = (k + 1)*t->nparts/t->nthreads;
+  size_t l0 = t->axis == 0 ? p0*AXIS_STRIPE : p0;
+  size_t l1 = t->axis == 0 ? GSL_MIN(p1*AXIS_STRIPE, n) : p1;
+  if (t->axis == 0) axis_cols(t, l0, l1);
+  else axis_rows(t, l0, l1);
+  return GSL_SUCCESS;
+}
+
+static int axis_serial(void *data)
+{
+  return axis_worker(data, 0);
+}
+
+void mygsl_reduce_axis(const gsl_matrix *m, int axis, int op, const double *c,
+		       double *r, size_t rstride, size_t *ir)
+{
+  struct axis_task t;
+  size_t work = m->size1*m->size2;
+  if (m->size1 == 0 || m->size2 == 0) return;
+  t.m = m; t.axis = axis; t.op = op; t.c = c;
+  t.r = r; t.rstride = rstride; t.ir = ir; t.part = NULL;
+  if (axis == 0) {
+    t.nparts = (m->size2 + AXIS_STRIPE - 1)/AXIS_STRIPE;
+    t.part = ALLOC_N(double, m->size2);
+  } else {
+    t.nparts = m->size1;
+  }
+  t.nthreads = rb_gsl_parallel_nthreads(work, t.nparts);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(axis_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(axis_serial, &t, work);
+  if (t.part) xfree(t.part);
+}
+
+/*
+  The axis argument of the Matrix reductions: nil (whole matrix), 0 or
+  :cols (one result per column), 1 or :rows (one per row), given as
+  the first argument or as {:axis => ...}.  The hash may also give
+  :out, a vector to store the result in, returned in *out (or Qnil).
+  Returns -1, 0 or 1.
+*/
+int rb_gsl_axis_opts(int argc, VALUE *argv, VALUE *out)
+{
+  VALUE vaxis = Qnil;
+  ID id;
+  if (out) *out = Qnil;
+  if (argc > 0 && TYPE(argv[argc-1]) == T_HASH) {
+    if (argc > 1) vaxis = argv[0];
+    else vaxis = rb_hash_aref(argv[argc-1], ID2SYM(rb_intern("axis")));
+    if (out) *out = rb_hash_aref(argv[argc-1], ID2SYM(rb_intern("out")));
+    argc--;
+  } else if (argc > 0) {
+    vaxis = argv[0];
+  }
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (NIL_P(vaxis)) return -1;
+  if (SYMBOL_P(vaxis)) {
+    id = SYM2ID(vaxis);
+    if (id == rb_intern("cols")) return 0;
+    if (id == rb_intern("rows")) return 1;
+  } else if (FIXNUM_P(vaxis) && (FIX2INT(vaxis) == 0 || FIX2INT(vaxis) == 1)) {
+    return FIX2INT(vaxis);
+  }
+  rb_raise(rb_eArgError, "axis must be 0 (or :cols), 1 (or :rows) or nil");
+  return -1;
+}
+
+static VALUE rb_gsl_parallel_threshold_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_parallel_threshold);
+}
+
+static VALUE rb_gsl_parallel_threshold_set(VALUE module, VALUE n)
+{
+  rb_gsl_parallel_threshold = NUM2SIZET(n);
+  return n;
+}
+
+static VALUE rb_gsl_parallel_threads_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_parallel_threads);
+}
+
+static VALUE rb_gsl_parallel_threads_set(VALUE module, VALUE n)
+{
+  rb_gsl_parallel_threads = NUM2SIZET(n);
+  return n;
+}
+
+void Init_gsl_reduce(VALUE module)
+{
+  rb_define_singleton_method(module, "parallel_threshold",
+			     rb_gsl_parallel_threshold_get, 0);
+  rb_define_singleton_method(module, "parallel_threshold=",
+			     rb_gsl_parallel_threshold_set, 1);
+  rb_define_singleton_method(module, "parallel_threads",
+			     rb_gsl_parallel_threads_get, 0);
+  rb_define_singleton_method(module, "parallel_threads=",
+			     rb_gsl_parallel_threads_set, 1);
+}
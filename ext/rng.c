@@ -16,13 +16,62 @@
 
 #include "rb_gsl_config.h"
 #include "rb_gsl_rng.h"
+#include <stdint.h>
 #ifdef HAVE_RNGEXTRA_RNGEXTRA_H
 #include "rngextra/rngextra.h"
 #endif
 
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+#include "ruby/ractor.h"
+#endif
+
 /* Global, since used in other source files */
 VALUE cgsl_rng;
 
+/*
+  The seed set by GSL::Rng.default_seed= and the generator returned by
+  GSL::Rng.default belong to the Ractor (to the process before Ruby
+  3.0), so that Ractors neither race on them nor draw from one stream.
+  The default type, and the default seed of a Ractor which has set none,
+  are those of GSL_RNG_TYPE and GSL_RNG_SEED, read once when loaded and
+  again by GSL::Rng.env_setup.
+*/
+enum { RNG_LOCAL_SEED, RNG_LOCAL_DEFAULT, RNG_LOCAL_COUNT };
+
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+static rb_ractor_local_key_t rng_local_key[RNG_LOCAL_COUNT];
+
+static VALUE rb_gsl_rng_local_get(int i)
+{
+  VALUE v;
+  if (!rb_ractor_local_storage_value_lookup(rng_local_key[i], &v)) return Qnil;
+  return v;
+}
+
+static void rb_gsl_rng_local_set(int i, VALUE v)
+{
+  rb_ractor_local_storage_value_set(rng_local_key[i], v);
+}
+#else
+static VALUE rng_local[RNG_LOCAL_COUNT];
+
+static VALUE rb_gsl_rng_local_get(int i)
+{
+  return rng_local[i];
+}
+
+static void rb_gsl_rng_local_set(int i, VALUE v)
+{
+  rng_local[i] = v;
+}
+#endif
+
+static unsigned long rb_gsl_rng_seed(void)
+{
+  VALUE seed = rb_gsl_rng_local_get(RNG_LOCAL_SEED);
+  return NIL_P(seed) ? gsl_rng_default_seed : NUM2ULONG(seed);
+}
+
 enum rb_gsl_rng_generator {
   GSL_RNG_DEFAULT,
   GSL_RNG_MT19937, GSL_RNG_MT19937_1999, GSL_RNG_MT19937_1998, 
@@ -53,6 +102,8 @@ enum rb_gsl_rng_generator {
   GSL_RNGEXTRA_RNG1, GSL_RNGEXTRA_RNG2,
   /* GSL-1.9 */
   GSL_RNG_KNUTHRAN2002,
+  /* rng_bulk.c */
+  GSL_RNG_PHILOX4X32, GSL_RNG_XOSHIRO256SS,
 };
 
 static const gsl_rng_type* get_gsl_rng_type(VALUE t);
@@ -66,14 +117,13 @@ static VALUE rb_gsl_rng_alloc(int argc, VALUE *argv, VALUE klass)
   const gsl_rng_type *T;
   unsigned long seed;
   int itype;
-  gsl_rng_env_setup();
   if (argc == 0) {
     T = gsl_rng_default;
-    seed = gsl_rng_default_seed;
+    seed = rb_gsl_rng_seed();
   } else {
     T = get_gsl_rng_type(argv[0]);    
     if (argc == 1) {
-      seed = gsl_rng_default_seed;
+      seed = rb_gsl_rng_seed();
     } else if (argc == 2) {
       itype = TYPE(argv[1]);
       if (itype == T_FIXNUM || itype == T_BIGNUM) {
@@ -111,6 +161,10 @@ static const gsl_rng_type* get_gsl_rng_type_name(char *name)
 {
   if (str_tail_grep(name, "default") == 0) return gsl_rng_default;
   else if (str_tail_grep(name, "mt19937") == 0) return gsl_rng_mt19937;
+  else if (str_tail_grep(name, "philox4x32") == 0) return mygsl_rng_philox4x32;
+  else if (str_tail_grep(name, "philox") == 0) return mygsl_rng_philox4x32;
+  else if (str_tail_grep(name, "xoshiro256ss") == 0) return mygsl_rng_xoshiro256ss;
+  else if (str_tail_grep(name, "xoshiro256**") == 0) return mygsl_rng_xoshiro256ss;
 #ifdef GSL_1_1_LATER
   else if (str_tail_grep(name, "borosh13") == 0) return gsl_rng_borosh13;
   else if (str_tail_grep(name, "coveyou") == 0) return gsl_rng_coveyou;
@@ -301,6 +355,8 @@ static const gsl_rng_type* get_gsl_rng_type_int(int itype)
 #ifdef GSL_1_9_LATER
   case GSL_RNG_KNUTHRAN2002: T = gsl_rng_knuthran2002; break;
 #endif
+  case GSL_RNG_PHILOX4X32: T = mygsl_rng_philox4x32; break;
+  case GSL_RNG_XOSHIRO256SS: T = mygsl_rng_xoshiro256ss; break;
   default:
     rb_raise(rb_eTypeError, "wrong generator type");
   }
@@ -373,6 +429,8 @@ static void rb_gsl_rng_define_const_type(VALUE module)
   rb_define_const(cgsl_rng, "KNUTHRAN2", INT2FIX(GSL_RNG_KNUTHRAN2));
   rb_define_const(cgsl_rng, "LECUYER21", INT2FIX(GSL_RNG_LECUYER21));
   rb_define_const(cgsl_rng, "WATERMAN14", INT2FIX(GSL_RNG_WATERMAN14));
+  rb_define_const(cgsl_rng, "PHILOX4X32", INT2FIX(GSL_RNG_PHILOX4X32));
+  rb_define_const(cgsl_rng, "XOSHIRO256SS", INT2FIX(GSL_RNG_XOSHIRO256SS));
   rb_define_const(cgsl_rng, "RNGEXTRA_RNG1", INT2FIX(GSL_RNGEXTRA_RNG1));
   rb_define_const(cgsl_rng, "RNGEXTRA_RNG2", INT2FIX(GSL_RNGEXTRA_RNG2));
   rb_define_const(module, "RNGEXTRA_RNG1", INT2FIX(GSL_RNGEXTRA_RNG1));
@@ -383,16 +441,27 @@ static void rb_gsl_rng_define_const_type(VALUE module)
 /* singleton */
 static VALUE rb_gsl_rng_default_seed(VALUE obj)
 {
-  return UINT2NUM(gsl_rng_default_seed);
+  return ULONG2NUM(rb_gsl_rng_seed());
 }
 
 /* singleton */
 static VALUE rb_gsl_rng_set_default_seed(VALUE obj, VALUE seed)
 {
-  gsl_rng_default_seed = NUM2UINT(seed);
+  rb_gsl_rng_local_set(RNG_LOCAL_SEED, ULONG2NUM(NUM2ULONG(seed)));
   return seed;
 }
 
+/* singleton: the generator of this Ractor, allocated on first use */
+static VALUE rb_gsl_rng_default(VALUE obj)
+{
+  VALUE r = rb_gsl_rng_local_get(RNG_LOCAL_DEFAULT);
+  if (NIL_P(r)) {
+    r = rb_gsl_rng_alloc(0, NULL, cgsl_rng);
+    rb_gsl_rng_local_set(RNG_LOCAL_DEFAULT, r);
+  }
+  return r;
+}
+
 static VALUE rb_gsl_rng_set(VALUE obj, VALUE s)
 {
   gsl_rng *r = NULL;
@@ -515,6 +584,7 @@ static VALUE rb_gsl_rng_types_setup(VALUE obj)
 static VALUE rb_gsl_rng_env_setup(VALUE obj)
 {
   gsl_rng_env_setup();
+  rb_gsl_rng_local_set(RNG_LOCAL_SEED, Qnil);
   return obj;
 }
 
@@ -570,10 +640,170 @@ static VALUE rb_gsl_rng_memcpy(VALUE obj, VALUE dst, VALUE org)
   return dst;
 }
 
+/*
+  Independent streams for parallel simulations.
+  GSL generators have no skip-ahead, so stream i of a pool is seeded with
+  a splitmix64 hash of (seed, i). The streams are fully determined by the
+  type, the seed and the stream index, whichever thread consumes them.
+*/
+VALUE cgsl_rng_pool;
+
+unsigned long rb_gsl_rng_stream_seed(unsigned long seed, size_t i)
+{
+  uint64_t z;
+  z = (uint64_t) seed + ((uint64_t) i + 1)*0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+  z ^= (z >> 31);
+  if ((unsigned long) z == 0) return 1;
+  return (unsigned long) z;
+}
+
+static void rb_gsl_rng_pool_mark(rb_gsl_rng_pool *pool)
+{
+  rb_gc_mark(pool->streams);
+}
+
+static void rb_gsl_rng_pool_free(rb_gsl_rng_pool *pool)
+{
+  free((char *) pool->r);
+  free((char *) pool);
+}
+
+static void rb_gsl_rng_pool_seed(rb_gsl_rng_pool *pool, unsigned long seed)
+{
+  size_t i;
+  pool->seed = seed;
+  for (i = 0; i < pool->n; i++)
+    gsl_rng_set(pool->r[i], rb_gsl_rng_stream_seed(seed, i));
+}
+
+static VALUE rb_gsl_rng_pool_make(VALUE klass, const gsl_rng_type *T,
+				  unsigned long seed, size_t n)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  VALUE obj;
+  size_t i;
+  if (n == 0) rb_raise(rb_eArgError, "number of streams must be positive");
+  pool = ALLOC(rb_gsl_rng_pool);
+  pool->n = 0;
+  pool->r = ALLOC_N(gsl_rng*, n);
+  pool->streams = rb_ary_new2(n);
+  obj = Data_Wrap_Struct(klass, rb_gsl_rng_pool_mark, rb_gsl_rng_pool_free, pool);
+  for (i = 0; i < n; i++) {
+    pool->r[i] = gsl_rng_alloc(T);
+    rb_ary_store(pool->streams, i, Data_Wrap_Struct(cgsl_rng, 0, gsl_rng_free, 
+						    pool->r[i]));
+    pool->n = i + 1;
+  }
+  rb_gsl_rng_pool_seed(pool, seed);
+  return obj;
+}
+
+/*
+  Document-method: <i>GSL::Rng::Pool.alloc</i>
+    GSL::Rng::Pool.alloc(type, seed, nstreams)
+*/
+static VALUE rb_gsl_rng_pool_new(VALUE klass, VALUE t, VALUE s, VALUE nn)
+{
+  const gsl_rng_type *T;
+  if (NIL_P(t)) T = gsl_rng_default;
+  else T = get_gsl_rng_type(t);
+  return rb_gsl_rng_pool_make(klass, T, NUM2ULONG(s), NUM2INT(nn));
+}
+
+size_t rb_gsl_rng_pool_get(VALUE obj, gsl_rng ***r)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_rng_pool))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Rng::Pool expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  *r = pool->r;
+  return pool->n;
+}
+
+static VALUE rb_gsl_rng_pool_size(VALUE obj)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  return INT2FIX(pool->n);
+}
+
+static VALUE rb_gsl_rng_pool_get_seed(VALUE obj)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  return ULONG2NUM(pool->seed);
+}
+
+static VALUE rb_gsl_rng_pool_set_seed(VALUE obj, VALUE s)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  rb_gsl_rng_pool_seed(pool, NUM2ULONG(s));
+  return obj;
+}
+
+static VALUE rb_gsl_rng_pool_stream(VALUE obj, VALUE ii)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  int i;
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  i = NUM2INT(ii);
+  if (i < 0) i += pool->n;
+  if (i < 0 || (size_t) i >= pool->n) rb_raise(rb_eIndexError, "index out of range");
+  return rb_ary_entry(pool->streams, i);
+}
+
+static VALUE rb_gsl_rng_pool_to_a(VALUE obj)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  return rb_ary_dup(pool->streams);
+}
+
+static VALUE rb_gsl_rng_pool_each(VALUE obj)
+{
+  rb_gsl_rng_pool *pool = NULL;
+  size_t i;
+  Data_Get_Struct(obj, rb_gsl_rng_pool, pool);
+  for (i = 0; i < pool->n; i++) rb_yield(rb_ary_entry(pool->streams, i));
+  return obj;
+}
+
+/*
+  Document-method: <i>GSL::Rng#split</i>
+    rng.split(n)
+    Returns a GSL::Rng::Pool of n streams of the same type, seeded from
+    the next output of rng.
+*/
+static VALUE rb_gsl_rng_split(VALUE obj, VALUE nn)
+{
+  gsl_rng *r = NULL;
+  unsigned long seed;
+  Data_Get_Struct(obj, gsl_rng, r);
+  seed = gsl_rng_get(r);
+  if (sizeof(unsigned long) > 4) seed = (unsigned long) (((uint64_t) seed << 32) ^ gsl_rng_get(r));
+  return rb_gsl_rng_pool_make(cgsl_rng_pool, r->type, seed, NUM2INT(nn));
+}
+
+void Init_gsl_rng_bulk(VALUE module);
 void Init_gsl_rng(VALUE module)
 {
+  int i;
   cgsl_rng = rb_define_class_under(module, "Rng", cGSL_Object);
 
+  gsl_rng_env_setup();
+  for (i = 0; i < RNG_LOCAL_COUNT; i++) {
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+    rng_local_key[i] = rb_ractor_local_storage_value_newkey();
+#else
+    rng_local[i] = Qnil;
+    rb_global_variable(&rng_local[i]);
+#endif
+  }
+
   rb_gsl_rng_define_const_type(module);
   
   rb_define_singleton_method(cgsl_rng, "alloc", rb_gsl_rng_alloc, -1);
@@ -581,6 +811,7 @@ void Init_gsl_rng(VALUE module)
   rb_define_singleton_method(cgsl_rng, "default_seed", rb_gsl_rng_default_seed, 0);
   rb_define_singleton_method(cgsl_rng, "set_default_seed", rb_gsl_rng_set_default_seed, 1);
   rb_define_singleton_method(cgsl_rng, "default_seed=", rb_gsl_rng_set_default_seed, 1);
+  rb_define_singleton_method(cgsl_rng, "default", rb_gsl_rng_default, 0);
 
   rb_define_method(cgsl_rng, "set", rb_gsl_rng_set, 1);
   rb_define_alias(cgsl_rng, "set_seed", "set");
@@ -609,4 +840,21 @@ void Init_gsl_rng(VALUE module)
   rb_define_method(cgsl_rng, "fread", rb_gsl_rng_fread, 1);
 #endif
   rb_define_singleton_method(cgsl_rng, "memcpy", rb_gsl_rng_memcpy, 2);
+  rb_define_method(cgsl_rng, "split", rb_gsl_rng_split, 1);
+
+  cgsl_rng_pool = rb_define_class_under(cgsl_rng, "Pool", cGSL_Object);
+  rb_define_singleton_method(cgsl_rng_pool, "alloc", rb_gsl_rng_pool_new, 3);
+  rb_define_singleton_method(cgsl_rng_pool, "new", rb_gsl_rng_pool_new, 3);
+  rb_include_module(cgsl_rng_pool, rb_mEnumerable);
+  rb_define_method(cgsl_rng_pool, "size", rb_gsl_rng_pool_size, 0);
+  rb_define_alias(cgsl_rng_pool, "length", "size");
+  rb_define_method(cgsl_rng_pool, "seed", rb_gsl_rng_pool_get_seed, 0);
+  rb_define_method(cgsl_rng_pool, "set", rb_gsl_rng_pool_set_seed, 1);
+  rb_define_alias(cgsl_rng_pool, "seed=", "set");
+  rb_define_method(cgsl_rng_pool, "[]", rb_gsl_rng_pool_stream, 1);
+  rb_define_alias(cgsl_rng_pool, "stream", "[]");
+  rb_define_method(cgsl_rng_pool, "to_a", rb_gsl_rng_pool_to_a, 0);
+  rb_define_method(cgsl_rng_pool, "each", rb_gsl_rng_pool_each, 0);
+
+  Init_gsl_rng_bulk(module);
 }
@@ -0,0 +1,349 @@
+/*
+  rng_bulk.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Two generator types besides those of GSL, and bulk fills for all.
+
+    r = GSL::Rng.alloc("philox4x32", seed)
+    r = GSL::Rng.alloc("xoshiro256ss", seed)
+    r.fill_uniform(v)          # v[i] = r.uniform, in order
+    r.fill_gaussian(v, sigma)  # Box-Muller on the uniforms
+    r.jump                     # to a far, non-overlapping part of the stream
+
+  philox4x32 is Philox4x32-10 (Salmon et al., SC 2011): output block i
+  is a 10-round bijection of the 128-bit counter i under the 64-bit
+  key = seed, so that blocks are independent of each other.  Bulk fills
+  compute PHILOX_LANES blocks side by side, in a loop the compiler
+  vectorizes, and give the very numbers of successive gets.  jump adds
+  2^64 to the counter.
+
+  xoshiro256ss is xoshiro256** (Blackman and Vigna, 2018), a 256-bit
+  state seeded by splitmix64; uniform doubles use the top 53 bits of its
+  64-bit outputs, get the top 32.  jump advances it by 2^128 outputs.
+
+  Both have max = 2^32 - 1, as the 32-bit generators of GSL.  The fills
+  of other generators call gsl_rng_uniform in a loop, without the GVL
+  for long vectors.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_rng.h"
+#include <stdint.h>
+
+#ifdef HAVE_ATTRIBUTE_TARGET_CLONES
+#define RNG_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define RNG_CLONES
+#endif
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+#define PHILOX_LANES 16
+
+typedef struct {
+  uint32_t ctr[4], key[2];
+  uint32_t out[4];
+  unsigned int idx;
+} philox_state;
+
+/* the 10 rounds on one block */
+static void philox_block(uint32_t x[4], uint32_t k0, uint32_t k1)
+{
+  uint64_t p0, p1;
+  int r;
+  for (r = 0; r < 10; r++) {
+    p0 = (uint64_t) PHILOX_M0*x[0];
+    p1 = (uint64_t) PHILOX_M1*x[2];
+    x[0] = (uint32_t) (p1 >> 32) ^ x[1] ^ k0;
+    x[1] = (uint32_t) p1;
+    x[2] = (uint32_t) (p0 >> 32) ^ x[3] ^ k1;
+    x[3] = (uint32_t) p0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+
+/* the same on PHILOX_LANES blocks x[0..3][j], a fixed trip count for
+   the vectorizer */
+RNG_CLONES
+static void philox_lanes(uint32_t x[4][PHILOX_LANES], uint32_t k0, uint32_t k1)
+{
+  uint64_t p0, p1;
+  uint32_t y0, y2;
+  size_t j;
+  int r;
+  for (r = 0; r < 10; r++) {
+    for (j = 0; j < PHILOX_LANES; j++) {
+      p0 = (uint64_t) PHILOX_M0*x[0][j];
+      p1 = (uint64_t) PHILOX_M1*x[2][j];
+      y0 = (uint32_t) (p1 >> 32) ^ x[1][j] ^ k0;
+      y2 = (uint32_t) (p0 >> 32) ^ x[3][j] ^ k1;
+      x[0][j] = y0;
+      x[1][j] = (uint32_t) p1;
+      x[2][j] = y2;
+      x[3][j] = (uint32_t) p0;
+    }
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+
+/* counter c + n, with carries through the 128 bits */
+static void philox_ctr_add(const uint32_t *c, uint64_t n, uint32_t *d)
+{
+  uint64_t lo = ((uint64_t) c[1] << 32 | c[0]) + n;
+  uint64_t hi = (uint64_t) c[3] << 32 | c[2];
+  if (lo < n) hi++;
+  d[0] = (uint32_t) lo; d[1] = (uint32_t) (lo >> 32);
+  d[2] = (uint32_t) hi; d[3] = (uint32_t) (hi >> 32);
+}
+
+static void philox_next_block(philox_state *s)
+{
+  memcpy(s->out, s->ctr, sizeof(s->out));
+  philox_block(s->out, s->key[0], s->key[1]);
+  philox_ctr_add(s->ctr, 1, s->ctr);
+  s->idx = 0;
+}
+
+static void philox_set(void *vstate, unsigned long seed)
+{
+  philox_state *s = (philox_state *) vstate;
+  uint64_t k = (uint64_t) seed;
+  memset(s, 0, sizeof(philox_state));
+  s->key[0] = (uint32_t) k;
+  s->key[1] = (uint32_t) (k >> 32);
+  s->idx = 4;
+}
+
+static unsigned long philox_get(void *vstate)
+{
+  philox_state *s = (philox_state *) vstate;
+  if (s->idx == 4) philox_next_block(s);
+  return s->out[s->idx++];
+}
+
+static double philox_get_double(void *vstate)
+{
+  return philox_get(vstate)/4294967296.0;
+}
+
+static const gsl_rng_type philox4x32_type = {
+  "philox4x32", 0xffffffffUL, 0, sizeof(philox_state),
+  philox_set, philox_get, philox_get_double
+};
+
+const gsl_rng_type *mygsl_rng_philox4x32 = &philox4x32_type;
+
+static void philox_fill(philox_state *s, double *x, size_t n)
+{
+  uint32_t b[4][PHILOX_LANES];
+  size_t i = 0, j;
+  int w;
+  while (i < n && s->idx < 4) x[i++] = s->out[s->idx++]/4294967296.0;
+  while (n - i >= 4*PHILOX_LANES) {
+    for (j = 0; j < PHILOX_LANES; j++) {
+      uint32_t c[4];
+      philox_ctr_add(s->ctr, j, c);
+      for (w = 0; w < 4; w++) b[w][j] = c[w];
+    }
+    philox_lanes(b, s->key[0], s->key[1]);
+    for (j = 0; j < PHILOX_LANES; j++)
+      for (w = 0; w < 4; w++) x[i + 4*j + w] = b[w][j]/4294967296.0;
+    philox_ctr_add(s->ctr, PHILOX_LANES, s->ctr);
+    i += 4*PHILOX_LANES;
+  }
+  for (; i < n; i++) x[i] = philox_get_double(s);
+}
+
+typedef struct {
+  uint64_t s[4];
+} xoshiro_state;
+
+static uint64_t xoshiro_rotl(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t xoshiro_next(xoshiro_state *st)
+{
+  uint64_t *s = st->s;
+  uint64_t result = xoshiro_rotl(s[1]*5, 7)*9, t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = xoshiro_rotl(s[3], 45);
+  return result;
+}
+
+static void xoshiro_set(void *vstate, unsigned long seed)
+{
+  xoshiro_state *st = (xoshiro_state *) vstate;
+  uint64_t z, x = (uint64_t) seed;
+  int i;
+  for (i = 0; i < 4; i++) {
+    z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    st->s[i] = z ^ (z >> 31);
+  }
+}
+
+static unsigned long xoshiro_get(void *vstate)
+{
+  return (unsigned long) (xoshiro_next((xoshiro_state *) vstate) >> 32);
+}
+
+static double xoshiro_get_double(void *vstate)
+{
+  return (xoshiro_next((xoshiro_state *) vstate) >> 11)*(1.0/9007199254740992.0);
+}
+
+static const gsl_rng_type xoshiro256ss_type = {
+  "xoshiro256ss", 0xffffffffUL, 0, sizeof(xoshiro_state),
+  xoshiro_set, xoshiro_get, xoshiro_get_double
+};
+
+const gsl_rng_type *mygsl_rng_xoshiro256ss = &xoshiro256ss_type;
+
+static void xoshiro_fill(xoshiro_state *st, double *x, size_t n)
+{
+  xoshiro_state s = *st;
+  size_t i;
+  for (i = 0; i < n; i++) x[i] = (xoshiro_next(&s) >> 11)*(1.0/9007199254740992.0);
+  *st = s;
+}
+
+static void xoshiro_jump(xoshiro_state *st)
+{
+  static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+				   0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+  uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  int i, b;
+  for (i = 0; i < 4; i++)
+    for (b = 0; b < 64; b++) {
+      if (JUMP[i] & ((uint64_t) 1 << b)) {
+	s0 ^= st->s[0]; s1 ^= st->s[1]; s2 ^= st->s[2]; s3 ^= st->s[3];
+      }
+      xoshiro_next(st);
+    }
+  st->s[0] = s0; st->s[1] = s1; st->s[2] = s2; st->s[3] = s3;
+}
+
+/* n uniforms of r, in order, at x */
+static void rng_uniforms(gsl_rng *r, double *x, size_t n)
+{
+  size_t i;
+  if (r->type == &philox4x32_type) philox_fill((philox_state *) r->state, x, n);
+  else if (r->type == &xoshiro256ss_type) xoshiro_fill((xoshiro_state *) r->state, x, n);
+  else for (i = 0; i < n; i++) x[i] = gsl_rng_uniform(r);
+}
+
+/* Box-Muller, in place, on pairs of uniforms */
+static void rng_box_muller(double *x, size_t n, double sigma)
+{
+  double rad, t;
+  size_t i;
+  for (i = 0; i + 1 < n; i += 2) {
+    rad = sigma*sqrt(-2.0*log(1.0 - x[i]));
+    t = 2.0*M_PI*x[i+1];
+    x[i] = rad*cos(t);
+    x[i+1] = rad*sin(t);
+  }
+}
+
+#define RNG_CHUNK 512
+struct rng_fill_data {
+  gsl_rng *r;
+  gsl_vector *v;
+  int gaussian;
+  double sigma;
+};
+
+static int rng_fill_nogvl(void *data)
+{
+  struct rng_fill_data *d = (struct rng_fill_data *) data;
+  double buf[RNG_CHUNK + 1], *x;
+  size_t i, j, m, n = d->v->size, stride = d->v->stride;
+  for (i = 0; i < n; i += m) {
+    m = GSL_MIN(RNG_CHUNK, n - i);
+    x = stride == 1 ? d->v->data + i : buf;
+    if (d->gaussian && m % 2) {
+      /* the odd tail takes a pair, of which one is kept */
+      rng_uniforms(d->r, buf, m + 1);
+      rng_box_muller(buf, m + 1, d->sigma);
+      x = buf;
+    } else {
+      rng_uniforms(d->r, x, m);
+      if (d->gaussian) rng_box_muller(x, m, d->sigma);
+    }
+    if (x != d->v->data + i)
+      for (j = 0; j < m; j++) d->v->data[(i + j)*stride] = x[j];
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_rng_fill(VALUE obj, VALUE vv, int gaussian, double sigma)
+{
+  struct rng_fill_data d;
+  CHECK_VECTOR(vv);
+  rb_check_frozen(vv);
+  Data_Get_Struct(obj, gsl_rng, d.r);
+  Data_Get_Struct(vv, gsl_vector, d.v);
+  d.gaussian = gaussian;
+  d.sigma = sigma;
+  rb_gsl_nogvl_call(rng_fill_nogvl, &d, d.v->size*(gaussian ? 8 : 1));
+  return vv;
+}
+
+/* rng.fill_uniform(v): v[i] = rng.uniform for i = 0 ... v.size */
+static VALUE rb_gsl_rng_fill_uniform(VALUE obj, VALUE vv)
+{
+  return rb_gsl_rng_fill(obj, vv, 0, 1.0);
+}
+
+/* rng.fill_gaussian(v, sigma = 1) */
+static VALUE rb_gsl_rng_fill_gaussian(int argc, VALUE *argv, VALUE obj)
+{
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  return rb_gsl_rng_fill(obj, argv[0], 1, argc == 2 ? NUM2DBL(argv[1]) : 1.0);
+}
+
+/* rng.jump: for philox4x32 and xoshiro256ss */
+static VALUE rb_gsl_rng_jump(VALUE obj)
+{
+  gsl_rng *r;
+  philox_state *s;
+  Data_Get_Struct(obj, gsl_rng, r);
+  if (r->type == &philox4x32_type) {
+    s = (philox_state *) r->state;
+    if (++s->ctr[2] == 0) s->ctr[3]++;
+    s->idx = 4;
+  } else if (r->type == &xoshiro256ss_type) {
+    xoshiro_jump((xoshiro_state *) r->state);
+  } else {
+    rb_raise(rb_eNotImpError, "jump is not available for %s", gsl_rng_name(r));
+  }
+  return obj;
+}
+
+void Init_gsl_rng_bulk(VALUE module)
+{
+  rb_define_method(cgsl_rng, "fill_uniform", rb_gsl_rng_fill_uniform, 1);
+  rb_define_method(cgsl_rng, "fill_gaussian", rb_gsl_rng_fill_gaussian, -1);
+  rb_define_method(cgsl_rng, "jump", rb_gsl_rng_jump, 0);
+}
@@ -389,6 +389,8 @@ void Init_gsl_root(VALUE module)
   rb_define_method(cgsl_fdfsolver, "name", rb_gsl_fdfsolver_name, 0);  
   rb_define_method(cgsl_fdfsolver, "solve", rb_gsl_fdfsolver_solve, -1);  
 
+  Init_gsl_root_batch(mgsl_root);
+
   rb_define_method(cgsl_function, "fsolve", rb_gsl_function_rootfinder, -1);
   rb_define_alias(cgsl_function, "solve", "fsolve");
 
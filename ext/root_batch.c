@@ -0,0 +1,497 @@
+/*
+  root_batch.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Many independent scalar equations f(x; p[i]) = 0, i = 0 ... n-1,
+  solved element by element in C.
+
+    f = GSL::Function.compile("x**3 - a*x - b", "a" => 0, "b" => 0)
+    p = GSL::Matrix[[1, 1], [2, 3], ...]           # one row (a, b) per equation
+    root, status, iter = GSL::Root.fsolve_batch(f, lower, upper, :params => p)
+
+    df = GSL::Function.compile("3*x**2 - a", "a" => 0, "b" => 0)
+    root, status, iter = GSL::Root.fdfsolve_batch(f, df, x0, :params => p)
+
+  fsolve_batch runs Brent's method (as gsl_root_fsolver_brent) on the
+  brackets [lower[i], upper[i]] until gsl_root_test_interval succeeds;
+  fdfsolve_batch runs Newton's method from x0[i] until
+  gsl_root_test_delta succeeds.  The bounds and starting points are
+  Vectors, Arrays, or Numerics shared by all the elements.
+
+  For a GSL::Function::Compiled, the columns of the Matrix :params are the
+  values of its parameters (in the order of compile) for each element;
+  the elements are then solved without the GVL, split over
+  GSL.parallel_threads.  Other integrands are called once per iteration
+  for all the elements still running: a GSL::Function (vectorized ones
+  with a Vector of points) or anything responding to call, given the
+  Vector x of points and the GSL::Vector::Int of the element indices and
+  returning a Vector or an Array of f (and for fdfsolve_batch, df) values.
+
+  Options :epsabs (0), :epsrel (1e-6), :max_iter (100) and :params.
+  Returns the Vector of roots, and GSL::Vector::Int of the statuses
+  (GSL::SUCCESS, GSL::EMAXITER, GSL::EINVAL for a bracket not
+  straddling the root, GSL::EBADFUNC for a non finite value,
+  GSL::EZERODIV for a zero derivative) and of the iteration counts.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_function.h"
+#include "rb_gsl_root.h"
+
+#define ROOTB_BLOCK 64
+#define ROOTB_RUNNING (-1)
+
+/* The state of gsl_root_fsolver_brent, or the iterate of Newton's method in x */
+typedef struct {
+  double a, b, c, d, e, fa, fb, fc;
+  double x, xl, xu;
+  int status, iter;
+} rootb_state;
+
+typedef struct {
+  int newton;
+  size_t n, max_iter;
+  double epsabs, epsrel;
+  VALUE f, df;
+  gsl_function *F, *DF;
+  void *cf, *cdf;               /* compiled functions */
+  const double *param;          /* n x tda */
+  size_t tda;
+  rootb_state *s;
+  size_t nthreads;
+} mygsl_rootb;
+
+static void mygsl_rootb_mark(mygsl_rootb *w)
+{
+  rb_gc_mark(w->f);
+  rb_gc_mark(w->df);
+}
+
+static void mygsl_rootb_free(mygsl_rootb *w)
+{
+  xfree(w->s);
+  xfree(w);
+}
+
+/* Brent: starts from the values at the bracket */
+static void rootb_brent_init(rootb_state *s, double flo, double fhi)
+{
+  s->fa = flo;
+  s->fb = s->fc = fhi;
+  s->c = s->b;
+  s->d = s->e = s->b - s->a;
+  s->x = 0.5*(s->a + s->b);
+  s->xl = s->a;
+  s->xu = s->b;
+  if (!gsl_finite(flo) || !gsl_finite(fhi)) s->status = GSL_EBADFUNC;
+  else if ((flo < 0.0 && fhi < 0.0) || (flo > 0.0 && fhi > 0.0)) s->status = GSL_EINVAL;
+  else s->status = ROOTB_RUNNING;
+}
+
+/* The first half of brent_iterate(): the next point to evaluate in *x,
+   or 0 when converged */
+static int rootb_brent_next(rootb_state *s, double *x)
+{
+  double tol, m, p, q, r, sr;
+  int ac_equal = 0;
+  double a = s->a, b = s->b, c = s->c, fa = s->fa, fb = s->fb, fc = s->fc;
+  double d = s->d, e = s->e;
+  if ((fb < 0 && fc < 0) || (fb > 0 && fc > 0)) {
+    ac_equal = 1;
+    c = a;
+    fc = fa;
+    d = b - a;
+    e = b - a;
+  }
+  if (fabs(fc) < fabs(fb)) {
+    ac_equal = 1;
+    a = b;
+    b = c;
+    c = a;
+    fa = fb;
+    fb = fc;
+    fc = fa;
+  }
+  tol = 0.5*GSL_DBL_EPSILON*fabs(b);
+  m = 0.5*(c - b);
+  if (fb == 0 || fabs(m) <= tol) {
+    s->x = b;
+    s->xl = GSL_MIN(b, c);
+    s->xu = GSL_MAX(b, c);
+    if (fb == 0) s->xl = s->xu = b;
+    s->status = GSL_SUCCESS;
+    return 0;
+  }
+  if (fabs(e) < tol || fabs(fa) <= fabs(fb)) {
+    d = m;
+    e = m;
+  } else {
+    sr = fb/fa;
+    if (ac_equal) {
+      p = 2*m*sr;
+      q = 1 - sr;
+    } else {
+      q = fa/fc;
+      r = fb/fc;
+      p = sr*(2*m*q*(q - r) - (b - a)*(r - 1));
+      q = (q - 1)*(r - 1)*(sr - 1);
+    }
+    if (p > 0) q = -q;
+    else p = -p;
+    if (2*p < GSL_MIN(3*m*q - fabs(tol*q), fabs(e*q))) {
+      e = d;
+      d = p/q;
+    } else {
+      d = m;
+      e = m;
+    }
+  }
+  a = b;
+  fa = fb;
+  if (fabs(d) > tol) b += d;
+  else b += (m > 0 ? +tol : -tol);
+  s->a = a;
+  s->b = b;
+  s->c = c;
+  s->d = d;
+  s->e = e;
+  s->fa = fa;
+  s->fc = fc;
+  *x = b;
+  return 1;
+}
+
+/* The second half: f(b) = fb, then the interval test */
+static void rootb_brent_set(const mygsl_rootb *w, rootb_state *s, double fb)
+{
+  double c = s->c;
+  s->fb = fb;
+  s->x = s->b;
+  s->iter++;
+  if (!gsl_finite(fb)) {
+    s->status = GSL_EBADFUNC;
+    return;
+  }
+  if ((fb < 0 && s->fc < 0) || (fb > 0 && s->fc > 0)) c = s->a;
+  s->xl = GSL_MIN(s->b, c);
+  s->xu = GSL_MAX(s->b, c);
+  if (gsl_root_test_interval(s->xl, s->xu, w->epsabs, w->epsrel) == GSL_SUCCESS)
+    s->status = GSL_SUCCESS;
+  else if ((size_t) s->iter >= w->max_iter)
+    s->status = GSL_EMAXITER;
+}
+
+/* Newton: x -> x - f(x)/df(x) */
+static void rootb_newton_set(const mygsl_rootb *w, rootb_state *s, double f, double df)
+{
+  double x0 = s->x;
+  s->iter++;
+  if (!gsl_finite(f) || !gsl_finite(df)) {
+    s->status = GSL_EBADFUNC;
+    return;
+  }
+  if (df == 0.0) {
+    s->status = GSL_EZERODIV;
+    return;
+  }
+  s->x = x0 - f/df;
+  if (gsl_root_test_delta(s->x, x0, w->epsabs, w->epsrel) == GSL_SUCCESS)
+    s->status = GSL_SUCCESS;
+  else if ((size_t) s->iter >= w->max_iter)
+    s->status = GSL_EMAXITER;
+}
+
+/*
+  Compiled functions: each element solved to the end in turn
+*/
+static double rootb_eval(const mygsl_rootb *w, void *c, size_t i, double x)
+{
+  if (w->param) return rb_gsl_function_compiled_eval_params(c, &x, w->param + i*w->tda);
+  return rb_gsl_function_compiled_eval_multi(c, &x);
+}
+
+static void rootb_solve(const mygsl_rootb *w, size_t i)
+{
+  rootb_state *s = w->s + i;
+  double x;
+  if (s->status != ROOTB_RUNNING) return;
+  if (w->newton) {
+    while (s->status == ROOTB_RUNNING)
+      rootb_newton_set(w, s, rootb_eval(w, w->cf, i, s->x), rootb_eval(w, w->cdf, i, s->x));
+    return;
+  }
+  rootb_brent_init(s, rootb_eval(w, w->cf, i, s->a), rootb_eval(w, w->cf, i, s->b));
+  while (s->status == ROOTB_RUNNING) {
+    if (!rootb_brent_next(s, &x)) break;
+    rootb_brent_set(w, s, rootb_eval(w, w->cf, i, x));
+  }
+}
+
+static int rootb_worker(void *data, size_t id)
+{
+  mygsl_rootb *w = (mygsl_rootb *) data;
+  size_t b, i;
+  for (b = id*ROOTB_BLOCK; b < w->n; b += w->nthreads*ROOTB_BLOCK) {
+    for (i = b; i < GSL_MIN(b + ROOTB_BLOCK, w->n); i++) rootb_solve(w, i);
+  }
+  return GSL_SUCCESS;
+}
+
+static int rootb_serial(void *data)
+{
+  mygsl_rootb *w = (mygsl_rootb *) data;
+  size_t i;
+  for (i = 0; i < w->n; i++) rootb_solve(w, i);
+  return GSL_SUCCESS;
+}
+
+/*
+  Ruby integrands: all the running elements advance together
+*/
+
+/* y[j] = f(x[j]) for the elements idx[0 ... m-1] */
+static void rootb_call(VALUE f, gsl_function *F, VALUE vx, VALUE vidx, size_t m, double *y)
+{
+  gsl_vector *x = NULL, *vy = NULL;
+  gsl_vector_int *idx = NULL;
+  VALUE v;
+  size_t j;
+  if (m == 0) return;
+  Data_Get_Struct(vx, gsl_vector, x);
+  Data_Get_Struct(vidx, gsl_vector_int, idx);
+  if (F) {
+    rb_gsl_function_eval_array(F, x->data, y, m);
+    return;
+  }
+  x->size = m;
+  idx->size = m;
+  v = rb_funcall(f, RBGSL_ID_call, 2, vx, vidx);
+  if (VECTOR_P(v)) {
+    Data_Get_Vector(v, vy);
+    if (vy->size != m) goto size_error;
+    for (j = 0; j < m; j++) y[j] = gsl_vector_get(vy, j);
+  } else {
+    Check_Type(v, T_ARRAY);
+    if ((size_t) RARRAY_LEN(v) != m) goto size_error;
+    for (j = 0; j < m; j++) y[j] = NUM2DBL(rb_ary_entry(v, j));
+  }
+  return;
+ size_error:
+  rb_raise(rb_eRuntimeError, "function returned %d values (%d expected)",
+	   (int) (VECTOR_P(v) ? vy->size : (size_t) RARRAY_LEN(v)), (int) m);
+}
+
+static void rootb_run_ruby(mygsl_rootb *w)
+{
+  gsl_vector *x, *y;
+  gsl_vector_int *idx;
+  VALUE vx, vy, vidx;
+  rootb_state *s;
+  size_t i, j, m, n = w->n;
+  double *fy, *dfy;
+  x = gsl_vector_alloc(n);
+  vx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+  y = gsl_vector_alloc(2*n);
+  vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+  idx = gsl_vector_int_alloc(n);
+  vidx = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, idx);
+  fy = y->data;
+  dfy = y->data + n;
+  if (!w->newton) {
+    for (i = 0; i < n; i++) {
+      x->data[i] = w->s[i].a;
+      idx->data[i] = i;
+    }
+    rootb_call(w->f, w->F, vx, vidx, n, fy);
+    for (i = 0; i < n; i++) x->data[i] = w->s[i].b;
+    rootb_call(w->f, w->F, vx, vidx, n, dfy);
+    for (i = 0; i < n; i++) {
+      if (w->s[i].status == ROOTB_RUNNING) rootb_brent_init(w->s + i, fy[i], dfy[i]);
+    }
+  }
+  for (;;) {
+    x->size = idx->size = n;
+    for (i = 0, m = 0; i < n; i++) {
+      s = w->s + i;
+      if (s->status != ROOTB_RUNNING) continue;
+      if (w->newton) x->data[m] = s->x;
+      else if (!rootb_brent_next(s, x->data + m)) continue;
+      idx->data[m++] = i;
+    }
+    if (m == 0) break;
+    rootb_call(w->f, w->F, vx, vidx, m, fy);
+    if (w->newton) {
+      x->size = idx->size = n;
+      rootb_call(w->df, w->DF, vx, vidx, m, dfy);
+    }
+    for (j = 0; j < m; j++) {
+      s = w->s + idx->data[j];
+      if (w->newton) rootb_newton_set(w, s, fy[j], dfy[j]);
+      else rootb_brent_set(w, s, fy[j]);
+    }
+  }
+  x->size = idx->size = n;
+  RB_GC_GUARD(vx);
+  RB_GC_GUARD(vy);
+  RB_GC_GUARD(vidx);
+}
+
+/* The number of elements given by v: 0 for a Numeric */
+static size_t rootb_size(VALUE v)
+{
+  gsl_vector *vv = NULL;
+  if (rb_obj_is_kind_of(v, rb_cNumeric)) return 0;
+  if (TYPE(v) == T_ARRAY) return RARRAY_LEN(v);
+  CHECK_VECTOR(v);
+  Data_Get_Vector(v, vv);
+  return vv->size;
+}
+
+/* Stores the values of v in the member at x of each of the n states */
+static void rootb_values(VALUE v, size_t n, double *x)
+{
+  const size_t stride = sizeof(rootb_state);
+  gsl_vector *vv = NULL;
+  double d;
+  size_t i, m = rootb_size(v);
+  if (m == 0) {
+    d = NUM2DBL(v);
+    for (i = 0; i < n; i++) *(double *) ((char *) x + i*stride) = d;
+    return;
+  }
+  if (m != n) rb_raise(rb_eArgError, "%d values for %d elements", (int) m, (int) n);
+  if (TYPE(v) == T_ARRAY) {
+    for (i = 0; i < n; i++) *(double *) ((char *) x + i*stride) = NUM2DBL(rb_ary_entry(v, i));
+    return;
+  }
+  Data_Get_Vector(v, vv);
+  for (i = 0; i < n; i++) *(double *) ((char *) x + i*stride) = gsl_vector_get(vv, i);
+}
+
+/* A compiled function, a GSL::Function or a callable */
+static void rootb_function(mygsl_rootb *w, VALUE f, gsl_function **F, void **c)
+{
+  if (rb_obj_is_kind_of(f, cgsl_function_compiled)) {
+    *c = rb_gsl_function_compiled_ptr(f);
+    if (w->param && rb_gsl_function_compiled_nparam(*c) != w->tda)
+      rb_raise(rb_eArgError, "%d columns of parameters for a function of %d parameters",
+	       (int) w->tda, (int) rb_gsl_function_compiled_nparam(*c));
+  } else if (rb_obj_is_kind_of(f, cgsl_function)) {
+    Data_Get_Struct(f, gsl_function, *F);
+  } else if (!rb_respond_to(f, RBGSL_ID_call)) {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Function or callable expected)",
+	     rb_class2name(CLASS_OF(f)));
+  }
+}
+
+static VALUE rb_gsl_root_solve_batch(VALUE f, VALUE df, VALUE lo, VALUE hi, VALUE opts)
+{
+  mygsl_rootb *w = NULL;
+  gsl_matrix *p = NULL;
+  gsl_vector *root;
+  gsl_vector_int *status, *iter;
+  rootb_state *s;
+  size_t i, n;
+  VALUE obj, v, vp = Qnil;
+  obj = Data_Make_Struct(0, mygsl_rootb, mygsl_rootb_mark, mygsl_rootb_free, w);
+  w->f = f;
+  w->df = df;
+  w->newton = !NIL_P(df);
+  w->epsabs = 0.0;
+  w->epsrel = 1e-6;
+  w->max_iter = 100;
+  if (!NIL_P(opts)) {
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsabs"))))) w->epsabs = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("epsrel"))))) w->epsrel = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_iter"))))) w->max_iter = NUM2SIZET(v);
+    vp = rb_hash_aref(opts, ID2SYM(rb_intern("params")));
+  }
+  if (w->max_iter == 0) rb_raise(rb_eArgError, "max_iter must be positive");
+  n = GSL_MAX(rootb_size(lo), NIL_P(hi) ? 0 : rootb_size(hi));
+  if (!NIL_P(vp)) {
+    CHECK_MATRIX(vp);
+    Data_Get_Struct(vp, gsl_matrix, p);
+    if (n == 0) n = p->size1;
+    if (p->size1 != n)
+      rb_raise(rb_eArgError, "%d rows of parameters for %d elements", (int) p->size1, (int) n);
+    w->param = p->data;
+    w->tda = p->size2;
+    if (p->tda != p->size2)
+      rb_raise(rb_eArgError, "the parameter matrix must be contiguous");
+  }
+  if (n == 0) n = 1;
+  w->n = n;
+  rootb_function(w, f, &w->F, &w->cf);
+  if (w->newton) rootb_function(w, df, &w->DF, &w->cdf);
+  if (w->param && (!w->cf || (w->newton && !w->cdf)))
+    rb_raise(rb_eArgError, "parameters are for compiled functions");
+  w->s = ALLOC_N(rootb_state, n);
+  memset(w->s, 0, sizeof(rootb_state)*n);
+  if (w->newton) {
+    rootb_values(lo, n, &w->s[0].x);
+  } else {
+    rootb_values(lo, n, &w->s[0].a);
+    rootb_values(hi, n, &w->s[0].b);
+  }
+  for (i = 0; i < n; i++) {
+    s = w->s + i;
+    s->status = ROOTB_RUNNING;
+    if (!w->newton && s->a > s->b) s->status = GSL_EINVAL;
+  }
+  if (w->cf && (!w->newton || w->cdf)) {
+    w->nthreads = rb_gsl_parallel_nthreads(n*w->max_iter, (n + ROOTB_BLOCK - 1)/ROOTB_BLOCK);
+    if (w->nthreads > 1) rb_gsl_nogvl_parallel(rootb_worker, w, w->nthreads);
+    else rb_gsl_nogvl_call(rootb_serial, w, n*w->max_iter);
+  } else {
+    if (w->cf) w->F = (gsl_function *) w->cf;
+    if (w->cdf) w->DF = (gsl_function *) w->cdf;
+    rootb_run_ruby(w);
+  }
+  root = gsl_vector_alloc(n);
+  status = gsl_vector_int_alloc(n);
+  iter = gsl_vector_int_alloc(n);
+  for (i = 0; i < n; i++) {
+    root->data[i] = w->s[i].x;
+    status->data[i] = w->s[i].status;
+    iter->data[i] = w->s[i].iter;
+  }
+  v = rb_ary_new3(3, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, root),
+		  Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, status),
+		  Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, iter));
+  RB_GC_GUARD(obj);
+  RB_GC_GUARD(vp);
+  return v;
+}
+
+/* GSL::Root.fsolve_batch(f, lower, upper[, opts]) */
+static VALUE rb_gsl_root_fsolve_batch(int argc, VALUE *argv, VALUE module)
+{
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  return rb_gsl_root_solve_batch(argv[0], Qnil, argv[1], argv[2], argc == 4 ? argv[3] : Qnil);
+}
+
+/* GSL::Root.fdfsolve_batch(f, df, x0[, opts]) */
+static VALUE rb_gsl_root_fdfsolve_batch(int argc, VALUE *argv, VALUE module)
+{
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  if (NIL_P(argv[1])) rb_raise(rb_eArgError, "derivative expected");
+  return rb_gsl_root_solve_batch(argv[0], argv[1], argv[2], Qnil, argc == 4 ? argv[3] : Qnil);
+}
+
+void Init_gsl_root_batch(VALUE mgsl_root)
+{
+  rb_define_module_function(mgsl_root, "fsolve_batch", rb_gsl_root_fsolve_batch, -1);
+  rb_define_module_function(mgsl_root, "fdfsolve_batch", rb_gsl_root_fdfsolve_batch, -1);
+}
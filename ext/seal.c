@@ -0,0 +1,365 @@
+/*
+  seal.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL.seal(obj, ...): freezes the objects and moves their numeric data
+  into one anonymous memory mapping, which is then made read-only.  This
+  is meant for the tables a preforking server (Unicorn, Puma in cluster
+  mode) loads in its master: nothing else lives in the pages of the
+  mapping, so that nothing writes them after the fork, and they stay
+  shared by all the workers instead of being copied one by one as the
+  heap around them is touched.  A stray write faults instead of copying
+  a page.
+
+    TABLE = GSL::Matrix.alloc(4096, 4096)   # filled by the master
+    CURVE = GSL::Spline.alloc(x, y)
+    GSL.seal(TABLE, CURVE)
+    # fork the workers
+
+  Sealed are Vector and Matrix (double, int and complex) which own their
+  data, Spline (the knots; the coefficients stay in the private state of
+  the interpolation type) and Histogram (the ranges and the bins).  The
+  data of each object starts on a 64-byte boundary, as in the records of
+  memory.c.  The objects stay on the Ruby heap and keep small records of
+  their own, outside the mapping, which is unmapped when the last of its
+  objects is collected.
+
+  Views and shared clones taken before sealing point into the old data,
+  which is released: take them afterwards.  A view of a sealed object
+  looks into the read-only pages, and writing through it, or through a
+  method which writes in place without checking that its receiver is
+  frozen, is a segmentation fault.  Objects already sealed are left as
+  they are; any other object raises TypeError before anything is done.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_histogram.h"
+#include "rb_gsl_interp.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct rb_gsl_seal_region {
+  void *addr;
+  size_t len;
+  size_t refs;
+};
+
+/* Called by the free functions of the sealed objects */
+void rb_gsl_seal_release(rb_gsl_seal_region *r)
+{
+  if (--r->refs > 0) return;
+  munmap(r->addr, r->len);
+  free(r);
+}
+
+/* The gsl_vector (gsl_matrix) comes first and its block follows, as in
+   the records of memory.c, so that rb_gsl_vector_owns_data holds; the
+   types of all elements share one layout */
+typedef struct {
+  gsl_vector x;
+  gsl_block b;
+  rb_gsl_seal_region *r;
+} seal_vector;
+
+typedef struct {
+  gsl_matrix x;
+  gsl_block b;
+  rb_gsl_seal_region *r;
+} seal_matrix;
+
+typedef struct {
+  gsl_histogram h;
+  rb_gsl_seal_region *r;
+} seal_histogram;
+
+static void seal_vector_free(seal_vector *p)
+{
+  rb_gsl_seal_release(p->r);
+  free(p);
+}
+
+static void seal_matrix_free(seal_matrix *p)
+{
+  rb_gsl_seal_release(p->r);
+  free(p);
+}
+
+static void seal_histogram_free(seal_histogram *p)
+{
+  rb_gsl_seal_release(p->r);
+  free(p);
+}
+
+enum {
+  SEAL_VECTOR,
+  SEAL_MATRIX,
+  SEAL_SPLINE,
+  SEAL_HISTOGRAM,
+};
+
+/* One object: the pieces of data to move, at most two, and the record
+   allocated for it before anything is changed */
+typedef struct {
+  VALUE obj;
+  int kind;
+  size_t nparts;
+  const void *src[2];
+  size_t len[2];
+  size_t offset[2];
+  void *rec;
+} seal_item;
+
+/* Bytes per element of the vectors (matrices) freed by f, or 0 */
+static size_t seal_vector_unit(RUBY_DATA_FUNC f)
+{
+  if (f == (RUBY_DATA_FUNC) gsl_vector_free) return sizeof(double);
+  if (f == (RUBY_DATA_FUNC) gsl_vector_int_free) return sizeof(int);
+  if (f == (RUBY_DATA_FUNC) gsl_vector_complex_free) return 2*sizeof(double);
+  return 0;
+}
+
+static size_t seal_matrix_unit(RUBY_DATA_FUNC f)
+{
+  if (f == (RUBY_DATA_FUNC) gsl_matrix_free) return sizeof(double);
+  if (f == (RUBY_DATA_FUNC) gsl_matrix_int_free) return sizeof(int);
+  if (f == (RUBY_DATA_FUNC) gsl_matrix_complex_free) return 2*sizeof(double);
+  return 0;
+}
+
+static int seal_sealed_p(VALUE obj)
+{
+  rb_gsl_spline *sp;
+  RUBY_DATA_FUNC f;
+  if ((sp = rb_gsl_spline_ptr(obj)) != NULL) return sp->seal != NULL;
+  if (TYPE(obj) != T_DATA) return 0;
+  f = RDATA(obj)->dfree;
+  return f == (RUBY_DATA_FUNC) seal_vector_free || f == (RUBY_DATA_FUNC) seal_matrix_free
+    || f == (RUBY_DATA_FUNC) seal_histogram_free;
+}
+
+/* Fills e with the data of obj; raises TypeError if obj cannot be sealed */
+static void seal_probe(VALUE obj, seal_item *e)
+{
+  rb_gsl_spline *sp;
+  RUBY_DATA_FUNC f;
+  size_t unit;
+  e->obj = obj;
+  e->rec = NULL;
+  if ((sp = rb_gsl_spline_ptr(obj)) != NULL) {
+    e->kind = SEAL_SPLINE;
+    e->nparts = 2;
+    e->src[0] = sp->s->x;
+    e->src[1] = sp->s->y;
+    e->len[0] = e->len[1] = sp->s->size*sizeof(double);
+    return;
+  }
+  if (TYPE(obj) == T_DATA) {
+    f = RDATA(obj)->dfree;
+    if ((unit = seal_vector_unit(f)) && rb_gsl_vector_owns_data(DATA_PTR(obj))) {
+      gsl_vector *v = (gsl_vector *) DATA_PTR(obj);
+      e->kind = SEAL_VECTOR;
+      e->nparts = 1;
+      e->src[0] = v->block->data;
+      e->len[0] = v->block->size*unit;
+      return;
+    }
+    if ((unit = seal_matrix_unit(f)) && rb_gsl_matrix_owns_data(DATA_PTR(obj))) {
+      gsl_matrix *m = (gsl_matrix *) DATA_PTR(obj);
+      e->kind = SEAL_MATRIX;
+      e->nparts = 1;
+      e->src[0] = m->block->data;
+      e->len[0] = m->block->size*unit;
+      return;
+    }
+    if (f == (RUBY_DATA_FUNC) gsl_histogram_free && rb_obj_is_kind_of(obj, cgsl_histogram)) {
+      gsl_histogram *h = (gsl_histogram *) DATA_PTR(obj);
+      e->kind = SEAL_HISTOGRAM;
+      e->nparts = 2;
+      e->src[0] = h->range;
+      e->src[1] = h->bin;
+      e->len[0] = (h->n + 1)*sizeof(double);
+      e->len[1] = h->n*sizeof(double);
+      return;
+    }
+  }
+  rb_raise(rb_eTypeError, "cannot seal %s (Vector or Matrix owning its data, Spline or Histogram expected)",
+	   rb_class2name(CLASS_OF(obj)));
+}
+
+static size_t seal_record_size(int kind)
+{
+  switch (kind) {
+  case SEAL_VECTOR: return sizeof(seal_vector);
+  case SEAL_MATRIX: return sizeof(seal_matrix);
+  case SEAL_HISTOGRAM: return sizeof(seal_histogram);
+  }
+  return 0;
+}
+
+/* Points obj at its copy in the mapping and releases the old data; the
+   old record is freed by the free function it was wrapped with */
+static void seal_apply(seal_item *e, char *base, rb_gsl_seal_region *r)
+{
+  void *old;
+  RUBY_DATA_FUNC f;
+  rb_gsl_spline *sp;
+  if (e->kind == SEAL_SPLINE) {
+    /* the knots were allocated by gsl_spline_alloc */
+    sp = rb_gsl_spline_ptr(e->obj);
+    free(sp->s->x);
+    free(sp->s->y);
+    sp->s->x = (double *) (base + e->offset[0]);
+    sp->s->y = (double *) (base + e->offset[1]);
+    sp->seal = r;
+    return;
+  }
+  old = DATA_PTR(e->obj);
+  f = RDATA(e->obj)->dfree;
+  switch (e->kind) {
+  case SEAL_VECTOR: {
+    gsl_vector *v = (gsl_vector *) old;
+    seal_vector *p = (seal_vector *) e->rec;
+    p->x = *v;
+    p->b.size = v->block->size;
+    p->b.data = (double *) (base + e->offset[0]);
+    p->x.data = (double *) ((char *) p->b.data + ((char *) v->data - (char *) v->block->data));
+    p->x.block = &p->b;
+    p->x.owner = 0;
+    p->r = r;
+    DATA_PTR(e->obj) = &p->x;
+    RDATA(e->obj)->dfree = (RUBY_DATA_FUNC) seal_vector_free;
+    (*f)(old);
+    break;
+  }
+  case SEAL_MATRIX: {
+    gsl_matrix *m = (gsl_matrix *) old;
+    seal_matrix *p = (seal_matrix *) e->rec;
+    p->x = *m;
+    p->b.size = m->block->size;
+    p->b.data = (double *) (base + e->offset[0]);
+    p->x.data = (double *) ((char *) p->b.data + ((char *) m->data - (char *) m->block->data));
+    p->x.block = &p->b;
+    p->x.owner = 0;
+    p->r = r;
+    DATA_PTR(e->obj) = &p->x;
+    RDATA(e->obj)->dfree = (RUBY_DATA_FUNC) seal_matrix_free;
+    (*f)(old);
+    break;
+  }
+  case SEAL_HISTOGRAM: {
+    seal_histogram *p = (seal_histogram *) e->rec;
+    p->h.n = ((gsl_histogram *) old)->n;
+    p->h.range = (double *) (base + e->offset[0]);
+    p->h.bin = (double *) (base + e->offset[1]);
+    p->r = r;
+    DATA_PTR(e->obj) = &p->h;
+    RDATA(e->obj)->dfree = (RUBY_DATA_FUNC) seal_histogram_free;
+    (*f)(old);
+    break;
+  }
+  }
+}
+
+static void seal_items_free(seal_item *items, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++) free(items[i].rec);
+}
+
+static VALUE rb_gsl_seal(int argc, VALUE *argv, VALUE module)
+{
+  seal_item *items;
+  rb_gsl_seal_region *r;
+  VALUE tmp;
+  size_t i, j, k, n = 0, len = 0;
+  long pagesize = sysconf(_SC_PAGESIZE);
+  void *addr;
+  if (argc < 1) rb_raise(rb_eArgError, "wrong number of arguments (0 for 1 or more)");
+  items = ALLOCV_N(seal_item, tmp, argc);
+  for (i = 0; i < (size_t) argc; i++) {
+    if (seal_sealed_p(argv[i])) continue;
+    for (j = 0; j < n; j++) if (items[j].obj == argv[i]) break;
+    if (j < n) continue;
+    seal_probe(argv[i], items + n);
+    for (k = 0; k < items[n].nparts; k++) {
+      len = (len + RB_GSL_SIMD_ALIGN - 1)/RB_GSL_SIMD_ALIGN*RB_GSL_SIMD_ALIGN;
+      items[n].offset[k] = len;
+      len += items[n].len[k];
+    }
+    n++;
+  }
+  if (n > 0) {
+    /* everything which may fail comes before the first object is changed */
+    len = (len + (size_t) pagesize - 1)/(size_t) pagesize*(size_t) pagesize;
+    for (i = 0; i < n; i++) {
+      if (items[i].kind == SEAL_SPLINE) continue;
+      if ((items[i].rec = malloc(seal_record_size(items[i].kind))) == NULL) {
+	seal_items_free(items, i);
+	rb_raise(rb_eNoMemError, "malloc failed");
+      }
+    }
+    if ((r = (rb_gsl_seal_region *) malloc(sizeof(rb_gsl_seal_region))) == NULL) {
+      seal_items_free(items, n);
+      rb_raise(rb_eNoMemError, "malloc failed");
+    }
+    addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      seal_items_free(items, n);
+      free(r);
+      rb_sys_fail("mmap");
+    }
+    for (i = 0; i < n; i++)
+      for (k = 0; k < items[i].nparts; k++)
+	memcpy((char *) addr + items[i].offset[k], items[i].src[k], items[i].len[k]);
+    if (mprotect(addr, len, PROT_READ) != 0) {
+      munmap(addr, len);
+      seal_items_free(items, n);
+      free(r);
+      rb_sys_fail("mprotect");
+    }
+    r->addr = addr;
+    r->len = len;
+    r->refs = n;
+    for (i = 0; i < n; i++) seal_apply(items + i, (char *) addr, r);
+  }
+  ALLOCV_END(tmp);
+  for (i = 0; i < (size_t) argc; i++) rb_funcall(argv[i], rb_intern("freeze"), 0);
+  return argc == 1 ? argv[0] : rb_ary_new4(argc, argv);
+}
+
+static VALUE rb_gsl_sealed_p(VALUE module, VALUE obj)
+{
+  return seal_sealed_p(obj) ? Qtrue : Qfalse;
+}
+#else
+void rb_gsl_seal_release(rb_gsl_seal_region *r)
+{
+}
+
+static VALUE rb_gsl_seal(int argc, VALUE *argv, VALUE module)
+{
+  rb_raise(rb_eNotImpError, "mprotect is not available on this platform");
+  return Qnil;
+}
+
+static VALUE rb_gsl_sealed_p(VALUE module, VALUE obj)
+{
+  return Qfalse;
+}
+#endif
+
+void Init_gsl_seal(VALUE module)
+{
+  rb_define_module_function(module, "seal", rb_gsl_seal, -1);
+  rb_define_module_function(module, "sealed?", rb_gsl_sealed_p, 1);
+}
@@ -12,6 +12,7 @@
 
 #include "rb_gsl_array.h"
 #include "rb_gsl_sf.h"
+#include "rb_gsl_function.h"
 #ifdef HAVE_NARRAY_H
 #include "narray.h"
 #endif
@@ -116,28 +117,486 @@ static VALUE rb_gsl_sf_result_e10_to_s(VALUE obj)
   return rb_str_new2(str);
 }
 
+/*
+  The evaluation engine of the Sf functions of one variable x, the
+  others fixed: over a Vector or a Matrix (into a new one, or into out),
+  an Array, or an integer Range, read lazily without any Array. Large
+  arguments are split over GSL.parallel_threads, the GVL released.
+*/
+enum {
+  MYGSL_SF_D,                   /* f(x) */
+  MYGSL_SF_ID,                  /* f(j, x) */
+  MYGSL_SF_DI,                  /* f(x, j) */
+  MYGSL_SF_DD,                  /* f(a, x) */
+  MYGSL_SF_DM,                  /* f(x, mode) */
+  MYGSL_SF_F                    /* GSL_FN_EVAL(F, x), compiled */
+};
+
+#define MYGSL_SF_BLOCK 1024
+
+typedef struct {
+  int kind;
+  double (*d)(double);
+  double (*id)(int, double);
+  double (*di)(double, int);
+  double (*dd)(double, double);
+  double (*dm)(double, gsl_mode_t);
+  gsl_function *F;
+  int j;
+  double a;
+  gsl_mode_t mode;
+  size_t n, ncols, nthreads;
+  const double *x;              /* x[r*xtda + c*xstride], or NULL for */
+  size_t xtda, xstride;
+  double x0;                    /* x0 + k, k = r*ncols + c */
+  double *y;
+  size_t ytda, ystride;
+} mygsl_sf_map;
+
+static double mygsl_sf_map_call(const mygsl_sf_map *m, double x)
+{
+  switch (m->kind) {
+  case MYGSL_SF_ID: return (*m->id)(m->j, x);
+  case MYGSL_SF_DI: return (*m->di)(x, m->j);
+  case MYGSL_SF_DD: return (*m->dd)(m->a, x);
+  case MYGSL_SF_DM: return (*m->dm)(x, m->mode);
+  case MYGSL_SF_F: return GSL_FN_EVAL(m->F, x);
+  default: return (*m->d)(x);
+  }
+}
+
+static void mygsl_sf_map_range(const mygsl_sf_map *m, size_t lo, size_t hi)
+{
+  size_t k, r, c;
+  double x;
+  for (k = lo; k < hi; k++) {
+    r = k/m->ncols;
+    c = k%m->ncols;
+    x = m->x ? m->x[r*m->xtda + c*m->xstride] : m->x0 + (double) k;
+    m->y[r*m->ytda + c*m->ystride] = mygsl_sf_map_call(m, x);
+  }
+}
+
+static int mygsl_sf_map_worker(void *data, size_t id)
+{
+  mygsl_sf_map *m = (mygsl_sf_map *) data;
+  mygsl_sf_map_range(m, m->n*id/m->nthreads, m->n*(id + 1)/m->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int mygsl_sf_map_serial(void *data)
+{
+  mygsl_sf_map *m = (mygsl_sf_map *) data;
+  mygsl_sf_map_range(m, 0, m->n);
+  return GSL_SUCCESS;
+}
+
+static void mygsl_sf_map_run(mygsl_sf_map *m)
+{
+  if (m->n == 0) return;
+  m->nthreads = rb_gsl_parallel_nthreads(m->n, (m->n + MYGSL_SF_BLOCK - 1)/MYGSL_SF_BLOCK);
+  if (m->nthreads > 1) rb_gsl_nogvl_parallel(mygsl_sf_map_worker, m, m->nthreads);
+  else rb_gsl_nogvl_call(mygsl_sf_map_serial, m, m->n);
+}
+
+/* The output Vector out for n results, checked, or NULL */
+static gsl_vector* mygsl_sf_map_out_vector(VALUE out, size_t n)
+{
+  gsl_vector *v = NULL;
+  if (NIL_P(out)) return NULL;
+  CHECK_VECTOR(out);
+  Data_Get_Struct(out, gsl_vector, v);
+  if (v->size != n) rb_raise(rb_eArgError, "output vector size must be %d", (int) n);
+  return v;
+}
+
+/* The integer Range x as x0 and n, or 0 if it is not one (to_a decides) */
+static int mygsl_sf_map_int_range(VALUE x, double *x0, size_t *n)
+{
+  VALUE vb, ve;
+  int excl;
+  long b, e;
+  if (!rb_range_values(x, &vb, &ve, &excl)) return 0;
+  if (!FIXNUM_P(vb) || !FIXNUM_P(ve)) return 0;
+  b = FIX2LONG(vb);
+  e = FIX2LONG(ve);
+  if (excl) e--;
+  *x0 = (double) b;
+  *n = e >= b ? (size_t) (e - b + 1) : 0;
+  return 1;
+}
+
+/* Evaluates over x into out (nil for a new result); Qundef if x is not
+   a Vector, Matrix, Array or Range */
+static VALUE mygsl_sf_map_eval(mygsl_sf_map *m, VALUE x, VALUE out)
+{
+  gsl_vector *v = NULL, *vout = NULL;
+  gsl_matrix *mx = NULL, *mout = NULL;
+  double *buf;
+  size_t i;
+  VALUE ary, tmp = 0;
+  if (CLASS_OF(x) == rb_cRange) {
+    if (!mygsl_sf_map_int_range(x, &m->x0, &m->n)) x = rb_gsl_range2ary(x);
+  }
+  if (MATRIX_P(x)) {
+    Data_Get_Struct(x, gsl_matrix, mx);
+    if (NIL_P(out)) {
+      mout = gsl_matrix_alloc(mx->size1, mx->size2);
+      out = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mout);
+    } else {
+      CHECK_MATRIX(out);
+      Data_Get_Struct(out, gsl_matrix, mout);
+      if (mout->size1 != mx->size1 || mout->size2 != mx->size2)
+	rb_raise(rb_eArgError, "output matrix must be %d x %d",
+		 (int) mx->size1, (int) mx->size2);
+    }
+    m->n = mx->size1*mx->size2;
+    m->ncols = mx->size2;
+    m->x = mx->data;
+    m->xtda = mx->tda;
+    m->xstride = 1;
+    m->y = mout->data;
+    m->ytda = mout->tda;
+    m->ystride = 1;
+    mygsl_sf_map_run(m);
+    return out;
+  }
+  if (VECTOR_P(x)) {
+    Data_Get_Struct(x, gsl_vector, v);
+    if (NIL_P(out)) {
+      vout = gsl_vector_alloc(v->size);
+      out = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vout);
+    } else {
+      vout = mygsl_sf_map_out_vector(out, v->size);
+    }
+    m->n = v->size;
+    m->ncols = GSL_MAX(v->size, 1);
+    m->x = v->data;
+    m->xtda = 0;
+    m->xstride = v->stride;
+    m->y = vout->data;
+    m->ytda = 0;
+    m->ystride = vout->stride;
+    mygsl_sf_map_run(m);
+    return out;
+  }
+  if (CLASS_OF(x) == rb_cRange || TYPE(x) == T_ARRAY) {
+    /* results in out, or in a buffer for the Array */
+    if (TYPE(x) == T_ARRAY) m->n = RARRAY_LEN(x);
+    vout = mygsl_sf_map_out_vector(out, m->n);
+    buf = vout && vout->stride == 1 ? vout->data : ALLOCV_N(double, tmp, m->n + 1);
+    if (TYPE(x) == T_ARRAY) {
+      for (i = 0; i < m->n; i++) buf[i] = NUM2DBL(rb_ary_entry(x, i));
+      m->x = buf;
+    } else {
+      m->x = NULL;
+    }
+    m->ncols = GSL_MAX(m->n, 1);
+    m->xtda = m->ytda = 0;
+    m->xstride = m->ystride = 1;
+    m->y = buf;
+    mygsl_sf_map_run(m);
+    if (vout) {
+      if (buf != vout->data) {
+	for (i = 0; i < m->n; i++) vout->data[i*vout->stride] = buf[i];
+	ALLOCV_END(tmp);
+      }
+      return out;
+    }
+    ary = rb_ary_new2(m->n);
+    for (i = 0; i < m->n; i++) rb_ary_store(ary, i, rb_float_new(buf[i]));
+    ALLOCV_END(tmp);
+    return ary;
+  }
+  return Qundef;
+}
+
+/* The functions of one variable of GSL::Sf, and of Math, by name */
+static const struct {
+  const char *name;
+  double (*f)(double);
+} mygsl_sf_functions1[] = {
+  {"Chi", gsl_sf_Chi}, {"Ci", gsl_sf_Ci}, {"Shi", gsl_sf_Shi}, {"Si", gsl_sf_Si},
+  {"angle_restrict_pos", gsl_sf_angle_restrict_pos},
+  {"angle_restrict_symm", gsl_sf_angle_restrict_symm},
+  {"atanint", gsl_sf_atanint},
+  {"bessel_I0", gsl_sf_bessel_I0}, {"bessel_I0_scaled", gsl_sf_bessel_I0_scaled},
+  {"bessel_I1", gsl_sf_bessel_I1}, {"bessel_I1_scaled", gsl_sf_bessel_I1_scaled},
+  {"bessel_J0", gsl_sf_bessel_J0}, {"bessel_J1", gsl_sf_bessel_J1},
+  {"bessel_K0", gsl_sf_bessel_K0}, {"bessel_K0_scaled", gsl_sf_bessel_K0_scaled},
+  {"bessel_K1", gsl_sf_bessel_K1}, {"bessel_K1_scaled", gsl_sf_bessel_K1_scaled},
+  {"bessel_Y0", gsl_sf_bessel_Y0}, {"bessel_Y1", gsl_sf_bessel_Y1},
+  {"bessel_i0_scaled", gsl_sf_bessel_i0_scaled}, {"bessel_i1_scaled", gsl_sf_bessel_i1_scaled},
+  {"bessel_i2_scaled", gsl_sf_bessel_i2_scaled},
+  {"bessel_j0", gsl_sf_bessel_j0}, {"bessel_j1", gsl_sf_bessel_j1},
+  {"bessel_j2", gsl_sf_bessel_j2},
+  {"bessel_k0_scaled", gsl_sf_bessel_k0_scaled}, {"bessel_k1_scaled", gsl_sf_bessel_k1_scaled},
+  {"bessel_k2_scaled", gsl_sf_bessel_k2_scaled},
+  {"bessel_y0", gsl_sf_bessel_y0}, {"bessel_y1", gsl_sf_bessel_y1},
+  {"bessel_y2", gsl_sf_bessel_y2},
+  {"clausen", gsl_sf_clausen}, {"dawson", gsl_sf_dawson},
+  {"debye_1", gsl_sf_debye_1}, {"debye_2", gsl_sf_debye_2},
+  {"debye_3", gsl_sf_debye_3}, {"debye_4", gsl_sf_debye_4},
+#ifdef GSL_1_8_LATER
+  {"debye_5", gsl_sf_debye_5}, {"debye_6", gsl_sf_debye_6},
+#endif
+  {"dilog", gsl_sf_dilog},
+  {"erf", gsl_sf_erf}, {"erf_Q", gsl_sf_erf_Q}, {"erf_Z", gsl_sf_erf_Z},
+  {"erfc", gsl_sf_erfc}, {"log_erfc", gsl_sf_log_erfc},
+#ifdef GSL_1_4_LATER
+  {"hazard", gsl_sf_hazard},
+#endif
+  {"eta", gsl_sf_eta}, {"zeta", gsl_sf_zeta},
+#ifdef GSL_1_4_9_LATER
+  {"zetam1", gsl_sf_zetam1},
+#endif
+  {"exp", gsl_sf_exp}, {"expm1", gsl_sf_expm1},
+  {"exprel", gsl_sf_exprel}, {"exprel_2", gsl_sf_exprel_2},
+  {"expint_3", gsl_sf_expint_3}, {"expint_E1", gsl_sf_expint_E1},
+  {"expint_E2", gsl_sf_expint_E2}, {"expint_Ei", gsl_sf_expint_Ei},
+#ifdef GSL_1_3_LATER
+  {"expint_E1_scaled", gsl_sf_expint_E1_scaled},
+  {"expint_E2_scaled", gsl_sf_expint_E2_scaled},
+  {"expint_Ei_scaled", gsl_sf_expint_Ei_scaled},
+#endif
+  {"fermi_dirac_m1", gsl_sf_fermi_dirac_m1}, {"fermi_dirac_0", gsl_sf_fermi_dirac_0},
+  {"fermi_dirac_1", gsl_sf_fermi_dirac_1}, {"fermi_dirac_2", gsl_sf_fermi_dirac_2},
+  {"fermi_dirac_mhalf", gsl_sf_fermi_dirac_mhalf},
+  {"fermi_dirac_half", gsl_sf_fermi_dirac_half},
+  {"fermi_dirac_3half", gsl_sf_fermi_dirac_3half},
+  {"gamma", gsl_sf_gamma}, {"lngamma", gsl_sf_lngamma},
+  {"gammastar", gsl_sf_gammastar}, {"gammainv", gsl_sf_gammainv},
+  {"lambert_W0", gsl_sf_lambert_W0}, {"lambert_Wm1", gsl_sf_lambert_Wm1},
+  {"legendre_P1", gsl_sf_legendre_P1}, {"legendre_P2", gsl_sf_legendre_P2},
+  {"legendre_P3", gsl_sf_legendre_P3}, {"legendre_Q0", gsl_sf_legendre_Q0},
+  {"legendre_Q1", gsl_sf_legendre_Q1},
+  {"log", gsl_sf_log}, {"log_abs", gsl_sf_log_abs},
+  {"log_1plusx", gsl_sf_log_1plusx}, {"log_1plusx_mx", gsl_sf_log_1plusx_mx},
+  {"psi", gsl_sf_psi}, {"psi_1piy", gsl_sf_psi_1piy},
+#ifdef GSL_1_6_LATER
+  {"psi_1", gsl_sf_psi_1},
+#endif
+  {"sin", gsl_sf_sin}, {"cos", gsl_sf_cos}, {"sinc", gsl_sf_sinc},
+  {"lncosh", gsl_sf_lncosh}, {"lnsinh", gsl_sf_lnsinh},
+  {"synchrotron_1", gsl_sf_synchrotron_1}, {"synchrotron_2", gsl_sf_synchrotron_2},
+  {"transport_2", gsl_sf_transport_2}, {"transport_3", gsl_sf_transport_3},
+  {"transport_4", gsl_sf_transport_4}, {"transport_5", gsl_sf_transport_5},
+  {"tan", tan}, {"asin", asin}, {"acos", acos}, {"atan", atan},
+  {"sinh", sinh}, {"cosh", cosh}, {"tanh", tanh},
+  {"asinh", gsl_asinh}, {"acosh", gsl_acosh}, {"atanh", gsl_atanh},
+  {"log1p", gsl_log1p}, {"log10", log10}, {"log2", log2},
+  {"sqrt", sqrt}, {"cbrt", cbrt}, {"abs", fabs}, {"floor", floor}, {"ceil", ceil},
+  {NULL, NULL}
+};
+
+/*
+  Vector#collect(f), Matrix#collect(f) and their bang forms (out = x):
+  f is a Symbol naming one of the functions above, :bessel_J0 for
+  GSL::Sf::bessel_J0, a String compiled by GSL::Function.compile, or a
+  GSL::Function::Compiled of x.  Either way, f is applied by the engine
+  above, with no call back into Ruby.
+*/
+VALUE rb_gsl_sf_collect(VALUE f, VALUE x, VALUE out)
+{
+  mygsl_sf_map m;
+  const char *name;
+  size_t i;
+  VALUE y;
+  memset(&m, 0, sizeof(mygsl_sf_map));
+  if (SYMBOL_P(f)) {
+    name = rb_id2name(SYM2ID(f));
+    for (i = 0; mygsl_sf_functions1[i].name; i++)
+      if (strcmp(mygsl_sf_functions1[i].name, name) == 0) break;
+    if (mygsl_sf_functions1[i].name == NULL)
+      rb_raise(rb_eArgError, "unknown function of one variable :%s", name);
+    m.kind = MYGSL_SF_D;
+    m.d = mygsl_sf_functions1[i].f;
+  } else {
+    if (TYPE(f) == T_STRING) f = rb_gsl_function_compile_multi(f, Qnil, 0);
+    if (!rb_obj_is_kind_of(f, cgsl_function_compiled))
+      rb_raise(rb_eTypeError,
+	       "wrong argument type %s (Symbol, String or GSL::Function::Compiled expected)",
+	       rb_class2name(CLASS_OF(f)));
+    if (rb_gsl_function_compiled_dim(rb_gsl_function_compiled_ptr(f)) != 0)
+      rb_raise(rb_eArgError, "function of x expected, not of x[0] ... x[dim-1]");
+    m.kind = MYGSL_SF_F;
+    Data_Get_Struct(f, gsl_function, m.F);
+  }
+  y = mygsl_sf_map_eval(&m, x, out);
+  RB_GC_GUARD(f);
+  return y;
+}
+
+/*
+  The engine of the gsl_sf_*_array functions: a->fill computes the
+  a->nout arrays of a->size values (and a->nexp exponents) at one x.
+  For a Vector or an Array of n points x, each array becomes a row of
+  an n x size Matrix, and each exponent an element of a Vector of n;
+  the rows are computed over GSL.parallel_threads, the GVL released.
+*/
+typedef struct {
+  const mygsl_sf_array *a;
+  size_t n, nthreads;
+  const double *x;
+  double *y[MYGSL_SF_ARRAY_MAXOUT];
+  size_t ytda[MYGSL_SF_ARRAY_MAXOUT];
+  double *e;                    /* n x nexp */
+  int *status;
+} mygsl_sf_array_map;
+
+static void mygsl_sf_array_range(const mygsl_sf_array_map *m, size_t lo, size_t hi)
+{
+  double *rows[MYGSL_SF_ARRAY_MAXOUT];
+  size_t r, k;
+  for (r = lo; r < hi; r++) {
+    for (k = 0; k < m->a->nout; k++) rows[k] = m->y[k] + r*m->ytda[k];
+    m->status[r] = (*m->a->fill)(m->a, m->x[r], rows, m->e + r*m->a->nexp);
+  }
+}
+
+static int mygsl_sf_array_worker(void *data, size_t id)
+{
+  mygsl_sf_array_map *m = (mygsl_sf_array_map *) data;
+  mygsl_sf_array_range(m, m->n*id/m->nthreads, m->n*(id + 1)/m->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int mygsl_sf_array_serial(void *data)
+{
+  mygsl_sf_array_map *m = (mygsl_sf_array_map *) data;
+  mygsl_sf_array_range(m, 0, m->n);
+  return GSL_SUCCESS;
+}
+
+/* The results at x scalar, as a Vector, or [v0, ..., e0, ..., status] */
+static VALUE mygsl_sf_array_eval1(mygsl_sf_array *a, double x, int argc, VALUE *out)
+{
+  gsl_vector *v[MYGSL_SF_ARRAY_MAXOUT], *tmp[MYGSL_SF_ARRAY_MAXOUT];
+  double *rows[MYGSL_SF_ARRAY_MAXOUT], e[MYGSL_SF_ARRAY_MAXOUT];
+  VALUE vv[MYGSL_SF_ARRAY_MAXOUT], ary, keep = Qnil;
+  size_t k;
+  int status;
+  for (k = 0; k < a->nout; k++) {
+    tmp[k] = NULL;
+    if ((int) k < argc && !NIL_P(out[k])) {
+      CHECK_VECTOR(out[k]);
+      Data_Get_Struct(out[k], gsl_vector, v[k]);
+      if (v[k]->size != a->size)
+	rb_raise(rb_eArgError, "output vector size must be %d", (int) a->size);
+      vv[k] = out[k];
+      if (v[k]->stride != 1) {
+	tmp[k] = gsl_vector_alloc(a->size);
+	if (NIL_P(keep)) keep = rb_ary_new();
+	rb_ary_push(keep, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, tmp[k]));
+      }
+    } else {
+      v[k] = gsl_vector_alloc(a->size);
+      vv[k] = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v[k]);
+    }
+    rows[k] = tmp[k] ? tmp[k]->data : v[k]->data;
+  }
+  status = (*a->fill)(a, x, rows, e);
+  for (k = 0; k < a->nout; k++) if (tmp[k]) gsl_vector_memcpy(v[k], tmp[k]);
+  RB_GC_GUARD(keep);
+  if (a->nout == 1 && a->nexp == 0 && !a->status) return vv[0];
+  ary = rb_ary_new2(a->nout + a->nexp + 1);
+  for (k = 0; k < a->nout; k++) rb_ary_push(ary, vv[k]);
+  for (k = 0; k < a->nexp; k++) rb_ary_push(ary, rb_float_new(e[k]));
+  if (a->status) rb_ary_push(ary, INT2FIX(status));
+  return ary;
+}
+
+/* Evaluates a at x, a Float, or a Vector or an Array of points, into
+   the argc Vectors or Matrices out (nil for new ones) */
+VALUE rb_gsl_sf_array_eval(mygsl_sf_array *a, VALUE x, int argc, VALUE *out)
+{
+  mygsl_sf_array_map m;
+  gsl_vector *v = NULL, *ve;
+  gsl_matrix *mx;
+  VALUE vm[MYGSL_SF_ARRAY_MAXOUT], ve_all[MYGSL_SF_ARRAY_MAXOUT], ary, tmp = 0, tmps = 0, tmpe = 0;
+  double *xs = NULL;
+  size_t i, k;
+  int status = GSL_SUCCESS;
+  if (argc > (int) a->nout)
+    rb_raise(rb_eArgError, "too many output arguments (%d for %d)", argc, (int) a->nout);
+  if (a->size == 0) rb_raise(rb_eArgError, "no orders to compute");
+  if (!VECTOR_P(x) && TYPE(x) != T_ARRAY) {
+    Need_Float(x);
+    return mygsl_sf_array_eval1(a, NUM2DBL(x), argc, out);
+  }
+  memset(&m, 0, sizeof(mygsl_sf_array_map));
+  m.a = a;
+  if (VECTOR_P(x)) {
+    Data_Get_Struct(x, gsl_vector, v);
+    m.n = v->size;
+  } else {
+    m.n = RARRAY_LEN(x);
+  }
+  if (m.n == 0) rb_raise(rb_eArgError, "no points x");
+  if (v && v->stride == 1) {
+    m.x = v->data;
+  } else {
+    xs = ALLOCV_N(double, tmp, m.n);
+    for (i = 0; i < m.n; i++) xs[i] = v ? gsl_vector_get(v, i) : NUM2DBL(rb_ary_entry(x, i));
+    m.x = xs;
+  }
+  for (k = 0; k < a->nout; k++) {
+    if ((int) k < argc && !NIL_P(out[k])) {
+      CHECK_MATRIX(out[k]);
+      Data_Get_Struct(out[k], gsl_matrix, mx);
+      if (mx->size1 != m.n || mx->size2 != a->size)
+	rb_raise(rb_eArgError, "output matrix must be %d x %d", (int) m.n, (int) a->size);
+      vm[k] = out[k];
+    } else {
+      mx = gsl_matrix_alloc(m.n, a->size);
+      vm[k] = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mx);
+    }
+    m.y[k] = mx->data;
+    m.ytda[k] = mx->tda;
+  }
+  m.e = ALLOCV_N(double, tmpe, m.n*a->nexp + 1);
+  m.status = ALLOCV_N(int, tmps, m.n);
+  m.nthreads = rb_gsl_parallel_nthreads(m.n*a->size, m.n);
+  if (m.nthreads > 1) rb_gsl_nogvl_parallel(mygsl_sf_array_worker, &m, m.nthreads);
+  else rb_gsl_nogvl_call(mygsl_sf_array_serial, &m, m.n*a->size);
+  for (i = 0; i < m.n && status == GSL_SUCCESS; i++) status = m.status[i];
+  for (k = 0; k < a->nexp; k++) {
+    ve = gsl_vector_alloc(m.n);
+    for (i = 0; i < m.n; i++) ve->data[i] = m.e[i*a->nexp + k];
+    ve_all[k] = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, ve);
+  }
+  if (tmp) ALLOCV_END(tmp);
+  ALLOCV_END(tmpe);
+  ALLOCV_END(tmps);
+  if (a->nout == 1 && a->nexp == 0 && !a->status) return vm[0];
+  ary = rb_ary_new2(a->nout + a->nexp + 1);
+  for (k = 0; k < a->nout; k++) rb_ary_push(ary, vm[k]);
+  for (k = 0; k < a->nexp; k++) rb_ary_push(ary, ve_all[k]);
+  if (a->status) rb_ary_push(ary, INT2FIX(status));
+  return ary;
+}
+
 VALUE rb_gsl_sf_eval1(double (*func)(double), VALUE argv)
 {
-  if (CLASS_OF(argv) == rb_cRange) argv = rb_gsl_range2ary(argv);
+  mygsl_sf_map m;
+  VALUE y;
+  memset(&m, 0, sizeof(mygsl_sf_map));
+  m.kind = MYGSL_SF_D;
+  m.d = func;
   switch (TYPE(argv)) {
   case T_FLOAT:
   case T_FIXNUM:
   case T_BIGNUM:
     return rb_float_new((*func)(NUM2DBL(argv)));
     break;
-  case T_ARRAY:
-    return rb_gsl_ary_eval1(argv, func);
-    break;
   default:
 #ifdef HAVE_NARRAY_H
     if (NA_IsNArray(argv)) {
       return rb_gsl_nary_eval1(argv, func);
     }
 #endif
-    if (MATRIX_P(argv)) {
-      return matrix_eval_create(argv, func);
-    } else if (VECTOR_P(argv)) {
-      return vector_eval_create(argv, func);
+    if ((y = mygsl_sf_map_eval(&m, argv, Qnil)) != Qundef) {
+      return y;
     } else if (COMPLEX_P(argv) || VECTOR_COMPLEX_P(argv) || MATRIX_COMPLEX_P(argv)) {
       return rb_gsl_sf_eval_complex(func, argv);
     } else {
@@ -145,38 +604,59 @@ VALUE rb_gsl_sf_eval1(double (*func)(double), VALUE argv)
     }
     break;
   }
+  return Qnil;
+}
+
+/* Evaluates func on x (a Vector, Matrix, Array or Range) into out, a
+   Vector or Matrix of as many elements; without out, the same as
+   rb_gsl_sf_eval1() */
+VALUE rb_gsl_sf_eval1_out(double (*func)(double), VALUE x, VALUE out)
+{
+  mygsl_sf_map m;
+  VALUE y;
+  if (NIL_P(out)) return rb_gsl_sf_eval1(func, x);
+  memset(&m, 0, sizeof(mygsl_sf_map));
+  m.kind = MYGSL_SF_D;
+  m.d = func;
+  if ((y = mygsl_sf_map_eval(&m, x, out)) != Qundef) return y;
+  rb_raise(rb_eTypeError, "wrong argument type %s (output buffer given, Vector or Matrix expected)",
+	   rb_class2name(CLASS_OF(x)));
+  return Qnil;
+}
+
+/* Arguments (x[, out]) or (x, :out => out) */
+VALUE rb_gsl_sf_eval1_argv(double (*func)(double), int argc, VALUE *argv)
+{
+  switch (argc) {
+  case 1:
+    return rb_gsl_sf_eval1(func, argv[0]);
+  case 2:
+    return rb_gsl_sf_eval1_out(func, argv[0], rb_gsl_out_arg(argv[1]));
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  return Qnil;
 }
 
 VALUE rb_gsl_sf_eval_int_double(double (*func)(int, double), VALUE jj, VALUE argv)
 {
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
-  VALUE ary, xx;
-  size_t i, j, k, n;
-  double val;
+  mygsl_sf_map mp;
+  VALUE ary;
 #ifdef HAVE_NARRAY_H
   double *ptr1, *ptr2;
   struct NARRAY *na;
+  size_t i, n;
 #endif
   CHECK_FIXNUM(jj);
-  j = FIX2INT(jj);
-  if (CLASS_OF(argv) == rb_cRange) argv = rb_gsl_range2ary(argv);
+  memset(&mp, 0, sizeof(mygsl_sf_map));
+  mp.kind = MYGSL_SF_ID;
+  mp.id = func;
+  mp.j = FIX2INT(jj);
   switch (TYPE(argv)) {
   case T_FLOAT:
   case T_FIXNUM:
   case T_BIGNUM:
-    return rb_float_new((*func)(j, NUM2DBL(argv)));
-    break;
-  case T_ARRAY:
-    n = RARRAY_LEN(argv);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      xx = rb_ary_entry(argv, i);
-      Need_Float(xx);
-      val = (*func)(j, NUM2DBL(xx));
-      rb_ary_store(ary, i, rb_float_new(val));
-    }
-    return ary;
+    return rb_float_new((*func)(mp.j, NUM2DBL(argv)));
     break;
   default:
 #ifdef HAVE_NARRAY_H
@@ -187,65 +667,36 @@ VALUE rb_gsl_sf_eval_int_double(double (*func)(int, double), VALUE jj, VALUE arg
       n = na->total;
       ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(argv));
       ptr2 = NA_PTR_TYPE(ary, double*);
-      for (i = 0; i < n; i++) ptr2[i] = (*func)(j, ptr1[i]);
+      for (i = 0; i < n; i++) ptr2[i] = (*func)(mp.j, ptr1[i]);
       return ary;
     }
 #endif
-    if (rb_obj_is_kind_of(argv, cgsl_matrix)) {
-      Data_Get_Struct(argv, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (k = 0; k < m->size2; k++) {
-	  val = (*func)(j, gsl_matrix_get(m, i, k));
-	  gsl_matrix_set(mnew, i, k, val);
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      CHECK_VECTOR(argv);
-      Data_Get_Struct(argv, gsl_vector, v);
-      n = v->size;
-      vnew = gsl_vector_alloc(n);
-      for (i = 0; i < n; i++) {
-	val = (*func)(j, gsl_vector_get(v, i));
-	gsl_vector_set(vnew, i, val);
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    }
+    if ((ary = mygsl_sf_map_eval(&mp, argv, Qnil)) != Qundef) return ary;
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(argv)));
     break;
   }
+  return Qnil;
 }
 
 VALUE rb_gsl_sf_eval_double_int(double (*func)(double, int), VALUE argv, VALUE jj)
 {
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
-  VALUE ary, xx;
-  size_t i, j, k, n;
-  double val;
+  mygsl_sf_map mp;
+  VALUE ary;
 #ifdef HAVE_NARRAY_H
   double *ptr1, *ptr2;
   struct NARRAY *na;
+  size_t i, n;
 #endif
   CHECK_FIXNUM(jj);
-  j = FIX2INT(jj);
-  if (CLASS_OF(argv) == rb_cRange) argv = rb_gsl_range2ary(argv);
+  memset(&mp, 0, sizeof(mygsl_sf_map));
+  mp.kind = MYGSL_SF_DI;
+  mp.di = func;
+  mp.j = FIX2INT(jj);
   switch (TYPE(argv)) {
   case T_FLOAT:
   case T_FIXNUM:
   case T_BIGNUM:
-    return rb_float_new((*func)(NUM2DBL(argv), j));
-    break;
-  case T_ARRAY:
-    n = RARRAY_LEN(argv);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      xx = rb_ary_entry(argv, i);
-      Need_Float(xx);
-      val = (*func)(NUM2DBL(xx), j);
-      rb_ary_store(ary, i, rb_float_new(val));
-    }
-    return ary;
+    return rb_float_new((*func)(NUM2DBL(argv), mp.j));
     break;
   default:
 #ifdef HAVE_NARRAY_H
@@ -256,31 +707,12 @@ VALUE rb_gsl_sf_eval_double_int(double (*func)(double, int), VALUE argv, VALUE j
       n = na->total;
       ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(argv));
       ptr2 = NA_PTR_TYPE(ary, double*);
-      for (i = 0; i < n; i++) ptr2[i] = (*func)(ptr1[i], j);
+      for (i = 0; i < n; i++) ptr2[i] = (*func)(ptr1[i], mp.j);
       return ary;
     }
 #endif
-    if (rb_obj_is_kind_of(argv, cgsl_matrix)) {
-      Data_Get_Struct(argv, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (k = 0; k < m->size2; k++) {
-	  val = (*func)(gsl_matrix_get(m, i, k), j);
-	  gsl_matrix_set(mnew, i, k, val);
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      CHECK_VECTOR(argv);
-      Data_Get_Struct(argv, gsl_vector, v);
-      n = v->size;
-      vnew = gsl_vector_alloc(n);
-      for (i = 0; i < n; i++) {
-	val = (*func)(gsl_vector_get(v, i), j);
-	gsl_vector_set(vnew, i, val);
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    }
+    if ((ary = mygsl_sf_map_eval(&mp, argv, Qnil)) != Qundef) return ary;
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(argv)));
     break;
   }
   return Qnil;
@@ -431,34 +863,23 @@ VALUE rb_gsl_sf_eval_int_double_double(double (*func)(int, double, double), VALU
 
 VALUE rb_gsl_sf_eval_double_double(double (*func)(double, double), VALUE ff, VALUE argv)
 {
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
-  VALUE ary, xx;
-  size_t i, k, n;
-  double val, f;
+  mygsl_sf_map mp;
+  VALUE ary;
 #ifdef HAVE_NARRAY_H
   double *ptr1, *ptr2;
   struct NARRAY *na;
+  size_t i, n;
 #endif
   Need_Float(ff);
-  f = NUM2DBL(ff);
-  if (CLASS_OF(argv) == rb_cRange) argv = rb_gsl_range2ary(argv);
+  memset(&mp, 0, sizeof(mygsl_sf_map));
+  mp.kind = MYGSL_SF_DD;
+  mp.dd = func;
+  mp.a = NUM2DBL(ff);
   switch (TYPE(argv)) {
   case T_FLOAT:
   case T_FIXNUM:
   case T_BIGNUM:
-    return rb_float_new((*func)(f, NUM2DBL(argv)));
-    break;
-  case T_ARRAY:
-    n = RARRAY_LEN(argv);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      xx = rb_ary_entry(argv, i);
-      Need_Float(xx);
-      val = (*func)(f, NUM2DBL(xx));
-      rb_ary_store(ary, i, rb_float_new(val));
-    }
-    return ary;
+    return rb_float_new((*func)(mp.a, NUM2DBL(argv)));
     break;
   default:
 #ifdef HAVE_NARRAY_H
@@ -469,30 +890,15 @@ VALUE rb_gsl_sf_eval_double_double(double (*func)(double, double), VALUE ff, VAL
       n = na->total;
       ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(argv));
       ptr2 = NA_PTR_TYPE(ary, double*);
-      for (i = 0; i < n; i++) ptr2[i] = (*func)(f, ptr1[i]);
+      for (i = 0; i < n; i++) ptr2[i] = (*func)(mp.a, ptr1[i]);
       return ary;
     }
 #endif
-    if (rb_obj_is_kind_of(argv, cgsl_matrix)) {
-      Data_Get_Struct(argv, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (k = 0; k < m->size2; k++) {
-	  gsl_matrix_set(mnew, i, k, (*func)(f, gsl_matrix_get(m, i, k)));
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      CHECK_VECTOR(argv);
-      Data_Get_Struct(argv, gsl_vector, v);
-      vnew = gsl_vector_alloc(v->size);
-      for (i = 0; i < v->size; i++) {
-	gsl_vector_set(vnew, i, (*func)(f, gsl_vector_get(v, i)));
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    }
+    if ((ary = mygsl_sf_map_eval(&mp, argv, Qnil)) != Qundef) return ary;
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(argv)));
     break;
   }
+  return Qnil;
 }
 
 VALUE rb_gsl_sf_eval_double3(double (*func)(double, double, double), 
@@ -770,16 +1176,14 @@ VALUE rb_gsl_sf_eval1_uint(double (*func)(unsigned int), VALUE argv)
 
 VALUE rb_gsl_sf_eval_double_m(double (*func)(double, gsl_mode_t), VALUE argv, VALUE m)
 {
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *mm = NULL, *mnew = NULL;
-  VALUE ary, xx;
-  size_t i, k, n;
-  double val;
+  mygsl_sf_map mp;
+  VALUE ary;
   gsl_mode_t mode;
   char c;
 #ifdef HAVE_NARRAY_H
   double *ptr1, *ptr2;
   struct NARRAY *na;
+  size_t i, n;
 #endif
   switch (TYPE(m)) {
   case T_STRING:
@@ -796,59 +1200,34 @@ VALUE rb_gsl_sf_eval_double_m(double (*func)(double, gsl_mode_t), VALUE argv, VA
     rb_raise(rb_eArgError, "wrong type argument %s (String or Fixnum expected)",
 	     rb_class2name(CLASS_OF(m)));
   }
-  if (CLASS_OF(argv) == rb_cRange) argv = rb_gsl_range2ary(argv);
+  memset(&mp, 0, sizeof(mygsl_sf_map));
+  mp.kind = MYGSL_SF_DM;
+  mp.dm = func;
+  mp.mode = mode;
   switch (TYPE(argv)) {
   case T_FLOAT:
   case T_FIXNUM:
   case T_BIGNUM:
-    return rb_float_new((*func)(NUM2DBL(argv), m));
-    break;
-  case T_ARRAY:
-    n = RARRAY_LEN(argv);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      xx = rb_ary_entry(argv, i);
-      Need_Float(xx);
-      val = (*func)(NUM2DBL(xx), m);
-      rb_ary_store(ary, i, rb_float_new(val));
-    }
-    return ary;
+    return rb_float_new((*func)(NUM2DBL(argv), mode));
     break;
   default:
 #ifdef HAVE_NARRAY_H
     if (NA_IsNArray(argv)) {
+      argv = na_change_type(argv, NA_DFLOAT);
       ptr1 = NA_PTR_TYPE(argv, double*);
       GetNArray(argv, na);
       n = na->total;
       ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(argv));
       ptr2 = NA_PTR_TYPE(ary, double*);
-      for (i = 0; i < n; i++) ptr2[i] = (*func)(ptr1[i], m);
+      for (i = 0; i < n; i++) ptr2[i] = (*func)(ptr1[i], mode);
       return ary;
     }
 #endif
-    if (rb_obj_is_kind_of(argv, cgsl_matrix)) {
-      Data_Get_Struct(argv, gsl_matrix, mm);
-      mnew = gsl_matrix_alloc(mm->size1, mm->size2);
-      for (i = 0; i < mm->size1; i++) {
-	for (k = 0; k < mm->size2; k++) {
-	  val = (*func)(gsl_matrix_get(mm, i, k), m);
-	  gsl_matrix_set(mnew, i, k, val);
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      CHECK_VECTOR(argv);
-      Data_Get_Struct(argv, gsl_vector, v);
-      n = v->size;
-      vnew = gsl_vector_alloc(n);
-      for (i = 0; i < n; i++) {
-	val = (*func)(gsl_vector_get(v, i), m);
-	gsl_vector_set(vnew, i, val);
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    }
+    if ((ary = mygsl_sf_map_eval(&mp, argv, Qnil)) != Qundef) return ary;
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(argv)));
     break;
   }
+  return Qnil;
 }
 
 VALUE rb_gsl_sf_eval_double2_m(double (*func)(double, double, gsl_mode_t), 
@@ -1433,6 +1812,140 @@ VALUE rb_gsl_sf_eval_complex(double (*f)(double), VALUE obj)
   }
 }
 
+/*
+  Complex functions of the gsl_sf_complex_*_e form f(x, y, &r1, &r2),
+  w = r1 + i r2, over a GSL::Complex, a Vector::Complex or a
+  Matrix::Complex (into a new one, or into out), the elements read
+  and written in place without any GSL::Complex in between: (x, y) is
+  z, or |z| and arg z for polar. Large arguments are split over
+  GSL.parallel_threads, the GVL released.
+*/
+typedef struct {
+  int (*f)(double, double, gsl_sf_result*, gsl_sf_result*);
+  int polar;
+  size_t n, ncols, nthreads;
+  const double *z;              /* z + 2*(r*ztda + c*zstride) */
+  size_t ztda, zstride;
+  double *w;
+  size_t wtda, wstride;
+} mygsl_sf_cmap;
+
+static void mygsl_sf_cmap_call(const mygsl_sf_cmap *m, const double *z, double *w)
+{
+  gsl_sf_result r1, r2;
+  double x = z[0], y = z[1];
+  if (m->polar) {
+    x = gsl_hypot(z[0], z[1]);
+    y = atan2(z[1], z[0]);
+  }
+  (*m->f)(x, y, &r1, &r2);
+  w[0] = r1.val;
+  w[1] = r2.val;
+}
+
+static void mygsl_sf_cmap_range(const mygsl_sf_cmap *m, size_t lo, size_t hi)
+{
+  size_t k, r, c;
+  for (k = lo; k < hi; k++) {
+    r = k/m->ncols;
+    c = k%m->ncols;
+    mygsl_sf_cmap_call(m, m->z + 2*(r*m->ztda + c*m->zstride), m->w + 2*(r*m->wtda + c*m->wstride));
+  }
+}
+
+static int mygsl_sf_cmap_worker(void *data, size_t id)
+{
+  mygsl_sf_cmap *m = (mygsl_sf_cmap *) data;
+  mygsl_sf_cmap_range(m, m->n*id/m->nthreads, m->n*(id + 1)/m->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int mygsl_sf_cmap_serial(void *data)
+{
+  mygsl_sf_cmap *m = (mygsl_sf_cmap *) data;
+  mygsl_sf_cmap_range(m, 0, m->n);
+  return GSL_SUCCESS;
+}
+
+/* f(z[, out]), or f(re, im) */
+VALUE rb_gsl_sf_eval_complex_e(int (*f)(double, double, gsl_sf_result*, gsl_sf_result*),
+			       int polar, int argc, VALUE *argv)
+{
+  mygsl_sf_cmap m;
+  gsl_complex *z, *znew, c;
+  gsl_vector_complex *v, *vout;
+  gsl_matrix_complex *mx, *mout;
+  VALUE x, out = Qnil;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  memset(&m, 0, sizeof(mygsl_sf_cmap));
+  m.f = f;
+  m.polar = polar;
+  x = argv[0];
+  if (argc == 2) {
+    if (rb_obj_is_kind_of(argv[1], rb_cNumeric)) {
+      GSL_SET_COMPLEX(&c, NUM2DBL(argv[0]), NUM2DBL(argv[1]));
+      znew = ALLOC(gsl_complex);
+      mygsl_sf_cmap_call(&m, c.dat, znew->dat);
+      return Data_Wrap_Struct(cgsl_complex, 0, free, znew);
+    }
+    out = rb_gsl_out_arg(argv[1]);
+  }
+  if (COMPLEX_P(x)) {
+    Data_Get_Struct(x, gsl_complex, z);
+    znew = ALLOC(gsl_complex);
+    mygsl_sf_cmap_call(&m, z->dat, znew->dat);
+    return Data_Wrap_Struct(cgsl_complex, 0, free, znew);
+  } else if (VECTOR_COMPLEX_P(x)) {
+    Data_Get_Struct(x, gsl_vector_complex, v);
+    if (NIL_P(out)) {
+      vout = gsl_vector_complex_alloc(v->size);
+      out = Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, vout);
+    } else {
+      CHECK_VECTOR_COMPLEX(out);
+      Data_Get_Struct(out, gsl_vector_complex, vout);
+      if (vout->size != v->size)
+	rb_raise(rb_eArgError, "output vector size must be %d", (int) v->size);
+    }
+    m.n = v->size;
+    m.ncols = GSL_MAX(v->size, 1);
+    m.z = v->data;
+    m.zstride = v->stride;
+    m.w = vout->data;
+    m.wstride = vout->stride;
+  } else if (MATRIX_COMPLEX_P(x)) {
+    Data_Get_Struct(x, gsl_matrix_complex, mx);
+    if (NIL_P(out)) {
+      mout = gsl_matrix_complex_alloc(mx->size1, mx->size2);
+      out = Data_Wrap_Struct(cgsl_matrix_complex, 0, gsl_matrix_complex_free, mout);
+    } else {
+      CHECK_MATRIX_COMPLEX(out);
+      Data_Get_Struct(out, gsl_matrix_complex, mout);
+      if (mout->size1 != mx->size1 || mout->size2 != mx->size2)
+	rb_raise(rb_eArgError, "output matrix must be %d x %d",
+		 (int) mx->size1, (int) mx->size2);
+    }
+    m.n = mx->size1*mx->size2;
+    m.ncols = mx->size2;
+    m.z = mx->data;
+    m.ztda = mx->tda;
+    m.zstride = 1;
+    m.w = mout->data;
+    m.wtda = mout->tda;
+    m.wstride = 1;
+  } else {
+    rb_raise(rb_eTypeError,
+	     "wrong argument type %s (GSL::Complex, Vector::Complex or Matrix::Complex expected)",
+	     rb_class2name(CLASS_OF(x)));
+  }
+  if (m.n > 0) {
+    m.nthreads = rb_gsl_parallel_nthreads(m.n, (m.n + MYGSL_SF_BLOCK - 1)/MYGSL_SF_BLOCK);
+    if (m.nthreads > 1) rb_gsl_nogvl_parallel(mygsl_sf_cmap_worker, &m, m.nthreads);
+    else rb_gsl_nogvl_call(mygsl_sf_cmap_serial, &m, m.n);
+  }
+  return out;
+}
+
 void Init_gsl_sf(VALUE module)
 {
   VALUE mgsl_sf;
@@ -1484,6 +1997,7 @@ void Init_gsl_sf(VALUE module)
   Init_gsl_sf_power(mgsl_sf);
   Init_gsl_sf_psi(mgsl_sf);
   Init_gsl_sf_synchrotron(mgsl_sf);
+  Init_gsl_sf_table(mgsl_sf);
   Init_gsl_sf_transport(mgsl_sf);
   Init_gsl_sf_trigonometric(mgsl_sf);
   Init_gsl_sf_zeta(mgsl_sf);
@@ -14,9 +14,9 @@
 EXTERN VALUE cgsl_vector;
 
 /* Cylindrical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_J0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_J0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_J0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_J0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_J0_e(VALUE obj, VALUE x)
@@ -24,9 +24,9 @@ static VALUE rb_gsl_sf_bessel_J0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_J0_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_J1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_J1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_J1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_J1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_J1_e(VALUE obj, VALUE x)
@@ -44,30 +44,39 @@ static VALUE rb_gsl_sf_bessel_Jn_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_Jn_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_Xn_array(VALUE obj, VALUE n0, VALUE n1, VALUE x,
+static int mygsl_sf_bessel_Xn_fill(const mygsl_sf_array *a, double x, double **y, double *e)
+{
+  return (*(int (*)(int, int, double, double[])) a->func)(a->i0, a->i1, x, y[0]);
+}
+
+/* Xn_array(nmin, nmax, x[, out]): x a Vector or an Array gives a Matrix,
+   a row for each x */
+static VALUE rb_gsl_sf_bessel_Xn_array(int argc, VALUE *argv,
 				       int (*f)(int, int, double, double[]))
 {
-  int nmin, nmax, n;
-  gsl_vector *v = NULL;
-  CHECK_FIXNUM(n0); CHECK_FIXNUM(n1);
-  Need_Float(x);
-  nmin = FIX2INT(n0);
-  nmax = FIX2INT(n1);
-  n = nmax - nmin + 1;
-  v = gsl_vector_alloc(n);
-  (*f)(nmin, nmax, NUM2DBL(x), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  mygsl_sf_array a;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  CHECK_FIXNUM(argv[0]); CHECK_FIXNUM(argv[1]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_bessel_Xn_fill;
+  a.func = (void (*)(void)) f;
+  a.i0 = FIX2INT(argv[0]);
+  a.i1 = FIX2INT(argv[1]);
+  a.size = a.i1 >= a.i0 ? a.i1 - a.i0 + 1 : 0;
+  a.nout = 1;
+  return rb_gsl_sf_array_eval(&a, argv[2], argc - 3, argv + 3);
 }
 
-static VALUE rb_gsl_sf_bessel_Jn_array(VALUE obj, VALUE n0, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_Jn_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_Xn_array(obj, n0, n1, x, gsl_sf_bessel_Jn_array);
+  return rb_gsl_sf_bessel_Xn_array(argc, argv, gsl_sf_bessel_Jn_array);
 }
 
 /* Irregular Cylindrical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_Y0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_Y0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_Y0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_Y0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_Y0_e(VALUE obj, VALUE x)
@@ -75,9 +84,9 @@ static VALUE rb_gsl_sf_bessel_Y0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_Y0_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_Y1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_Y1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_Y1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_Y1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_Y1_e(VALUE obj, VALUE x)
@@ -95,15 +104,15 @@ static VALUE rb_gsl_sf_bessel_Yn_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_Yn_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_Yn_array(VALUE obj, VALUE n0, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_Yn_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_Xn_array(obj, n0, n1, x, gsl_sf_bessel_Yn_array);
+  return rb_gsl_sf_bessel_Xn_array(argc, argv, gsl_sf_bessel_Yn_array);
 }
 
 /* Regular Modified Cylindrical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_I0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_I0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_I0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_I0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_I0_e(VALUE obj, VALUE x)
@@ -111,9 +120,9 @@ static VALUE rb_gsl_sf_bessel_I0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_I0_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_I1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_I1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_I1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_I1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_I1_e(VALUE obj, VALUE x)
@@ -131,14 +140,14 @@ static VALUE rb_gsl_sf_bessel_In_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_In_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_In_array(VALUE obj, VALUE n0, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_In_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_Xn_array(obj, n0, n1, x, gsl_sf_bessel_In_array);
+  return rb_gsl_sf_bessel_Xn_array(argc, argv, gsl_sf_bessel_In_array);
 }
 
-static VALUE rb_gsl_sf_bessel_I0_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_I0_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_I0_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_I0_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_I0_scaled_e(VALUE obj, VALUE x)
@@ -146,9 +155,9 @@ static VALUE rb_gsl_sf_bessel_I0_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_I0_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_I1_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_I1_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_I1_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_I1_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_I1_scaled_e(VALUE obj, VALUE x)
@@ -166,16 +175,15 @@ static VALUE rb_gsl_sf_bessel_In_scaled_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_In_scaled_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_In_scaled_array(VALUE obj, VALUE n0, VALUE n1,
-					      VALUE x)
+static VALUE rb_gsl_sf_bessel_In_scaled_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_Xn_array(obj, n0, n1, x, gsl_sf_bessel_In_scaled_array);
+  return rb_gsl_sf_bessel_Xn_array(argc, argv, gsl_sf_bessel_In_scaled_array);
 }
 
 /* Irregular Modified Cylindrical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_K0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_K0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_K0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_K0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_K0_e(VALUE obj, VALUE x)
@@ -183,9 +191,9 @@ static VALUE rb_gsl_sf_bessel_K0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_K0_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_K1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_K1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_K1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_K1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_K1_e(VALUE obj, VALUE x)
@@ -203,14 +211,14 @@ static VALUE rb_gsl_sf_bessel_Kn_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_Kn_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_Kn_array(VALUE obj, VALUE n0, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_Kn_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_Xn_array(obj, n0, n1, x, gsl_sf_bessel_Kn_array);
+  return rb_gsl_sf_bessel_Xn_array(argc, argv, gsl_sf_bessel_Kn_array);
 }
 
-static VALUE rb_gsl_sf_bessel_K0_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_K0_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_K0_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_K0_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_K0_scaled_e(VALUE obj, VALUE x)
@@ -218,9 +226,9 @@ static VALUE rb_gsl_sf_bessel_K0_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_K0_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_K1_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_K1_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_K1_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_K1_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_K1_scaled_e(VALUE obj, VALUE x)
@@ -238,16 +246,15 @@ static VALUE rb_gsl_sf_bessel_Kn_scaled_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_Kn_scaled_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_Kn_scaled_array(VALUE obj, VALUE n0, VALUE n1,
-					      VALUE x)
+static VALUE rb_gsl_sf_bessel_Kn_scaled_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_Xn_array(obj, n0, n1, x, gsl_sf_bessel_Kn_scaled_array);
+  return rb_gsl_sf_bessel_Xn_array(argc, argv, gsl_sf_bessel_Kn_scaled_array);
 }
 
 /* Spherical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_j0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_j0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_j0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_j0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_j0_e(VALUE obj, VALUE x)
@@ -255,9 +262,9 @@ static VALUE rb_gsl_sf_bessel_j0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_j0_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_j1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_j1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_j1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_j1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_j1_e(VALUE obj, VALUE x)
@@ -265,9 +272,9 @@ static VALUE rb_gsl_sf_bessel_j1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_j1_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_j2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_j2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_j2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_j2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_j2_e(VALUE obj, VALUE x)
@@ -285,36 +292,42 @@ static VALUE rb_gsl_sf_bessel_jl_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_jl_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_xl_array(VALUE obj, VALUE n1, VALUE x,
+static int mygsl_sf_bessel_xl_fill(const mygsl_sf_array *a, double x, double **y, double *e)
+{
+  return (*(int (*)(int, double, double[])) a->func)(a->i0, x, y[0]);
+}
+
+/* xl_array(lmax, x[, out]) */
+static VALUE rb_gsl_sf_bessel_xl_array(int argc, VALUE *argv,
 				       int (*f)(int, double, double[]))
 {
-  int nmax, n;
-  // local variable "status" declared and set, but never used
-  //int status;
-  gsl_vector *v = NULL;
-  CHECK_FIXNUM(n1);
-  Need_Float(x);
-  nmax = FIX2INT(n1);
-  n = nmax  + 1;
-  v = gsl_vector_alloc(n);
-  /*status =*/ (*f)(nmax, NUM2DBL(x), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  mygsl_sf_array a;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  CHECK_FIXNUM(argv[0]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_bessel_xl_fill;
+  a.func = (void (*)(void)) f;
+  a.i0 = FIX2INT(argv[0]);
+  a.size = a.i0 >= 0 ? a.i0 + 1 : 0;
+  a.nout = 1;
+  return rb_gsl_sf_array_eval(&a, argv[1], argc - 2, argv + 2);
 }
 
-static VALUE rb_gsl_sf_bessel_jl_array(VALUE obj, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_jl_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_xl_array(obj, n1, x, gsl_sf_bessel_jl_array);
+  return rb_gsl_sf_bessel_xl_array(argc, argv, gsl_sf_bessel_jl_array);
 }
 
-static VALUE rb_gsl_sf_bessel_jl_steed_array(VALUE obj, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_jl_steed_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_xl_array(obj, n1, x, gsl_sf_bessel_jl_steed_array);
+  return rb_gsl_sf_bessel_xl_array(argc, argv, gsl_sf_bessel_jl_steed_array);
 }
 
 /* Irregular Cylindrical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_y0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_y0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_y0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_y0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_y0_e(VALUE obj, VALUE x)
@@ -322,9 +335,9 @@ static VALUE rb_gsl_sf_bessel_y0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_y0_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_y1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_y1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_y1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_y1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_y1_e(VALUE obj, VALUE x)
@@ -332,9 +345,9 @@ static VALUE rb_gsl_sf_bessel_y1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_y1_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_y2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_y2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_y2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_y2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_y2_e(VALUE obj, VALUE x)
@@ -352,15 +365,15 @@ static VALUE rb_gsl_sf_bessel_yl_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_yl_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_yl_array(VALUE obj, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_yl_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_xl_array(obj, n1, x, gsl_sf_bessel_yl_array);
+  return rb_gsl_sf_bessel_xl_array(argc, argv, gsl_sf_bessel_yl_array);
 }
 
 /* Regular Modified Cylindrical Bessel Functions */
-static VALUE rb_gsl_sf_bessel_i0_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_i0_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_i0_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_i0_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_i0_scaled_e(VALUE obj, VALUE x)
@@ -368,9 +381,9 @@ static VALUE rb_gsl_sf_bessel_i0_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_i0_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_i1_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_i1_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_i1_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_i1_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_i1_scaled_e(VALUE obj, VALUE x)
@@ -378,9 +391,9 @@ static VALUE rb_gsl_sf_bessel_i1_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_i1_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_i2_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_i2_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_i2_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_i2_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_i2_scaled_e(VALUE obj, VALUE x)
@@ -398,16 +411,16 @@ static VALUE rb_gsl_sf_bessel_il_scaled_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_il_scaled_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_il_scaled_array(VALUE obj, VALUE n1, VALUE x)
+static VALUE rb_gsl_sf_bessel_il_scaled_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_xl_array(obj, n1, x, gsl_sf_bessel_il_scaled_array);
+  return rb_gsl_sf_bessel_xl_array(argc, argv, gsl_sf_bessel_il_scaled_array);
 }
 
 /* Irregular Modified Cylindrical Bessel Functions */
 
-static VALUE rb_gsl_sf_bessel_k0_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_k0_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_k0_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_k0_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_k0_scaled_e(VALUE obj, VALUE x)
@@ -415,9 +428,9 @@ static VALUE rb_gsl_sf_bessel_k0_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_k0_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_k1_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_k1_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_k1_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_k1_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_k1_scaled_e(VALUE obj, VALUE x)
@@ -425,9 +438,9 @@ static VALUE rb_gsl_sf_bessel_k1_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_bessel_k1_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_bessel_k2_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_bessel_k2_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_bessel_k2_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_bessel_k2_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_bessel_k2_scaled_e(VALUE obj, VALUE x)
@@ -445,10 +458,9 @@ static VALUE rb_gsl_sf_bessel_kl_scaled_e(VALUE obj, VALUE n, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_bessel_kl_scaled_e, n, x);
 }
 
-static VALUE rb_gsl_sf_bessel_kl_scaled_array(VALUE obj, VALUE n1,
-					      VALUE x)
+static VALUE rb_gsl_sf_bessel_kl_scaled_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_bessel_xl_array(obj, n1, x, gsl_sf_bessel_kl_scaled_array);
+  return rb_gsl_sf_bessel_xl_array(argc, argv, gsl_sf_bessel_kl_scaled_array);
 }
 
 /* Regular Bessel Function - Fractional Order */
@@ -661,85 +673,85 @@ void Init_gsl_sf_bessel(VALUE module)
 {
   VALUE mgsl_sf_bessel;
 
-  rb_define_module_function(module, "bessel_J0",  rb_gsl_sf_bessel_J0, 1);
+  rb_define_module_function(module, "bessel_J0",  rb_gsl_sf_bessel_J0, -1);
   rb_define_module_function(module, "bessel_J0_e",  rb_gsl_sf_bessel_J0_e, 1);
-  rb_define_module_function(module, "bessel_J1",  rb_gsl_sf_bessel_J1, 1);
+  rb_define_module_function(module, "bessel_J1",  rb_gsl_sf_bessel_J1, -1);
   rb_define_module_function(module, "bessel_J1_e",  rb_gsl_sf_bessel_J1_e, 1);
   rb_define_module_function(module, "bessel_Jn",  rb_gsl_sf_bessel_Jn, 2);
   rb_define_module_function(module, "bessel_Jn_e",  rb_gsl_sf_bessel_Jn_e, 2);
-  rb_define_module_function(module, "bessel_Jn_array",  rb_gsl_sf_bessel_Jn_array, 3);
-  rb_define_module_function(module, "bessel_Y0",  rb_gsl_sf_bessel_Y0, 1);
+  rb_define_module_function(module, "bessel_Jn_array",  rb_gsl_sf_bessel_Jn_array, -1);
+  rb_define_module_function(module, "bessel_Y0",  rb_gsl_sf_bessel_Y0, -1);
   rb_define_module_function(module, "bessel_Y0_e",  rb_gsl_sf_bessel_Y0_e, 1);
-  rb_define_module_function(module, "bessel_Y1",  rb_gsl_sf_bessel_Y1, 1);
+  rb_define_module_function(module, "bessel_Y1",  rb_gsl_sf_bessel_Y1, -1);
   rb_define_module_function(module, "bessel_Y1_e",  rb_gsl_sf_bessel_Y1_e, 1);
   rb_define_module_function(module, "bessel_Yn",  rb_gsl_sf_bessel_Yn, 2);
   rb_define_module_function(module, "bessel_Yn_e",  rb_gsl_sf_bessel_Yn_e, 2);
-  rb_define_module_function(module, "bessel_Yn_array",  rb_gsl_sf_bessel_Yn_array, 3);
-  rb_define_module_function(module, "bessel_I0",  rb_gsl_sf_bessel_I0, 1);
+  rb_define_module_function(module, "bessel_Yn_array",  rb_gsl_sf_bessel_Yn_array, -1);
+  rb_define_module_function(module, "bessel_I0",  rb_gsl_sf_bessel_I0, -1);
   rb_define_module_function(module, "bessel_I0_e",  rb_gsl_sf_bessel_I0_e, 1);
-  rb_define_module_function(module, "bessel_I1",  rb_gsl_sf_bessel_I1, 1);
+  rb_define_module_function(module, "bessel_I1",  rb_gsl_sf_bessel_I1, -1);
   rb_define_module_function(module, "bessel_I1_e",  rb_gsl_sf_bessel_I1_e, 1);
   rb_define_module_function(module, "bessel_In",  rb_gsl_sf_bessel_In, 2);
   rb_define_module_function(module, "bessel_In_e",  rb_gsl_sf_bessel_In_e, 2);
-  rb_define_module_function(module, "bessel_In_array",  rb_gsl_sf_bessel_In_array, 3);
-  rb_define_module_function(module, "bessel_I0_scaled",  rb_gsl_sf_bessel_I0_scaled, 1);
+  rb_define_module_function(module, "bessel_In_array",  rb_gsl_sf_bessel_In_array, -1);
+  rb_define_module_function(module, "bessel_I0_scaled",  rb_gsl_sf_bessel_I0_scaled, -1);
   rb_define_module_function(module, "bessel_I0_scaled_e",  rb_gsl_sf_bessel_I0_scaled_e, 1);
-  rb_define_module_function(module, "bessel_I1_scaled",  rb_gsl_sf_bessel_I1_scaled, 1);
+  rb_define_module_function(module, "bessel_I1_scaled",  rb_gsl_sf_bessel_I1_scaled, -1);
   rb_define_module_function(module, "bessel_I1_scaled_e",  rb_gsl_sf_bessel_I1_scaled_e, 1);
   rb_define_module_function(module, "bessel_In_scaled",  rb_gsl_sf_bessel_In_scaled, 2);
   rb_define_module_function(module, "bessel_In_scaled_e",  rb_gsl_sf_bessel_In_scaled_e, 2);
-  rb_define_module_function(module, "bessel_In_scaled_array",  rb_gsl_sf_bessel_In_scaled_array, 3);
-  rb_define_module_function(module, "bessel_K0",  rb_gsl_sf_bessel_K0, 1);
+  rb_define_module_function(module, "bessel_In_scaled_array",  rb_gsl_sf_bessel_In_scaled_array, -1);
+  rb_define_module_function(module, "bessel_K0",  rb_gsl_sf_bessel_K0, -1);
   rb_define_module_function(module, "bessel_K0_e",  rb_gsl_sf_bessel_K0_e, 1);
-  rb_define_module_function(module, "bessel_K1",  rb_gsl_sf_bessel_K1, 1);
+  rb_define_module_function(module, "bessel_K1",  rb_gsl_sf_bessel_K1, -1);
   rb_define_module_function(module, "bessel_K1_e",  rb_gsl_sf_bessel_K1_e, 1);
   rb_define_module_function(module, "bessel_Kn",  rb_gsl_sf_bessel_Kn, 2);
   rb_define_module_function(module, "bessel_Kn_e",  rb_gsl_sf_bessel_Kn_e, 2);
-  rb_define_module_function(module, "bessel_Kn_array",  rb_gsl_sf_bessel_Kn_array, 3);
-  rb_define_module_function(module, "bessel_K0_scaled",  rb_gsl_sf_bessel_K0_scaled, 1);
+  rb_define_module_function(module, "bessel_Kn_array",  rb_gsl_sf_bessel_Kn_array, -1);
+  rb_define_module_function(module, "bessel_K0_scaled",  rb_gsl_sf_bessel_K0_scaled, -1);
   rb_define_module_function(module, "bessel_K0_scaled_e",  rb_gsl_sf_bessel_K0_scaled_e, 1);
-  rb_define_module_function(module, "bessel_K1_scaled",  rb_gsl_sf_bessel_K1_scaled, 1);
+  rb_define_module_function(module, "bessel_K1_scaled",  rb_gsl_sf_bessel_K1_scaled, -1);
   rb_define_module_function(module, "bessel_K1_scaled_e",  rb_gsl_sf_bessel_K1_scaled_e, 1);
   rb_define_module_function(module, "bessel_Kn_scaled",  rb_gsl_sf_bessel_Kn_scaled, 2);
   rb_define_module_function(module, "bessel_Kn_scaled_e",  rb_gsl_sf_bessel_Kn_scaled_e, 2);
-  rb_define_module_function(module, "bessel_Kn_scaled_array",  rb_gsl_sf_bessel_Kn_scaled_array, 3);
-  rb_define_module_function(module, "bessel_j0",  rb_gsl_sf_bessel_j0, 1);
+  rb_define_module_function(module, "bessel_Kn_scaled_array",  rb_gsl_sf_bessel_Kn_scaled_array, -1);
+  rb_define_module_function(module, "bessel_j0",  rb_gsl_sf_bessel_j0, -1);
   rb_define_module_function(module, "bessel_j0_e",  rb_gsl_sf_bessel_j0_e, 1);
-  rb_define_module_function(module, "bessel_j1",  rb_gsl_sf_bessel_j1, 1);
+  rb_define_module_function(module, "bessel_j1",  rb_gsl_sf_bessel_j1, -1);
   rb_define_module_function(module, "bessel_j1_e",  rb_gsl_sf_bessel_j1_e, 1);
-  rb_define_module_function(module, "bessel_j2",  rb_gsl_sf_bessel_j2, 1);
+  rb_define_module_function(module, "bessel_j2",  rb_gsl_sf_bessel_j2, -1);
   rb_define_module_function(module, "bessel_j2_e",  rb_gsl_sf_bessel_j2_e, 1);
   rb_define_module_function(module, "bessel_jl",  rb_gsl_sf_bessel_jl, 2);
   rb_define_module_function(module, "bessel_jl_e",  rb_gsl_sf_bessel_jl_e, 2);
-  rb_define_module_function(module, "bessel_jl_array",  rb_gsl_sf_bessel_jl_array, 2);
-  rb_define_module_function(module, "bessel_jl_steed_array",  rb_gsl_sf_bessel_jl_steed_array, 2);
-  rb_define_module_function(module, "bessel_y0",  rb_gsl_sf_bessel_y0, 1);
+  rb_define_module_function(module, "bessel_jl_array",  rb_gsl_sf_bessel_jl_array, -1);
+  rb_define_module_function(module, "bessel_jl_steed_array",  rb_gsl_sf_bessel_jl_steed_array, -1);
+  rb_define_module_function(module, "bessel_y0",  rb_gsl_sf_bessel_y0, -1);
   rb_define_module_function(module, "bessel_y0_e",  rb_gsl_sf_bessel_y0_e, 1);
-  rb_define_module_function(module, "bessel_y1",  rb_gsl_sf_bessel_y1, 1);
+  rb_define_module_function(module, "bessel_y1",  rb_gsl_sf_bessel_y1, -1);
   rb_define_module_function(module, "bessel_y1_e",  rb_gsl_sf_bessel_y1_e, 1);
-  rb_define_module_function(module, "bessel_y2",  rb_gsl_sf_bessel_y2, 1);
+  rb_define_module_function(module, "bessel_y2",  rb_gsl_sf_bessel_y2, -1);
   rb_define_module_function(module, "bessel_y2_e",  rb_gsl_sf_bessel_y2_e, 1);
   rb_define_module_function(module, "bessel_yl",  rb_gsl_sf_bessel_yl, 2);
   rb_define_module_function(module, "bessel_yl_e",  rb_gsl_sf_bessel_yl_e, 2);
-  rb_define_module_function(module, "bessel_yl_array",  rb_gsl_sf_bessel_yl_array, 2);
-  rb_define_module_function(module, "bessel_i0_scaled",  rb_gsl_sf_bessel_i0_scaled, 1);
+  rb_define_module_function(module, "bessel_yl_array",  rb_gsl_sf_bessel_yl_array, -1);
+  rb_define_module_function(module, "bessel_i0_scaled",  rb_gsl_sf_bessel_i0_scaled, -1);
   rb_define_module_function(module, "bessel_i0_scaled_e",  rb_gsl_sf_bessel_i0_scaled_e, 1);
-  rb_define_module_function(module, "bessel_i1_scaled",  rb_gsl_sf_bessel_i1_scaled, 1);
+  rb_define_module_function(module, "bessel_i1_scaled",  rb_gsl_sf_bessel_i1_scaled, -1);
   rb_define_module_function(module, "bessel_i1_scaled_e",  rb_gsl_sf_bessel_i1_scaled_e, 1);
-  rb_define_module_function(module, "bessel_i2_scaled",  rb_gsl_sf_bessel_i2_scaled, 1);
+  rb_define_module_function(module, "bessel_i2_scaled",  rb_gsl_sf_bessel_i2_scaled, -1);
   rb_define_module_function(module, "bessel_i2_scaled_e",  rb_gsl_sf_bessel_i2_scaled_e, 1);
   rb_define_module_function(module, "bessel_il_scaled",  rb_gsl_sf_bessel_il_scaled, 2);
   rb_define_module_function(module, "bessel_il_scaled_e",  rb_gsl_sf_bessel_il_scaled_e, 2);
-  rb_define_module_function(module, "bessel_il_scaled_array",  rb_gsl_sf_bessel_il_scaled_array, 2);
-  rb_define_module_function(module, "bessel_k0_scaled",  rb_gsl_sf_bessel_k0_scaled, 1);
+  rb_define_module_function(module, "bessel_il_scaled_array",  rb_gsl_sf_bessel_il_scaled_array, -1);
+  rb_define_module_function(module, "bessel_k0_scaled",  rb_gsl_sf_bessel_k0_scaled, -1);
   rb_define_module_function(module, "bessel_k0_scaled_e",  rb_gsl_sf_bessel_k0_scaled_e, 1);
-  rb_define_module_function(module, "bessel_k1_scaled",  rb_gsl_sf_bessel_k1_scaled, 1);
+  rb_define_module_function(module, "bessel_k1_scaled",  rb_gsl_sf_bessel_k1_scaled, -1);
   rb_define_module_function(module, "bessel_k1_scaled_e",  rb_gsl_sf_bessel_k1_scaled_e, 1);
-  rb_define_module_function(module, "bessel_k2_scaled",  rb_gsl_sf_bessel_k2_scaled, 1);
+  rb_define_module_function(module, "bessel_k2_scaled",  rb_gsl_sf_bessel_k2_scaled, -1);
   rb_define_module_function(module, "bessel_k2_scaled_e",  rb_gsl_sf_bessel_k2_scaled_e, 1);
   rb_define_module_function(module, "bessel_kl_scaled",  rb_gsl_sf_bessel_kl_scaled, 2);
   rb_define_module_function(module, "bessel_kl_scaled_e",  rb_gsl_sf_bessel_kl_scaled_e, 2);
-  rb_define_module_function(module, "bessel_kl_scaled_array",  rb_gsl_sf_bessel_kl_scaled_array, 2);
+  rb_define_module_function(module, "bessel_kl_scaled_array",  rb_gsl_sf_bessel_kl_scaled_array, -1);
   rb_define_module_function(module, "bessel_Jnu",  rb_gsl_sf_bessel_Jnu, 2);
   rb_define_module_function(module, "bessel_Jnu_e",  rb_gsl_sf_bessel_Jnu_e, 2);
   rb_define_module_function(module, "bessel_sequence_Jnu_e",  rb_gsl_sf_bessel_sequence_Jnu_e, -1);
@@ -766,85 +778,85 @@ void Init_gsl_sf_bessel(VALUE module)
   /*******************************/
   mgsl_sf_bessel = rb_define_module_under(module, "Bessel");
 
-  rb_define_module_function(mgsl_sf_bessel, "J0",  rb_gsl_sf_bessel_J0, 1);
+  rb_define_module_function(mgsl_sf_bessel, "J0",  rb_gsl_sf_bessel_J0, -1);
   rb_define_module_function(mgsl_sf_bessel, "J0_e",  rb_gsl_sf_bessel_J0_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "J1",  rb_gsl_sf_bessel_J1, 1);
+  rb_define_module_function(mgsl_sf_bessel, "J1",  rb_gsl_sf_bessel_J1, -1);
   rb_define_module_function(mgsl_sf_bessel, "J1_e",  rb_gsl_sf_bessel_J1_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "Jn",  rb_gsl_sf_bessel_Jn, 2);
   rb_define_module_function(mgsl_sf_bessel, "Jn_e",  rb_gsl_sf_bessel_Jn_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "Jn_array",  rb_gsl_sf_bessel_Jn_array, 3);
-  rb_define_module_function(mgsl_sf_bessel, "Y0",  rb_gsl_sf_bessel_Y0, 1);
+  rb_define_module_function(mgsl_sf_bessel, "Jn_array",  rb_gsl_sf_bessel_Jn_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "Y0",  rb_gsl_sf_bessel_Y0, -1);
   rb_define_module_function(mgsl_sf_bessel, "Y0_e",  rb_gsl_sf_bessel_Y0_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "Y1",  rb_gsl_sf_bessel_Y1, 1);
+  rb_define_module_function(mgsl_sf_bessel, "Y1",  rb_gsl_sf_bessel_Y1, -1);
   rb_define_module_function(mgsl_sf_bessel, "Y1_e",  rb_gsl_sf_bessel_Y1_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "Yn",  rb_gsl_sf_bessel_Yn, 2);
   rb_define_module_function(mgsl_sf_bessel, "Yn_e",  rb_gsl_sf_bessel_Yn_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "Yn_array",  rb_gsl_sf_bessel_Yn_array, 3);
-  rb_define_module_function(mgsl_sf_bessel, "I0",  rb_gsl_sf_bessel_I0, 1);
+  rb_define_module_function(mgsl_sf_bessel, "Yn_array",  rb_gsl_sf_bessel_Yn_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "I0",  rb_gsl_sf_bessel_I0, -1);
   rb_define_module_function(mgsl_sf_bessel, "I0_e",  rb_gsl_sf_bessel_I0_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "I1",  rb_gsl_sf_bessel_I1, 1);
+  rb_define_module_function(mgsl_sf_bessel, "I1",  rb_gsl_sf_bessel_I1, -1);
   rb_define_module_function(mgsl_sf_bessel, "I1_e",  rb_gsl_sf_bessel_I1_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "In",  rb_gsl_sf_bessel_In, 2);
   rb_define_module_function(mgsl_sf_bessel, "In_e",  rb_gsl_sf_bessel_In_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "In_array",  rb_gsl_sf_bessel_In_array, 3);
-  rb_define_module_function(mgsl_sf_bessel, "I0_scaled",  rb_gsl_sf_bessel_I0_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "In_array",  rb_gsl_sf_bessel_In_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "I0_scaled",  rb_gsl_sf_bessel_I0_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "I0_scaled_e",  rb_gsl_sf_bessel_I0_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "I1_scaled",  rb_gsl_sf_bessel_I1_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "I1_scaled",  rb_gsl_sf_bessel_I1_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "I1_scaled_e",  rb_gsl_sf_bessel_I1_scaled_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "In_scaled",  rb_gsl_sf_bessel_In_scaled, 2);
   rb_define_module_function(mgsl_sf_bessel, "In_scaled_e",  rb_gsl_sf_bessel_In_scaled_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "In_scaled_array",  rb_gsl_sf_bessel_In_scaled_array, 3);
-  rb_define_module_function(mgsl_sf_bessel, "K0",  rb_gsl_sf_bessel_K0, 1);
+  rb_define_module_function(mgsl_sf_bessel, "In_scaled_array",  rb_gsl_sf_bessel_In_scaled_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "K0",  rb_gsl_sf_bessel_K0, -1);
   rb_define_module_function(mgsl_sf_bessel, "K0_e",  rb_gsl_sf_bessel_K0_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "K1",  rb_gsl_sf_bessel_K1, 1);
+  rb_define_module_function(mgsl_sf_bessel, "K1",  rb_gsl_sf_bessel_K1, -1);
   rb_define_module_function(mgsl_sf_bessel, "K1_e",  rb_gsl_sf_bessel_K1_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "Kn",  rb_gsl_sf_bessel_Kn, 2);
   rb_define_module_function(mgsl_sf_bessel, "Kn_e",  rb_gsl_sf_bessel_Kn_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "Kn_array",  rb_gsl_sf_bessel_Kn_array, 3);
-  rb_define_module_function(mgsl_sf_bessel, "K0_scaled",  rb_gsl_sf_bessel_K0_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "Kn_array",  rb_gsl_sf_bessel_Kn_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "K0_scaled",  rb_gsl_sf_bessel_K0_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "K0_scaled_e",  rb_gsl_sf_bessel_K0_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "K1_scaled",  rb_gsl_sf_bessel_K1_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "K1_scaled",  rb_gsl_sf_bessel_K1_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "K1_scaled_e",  rb_gsl_sf_bessel_K1_scaled_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "Kn_scaled",  rb_gsl_sf_bessel_Kn_scaled, 2);
   rb_define_module_function(mgsl_sf_bessel, "Kn_scaled_e",  rb_gsl_sf_bessel_Kn_scaled_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "Kn_scaled_array",  rb_gsl_sf_bessel_Kn_scaled_array, 3);
-  rb_define_module_function(mgsl_sf_bessel, "j0",  rb_gsl_sf_bessel_j0, 1);
+  rb_define_module_function(mgsl_sf_bessel, "Kn_scaled_array",  rb_gsl_sf_bessel_Kn_scaled_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "j0",  rb_gsl_sf_bessel_j0, -1);
   rb_define_module_function(mgsl_sf_bessel, "j0_e",  rb_gsl_sf_bessel_j0_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "j1",  rb_gsl_sf_bessel_j1, 1);
+  rb_define_module_function(mgsl_sf_bessel, "j1",  rb_gsl_sf_bessel_j1, -1);
   rb_define_module_function(mgsl_sf_bessel, "j1_e",  rb_gsl_sf_bessel_j1_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "j2",  rb_gsl_sf_bessel_j2, 1);
+  rb_define_module_function(mgsl_sf_bessel, "j2",  rb_gsl_sf_bessel_j2, -1);
   rb_define_module_function(mgsl_sf_bessel, "j2_e",  rb_gsl_sf_bessel_j2_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "jl",  rb_gsl_sf_bessel_jl, 2);
   rb_define_module_function(mgsl_sf_bessel, "jl_e",  rb_gsl_sf_bessel_jl_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "jl_array",  rb_gsl_sf_bessel_jl_array, 2);
-  rb_define_module_function(mgsl_sf_bessel, "jl_steed_array",  rb_gsl_sf_bessel_jl_steed_array, 2);
-  rb_define_module_function(mgsl_sf_bessel, "y0",  rb_gsl_sf_bessel_y0, 1);
+  rb_define_module_function(mgsl_sf_bessel, "jl_array",  rb_gsl_sf_bessel_jl_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "jl_steed_array",  rb_gsl_sf_bessel_jl_steed_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "y0",  rb_gsl_sf_bessel_y0, -1);
   rb_define_module_function(mgsl_sf_bessel, "y0_e",  rb_gsl_sf_bessel_y0_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "y1",  rb_gsl_sf_bessel_y1, 1);
+  rb_define_module_function(mgsl_sf_bessel, "y1",  rb_gsl_sf_bessel_y1, -1);
   rb_define_module_function(mgsl_sf_bessel, "y1_e",  rb_gsl_sf_bessel_y1_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "y2",  rb_gsl_sf_bessel_y2, 1);
+  rb_define_module_function(mgsl_sf_bessel, "y2",  rb_gsl_sf_bessel_y2, -1);
   rb_define_module_function(mgsl_sf_bessel, "y2_e",  rb_gsl_sf_bessel_y2_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "yl",  rb_gsl_sf_bessel_yl, 2);
   rb_define_module_function(mgsl_sf_bessel, "yl_e",  rb_gsl_sf_bessel_yl_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "yl_array",  rb_gsl_sf_bessel_yl_array, 2);
-  rb_define_module_function(mgsl_sf_bessel, "i0_scaled",  rb_gsl_sf_bessel_i0_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "yl_array",  rb_gsl_sf_bessel_yl_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "i0_scaled",  rb_gsl_sf_bessel_i0_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "i0_scaled_e",  rb_gsl_sf_bessel_i0_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "i1_scaled",  rb_gsl_sf_bessel_i1_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "i1_scaled",  rb_gsl_sf_bessel_i1_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "i1_scaled_e",  rb_gsl_sf_bessel_i1_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "i2_scaled",  rb_gsl_sf_bessel_i2_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "i2_scaled",  rb_gsl_sf_bessel_i2_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "i2_scaled_e",  rb_gsl_sf_bessel_i2_scaled_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "il_scaled",  rb_gsl_sf_bessel_il_scaled, 2);
   rb_define_module_function(mgsl_sf_bessel, "il_scaled_e",  rb_gsl_sf_bessel_il_scaled_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "il_scaled_array",  rb_gsl_sf_bessel_il_scaled_array, 2);
-  rb_define_module_function(mgsl_sf_bessel, "k0_scaled",  rb_gsl_sf_bessel_k0_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "il_scaled_array",  rb_gsl_sf_bessel_il_scaled_array, -1);
+  rb_define_module_function(mgsl_sf_bessel, "k0_scaled",  rb_gsl_sf_bessel_k0_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "k0_scaled_e",  rb_gsl_sf_bessel_k0_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "k1_scaled",  rb_gsl_sf_bessel_k1_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "k1_scaled",  rb_gsl_sf_bessel_k1_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "k1_scaled_e",  rb_gsl_sf_bessel_k1_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_bessel, "k2_scaled",  rb_gsl_sf_bessel_k2_scaled, 1);
+  rb_define_module_function(mgsl_sf_bessel, "k2_scaled",  rb_gsl_sf_bessel_k2_scaled, -1);
   rb_define_module_function(mgsl_sf_bessel, "k2_scaled_e",  rb_gsl_sf_bessel_k2_scaled_e, 1);
   rb_define_module_function(mgsl_sf_bessel, "kl_scaled",  rb_gsl_sf_bessel_kl_scaled, 2);
   rb_define_module_function(mgsl_sf_bessel, "kl_scaled_e",  rb_gsl_sf_bessel_kl_scaled_e, 2);
-  rb_define_module_function(mgsl_sf_bessel, "kl_scaled_array",  rb_gsl_sf_bessel_kl_scaled_array, 2);
+  rb_define_module_function(mgsl_sf_bessel, "kl_scaled_array",  rb_gsl_sf_bessel_kl_scaled_array, -1);
   rb_define_module_function(mgsl_sf_bessel, "Jnu",  rb_gsl_sf_bessel_Jnu, 2);
   rb_define_module_function(mgsl_sf_bessel, "Jnu_e",  rb_gsl_sf_bessel_Jnu_e, 2);
   rb_define_module_function(mgsl_sf_bessel, "sequence_Jnu_e",  rb_gsl_sf_bessel_sequence_Jnu_e, 3);
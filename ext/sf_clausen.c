@@ -11,9 +11,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_clausen(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_clausen(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_clausen, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_clausen, argc, argv);
 }
 
 static VALUE rb_gsl_sf_clausen_e(VALUE obj, VALUE x)
@@ -23,6 +23,6 @@ static VALUE rb_gsl_sf_clausen_e(VALUE obj, VALUE x)
 
 void Init_gsl_sf_clausen(VALUE module)
 {
-  rb_define_module_function(module, "clausen",  rb_gsl_sf_clausen, 1);
+  rb_define_module_function(module, "clausen",  rb_gsl_sf_clausen, -1);
   rb_define_module_function(module, "clausen_e",  rb_gsl_sf_clausen_e, 1);
 }
@@ -65,93 +65,64 @@ static VALUE rb_gsl_sf_coulomb_wave_FG_e(VALUE obj, VALUE eta, VALUE x,
 		     rb_float_new(exp_F), rb_float_new(exp_G), INT2FIX(status));
 }
 
-static VALUE rb_gsl_sf_coulomb_wave_F_array(VALUE obj, VALUE Lmin, VALUE kmax,
-					 VALUE eta, VALUE x)
+/*
+  The coulomb arrays, for L = Lmin .. Lmin + kmax: wave_F_array(Lmin, kmax,
+  eta, x[, out]) gives [F, F_exponent, status], wave_FG_array [F, G,
+  F_exponent, G_exponent, status], wave_FGp_array [F, Fp, G, Gp,
+  F_exponent, G_exponent, status], wave_sphF_array [F, F_exponents,
+  status]. x a Vector or an Array gives a Matrix for each array, a row
+  for each x, and a Vector for each exponent.
+*/
+static int mygsl_sf_coulomb_wave_fill(const mygsl_sf_array *a, double x, double **y, double *e)
 {
-  double F_exponent;
-  int status;
-  size_t size;
-  gsl_vector *v = NULL;
-  CHECK_FIXNUM(kmax);
-  Need_Float(Lmin); Need_Float(eta); Need_Float(x);
-  size = FIX2INT(kmax);
-  v = gsl_vector_alloc(size);
-  status = gsl_sf_coulomb_wave_F_array(NUM2DBL(Lmin), size, NUM2DBL(eta), 
-				   NUM2DBL(x), v->data, &F_exponent);
-  
-  return rb_ary_new3(3, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v), 
-		     rb_float_new(F_exponent), INT2FIX(status));
+  double L = a->d0, eta = a->d1;
+  int kmax = a->i0;
+  switch (a->i1) {
+  case 0: return gsl_sf_coulomb_wave_F_array(L, kmax, eta, x, y[0], e);
+  case 1: return gsl_sf_coulomb_wave_FG_array(L, kmax, eta, x, y[0], y[1], e, e + 1);
+  case 2: return gsl_sf_coulomb_wave_FGp_array(L, kmax, eta, x, y[0], y[1], y[2], y[3], e, e + 1);
+  default: return gsl_sf_coulomb_wave_sphF_array(L, kmax, eta, x, y[0], y[1]);
+  }
 }
 
-static VALUE rb_gsl_sf_coulomb_wave_FG_array(VALUE obj, VALUE Lmin, VALUE kmax,
-					 VALUE eta, VALUE x)
+static VALUE rb_gsl_sf_coulomb_wave_array(int argc, VALUE *argv, int kind,
+					  size_t nout, size_t nexp)
 {
-  double F_exponent, G_exponent;
-  int status;
-  size_t size;
-  gsl_vector *vf = NULL, *vg = NULL;
-  VALUE fary, gary;
-  CHECK_FIXNUM(kmax);
-  Need_Float(Lmin); Need_Float(eta); Need_Float(x);
-  size = FIX2INT(kmax);
-  vf = gsl_vector_alloc(size);
-  vg = gsl_vector_alloc(size);
-
-  status = gsl_sf_coulomb_wave_FG_array(NUM2DBL(Lmin), size, NUM2DBL(eta), 
-				   NUM2DBL(x), vf->data, vg->data,
-				    &F_exponent, &G_exponent);
-  fary = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vf);
-  gary = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vf);
-  return rb_ary_new3(5, fary, gary,
-		     rb_float_new(F_exponent), rb_float_new(G_exponent),
-		     INT2FIX(status));
+  mygsl_sf_array a;
+  if (argc < 4 || argc > 4 + (int) nout)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 4..%d)", argc, 4 + (int) nout);
+  CHECK_FIXNUM(argv[1]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_coulomb_wave_fill;
+  a.d0 = NUM2DBL(argv[0]);
+  a.d1 = NUM2DBL(argv[2]);
+  a.i0 = FIX2INT(argv[1]);
+  a.i1 = kind;
+  a.size = a.i0 >= 0 ? a.i0 + 1 : 0;
+  a.nout = nout;
+  a.nexp = nexp;
+  a.status = 1;
+  return rb_gsl_sf_array_eval(&a, argv[3], argc - 4, argv + 4);
 }
 
-static VALUE rb_gsl_sf_coulomb_wave_FGp_array(VALUE obj, VALUE Lmin, VALUE kmax,
-					 VALUE eta, VALUE x)
+static VALUE rb_gsl_sf_coulomb_wave_F_array(int argc, VALUE *argv, VALUE obj)
 {
-  double F_exponent, G_exponent;
-  int status;
-  size_t size;
-  gsl_vector *vf = NULL, *vg = NULL, *vfp = NULL, *vgp = NULL;
-  VALUE fary, gary, fpary, gpary;
-  CHECK_FIXNUM(kmax);
-  Need_Float(Lmin); Need_Float(eta); Need_Float(x);
-  size = FIX2INT(kmax);
-  vf = gsl_vector_alloc(size);
-  vfp = gsl_vector_alloc(size);
-  vg = gsl_vector_alloc(size);
-  vgp = gsl_vector_alloc(size);
-
-  status = gsl_sf_coulomb_wave_FGp_array(NUM2DBL(Lmin), size, NUM2DBL(eta), 
-				     NUM2DBL(x), vf->data, vfp->data, 
-				     vg->data, vgp->data,
-				     &F_exponent, &G_exponent);
-  fary = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vf);
-  fpary =Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vfp);
-  gary = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vg);
-  gpary =Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vgp);
-  return rb_ary_new3(7, fary, fpary, gary, gpary,
-		     rb_float_new(F_exponent), rb_float_new(G_exponent),
-		     INT2FIX(status));
+  return rb_gsl_sf_coulomb_wave_array(argc, argv, 0, 1, 1);
 }
 
-static VALUE rb_gsl_sf_coulomb_wave_sphF_array(VALUE obj, VALUE Lmin, VALUE kmax,
-					 VALUE eta, VALUE x)
+static VALUE rb_gsl_sf_coulomb_wave_FG_array(int argc, VALUE *argv, VALUE obj)
 {
-  int status;
-  size_t size;
-  gsl_vector *v = NULL, *v2 = NULL;
-  CHECK_FIXNUM(kmax);
-  Need_Float(Lmin); Need_Float(eta); Need_Float(x);
-  size = FIX2INT(kmax);
-  v = gsl_vector_alloc(size);
-  v2 = gsl_vector_alloc(size);
-  status =  gsl_sf_coulomb_wave_sphF_array(NUM2DBL(Lmin), size, NUM2DBL(eta), 
-				       NUM2DBL(x), v->data, v2->data);
-  return rb_ary_new3(3, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v), 
-		     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v2), 
-		     INT2FIX(status));
+  return rb_gsl_sf_coulomb_wave_array(argc, argv, 1, 2, 2);
+}
+
+static VALUE rb_gsl_sf_coulomb_wave_FGp_array(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_coulomb_wave_array(argc, argv, 2, 4, 2);
+}
+
+static VALUE rb_gsl_sf_coulomb_wave_sphF_array(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_coulomb_wave_array(argc, argv, 3, 2, 0);
 }
 
 static VALUE rb_gsl_sf_coulomb_CL_e(VALUE obj, VALUE L, VALUE eta)
@@ -159,19 +130,25 @@ static VALUE rb_gsl_sf_coulomb_CL_e(VALUE obj, VALUE L, VALUE eta)
   return rb_gsl_sf_eval_e_double2(gsl_sf_coulomb_CL_e, L, eta);
 }
 
-static VALUE rb_gsl_sf_coulomb_CL_array(VALUE obj, VALUE Lmin, VALUE kmax,
-					VALUE eta)
+static int mygsl_sf_coulomb_CL_fill(const mygsl_sf_array *a, double eta, double **y, double *e)
 {
-  gsl_vector *v = NULL;
-  size_t size;
-  // local variable "status" declared and set, but never used
-  //int status;
-  CHECK_FIXNUM(kmax);
-  Need_Float(Lmin); Need_Float(eta); 
-  size = FIX2INT(kmax);
-  v = gsl_vector_alloc(size);
-  /*status =*/ gsl_sf_coulomb_CL_array(NUM2DBL(Lmin), size, NUM2DBL(eta), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  return gsl_sf_coulomb_CL_array(a->d0, a->i0, eta, y[0]);
+}
+
+/* CL_array(Lmin, kmax, eta[, out]), eta a Vector or an Array too */
+static VALUE rb_gsl_sf_coulomb_CL_array(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_sf_array a;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  CHECK_FIXNUM(argv[1]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_coulomb_CL_fill;
+  a.d0 = NUM2DBL(argv[0]);
+  a.i0 = FIX2INT(argv[1]);
+  a.size = a.i0 >= 0 ? a.i0 + 1 : 0;
+  a.nout = 1;
+  return rb_gsl_sf_array_eval(&a, argv[2], argc - 3, argv + 3);
 }
 
 void Init_gsl_sf_coulomb(VALUE module)
@@ -183,12 +160,12 @@ void Init_gsl_sf_coulomb(VALUE module)
   rb_define_module_function(module, "hydrogenicR",  rb_gsl_sf_hydrogenicR, 4);
   rb_define_module_function(module, "hydrogenicR_e",  rb_gsl_sf_hydrogenicR_e, 4);
   rb_define_module_function(module, "coulomb_wave_FG_e",  rb_gsl_sf_coulomb_wave_FG_e, 4);
-  rb_define_module_function(module, "coulomb_wave_F_array",  rb_gsl_sf_coulomb_wave_F_array, 4);
-  rb_define_module_function(module, "coulomb_wave_FG_array",  rb_gsl_sf_coulomb_wave_FG_array, 4);
-  rb_define_module_function(module, "coulomb_wave_FGp_array",  rb_gsl_sf_coulomb_wave_FGp_array, 4);
-  rb_define_module_function(module, "coulomb_wave_sphF_array ",  rb_gsl_sf_coulomb_wave_sphF_array, 4);
+  rb_define_module_function(module, "coulomb_wave_F_array",  rb_gsl_sf_coulomb_wave_F_array, -1);
+  rb_define_module_function(module, "coulomb_wave_FG_array",  rb_gsl_sf_coulomb_wave_FG_array, -1);
+  rb_define_module_function(module, "coulomb_wave_FGp_array",  rb_gsl_sf_coulomb_wave_FGp_array, -1);
+  rb_define_module_function(module, "coulomb_wave_sphF_array",  rb_gsl_sf_coulomb_wave_sphF_array, -1);
   rb_define_module_function(module, "coulomb_CL_e",  rb_gsl_sf_coulomb_CL_e, 2);
-  rb_define_module_function(module, "coulomb_CL_array",  rb_gsl_sf_coulomb_CL_array, 3);
+  rb_define_module_function(module, "coulomb_CL_array",  rb_gsl_sf_coulomb_CL_array, -1);
 
   mgsl_sf_coulomb = rb_define_module_under(module, "Coulomb");
   
@@ -197,10 +174,10 @@ void Init_gsl_sf_coulomb(VALUE module)
   rb_define_module_function(mgsl_sf_coulomb, "hydrogenicR",  rb_gsl_sf_hydrogenicR, 4);
   rb_define_module_function(mgsl_sf_coulomb, "hydrogenicR_e",  rb_gsl_sf_hydrogenicR_e, 4);
   rb_define_module_function(mgsl_sf_coulomb, "wave_FG_e",  rb_gsl_sf_coulomb_wave_FG_e, 4);
-  rb_define_module_function(mgsl_sf_coulomb, "wave_F_array",  rb_gsl_sf_coulomb_wave_F_array, 4);
-  rb_define_module_function(mgsl_sf_coulomb, "wave_FG_array",  rb_gsl_sf_coulomb_wave_FG_array, 4);
-  rb_define_module_function(mgsl_sf_coulomb, "wave_FGp_array",  rb_gsl_sf_coulomb_wave_FGp_array, 4);
-  rb_define_module_function(mgsl_sf_coulomb, "wave_sphF_array ",  rb_gsl_sf_coulomb_wave_sphF_array, 4);
+  rb_define_module_function(mgsl_sf_coulomb, "wave_F_array",  rb_gsl_sf_coulomb_wave_F_array, -1);
+  rb_define_module_function(mgsl_sf_coulomb, "wave_FG_array",  rb_gsl_sf_coulomb_wave_FG_array, -1);
+  rb_define_module_function(mgsl_sf_coulomb, "wave_FGp_array",  rb_gsl_sf_coulomb_wave_FGp_array, -1);
+  rb_define_module_function(mgsl_sf_coulomb, "wave_sphF_array",  rb_gsl_sf_coulomb_wave_sphF_array, -1);
   rb_define_module_function(mgsl_sf_coulomb, "CL_e",  rb_gsl_sf_coulomb_CL_e, 2);
-  rb_define_module_function(mgsl_sf_coulomb, "CL_array",  rb_gsl_sf_coulomb_CL_array, 3);
+  rb_define_module_function(mgsl_sf_coulomb, "CL_array",  rb_gsl_sf_coulomb_CL_array, -1);
 }
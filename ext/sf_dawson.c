@@ -12,9 +12,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_dawson(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_dawson(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_dawson, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_dawson, argc, argv);
 }
 
 static VALUE rb_gsl_sf_dawson_e(VALUE obj, VALUE x)
@@ -24,6 +24,6 @@ static VALUE rb_gsl_sf_dawson_e(VALUE obj, VALUE x)
 
 void Init_gsl_sf_dawson(VALUE module)
 {
-  rb_define_module_function(module, "dawson",  rb_gsl_sf_dawson, 1);
+  rb_define_module_function(module, "dawson",  rb_gsl_sf_dawson, -1);
   rb_define_module_function(module, "dawson_e",  rb_gsl_sf_dawson_e, 1);
 }
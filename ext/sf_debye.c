@@ -12,9 +12,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_debye_1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_debye_1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_debye_1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_debye_1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_debye_1_e(VALUE obj, VALUE x)
@@ -22,9 +22,9 @@ static VALUE rb_gsl_sf_debye_1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_debye_1_e, x);
 }
 
-static VALUE rb_gsl_sf_debye_2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_debye_2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_debye_2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_debye_2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_debye_2_e(VALUE obj, VALUE x)
@@ -32,9 +32,9 @@ static VALUE rb_gsl_sf_debye_2_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_debye_2_e, x);
 }
 
-static VALUE rb_gsl_sf_debye_3(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_debye_3(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_debye_3, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_debye_3, argc, argv);
 }
 
 static VALUE rb_gsl_sf_debye_3_e(VALUE obj, VALUE x)
@@ -42,9 +42,9 @@ static VALUE rb_gsl_sf_debye_3_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_debye_3_e, x);
 }
 
-static VALUE rb_gsl_sf_debye_4(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_debye_4(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_debye_4, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_debye_4, argc, argv);
 }
 
 static VALUE rb_gsl_sf_debye_4_e(VALUE obj, VALUE x)
@@ -98,18 +98,18 @@ static VALUE rb_gsl_sf_debye_n(int argc, VALUE *argv, VALUE obj)
 }
 
 #ifdef GSL_1_8_LATER
-static VALUE rb_gsl_sf_debye_5(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_debye_5(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_debye_5, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_debye_5, argc, argv);
 }
 
 static VALUE rb_gsl_sf_debye_5_e(VALUE obj, VALUE x)
 {
   return rb_gsl_sf_eval_e(gsl_sf_debye_5_e, x);
 }
-static VALUE rb_gsl_sf_debye_6(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_debye_6(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_debye_6, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_debye_6, argc, argv);
 }
 
 static VALUE rb_gsl_sf_debye_6_e(VALUE obj, VALUE x)
@@ -122,35 +122,35 @@ static VALUE rb_gsl_sf_debye_6_e(VALUE obj, VALUE x)
 void Init_gsl_sf_debye(VALUE module)
 {
   VALUE mgsl_sf_debye;
-  rb_define_module_function(module, "debye_1",  rb_gsl_sf_debye_1, 1);
+  rb_define_module_function(module, "debye_1",  rb_gsl_sf_debye_1, -1);
   rb_define_module_function(module, "debye_1_e",  rb_gsl_sf_debye_1_e, 1);
-  rb_define_module_function(module, "debye_2",  rb_gsl_sf_debye_2, 1);
+  rb_define_module_function(module, "debye_2",  rb_gsl_sf_debye_2, -1);
   rb_define_module_function(module, "debye_2_e",  rb_gsl_sf_debye_2_e, 1);
-  rb_define_module_function(module, "debye_3",  rb_gsl_sf_debye_3, 1);
+  rb_define_module_function(module, "debye_3",  rb_gsl_sf_debye_3, -1);
   rb_define_module_function(module, "debye_3_e",  rb_gsl_sf_debye_3_e, 1);
-  rb_define_module_function(module, "debye_4",  rb_gsl_sf_debye_4, 1);
+  rb_define_module_function(module, "debye_4",  rb_gsl_sf_debye_4, -1);
   rb_define_module_function(module, "debye_4_e",  rb_gsl_sf_debye_4_e, 1);
 #ifdef GSL_1_8_LATER
-  rb_define_module_function(module, "debye_5",  rb_gsl_sf_debye_5, 1);
+  rb_define_module_function(module, "debye_5",  rb_gsl_sf_debye_5, -1);
   rb_define_module_function(module, "debye_5_e",  rb_gsl_sf_debye_5_e, 1);
-  rb_define_module_function(module, "debye_6",  rb_gsl_sf_debye_6, 1);
+  rb_define_module_function(module, "debye_6",  rb_gsl_sf_debye_6, -1);
   rb_define_module_function(module, "debye_6_e",  rb_gsl_sf_debye_6_e, 1);
 #endif
   rb_define_module_function(module, "debye_n",  rb_gsl_sf_debye_n, -1);
 
   mgsl_sf_debye = rb_define_module_under(module, "Debye");
-  rb_define_module_function(mgsl_sf_debye, "one",  rb_gsl_sf_debye_1, 1);
+  rb_define_module_function(mgsl_sf_debye, "one",  rb_gsl_sf_debye_1, -1);
   rb_define_module_function(mgsl_sf_debye, "one_e",  rb_gsl_sf_debye_1_e, 1);
-  rb_define_module_function(mgsl_sf_debye, "two",  rb_gsl_sf_debye_2, 1);
+  rb_define_module_function(mgsl_sf_debye, "two",  rb_gsl_sf_debye_2, -1);
   rb_define_module_function(mgsl_sf_debye, "two_e",  rb_gsl_sf_debye_2_e, 1);
-  rb_define_module_function(mgsl_sf_debye, "three",  rb_gsl_sf_debye_3, 1);
+  rb_define_module_function(mgsl_sf_debye, "three",  rb_gsl_sf_debye_3, -1);
   rb_define_module_function(mgsl_sf_debye, "three_e",  rb_gsl_sf_debye_3_e, 1);
-  rb_define_module_function(mgsl_sf_debye, "four",  rb_gsl_sf_debye_4, 1);
+  rb_define_module_function(mgsl_sf_debye, "four",  rb_gsl_sf_debye_4, -1);
   rb_define_module_function(mgsl_sf_debye, "four_e",  rb_gsl_sf_debye_4_e, 1);
 #ifdef GSL_1_8_LATER
-  rb_define_module_function(mgsl_sf_debye, "five",  rb_gsl_sf_debye_5, 1);
+  rb_define_module_function(mgsl_sf_debye, "five",  rb_gsl_sf_debye_5, -1);
   rb_define_module_function(mgsl_sf_debye, "five_e",  rb_gsl_sf_debye_5_e, 1);
-  rb_define_module_function(mgsl_sf_debye, "six",  rb_gsl_sf_debye_6, 1);
+  rb_define_module_function(mgsl_sf_debye, "six",  rb_gsl_sf_debye_6, -1);
   rb_define_module_function(mgsl_sf_debye, "six_e",  rb_gsl_sf_debye_6_e, 1);
 #endif
   rb_define_module_function(mgsl_sf_debye, "n",  rb_gsl_sf_debye_n, -1);
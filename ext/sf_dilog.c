@@ -12,9 +12,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_dilog(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_dilog(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_dilog, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_dilog, argc, argv);
 }
 
 static VALUE rb_gsl_sf_dilog_e(VALUE obj, VALUE x)
@@ -35,9 +35,17 @@ static VALUE rb_gsl_sf_complex_dilog_e(VALUE obj, VALUE r, VALUE theta)
   return rb_ary_new3(2, vre, vim);
 }
 
+/* complex_dilog(z[, out]): Li2(z), z a GSL::Complex, Vector::Complex
+   or Matrix::Complex */
+static VALUE rb_gsl_sf_complex_dilog(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval_complex_e(gsl_sf_complex_dilog_e, 1, argc, argv);
+}
+
 void Init_gsl_sf_dilog(VALUE module)
 {
-  rb_define_module_function(module, "dilog",  rb_gsl_sf_dilog, 1);
+  rb_define_module_function(module, "dilog",  rb_gsl_sf_dilog, -1);
   rb_define_module_function(module, "dilog_e",  rb_gsl_sf_dilog_e, 1);
   rb_define_module_function(module, "complex_dilog_e",  rb_gsl_sf_complex_dilog_e, 2);
+  rb_define_module_function(module, "complex_dilog",  rb_gsl_sf_complex_dilog, -1);
 }
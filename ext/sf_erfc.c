@@ -12,9 +12,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_erf(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_erf(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_erf, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_erf, argc, argv);
 }
 
 static VALUE rb_gsl_sf_erf_e(VALUE obj, VALUE x)
@@ -22,9 +22,9 @@ static VALUE rb_gsl_sf_erf_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_erf_e, x);
 }
 
-static VALUE rb_gsl_sf_erfc(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_erfc(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_erfc, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_erfc, argc, argv);
 }
 
 static VALUE rb_gsl_sf_erfc_e(VALUE obj, VALUE x)
@@ -32,9 +32,9 @@ static VALUE rb_gsl_sf_erfc_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_erfc_e, x);
 }
 
-static VALUE rb_gsl_sf_log_erfc(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_log_erfc(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_log_erfc, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_log_erfc, argc, argv);
 }
 
 static VALUE rb_gsl_sf_log_erfc_e(VALUE obj, VALUE x)
@@ -42,9 +42,9 @@ static VALUE rb_gsl_sf_log_erfc_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_log_erfc_e, x);
 }
 
-static VALUE rb_gsl_sf_erf_Z(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_erf_Z(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_erf_Z, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_erf_Z, argc, argv);
 }
 
 static VALUE rb_gsl_sf_erf_Z_e(VALUE obj, VALUE x)
@@ -52,9 +52,9 @@ static VALUE rb_gsl_sf_erf_Z_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_erf_Z_e, x);
 }
 
-static VALUE rb_gsl_sf_erf_Q(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_erf_Q(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_erf_Q, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_erf_Q, argc, argv);
 }
 
 static VALUE rb_gsl_sf_erf_Q_e(VALUE obj, VALUE x)
@@ -63,9 +63,9 @@ static VALUE rb_gsl_sf_erf_Q_e(VALUE obj, VALUE x)
 }
 
 #ifdef GSL_1_4_LATER
-static VALUE rb_gsl_sf_hazard(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_hazard(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_hazard, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_hazard, argc, argv);
 }
 
 static VALUE rb_gsl_sf_hazard_e(VALUE obj, VALUE x)
@@ -76,18 +76,18 @@ static VALUE rb_gsl_sf_hazard_e(VALUE obj, VALUE x)
 
 void Init_gsl_sf_erfc(VALUE module)
 {
-  rb_define_module_function(module, "erf",  rb_gsl_sf_erf, 1);
+  rb_define_module_function(module, "erf",  rb_gsl_sf_erf, -1);
   rb_define_module_function(module, "erf_e",  rb_gsl_sf_erf_e, 1);
-  rb_define_module_function(module, "erfc",  rb_gsl_sf_erfc, 1);
+  rb_define_module_function(module, "erfc",  rb_gsl_sf_erfc, -1);
   rb_define_module_function(module, "erfc_e",  rb_gsl_sf_erfc_e, 1);
-  rb_define_module_function(module, "log_erfc",  rb_gsl_sf_log_erfc, 1);
+  rb_define_module_function(module, "log_erfc",  rb_gsl_sf_log_erfc, -1);
   rb_define_module_function(module, "log_erfc_e",  rb_gsl_sf_log_erfc_e, 1);
-  rb_define_module_function(module, "erf_Z",  rb_gsl_sf_erf_Z, 1);
+  rb_define_module_function(module, "erf_Z",  rb_gsl_sf_erf_Z, -1);
   rb_define_module_function(module, "erf_Z_e",  rb_gsl_sf_erf_Z_e, 1);
-  rb_define_module_function(module, "erf_Q",  rb_gsl_sf_erf_Q, 1);
+  rb_define_module_function(module, "erf_Q",  rb_gsl_sf_erf_Q, -1);
   rb_define_module_function(module, "erf_Q_e",  rb_gsl_sf_erf_Q_e, 1);
 #ifdef GSL_1_4_LATER
-  rb_define_module_function(module, "hazard",  rb_gsl_sf_hazard, 1);
+  rb_define_module_function(module, "hazard",  rb_gsl_sf_hazard, -1);
   rb_define_module_function(module, "hazard_e",  rb_gsl_sf_hazard_e, 1);
 #endif
 }
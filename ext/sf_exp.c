@@ -61,9 +61,9 @@ static VALUE rb_gsl_sf_exp_mult_e10_e(VALUE obj, VALUE x, VALUE y)
   return v;
 }
 
-static VALUE rb_gsl_sf_expm1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expm1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expm1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expm1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expm1_e(VALUE obj, VALUE x)
@@ -71,9 +71,9 @@ static VALUE rb_gsl_sf_expm1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expm1_e, x);
 }
 
-static VALUE rb_gsl_sf_exprel(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_exprel(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_exprel, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_exprel, argc, argv);
 }
 
 static VALUE rb_gsl_sf_exprel_e(VALUE obj, VALUE x)
@@ -81,9 +81,9 @@ static VALUE rb_gsl_sf_exprel_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_exprel_e, x);
 }
 
-static VALUE rb_gsl_sf_exprel_2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_exprel_2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_exprel_2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_exprel_2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_exprel_2_e(VALUE obj, VALUE x)
@@ -154,11 +154,11 @@ void Init_gsl_sf_exp(VALUE module)
   rb_define_module_function(module, "exp_mult",  rb_gsl_sf_exp_mult, 2);
   rb_define_module_function(module, "exp_mult_e",  rb_gsl_sf_exp_mult_e, 2);
   rb_define_module_function(module, "exp_mult_e10_e",  rb_gsl_sf_exp_mult_e10_e, 2);
-  rb_define_module_function(module, "expm1",  rb_gsl_sf_expm1, 1);
+  rb_define_module_function(module, "expm1",  rb_gsl_sf_expm1, -1);
   rb_define_module_function(module, "expm1_e",  rb_gsl_sf_expm1_e, 1);
-  rb_define_module_function(module, "exprel",  rb_gsl_sf_exprel, 1);
+  rb_define_module_function(module, "exprel",  rb_gsl_sf_exprel, -1);
   rb_define_module_function(module, "exprel_e",  rb_gsl_sf_exprel_e, 1);
-  rb_define_module_function(module, "exprel_2",  rb_gsl_sf_exprel_2, 1);
+  rb_define_module_function(module, "exprel_2",  rb_gsl_sf_exprel_2, -1);
   rb_define_module_function(module, "exprel_2_e",  rb_gsl_sf_exprel_2_e, 1);
   rb_define_module_function(module, "exprel_n",  rb_gsl_sf_exprel_n, 2);
   rb_define_module_function(module, "exprel_n_e",  rb_gsl_sf_exprel_n_e, 2);
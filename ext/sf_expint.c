@@ -12,9 +12,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_expint_E1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_E1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_E1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_E1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_E1_e(VALUE obj, VALUE x)
@@ -22,9 +22,9 @@ static VALUE rb_gsl_sf_expint_E1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expint_E1_e, x);
 }
 
-static VALUE rb_gsl_sf_expint_E2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_E2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_E2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_E2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_E2_e(VALUE obj, VALUE x)
@@ -32,9 +32,9 @@ static VALUE rb_gsl_sf_expint_E2_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expint_E2_e, x);
 }
 
-static VALUE rb_gsl_sf_expint_Ei(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_Ei(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_Ei, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_Ei, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_Ei_e(VALUE obj, VALUE x)
@@ -42,9 +42,9 @@ static VALUE rb_gsl_sf_expint_Ei_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expint_Ei_e, x);
 }
 
-static VALUE rb_gsl_sf_Shi(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_Shi(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_Shi, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_Shi, argc, argv);
 }
 
 static VALUE rb_gsl_sf_Shi_e(VALUE obj, VALUE x)
@@ -52,9 +52,9 @@ static VALUE rb_gsl_sf_Shi_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_Shi_e, x);
 }
 
-static VALUE rb_gsl_sf_Chi(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_Chi(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_Chi, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_Chi, argc, argv);
 }
 
 static VALUE rb_gsl_sf_Chi_e(VALUE obj, VALUE x)
@@ -62,9 +62,9 @@ static VALUE rb_gsl_sf_Chi_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_Chi_e, x);
 }
 
-static VALUE rb_gsl_sf_expint_3(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_3(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_3, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_3, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_3_e(VALUE obj, VALUE x)
@@ -72,9 +72,9 @@ static VALUE rb_gsl_sf_expint_3_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expint_3_e, x);
 }
 
-static VALUE rb_gsl_sf_Si(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_Si(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_Si, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_Si, argc, argv);
 }
 
 static VALUE rb_gsl_sf_Si_e(VALUE obj, VALUE x)
@@ -82,9 +82,9 @@ static VALUE rb_gsl_sf_Si_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_Si_e, x);
 }
 
-static VALUE rb_gsl_sf_Ci(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_Ci(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_Ci, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_Ci, argc, argv);
 }
 
 static VALUE rb_gsl_sf_Ci_e(VALUE obj, VALUE x)
@@ -92,9 +92,9 @@ static VALUE rb_gsl_sf_Ci_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_Ci_e, x);
 }
 
-static VALUE rb_gsl_sf_atanint(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_atanint(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_atanint, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_atanint, argc, argv);
 }
 
 static VALUE rb_gsl_sf_atanint_e(VALUE obj, VALUE x)
@@ -103,9 +103,9 @@ static VALUE rb_gsl_sf_atanint_e(VALUE obj, VALUE x)
 }
 
 #ifdef GSL_1_3_LATER
-static VALUE rb_gsl_sf_expint_E1_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_E1_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_E1_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_E1_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_E1_scaled_e(VALUE obj, VALUE x)
@@ -113,9 +113,9 @@ static VALUE rb_gsl_sf_expint_E1_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expint_E1_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_expint_E2_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_E2_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_E2_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_E2_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_E2_scaled_e(VALUE obj, VALUE x)
@@ -123,9 +123,9 @@ static VALUE rb_gsl_sf_expint_E2_scaled_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_expint_E2_scaled_e, x);
 }
 
-static VALUE rb_gsl_sf_expint_Ei_scaled(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_expint_Ei_scaled(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_expint_Ei_scaled, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_expint_Ei_scaled, argc, argv);
 }
 
 static VALUE rb_gsl_sf_expint_Ei_scaled_e(VALUE obj, VALUE x)
@@ -154,50 +154,50 @@ void Init_gsl_sf_expint(VALUE module)
 {
   VALUE mgsl_sf_expint;
 
-  rb_define_module_function(module, "expint_E1",  rb_gsl_sf_expint_E1, 1);
+  rb_define_module_function(module, "expint_E1",  rb_gsl_sf_expint_E1, -1);
   rb_define_module_function(module, "expint_E1_e",  rb_gsl_sf_expint_E1_e, 1);
-  rb_define_module_function(module, "expint_E2",  rb_gsl_sf_expint_E2, 1);
+  rb_define_module_function(module, "expint_E2",  rb_gsl_sf_expint_E2, -1);
   rb_define_module_function(module, "expint_E2_e",  rb_gsl_sf_expint_E2_e, 1);
-  rb_define_module_function(module, "expint_Ei",  rb_gsl_sf_expint_Ei, 1);
+  rb_define_module_function(module, "expint_Ei",  rb_gsl_sf_expint_Ei, -1);
   rb_define_module_function(module, "expint_Ei_e",  rb_gsl_sf_expint_Ei_e, 1);
 
-  rb_define_module_function(module, "Shi",  rb_gsl_sf_Shi, 1);
+  rb_define_module_function(module, "Shi",  rb_gsl_sf_Shi, -1);
   rb_define_module_function(module, "Shi_e",  rb_gsl_sf_Shi_e, 1);
-  rb_define_module_function(module, "Chi",  rb_gsl_sf_Chi, 1);
+  rb_define_module_function(module, "Chi",  rb_gsl_sf_Chi, -1);
   rb_define_module_function(module, "Chi_e",  rb_gsl_sf_Chi_e, 1);
-  rb_define_module_function(module, "expint_3",  rb_gsl_sf_expint_3, 1);
+  rb_define_module_function(module, "expint_3",  rb_gsl_sf_expint_3, -1);
   rb_define_module_function(module, "expint_3_e",  rb_gsl_sf_expint_3_e, 1);
-  rb_define_module_function(module, "Si",  rb_gsl_sf_Si, 1);
+  rb_define_module_function(module, "Si",  rb_gsl_sf_Si, -1);
   rb_define_module_function(module, "Si_e",  rb_gsl_sf_Si_e, 1);
-  rb_define_module_function(module, "Ci",  rb_gsl_sf_Ci, 1);
+  rb_define_module_function(module, "Ci",  rb_gsl_sf_Ci, -1);
   rb_define_module_function(module, "Ci_e",  rb_gsl_sf_Ci_e, 1);
-  rb_define_module_function(module, "atanint",  rb_gsl_sf_atanint, 1);
+  rb_define_module_function(module, "atanint",  rb_gsl_sf_atanint, -1);
   rb_define_module_function(module, "atanint_e",  rb_gsl_sf_atanint_e, 1);
 
 
   mgsl_sf_expint = rb_define_module_under(module, "Expint");
-  rb_define_module_function(mgsl_sf_expint, "E1",  rb_gsl_sf_expint_E1, 1);
+  rb_define_module_function(mgsl_sf_expint, "E1",  rb_gsl_sf_expint_E1, -1);
   rb_define_module_function(mgsl_sf_expint, "E1_e",  rb_gsl_sf_expint_E1_e, 1);
-  rb_define_module_function(mgsl_sf_expint, "E2",  rb_gsl_sf_expint_E2, 1);
+  rb_define_module_function(mgsl_sf_expint, "E2",  rb_gsl_sf_expint_E2, -1);
   rb_define_module_function(mgsl_sf_expint, "E2_e",  rb_gsl_sf_expint_E2_e, 1);
-  rb_define_module_function(mgsl_sf_expint, "Ei",  rb_gsl_sf_expint_Ei, 1);
+  rb_define_module_function(mgsl_sf_expint, "Ei",  rb_gsl_sf_expint_Ei, -1);
   rb_define_module_function(mgsl_sf_expint, "Ei_e",  rb_gsl_sf_expint_Ei_e, 1);
-  rb_define_module_function(mgsl_sf_expint, "three",  rb_gsl_sf_expint_3, 1);
+  rb_define_module_function(mgsl_sf_expint, "three",  rb_gsl_sf_expint_3, -1);
   rb_define_module_function(mgsl_sf_expint, "three_e",  rb_gsl_sf_expint_3_e, 1);
 
 #ifdef GSL_1_3_LATER
-  rb_define_module_function(module, "expint_E1_scaled",  rb_gsl_sf_expint_E1_scaled, 1);
+  rb_define_module_function(module, "expint_E1_scaled",  rb_gsl_sf_expint_E1_scaled, -1);
   rb_define_module_function(module, "expint_E1_scaled_e",  rb_gsl_sf_expint_E1_scaled_e, 1);
-  rb_define_module_function(module, "expint_E2_scaled",  rb_gsl_sf_expint_E2_scaled, 1);
+  rb_define_module_function(module, "expint_E2_scaled",  rb_gsl_sf_expint_E2_scaled, -1);
   rb_define_module_function(module, "expint_E2_scaled_e",  rb_gsl_sf_expint_E2_scaled_e, 1);
-  rb_define_module_function(module, "expint_Ei_scaled",  rb_gsl_sf_expint_Ei_scaled, 1);
+  rb_define_module_function(module, "expint_Ei_scaled",  rb_gsl_sf_expint_Ei_scaled, -1);
   rb_define_module_function(module, "expint_Ei_scaled_e",  rb_gsl_sf_expint_Ei_scaled_e, 1);
 
-  rb_define_module_function(mgsl_sf_expint, "E1_scaled",  rb_gsl_sf_expint_E1_scaled, 1);
+  rb_define_module_function(mgsl_sf_expint, "E1_scaled",  rb_gsl_sf_expint_E1_scaled, -1);
   rb_define_module_function(mgsl_sf_expint, "E1_scaled_e",  rb_gsl_sf_expint_E1_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_expint, "E2_scaled",  rb_gsl_sf_expint_E2_scaled, 1);
+  rb_define_module_function(mgsl_sf_expint, "E2_scaled",  rb_gsl_sf_expint_E2_scaled, -1);
   rb_define_module_function(mgsl_sf_expint, "E2_scaled_e",  rb_gsl_sf_expint_E2_scaled_e, 1);
-  rb_define_module_function(mgsl_sf_expint, "Ei_scaled",  rb_gsl_sf_expint_Ei_scaled, 1);
+  rb_define_module_function(mgsl_sf_expint, "Ei_scaled",  rb_gsl_sf_expint_Ei_scaled, -1);
   rb_define_module_function(mgsl_sf_expint, "Ei_scaled_e",  rb_gsl_sf_expint_Ei_scaled_e, 1);
 #endif
 
@@ -12,9 +12,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_fermi_dirac_m1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_m1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_m1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_m1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_m1_e(VALUE obj, VALUE x)
@@ -22,9 +22,9 @@ static VALUE rb_gsl_sf_fermi_dirac_m1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_fermi_dirac_m1_e, x);
 }
 
-static VALUE rb_gsl_sf_fermi_dirac_0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_0_e(VALUE obj, VALUE x)
@@ -32,9 +32,9 @@ static VALUE rb_gsl_sf_fermi_dirac_0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_fermi_dirac_0_e, x);
 }
 
-static VALUE rb_gsl_sf_fermi_dirac_1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_1_e(VALUE obj, VALUE x)
@@ -42,9 +42,9 @@ static VALUE rb_gsl_sf_fermi_dirac_1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_fermi_dirac_1_e, x);
 }
 
-static VALUE rb_gsl_sf_fermi_dirac_2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_2_e(VALUE obj, VALUE x)
@@ -62,9 +62,9 @@ static VALUE rb_gsl_sf_fermi_dirac_int_e(VALUE obj, VALUE j, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_fermi_dirac_int_e, j, x);
 }
 
-static VALUE rb_gsl_sf_fermi_dirac_mhalf(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_mhalf(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_mhalf, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_mhalf, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_mhalf_e(VALUE obj, VALUE x)
@@ -72,9 +72,9 @@ static VALUE rb_gsl_sf_fermi_dirac_mhalf_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_fermi_dirac_mhalf_e, x);
 }
 
-static VALUE rb_gsl_sf_fermi_dirac_half(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_half(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_half, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_half, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_half_e(VALUE obj, VALUE x)
@@ -82,9 +82,9 @@ static VALUE rb_gsl_sf_fermi_dirac_half_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_fermi_dirac_half_e, x);
 }
 
-static VALUE rb_gsl_sf_fermi_dirac_3half(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_fermi_dirac_3half(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_fermi_dirac_3half, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_fermi_dirac_3half, argc, argv);
 }
 
 static VALUE rb_gsl_sf_fermi_dirac_3half_e(VALUE obj, VALUE x)
@@ -106,41 +106,41 @@ void Init_gsl_sf_fermi_dirac(VALUE module)
 {
   VALUE mgsl_sf_fermi;
 
-  rb_define_module_function(module, "fermi_dirac_m1",  rb_gsl_sf_fermi_dirac_m1, 1);
+  rb_define_module_function(module, "fermi_dirac_m1",  rb_gsl_sf_fermi_dirac_m1, -1);
   rb_define_module_function(module, "fermi_dirac_m1_e",  rb_gsl_sf_fermi_dirac_m1_e, 1);
-  rb_define_module_function(module, "fermi_dirac_0",  rb_gsl_sf_fermi_dirac_0, 1);
+  rb_define_module_function(module, "fermi_dirac_0",  rb_gsl_sf_fermi_dirac_0, -1);
   rb_define_module_function(module, "fermi_dirac_0_e",  rb_gsl_sf_fermi_dirac_0_e, 1);
-  rb_define_module_function(module, "fermi_dirac_1",  rb_gsl_sf_fermi_dirac_1, 1);
+  rb_define_module_function(module, "fermi_dirac_1",  rb_gsl_sf_fermi_dirac_1, -1);
   rb_define_module_function(module, "fermi_dirac_1_e",  rb_gsl_sf_fermi_dirac_1_e, 1);
-  rb_define_module_function(module, "fermi_dirac_2",  rb_gsl_sf_fermi_dirac_2, 1);
+  rb_define_module_function(module, "fermi_dirac_2",  rb_gsl_sf_fermi_dirac_2, -1);
   rb_define_module_function(module, "fermi_dirac_2_e",  rb_gsl_sf_fermi_dirac_2_e, 1);
   rb_define_module_function(module, "fermi_dirac_int",  rb_gsl_sf_fermi_dirac_int, 2);
   rb_define_module_function(module, "fermi_dirac_int_e",  rb_gsl_sf_fermi_dirac_int_e, 2);
-  rb_define_module_function(module, "fermi_dirac_mhalf",  rb_gsl_sf_fermi_dirac_mhalf, 1);
+  rb_define_module_function(module, "fermi_dirac_mhalf",  rb_gsl_sf_fermi_dirac_mhalf, -1);
   rb_define_module_function(module, "fermi_dirac_mhalf_e",  rb_gsl_sf_fermi_dirac_mhalf_e, 1);
-  rb_define_module_function(module, "fermi_dirac_half",  rb_gsl_sf_fermi_dirac_half, 1);
+  rb_define_module_function(module, "fermi_dirac_half",  rb_gsl_sf_fermi_dirac_half, -1);
   rb_define_module_function(module, "fermi_dirac_half_e",  rb_gsl_sf_fermi_dirac_half_e, 1);
-  rb_define_module_function(module, "fermi_dirac_3half",  rb_gsl_sf_fermi_dirac_3half, 1);
+  rb_define_module_function(module, "fermi_dirac_3half",  rb_gsl_sf_fermi_dirac_3half, -1);
   rb_define_module_function(module, "fermi_dirac_3half_e",  rb_gsl_sf_fermi_dirac_3half_e, 1);
   rb_define_module_function(module, "fermi_dirac_inc_0",  rb_gsl_sf_fermi_dirac_inc_0, 2);
   rb_define_module_function(module, "fermi_dirac_inc_0_e",  rb_gsl_sf_fermi_dirac_inc_0_e, 2);
 
   mgsl_sf_fermi = rb_define_module_under(module, "Fermi_Dirac");
-  rb_define_module_function(mgsl_sf_fermi, "m1",  rb_gsl_sf_fermi_dirac_m1, 1);
+  rb_define_module_function(mgsl_sf_fermi, "m1",  rb_gsl_sf_fermi_dirac_m1, -1);
   rb_define_module_function(mgsl_sf_fermi, "m1_e",  rb_gsl_sf_fermi_dirac_m1_e, 1);
-  rb_define_module_function(mgsl_sf_fermi, "zero",  rb_gsl_sf_fermi_dirac_0, 1);
+  rb_define_module_function(mgsl_sf_fermi, "zero",  rb_gsl_sf_fermi_dirac_0, -1);
   rb_define_module_function(mgsl_sf_fermi, "zero_e",  rb_gsl_sf_fermi_dirac_0_e, 1);
-  rb_define_module_function(mgsl_sf_fermi, "one",  rb_gsl_sf_fermi_dirac_1, 1);
+  rb_define_module_function(mgsl_sf_fermi, "one",  rb_gsl_sf_fermi_dirac_1, -1);
   rb_define_module_function(mgsl_sf_fermi, "one_e",  rb_gsl_sf_fermi_dirac_1_e, 1);
-  rb_define_module_function(mgsl_sf_fermi, "two",  rb_gsl_sf_fermi_dirac_2, 1);
+  rb_define_module_function(mgsl_sf_fermi, "two",  rb_gsl_sf_fermi_dirac_2, -1);
   rb_define_module_function(mgsl_sf_fermi, "two_e",  rb_gsl_sf_fermi_dirac_2_e, 1);
   rb_define_module_function(mgsl_sf_fermi, "int",  rb_gsl_sf_fermi_dirac_int, 2);
   rb_define_module_function(mgsl_sf_fermi, "int_e",  rb_gsl_sf_fermi_dirac_int_e, 2);
-  rb_define_module_function(mgsl_sf_fermi, "mhalf",  rb_gsl_sf_fermi_dirac_mhalf, 1);
+  rb_define_module_function(mgsl_sf_fermi, "mhalf",  rb_gsl_sf_fermi_dirac_mhalf, -1);
   rb_define_module_function(mgsl_sf_fermi, "mhalf_e",  rb_gsl_sf_fermi_dirac_mhalf_e, 1);
-  rb_define_module_function(mgsl_sf_fermi, "half",  rb_gsl_sf_fermi_dirac_half, 1);
+  rb_define_module_function(mgsl_sf_fermi, "half",  rb_gsl_sf_fermi_dirac_half, -1);
   rb_define_module_function(mgsl_sf_fermi, "half_e",  rb_gsl_sf_fermi_dirac_half_e, 1);
-  rb_define_module_function(mgsl_sf_fermi, "threehalf",  rb_gsl_sf_fermi_dirac_3half, 1);
+  rb_define_module_function(mgsl_sf_fermi, "threehalf",  rb_gsl_sf_fermi_dirac_3half, -1);
   rb_define_module_function(mgsl_sf_fermi, "threehalf_e",  rb_gsl_sf_fermi_dirac_3half_e, 1);
   rb_define_module_function(mgsl_sf_fermi, "inc_0",  rb_gsl_sf_fermi_dirac_inc_0, 2);
   rb_define_module_function(mgsl_sf_fermi, "inc_0_e",  rb_gsl_sf_fermi_dirac_inc_0_e, 2);
@@ -11,9 +11,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_gamma(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_gamma(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_gamma, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_gamma, argc, argv);
 }
 
 static VALUE rb_gsl_sf_gamma_e(VALUE obj, VALUE x)
@@ -21,9 +21,9 @@ static VALUE rb_gsl_sf_gamma_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_gamma_e, x);
 }
 
-static VALUE rb_gsl_sf_lngamma(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_lngamma(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_lngamma, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_lngamma, argc, argv);
 }
 
 static VALUE rb_gsl_sf_lngamma_e(VALUE obj, VALUE x)
@@ -44,9 +44,9 @@ static VALUE rb_gsl_sf_lngamma_sgn_e(VALUE obj, VALUE x)
   return rb_ary_new3(2, v, rb_float_new(sgn));
 }
 
-static VALUE rb_gsl_sf_gammastar(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_gammastar(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_gammastar, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_gammastar, argc, argv);
 }
 
 static VALUE rb_gsl_sf_gammastar_e(VALUE obj, VALUE x)
@@ -54,9 +54,9 @@ static VALUE rb_gsl_sf_gammastar_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_gammastar_e, x);
 }
 
-static VALUE rb_gsl_sf_gammainv(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_gammainv(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_gammainv, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_gammainv, argc, argv);
 }
 
 static VALUE rb_gsl_sf_gammainv_e(VALUE obj, VALUE x)
@@ -82,6 +82,7 @@ static VALUE rb_gsl_sf_lngamma_complex_e(int argc, VALUE *argv, VALUE obj)
     Need_Float(argv[0]); Need_Float(argv[1]);
     re = NUM2DBL(argv[0]);
     im = NUM2DBL(argv[1]);
+    break;
   default:
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
   }
@@ -91,6 +92,13 @@ static VALUE rb_gsl_sf_lngamma_complex_e(int argc, VALUE *argv, VALUE obj)
   return rb_ary_new3(3, vlnr, varg, INT2FIX(status));
 }
 
+/* lngamma_complex(z[, out]): log Gamma(z), z a GSL::Complex,
+   Vector::Complex or Matrix::Complex */
+static VALUE rb_gsl_sf_lngamma_complex(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval_complex_e(gsl_sf_lngamma_complex_e, 0, argc, argv);
+}
+
 static VALUE rb_gsl_sf_taylorcoeff(VALUE obj, VALUE n, VALUE x)
 {
   return rb_gsl_sf_eval_int_double(gsl_sf_taylorcoeff, n, x);
@@ -296,16 +304,17 @@ static VALUE rb_gsl_sf_bincoef(VALUE obj, VALUE n, VALUE k)
 void Init_gsl_sf_gamma(VALUE module)
 {
   rb_define_const(module, "GAMMA_XMAX", NUM2DBL(GSL_SF_GAMMA_XMAX));
-  rb_define_module_function(module, "gamma",  rb_gsl_sf_gamma, 1);
+  rb_define_module_function(module, "gamma",  rb_gsl_sf_gamma, -1);
   rb_define_module_function(module, "gamma_e",  rb_gsl_sf_gamma_e, 1);
-  rb_define_module_function(module, "lngamma",  rb_gsl_sf_lngamma, 1);
+  rb_define_module_function(module, "lngamma",  rb_gsl_sf_lngamma, -1);
   rb_define_module_function(module, "lngamma_e",  rb_gsl_sf_lngamma_e, 1);
   rb_define_module_function(module, "lngamma_sgn_e",  rb_gsl_sf_lngamma_sgn_e, 1);
-  rb_define_module_function(module, "gammastar",  rb_gsl_sf_gammastar, 1);
+  rb_define_module_function(module, "gammastar",  rb_gsl_sf_gammastar, -1);
   rb_define_module_function(module, "gammastar_e",  rb_gsl_sf_gammastar_e, 1);
-  rb_define_module_function(module, "gammainv",  rb_gsl_sf_gammainv, 1);
+  rb_define_module_function(module, "gammainv",  rb_gsl_sf_gammainv, -1);
   rb_define_module_function(module, "gammainv_e",  rb_gsl_sf_gammainv_e, 1);
   rb_define_module_function(module, "lngamma_complex_e",  rb_gsl_sf_lngamma_complex_e, -1);
+  rb_define_module_function(module, "lngamma_complex",  rb_gsl_sf_lngamma_complex, -1);
   rb_define_module_function(module, "taylorcoeff",  rb_gsl_sf_taylorcoeff, 2);
   rb_define_module_function(module, "taylorcoeff_e",  rb_gsl_sf_taylorcoeff_e, 2);
   rb_define_module_function(module, "fact",  rb_gsl_sf_fact, 1);
@@ -60,14 +60,26 @@ static VALUE rb_gsl_sf_gegenpoly_n_e(VALUE obj, VALUE n, VALUE lambda, VALUE x)
   return v;
 }
 
-static VALUE rb_gsl_sf_gegenpoly_array(VALUE obj, VALUE nmax, VALUE lambda, VALUE x)
+static int mygsl_sf_gegenpoly_fill(const mygsl_sf_array *a, double x, double **y, double *e)
 {
-  gsl_vector *v = NULL;
-  CHECK_FIXNUM(nmax);
-  Need_Float(lambda); Need_Float(x);
-  v = gsl_vector_alloc(nmax);
-  gsl_sf_gegenpoly_array(FIX2INT(nmax), NUM2DBL(lambda), NUM2DBL(x), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  return gsl_sf_gegenpoly_array(a->i0, a->d0, x, y[0]);
+}
+
+/* gegenpoly_array(nmax, lambda, x[, out]): C^lambda_n(x), n = 0 .. nmax;
+   x a Vector or an Array gives a Matrix, a row for each x */
+static VALUE rb_gsl_sf_gegenpoly_array(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_sf_array a;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  CHECK_FIXNUM(argv[0]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_gegenpoly_fill;
+  a.i0 = FIX2INT(argv[0]);
+  a.d0 = NUM2DBL(argv[1]);
+  a.size = a.i0 >= 0 ? a.i0 + 1 : 0;
+  a.nout = 1;
+  return rb_gsl_sf_array_eval(&a, argv[2], argc - 3, argv + 3);
 }
 
 void Init_gsl_sf_gegenbauer(VALUE module)
@@ -81,7 +93,7 @@ void Init_gsl_sf_gegenbauer(VALUE module)
   rb_define_module_function(module, "gegenpoly_3_e",  rb_gsl_sf_gegenpoly_3_e, 2);
   rb_define_module_function(module, "gegenpoly_n",  rb_gsl_sf_gegenpoly_n, 3);
   rb_define_module_function(module, "gegenpoly_n_e",  rb_gsl_sf_gegenpoly_n_e, 3);
-  rb_define_module_function(module, "gegenpoly_array",  rb_gsl_sf_gegenpoly_array, 3);
+  rb_define_module_function(module, "gegenpoly_array",  rb_gsl_sf_gegenpoly_array, -1);
 
   mgsl_sf_gegenpoly = rb_define_module_under(module, "Gegenpoly");
   rb_define_module_function(mgsl_sf_gegenpoly, "one",  rb_gsl_sf_gegenpoly_1, 2);
@@ -92,6 +104,6 @@ void Init_gsl_sf_gegenbauer(VALUE module)
   rb_define_module_function(mgsl_sf_gegenpoly, "three_e",  rb_gsl_sf_gegenpoly_3_e, 2);
   rb_define_module_function(mgsl_sf_gegenpoly, "n",  rb_gsl_sf_gegenpoly_n, 3);
   rb_define_module_function(mgsl_sf_gegenpoly, "n_e",  rb_gsl_sf_gegenpoly_n_e, 3);
-  rb_define_module_function(mgsl_sf_gegenpoly, "array",  rb_gsl_sf_gegenpoly_array, 3);
+  rb_define_module_function(mgsl_sf_gegenpoly, "array",  rb_gsl_sf_gegenpoly_array, -1);
 
 }
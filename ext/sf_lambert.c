@@ -11,9 +11,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_lambert_W0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_lambert_W0(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_lambert_W0, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_lambert_W0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_lambert_W0_e(VALUE obj, VALUE x)
@@ -21,9 +21,9 @@ static VALUE rb_gsl_sf_lambert_W0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_lambert_W0_e, x);
 }
 
-static VALUE rb_gsl_sf_lambert_Wm1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_lambert_Wm1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_lambert_Wm1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_lambert_Wm1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_lambert_Wm1_e(VALUE obj, VALUE x)
@@ -34,14 +34,14 @@ static VALUE rb_gsl_sf_lambert_Wm1_e(VALUE obj, VALUE x)
 void Init_gsl_sf_lambert(VALUE module)
 {
   VALUE mgsl_sf_lambert;
-  rb_define_module_function(module, "lambert_W0",  rb_gsl_sf_lambert_W0, 1);
+  rb_define_module_function(module, "lambert_W0",  rb_gsl_sf_lambert_W0, -1);
   rb_define_module_function(module, "lambert_W0_e",  rb_gsl_sf_lambert_W0_e, 1);
-  rb_define_module_function(module, "lambert_Wm1",  rb_gsl_sf_lambert_Wm1, 1);
+  rb_define_module_function(module, "lambert_Wm1",  rb_gsl_sf_lambert_Wm1, -1);
   rb_define_module_function(module, "lambert_Wm1_e",  rb_gsl_sf_lambert_Wm1_e, 1);
 
   mgsl_sf_lambert = rb_define_module_under(module, "Lambert");
-  rb_define_module_function(mgsl_sf_lambert, "W0",  rb_gsl_sf_lambert_W0, 1);
+  rb_define_module_function(mgsl_sf_lambert, "W0",  rb_gsl_sf_lambert_W0, -1);
   rb_define_module_function(mgsl_sf_lambert, "W0_e",  rb_gsl_sf_lambert_W0_e, 1);
-  rb_define_module_function(mgsl_sf_lambert, "Wm1",  rb_gsl_sf_lambert_Wm1, 1);
+  rb_define_module_function(mgsl_sf_lambert, "Wm1",  rb_gsl_sf_lambert_Wm1, -1);
   rb_define_module_function(mgsl_sf_lambert, "Wm1_e",  rb_gsl_sf_lambert_Wm1_e, 1);
 }
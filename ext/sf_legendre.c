@@ -12,9 +12,9 @@
 #include "rb_gsl_sf.h"
 EXTERN VALUE cgsl_vector;
 
-static VALUE rb_gsl_sf_legendre_P1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_legendre_P1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_legendre_P1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_legendre_P1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_legendre_P1_e(VALUE obj, VALUE x)
@@ -22,9 +22,9 @@ static VALUE rb_gsl_sf_legendre_P1_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_legendre_P1_e, x);
 }
 
-static VALUE rb_gsl_sf_legendre_P2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_legendre_P2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_legendre_P2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_legendre_P2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_legendre_P2_e(VALUE obj, VALUE x)
@@ -32,9 +32,9 @@ static VALUE rb_gsl_sf_legendre_P2_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_legendre_P2_e, x);
 }
 
-static VALUE rb_gsl_sf_legendre_P3(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_legendre_P3(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_legendre_P3, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_legendre_P3, argc, argv);
 }
 
 static VALUE rb_gsl_sf_legendre_P3_e(VALUE obj, VALUE x)
@@ -52,19 +52,43 @@ static VALUE rb_gsl_sf_legendre_Pl_e(VALUE obj, VALUE l, VALUE x)
   return rb_gsl_sf_eval_e_int_double(gsl_sf_legendre_Pl_e, l, x);
 }
 
-static VALUE rb_gsl_sf_legendre_Pl_array(VALUE obj, VALUE lmax, VALUE x)
+static int mygsl_sf_legendre_l_fill(const mygsl_sf_array *a, double x, double **y, double *e)
 {
-  gsl_vector *v = NULL;
-  CHECK_FIXNUM(lmax);
-  Need_Float(x);
-  v = gsl_vector_alloc(FIX2INT(lmax) + 1);
-  gsl_sf_legendre_Pl_array(FIX2INT(lmax), NUM2DBL(x), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  if (a->nout == 2)
+    return (*(int (*)(int, double, double[], double[])) a->func)(a->i0, x, y[0], y[1]);
+  return (*(int (*)(int, double, double[])) a->func)(a->i0, x, y[0]);
+}
+
+/* Pl_array(lmax, x[, out]), Pl_deriv_array(lmax, x[, out, dout]): x a
+   Vector or an Array gives a Matrix, a row for each x */
+static VALUE rb_gsl_sf_legendre_l_array(int argc, VALUE *argv, void (*f)(void), size_t nout)
+{
+  mygsl_sf_array a;
+  if (argc < 2 || argc > 2 + (int) nout)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2..%d)", argc, 2 + (int) nout);
+  CHECK_FIXNUM(argv[0]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_legendre_l_fill;
+  a.func = f;
+  a.i0 = FIX2INT(argv[0]);
+  a.size = a.i0 >= 0 ? a.i0 + 1 : 0;
+  a.nout = nout;
+  return rb_gsl_sf_array_eval(&a, argv[1], argc - 2, argv + 2);
 }
 
-static VALUE rb_gsl_sf_legendre_Q0(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_legendre_Pl_array(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_legendre_Q0, x);
+  return rb_gsl_sf_legendre_l_array(argc, argv, (void (*)(void)) gsl_sf_legendre_Pl_array, 1);
+}
+
+static VALUE rb_gsl_sf_legendre_Pl_deriv_array(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_legendre_l_array(argc, argv, (void (*)(void)) gsl_sf_legendre_Pl_deriv_array, 2);
+}
+
+static VALUE rb_gsl_sf_legendre_Q0(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval1_argv(gsl_sf_legendre_Q0, argc, argv);
 }
 
 static VALUE rb_gsl_sf_legendre_Q0_e(VALUE obj, VALUE x)
@@ -72,9 +96,9 @@ static VALUE rb_gsl_sf_legendre_Q0_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_legendre_Q0_e, x);
 }
 
-static VALUE rb_gsl_sf_legendre_Q1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_legendre_Q1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_legendre_Q1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_legendre_Q1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_legendre_Q1_e(VALUE obj, VALUE x)
@@ -110,19 +134,39 @@ static VALUE rb_gsl_sf_legendre_Plm_e(VALUE obj, VALUE l, VALUE m, VALUE x)
   return rb_ary_new3(2, v, INT2FIX(status));
 }
 
-static VALUE rb_gsl_sf_legendre_Plm_array(VALUE obj, VALUE lmax, VALUE m, VALUE x)
+static int mygsl_sf_legendre_lm_fill(const mygsl_sf_array *a, double x, double **y, double *e)
 {
-  gsl_vector *v = NULL;
-  int size;
-  int ll, mm;
-  CHECK_FIXNUM(lmax); CHECK_FIXNUM(m);
-  Need_Float(x);
-  ll = FIX2INT(lmax);
-  mm = FIX2INT(m);
-  size = gsl_sf_legendre_array_size(ll, mm);
-  v = gsl_vector_alloc(size);
-  gsl_sf_legendre_Plm_array(ll, mm, NUM2DBL(x), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  if (a->nout == 2)
+    return (*(int (*)(int, int, double, double[], double[])) a->func)(a->i0, a->i1, x, y[0], y[1]);
+  return (*(int (*)(int, int, double, double[])) a->func)(a->i0, a->i1, x, y[0]);
+}
+
+/* Plm_array(lmax, m, x[, out]), Plm_deriv_array(lmax, m, x[, out, dout]),
+   and the same for sphPlm */
+static VALUE rb_gsl_sf_legendre_lm_array(int argc, VALUE *argv, void (*f)(void), size_t nout)
+{
+  mygsl_sf_array a;
+  if (argc < 3 || argc > 3 + (int) nout)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3..%d)", argc, 3 + (int) nout);
+  CHECK_FIXNUM(argv[0]); CHECK_FIXNUM(argv[1]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_legendre_lm_fill;
+  a.func = f;
+  a.i0 = FIX2INT(argv[0]);
+  a.i1 = FIX2INT(argv[1]);
+  a.size = a.i1 >= 0 && a.i0 >= a.i1 ? gsl_sf_legendre_array_size(a.i0, a.i1) : 0;
+  a.nout = nout;
+  return rb_gsl_sf_array_eval(&a, argv[2], argc - 3, argv + 3);
+}
+
+static VALUE rb_gsl_sf_legendre_Plm_array(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_legendre_lm_array(argc, argv, (void (*)(void)) gsl_sf_legendre_Plm_array, 1);
+}
+
+static VALUE rb_gsl_sf_legendre_Plm_deriv_array(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_legendre_lm_array(argc, argv, (void (*)(void)) gsl_sf_legendre_Plm_deriv_array, 2);
 }
 
 static VALUE rb_gsl_sf_legendre_sphPlm(VALUE obj, VALUE l, VALUE m, VALUE x)
@@ -142,19 +186,14 @@ static VALUE rb_gsl_sf_legendre_sphPlm_e(VALUE obj, VALUE l, VALUE m, VALUE x)
   return rb_ary_new3(2, v, INT2FIX(status));
 }
 
-static VALUE rb_gsl_sf_legendre_sphPlm_array(VALUE obj, VALUE lmax, VALUE m, VALUE x)
+static VALUE rb_gsl_sf_legendre_sphPlm_array(int argc, VALUE *argv, VALUE obj)
 {
-  gsl_vector *v = NULL;
-  int size;
-  int ll, mm;
-  CHECK_FIXNUM(lmax); CHECK_FIXNUM(m);
-  Need_Float(x);
-  ll = FIX2INT(lmax);
-  mm = FIX2INT(m);
-  size = gsl_sf_legendre_array_size(ll, mm);
-  v = gsl_vector_alloc(size);
-  gsl_sf_legendre_sphPlm_array(ll, mm, NUM2DBL(x), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  return rb_gsl_sf_legendre_lm_array(argc, argv, (void (*)(void)) gsl_sf_legendre_sphPlm_array, 1);
+}
+
+static VALUE rb_gsl_sf_legendre_sphPlm_deriv_array(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_legendre_lm_array(argc, argv, (void (*)(void)) gsl_sf_legendre_sphPlm_deriv_array, 2);
 }
 
 static VALUE rb_gsl_sf_legendre_array_size(VALUE obj, VALUE lmax, VALUE m)
@@ -265,42 +304,55 @@ static VALUE rb_gsl_sf_legendre_H3d_e(VALUE obj,VALUE l,  VALUE lambda, VALUE et
   return v;
 }
 
-static VALUE rb_gsl_sf_legendre_H3d_array(VALUE obj, VALUE lmax, VALUE lambda, VALUE eta)
+static int mygsl_sf_legendre_H3d_fill(const mygsl_sf_array *a, double eta, double **y, double *e)
 {
-  gsl_vector *v = NULL;
-  CHECK_FIXNUM(lmax);
-  Need_Float(lambda);
-  Need_Float(eta);
-  v = gsl_vector_alloc(FIX2INT(lmax) + 1);
-  gsl_sf_legendre_H3d_array(FIX2INT(lmax), NUM2DBL(lambda), NUM2DBL(eta), v->data);
-  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  return gsl_sf_legendre_H3d_array(a->i0, a->d0, eta, y[0]);
+}
+
+/* H3d_array(lmax, lambda, eta[, out]), eta a Vector or an Array too */
+static VALUE rb_gsl_sf_legendre_H3d_array(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_sf_array a;
+  if (argc < 3 || argc > 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 3 or 4)", argc);
+  CHECK_FIXNUM(argv[0]);
+  memset(&a, 0, sizeof(mygsl_sf_array));
+  a.fill = mygsl_sf_legendre_H3d_fill;
+  a.i0 = FIX2INT(argv[0]);
+  a.d0 = NUM2DBL(argv[1]);
+  a.size = a.i0 >= 0 ? a.i0 + 1 : 0;
+  a.nout = 1;
+  return rb_gsl_sf_array_eval(&a, argv[2], argc - 3, argv + 3);
 }
 
 void Init_gsl_sf_legendre(VALUE module)
 {
   VALUE mgsl_sf_leg;
 
-  rb_define_module_function(module, "legendre_P1",  rb_gsl_sf_legendre_P1, 1);
+  rb_define_module_function(module, "legendre_P1",  rb_gsl_sf_legendre_P1, -1);
   rb_define_module_function(module, "legendre_P1_e",  rb_gsl_sf_legendre_P1_e, 1);
-  rb_define_module_function(module, "legendre_P2",  rb_gsl_sf_legendre_P2, 1);
+  rb_define_module_function(module, "legendre_P2",  rb_gsl_sf_legendre_P2, -1);
   rb_define_module_function(module, "legendre_P2_e",  rb_gsl_sf_legendre_P2_e, 1);
-  rb_define_module_function(module, "legendre_P3",  rb_gsl_sf_legendre_P3, 1);
+  rb_define_module_function(module, "legendre_P3",  rb_gsl_sf_legendre_P3, -1);
   rb_define_module_function(module, "legendre_P3_e",  rb_gsl_sf_legendre_P3_e, 1);
   rb_define_module_function(module, "legendre_Pl",  rb_gsl_sf_legendre_Pl, 2);
   rb_define_module_function(module, "legendre_Pl_e",  rb_gsl_sf_legendre_Pl_e, 2);
-  rb_define_module_function(module, "legendre_Pl_array",  rb_gsl_sf_legendre_Pl_array, 2);
-  rb_define_module_function(module, "legendre_Q0",  rb_gsl_sf_legendre_Q0, 1);
+  rb_define_module_function(module, "legendre_Pl_array",  rb_gsl_sf_legendre_Pl_array, -1);
+  rb_define_module_function(module, "legendre_Pl_deriv_array",  rb_gsl_sf_legendre_Pl_deriv_array, -1);
+  rb_define_module_function(module, "legendre_Q0",  rb_gsl_sf_legendre_Q0, -1);
   rb_define_module_function(module, "legendre_Q0_e",  rb_gsl_sf_legendre_Q0_e, 1);
-  rb_define_module_function(module, "legendre_Q1",  rb_gsl_sf_legendre_Q1, 1);
+  rb_define_module_function(module, "legendre_Q1",  rb_gsl_sf_legendre_Q1, -1);
   rb_define_module_function(module, "legendre_Q1_e",  rb_gsl_sf_legendre_Q1_e, 1);
   rb_define_module_function(module, "legendre_Ql",  rb_gsl_sf_legendre_Ql, 2);
   rb_define_module_function(module, "legendre_Ql_e",  rb_gsl_sf_legendre_Ql_e, 2);
   rb_define_module_function(module, "legendre_Plm",  rb_gsl_sf_legendre_Plm, 3);
   rb_define_module_function(module, "legendre_Plm_e",  rb_gsl_sf_legendre_Plm_e, 3);
-  rb_define_module_function(module, "legendre_Plm_array",  rb_gsl_sf_legendre_Plm_array, 3);
+  rb_define_module_function(module, "legendre_Plm_array",  rb_gsl_sf_legendre_Plm_array, -1);
+  rb_define_module_function(module, "legendre_Plm_deriv_array",  rb_gsl_sf_legendre_Plm_deriv_array, -1);
   rb_define_module_function(module, "legendre_sphPlm",  rb_gsl_sf_legendre_sphPlm, 3);
   rb_define_module_function(module, "legendre_sphPlm_e",  rb_gsl_sf_legendre_sphPlm_e, 3);
-  rb_define_module_function(module, "legendre_sphPlm_array",  rb_gsl_sf_legendre_sphPlm_array, 3);
+  rb_define_module_function(module, "legendre_sphPlm_array",  rb_gsl_sf_legendre_sphPlm_array, -1);
+  rb_define_module_function(module, "legendre_sphPlm_deriv_array",  rb_gsl_sf_legendre_sphPlm_deriv_array, -1);
   rb_define_module_function(module, "legendre_array_size",  rb_gsl_sf_legendre_array_size, 2);
   rb_define_module_function(module, "conicalP_half",  rb_gsl_sf_conicalP_half, 2);
   rb_define_module_function(module, "conicalP_half_e",  rb_gsl_sf_conicalP_half_e, 2);
@@ -320,30 +372,33 @@ void Init_gsl_sf_legendre(VALUE module)
   rb_define_module_function(module, "legendre_H3d_1_e",  rb_gsl_sf_legendre_H3d_1_e, 2);
   rb_define_module_function(module, "legendre_H3d",  rb_gsl_sf_legendre_H3d, 3);
   rb_define_module_function(module, "legendre_H3d_e",  rb_gsl_sf_legendre_H3d_e, 3);
-  rb_define_module_function(module, "legendre_H3d_array",  rb_gsl_sf_legendre_H3d_array, 3);
+  rb_define_module_function(module, "legendre_H3d_array",  rb_gsl_sf_legendre_H3d_array, -1);
 
   /*****/
 
   mgsl_sf_leg = rb_define_module_under(module, "Legendre");
-  rb_define_module_function(mgsl_sf_leg, "P1",  rb_gsl_sf_legendre_P1, 1);
+  rb_define_module_function(mgsl_sf_leg, "P1",  rb_gsl_sf_legendre_P1, -1);
   rb_define_module_function(mgsl_sf_leg, "P1_e",  rb_gsl_sf_legendre_P1_e, 1);
-  rb_define_module_function(mgsl_sf_leg, "P2",  rb_gsl_sf_legendre_P2, 1);
+  rb_define_module_function(mgsl_sf_leg, "P2",  rb_gsl_sf_legendre_P2, -1);
   rb_define_module_function(mgsl_sf_leg, "P2_e",  rb_gsl_sf_legendre_P2_e, 1);
-  rb_define_module_function(mgsl_sf_leg, "P3",  rb_gsl_sf_legendre_P3, 1);
+  rb_define_module_function(mgsl_sf_leg, "P3",  rb_gsl_sf_legendre_P3, -1);
   rb_define_module_function(mgsl_sf_leg, "P3_e",  rb_gsl_sf_legendre_P3_e, 1);
   rb_define_module_function(mgsl_sf_leg, "Pl",  rb_gsl_sf_legendre_Pl, 2);
   rb_define_module_function(mgsl_sf_leg, "Pl_e",  rb_gsl_sf_legendre_Pl_e, 2);
-  rb_define_module_function(mgsl_sf_leg, "Pl_array",  rb_gsl_sf_legendre_Pl_array, 2);
-  rb_define_module_function(mgsl_sf_leg, "Q0",  rb_gsl_sf_legendre_Q0, 1);
+  rb_define_module_function(mgsl_sf_leg, "Pl_array",  rb_gsl_sf_legendre_Pl_array, -1);
+  rb_define_module_function(mgsl_sf_leg, "Pl_deriv_array",  rb_gsl_sf_legendre_Pl_deriv_array, -1);
+  rb_define_module_function(mgsl_sf_leg, "Q0",  rb_gsl_sf_legendre_Q0, -1);
   rb_define_module_function(mgsl_sf_leg, "Q0_e",  rb_gsl_sf_legendre_Q0_e, 1);
-  rb_define_module_function(mgsl_sf_leg, "Q1",  rb_gsl_sf_legendre_Q1, 1);
+  rb_define_module_function(mgsl_sf_leg, "Q1",  rb_gsl_sf_legendre_Q1, -1);
   rb_define_module_function(mgsl_sf_leg, "Q1_e",  rb_gsl_sf_legendre_Q1_e, 1);
   rb_define_module_function(mgsl_sf_leg, "Plm",  rb_gsl_sf_legendre_Plm, 3);
   rb_define_module_function(mgsl_sf_leg, "Plm_e",  rb_gsl_sf_legendre_Plm_e, 3);
-  rb_define_module_function(mgsl_sf_leg, "Plm_array",  rb_gsl_sf_legendre_Plm_array, 3);
+  rb_define_module_function(mgsl_sf_leg, "Plm_array",  rb_gsl_sf_legendre_Plm_array, -1);
+  rb_define_module_function(mgsl_sf_leg, "Plm_deriv_array",  rb_gsl_sf_legendre_Plm_deriv_array, -1);
   rb_define_module_function(mgsl_sf_leg, "sphPlm",  rb_gsl_sf_legendre_sphPlm, 3);
   rb_define_module_function(mgsl_sf_leg, "sphPlm_e",  rb_gsl_sf_legendre_sphPlm_e, 3);
-  rb_define_module_function(mgsl_sf_leg, "sphPlm_array",  rb_gsl_sf_legendre_sphPlm_array, 3);
+  rb_define_module_function(mgsl_sf_leg, "sphPlm_array",  rb_gsl_sf_legendre_sphPlm_array, -1);
+  rb_define_module_function(mgsl_sf_leg, "sphPlm_deriv_array",  rb_gsl_sf_legendre_sphPlm_deriv_array, -1);
   rb_define_module_function(mgsl_sf_leg, "array_size",  rb_gsl_sf_legendre_array_size, 2);
   rb_define_module_function(mgsl_sf_leg, "conicalP_half",  rb_gsl_sf_conicalP_half, 2);
   rb_define_module_function(mgsl_sf_leg, "conicalP_half_e",  rb_gsl_sf_conicalP_half_e, 2);
@@ -363,6 +418,6 @@ void Init_gsl_sf_legendre(VALUE module)
   rb_define_module_function(mgsl_sf_leg, "H3d_1_e",  rb_gsl_sf_legendre_H3d_1_e, 2);
   rb_define_module_function(mgsl_sf_leg, "H3d",  rb_gsl_sf_legendre_H3d, 3);
   rb_define_module_function(mgsl_sf_leg, "H3d_e",  rb_gsl_sf_legendre_H3d_e, 3);
-  rb_define_module_function(mgsl_sf_leg, "H3d_array",  rb_gsl_sf_legendre_H3d_array, 3);
+  rb_define_module_function(mgsl_sf_leg, "H3d_array",  rb_gsl_sf_legendre_H3d_array, -1);
 
 }
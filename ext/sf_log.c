@@ -31,9 +31,9 @@ static VALUE rb_gsl_sf_log_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_log_e, x);
 }
 
-static VALUE rb_gsl_sf_log_abs(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_log_abs(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_log_abs, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_log_abs, argc, argv);
 }
 
 static VALUE rb_gsl_sf_log_abs_e(VALUE obj, VALUE x)
@@ -60,6 +60,7 @@ static VALUE rb_gsl_sf_complex_log_e(int argc, VALUE *argv, VALUE obj)
     Need_Float(argv[0]);     Need_Float(argv[1]);
     re = NUM2DBL(argv[0]);
     im = NUM2DBL(argv[1]);
+    break;
   default:
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
     break;
@@ -70,9 +71,16 @@ static VALUE rb_gsl_sf_complex_log_e(int argc, VALUE *argv, VALUE obj)
   return rb_ary_new3(2, vlnr, vtheta);
 }
 
-static VALUE rb_gsl_sf_log_1plusx(VALUE obj, VALUE x)
+/* complex_log(z[, out]), z a GSL::Complex, Vector::Complex or
+   Matrix::Complex */
+static VALUE rb_gsl_sf_complex_log(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval_complex_e(gsl_sf_complex_log_e, 0, argc, argv);
+}
+
+static VALUE rb_gsl_sf_log_1plusx(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_log_1plusx, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_log_1plusx, argc, argv);
 }
 
 static VALUE rb_gsl_sf_log_1plusx_e(VALUE obj, VALUE x)
@@ -80,9 +88,9 @@ static VALUE rb_gsl_sf_log_1plusx_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_log_1plusx_e, x);
 }
 
-static VALUE rb_gsl_sf_log_1plusx_mx(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_log_1plusx_mx(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_log_1plusx_mx, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_log_1plusx_mx, argc, argv);
 }
 
 static VALUE rb_gsl_sf_log_1plusx_mx_e(VALUE obj, VALUE x)
@@ -95,11 +103,12 @@ void Init_gsl_sf_log(VALUE module)
   rb_define_module_function(module, "log",  rb_gsl_sf_log, 1);
   rb_define_module_function(module, "log10",  rb_gsl_sf_log10, 1);  
   rb_define_module_function(module, "log_e",  rb_gsl_sf_log_e, 1);
-  rb_define_module_function(module, "log_abs",  rb_gsl_sf_log_abs, 1);
+  rb_define_module_function(module, "log_abs",  rb_gsl_sf_log_abs, -1);
   rb_define_module_function(module, "log_abs_e",  rb_gsl_sf_log_abs_e, 1);
   rb_define_module_function(module, "complex_log_e",  rb_gsl_sf_complex_log_e, -1);
-  rb_define_module_function(module, "log_1plusx",  rb_gsl_sf_log_1plusx, 1);
+  rb_define_module_function(module, "complex_log",  rb_gsl_sf_complex_log, -1);
+  rb_define_module_function(module, "log_1plusx",  rb_gsl_sf_log_1plusx, -1);
   rb_define_module_function(module, "log_1plusx_e",  rb_gsl_sf_log_1plusx_e, 1);
-  rb_define_module_function(module, "log_1plusx_mx",  rb_gsl_sf_log_1plusx_mx, 1);
+  rb_define_module_function(module, "log_1plusx_mx",  rb_gsl_sf_log_1plusx_mx, -1);
   rb_define_module_function(module, "log_1plusx_mx_e",  rb_gsl_sf_log_1plusx_mx_e, 1);
 }
@@ -21,9 +21,9 @@ static VALUE rb_gsl_sf_psi_int_e(VALUE obj, VALUE n)
   return rb_gsl_sf_eval_e_int(gsl_sf_psi_int_e, n);
 }
 
-static VALUE rb_gsl_sf_psi(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_psi(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_psi, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_psi, argc, argv);
 }
 
 static VALUE rb_gsl_sf_psi_e(VALUE obj, VALUE x)
@@ -32,9 +32,9 @@ static VALUE rb_gsl_sf_psi_e(VALUE obj, VALUE x)
 }
 
 #ifdef GSL_1_6_LATER
-static VALUE rb_gsl_sf_psi_1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_psi_1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_psi_1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_psi_1, argc, argv);
 }
 #endif
 
@@ -45,9 +45,9 @@ static VALUE rb_gsl_sf_psi_1_e(VALUE obj, VALUE x)
 }
 #endif
 
-static VALUE rb_gsl_sf_psi_1piy(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_psi_1piy(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_psi_1piy, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_psi_1piy, argc, argv);
 }
 
 static VALUE rb_gsl_sf_psi_1piy_e(VALUE obj, VALUE x)
@@ -79,18 +79,18 @@ void Init_gsl_sf_psi(VALUE module)
 {
   rb_define_module_function(module, "psi_int",  rb_gsl_sf_psi_int, 1);
   rb_define_module_function(module, "psi_int_e",  rb_gsl_sf_psi_int_e, 1);
-  rb_define_module_function(module, "psi_1piy",  rb_gsl_sf_psi_1piy, 1);
+  rb_define_module_function(module, "psi_1piy",  rb_gsl_sf_psi_1piy, -1);
   rb_define_module_function(module, "psi_1piy_e",  rb_gsl_sf_psi_1piy_e, 1);
   rb_define_module_function(module, "psi_1_int",  rb_gsl_sf_psi_1_int, 1);
   rb_define_module_function(module, "psi_1_int_e",  rb_gsl_sf_psi_1_int_e, 1);
   rb_define_module_function(module, "psi_n",  rb_gsl_sf_psi_n, 2);
   rb_define_module_function(module, "psi_n_e",  rb_gsl_sf_psi_n_e, 2);
 
-  rb_define_module_function(module, "psi",  rb_gsl_sf_psi, 1);
+  rb_define_module_function(module, "psi",  rb_gsl_sf_psi, -1);
   rb_define_module_function(module, "psi_e",  rb_gsl_sf_psi_e, 1);
 
 #ifdef GSL_1_6_LATER
-    rb_define_module_function(module, "psi_1",  rb_gsl_sf_psi_1, 1);
+    rb_define_module_function(module, "psi_1",  rb_gsl_sf_psi_1, -1);
 #endif
 #ifdef GSL_1_4_9_LATER
     rb_define_module_function(module, "psi_1_e",  rb_gsl_sf_psi_1_e, 1);
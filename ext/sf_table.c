@@ -0,0 +1,496 @@
+/*
+  sf_table.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Tables of special functions: a piecewise Chebyshev approximation of
+  f over [a, b], built once, for functions evaluated very many times
+  over a fixed domain.
+
+    t = GSL::Sf::Table.new(:fermi_dirac_half, -5, 20, 1e-12)
+    t.eval(3.0)                       # ~ GSL::Sf::fermi_dirac_half(3.0)
+    t.eval(x, out)                    # x a Vector or a Matrix
+
+  f is the name of one of the Sf functions of one variable listed in
+  GSL::Sf::Table.functions, or a Proc. [a, b] is bisected until the
+  series of :order (16) of each piece, computed by gsl_cheb_init,
+  agrees with f to max(tol*|f(x)|, :atol) (:atol 0) at 2*order + 3
+  points of the piece, and its last two coefficients are below that
+  bound. Table#error is the largest relative (or, below :atol,
+  absolute) difference found.
+
+  Table#eval takes a Float, an Array, a Vector or a Matrix [and an
+  output Vector or Matrix]; x outside [a, b] gives NaN. Points are
+  evaluated four at a time, the Clenshaw recurrences of the four run
+  side by side; large arguments are split over GSL.parallel_threads,
+  the GVL released.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_sf.h"
+#include "rb_gsl_function.h"
+#include <gsl/gsl_chebyshev.h>
+
+static VALUE cgsl_sf_table;
+
+#define MYGSL_SF_TABLE_MAXDEPTH 48
+#define MYGSL_SF_TABLE_BLOCK 1024
+
+static const struct {
+  const char *name;
+  double (*f)(double);
+} mygsl_sf_table_functions[] = {
+  {"bessel_I0", gsl_sf_bessel_I0},
+  {"bessel_I0_scaled", gsl_sf_bessel_I0_scaled},
+  {"bessel_J0", gsl_sf_bessel_J0},
+  {"bessel_J1", gsl_sf_bessel_J1},
+  {"bessel_K0", gsl_sf_bessel_K0},
+  {"bessel_K0_scaled", gsl_sf_bessel_K0_scaled},
+  {"bessel_Y0", gsl_sf_bessel_Y0},
+  {"bessel_Y1", gsl_sf_bessel_Y1},
+  {"dawson", gsl_sf_dawson},
+  {"debye_1", gsl_sf_debye_1},
+  {"debye_2", gsl_sf_debye_2},
+  {"debye_3", gsl_sf_debye_3},
+  {"debye_4", gsl_sf_debye_4},
+#ifdef GSL_1_8_LATER
+  {"debye_5", gsl_sf_debye_5},
+  {"debye_6", gsl_sf_debye_6},
+#endif
+  {"dilog", gsl_sf_dilog},
+  {"erf", gsl_sf_erf},
+  {"erfc", gsl_sf_erfc},
+  {"expint_3", gsl_sf_expint_3},
+  {"expint_E1", gsl_sf_expint_E1},
+  {"expint_E2", gsl_sf_expint_E2},
+  {"expint_Ei", gsl_sf_expint_Ei},
+  {"fermi_dirac_0", gsl_sf_fermi_dirac_0},
+  {"fermi_dirac_1", gsl_sf_fermi_dirac_1},
+  {"fermi_dirac_2", gsl_sf_fermi_dirac_2},
+  {"fermi_dirac_3half", gsl_sf_fermi_dirac_3half},
+  {"fermi_dirac_half", gsl_sf_fermi_dirac_half},
+  {"fermi_dirac_m1", gsl_sf_fermi_dirac_m1},
+  {"fermi_dirac_mhalf", gsl_sf_fermi_dirac_mhalf},
+  {"gamma", gsl_sf_gamma},
+  {"lambert_W0", gsl_sf_lambert_W0},
+  {"lngamma", gsl_sf_lngamma},
+  {"log_erfc", gsl_sf_log_erfc},
+  {"psi", gsl_sf_psi},
+  {"synchrotron_1", gsl_sf_synchrotron_1},
+  {"synchrotron_2", gsl_sf_synchrotron_2},
+  {NULL, NULL}
+};
+
+typedef struct {
+  size_t n, order, cap;         /* pieces, their order */
+  double a, b, tol, atol, err;
+  double *brk;                  /* n + 1 breakpoints */
+  double *mid, *ihw;            /* piece centres, inverse half widths */
+  double *c;                    /* n x (order + 1), c[0] halved */
+  double (*f)(double);
+  VALUE func;
+} mygsl_sf_table;
+
+static void mygsl_sf_table_mark(mygsl_sf_table *t)
+{
+  rb_gc_mark(t->func);
+}
+
+static void mygsl_sf_table_free(mygsl_sf_table *t)
+{
+  if (t->brk) xfree(t->brk);
+  if (t->mid) xfree(t->mid);
+  if (t->ihw) xfree(t->ihw);
+  if (t->c) xfree(t->c);
+  xfree(t);
+}
+
+static double mygsl_sf_table_f(double x, void *p)
+{
+  mygsl_sf_table *t = (mygsl_sf_table *) p;
+  if (t->f) return (*t->f)(x);
+  return NUM2DBL(rb_funcall(t->func, RBGSL_ID_call, 1, rb_float_new(x)));
+}
+
+static double mygsl_sf_table_clenshaw(const double *c, size_t order, double u)
+{
+  double d = 0.0, dd = 0.0, tmp;
+  size_t j;
+  for (j = order; j >= 1; j--) {
+    tmp = d;
+    d = 2.0*u*d - dd + c[j];
+    dd = tmp;
+  }
+  return u*d - dd + c[0];
+}
+
+/* The piece of x, or -1 outside [a, b] */
+static long mygsl_sf_table_piece(const mygsl_sf_table *t, double x)
+{
+  size_t lo = 0, hi = t->n, m;
+  if (!(x >= t->a && x <= t->b)) return -1;
+  while (hi - lo > 1) {
+    m = (lo + hi)/2;
+    if (x >= t->brk[m]) lo = m;
+    else hi = m;
+  }
+  return (long) lo;
+}
+
+/* Four points at once: the recurrences are independent */
+static void mygsl_sf_table_eval4(const mygsl_sf_table *t, const double *x, double *y)
+{
+  const double *c[4];
+  double u[4], d[4], dd[4], tmp;
+  long i[4];
+  size_t j, k, nc = t->order + 1;
+  for (k = 0; k < 4; k++) {
+    i[k] = mygsl_sf_table_piece(t, x[k]);
+    c[k] = t->c + (i[k] < 0 ? 0 : i[k])*nc;
+    u[k] = i[k] < 0 ? 0.0 : (x[k] - t->mid[i[k]])*t->ihw[i[k]];
+    d[k] = dd[k] = 0.0;
+  }
+  for (j = t->order; j >= 1; j--) {
+    for (k = 0; k < 4; k++) {
+      tmp = d[k];
+      d[k] = 2.0*u[k]*d[k] - dd[k] + c[k][j];
+      dd[k] = tmp;
+    }
+  }
+  for (k = 0; k < 4; k++) y[k] = i[k] < 0 ? GSL_NAN : u[k]*d[k] - dd[k] + c[k][0];
+}
+
+static double mygsl_sf_table_eval1(const mygsl_sf_table *t, double x)
+{
+  long i = mygsl_sf_table_piece(t, x);
+  if (i < 0) return GSL_NAN;
+  return mygsl_sf_table_clenshaw(t->c + i*(t->order + 1), t->order,
+				 (x - t->mid[i])*t->ihw[i]);
+}
+
+/***** building *****/
+
+static void mygsl_sf_table_push(mygsl_sf_table *t, double lo, double hi, const double *c)
+{
+  if (t->n == t->cap) {
+    t->cap = t->cap ? 2*t->cap : 16;
+    REALLOC_N(t->brk, double, t->cap + 1);
+    REALLOC_N(t->mid, double, t->cap);
+    REALLOC_N(t->ihw, double, t->cap);
+    REALLOC_N(t->c, double, t->cap*(t->order + 1));
+  }
+  t->brk[t->n] = lo;
+  t->brk[t->n + 1] = hi;
+  t->mid[t->n] = 0.5*(lo + hi);
+  t->ihw[t->n] = 2.0/(hi - lo);
+  memcpy(t->c + t->n*(t->order + 1), c, sizeof(double)*(t->order + 1));
+  t->n++;
+}
+
+/* Fits [lo, hi] with cs, bisecting it until the tolerance is met */
+static void mygsl_sf_table_fit(mygsl_sf_table *t, gsl_cheb_series *cs, gsl_function *F,
+			       double lo, double hi, int depth)
+{
+  double *c, x, fx, px, e, worst = 0.0, fmin = GSL_POSINF;
+  size_t k, m = 2*t->order + 3;
+  int ok = 1;
+  gsl_cheb_init(cs, F, lo, hi);
+  c = cs->c;
+  c[0] *= 0.5;
+  for (k = 0; k < m && ok; k++) {
+    x = lo + (hi - lo)*k/(m - 1);
+    fx = mygsl_sf_table_f(x, t);
+    px = mygsl_sf_table_clenshaw(c, t->order, (x - 0.5*(lo + hi))*2.0/(hi - lo));
+    if (!gsl_finite(fx)) rb_raise(rb_eArgError, "f(%g) is not finite", x);
+    e = fabs(px - fx);
+    if (e > GSL_MAX(t->tol*fabs(fx), t->atol)) ok = 0;
+    e /= t->tol > 0.0 ? GSL_MAX(fabs(fx), t->atol/t->tol) : 1.0;
+    if (e > worst) worst = e;
+    if (fabs(fx) < fmin) fmin = fabs(fx);
+  }
+  if (ok && t->order >= 1
+      && fabs(c[t->order]) + fabs(c[t->order - 1]) > GSL_MAX(t->tol*fmin, t->atol))
+    ok = 0;
+  if (ok) {
+    mygsl_sf_table_push(t, lo, hi, c);
+    if (worst > t->err) t->err = worst;
+    return;
+  }
+  if (depth >= MYGSL_SF_TABLE_MAXDEPTH || hi - lo <= 64*GSL_DBL_EPSILON*GSL_MAX(fabs(lo), fabs(hi)))
+    rb_raise(rb_eArgError, "tol %g not reached near x = %g (try :atol or a larger :order)",
+	     t->tol, 0.5*(lo + hi));
+  mygsl_sf_table_fit(t, cs, F, lo, 0.5*(lo + hi), depth + 1);
+  mygsl_sf_table_fit(t, cs, F, 0.5*(lo + hi), hi, depth + 1);
+}
+
+static VALUE rb_gsl_sf_table_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_sf_table *t = NULL;
+  gsl_cheb_series *cs;
+  gsl_function F;
+  VALUE obj, v, name;
+  size_t i;
+  if (argc < 4 || argc > 5)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 4 or 5)", argc);
+  obj = Data_Make_Struct(klass, mygsl_sf_table, mygsl_sf_table_mark, mygsl_sf_table_free, t);
+  t->func = argv[0];
+  t->a = NUM2DBL(argv[1]);
+  t->b = NUM2DBL(argv[2]);
+  t->tol = NUM2DBL(argv[3]);
+  t->order = 16;
+  if (argc == 5) {
+    Check_Type(argv[4], T_HASH);
+    if (!NIL_P(v = rb_hash_aref(argv[4], ID2SYM(rb_intern("order"))))) t->order = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(argv[4], ID2SYM(rb_intern("atol"))))) t->atol = NUM2DBL(v);
+  }
+  if (!(t->b > t->a)) rb_raise(rb_eArgError, "empty interval [%g, %g]", t->a, t->b);
+  if (!(t->tol > 0.0) && !(t->atol > 0.0)) rb_raise(rb_eArgError, "tol must be positive");
+  if (t->order < 2) rb_raise(rb_eArgError, "order must be at least 2");
+  if (!rb_obj_is_kind_of(t->func, rb_cProc)) {
+    name = TYPE(t->func) == T_SYMBOL ? rb_sym_to_s(t->func) : StringValue(t->func);
+    for (i = 0; mygsl_sf_table_functions[i].name; i++)
+      if (strcmp(mygsl_sf_table_functions[i].name, RSTRING_PTR(name)) == 0) break;
+    if (mygsl_sf_table_functions[i].name == NULL)
+      rb_raise(rb_eArgError, "no table for %s (see GSL::Sf::Table.functions)", RSTRING_PTR(name));
+    t->f = mygsl_sf_table_functions[i].f;
+    t->func = rb_str_new_frozen(name);
+  }
+  F.function = &mygsl_sf_table_f;
+  F.params = t;
+  cs = gsl_cheb_alloc(t->order);
+  v = Data_Wrap_Struct(rb_cObject, 0, gsl_cheb_free, cs);
+  mygsl_sf_table_fit(t, cs, &F, t->a, t->b, 0);
+  t->brk[0] = t->a;
+  t->brk[t->n] = t->b;
+  RB_GC_GUARD(v);
+  return obj;
+}
+
+/***** evaluation *****/
+
+typedef struct {
+  const mygsl_sf_table *t;
+  size_t n, ncols, nthreads;
+  const double *x;              /* x[r*xtda + c*xstride] */
+  size_t xtda, xstride;
+  double *y;
+  size_t ytda, ystride;
+} mygsl_sf_table_map;
+
+static void mygsl_sf_table_map_range(const mygsl_sf_table_map *m, size_t lo, size_t hi)
+{
+  double x[4], y[4];
+  size_t k, l, nb, r, c, idx[4];
+  while (lo < hi) {
+    nb = GSL_MIN(hi - lo, 4);
+    for (l = 0; l < 4; l++) {
+      k = lo + (l < nb ? l : 0);
+      r = k/m->ncols;
+      c = k%m->ncols;
+      idx[l] = r*m->ytda + c*m->ystride;
+      x[l] = m->x[r*m->xtda + c*m->xstride];
+    }
+    mygsl_sf_table_eval4(m->t, x, y);
+    for (l = 0; l < nb; l++) m->y[idx[l]] = y[l];
+    lo += nb;
+  }
+}
+
+static int mygsl_sf_table_map_worker(void *data, size_t id)
+{
+  mygsl_sf_table_map *m = (mygsl_sf_table_map *) data;
+  mygsl_sf_table_map_range(m, m->n*id/m->nthreads, m->n*(id + 1)/m->nthreads);
+  return GSL_SUCCESS;
+}
+
+static int mygsl_sf_table_map_serial(void *data)
+{
+  mygsl_sf_table_map *m = (mygsl_sf_table_map *) data;
+  mygsl_sf_table_map_range(m, 0, m->n);
+  return GSL_SUCCESS;
+}
+
+static void mygsl_sf_table_map_run(mygsl_sf_table_map *m)
+{
+  if (m->n == 0) return;
+  m->nthreads = rb_gsl_parallel_nthreads(m->n, (m->n + MYGSL_SF_TABLE_BLOCK - 1)/MYGSL_SF_TABLE_BLOCK);
+  if (m->nthreads > 1) rb_gsl_nogvl_parallel(mygsl_sf_table_map_worker, m, m->nthreads);
+  else rb_gsl_nogvl_call(mygsl_sf_table_map_serial, m, m->n);
+}
+
+/* Table#eval(x[, out]) */
+static VALUE rb_gsl_sf_table_eval(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  mygsl_sf_table_map m;
+  gsl_vector *v = NULL, *vout = NULL;
+  gsl_matrix *mx = NULL, *mout = NULL;
+  VALUE x, out = Qnil, ary, tmp = 0;
+  double *buf;
+  size_t i;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  x = argv[0];
+  if (argc == 2) out = rb_gsl_out_arg(argv[1]);
+  memset(&m, 0, sizeof(mygsl_sf_table_map));
+  m.t = t;
+  switch (TYPE(x)) {
+  case T_FLOAT:
+  case T_FIXNUM:
+  case T_BIGNUM:
+    return rb_float_new(mygsl_sf_table_eval1(t, NUM2DBL(x)));
+  case T_ARRAY:
+    m.n = RARRAY_LEN(x);
+    buf = ALLOCV_N(double, tmp, m.n + 1);
+    for (i = 0; i < m.n; i++) buf[i] = NUM2DBL(rb_ary_entry(x, i));
+    m.ncols = GSL_MAX(m.n, 1);
+    m.x = m.y = buf;
+    m.xstride = m.ystride = 1;
+    mygsl_sf_table_map_run(&m);
+    ary = rb_ary_new2(m.n);
+    for (i = 0; i < m.n; i++) rb_ary_store(ary, i, rb_float_new(buf[i]));
+    ALLOCV_END(tmp);
+    return ary;
+  default:
+    break;
+  }
+  if (MATRIX_P(x)) {
+    Data_Get_Struct(x, gsl_matrix, mx);
+    if (NIL_P(out)) {
+      mout = gsl_matrix_alloc(mx->size1, mx->size2);
+      out = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mout);
+    } else {
+      CHECK_MATRIX(out);
+      Data_Get_Struct(out, gsl_matrix, mout);
+      if (mout->size1 != mx->size1 || mout->size2 != mx->size2)
+	rb_raise(rb_eArgError, "output matrix must be %d x %d",
+		 (int) mx->size1, (int) mx->size2);
+    }
+    m.n = mx->size1*mx->size2;
+    m.ncols = mx->size2;
+    m.x = mx->data;
+    m.xtda = mx->tda;
+    m.xstride = 1;
+    m.y = mout->data;
+    m.ytda = mout->tda;
+    m.ystride = 1;
+  } else {
+    CHECK_VECTOR(x);
+    Data_Get_Struct(x, gsl_vector, v);
+    if (NIL_P(out)) {
+      vout = gsl_vector_alloc(v->size);
+      out = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vout);
+    } else {
+      CHECK_VECTOR(out);
+      Data_Get_Struct(out, gsl_vector, vout);
+      if (vout->size != v->size)
+	rb_raise(rb_eArgError, "output vector size must be %d", (int) v->size);
+    }
+    m.n = v->size;
+    m.ncols = GSL_MAX(v->size, 1);
+    m.x = v->data;
+    m.xstride = v->stride;
+    m.y = vout->data;
+    m.ystride = vout->stride;
+  }
+  mygsl_sf_table_map_run(&m);
+  return out;
+}
+
+static VALUE rb_gsl_sf_table_a(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return rb_float_new(t->a);
+}
+
+static VALUE rb_gsl_sf_table_b(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return rb_float_new(t->b);
+}
+
+static VALUE rb_gsl_sf_table_tol(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return rb_float_new(t->tol);
+}
+
+static VALUE rb_gsl_sf_table_error(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return rb_float_new(t->err);
+}
+
+static VALUE rb_gsl_sf_table_order(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return INT2FIX(t->order);
+}
+
+static VALUE rb_gsl_sf_table_size(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return INT2FIX(t->n);
+}
+
+static VALUE rb_gsl_sf_table_breakpoints(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  gsl_vector *v;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  v = gsl_vector_alloc(t->n + 1);
+  memcpy(v->data, t->brk, sizeof(double)*(t->n + 1));
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+/* The function: its name, or the Proc */
+static VALUE rb_gsl_sf_table_function(VALUE obj)
+{
+  mygsl_sf_table *t = NULL;
+  Data_Get_Struct(obj, mygsl_sf_table, t);
+  return t->func;
+}
+
+static VALUE rb_gsl_sf_table_functions(VALUE klass)
+{
+  VALUE ary = rb_ary_new();
+  size_t i;
+  for (i = 0; mygsl_sf_table_functions[i].name; i++)
+    rb_ary_push(ary, ID2SYM(rb_intern(mygsl_sf_table_functions[i].name)));
+  return ary;
+}
+
+void Init_gsl_sf_table(VALUE module)
+{
+  cgsl_sf_table = rb_define_class_under(module, "Table", cGSL_Object);
+  rb_define_singleton_method(cgsl_sf_table, "new", rb_gsl_sf_table_new, -1);
+  rb_define_singleton_method(cgsl_sf_table, "alloc", rb_gsl_sf_table_new, -1);
+  rb_define_singleton_method(cgsl_sf_table, "functions", rb_gsl_sf_table_functions, 0);
+  rb_define_method(cgsl_sf_table, "eval", rb_gsl_sf_table_eval, -1);
+  rb_define_alias(cgsl_sf_table, "call", "eval");
+  rb_define_alias(cgsl_sf_table, "[]", "eval");
+  rb_define_method(cgsl_sf_table, "a", rb_gsl_sf_table_a, 0);
+  rb_define_method(cgsl_sf_table, "b", rb_gsl_sf_table_b, 0);
+  rb_define_method(cgsl_sf_table, "tol", rb_gsl_sf_table_tol, 0);
+  rb_define_method(cgsl_sf_table, "error", rb_gsl_sf_table_error, 0);
+  rb_define_method(cgsl_sf_table, "order", rb_gsl_sf_table_order, 0);
+  rb_define_method(cgsl_sf_table, "size", rb_gsl_sf_table_size, 0);
+  rb_define_alias(cgsl_sf_table, "pieces", "size");
+  rb_define_method(cgsl_sf_table, "breakpoints", rb_gsl_sf_table_breakpoints, 0);
+  rb_define_method(cgsl_sf_table, "function", rb_gsl_sf_table_function, 0);
+}
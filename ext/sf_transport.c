@@ -11,9 +11,9 @@
 
 #include "rb_gsl_sf.h"
 
-static VALUE rb_gsl_sf_transport_2(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_transport_2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_transport_2, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_transport_2, argc, argv);
 }
 
 static VALUE rb_gsl_sf_transport_2_e(VALUE obj, VALUE x)
@@ -21,9 +21,9 @@ static VALUE rb_gsl_sf_transport_2_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_transport_2_e, x);
 }
 
-static VALUE rb_gsl_sf_transport_3(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_transport_3(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_transport_3, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_transport_3, argc, argv);
 }
 
 static VALUE rb_gsl_sf_transport_3_e(VALUE obj, VALUE x)
@@ -31,9 +31,9 @@ static VALUE rb_gsl_sf_transport_3_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_transport_3_e, x);
 }
 
-static VALUE rb_gsl_sf_transport_4(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_transport_4(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_transport_4, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_transport_4, argc, argv);
 }
 
 static VALUE rb_gsl_sf_transport_4_e(VALUE obj, VALUE x)
@@ -41,9 +41,9 @@ static VALUE rb_gsl_sf_transport_4_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_transport_4_e, x);
 }
 
-static VALUE rb_gsl_sf_transport_5(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_transport_5(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_transport_5, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_transport_5, argc, argv);
 }
 
 static VALUE rb_gsl_sf_transport_5_e(VALUE obj, VALUE x)
@@ -55,22 +55,22 @@ void Init_gsl_sf_transport(VALUE module)
 {
   VALUE mgsl_sf_trans;
 
-  rb_define_module_function(module, "transport_2",  rb_gsl_sf_transport_2, 1);
+  rb_define_module_function(module, "transport_2",  rb_gsl_sf_transport_2, -1);
   rb_define_module_function(module, "transport_2_e",  rb_gsl_sf_transport_2_e, 1);
-  rb_define_module_function(module, "transport_3",  rb_gsl_sf_transport_3, 1);
+  rb_define_module_function(module, "transport_3",  rb_gsl_sf_transport_3, -1);
   rb_define_module_function(module, "transport_3_e",  rb_gsl_sf_transport_3_e, 1);
-  rb_define_module_function(module, "transport_4",  rb_gsl_sf_transport_4, 1);
+  rb_define_module_function(module, "transport_4",  rb_gsl_sf_transport_4, -1);
   rb_define_module_function(module, "transport_4_e",  rb_gsl_sf_transport_4_e, 1);
-  rb_define_module_function(module, "transport_5",  rb_gsl_sf_transport_5, 1);
+  rb_define_module_function(module, "transport_5",  rb_gsl_sf_transport_5, -1);
   rb_define_module_function(module, "transport_5_e",  rb_gsl_sf_transport_5_e, 1);
 
   mgsl_sf_trans = rb_define_module_under(module, "Transport");
-  rb_define_module_function(mgsl_sf_trans, "two",  rb_gsl_sf_transport_2, 1);
+  rb_define_module_function(mgsl_sf_trans, "two",  rb_gsl_sf_transport_2, -1);
   rb_define_module_function(mgsl_sf_trans, "two_e",  rb_gsl_sf_transport_2_e, 1);
-  rb_define_module_function(mgsl_sf_trans, "three",  rb_gsl_sf_transport_3, 1);
+  rb_define_module_function(mgsl_sf_trans, "three",  rb_gsl_sf_transport_3, -1);
   rb_define_module_function(mgsl_sf_trans, "three_e",  rb_gsl_sf_transport_3_e, 1);
-  rb_define_module_function(mgsl_sf_trans, "four",  rb_gsl_sf_transport_4, 1);
+  rb_define_module_function(mgsl_sf_trans, "four",  rb_gsl_sf_transport_4, -1);
   rb_define_module_function(mgsl_sf_trans, "four_e",  rb_gsl_sf_transport_4_e, 1);
-  rb_define_module_function(mgsl_sf_trans, "five",  rb_gsl_sf_transport_5, 1);
+  rb_define_module_function(mgsl_sf_trans, "five",  rb_gsl_sf_transport_5, -1);
   rb_define_module_function(mgsl_sf_trans, "fine_e",  rb_gsl_sf_transport_5_e, 1);
 }
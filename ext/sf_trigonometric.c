@@ -46,9 +46,9 @@ static VALUE rb_gsl_sf_hypot_e(VALUE obj, VALUE x, VALUE y)
   return rb_gsl_sf_eval_e_double2(gsl_sf_hypot_e, x, y);
 }
 
-static VALUE rb_gsl_sf_sinc(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_sinc(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_sinc, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_sinc, argc, argv);
 }
 
 static VALUE rb_gsl_sf_sinc_e(VALUE obj, VALUE x)
@@ -102,9 +102,26 @@ static VALUE rb_gsl_sf_complex_logsin_e(int argc, VALUE *argv, VALUE obj)
   return rb_gsl_sf_complex_XXX_e(argc, argv, obj, gsl_sf_complex_logsin_e);
 }
 
-static VALUE rb_gsl_sf_lnsinh(VALUE obj, VALUE x)
+/* complex_sin(z[, out]) etc, z a GSL::Complex, Vector::Complex or
+   Matrix::Complex */
+static VALUE rb_gsl_sf_complex_sin(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_lnsinh, x);
+  return rb_gsl_sf_eval_complex_e(gsl_sf_complex_sin_e, 0, argc, argv);
+}
+
+static VALUE rb_gsl_sf_complex_cos(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval_complex_e(gsl_sf_complex_cos_e, 0, argc, argv);
+}
+
+static VALUE rb_gsl_sf_complex_logsin(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval_complex_e(gsl_sf_complex_logsin_e, 0, argc, argv);
+}
+
+static VALUE rb_gsl_sf_lnsinh(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sf_eval1_argv(gsl_sf_lnsinh, argc, argv);
 }
 
 static VALUE rb_gsl_sf_lnsinh_e(VALUE obj, VALUE x)
@@ -112,9 +129,9 @@ static VALUE rb_gsl_sf_lnsinh_e(VALUE obj, VALUE x)
   return rb_gsl_sf_eval_e(gsl_sf_lnsinh_e, x);
 }
 
-static VALUE rb_gsl_sf_lncosh(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_lncosh(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_lncosh, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_lncosh, argc, argv);
 }
 
 static VALUE rb_gsl_sf_lncosh_e(VALUE obj, VALUE x)
@@ -132,14 +149,14 @@ static VALUE rb_gsl_sf_rect_to_polar(int argc, VALUE *argv, VALUE obj)
   return rb_gsl_sf_complex_XXX_e(argc, argv, obj, gsl_sf_rect_to_polar);
 }
 
-static VALUE rb_gsl_sf_angle_restrict_symm(VALUE obj, VALUE theta)
+static VALUE rb_gsl_sf_angle_restrict_symm(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_angle_restrict_symm, theta);
+  return rb_gsl_sf_eval1_argv(gsl_sf_angle_restrict_symm, argc, argv);
 }
 
-static VALUE rb_gsl_sf_angle_restrict_pos(VALUE obj, VALUE theta)
+static VALUE rb_gsl_sf_angle_restrict_pos(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_angle_restrict_pos, theta);
+  return rb_gsl_sf_eval1_argv(gsl_sf_angle_restrict_pos, argc, argv);
 }
 
 /*
@@ -188,19 +205,22 @@ void Init_gsl_sf_trigonometric(VALUE module)
   rb_define_module_function(module, "cos_e",  rb_gsl_sf_cos_e, 1);
   rb_define_module_function(module, "hypot",  rb_gsl_sf_hypot, 2);
   rb_define_module_function(module, "hypot_e",  rb_gsl_sf_hypot_e, 2);
-  rb_define_module_function(module, "sinc",  rb_gsl_sf_sinc, 1);
+  rb_define_module_function(module, "sinc",  rb_gsl_sf_sinc, -1);
   rb_define_module_function(module, "sinc_e",  rb_gsl_sf_sinc_e, 1);
   rb_define_module_function(module, "complex_sin_e",  rb_gsl_sf_complex_sin_e, -1);
   rb_define_module_function(module, "complex_cos_e",  rb_gsl_sf_complex_cos_e, -1);
   rb_define_module_function(module, "complex_logsin_e",  rb_gsl_sf_complex_logsin_e, -1);
-  rb_define_module_function(module, "lnsinh",  rb_gsl_sf_lnsinh, 1);
+  rb_define_module_function(module, "complex_sin",  rb_gsl_sf_complex_sin, -1);
+  rb_define_module_function(module, "complex_cos",  rb_gsl_sf_complex_cos, -1);
+  rb_define_module_function(module, "complex_logsin",  rb_gsl_sf_complex_logsin, -1);
+  rb_define_module_function(module, "lnsinh",  rb_gsl_sf_lnsinh, -1);
   rb_define_module_function(module, "lnsinh_e",  rb_gsl_sf_lnsinh_e, 1);
-  rb_define_module_function(module, "lncosh",  rb_gsl_sf_lncosh, 1);
+  rb_define_module_function(module, "lncosh",  rb_gsl_sf_lncosh, -1);
   rb_define_module_function(module, "lncosh_e",  rb_gsl_sf_lncosh_e, 1);
   rb_define_module_function(module, "polar_to_rect",  rb_gsl_sf_polar_to_rect, -1);
   rb_define_module_function(module, "rect_to_polar",  rb_gsl_sf_rect_to_polar, -1);
-  rb_define_module_function(module, "angle_restrict_symm",  rb_gsl_sf_angle_restrict_symm, 1);
-  rb_define_module_function(module, "angle_restrict_pos",  rb_gsl_sf_angle_restrict_pos, 1);
+  rb_define_module_function(module, "angle_restrict_symm",  rb_gsl_sf_angle_restrict_symm, -1);
+  rb_define_module_function(module, "angle_restrict_pos",  rb_gsl_sf_angle_restrict_pos, -1);
 
   /*  rb_define_module_function(module, "sin_err",  rb_gsl_sf_sin_err, 2);
       rb_define_module_function(module, "cos_err",  rb_gsl_sf_cos_err, 2);*/
@@ -27,9 +27,9 @@ static VALUE rb_gsl_sf_zeta_int_e(VALUE obj, VALUE n)
   return rb_gsl_sf_eval_e_int(gsl_sf_zeta_int_e, nn);
 }
 
-static VALUE rb_gsl_sf_zeta(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_zeta(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_zeta, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_zeta, argc, argv);
 }
 
 static VALUE rb_gsl_sf_zeta_e(VALUE obj, VALUE x)
@@ -58,9 +58,9 @@ static VALUE rb_gsl_sf_eta_int_e(VALUE obj, VALUE n)
   return rb_gsl_sf_eval_e_int(gsl_sf_eta_int_e, n);
 }
 
-static VALUE rb_gsl_sf_eta(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_eta(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_eta, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_eta, argc, argv);
 }
 
 static VALUE rb_gsl_sf_eta_e(VALUE obj, VALUE x)
@@ -85,9 +85,9 @@ static VALUE rb_gsl_sf_zetam1_int_e(VALUE obj, VALUE n)
   return rb_gsl_sf_eval_e_int(gsl_sf_zetam1_int_e, nn);
 }
 
-static VALUE rb_gsl_sf_zetam1(VALUE obj, VALUE x)
+static VALUE rb_gsl_sf_zetam1(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(gsl_sf_zetam1, x);
+  return rb_gsl_sf_eval1_argv(gsl_sf_zetam1, argc, argv);
 }
 
 static VALUE rb_gsl_sf_zetam1_e(VALUE obj, VALUE x)
@@ -100,20 +100,20 @@ void Init_gsl_sf_zeta(VALUE module)
 {
   rb_define_module_function(module, "zeta_int",  rb_gsl_sf_zeta_int, 1);
   rb_define_module_function(module, "zeta_int_e",  rb_gsl_sf_zeta_int_e, 1);
-  rb_define_module_function(module, "zeta",  rb_gsl_sf_zeta, 1);
+  rb_define_module_function(module, "zeta",  rb_gsl_sf_zeta, -1);
   rb_define_module_function(module, "zeta_e",  rb_gsl_sf_zeta_e, 1);
 
   rb_define_module_function(module, "hzeta",  rb_gsl_sf_hzeta, 2);
   rb_define_module_function(module, "hzeta_e",  rb_gsl_sf_hzeta_e, 2);
   rb_define_module_function(module, "eta_int",  rb_gsl_sf_eta_int, 1);
   rb_define_module_function(module, "eta_int_e",  rb_gsl_sf_eta_int_e, 1);
-  rb_define_module_function(module, "eta",  rb_gsl_sf_eta, 1);
+  rb_define_module_function(module, "eta",  rb_gsl_sf_eta, -1);
   rb_define_module_function(module, "eta_e",  rb_gsl_sf_eta_e, 1);
 
 #ifdef GSL_1_4_9_LATER
   rb_define_module_function(module, "zetam1_int",  rb_gsl_sf_zetam1_int, 1);
   rb_define_module_function(module, "zetam1_int_e",  rb_gsl_sf_zetam1_int_e, 1);
-  rb_define_module_function(module, "zetam1",  rb_gsl_sf_zetam1, 1);
+  rb_define_module_function(module, "zetam1",  rb_gsl_sf_zetam1, -1);
   rb_define_module_function(module, "zetam1_e",  rb_gsl_sf_zetam1_e, 1);
 #endif
 }
@@ -11,6 +11,7 @@
 
 #include "rb_gsl_config.h"
 #include "rb_gsl_fft.h"
+#include "rb_gsl_common.h"
 
 enum FFT_CONV_CORR {
   RB_GSL_FFT_CONVOLVE = 0,
@@ -283,6 +284,423 @@ static VALUE rb_gsl_fft_halfcomplex_correlate(int argc, VALUE *argv, VALUE obj)
             RB_GSL_FFT_CORRELATE);
 }
 
+/* z = x*y, spectra in the halfcomplex format of length n; z may be x */
+static void rbgsl_hc_mul(const double *x, const double *y, double *z, size_t n)
+{
+  size_t i;
+  double re;
+  z[0] = x[0]*y[0];
+  for (i = 1; i + 1 < n; i += 2) {
+    re = x[i]*y[i] - x[i+1]*y[i+1];
+    z[i+1] = x[i]*y[i+1] + x[i+1]*y[i];
+    z[i] = re;
+  }
+  if (n % 2 == 0) z[n-1] = x[n-1]*y[n-1];
+}
+
+/*
+  Convolves in place count sequences of n values, the r-th at x + r*dist
+  with the given stride, with the kernel k of odd length nk centered on
+  k[nk/2]: x[i] <- sum_j k[j] x[i + nk/2 - j], the values beyond the
+  ends taken as 0.  Each takes one transform of length
+  rb_gsl_fft_good_size(n + nk - 1), the kernel spectrum being computed
+  once.  Used by GSL::KDE; must be called with the GVL held.
+*/
+void rb_gsl_fft_convolve_same(double *x, size_t n, size_t stride, size_t dist,
+			      size_t count, const double *k, size_t nk)
+{
+  size_t nfft = rb_gsl_fft_good_size(n + nk - 1), h = nk/2, r, i;
+  double *kf, *buf, *xr;
+  VALUE tmp;
+  kf = ALLOCV_N(double, tmp, 2*nfft);
+  buf = kf + nfft;
+  memset(kf, 0, sizeof(double)*nfft);
+  memcpy(kf, k, sizeof(double)*nk);
+  rb_gsl_fft_real_cached(kf, nfft, 0);
+  for (r = 0; r < count; r++) {
+    xr = x + r*dist;
+    for (i = 0; i < n; i++) buf[i] = xr[i*stride];
+    for (i = n; i < nfft; i++) buf[i] = 0.0;
+    rb_gsl_fft_real_cached(buf, nfft, 0);
+    rbgsl_hc_mul(buf, kf, buf, nfft);
+    rb_gsl_fft_real_cached(buf, nfft, 1);
+    for (i = 0; i < n; i++) xr[i*stride] = buf[i + h];
+  }
+  ALLOCV_END(tmp);
+}
+
+/*
+  GSL::Signal::Convolver: streaming linear convolution by overlap-add.
+  The kernel spectrum and all buffers are allocated once; each call of
+  process() transforms one block of at most block_size samples.
+*/
+static VALUE mgsl_signal, cgsl_signal_convolver;
+
+typedef struct {
+  size_t m;        /* kernel length */
+  size_t block;    /* maximum block length */
+  size_t nfft;     /* transform length, power of 2 >= block + m - 1 */
+  double *kernel;  /* kernel spectrum, halfcomplex */
+  double *buf;
+  double *tail;    /* m - 1 samples carried over to the next block */
+  gsl_fft_real_wavetable *rtable;
+  gsl_fft_halfcomplex_wavetable *htable;
+  gsl_fft_real_workspace *space;
+} rb_gsl_convolver;
+
+static void rb_gsl_convolver_free(rb_gsl_convolver *c)
+{
+  if (c->rtable) gsl_fft_real_wavetable_free(c->rtable);
+  if (c->htable) gsl_fft_halfcomplex_wavetable_free(c->htable);
+  if (c->space) gsl_fft_real_workspace_free(c->space);
+  free(c->kernel);
+  free(c->buf);
+  free(c->tail);
+  free(c);
+}
+
+static VALUE rb_gsl_convolver_new(VALUE klass, VALUE vk, VALUE vblock)
+{
+  rb_gsl_convolver *c;
+  gsl_vector *k;
+  size_t i;
+  long block;
+  CHECK_VECTOR(vk);
+  Data_Get_Struct(vk, gsl_vector, k);
+  block = NUM2LONG(vblock);
+  if (k->size == 0) rb_raise(rb_eArgError, "empty kernel");
+  if (block <= 0) rb_raise(rb_eArgError, "block size must be positive");
+  c = (rb_gsl_convolver *) calloc(1, sizeof(rb_gsl_convolver));
+  if (c == NULL) rb_raise(rb_eNoMemError, "calloc failed");
+  c->m = k->size;
+  c->block = (size_t) block;
+  for (c->nfft = 2; c->nfft < c->block + c->m - 1; c->nfft *= 2);
+  c->kernel = (double *) calloc(c->nfft, sizeof(double));
+  c->buf = (double *) calloc(c->nfft, sizeof(double));
+  c->tail = (double *) calloc(c->m, sizeof(double));
+  c->rtable = gsl_fft_real_wavetable_alloc(c->nfft);
+  c->htable = gsl_fft_halfcomplex_wavetable_alloc(c->nfft);
+  c->space = gsl_fft_real_workspace_alloc(c->nfft);
+  if (!c->kernel || !c->buf || !c->tail || !c->rtable || !c->htable || !c->space) {
+    rb_gsl_convolver_free(c);
+    rb_raise(rb_eNoMemError, "allocation failed");
+  }
+  for (i = 0; i < c->m; i++) c->kernel[i] = gsl_vector_get(k, i);
+  gsl_fft_real_transform(c->kernel, 1, c->nfft, c->rtable, c->space);
+  return Data_Wrap_Struct(klass, 0, rb_gsl_convolver_free, c);
+}
+
+/* convolver.process(x[, y]): filters the block x, with the tail of the
+   previous blocks added, into y (a new vector if not given). */
+static VALUE rb_gsl_convolver_process(int argc, VALUE *argv, VALUE obj)
+{
+  rb_gsl_convolver *c;
+  gsl_vector *x, *y;
+  size_t i, n, ntail;
+  VALUE vy;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  Data_Get_Struct(obj, rb_gsl_convolver, c);
+  CHECK_VECTOR(argv[0]);
+  Data_Get_Struct(argv[0], gsl_vector, x);
+  n = x->size;
+  if (n > c->block)
+    rb_raise(rb_eArgError, "block too long (%d > %d)", (int) n, (int) c->block);
+  if (argc == 2) {
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Struct(argv[1], gsl_vector, y);
+    if (y->size != n) rb_raise(rb_eArgError, "output vector size must be %d", (int) n);
+    vy = argv[1];
+  } else {
+    y = gsl_vector_alloc(n);
+    vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+  }
+  if (n == 0) return vy;
+  for (i = 0; i < n; i++) c->buf[i] = gsl_vector_get(x, i);
+  for (i = n; i < c->nfft; i++) c->buf[i] = 0.0;
+  gsl_fft_real_transform(c->buf, 1, c->nfft, c->rtable, c->space);
+  rbgsl_calc_conv_corr_c(c->buf, c->kernel, c->buf, c->nfft, c->htable, c->space,
+			 RB_GSL_FFT_CONVOLVE);
+  gsl_fft_halfcomplex_inverse(c->buf, 1, c->nfft, c->htable, c->space);
+  ntail = c->m - 1;
+  for (i = 0; i < n; i++) 
+    gsl_vector_set(y, i, c->buf[i] + (i < ntail ? c->tail[i] : 0.0));
+  for (i = 0; i < ntail; i++)
+    c->tail[i] = c->buf[n + i] + (n + i < ntail ? c->tail[n + i] : 0.0);
+  return vy;
+}
+
+/* Returns the kernel_size - 1 samples still pending (nil for a kernel
+   of length 1) and resets */
+static VALUE rb_gsl_convolver_flush(VALUE obj)
+{
+  rb_gsl_convolver *c;
+  gsl_vector *v;
+  Data_Get_Struct(obj, rb_gsl_convolver, c);
+  if (c->m == 1) return Qnil;
+  v = gsl_vector_alloc(c->m - 1);
+  memcpy(v->data, c->tail, sizeof(double)*(c->m - 1));
+  memset(c->tail, 0, sizeof(double)*c->m);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE rb_gsl_convolver_reset(VALUE obj)
+{
+  rb_gsl_convolver *c;
+  Data_Get_Struct(obj, rb_gsl_convolver, c);
+  memset(c->tail, 0, sizeof(double)*c->m);
+  return obj;
+}
+
+static VALUE rb_gsl_convolver_kernel_size(VALUE obj)
+{
+  rb_gsl_convolver *c;
+  Data_Get_Struct(obj, rb_gsl_convolver, c);
+  return SIZET2NUM(c->m);
+}
+
+static VALUE rb_gsl_convolver_block_size(VALUE obj)
+{
+  rb_gsl_convolver *c;
+  Data_Get_Struct(obj, rb_gsl_convolver, c);
+  return SIZET2NUM(c->block);
+}
+
+static VALUE rb_gsl_convolver_fft_size(VALUE obj)
+{
+  rb_gsl_convolver *c;
+  Data_Get_Struct(obj, rb_gsl_convolver, c);
+  return SIZET2NUM(c->nfft);
+}
+
+/*
+  GSL::Signal.xcorr(m, opts = {}): the cross-correlations of every pair
+  of columns of the n x p matrix m,
+
+    r_ij(k) = sum_t m[t+k][i] m[t][j],   -max_lag <= k <= max_lag,
+
+  the values beyond the ends taken as 0 (a linear correlation, where
+  Vector#correlate is circular).  Each column is transformed once,
+  padded to rb_gsl_fft_good_size(n + max_lag), and the spectra are kept;
+  each pair of them is then multiplied and transformed back, the pairs
+  spread over GSL.parallel_threads threads with the GVL released.
+
+  Options:
+    :max_lag    n - 1
+    :center     subtract the mean of each column first (false)
+    :normalize  divide r_ij by sqrt(r_ii(0) r_jj(0)) (false)
+    :peak       true for the largest value of each r_ij, :abs for the
+                largest magnitude, instead of all the lags
+
+  Returns a p(p+1)/2 x (2 max_lag + 1) Matrix, the pair i <= j in row
+  i*p - i*(i-1)/2 + j - i and the lag k in column k + max_lag (r_ji(k)
+  is r_ij(-k)).  With :peak, [lags, values]: a p x p Matrix::Int and a p
+  x p Matrix.  m.xcorr(opts) is the same.
+*/
+enum {
+  XCORR_ALL,
+  XCORR_PEAK_MAX,
+  XCORR_PEAK_ABS,
+};
+
+struct xcorr_task {
+  const gsl_matrix *m;
+  size_t n, p, nfft, maxlag, npairs, nthreads;
+  int center, normalize, peak, phase;
+  double *spec;     /* p spectra of nfft */
+  double *norm;     /* p */
+  double *buf;      /* nthreads x nfft */
+  gsl_fft_real_wavetable *rtable;
+  gsl_fft_halfcomplex_wavetable *htable;
+  gsl_fft_real_workspace **space;   /* nthreads */
+  gsl_matrix *out;
+  gsl_matrix_int *lags;
+  gsl_matrix *vals;
+};
+
+/* z = x*conj(y), spectra in the halfcomplex format of length n */
+static void rbgsl_hc_mul_conj(const double *x, const double *y, double *z, size_t n)
+{
+  size_t i;
+  z[0] = x[0]*y[0];
+  for (i = 1; i + 1 < n; i += 2) {
+    z[i] = x[i]*y[i] + x[i+1]*y[i+1];
+    z[i+1] = x[i+1]*y[i] - x[i]*y[i+1];
+  }
+  if (n % 2 == 0) z[n-1] = x[n-1]*y[n-1];
+}
+
+static void xcorr_transform(struct xcorr_task *t, size_t s, size_t id)
+{
+  const gsl_matrix *m = t->m;
+  double *x = t->spec + s*t->nfft, mean = 0.0, ss = 0.0;
+  size_t i;
+  for (i = 0; i < t->n; i++) x[i] = m->data[i*m->tda + s];
+  if (t->center) {
+    for (i = 0; i < t->n; i++) mean += x[i];
+    mean /= (double) t->n;
+    for (i = 0; i < t->n; i++) x[i] -= mean;
+  }
+  for (i = 0; i < t->n; i++) ss += x[i]*x[i];
+  for (i = t->n; i < t->nfft; i++) x[i] = 0.0;
+  t->norm[s] = ss;
+  gsl_fft_real_transform(x, 1, t->nfft, t->rtable, t->space[id]);
+}
+
+static void xcorr_pair(struct xcorr_task *t, size_t q, size_t i, size_t j, size_t id)
+{
+  double *buf = t->buf + id*t->nfft, scale = 1.0, v, best = 0.0;
+  long k, L = (long) t->maxlag, kbest = 0;
+  rbgsl_hc_mul_conj(t->spec + i*t->nfft, t->spec + j*t->nfft, buf, t->nfft);
+  gsl_fft_halfcomplex_inverse(buf, 1, t->nfft, t->htable, t->space[id]);
+  if (t->normalize) scale = 1.0/sqrt(t->norm[i]*t->norm[j]);
+  for (k = -L; k <= L; k++) {
+    v = buf[k >= 0 ? (size_t) k : t->nfft - (size_t) (-k)]*scale;
+    if (t->peak == XCORR_ALL) {
+      t->out->data[q*t->out->tda + (size_t) (k + L)] = v;
+    } else if (k == -L || (t->peak == XCORR_PEAK_ABS ? fabs(v) > fabs(best) : v > best)) {
+      best = v;
+      kbest = k;
+    }
+  }
+  if (t->peak == XCORR_ALL) return;
+  t->lags->data[i*t->lags->tda + j] = (int) kbest;
+  t->lags->data[j*t->lags->tda + i] = (int) -kbest;
+  t->vals->data[i*t->vals->tda + j] = best;
+  t->vals->data[j*t->vals->tda + i] = best;
+}
+
+static int xcorr_worker(void *data, size_t id)
+{
+  struct xcorr_task *t = (struct xcorr_task *) data;
+  size_t s, q, q0, q1, i, j;
+  if (t->phase == 0) {
+    for (s = id*t->p/t->nthreads; s < (id + 1)*t->p/t->nthreads; s++)
+      xcorr_transform(t, s, id);
+    return GSL_SUCCESS;
+  }
+  q0 = id*t->npairs/t->nthreads;
+  q1 = (id + 1)*t->npairs/t->nthreads;
+  /* the pair of index q0, rows i having p - i pairs each */
+  for (i = 0, q = 0; q + (t->p - i) <= q0; q += t->p - i, i++);
+  j = i + (q0 - q);
+  for (q = q0; q < q1; q++) {
+    xcorr_pair(t, q, i, j, id);
+    if (++j == t->p) j = ++i;
+  }
+  return GSL_SUCCESS;
+}
+
+static int xcorr_serial(void *data)
+{
+  return xcorr_worker(data, 0);
+}
+
+static void xcorr_run(struct xcorr_task *t, int phase, size_t work)
+{
+  t->phase = phase;
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(xcorr_worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(xcorr_serial, t, work);
+}
+
+static void xcorr_free(struct xcorr_task *t)
+{
+  size_t id;
+  if (t->rtable) gsl_fft_real_wavetable_free(t->rtable);
+  if (t->htable) gsl_fft_halfcomplex_wavetable_free(t->htable);
+  if (t->space) {
+    for (id = 0; id < t->nthreads; id++)
+      if (t->space[id]) gsl_fft_real_workspace_free(t->space[id]);
+    xfree(t->space);
+  }
+  if (t->spec) xfree(t->spec);
+  if (t->buf) xfree(t->buf);
+}
+
+static VALUE xcorr_ensure(VALUE data)
+{
+  xcorr_free((struct xcorr_task *) data);
+  return Qnil;
+}
+
+static VALUE xcorr_body(VALUE data)
+{
+  struct xcorr_task *t = (struct xcorr_task *) data;
+  size_t id, logn;
+  t->rtable = gsl_fft_real_wavetable_alloc(t->nfft);
+  t->htable = gsl_fft_halfcomplex_wavetable_alloc(t->nfft);
+  t->space = ALLOC_N(gsl_fft_real_workspace *, t->nthreads);
+  for (id = 0; id < t->nthreads; id++) t->space[id] = NULL;
+  for (id = 0; id < t->nthreads; id++) t->space[id] = gsl_fft_real_workspace_alloc(t->nfft);
+  for (id = 0; id < t->nthreads; id++)
+    if (t->space[id] == NULL) rb_raise(rb_eNoMemError, "fft workspace allocation failed");
+  if (t->rtable == NULL || t->htable == NULL)
+    rb_raise(rb_eNoMemError, "fft wavetable allocation failed");
+  t->spec = ALLOC_N(double, t->p*t->nfft + t->p);
+  t->norm = t->spec + t->p*t->nfft;
+  t->buf = ALLOC_N(double, t->nthreads*t->nfft);
+  for (logn = 1; ((size_t) 1 << logn) < t->nfft; logn++);
+  xcorr_run(t, 0, t->p*t->nfft*logn);
+  xcorr_run(t, 1, t->npairs*t->nfft*logn);
+  return Qnil;
+}
+
+static VALUE rb_gsl_signal_xcorr(int argc, VALUE *argv, VALUE module)
+{
+  struct xcorr_task t;
+  VALUE opts = Qnil, v, vout;
+  size_t logn;
+  memset(&t, 0, sizeof(t));
+  rb_scan_args(argc, argv, "11", &v, &opts);
+  CHECK_MATRIX(v);
+  Data_Get_Struct(v, gsl_matrix, t.m);
+  t.n = t.m->size1;
+  t.p = t.m->size2;
+  if (t.n == 0 || t.p == 0) rb_raise(rb_eArgError, "empty matrix");
+  t.maxlag = t.n - 1;
+  if (!NIL_P(opts)) {
+    VALUE lag, peak;
+    Check_Type(opts, T_HASH);
+    lag = rb_hash_aref(opts, ID2SYM(rb_intern("max_lag")));
+    if (!NIL_P(lag)) {
+      if (NUM2LONG(lag) < 0 || (size_t) NUM2LONG(lag) >= t.n)
+	rb_raise(rb_eArgError, "max_lag must be between 0 and %d", (int) t.n - 1);
+      t.maxlag = NUM2SIZET(lag);
+    }
+    t.center = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("center"))));
+    t.normalize = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("normalize"))));
+    peak = rb_hash_aref(opts, ID2SYM(rb_intern("peak")));
+    if (peak == ID2SYM(rb_intern("abs"))) t.peak = XCORR_PEAK_ABS;
+    else if (RTEST(peak)) t.peak = XCORR_PEAK_MAX;
+  }
+  t.nfft = rb_gsl_fft_good_size(t.n + t.maxlag);
+  t.npairs = t.p*(t.p + 1)/2;
+  for (logn = 1; ((size_t) 1 << logn) < t.nfft; logn++);
+  t.nthreads = rb_gsl_parallel_nthreads(t.npairs*t.nfft*logn, GSL_MIN(t.p, t.npairs));
+  if (t.nthreads == 0) t.nthreads = 1;
+  if (t.peak == XCORR_ALL) {
+    t.out = gsl_matrix_alloc(t.npairs, 2*t.maxlag + 1);
+    vout = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, t.out);
+  } else {
+    t.lags = gsl_matrix_int_alloc(t.p, t.p);
+    t.vals = gsl_matrix_alloc(t.p, t.p);
+    vout = rb_ary_new3(2, Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, t.lags),
+		       Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, t.vals));
+  }
+  rb_ensure(xcorr_body, (VALUE) &t, xcorr_ensure, (VALUE) &t);
+  RB_GC_GUARD(v);
+  return vout;
+}
+
+static VALUE rb_gsl_matrix_xcorr(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE args[2];
+  rb_check_arity(argc, 0, 1);
+  args[0] = obj;
+  args[1] = argc == 1 ? argv[0] : Qnil;
+  return rb_gsl_signal_xcorr(1 + argc, args, mgsl_signal);
+}
+
 void Init_gsl_signal(VALUE module)
 {
   rb_define_method(cgsl_vector, "real_convolve", rb_gsl_fft_real_convolve, -1);
@@ -300,6 +718,20 @@ void Init_gsl_signal(VALUE module)
   rb_define_alias(cgsl_vector, "hc_convolve", "halfcomplex_convolve");
   rb_define_alias(cgsl_vector, "hc_deconvolve", "halfcomplex_deconvolve");
   rb_define_alias(cgsl_vector, "hc_correlate", "halfcomplex_correlate");
+
+  mgsl_signal = rb_define_module_under(module, "Signal");
+  cgsl_signal_convolver = rb_define_class_under(mgsl_signal, "Convolver", cGSL_Object);
+  rb_define_singleton_method(cgsl_signal_convolver, "new", rb_gsl_convolver_new, 2);
+  rb_define_singleton_method(cgsl_signal_convolver, "alloc", rb_gsl_convolver_new, 2);
+  rb_define_method(cgsl_signal_convolver, "process", rb_gsl_convolver_process, -1);
+  rb_define_method(cgsl_signal_convolver, "flush", rb_gsl_convolver_flush, 0);
+  rb_define_method(cgsl_signal_convolver, "reset", rb_gsl_convolver_reset, 0);
+  rb_define_method(cgsl_signal_convolver, "kernel_size", rb_gsl_convolver_kernel_size, 0);
+  rb_define_method(cgsl_signal_convolver, "block_size", rb_gsl_convolver_block_size, 0);
+  rb_define_method(cgsl_signal_convolver, "fft_size", rb_gsl_convolver_fft_size, 0);
+
+  rb_define_module_function(mgsl_signal, "xcorr", rb_gsl_signal_xcorr, -1);
+  rb_define_method(cgsl_matrix, "xcorr", rb_gsl_matrix_xcorr, -1);
 }
 
 #undef WAVETABLE_P
@@ -11,6 +11,7 @@
 
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_siman.h>
+#include <gsl/gsl_permutation.h>
 #include "rb_gsl.h"
 #include "rb_gsl_array.h"
 #include "rb_gsl_function.h"
@@ -25,12 +26,22 @@ static VALUE cgsl_siman_solver;
 static VALUE cgsl_siman_params;
 
 /***** siman_solver *****/
+/*
+  The state is a GSL::Vector or a GSL::Permutation, copied and
+  destroyed in C. Each state is wrapped once for the procs (vstate);
+  during a solve, the wrappers of the states GSL constructs are kept
+  alive by the Array keep, as is the wrapper of the Rng, vrng.
+*/
 typedef struct __siman_solver {
   VALUE proc_efunc;
   VALUE proc_step;
   VALUE proc_metric;
   VALUE proc_print;
   gsl_vector *vx;
+  gsl_permutation *p;
+  VALUE vstate;
+  VALUE vrng;
+  VALUE keep;
 } siman_solver;
 
 static siman_solver* gsl_siman_solver_alloc(size_t size);
@@ -43,12 +54,23 @@ static void gsl_siman_solver_mark(siman_solver *s)
   rb_gc_mark(s->proc_step);
   rb_gc_mark(s->proc_metric);
   rb_gc_mark(s->proc_print);
+  rb_gc_mark(s->vstate);
+  rb_gc_mark(s->vrng);
+  rb_gc_mark(s->keep);
 }
 
 static siman_solver* gsl_siman_solver_alloc(size_t size)
 {
   siman_solver *ss = NULL;
   ss = ALLOC(siman_solver);
+  ss->proc_efunc = Qnil;
+  ss->proc_step = Qnil;
+  ss->proc_metric = Qnil;
+  ss->proc_print = Qnil;
+  ss->vstate = Qnil;
+  ss->vrng = Qnil;
+  ss->keep = Qnil;
+  ss->p = NULL;
   if (size > 0) {
     ss->vx = gsl_vector_alloc(size);
   } else {
@@ -60,9 +82,52 @@ static siman_solver* gsl_siman_solver_alloc(size_t size)
 static void gsl_siman_solver_free(siman_solver *ss)
 {
   if (ss->vx) gsl_vector_free(ss->vx);
+  if (ss->p) gsl_permutation_free(ss->p);
   free((siman_solver *) ss);
 }
 
+/* The state for the procs, wrapped on the first call */
+static VALUE rb_gsl_siman_state(siman_solver *ss)
+{
+  if (NIL_P(ss->vstate)) {
+    if (ss->p) ss->vstate = Data_Wrap_Struct(cgsl_permutation, 0, NULL, ss->p);
+    else ss->vstate = Data_Wrap_Struct(cgsl_vector, 0, NULL, ss->vx);
+    if (!NIL_P(ss->keep)) rb_ary_push(ss->keep, ss->vstate);
+  }
+  return ss->vstate;
+}
+
+/* Gives ss a state of the kind and size of x0, a copy of it */
+static void rb_gsl_siman_state_set(siman_solver *ss, VALUE x0)
+{
+  gsl_vector *v = NULL;
+  gsl_permutation *p = NULL;
+  if (PERMUTATION_P(x0)) {
+    Data_Get_Struct(x0, gsl_permutation, p);
+    if (ss->vx || (ss->p && ss->p->size != p->size)) {
+      if (ss->vx) gsl_vector_free(ss->vx);
+      if (ss->p) gsl_permutation_free(ss->p);
+      ss->vx = NULL;
+      ss->p = NULL;
+      ss->vstate = Qnil;
+    }
+    if (ss->p == NULL) ss->p = gsl_permutation_alloc(p->size);
+    gsl_permutation_memcpy(ss->p, p);
+  } else {
+    CHECK_VECTOR(x0);
+    Data_Get_Struct(x0, gsl_vector, v);
+    if (ss->p || (ss->vx && ss->vx->size != v->size)) {
+      if (ss->vx) gsl_vector_free(ss->vx);
+      if (ss->p) gsl_permutation_free(ss->p);
+      ss->vx = NULL;
+      ss->p = NULL;
+      ss->vstate = Qnil;
+    }
+    if (ss->vx == NULL) ss->vx = gsl_vector_alloc(v->size);
+    gsl_vector_memcpy(ss->vx, v);
+  }
+}
+
 static VALUE rb_gsl_siman_solver_new(int argc, VALUE *argv, VALUE klass)
 {
   siman_solver *ss = NULL;
@@ -117,7 +182,7 @@ static double rb_gsl_siman_Efunc_t(void *data)
   siman_solver *ss = NULL;
   ss = (siman_solver *) data;
   proc = (VALUE) ss->proc_efunc;
-  params = Data_Wrap_Struct(cgsl_vector, 0, NULL, ss->vx);
+  params = rb_gsl_siman_state(ss);
   result = rb_funcall(proc, RBGSL_ID_call, 1, params);
   return NUM2DBL(result);
 }
@@ -150,7 +215,8 @@ static void rb_gsl_siman_copy_t(void *source, void *dest)
   siman_solver *sssrc = NULL, *ssdest = NULL;
   sssrc = (siman_solver *) source;
   ssdest = (siman_solver *) dest;
-  gsl_vector_memcpy(ssdest->vx, sssrc->vx);
+  if (sssrc->p) gsl_permutation_memcpy(ssdest->p, sssrc->p);
+  else gsl_vector_memcpy(ssdest->vx, sssrc->vx);
 }
 
 /***** siman_copy_construct *****/
@@ -159,12 +225,19 @@ static void* rb_gsl_siman_copy_construct_t(void *data)
   siman_solver *ssdest = NULL;
   siman_solver *sssrc = NULL;
   sssrc = (siman_solver *) data;
-  ssdest = (siman_solver *) gsl_siman_solver_alloc(sssrc->vx->size);
+  if (sssrc->p) {
+    ssdest = (siman_solver *) gsl_siman_solver_alloc(0);
+    ssdest->p = gsl_permutation_alloc(sssrc->p->size);
+  } else {
+    ssdest = (siman_solver *) gsl_siman_solver_alloc(sssrc->vx->size);
+  }
   ssdest->proc_efunc = sssrc->proc_efunc;
   ssdest->proc_step = sssrc->proc_step;
   ssdest->proc_metric = sssrc->proc_metric;
   ssdest->proc_print = sssrc->proc_print;
-  gsl_vector_memcpy(ssdest->vx, sssrc->vx);
+  ssdest->vrng = sssrc->vrng;
+  ssdest->keep = sssrc->keep;
+  rb_gsl_siman_copy_t(sssrc, ssdest);
   return ssdest;
 }
 
@@ -223,7 +296,7 @@ static void rb_gsl_siman_print_t(void *data)
   ss = (siman_solver *) data;
   proc = ss->proc_print;
   if (NIL_P(proc)) return;
-  params = Data_Wrap_Struct(cgsl_vector, 0, NULL, ss->vx);
+  params = rb_gsl_siman_state(ss);
   rb_funcall(proc, RBGSL_ID_call, 1, params);
 }
 
@@ -291,8 +364,9 @@ static void rb_gsl_siman_step_t(const gsl_rng *r, void *data, double step_size)
   siman_solver *ss = NULL;
   ss = (siman_solver *) data;
   proc = (VALUE) ss->proc_step;
-  rng = Data_Wrap_Struct(cgsl_rng, 0, NULL, (gsl_rng *) r);
-  params = Data_Wrap_Struct(cgsl_vector, 0, NULL, ss->vx);
+  rng = ss->vrng;
+  if (NIL_P(rng)) rng = Data_Wrap_Struct(cgsl_rng, 0, NULL, (gsl_rng *) r);
+  params = rb_gsl_siman_state(ss);
   rb_funcall(proc, RBGSL_ID_call, 3, rng, params, rb_float_new(step_size));
 }
 
@@ -361,8 +435,8 @@ static double rb_gsl_siman_metric_t(void *data, void *yp)
   ss = (siman_solver *) data;
   ssy = (siman_solver *) yp;
   proc = ss->proc_metric;
-  vxp = Data_Wrap_Struct(cgsl_vector, 0, NULL, ss->vx);
-  vyp = Data_Wrap_Struct(cgsl_vector, 0, NULL, ssy->vx);
+  vxp = rb_gsl_siman_state(ss);
+  vyp = rb_gsl_siman_state(ssy);
   result = rb_funcall(proc, RBGSL_ID_call, 2, vxp, vyp);
   return NUM2DBL(result);
 }
@@ -569,18 +643,25 @@ static VALUE rb_gsl_siman_solver_solve(VALUE obj, VALUE rng,
   siman_metric *metric = NULL;
   siman_print *print = NULL;
   gsl_vector *vtmp = NULL;
+  gsl_permutation *ptmp = NULL;
   gsl_siman_params_t *params = NULL;
-  int flag = 0;
+  VALUE vss = Qnil, keep;
   /*  Data_Get_Struct(obj, siman_solver, ss);*/
-  CHECK_VECTOR(vx0p);
-  Data_Get_Struct(vx0p, gsl_vector, vtmp);
+  if (PERMUTATION_P(vx0p)) {
+    Data_Get_Struct(vx0p, gsl_permutation, ptmp);
+  } else {
+    CHECK_VECTOR(vx0p);
+    Data_Get_Struct(vx0p, gsl_vector, vtmp);
+  }
 
   switch (TYPE(obj)) {
   case T_MODULE:
   case T_CLASS:
   case T_OBJECT:
-    ss = gsl_siman_solver_alloc(vtmp->size);
-    flag = 1;
+    /* wrapped, so that it is freed if a proc raises */
+    ss = gsl_siman_solver_alloc(0);
+    vss = Data_Wrap_Struct(cgsl_siman_solver, gsl_siman_solver_mark,
+			   gsl_siman_solver_free, ss);
     break;
   default:
     Data_Get_Struct(obj, siman_solver, ss);
@@ -621,7 +702,11 @@ static VALUE rb_gsl_siman_solver_solve(VALUE obj, VALUE rng,
   ss->proc_step    = step->proc;
   ss->proc_metric  = metric->proc;
 
-  gsl_vector_memcpy(ss->vx, vtmp);
+  rb_gsl_siman_state_set(ss, vx0p);
+  keep = rb_ary_new();
+  ss->keep = keep;
+  ss->vrng = Data_Wrap_Struct(cgsl_rng, 0, NULL, r);
+  rb_ary_push(keep, ss->vrng);
 
   if (NIL_P(vprint)) {
     gsl_siman_solve(r, ss, rb_gsl_siman_Efunc_t, 
@@ -644,13 +729,18 @@ static VALUE rb_gsl_siman_solver_solve(VALUE obj, VALUE rng,
 		    *params);
   }
 
-  gsl_vector_memcpy(vtmp, ss->vx);
-
-  if (flag == 1) gsl_siman_solver_free(ss);
+  if (ptmp) gsl_permutation_memcpy(ptmp, ss->p);
+  else gsl_vector_memcpy(vtmp, ss->vx);
+  ss->keep = Qnil;
+  ss->vrng = Qnil;
 
+  RB_GC_GUARD(vss);
+  RB_GC_GUARD(keep);
   return obj;
 }
 
+void Init_gsl_siman_tempering(VALUE mgsl_siman);
+
 void Init_gsl_siman(VALUE module)
 {
   VALUE mgsl_siman;
@@ -714,4 +804,6 @@ void Init_gsl_siman(VALUE module)
 
   rb_define_singleton_method(cgsl_siman_solver, "solve", rb_gsl_siman_solver_solve, 7);
   rb_define_singleton_method(mgsl_siman, "solve", rb_gsl_siman_solver_solve, 7);
+
+  Init_gsl_siman_tempering(mgsl_siman);
 }
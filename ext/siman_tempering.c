@@ -0,0 +1,456 @@
+/*
+  siman_tempering.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Parallel tempering (replica exchange): chains of Metropolis moves at
+  a ladder of temperatures, the states of neighbouring chains swapped
+  from time to time so that the cold chains escape their local minima.
+
+    x, e, states, energies, accept, swap =
+      GSL::Siman.tempering("(x[0]**2 - 4)**2 + x[1]**2", [3, 3],
+                           :chains => 8, :t_max => 50, :sweeps => 2000)
+
+  The states are GSL::Vector-s of the dimension of x0, moved in place
+  and copied without any Ruby object: a move adds to each coordinate a
+  uniform variate of [-step_size, step_size]. The energy is
+
+    - a String, an expression in x[0] ... x[n-1] compiled with the
+      parameters :params (see GSL::Function.compile); the chains then
+      run without the GVL, split over GSL.parallel_threads;
+    - a Proc called with the proposed state (a Vector) for its energy;
+    - with :batch => true, a Proc called once per round of moves with
+      the Matrix of the proposals of all the chains (one per row) for
+      the Vector (or Array) of their energies.
+
+  A Proc :step, called as in GSL::Siman::Step with (rng, x, step_size)
+  and moving x in place, replaces the uniform move; the chains then run
+  with the GVL held. The Vectors given to the procs are only valid
+  during the call.
+
+  x0 is the starting state of all the chains, or a Matrix of one per
+  chain. Options:
+    :chains (8), :t_min (1.0), :t_max (100.0)  geometric ladder
+    :temperatures  the ladder itself (ascending), instead
+    :sweeps (1000)    rounds of :iters (10) moves per chain, each
+                      followed by an exchange between neighbours
+    :step_size (1.0)  a Float, or one per chain
+    :mu_t (1.0)       all temperatures divided by mu_t after each
+                      exchange: multi-chain annealing
+    :rng              a GSL::Rng::Pool of chains + 1 streams, the last
+                      one for the exchanges, or else
+    :seed             seeds the streams as GSL::Rng::Pool does
+
+  Each chain draws from its own stream, so that the results do not
+  depend on the threads. Returns the lowest state found and its energy,
+  the Matrix of the final states of the chains (from the coldest) with
+  the Vector of their energies, and the Vectors of the fraction of
+  moves accepted per chain and of swaps accepted per pair of
+  neighbours (nil for a single chain).
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_function.h"
+#include "rb_gsl_rng.h"
+
+typedef struct {
+  size_t n, dim, iters, nthreads;
+  double *x, *y;                /* n x dim states and proposals */
+  double *e, *t, *step, *e1;
+  double *best_x, *best_e;      /* per chain, so that threads do not share */
+  size_t *accepted, *swapped, *tried;
+  gsl_rng **r;                  /* n + 1 streams */
+  size_t nr;                    /* allocated here, 0 if from a Pool */
+  gsl_vector *yv;               /* views of the proposals for the procs */
+  gsl_matrix ym;
+  void *c;                      /* the compiled energy */
+  VALUE func, vstep, views, rngs, vpool;
+} mygsl_tempering;
+
+static void mygsl_tempering_mark(mygsl_tempering *w)
+{
+  rb_gc_mark(w->func);
+  rb_gc_mark(w->vstep);
+  rb_gc_mark(w->views);
+  rb_gc_mark(w->rngs);
+  rb_gc_mark(w->vpool);
+}
+
+static void mygsl_tempering_free(mygsl_tempering *w)
+{
+  size_t i;
+  if (w->r) {
+    for (i = 0; i < w->nr; i++)
+      if (w->r[i]) gsl_rng_free(w->r[i]);
+    if (w->nr) xfree(w->r);
+  }
+  if (w->x) xfree(w->x);
+  if (w->y) xfree(w->y);
+  if (w->e) xfree(w->e);
+  if (w->t) xfree(w->t);
+  if (w->step) xfree(w->step);
+  if (w->e1) xfree(w->e1);
+  if (w->best_x) xfree(w->best_x);
+  if (w->best_e) xfree(w->best_e);
+  if (w->accepted) xfree(w->accepted);
+  if (w->swapped) xfree(w->swapped);
+  if (w->tried) xfree(w->tried);
+  if (w->yv) xfree(w->yv);
+  xfree(w);
+}
+
+/* The energy of the state y of chain i; the GVL is held for procs */
+static double tempering_energy(mygsl_tempering *w, size_t i, const double *y)
+{
+  if (w->c) return rb_gsl_function_compiled_eval_multi(w->c, y);
+  return NUM2DBL(rb_funcall(w->func, RBGSL_ID_call, 1, rb_ary_entry(w->views, i)));
+}
+
+/* Proposes in w->y a move of chain i */
+static void tempering_propose(mygsl_tempering *w, size_t i)
+{
+  double *x = w->x + i*w->dim, *y = w->y + i*w->dim;
+  gsl_rng *r = w->r[i];
+  size_t j;
+  memcpy(y, x, sizeof(double)*w->dim);
+  if (NIL_P(w->vstep)) {
+    for (j = 0; j < w->dim; j++) y[j] += w->step[i]*(2.0*gsl_rng_uniform(r) - 1.0);
+  } else {
+    rb_funcall(w->vstep, RBGSL_ID_call, 3, rb_ary_entry(w->rngs, i),
+	       rb_ary_entry(w->views, i), rb_float_new(w->step[i]));
+  }
+}
+
+/* The Metropolis rule for the proposal of chain i of energy e1;
+   rejects NaN */
+static void tempering_accept(mygsl_tempering *w, size_t i, double e1)
+{
+  double de = e1 - w->e[i];
+  if (de <= 0.0 || gsl_rng_uniform(w->r[i]) < exp(-de/w->t[i])) {
+    memcpy(w->x + i*w->dim, w->y + i*w->dim, sizeof(double)*w->dim);
+    w->e[i] = e1;
+    w->accepted[i]++;
+    if (e1 < w->best_e[i]) {
+      w->best_e[i] = e1;
+      memcpy(w->best_x + i*w->dim, w->y + i*w->dim, sizeof(double)*w->dim);
+    }
+  }
+}
+
+static void tempering_chain(mygsl_tempering *w, size_t i)
+{
+  size_t k;
+  for (k = 0; k < w->iters; k++) {
+    tempering_propose(w, i);
+    tempering_accept(w, i, tempering_energy(w, i, w->y + i*w->dim));
+  }
+}
+
+static int tempering_worker(void *data, size_t id)
+{
+  mygsl_tempering *w = (mygsl_tempering *) data;
+  size_t i;
+  for (i = id; i < w->n; i += w->nthreads) tempering_chain(w, i);
+  return GSL_SUCCESS;
+}
+
+static int tempering_serial(void *data)
+{
+  return tempering_worker(data, 0);
+}
+
+/* The energies in w->e1 of all the proposals, by one call of the
+   batch proc */
+static void tempering_batch_energies(mygsl_tempering *w)
+{
+  VALUE ve;
+  gsl_vector *e = NULL;
+  size_t i;
+  ve = rb_funcall(w->func, RBGSL_ID_call, 1, rb_ary_entry(w->views, w->n));
+  if (TYPE(ve) == T_ARRAY) {
+    if ((size_t) RARRAY_LEN(ve) != w->n)
+      rb_raise(rb_eArgError, "%d energies for %d chains", (int) RARRAY_LEN(ve), (int) w->n);
+    for (i = 0; i < w->n; i++) w->e1[i] = NUM2DBL(rb_ary_entry(ve, i));
+  } else {
+    CHECK_VECTOR(ve);
+    Data_Get_Struct(ve, gsl_vector, e);
+    if (e->size != w->n)
+      rb_raise(rb_eArgError, "%d energies for %d chains", (int) e->size, (int) w->n);
+    for (i = 0; i < w->n; i++) w->e1[i] = gsl_vector_get(e, i);
+  }
+}
+
+/* One round of moves of all the chains, priced together */
+static void tempering_batch(mygsl_tempering *w)
+{
+  size_t i, k;
+  for (k = 0; k < w->iters; k++) {
+    for (i = 0; i < w->n; i++) tempering_propose(w, i);
+    tempering_batch_energies(w);
+    for (i = 0; i < w->n; i++) tempering_accept(w, i, w->e1[i]);
+  }
+}
+
+/* Swaps the even (or odd) pairs of neighbours */
+static void tempering_exchange(mygsl_tempering *w, size_t parity)
+{
+  gsl_rng *r = w->r[w->n];
+  double d, tmp, *a, *b;
+  size_t i, j;
+  for (i = parity; i + 1 < w->n; i += 2) {
+    w->tried[i]++;
+    d = (1.0/w->t[i] - 1.0/w->t[i+1])*(w->e[i] - w->e[i+1]);
+    if (!(d >= 0.0 || gsl_rng_uniform(r) < exp(d))) continue;
+    a = w->x + i*w->dim;
+    b = a + w->dim;
+    for (j = 0; j < w->dim; j++) {
+      tmp = a[j];
+      a[j] = b[j];
+      b[j] = tmp;
+    }
+    tmp = w->e[i];
+    w->e[i] = w->e[i+1];
+    w->e[i+1] = tmp;
+    w->swapped[i]++;
+  }
+}
+
+/* The ladder: :temperatures, or geometric from t_min to t_max */
+static void tempering_ladder(mygsl_tempering *w, VALUE vt, double tmin, double tmax)
+{
+  gsl_vector *t;
+  size_t i, nt;
+  if (!NIL_P(vt)) {
+    t = get_vector(vt);
+    if ((nt = t->size) != w->n) {
+      if (!VECTOR_P(vt)) gsl_vector_free(t);
+      rb_raise(rb_eArgError, "%d temperatures for %d chains", (int) nt, (int) w->n);
+    }
+    for (i = 0; i < w->n; i++) w->t[i] = gsl_vector_get(t, i);
+    if (!VECTOR_P(vt)) gsl_vector_free(t);
+  } else {
+    if (!(tmax >= tmin)) rb_raise(rb_eArgError, "t_max must be at least t_min");
+    for (i = 0; i < w->n; i++)
+      w->t[i] = w->n == 1 ? tmin : tmin*pow(tmax/tmin, (double) i/(w->n - 1));
+  }
+  for (i = 0; i < w->n; i++) {
+    if (!(w->t[i] > 0.0)) rb_raise(rb_eArgError, "temperatures must be positive");
+    if (i > 0 && w->t[i] < w->t[i-1])
+      rb_raise(rb_eArgError, "temperatures must be ascending");
+  }
+}
+
+static void tempering_streams(mygsl_tempering *w, VALUE vpool, VALUE vseed)
+{
+  unsigned long seed = gsl_rng_default_seed;
+  size_t i, nr;
+  if (!NIL_P(vpool)) {
+    nr = rb_gsl_rng_pool_get(vpool, &w->r);
+    if (nr < w->n + 1)
+      rb_raise(rb_eArgError, "a Pool of %d streams for %d chains (%d needed)",
+	       (int) nr, (int) w->n, (int) w->n + 1);
+    w->vpool = vpool;
+    return;
+  }
+  if (!NIL_P(vseed)) seed = NUM2ULONG(vseed);
+  w->r = ALLOC_N(gsl_rng *, w->n + 1);
+  memset(w->r, 0, sizeof(gsl_rng *)*(w->n + 1));
+  w->nr = w->n + 1;
+  for (i = 0; i < w->nr; i++) {
+    w->r[i] = gsl_rng_alloc(gsl_rng_default);
+    gsl_rng_set(w->r[i], rb_gsl_rng_stream_seed(seed, i));
+  }
+}
+
+/* Wraps the proposals, each as a Vector and all as a Matrix, once */
+static void tempering_views(mygsl_tempering *w)
+{
+  size_t i;
+  w->yv = ALLOC_N(gsl_vector, w->n);
+  w->views = rb_ary_new2(w->n + 1);
+  for (i = 0; i < w->n; i++) {
+    w->yv[i].size = w->dim;
+    w->yv[i].stride = 1;
+    w->yv[i].data = w->y + i*w->dim;
+    w->yv[i].block = NULL;
+    w->yv[i].owner = 0;
+    rb_ary_store(w->views, i, Data_Wrap_Struct(cgsl_vector, 0, NULL, &w->yv[i]));
+  }
+  w->ym.size1 = w->n;
+  w->ym.size2 = w->dim;
+  w->ym.tda = w->dim;
+  w->ym.data = w->y;
+  w->ym.block = NULL;
+  w->ym.owner = 0;
+  rb_ary_store(w->views, w->n, Data_Wrap_Struct(cgsl_matrix, 0, NULL, &w->ym));
+  if (!NIL_P(w->vstep)) {
+    w->rngs = rb_ary_new2(w->n);
+    for (i = 0; i < w->n; i++)
+      rb_ary_store(w->rngs, i, Data_Wrap_Struct(cgsl_rng, 0, NULL, w->r[i]));
+  }
+}
+
+static VALUE tempering_results(mygsl_tempering *w, size_t sweeps)
+{
+  gsl_vector *xb, *e, *acc, *sw = NULL;
+  gsl_matrix *x;
+  size_t i, ib = 0;
+  for (i = 1; i < w->n; i++)
+    if (w->best_e[i] < w->best_e[ib] || gsl_isnan(w->best_e[ib])) ib = i;
+  xb = gsl_vector_alloc(w->dim);
+  memcpy(xb->data, w->best_x + ib*w->dim, sizeof(double)*w->dim);
+  x = gsl_matrix_alloc(w->n, w->dim);
+  e = gsl_vector_alloc(w->n);
+  acc = gsl_vector_alloc(w->n);
+  if (w->n > 1) sw = gsl_vector_calloc(w->n - 1);
+  for (i = 0; i < w->n; i++) {
+    memcpy(x->data + i*x->tda, w->x + i*w->dim, sizeof(double)*w->dim);
+    e->data[i] = w->e[i];
+    acc->data[i] = sweeps*w->iters > 0 ? (double) w->accepted[i]/(sweeps*w->iters) : 0.0;
+    if (i + 1 < w->n && w->tried[i] > 0)
+      sw->data[i] = (double) w->swapped[i]/w->tried[i];
+  }
+  return rb_ary_new3(6, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, xb),
+		     rb_float_new(w->best_e[ib]),
+		     Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, x),
+		     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, e),
+		     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, acc),
+		     sw ? Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, sw) : Qnil);
+}
+
+/* GSL::Siman.tempering(energy, x0[, opts]) */
+static VALUE rb_gsl_siman_tempering(int argc, VALUE *argv, VALUE module)
+{
+  mygsl_tempering *w = NULL;
+  gsl_vector *x0 = NULL, *vs;
+  gsl_matrix *m0 = NULL;
+  VALUE obj, opts, v, vt = Qnil, vparams = Qnil, vpool = Qnil, vseed = Qnil;
+  VALUE vstepsize = Qnil;
+  size_t i, j, k, ns, sweeps = 1000;
+  double tmin = 1.0, tmax = 100.0, mu_t = 1.0;
+  int batch = 0, native;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  obj = Data_Make_Struct(0, mygsl_tempering, mygsl_tempering_mark, mygsl_tempering_free, w);
+  w->func = argv[0];
+  w->vstep = Qnil;
+  w->views = Qnil;
+  w->rngs = Qnil;
+  w->vpool = Qnil;
+  w->n = 8;
+  w->iters = 10;
+  if (MATRIX_P(argv[1])) {
+    Data_Get_Struct(argv[1], gsl_matrix, m0);
+    w->n = m0->size1;
+    w->dim = m0->size2;
+  } else {
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Struct(argv[1], gsl_vector, x0);
+    w->dim = x0->size;
+  }
+  if (argc == 3) {
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("chains"))))) {
+      if (m0 && NUM2SIZET(v) != w->n)
+	rb_raise(rb_eArgError, "%d chains for %d starting states", (int) NUM2SIZET(v), (int) w->n);
+      w->n = NUM2SIZET(v);
+    }
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("sweeps"))))) sweeps = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("iters"))))) w->iters = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("t_min"))))) tmin = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("t_max"))))) tmax = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("mu_t"))))) mu_t = NUM2DBL(v);
+    batch = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("batch"))));
+    vt = rb_hash_aref(opts, ID2SYM(rb_intern("temperatures")));
+    vstepsize = rb_hash_aref(opts, ID2SYM(rb_intern("step_size")));
+    vparams = rb_hash_aref(opts, ID2SYM(rb_intern("params")));
+    vpool = rb_hash_aref(opts, ID2SYM(rb_intern("rng")));
+    vseed = rb_hash_aref(opts, ID2SYM(rb_intern("seed")));
+    w->vstep = rb_hash_aref(opts, ID2SYM(rb_intern("step")));
+  }
+  if (w->n == 0) rb_raise(rb_eArgError, "no chains");
+  if (w->dim == 0) rb_raise(rb_eArgError, "states of no dimension");
+  if (!(mu_t > 0.0)) rb_raise(rb_eArgError, "mu_t must be positive");
+  if (!NIL_P(w->vstep) && !rb_obj_is_kind_of(w->vstep, rb_cProc))
+    rb_raise(rb_eTypeError, "wrong argument type %s (Proc expected)",
+	     rb_class2name(CLASS_OF(w->vstep)));
+  if (TYPE(w->func) == T_STRING) {
+    if (batch) rb_raise(rb_eArgError, "batch is for Proc energies");
+    w->func = rb_gsl_function_compile_multi(w->func, vparams, w->dim);
+    w->c = rb_gsl_function_compiled_ptr(w->func);
+  } else if (rb_obj_is_kind_of(w->func, rb_cProc)) {
+    if (!NIL_P(vparams)) rb_raise(rb_eArgError, "params are for compiled energies");
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (String or Proc expected)",
+	     rb_class2name(CLASS_OF(w->func)));
+  }
+  w->x = ALLOC_N(double, w->n*w->dim);
+  w->y = ALLOC_N(double, w->n*w->dim);
+  w->best_x = ALLOC_N(double, w->n*w->dim);
+  w->e = ALLOC_N(double, w->n);
+  w->e1 = ALLOC_N(double, w->n);
+  w->t = ALLOC_N(double, w->n);
+  w->step = ALLOC_N(double, w->n);
+  w->best_e = ALLOC_N(double, w->n);
+  w->accepted = ALLOC_N(size_t, w->n);
+  w->swapped = ALLOC_N(size_t, w->n);
+  w->tried = ALLOC_N(size_t, w->n);
+  memset(w->accepted, 0, sizeof(size_t)*w->n);
+  memset(w->swapped, 0, sizeof(size_t)*w->n);
+  memset(w->tried, 0, sizeof(size_t)*w->n);
+  tempering_ladder(w, vt, tmin, tmax);
+  if (NIL_P(vstepsize) || rb_obj_is_kind_of(vstepsize, rb_cNumeric)) {
+    for (i = 0; i < w->n; i++) w->step[i] = NIL_P(vstepsize) ? 1.0 : NUM2DBL(vstepsize);
+  } else {
+    vs = get_vector(vstepsize);
+    if ((ns = vs->size) != w->n) {
+      if (!VECTOR_P(vstepsize)) gsl_vector_free(vs);
+      rb_raise(rb_eArgError, "%d step sizes for %d chains", (int) ns, (int) w->n);
+    }
+    for (i = 0; i < w->n; i++) w->step[i] = gsl_vector_get(vs, i);
+    if (!VECTOR_P(vstepsize)) gsl_vector_free(vs);
+  }
+  for (i = 0; i < w->n; i++)
+    for (j = 0; j < w->dim; j++)
+      w->x[i*w->dim + j] = m0 ? gsl_matrix_get(m0, i, j) : gsl_vector_get(x0, j);
+  tempering_streams(w, vpool, vseed);
+  native = w->c != NULL && NIL_P(w->vstep);
+  if (!native) tempering_views(w);
+  /* the starting energies */
+  memcpy(w->y, w->x, sizeof(double)*w->n*w->dim);
+  if (batch) {
+    tempering_batch_energies(w);
+    memcpy(w->e, w->e1, sizeof(double)*w->n);
+  } else {
+    for (i = 0; i < w->n; i++) w->e[i] = tempering_energy(w, i, w->y + i*w->dim);
+  }
+  memcpy(w->best_x, w->x, sizeof(double)*w->n*w->dim);
+  memcpy(w->best_e, w->e, sizeof(double)*w->n);
+  w->nthreads = native ? rb_gsl_parallel_nthreads(sweeps*w->iters*w->n*w->dim, w->n) : 1;
+  for (k = 0; k < sweeps; k++) {
+    if (batch) tempering_batch(w);
+    else if (w->nthreads > 1) rb_gsl_nogvl_parallel(tempering_worker, w, w->nthreads);
+    else if (native) rb_gsl_nogvl_call(tempering_serial, w, w->iters*w->n*w->dim);
+    else tempering_serial(w);
+    tempering_exchange(w, k % 2);
+    if (mu_t != 1.0)
+      for (i = 0; i < w->n; i++) w->t[i] /= mu_t;
+  }
+  v = tempering_results(w, sweeps);
+  RB_GC_GUARD(obj);
+  return v;
+}
+
+void Init_gsl_siman_tempering(VALUE mgsl_siman)
+{
+  rb_define_module_function(mgsl_siman, "tempering", rb_gsl_siman_tempering, -1);
+}
@@ -0,0 +1,103 @@
+/*
+  small.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Vec2, Vec3, Vec4 and GSL::Mat2, Mat3, Mat4: fixed-size vectors
+  and matrices of doubles for geometry and per-particle work, where a
+  GSL::Vector.alloc(3) costs a gsl_vector, a gsl_block and their data,
+  and every operation goes through a stride loop or a BLAS call.  The
+  elements are stored in the Ruby object itself (in the object slot
+  where Ruby embeds typed data, else in one allocation), and the kernels
+  are compiled once for each size from small_source.c.
+
+    a = GSL::Vec3[1, 0, 0]
+    b = GSL::Vec3[0, 1, 0]
+    a.cross(b)             # GSL::Vec3[0, 0, 1]
+    r = GSL::Mat3.identity*2
+    r.inverse*a            # GSL::Vec3[0.5, 0, 0]
+
+  The operators return new objects; [] and []= index the elements, to_v
+  and to_m convert to GSL::Vector and GSL::Matrix, and new accepts
+  those.  A frozen object can be shared between Ractors.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include <math.h>
+
+/* geometry.c */
+void vector3_rotateX(const double x[3], double theta, double xout[3]);
+void vector3_rotateY(const double x[3], double theta, double xout[3]);
+void vector3_rotateZ(const double x[3], double theta, double xout[3]);
+void vector3_rotate(const double x[3], double theta, double phi, double xout[3]);
+
+#ifdef HAVE_CONST_RUBY_TYPED_EMBEDDABLE
+#define SMALL_TYPED_EMBED RUBY_TYPED_EMBEDDABLE
+#else
+#define SMALL_TYPED_EMBED 0
+#endif
+#ifdef RUBY_TYPED_FROZEN_SHAREABLE
+#define SMALL_TYPED_FLAGS (RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE | SMALL_TYPED_EMBED)
+#else
+#define SMALL_TYPED_FLAGS (RUBY_TYPED_FREE_IMMEDIATELY | SMALL_TYPED_EMBED)
+#endif
+
+/* indexed by the size */
+static VALUE cgsl_small_vec[5], cgsl_small_mat[5];
+
+#define BASE_DOUBLE
+#include "templates_on.h"
+
+#define SMALL_N 2
+#define SMALL_VEC vec2
+#define SMALL_MAT mat2
+#define SMALL_VEC_CLASS "Vec2"
+#define SMALL_MAT_CLASS "Mat2"
+#include "small_source.c"
+#undef SMALL_N
+#undef SMALL_VEC
+#undef SMALL_MAT
+#undef SMALL_VEC_CLASS
+#undef SMALL_MAT_CLASS
+
+#define SMALL_N 3
+#define SMALL_VEC vec3
+#define SMALL_MAT mat3
+#define SMALL_VEC_CLASS "Vec3"
+#define SMALL_MAT_CLASS "Mat3"
+#include "small_source.c"
+#undef SMALL_N
+#undef SMALL_VEC
+#undef SMALL_MAT
+#undef SMALL_VEC_CLASS
+#undef SMALL_MAT_CLASS
+
+#define SMALL_N 4
+#define SMALL_VEC vec4
+#define SMALL_MAT mat4
+#define SMALL_VEC_CLASS "Vec4"
+#define SMALL_MAT_CLASS "Mat4"
+#include "small_source.c"
+#undef SMALL_N
+#undef SMALL_VEC
+#undef SMALL_MAT
+#undef SMALL_VEC_CLASS
+#undef SMALL_MAT_CLASS
+
+void Init_gsl_small(VALUE module)
+{
+  rb_gsl_vec2_define(module);
+  rb_gsl_vec3_define(module);
+  rb_gsl_vec4_define(module);
+}
+
+#include "templates_off.h"
+#undef BASE_DOUBLE
@@ -0,0 +1,715 @@
+/*
+  small_source.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The VecN and MatN classes for one size SMALL_N, included by small.c
+  once for each of 2, 3 and 4.  The loops run over the constant SMALL_N
+  and are unrolled by the compiler; det and inverse are written out for
+  each size.
+*/
+
+#define VEC(name) CONCAT2(CONCAT2(mygsl, SMALL_VEC), name)
+#define MAT(name) CONCAT2(CONCAT2(mygsl, SMALL_MAT), name)
+#define RB_VEC(name) CONCAT2(CONCAT2(rb_gsl, SMALL_VEC), name)
+#define RB_MAT(name) CONCAT2(CONCAT2(rb_gsl, SMALL_MAT), name)
+#define NN (SMALL_N*SMALL_N)
+
+typedef struct {
+  ATOMIC x[SMALL_N];
+} VEC(t);
+
+/* row major */
+typedef struct {
+  ATOMIC a[NN];
+} MAT(t);
+
+static const rb_data_type_t VEC(data_type) = {
+  "GSL::" SMALL_VEC_CLASS,
+  { 0, RUBY_TYPED_DEFAULT_FREE, 0, },
+  0, 0, SMALL_TYPED_FLAGS
+};
+
+static const rb_data_type_t MAT(data_type) = {
+  "GSL::" SMALL_MAT_CLASS,
+  { 0, RUBY_TYPED_DEFAULT_FREE, 0, },
+  0, 0, SMALL_TYPED_FLAGS
+};
+
+static VEC(t)* VEC(get)(VALUE obj)
+{
+  return (VEC(t) *) rb_check_typeddata(obj, &VEC(data_type));
+}
+
+static MAT(t)* MAT(get)(VALUE obj)
+{
+  return (MAT(t) *) rb_check_typeddata(obj, &MAT(data_type));
+}
+
+static VALUE RB_VEC(alloc)(VALUE klass)
+{
+  VEC(t) *p;
+  return TypedData_Make_Struct(klass, VEC(t), &VEC(data_type), p);
+}
+
+static VALUE RB_MAT(alloc)(VALUE klass)
+{
+  MAT(t) *p;
+  return TypedData_Make_Struct(klass, MAT(t), &MAT(data_type), p);
+}
+
+/* A new zero vector (matrix); *p receives its data */
+static VALUE VEC(new)(VEC(t) **p)
+{
+  return TypedData_Make_Struct(cgsl_small_vec[SMALL_N], VEC(t), &VEC(data_type), *p);
+}
+
+static VALUE MAT(new)(MAT(t) **p)
+{
+  return TypedData_Make_Struct(cgsl_small_mat[SMALL_N], MAT(t), &MAT(data_type), *p);
+}
+
+/*****/
+
+static ATOMIC VEC(dot)(const ATOMIC *a, const ATOMIC *b)
+{
+  ATOMIC s = 0;
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) s += a[i]*b[i];
+  return s;
+}
+
+/* c = a b; c may be neither a nor b */
+static void MAT(mul)(const ATOMIC *a, const ATOMIC *b, ATOMIC *c)
+{
+  size_t i, j, k;
+  for (i = 0; i < SMALL_N; i++) {
+    for (j = 0; j < SMALL_N; j++) {
+      ATOMIC s = 0;
+      for (k = 0; k < SMALL_N; k++) s += a[i*SMALL_N + k]*b[k*SMALL_N + j];
+      c[i*SMALL_N + j] = s;
+    }
+  }
+}
+
+static void MAT(mul_vec)(const ATOMIC *a, const ATOMIC *x, ATOMIC *y)
+{
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) y[i] = VEC(dot)(a + i*SMALL_N, x);
+}
+
+#if SMALL_N == 2
+static ATOMIC MAT(det)(const ATOMIC *a)
+{
+  return a[0]*a[3] - a[1]*a[2];
+}
+
+static int MAT(inverse)(const ATOMIC *a, ATOMIC *b)
+{
+  ATOMIC d = MAT(det)(a);
+  if (d == 0) GSL_ERROR("matrix is singular", GSL_ESING);
+  d = 1/d;
+  b[0] = a[3]*d;
+  b[1] = -a[1]*d;
+  b[2] = -a[2]*d;
+  b[3] = a[0]*d;
+  return GSL_SUCCESS;
+}
+#elif SMALL_N == 3
+static ATOMIC MAT(det)(const ATOMIC *a)
+{
+  return a[0]*(a[4]*a[8] - a[5]*a[7]) - a[1]*(a[3]*a[8] - a[5]*a[6])
+    + a[2]*(a[3]*a[7] - a[4]*a[6]);
+}
+
+/* the transposed cofactors over the determinant */
+static int MAT(inverse)(const ATOMIC *a, ATOMIC *b)
+{
+  ATOMIC c0 = a[4]*a[8] - a[5]*a[7];
+  ATOMIC c1 = a[5]*a[6] - a[3]*a[8];
+  ATOMIC c2 = a[3]*a[7] - a[4]*a[6];
+  ATOMIC d = a[0]*c0 + a[1]*c1 + a[2]*c2;
+  if (d == 0) GSL_ERROR("matrix is singular", GSL_ESING);
+  d = 1/d;
+  b[0] = c0*d;
+  b[1] = (a[2]*a[7] - a[1]*a[8])*d;
+  b[2] = (a[1]*a[5] - a[2]*a[4])*d;
+  b[3] = c1*d;
+  b[4] = (a[0]*a[8] - a[2]*a[6])*d;
+  b[5] = (a[2]*a[3] - a[0]*a[5])*d;
+  b[6] = c2*d;
+  b[7] = (a[1]*a[6] - a[0]*a[7])*d;
+  b[8] = (a[0]*a[4] - a[1]*a[3])*d;
+  return GSL_SUCCESS;
+}
+#else
+/* The 2x2 minors of the two upper rows (s) and of the two lower rows
+   (c), from which both the determinant and the inverse are built */
+static ATOMIC MAT(minors)(const ATOMIC *a, ATOMIC *s, ATOMIC *c)
+{
+  s[0] = a[0]*a[5] - a[4]*a[1];
+  s[1] = a[0]*a[6] - a[4]*a[2];
+  s[2] = a[0]*a[7] - a[4]*a[3];
+  s[3] = a[1]*a[6] - a[5]*a[2];
+  s[4] = a[1]*a[7] - a[5]*a[3];
+  s[5] = a[2]*a[7] - a[6]*a[3];
+  c[0] = a[8]*a[13] - a[12]*a[9];
+  c[1] = a[8]*a[14] - a[12]*a[10];
+  c[2] = a[8]*a[15] - a[12]*a[11];
+  c[3] = a[9]*a[14] - a[13]*a[10];
+  c[4] = a[9]*a[15] - a[13]*a[11];
+  c[5] = a[10]*a[15] - a[14]*a[11];
+  return s[0]*c[5] - s[1]*c[4] + s[2]*c[3] + s[3]*c[2] - s[4]*c[1] + s[5]*c[0];
+}
+
+static ATOMIC MAT(det)(const ATOMIC *a)
+{
+  ATOMIC s[6], c[6];
+  return MAT(minors)(a, s, c);
+}
+
+static int MAT(inverse)(const ATOMIC *a, ATOMIC *b)
+{
+  ATOMIC s[6], c[6], d;
+  d = MAT(minors)(a, s, c);
+  if (d == 0) GSL_ERROR("matrix is singular", GSL_ESING);
+  d = 1/d;
+  b[0] = (a[5]*c[5] - a[6]*c[4] + a[7]*c[3])*d;
+  b[1] = (-a[1]*c[5] + a[2]*c[4] - a[3]*c[3])*d;
+  b[2] = (a[13]*s[5] - a[14]*s[4] + a[15]*s[3])*d;
+  b[3] = (-a[9]*s[5] + a[10]*s[4] - a[11]*s[3])*d;
+  b[4] = (-a[4]*c[5] + a[6]*c[2] - a[7]*c[1])*d;
+  b[5] = (a[0]*c[5] - a[2]*c[2] + a[3]*c[1])*d;
+  b[6] = (-a[12]*s[5] + a[14]*s[2] - a[15]*s[1])*d;
+  b[7] = (a[8]*s[5] - a[10]*s[2] + a[11]*s[1])*d;
+  b[8] = (a[4]*c[4] - a[5]*c[2] + a[7]*c[0])*d;
+  b[9] = (-a[0]*c[4] + a[1]*c[2] - a[3]*c[0])*d;
+  b[10] = (a[12]*s[4] - a[13]*s[2] + a[15]*s[0])*d;
+  b[11] = (-a[8]*s[4] + a[9]*s[2] - a[11]*s[0])*d;
+  b[12] = (-a[4]*c[3] + a[5]*c[1] - a[6]*c[0])*d;
+  b[13] = (a[0]*c[3] - a[1]*c[1] + a[2]*c[0])*d;
+  b[14] = (-a[12]*s[3] + a[13]*s[1] - a[14]*s[0])*d;
+  b[15] = (a[8]*s[3] - a[9]*s[1] + a[10]*s[0])*d;
+  return GSL_SUCCESS;
+}
+#endif
+
+/***** VecN *****/
+
+/* VecN.new(x0, ..., xN-1), VecN.new(Array), VecN.new(GSL::Vector); zero
+   without arguments */
+static VALUE RB_VEC(initialize)(int argc, VALUE *argv, VALUE obj)
+{
+  VEC(t) *p = VEC(get)(obj);
+  gsl_vector *v;
+  size_t i;
+  rb_check_frozen(obj);
+  if (argc == 1 && TYPE(argv[0]) == T_ARRAY) {
+    if (RARRAY_LEN(argv[0]) != SMALL_N)
+      rb_raise(rb_eArgError, "%d elements expected (%ld given)", SMALL_N, RARRAY_LEN(argv[0]));
+    for (i = 0; i < SMALL_N; i++) p->x[i] = NUM2DBL(rb_ary_entry(argv[0], i));
+  } else if (argc == 1 && VECTOR_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_vector, v);
+    if (v->size != SMALL_N)
+      rb_raise(rb_eArgError, "Vector of size %d expected (%d given)", SMALL_N, (int) v->size);
+    for (i = 0; i < SMALL_N; i++) p->x[i] = v->data[i*v->stride];
+  } else if (argc == SMALL_N) {
+    for (i = 0; i < SMALL_N; i++) p->x[i] = NUM2DBL(argv[i]);
+  } else if (argc != 0) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0, 1 or %d)", argc, SMALL_N);
+  }
+  return obj;
+}
+
+static VALUE RB_VEC(dup)(VALUE obj)
+{
+  VEC(t) *p;
+  VALUE vnew = VEC(new)(&p);
+  *p = *VEC(get)(obj);
+  return vnew;
+}
+
+static size_t VEC(index)(VALUE ii)
+{
+  long i = NUM2LONG(ii);
+  if (i < 0) i += SMALL_N;
+  if (i < 0 || i >= SMALL_N) rb_raise(rb_eIndexError, "index %ld out of range", NUM2LONG(ii));
+  return (size_t) i;
+}
+
+static VALUE RB_VEC(get)(VALUE obj, VALUE ii)
+{
+  return rb_float_new(VEC(get)(obj)->x[VEC(index)(ii)]);
+}
+
+static VALUE RB_VEC(set)(VALUE obj, VALUE ii, VALUE x)
+{
+  rb_check_frozen(obj);
+  VEC(get)(obj)->x[VEC(index)(ii)] = NUM2DBL(x);
+  return x;
+}
+
+static VALUE RB_VEC(size)(VALUE obj)
+{
+  return INT2FIX(SMALL_N);
+}
+
+static VALUE RB_VEC(to_a)(VALUE obj)
+{
+  VEC(t) *p = VEC(get)(obj);
+  VALUE ary = rb_ary_new2(SMALL_N);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) rb_ary_store(ary, i, rb_float_new(p->x[i]));
+  return ary;
+}
+
+static VALUE RB_VEC(to_v)(VALUE obj)
+{
+  VEC(t) *p = VEC(get)(obj);
+  gsl_vector *v = gsl_vector_alloc(SMALL_N);
+  memcpy(v->data, p->x, sizeof(p->x));
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE RB_VEC(inspect)(VALUE obj)
+{
+  VEC(t) *p = VEC(get)(obj);
+  VALUE str = rb_str_new_cstr(rb_obj_classname(obj));
+  size_t i;
+  for (i = 0; i < SMALL_N; i++)
+    rb_str_catf(str, "%s%g", i == 0 ? "[" : ", ", p->x[i]);
+  return rb_str_cat_cstr(str, "]");
+}
+
+static VALUE RB_VEC(equal)(VALUE obj, VALUE other)
+{
+  if (!rb_typeddata_is_kind_of(other, &VEC(data_type))) return Qfalse;
+  return memcmp(VEC(get)(obj)->x, VEC(get)(other)->x, sizeof(VEC(t))) == 0 ? Qtrue : Qfalse;
+}
+
+static VALUE RB_VEC(add)(VALUE obj, VALUE other)
+{
+  VEC(t) *a = VEC(get)(obj), *b = VEC(get)(other), *c;
+  VALUE vnew = VEC(new)(&c);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) c->x[i] = a->x[i] + b->x[i];
+  return vnew;
+}
+
+static VALUE RB_VEC(sub)(VALUE obj, VALUE other)
+{
+  VEC(t) *a = VEC(get)(obj), *b = VEC(get)(other), *c;
+  VALUE vnew = VEC(new)(&c);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) c->x[i] = a->x[i] - b->x[i];
+  return vnew;
+}
+
+static VALUE RB_VEC(uminus)(VALUE obj)
+{
+  VEC(t) *a = VEC(get)(obj), *c;
+  VALUE vnew = VEC(new)(&c);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) c->x[i] = -a->x[i];
+  return vnew;
+}
+
+static VALUE RB_VEC(scale)(VALUE obj, ATOMIC s)
+{
+  VEC(t) *a = VEC(get)(obj), *c;
+  VALUE vnew = VEC(new)(&c);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) c->x[i] = a->x[i]*s;
+  return vnew;
+}
+
+static VALUE RB_VEC(mul)(VALUE obj, VALUE s)
+{
+  return RB_VEC(scale)(obj, NUM2DBL(s));
+}
+
+static VALUE RB_VEC(div)(VALUE obj, VALUE s)
+{
+  return RB_VEC(scale)(obj, 1/NUM2DBL(s));
+}
+
+/* 2*v */
+static VALUE RB_VEC(coerce)(VALUE obj, VALUE other)
+{
+  return rb_assoc_new(obj, other);
+}
+
+static VALUE RB_VEC(dot2)(VALUE obj, VALUE other)
+{
+  return rb_float_new(VEC(dot)(VEC(get)(obj)->x, VEC(get)(other)->x));
+}
+
+static VALUE RB_VEC(norm)(VALUE obj)
+{
+  VEC(t) *a = VEC(get)(obj);
+  return rb_float_new(sqrt(VEC(dot)(a->x, a->x)));
+}
+
+static VALUE RB_VEC(norm2)(VALUE obj)
+{
+  VEC(t) *a = VEC(get)(obj);
+  return rb_float_new(VEC(dot)(a->x, a->x));
+}
+
+static VALUE RB_VEC(normalize)(VALUE obj)
+{
+  VEC(t) *a = VEC(get)(obj);
+  return RB_VEC(scale)(obj, 1/sqrt(VEC(dot)(a->x, a->x)));
+}
+
+#if SMALL_N == 2
+/* the z component of the cross product of (a, 0) and (b, 0) */
+static VALUE RB_VEC(cross)(VALUE obj, VALUE other)
+{
+  VEC(t) *a = VEC(get)(obj), *b = VEC(get)(other);
+  return rb_float_new(a->x[0]*b->x[1] - a->x[1]*b->x[0]);
+}
+#elif SMALL_N == 3
+static VALUE RB_VEC(cross)(VALUE obj, VALUE other)
+{
+  VEC(t) *a = VEC(get)(obj), *b = VEC(get)(other), *c;
+  VALUE vnew = VEC(new)(&c);
+  c->x[0] = a->x[1]*b->x[2] - a->x[2]*b->x[1];
+  c->x[1] = a->x[2]*b->x[0] - a->x[0]*b->x[2];
+  c->x[2] = a->x[0]*b->x[1] - a->x[1]*b->x[0];
+  return vnew;
+}
+
+/* The rotations of geometry.c, returning a new Vec3 */
+static VALUE RB_VEC(rotate_axis)(VALUE obj, VALUE angle,
+				 void (*f)(const double *, double, double *))
+{
+  VEC(t) *c;
+  VALUE vnew = VEC(new)(&c);
+  (*f)(VEC(get)(obj)->x, NUM2DBL(angle), c->x);
+  return vnew;
+}
+
+static VALUE RB_VEC(rotateX)(VALUE obj, VALUE angle)
+{
+  return RB_VEC(rotate_axis)(obj, angle, vector3_rotateX);
+}
+
+static VALUE RB_VEC(rotateY)(VALUE obj, VALUE angle)
+{
+  return RB_VEC(rotate_axis)(obj, angle, vector3_rotateY);
+}
+
+static VALUE RB_VEC(rotateZ)(VALUE obj, VALUE angle)
+{
+  return RB_VEC(rotate_axis)(obj, angle, vector3_rotateZ);
+}
+
+static VALUE RB_VEC(rotate)(VALUE obj, VALUE theta, VALUE phi)
+{
+  VEC(t) *c;
+  VALUE vnew = VEC(new)(&c);
+  vector3_rotate(VEC(get)(obj)->x, NUM2DBL(theta), NUM2DBL(phi), c->x);
+  return vnew;
+}
+#endif
+
+/***** MatN *****/
+
+/* MatN.new(a00, a01, ...), MatN.new([[a00, a01, ...], ...]) or a flat
+   Array, MatN.new(GSL::Matrix); zero without arguments */
+static VALUE RB_MAT(initialize)(int argc, VALUE *argv, VALUE obj)
+{
+  MAT(t) *p = MAT(get)(obj);
+  gsl_matrix *m;
+  VALUE row;
+  size_t i, j;
+  rb_check_frozen(obj);
+  if (argc == 1 && TYPE(argv[0]) == T_ARRAY) {
+    if (RARRAY_LEN(argv[0]) == NN) {
+      for (i = 0; i < NN; i++) p->a[i] = NUM2DBL(rb_ary_entry(argv[0], i));
+    } else if (RARRAY_LEN(argv[0]) == SMALL_N) {
+      for (i = 0; i < SMALL_N; i++) {
+	row = rb_ary_entry(argv[0], i);
+	Check_Type(row, T_ARRAY);
+	if (RARRAY_LEN(row) != SMALL_N)
+	  rb_raise(rb_eArgError, "rows of %d elements expected", SMALL_N);
+	for (j = 0; j < SMALL_N; j++) p->a[i*SMALL_N + j] = NUM2DBL(rb_ary_entry(row, j));
+      }
+    } else {
+      rb_raise(rb_eArgError, "%d rows or %d elements expected", SMALL_N, NN);
+    }
+  } else if (argc == 1 && MATRIX_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_matrix, m);
+    if (m->size1 != SMALL_N || m->size2 != SMALL_N)
+      rb_raise(rb_eArgError, "%dx%d Matrix expected", SMALL_N, SMALL_N);
+    for (i = 0; i < SMALL_N; i++)
+      for (j = 0; j < SMALL_N; j++) p->a[i*SMALL_N + j] = m->data[i*m->tda + j];
+  } else if (argc == NN) {
+    for (i = 0; i < NN; i++) p->a[i] = NUM2DBL(argv[i]);
+  } else if (argc != 0) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0, 1 or %d)", argc, NN);
+  }
+  return obj;
+}
+
+static VALUE RB_MAT(identity)(VALUE klass)
+{
+  MAT(t) *p;
+  VALUE vnew = MAT(new)(&p);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) p->a[i*(SMALL_N + 1)] = 1;
+  return vnew;
+}
+
+static VALUE RB_MAT(dup)(VALUE obj)
+{
+  MAT(t) *p;
+  VALUE vnew = MAT(new)(&p);
+  *p = *MAT(get)(obj);
+  return vnew;
+}
+
+static size_t MAT(index)(VALUE ii, VALUE jj)
+{
+  long i = NUM2LONG(ii), j = NUM2LONG(jj);
+  if (i < 0) i += SMALL_N;
+  if (j < 0) j += SMALL_N;
+  if (i < 0 || i >= SMALL_N || j < 0 || j >= SMALL_N)
+    rb_raise(rb_eIndexError, "index (%ld, %ld) out of range", NUM2LONG(ii), NUM2LONG(jj));
+  return (size_t) (i*SMALL_N + j);
+}
+
+static VALUE RB_MAT(get)(VALUE obj, VALUE ii, VALUE jj)
+{
+  return rb_float_new(MAT(get)(obj)->a[MAT(index)(ii, jj)]);
+}
+
+static VALUE RB_MAT(set)(VALUE obj, VALUE ii, VALUE jj, VALUE x)
+{
+  rb_check_frozen(obj);
+  MAT(get)(obj)->a[MAT(index)(ii, jj)] = NUM2DBL(x);
+  return x;
+}
+
+static VALUE RB_MAT(size)(VALUE obj)
+{
+  return rb_assoc_new(INT2FIX(SMALL_N), INT2FIX(SMALL_N));
+}
+
+static VALUE RB_MAT(to_a)(VALUE obj)
+{
+  MAT(t) *p = MAT(get)(obj);
+  VALUE ary = rb_ary_new2(SMALL_N), row;
+  size_t i, j;
+  for (i = 0; i < SMALL_N; i++) {
+    row = rb_ary_new2(SMALL_N);
+    for (j = 0; j < SMALL_N; j++) rb_ary_store(row, j, rb_float_new(p->a[i*SMALL_N + j]));
+    rb_ary_store(ary, i, row);
+  }
+  return ary;
+}
+
+static VALUE RB_MAT(to_m)(VALUE obj)
+{
+  MAT(t) *p = MAT(get)(obj);
+  gsl_matrix *m = gsl_matrix_alloc(SMALL_N, SMALL_N);
+  size_t i;
+  for (i = 0; i < SMALL_N; i++)
+    memcpy(m->data + i*m->tda, p->a + i*SMALL_N, SMALL_N*sizeof(ATOMIC));
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static VALUE RB_MAT(inspect)(VALUE obj)
+{
+  MAT(t) *p = MAT(get)(obj);
+  VALUE str = rb_str_new_cstr(rb_obj_classname(obj));
+  size_t i, j;
+  for (i = 0; i < SMALL_N; i++) {
+    rb_str_cat_cstr(str, i == 0 ? "[[" : ", [");
+    for (j = 0; j < SMALL_N; j++)
+      rb_str_catf(str, "%s%g", j == 0 ? "" : ", ", p->a[i*SMALL_N + j]);
+    rb_str_cat_cstr(str, "]");
+  }
+  return rb_str_cat_cstr(str, "]");
+}
+
+static VALUE RB_MAT(equal)(VALUE obj, VALUE other)
+{
+  if (!rb_typeddata_is_kind_of(other, &MAT(data_type))) return Qfalse;
+  return memcmp(MAT(get)(obj)->a, MAT(get)(other)->a, sizeof(MAT(t))) == 0 ? Qtrue : Qfalse;
+}
+
+static VALUE RB_MAT(add)(VALUE obj, VALUE other)
+{
+  MAT(t) *a = MAT(get)(obj), *b = MAT(get)(other), *c;
+  VALUE vnew = MAT(new)(&c);
+  size_t i;
+  for (i = 0; i < NN; i++) c->a[i] = a->a[i] + b->a[i];
+  return vnew;
+}
+
+static VALUE RB_MAT(sub)(VALUE obj, VALUE other)
+{
+  MAT(t) *a = MAT(get)(obj), *b = MAT(get)(other), *c;
+  VALUE vnew = MAT(new)(&c);
+  size_t i;
+  for (i = 0; i < NN; i++) c->a[i] = a->a[i] - b->a[i];
+  return vnew;
+}
+
+static VALUE RB_MAT(uminus)(VALUE obj)
+{
+  MAT(t) *a = MAT(get)(obj), *c;
+  VALUE vnew = MAT(new)(&c);
+  size_t i;
+  for (i = 0; i < NN; i++) c->a[i] = -a->a[i];
+  return vnew;
+}
+
+/* MatN*MatN, MatN*VecN, MatN*Numeric */
+static VALUE RB_MAT(mul2)(VALUE obj, VALUE other)
+{
+  MAT(t) *a = MAT(get)(obj), *c;
+  VEC(t) *y;
+  VALUE vnew;
+  size_t i;
+  if (rb_typeddata_is_kind_of(other, &MAT(data_type))) {
+    vnew = MAT(new)(&c);
+    MAT(mul)(a->a, MAT(get)(other)->a, c->a);
+  } else if (rb_typeddata_is_kind_of(other, &VEC(data_type))) {
+    vnew = VEC(new)(&y);
+    MAT(mul_vec)(a->a, VEC(get)(other)->x, y->x);
+  } else {
+    ATOMIC s = NUM2DBL(other);
+    vnew = MAT(new)(&c);
+    for (i = 0; i < NN; i++) c->a[i] = a->a[i]*s;
+  }
+  return vnew;
+}
+
+static VALUE RB_MAT(coerce)(VALUE obj, VALUE other)
+{
+  return rb_assoc_new(obj, other);
+}
+
+static VALUE RB_MAT(transpose)(VALUE obj)
+{
+  MAT(t) *a = MAT(get)(obj), *c;
+  VALUE vnew = MAT(new)(&c);
+  size_t i, j;
+  for (i = 0; i < SMALL_N; i++)
+    for (j = 0; j < SMALL_N; j++) c->a[j*SMALL_N + i] = a->a[i*SMALL_N + j];
+  return vnew;
+}
+
+static VALUE RB_MAT(trace)(VALUE obj)
+{
+  MAT(t) *a = MAT(get)(obj);
+  ATOMIC s = 0;
+  size_t i;
+  for (i = 0; i < SMALL_N; i++) s += a->a[i*(SMALL_N + 1)];
+  return rb_float_new(s);
+}
+
+static VALUE RB_MAT(det2)(VALUE obj)
+{
+  return rb_float_new(MAT(det)(MAT(get)(obj)->a));
+}
+
+static VALUE RB_MAT(inverse2)(VALUE obj)
+{
+  MAT(t) *c;
+  VALUE vnew = MAT(new)(&c);
+  MAT(inverse)(MAT(get)(obj)->a, c->a);
+  return vnew;
+}
+
+static void RB_VEC(define)(VALUE module)
+{
+  VALUE klass, mklass;
+  klass = rb_define_class_under(module, SMALL_VEC_CLASS, cGSL_Object);
+  mklass = rb_define_class_under(module, SMALL_MAT_CLASS, cGSL_Object);
+  cgsl_small_vec[SMALL_N] = klass;
+  cgsl_small_mat[SMALL_N] = mklass;
+
+  rb_define_alloc_func(klass, RB_VEC(alloc));
+  rb_define_alias(rb_singleton_class(klass), "alloc", "new");
+  rb_define_alias(rb_singleton_class(klass), "[]", "new");
+  rb_define_method(klass, "initialize", RB_VEC(initialize), -1);
+  rb_define_method(klass, "dup", RB_VEC(dup), 0);
+  rb_define_method(klass, "clone", RB_VEC(dup), 0);
+  rb_define_method(klass, "[]", RB_VEC(get), 1);
+  rb_define_method(klass, "[]=", RB_VEC(set), 2);
+  rb_define_alias(klass, "get", "[]");
+  rb_define_alias(klass, "set", "[]=");
+  rb_define_method(klass, "size", RB_VEC(size), 0);
+  rb_define_method(klass, "to_a", RB_VEC(to_a), 0);
+  rb_define_method(klass, "to_v", RB_VEC(to_v), 0);
+  rb_define_method(klass, "inspect", RB_VEC(inspect), 0);
+  rb_define_alias(klass, "to_s", "inspect");
+  rb_define_method(klass, "==", RB_VEC(equal), 1);
+  rb_define_method(klass, "+", RB_VEC(add), 1);
+  rb_define_method(klass, "-", RB_VEC(sub), 1);
+  rb_define_method(klass, "-@", RB_VEC(uminus), 0);
+  rb_define_method(klass, "*", RB_VEC(mul), 1);
+  rb_define_method(klass, "/", RB_VEC(div), 1);
+  rb_define_method(klass, "coerce", RB_VEC(coerce), 1);
+  rb_define_method(klass, "dot", RB_VEC(dot2), 1);
+  rb_define_method(klass, "norm", RB_VEC(norm), 0);
+  rb_define_alias(klass, "dnrm2", "norm");
+  rb_define_method(klass, "norm2", RB_VEC(norm2), 0);
+  rb_define_method(klass, "normalize", RB_VEC(normalize), 0);
+#if SMALL_N <= 3
+  rb_define_method(klass, "cross", RB_VEC(cross), 1);
+#endif
+#if SMALL_N == 3
+  rb_define_method(klass, "rotateX", RB_VEC(rotateX), 1);
+  rb_define_method(klass, "rotateY", RB_VEC(rotateY), 1);
+  rb_define_method(klass, "rotateZ", RB_VEC(rotateZ), 1);
+  rb_define_method(klass, "rotate", RB_VEC(rotate), 2);
+#endif
+
+  rb_define_alloc_func(mklass, RB_MAT(alloc));
+  rb_define_alias(rb_singleton_class(mklass), "alloc", "new");
+  rb_define_alias(rb_singleton_class(mklass), "[]", "new");
+  rb_define_singleton_method(mklass, "identity", RB_MAT(identity), 0);
+  rb_define_alias(rb_singleton_class(mklass), "eye", "identity");
+  rb_define_method(mklass, "initialize", RB_MAT(initialize), -1);
+  rb_define_method(mklass, "dup", RB_MAT(dup), 0);
+  rb_define_method(mklass, "clone", RB_MAT(dup), 0);
+  rb_define_method(mklass, "[]", RB_MAT(get), 2);
+  rb_define_method(mklass, "[]=", RB_MAT(set), 3);
+  rb_define_alias(mklass, "get", "[]");
+  rb_define_alias(mklass, "set", "[]=");
+  rb_define_method(mklass, "size", RB_MAT(size), 0);
+  rb_define_alias(mklass, "shape", "size");
+  rb_define_method(mklass, "to_a", RB_MAT(to_a), 0);
+  rb_define_method(mklass, "to_m", RB_MAT(to_m), 0);
+  rb_define_method(mklass, "inspect", RB_MAT(inspect), 0);
+  rb_define_alias(mklass, "to_s", "inspect");
+  rb_define_method(mklass, "==", RB_MAT(equal), 1);
+  rb_define_method(mklass, "+", RB_MAT(add), 1);
+  rb_define_method(mklass, "-", RB_MAT(sub), 1);
+  rb_define_method(mklass, "-@", RB_MAT(uminus), 0);
+  rb_define_method(mklass, "*", RB_MAT(mul2), 1);
+  rb_define_method(mklass, "coerce", RB_MAT(coerce), 1);
+  rb_define_method(mklass, "transpose", RB_MAT(transpose), 0);
+  rb_define_alias(mklass, "trans", "transpose");
+  rb_define_method(mklass, "trace", RB_MAT(trace), 0);
+  rb_define_method(mklass, "det", RB_MAT(det2), 0);
+  rb_define_method(mklass, "inverse", RB_MAT(inverse2), 0);
+  rb_define_alias(mklass, "inv", "inverse");
+}
+
+#undef VEC
+#undef MAT
+#undef RB_VEC
+#undef RB_MAT
+#undef NN
@@ -16,6 +16,9 @@
 EXTERN ID RBGSL_ID_call;
 EXTERN VALUE cgsl_complex;
 
+void Init_gsl_sort_parallel(VALUE module);
+void Init_gsl_sort_select(VALUE module);
+
 int rb_gsl_comparison_double(const void *aa, const void *bb);
 int rb_gsl_comparison_complex(const void *aa, const void *bb);
 int rb_gsl_comparison_double(const void *aa, const void *bb)
@@ -200,6 +203,9 @@ void Init_gsl_sort(VALUE module)
   rb_define_method(cgsl_vector_complex, "heapsort", rb_gsl_heapsort_vector_complex2, 0);
   rb_define_method(cgsl_vector_complex, "heapsort_index", rb_gsl_heapsort_index_vector_complex, 0);
 
+  Init_gsl_sort_parallel(module);
+  Init_gsl_sort_select(module);
+
 #ifdef HAVE_NARRAY_H
   rb_define_method(cNArray, "gsl_sort", rb_gsl_sort_narray, 0);
   rb_define_method(cNArray, "gsl_sort!", rb_gsl_sort_narray_bang, 0);
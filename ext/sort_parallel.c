@@ -0,0 +1,331 @@
+/*
+  sort_parallel.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Radix and parallel sorts of GSL::Vector and GSL::Vector::Int.
+
+    v.radix_sort!                 # in place, as sort!
+    w = v.radix_sort              # a sorted copy
+    p = v.radix_sort_index        # GSL::Permutation: w[i] == v[p[i]]
+    v.parallel_sort!              # parallel_sort, parallel_sort_index
+
+  The elements are mapped to unsigned 64-bit keys in the same order (for
+  a double, its bits with the sign bit flipped, or all of them flipped
+  when negative) and sorted by a least-significant-digit radix sort of
+  8 bits a pass, the passes where all the keys share the digit being
+  skipped: the 4 upper bytes for Vector::Int, and often the exponent
+  bytes of doubles.  The sort is stable, so that the permutation keeps
+  ties in ascending order of index.  -0.0 comes before 0.0, and NaNs go
+  to the ends by the sign bit, where gsl_sort leaves them anywhere.
+
+  parallel_* split the vector in GSL.parallel_threads runs, radix sorted
+  concurrently from GSL.parallel_threshold elements on, then merged
+  pairwise, each round of merges being split evenly between the threads
+  by merge path.  Below the threshold they are radix_*.  The sorts take
+  one buffer of the size of the vector (two more of indices for the
+  _index forms) and release the GVL.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include <stdint.h>
+
+#define SORTP_CHUNK_MIN 65536
+#define SORTP_SIGN UINT64_C(0x8000000000000000)
+
+struct sortp_task {
+  uint64_t *k[2];               /* the keys and their buffer */
+  size_t *ix[2];                /* the indices and their buffer, or NULL */
+  size_t n, nthreads;
+  int dest;                     /* where the sorted runs of the threads go */
+  unsigned int round;           /* merge of the runs of 2**round chunks */
+  int src;                      /* the buffer the runs of the round are in */
+};
+
+static uint64_t sortp_key_double(double x)
+{
+  uint64_t u;
+  memcpy(&u, &x, sizeof(u));
+  return (u & SORTP_SIGN) ? ~u : (u | SORTP_SIGN);
+}
+
+static double sortp_double_key(uint64_t u)
+{
+  double x;
+  u = (u & SORTP_SIGN) ? (u & ~SORTP_SIGN) : ~u;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+static uint64_t sortp_key_int(int x)
+{
+  return (uint64_t) ((uint32_t) x ^ UINT32_C(0x80000000));
+}
+
+static int sortp_int_key(uint64_t u)
+{
+  return (int) ((uint32_t) u ^ UINT32_C(0x80000000));
+}
+
+/* LSD radix sort of k[0 ... n-1], the indices ix (or NULL) following,
+   with k2 and ix2 as buffers.  Returns 1 when the result is left in k2
+   and ix2, 0 when in k and ix. */
+static int sortp_radix(uint64_t *k, size_t *ix, uint64_t *k2, size_t *ix2, size_t n)
+{
+  size_t count[8][256], i, b, d, c, sum;
+  uint64_t *ks = k, *kd = k2, *kt;
+  size_t *is = ix, *id = ix2, *it;
+  int flip = 0;
+  if (n < 2) return 0;
+  memset(count, 0, sizeof(count));
+  for (i = 0; i < n; i++)
+    for (b = 0; b < 8; b++) count[b][(k[i] >> (8*b)) & 0xff]++;
+  for (b = 0; b < 8; b++) {
+    if (count[b][(ks[0] >> (8*b)) & 0xff] == n) continue;
+    for (d = 0, sum = 0; d < 256; d++) {
+      c = count[b][d];
+      count[b][d] = sum;
+      sum += c;
+    }
+    if (is) {
+      for (i = 0; i < n; i++) {
+	c = count[b][(ks[i] >> (8*b)) & 0xff]++;
+	kd[c] = ks[i];
+	id[c] = is[i];
+      }
+    } else {
+      for (i = 0; i < n; i++) kd[count[b][(ks[i] >> (8*b)) & 0xff]++] = ks[i];
+    }
+    kt = ks; ks = kd; kd = kt;
+    it = is; is = id; id = it;
+    flip ^= 1;
+  }
+  return flip;
+}
+
+/* The number of elements of a[0 ... m-1] among the first d of the
+   stable merge of a and b[0 ... nb-1] */
+static size_t sortp_split(const uint64_t *a, size_t m, const uint64_t *b, size_t nb, size_t d)
+{
+  size_t lo = d > nb ? d - nb : 0, hi = d < m ? d : m, mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo)/2;
+    if (a[mid] <= b[d - mid - 1]) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+static size_t sortp_bound(const struct sortp_task *t, size_t c)
+{
+  if (c > t->nthreads) c = t->nthreads;
+  return t->n*c/t->nthreads;
+}
+
+static int sortp_chunk_worker(void *data, size_t id)
+{
+  struct sortp_task *t = (struct sortp_task *) data;
+  size_t lo = sortp_bound(t, id), n = sortp_bound(t, id + 1) - lo;
+  int at;
+  at = sortp_radix(t->k[0] + lo, t->ix[0] ? t->ix[0] + lo : NULL,
+		   t->k[1] + lo, t->ix[1] ? t->ix[1] + lo : NULL, n);
+  if (at != t->dest) {
+    memcpy(t->k[t->dest] + lo, t->k[at] + lo, sizeof(uint64_t)*n);
+    if (t->ix[0]) memcpy(t->ix[t->dest] + lo, t->ix[at] + lo, sizeof(size_t)*n);
+  }
+  return GSL_SUCCESS;
+}
+
+/* Positions o0 ... o1-1 of the merge of the runs [lo, mid) and [mid, hi) */
+static void sortp_merge_range(struct sortp_task *t, size_t lo, size_t mid, size_t hi,
+			      size_t o0, size_t o1)
+{
+  const uint64_t *a = t->k[t->src] + lo, *b = t->k[t->src] + mid;
+  const size_t *ia = t->ix[0] ? t->ix[t->src] + lo : NULL;
+  const size_t *ib = t->ix[0] ? t->ix[t->src] + mid : NULL;
+  uint64_t *out = t->k[!t->src];
+  size_t *iout = t->ix[0] ? t->ix[!t->src] : NULL;
+  size_t m = mid - lo, nb = hi - mid, i, j, i1, j1, o;
+  i = sortp_split(a, m, b, nb, o0 - lo);
+  j = o0 - lo - i;
+  i1 = sortp_split(a, m, b, nb, o1 - lo);
+  j1 = o1 - lo - i1;
+  for (o = o0; i < i1 && j < j1; o++) {
+    if (a[i] <= b[j]) {
+      if (iout) iout[o] = ia[i];
+      out[o] = a[i++];
+    } else {
+      if (iout) iout[o] = ib[j];
+      out[o] = b[j++];
+    }
+  }
+  for (; i < i1; o++, i++) {
+    if (iout) iout[o] = ia[i];
+    out[o] = a[i];
+  }
+  for (; j < j1; o++, j++) {
+    if (iout) iout[o] = ib[j];
+    out[o] = b[j];
+  }
+}
+
+static int sortp_merge_worker(void *data, size_t id)
+{
+  struct sortp_task *t = (struct sortp_task *) data;
+  size_t o0 = t->n*id/t->nthreads, o1 = t->n*(id + 1)/t->nthreads;
+  size_t w = (size_t) 1 << t->round, q, lo, mid, hi;
+  for (q = 0; q*2*w < t->nthreads; q++) {
+    lo = sortp_bound(t, 2*q*w);
+    mid = sortp_bound(t, (2*q + 1)*w);
+    hi = sortp_bound(t, (2*q + 2)*w);
+    if (hi <= o0 || lo >= o1) continue;
+    sortp_merge_range(t, lo, mid, hi, GSL_MAX(lo, o0), GSL_MIN(hi, o1));
+  }
+  return GSL_SUCCESS;
+}
+
+static int sortp_serial(void *data)
+{
+  struct sortp_task *t = (struct sortp_task *) data;
+  t->dest = 0;
+  t->nthreads = 1;
+  return sortp_chunk_worker(t, 0);
+}
+
+/* Sorts the keys k[0 ... n-1], with the indices ix if not NULL */
+static void sortp_run(uint64_t *k, size_t *ix, size_t n, int parallel)
+{
+  struct sortp_task t;
+  unsigned int rounds = 0;
+  VALUE vk, vix = 0;
+  t.n = n;
+  t.k[0] = k;
+  t.k[1] = ALLOCV_N(uint64_t, vk, n);
+  t.ix[0] = ix;
+  t.ix[1] = ix ? ALLOCV_N(size_t, vix, n) : NULL;
+  t.nthreads = parallel ? rb_gsl_parallel_nthreads(n, n/SORTP_CHUNK_MIN) : 1;
+  if (t.nthreads <= 1) {
+    rb_gsl_nogvl_call(sortp_serial, &t, n);
+  } else {
+    while (((size_t) 1 << rounds) < t.nthreads) rounds++;
+    /* the runs start where the last round leaves the result in k */
+    t.dest = rounds & 1;
+    rb_gsl_nogvl_parallel(sortp_chunk_worker, &t, t.nthreads);
+    for (t.round = 0, t.src = t.dest; t.round < rounds; t.round++, t.src = !t.src)
+      rb_gsl_nogvl_parallel(sortp_merge_worker, &t, t.nthreads);
+  }
+  ALLOCV_END(vk);
+  if (vix) ALLOCV_END(vix);
+}
+
+static VALUE sortp_vector(VALUE obj, int inplace, int index, int parallel)
+{
+  gsl_vector *v = NULL, *vnew = NULL;
+  gsl_vector_int *vi = NULL, *vinew = NULL;
+  gsl_permutation *p = NULL;
+  uint64_t *k;
+  double *d;
+  size_t n, i, stride;
+  VALUE vk = 0, ret = obj;
+  int isint = VECTOR_INT_P(obj);
+  if (isint) {
+    Data_Get_Struct(obj, gsl_vector_int, vi);
+    n = vi->size;
+    stride = vi->stride;
+  } else {
+    CHECK_VECTOR(obj);
+    Data_Get_Struct(obj, gsl_vector, v);
+    n = v->size;
+    stride = v->stride;
+  }
+  if (index) {
+    p = gsl_permutation_alloc(n);
+    ret = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
+    for (i = 0; i < n; i++) p->data[i] = i;
+  } else if (!inplace) {
+    if (isint) {
+      vinew = gsl_vector_int_alloc(n);
+      ret = Data_Wrap_Struct(VECTOR_INT_ROW_COL(obj), 0, gsl_vector_int_free, vinew);
+    } else {
+      vnew = gsl_vector_alloc(n);
+      ret = Data_Wrap_Struct(VECTOR_ROW_COL(obj), 0, gsl_vector_free, vnew);
+    }
+  }
+  if (!isint && !index && (vnew || stride == 1)) {
+    /* the keys of a contiguous result take its place while sorted */
+    d = vnew ? vnew->data : v->data;
+    k = (uint64_t *) d;
+    for (i = 0; i < n; i++) k[i] = sortp_key_double(v->data[i*stride]);
+  } else {
+    k = ALLOCV_N(uint64_t, vk, n);
+    if (isint) for (i = 0; i < n; i++) k[i] = sortp_key_int(vi->data[i*stride]);
+    else for (i = 0; i < n; i++) k[i] = sortp_key_double(v->data[i*stride]);
+  }
+  sortp_run(k, p ? p->data : NULL, n, parallel);
+  if (!index) {
+    if (isint) {
+      if (vinew) for (i = 0; i < n; i++) vinew->data[i] = sortp_int_key(k[i]);
+      else for (i = 0; i < n; i++) vi->data[i*stride] = sortp_int_key(k[i]);
+    } else {
+      d = vnew ? vnew->data : v->data;
+      if (vnew) stride = 1;
+      for (i = 0; i < n; i++) d[i*stride] = sortp_double_key(k[i]);
+    }
+  }
+  if (vk) ALLOCV_END(vk);
+  return ret;
+}
+
+static VALUE rb_gsl_vector_radix_sort_bang(VALUE obj)
+{
+  return sortp_vector(obj, 1, 0, 0);
+}
+
+static VALUE rb_gsl_vector_radix_sort(VALUE obj)
+{
+  return sortp_vector(obj, 0, 0, 0);
+}
+
+static VALUE rb_gsl_vector_radix_sort_index(VALUE obj)
+{
+  return sortp_vector(obj, 0, 1, 0);
+}
+
+static VALUE rb_gsl_vector_parallel_sort_bang(VALUE obj)
+{
+  return sortp_vector(obj, 1, 0, 1);
+}
+
+static VALUE rb_gsl_vector_parallel_sort(VALUE obj)
+{
+  return sortp_vector(obj, 0, 0, 1);
+}
+
+static VALUE rb_gsl_vector_parallel_sort_index(VALUE obj)
+{
+  return sortp_vector(obj, 0, 1, 1);
+}
+
+void Init_gsl_sort_parallel(VALUE module)
+{
+  VALUE klass[2];
+  int i;
+  klass[0] = cgsl_vector;
+  klass[1] = cgsl_vector_int;
+  for (i = 0; i < 2; i++) {
+    rb_define_method(klass[i], "radix_sort!", rb_gsl_vector_radix_sort_bang, 0);
+    rb_define_method(klass[i], "radix_sort", rb_gsl_vector_radix_sort, 0);
+    rb_define_method(klass[i], "radix_sort_index", rb_gsl_vector_radix_sort_index, 0);
+    rb_define_method(klass[i], "parallel_sort!", rb_gsl_vector_parallel_sort_bang, 0);
+    rb_define_method(klass[i], "parallel_sort", rb_gsl_vector_parallel_sort, 0);
+    rb_define_method(klass[i], "parallel_sort_index", rb_gsl_vector_parallel_sort_index, 0);
+  }
+}
@@ -0,0 +1,372 @@
+/*
+  sort_select.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Selection without sorting.
+
+    x = v.nth_element(k)          # the (k+1)-th smallest element of v
+    x = v.nth_element!(k)         # the same, v being reordered in place
+    m = v.median!                 # exact, v being reordered in place
+    m = v.median_approx(bins)     # within stddev/bins, v left untouched
+    m.nth_element_rows(k)         # GSL::Vector of the (k+1)-th of each row
+    m.nth_element_rows!(k)        # also median_rows, median_rows!
+
+  nth_element! leaves v partitioned as std::nth_element: v[k] is the
+  element a sort would put there, none before it is greater, none after
+  it smaller.  It is an introselect: quickselect on the median of three
+  with three-way partitions, which take runs of ties at once, and the
+  median of medians as pivot once the partitions have failed to shrink
+  quickly enough, so O(n) in the worst case.  The forms without ! work
+  on a copy, the row forms on one buffer of a row per thread.  median!
+  is the median of gsl_stats_median_from_sorted_data without a copy or
+  a sort; median_approx is the binapprox of Tibshirani (2008): two
+  passes and bins counters, no copy.  The rows are split between
+  GSL.parallel_threads threads, and the GVL released, from
+  GSL.parallel_threshold elements on.  The order of NaNs is undefined,
+  as for gsl_sort.
+
+  The first k, or the largest k, elements of a vector are
+  sort_smallest(k) and sort_largest(k), with the _index forms.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+#define SELECT_SMALL 16
+
+#define SEL(i) a[(i)*s]
+
+static void select_swap(double *a, size_t s, size_t i, size_t j)
+{
+  double t = SEL(i);
+  SEL(i) = SEL(j);
+  SEL(j) = t;
+}
+
+static void select_insertion(double *a, size_t s, size_t lo, size_t hi)
+{
+  size_t i, j;
+  double x;
+  for (i = lo + 1; i < hi; i++) {
+    x = SEL(i);
+    for (j = i; j > lo && SEL(j-1) > x; j--) SEL(j) = SEL(j-1);
+    SEL(j) = x;
+  }
+}
+
+/* Three-way partition of [lo, hi) around p: [lo, *lt) < p, [*lt, *gt)
+   equal to p, [*gt, hi) > p */
+static void select_partition(double *a, size_t s, size_t lo, size_t hi, double p,
+			     size_t *lt, size_t *gt)
+{
+  size_t i = lo, l = lo, g = hi;
+  while (i < g) {
+    if (SEL(i) < p) select_swap(a, s, l++, i++);
+    else if (SEL(i) > p) select_swap(a, s, i, --g);
+    else i++;
+  }
+  *lt = l;
+  *gt = g;
+}
+
+static double select_median3(double x, double y, double z)
+{
+  if (x < y) {
+    if (y < z) return y;
+    return x < z ? z : x;
+  }
+  if (x < z) return x;
+  return y < z ? z : y;
+}
+
+static void select_nth(double *a, size_t s, size_t lo, size_t hi, size_t k);
+
+/* The median of the medians of the groups of 5 of [lo, hi), the
+   medians being gathered at the front */
+static double select_pivot_mom(double *a, size_t s, size_t lo, size_t hi)
+{
+  size_t g, ng = 0, g1;
+  for (g = lo; g < hi; g += 5) {
+    g1 = GSL_MIN(g + 5, hi);
+    select_insertion(a, s, g, g1);
+    select_swap(a, s, lo + ng++, g + (g1 - g - 1)/2);
+  }
+  select_nth(a, s, lo, lo + ng, lo + (ng - 1)/2);
+  return SEL(lo + (ng - 1)/2);
+}
+
+/* Reorders [lo, hi) so that a[k] is in its sorted place */
+static void select_nth(double *a, size_t s, size_t lo, size_t hi, size_t k)
+{
+  size_t lt, gt, budget = 0, n;
+  double p;
+  for (n = hi - lo; n > 1; n >>= 1) budget += 2;
+  while (hi - lo > SELECT_SMALL) {
+    if (budget > 0) {
+      budget--;
+      p = select_median3(SEL(lo), SEL(lo + (hi - lo)/2), SEL(hi - 1));
+    } else {
+      p = select_pivot_mom(a, s, lo, hi);
+    }
+    select_partition(a, s, lo, hi, p, &lt, &gt);
+    if (k < lt) hi = lt;
+    else if (k >= gt) lo = gt;
+    else return;
+  }
+  select_insertion(a, s, lo, hi);
+}
+
+/* The k-th element of a[0 ... n-1] in sorted order, in place */
+static double select_value(double *a, size_t s, size_t n, size_t k)
+{
+  select_nth(a, s, 0, n, k);
+  return SEL(k);
+}
+
+static double select_median(double *a, size_t s, size_t n)
+{
+  size_t k = n/2, i;
+  double lower;
+  if (n == 0) return GSL_NAN;
+  select_nth(a, s, 0, n, k);
+  if (n % 2) return SEL(k);
+  /* the largest of the lower half is the other middle element */
+  lower = SEL(0);
+  for (i = 1; i < k; i++) if (SEL(i) > lower) lower = SEL(i);
+  return (lower + SEL(k))/2.0;
+}
+
+/* binapprox: the median is within one standard deviation of the mean */
+static double select_median_approx(const double *a, size_t s, size_t n, size_t *count,
+				   size_t bins)
+{
+  double mean = 0.0, var = 0.0, d, sd, lo, scale;
+  size_t i, below = 0, b, cum, r1 = (n + 1)/2, r2 = n/2 + 1, b1 = bins;
+  for (i = 0; i < n; i++) {
+    d = SEL(i) - mean;
+    mean += d/(i + 1);
+    var += d*(SEL(i) - mean);
+  }
+  sd = sqrt(var/n);
+  if (!(sd > 0.0)) return mean;
+  lo = mean - sd;
+  scale = bins/(2.0*sd);
+  memset(count, 0, sizeof(size_t)*bins);
+  for (i = 0; i < n; i++) {
+    d = SEL(i);
+    if (d < lo) below++;
+    else if (d < mean + sd) {
+      b = (size_t) ((d - lo)*scale);
+      count[GSL_MIN(b, bins - 1)]++;
+    }
+  }
+  /* the bins of the two middle ranks, which are one for n odd */
+  for (b = 0, cum = below; b < bins; b++) {
+    cum += count[b];
+    if (cum >= r1 && b1 == bins) b1 = b;
+    if (cum >= r2) break;
+  }
+  b = GSL_MIN(b, bins - 1);
+  return lo + (GSL_MIN(b1, b) + b + 1.0)/(2.0*scale);
+}
+
+#undef SEL
+
+/* Vectors */
+
+struct select_vector {
+  double *a;
+  size_t stride, n, k, bins;
+  size_t *count;
+  int op;                       /* SELECT_NTH, SELECT_MEDIAN, SELECT_APPROX */
+  double result;
+};
+
+enum { SELECT_NTH, SELECT_MEDIAN, SELECT_APPROX };
+
+static int select_vector_run(void *data)
+{
+  struct select_vector *t = (struct select_vector *) data;
+  switch (t->op) {
+  case SELECT_NTH:
+    t->result = select_value(t->a, t->stride, t->n, t->k);
+    break;
+  case SELECT_MEDIAN:
+    t->result = select_median(t->a, t->stride, t->n);
+    break;
+  default:
+    t->result = select_median_approx(t->a, t->stride, t->n, t->count, t->bins);
+    break;
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE select_vector(VALUE obj, int op, size_t k, size_t bins, int inplace)
+{
+  struct select_vector t;
+  gsl_vector *v;
+  VALUE vbuf = 0, vcount = 0;
+  size_t i;
+  CHECK_VECTOR(obj);
+  Data_Get_Struct(obj, gsl_vector, v);
+  if (op == SELECT_NTH && k >= v->size)
+    rb_raise(rb_eIndexError, "index %d out of range for a vector of size %d",
+	     (int) k, (int) v->size);
+  t.op = op;
+  t.n = v->size;
+  t.k = k;
+  t.bins = bins;
+  t.count = NULL;
+  if (inplace) {
+    t.a = v->data;
+    t.stride = v->stride;
+  } else {
+    t.a = ALLOCV_N(double, vbuf, v->size);
+    t.stride = 1;
+    for (i = 0; i < v->size; i++) t.a[i] = v->data[i*v->stride];
+  }
+  if (op == SELECT_APPROX) t.count = ALLOCV_N(size_t, vcount, bins);
+  rb_gsl_nogvl_call(select_vector_run, &t, t.n);
+  if (vbuf) ALLOCV_END(vbuf);
+  if (vcount) ALLOCV_END(vcount);
+  return rb_float_new(t.result);
+}
+
+static size_t select_index(VALUE kk)
+{
+  long k = NUM2LONG(kk);
+  if (k < 0) rb_raise(rb_eIndexError, "negative index %ld", k);
+  return (size_t) k;
+}
+
+static VALUE rb_gsl_vector_nth_element(VALUE obj, VALUE kk)
+{
+  return select_vector(obj, SELECT_NTH, select_index(kk), 0, 0);
+}
+
+static VALUE rb_gsl_vector_nth_element_bang(VALUE obj, VALUE kk)
+{
+  return select_vector(obj, SELECT_NTH, select_index(kk), 0, 1);
+}
+
+static VALUE rb_gsl_vector_median_bang(VALUE obj)
+{
+  return select_vector(obj, SELECT_MEDIAN, 0, 0, 1);
+}
+
+static VALUE rb_gsl_vector_median_approx(int argc, VALUE *argv, VALUE obj)
+{
+  long bins = 1000;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) bins = NUM2LONG(argv[0]);
+  if (bins < 1) rb_raise(rb_eArgError, "bins must be positive");
+  /* the approximation reads the data only: no copy */
+  return select_vector(obj, SELECT_APPROX, 0, (size_t) bins, 1);
+}
+
+/* Matrix rows */
+
+struct select_rows {
+  gsl_matrix *m;
+  double *out, *buf;            /* buf: one row per thread, NULL in place */
+  size_t k, nthreads;
+  int median;
+};
+
+static void select_rows_range(struct select_rows *t, size_t i0, size_t i1, double *buf)
+{
+  gsl_matrix *m = t->m;
+  size_t i, n = m->size2;
+  double *row;
+  for (i = i0; i < i1; i++) {
+    row = m->data + i*m->tda;
+    if (buf) {
+      memcpy(buf, row, sizeof(double)*n);
+      row = buf;
+    }
+    t->out[i] = t->median ? select_median(row, 1, n) : select_value(row, 1, n, t->k);
+  }
+}
+
+static int select_rows_worker(void *data, size_t id)
+{
+  struct select_rows *t = (struct select_rows *) data;
+  size_t n = t->m->size1;
+  select_rows_range(t, n*id/t->nthreads, n*(id + 1)/t->nthreads,
+		    t->buf ? t->buf + id*t->m->size2 : NULL);
+  return GSL_SUCCESS;
+}
+
+static int select_rows_serial(void *data)
+{
+  struct select_rows *t = (struct select_rows *) data;
+  select_rows_range(t, 0, t->m->size1, t->buf);
+  return GSL_SUCCESS;
+}
+
+static VALUE select_matrix_rows(VALUE obj, int median, size_t k, int inplace)
+{
+  struct select_rows t;
+  gsl_vector *out;
+  VALUE vout, vbuf = 0;
+  size_t work;
+  CHECK_MATRIX(obj);
+  Data_Get_Struct(obj, gsl_matrix, t.m);
+  if (!median && k >= t.m->size2)
+    rb_raise(rb_eIndexError, "index %d out of range for rows of size %d",
+	     (int) k, (int) t.m->size2);
+  out = gsl_vector_alloc(t.m->size1);
+  vout = Data_Wrap_Struct(cgsl_vector_col, 0, gsl_vector_free, out);
+  t.out = out->data;
+  t.k = k;
+  t.median = median;
+  work = t.m->size1*t.m->size2;
+  t.nthreads = rb_gsl_parallel_nthreads(work, t.m->size1);
+  if (t.nthreads < 1) t.nthreads = 1;
+  t.buf = inplace ? NULL : ALLOCV_N(double, vbuf, t.nthreads*t.m->size2);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(select_rows_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(select_rows_serial, &t, work);
+  if (vbuf) ALLOCV_END(vbuf);
+  return vout;
+}
+
+static VALUE rb_gsl_matrix_nth_element_rows(VALUE obj, VALUE kk)
+{
+  return select_matrix_rows(obj, 0, select_index(kk), 0);
+}
+
+static VALUE rb_gsl_matrix_nth_element_rows_bang(VALUE obj, VALUE kk)
+{
+  return select_matrix_rows(obj, 0, select_index(kk), 1);
+}
+
+static VALUE rb_gsl_matrix_median_rows(VALUE obj)
+{
+  return select_matrix_rows(obj, 1, 0, 0);
+}
+
+static VALUE rb_gsl_matrix_median_rows_bang(VALUE obj)
+{
+  return select_matrix_rows(obj, 1, 0, 1);
+}
+
+void Init_gsl_sort_select(VALUE module)
+{
+  rb_define_method(cgsl_vector, "nth_element", rb_gsl_vector_nth_element, 1);
+  rb_define_method(cgsl_vector, "nth_element!", rb_gsl_vector_nth_element_bang, 1);
+  rb_define_method(cgsl_vector, "median!", rb_gsl_vector_median_bang, 0);
+  rb_define_method(cgsl_vector, "median_approx", rb_gsl_vector_median_approx, -1);
+
+  rb_define_method(cgsl_matrix, "nth_element_rows", rb_gsl_matrix_nth_element_rows, 1);
+  rb_define_method(cgsl_matrix, "nth_element_rows!", rb_gsl_matrix_nth_element_rows_bang, 1);
+  rb_define_method(cgsl_matrix, "median_rows", rb_gsl_matrix_median_rows, 0);
+  rb_define_method(cgsl_matrix, "median_rows!", rb_gsl_matrix_median_rows_bang, 0);
+}
@@ -15,6 +15,72 @@ EXTERN VALUE cgsl_interp_accel;  /* defined in interp.c */
 
 static void rb_gsl_spline_free(rb_gsl_spline *sp);
 
+/*
+  A spline is not changed by evaluation once initialized, so that a
+  frozen one can be shared between threads and Ractors: the evaluators
+  take the interval cache from an Interp::Accel given as their last
+  argument, or from a per-thread accelerator kept for the last few
+  splines evaluated on the thread.  The accelerator of the object is
+  used only by find and returned by accel.
+*/
+#ifdef RUBY_TYPED_FROZEN_SHAREABLE
+static const rb_data_type_t rb_gsl_spline_data_type = {
+  "GSL::Spline",
+  { 0, (void (*)(void *)) rb_gsl_spline_free, 0, },
+  0, 0, RUBY_TYPED_FROZEN_SHAREABLE
+};
+#define SPLINE_WRAP(klass, sp) TypedData_Wrap_Struct(klass, &rb_gsl_spline_data_type, sp)
+#define SPLINE_GET(obj, sp) TypedData_Get_Struct(obj, rb_gsl_spline, &rb_gsl_spline_data_type, sp)
+#else
+#define SPLINE_WRAP(klass, sp) Data_Wrap_Struct(klass, 0, rb_gsl_spline_free, sp)
+#define SPLINE_GET(obj, sp) Data_Get_Struct(obj, rb_gsl_spline, sp)
+#endif
+
+#define SPLINE_ACCEL_SLOTS 8
+
+struct spline_accel_slot {
+  const gsl_spline *s;
+  gsl_interp_accel a;
+};
+
+static RB_GSL_THREAD_LOCAL struct {
+  struct spline_accel_slot e[SPLINE_ACCEL_SLOTS];
+  unsigned int next;
+} spline_accel;
+
+/*
+  The accelerator of this thread for s.  A slot left by a freed spline
+  may be picked up by a new one at the same address; the cache is only
+  a hint, checked against the knots, and is reset if out of range.
+*/
+static gsl_interp_accel* rb_gsl_spline_thread_accel(const gsl_spline *s)
+{
+  struct spline_accel_slot *e;
+  size_t i;
+  for (i = 0; i < SPLINE_ACCEL_SLOTS; i++) {
+    e = spline_accel.e + i;
+    if (e->s != s) continue;
+    if (e->a.cache + 1 >= s->size) gsl_interp_accel_reset(&e->a);
+    return &e->a;
+  }
+  e = spline_accel.e + spline_accel.next++ % SPLINE_ACCEL_SLOTS;
+  e->s = s;
+  gsl_interp_accel_reset(&e->a);
+  return &e->a;
+}
+
+/* Takes a trailing Interp::Accel off argv, or the thread's accelerator */
+static gsl_interp_accel* rb_gsl_spline_get_accel(int *argc, VALUE *argv, const gsl_spline *s)
+{
+  gsl_interp_accel *a = NULL;
+  if (*argc > 0 && rb_obj_is_kind_of(argv[*argc-1], cgsl_interp_accel)) {
+    Data_Get_Struct(argv[*argc-1], gsl_interp_accel, a);
+    *argc -= 1;
+    return a;
+  }
+  return rb_gsl_spline_thread_accel(s);
+}
+
 static VALUE rb_gsl_spline_new(int argc, VALUE *argv, VALUE klass)
 {
   rb_gsl_spline *sp = NULL;
@@ -46,17 +112,38 @@ static VALUE rb_gsl_spline_new(int argc, VALUE *argv, VALUE klass)
   if (T == NULL) T = gsl_interp_cspline;
   sp->s = gsl_spline_alloc(T, size);
   sp->a = gsl_interp_accel_alloc();
+  sp->seal = NULL;
   if (ptrx && ptry) gsl_spline_init(sp->s, ptrx, ptry, size);
-  return Data_Wrap_Struct(klass, 0, rb_gsl_spline_free, sp);
+  return SPLINE_WRAP(klass, sp);
 }
 
 static void rb_gsl_spline_free(rb_gsl_spline *sp)
 {
+  if (sp->seal) {
+    /* the knots are in the mapping of GSL.seal */
+    sp->s->x = NULL;
+    sp->s->y = NULL;
+  }
   gsl_spline_free(sp->s);
   gsl_interp_accel_free(sp->a);
+  if (sp->seal) rb_gsl_seal_release(sp->seal);
   free((rb_gsl_spline *) sp);
 }
 
+/* The rb_gsl_spline of obj, or NULL if obj is not a Spline (GSL.seal) */
+rb_gsl_spline* rb_gsl_spline_ptr(VALUE obj)
+{
+  rb_gsl_spline *sp = NULL;
+#ifdef RUBY_TYPED_FROZEN_SHAREABLE
+  if (!rb_typeddata_is_kind_of(obj, &rb_gsl_spline_data_type)) return NULL;
+#else
+  if (TYPE(obj) != T_DATA || RDATA(obj)->dfree != (RUBY_DATA_FUNC) rb_gsl_spline_free)
+    return NULL;
+#endif
+  SPLINE_GET(obj, sp);
+  return sp;
+}
+
 static VALUE rb_gsl_spline_init(VALUE obj, VALUE xxa, VALUE yya)
 {
   rb_gsl_spline *sp = NULL;
@@ -68,7 +155,8 @@ static VALUE rb_gsl_spline_init(VALUE obj, VALUE xxa, VALUE yya)
 #ifdef HAVE_NARRAY_H
   struct NARRAY *nax = NULL, *nay = NULL;
 #endif
-  Data_Get_Struct(obj, rb_gsl_spline, sp);
+  rb_check_frozen(obj);
+  SPLINE_GET(obj, sp);
   p = sp->s;
   if (TYPE(xxa) == T_ARRAY) {
     //    size = RARRAY(xxa)->len;
@@ -115,112 +203,63 @@ static VALUE rb_gsl_spline_init(VALUE obj, VALUE xxa, VALUE yya)
 static VALUE rb_gsl_spline_accel(VALUE obj)
 {
   rb_gsl_spline *rgi = NULL;
-  Data_Get_Struct(obj, rb_gsl_spline, rgi);
+  SPLINE_GET(obj, rgi);
   return Data_Wrap_Struct(cgsl_interp_accel, 0, NULL, rgi->a);
 }
 
-static VALUE rb_gsl_spline_evaluate(VALUE obj, VALUE xx,
-				    double (*eval)(const gsl_spline *, double, 
-						   gsl_interp_accel *))
+static VALUE rb_gsl_spline_evaluate(int argc, VALUE *argv, VALUE obj, int mask)
 {
   rb_gsl_spline *rgs = NULL;
-  gsl_vector *v = NULL, *vnew = NULL;
-  gsl_matrix *m = NULL, *mnew = NULL;
-  VALUE ary, x;
-  double val;
-  size_t n, i, j;
-#ifdef HAVE_NARRAY_H
-  double *ptr1 = NULL, *ptr2 = NULL;
-  struct NARRAY *na = NULL;
-#endif
-  Data_Get_Struct(obj, rb_gsl_spline, rgs);
-  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
-  switch (TYPE(xx)) {
-  case T_FIXNUM:  case T_BIGNUM:  case T_FLOAT:
-    Need_Float(xx);
-    return rb_float_new((*eval)(rgs->s, NUM2DBL(xx), rgs->a));
-    break;
-  case T_ARRAY:
-    //    n = RARRAY(xx)->len;
-    n = RARRAY_LEN(xx);
-    ary = rb_ary_new2(n);
-    for (i = 0; i < n; i++) {
-      x = rb_ary_entry(xx, i);
-      Need_Float(x);
-      val = (*eval)(rgs->s, NUM2DBL(x), rgs->a);
-      rb_ary_store(ary, i, rb_float_new(val));
-    }
-    return ary;
-    break;
-  default:
-#ifdef HAVE_NARRAY_H
-    if (NA_IsNArray(xx)) {
-      GetNArray(xx, na);
-      ptr1 = (double *) na->ptr;
-      n = na->total;
-      ary = na_make_object(NA_DFLOAT, na->rank, na->shape, CLASS_OF(xx));
-      ptr2 = NA_PTR_TYPE(ary, double*);
-      for (i = 0; i < n; i++) 
-	ptr2[i] = (*eval)(rgs->s, ptr1[i], rgs->a);
-      return ary;
-    }
-#endif
-    if (VECTOR_P(xx)) {
-      Data_Get_Struct(xx, gsl_vector, v);
-      vnew = gsl_vector_alloc(v->size);
-      for (i = 0; i < v->size; i++) {
-	val = (*eval)(rgs->s, gsl_vector_get(v, i), rgs->a);
-	gsl_vector_set(vnew, i, val);
-      }
-      return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
-    } else if (MATRIX_P(xx)) {
-      Data_Get_Struct(xx, gsl_matrix, m);
-      mnew = gsl_matrix_alloc(m->size1, m->size2);
-      for (i = 0; i < m->size1; i++) {
-	for (j = 0; j < m->size2; j++) {
-	  val = (*eval)(rgs->s, gsl_matrix_get(m, i, j), rgs->a);
-	  gsl_matrix_set(mnew, i, j, val);
-	}
-      }
-      return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
-    } else {
-      rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(xx)));
-    }
-    break;
-  }
+  gsl_interp_accel *a = NULL;
+  VALUE out[3] = { Qnil, Qnil, Qnil };
+  size_t k, nout = 0;
+  int i;
+  SPLINE_GET(obj, rgs);
+  a = rb_gsl_spline_get_accel(&argc, argv, rgs->s);
+  for (k = 0; k < 3; k++) if (mask & (1 << k)) nout++;
+  if (argc < 1 || (size_t) argc > 1 + nout)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 to %d)", argc, (int) (1 + nout));
+  for (k = 0, i = 1; k < 3 && i < argc; k++) if (mask & (1 << k)) out[k] = argv[i++];
+  return mygsl_interp_evaluate(rgs->s->interp, rgs->s->x, rgs->s->y, a, argv[0], mask, out);
+}
 
-  /* never reach here */
-  return Qnil;
+/* eval(x[, out][, accel]): x a Numeric, Array, Range, Vector, Matrix or NArray */
+static VALUE rb_gsl_spline_eval(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_spline_evaluate(argc, argv, obj, 1);
 }
 
-static VALUE rb_gsl_spline_eval(VALUE obj, VALUE xx)
+static VALUE rb_gsl_spline_eval_deriv(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_spline_evaluate(obj, xx, gsl_spline_eval);
+  return rb_gsl_spline_evaluate(argc, argv, obj, 2);
 }
 
-static VALUE rb_gsl_spline_eval_deriv(VALUE obj, VALUE xx)
+static VALUE rb_gsl_spline_eval_deriv2(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_spline_evaluate(obj, xx, gsl_spline_eval_deriv);
+  return rb_gsl_spline_evaluate(argc, argv, obj, 4);
 }
 
-static VALUE rb_gsl_spline_eval_deriv2(VALUE obj, VALUE xx)
+/* eval_derivs(x[, y, dy, d2y]): [value, first, second derivative] in one pass */
+static VALUE rb_gsl_spline_eval_derivs(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_spline_evaluate(obj, xx, gsl_spline_eval_deriv2);
+  return rb_gsl_spline_evaluate(argc, argv, obj, 7);
 }
 
-static VALUE rb_gsl_spline_eval_integ(VALUE obj, VALUE aa, VALUE bb)
+/* eval_integ(a, b[, accel]) */
+static VALUE rb_gsl_spline_eval_integ(int argc, VALUE *argv, VALUE obj)
 {
   rb_gsl_spline *sp = NULL;
   gsl_spline *s = NULL;
   gsl_interp_accel *acc = NULL;
   double a, b;
-  Need_Float(aa);
-  Need_Float(bb);
-  Data_Get_Struct(obj, rb_gsl_spline, sp);
+  SPLINE_GET(obj, sp);
   s = sp->s;
-  acc = sp->a;
-  a = NUM2DBL(aa);
-  b = NUM2DBL(bb);
+  acc = rb_gsl_spline_get_accel(&argc, argv, s);
+  if (argc != 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2)", argc);
+  Need_Float(argv[0]);
+  Need_Float(argv[1]);
+  a = NUM2DBL(argv[0]);
+  b = NUM2DBL(argv[1]);
   return rb_float_new(gsl_spline_eval_integ(s, a, b, acc));
 }
 
@@ -229,7 +268,7 @@ static VALUE rb_gsl_spline_find(VALUE obj, VALUE vv, VALUE xx)
   rb_gsl_spline *sp = NULL;
   double *ptr = NULL, x;
   size_t size, stride;
-  Data_Get_Struct(obj, rb_gsl_spline, sp);
+  SPLINE_GET(obj, sp);
   ptr = get_vector_ptr(vv, &stride, &size);
   //  x = RFLOAT(xx)->value;
   x = NUM2DBL(xx);
@@ -241,9 +280,9 @@ static VALUE rb_gsl_spline_eval_e(VALUE obj, VALUE xx)
   rb_gsl_spline *rgs = NULL;
   double val;
   int status;
-  Data_Get_Struct(obj, rb_gsl_spline, rgs);
+  SPLINE_GET(obj, rgs);
   Need_Float(xx);
-  status = gsl_spline_eval_e(rgs->s, NUM2DBL(xx), rgs->a, &val);
+  status = gsl_spline_eval_e(rgs->s, NUM2DBL(xx), rb_gsl_spline_thread_accel(rgs->s), &val);
   switch (status) {
   case GSL_EDOM:
     rb_gsl_error_handler("gsl_spline_eval_e error", __FILE__, __LINE__, status);
@@ -260,9 +299,9 @@ static VALUE rb_gsl_spline_eval_deriv_e(VALUE obj, VALUE xx)
   rb_gsl_spline *rgs = NULL;
   double val;
   int status;
-  Data_Get_Struct(obj, rb_gsl_spline, rgs);
+  SPLINE_GET(obj, rgs);
   Need_Float(xx);
-  status = gsl_spline_eval_deriv_e(rgs->s, NUM2DBL(xx), rgs->a, &val);
+  status = gsl_spline_eval_deriv_e(rgs->s, NUM2DBL(xx), rb_gsl_spline_thread_accel(rgs->s), &val);
   switch (status) {
   case GSL_EDOM:
     rb_gsl_error_handler("gsl_spline_eval_deriv_e error", __FILE__, __LINE__, status);
@@ -279,9 +318,9 @@ static VALUE rb_gsl_spline_eval_deriv2_e(VALUE obj, VALUE xx)
   rb_gsl_spline *rgs = NULL;
   double val;
   int status;
-  Data_Get_Struct(obj, rb_gsl_spline, rgs);
+  SPLINE_GET(obj, rgs);
   Need_Float(xx);
-  status = gsl_spline_eval_deriv2_e(rgs->s, NUM2DBL(xx), rgs->a, &val);
+  status = gsl_spline_eval_deriv2_e(rgs->s, NUM2DBL(xx), rb_gsl_spline_thread_accel(rgs->s), &val);
   switch (status) {
   case GSL_EDOM:
     rb_gsl_error_handler("gsl_spline_eval_deriv2_e error", __FILE__, __LINE__, status);
@@ -298,9 +337,9 @@ static VALUE rb_gsl_spline_eval_integ_e(VALUE obj, VALUE a, VALUE b)
   rb_gsl_spline *rgs = NULL;
   double val;
   int status;
-  Data_Get_Struct(obj, rb_gsl_spline, rgs);
+  SPLINE_GET(obj, rgs);
   Need_Float(a); Need_Float(b);
-  status = gsl_spline_eval_integ_e(rgs->s, NUM2DBL(a), NUM2DBL(b), rgs->a, &val);
+  status = gsl_spline_eval_integ_e(rgs->s, NUM2DBL(a), NUM2DBL(b), rb_gsl_spline_thread_accel(rgs->s), &val);
   switch (status) {
   case GSL_EDOM:
     rb_gsl_error_handler("gsl_spline_eval_integ_e error", __FILE__, __LINE__, status);
@@ -316,7 +355,7 @@ static VALUE rb_gsl_spline_info(VALUE obj)
 {
   rb_gsl_spline *p = NULL;
   char buf[256];
-  Data_Get_Struct(obj, rb_gsl_spline, p);
+  SPLINE_GET(obj, p);
   sprintf(buf, "Class:      %s\n", rb_class2name(CLASS_OF(obj)));
   //  sprintf(buf, "%sSuperClass: %s\n", buf, rb_class2name(RCLASS(CLASS_OF(obj))->super));
   sprintf(buf, "%sType:       %s\n", buf, gsl_interp_name(p->s->interp));
@@ -330,13 +369,13 @@ static VALUE rb_gsl_spline_info(VALUE obj)
 static VALUE rb_gsl_spline_name(VALUE obj)
 {
   rb_gsl_spline *p = NULL;
-  Data_Get_Struct(obj, rb_gsl_spline, p);
+  SPLINE_GET(obj, p);
   return rb_str_new2(gsl_spline_name(p->s));
 }
 static VALUE rb_gsl_spline_min_size(VALUE obj)
 {
   rb_gsl_spline *sp = NULL;
-  Data_Get_Struct(obj, rb_gsl_spline, sp);
+  SPLINE_GET(obj, sp);
   return UINT2NUM(gsl_spline_min_size(sp->s));
 }
 
@@ -345,7 +384,7 @@ static VALUE rb_gsl_spline_min_size(VALUE obj)
 static VALUE rb_gsl_spline_name(VALUE obj)
 {
   rb_gsl_spline *sp = NULL;
-  Data_Get_Struct(obj, rb_gsl_spline, sp);
+  SPLINE_GET(obj, sp);
   return rb_str_new2(gsl_interp_name(sp->s->interp));
 }
 
@@ -357,33 +396,34 @@ void Init_gsl_spline(VALUE module)
 
   cgsl_spline = rb_define_class_under(module, "Spline", cGSL_Object);
 
+  /* these do not touch the object once initialized */
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(true);
+#endif
   rb_define_singleton_method(cgsl_spline, "alloc", rb_gsl_spline_new, -1);
 
   /*****/
 
   rb_define_method(cgsl_spline, "init", rb_gsl_spline_init, 2);
-  rb_define_method(cgsl_spline, "accel", rb_gsl_spline_accel, 0);
-  rb_define_method(cgsl_spline, "eval", rb_gsl_spline_eval, 1);
+  rb_define_method(cgsl_spline, "eval", rb_gsl_spline_eval, -1);
   rb_define_alias(cgsl_spline, "[]", "eval");
-  rb_define_method(cgsl_spline, "eval_deriv", rb_gsl_spline_eval_deriv, 1);
+  rb_define_method(cgsl_spline, "eval_deriv", rb_gsl_spline_eval_deriv, -1);
   rb_define_alias(cgsl_spline, "deriv", "eval_deriv");
-  rb_define_method(cgsl_spline, "eval_deriv2", rb_gsl_spline_eval_deriv2, 1);
+  rb_define_method(cgsl_spline, "eval_deriv2", rb_gsl_spline_eval_deriv2, -1);
   rb_define_alias(cgsl_spline, "deriv2", "eval_deriv2");
-  rb_define_method(cgsl_spline, "eval_integ", rb_gsl_spline_eval_integ, 2);
+  rb_define_method(cgsl_spline, "eval_derivs", rb_gsl_spline_eval_derivs, -1);
+  rb_define_method(cgsl_spline, "eval_integ", rb_gsl_spline_eval_integ, -1);
   rb_define_alias(cgsl_spline, "integ", "eval_integ");
 
   rb_define_method(cgsl_spline, "name", rb_gsl_spline_name, 0);
   rb_define_alias(cgsl_spline, "type", "name");
 
-  rb_define_method(cgsl_spline, "find", rb_gsl_spline_find, 2);
-  rb_define_alias(cgsl_spline, "accel_find", "find");
-
   rb_define_method(cgsl_spline, "eval_e", rb_gsl_spline_eval_e, 1);
   rb_define_method(cgsl_spline, "eval_deriv_e", rb_gsl_spline_eval_deriv_e, 1);
   rb_define_alias(cgsl_spline, "deriv_e", "eval_deriv_e");
   rb_define_method(cgsl_spline, "eval_deriv2_e", rb_gsl_spline_eval_deriv2_e, 1);
   rb_define_alias(cgsl_spline, "deri2v_e", "eval_deriv2_e");
-  rb_define_method(cgsl_spline, "eval_integ_e", rb_gsl_spline_eval_integ_e, 1);
+  rb_define_method(cgsl_spline, "eval_integ_e", rb_gsl_spline_eval_integ_e, 2);
   rb_define_alias(cgsl_spline, "integ_e", "eval_integ_e");
 
   rb_define_method(cgsl_spline, "info", rb_gsl_spline_info, 0);
@@ -391,5 +431,14 @@ void Init_gsl_spline(VALUE module)
 #ifdef GSL_1_8_LATER
   rb_define_method(cgsl_spline, "min_size", rb_gsl_spline_min_size, 0);
 #endif
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  rb_ext_ractor_safe(false);
+#endif
+
+  /* these use the accelerator of the object */
+  rb_define_method(cgsl_spline, "accel", rb_gsl_spline_accel, 0);
+  rb_define_method(cgsl_spline, "find", rb_gsl_spline_find, 2);
+  rb_define_alias(cgsl_spline, "accel_find", "find");
 
+  Init_gsl_spline_window(cgsl_spline);
 }
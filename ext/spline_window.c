@@ -0,0 +1,522 @@
+/*
+  spline_window.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  A spline over the last capacity points of a stream.
+
+    w = GSL::Spline::Window.alloc("akima", 500)
+    w.push(t, y)            # or w << [t, y]; drops the oldest when full
+    w.append(ta, ya)
+    w.eval(x)               # also [], eval_deriv, eval_deriv2, eval_integ
+
+  GSL::Spline#init recomputes every coefficient; here a new point (and
+  the oldest one leaving) only updates the intervals near the ends:
+
+    linear   the new interval
+    akima    the last 3 and first 2 intervals, whose slopes and end
+             extrapolations change (Akima's coefficients are local)
+    cspline  the natural spline with the second derivatives re-solved
+             over the WINDOW_CSPLINE_SPAN knots next to the end, the one
+             beyond held.  A change at an end decays at every knot by
+             a factor below 1/2 (0.27 on a uniform grid), so this is
+             the full solution to rounding for a span of 64.
+
+  The coefficients are those of gsl_interp_linear, cspline and akima on
+  the points of the window; x must be strictly increasing.  The points
+  are kept in buffers of twice the capacity, moved down when the end is
+  reached, so that a push costs O(1) amortized (O(span) for cspline)
+  whatever the capacity.  eval and friends take a Numeric, an Array, a
+  Vector or a Matrix as GSL::Spline, and raise GSL::ERROR::EDOM outside
+  [xmin, xmax] and GSL::ERROR::EINVAL before min_size points.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_interp.h"
+#include "rb_gsl_common.h"
+
+EXTERN VALUE cgsl_vector, cgsl_matrix;
+
+#define WINDOW_CSPLINE_SPAN 64
+
+typedef struct {
+  const gsl_interp_type *T;
+  size_t cap, n, off, min_size;
+  double *x, *y, *b, *c, *d;    /* 2*cap each, the window at off */
+  size_t cache;
+} mygsl_spline_window;
+
+static void mygsl_spline_window_free(mygsl_spline_window *w)
+{
+  xfree(w->x);
+  xfree(w);
+}
+
+#define WX(w, i) ((w)->x[(w)->off + (i)])
+#define WY(w, i) ((w)->y[(w)->off + (i)])
+
+static void window_linear(mygsl_spline_window *w, size_t i0, size_t i1)
+{
+  size_t i, k;
+  for (i = i0; i < i1; i++) {
+    k = w->off + i;
+    w->b[k] = (w->y[k+1] - w->y[k])/(w->x[k+1] - w->x[k]);
+    w->c[k] = w->d[k] = 0.0;
+  }
+}
+
+/* The slopes of Akima, extrapolated two beyond each end */
+static double window_akima_m(const mygsl_spline_window *w, long i)
+{
+  long n = (long) w->n;
+  if (i < 0) {
+    double m0 = window_akima_m(w, 0), m1 = window_akima_m(w, 1);
+    return i == -1 ? 2.0*m0 - m1 : 3.0*m0 - 2.0*m1;
+  }
+  if (i > n - 2) {
+    double m2 = window_akima_m(w, n - 2), m3 = window_akima_m(w, n - 3);
+    return i == n - 1 ? 2.0*m2 - m3 : 3.0*m2 - 2.0*m3;
+  }
+  return (WY(w, i + 1) - WY(w, i))/(WX(w, i + 1) - WX(w, i));
+}
+
+/* Intervals i0 ... i1-1 as akima_calc of GSL */
+static void window_akima(mygsl_spline_window *w, size_t i0, size_t i1)
+{
+  double m[6], ne, ne_next, alpha, alpha_next, tl_next, h;
+  size_t i, k;
+  long j;
+  for (i = i0; i < i1; i++) {
+    for (j = 0; j < 5; j++) m[j] = window_akima_m(w, (long) i + j - 2);
+    k = w->off + i;
+    h = w->x[k+1] - w->x[k];
+    /* m[2] is the slope of the interval, m[0] and m[1] those before */
+    ne = fabs(m[3] - m[2]) + fabs(m[1] - m[0]);
+    if (ne == 0.0) {
+      w->b[k] = m[2];
+      w->c[k] = w->d[k] = 0.0;
+      continue;
+    }
+    ne_next = fabs(m[4] - m[3]) + fabs(m[2] - m[1]);
+    alpha = fabs(m[1] - m[0])/ne;
+    if (ne_next == 0.0) {
+      tl_next = m[2];
+    } else {
+      alpha_next = fabs(m[2] - m[1])/ne_next;
+      tl_next = (1.0 - alpha_next)*m[2] + alpha_next*m[3];
+    }
+    w->b[k] = (1.0 - alpha)*m[1] + alpha*m[2];
+    w->c[k] = (3.0*m[2] - 2.0*w->b[k] - tl_next)/h;
+    w->d[k] = (w->b[k] + tl_next - 2.0*m[2])/(h*h);
+  }
+}
+
+/*
+  The natural spline on knots lo ... hi: c (half the second derivative)
+  is solved at lo+1 ... hi-1 with c[lo] and c[hi] as they are, zero at
+  the ends of the window, then b and d of the intervals lo ... hi-1.
+*/
+static void window_cspline(mygsl_spline_window *w, size_t lo, size_t hi)
+{
+  double *x = w->x + w->off, *y = w->y + w->off, *c = w->c + w->off;
+  double *b = w->b + w->off, *d = w->d + w->off;
+  double *g, hl, hr, m;
+  size_t i, nn;
+  if (lo == 0) c[0] = 0.0;
+  if (hi == w->n - 1) c[hi] = 0.0;
+  nn = hi - lo + 1;
+  g = ALLOC_N(double, nn);
+  /* Thomas algorithm, g the modified superdiagonal */
+  for (i = lo + 1; i < hi; i++) {
+    hl = x[i] - x[i-1];
+    hr = x[i+1] - x[i];
+    c[i] = 3.0*((y[i+1] - y[i])/hr - (y[i] - y[i-1])/hl);
+    if (i == lo + 1) c[i] -= hl*c[lo];
+    if (i == hi - 1) c[i] -= hr*c[hi];
+    m = 2.0*(hl + hr) - (i > lo + 1 ? hl*g[i-1-lo] : 0.0);
+    g[i-lo] = hr/m;
+    c[i] = (c[i] - (i > lo + 1 ? hl*c[i-1] : 0.0))/m;
+  }
+  for (i = hi - 1; i > lo + 1; i--) c[i-1] -= g[i-1-lo]*c[i];
+  xfree(g);
+  for (i = lo; i < hi; i++) {
+    hr = x[i+1] - x[i];
+    b[i] = (y[i+1] - y[i])/hr - hr*(c[i+1] + 2.0*c[i])/3.0;
+    d[i] = (c[i+1] - c[i])/(3.0*hr);
+  }
+}
+
+/* Coefficients after points were added at the end (nadd) and dropped
+   at the start (ndrop); all of them when the window just became usable */
+static void window_update(mygsl_spline_window *w, size_t nadd, size_t ndrop)
+{
+  size_t n = w->n, nint = n - 1, lo;
+  if (n < w->min_size) return;
+  if (n - nadd < w->min_size) nadd = ndrop = n;
+  if (w->T == gsl_interp_linear) {
+    window_linear(w, nadd >= nint ? 0 : nint - nadd, nint);
+  } else if (w->T == gsl_interp_akima) {
+    window_akima(w, nadd + 2 >= nint ? 0 : nint - nadd - 2, nint);
+    if (ndrop > 0) window_akima(w, 0, GSL_MIN(2, nint));
+  } else {
+    lo = nadd + WINDOW_CSPLINE_SPAN >= n ? 0 : n - 1 - nadd - WINDOW_CSPLINE_SPAN;
+    window_cspline(w, lo, n - 1);
+    if (ndrop > 0 && lo > 0) window_cspline(w, 0, GSL_MIN(WINDOW_CSPLINE_SPAN, n - 1));
+  }
+}
+
+/* Appends the points, dropping the oldest beyond the capacity */
+static void window_push(mygsl_spline_window *w, const double *x, size_t xstride,
+			const double *y, size_t ystride, size_t np)
+{
+  size_t i, k, nadd = 0, ndrop = 0, keep;
+  double last = w->n > 0 ? WX(w, w->n - 1) : -GSL_POSINF;
+  for (i = 0; i < np; i++) {
+    if (!(x[i*xstride] > last))
+      rb_raise(rb_eArgError, "x values must be strictly increasing (%g after %g)",
+	       x[i*xstride], last);
+    last = x[i*xstride];
+  }
+  /* only the last cap of the new points can stay */
+  if (np > w->cap) {
+    x += (np - w->cap)*xstride;
+    y += (np - w->cap)*ystride;
+    np = w->cap;
+  }
+  for (i = 0; i < np; i++) {
+    if (w->n == w->cap) {
+      w->off++;
+      w->n--;
+      ndrop++;
+    }
+    if (w->off + w->n == 2*w->cap) {
+      keep = w->n;
+      memmove(w->x, w->x + w->off, keep*sizeof(double));
+      memmove(w->y, w->y + w->off, keep*sizeof(double));
+      memmove(w->b, w->b + w->off, keep*sizeof(double));
+      memmove(w->c, w->c + w->off, keep*sizeof(double));
+      memmove(w->d, w->d + w->off, keep*sizeof(double));
+      w->off = 0;
+    }
+    k = w->off + w->n;
+    w->x[k] = x[i*xstride];
+    w->y[k] = y[i*ystride];
+    w->b[k] = w->c[k] = w->d[k] = 0.0;
+    w->n++;
+    nadd++;
+  }
+  if (nadd >= w->n) ndrop = 0;
+  if (ndrop > 0 && w->cache >= ndrop) w->cache -= ndrop;
+  else w->cache = 0;
+  window_update(w, GSL_MIN(nadd, w->n), ndrop);
+}
+
+/* The interval of x, or -1 outside the window */
+static long window_find(mygsl_spline_window *w, double x)
+{
+  size_t j, last = w->n - 1;
+  if (!(x >= WX(w, 0) && x <= WX(w, last))) return -1;
+  j = w->cache < last ? w->cache : last - 1;
+  j = mygsl_interp_hunt(w->x + w->off, last, j, x);
+  w->cache = j;
+  return (long) j;
+}
+
+static double window_eval1(mygsl_spline_window *w, double x, int k, int *bad)
+{
+  long i = window_find(w, x);
+  size_t j;
+  double t;
+  if (i < 0) {
+    *bad = 1;
+    return GSL_NAN;
+  }
+  j = w->off + i;
+  t = x - w->x[j];
+  switch (k) {
+  case 0: return w->y[j] + t*(w->b[j] + t*(w->c[j] + t*w->d[j]));
+  case 1: return w->b[j] + t*(2.0*w->c[j] + 3.0*t*w->d[j]);
+  default: return 2.0*w->c[j] + 6.0*t*w->d[j];
+  }
+}
+
+static double window_integ1(const mygsl_spline_window *w, size_t j, double t0, double t1)
+{
+  double F0, F1;
+  F0 = t0*(w->y[j] + t0*(w->b[j]/2.0 + t0*(w->c[j]/3.0 + t0*w->d[j]/4.0)));
+  F1 = t1*(w->y[j] + t1*(w->b[j]/2.0 + t1*(w->c[j]/3.0 + t1*w->d[j]/4.0)));
+  return F1 - F0;
+}
+
+static mygsl_spline_window* window_get(VALUE obj)
+{
+  mygsl_spline_window *w = NULL;
+  Data_Get_Struct(obj, mygsl_spline_window, w);
+  return w;
+}
+
+static mygsl_spline_window* window_get_ready(VALUE obj)
+{
+  mygsl_spline_window *w = window_get(obj);
+  if (w->n < w->min_size)
+    rb_gsl_error_handler("insufficient number of points for interpolation type",
+			 __FILE__, __LINE__, GSL_EINVAL);
+  return w;
+}
+
+/*
+  GSL::Spline::Window.alloc(type, capacity[, xa, ya]):
+  type linear, cspline or akima
+*/
+static VALUE rb_gsl_spline_window_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_spline_window *w = NULL;
+  const gsl_interp_type *T;
+  size_t cap;
+  VALUE obj;
+  if (argc != 2 && argc != 4)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 4)", argc);
+  T = get_interp_type(argv[0]);
+  if (T != gsl_interp_linear && T != gsl_interp_cspline && T != gsl_interp_akima)
+    rb_raise(rb_eArgError, "%s is not available for a window (linear, cspline, akima)",
+	     T->name);
+  cap = NUM2SIZET(argv[1]);
+  w = ALLOC(mygsl_spline_window);
+  w->T = T;
+  w->min_size = T == gsl_interp_linear ? 2 : (T == gsl_interp_cspline ? 3 : 5);
+  if (cap < w->min_size) {
+    xfree(w);
+    rb_raise(rb_eArgError, "capacity %d is below the %d points of %s",
+	     (int) cap, (int) w->min_size, T->name);
+  }
+  w->cap = cap;
+  w->n = w->off = w->cache = 0;
+  w->x = ALLOC_N(double, 10*cap);
+  w->y = w->x + 2*cap;
+  w->b = w->y + 2*cap;
+  w->c = w->b + 2*cap;
+  w->d = w->c + 2*cap;
+  obj = Data_Wrap_Struct(klass, 0, mygsl_spline_window_free, w);
+  if (argc == 4) rb_funcall(obj, rb_intern("append"), 2, argv[2], argv[3]);
+  return obj;
+}
+
+/* push(x, y): appends one point */
+static VALUE rb_gsl_spline_window_push(VALUE obj, VALUE xx, VALUE yy)
+{
+  double x = NUM2DBL(rb_Float(xx)), y = NUM2DBL(rb_Float(yy));
+  window_push(window_get(obj), &x, 1, &y, 1, 1);
+  return obj;
+}
+
+/* w << [x, y] */
+static VALUE rb_gsl_spline_window_shift_left(VALUE obj, VALUE xy)
+{
+  Check_Type(xy, T_ARRAY);
+  if (RARRAY_LEN(xy) != 2) rb_raise(rb_eArgError, "[x, y] expected");
+  return rb_gsl_spline_window_push(obj, rb_ary_entry(xy, 0), rb_ary_entry(xy, 1));
+}
+
+/* append(xa, ya): the points of two Arrays or Vectors, in order */
+static VALUE rb_gsl_spline_window_append(VALUE obj, VALUE xxa, VALUE yya)
+{
+  double *xa, *ya;
+  size_t sx, sy, nx, ny;
+  gsl_vector *vx = NULL, *vy = NULL;
+  if (TYPE(xxa) == T_ARRAY) {
+    vx = make_cvector_from_rarray(xxa);
+    xxa = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vx);
+  }
+  if (TYPE(yya) == T_ARRAY) {
+    vy = make_cvector_from_rarray(yya);
+    yya = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vy);
+  }
+  xa = get_vector_ptr(xxa, &sx, &nx);
+  ya = get_vector_ptr(yya, &sy, &ny);
+  if (nx != ny) rb_raise(rb_eArgError, "size mismatch (xa:%d != ya:%d)", (int) nx, (int) ny);
+  window_push(window_get(obj), xa, sx, ya, sy, nx);
+  RB_GC_GUARD(xxa);
+  RB_GC_GUARD(yya);
+  return obj;
+}
+
+/* The value (k = 0) or a derivative at a Numeric, Array, Vector or Matrix */
+static VALUE rb_gsl_spline_window_evaluate(int argc, VALUE *argv, VALUE obj, int k)
+{
+  mygsl_spline_window *w;
+  gsl_vector *v = NULL;
+  gsl_matrix *m = NULL;
+  VALUE xx, out = Qnil, res, ary;
+  double *x, *optr = NULL, y;
+  size_t n1 = 1, n2, xstride = 1, xtda = 0, ostride, otda, i, j;
+  int is_ary = 0, bad = 0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  w = window_get_ready(obj);
+  xx = argv[0];
+  if (argc == 2) out = argv[1];
+  if (CLASS_OF(xx) == rb_cRange) xx = rb_gsl_range2ary(xx);
+  switch (TYPE(xx)) {
+  case T_FIXNUM:  case T_BIGNUM:  case T_FLOAT:
+    if (!NIL_P(out)) rb_raise(rb_eArgError, "output given for a single value");
+    y = window_eval1(w, NUM2DBL(xx), k, &bad);
+    if (bad) GSL_ERROR_VAL("interpolation error", GSL_EDOM, rb_float_new(y));
+    return rb_float_new(y);
+  case T_ARRAY:
+    v = make_cvector_from_rarray(xx);
+    xx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    is_ary = 1;
+    break;
+  default:
+    break;
+  }
+  if (VECTOR_P(xx)) {
+    Data_Get_Struct(xx, gsl_vector, v);
+    x = v->data; n2 = v->size; xstride = v->stride;
+  } else if (MATRIX_P(xx)) {
+    Data_Get_Struct(xx, gsl_matrix, m);
+    x = m->data; n1 = m->size1; n2 = m->size2; xtda = m->tda;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(xx)));
+  }
+  res = mygsl_interp_output(out, xx, n1, n2, &optr, &ostride, &otda);
+  for (i = 0; i < n1; i++)
+    for (j = 0; j < n2; j++)
+      optr[i*otda + j*ostride] = window_eval1(w, x[i*xtda + j*xstride], k, &bad);
+  if (is_ary && NIL_P(out)) {
+    ary = rb_ary_new2(n2);
+    for (j = 0; j < n2; j++) rb_ary_store(ary, j, rb_float_new(optr[j*ostride]));
+    res = ary;
+  }
+  RB_GC_GUARD(xx);
+  if (bad) GSL_ERROR_VAL("interpolation error", GSL_EDOM, res);
+  return res;
+}
+
+static VALUE rb_gsl_spline_window_eval(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_spline_window_evaluate(argc, argv, obj, 0);
+}
+
+static VALUE rb_gsl_spline_window_eval_deriv(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_spline_window_evaluate(argc, argv, obj, 1);
+}
+
+static VALUE rb_gsl_spline_window_eval_deriv2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_spline_window_evaluate(argc, argv, obj, 2);
+}
+
+static VALUE rb_gsl_spline_window_eval_integ(VALUE obj, VALUE aa, VALUE bb)
+{
+  mygsl_spline_window *w = window_get_ready(obj);
+  double a = NUM2DBL(rb_Float(aa)), b = NUM2DBL(rb_Float(bb)), s;
+  long i0, i1, i;
+  if (a > b)
+    GSL_ERROR_VAL("a must be less than or equal to b", GSL_EINVAL, rb_float_new(GSL_NAN));
+  i0 = window_find(w, a);
+  i1 = window_find(w, b);
+  if (i0 < 0 || i1 < 0) GSL_ERROR_VAL("interpolation error", GSL_EDOM, rb_float_new(GSL_NAN));
+  if (i0 == i1) return rb_float_new(window_integ1(w, w->off + i0, a - WX(w, i0), b - WX(w, i0)));
+  s = window_integ1(w, w->off + i0, a - WX(w, i0), WX(w, i0 + 1) - WX(w, i0));
+  for (i = i0 + 1; i < i1; i++)
+    s += window_integ1(w, w->off + i, 0.0, WX(w, i + 1) - WX(w, i));
+  s += window_integ1(w, w->off + i1, 0.0, b - WX(w, i1));
+  return rb_float_new(s);
+}
+
+/* The x (k = 0) or y values in the window, oldest first */
+static VALUE window_points(VALUE obj, int k)
+{
+  mygsl_spline_window *w = window_get(obj);
+  gsl_vector *v;
+  size_t i;
+  if (w->n == 0) return Qnil;
+  v = gsl_vector_alloc(w->n);
+  for (i = 0; i < w->n; i++) v->data[i] = k == 0 ? WX(w, i) : WY(w, i);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE rb_gsl_spline_window_xa(VALUE obj)
+{
+  return window_points(obj, 0);
+}
+
+static VALUE rb_gsl_spline_window_ya(VALUE obj)
+{
+  return window_points(obj, 1);
+}
+
+static VALUE rb_gsl_spline_window_xmin(VALUE obj)
+{
+  mygsl_spline_window *w = window_get(obj);
+  return w->n > 0 ? rb_float_new(WX(w, 0)) : Qnil;
+}
+
+static VALUE rb_gsl_spline_window_xmax(VALUE obj)
+{
+  mygsl_spline_window *w = window_get(obj);
+  return w->n > 0 ? rb_float_new(WX(w, w->n - 1)) : Qnil;
+}
+
+static VALUE rb_gsl_spline_window_size(VALUE obj)
+{
+  return SIZET2NUM(window_get(obj)->n);
+}
+
+static VALUE rb_gsl_spline_window_capacity(VALUE obj)
+{
+  return SIZET2NUM(window_get(obj)->cap);
+}
+
+static VALUE rb_gsl_spline_window_min_size(VALUE obj)
+{
+  return SIZET2NUM(window_get(obj)->min_size);
+}
+
+static VALUE rb_gsl_spline_window_name(VALUE obj)
+{
+  return rb_str_new2(window_get(obj)->T->name);
+}
+
+static VALUE rb_gsl_spline_window_clear(VALUE obj)
+{
+  mygsl_spline_window *w = window_get(obj);
+  w->n = w->off = w->cache = 0;
+  return obj;
+}
+
+void Init_gsl_spline_window(VALUE cgsl_spline)
+{
+  VALUE cwindow;
+  cwindow = rb_define_class_under(cgsl_spline, "Window", cGSL_Object);
+  rb_define_singleton_method(cwindow, "alloc", rb_gsl_spline_window_new, -1);
+  rb_define_method(cwindow, "push", rb_gsl_spline_window_push, 2);
+  rb_define_method(cwindow, "<<", rb_gsl_spline_window_shift_left, 1);
+  rb_define_method(cwindow, "append", rb_gsl_spline_window_append, 2);
+  rb_define_method(cwindow, "clear", rb_gsl_spline_window_clear, 0);
+  rb_define_method(cwindow, "eval", rb_gsl_spline_window_eval, -1);
+  rb_define_alias(cwindow, "[]", "eval");
+  rb_define_method(cwindow, "eval_deriv", rb_gsl_spline_window_eval_deriv, -1);
+  rb_define_alias(cwindow, "deriv", "eval_deriv");
+  rb_define_method(cwindow, "eval_deriv2", rb_gsl_spline_window_eval_deriv2, -1);
+  rb_define_alias(cwindow, "deriv2", "eval_deriv2");
+  rb_define_method(cwindow, "eval_integ", rb_gsl_spline_window_eval_integ, 2);
+  rb_define_alias(cwindow, "integ", "eval_integ");
+  rb_define_method(cwindow, "xa", rb_gsl_spline_window_xa, 0);
+  rb_define_method(cwindow, "ya", rb_gsl_spline_window_ya, 0);
+  rb_define_method(cwindow, "xmin", rb_gsl_spline_window_xmin, 0);
+  rb_define_method(cwindow, "xmax", rb_gsl_spline_window_xmax, 0);
+  rb_define_method(cwindow, "size", rb_gsl_spline_window_size, 0);
+  rb_define_method(cwindow, "capacity", rb_gsl_spline_window_capacity, 0);
+  rb_define_method(cwindow, "min_size", rb_gsl_spline_window_min_size, 0);
+  rb_define_method(cwindow, "name", rb_gsl_spline_window_name, 0);
+  rb_define_alias(cwindow, "type", "name");
+}
@@ -0,0 +1,704 @@
+/*
+  spmatrix.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::SpMatrix (gsl_spmatrix, GSL >= 2.0), GSL::SpBlas and the
+  GSL::SpLinalg GMRES solver.
+
+    a = GSL::SpMatrix.alloc(n, n)          # triplet (:coo) storage
+    a[i, j] = x                             # or SpMatrix.from_triplets
+    a = a.to_csr                            # or #to_csc
+    y = a*x                                 # SpMV with a GSL::Vector
+    c = a*b                                 # sparse times dense GSL::Matrix
+    x, iter, normr = GSL::SpLinalg.gmres(a, b, :tol => 1e-10)
+
+  The products are computed here rather than by gsl_spblas_dgemv, so that
+  every storage format and both transposes are supported.  A compressed
+  row (or transposed compressed column) SpMV is split by rows over
+  GSL.parallel_threads threads from GSL.parallel_threshold non-zeros on;
+  the GVL is released during products and GMRES iterations.
+*/
+
+#include "rb_gsl_config.h"
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_linalg.h"
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_spmatrix.h>
+#include <gsl/gsl_spblas.h>
+#ifdef HAVE_GSL_GSL_SPLINALG_H
+#include <gsl/gsl_splinalg.h>
+#endif
+
+#if defined(HAVE_GSL_SPMATRIX_CRS)
+#define mygsl_spmatrix_to_csr gsl_spmatrix_crs
+#define mygsl_spmatrix_to_csc gsl_spmatrix_ccs
+#elif defined(HAVE_GSL_SPMATRIX_COMPROW)
+#define mygsl_spmatrix_to_csr gsl_spmatrix_comprow
+#define mygsl_spmatrix_to_csc gsl_spmatrix_compcol
+#else
+#define mygsl_spmatrix_to_csc gsl_spmatrix_compcol
+#endif
+
+static VALUE cgsl_spmatrix;
+#ifdef HAVE_GSL_GSL_SPLINALG_H
+static VALUE cgsl_splinalg_gmres;
+#endif
+
+#define SPMATRIX_CSC_P(m) ((m)->sptype == GSL_SPMATRIX_CCS)
+#ifdef GSL_SPMATRIX_CRS
+#define SPMATRIX_CSR_P(m) ((m)->sptype == GSL_SPMATRIX_CRS)
+#else
+#define SPMATRIX_CSR_P(m) 0
+#endif
+
+int rb_gsl_spmatrix_p(VALUE obj)
+{
+  return cgsl_spmatrix && rb_obj_is_kind_of(obj, cgsl_spmatrix) ? 1 : 0;
+}
+
+gsl_spmatrix* rb_gsl_get_spmatrix(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_spmatrix))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::SpMatrix expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return m;
+}
+
+static VALUE rb_gsl_spmatrix_wrap(gsl_spmatrix *m)
+{
+  if (m == NULL) rb_raise(rb_eNoMemError, "gsl_spmatrix allocation failed");
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free, m);
+}
+
+static gsl_spmatrix* mygsl_spmatrix_clone(const gsl_spmatrix *m)
+{
+  gsl_spmatrix *mnew;
+  mnew = gsl_spmatrix_alloc_nzmax(m->size1, m->size2, GSL_MAX(m->nz, 1), m->sptype);
+  if (mnew == NULL) rb_raise(rb_eNoMemError, "gsl_spmatrix allocation failed");
+  gsl_spmatrix_memcpy(mnew, m);
+  return mnew;
+}
+
+/* A new compressed column copy of m, or NULL if m is already CSC */
+static gsl_spmatrix* mygsl_spmatrix_csc_or_null(const gsl_spmatrix *m)
+{
+  if (SPMATRIX_CSC_P(m)) return NULL;
+#ifdef mygsl_spmatrix_to_csr
+  if (SPMATRIX_CSR_P(m)) {
+    gsl_spmatrix *t, *c;
+    size_t r, k;
+    /* GSL compresses only triplets */
+    t = gsl_spmatrix_alloc_nzmax(m->size1, m->size2, GSL_MAX(m->nz, 1),
+				 GSL_SPMATRIX_TRIPLET);
+    for (r = 0; r < m->size1; r++)
+      for (k = m->p[r]; k < (size_t) m->p[r+1]; k++)
+	gsl_spmatrix_set(t, r, m->i[k], m->data[k]);
+    c = mygsl_spmatrix_to_csc(t);
+    gsl_spmatrix_free(t);
+    return c;
+  }
+#endif
+  return mygsl_spmatrix_to_csc(m);
+}
+
+/*
+  A size1 x size2 matrix whose row r holds the width values
+  val[r*width ...] from column start[r] on (a B-spline design matrix);
+  compressed rows where GSL has them, compressed columns otherwise
+*/
+VALUE rb_gsl_spmatrix_band_rows(size_t size1, size_t size2, size_t width,
+				const size_t *start, const double *val)
+{
+  gsl_spmatrix *m;
+  size_t r, j, nz = size1*width;
+  VALUE obj;
+#ifdef GSL_SPMATRIX_CRS
+  m = gsl_spmatrix_alloc_nzmax(size1, size2, GSL_MAX(nz, 1), GSL_SPMATRIX_CRS);
+  obj = rb_gsl_spmatrix_wrap(m);
+  for (r = 0; r < size1; r++) {
+    m->p[r] = r*width;
+    for (j = 0; j < width; j++) {
+      m->i[r*width + j] = start[r] + j;
+      m->data[r*width + j] = val[r*width + j];
+    }
+  }
+  m->p[size1] = nz;
+#else
+  size_t k, *next;
+  m = gsl_spmatrix_alloc_nzmax(size1, size2, GSL_MAX(nz, 1), GSL_SPMATRIX_CCS);
+  obj = rb_gsl_spmatrix_wrap(m);
+  next = ALLOC_N(size_t, size2 + 1);
+  for (j = 0; j <= size2; j++) m->p[j] = 0;
+  for (r = 0; r < size1; r++)
+    for (j = 0; j < width; j++) m->p[start[r] + j + 1]++;
+  for (j = 0; j < size2; j++) m->p[j+1] += m->p[j];
+  for (j = 0; j < size2; j++) next[j] = m->p[j];
+  for (r = 0; r < size1; r++)
+    for (j = 0; j < width; j++) {
+      k = next[start[r] + j]++;
+      m->i[k] = r;
+      m->data[k] = val[r*width + j];
+    }
+  xfree(next);
+#endif
+  m->nz = nz;
+  return obj;
+}
+
+/*****/
+
+/* GSL::SpMatrix.alloc(size1, size2[, nzmax]) */
+static VALUE rb_gsl_spmatrix_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  size_t nzmax;
+  switch (argc) {
+  case 2: nzmax = 16; break;
+  case 3: nzmax = NUM2SIZET(argv[2]); break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  }
+  return rb_gsl_spmatrix_wrap(gsl_spmatrix_alloc_nzmax(NUM2SIZET(argv[0]),
+						       NUM2SIZET(argv[1]),
+						       GSL_MAX(nzmax, 1),
+						       GSL_SPMATRIX_TRIPLET));
+}
+
+static size_t sp_index_at(VALUE ary, size_t k)
+{
+  gsl_vector_int *v = NULL;
+  if (VECTOR_INT_P(ary)) {
+    Data_Get_Struct(ary, gsl_vector_int, v);
+    return (size_t) gsl_vector_int_get(v, k);
+  }
+  return NUM2SIZET(rb_ary_entry(ary, k));
+}
+
+static size_t sp_length(VALUE ary)
+{
+  gsl_vector_int *vi = NULL;
+  gsl_vector *v = NULL;
+  if (VECTOR_INT_P(ary)) {
+    Data_Get_Struct(ary, gsl_vector_int, vi);
+    return vi->size;
+  }
+  if (VECTOR_P(ary)) {
+    Data_Get_Struct(ary, gsl_vector, v);
+    return v->size;
+  }
+  Check_Type(ary, T_ARRAY);
+  return RARRAY_LEN(ary);
+}
+
+/* GSL::SpMatrix.from_triplets(size1, size2, rows, cols, values) */
+static VALUE rb_gsl_spmatrix_from_triplets(VALUE klass, VALUE n1, VALUE n2,
+					   VALUE rows, VALUE cols, VALUE vals)
+{
+  gsl_spmatrix *m;
+  gsl_vector *v = NULL;
+  size_t n = sp_length(rows), k, i, j;
+  VALUE obj;
+  if (sp_length(cols) != n || sp_length(vals) != n)
+    rb_raise(rb_eArgError, "rows, cols and values must have the same length");
+  if (VECTOR_P(vals)) Data_Get_Struct(vals, gsl_vector, v);
+  m = gsl_spmatrix_alloc_nzmax(NUM2SIZET(n1), NUM2SIZET(n2), GSL_MAX(n, 1),
+			       GSL_SPMATRIX_TRIPLET);
+  obj = rb_gsl_spmatrix_wrap(m);
+  for (k = 0; k < n; k++) {
+    i = sp_index_at(rows, k);
+    j = sp_index_at(cols, k);
+    if (i >= m->size1 || j >= m->size2)
+      rb_raise(rb_eIndexError, "index (%d, %d) out of range", (int) i, (int) j);
+    gsl_spmatrix_set(m, i, j, v ? gsl_vector_get(v, k) : NUM2DBL(rb_ary_entry(vals, k)));
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_spmatrix_size1(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_get_spmatrix(obj)->size1);
+}
+
+static VALUE rb_gsl_spmatrix_size2(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_get_spmatrix(obj)->size2);
+}
+
+static VALUE rb_gsl_spmatrix_shape(VALUE obj)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj);
+  return rb_ary_new3(2, SIZET2NUM(m->size1), SIZET2NUM(m->size2));
+}
+
+static VALUE rb_gsl_spmatrix_nnz(VALUE obj)
+{
+  return SIZET2NUM(gsl_spmatrix_nnz(rb_gsl_get_spmatrix(obj)));
+}
+
+/* :coo (triplets), :csc or :csr */
+static VALUE rb_gsl_spmatrix_format(VALUE obj)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj);
+  if (SPMATRIX_CSC_P(m)) return ID2SYM(rb_intern("csc"));
+  if (SPMATRIX_CSR_P(m)) return ID2SYM(rb_intern("csr"));
+  return ID2SYM(rb_intern("coo"));
+}
+
+static VALUE rb_gsl_spmatrix_get(VALUE obj, VALUE i, VALUE j)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj);
+  size_t ii = NUM2SIZET(i), jj = NUM2SIZET(j);
+  if (ii >= m->size1 || jj >= m->size2)
+    rb_raise(rb_eIndexError, "index (%d, %d) out of range", (int) ii, (int) jj);
+  return rb_float_new(gsl_spmatrix_get(m, ii, jj));
+}
+
+static VALUE rb_gsl_spmatrix_set(VALUE obj, VALUE i, VALUE j, VALUE x)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj);
+  size_t ii = NUM2SIZET(i), jj = NUM2SIZET(j);
+  if (ii >= m->size1 || jj >= m->size2)
+    rb_raise(rb_eIndexError, "index (%d, %d) out of range", (int) ii, (int) jj);
+  gsl_spmatrix_set(m, ii, jj, NUM2DBL(x));
+  return x;
+}
+
+static VALUE rb_gsl_spmatrix_clone(VALUE obj)
+{
+  return rb_gsl_spmatrix_wrap(mygsl_spmatrix_clone(rb_gsl_get_spmatrix(obj)));
+}
+
+static VALUE rb_gsl_spmatrix_to_csc(VALUE obj)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj), *c;
+  c = mygsl_spmatrix_csc_or_null(m);
+  return rb_gsl_spmatrix_wrap(c ? c : mygsl_spmatrix_clone(m));
+}
+
+static VALUE rb_gsl_spmatrix_to_csr(VALUE obj)
+{
+#ifdef mygsl_spmatrix_to_csr
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj), *t, *c;
+  size_t j, k;
+  if (SPMATRIX_CSR_P(m)) return rb_gsl_spmatrix_wrap(mygsl_spmatrix_clone(m));
+  if (!SPMATRIX_CSC_P(m)) return rb_gsl_spmatrix_wrap(mygsl_spmatrix_to_csr(m));
+  t = gsl_spmatrix_alloc_nzmax(m->size1, m->size2, GSL_MAX(m->nz, 1),
+			       GSL_SPMATRIX_TRIPLET);
+  for (j = 0; j < m->size2; j++)
+    for (k = m->p[j]; k < (size_t) m->p[j+1]; k++)
+      gsl_spmatrix_set(t, m->i[k], j, m->data[k]);
+  c = mygsl_spmatrix_to_csr(t);
+  gsl_spmatrix_free(t);
+  return rb_gsl_spmatrix_wrap(c);
+#else
+  rb_raise(rb_eNotImpError, "compressed row storage needs GSL 2.2 or later");
+  return Qnil;
+#endif
+}
+
+static VALUE rb_gsl_spmatrix_transpose(VALUE obj)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj), *t;
+  t = gsl_spmatrix_alloc_nzmax(m->size2, m->size1, GSL_MAX(m->nz, 1), m->sptype);
+  if (t == NULL) rb_raise(rb_eNoMemError, "gsl_spmatrix allocation failed");
+  gsl_spmatrix_transpose_memcpy(t, m);
+  return rb_gsl_spmatrix_wrap(t);
+}
+
+static VALUE rb_gsl_spmatrix_to_m(VALUE obj)
+{
+  gsl_spmatrix *m = rb_gsl_get_spmatrix(obj);
+  gsl_matrix *d = gsl_matrix_alloc(m->size1, m->size2);
+  gsl_spmatrix_sp2d(d, m);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, d);
+}
+
+/* GSL::Matrix#to_sp: the non-zero elements as triplets */
+static VALUE rb_gsl_matrix_to_sp(VALUE obj)
+{
+  gsl_matrix *d = NULL;
+  gsl_spmatrix *m;
+  Data_Get_Struct(obj, gsl_matrix, d);
+  m = gsl_spmatrix_alloc(d->size1, d->size2);
+  if (m == NULL) rb_raise(rb_eNoMemError, "gsl_spmatrix allocation failed");
+  gsl_spmatrix_d2sp(m, d);
+  return rb_gsl_spmatrix_wrap(m);
+}
+
+static VALUE rb_gsl_spmatrix_scale_bang(VALUE obj, VALUE x)
+{
+  gsl_spmatrix_scale(rb_gsl_get_spmatrix(obj), NUM2DBL(x));
+  return obj;
+}
+
+/*****
+  Products
+*****/
+
+struct spmv_task {
+  const gsl_spmatrix *A;
+  int trans;
+  double alpha;
+  const double *x;
+  size_t sx;
+  double *y;
+  size_t sy;
+  size_t nouter, nthreads;
+};
+
+/* y[r] += alpha sum_k A[r, i[k]] x[i[k]] for rows of CSR, columns of CSC */
+static int spmv_gather(void *data, size_t t)
+{
+  struct spmv_task *s = (struct spmv_task *) data;
+  const gsl_spmatrix *A = s->A;
+  size_t r, k, r0 = t*s->nouter/s->nthreads, r1 = (t + 1)*s->nouter/s->nthreads;
+  double sum;
+  for (r = r0; r < r1; r++) {
+    sum = 0.0;
+    for (k = A->p[r]; k < (size_t) A->p[r+1]; k++)
+      sum += A->data[k]*s->x[(size_t) A->i[k]*s->sx];
+    s->y[r*s->sy] += s->alpha*sum;
+  }
+  return GSL_SUCCESS;
+}
+
+static int spmv_gather_serial(void *data)
+{
+  return spmv_gather(data, 0);
+}
+
+/* The other orientations scatter into y, serially */
+static int spmv_scatter(void *data)
+{
+  struct spmv_task *s = (struct spmv_task *) data;
+  const gsl_spmatrix *A = s->A;
+  size_t c, k, r;
+  double xc;
+  if (SPMATRIX_CSC_P(A) || SPMATRIX_CSR_P(A)) {
+    for (c = 0; c < s->nouter; c++) {
+      xc = s->alpha*s->x[c*s->sx];
+      for (k = A->p[c]; k < (size_t) A->p[c+1]; k++)
+	s->y[(size_t) A->i[k]*s->sy] += A->data[k]*xc;
+    }
+    return GSL_SUCCESS;
+  }
+  for (k = 0; k < A->nz; k++) {
+    r = A->i[k]; c = A->p[k];
+    if (s->trans) { size_t tmp = r; r = c; c = tmp; }
+    s->y[r*s->sy] += s->alpha*A->data[k]*s->x[c*s->sx];
+  }
+  return GSL_SUCCESS;
+}
+
+/* y = alpha op(A) x + beta y */
+static int mygsl_spblas_dgemv(int trans, double alpha, const gsl_spmatrix *A,
+			      const gsl_vector *x, double beta, gsl_vector *y)
+{
+  struct spmv_task s;
+  size_t n1 = trans ? A->size2 : A->size1, n2 = trans ? A->size1 : A->size2;
+  int gather;
+  if (x->size != n2 || y->size != n1)
+    GSL_ERROR("invalid length", GSL_EBADLEN);
+  if (beta == 0.0) gsl_vector_set_zero(y);
+  else if (beta != 1.0) gsl_vector_scale(y, beta);
+  if (alpha == 0.0) return GSL_SUCCESS;
+  s.A = A; s.trans = trans; s.alpha = alpha;
+  s.x = x->data; s.sx = x->stride;
+  s.y = y->data; s.sy = y->stride;
+  gather = (SPMATRIX_CSR_P(A) && !trans) || (SPMATRIX_CSC_P(A) && trans);
+  if (SPMATRIX_CSR_P(A)) s.nouter = A->size1;
+  else if (SPMATRIX_CSC_P(A)) s.nouter = A->size2;
+  else s.nouter = 0;
+  if (gather) {
+    s.nthreads = rb_gsl_parallel_nthreads(A->nz, s.nouter);
+    if (s.nthreads > 1) return rb_gsl_nogvl_parallel(spmv_gather, &s, s.nthreads);
+    s.nthreads = 1;
+    return rb_gsl_nogvl_call(spmv_gather_serial, &s, A->nz);
+  }
+  return rb_gsl_nogvl_call(spmv_scatter, &s, A->nz);
+}
+
+/* C = A B, B dense: row r of C accumulates A[r,c] times row c of B */
+static gsl_matrix* mygsl_spmatrix_mul_dense(const gsl_spmatrix *A, const gsl_matrix *B)
+{
+  gsl_matrix *C;
+  gsl_vector_view cr;
+  gsl_vector_const_view bc;
+  size_t o, k, r, c;
+  if (A->size2 != B->size1)
+    rb_raise(rb_eRangeError, "matrix sizes are different (%d x %d, %d x %d)",
+	     (int) A->size1, (int) A->size2, (int) B->size1, (int) B->size2);
+  C = gsl_matrix_calloc(A->size1, B->size2);
+  if (SPMATRIX_CSR_P(A) || SPMATRIX_CSC_P(A)) {
+    for (o = 0; o < (SPMATRIX_CSR_P(A) ? A->size1 : A->size2); o++) {
+      for (k = A->p[o]; k < (size_t) A->p[o+1]; k++) {
+	r = SPMATRIX_CSR_P(A) ? o : (size_t) A->i[k];
+	c = SPMATRIX_CSR_P(A) ? (size_t) A->i[k] : o;
+	cr = gsl_matrix_row(C, r);
+	bc = gsl_matrix_const_row(B, c);
+	gsl_blas_daxpy(A->data[k], &bc.vector, &cr.vector);
+      }
+    }
+  } else {
+    for (k = 0; k < A->nz; k++) {
+      cr = gsl_matrix_row(C, A->i[k]);
+      bc = gsl_matrix_const_row(B, A->p[k]);
+      gsl_blas_daxpy(A->data[k], &bc.vector, &cr.vector);
+    }
+  }
+  return C;
+}
+
+/* A*x (Vector), A*B (Matrix, dense result; SpMatrix, CSC result), A*c */
+static VALUE rb_gsl_spmatrix_mul(VALUE obj, VALUE other)
+{
+  gsl_spmatrix *A = rb_gsl_get_spmatrix(obj), *B, *Ac, *Bc, *C;
+  gsl_vector *x = NULL, *y;
+  gsl_matrix *M = NULL;
+  if (VECTOR_P(other)) {
+    Data_Get_Struct(other, gsl_vector, x);
+    y = gsl_vector_alloc(A->size1);
+    mygsl_spblas_dgemv(0, 1.0, A, x, 0.0, y);
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+  }
+  if (MATRIX_P(other)) {
+    Data_Get_Struct(other, gsl_matrix, M);
+    return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free,
+			    mygsl_spmatrix_mul_dense(A, M));
+  }
+  if (rb_obj_is_kind_of(other, cgsl_spmatrix)) {
+    B = rb_gsl_get_spmatrix(other);
+    Ac = mygsl_spmatrix_csc_or_null(A);
+    Bc = mygsl_spmatrix_csc_or_null(B);
+    C = gsl_spmatrix_alloc_nzmax(A->size1, B->size2, 1, GSL_SPMATRIX_CCS);
+    gsl_spblas_dgemm(1.0, Ac ? Ac : A, Bc ? Bc : B, C);
+    if (Ac) gsl_spmatrix_free(Ac);
+    if (Bc) gsl_spmatrix_free(Bc);
+    return rb_gsl_spmatrix_wrap(C);
+  }
+  C = mygsl_spmatrix_clone(A);
+  gsl_spmatrix_scale(C, NUM2DBL(other));
+  return rb_gsl_spmatrix_wrap(C);
+}
+
+/* GSL::SpBlas.dgemv(trans, alpha, A, x[, beta, y]); y is overwritten
+   when given, otherwise a new vector is returned */
+static VALUE rb_gsl_spblas_dgemv(int argc, VALUE *argv, VALUE module)
+{
+  gsl_spmatrix *A;
+  gsl_vector *x = NULL, *y = NULL;
+  double beta = 0.0;
+  int trans;
+  VALUE vy;
+  if (argc != 4 && argc != 6)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 4 or 6)", argc);
+  trans = FIX2INT(argv[0]) != CblasNoTrans;
+  A = rb_gsl_get_spmatrix(argv[2]);
+  CHECK_VECTOR(argv[3]);
+  Data_Get_Struct(argv[3], gsl_vector, x);
+  if (argc == 6) {
+    beta = NUM2DBL(argv[4]);
+    CHECK_VECTOR(argv[5]);
+    Data_Get_Struct(argv[5], gsl_vector, y);
+    vy = argv[5];
+  } else {
+    y = gsl_vector_alloc(trans ? A->size2 : A->size1);
+    vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+  }
+  mygsl_spblas_dgemv(trans, NUM2DBL(argv[1]), A, x, beta, y);
+  return vy;
+}
+
+/*****
+  Iterative solvers
+*****/
+#ifdef HAVE_GSL_GSL_SPLINALG_H
+
+/* GSL::SpLinalg::GMRES.alloc(n[, m]), m the restart (0: GSL's default) */
+static VALUE rb_gsl_splinalg_gmres_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_splinalg_itersolve *w;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  w = gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, NUM2SIZET(argv[0]),
+				   argc == 2 ? NUM2SIZET(argv[1]) : 0);
+  if (w == NULL) rb_raise(rb_eNoMemError, "gsl_splinalg_itersolve_alloc failed");
+  return Data_Wrap_Struct(klass, 0, gsl_splinalg_itersolve_free, w);
+}
+
+struct gmres_task {
+  const gsl_spmatrix *A;
+  const gsl_vector *b;
+  gsl_vector *x;
+  gsl_splinalg_itersolve *w;
+  double tol;
+  size_t max_iter, iter;
+};
+
+static int gmres_run(void *data)
+{
+  struct gmres_task *t = (struct gmres_task *) data;
+  int status = GSL_CONTINUE;
+  for (t->iter = 0; t->iter < t->max_iter && status == GSL_CONTINUE; t->iter++)
+    status = gsl_splinalg_itersolve_iterate(t->A, t->b, t->tol, t->x, t->w);
+  return status;
+}
+
+/* One solver run of up to max_iter calls; returns the status */
+static int mygsl_gmres(gsl_splinalg_itersolve *w, const gsl_spmatrix *A,
+		       const gsl_vector *b, double tol, gsl_vector *x,
+		       size_t max_iter, size_t *iter)
+{
+  struct gmres_task t;
+  gsl_spmatrix *Ac = NULL;
+  int status;
+  if (A->size1 != A->size2) GSL_ERROR("matrix must be square", GSL_ENOTSQR);
+  Ac = mygsl_spmatrix_csc_or_null(A);
+  t.A = Ac ? Ac : A; t.b = b; t.x = x; t.w = w; t.tol = tol;
+  t.max_iter = max_iter;
+  status = rb_gsl_nogvl_call(gmres_run, &t, A->nz*max_iter);
+  if (Ac) gsl_spmatrix_free(Ac);
+  *iter = t.iter;
+  return status;
+}
+
+/* GMRES#iterate(A, b, tol, x): status (GSL::SUCCESS or GSL::CONTINUE) */
+static VALUE rb_gsl_splinalg_gmres_iterate(VALUE obj, VALUE A, VALUE b, VALUE tol,
+					   VALUE x)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  gsl_vector *vb = NULL, *vx = NULL;
+  size_t iter;
+  Data_Get_Struct(obj, gsl_splinalg_itersolve, w);
+  CHECK_VECTOR(b); CHECK_VECTOR(x);
+  Data_Get_Struct(b, gsl_vector, vb);
+  Data_Get_Struct(x, gsl_vector, vx);
+  return INT2FIX(mygsl_gmres(w, rb_gsl_get_spmatrix(A), vb, NUM2DBL(tol), vx, 1, &iter));
+}
+
+static VALUE rb_gsl_splinalg_gmres_normr(VALUE obj)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  Data_Get_Struct(obj, gsl_splinalg_itersolve, w);
+  return rb_float_new(gsl_splinalg_itersolve_normr(w));
+}
+
+static VALUE rb_gsl_splinalg_gmres_name(VALUE obj)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  Data_Get_Struct(obj, gsl_splinalg_itersolve, w);
+  return rb_str_new2(gsl_splinalg_itersolve_name(w));
+}
+
+/*
+  GSL::SpLinalg.gmres(A, b[, opts]) -> [x, iterations, residual norm]
+  Options: :tol (1e-10), :max_iter (1000), :restart (GSL's default),
+  :x0 (initial guess, default zero; not modified).
+*/
+static VALUE rb_gsl_splinalg_gmres(int argc, VALUE *argv, VALUE module)
+{
+  gsl_spmatrix *A;
+  gsl_vector *b = NULL, *x, *x0 = NULL;
+  gsl_splinalg_itersolve *w;
+  VALUE opts = Qnil, v, vx;
+  double tol = 1e-10, normr;
+  size_t max_iter = 1000, restart = 0, iter;
+  switch (argc) {
+  case 3:
+    opts = argv[2];
+    Check_Type(opts, T_HASH);
+    /* no break */
+  case 2:
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  }
+  A = rb_gsl_get_spmatrix(argv[0]);
+  if (A->size1 != A->size2) rb_raise(rb_eArgError, "matrix must be square");
+  CHECK_VECTOR(argv[1]);
+  Data_Get_Struct(argv[1], gsl_vector, b);
+  if (!NIL_P(opts)) {
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("tol"))))) tol = NUM2DBL(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("max_iter"))))) max_iter = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("restart"))))) restart = NUM2SIZET(v);
+    if (!NIL_P(v = rb_hash_aref(opts, ID2SYM(rb_intern("x0"))))) {
+      CHECK_VECTOR(v);
+      Data_Get_Struct(v, gsl_vector, x0);
+    }
+  }
+  x = gsl_vector_calloc(A->size2);
+  vx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+  if (x0) gsl_vector_memcpy(x, x0);
+  w = gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, A->size1, restart);
+  if (w == NULL) rb_raise(rb_eNoMemError, "gsl_splinalg_itersolve_alloc failed");
+  mygsl_gmres(w, A, b, tol, x, max_iter, &iter);
+  normr = gsl_splinalg_itersolve_normr(w);
+  gsl_splinalg_itersolve_free(w);
+  return rb_ary_new3(3, vx, SIZET2NUM(iter), rb_float_new(normr));
+}
+#endif
+
+void Init_gsl_spmatrix(VALUE module)
+{
+  VALUE mgsl_spblas;
+#ifdef HAVE_GSL_GSL_SPLINALG_H
+  VALUE mgsl_splinalg;
+#endif
+
+  cgsl_spmatrix = rb_define_class_under(module, "SpMatrix", cGSL_Object);
+  rb_define_singleton_method(cgsl_spmatrix, "alloc", rb_gsl_spmatrix_alloc, -1);
+  rb_define_singleton_method(cgsl_spmatrix, "new", rb_gsl_spmatrix_alloc, -1);
+  rb_define_singleton_method(cgsl_spmatrix, "from_triplets",
+			     rb_gsl_spmatrix_from_triplets, 5);
+
+  rb_define_method(cgsl_spmatrix, "size1", rb_gsl_spmatrix_size1, 0);
+  rb_define_method(cgsl_spmatrix, "size2", rb_gsl_spmatrix_size2, 0);
+  rb_define_method(cgsl_spmatrix, "shape", rb_gsl_spmatrix_shape, 0);
+  rb_define_alias(cgsl_spmatrix, "size", "shape");
+  rb_define_method(cgsl_spmatrix, "nnz", rb_gsl_spmatrix_nnz, 0);
+  rb_define_method(cgsl_spmatrix, "format", rb_gsl_spmatrix_format, 0);
+  rb_define_method(cgsl_spmatrix, "get", rb_gsl_spmatrix_get, 2);
+  rb_define_alias(cgsl_spmatrix, "[]", "get");
+  rb_define_method(cgsl_spmatrix, "set", rb_gsl_spmatrix_set, 3);
+  rb_define_alias(cgsl_spmatrix, "[]=", "set");
+  rb_define_method(cgsl_spmatrix, "clone", rb_gsl_spmatrix_clone, 0);
+  rb_define_alias(cgsl_spmatrix, "dup", "clone");
+  rb_define_method(cgsl_spmatrix, "to_csc", rb_gsl_spmatrix_to_csc, 0);
+  rb_define_alias(cgsl_spmatrix, "ccs", "to_csc");
+  rb_define_method(cgsl_spmatrix, "to_csr", rb_gsl_spmatrix_to_csr, 0);
+  rb_define_alias(cgsl_spmatrix, "crs", "to_csr");
+  rb_define_method(cgsl_spmatrix, "transpose", rb_gsl_spmatrix_transpose, 0);
+  rb_define_alias(cgsl_spmatrix, "trans", "transpose");
+  rb_define_method(cgsl_spmatrix, "to_m", rb_gsl_spmatrix_to_m, 0);
+  rb_define_alias(cgsl_spmatrix, "to_dense", "to_m");
+  rb_define_method(cgsl_spmatrix, "scale!", rb_gsl_spmatrix_scale_bang, 1);
+  rb_define_method(cgsl_spmatrix, "*", rb_gsl_spmatrix_mul, 1);
+  rb_define_alias(cgsl_spmatrix, "mul", "*");
+
+  rb_define_method(cgsl_matrix, "to_sp", rb_gsl_matrix_to_sp, 0);
+
+  mgsl_spblas = rb_define_module_under(module, "SpBlas");
+  rb_define_module_function(mgsl_spblas, "dgemv", rb_gsl_spblas_dgemv, -1);
+
+#ifdef HAVE_GSL_GSL_SPLINALG_H
+  mgsl_splinalg = rb_define_module_under(module, "SpLinalg");
+  rb_define_module_function(mgsl_splinalg, "gmres", rb_gsl_splinalg_gmres, -1);
+  cgsl_splinalg_gmres = rb_define_class_under(mgsl_splinalg, "GMRES", cGSL_Object);
+  rb_define_singleton_method(cgsl_splinalg_gmres, "alloc",
+			     rb_gsl_splinalg_gmres_alloc, -1);
+  rb_define_method(cgsl_splinalg_gmres, "iterate", rb_gsl_splinalg_gmres_iterate, 4);
+  rb_define_method(cgsl_splinalg_gmres, "normr", rb_gsl_splinalg_gmres_normr, 0);
+  rb_define_method(cgsl_splinalg_gmres, "name", rb_gsl_splinalg_gmres_name, 0);
+#endif
+}
+#endif
@@ -31,6 +31,86 @@ static double* get_vector_stats2(int argc, VALUE *argv, VALUE obj,
   return v;
 }
 
+/*
+  Moments computed with the pairwise, possibly threaded reductions of
+  reduce.c (mean first, then the sum of squared or absolute deviations),
+  in place of the gsl_stats_ recurrences; same signatures.
+*/
+static double mygsl_stats_mean(const double *data, size_t stride, size_t n)
+{
+  return mygsl_reduce(data, stride, n, MYGSL_REDUCE_SUM, 0.0)/n;
+}
+
+static double mygsl_stats_tss_m(const double *data, size_t stride, size_t n,
+				double mean)
+{
+  return mygsl_reduce(data, stride, n, MYGSL_REDUCE_SUMSQ, mean);
+}
+
+static double mygsl_stats_variance_m(const double *data, size_t stride, size_t n,
+				     double mean)
+{
+  return mygsl_stats_tss_m(data, stride, n, mean)/(n - 1);
+}
+
+static double mygsl_stats_variance(const double *data, size_t stride, size_t n)
+{
+  return mygsl_stats_variance_m(data, stride, n, mygsl_stats_mean(data, stride, n));
+}
+
+static double mygsl_stats_sd_m(const double *data, size_t stride, size_t n,
+			       double mean)
+{
+  return sqrt(mygsl_stats_variance_m(data, stride, n, mean));
+}
+
+static double mygsl_stats_sd(const double *data, size_t stride, size_t n)
+{
+  return sqrt(mygsl_stats_variance(data, stride, n));
+}
+
+#ifdef GSL_1_11_LATER
+static double mygsl_stats_tss(const double *data, size_t stride, size_t n)
+{
+  return mygsl_stats_tss_m(data, stride, n, mygsl_stats_mean(data, stride, n));
+}
+#endif
+
+static double mygsl_stats_variance_with_fixed_mean(const double *data, size_t stride,
+						   size_t n, double mean)
+{
+  return mygsl_stats_tss_m(data, stride, n, mean)/n;
+}
+
+static double mygsl_stats_sd_with_fixed_mean(const double *data, size_t stride,
+					     size_t n, double mean)
+{
+  return sqrt(mygsl_stats_variance_with_fixed_mean(data, stride, n, mean));
+}
+
+static double mygsl_stats_absdev_m(const double *data, size_t stride, size_t n,
+				   double mean)
+{
+  return mygsl_reduce(data, stride, n, MYGSL_REDUCE_ABSDEV, mean)/n;
+}
+
+static double mygsl_stats_absdev(const double *data, size_t stride, size_t n)
+{
+  return mygsl_stats_absdev_m(data, stride, n, mygsl_stats_mean(data, stride, n));
+}
+
+static void mygsl_stats_minmax_index(double *min, double *max, size_t *imin,
+				     size_t *imax, const double *data,
+				     size_t stride, size_t n)
+{
+  if (n > 0) {
+    mygsl_reduce_minmax(data, stride, n, min, max, imin, imax);
+    return;
+  }
+  gsl_stats_minmax(min, max, data, stride, n);
+  gsl_stats_minmax_index(imin, imax, data, stride, n);
+}
+
 static VALUE rb_gsl_stats_XXX(int argc, VALUE *argv, VALUE obj,
 			      double (*f)(const double*, size_t, size_t))
 {
@@ -97,7 +177,7 @@ static VALUE rb_gsl_stats_XXX2(int argc, VALUE *argv, VALUE obj,
 
 static VALUE rb_gsl_stats_mean(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_stats_XXX(argc, argv, obj, gsl_stats_mean);
+  return rb_gsl_stats_XXX(argc, argv, obj, mygsl_stats_mean);
 }
 
 static VALUE rb_gsl_stats_XXX_m(int argc, VALUE *argv, VALUE obj,
@@ -148,20 +228,20 @@ static VALUE rb_gsl_stats_XXX_m(int argc, VALUE *argv, VALUE obj,
 static VALUE rb_gsl_stats_variance_m(int argc, VALUE *argv, VALUE obj)
 {
   return rb_gsl_stats_XXX_m(argc, argv, obj,
-			    gsl_stats_variance, gsl_stats_variance_m);
+			    mygsl_stats_variance, mygsl_stats_variance_m);
 }
 
 static VALUE rb_gsl_stats_sd_m(int argc, VALUE *argv, VALUE obj)
 {
   return rb_gsl_stats_XXX_m(argc, argv, obj,
-			    gsl_stats_sd, gsl_stats_sd_m);
+			    mygsl_stats_sd, mygsl_stats_sd_m);
 }
 
 #ifdef GSL_1_11_LATER
 static VALUE rb_gsl_stats_tss_m(int argc, VALUE *argv, VALUE obj)
 {
   return rb_gsl_stats_XXX_m(argc, argv, obj,
-			    gsl_stats_tss, gsl_stats_tss_m);
+			    mygsl_stats_tss, mygsl_stats_tss_m);
 }
 #endif
 
@@ -169,20 +249,20 @@ static VALUE rb_gsl_stats_variance_with_fixed_mean(int argc, VALUE *argv,
 						   VALUE obj)
 {
   return rb_gsl_stats_XXX1(argc, argv, obj,
-			   gsl_stats_variance_with_fixed_mean);
+			   mygsl_stats_variance_with_fixed_mean);
 }
 
 static VALUE rb_gsl_stats_sd_with_fixed_mean(int argc, VALUE *argv, 
 						   VALUE obj)
 {
   return rb_gsl_stats_XXX1(argc, argv, obj,
-			   gsl_stats_sd_with_fixed_mean);
+			   mygsl_stats_sd_with_fixed_mean);
 }
 
 static VALUE rb_gsl_stats_absdev_m(int argc, VALUE *argv, VALUE obj)
 {
   return rb_gsl_stats_XXX_m(argc, argv, obj,
-			    gsl_stats_absdev, gsl_stats_absdev_m);
+			    mygsl_stats_absdev, mygsl_stats_absdev_m);
 }
 
 static VALUE rb_gsl_stats_skew(int argc, VALUE *argv, 
@@ -333,18 +413,19 @@ static VALUE rb_gsl_stats_wkurtosis_m_sd(VALUE obj, VALUE ww, VALUE wm, VALUE ws
 static VALUE rb_gsl_stats_max(int argc, VALUE *argv, VALUE obj)
 {
   size_t stride, size;
-  double max, *data = NULL;
+  double min, max, *data = NULL;
+  size_t imin, imax;
   data = get_vector_stats2(argc, argv, obj, &stride, &size);
-  max = gsl_stats_max(data, stride, size);
+  mygsl_stats_minmax_index(&min, &max, &imin, &imax, data, stride, size);
   return rb_float_new(max);
 }
 
 static VALUE rb_gsl_stats_min(int argc, VALUE *argv, VALUE obj)
 {
-  double min, *data = NULL;
-  size_t stride, size;
+  double min, max, *data = NULL;
+  size_t stride, size, imin, imax;
   data = get_vector_stats2(argc, argv, obj, &stride, &size);
-  min = gsl_stats_min(data, stride, size);
+  mygsl_stats_minmax_index(&min, &max, &imin, &imax, data, stride, size);
   return rb_float_new(min);
 }
 
@@ -352,35 +433,36 @@ static VALUE rb_gsl_stats_minmax(int argc, VALUE *argv, VALUE obj)
 {
   size_t stride, size;
   double min, max, *data = NULL;
+  size_t imin, imax;
   data = get_vector_stats2(argc, argv, obj, &stride, &size);
-  gsl_stats_minmax(&min, &max, data, stride, size);
+  mygsl_stats_minmax_index(&min, &max, &imin, &imax, data, stride, size);
   return rb_ary_new3(2, rb_float_new(min), rb_float_new(max));
 }
 
 static VALUE rb_gsl_stats_max_index(int argc, VALUE *argv, VALUE obj)
 {
-  double *data = NULL;
-  size_t index, stride, size;
+  double min, max, *data = NULL;
+  size_t imin, imax, stride, size;
   data = get_vector_stats2(argc, argv, obj, &stride, &size);
-  index = gsl_stats_max_index(data, stride, size);
-  return INT2FIX(index);
+  mygsl_stats_minmax_index(&min, &max, &imin, &imax, data, stride, size);
+  return INT2FIX(imax);
 }
 
 static VALUE rb_gsl_stats_min_index(int argc, VALUE *argv, VALUE obj)
 {
-  double *data = NULL;
-  size_t index, stride, size;
+  double min, max, *data = NULL;
+  size_t imin, imax, stride, size;
   data = get_vector_stats2(argc, argv, obj, &stride, &size);
-  index = gsl_stats_min_index(data, stride, size);
-  return INT2FIX(index);
+  mygsl_stats_minmax_index(&min, &max, &imin, &imax, data, stride, size);
+  return INT2FIX(imin);
 }
 
 static VALUE rb_gsl_stats_minmax_index(int argc, VALUE *argv, VALUE obj)
 {
-  double *data = NULL;
+  double min, max, *data = NULL;
   size_t imin, imax, stride, size;
   data = get_vector_stats2(argc, argv, obj, &stride, &size);
-  gsl_stats_minmax_index(&imin, &imax, data, stride, size);
+  mygsl_stats_minmax_index(&min, &max, &imin, &imax, data, stride, size);
   return rb_ary_new3(2, INT2FIX(imin), INT2FIX(imax));
 }
 
@@ -631,6 +713,573 @@ static VALUE rb_gsl_stats_wkurtosis_m2(VALUE obj, VALUE ww, VALUE dd, VALUE mm,
   return rb_float_new(wkurtosis);
 }
 
+/*
+  Summary statistics in one pass over the data:
+
+    s = GSL::Stats.summary(v[, w])  # or v.summary([w])
+    s.mean; s.variance; s.sd; s.skew; s.kurtosis; s.min; s.max
+    m.summary(:cols)                # one Summary per column
+
+  The moments come from mygsl_reduce_moments() (reduce.c) and follow the
+  definitions of the gsl_stats_ (or gsl_stats_w-) functions, so
+  s.skew == v.skew and s.variance == v.variance up to rounding.
+*/
+static VALUE cgsl_stats_summary;
+
+static VALUE rb_gsl_stats_summary_new(const mygsl_moments *r, size_t n, int weighted)
+{
+  double var, sd, skew, kurt, sw;
+  sw = weighted ? r->sw : (double) n;
+  if (weighted) var = r->sw/(r->sw*r->sw - r->sw2)*r->m2;
+  else var = n > 1 ? r->m2/(n - 1) : GSL_NAN;
+  sd = sqrt(var);
+  skew = (r->m3/sw)/(var*sd);
+  kurt = (r->m4/sw)/(var*var) - 3.0;
+  return rb_struct_new(cgsl_stats_summary, SIZET2NUM(n),
+		       rb_float_new(r->mean), rb_float_new(var), rb_float_new(sd),
+		       rb_float_new(skew), rb_float_new(kurt),
+		       rb_float_new(r->min), rb_float_new(r->max));
+}
+
+static VALUE rb_gsl_stats_summary(int argc, VALUE *argv, VALUE obj)
+{
+  double *x, *w = NULL;
+  size_t stridex, sizex, stridew = 1, sizew;
+  mygsl_moments r;
+  int iw;
+  x = get_vector_stats2(argc, argv, obj, &stridex, &sizex);
+  switch (TYPE(obj)) {
+  case T_MODULE:  case T_CLASS:  case T_OBJECT:
+    if (argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+    iw = 1;
+    break;
+  default:
+    if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+    iw = 0;
+    break;
+  }
+  if (argc > iw && !NIL_P(argv[iw])) {
+    w = get_vector_ptr(argv[iw], &stridew, &sizew);
+    if (sizew != sizex) rb_raise(rb_eArgError, "weights and data have different lengths");
+  }
+  if (sizex == 0) rb_raise(rb_eArgError, "empty data");
+  mygsl_reduce_moments(x, stridex, w, stridew, sizex, &r);
+  return rb_gsl_stats_summary_new(&r, sizex, w != NULL);
+}
+
+static VALUE rb_gsl_matrix_summary(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *m = NULL, *mtmp = NULL;
+  mygsl_moments r;
+  VALUE ary;
+  ID axis = 0;
+  size_t i, n;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1 && !NIL_P(argv[0])) {
+    if (!SYMBOL_P(argv[0])) rb_raise(rb_eTypeError, "axis must be nil, :rows or :cols");
+    axis = SYM2ID(argv[0]);
+    if (axis != rb_intern("rows") && axis != rb_intern("cols"))
+      rb_raise(rb_eArgError, "axis must be nil, :rows or :cols");
+  }
+  Data_Get_Struct(obj, gsl_matrix, m);
+  if (m->size1 == 0 || m->size2 == 0) rb_raise(rb_eArgError, "empty matrix");
+  if (axis == rb_intern("rows")) {
+    ary = rb_ary_new2(m->size1);
+    for (i = 0; i < m->size1; i++) {
+      mygsl_reduce_moments(m->data + i*m->tda, 1, NULL, 1, m->size2, &r);
+      rb_ary_store(ary, i, rb_gsl_stats_summary_new(&r, m->size2, 0));
+    }
+    return ary;
+  } else if (axis == rb_intern("cols")) {
+    ary = rb_ary_new2(m->size2);
+    for (i = 0; i < m->size2; i++) {
+      mygsl_reduce_moments(m->data + i, m->tda, NULL, 1, m->size1, &r);
+      rb_ary_store(ary, i, rb_gsl_stats_summary_new(&r, m->size1, 0));
+    }
+    return ary;
+  }
+  /* a view with tda > size2 is not one strided run; reduce a packed copy */
+  n = m->size1*m->size2;
+  if (m->tda != m->size2) m = mtmp = make_matrix_clone(m);
+  mygsl_reduce_moments(m->data, 1, NULL, 1, n, &r);
+  if (mtmp) gsl_matrix_free(mtmp);
+  return rb_gsl_stats_summary_new(&r, n, 0);
+}
+
+/*
+  Sums, means, variances and standard deviations of a matrix, of all
+  its elements or along an axis (see rb_gsl_axis_opts):
+
+    m.mean                  # a Float
+    m.mean(:axis => 0)      # column means, a GSL::Vector
+    m.sd(1)                 # row sd's, a GSL::Vector::Col
+    m.sum(:axis => 0, :out => v)
+
+  Columns are reduced in one row-major sweep (mygsl_reduce_axis), not
+  through a view per column.
+*/
+enum {
+  MATRIX_STATS_SUM,
+  MATRIX_STATS_MEAN,
+  MATRIX_STATS_VARIANCE,
+  MATRIX_STATS_SD,
+};
+
+static VALUE rb_gsl_matrix_stats(int argc, VALUE *argv, VALUE obj, int kind)
+{
+  gsl_matrix *m = NULL, *mtmp = NULL;
+  gsl_vector *v = NULL;
+  VALUE vout, vret;
+  double *c, sum, mean, ss;
+  size_t n, nin, nout, k;
+  int axis;
+  axis = rb_gsl_axis_opts(argc, argv, &vout);
+  Data_Get_Struct(obj, gsl_matrix, m);
+  if (m->size1 == 0 || m->size2 == 0) rb_raise(rb_eArgError, "empty matrix");
+  if (axis < 0) {
+    if (!NIL_P(vout)) rb_raise(rb_eArgError, ":out needs an axis");
+    n = m->size1*m->size2;
+    if (m->tda != m->size2) m = mtmp = make_matrix_clone(m);
+    sum = mygsl_reduce(m->data, 1, n, MYGSL_REDUCE_SUM, 0.0);
+    mean = sum/n;
+    ss = kind >= MATRIX_STATS_VARIANCE ?
+      mygsl_reduce(m->data, 1, n, MYGSL_REDUCE_SUMSQ, mean) : 0.0;
+    if (mtmp) gsl_matrix_free(mtmp);
+    switch (kind) {
+    case MATRIX_STATS_SUM: return rb_float_new(sum);
+    case MATRIX_STATS_MEAN: return rb_float_new(mean);
+    case MATRIX_STATS_VARIANCE: return rb_float_new(ss/(n - 1));
+    default: return rb_float_new(sqrt(ss/(n - 1)));
+    }
+  }
+  nout = axis == 0 ? m->size2 : m->size1;
+  nin = axis == 0 ? m->size1 : m->size2;
+  if (NIL_P(vout)) {
+    v = gsl_vector_alloc(nout);
+    vret = Data_Wrap_Struct(axis == 0 ? cgsl_vector : cgsl_vector_col, 0,
+			    gsl_vector_free, v);
+  } else {
+    CHECK_VECTOR(vout);
+    Data_Get_Struct(vout, gsl_vector, v);
+    if (v->size != nout) rb_raise(rb_eArgError, "out has length %d, should be %d",
+				 (int) v->size, (int) nout);
+    vret = vout;
+  }
+  mygsl_reduce_axis(m, axis, MYGSL_REDUCE_SUM, NULL, v->data, v->stride, NULL);
+  if (kind == MATRIX_STATS_SUM) return vret;
+  for (k = 0; k < nout; k++) v->data[k*v->stride] /= nin;
+  if (kind == MATRIX_STATS_MEAN) return vret;
+  c = ALLOC_N(double, nout);
+  for (k = 0; k < nout; k++) c[k] = v->data[k*v->stride];
+  mygsl_reduce_axis(m, axis, MYGSL_REDUCE_SUMSQ, c, v->data, v->stride, NULL);
+  xfree(c);
+  for (k = 0; k < nout; k++) {
+    v->data[k*v->stride] /= (nin - 1);
+    if (kind == MATRIX_STATS_SD) v->data[k*v->stride] = sqrt(v->data[k*v->stride]);
+  }
+  return vret;
+}
+
+static VALUE rb_gsl_matrix_stats_sum(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_stats(argc, argv, obj, MATRIX_STATS_SUM);
+}
+
+static VALUE rb_gsl_matrix_stats_mean(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_stats(argc, argv, obj, MATRIX_STATS_MEAN);
+}
+
+static VALUE rb_gsl_matrix_stats_variance(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_stats(argc, argv, obj, MATRIX_STATS_VARIANCE);
+}
+
+static VALUE rb_gsl_matrix_stats_sd(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_stats(argc, argv, obj, MATRIX_STATS_SD);
+}
+
+/*
+  Covariance and correlation matrices of the columns of a matrix, its
+  rows being the observations:
+
+    c = m.covariance_matrix                  # p x p
+    r = m.correlation_matrix(:weights => w)  # one weight per row
+    m.covariance_matrix(:missing => :pairwise)
+
+  The columns are centered once, and all the pairs then come from one
+  dsyrk of the centered data (times sqrt(w)): the normalization is that
+  of GSL::Stats.covariance, 1/(n - 1), and with weights that of
+  GSL::Stats.wvariance, sw/(sw^2 - sw2).  With :missing => :pairwise, a
+  pair is computed over the rows where both values are not NaN: with
+  M the mask of the present values and Z the (centered) data, 0 where
+  it is missing, the sums of every pair are the products M'WM, M'W^2M,
+  Z'WM, Z'WZ and (Z.*Z)'WM (dsyrk and dgemm).  The products are made
+  with the GVL released.
+*/
+typedef struct {
+  const gsl_matrix *X;
+  const double *w;
+  size_t wstride;
+  int pairwise, corr;
+  double *buf;                  /* 2p */
+  gsl_matrix *Z, *M, *T;        /* n x p; M and T pairwise only */
+  gsl_matrix *C, *S, *SW, *SW2; /* p x p; S, SW and SW2 pairwise only */
+} mygsl_covariance;
+
+/* Z = sqrt(w)(X - mean), the means over the present values; pairwise,
+   M = sqrt(w) where present and Z = M = 0 where missing */
+static void mygsl_covariance_center(mygsl_covariance *c)
+{
+  const gsl_matrix *X = c->X;
+  size_t n = X->size1, p = X->size2, r, j;
+  double *mean = c->buf, *sw = c->buf + p, x, wr;
+  for (j = 0; j < p; j++) mean[j] = sw[j] = 0.0;
+  for (r = 0; r < n; r++) {
+    wr = c->w ? c->w[r*c->wstride] : 1.0;
+    for (j = 0; j < p; j++) {
+      x = X->data[r*X->tda + j];
+      if (c->pairwise && gsl_isnan(x)) continue;
+      mean[j] += wr*x;
+      sw[j] += wr;
+    }
+  }
+  for (j = 0; j < p; j++) mean[j] /= sw[j];
+  for (r = 0; r < n; r++) {
+    wr = c->w ? sqrt(c->w[r*c->wstride]) : 1.0;
+    for (j = 0; j < p; j++) {
+      x = X->data[r*X->tda + j];
+      if (c->pairwise && gsl_isnan(x)) {
+	c->Z->data[r*p + j] = 0.0;
+	c->M->data[r*p + j] = 0.0;
+      } else {
+	c->Z->data[r*p + j] = wr*(x - mean[j]);
+	if (c->pairwise) c->M->data[r*p + j] = wr;
+      }
+    }
+  }
+}
+
+/* C = A'A, for the n x p A: its lower triangle, then mirrored */
+static void mygsl_covariance_syrk(const gsl_matrix *A, gsl_matrix *C)
+{
+  size_t i, j;
+  gsl_blas_dsyrk(CblasLower, CblasTrans, 1.0, A, 0.0, C);
+  for (i = 0; i < C->size1; i++)
+    for (j = i + 1; j < C->size2; j++) C->data[i*C->tda + j] = C->data[j*C->tda + i];
+}
+
+static int mygsl_covariance_complete(void *data)
+{
+  mygsl_covariance *c = (mygsl_covariance *) data;
+  gsl_matrix *C = c->C;
+  size_t n = c->X->size1, p = C->size1, r, i, j;
+  double sw = 0.0, sw2 = 0.0, wr, *d = c->buf;
+  mygsl_covariance_center(c);
+  mygsl_covariance_syrk(c->Z, C);
+  if (!c->corr) {
+    for (r = 0; r < n; r++) {
+      wr = c->w ? c->w[r*c->wstride] : 1.0;
+      sw += wr;
+      sw2 += wr*wr;
+    }
+    gsl_matrix_scale(C, sw/(sw*sw - sw2));
+    return GSL_SUCCESS;
+  }
+  for (i = 0; i < p; i++) d[i] = sqrt(C->data[i*C->tda + i]);
+  for (i = 0; i < p; i++) {
+    for (j = 0; j < p; j++) C->data[i*C->tda + j] /= d[i]*d[j];
+    if (d[i] > 0.0) C->data[i*C->tda + i] = 1.0;
+  }
+  return GSL_SUCCESS;
+}
+
+static int mygsl_covariance_pairwise(void *data)
+{
+  mygsl_covariance *c = (mygsl_covariance *) data;
+  gsl_matrix *C = c->C, *S = c->S, *SW = c->SW, *SW2 = c->SW, *Q = c->SW2;
+  size_t np = c->Z->size1*c->Z->size2, p = C->size1, i, j, k;
+  double sij, sji, sw, vi, vj, *cij;
+  mygsl_covariance_center(c);
+  /* the weights, products and sums of the present pairs */
+  mygsl_covariance_syrk(c->M, SW);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, c->Z, c->M, 0.0, S);
+  mygsl_covariance_syrk(c->Z, C);
+  if (c->corr) {
+    /* Q = (Z.*Z)'(M != 0): the sums of squares of i over the rows with j */
+    for (k = 0; k < np; k++) {
+      c->T->data[k] = c->M->data[k] != 0.0 ? 1.0 : 0.0;
+      c->Z->data[k] *= c->Z->data[k];
+    }
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, c->Z, c->T, 0.0, Q);
+  } else if (c->w) {
+    /* SW2 = M'W^2M */
+    for (k = 0; k < np; k++) c->T->data[k] = c->M->data[k]*c->M->data[k];
+    SW2 = c->SW2;
+    mygsl_covariance_syrk(c->T, SW2);
+  }
+  for (i = 0; i < p; i++) {
+    for (j = 0; j <= i; j++) {
+      sw = SW->data[i*SW->tda + j];
+      sij = S->data[i*S->tda + j];
+      sji = S->data[j*S->tda + i];
+      cij = C->data + i*C->tda + j;
+      *cij -= sij*sji/sw;
+      if (c->corr) {
+	vi = Q->data[i*Q->tda + j] - sij*sij/sw;
+	vj = Q->data[j*Q->tda + i] - sji*sji/sw;
+	*cij = i == j && vi > 0.0 ? 1.0 : *cij/sqrt(vi*vj);
+      } else {
+	*cij *= sw/(sw*sw - SW2->data[i*SW2->tda + j]);
+      }
+      C->data[j*C->tda + i] = *cij;
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/* Matrix#covariance_matrix(opts = {}), #correlation_matrix(opts = {}) */
+static VALUE rb_gsl_matrix_covariance(int argc, VALUE *argv, VALUE obj, int corr)
+{
+  mygsl_covariance c;
+  VALUE opts = Qnil, vw = Qnil, vmiss = Qnil, vc;
+  size_t n, p, nw = 0;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) opts = argv[0];
+  memset(&c, 0, sizeof(c));
+  if (!NIL_P(opts)) {
+    Check_Type(opts, T_HASH);
+    vw = rb_hash_aref(opts, ID2SYM(rb_intern("weights")));
+    vmiss = rb_hash_aref(opts, ID2SYM(rb_intern("missing")));
+  }
+  if (!NIL_P(vmiss)) {
+    if (vmiss != ID2SYM(rb_intern("pairwise")))
+      rb_raise(rb_eArgError, ":missing must be nil or :pairwise");
+    c.pairwise = 1;
+  }
+  Data_Get_Struct(obj, gsl_matrix, c.X);
+  n = c.X->size1;
+  p = c.X->size2;
+  if (n < 2 || p == 0) rb_raise(rb_eArgError, "at least 2 rows and 1 column are needed");
+  if (!NIL_P(vw)) {
+    c.w = get_vector_ptr(vw, &c.wstride, &nw);
+    if (nw != n) rb_raise(rb_eArgError, "%d weights for %d rows", (int) nw, (int) n);
+  }
+  c.corr = corr;
+  c.C = gsl_matrix_alloc(p, p);
+  vc = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, c.C);
+  c.buf = ALLOC_N(double, 2*p);
+  c.Z = gsl_matrix_alloc(n, p);
+  if (c.pairwise) {
+    c.M = gsl_matrix_alloc(n, p);
+    c.S = gsl_matrix_alloc(p, p);
+    c.SW = gsl_matrix_alloc(p, p);
+    if (corr || c.w) {
+      c.T = gsl_matrix_alloc(n, p);
+      c.SW2 = gsl_matrix_alloc(p, p);
+    }
+    rb_gsl_nogvl_call(mygsl_covariance_pairwise, &c, n*p*p);
+  } else {
+    rb_gsl_nogvl_call(mygsl_covariance_complete, &c, n*p*p);
+  }
+  xfree(c.buf);
+  gsl_matrix_free(c.Z);
+  if (c.M) gsl_matrix_free(c.M);
+  if (c.T) gsl_matrix_free(c.T);
+  if (c.S) gsl_matrix_free(c.S);
+  if (c.SW) gsl_matrix_free(c.SW);
+  if (c.SW2) gsl_matrix_free(c.SW2);
+  RB_GC_GUARD(vw);
+  return vc;
+}
+
+static VALUE rb_gsl_matrix_covariance_matrix(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_covariance(argc, argv, obj, 0);
+}
+
+static VALUE rb_gsl_matrix_correlation_matrix(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_matrix_covariance(argc, argv, obj, 1);
+}
+
+/*
+  Mergeable running statistics, for data that arrive in pieces:
+
+    r = GSL::Stats::Running.new
+    r.push(x); r.push_vector(v[, w])
+    r.merge!(other)                 # e.g. partial results of workers
+    r.mean; r.variance; r.skew; r.summary
+
+  Only the moments are kept (no data); merging uses the same update as
+  the blocked reduction, so an accumulator fed in pieces agrees with
+  GSL::Stats.summary of the concatenated data up to rounding.
+  gsl_rstat cannot be merged, so it is not used here.
+*/
+typedef struct {
+  size_t n;
+  mygsl_moments m;
+} mygsl_running;
+
+static VALUE cgsl_stats_running;
+
+static void mygsl_running_reset(mygsl_running *r)
+{
+  r->n = 0;
+  r->m.sw = r->m.sw2 = 0.0;
+  r->m.mean = r->m.m2 = r->m.m3 = r->m.m4 = 0.0;
+  r->m.min = GSL_POSINF;
+  r->m.max = GSL_NEGINF;
+}
+
+static mygsl_running* get_running(VALUE obj)
+{
+  mygsl_running *r = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_stats_running))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Stats::Running expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_running, r);
+  return r;
+}
+
+static VALUE rb_gsl_stats_running_alloc(VALUE klass)
+{
+  mygsl_running *r = NULL;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_running, 0, free, r);
+  mygsl_running_reset(r);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_running_init_copy(VALUE obj, VALUE orig)
+{
+  if (obj == orig) return obj;
+  *get_running(obj) = *get_running(orig);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_running_reset(VALUE obj)
+{
+  mygsl_running_reset(get_running(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_stats_running_push(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_running *r = get_running(obj);
+  mygsl_moments b;
+  double x, w = 1.0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  x = NUM2DBL(argv[0]);
+  if (argc == 2) w = NUM2DBL(argv[1]);
+  b.sw = w; b.sw2 = w*w;
+  b.mean = x; b.m2 = b.m3 = b.m4 = 0.0;
+  b.min = b.max = x;
+  mygsl_moments_merge(&r->m, &b);
+  r->n++;
+  return obj;
+}
+
+static VALUE rb_gsl_stats_running_lshift(VALUE obj, VALUE x)
+{
+  return rb_gsl_stats_running_push(1, &x, obj);
+}
+
+static VALUE rb_gsl_stats_running_push_vector(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_running *r = get_running(obj);
+  mygsl_moments b;
+  double *x, *w = NULL;
+  size_t stridex, sizex, stridew = 1, sizew;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  x = get_vector_ptr(argv[0], &stridex, &sizex);
+  if (argc == 2 && !NIL_P(argv[1])) {
+    w = get_vector_ptr(argv[1], &stridew, &sizew);
+    if (sizew != sizex) rb_raise(rb_eArgError, "weights and data have different lengths");
+  }
+  if (sizex == 0) return obj;
+  mygsl_reduce_moments(x, stridex, w, stridew, sizex, &b);
+  mygsl_moments_merge(&r->m, &b);
+  r->n += sizex;
+  return obj;
+}
+
+static VALUE rb_gsl_stats_running_merge_bang(VALUE obj, VALUE other)
+{
+  mygsl_running *r = get_running(obj), *o = get_running(other);
+  mygsl_running b = *o;
+  mygsl_moments_merge(&r->m, &b.m);
+  r->n += b.n;
+  return obj;
+}
+
+static VALUE rb_gsl_stats_running_merge(VALUE obj, VALUE other)
+{
+  return rb_gsl_stats_running_merge_bang(rb_obj_dup(obj), other);
+}
+
+static VALUE rb_gsl_stats_running_n(VALUE obj)
+{
+  return SIZET2NUM(get_running(obj)->n);
+}
+
+static VALUE rb_gsl_stats_running_sum_weights(VALUE obj)
+{
+  return rb_float_new(get_running(obj)->m.sw);
+}
+
+static VALUE rb_gsl_stats_running_summary(VALUE obj)
+{
+  mygsl_running *r = get_running(obj);
+  mygsl_moments m = r->m;
+  if (r->n == 0) m.mean = m.min = m.max = GSL_NAN;
+  return rb_gsl_stats_summary_new(&m, r->n, 1);
+}
+
+static VALUE rb_gsl_stats_running_mean(VALUE obj)
+{
+  mygsl_running *r = get_running(obj);
+  return rb_float_new(r->n == 0 ? GSL_NAN : r->m.mean);
+}
+
+static VALUE rb_gsl_stats_running_variance(VALUE obj)
+{
+  return rb_struct_aref(rb_gsl_stats_running_summary(obj), INT2FIX(2));
+}
+
+static VALUE rb_gsl_stats_running_sd(VALUE obj)
+{
+  return rb_struct_aref(rb_gsl_stats_running_summary(obj), INT2FIX(3));
+}
+
+static VALUE rb_gsl_stats_running_skew(VALUE obj)
+{
+  return rb_struct_aref(rb_gsl_stats_running_summary(obj), INT2FIX(4));
+}
+
+static VALUE rb_gsl_stats_running_kurtosis(VALUE obj)
+{
+  return rb_struct_aref(rb_gsl_stats_running_summary(obj), INT2FIX(5));
+}
+
+static VALUE rb_gsl_stats_running_min(VALUE obj)
+{
+  mygsl_running *r = get_running(obj);
+  return rb_float_new(r->n == 0 ? GSL_NAN : r->m.min);
+}
+
+static VALUE rb_gsl_stats_running_max(VALUE obj)
+{
+  mygsl_running *r = get_running(obj);
+  return rb_float_new(r->n == 0 ? GSL_NAN : r->m.max);
+}
+
+void Init_gsl_stats_quantile(VALUE module);
+void Init_gsl_stats_rolling(VALUE module);
+
 void Init_gsl_stats(VALUE module)
 {
   VALUE mgsl_stats;
@@ -797,4 +1446,43 @@ void Init_gsl_stats(VALUE module)
   rb_define_alias(cgsl_vector, "quantile_from_sorted_data", 
 		  "stats_quantile_from_sorted_data");
 
+  cgsl_stats_summary = rb_struct_define(NULL, "size", "mean", "variance", "sd",
+					"skew", "kurtosis", "min", "max", NULL);
+  rb_define_const(mgsl_stats, "Summary", cgsl_stats_summary);
+  rb_define_singleton_method(mgsl_stats, "summary", rb_gsl_stats_summary, -1);
+  rb_define_method(cgsl_vector, "stats_summary", rb_gsl_stats_summary, -1);
+  rb_define_alias(cgsl_vector, "summary", "stats_summary");
+  rb_define_method(cgsl_matrix, "summary", rb_gsl_matrix_summary, -1);
+  rb_define_method(cgsl_matrix, "sum", rb_gsl_matrix_stats_sum, -1);
+  rb_define_method(cgsl_matrix, "mean", rb_gsl_matrix_stats_mean, -1);
+  rb_define_method(cgsl_matrix, "variance", rb_gsl_matrix_stats_variance, -1);
+  rb_define_alias(cgsl_matrix, "var", "variance");
+  rb_define_method(cgsl_matrix, "sd", rb_gsl_matrix_stats_sd, -1);
+  rb_define_method(cgsl_matrix, "covariance_matrix", rb_gsl_matrix_covariance_matrix, -1);
+  rb_define_method(cgsl_matrix, "correlation_matrix", rb_gsl_matrix_correlation_matrix, -1);
+
+  cgsl_stats_running = rb_define_class_under(mgsl_stats, "Running", cGSL_Object);
+  rb_define_alloc_func(cgsl_stats_running, rb_gsl_stats_running_alloc);
+  rb_define_method(cgsl_stats_running, "initialize_copy", rb_gsl_stats_running_init_copy, 1);
+  rb_define_method(cgsl_stats_running, "reset", rb_gsl_stats_running_reset, 0);
+  rb_define_method(cgsl_stats_running, "push", rb_gsl_stats_running_push, -1);
+  rb_define_method(cgsl_stats_running, "<<", rb_gsl_stats_running_lshift, 1);
+  rb_define_method(cgsl_stats_running, "push_vector", rb_gsl_stats_running_push_vector, -1);
+  rb_define_method(cgsl_stats_running, "merge!", rb_gsl_stats_running_merge_bang, 1);
+  rb_define_method(cgsl_stats_running, "merge", rb_gsl_stats_running_merge, 1);
+  rb_define_method(cgsl_stats_running, "n", rb_gsl_stats_running_n, 0);
+  rb_define_alias(cgsl_stats_running, "size", "n");
+  rb_define_method(cgsl_stats_running, "sum_weights", rb_gsl_stats_running_sum_weights, 0);
+  rb_define_method(cgsl_stats_running, "summary", rb_gsl_stats_running_summary, 0);
+  rb_define_method(cgsl_stats_running, "mean", rb_gsl_stats_running_mean, 0);
+  rb_define_method(cgsl_stats_running, "variance", rb_gsl_stats_running_variance, 0);
+  rb_define_method(cgsl_stats_running, "sd", rb_gsl_stats_running_sd, 0);
+  rb_define_method(cgsl_stats_running, "skew", rb_gsl_stats_running_skew, 0);
+  rb_define_method(cgsl_stats_running, "kurtosis", rb_gsl_stats_running_kurtosis, 0);
+  rb_define_method(cgsl_stats_running, "min", rb_gsl_stats_running_min, 0);
+  rb_define_method(cgsl_stats_running, "max", rb_gsl_stats_running_max, 0);
+
+  Init_gsl_stats_quantile(mgsl_stats);
+  Init_gsl_stats_rolling(mgsl_stats);
+
 }
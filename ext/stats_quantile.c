@@ -0,0 +1,574 @@
+/*
+  stats_quantile.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Quantile estimators in constant memory, for data too large to sort.
+
+    p2 = GSL::Stats::P2.new(0.99)       # a single quantile
+    p2.push(x); p2.push_vector(v)
+    p2.quantile
+
+    td = GSL::Stats::TDigest.new(100)   # compression
+    td.push(x[, w]); td.push_vector(v)
+    td.merge!(other)
+    td.quantile(0.5); td.quantile([0.9, 0.99]); td.cdf(x)
+
+  P2 is the P-square algorithm of Jain and Chlamtac (CACM 28, 1985), as
+  in gsl_rstat_quantile: five markers, adjusted by piecewise parabolic
+  interpolation.  It tracks one fixed quantile and cannot be merged.
+
+  TDigest is Dunning's merging t-digest: the data are summarized by at
+  most ~compression weighted centroids, small near q = 0 and q = 1 (the
+  k1 scale function); the error in rank of quantile(q) is of the order
+  of sqrt(q(1 - q))/compression.  New points go to a buffer sorted and
+  merged into the centroids when it fills, so digests built apart can be
+  merged with each other.  NaNs are ignored by both estimators.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_statistics.h"
+
+static VALUE cgsl_stats_p2, cgsl_stats_tdigest;
+
+/*****/
+
+typedef struct {
+  double p;
+  size_t n;
+  double q[5], pos[5], want[5], dwant[5];
+} mygsl_p2;
+
+static void mygsl_p2_init(mygsl_p2 *s, double p)
+{
+  s->p = p;
+  s->n = 0;
+  s->dwant[0] = 0.0;
+  s->dwant[1] = 0.5*p;
+  s->dwant[2] = p;
+  s->dwant[3] = 0.5*(1.0 + p);
+  s->dwant[4] = 1.0;
+}
+
+static int mygsl_dcmp(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void mygsl_p2_add(mygsl_p2 *s, double x)
+{
+  double d, qp, dn, *q = s->q, *pos = s->pos;
+  size_t i, k;
+  int ds;
+  if (gsl_isnan(x)) return;
+  if (s->n < 5) {
+    q[s->n++] = x;
+    if (s->n == 5) {
+      qsort(q, 5, sizeof(double), mygsl_dcmp);
+      for (i = 0; i < 5; i++) {
+	pos[i] = (double) i;
+	s->want[i] = 4.0*s->dwant[i];
+      }
+    }
+    return;
+  }
+  if (x < q[0]) {
+    q[0] = x;
+    k = 0;
+  } else if (x >= q[4]) {
+    q[4] = x;
+    k = 3;
+  } else {
+    for (k = 0; k < 3 && x >= q[k+1]; k++);
+  }
+  for (i = k + 1; i < 5; i++) pos[i] += 1.0;
+  for (i = 0; i < 5; i++) s->want[i] += s->dwant[i];
+  for (i = 1; i < 4; i++) {
+    d = s->want[i] - pos[i];
+    if ((d >= 1.0 && pos[i+1] - pos[i] > 1.0)
+	|| (d <= -1.0 && pos[i-1] - pos[i] < -1.0)) {
+      ds = d > 0.0 ? 1 : -1;
+      dn = (double) ds;
+      qp = q[i] + dn/(pos[i+1] - pos[i-1])
+	*((pos[i] - pos[i-1] + dn)*(q[i+1] - q[i])/(pos[i+1] - pos[i])
+	  + (pos[i+1] - pos[i] - dn)*(q[i] - q[i-1])/(pos[i] - pos[i-1]));
+      if (q[i-1] < qp && qp < q[i+1]) q[i] = qp;
+      else q[i] += dn*(q[i+ds] - q[i])/(pos[i+ds] - pos[i]);
+      pos[i] += dn;
+    }
+  }
+  s->n++;
+}
+
+static double mygsl_p2_get(const mygsl_p2 *s)
+{
+  double tmp[5];
+  if (s->n == 0) return GSL_NAN;
+  if (s->n >= 5) return s->q[2];
+  memcpy(tmp, s->q, s->n*sizeof(double));
+  qsort(tmp, s->n, sizeof(double), mygsl_dcmp);
+  return gsl_stats_quantile_from_sorted_data(tmp, 1, s->n, s->p);
+}
+
+static mygsl_p2* get_p2(VALUE obj)
+{
+  mygsl_p2 *s = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_stats_p2))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Stats::P2 expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_p2, s);
+  return s;
+}
+
+static VALUE rb_gsl_stats_p2_alloc(VALUE klass)
+{
+  mygsl_p2 *s = NULL;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_p2, 0, free, s);
+  mygsl_p2_init(s, 0.5);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_p2_initialize(int argc, VALUE *argv, VALUE obj)
+{
+  double p = 0.5;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) p = NUM2DBL(argv[0]);
+  if (!(p >= 0.0 && p <= 1.0)) rb_raise(rb_eArgError, "quantile must be in [0, 1]");
+  mygsl_p2_init(get_p2(obj), p);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_p2_init_copy(VALUE obj, VALUE orig)
+{
+  if (obj == orig) return obj;
+  *get_p2(obj) = *get_p2(orig);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_p2_reset(VALUE obj)
+{
+  mygsl_p2 *s = get_p2(obj);
+  mygsl_p2_init(s, s->p);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_p2_push(VALUE obj, VALUE x)
+{
+  mygsl_p2_add(get_p2(obj), NUM2DBL(x));
+  return obj;
+}
+
+static VALUE rb_gsl_stats_p2_push_vector(VALUE obj, VALUE vv)
+{
+  mygsl_p2 *s = get_p2(obj);
+  double *x;
+  size_t stride, size, i;
+  x = get_vector_ptr(vv, &stride, &size);
+  for (i = 0; i < size; i++) mygsl_p2_add(s, x[i*stride]);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_p2_n(VALUE obj)
+{
+  return SIZET2NUM(get_p2(obj)->n);
+}
+
+static VALUE rb_gsl_stats_p2_p(VALUE obj)
+{
+  return rb_float_new(get_p2(obj)->p);
+}
+
+static VALUE rb_gsl_stats_p2_quantile(VALUE obj)
+{
+  return rb_float_new(mygsl_p2_get(get_p2(obj)));
+}
+
+/*****/
+
+typedef struct {
+  double mean, w;
+} mygsl_centroid;
+
+typedef struct {
+  double compression;
+  size_t ncent, nbuf, capcent, capbuf;
+  double total, min, max;
+  size_t n;
+  int reverse;          /* direction of the next merge pass */
+  mygsl_centroid *c;    /* ncent centroids, then nbuf buffered points */
+} mygsl_tdigest;
+
+static void mygsl_tdigest_free(mygsl_tdigest *t)
+{
+  if (t->c) xfree(t->c);
+  free(t);
+}
+
+static void mygsl_tdigest_init(mygsl_tdigest *t, double compression)
+{
+  t->compression = compression;
+  t->capcent = (size_t) ceil(compression) + 8;
+  t->capbuf = 5*t->capcent;
+  t->ncent = t->nbuf = t->n = 0;
+  t->reverse = 0;
+  t->total = 0.0;
+  t->min = GSL_POSINF;
+  t->max = GSL_NEGINF;
+  if (t->c) xfree(t->c);
+  t->c = ALLOC_N(mygsl_centroid, t->capcent + t->capbuf);
+}
+
+static int mygsl_centroid_cmp(const void *a, const void *b)
+{
+  return mygsl_dcmp(&((const mygsl_centroid *) a)->mean,
+		    &((const mygsl_centroid *) b)->mean);
+}
+
+static int mygsl_centroid_rcmp(const void *a, const void *b)
+{
+  return mygsl_centroid_cmp(b, a);
+}
+
+/* k1 scale function and the largest q reachable from q0 by one unit */
+static double mygsl_tdigest_qlimit(double compression, double q0)
+{
+  double k = compression/(2.0*M_PI)*asin(2.0*q0 - 1.0) + 1.0;
+  if (k >= compression/4.0) return 1.0;
+  return 0.5*(sin(2.0*M_PI*k/compression) + 1.0);
+}
+
+static void mygsl_tdigest_flush(mygsl_tdigest *t)
+{
+  mygsl_centroid *c = t->c, cur;
+  size_t m = t->ncent + t->nbuf, i, out = 0;
+  double wsofar = 0.0, qlim;
+  if (t->nbuf == 0) return;
+  /*
+    Merging always from the left drifts the centroids towards q = 1;
+    alternating the direction cancels that (k1 is symmetric in q).
+  */
+  qsort(c, m, sizeof(mygsl_centroid),
+	t->reverse ? mygsl_centroid_rcmp : mygsl_centroid_cmp);
+  cur = c[0];
+  qlim = mygsl_tdigest_qlimit(t->compression, 0.0);
+  for (i = 1; i < m; i++) {
+    if ((wsofar + cur.w + c[i].w)/t->total <= qlim) {
+      cur.w += c[i].w;
+      cur.mean += (c[i].mean - cur.mean)*c[i].w/cur.w;
+    } else {
+      wsofar += cur.w;
+      c[out++] = cur;
+      qlim = mygsl_tdigest_qlimit(t->compression, wsofar/t->total);
+      cur = c[i];
+    }
+  }
+  c[out++] = cur;
+  if (t->reverse) {
+    for (i = 0; i < out/2; i++) {
+      cur = c[i];
+      c[i] = c[out-1-i];
+      c[out-1-i] = cur;
+    }
+  }
+  t->reverse = !t->reverse;
+  t->ncent = out;
+  t->nbuf = 0;
+}
+
+static int mygsl_tdigest_add(mygsl_tdigest *t, double x, double w)
+{
+  if (gsl_isnan(x) || !(w > 0.0)) return 0;
+  if (t->ncent + t->nbuf == t->capcent + t->capbuf) mygsl_tdigest_flush(t);
+  t->c[t->ncent + t->nbuf].mean = x;
+  t->c[t->ncent + t->nbuf].w = w;
+  t->nbuf++;
+  t->total += w;
+  if (x < t->min) t->min = x;
+  if (x > t->max) t->max = x;
+  return 1;
+}
+
+/*
+  Centroid i is taken to spread its weight around its mean, half on
+  either side; between consecutive centroid centers, and between the
+  extreme centers and min/max, the distribution is interpolated
+  linearly.
+*/
+static double mygsl_tdigest_quantile(mygsl_tdigest *t, double q)
+{
+  mygsl_centroid *c;
+  double target, left, right;
+  size_t i;
+  mygsl_tdigest_flush(t);
+  if (t->ncent == 0) return GSL_NAN;
+  if (q <= 0.0) return t->min;
+  if (q >= 1.0) return t->max;
+  c = t->c;
+  if (t->ncent == 1) return t->min + q*(t->max - t->min);
+  target = q*t->total;
+  left = 0.5*c[0].w;
+  if (target < left) {
+    /* the first unit of weight is the minimum itself */
+    if (target < 1.0 || left <= 1.0) return t->min;
+    return t->min + (c[0].mean - t->min)*(target - 1.0)/(left - 1.0);
+  }
+  for (i = 0; i + 1 < t->ncent; i++) {
+    right = left + 0.5*(c[i].w + c[i+1].w);
+    if (target < right)
+      return c[i].mean + (c[i+1].mean - c[i].mean)*(target - left)/(right - left);
+    left = right;
+  }
+  right = t->total - 1.0;
+  if (target >= right || right <= left) return t->max;
+  return c[i].mean + (t->max - c[i].mean)*(target - left)/(right - left);
+}
+
+static double mygsl_tdigest_cdf(mygsl_tdigest *t, double x)
+{
+  mygsl_centroid *c;
+  double left, right;
+  size_t i;
+  mygsl_tdigest_flush(t);
+  if (t->ncent == 0) return GSL_NAN;
+  if (x < t->min) return 0.0;
+  if (x >= t->max) return 1.0;
+  c = t->c;
+  if (t->ncent == 1 || t->max == t->min)
+    return t->max > t->min ? (x - t->min)/(t->max - t->min) : 1.0;
+  left = 0.5*c[0].w;
+  if (x < c[0].mean)
+    return left*(x - t->min)/(c[0].mean - t->min)/t->total;
+  for (i = 0; i + 1 < t->ncent; i++) {
+    right = left + 0.5*(c[i].w + c[i+1].w);
+    if (x < c[i+1].mean) {
+      if (c[i+1].mean == c[i].mean) return right/t->total;
+      return (left + (right - left)*(x - c[i].mean)/(c[i+1].mean - c[i].mean))/t->total;
+    }
+    left = right;
+  }
+  return (left + (t->total - left)*(x - c[i].mean)/(t->max - c[i].mean))/t->total;
+}
+
+static mygsl_tdigest* get_tdigest(VALUE obj)
+{
+  mygsl_tdigest *t = NULL;
+  if (!rb_obj_is_kind_of(obj, cgsl_stats_tdigest))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Stats::TDigest expected)",
+	     rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_tdigest, t);
+  return t;
+}
+
+static VALUE rb_gsl_stats_tdigest_alloc(VALUE klass)
+{
+  mygsl_tdigest *t = NULL;
+  VALUE obj;
+  obj = Data_Make_Struct(klass, mygsl_tdigest, 0, mygsl_tdigest_free, t);
+  t->c = NULL;
+  mygsl_tdigest_init(t, 100.0);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_initialize(int argc, VALUE *argv, VALUE obj)
+{
+  double compression = 100.0;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) compression = NUM2DBL(argv[0]);
+  if (!(compression >= 10.0 && compression <= 1e6))
+    rb_raise(rb_eArgError, "compression must be in [10, 1e6]");
+  mygsl_tdigest_init(get_tdigest(obj), compression);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_init_copy(VALUE obj, VALUE orig)
+{
+  mygsl_tdigest *t, *o;
+  if (obj == orig) return obj;
+  t = get_tdigest(obj);
+  o = get_tdigest(orig);
+  mygsl_tdigest_init(t, o->compression);
+  memcpy(t->c, o->c, (o->ncent + o->nbuf)*sizeof(mygsl_centroid));
+  t->ncent = o->ncent; t->nbuf = o->nbuf; t->n = o->n;
+  t->total = o->total; t->min = o->min; t->max = o->max;
+  t->reverse = o->reverse;
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_reset(VALUE obj)
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  mygsl_tdigest_init(t, t->compression);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_push(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  double x, w = 1.0;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  x = NUM2DBL(argv[0]);
+  if (argc == 2) w = NUM2DBL(argv[1]);
+  t->n += mygsl_tdigest_add(t, x, w);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_lshift(VALUE obj, VALUE x)
+{
+  return rb_gsl_stats_tdigest_push(1, &x, obj);
+}
+
+static VALUE rb_gsl_stats_tdigest_push_vector(VALUE obj, VALUE vv)
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  double *x;
+  size_t stride, size, i;
+  x = get_vector_ptr(vv, &stride, &size);
+  for (i = 0; i < size; i++) t->n += mygsl_tdigest_add(t, x[i*stride], 1.0);
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_merge_bang(VALUE obj, VALUE other)
+{
+  mygsl_tdigest *t = get_tdigest(obj), *o = get_tdigest(other);
+  mygsl_centroid *tmp;
+  size_t m, i;
+  double min, max;
+  mygsl_tdigest_flush(o);
+  m = o->ncent;
+  if (m == 0) return obj;
+  /* o may be t itself */
+  tmp = ALLOC_N(mygsl_centroid, m);
+  memcpy(tmp, o->c, m*sizeof(mygsl_centroid));
+  min = o->min; max = o->max;
+  t->n += o->n;
+  for (i = 0; i < m; i++) mygsl_tdigest_add(t, tmp[i].mean, tmp[i].w);
+  xfree(tmp);
+  if (min < t->min) t->min = min;
+  if (max > t->max) t->max = max;
+  return obj;
+}
+
+static VALUE rb_gsl_stats_tdigest_merge(VALUE obj, VALUE other)
+{
+  return rb_gsl_stats_tdigest_merge_bang(rb_obj_dup(obj), other);
+}
+
+/* q a Numeric, an Array or a GSL::Vector; the result has the same form */
+static VALUE rb_gsl_stats_tdigest_eval(VALUE obj, VALUE q,
+				       double (*f)(mygsl_tdigest*, double))
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  gsl_vector *v = NULL, *vnew = NULL;
+  VALUE ary;
+  size_t i;
+  if (TYPE(q) == T_ARRAY) {
+    ary = rb_ary_new2(RARRAY_LEN(q));
+    for (i = 0; i < (size_t) RARRAY_LEN(q); i++)
+      rb_ary_store(ary, i, rb_float_new((*f)(t, NUM2DBL(rb_ary_entry(q, i)))));
+    return ary;
+  } else if (VECTOR_P(q)) {
+    Data_Get_Struct(q, gsl_vector, v);
+    vnew = gsl_vector_alloc(v->size);
+    for (i = 0; i < v->size; i++) gsl_vector_set(vnew, i, (*f)(t, gsl_vector_get(v, i)));
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
+  }
+  return rb_float_new((*f)(t, NUM2DBL(q)));
+}
+
+static VALUE rb_gsl_stats_tdigest_quantile(VALUE obj, VALUE q)
+{
+  return rb_gsl_stats_tdigest_eval(obj, q, mygsl_tdigest_quantile);
+}
+
+static VALUE rb_gsl_stats_tdigest_median(VALUE obj)
+{
+  return rb_float_new(mygsl_tdigest_quantile(get_tdigest(obj), 0.5));
+}
+
+static VALUE rb_gsl_stats_tdigest_cdf(VALUE obj, VALUE x)
+{
+  return rb_gsl_stats_tdigest_eval(obj, x, mygsl_tdigest_cdf);
+}
+
+static VALUE rb_gsl_stats_tdigest_n(VALUE obj)
+{
+  return SIZET2NUM(get_tdigest(obj)->n);
+}
+
+static VALUE rb_gsl_stats_tdigest_sum_weights(VALUE obj)
+{
+  return rb_float_new(get_tdigest(obj)->total);
+}
+
+static VALUE rb_gsl_stats_tdigest_compression(VALUE obj)
+{
+  return rb_float_new(get_tdigest(obj)->compression);
+}
+
+static VALUE rb_gsl_stats_tdigest_centroids(VALUE obj)
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  mygsl_tdigest_flush(t);
+  return SIZET2NUM(t->ncent);
+}
+
+static VALUE rb_gsl_stats_tdigest_min(VALUE obj)
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  return rb_float_new(t->n == 0 ? GSL_NAN : t->min);
+}
+
+static VALUE rb_gsl_stats_tdigest_max(VALUE obj)
+{
+  mygsl_tdigest *t = get_tdigest(obj);
+  return rb_float_new(t->n == 0 ? GSL_NAN : t->max);
+}
+
+void Init_gsl_stats_quantile(VALUE module)
+{
+  cgsl_stats_p2 = rb_define_class_under(module, "P2", cGSL_Object);
+  rb_define_alloc_func(cgsl_stats_p2, rb_gsl_stats_p2_alloc);
+  rb_define_method(cgsl_stats_p2, "initialize", rb_gsl_stats_p2_initialize, -1);
+  rb_define_method(cgsl_stats_p2, "initialize_copy", rb_gsl_stats_p2_init_copy, 1);
+  rb_define_method(cgsl_stats_p2, "reset", rb_gsl_stats_p2_reset, 0);
+  rb_define_method(cgsl_stats_p2, "push", rb_gsl_stats_p2_push, 1);
+  rb_define_alias(cgsl_stats_p2, "<<", "push");
+  rb_define_method(cgsl_stats_p2, "push_vector", rb_gsl_stats_p2_push_vector, 1);
+  rb_define_method(cgsl_stats_p2, "n", rb_gsl_stats_p2_n, 0);
+  rb_define_alias(cgsl_stats_p2, "size", "n");
+  rb_define_method(cgsl_stats_p2, "p", rb_gsl_stats_p2_p, 0);
+  rb_define_method(cgsl_stats_p2, "quantile", rb_gsl_stats_p2_quantile, 0);
+  rb_define_alias(cgsl_stats_p2, "get", "quantile");
+
+  cgsl_stats_tdigest = rb_define_class_under(module, "TDigest", cGSL_Object);
+  rb_define_alloc_func(cgsl_stats_tdigest, rb_gsl_stats_tdigest_alloc);
+  rb_define_method(cgsl_stats_tdigest, "initialize", rb_gsl_stats_tdigest_initialize, -1);
+  rb_define_method(cgsl_stats_tdigest, "initialize_copy", rb_gsl_stats_tdigest_init_copy, 1);
+  rb_define_method(cgsl_stats_tdigest, "reset", rb_gsl_stats_tdigest_reset, 0);
+  rb_define_method(cgsl_stats_tdigest, "push", rb_gsl_stats_tdigest_push, -1);
+  rb_define_method(cgsl_stats_tdigest, "<<", rb_gsl_stats_tdigest_lshift, 1);
+  rb_define_method(cgsl_stats_tdigest, "push_vector", rb_gsl_stats_tdigest_push_vector, 1);
+  rb_define_method(cgsl_stats_tdigest, "merge!", rb_gsl_stats_tdigest_merge_bang, 1);
+  rb_define_method(cgsl_stats_tdigest, "merge", rb_gsl_stats_tdigest_merge, 1);
+  rb_define_method(cgsl_stats_tdigest, "quantile", rb_gsl_stats_tdigest_quantile, 1);
+  rb_define_method(cgsl_stats_tdigest, "median", rb_gsl_stats_tdigest_median, 0);
+  rb_define_method(cgsl_stats_tdigest, "cdf", rb_gsl_stats_tdigest_cdf, 1);
+  rb_define_method(cgsl_stats_tdigest, "n", rb_gsl_stats_tdigest_n, 0);
+  rb_define_alias(cgsl_stats_tdigest, "size", "n");
+  rb_define_method(cgsl_stats_tdigest, "sum_weights", rb_gsl_stats_tdigest_sum_weights, 0);
+  rb_define_method(cgsl_stats_tdigest, "compression", rb_gsl_stats_tdigest_compression, 0);
+  rb_define_method(cgsl_stats_tdigest, "centroids", rb_gsl_stats_tdigest_centroids, 0);
+  rb_define_method(cgsl_stats_tdigest, "min", rb_gsl_stats_tdigest_min, 0);
+  rb_define_method(cgsl_stats_tdigest, "max", rb_gsl_stats_tdigest_max, 0);
+}
@@ -0,0 +1,362 @@
+/*
+  stats_rolling.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Statistics over a sliding window, in one call:
+
+    r = v.rolling(60, :median)           # or GSL::Stats.rolling(v, 60, :median)
+    r = v.rolling(60, :mean, :pad => true)
+
+  r[k] is the statistic of v[k..k+w-1], so r has v.size - w + 1
+  elements; with :pad => true it has v.size elements, the window
+  ending at element k and the first w - 1 entries NaN (a trailing
+  window, as for a price series).  The statistics are :sum, :mean,
+  :variance, :sd (with w - 1 in the denominator, as gsl_stats_variance),
+  :min, :max, :median and :mad (scaled by 1.4826, as gsl_stats_mad).
+
+  Sums and moments are updated in O(1) per step and recomputed exactly
+  (two-pass) at every w-th step, so rounding does not drift; min and
+  max use monotonic deques, O(1) amortized; the median keeps the window
+  in a pair of indexed heaps around it, O(log w) per step (the
+  "mediator" scheme also used by gsl_movstat).  :mad sorts the absolute
+  deviations of each window, O(w log w).  The outputs are computed in
+  chunks of ROLLING_CHUNK, each starting from a fresh state, spread
+  over threads with the GVL released, so the result does not depend on
+  the number of threads.  This is gsl_movstat of GSL 2.5, without its
+  dependency.  The data should not contain NaNs.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include "rb_gsl_statistics.h"
+#include <gsl/gsl_sort.h>
+
+#define ROLLING_CHUNK 8192
+
+enum {
+  ROLLING_SUM,
+  ROLLING_MEAN,
+  ROLLING_VARIANCE,
+  ROLLING_SD,
+  ROLLING_MIN,
+  ROLLING_MAX,
+  ROLLING_MEDIAN,
+  ROLLING_MAD,
+};
+
+/*
+  The window as a ring buffer of w values, with a max-heap below the
+  median and a min-heap above it; heap[0] is the median, heap[-i] the
+  max-heap and heap[i] the min-heap, pos[] the heap slot of each value.
+*/
+typedef struct {
+  double *data;
+  int *pos, *heap;
+  int n, idx, ct;
+} mygsl_mediator;
+
+#define MEDIATOR_MINCT(m) (((m)->ct - 1)/2)
+#define MEDIATOR_MAXCT(m) ((m)->ct/2)
+
+static void mediator_init(mygsl_mediator *m, int n, double *data, int *ibuf)
+{
+  int i;
+  m->data = data;
+  m->pos = ibuf;
+  m->heap = ibuf + n + n/2;
+  m->n = n;
+  m->ct = m->idx = 0;
+  for (i = n - 1; i >= 0; i--) {
+    m->pos[i] = ((i + 1)/2)*((i & 1) ? -1 : 1);
+    m->heap[m->pos[i]] = i;
+  }
+}
+
+static int mediator_less(const mygsl_mediator *m, int i, int j)
+{
+  return m->data[m->heap[i]] < m->data[m->heap[j]];
+}
+
+static int mediator_exchange(mygsl_mediator *m, int i, int j)
+{
+  int t = m->heap[i];
+  m->heap[i] = m->heap[j];
+  m->heap[j] = t;
+  m->pos[m->heap[i]] = i;
+  m->pos[m->heap[j]] = j;
+  return 1;
+}
+
+static int mediator_cmpexch(mygsl_mediator *m, int i, int j)
+{
+  return mediator_less(m, i, j) && mediator_exchange(m, i, j);
+}
+
+/* Sift down from slot i/2, i being one of its children (i = 1: the median) */
+static void mediator_min_down(mygsl_mediator *m, int i)
+{
+  for (; i <= MEDIATOR_MINCT(m); i *= 2) {
+    if (i > 1 && i < MEDIATOR_MINCT(m) && mediator_less(m, i + 1, i)) i++;
+    if (!mediator_cmpexch(m, i, i/2)) break;
+  }
+}
+
+static void mediator_max_down(mygsl_mediator *m, int i)
+{
+  for (; i >= -MEDIATOR_MAXCT(m); i *= 2) {
+    if (i < -1 && i > -MEDIATOR_MAXCT(m) && mediator_less(m, i, i - 1)) i--;
+    if (!mediator_cmpexch(m, i/2, i)) break;
+  }
+}
+
+/* both return whether the median changed */
+static int mediator_min_up(mygsl_mediator *m, int i)
+{
+  while (i > 0 && mediator_cmpexch(m, i, i/2)) i /= 2;
+  return i == 0;
+}
+
+static int mediator_max_up(mygsl_mediator *m, int i)
+{
+  while (i < 0 && mediator_cmpexch(m, i/2, i)) i /= 2;
+  return i == 0;
+}
+
+/* Replaces the oldest value (once the window is full) by v */
+static void mediator_insert(mygsl_mediator *m, double v)
+{
+  int isnew = m->ct < m->n, p = m->pos[m->idx];
+  double old = m->data[m->idx];
+  m->data[m->idx] = v;
+  m->idx = (m->idx + 1) % m->n;
+  m->ct += isnew;
+  if (p > 0) {
+    if (!isnew && old < v) mediator_min_down(m, 2*p);
+    else if (mediator_min_up(m, p)) mediator_max_down(m, -1);
+  } else if (p < 0) {
+    if (!isnew && v < old) mediator_max_down(m, 2*p);
+    else if (mediator_max_up(m, p)) mediator_min_down(m, 1);
+  } else {
+    if (MEDIATOR_MAXCT(m)) mediator_max_down(m, -1);
+    if (MEDIATOR_MINCT(m)) mediator_min_down(m, 1);
+  }
+}
+
+static double mediator_median(const mygsl_mediator *m)
+{
+  double v = m->data[m->heap[0]];
+  if ((m->ct & 1) == 0) v = 0.5*(v + m->data[m->heap[-1]]);
+  return v;
+}
+
+/*****/
+
+struct rolling_task {
+  const double *x;
+  size_t stride, w, nout, nchunks, nthreads;
+  int stat;
+  double *r, *dbuf;
+  int *ibuf;
+  size_t *qbuf;
+};
+
+static void rolling_moments(const struct rolling_task *t, size_t o0, size_t o1)
+{
+  const double *x = t->x;
+  size_t s = t->stride, w = t->w, k, i;
+  double mean = 0.0, m2 = 0.0, mold, xo, xn, d, v;
+  for (k = o0; k < o1; k++) {
+    if ((k - o0) % w == 0) {
+      for (i = 0, mean = 0.0; i < w; i++) mean += x[(k + i)*s];
+      mean /= w;
+      for (i = 0, m2 = 0.0; i < w; i++) {
+	d = x[(k + i)*s] - mean;
+	m2 += d*d;
+      }
+    } else {
+      xo = x[(k - 1)*s];
+      xn = x[(k + w - 1)*s];
+      mold = mean;
+      mean += (xn - xo)/w;
+      m2 += (xn - xo)*(xn - mean + xo - mold);
+      if (m2 < 0.0) m2 = 0.0;
+    }
+    switch (t->stat) {
+    case ROLLING_SUM: v = mean*w; break;
+    case ROLLING_MEAN: v = mean; break;
+    case ROLLING_VARIANCE: v = m2/(w - 1); break;
+    default: v = sqrt(m2/(w - 1)); break;
+    }
+    t->r[k] = v;
+  }
+}
+
+/* Monotonic deque of indices, as a ring of w entries */
+static void rolling_extremum(const struct rolling_task *t, size_t o0, size_t o1,
+			     size_t *q)
+{
+  const double *x = t->x;
+  size_t s = t->stride, w = t->w, head = 0, len = 0, j, jend = o1 + w - 1;
+  int max = t->stat == ROLLING_MAX;
+  double v, b;
+  for (j = o0; j < jend; j++) {
+    v = x[j*s];
+    if (len > 0 && q[head] + w <= j) {
+      head = (head + 1) % w;
+      len--;
+    }
+    while (len > 0) {
+      b = x[q[(head + len - 1) % w]*s];
+      if (max ? b <= v : b >= v) len--;
+      else break;
+    }
+    q[(head + len) % w] = j;
+    len++;
+    if (j + 1 >= o0 + w) t->r[j + 1 - w] = x[q[head]*s];
+  }
+}
+
+static void rolling_median(const struct rolling_task *t, size_t o0, size_t o1,
+			   double *dbuf, int *ibuf)
+{
+  const double *x = t->x;
+  size_t s = t->stride, w = t->w, j, i, jend = o1 + w - 1;
+  double med, *dev = dbuf + w;
+  mygsl_mediator m;
+  mediator_init(&m, (int) w, dbuf, ibuf);
+  for (j = o0; j < jend; j++) {
+    mediator_insert(&m, x[j*s]);
+    if (j + 1 < o0 + w) continue;
+    med = mediator_median(&m);
+    if (t->stat == ROLLING_MEDIAN) {
+      t->r[j + 1 - w] = med;
+      continue;
+    }
+    for (i = 0; i < w; i++) dev[i] = fabs(dbuf[i] - med);
+    gsl_sort(dev, 1, w);
+    t->r[j + 1 - w] = 1.482602218505602*gsl_stats_median_from_sorted_data(dev, 1, w);
+  }
+}
+
+static int rolling_worker(void *data, size_t k)
+{
+  struct rolling_task *t = (struct rolling_task *) data;
+  size_t c0 = k*t->nchunks/t->nthreads, c1 = (k + 1)*t->nchunks/t->nthreads, c;
+  size_t o0, o1;
+  for (c = c0; c < c1; c++) {
+    o0 = c*ROLLING_CHUNK;
+    o1 = GSL_MIN(o0 + ROLLING_CHUNK, t->nout);
+    switch (t->stat) {
+    case ROLLING_MIN: case ROLLING_MAX:
+      rolling_extremum(t, o0, o1, t->qbuf + k*t->w);
+      break;
+    case ROLLING_MEDIAN: case ROLLING_MAD:
+      rolling_median(t, o0, o1, t->dbuf + 2*k*t->w, t->ibuf + 2*k*t->w);
+      break;
+    default:
+      rolling_moments(t, o0, o1);
+      break;
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static int rolling_serial(void *data)
+{
+  return rolling_worker(data, 0);
+}
+
+/* r[k] = stat(x[k], ..., x[k+w-1]) for k < n - w + 1; w <= n */
+static void mygsl_rolling(const double *x, size_t stride, size_t n, size_t w,
+			  int stat, double *r)
+{
+  struct rolling_task t;
+  size_t work;
+  t.x = x; t.stride = stride; t.w = w; t.stat = stat; t.r = r;
+  t.nout = n - w + 1;
+  t.nchunks = (t.nout + ROLLING_CHUNK - 1)/ROLLING_CHUNK;
+  work = stat == ROLLING_MAD ? t.nout*w : t.nout;
+  t.nthreads = rb_gsl_parallel_nthreads(work, t.nchunks);
+  t.dbuf = NULL; t.ibuf = NULL; t.qbuf = NULL;
+  if (stat == ROLLING_MIN || stat == ROLLING_MAX) {
+    t.qbuf = ALLOC_N(size_t, t.nthreads*w);
+  } else if (stat == ROLLING_MEDIAN || stat == ROLLING_MAD) {
+    t.dbuf = ALLOC_N(double, 2*t.nthreads*w);
+    t.ibuf = ALLOC_N(int, 2*t.nthreads*w);
+  }
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(rolling_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(rolling_serial, &t, work);
+  if (t.qbuf) xfree(t.qbuf);
+  if (t.dbuf) xfree(t.dbuf);
+  if (t.ibuf) xfree(t.ibuf);
+}
+
+static int rolling_stat(VALUE sym)
+{
+  static const char *names[] = {"sum", "mean", "variance", "sd", "min", "max",
+				"median", "mad", NULL};
+  ID id;
+  int i;
+  if (!SYMBOL_P(sym)) rb_raise(rb_eTypeError, "statistic must be a Symbol");
+  id = SYM2ID(sym);
+  for (i = 0; names[i]; i++) if (id == rb_intern(names[i])) return i;
+  rb_raise(rb_eArgError, "unknown rolling statistic :%s", rb_id2name(id));
+  return -1;
+}
+
+/*
+  GSL::Stats.rolling(v, w[, stat, opts]), v.rolling(w[, stat, opts]);
+  stat defaults to :mean
+*/
+static VALUE rb_gsl_stats_rolling(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE vx, opts = Qnil;
+  gsl_vector *r = NULL;
+  double *x;
+  size_t stride, n, w, k, off = 0;
+  int stat = ROLLING_MEAN, pad = 0;
+  switch (TYPE(obj)) {
+  case T_MODULE:  case T_CLASS:  case T_OBJECT:
+    if (argc < 1) rb_raise(rb_eArgError, "too few arguments");
+    vx = argv[0];
+    argc--; argv++;
+    break;
+  default:
+    vx = obj;
+    break;
+  }
+  if (argc > 0 && TYPE(argv[argc-1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  x = get_vector_ptr(vx, &stride, &n);
+  CHECK_FIXNUM(argv[0]);
+  if (FIX2LONG(argv[0]) < 1) rb_raise(rb_eArgError, "window must be positive");
+  w = FIX2LONG(argv[0]);
+  if (w > n) rb_raise(rb_eArgError, "window longer than data (%d > %d)", (int) w, (int) n);
+  if (argc == 2) stat = rolling_stat(argv[1]);
+  if (!NIL_P(opts)) pad = RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("pad"))));
+  if (pad) {
+    r = gsl_vector_alloc(n);
+    off = w - 1;
+    for (k = 0; k < off; k++) gsl_vector_set(r, k, GSL_NAN);
+  } else {
+    r = gsl_vector_alloc(n - w + 1);
+  }
+  mygsl_rolling(x, stride, n, w, stat, r->data + off);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, r);
+}
+
+void Init_gsl_stats_rolling(VALUE module)
+{
+  rb_define_singleton_method(module, "rolling", rb_gsl_stats_rolling, -1);
+  rb_define_method(cgsl_vector, "stats_rolling", rb_gsl_stats_rolling, -1);
+  rb_define_alias(cgsl_vector, "rolling", "stats_rolling");
+}
@@ -119,10 +119,167 @@ static VALUE rb_gsl_sum_levin_utrunc_terms_used(VALUE obj)
   return INT2FIX(w->terms_used);
 }
 
+/*
+  GSL::Sum::Stream: the truncated Levin u-transform of a series whose
+  terms come in batches,
+
+    s = GSL::Sum::Stream.alloc
+    begin
+      sum, err = s.push(next_terms)     # Float, Array or Vector
+    end until err < tol*sum.abs
+
+  with the convergence test of gsl_sum_levin_utrunc_accel() applied as
+  each term is stepped: once the truncation error stops decreasing the
+  best estimate so far is kept, and terms pushed after it reaches the
+  working precision are ignored.  The workspace doubles as needed.
+  Zero terms, which the transform cannot take, add nothing and are
+  skipped.
+*/
+typedef struct {
+  gsl_sum_levin_utrunc_workspace *w;
+  size_t n;
+  double result, actual_trunc, trunc, least_trunc, least_result;
+  int before, converging, done;
+} rb_gsl_sum_stream;
+
+static void rb_gsl_sum_stream_free(rb_gsl_sum_stream *s)
+{
+  if (s->w) gsl_sum_levin_utrunc_free(s->w);
+  free(s);
+}
+
+static void rb_gsl_sum_stream_reset0(rb_gsl_sum_stream *s)
+{
+  s->n = 0;
+  s->result = s->actual_trunc = s->trunc = 0.0;
+  s->least_trunc = GSL_DBL_MAX;
+  s->least_result = 0.0;
+  s->before = s->converging = s->done = 0;
+  s->w->sum_plain = 0.0;
+  s->w->terms_used = 0;
+}
+
+static VALUE rb_gsl_sum_stream_new(int argc, VALUE *argv, VALUE klass)
+{
+  rb_gsl_sum_stream *s;
+  VALUE obj;
+  size_t n = 64;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) n = NUM2ULONG(argv[0]);
+  if (n < 2) n = 2;
+  obj = Data_Make_Struct(klass, rb_gsl_sum_stream, 0, rb_gsl_sum_stream_free, s);
+  s->w = gsl_sum_levin_utrunc_alloc(n);
+  rb_gsl_sum_stream_reset0(s);
+  return obj;
+}
+
+static void mygsl_sum_stream_grow(rb_gsl_sum_stream *s)
+{
+  gsl_sum_levin_utrunc_workspace *w;
+  w = gsl_sum_levin_utrunc_alloc(2*s->w->size);
+  memcpy(w->q_num, s->w->q_num, sizeof(double)*s->n);
+  memcpy(w->q_den, s->w->q_den, sizeof(double)*s->n);
+  memcpy(w->dsum, s->w->dsum, sizeof(double)*s->n);
+  w->sum_plain = s->w->sum_plain;
+  w->terms_used = s->w->terms_used;
+  gsl_sum_levin_utrunc_free(s->w);
+  s->w = w;
+}
+
+static void mygsl_sum_stream_step(rb_gsl_sum_stream *s, double t)
+{
+  const double SMALL = 0.01;
+  double result_nm1, actual_trunc_nm1, trunc_nm1;
+  int better;
+  if (s->done || t == 0.0) return;
+  if (s->n == s->w->size) mygsl_sum_stream_grow(s);
+  result_nm1 = s->result;
+  gsl_sum_levin_utrunc_step(t, s->n, s->w, &s->result);
+  s->n++;
+  s->w->terms_used = s->n;
+  actual_trunc_nm1 = s->actual_trunc;
+  s->actual_trunc = fabs(s->result - result_nm1);
+  trunc_nm1 = s->trunc;
+  s->trunc = 0.5*(s->actual_trunc + actual_trunc_nm1);
+  better = (s->trunc < trunc_nm1 || s->trunc < SMALL*fabs(s->result));
+  s->converging = s->converging || (better && s->before);
+  s->before = better;
+  if (s->converging) {
+    if (s->trunc < s->least_trunc) {
+      s->least_trunc = s->trunc;
+      s->least_result = s->result;
+    }
+    if (fabs(s->trunc/s->result) < 10.0*GSL_DBL_EPSILON) s->done = 1;
+  }
+}
+
+static VALUE rb_gsl_sum_stream_sum(VALUE obj)
+{
+  rb_gsl_sum_stream *s;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  return rb_float_new(s->converging ? s->least_result : s->result);
+}
+
+static VALUE rb_gsl_sum_stream_abserr(VALUE obj)
+{
+  rb_gsl_sum_stream *s;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  if (s->n < 2) return rb_float_new(GSL_POSINF);
+  return rb_float_new(s->converging ? s->least_trunc : s->trunc);
+}
+
+/* s.push(terms): [sum, abserr] after the terms */
+static VALUE rb_gsl_sum_stream_push(VALUE obj, VALUE tt)
+{
+  rb_gsl_sum_stream *s;
+  double *ptr;
+  size_t i, n, stride;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  if (rb_obj_is_kind_of(tt, rb_cNumeric)) {
+    mygsl_sum_stream_step(s, NUM2DBL(tt));
+  } else if (TYPE(tt) == T_ARRAY) {
+    for (i = 0; i < (size_t) RARRAY_LEN(tt); i++)
+      mygsl_sum_stream_step(s, NUM2DBL(rb_ary_entry(tt, i)));
+  } else {
+    ptr = get_vector_ptr(tt, &stride, &n);
+    for (i = 0; i < n; i++) mygsl_sum_stream_step(s, ptr[i*stride]);
+  }
+  return rb_ary_new3(2, rb_gsl_sum_stream_sum(obj), rb_gsl_sum_stream_abserr(obj));
+}
+
+static VALUE rb_gsl_sum_stream_sum_plain(VALUE obj)
+{
+  rb_gsl_sum_stream *s;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  return rb_float_new(s->w->sum_plain);
+}
+
+static VALUE rb_gsl_sum_stream_terms_used(VALUE obj)
+{
+  rb_gsl_sum_stream *s;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  return INT2FIX(s->n);
+}
+
+static VALUE rb_gsl_sum_stream_converging(VALUE obj)
+{
+  rb_gsl_sum_stream *s;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  return s->converging ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_sum_stream_reset(VALUE obj)
+{
+  rb_gsl_sum_stream *s;
+  Data_Get_Struct(obj, rb_gsl_sum_stream, s);
+  rb_gsl_sum_stream_reset0(s);
+  return obj;
+}
+
 void Init_gsl_sum(VALUE module) 
 {
   VALUE mgsl_sum;
-  VALUE cgsl_sum_levin_u, cgsl_sum_levin_utrunc;
+  VALUE cgsl_sum_levin_u, cgsl_sum_levin_utrunc, cgsl_sum_stream;
 
   mgsl_sum = rb_define_module_under(module, "Sum");
   cgsl_sum_levin_u = rb_define_class_under(mgsl_sum, 
@@ -152,6 +309,17 @@ void Init_gsl_sum(VALUE module)
 		   rb_gsl_sum_levin_utrunc_sum_plain, 0);
   rb_define_method(cgsl_sum_levin_utrunc, "terms_used", 
 		   rb_gsl_sum_levin_utrunc_terms_used, 0);
+
+  cgsl_sum_stream = rb_define_class_under(mgsl_sum, "Stream", cGSL_Object);
+  rb_define_singleton_method(cgsl_sum_stream, "new", rb_gsl_sum_stream_new, -1);
+  rb_define_singleton_method(cgsl_sum_stream, "alloc", rb_gsl_sum_stream_new, -1);
+  rb_define_method(cgsl_sum_stream, "push", rb_gsl_sum_stream_push, 1);
+  rb_define_method(cgsl_sum_stream, "sum", rb_gsl_sum_stream_sum, 0);
+  rb_define_method(cgsl_sum_stream, "abserr", rb_gsl_sum_stream_abserr, 0);
+  rb_define_method(cgsl_sum_stream, "sum_plain", rb_gsl_sum_stream_sum_plain, 0);
+  rb_define_method(cgsl_sum_stream, "terms_used", rb_gsl_sum_stream_terms_used, 0);
+  rb_define_method(cgsl_sum_stream, "converging?", rb_gsl_sum_stream_converging, 0);
+  rb_define_method(cgsl_sum_stream, "reset", rb_gsl_sum_stream_reset, 0);
   /***/
 
   rb_define_method(cgsl_vector, "accel_sum", rb_gsl_sum_accel, 0);
@@ -1,17 +1,259 @@
 #include "rb_gsl.h"
 
 #ifdef HAVE_TAMU_ANOVA_TAMU_ANOVA_H
+#include <gsl/gsl_cdf.h>
+
+/*
+  One-way ANOVA of many responses sharing a factor, in one pass.
+
+    tables = GSL::TAMU_ANOVA::Table.oneway(m, factor, J)
+    acc = GSL::TAMU_ANOVA::Accumulator.alloc(J, ncols)
+    acc.add(row, level)    # or acc.add(matrix, factor)
+    acc.tables; acc.table(c); acc.F; acc.p
+
+  With a GSL::Matrix the columns are the responses and row i belongs to
+  the group factor[i] (1 .. J); the result is an Array of one Table per
+  column.  The accumulator keeps for each group and column the count,
+  the mean and the sum of the squared deviations from it, updated row
+  by row (Welford) so that rows can be given in any number of calls:
+  sums of squares taken around zero would lose the within group
+  variance of responses with a large mean.  The tables are made from
+  these, SSTr from the group means and SSE from the deviations, and
+  agree with tamu_anova() up to rounding.  The columns of a large
+  matrix are split over GSL.parallel_threads threads.
+*/
+
+typedef struct {
+  size_t J, ncols;
+  size_t *n;
+  double *mean, *m2;
+} mygsl_anova_accum;
+
+static VALUE cgsl_tamu_anova_table, cgsl_tamu_anova_accum;
+
+/* The levels of factor, checked against 1 .. J, less base */
+static long* anova_levels(VALUE factor, size_t I, long J, long base)
+{
+  long *g = ALLOC_N(long, I), l;
+  size_t i;
+  gsl_vector_int *vi = NULL;
+  gsl_vector *v = NULL;
+  if (VECTOR_INT_P(factor)) Data_Get_Struct(factor, gsl_vector_int, vi);
+  else if (VECTOR_P(factor)) Data_Get_Struct(factor, gsl_vector, v);
+  else Check_Type(factor, T_ARRAY);
+  if ((vi ? vi->size : v ? v->size : (size_t) RARRAY_LEN(factor)) < I) {
+    xfree(g);
+    rb_raise(rb_eIndexError, "factor has fewer than %d entries", (int) I);
+  }
+  for (i = 0; i < I; i++) {
+    if (vi) l = gsl_vector_int_get(vi, i);
+    else if (v) l = (long) gsl_vector_get(v, i);
+    else l = NUM2LONG(rb_ary_entry(factor, i));
+    if (l < 1 || l > J) {
+      xfree(g);
+      rb_raise(rb_eArgError, "factor level %ld out of range 1..%ld", l, J);
+    }
+    g[i] = l - base;
+  }
+  return g;
+}
+
+static void mygsl_anova_accum_reset(mygsl_anova_accum *a)
+{
+  memset(a->n, 0, sizeof(size_t)*a->J);
+  memset(a->mean, 0, sizeof(double)*a->J*a->ncols);
+  memset(a->m2, 0, sizeof(double)*a->J*a->ncols);
+}
+
+static mygsl_anova_accum* mygsl_anova_accum_alloc(size_t J, size_t ncols)
+{
+  mygsl_anova_accum *a = ALLOC(mygsl_anova_accum);
+  a->J = J;
+  a->ncols = ncols;
+  a->n = ALLOC_N(size_t, J);
+  a->mean = ALLOC_N(double, J*ncols);
+  a->m2 = ALLOC_N(double, J*ncols);
+  mygsl_anova_accum_reset(a);
+  return a;
+}
+
+static void mygsl_anova_accum_free(mygsl_anova_accum *a)
+{
+  xfree(a->n);
+  xfree(a->mean);
+  xfree(a->m2);
+  xfree(a);
+}
+
+/*
+  The rows x[i*tda + c] of group g[i].  k[i] is the count of the group
+  once row i is in: the counts do not depend on the column, so they are
+  found beforehand and the threads share them.
+*/
+struct anova_task {
+  mygsl_anova_accum *a;
+  const double *x;
+  size_t rows, tda, nthreads;
+  const long *g;
+  const size_t *k;
+};
+
+static void anova_accum_columns(const struct anova_task *t, size_t c0, size_t c1)
+{
+  size_t i, c, nc = t->a->ncols;
+  for (i = 0; i < t->rows; i++) {
+    const double *xi = t->x + i*t->tda, r = 1.0/t->k[i];
+    double *mean = t->a->mean + t->g[i]*nc, *m2 = t->a->m2 + t->g[i]*nc;
+    for (c = c0; c < c1; c++) {
+      double d = xi[c] - mean[c];
+      mean[c] += d*r;
+      m2[c] += d*(xi[c] - mean[c]);
+    }
+  }
+}
+
+static int anova_worker(void *data, size_t id)
+{
+  struct anova_task *t = (struct anova_task *) data;
+  /* whole cache lines of columns to each thread */
+  size_t chunk = ((t->a->ncols + t->nthreads - 1)/t->nthreads + 7) & ~(size_t) 7;
+  anova_accum_columns(t, GSL_MIN(id*chunk, t->a->ncols),
+		      GSL_MIN((id + 1)*chunk, t->a->ncols));
+  return GSL_SUCCESS;
+}
+
+static int anova_serial(void *data)
+{
+  struct anova_task *t = (struct anova_task *) data;
+  anova_accum_columns(t, 0, t->a->ncols);
+  return GSL_SUCCESS;
+}
+
+/* Adds rows of a->ncols values, the groups g already checked */
+static void mygsl_anova_accum_add(mygsl_anova_accum *a, const double *x, size_t rows,
+				  size_t tda, const long *g)
+{
+  struct anova_task t;
+  size_t i, k1, *k = rows > 1 ? ALLOC_N(size_t, rows) : &k1, work = rows*a->ncols;
+  for (i = 0; i < rows; i++) k[i] = ++a->n[g[i]];
+  t.a = a;
+  t.x = x;
+  t.rows = rows;
+  t.tda = tda;
+  t.g = g;
+  t.k = k;
+  t.nthreads = rb_gsl_parallel_nthreads(work, a->ncols/64 + 1);
+  if (t.nthreads > 1) rb_gsl_nogvl_parallel(anova_worker, &t, t.nthreads);
+  else rb_gsl_nogvl_call(anova_serial, &t, work);
+  if (k != &k1) xfree(k);
+}
+
+static void mygsl_anova_accum_table(const mygsl_anova_accum *a, size_t c,
+				    struct tamu_anova_table *t)
+{
+  size_t j, N = 0;
+  double grand = 0.0, sstr = 0.0, sse = 0.0;
+  for (j = 0; j < a->J; j++) {
+    N += a->n[j];
+    grand += a->n[j]*a->mean[j*a->ncols + c];
+  }
+  if (N > 0) grand /= N;
+  for (j = 0; j < a->J; j++) {
+    double d = a->mean[j*a->ncols + c] - grand;
+    sstr += a->n[j]*d*d;
+    sse += a->m2[j*a->ncols + c];
+  }
+  t->dfTr = (long) a->J - 1;
+  t->dfE = (long) N - (long) a->J;
+  t->dfT = (long) N - 1;
+  t->SSTr = sstr;
+  t->SSE = sse;
+  t->SST = sstr + sse;
+  t->MSTr = sstr/t->dfTr;
+  t->MSE = sse/t->dfE;
+  t->F = t->MSTr/t->MSE;
+  t->p = gsl_cdf_fdist_Q(t->F, (double) t->dfTr, (double) t->dfE);
+}
+
+static VALUE anova_table_new(const mygsl_anova_accum *a, size_t c)
+{
+  struct tamu_anova_table *table = ALLOC(struct tamu_anova_table);
+  mygsl_anova_accum_table(a, c, table);
+  return Data_Wrap_Struct(cgsl_tamu_anova_table, 0, xfree, table);
+}
+
+static VALUE anova_tables(const mygsl_anova_accum *a)
+{
+  VALUE ary = rb_ary_new2(a->ncols);
+  size_t c;
+  for (c = 0; c < a->ncols; c++) rb_ary_store(ary, c, anova_table_new(a, c));
+  return ary;
+}
+
+/* Adds the rows of m, or the one row x (a Vector or a Float), to acc */
+static void anova_accum_add_value(mygsl_anova_accum *a, VALUE x, VALUE factor)
+{
+  gsl_matrix *m;
+  gsl_vector *v;
+  long *g, l;
+  double d;
+  if (MATRIX_P(x)) {
+    Data_Get_Struct(x, gsl_matrix, m);
+    if (m->size2 != a->ncols)
+      rb_raise(rb_eRuntimeError, "matrix has %d columns, %d expected",
+	       (int) m->size2, (int) a->ncols);
+    g = anova_levels(factor, m->size1, (long) a->J, 1);
+    mygsl_anova_accum_add(a, m->data, m->size1, m->tda, g);
+    xfree(g);
+    return;
+  }
+  l = NUM2LONG(factor);
+  if (l < 1 || l > (long) a->J)
+    rb_raise(rb_eArgError, "factor level %ld out of range 1..%d", l, (int) a->J);
+  l--;
+  if (VECTOR_P(x)) {
+    Data_Get_Struct(x, gsl_vector, v);
+    if (v->size != a->ncols)
+      rb_raise(rb_eRuntimeError, "vector has %d elements, %d expected",
+	       (int) v->size, (int) a->ncols);
+    if (v->stride == 1) {
+      mygsl_anova_accum_add(a, v->data, 1, a->ncols, &l);
+      return;
+    }
+    v = make_vector_clone(v);
+    mygsl_anova_accum_add(a, v->data, 1, a->ncols, &l);
+    gsl_vector_free(v);
+    return;
+  }
+  if (a->ncols != 1)
+    rb_raise(rb_eTypeError, "a Vector of %d values or a Matrix expected", (int) a->ncols);
+  d = NUM2DBL(x);
+  mygsl_anova_accum_add(a, &d, 1, 1, &l);
+}
+
 VALUE rb_tamu_anova_alloc(int argc, VALUE *argv, VALUE klass)
 {
-  gsl_vector *data;
-  gsl_vector_long *factor;
-  long I, J;
+  gsl_vector *data, *tmp = NULL;
+  gsl_matrix *m;
+  mygsl_anova_accum *a;
+  long I, J, *factor;
   struct tamu_anova_table *table;
+  VALUE ary, acc;
   switch (argc) {
   case 3:
   case 4:
+    if (MATRIX_P(argv[0])) {
+      Data_Get_Struct(argv[0], gsl_matrix, m);
+      J = NUM2LONG(argv[argc-1]);
+      if (J < 2) rb_raise(rb_eArgError, "at least 2 groups expected");
+      a = mygsl_anova_accum_alloc(J, m->size2);
+      acc = Data_Wrap_Struct(cgsl_tamu_anova_accum, 0, mygsl_anova_accum_free, a);
+      anova_accum_add_value(a, argv[0], argv[1]);
+      ary = anova_tables(a);
+      RB_GC_GUARD(acc);
+      return ary;
+    }
     Data_Get_Struct(argv[0], gsl_vector, data);
-    Data_Get_Struct(argv[1], gsl_vector_long, factor);
     if (argc == 3) {
       I = data->size;
       J = NUM2INT(argv[2]);
@@ -19,8 +261,13 @@ VALUE rb_tamu_anova_alloc(int argc, VALUE *argv, VALUE klass)
       I = NUM2INT(argv[2]);
       J = NUM2INT(argv[3]);
     }
+    if (I > (long) data->size) rb_raise(rb_eIndexError, "data has fewer than %ld entries", I);
+    factor = anova_levels(argv[1], I, J, 0);
+    if (data->stride != 1) data = tmp = make_vector_clone(data);
     table = (struct tamu_anova_table *) malloc(sizeof(struct tamu_anova_table));
-    *table = tamu_anova(data->data, factor->data, I, J);
+    *table = tamu_anova(data->data, factor, I, J);
+    if (tmp) gsl_vector_free(tmp);
+    xfree(factor);
     break;
   default:
     rb_raise(rb_eArgError, "Wrong number of arguments (%d for 3 or 4)", argc);
@@ -37,20 +284,151 @@ VALUE rb_tamu_anova_printtable(VALUE *vTable)
   return Qtrue;
 }
 
+#define TAMU_ANOVA_TABLE_READER(field, conv) \
+static VALUE rb_tamu_anova_table_##field(VALUE obj) \
+{ \
+  struct tamu_anova_table *table; \
+  Data_Get_Struct(obj, struct tamu_anova_table, table); \
+  return conv(table->field); \
+}
+
+TAMU_ANOVA_TABLE_READER(dfTr, LONG2NUM)
+TAMU_ANOVA_TABLE_READER(dfE, LONG2NUM)
+TAMU_ANOVA_TABLE_READER(dfT, LONG2NUM)
+TAMU_ANOVA_TABLE_READER(SSTr, rb_float_new)
+TAMU_ANOVA_TABLE_READER(SSE, rb_float_new)
+TAMU_ANOVA_TABLE_READER(SST, rb_float_new)
+TAMU_ANOVA_TABLE_READER(MSTr, rb_float_new)
+TAMU_ANOVA_TABLE_READER(MSE, rb_float_new)
+TAMU_ANOVA_TABLE_READER(F, rb_float_new)
+TAMU_ANOVA_TABLE_READER(p, rb_float_new)
+
+static VALUE rb_tamu_anova_accum_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  long J, ncols = 1;
+  switch (argc) {
+  case 2:
+    ncols = NUM2LONG(argv[1]);
+    /* no break */
+  case 1:
+    J = NUM2LONG(argv[0]);
+    break;
+  default:
+    rb_raise(rb_eArgError, "Wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  if (J < 2) rb_raise(rb_eArgError, "at least 2 groups expected");
+  if (ncols < 1) rb_raise(rb_eArgError, "at least 1 column expected");
+  return Data_Wrap_Struct(klass, 0, mygsl_anova_accum_free,
+			  mygsl_anova_accum_alloc(J, ncols));
+}
+
+static VALUE rb_tamu_anova_accum_add(VALUE obj, VALUE x, VALUE factor)
+{
+  mygsl_anova_accum *a;
+  Data_Get_Struct(obj, mygsl_anova_accum, a);
+  anova_accum_add_value(a, x, factor);
+  return obj;
+}
+
+static VALUE rb_tamu_anova_accum_reset(VALUE obj)
+{
+  mygsl_anova_accum *a;
+  Data_Get_Struct(obj, mygsl_anova_accum, a);
+  mygsl_anova_accum_reset(a);
+  return obj;
+}
+
+static VALUE rb_tamu_anova_accum_n(VALUE obj)
+{
+  mygsl_anova_accum *a;
+  gsl_vector_int *n;
+  size_t j;
+  Data_Get_Struct(obj, mygsl_anova_accum, a);
+  n = gsl_vector_int_alloc(a->J);
+  for (j = 0; j < a->J; j++) gsl_vector_int_set(n, j, (int) a->n[j]);
+  return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, n);
+}
+
+static VALUE rb_tamu_anova_accum_table(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_anova_accum *a;
+  long c = 0;
+  Data_Get_Struct(obj, mygsl_anova_accum, a);
+  if (argc > 1) rb_raise(rb_eArgError, "Wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) c = NUM2LONG(argv[0]);
+  if (c < 0) c += a->ncols;
+  if (c < 0 || c >= (long) a->ncols) rb_raise(rb_eIndexError, "column out of range");
+  return anova_table_new(a, c);
+}
+
+static VALUE rb_tamu_anova_accum_tables(VALUE obj)
+{
+  mygsl_anova_accum *a;
+  Data_Get_Struct(obj, mygsl_anova_accum, a);
+  return anova_tables(a);
+}
+
+/* The F statistics, or the p-values, of all columns as a Vector */
+static VALUE rb_tamu_anova_accum_stat(VALUE obj, int p)
+{
+  mygsl_anova_accum *a;
+  struct tamu_anova_table t;
+  gsl_vector *v;
+  size_t c;
+  Data_Get_Struct(obj, mygsl_anova_accum, a);
+  v = gsl_vector_alloc(a->ncols);
+  for (c = 0; c < a->ncols; c++) {
+    mygsl_anova_accum_table(a, c, &t);
+    gsl_vector_set(v, c, p ? t.p : t.F);
+  }
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE rb_tamu_anova_accum_F(VALUE obj)
+{
+  return rb_tamu_anova_accum_stat(obj, 0);
+}
+
+static VALUE rb_tamu_anova_accum_p(VALUE obj)
+{
+  return rb_tamu_anova_accum_stat(obj, 1);
+}
+
 #endif
 
 void Init_tamu_anova(VALUE module)
 {
 #ifdef HAVE_TAMU_ANOVA_TAMU_ANOVA_H
   VALUE mTAMU_ANOVA;
-  VALUE cTable;
+  VALUE cTable, cAccum;
 
   mTAMU_ANOVA = rb_define_module_under(module, "TAMU_ANOVA");
-  cTable = rb_define_class_under(mTAMU_ANOVA, "Table", cGSL_Object);
+  cgsl_tamu_anova_table = cTable = rb_define_class_under(mTAMU_ANOVA, "Table", cGSL_Object);
+  cgsl_tamu_anova_accum = cAccum = rb_define_class_under(mTAMU_ANOVA, "Accumulator",
+							 cGSL_Object);
 
   rb_define_singleton_method(cTable, "alloc", rb_tamu_anova_alloc, -1);
   rb_define_singleton_method(cTable, "oneway", rb_tamu_anova_alloc, -1);
 
   rb_define_method(cTable, "print", rb_tamu_anova_printtable, 0);
+  rb_define_method(cTable, "dfTr", rb_tamu_anova_table_dfTr, 0);
+  rb_define_method(cTable, "dfE", rb_tamu_anova_table_dfE, 0);
+  rb_define_method(cTable, "dfT", rb_tamu_anova_table_dfT, 0);
+  rb_define_method(cTable, "SSTr", rb_tamu_anova_table_SSTr, 0);
+  rb_define_method(cTable, "SSE", rb_tamu_anova_table_SSE, 0);
+  rb_define_method(cTable, "SST", rb_tamu_anova_table_SST, 0);
+  rb_define_method(cTable, "MSTr", rb_tamu_anova_table_MSTr, 0);
+  rb_define_method(cTable, "MSE", rb_tamu_anova_table_MSE, 0);
+  rb_define_method(cTable, "F", rb_tamu_anova_table_F, 0);
+  rb_define_method(cTable, "p", rb_tamu_anova_table_p, 0);
+
+  rb_define_singleton_method(cAccum, "alloc", rb_tamu_anova_accum_alloc, -1);
+  rb_define_method(cAccum, "add", rb_tamu_anova_accum_add, 2);
+  rb_define_method(cAccum, "reset", rb_tamu_anova_accum_reset, 0);
+  rb_define_method(cAccum, "n", rb_tamu_anova_accum_n, 0);
+  rb_define_method(cAccum, "table", rb_tamu_anova_accum_table, -1);
+  rb_define_method(cAccum, "tables", rb_tamu_anova_accum_tables, 0);
+  rb_define_method(cAccum, "F", rb_tamu_anova_accum_F, 0);
+  rb_define_method(cAccum, "p", rb_tamu_anova_accum_p, 0);
 #endif
 }
@@ -18,6 +18,7 @@
 
 #include "rb_gsl_config.h"
 #include "rb_gsl_tensor.h"
+#include "rb_gsl_fft.h"
 
 #ifdef HAVE_NARRAY_H
 #include "rb_gsl_with_narray.h"
@@ -340,17 +340,343 @@ static VALUE FUNCTION(rb_tensor,fscanf)(VALUE obj, VALUE io)
   return INT2FIX(status);
 }
 
+/*
+  Index permutation and contraction.  The data of a tensor of rank r
+  and dimension d is stored in row-major order, axis k with the stride
+  d**(r-1-k), so a permutation is a strided copy and a contraction of
+  two tensors is, once the contracted axes of a are permuted last and
+  those of b first, a matrix product (dgemm for Tensor).
+*/
+#ifdef BASE_DOUBLE
+#define RB_TENSOR_MAX_RANK 32
+#define RB_TENSOR_TILE 32
+
+/* The matrix product c = a b of (m x k) (k x n), split over rows */
+struct rb_tensor_gemm {
+  const void *a, *b;
+  void *c;
+  size_t m, n, k;
+  size_t nthreads;
+};
+
+/* Section of the tensor data copied with the indices permuted */
+struct rb_tensor_permute {
+  const void *src;
+  void *dst;
+  unsigned int rank;
+  size_t dim;
+  const size_t *perm;
+};
+
+static void rb_tensor_strides(unsigned int rank, size_t dim, size_t *stride)
+{
+  unsigned int k;
+  size_t s = 1;
+  for (k = rank; k-- > 0;) {
+    stride[k] = s;
+    s *= dim;
+  }
+}
+
+static void rb_tensor_check_rank(unsigned int rank)
+{
+  if (rank > RB_TENSOR_MAX_RANK)
+    rb_raise(rb_eArgError, "tensor of rank %d (at most %d)", (int) rank, RB_TENSOR_MAX_RANK);
+}
+
+/* The axes in ary (an Integer or an Array), distinct and below rank;
+   returns their number */
+static size_t rb_tensor_get_axes(VALUE ary, unsigned int rank, size_t *axes, char *used)
+{
+  size_t n, i;
+  long k;
+  if (FIXNUM_P(ary)) ary = rb_ary_new3(1, ary);
+  Check_Type(ary, T_ARRAY);
+  n = RARRAY_LEN(ary);
+  if (n > rank)
+    rb_raise(rb_eArgError, "%d axes for a tensor of rank %d", (int) n, (int) rank);
+  for (i = 0; i < n; i++) {
+    k = NUM2LONG(rb_ary_entry(ary, i));
+    if (k < 0 || k >= (long) rank || used[k])
+      rb_raise(rb_eArgError, "invalid axis %ld for a tensor of rank %d", k, (int) rank);
+    used[k] = 1;
+    axes[i] = (size_t) k;
+  }
+  return n;
+}
+
+static int rb_tensor_perm_identity(const size_t *perm, unsigned int rank)
+{
+  unsigned int k;
+  for (k = 0; k < rank; k++) if (perm[k] != k) return 0;
+  return 1;
+}
+#endif
+
+/* dst axis k is src axis perm[k]: the runs along the last axis of src
+   are copied contiguously if it stays last, else in tiles of the two
+   last axes of src and dst, so both sides are read and written by cache
+   lines */
+static void FUNCTION(rb_tensor,permute_data)(const BASE *src, BASE *dst, unsigned int rank,
+					     size_t dim, const size_t *perm)
+{
+  size_t sstr[RB_TENSOR_MAX_RANK], dstr[RB_TENSOR_MAX_RANK], ss[RB_TENSOR_MAX_RANK];
+  size_t ax[RB_TENSOR_MAX_RANK], idx[RB_TENSOR_MAX_RANK];
+  size_t os = 0, od = 0, q = 0, sq, i, j, i0, j0, i1, j1;
+  unsigned int k, na = 0;
+  int m;
+  if (rank == 0 || dim <= 1) {
+    memcpy(dst, src, sizeof(BASE)*(rank == 0 ? 1 : dim));
+    return;
+  }
+  rb_tensor_strides(rank, dim, sstr);
+  rb_tensor_strides(rank, dim, dstr);
+  for (k = 0; k < rank; k++) {
+    ss[k] = sstr[perm[k]];
+    if (perm[k] == rank - 1) q = k;
+  }
+  for (k = 0; k + 1 < rank; k++) if (k != q) ax[na++] = k;
+  memset(idx, 0, sizeof(idx));
+  sq = ss[rank-1];
+  for (;;) {
+    if (q == rank - 1) {
+      memcpy(dst + od, src + os, sizeof(BASE)*dim);
+    } else {
+      for (i0 = 0; i0 < dim; i0 += RB_TENSOR_TILE) {
+	i1 = GSL_MIN(i0 + RB_TENSOR_TILE, dim);
+	for (j0 = 0; j0 < dim; j0 += RB_TENSOR_TILE) {
+	  j1 = GSL_MIN(j0 + RB_TENSOR_TILE, dim);
+	  for (j = j0; j < j1; j++)
+	    for (i = i0; i < i1; i++)
+	      dst[od + i*dstr[q] + j] = src[os + i + j*sq];
+	}
+      }
+    }
+    for (m = (int) na - 1; m >= 0; m--) {
+      k = ax[m];
+      os += ss[k];
+      od += dstr[k];
+      if (++idx[m] < dim) break;
+      os -= dim*ss[k];
+      od -= dim*dstr[k];
+      idx[m] = 0;
+    }
+    if (m < 0) break;
+  }
+}
+
+static int FUNCTION(rb_tensor,permute_call)(void *data)
+{
+  struct rb_tensor_permute *p = (struct rb_tensor_permute *) data;
+  FUNCTION(rb_tensor,permute_data)((const BASE *) p->src, (BASE *) p->dst, p->rank,
+				   p->dim, p->perm);
+  return GSL_SUCCESS;
+}
+
+static void FUNCTION(rb_tensor,permute0)(const BASE *src, BASE *dst, unsigned int rank,
+					 size_t dim, const size_t *perm, size_t size)
+{
+  struct rb_tensor_permute p;
+  p.src = src;
+  p.dst = dst;
+  p.rank = rank;
+  p.dim = dim;
+  p.perm = perm;
+  rb_gsl_nogvl_call(FUNCTION(rb_tensor,permute_call), &p, size);
+}
+
+/* rows [i0, i1) of c = a b */
+static void FUNCTION(rb_tensor,gemm_rows)(struct rb_tensor_gemm *g, size_t i0, size_t i1)
+{
+#ifdef BASE_DOUBLE
+  gsl_matrix_const_view A, B;
+  gsl_matrix_view C;
+  if (i1 <= i0) return;
+  A = gsl_matrix_const_view_array((const double *) g->a + i0*g->k, i1 - i0, g->k);
+  B = gsl_matrix_const_view_array((const double *) g->b, g->k, g->n);
+  C = gsl_matrix_view_array((double *) g->c + i0*g->n, i1 - i0, g->n);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &A.matrix, &B.matrix, 0.0, &C.matrix);
+#else
+  const BASE *a = (const BASE *) g->a, *b = (const BASE *) g->b;
+  BASE *c = (BASE *) g->c, x;
+  size_t i, j, l, l0, l1;
+  for (i = i0; i < i1; i++) memset(c + i*g->n, 0, sizeof(BASE)*g->n);
+  for (l0 = 0; l0 < g->k; l0 += RB_TENSOR_TILE) {
+    l1 = GSL_MIN(l0 + RB_TENSOR_TILE, g->k);
+    for (i = i0; i < i1; i++) {
+      for (l = l0; l < l1; l++) {
+	x = a[i*g->k + l];
+	if (x == 0) continue;
+	for (j = 0; j < g->n; j++) c[i*g->n + j] += x*b[l*g->n + j];
+      }
+    }
+  }
+#endif
+}
+
+static int FUNCTION(rb_tensor,gemm_worker)(void *data, size_t id)
+{
+  struct rb_tensor_gemm *g = (struct rb_tensor_gemm *) data;
+  size_t rows = (g->m + g->nthreads - 1)/g->nthreads;
+  FUNCTION(rb_tensor,gemm_rows)(g, id*rows, GSL_MIN((id + 1)*rows, g->m));
+  return GSL_SUCCESS;
+}
+
+static int FUNCTION(rb_tensor,gemm_serial)(void *data)
+{
+  struct rb_tensor_gemm *g = (struct rb_tensor_gemm *) data;
+  FUNCTION(rb_tensor,gemm_rows)(g, 0, g->m);
+  return GSL_SUCCESS;
+}
+
+static GSL_TYPE(rbgsl_tensor)* FUNCTION(rb_tensor,alloc_wrap)(unsigned int rank, size_t dim,
+							       VALUE *v)
+{
+  GSL_TYPE(rbgsl_tensor) *t;
+  t = FUNCTION(rbgsl_tensor,alloc)(rank, dim);
+  *v = Data_Wrap_Struct(GSL_TYPE(cgsl_tensor), 0, FUNCTION(rbgsl_tensor,free), t);
+  return t;
+}
+
+/* The tensor with its indices permuted: axis k of the result is axis
+   perm[k] of t */
+static VALUE FUNCTION(rb_tensor,permute1)(GSL_TYPE(rbgsl_tensor) *t, const size_t *perm)
+{
+  GSL_TYPE(rbgsl_tensor) *tnew;
+  VALUE vnew;
+  tnew = FUNCTION(rb_tensor,alloc_wrap)(t->tensor->rank, t->tensor->dimension, &vnew);
+  FUNCTION(rb_tensor,permute0)(t->tensor->data, tnew->tensor->data, t->tensor->rank,
+			       t->tensor->dimension, perm, t->tensor->size);
+  return vnew;
+}
+
+static VALUE FUNCTION(rb_tensor,permute)(VALUE obj, VALUE pp)
+{
+  GSL_TYPE(rbgsl_tensor) *t;
+  size_t perm[RB_TENSOR_MAX_RANK];
+  char used[RB_TENSOR_MAX_RANK];
+  unsigned int rank;
+  Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), t);
+  rank = t->tensor->rank;
+  rb_tensor_check_rank(rank);
+  memset(used, 0, sizeof(used));
+  if (rb_tensor_get_axes(pp, rank, perm, used) != rank)
+    rb_raise(rb_eArgError, "permutation of %d axes expected", (int) rank);
+  return FUNCTION(rb_tensor,permute1)(t, perm);
+}
+
+/*
+  sum over the pairs (ia[l], ib[l]) of axes of a and b: the free axes of
+  a, then those of b.  With no pairs, the tensor product.
+*/
+static VALUE FUNCTION(rb_tensor,contract2)(GSL_TYPE(rbgsl_tensor) *a, GSL_TYPE(rbgsl_tensor) *b,
+					   VALUE ia, VALUE ib)
+{
+  GSL_TYPE(rbgsl_tensor) *c;
+  struct rb_tensor_gemm g;
+  size_t ca[RB_TENSOR_MAX_RANK], cb[RB_TENSOR_MAX_RANK];
+  size_t pa[RB_TENSOR_MAX_RANK], pb[RB_TENSOR_MAX_RANK];
+  char ua[RB_TENSOR_MAX_RANK], ub[RB_TENSOR_MAX_RANK];
+  unsigned int rank_a = a->tensor->rank, rank_b = b->tensor->rank, k;
+  size_t dim = a->tensor->dimension, nk = 0, l, m = 1, n = 1, kk = 1, work;
+  BASE *ta = NULL, *tb = NULL;
+  VALUE va = 0, vb = 0, vc;
+  rb_tensor_check_rank(rank_a);
+  rb_tensor_check_rank(rank_b);
+  if (b->tensor->dimension != dim)
+    rb_raise(rb_eArgError, "tensors of different dimensions (%d and %d)",
+	     (int) dim, (int) b->tensor->dimension);
+  memset(ua, 0, sizeof(ua));
+  memset(ub, 0, sizeof(ub));
+  if (!NIL_P(ia)) {
+    nk = rb_tensor_get_axes(ia, rank_a, ca, ua);
+    if (rb_tensor_get_axes(ib, rank_b, cb, ub) != nk)
+      rb_raise(rb_eArgError, "different numbers of axes to contract");
+  }
+  for (k = 0, l = 0; k < rank_a; k++) if (!ua[k]) pa[l++] = k;
+  for (k = 0; k < nk; k++) pa[l++] = ca[k];
+  for (k = 0, l = 0; k < nk; k++) pb[l++] = cb[k];
+  for (k = 0; k < rank_b; k++) if (!ub[k]) pb[l++] = k;
+  for (k = 0; k < rank_a - nk; k++) m *= dim;
+  for (k = 0; k < nk; k++) kk *= dim;
+  for (k = 0; k < rank_b - nk; k++) n *= dim;
+  c = FUNCTION(rb_tensor,alloc_wrap)(rank_a + rank_b - 2*nk, dim, &vc);
+  g.a = a->tensor->data;
+  g.b = b->tensor->data;
+  if (!rb_tensor_perm_identity(pa, rank_a)) {
+    ta = ALLOCV_N(BASE, va, a->tensor->size);
+    FUNCTION(rb_tensor,permute0)(a->tensor->data, ta, rank_a, dim, pa, a->tensor->size);
+    g.a = ta;
+  }
+  if (!rb_tensor_perm_identity(pb, rank_b)) {
+    tb = ALLOCV_N(BASE, vb, b->tensor->size);
+    FUNCTION(rb_tensor,permute0)(b->tensor->data, tb, rank_b, dim, pb, b->tensor->size);
+    g.b = tb;
+  }
+  g.c = c->tensor->data;
+  g.m = m;
+  g.n = n;
+  g.k = kk;
+  work = m*n*kk;
+  g.nthreads = rb_gsl_parallel_nthreads(work, m);
+  if (g.nthreads > 1) rb_gsl_nogvl_parallel(FUNCTION(rb_tensor,gemm_worker), &g, g.nthreads);
+  else rb_gsl_nogvl_call(FUNCTION(rb_tensor,gemm_serial), &g, work);
+  if (ta) ALLOCV_END(va);
+  if (tb) ALLOCV_END(vb);
+  return vc;
+}
+
+/* The sum over i = j of the axes i and j of t */
+static VALUE FUNCTION(rb_tensor,trace)(GSL_TYPE(rbgsl_tensor) *t, long i, long j)
+{
+  GSL_TYPE(rbgsl_tensor) *c;
+  size_t str[RB_TENSOR_MAX_RANK], ax[RB_TENSOR_MAX_RANK], idx[RB_TENSOR_MAX_RANK];
+  size_t dim = t->tensor->dimension, os = 0, o = 0, step, l;
+  unsigned int rank = t->tensor->rank, k, na = 0;
+  const BASE *src = t->tensor->data;
+  BASE *dst, s;
+  VALUE vc;
+  int m;
+  rb_tensor_check_rank(rank);
+  if (i < 0 || j < 0 || i >= (long) rank || j >= (long) rank || i == j)
+    rb_raise(rb_eArgError, "invalid axes %ld, %ld for a tensor of rank %d", i, j, (int) rank);
+  c = FUNCTION(rb_tensor,alloc_wrap)(rank - 2, dim, &vc);
+  dst = c->tensor->data;
+  rb_tensor_strides(rank, dim, str);
+  step = str[i] + str[j];
+  for (k = 0; k < rank; k++) if (k != (unsigned int) i && k != (unsigned int) j) ax[na++] = k;
+  memset(idx, 0, sizeof(idx));
+  for (;;) {
+    s = 0;
+    for (l = 0; l < dim; l++) s += src[os + l*step];
+    dst[o++] = s;
+    for (m = (int) na - 1; m >= 0; m--) {
+      os += str[ax[m]];
+      if (++idx[m] < dim) break;
+      os -= dim*str[ax[m]];
+      idx[m] = 0;
+    }
+    if (m < 0) break;
+  }
+  return vc;
+}
 static VALUE FUNCTION(rb_tensor,swap_indices)(VALUE obj, VALUE ii, VALUE jj)
 {
-  GSL_TYPE(rbgsl_tensor) *t, *tnew;
+  GSL_TYPE(rbgsl_tensor) *t;
+  size_t perm[RB_TENSOR_MAX_RANK];
+  unsigned int rank, k;
+  long i, j;
   Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), t);
-  tnew = ALLOC(GSL_TYPE(rbgsl_tensor));
-  if (t->tensor->rank == 0) 
-    tnew->indices = gsl_permutation_alloc(1);
-  else
-    tnew->indices = gsl_permutation_alloc(t->tensor->rank);
-  tnew->tensor = FUNCTION(tensor,swap_indices)(t->tensor, FIX2INT(ii), FIX2INT(jj));
-  return Data_Wrap_Struct(GSL_TYPE(cgsl_tensor), 0, FUNCTION(rbgsl_tensor,free), tnew);
+  rank = t->tensor->rank;
+  rb_tensor_check_rank(rank);
+  i = NUM2LONG(ii);
+  j = NUM2LONG(jj);
+  if (i < 0 || j < 0 || i >= (long) rank || j >= (long) rank)
+    rb_raise(rb_eArgError, "invalid axes %ld, %ld for a tensor of rank %d", i, j, (int) rank);
+  for (k = 0; k < rank; k++) perm[k] = k;
+  perm[i] = j;
+  perm[j] = i;
+  return FUNCTION(rb_tensor,permute1)(t, perm);
 }
 
 static VALUE FUNCTION(rb_tensor,max)(VALUE obj)
@@ -427,14 +753,100 @@ static VALUE FUNCTION(rb_tensor,isnull2)(VALUE obj)
   else return Qfalse;
 }
 
+/*
+  Broadcasting: the operand of lower rank, or a Vector of dimension**k
+  elements, is repeated along the leading axes of the other, as its
+  data is a run of whole blocks of the smaller one.  Nothing expanded
+  is allocated.
+*/
+#ifdef BASE_DOUBLE
+#define RB_TENSOR_BCAST(OP) \
+  for (i0 = 0; i0 < n; i0 += m) \
+    for (j = 0; j < m; j++) \
+      c[i0 + j] = a[(na == n ? i0 + j : j)*sa] OP b[(nb == n ? i0 + j : j)*sb]
+
+/* the rank k such that n = dim**k, or -1 */
+static int rb_tensor_size_rank(size_t n, size_t dim)
+{
+  int k = 0;
+  if (dim <= 1) return n == 1 ? 0 : -1;
+  while (n > 1 && n % dim == 0) {
+    n /= dim;
+    k++;
+  }
+  return n == 1 ? k : -1;
+}
+#endif
+
+/* c[i] = a[i] op b[i] with the smaller of a and b repeated */
+static void FUNCTION(rb_tensor,broadcast)(BASE *c, const BASE *a, size_t na, size_t sa,
+					  const BASE *b, size_t nb, size_t sb, int flag)
+{
+  size_t n = GSL_MAX(na, nb), m = GSL_MIN(na, nb), i0, j;
+  switch (flag) {
+  case TENSOR_ADD: RB_TENSOR_BCAST(+); break;
+  case TENSOR_SUB: RB_TENSOR_BCAST(-); break;
+  case TENSOR_MUL_ELEMENTS: RB_TENSOR_BCAST(*); break;
+  case TENSOR_DIV_ELEMENTS: RB_TENSOR_BCAST(/); break;
+  }
+}
+
+/* The data, size and stride of a tensor or vector operand bb of a
+   tensor of dimension dim, if it is to be broadcast (its shape differs
+   from that of a); returns 0 otherwise */
+static int FUNCTION(rb_tensor,broadcast_operand)(const GSL_TYPE(rbgsl_tensor) *a, VALUE bb,
+						 int inplace, BASE **data, size_t *n,
+						 size_t *stride)
+{
+  GSL_TYPE(rbgsl_tensor) *b;
+  GSL_TYPE(gsl_vector) *v;
+  int k;
+  if (TEN_P(bb)) {
+    Data_Get_Struct(bb, GSL_TYPE(rbgsl_tensor), b);
+    if (b->tensor->rank == a->tensor->rank) return 0;
+    if (b->tensor->dimension != a->tensor->dimension)
+      rb_raise(rb_eArgError, "tensors of different dimensions (%d and %d)",
+	       (int) a->tensor->dimension, (int) b->tensor->dimension);
+    *data = b->tensor->data;
+    *n = b->tensor->size;
+    *stride = 1;
+  } else if (VEC_P(bb)) {
+    Data_Get_Struct(bb, GSL_TYPE(gsl_vector), v);
+    k = rb_tensor_size_rank(v->size, a->tensor->dimension);
+    if (k < 0)
+      rb_raise(rb_eArgError, "vector of %d elements for a tensor of dimension %d",
+	       (int) v->size, (int) a->tensor->dimension);
+    *data = v->data;
+    *n = v->size;
+    *stride = v->stride;
+  } else {
+    return 0;
+  }
+  if (inplace && *n > a->tensor->size)
+    rb_raise(rb_eArgError, "operand of higher rank than the receiver");
+  return 1;
+}
+
 static VALUE FUNCTION(rb_tensor,oper)(VALUE obj, VALUE bb,
 					   int flag)
 {
   GSL_TYPE(rbgsl_tensor) *a, *b, *anew;
-  BASE x;
+  BASE x, *bdata;
+  size_t nb, sb;
   int (*f)(GSL_TYPE(tensor)*, const GSL_TYPE(tensor)*);
   int (*f2)(GSL_TYPE(tensor)*, const double);
   Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), a);
+  if (flag <= TENSOR_DIV_ELEMENTS
+      && FUNCTION(rb_tensor,broadcast_operand)(a, bb, 0, &bdata, &nb, &sb)) {
+    if (nb > a->tensor->size)
+      anew = FUNCTION(rbgsl_tensor,alloc)(rb_tensor_size_rank(nb, a->tensor->dimension),
+					  a->tensor->dimension);
+    else
+      anew = FUNCTION(rbgsl_tensor,alloc)(a->tensor->rank, a->tensor->dimension);
+    FUNCTION(rb_tensor,broadcast)(anew->tensor->data, a->tensor->data, a->tensor->size, 1,
+				  bdata, nb, sb, flag);
+    return Data_Wrap_Struct(GSL_TYPE(cgsl_tensor), 0, FUNCTION(rbgsl_tensor,free), anew);
+  }
   anew = FUNCTION(rbgsl_tensor,copy)(a);
   if (TEN_P(bb)) {
     Data_Get_Struct(bb, GSL_TYPE(rbgsl_tensor), b);
@@ -478,10 +890,17 @@ static VALUE FUNCTION(rb_tensor,oper)(VALUE obj, VALUE bb,
 static VALUE FUNCTION(rb_tensor,oper_bang)(VALUE obj, VALUE bb, int flag)
 {
   GSL_TYPE(rbgsl_tensor) *a, *b;
-  BASE x;
+  BASE x, *bdata;
+  size_t nb, sb;
   int (*f)(GSL_TYPE(tensor)*, const GSL_TYPE(tensor)*);
   int (*f2)(GSL_TYPE(tensor)*, const double);
   Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), a);
+  if (flag <= TENSOR_DIV_ELEMENTS
+      && FUNCTION(rb_tensor,broadcast_operand)(a, bb, 1, &bdata, &nb, &sb)) {
+    FUNCTION(rb_tensor,broadcast)(a->tensor->data, a->tensor->data, a->tensor->size, 1,
+				  bdata, nb, sb, flag);
+    return obj;
+  }
   if (TEN_P(bb)) {
     Data_Get_Struct(bb, GSL_TYPE(rbgsl_tensor), b);
     switch (flag) {
@@ -594,9 +1013,8 @@ static VALUE FUNCTION(rb_tensor,scale_bang)(VALUE obj, VALUE bb)
 /*****/
 static VALUE FUNCTION(rb_tensor,product_singleton)(VALUE obj, VALUE aa, VALUE bb)
 {
-  GSL_TYPE(rbgsl_tensor) *a, *b, *c;
+  GSL_TYPE(rbgsl_tensor) *a, *b;
   CHECK_TEN(aa);
-  CHECK_TEN(bb);
   Data_Get_Struct(aa, GSL_TYPE(rbgsl_tensor), a);
   switch (TYPE(bb)) {
   case T_FIXNUM:
@@ -605,53 +1023,39 @@ static VALUE FUNCTION(rb_tensor,product_singleton)(VALUE obj, VALUE aa, VALUE bb
     return FUNCTION(rb_tensor,mul_elements)(aa, bb);
     break;
   default:
+    CHECK_TEN(bb);
     Data_Get_Struct(bb, GSL_TYPE(rbgsl_tensor), b);
-    c = ALLOC(GSL_TYPE(rbgsl_tensor));
-    c->tensor = FUNCTION(tensor,product(a->tensor, b->tensor));
-    if (c->tensor->rank == 0)
-      c->indices = gsl_permutation_alloc(1);
-    else
-      c->indices = gsl_permutation_alloc(c->tensor->rank);
-    return Data_Wrap_Struct(GSL_TYPE(cgsl_tensor), 0, FUNCTION(rbgsl_tensor,free), c);
+    return FUNCTION(rb_tensor,contract2)(a, b, Qnil, Qnil);
     break;
   }
 }
 
 static VALUE FUNCTION(rb_tensor,product)(VALUE obj, VALUE bb)
 {
-  GSL_TYPE(rbgsl_tensor) *a, *b, *c;
-  switch (TYPE(bb)) {
-  case T_FIXNUM:
-  case T_BIGNUM:
-  case T_FLOAT:
-    return FUNCTION(rb_tensor,mul_elements)(obj, bb);
-    break;
-  default:
-    CHECK_TEN(bb);
-    Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), a);
-    Data_Get_Struct(bb, GSL_TYPE(rbgsl_tensor), b);
-    c = ALLOC(GSL_TYPE(rbgsl_tensor));
-    c->tensor = FUNCTION(tensor,product(a->tensor, b->tensor));
-    if (c->tensor->rank == 0)
-      c->indices = gsl_permutation_alloc(1);
-    else
-      c->indices = gsl_permutation_alloc(c->tensor->rank);
-    return Data_Wrap_Struct(GSL_TYPE(cgsl_tensor), 0, FUNCTION(rbgsl_tensor,free), c);
-    break;
-  }
+  return FUNCTION(rb_tensor,product_singleton)(GSL_TYPE(cgsl_tensor), obj, bb);
 }
 
-static VALUE FUNCTION(rb_tensor,contract)(VALUE obj, VALUE ii, VALUE jj)
+/* contract(i, j): the sum over the axes i = j;
+   contract(b, ia, ib): the sum over the pairs of axes ia[l] of self and
+   ib[l] of b */
+static VALUE FUNCTION(rb_tensor,contract)(int argc, VALUE *argv, VALUE obj)
 {
-  GSL_TYPE(rbgsl_tensor) *t, *tnew;
-  size_t rank;
+  GSL_TYPE(rbgsl_tensor) *t, *b;
   Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), t);
-  tnew = ALLOC(GSL_TYPE(rbgsl_tensor));
-  tnew->tensor = FUNCTION(tensor,contract)(t->tensor, FIX2INT(ii), FIX2INT(jj));
-  if (tnew->tensor->rank == 0) rank = 1;
-  else rank = tnew->tensor->rank;
-  tnew->indices = gsl_permutation_alloc(rank);
-  return Data_Wrap_Struct(GSL_TYPE(cgsl_tensor), 0, FUNCTION(rbgsl_tensor,free), tnew);
+  switch (argc) {
+  case 2:
+    return FUNCTION(rb_tensor,trace)(t, NUM2LONG(argv[0]), NUM2LONG(argv[1]));
+    break;
+  case 3:
+    CHECK_TEN(argv[0]);
+    Data_Get_Struct(argv[0], GSL_TYPE(rbgsl_tensor), b);
+    return FUNCTION(rb_tensor,contract2)(t, b, argv[1], argv[2]);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+    break;
+  }
+  return Qnil;
 }
 
 static VALUE FUNCTION(rb_tensor,size)(VALUE obj)
@@ -712,6 +1116,36 @@ static VALUE FUNCTION(rb_tensor,to_v)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_vector), 0, FUNCTION(gsl_vector,free), v);
 }
 
+#ifdef BASE_DOUBLE
+/* Three-dimensional FFT of a rank 3 tensor. Returns a GSL::Vector::Complex
+   of size dimension**3 in the index order of the tensor. */
+static VALUE rb_tensor_fft3_common(VALUE obj, int inverse)
+{
+  rbgsl_tensor *t;
+  gsl_vector_complex *v;
+  size_t i, dims[3];
+  Data_Get_Struct(obj, rbgsl_tensor, t);
+  if (t->tensor->rank != 3)
+    rb_raise(rb_eArgError, "rank 3 tensor expected (rank %d given)", 
+	     (int) t->tensor->rank);
+  v = gsl_vector_complex_calloc(t->tensor->size);
+  for (i = 0; i < t->tensor->size; i++) v->data[2*i] = t->tensor->data[i];
+  dims[0] = dims[1] = dims[2] = t->tensor->dimension;
+  rb_gsl_fft_complex_nd(v->data, 3, dims, inverse);
+  return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v);
+}
+
+static VALUE rb_tensor_fft3(VALUE obj)
+{
+  return rb_tensor_fft3_common(obj, 0);
+}
+
+static VALUE rb_tensor_ifft3(VALUE obj)
+{
+  return rb_tensor_fft3_common(obj, 1);
+}
+#endif
+
 /*
   Creates a subtensor slicing the existing tensor.
   NOTE: no new data region is malloced.
@@ -753,6 +1187,104 @@ static VALUE FUNCTION(rb_tensor,subtensor)(int argc, VALUE *argv, VALUE obj)
   return Data_Wrap_Struct(QUALIFIED_VIEW(cgsl_tensor,view), 0, FUNCTION(rbgsl_tensor,free2), tnew);	       
 }
 
+/*
+  slice(s0, s1, ...): one argument per leading axis, an Integer fixing
+  the index, nil for the whole axis, a Range, or [range, step].  One or
+  two free axes give a GSL::Vector::View or GSL::Matrix::View with the
+  strides of the tensor data (for a matrix, the last free axis must be
+  the last axis, with step 1); more free axes must be whole trailing
+  axes, and give a Tensor::View as subtensor.
+*/
+static VALUE FUNCTION(rb_tensor,slice)(int argc, VALUE *argv, VALUE obj)
+{
+  GSL_TYPE(rbgsl_tensor) *t, *tnew;
+  QUALIFIED_VIEW(gsl_vector,view) *vv;
+  QUALIFIED_VIEW(gsl_matrix,view) *mv;
+  size_t str[RB_TENSOR_MAX_RANK], fn[RB_TENSOR_MAX_RANK], fs[RB_TENSOR_MAX_RANK];
+  size_t fax[RB_TENSOR_MAX_RANK], lead[RB_TENSOR_MAX_RANK];
+  size_t dim, offset = 0, nfree = 0, nlead = 0, k;
+  unsigned int rank;
+  long beg, len, step, i;
+  VALUE spec, vstep, v;
+  Data_Get_Struct(obj, GSL_TYPE(rbgsl_tensor), t);
+  rank = t->tensor->rank;
+  dim = t->tensor->dimension;
+  rb_tensor_check_rank(rank);
+  if ((unsigned int) argc > rank)
+    rb_raise(rb_eArgError, "%d indices for a tensor of rank %d", argc, (int) rank);
+  rb_tensor_strides(rank, dim, str);
+  for (k = 0; k < rank; k++) {
+    spec = (long) k < argc ? argv[k] : Qnil;
+    step = 1;
+    if (TYPE(spec) == T_ARRAY) {
+      vstep = rb_ary_entry(spec, 1);
+      spec = rb_ary_entry(spec, 0);
+      step = NIL_P(vstep) ? 1 : NUM2LONG(vstep);
+      if (step < 1) rb_raise(rb_eArgError, "step must be positive");
+    }
+    if (NIL_P(spec) || spec == Qtrue) {
+      beg = 0;
+      len = (long) dim;
+    } else if (rb_obj_is_kind_of(spec, rb_cRange)) {
+      if (rb_range_beg_len(spec, &beg, &len, (long) dim, 1) != Qtrue)
+	rb_raise(rb_eRangeError, "range out of axis %d", (int) k);
+    } else {
+      i = NUM2LONG(spec);
+      if (i < 0) i += (long) dim;
+      if (i < 0 || i >= (long) dim)
+	rb_raise(rb_eRangeError, "index %ld out of axis %d", NUM2LONG(spec), (int) k);
+      offset += (size_t) i*str[k];
+      if (nfree == 0) lead[nlead++] = (size_t) i;
+      continue;
+    }
+    offset += (size_t) beg*str[k];
+    fax[nfree] = k;
+    fn[nfree] = (size_t) ((len + step - 1)/step);
+    fs[nfree] = (size_t) step*str[k];
+    nfree++;
+  }
+  switch (nfree) {
+  case 0:
+    return C_TO_VALUE(t->tensor->data[offset]);
+    break;
+  case 1:
+    vv = ALLOC(QUALIFIED_VIEW(gsl_vector,view));
+    vv->vector.data = t->tensor->data + offset;
+    vv->vector.size = fn[0];
+    vv->vector.stride = fs[0];
+    vv->vector.block = NULL;
+    vv->vector.owner = 0;
+    v = Data_Wrap_Struct(QUALIFIED_VIEW(cgsl_vector,view), 0, free, vv);
+    break;
+  case 2:
+    if (fs[1] != 1)
+      rb_raise(rb_eArgError, "the second free axis of a matrix slice must be the last axis, with step 1 (permute first)");
+    mv = ALLOC(QUALIFIED_VIEW(gsl_matrix,view));
+    mv->matrix.data = t->tensor->data + offset;
+    mv->matrix.size1 = fn[0];
+    mv->matrix.size2 = fn[1];
+    mv->matrix.tda = fs[0];
+    mv->matrix.block = NULL;
+    mv->matrix.owner = 0;
+    v = Data_Wrap_Struct(QUALIFIED_VIEW(cgsl_matrix,view), 0, free, mv);
+    break;
+  default:
+    for (k = 0; k < nfree; k++) {
+      if (nlead + nfree != rank || fax[k] != nlead + k || fn[k] != dim || fs[k] != str[fax[k]])
+	rb_raise(rb_eArgError, "slices of more than 2 axes must span whole trailing axes");
+    }
+    tnew = ALLOC(GSL_TYPE(rbgsl_tensor));
+    tnew->tensor = (GSL_TYPE(tensor)*) malloc(sizeof(GSL_TYPE(tensor)));
+    for (k = 0; k < t->indices->size; k++) t->indices->data[k] = k < nlead ? lead[k] : 0;
+    *(tnew->tensor) = FUNCTION(tensor,subtensor)(t->tensor, nfree, t->indices->data);
+    tnew->indices = gsl_permutation_alloc(nfree);
+    v = Data_Wrap_Struct(QUALIFIED_VIEW(cgsl_tensor,view), 0, FUNCTION(rbgsl_tensor,free2), tnew);
+    break;
+  }
+  rb_ivar_set(v, rb_intern("@tensor"), obj);
+  return v;
+}
+
 #ifdef BASE_DOUBLE
 #define SHOW_ELM 6
 #define PRINTF_FORMAT "%4.3e "
@@ -1008,6 +1540,8 @@ void FUNCTION(Init_tensor,init)(VALUE module)
 
   rb_define_method(GSL_TYPE(cgsl_tensor), "swap_indices",
 			     FUNCTION(rb_tensor,swap_indices), 2);
+  rb_define_method(GSL_TYPE(cgsl_tensor), "permute",
+			     FUNCTION(rb_tensor,permute), 1);
 
   rb_define_method(GSL_TYPE(cgsl_tensor), "max",
 			     FUNCTION(rb_tensor,max), 0);
@@ -1046,7 +1580,7 @@ void FUNCTION(Init_tensor,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_tensor), "product",
 			     FUNCTION(rb_tensor,product), 1);
   rb_define_method(GSL_TYPE(cgsl_tensor), "contract",
-			     FUNCTION(rb_tensor,contract), 2);
+			     FUNCTION(rb_tensor,contract), -1);
 
   rb_define_alias(GSL_TYPE(cgsl_tensor), "+", "add");
   rb_define_alias(GSL_TYPE(cgsl_tensor), "-", "sub");
@@ -1087,6 +1621,10 @@ void FUNCTION(Init_tensor,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_tensor), "to_v",
 			     FUNCTION(rb_tensor,to_v), 0);
   rb_define_alias(GSL_TYPE(cgsl_tensor), "to_gv", "to_v");
+#ifdef BASE_DOUBLE
+  rb_define_method(cgsl_tensor, "fft3", rb_tensor_fft3, 0);
+  rb_define_method(cgsl_tensor, "ifft3", rb_tensor_ifft3, 0);
+#endif
 
   rb_define_method(GSL_TYPE(cgsl_tensor), "to_vector",
 			     FUNCTION(rb_tensor,2vector), 0);
@@ -1096,6 +1634,8 @@ void FUNCTION(Init_tensor,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_tensor), "subtensor",
 			     FUNCTION(rb_tensor,subtensor), -1);
   rb_define_alias(GSL_TYPE(cgsl_tensor), "view", "subtensor");
+  rb_define_method(GSL_TYPE(cgsl_tensor), "slice",
+			     FUNCTION(rb_tensor,slice), -1);
 
   rb_define_method(GSL_TYPE(cgsl_tensor), "to_s",
 			     FUNCTION(rb_tensor,to_s), 0);
@@ -1106,8 +1646,7 @@ void FUNCTION(Init_tensor,init)(VALUE module)
 			     FUNCTION(rb_tensor,equal), -1);
   rb_define_alias(GSL_TYPE(cgsl_tensor), "==", "equal?");
 
-  rb_define_method(GSL_TYPE(cgsl_tensor), "coerce",
-			     FUNCTION(rb_tensor,coerce), 1);
+  rb_gsl_define_coerce(GSL_TYPE(cgsl_tensor), FUNCTION(rb_tensor,coerce));
 
   rb_define_method(GSL_TYPE(cgsl_tensor), "info", 
 		   FUNCTION(rb_tensor,info), 0);
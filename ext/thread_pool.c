@@ -0,0 +1,419 @@
+/*
+  thread_pool.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::ThreadPool: the native threads on which rb_gsl_nogvl_parallel()
+  runs the parts of every parallel kernel (reductions, vmath, transpose,
+  sorts, compiled MultiFit residuals, Monte.qmc, ...).  The workers are
+  started by the first parallel call and then wait for work, so that a
+  kernel no longer pays a thread creation per part.
+
+    GSL::ThreadPool.size            # threads, the caller included (CPUs)
+    GSL::ThreadPool.size = 4
+    GSL::ThreadPool.affinity = true # worker k on CPU k+1 (mod CPUs)
+    GSL::ThreadPool.blas = :keep    # or :serial, the default
+    GSL::ThreadPool.stats
+    #=> {:batches=>12, :parts=>96, :caller_parts=>20, :nested=>0,
+    #    :wait=>0.0012, :workers=>[{:parts=>10, :busy=>0.031}, ...]}
+    GSL::ThreadPool.reset_stats
+    GSL::ThreadPool.shutdown        # restarted by the next parallel call
+
+  The parts of a batch are queued; the idle workers and the thread which
+  submitted the batch take the next unclaimed part, the submitter until
+  none is left, so that a batch completes even while the workers are busy
+  with the batches of other Ruby threads.  A batch submitted from a part
+  already running on the pool runs serially on its thread.  With blas =
+  :serial a threaded BLAS backend (OpenBLAS, MKL, BLIS) is set to one
+  thread while batches run and restored after the last one, so that parts
+  calling BLAS do not oversubscribe the CPUs; :keep leaves it as set by
+  GSL::Blas.num_threads.  GSL.parallel_threads = 0 (the default) cuts
+  the work in ThreadPool.size parts.
+
+  In stats, busy is the time in seconds the worker spent in parts and
+  wait the time the submitters spent waiting for the parts taken by
+  workers once theirs were done.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_common.h"
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <sched.h>
+#endif
+
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL) && defined(HAVE_PTHREAD_H)
+#define POOL_THREADS
+#endif
+
+#define POOL_MAX_WORKERS 255
+
+struct pool_batch {
+  void (*task)(void *, size_t);
+  void *data;
+  size_t n, next, done;         /* parts, first unclaimed, finished */
+  int blas;                     /* the BLAS threads were lowered for it */
+  struct pool_batch *link;
+};
+
+struct pool_worker {
+  int running;                  /* a thread serves the slot */
+  size_t parts, busy;           /* parts run, ns spent in them */
+};
+
+static size_t pool_size = 0;    /* 0: the number of CPUs */
+static int pool_affinity = 0;
+static int pool_blas_serial = 1;
+static struct pool_worker pool_workers[POOL_MAX_WORKERS];
+static size_t pool_batches = 0, pool_caller_parts = 0, pool_nested = 0, pool_wait = 0;
+static RB_GSL_THREAD_LOCAL int pool_inside = 0;
+
+#ifdef POOL_THREADS
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static struct pool_batch *pool_queue = NULL; /* batches with unclaimed parts */
+static size_t pool_generation = 0;
+static int pool_blas_batches = 0, pool_blas_saved = 1;
+#define POOL_LOCK() pthread_mutex_lock(&pool_lock)
+#define POOL_UNLOCK() pthread_mutex_unlock(&pool_lock)
+#else
+#define POOL_LOCK()
+#define POOL_UNLOCK()
+#endif
+
+static size_t pool_ncpu(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0) return (size_t) n;
+#endif
+  return 1;
+}
+
+static size_t pool_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (size_t) ts.tv_sec*1000000000 + (size_t) ts.tv_nsec;
+#else
+  return (size_t) ((double) clock()*1e9/CLOCKS_PER_SEC);
+#endif
+}
+
+/* Threads running the parts of a batch, the submitting one included */
+size_t rb_gsl_thread_pool_size(void)
+{
+#ifdef POOL_THREADS
+  size_t n = pool_size ? pool_size : pool_ncpu();
+  return n > POOL_MAX_WORKERS + 1 ? POOL_MAX_WORKERS + 1 : n;
+#else
+  return 1;
+#endif
+}
+
+#ifdef POOL_THREADS
+/* From here on, the functions are called with pool_lock held */
+
+static void pool_unlink(struct pool_batch *b)
+{
+  struct pool_batch **p;
+  for (p = &pool_queue; *p; p = &(*p)->link) {
+    if (*p == b) {
+      *p = b->link;
+      return;
+    }
+  }
+}
+
+/* The next part of b, which leaves the queue with its last one */
+static size_t pool_claim(struct pool_batch *b)
+{
+  size_t k = b->next++;
+  if (b->next == b->n) pool_unlink(b);
+  return k;
+}
+
+static void pool_blas_enter(struct pool_batch *b)
+{
+  b->blas = pool_blas_serial;
+  if (!b->blas || pool_blas_batches++ > 0) return;
+  pool_blas_saved = mygsl_blas_get_num_threads();
+  if (pool_blas_saved > 1) mygsl_blas_set_num_threads(1);
+}
+
+static void pool_blas_leave(struct pool_batch *b)
+{
+  if (!b->blas || --pool_blas_batches > 0) return;
+  if (pool_blas_saved > 1) mygsl_blas_set_num_threads(pool_blas_saved);
+}
+
+static void pool_pin(size_t id)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET((int) ((id + 1) % pool_ncpu()), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+static void* pool_main(void *p)
+{
+  size_t id = (size_t) p, gen, k, t0;
+  struct pool_batch *b;
+  pool_inside = 1;
+  POOL_LOCK();
+  gen = pool_generation;
+  if (pool_affinity) pool_pin(id);
+  while (gen == pool_generation && id + 1 < rb_gsl_thread_pool_size()) {
+    if ((b = pool_queue) == NULL) {
+      pthread_cond_wait(&pool_work, &pool_lock);
+      continue;
+    }
+    k = pool_claim(b);
+    POOL_UNLOCK();
+    t0 = pool_now();
+    (*b->task)(b->data, k);
+    t0 = pool_now() - t0;
+    POOL_LOCK();
+    pool_workers[id].parts++;
+    pool_workers[id].busy += t0;
+    if (++b->done == b->n) pthread_cond_broadcast(&pool_done);
+  }
+  pool_workers[id].running = 0;
+  POOL_UNLOCK();
+  return NULL;
+}
+
+/* Starts the missing workers; those of an older generation, still
+   leaving, are replaced by a later batch */
+static void pool_start(void)
+{
+  pthread_attr_t attr;
+  pthread_t th;
+  size_t id, nw = rb_gsl_thread_pool_size() - 1;
+  if (pthread_attr_init(&attr) != 0) return;
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  for (id = 0; id < nw; id++) {
+    if (pool_workers[id].running) continue;
+    if (pthread_create(&th, &attr, pool_main, (void *) id) != 0) break;
+    pool_workers[id].running = 1;
+  }
+  pthread_attr_destroy(&attr);
+}
+
+/* The threads are gone in a forked child, and the lock may be held */
+static void pool_atfork_child(void)
+{
+  size_t id;
+  pthread_mutex_init(&pool_lock, NULL);
+  pthread_cond_init(&pool_work, NULL);
+  pthread_cond_init(&pool_done, NULL);
+  pool_queue = NULL;
+  pool_blas_batches = 0;
+  for (id = 0; id < POOL_MAX_WORKERS; id++) pool_workers[id].running = 0;
+}
+#endif
+
+/*
+  Runs task(data, k) for k = 0 ... n-1 on the workers of the pool and on
+  the calling thread, and returns once all of them have; called without
+  the GVL (from rb_gsl_nogvl_parallel()).  Serial when the pool has no
+  threads or the caller is itself running a part.
+*/
+void rb_gsl_thread_pool_run(void (*task)(void *, size_t), void *data, size_t n)
+{
+  size_t k;
+#ifdef POOL_THREADS
+  struct pool_batch b, **p;
+  size_t t0;
+  int inside = pool_inside;
+  if (n > 1 && !inside && rb_gsl_thread_pool_size() > 1) {
+    b.task = task;
+    b.data = data;
+    b.n = n;
+    b.next = 0;
+    b.done = 0;
+    b.link = NULL;
+    pool_inside = 1;
+    POOL_LOCK();
+    pool_start();
+    pool_blas_enter(&b);
+    for (p = &pool_queue; *p; p = &(*p)->link);
+    *p = &b;
+    pool_batches++;
+    pthread_cond_broadcast(&pool_work);
+    while (b.next < b.n) {
+      k = pool_claim(&b);
+      POOL_UNLOCK();
+      (*task)(data, k);
+      POOL_LOCK();
+      pool_caller_parts++;
+      b.done++;
+    }
+    t0 = pool_now();
+    while (b.done < b.n) pthread_cond_wait(&pool_done, &pool_lock);
+    pool_wait += pool_now() - t0;
+    pool_blas_leave(&b);
+    POOL_UNLOCK();
+    pool_inside = inside;
+    return;
+  }
+  if (inside && n > 1) {
+    POOL_LOCK();
+    pool_nested++;
+    POOL_UNLOCK();
+  }
+#endif
+  for (k = 0; k < n; k++) (*task)(data, k);
+}
+
+static VALUE rb_gsl_thread_pool_size_get(VALUE module)
+{
+  return SIZET2NUM(rb_gsl_thread_pool_size());
+}
+
+static VALUE rb_gsl_thread_pool_size_set(VALUE module, VALUE nn)
+{
+  size_t n = NUM2SIZET(nn);
+  if (n > POOL_MAX_WORKERS + 1)
+    rb_raise(rb_eArgError, "at most %d threads", POOL_MAX_WORKERS + 1);
+  POOL_LOCK();
+  pool_size = n;
+#ifdef POOL_THREADS
+  pthread_cond_broadcast(&pool_work);
+#endif
+  POOL_UNLOCK();
+  return nn;
+}
+
+/* Native threads currently serving the pool */
+static VALUE rb_gsl_thread_pool_workers(VALUE module)
+{
+  size_t id, n = 0;
+  POOL_LOCK();
+  for (id = 0; id < POOL_MAX_WORKERS; id++) if (pool_workers[id].running) n++;
+  POOL_UNLOCK();
+  return SIZET2NUM(n);
+}
+
+/* Stops the workers once they are idle; the next batch starts new ones */
+static VALUE rb_gsl_thread_pool_shutdown(VALUE module)
+{
+#ifdef POOL_THREADS
+  POOL_LOCK();
+  pool_generation++;
+  pthread_cond_broadcast(&pool_work);
+  POOL_UNLOCK();
+#endif
+  return Qnil;
+}
+
+static VALUE rb_gsl_thread_pool_affinity_get(VALUE module)
+{
+  return pool_affinity ? Qtrue : Qfalse;
+}
+
+/* Applies to the workers started afterwards: the running ones are
+   replaced */
+static VALUE rb_gsl_thread_pool_affinity_set(VALUE module, VALUE flag)
+{
+#ifndef HAVE_PTHREAD_SETAFFINITY_NP
+  if (RTEST(flag))
+    rb_raise(rb_eNotImpError, "thread affinity is not supported on this platform");
+#endif
+  pool_affinity = RTEST(flag) ? 1 : 0;
+  rb_gsl_thread_pool_shutdown(module);
+  return flag;
+}
+
+static VALUE rb_gsl_thread_pool_blas_get(VALUE module)
+{
+  return ID2SYM(rb_intern(pool_blas_serial ? "serial" : "keep"));
+}
+
+static VALUE rb_gsl_thread_pool_blas_set(VALUE module, VALUE mode)
+{
+  ID id = SYMBOL_P(mode) ? SYM2ID(mode) : 0;
+  if (id == rb_intern("serial")) pool_blas_serial = 1;
+  else if (id == rb_intern("keep")) pool_blas_serial = 0;
+  else rb_raise(rb_eArgError, "BLAS policy must be :serial or :keep");
+  return mode;
+}
+
+static VALUE rb_gsl_thread_pool_stats(VALUE module)
+{
+  struct pool_worker w[POOL_MAX_WORKERS];
+  VALUE h = rb_hash_new(), workers = rb_ary_new(), v;
+  size_t id, parts, nw, batches, caller_parts, nested, wait;
+  POOL_LOCK();
+  memcpy(w, pool_workers, sizeof(w));
+  batches = pool_batches;
+  caller_parts = pool_caller_parts;
+  nested = pool_nested;
+  wait = pool_wait;
+  POOL_UNLOCK();
+  parts = caller_parts;
+  nw = rb_gsl_thread_pool_size() - 1;
+  for (id = 0; id < POOL_MAX_WORKERS; id++) {
+    parts += w[id].parts;
+    if (id >= nw && w[id].parts == 0) continue;
+    v = rb_hash_new();
+    rb_hash_aset(v, ID2SYM(rb_intern("parts")), SIZET2NUM(w[id].parts));
+    rb_hash_aset(v, ID2SYM(rb_intern("busy")), rb_float_new(w[id].busy*1e-9));
+    rb_ary_store(workers, id, v);
+  }
+  rb_hash_aset(h, ID2SYM(rb_intern("batches")), SIZET2NUM(batches));
+  rb_hash_aset(h, ID2SYM(rb_intern("parts")), SIZET2NUM(parts));
+  rb_hash_aset(h, ID2SYM(rb_intern("caller_parts")), SIZET2NUM(caller_parts));
+  rb_hash_aset(h, ID2SYM(rb_intern("nested")), SIZET2NUM(nested));
+  rb_hash_aset(h, ID2SYM(rb_intern("wait")), rb_float_new(wait*1e-9));
+  rb_hash_aset(h, ID2SYM(rb_intern("workers")), workers);
+  return h;
+}
+
+static VALUE rb_gsl_thread_pool_reset_stats(VALUE module)
+{
+  size_t id;
+  POOL_LOCK();
+  for (id = 0; id < POOL_MAX_WORKERS; id++) {
+    pool_workers[id].parts = 0;
+    pool_workers[id].busy = 0;
+  }
+  pool_batches = pool_caller_parts = pool_nested = pool_wait = 0;
+  POOL_UNLOCK();
+  return Qnil;
+}
+
+void Init_gsl_thread_pool(VALUE module)
+{
+  VALUE mgsl_pool;
+  mgsl_pool = rb_define_module_under(module, "ThreadPool");
+  rb_define_module_function(mgsl_pool, "size", rb_gsl_thread_pool_size_get, 0);
+  rb_define_module_function(mgsl_pool, "size=", rb_gsl_thread_pool_size_set, 1);
+  rb_define_module_function(mgsl_pool, "workers", rb_gsl_thread_pool_workers, 0);
+  rb_define_module_function(mgsl_pool, "shutdown", rb_gsl_thread_pool_shutdown, 0);
+  rb_define_module_function(mgsl_pool, "affinity", rb_gsl_thread_pool_affinity_get, 0);
+  rb_define_module_function(mgsl_pool, "affinity=", rb_gsl_thread_pool_affinity_set, 1);
+  rb_define_module_function(mgsl_pool, "blas", rb_gsl_thread_pool_blas_get, 0);
+  rb_define_module_function(mgsl_pool, "blas=", rb_gsl_thread_pool_blas_set, 1);
+  rb_define_module_function(mgsl_pool, "stats", rb_gsl_thread_pool_stats, 0);
+  rb_define_module_function(mgsl_pool, "reset_stats", rb_gsl_thread_pool_reset_stats, 0);
+#ifdef POOL_THREADS
+  pthread_atfork(NULL, NULL, pool_atfork_child);
+#endif
+}
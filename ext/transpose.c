@@ -0,0 +1,260 @@
+/*
+  transpose.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Matrix transposes behind Matrix#transpose and Matrix#transpose!, for
+  double and int matrices.
+
+  The copying transpose walks the matrix in TRANSPOSE_TILE x
+  TRANSPOSE_TILE tiles, so that both the rows read and the rows written
+  stay in cache, instead of going down a whole column of the result per
+  source row.  The in-place transpose of a square matrix swaps tiles
+  across the diagonal.  Both split their tile rows over
+  GSL.parallel_threads threads from GSL.parallel_threshold elements on,
+  with the GVL released.  A packed (tda == size2) rectangular matrix is
+  transposed in place by following the cycles of the permutation, and
+  changes shape.
+
+  Matrix#transpose_naive keeps the previous gsl_matrix_transpose_memcpy
+  path for comparison; see examples/matrix/transpose_bench.rb.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+#define TRANSPOSE_TILE 32
+
+struct transpose_task {
+  void *dst;
+  const void *src;
+  size_t size1, size2;          /* of src; dst is size2 x size1 */
+  size_t tda_dst, tda_src;
+  int is_double;
+  size_t ntiles, nthreads;      /* tile rows */
+};
+
+static void tile_copy_double(double *d, size_t tdad, const double *s, size_t tdas,
+			     size_t i0, size_t i1, size_t j0, size_t j1)
+{
+  size_t i, j;
+  for (i = i0; i < i1; i++)
+    for (j = j0; j < j1; j++) d[j*tdad + i] = s[i*tdas + j];
+}
+
+static void tile_copy_int(int *d, size_t tdad, const int *s, size_t tdas,
+			  size_t i0, size_t i1, size_t j0, size_t j1)
+{
+  size_t i, j;
+  for (i = i0; i < i1; i++)
+    for (j = j0; j < j1; j++) d[j*tdad + i] = s[i*tdas + j];
+}
+
+/* Swaps the tile [i0,i1) x [j0,j1) with its mirror; on the diagonal
+   (i0 == j0) only the upper half is swapped */
+static void tile_swap_double(double *a, size_t tda, size_t i0, size_t i1,
+			     size_t j0, size_t j1)
+{
+  size_t i, j;
+  double tmp;
+  for (i = i0; i < i1; i++)
+    for (j = (i0 == j0 ? i + 1 : j0); j < j1; j++) {
+      tmp = a[i*tda + j];
+      a[i*tda + j] = a[j*tda + i];
+      a[j*tda + i] = tmp;
+    }
+}
+
+static void tile_swap_int(int *a, size_t tda, size_t i0, size_t i1,
+			  size_t j0, size_t j1)
+{
+  size_t i, j;
+  int tmp;
+  for (i = i0; i < i1; i++)
+    for (j = (i0 == j0 ? i + 1 : j0); j < j1; j++) {
+      tmp = a[i*tda + j];
+      a[i*tda + j] = a[j*tda + i];
+      a[j*tda + i] = tmp;
+    }
+}
+
+/* Tile rows i, i + nthreads, ... so that the triangular work of the
+   in-place transpose is balanced */
+static int transpose_copy_worker(void *data, size_t k)
+{
+  struct transpose_task *t = (struct transpose_task *) data;
+  size_t I, i0, i1, j0, j1;
+  for (I = k; I < t->ntiles; I += t->nthreads) {
+    i0 = I*TRANSPOSE_TILE;
+    i1 = GSL_MIN(i0 + TRANSPOSE_TILE, t->size1);
+    for (j0 = 0; j0 < t->size2; j0 += TRANSPOSE_TILE) {
+      j1 = GSL_MIN(j0 + TRANSPOSE_TILE, t->size2);
+      if (t->is_double)
+	tile_copy_double((double*) t->dst, t->tda_dst, (const double*) t->src,
+			 t->tda_src, i0, i1, j0, j1);
+      else
+	tile_copy_int((int*) t->dst, t->tda_dst, (const int*) t->src,
+		      t->tda_src, i0, i1, j0, j1);
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static int transpose_swap_worker(void *data, size_t k)
+{
+  struct transpose_task *t = (struct transpose_task *) data;
+  size_t I, i0, i1, j0, j1;
+  for (I = k; I < t->ntiles; I += t->nthreads) {
+    i0 = I*TRANSPOSE_TILE;
+    i1 = GSL_MIN(i0 + TRANSPOSE_TILE, t->size1);
+    for (j0 = i0; j0 < t->size1; j0 += TRANSPOSE_TILE) {
+      j1 = GSL_MIN(j0 + TRANSPOSE_TILE, t->size1);
+      if (t->is_double)
+	tile_swap_double((double*) t->dst, t->tda_dst, i0, i1, j0, j1);
+      else
+	tile_swap_int((int*) t->dst, t->tda_dst, i0, i1, j0, j1);
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static int transpose_copy_serial(void *data)
+{
+  return transpose_copy_worker(data, 0);
+}
+
+static int transpose_swap_serial(void *data)
+{
+  return transpose_swap_worker(data, 0);
+}
+
+static void transpose_run(struct transpose_task *t, int (*worker)(void *, size_t),
+			  int (*serial)(void *))
+{
+  size_t n = t->size1*t->size2;
+  t->ntiles = (t->size1 + TRANSPOSE_TILE - 1)/TRANSPOSE_TILE;
+  t->nthreads = rb_gsl_parallel_nthreads(n, t->ntiles);
+  if (t->nthreads > 1) rb_gsl_nogvl_parallel(worker, t, t->nthreads);
+  else rb_gsl_nogvl_call(serial, t, n);
+}
+
+struct transpose_cycles {
+  void *data;
+  size_t size1, size2;
+  int is_double;
+  unsigned char *done;
+};
+
+/* Row-major size1 x size2 -> size2 x size1: the element at k = i*size2 + j
+   goes to j*size1 + i */
+static int transpose_cycles_run(void *data)
+{
+  struct transpose_cycles *c = (struct transpose_cycles *) data;
+  size_t n = c->size1*c->size2, start, k;
+  double *a = (double*) c->data, vd = 0.0, td;
+  int *b = (int*) c->data, vi = 0, ti;
+  for (start = 1; start + 1 < n; start++) {
+    if (c->done[start/8] & (1 << (start % 8))) continue;
+    k = start;
+    if (c->is_double) vd = a[k];
+    else vi = b[k];
+    do {
+      k = (k % c->size2)*c->size1 + k/c->size2;
+      if (c->is_double) { td = a[k]; a[k] = vd; vd = td; }
+      else { ti = b[k]; b[k] = vi; vi = ti; }
+      c->done[k/8] |= 1 << (k % 8);
+    } while (k != start);
+  }
+  return GSL_SUCCESS;
+}
+
+static void transpose_in_place_cycles(void *data, size_t size1, size_t size2,
+				      int is_double)
+{
+  struct transpose_cycles c;
+  size_t n = size1*size2;
+  c.data = data;
+  c.size1 = size1;
+  c.size2 = size2;
+  c.is_double = is_double;
+  c.done = ALLOC_N(unsigned char, n/8 + 1);
+  memset(c.done, 0, n/8 + 1);
+  rb_gsl_nogvl_call(transpose_cycles_run, &c, n);
+  xfree(c.done);
+}
+
+int mygsl_matrix_transpose_memcpy(gsl_matrix *dst, const gsl_matrix *src)
+{
+  struct transpose_task t;
+  if (dst->size1 != src->size2 || dst->size2 != src->size1)
+    GSL_ERROR("dimensions of dest matrix must be transpose of src matrix",
+	      GSL_EBADLEN);
+  t.dst = dst->data; t.src = src->data;
+  t.size1 = src->size1; t.size2 = src->size2;
+  t.tda_dst = dst->tda; t.tda_src = src->tda;
+  t.is_double = 1;
+  transpose_run(&t, transpose_copy_worker, transpose_copy_serial);
+  return GSL_SUCCESS;
+}
+
+int mygsl_matrix_int_transpose_memcpy(gsl_matrix_int *dst, const gsl_matrix_int *src)
+{
+  struct transpose_task t;
+  if (dst->size1 != src->size2 || dst->size2 != src->size1)
+    GSL_ERROR("dimensions of dest matrix must be transpose of src matrix",
+	      GSL_EBADLEN);
+  t.dst = dst->data; t.src = src->data;
+  t.size1 = src->size1; t.size2 = src->size2;
+  t.tda_dst = dst->tda; t.tda_src = src->tda;
+  t.is_double = 0;
+  transpose_run(&t, transpose_copy_worker, transpose_copy_serial);
+  return GSL_SUCCESS;
+}
+
+/* A rectangular matrix must be packed; its size1 and size2 are swapped */
+int mygsl_matrix_transpose(gsl_matrix *m)
+{
+  struct transpose_task t;
+  size_t tmp;
+  if (m->size1 == m->size2) {
+    t.dst = m->data; t.src = m->data;
+    t.size1 = t.size2 = m->size1;
+    t.tda_dst = t.tda_src = m->tda;
+    t.is_double = 1;
+    transpose_run(&t, transpose_swap_worker, transpose_swap_serial);
+    return GSL_SUCCESS;
+  }
+  if (m->tda != m->size2)
+    GSL_ERROR("matrix must be square or packed to transpose in place", GSL_ENOTSQR);
+  transpose_in_place_cycles(m->data, m->size1, m->size2, 1);
+  tmp = m->size1; m->size1 = m->size2; m->size2 = tmp;
+  m->tda = m->size2;
+  return GSL_SUCCESS;
+}
+
+int mygsl_matrix_int_transpose(gsl_matrix_int *m)
+{
+  struct transpose_task t;
+  size_t tmp;
+  if (m->size1 == m->size2) {
+    t.dst = m->data; t.src = m->data;
+    t.size1 = t.size2 = m->size1;
+    t.tda_dst = t.tda_src = m->tda;
+    t.is_double = 0;
+    transpose_run(&t, transpose_swap_worker, transpose_swap_serial);
+    return GSL_SUCCESS;
+  }
+  if (m->tda != m->size2)
+    GSL_ERROR("matrix must be square or packed to transpose in place", GSL_ENOTSQR);
+  transpose_in_place_cycles(m->data, m->size1, m->size2, 0);
+  tmp = m->size1; m->size1 = m->size2; m->size2 = tmp;
+  m->tda = m->size2;
+  return GSL_SUCCESS;
+}
@@ -0,0 +1,89 @@
+/*
+  typetag.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  The type tags of the exact classes behind VECTOR_P(), MATRIX_P(),
+  CHECK_VECTOR() and the other predicates of rb_gsl_common.h.
+
+  rb_obj_is_kind_of() walks the ancestors of the class of its argument,
+  and the entry points test an argument against several classes in a
+  row (a Float given to GSL::Sf::erf is first asked whether it is a
+  Vector, a Matrix, a Complex ...), so that for small inputs deciding
+  what the argument is costs more than the evaluation.  The predicates
+  look the class of the object up here first: for the GSL classes and
+  the Ruby ones an entry point is usually given, the answer is one
+  probe of an open addressing table, a Fixnum or a flonum not even
+  that.  Only classes defined when the library is loaded are entered,
+  which are never collected: a subclass defined in Ruby, or the
+  singleton class of an object, is not in the table and goes through
+  rb_obj_is_kind_of().  bench/dispatch_bench.rb times the calls.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_complex.h"
+
+rb_gsl_typetag rb_gsl_typetags[RB_GSL_TYPETAG_SIZE];
+
+static void typetag_add(VALUE klass)
+{
+  static const struct {
+    unsigned int tag;
+    VALUE *base;
+  } bases[] = {
+    {RB_GSL_T_COMPLEX, &cgsl_complex},
+    {RB_GSL_T_VECTOR, &cgsl_vector},
+    {RB_GSL_T_VECTOR_INT, &cgsl_vector_int},
+    {RB_GSL_T_VECTOR_COMPLEX, &cgsl_vector_complex},
+    {RB_GSL_T_MATRIX, &cgsl_matrix},
+    {RB_GSL_T_MATRIX_INT, &cgsl_matrix_int},
+    {RB_GSL_T_MATRIX_COMPLEX, &cgsl_matrix_complex},
+    {RB_GSL_T_VECTOR_COL, &cgsl_vector_col},
+    {RB_GSL_T_VECTOR_INT_COL, &cgsl_vector_int_col},
+  };
+  unsigned int tags = RB_GSL_T_KNOWN;
+  size_t i, h, n = 0;
+  if (klass == 0 || NIL_P(klass)) return;
+  for (i = 0; i < sizeof(bases)/sizeof(bases[0]); i++)
+    if (*bases[i].base && rb_class_inherited_p(klass, *bases[i].base) == Qtrue)
+      tags |= bases[i].tag;
+  for (h = rb_gsl_typetag_hash(klass); rb_gsl_typetags[h].klass;
+       h = (h + 1) & (RB_GSL_TYPETAG_SIZE - 1)) {
+    if (rb_gsl_typetags[h].klass == klass) return;
+    /* keep the table at most half full so that misses stay short */
+    if (++n > RB_GSL_TYPETAG_SIZE/2) return;
+  }
+  rb_gsl_typetags[h].tags = tags;
+  rb_gsl_typetags[h].klass = klass;
+}
+
+void Init_gsl_typetag(VALUE module)
+{
+  VALUE *gsl[] = {
+    &cgsl_complex,
+    &cgsl_vector, &cgsl_vector_col, &cgsl_vector_view, &cgsl_vector_col_view,
+    &cgsl_vector_view_ro, &cgsl_vector_col_view_ro,
+    &cgsl_vector_int, &cgsl_vector_int_col, &cgsl_vector_int_view,
+    &cgsl_vector_int_col_view, &cgsl_vector_int_view_ro, &cgsl_vector_int_col_view_ro,
+    &cgsl_vector_complex, &cgsl_vector_complex_col, &cgsl_vector_complex_view,
+    &cgsl_vector_complex_col_view, &cgsl_vector_complex_view_ro,
+    &cgsl_matrix, &cgsl_matrix_view, &cgsl_matrix_view_ro,
+    &cgsl_matrix_int, &cgsl_matrix_int_view, &cgsl_matrix_int_view_ro,
+    &cgsl_matrix_complex, &cgsl_matrix_complex_view, &cgsl_matrix_complex_view_ro,
+    &cgsl_permutation,
+  };
+  VALUE ruby[] = {
+    rb_cFloat, rb_cInteger, rb_cArray, rb_cRange, rb_cString, rb_cSymbol,
+    rb_cHash, rb_cProc, rb_cRational, rb_cComplex,
+  };
+  size_t i;
+  for (i = 0; i < sizeof(gsl)/sizeof(gsl[0]); i++) typetag_add(*gsl[i]);
+  for (i = 0; i < sizeof(ruby)/sizeof(ruby[0]); i++) typetag_add(ruby[i]);
+}
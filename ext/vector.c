@@ -19,9 +19,13 @@
 #include "rb_gsl_histogram.h"
 #include "rb_gsl_complex.h"
 #include "rb_gsl_poly.h"
+#include "rb_gsl_sf.h"
 #ifdef HAVE_NARRAY_H
 #include "rb_gsl_with_narray.h"
 #endif
+#ifdef HAVE_RUBY_IO_BUFFER_H
+#include <ruby/io/buffer.h>
+#endif
 
 #define BASE_DOUBLE
 #include "templates_on.h"
@@ -54,6 +54,8 @@ static VALUE rb_gsl_vector_complex_new(int argc, VALUE *argv, VALUE klass)
 	  GSL_SET_IMAG(z2, NUM2DBL(rb_ary_entry(tmp, 1)));
 	} else if (COMPLEX_P(tmp)) {
 	  Data_Get_Struct(tmp, gsl_complex, z2);
+	} else if (TYPE(tmp) == T_COMPLEX) {
+	  z = rb_gsl_obj_to_gsl_complex(tmp, NULL);
 	} else {
 	  rb_raise(rb_eTypeError, 
 		   "wrong argument type %s (Array or Complex expected)", 
@@ -75,10 +77,11 @@ static VALUE rb_gsl_vector_complex_new(int argc, VALUE *argv, VALUE klass)
       Data_Get_Struct(argv[1], gsl_vector, y);
       n = GSL_MIN_INT(x->size, y->size);
       v = gsl_vector_complex_alloc(n);
-      for (i = 0; i < n; i++) {
-	z.dat[0] = gsl_vector_get(x, i);
-	z.dat[1] = gsl_vector_get(y, i);
-	gsl_vector_complex_set(v, i, z);
+      if (v == NULL) rb_raise(rb_eNoMemError, "gsl_vector_complex_alloc failed");
+      {
+	gsl_vector_const_view xv = gsl_vector_const_subvector(x, 0, n);
+	gsl_vector_const_view yv = gsl_vector_const_subvector(y, 0, n);
+	mygsl_vector_complex_join(v, &xv.vector, &yv.vector);
       }
       break;
     }
@@ -209,6 +212,7 @@ static VALUE rb_gsl_vector_complex_set_all(int argc, VALUE *argv, VALUE obj)
 
   if (argc < 1) rb_raise(rb_eArgError, "wrong number of arguments");
 
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_vector_complex, v);
 
   switch (argc) {
@@ -286,6 +290,7 @@ static VALUE rb_gsl_vector_complex_set(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-4)", argc);
   }
 
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, gsl_vector_complex, v);
   other = argv[argc-1];
 
@@ -314,6 +319,45 @@ static VALUE rb_gsl_vector_complex_set(int argc, VALUE *argv, VALUE obj)
   return obj;
 }
 
+/*
+  The Ruby Complex forms of the elements, which allocate no GSL::Complex:
+  v.get_c(i), v.each_c { |z| ... }, v.to_c_a; v[i] = z takes a Complex.
+  v[range] is a view, as for v.subvector.
+*/
+static VALUE rb_gsl_vector_complex_get_c(VALUE obj, VALUE ii)
+{
+  gsl_vector_complex *v = NULL;
+  long i;
+  Data_Get_Struct(obj, gsl_vector_complex, v);
+  i = NUM2LONG(ii);
+  if (i < 0) i += (long) v->size;
+  if (i < 0 || (size_t) i >= v->size)
+    rb_raise(rb_eIndexError, "index %ld out of range (size %d)", NUM2LONG(ii), (int) v->size);
+  return rb_gsl_complex_to_c(gsl_vector_complex_get(v, (size_t) i));
+}
+
+static VALUE rb_gsl_vector_complex_each_c(VALUE obj)
+{
+  gsl_vector_complex *v = NULL;
+  size_t i;
+  Data_Get_Struct(obj, gsl_vector_complex, v);
+  for (i = 0; i < v->size; i++)
+    rb_yield(rb_gsl_complex_to_c(gsl_vector_complex_get(v, i)));
+  return obj;
+}
+
+static VALUE rb_gsl_vector_complex_to_c_a(VALUE obj)
+{
+  gsl_vector_complex *v = NULL;
+  size_t i;
+  VALUE ary;
+  Data_Get_Struct(obj, gsl_vector_complex, v);
+  ary = rb_ary_new2(v->size);
+  for (i = 0; i < v->size; i++)
+    rb_ary_store(ary, i, rb_gsl_complex_to_c(gsl_vector_complex_get(v, i)));
+  return ary;
+}
+
 static VALUE rb_gsl_vector_complex_each(VALUE obj)
 {
   gsl_vector_complex *v = NULL;
@@ -624,29 +668,19 @@ static VALUE rb_gsl_vector_complex_set_imag(VALUE obj, VALUE val)
 
 static VALUE rb_gsl_vector_complex_conj(VALUE obj)
 {
-  size_t i;
   gsl_vector_complex *vin = NULL;
   gsl_vector_complex *vout = NULL;
   Data_Get_Struct(obj, gsl_vector_complex, vin);
   vout = gsl_vector_complex_alloc(vin->size);
-  for(i=0; i<vin->size; i++) {
-    gsl_vector_complex_set(vout, i,
-        gsl_complex_conjugate(
-          gsl_vector_complex_get(vin, i)));
-  }
+  mygsl_vector_complex_conjugate(vout, vin);
   return Data_Wrap_Struct(VECTOR_COMPLEX_ROW_COL(obj), 0, gsl_vector_complex_free, vout);
 }
 
 static VALUE rb_gsl_vector_complex_conj_bang(VALUE obj)
 {
-  size_t i;
   gsl_vector_complex *v = NULL;
   Data_Get_Struct(obj, gsl_vector_complex, v);
-  for(i=0; i<v->size; i++) {
-    gsl_vector_complex_set(v, i,
-        gsl_complex_conjugate(
-          gsl_vector_complex_get(v, i)));
-  }
+  mygsl_vector_complex_conjugate(v, v);
   return obj;
 }
 
@@ -742,7 +776,7 @@ static VALUE rb_gsl_vector_complex_memcpy(VALUE obj, VALUE dst, VALUE src)
   return dst;
 }
 
-static VALUE rb_gsl_vector_complex_clone(VALUE obj)
+static VALUE rb_gsl_vector_complex_dup(VALUE obj)
 {
   gsl_vector_complex *v = NULL, *vnew = NULL;
   Data_Get_Struct(obj, gsl_vector_complex, v);
@@ -755,6 +789,12 @@ static VALUE rb_gsl_vector_complex_clone(VALUE obj)
     return Data_Wrap_Struct(cgsl_vector_complex_col, 0, gsl_vector_complex_free, vnew);
 }
 
+/* shares the data of a frozen vector, see rb_gsl_array_clone in array.c */
+static VALUE rb_gsl_vector_complex_clone(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_array_clone(argc, argv, obj, rb_gsl_vector_complex_dup);
+}
+
 static VALUE rb_gsl_vector_complex_reverse(VALUE obj)
 {
   gsl_vector_complex *v = NULL;
@@ -860,7 +900,7 @@ static VALUE rb_gsl_vector_complex_ifftshift_bang(VALUE obj)
 
 static VALUE rb_gsl_vector_complex_ifftshift(VALUE obj)
 {
-  return rb_gsl_vector_complex_ifftshift_bang(rb_gsl_vector_complex_clone(obj));
+  return rb_gsl_vector_complex_ifftshift_bang(rb_gsl_vector_complex_dup(obj));
   gsl_vector_complex *v, *vnew;
   gsl_vector_complex_view vv, vvnew;
   size_t n;
@@ -1045,7 +1085,7 @@ static VALUE rb_gsl_vector_complex_arithmetics(int flag, VALUE obj, VALUE bb)
 	break;
       case GSL_VECTOR_COMPLEX_MUL:
       case GSL_VECTOR_COMPLEX_MUL_BANG:
-	gsl_vector_complex_mul(cvnew, cb);
+	mygsl_vector_complex_mul(cvnew, cb);
 	break;
       case GSL_VECTOR_COMPLEX_DIV:
       case GSL_VECTOR_COMPLEX_DIV_BANG:
@@ -1066,7 +1106,7 @@ static VALUE rb_gsl_vector_complex_arithmetics(int flag, VALUE obj, VALUE bb)
 	break;
       case GSL_VECTOR_COMPLEX_MUL:
       case GSL_VECTOR_COMPLEX_MUL_BANG:
-	gsl_vector_complex_mul(cvnew, cb);
+	mygsl_vector_complex_mul(cvnew, cb);
 	break;
       case GSL_VECTOR_COMPLEX_DIV:
       case GSL_VECTOR_COMPLEX_DIV_BANG:
@@ -1357,14 +1397,26 @@ static VALUE rb_gsl_vector_complex_XXXz2_bang(VALUE obj, VALUE a,
   return obj;
 }
 
+/* abs, abs2 and arg through the kernels of vecmath.c */
+static VALUE rb_gsl_vector_complex_cmath(VALUE obj, int fn)
+{
+  gsl_vector_complex *m;
+  gsl_vector *v;
+  Data_Get_Struct(obj, gsl_vector_complex, m);
+  v = gsl_vector_alloc(m->size);
+  if (v == NULL) rb_raise(rb_eNoMemError, "gsl_vector_alloc failed");
+  mygsl_vector_complex_cmath(v, m, fn);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
 static VALUE rb_gsl_vector_complex_abs2(VALUE obj)
 {
-  return rb_gsl_vector_complex_XXX(obj, gsl_complex_abs2);
+  return rb_gsl_vector_complex_cmath(obj, MYGSL_CMATH_ABS2);
 }
 
 static VALUE rb_gsl_vector_complex_abs(VALUE obj)
 {
-  return rb_gsl_vector_complex_XXX(obj, gsl_complex_abs);
+  return rb_gsl_vector_complex_cmath(obj, MYGSL_CMATH_ABS);
 }
 
 static VALUE rb_gsl_vector_complex_logabs(VALUE obj)
@@ -1374,7 +1426,32 @@ static VALUE rb_gsl_vector_complex_logabs(VALUE obj)
 
 static VALUE rb_gsl_vector_complex_arg(VALUE obj)
 {
-  return rb_gsl_vector_complex_XXX(obj, gsl_complex_arg);
+  return rb_gsl_vector_complex_cmath(obj, MYGSL_CMATH_ARG);
+}
+
+/* [abs, arg] */
+static VALUE rb_gsl_vector_complex_amp_phase(VALUE obj)
+{
+  return rb_ary_new3(2, rb_gsl_vector_complex_cmath(obj, MYGSL_CMATH_ABS),
+		     rb_gsl_vector_complex_cmath(obj, MYGSL_CMATH_ARG));
+}
+
+/* [re, im]: the parts as contiguous vectors, unlike the views of #re and #im */
+static VALUE rb_gsl_vector_complex_to_planar(VALUE obj)
+{
+  gsl_vector_complex *z;
+  gsl_vector *re, *im;
+  Data_Get_Struct(obj, gsl_vector_complex, z);
+  re = gsl_vector_alloc(z->size);
+  im = gsl_vector_alloc(z->size);
+  if (re == NULL || im == NULL) {
+    if (re) gsl_vector_free(re);
+    if (im) gsl_vector_free(im);
+    rb_raise(rb_eNoMemError, "gsl_vector_alloc failed");
+  }
+  mygsl_vector_complex_split(re, im, z);
+  return rb_ary_new3(2, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, re),
+		     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, im));
 }
 
 static VALUE rb_gsl_vector_complex_sqrt(VALUE obj)
@@ -2059,6 +2136,10 @@ void Init_gsl_vector_complex(VALUE module)
   rb_define_alias(cgsl_vector_complex, "[]=", "set");
   rb_define_method(cgsl_vector_complex, "set_all", rb_gsl_vector_complex_set_all, -1);
 
+  rb_define_method(cgsl_vector_complex, "get_c", rb_gsl_vector_complex_get_c, 1);
+  rb_define_method(cgsl_vector_complex, "each_c", rb_gsl_vector_complex_each_c, 0);
+  rb_define_method(cgsl_vector_complex, "to_c_a", rb_gsl_vector_complex_to_c_a, 0);
+
   rb_define_method(cgsl_vector_complex, "each", rb_gsl_vector_complex_each, 0);
   rb_define_method(cgsl_vector_complex, "reverse_each", rb_gsl_vector_complex_reverse_each, 0);
   rb_define_method(cgsl_vector_complex, "each_index", rb_gsl_vector_complex_each_index, 0);
@@ -2105,9 +2186,9 @@ void Init_gsl_vector_complex(VALUE module)
   rb_define_method(cgsl_vector_complex, "subvector_with_stride", rb_gsl_vector_complex_subvector_with_stride, 3);
   
   rb_define_singleton_method(cgsl_vector_complex, "memcpy", rb_gsl_vector_complex_memcpy, 2);
-  rb_define_method(cgsl_vector_complex, "clone", rb_gsl_vector_complex_clone, 0);
-  rb_define_alias(cgsl_vector_complex, "duplicate", "clone");
-  rb_define_alias(cgsl_vector_complex, "dup", "clone");
+  rb_define_method(cgsl_vector_complex, "clone", rb_gsl_vector_complex_clone, -1);
+  rb_define_method(cgsl_vector_complex, "dup", rb_gsl_vector_complex_dup, 0);
+  rb_define_alias(cgsl_vector_complex, "duplicate", "dup");
   rb_define_method(cgsl_vector_complex, "reverse!", rb_gsl_vector_complex_reverse, 0);
   rb_define_method(cgsl_vector_complex, "reverse", rb_gsl_vector_complex_reverse2, 0);
   rb_define_method(cgsl_vector_complex, "swap_elements", rb_gsl_vector_complex_swap_elements, 2);
@@ -2153,7 +2234,7 @@ void Init_gsl_vector_complex(VALUE module)
   rb_define_alias(cgsl_vector_complex, "scale!", "mul!");
   rb_define_alias(cgsl_vector_complex, "/", "div");
 
-  rb_define_method(cgsl_vector_complex, "coerce", rb_gsl_vector_complex_coerce, 1);  
+  rb_gsl_define_coerce(cgsl_vector_complex, rb_gsl_vector_complex_coerce);
 
   /* 2.Aug.2004 */
   rb_define_singleton_method(cgsl_vector_complex, "inner_product", rb_gsl_vector_complex_inner_product, -1);
@@ -2173,6 +2254,8 @@ void Init_gsl_vector_complex(VALUE module)
   rb_define_method(cgsl_vector_complex, "arg", rb_gsl_vector_complex_arg, 0);
   rb_define_alias(cgsl_vector_complex, "angle", "arg");
   rb_define_alias(cgsl_vector_complex, "phase", "arg");
+  rb_define_method(cgsl_vector_complex, "amp_phase", rb_gsl_vector_complex_amp_phase, 0);
+  rb_define_method(cgsl_vector_complex, "to_planar", rb_gsl_vector_complex_to_planar, 0);
   rb_define_method(cgsl_vector_complex, "logabs", rb_gsl_vector_complex_logabs, 0);
 
   rb_define_method(cgsl_vector_complex, "sqrt", rb_gsl_vector_complex_sqrt, 0);
@@ -145,6 +145,16 @@ enum {
   GSL_VECTOR_DIV,
 };
 
+static int vector_kernel_op(int flag)
+{
+  switch (flag) {
+  case GSL_VECTOR_ADD: return MYGSL_KERNEL_ADD;
+  case GSL_VECTOR_SUB: return MYGSL_KERNEL_SUB;
+  case GSL_VECTOR_MUL: return MYGSL_KERNEL_MUL;
+  default: return MYGSL_KERNEL_DIV;
+  }
+}
+
 static VALUE rb_gsl_vector_arithmetics(int flag, VALUE obj, VALUE bb) 
 {
   gsl_vector *v = NULL, *vnew = NULL, *b = NULL;
@@ -154,24 +164,9 @@ static VALUE rb_gsl_vector_arithmetics(int flag, VALUE obj, VALUE bb)
   switch (TYPE(bb)) {
   case T_FLOAT:
   case T_FIXNUM:
-    switch (flag) {
-    case GSL_VECTOR_ADD:
-      vnew = make_vector_clone(v);
-      gsl_vector_add_constant(vnew, NUM2DBL(bb));
-      break;
-    case GSL_VECTOR_SUB:
-      vnew = make_vector_clone(v);
-      gsl_vector_add_constant(vnew, -NUM2DBL(bb));
-      break;
-    case GSL_VECTOR_MUL:
-      vnew = make_vector_clone(v);
-      gsl_vector_scale(vnew, NUM2DBL(bb));
-      break;
-    case GSL_VECTOR_DIV:
-      vnew = make_vector_clone(v);
-      gsl_vector_scale(vnew, 1.0/NUM2DBL(bb));
-      break;
-    }
+    vnew = gsl_vector_alloc(v->size);
+    if (vnew == NULL) rb_raise(rb_eNoMemError, "gsl_vector_alloc failed");
+    mygsl_vector_binop_const(vnew, v, NUM2DBL(bb), vector_kernel_op(flag));
     if (!VECTOR_VIEW_P(obj)) 
       return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_vector_free, vnew);
     else 
@@ -181,24 +176,9 @@ static VALUE rb_gsl_vector_arithmetics(int flag, VALUE obj, VALUE bb)
     if (VECTOR_INT_P(bb)) bb = rb_gsl_vector_int_to_f(bb);
     if (VECTOR_P(bb)) {
       Data_Get_Struct(bb, gsl_vector, b);
-      switch (flag) {
-      case GSL_VECTOR_ADD:
-	vnew = make_vector_clone(v);
-	gsl_vector_add(vnew, b);
-	break;
-      case GSL_VECTOR_SUB:
-	vnew = make_vector_clone(v);
-	gsl_vector_sub(vnew, b);
-	break;
-      case GSL_VECTOR_MUL:
-	vnew = make_vector_clone(v);
-	gsl_vector_mul(vnew, b);
-	break;
-      case GSL_VECTOR_DIV:
-	vnew = make_vector_clone(v);
-	gsl_vector_div(vnew, b);
-	break;
-      }
+      vnew = gsl_vector_alloc(v->size);
+      if (vnew == NULL) rb_raise(rb_eNoMemError, "gsl_vector_alloc failed");
+      mygsl_vector_binop(vnew, v, b, vector_kernel_op(flag));
       if (!VECTOR_VIEW_P(obj)) 
 	return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_vector_free, vnew);
       else 
@@ -294,6 +274,62 @@ VALUE rb_gsl_vector_div(VALUE obj, VALUE b)
   return rb_gsl_vector_arithmetics(GSL_VECTOR_DIV, obj, b);
 }
 
+/* a.add(b[, out]), a.add(b, :out => out) etc.: with an output vector the
+   elementwise result is written there instead of a new vector */
+static VALUE rb_gsl_vector_arithmetics_out(int argc, VALUE *argv, VALUE obj,
+					   int flag, VALUE (*f)(VALUE, VALUE))
+{
+  gsl_vector *v = NULL, *vout = NULL, *b = NULL;
+  VALUE out, bb;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  out = (argc == 2) ? rb_gsl_out_arg(argv[1]) : Qnil;
+  if (NIL_P(out)) return (*f)(obj, argv[0]);
+  bb = argv[0];
+  CHECK_VECTOR(out);
+  Data_Get_Struct(obj, gsl_vector, v);
+  Data_Get_Struct(out, gsl_vector, vout);
+  switch (TYPE(bb)) {
+  case T_FLOAT:
+  case T_FIXNUM:
+  case T_BIGNUM:
+    mygsl_vector_binop_const(vout, v, NUM2DBL(bb), vector_kernel_op(flag));
+    break;
+  default:
+    if (VECTOR_INT_P(bb)) bb = rb_gsl_vector_int_to_f(bb);
+    if (!VECTOR_P(bb))
+      rb_raise(rb_eTypeError, "wrong argument type %s (Vector or Numeric expected)",
+	       rb_class2name(CLASS_OF(bb)));
+    if (flag == GSL_VECTOR_MUL && ((VECTOR_ROW_P(obj) && VECTOR_COL_P(bb))
+				   || (VECTOR_COL_P(obj) && VECTOR_ROW_P(bb))))
+      rb_raise(rb_eArgError, "output vector not supported for inner or outer products");
+    Data_Get_Struct(bb, gsl_vector, b);
+    mygsl_vector_binop(vout, v, b, vector_kernel_op(flag));
+    break;
+  }
+  return out;
+}
+
+static VALUE rb_gsl_vector_add_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_arithmetics_out(argc, argv, obj, GSL_VECTOR_ADD, rb_gsl_vector_add);
+}
+
+static VALUE rb_gsl_vector_sub_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_arithmetics_out(argc, argv, obj, GSL_VECTOR_SUB, rb_gsl_vector_sub);
+}
+
+static VALUE rb_gsl_vector_mul_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_arithmetics_out(argc, argv, obj, GSL_VECTOR_MUL, rb_gsl_vector_mul);
+}
+
+static VALUE rb_gsl_vector_div_out(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_arithmetics_out(argc, argv, obj, GSL_VECTOR_DIV, rb_gsl_vector_div);
+}
+
 VALUE rb_ary_to_gv0(VALUE ary)
 {
   gsl_vector *v = NULL;
@@ -500,12 +536,12 @@ VALUE rb_gsl_vector_to_i(VALUE obj)
 
 /* singleton */
 #ifdef HAVE_GNU_GRAPH
-static void draw_hist(VALUE obj, FILE *fp);
-static void draw_vector(VALUE obj, FILE *fp);
-static void draw_vector2(VALUE xx, VALUE yy, FILE *fp);
-static void draw_vector_array(VALUE ary, FILE *fp);
+static void draw_hist(VALUE obj, rb_gsl_pipe *fp);
+static void draw_vector(VALUE obj, rb_gsl_pipe *fp);
+static void draw_vector2(VALUE xx, VALUE yy, rb_gsl_pipe *fp);
+static void draw_vector_array(VALUE ary, rb_gsl_pipe *fp);
 #ifdef HAVE_NARRAY_H
-static void draw_narray(VALUE obj, FILE *fp);
+static void draw_narray(VALUE obj, rb_gsl_pipe *fp);
 #endif // HAVE_NARRAY_H
 #endif // HAVE_GNU_GRAPH
 
@@ -515,10 +551,10 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
   size_t i, iend, j, n = 0;
   gsl_vector *x = NULL, *y = NULL;
   gsl_histogram *h = NULL;
-  VALUE vx = (VALUE) NULL;
+  VALUE vx = (VALUE) NULL, pipe;
   char command[1024];
   int flag = 0;
-  FILE *fp = NULL;
+  rb_gsl_pipe *fp = NULL;
   if (argc < 1)
     rb_raise(rb_eArgError, "two few arguments");
 
@@ -530,9 +566,8 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
     iend = argc;
   }
 
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
   if (iend == 1) {
-    fp = popen(command, "w");
-    if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
     if (VECTOR_P(argv[0])) {
       draw_vector(argv[0], fp);
     } else if (HISTOGRAM_P(argv[0])) {
@@ -544,15 +579,12 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
       draw_narray(argv[0], fp);
 #endif
     } else {
-      if (fp) pclose(fp);
       rb_raise(rb_eTypeError, "wrong argument type %s", 
 	       rb_class2name(CLASS_OF(argv[0])));
     }
-    if (fp) pclose(fp);
+    rb_gsl_pipe_send(pipe, command, "GNU graph");
     return Qtrue;
   } else {
-    fp = popen(command, "w");
-    if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
     if (VECTOR_P(argv[0])) {
       Data_Get_Struct(argv[0], gsl_vector, x);
       vx = argv[0];
@@ -566,10 +598,10 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
 	gsl_vector_set(x, j, h->range[j]);
       flag = 1;
       draw_hist(argv[0], fp);
-      fprintf(fp, "\n");
+      rb_gsl_pipe_break(fp);
     } else if (TYPE(argv[0]) == T_ARRAY) {
       draw_vector_array(argv[0], fp);
-      fprintf(fp, "\n");
+      rb_gsl_pipe_break(fp);
 #ifdef HAVE_NARRAY_H
     } else if (NA_IsNArray(argv[0])) {
       vx = argv[0];
@@ -596,7 +628,6 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
       for (j = 0; j < n; j++) gsl_vector_set(x, j, (double) j);
       flag = 1;
     } else {
-      if (fp) pclose(fp);
       rb_raise(rb_eTypeError, "wrong argument type %s", 
 	       rb_class2name(CLASS_OF(argv[0])));
     }
@@ -611,10 +642,9 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
       else 
 	rb_raise(rb_eTypeError, "wrong argument type %s", 
 		 rb_class2name(CLASS_OF(argv[i])));
-      fprintf(fp, "\n");
-      fflush(fp);
+      rb_gsl_pipe_break(fp);
     }
-    fclose(fp);
+    rb_gsl_pipe_send(pipe, command, "GNU graph");
     return Qtrue;
   }
   return Qtrue;
@@ -625,24 +655,27 @@ static VALUE rb_gsl_vector_graph2(int argc, VALUE *argv, VALUE obj)
 }
 
 #ifdef HAVE_GNU_GRAPH
-static void draw_vector(VALUE obj, FILE *fp)
+static void draw_vector(VALUE obj, rb_gsl_pipe *fp)
 {
   gsl_vector *x = NULL;
-  size_t j;
+  size_t j, k, m, *idx;
   Data_Get_Vector(obj, x);
-  for (j = 0; j < x->size; j++)
-    fprintf(fp, "%d %g\n", (int) j, gsl_vector_get(x, j));
-  fflush(fp);
+  idx = rb_gsl_plot_decimate(NULL, 1, x->data, x->stride, x->size, &m);
+  for (k = 0; k < m; k++) {
+    j = idx ? idx[k] : k;
+    rb_gsl_pipe_point(fp, (double) j, gsl_vector_get(x, j));
+  }
+  if (idx) xfree(idx);
 }
 
-static void draw_vector2(VALUE xx, VALUE yy, FILE *fp)
+static void draw_vector2(VALUE xx, VALUE yy, rb_gsl_pipe *fp)
 {
 #ifdef HAVE_NARRAY_H
   struct NARRAY *nax, *nay;
 #endif // HAVE_NARRAY_H
   double *ptr1 = NULL, *ptr2 = NULL;
   gsl_vector *vx, *vy;
-  size_t j, n, stridex = 1, stridey = 1;
+  size_t j, k, m, n, stridex = 1, stridey = 1, *idx;
   if (VECTOR_P(xx)) {
     Data_Get_Struct(xx, gsl_vector, vx);
     ptr1 = vx->data;
@@ -674,13 +707,16 @@ static void draw_vector2(VALUE xx, VALUE yy, FILE *fp)
     rb_raise(rb_eTypeError, "wrong argument type %s (Vector expected)",
 	     rb_class2name(CLASS_OF(yy)));
   }
-  for (j = 0; j < n; j++)
-    fprintf(fp, "%g %g\n", ptr1[j*stridex], ptr2[j*stridey]);
-  fflush(fp);
+  idx = rb_gsl_plot_decimate(ptr1, stridex, ptr2, stridey, n, &m);
+  for (k = 0; k < m; k++) {
+    j = idx ? idx[k] : k;
+    rb_gsl_pipe_point(fp, ptr1[j*stridex], ptr2[j*stridey]);
+  }
+  if (idx) xfree(idx);
 }
 
 #ifdef HAVE_NARRAY_H
-static void draw_narray(VALUE obj, FILE *fp)
+static void draw_narray(VALUE obj, rb_gsl_pipe *fp)
 {
   struct NARRAY *na;
   double *ptr;
@@ -688,26 +724,24 @@ static void draw_narray(VALUE obj, FILE *fp)
   GetNArray(obj, na);
   ptr = (double *) na->ptr;
   for (j = 0; j < na->total; j++)
-    fprintf(fp, "%d %g\n", (int) j, ptr[j]);
-  fflush(fp);
+    rb_gsl_pipe_point(fp, (double) j, ptr[j]);
 }
 #endif // HAVE_NARRAY_H
 
-static void draw_hist(VALUE obj, FILE *fp)
+static void draw_hist(VALUE obj, rb_gsl_pipe *fp)
 {
   gsl_histogram *h = NULL;
   size_t j;
   Data_Get_Struct(obj, gsl_histogram, h);
   for (j = 0; j < h->n; j++) {
-    fprintf(fp, "%g %g\n%g %g\n", 
-	    h->range[j], h->bin[j], h->range[j+1], h->bin[j]);
+    rb_gsl_pipe_point(fp, h->range[j], h->bin[j]);
+    rb_gsl_pipe_point(fp, h->range[j+1], h->bin[j]);
   }
-  fflush(fp);
 }
 
-static void draw_vector_array(VALUE ary, FILE *fp)
+static void draw_vector_array(VALUE ary, rb_gsl_pipe *fp)
 {
-  double *ptrx = NULL, *ptry = NULL, *ptrz = NULL;
+  double *ptrx = NULL, *ptry = NULL, *ptrz = NULL, rec[3];
   VALUE vx;
   size_t j, n, stridex, stridey, stridez;
   int flag = 0;
@@ -742,24 +776,27 @@ static void draw_vector_array(VALUE ary, FILE *fp)
   switch (flag) {
   case 0:
     for (j = 0; j < n; j++) 
-      fprintf(fp, "%g %g\n", ptrx[j*stridex], ptry[j*stridey]);
+      rb_gsl_pipe_point(fp, ptrx[j*stridex], ptry[j*stridey]);
     break;
   case 1:
     for (j = 0; j < n; j++) 
-      fprintf(fp, "%d %g\n", (int) j, ptry[j*stridey]);
+      rb_gsl_pipe_point(fp, (double) j, ptry[j*stridey]);
     break;
   case 2:
-    for (j = 0; j < n; j++) 
-      fprintf(fp, "%d %g %g\n", (int) j, ptry[j*stridey], ptrz[j*stridez]);
+    for (j = 0; j < n; j++) {
+      rec[0] = (double) j; rec[1] = ptry[j*stridey]; rec[2] = ptrz[j*stridez];
+      rb_gsl_pipe_record(fp, 3, rec);
+    }
     break;
   case 3:
-    for (j = 0; j < n; j++) 
-      fprintf(fp, "%g %g %g\n", ptrx[j*stridex], ptry[j*stridey], ptrz[j*stridez]);
+    for (j = 0; j < n; j++) {
+      rec[0] = ptrx[j*stridex]; rec[1] = ptry[j*stridey]; rec[2] = ptrz[j*stridez];
+      rb_gsl_pipe_record(fp, 3, rec);
+    }
     break;
   default:
     break;
   }
-  fflush(fp);
 }
 #endif // HAVE_GNU_GRAPH
 
@@ -767,12 +804,12 @@ static void draw_vector_array(VALUE ary, FILE *fp)
 static VALUE rb_gsl_vector_plot2(int argc, VALUE *argv, VALUE obj)
 {
   gsl_vector *x = NULL, *y = NULL, *xerr = NULL, *yerr = NULL;
-  FILE *fp = NULL;
-  size_t i, n;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
+  size_t i, k, m, n, ncols, *idx = NULL;
+  double rec[4];
   char command[1024];
-  fp = popen("gnuplot -persist", "w");
-  if (fp == NULL) rb_raise(rb_eIOError, "GNU graph not found.");
-  strcpy(command, "plot '-'");
+  strcpy(command, "");
   switch (argc) {
   case 5:
     if (TYPE(argv[4]) == T_STRING)
@@ -824,23 +861,33 @@ static VALUE rb_gsl_vector_plot2(int argc, VALUE *argv, VALUE obj)
   }
   if (x == NULL) rb_raise(rb_eRuntimeError, "x data is not given");
   n = x->size;
-  fprintf(fp, "%s\n", command);
-  for (i = 0; i < n; i++) {
-    if (y == NULL) 
-      fprintf(fp, "%d %g\n", (int) i, gsl_vector_get(x, i));
-    else if (yerr == NULL)
-      fprintf(fp, "%g %g\n", gsl_vector_get(x, i), gsl_vector_get(y, i));
-    else if (xerr) 
-      fprintf(fp, "%g %g %g %g\n", gsl_vector_get(x, i), gsl_vector_get(y, i),
-	      gsl_vector_get(xerr, i), gsl_vector_get(yerr, i));
-    else
-     fprintf(fp, "%g %g %g\n", gsl_vector_get(x, i), gsl_vector_get(y, i),
-	     gsl_vector_get(yerr, i));
+  if (y == NULL || yerr == NULL) ncols = 2;
+  else if (xerr) ncols = 4;
+  else ncols = 3;
+  m = n;
+  if (y == NULL) idx = rb_gsl_plot_decimate(NULL, 1, x->data, x->stride, n, &m);
+  else if (ncols == 2) idx = rb_gsl_plot_decimate(x->data, x->stride, y->data, y->stride, n, &m);
+  pipe = rb_gsl_pipe_new(1, &fp);
+  rb_gsl_pipe_gnuplot(fp, m, ncols, command);
+  for (k = 0; k < m; k++) {
+    i = idx ? idx[k] : k;
+    if (y == NULL) {
+      rec[0] = (double) i;
+      rec[1] = gsl_vector_get(x, i);
+    } else {
+      rec[0] = gsl_vector_get(x, i);
+      rec[1] = gsl_vector_get(y, i);
+      if (ncols == 3) {
+	rec[2] = gsl_vector_get(yerr, i);
+      } else if (ncols == 4) {
+	rec[2] = gsl_vector_get(xerr, i);
+	rec[3] = gsl_vector_get(yerr, i);
+      }
+    }
+    rb_gsl_pipe_record(fp, ncols, rec);
   }
-  fprintf(fp, "e\n");
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  if (idx) xfree(idx);
+  rb_gsl_pipe_send(pipe, "gnuplot -persist", "gnuplot");
   return Qtrue;
 }
 
@@ -1032,34 +1079,50 @@ static VALUE rb_gsl_vector_dB(VALUE obj)
   return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
 }
 
-static VALUE rb_gsl_vector_sin(VALUE obj)
+/* Elementwise functions take an optional output buffer: obj.sin(out)
+   or obj.sin(:out => out) */
+static VALUE rb_gsl_vector_eval1(int argc, VALUE *argv, VALUE obj, 
+			      double (*func)(double))
+{
+  switch (argc) {
+  case 0:
+    return rb_gsl_sf_eval1(func, obj);
+  case 1:
+    return rb_gsl_sf_eval1_out(func, obj, rb_gsl_out_arg(argv[0]));
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  }
+  return Qnil;
+}
+
+static VALUE rb_gsl_vector_sin(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(sin, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_SIN, sin);
 }
 
-static VALUE rb_gsl_vector_cos(VALUE obj)
+static VALUE rb_gsl_vector_cos(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(cos, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_COS, cos);
 }
 
-static VALUE rb_gsl_vector_tan(VALUE obj)
+static VALUE rb_gsl_vector_tan(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(tan, obj);
+  return rb_gsl_vector_eval1(argc, argv, obj, tan);
 }
 
-static VALUE rb_gsl_vector_exp(VALUE obj)
+static VALUE rb_gsl_vector_exp(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(exp, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_EXP, exp);
 }
 
-static VALUE rb_gsl_vector_log(VALUE obj)
+static VALUE rb_gsl_vector_log(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(log, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_LOG, log);
 }
 
-static VALUE rb_gsl_vector_log10(VALUE obj)
+static VALUE rb_gsl_vector_log10(int argc, VALUE *argv, VALUE obj)
 {
-  return rb_gsl_sf_eval1(log10, obj);
+  return rb_gsl_vmath_eval(argc, argv, obj, MYGSL_VMATH_LOG10, log10);
 }
 
 static VALUE rb_gsl_vector_rotate_bang(int argc, VALUE *argv, VALUE klass)
@@ -1359,13 +1422,13 @@ void Init_gsl_vector(VALUE module)
   rb_define_singleton_method(cgsl_vector, "logspace2", rb_gsl_vector_logspace2, -1);
   rb_define_module_function(module, "logspace2", rb_gsl_vector_logspace2, -1);
 
-  rb_define_method(cgsl_vector, "add", rb_gsl_vector_add, 1);
+  rb_define_method(cgsl_vector, "add", rb_gsl_vector_add_out, -1);
   rb_define_alias(cgsl_vector, "+", "add");
-  rb_define_method(cgsl_vector, "sub", rb_gsl_vector_sub, 1);
+  rb_define_method(cgsl_vector, "sub", rb_gsl_vector_sub_out, -1);
   rb_define_alias(cgsl_vector, "-", "sub");
-  rb_define_method(cgsl_vector, "mul", rb_gsl_vector_mul, 1);
+  rb_define_method(cgsl_vector, "mul", rb_gsl_vector_mul_out, -1);
   rb_define_alias(cgsl_vector, "*", "mul");
-  rb_define_method(cgsl_vector, "div", rb_gsl_vector_div, 1);
+  rb_define_method(cgsl_vector, "div", rb_gsl_vector_div_out, -1);
   rb_define_alias(cgsl_vector, "/", "div");
 
   rb_define_method(cgsl_vector, "to_complex", rb_gsl_vector_to_complex, 0);
@@ -1373,7 +1436,7 @@ void Init_gsl_vector(VALUE module)
 
   /*****/
 
-  rb_define_method(cgsl_vector, "coerce", rb_gsl_vector_coerce, 1);
+  rb_gsl_define_coerce(cgsl_vector, rb_gsl_vector_coerce);
 
   /*****/
   rb_define_method(rb_cArray, "to_gv", rb_ary_to_gv0, 0);
@@ -1410,12 +1473,12 @@ void Init_gsl_vector(VALUE module)
 
   rb_define_method(cgsl_vector, "dB", rb_gsl_vector_dB, 0);
 
-  rb_define_method(cgsl_vector, "sin", rb_gsl_vector_sin, 0);
-  rb_define_method(cgsl_vector, "cos", rb_gsl_vector_cos, 0);
-  rb_define_method(cgsl_vector, "tan", rb_gsl_vector_tan, 0);
-  rb_define_method(cgsl_vector, "exp", rb_gsl_vector_exp, 0);
-  rb_define_method(cgsl_vector, "log", rb_gsl_vector_log, 0);
-  rb_define_method(cgsl_vector, "log10", rb_gsl_vector_log10, 0);
+  rb_define_method(cgsl_vector, "sin", rb_gsl_vector_sin, -1);
+  rb_define_method(cgsl_vector, "cos", rb_gsl_vector_cos, -1);
+  rb_define_method(cgsl_vector, "tan", rb_gsl_vector_tan, -1);
+  rb_define_method(cgsl_vector, "exp", rb_gsl_vector_exp, -1);
+  rb_define_method(cgsl_vector, "log", rb_gsl_vector_log, -1);
+  rb_define_method(cgsl_vector, "log10", rb_gsl_vector_log10, -1);
 
   rb_define_singleton_method(cgsl_vector, "rotate", rb_gsl_vector_rotate, -1);
   rb_define_singleton_method(cgsl_vector, "rotate!", rb_gsl_vector_rotate_bang, -1);
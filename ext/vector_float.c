@@ -0,0 +1,507 @@
+/*
+  vector_float.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Vector::Float: single precision vectors (gsl_vector_float), half
+  the memory of GSL::Vector. Elements are converted from and to Ruby
+  Floats on access; sum, dot and norms accumulate in double precision.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+#include <gsl/gsl_blas.h>
+
+VALUE rb_gsl_vector_float_wrap(gsl_vector_float *v)
+{
+  return Data_Wrap_Struct(cgsl_vector_float, 0, gsl_vector_float_free, v);
+}
+
+gsl_vector_float* rb_gsl_get_vector_float(VALUE obj)
+{
+  gsl_vector_float *v = NULL;
+  CHECK_VECTOR_FLOAT(obj);
+  Data_Get_Struct(obj, gsl_vector_float, v);
+  return v;
+}
+
+static gsl_vector_float* vector_float_from_ary(VALUE ary)
+{
+  gsl_vector_float *v;
+  size_t i;
+  v = gsl_vector_float_alloc(RARRAY_LEN(ary));
+  for (i = 0; i < v->size; i++)
+    gsl_vector_float_set(v, i, (float) NUM2DBL(rb_ary_entry(ary, i)));
+  return v;
+}
+
+static gsl_vector_float* vector_float_from_vector(const gsl_vector *x)
+{
+  gsl_vector_float *v;
+  size_t i;
+  v = gsl_vector_float_alloc(x->size);
+  for (i = 0; i < x->size; i++)
+    v->data[i] = (float) x->data[i*x->stride];
+  return v;
+}
+
+/* Vector::Float.alloc(n), alloc(array), alloc(vector), alloc(x0, x1, ...) */
+static VALUE rb_gsl_vector_float_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_vector_float *v = NULL, *x;
+  gsl_vector *vd;
+  size_t i;
+  if (argc == 1) {
+    if (FIXNUM_P(argv[0])) {
+      v = gsl_vector_float_calloc(FIX2INT(argv[0]));
+    } else if (TYPE(argv[0]) == T_ARRAY) {
+      v = vector_float_from_ary(argv[0]);
+    } else if (VECTOR_FLOAT_P(argv[0])) {
+      Data_Get_Struct(argv[0], gsl_vector_float, x);
+      v = gsl_vector_float_alloc(x->size);
+      gsl_vector_float_memcpy(v, x);
+    } else if (VECTOR_P(argv[0])) {
+      Data_Get_Struct(argv[0], gsl_vector, vd);
+      v = vector_float_from_vector(vd);
+    }
+  }
+  if (v == NULL) {
+    if (argc == 0) rb_raise(rb_eArgError, "wrong number of arguments (0 for >= 1)");
+    v = gsl_vector_float_alloc(argc);
+    for (i = 0; i < (size_t) argc; i++)
+      gsl_vector_float_set(v, i, (float) NUM2DBL(argv[i]));
+  }
+  return Data_Wrap_Struct(klass, 0, gsl_vector_float_free, v);
+}
+
+static VALUE rb_gsl_vector_float_calloc(VALUE klass, VALUE n)
+{
+  return Data_Wrap_Struct(klass, 0, gsl_vector_float_free,
+			  gsl_vector_float_calloc(FIX2INT(n)));
+}
+
+static VALUE rb_gsl_vector_float_size(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_get_vector_float(obj)->size);
+}
+
+static size_t vector_float_index(const gsl_vector_float *v, VALUE ii)
+{
+  int i = NUM2INT(ii);
+  if (i < 0) i += v->size;
+  if (i < 0 || (size_t) i >= v->size)
+    rb_raise(rb_eIndexError, "index %d out of range", NUM2INT(ii));
+  return (size_t) i;
+}
+
+static VALUE rb_gsl_vector_float_get(VALUE obj, VALUE ii)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  return rb_float_new(gsl_vector_float_get(v, vector_float_index(v, ii)));
+}
+
+static VALUE rb_gsl_vector_float_set(VALUE obj, VALUE ii, VALUE x)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  gsl_vector_float_set(v, vector_float_index(v, ii), (float) NUM2DBL(x));
+  return x;
+}
+
+static VALUE rb_gsl_vector_float_set_all(VALUE obj, VALUE x)
+{
+  gsl_vector_float_set_all(rb_gsl_get_vector_float(obj), (float) NUM2DBL(x));
+  return obj;
+}
+
+static VALUE rb_gsl_vector_float_set_zero(VALUE obj)
+{
+  gsl_vector_float_set_zero(rb_gsl_get_vector_float(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_vector_float_to_a(VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  VALUE ary;
+  size_t i;
+  ary = rb_ary_new2(v->size);
+  for (i = 0; i < v->size; i++)
+    rb_ary_store(ary, i, rb_float_new(gsl_vector_float_get(v, i)));
+  return ary;
+}
+
+static VALUE rb_gsl_vector_float_each(VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  size_t i;
+  for (i = 0; i < v->size; i++) rb_yield(rb_float_new(gsl_vector_float_get(v, i)));
+  return obj;
+}
+
+/* Vector::Float#to_v: a double precision GSL::Vector */
+static VALUE rb_gsl_vector_float_to_v(VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  gsl_vector *vnew;
+  size_t i;
+  vnew = gsl_vector_alloc(v->size);
+  for (i = 0; i < v->size; i++) vnew->data[i] = v->data[i*v->stride];
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
+}
+
+/* Vector#to_float */
+static VALUE rb_gsl_vector_to_float(VALUE obj)
+{
+  gsl_vector *v = NULL;
+  Data_Get_Struct(obj, gsl_vector, v);
+  return rb_gsl_vector_float_wrap(vector_float_from_vector(v));
+}
+
+static VALUE rb_gsl_vector_float_to_s(VALUE obj)
+{
+  return rb_funcall(rb_gsl_vector_float_to_v(obj), rb_intern("to_s"), 0);
+}
+
+static VALUE rb_gsl_vector_float_inspect(VALUE obj)
+{
+  VALUE str;
+  char buf[64];
+  sprintf(buf, "%s\n", rb_class2name(CLASS_OF(obj)));
+  str = rb_str_new2(buf);
+  return rb_str_concat(str, rb_gsl_vector_float_to_s(obj));
+}
+
+static VALUE rb_gsl_vector_float_clone(VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj), *vnew;
+  vnew = gsl_vector_float_alloc(v->size);
+  gsl_vector_float_memcpy(vnew, v);
+  return rb_gsl_vector_float_wrap(vnew);
+}
+
+/* subvector(offset, n), subvector_with_stride(offset, stride, n) */
+static VALUE rb_gsl_vector_float_subvector(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  gsl_vector_float_view *vv;
+  size_t offset, stride = 1, n;
+  switch (argc) {
+  case 2:
+    offset = NUM2SIZET(argv[0]); n = NUM2SIZET(argv[1]);
+    break;
+  case 3:
+    offset = NUM2SIZET(argv[0]); stride = NUM2SIZET(argv[1]); n = NUM2SIZET(argv[2]);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  }
+  if (n == 0 || stride == 0 || offset + (n - 1)*stride >= v->size)
+    rb_raise(rb_eRangeError, "subvector out of range");
+  vv = ALLOC(gsl_vector_float_view);
+  *vv = gsl_vector_float_subvector_with_stride(v, offset, stride, n);
+  return Data_Wrap_Struct(cgsl_vector_float_view, 0, free, vv);
+}
+
+/* Elementwise out = a op b, or a op c when b is NULL */
+static void vector_float_op(gsl_vector_float *out, const gsl_vector_float *a,
+			    const gsl_vector_float *b, float c, int op)
+{
+  size_t i, so = out->stride, sa = a->stride, sb = b ? b->stride : 0;
+  float *o = out->data, y;
+  const float *x = a->data, *z = b ? b->data : &c;
+  for (i = 0; i < a->size; i++) {
+    y = z[i*sb];
+    switch (op) {
+    case MYGSL_KERNEL_ADD: o[i*so] = x[i*sa] + y; break;
+    case MYGSL_KERNEL_SUB: o[i*so] = x[i*sa] - y; break;
+    case MYGSL_KERNEL_MUL: o[i*so] = x[i*sa] * y; break;
+    default: o[i*so] = x[i*sa] / y; break;
+    }
+  }
+}
+
+static VALUE vector_float_arith(VALUE obj, VALUE other, int op, int inplace)
+{
+  gsl_vector_float *a = rb_gsl_get_vector_float(obj), *b = NULL, *out;
+  float c = 0.0;
+  if (VECTOR_FLOAT_P(other)) {
+    Data_Get_Struct(other, gsl_vector_float, b);
+    if (b->size != a->size)
+      rb_raise(rb_eArgError, "vectors must have same length (%d and %d)",
+	       (int) a->size, (int) b->size);
+  } else {
+    c = (float) NUM2DBL(other);
+  }
+  if (inplace) {
+    vector_float_op(a, a, b, c, op);
+    return obj;
+  }
+  out = gsl_vector_float_alloc(a->size);
+  vector_float_op(out, a, b, c, op);
+  return rb_gsl_vector_float_wrap(out);
+}
+
+static VALUE rb_gsl_vector_float_add(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_ADD, 0);
+}
+
+static VALUE rb_gsl_vector_float_sub(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_SUB, 0);
+}
+
+static VALUE rb_gsl_vector_float_mul(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_MUL, 0);
+}
+
+static VALUE rb_gsl_vector_float_div(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_DIV, 0);
+}
+
+static VALUE rb_gsl_vector_float_add_bang(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_ADD, 1);
+}
+
+static VALUE rb_gsl_vector_float_sub_bang(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_SUB, 1);
+}
+
+static VALUE rb_gsl_vector_float_mul_bang(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_MUL, 1);
+}
+
+static VALUE rb_gsl_vector_float_div_bang(VALUE obj, VALUE b)
+{
+  return vector_float_arith(obj, b, MYGSL_KERNEL_DIV, 1);
+}
+
+static VALUE rb_gsl_vector_float_uminus(VALUE obj)
+{
+  return vector_float_arith(obj, INT2FIX(-1), MYGSL_KERNEL_MUL, 0);
+}
+
+static VALUE rb_gsl_vector_float_coerce(VALUE obj, VALUE other)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj), *vnew;
+  vnew = gsl_vector_float_alloc(v->size);
+  gsl_vector_float_set_all(vnew, (float) NUM2DBL(other));
+  return rb_ary_new3(2, rb_gsl_vector_float_wrap(vnew), obj);
+}
+
+static VALUE rb_gsl_vector_float_sum(VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  double sum = 0.0;
+  size_t i;
+  for (i = 0; i < v->size; i++) sum += v->data[i*v->stride];
+  return rb_float_new(sum);
+}
+
+static VALUE rb_gsl_vector_float_max(VALUE obj)
+{
+  return rb_float_new(gsl_vector_float_max(rb_gsl_get_vector_float(obj)));
+}
+
+static VALUE rb_gsl_vector_float_min(VALUE obj)
+{
+  return rb_float_new(gsl_vector_float_min(rb_gsl_get_vector_float(obj)));
+}
+
+static VALUE rb_gsl_vector_float_minmax(VALUE obj)
+{
+  float min, max;
+  gsl_vector_float_minmax(rb_gsl_get_vector_float(obj), &min, &max);
+  return rb_ary_new3(2, rb_float_new(min), rb_float_new(max));
+}
+
+static VALUE rb_gsl_vector_float_max_index(VALUE obj)
+{
+  return SIZET2NUM(gsl_vector_float_max_index(rb_gsl_get_vector_float(obj)));
+}
+
+static VALUE rb_gsl_vector_float_min_index(VALUE obj)
+{
+  return SIZET2NUM(gsl_vector_float_min_index(rb_gsl_get_vector_float(obj)));
+}
+
+/* BLAS level 1: dot products accumulate in double (dsdot) */
+static VALUE rb_gsl_vector_float_dot(VALUE obj, VALUE other)
+{
+  gsl_vector_float *a = rb_gsl_get_vector_float(obj), *b = rb_gsl_get_vector_float(other);
+  double r;
+  gsl_blas_dsdot(a, b, &r);
+  return rb_float_new(r);
+}
+
+static VALUE rb_gsl_vector_float_nrm2(VALUE obj)
+{
+  return rb_float_new(gsl_blas_snrm2(rb_gsl_get_vector_float(obj)));
+}
+
+static VALUE rb_gsl_vector_float_asum(VALUE obj)
+{
+  return rb_float_new(gsl_blas_sasum(rb_gsl_get_vector_float(obj)));
+}
+
+/* self += alpha*x */
+static VALUE rb_gsl_vector_float_axpy_bang(VALUE obj, VALUE alpha, VALUE x)
+{
+  gsl_blas_saxpy((float) NUM2DBL(alpha), rb_gsl_get_vector_float(x),
+		 rb_gsl_get_vector_float(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_vector_float_scale_bang(VALUE obj, VALUE alpha)
+{
+  gsl_blas_sscal((float) NUM2DBL(alpha), rb_gsl_get_vector_float(obj));
+  return obj;
+}
+
+static VALUE rb_gsl_vector_float_to_binary(VALUE obj)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  VALUE str;
+  float *p;
+  size_t i;
+  if (v->stride == 1) return rb_str_new((char*) v->data, v->size*sizeof(float));
+  str = rb_str_new(NULL, v->size*sizeof(float));
+  p = (float*) RSTRING_PTR(str);
+  for (i = 0; i < v->size; i++) p[i] = v->data[i*v->stride];
+  return str;
+}
+
+static void vector_float_set_binary(gsl_vector_float *v, const char *s)
+{
+  size_t i;
+  if (v->stride == 1) {
+    memcpy(v->data, s, v->size*sizeof(float));
+    return;
+  }
+  for (i = 0; i < v->size; i++)
+    memcpy(v->data + i*v->stride, s + i*sizeof(float), sizeof(float));
+}
+
+static VALUE rb_gsl_vector_float_from_binary(VALUE klass, VALUE str)
+{
+  gsl_vector_float *v;
+  size_t len;
+  StringValue(str);
+  len = RSTRING_LEN(str);
+  if (len == 0 || len % sizeof(float))
+    rb_raise(rb_eArgError, "binary length %d is not a positive multiple of %d",
+	     (int) len, (int) sizeof(float));
+  v = gsl_vector_float_alloc(len/sizeof(float));
+  vector_float_set_binary(v, RSTRING_PTR(str));
+  return Data_Wrap_Struct(klass, 0, gsl_vector_float_free, v);
+}
+
+/* io is a file name or an object responding to write / read */
+static VALUE rb_gsl_vector_float_fwrite(VALUE obj, VALUE io)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  FILE *f;
+  int status, flag = 0;
+  if (TYPE(io) != T_STRING) {
+    rb_funcall(io, rb_intern("write"), 1, rb_gsl_vector_float_to_binary(obj));
+    return INT2FIX(GSL_SUCCESS);
+  }
+  f = rb_gsl_open_writefile(io, &flag);
+  status = gsl_vector_float_fwrite(f, v);
+  if (flag == 1) fclose(f);
+  return INT2FIX(status);
+}
+
+static VALUE rb_gsl_vector_float_fread(VALUE obj, VALUE io)
+{
+  gsl_vector_float *v = rb_gsl_get_vector_float(obj);
+  FILE *f;
+  VALUE str;
+  int status, flag = 0;
+  if (TYPE(io) != T_STRING) {
+    str = rb_funcall(io, rb_intern("read"), 1, SIZET2NUM(v->size*sizeof(float)));
+    if (NIL_P(str) || (size_t) RSTRING_LEN(str) != v->size*sizeof(float))
+      rb_raise(rb_eIOError, "end of input before %d elements were read", (int) v->size);
+    vector_float_set_binary(v, RSTRING_PTR(str));
+    return INT2FIX(GSL_SUCCESS);
+  }
+  f = rb_gsl_open_readfile(io, &flag);
+  status = gsl_vector_float_fread(f, v);
+  if (flag == 1) fclose(f);
+  return INT2FIX(status);
+}
+
+void Init_gsl_vector_float(VALUE module)
+{
+  rb_define_singleton_method(cgsl_vector_float, "new", rb_gsl_vector_float_new, -1);
+  rb_define_singleton_method(cgsl_vector_float, "alloc", rb_gsl_vector_float_new, -1);
+  rb_define_singleton_method(cgsl_vector_float, "[]", rb_gsl_vector_float_new, -1);
+  rb_define_singleton_method(cgsl_vector_float, "calloc", rb_gsl_vector_float_calloc, 1);
+
+  rb_define_method(cgsl_vector_float, "size", rb_gsl_vector_float_size, 0);
+  rb_define_alias(cgsl_vector_float, "len", "size");
+  rb_define_alias(cgsl_vector_float, "length", "size");
+  rb_define_method(cgsl_vector_float, "get", rb_gsl_vector_float_get, 1);
+  rb_define_alias(cgsl_vector_float, "[]", "get");
+  rb_define_method(cgsl_vector_float, "set", rb_gsl_vector_float_set, 2);
+  rb_define_alias(cgsl_vector_float, "[]=", "set");
+  rb_define_method(cgsl_vector_float, "set_all", rb_gsl_vector_float_set_all, 1);
+  rb_define_method(cgsl_vector_float, "set_zero", rb_gsl_vector_float_set_zero, 0);
+  rb_define_method(cgsl_vector_float, "to_a", rb_gsl_vector_float_to_a, 0);
+  rb_define_method(cgsl_vector_float, "each", rb_gsl_vector_float_each, 0);
+  rb_define_method(cgsl_vector_float, "to_v", rb_gsl_vector_float_to_v, 0);
+  rb_define_alias(cgsl_vector_float, "to_double", "to_v");
+  rb_define_method(cgsl_vector, "to_float", rb_gsl_vector_to_float, 0);
+  rb_define_method(cgsl_vector_float, "to_s", rb_gsl_vector_float_to_s, 0);
+  rb_define_method(cgsl_vector_float, "inspect", rb_gsl_vector_float_inspect, 0);
+  rb_define_method(cgsl_vector_float, "clone", rb_gsl_vector_float_clone, 0);
+  rb_define_alias(cgsl_vector_float, "dup", "clone");
+  rb_define_method(cgsl_vector_float, "subvector", rb_gsl_vector_float_subvector, -1);
+  rb_define_alias(cgsl_vector_float, "view", "subvector");
+  rb_define_alias(cgsl_vector_float, "subvector_with_stride", "subvector");
+
+  rb_define_method(cgsl_vector_float, "+", rb_gsl_vector_float_add, 1);
+  rb_define_method(cgsl_vector_float, "-", rb_gsl_vector_float_sub, 1);
+  rb_define_method(cgsl_vector_float, "*", rb_gsl_vector_float_mul, 1);
+  rb_define_method(cgsl_vector_float, "/", rb_gsl_vector_float_div, 1);
+  rb_define_method(cgsl_vector_float, "add!", rb_gsl_vector_float_add_bang, 1);
+  rb_define_method(cgsl_vector_float, "sub!", rb_gsl_vector_float_sub_bang, 1);
+  rb_define_method(cgsl_vector_float, "mul!", rb_gsl_vector_float_mul_bang, 1);
+  rb_define_method(cgsl_vector_float, "div!", rb_gsl_vector_float_div_bang, 1);
+  rb_define_method(cgsl_vector_float, "-@", rb_gsl_vector_float_uminus, 0);
+  rb_define_method(cgsl_vector_float, "coerce", rb_gsl_vector_float_coerce, 1);
+
+  rb_define_method(cgsl_vector_float, "sum", rb_gsl_vector_float_sum, 0);
+  rb_define_method(cgsl_vector_float, "max", rb_gsl_vector_float_max, 0);
+  rb_define_method(cgsl_vector_float, "min", rb_gsl_vector_float_min, 0);
+  rb_define_method(cgsl_vector_float, "minmax", rb_gsl_vector_float_minmax, 0);
+  rb_define_method(cgsl_vector_float, "max_index", rb_gsl_vector_float_max_index, 0);
+  rb_define_method(cgsl_vector_float, "min_index", rb_gsl_vector_float_min_index, 0);
+
+  rb_define_method(cgsl_vector_float, "dot", rb_gsl_vector_float_dot, 1);
+  rb_define_alias(cgsl_vector_float, "sdot", "dot");
+  rb_define_method(cgsl_vector_float, "nrm2", rb_gsl_vector_float_nrm2, 0);
+  rb_define_alias(cgsl_vector_float, "snrm2", "nrm2");
+  rb_define_alias(cgsl_vector_float, "norm", "nrm2");
+  rb_define_method(cgsl_vector_float, "asum", rb_gsl_vector_float_asum, 0);
+  rb_define_method(cgsl_vector_float, "axpy!", rb_gsl_vector_float_axpy_bang, 2);
+  rb_define_method(cgsl_vector_float, "scale!", rb_gsl_vector_float_scale_bang, 1);
+
+  rb_define_method(cgsl_vector_float, "to_binary", rb_gsl_vector_float_to_binary, 0);
+  rb_define_singleton_method(cgsl_vector_float, "from_binary",
+			     rb_gsl_vector_float_from_binary, 1);
+  rb_define_method(cgsl_vector_float, "fwrite", rb_gsl_vector_float_fwrite, 1);
+  rb_define_method(cgsl_vector_float, "fread", rb_gsl_vector_float_fread, 1);
+}
@@ -187,7 +187,7 @@ void Init_gsl_vector_int(VALUE module)
   rb_define_method(cgsl_vector_int, "to_complex", rb_gsl_vector_int_to_complex, 0);
 
   /*****/
-  rb_define_method(cgsl_vector_int, "coerce", rb_gsl_vector_int_coerce, 1);
+  rb_gsl_define_coerce(cgsl_vector_int, rb_gsl_vector_int_coerce);
 
   rb_define_method(cgsl_vector_int, "add", rb_gsl_vector_int_add, 1);
   rb_define_method(cgsl_vector_int, "sub", rb_gsl_vector_int_sub, 1);
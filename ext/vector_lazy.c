@@ -0,0 +1,545 @@
+/*
+  vector_lazy.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Vector::Lazy: deferred elementwise expressions.
+
+    a.lazy + b*2.0 - c.lazy.abs
+
+  builds an expression tree instead of allocating a vector for every
+  operator.  The tree is evaluated by to_v (or eval(out)) in a single
+  pass over the data, LAZY_CHUNK elements at a time, without
+  intermediate vectors.
+
+  The leaves can also be generators, whose elements are computed where
+  they are read and never stored:
+
+    GSL::Vector::Lazy.linspace(0, 1, 10**9).sin.sum
+    GSL::Vector::Lazy.logspace(-3, 3, n).each_chunk { |x| GSL::Sf::gamma(x) }
+
+  with the same elements as GSL::Vector.linspace and logspace, and
+  start + i*step for indgen.  The C functions read the data of their
+  GSL::Vector arguments directly, so a lazy vector is not one of them:
+  each_chunk yields its elements in pieces, in a single vector reused
+  from one piece to the next, to_v stores it whole, and [], sum, min
+  and max read it without storing.
+*/
+
+#include "rb_gsl_config.h"
+#include "rb_gsl_array.h"
+#include "rb_gsl_common.h"
+
+static VALUE cgsl_vector_lazy;
+
+enum {
+  LAZY_VECTOR,
+  LAZY_CONST,
+  LAZY_ADD,
+  LAZY_SUB,
+  LAZY_MUL,
+  LAZY_DIV,
+  LAZY_POW,
+  LAZY_NEG,
+  LAZY_ABS,
+  LAZY_SQRT,
+  LAZY_SQUARE,
+  LAZY_EXP,
+  LAZY_LOG,
+  LAZY_SIN,
+  LAZY_COS,
+  LAZY_TANH,
+  LAZY_LINSPACE,
+  LAZY_LOGSPACE,
+  LAZY_INDGEN,
+};
+
+#define LAZY_CHUNK 256
+
+typedef struct {
+  int op;
+  double c;
+  VALUE a, b;      /* operands: Lazy, or the GSL::Vector of a LAZY_VECTOR */
+  size_t size;     /* 0 for constants */
+  double h, end;   /* generators: c + i*h, end the last of linspace and logspace */
+} rb_gsl_lazy;
+
+static void rb_gsl_lazy_mark(rb_gsl_lazy *e)
+{
+  rb_gc_mark(e->a);
+  rb_gc_mark(e->b);
+}
+
+static VALUE rb_gsl_lazy_wrap(int op, double c, VALUE a, VALUE b, size_t size)
+{
+  rb_gsl_lazy *e = ALLOC(rb_gsl_lazy);
+  e->op = op;
+  e->c = c;
+  e->a = a;
+  e->b = b;
+  e->size = size;
+  e->h = e->end = 0.0;
+  return Data_Wrap_Struct(cgsl_vector_lazy, rb_gsl_lazy_mark, free, e);
+}
+
+static VALUE rb_gsl_lazy_operand(VALUE x)
+{
+  gsl_vector *v;
+  if (rb_obj_is_kind_of(x, cgsl_vector_lazy)) return x;
+  if (VECTOR_P(x)) {
+    Data_Get_Struct(x, gsl_vector, v);
+    return rb_gsl_lazy_wrap(LAZY_VECTOR, 0.0, x, Qnil, v->size);
+  }
+  if (rb_obj_is_kind_of(x, rb_cNumeric))
+    return rb_gsl_lazy_wrap(LAZY_CONST, NUM2DBL(x), Qnil, Qnil, 0);
+  rb_raise(rb_eTypeError, "wrong argument type %s (Vector, Vector::Lazy or Numeric expected)",
+	   rb_class2name(CLASS_OF(x)));
+  return Qnil;
+}
+
+static size_t rb_gsl_lazy_size(VALUE x)
+{
+  rb_gsl_lazy *e;
+  Data_Get_Struct(x, rb_gsl_lazy, e);
+  return e->size;
+}
+
+static VALUE rb_gsl_lazy_binary(int op, VALUE obj, VALUE other)
+{
+  size_t n1, n2;
+  other = rb_gsl_lazy_operand(other);
+  n1 = rb_gsl_lazy_size(obj);
+  n2 = rb_gsl_lazy_size(other);
+  if (n1 && n2 && n1 != n2)
+    rb_raise(rb_eRangeError, "vector sizes differ (%d and %d)", (int) n1, (int) n2);
+  return rb_gsl_lazy_wrap(op, 0.0, obj, other, n1 ? n1 : n2);
+}
+
+static VALUE rb_gsl_lazy_unary(int op, VALUE obj)
+{
+  return rb_gsl_lazy_wrap(op, 0.0, obj, Qnil, rb_gsl_lazy_size(obj));
+}
+
+static VALUE rb_gsl_vector_lazy(VALUE obj)
+{
+  return rb_gsl_lazy_operand(obj);
+}
+
+static VALUE rb_gsl_lazy_add(VALUE obj, VALUE b) { return rb_gsl_lazy_binary(LAZY_ADD, obj, b); }
+static VALUE rb_gsl_lazy_sub(VALUE obj, VALUE b) { return rb_gsl_lazy_binary(LAZY_SUB, obj, b); }
+static VALUE rb_gsl_lazy_mul(VALUE obj, VALUE b) { return rb_gsl_lazy_binary(LAZY_MUL, obj, b); }
+static VALUE rb_gsl_lazy_div(VALUE obj, VALUE b) { return rb_gsl_lazy_binary(LAZY_DIV, obj, b); }
+static VALUE rb_gsl_lazy_pow(VALUE obj, VALUE b) { return rb_gsl_lazy_binary(LAZY_POW, obj, b); }
+static VALUE rb_gsl_lazy_neg(VALUE obj) { return rb_gsl_lazy_unary(LAZY_NEG, obj); }
+static VALUE rb_gsl_lazy_abs(VALUE obj) { return rb_gsl_lazy_unary(LAZY_ABS, obj); }
+static VALUE rb_gsl_lazy_sqrt(VALUE obj) { return rb_gsl_lazy_unary(LAZY_SQRT, obj); }
+static VALUE rb_gsl_lazy_square(VALUE obj) { return rb_gsl_lazy_unary(LAZY_SQUARE, obj); }
+static VALUE rb_gsl_lazy_exp(VALUE obj) { return rb_gsl_lazy_unary(LAZY_EXP, obj); }
+static VALUE rb_gsl_lazy_log(VALUE obj) { return rb_gsl_lazy_unary(LAZY_LOG, obj); }
+static VALUE rb_gsl_lazy_sin(VALUE obj) { return rb_gsl_lazy_unary(LAZY_SIN, obj); }
+static VALUE rb_gsl_lazy_cos(VALUE obj) { return rb_gsl_lazy_unary(LAZY_COS, obj); }
+static VALUE rb_gsl_lazy_tanh(VALUE obj) { return rb_gsl_lazy_unary(LAZY_TANH, obj); }
+
+static VALUE rb_gsl_lazy_coerce(VALUE obj, VALUE other)
+{
+  return rb_ary_new3(2, rb_gsl_lazy_operand(other), obj);
+}
+
+static VALUE rb_gsl_lazy_size_get(VALUE obj)
+{
+  return SIZET2NUM(rb_gsl_lazy_size(obj));
+}
+
+/*
+  Evaluation: the tree is flattened into a postfix program run on a
+  stack of LAZY_CHUNK-element buffers.
+*/
+struct lazy_instr {
+  int op;
+  double c, h, end;
+  size_t size;
+  const gsl_vector *v;
+};
+
+struct lazy_prog {
+  struct lazy_instr *code;
+  size_t len, depth;
+  double *stack;
+  gsl_vector *out;
+  size_t first;    /* out receives the elements first ... first+out->size-1 */
+};
+
+/* Elements i0 ... i0+nb-1 of a generator */
+static void lazy_generate(const struct lazy_instr *in, size_t i0, size_t nb, double *s)
+{
+  size_t i;
+  switch (in->op) {
+  case LAZY_LINSPACE:
+    for (i = 0; i < nb; i++) s[i] = (i0 + i)*in->h + in->c;
+    if (i0 == 0) s[0] = in->c;
+    if (in->size > 1 && i0 + nb == in->size) s[nb-1] = in->end;
+    break;
+  case LAZY_LOGSPACE:
+    for (i = 0; i < nb; i++) s[i] = pow(10.0, in->h*(i0 + i) + in->c);
+    if (i0 == 0) s[0] = pow(10.0, in->c);
+    if (in->size > 1 && i0 + nb == in->size) s[nb-1] = pow(10.0, in->end);
+    break;
+  default:
+    for (i = 0; i < nb; i++) s[i] = in->c + (i0 + i)*in->h;
+    break;
+  }
+}
+
+static size_t lazy_compile(VALUE x, struct lazy_instr *code, size_t *len,
+			   size_t *depth, size_t sp)
+{
+  rb_gsl_lazy *e;
+  gsl_vector *v;
+  struct lazy_instr *in;
+  size_t d;
+  Data_Get_Struct(x, rb_gsl_lazy, e);
+  switch (e->op) {
+  case LAZY_VECTOR:
+  case LAZY_CONST:
+  case LAZY_LINSPACE:
+  case LAZY_LOGSPACE:
+  case LAZY_INDGEN:
+    d = sp + 1;
+    break;
+  case LAZY_ADD: case LAZY_SUB: case LAZY_MUL: case LAZY_DIV: case LAZY_POW:
+    lazy_compile(e->a, code, len, depth, sp);
+    lazy_compile(e->b, code, len, depth, sp + 1);
+    d = sp + 1;
+    break;
+  default:
+    lazy_compile(e->a, code, len, depth, sp);
+    d = sp + 1;
+    break;
+  }
+  if (d > *depth) *depth = d;
+  if (code) {
+    in = &code[*len];
+    in->op = e->op;
+    in->c = e->c;
+    in->h = e->h;
+    in->end = e->end;
+    in->size = e->size;
+    in->v = NULL;
+    if (e->op == LAZY_VECTOR) {
+      Data_Get_Struct(e->a, gsl_vector, v);
+      in->v = v;
+    }
+  }
+  (*len)++;
+  return d;
+}
+
+static int lazy_run(void *data)
+{
+  struct lazy_prog *p = (struct lazy_prog *) data;
+  const struct lazy_instr *in;
+  size_t i0, nb, i, k, sp;
+  double *s, *t;
+  const double *src;
+
+  for (i0 = 0; i0 < p->out->size; i0 += LAZY_CHUNK) {
+    nb = GSL_MIN(LAZY_CHUNK, p->out->size - i0);
+    sp = 0;
+    for (k = 0; k < p->len; k++) {
+      in = &p->code[k];
+      switch (in->op) {
+      case LAZY_VECTOR:
+	s = p->stack + LAZY_CHUNK*sp++;
+	src = in->v->data + (p->first + i0)*in->v->stride;
+	if (in->v->stride == 1) memcpy(s, src, sizeof(double)*nb);
+	else for (i = 0; i < nb; i++) s[i] = src[i*in->v->stride];
+	continue;
+      case LAZY_CONST:
+	s = p->stack + LAZY_CHUNK*sp++;
+	for (i = 0; i < nb; i++) s[i] = in->c;
+	continue;
+      case LAZY_LINSPACE: case LAZY_LOGSPACE: case LAZY_INDGEN:
+	lazy_generate(in, p->first + i0, nb, p->stack + LAZY_CHUNK*sp++);
+	continue;
+      case LAZY_ADD: case LAZY_SUB: case LAZY_MUL: case LAZY_DIV: case LAZY_POW:
+	sp--;
+	s = p->stack + LAZY_CHUNK*(sp - 1);
+	t = p->stack + LAZY_CHUNK*sp;
+	switch (in->op) {
+	case LAZY_ADD: for (i = 0; i < nb; i++) s[i] += t[i]; break;
+	case LAZY_SUB: for (i = 0; i < nb; i++) s[i] -= t[i]; break;
+	case LAZY_MUL: for (i = 0; i < nb; i++) s[i] *= t[i]; break;
+	case LAZY_DIV: for (i = 0; i < nb; i++) s[i] /= t[i]; break;
+	default: for (i = 0; i < nb; i++) s[i] = pow(s[i], t[i]); break;
+	}
+	continue;
+      default:
+	s = p->stack + LAZY_CHUNK*(sp - 1);
+	switch (in->op) {
+	case LAZY_NEG: for (i = 0; i < nb; i++) s[i] = -s[i]; break;
+	case LAZY_ABS: for (i = 0; i < nb; i++) s[i] = fabs(s[i]); break;
+	case LAZY_SQRT: for (i = 0; i < nb; i++) s[i] = sqrt(s[i]); break;
+	case LAZY_SQUARE: for (i = 0; i < nb; i++) s[i] *= s[i]; break;
+	case LAZY_EXP: for (i = 0; i < nb; i++) s[i] = exp(s[i]); break;
+	case LAZY_LOG: for (i = 0; i < nb; i++) s[i] = log(s[i]); break;
+	case LAZY_SIN: for (i = 0; i < nb; i++) s[i] = sin(s[i]); break;
+	case LAZY_COS: for (i = 0; i < nb; i++) s[i] = cos(s[i]); break;
+	default: for (i = 0; i < nb; i++) s[i] = tanh(s[i]); break;
+	}
+	continue;
+      }
+    }
+    s = p->stack;
+    t = p->out->data + i0*p->out->stride;
+    if (p->out->stride == 1) memcpy(t, s, sizeof(double)*nb);
+    else for (i = 0; i < nb; i++) t[i*p->out->stride] = s[i];
+  }
+  return GSL_SUCCESS;
+}
+
+/* Compiles obj into p, from element 0 (p->out is left to the caller) */
+static void lazy_prog_init(struct lazy_prog *p, VALUE obj)
+{
+  p->len = 0;
+  p->depth = 0;
+  p->first = 0;
+  lazy_compile(obj, NULL, &p->len, &p->depth, 0);
+  p->code = ALLOC_N(struct lazy_instr, p->len);
+  p->stack = ALLOC_N(double, LAZY_CHUNK*p->depth);
+  p->len = 0;
+  lazy_compile(obj, p->code, &p->len, &p->depth, 0);
+}
+
+static void lazy_prog_free(struct lazy_prog *p)
+{
+  xfree(p->code);
+  xfree(p->stack);
+}
+
+/* lazy.eval([out]): evaluates into out (which may be one of the operands)
+   or into a new vector */
+static VALUE rb_gsl_lazy_eval(int argc, VALUE *argv, VALUE obj)
+{
+  struct lazy_prog p;
+  size_t n;
+  VALUE vout;
+
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  n = rb_gsl_lazy_size(obj);
+  if (argc == 1) {
+    CHECK_VECTOR(argv[0]);
+    Data_Get_Struct(argv[0], gsl_vector, p.out);
+    if (n && p.out->size != n)
+      rb_raise(rb_eRangeError, "output vector size must be %d", (int) n);
+    vout = argv[0];
+  } else {
+    if (n == 0) rb_raise(rb_eArgError, "constant expression has no size");
+    p.out = gsl_vector_alloc(n);
+    vout = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, p.out);
+  }
+  lazy_prog_init(&p, obj);
+  rb_gsl_nogvl_call(lazy_run, &p, p.out->size*p.len);
+  lazy_prog_free(&p);
+  return vout;
+}
+
+/* Generators: Lazy.linspace(min, max, n = 10), logspace(min, max, n = 10) */
+static VALUE rb_gsl_lazy_xspace(int argc, VALUE *argv, int op)
+{
+  rb_gsl_lazy *e;
+  size_t n = 10;
+  double min, max;
+  VALUE obj;
+  if (argc < 2 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  if (argc == 3) n = NUM2SIZET(argv[2]);
+  if (n == 0) rb_raise(rb_eArgError, "size must be positive");
+  min = NUM2DBL(rb_Float(argv[0]));
+  max = NUM2DBL(rb_Float(argv[1]));
+  obj = rb_gsl_lazy_wrap(op, min, Qnil, Qnil, n);
+  Data_Get_Struct(obj, rb_gsl_lazy, e);
+  e->h = n > 1 ? (max - min)/(n - 1) : 0.0;
+  e->end = max;
+  return obj;
+}
+
+static VALUE rb_gsl_lazy_linspace(int argc, VALUE *argv, VALUE klass)
+{
+  return rb_gsl_lazy_xspace(argc, argv, LAZY_LINSPACE);
+}
+
+static VALUE rb_gsl_lazy_logspace(int argc, VALUE *argv, VALUE klass)
+{
+  return rb_gsl_lazy_xspace(argc, argv, LAZY_LOGSPACE);
+}
+
+/* Lazy.indgen(n, start = 0, step = 1) */
+static VALUE rb_gsl_lazy_indgen(int argc, VALUE *argv, VALUE klass)
+{
+  rb_gsl_lazy *e;
+  size_t n;
+  VALUE obj;
+  if (argc < 1 || argc > 3)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-3)", argc);
+  n = NUM2SIZET(argv[0]);
+  if (n == 0) rb_raise(rb_eArgError, "size must be positive");
+  obj = rb_gsl_lazy_wrap(LAZY_INDGEN, argc > 1 ? NUM2DBL(rb_Float(argv[1])) : 0.0,
+			 Qnil, Qnil, n);
+  Data_Get_Struct(obj, rb_gsl_lazy, e);
+  e->h = argc > 2 ? NUM2DBL(rb_Float(argv[2])) : 1.0;
+  return obj;
+}
+
+/* Element i (negative from the end), computed alone */
+static VALUE rb_gsl_lazy_get(VALUE obj, VALUE ii)
+{
+  struct lazy_prog p;
+  gsl_vector out;
+  double x;
+  long i = NUM2LONG(ii);
+  size_t n = rb_gsl_lazy_size(obj);
+  if (n == 0) rb_raise(rb_eArgError, "constant expression has no size");
+  if (i < 0) i += (long) n;
+  if (i < 0 || (size_t) i >= n) rb_raise(rb_eRangeError, "index %ld out of range", NUM2LONG(ii));
+  out.size = 1;
+  out.stride = 1;
+  out.data = &x;
+  out.block = NULL;
+  out.owner = 0;
+  lazy_prog_init(&p, obj);
+  p.out = &out;
+  p.first = (size_t) i;
+  lazy_run(&p);
+  lazy_prog_free(&p);
+  return rb_float_new(x);
+}
+
+#define LAZY_PIECE (64*LAZY_CHUNK)
+
+/*
+  each_chunk(size = 16384) { |v, first| }: v holds elements first ...
+  first+v.size-1; the same vector is filled again for every piece
+*/
+static VALUE rb_gsl_lazy_each_chunk(int argc, VALUE *argv, VALUE obj)
+{
+  struct lazy_prog p;
+  gsl_vector *v;
+  size_t n, piece = LAZY_PIECE, i0;
+  VALUE vv;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) piece = NUM2SIZET(argv[0]);
+  if (piece == 0) rb_raise(rb_eArgError, "chunk size must be positive");
+  n = rb_gsl_lazy_size(obj);
+  if (n == 0) rb_raise(rb_eArgError, "constant expression has no size");
+  piece = GSL_MIN(piece, n);
+  v = gsl_vector_alloc(piece);
+  vv = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  for (i0 = 0; i0 < n; i0 += piece) {
+    v->size = GSL_MIN(piece, n - i0);
+    lazy_prog_init(&p, obj);
+    p.out = v;
+    p.first = i0;
+    rb_gsl_nogvl_call(lazy_run, &p, v->size*p.len);
+    lazy_prog_free(&p);
+    rb_yield_values(2, vv, SIZET2NUM(i0));
+  }
+  return obj;
+}
+
+struct lazy_reduce {
+  struct lazy_prog p;
+  size_t n;
+  int op;          /* 0 sum, 1 min, 2 max */
+  double r;
+};
+
+static int lazy_reduce_run(void *data)
+{
+  struct lazy_reduce *t = (struct lazy_reduce *) data;
+  double buf[LAZY_CHUNK], s;
+  gsl_vector out;
+  size_t i0, i;
+  out.stride = 1;
+  out.data = buf;
+  out.block = NULL;
+  out.owner = 0;
+  t->p.out = &out;
+  t->r = t->op == 0 ? 0.0 : (t->op == 1 ? GSL_POSINF : GSL_NEGINF);
+  for (i0 = 0; i0 < t->n; i0 += LAZY_CHUNK) {
+    out.size = GSL_MIN(LAZY_CHUNK, t->n - i0);
+    t->p.first = i0;
+    lazy_run(&t->p);
+    switch (t->op) {
+    case 0:
+      for (i = 0, s = 0.0; i < out.size; i++) s += buf[i];
+      t->r += s;
+      break;
+    case 1:
+      for (i = 0; i < out.size; i++) if (buf[i] < t->r || gsl_isnan(buf[i])) t->r = buf[i];
+      break;
+    default:
+      for (i = 0; i < out.size; i++) if (buf[i] > t->r || gsl_isnan(buf[i])) t->r = buf[i];
+      break;
+    }
+    if (t->op && gsl_isnan(t->r)) break;
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_lazy_reduce(VALUE obj, int op)
+{
+  struct lazy_reduce t;
+  t.n = rb_gsl_lazy_size(obj);
+  if (t.n == 0) rb_raise(rb_eArgError, "constant expression has no size");
+  t.op = op;
+  lazy_prog_init(&t.p, obj);
+  rb_gsl_nogvl_call(lazy_reduce_run, &t, t.n*t.p.len);
+  lazy_prog_free(&t.p);
+  return rb_float_new(t.r);
+}
+
+static VALUE rb_gsl_lazy_sum(VALUE obj) { return rb_gsl_lazy_reduce(obj, 0); }
+static VALUE rb_gsl_lazy_min(VALUE obj) { return rb_gsl_lazy_reduce(obj, 1); }
+static VALUE rb_gsl_lazy_max(VALUE obj) { return rb_gsl_lazy_reduce(obj, 2); }
+
+void Init_gsl_vector_lazy(VALUE module)
+{
+  cgsl_vector_lazy = rb_define_class_under(cgsl_vector, "Lazy", cGSL_Object);
+  rb_define_method(cgsl_vector, "lazy", rb_gsl_vector_lazy, 0);
+
+  rb_define_method(cgsl_vector_lazy, "+", rb_gsl_lazy_add, 1);
+  rb_define_method(cgsl_vector_lazy, "-", rb_gsl_lazy_sub, 1);
+  rb_define_method(cgsl_vector_lazy, "*", rb_gsl_lazy_mul, 1);
+  rb_define_method(cgsl_vector_lazy, "/", rb_gsl_lazy_div, 1);
+  rb_define_method(cgsl_vector_lazy, "**", rb_gsl_lazy_pow, 1);
+  rb_define_method(cgsl_vector_lazy, "-@", rb_gsl_lazy_neg, 0);
+  rb_define_method(cgsl_vector_lazy, "abs", rb_gsl_lazy_abs, 0);
+  rb_define_method(cgsl_vector_lazy, "sqrt", rb_gsl_lazy_sqrt, 0);
+  rb_define_method(cgsl_vector_lazy, "square", rb_gsl_lazy_square, 0);
+  rb_define_method(cgsl_vector_lazy, "exp", rb_gsl_lazy_exp, 0);
+  rb_define_method(cgsl_vector_lazy, "log", rb_gsl_lazy_log, 0);
+  rb_define_method(cgsl_vector_lazy, "sin", rb_gsl_lazy_sin, 0);
+  rb_define_method(cgsl_vector_lazy, "cos", rb_gsl_lazy_cos, 0);
+  rb_define_method(cgsl_vector_lazy, "tanh", rb_gsl_lazy_tanh, 0);
+  rb_define_method(cgsl_vector_lazy, "coerce", rb_gsl_lazy_coerce, 1);
+  rb_define_method(cgsl_vector_lazy, "size", rb_gsl_lazy_size_get, 0);
+
+  rb_define_method(cgsl_vector_lazy, "eval", rb_gsl_lazy_eval, -1);
+  rb_define_alias(cgsl_vector_lazy, "to_v", "eval");
+  rb_define_alias(cgsl_vector_lazy, "materialize", "eval");
+
+  rb_define_singleton_method(cgsl_vector_lazy, "linspace", rb_gsl_lazy_linspace, -1);
+  rb_define_singleton_method(cgsl_vector_lazy, "logspace", rb_gsl_lazy_logspace, -1);
+  rb_define_singleton_method(cgsl_vector_lazy, "indgen", rb_gsl_lazy_indgen, -1);
+  rb_define_method(cgsl_vector_lazy, "[]", rb_gsl_lazy_get, 1);
+  rb_define_method(cgsl_vector_lazy, "each_chunk", rb_gsl_lazy_each_chunk, -1);
+  rb_define_method(cgsl_vector_lazy, "sum", rb_gsl_lazy_sum, 0);
+  rb_define_method(cgsl_vector_lazy, "min", rb_gsl_lazy_min, 0);
+  rb_define_method(cgsl_vector_lazy, "max", rb_gsl_lazy_max, 0);
+}
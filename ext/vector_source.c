@@ -444,6 +444,7 @@ static VALUE FUNCTION(rb_gsl_vector,set)(int argc, VALUE *argv, VALUE obj)
     rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-4)", argc);
   }
 
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   other = argv[argc-1];
 
@@ -472,6 +473,7 @@ static VALUE FUNCTION(rb_gsl_vector,set_all)(VALUE obj, VALUE xx)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   BASE xnative = NUMCONV2(xx);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   FUNCTION(gsl_vector,set_all)(v, xnative);
   return obj;
@@ -480,6 +482,7 @@ static VALUE FUNCTION(rb_gsl_vector,set_all)(VALUE obj, VALUE xx)
 VALUE FUNCTION(rb_gsl_vector,do_something)(VALUE obj, void (*func)(GSL_TYPE(gsl_vector)*))
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   (*func)(v);
   return obj;
@@ -494,6 +497,7 @@ static VALUE FUNCTION(rb_gsl_vector,set_basis)(VALUE obj, VALUE ii)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   CHECK_FIXNUM(ii);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   FUNCTION(gsl_vector,set_basis)(v, (size_t) FIX2INT(ii));
   return obj;
@@ -556,6 +560,7 @@ static VALUE FUNCTION(rb_gsl_vector,to_a)(VALUE obj)
 static VALUE FUNCTION(rb_gsl_vector,reverse_bang)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   FUNCTION(gsl_vector,reverse)(v);
   return obj;
@@ -572,26 +577,49 @@ static VALUE FUNCTION(rb_gsl_vector,reverse)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_vector), 0, FUNCTION(gsl_vector,free), vnew);
 }
 
+/* double vectors go through the blocked, possibly threaded reduction
+   of reduce.c */
+static void FUNCTION(mygsl_vector,minmax_all)(const GSL_TYPE(gsl_vector) *v,
+					       BASE *min, BASE *max,
+					       size_t *imin, size_t *imax)
+{
+#ifdef BASE_DOUBLE
+  if (v->size > 0) {
+    mygsl_reduce_minmax(v->data, v->stride, v->size, min, max, imin, imax);
+    return;
+  }
+#endif
+  FUNCTION(gsl_vector,minmax)(v, min, max);
+  FUNCTION(gsl_vector,minmax_index)(v, imin, imax);
+}
+
 static VALUE FUNCTION(rb_gsl_vector,max)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  BASE min, max;
+  size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  return C_TO_VALUE2(FUNCTION(gsl_vector,max)(v));
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
+  return C_TO_VALUE2(max);
 }
 
 static VALUE FUNCTION(rb_gsl_vector,min)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  BASE min, max;
+  size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  return C_TO_VALUE2(FUNCTION(gsl_vector,min)(v));
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
+  return C_TO_VALUE2(min);
 }
 
 static VALUE FUNCTION(rb_gsl_vector,minmax)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   BASE min, max;
+  size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  FUNCTION(gsl_vector,minmax)(v, &min, &max);
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
   return rb_ary_new3(2, C_TO_VALUE2(min), C_TO_VALUE2(max));
 }
 
@@ -599,40 +627,49 @@ static VALUE FUNCTION(rb_gsl_vector,maxmin)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   BASE min, max;
+  size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  FUNCTION(gsl_vector,minmax)(v, &min, &max);
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
   return rb_ary_new3(2, C_TO_VALUE2(max), C_TO_VALUE2(min));
 }
 
 static VALUE FUNCTION(rb_gsl_vector,max_index)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  BASE min, max;
+  size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  return INT2FIX(FUNCTION(gsl_vector,max_index)(v));
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
+  return INT2FIX(imax);
 }
 
 static VALUE FUNCTION(rb_gsl_vector,min_index)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  BASE min, max;
+  size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  return INT2FIX(FUNCTION(gsl_vector,min_index)(v));
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
+  return INT2FIX(imin);
 }
 
 static VALUE FUNCTION(rb_gsl_vector,minmax_index)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  BASE min, max;
   size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  FUNCTION(gsl_vector,minmax_index)(v, &imin, &imax);
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
   return rb_ary_new3(2, INT2FIX(imin), INT2FIX(imax));
 }
 
 static VALUE FUNCTION(rb_gsl_vector,maxmin_index)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
+  BASE min, max;
   size_t imin, imax;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
-  FUNCTION(gsl_vector,minmax_index)(v, &imin, &imax);
+  FUNCTION(mygsl_vector,minmax_all)(v, &min, &max, &imin, &imax);
   return rb_ary_new3(2, INT2FIX(imax), INT2FIX(imin));
 }
 
@@ -692,6 +729,27 @@ static VALUE FUNCTION(rb_gsl_vector,trans_bang)(VALUE obj)
   return obj;
 }
 
+/* v.t: the same elements as a column (row) view of a row (column)
+   vector, nothing being copied; read-only views stay read-only */
+static VALUE FUNCTION(rb_gsl_vector,t)(VALUE obj)
+{
+  GSL_TYPE(gsl_vector) *v = NULL;
+  QUALIFIED_VIEW(gsl_vector,view) *vv = NULL;
+  int ro;
+  Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
+  ro = CLASS_OF(obj) == QUALIFIED_VIEW(cgsl_vector,view_ro)
+    || CLASS_OF(obj) == QUALIFIED_VIEW(cgsl_vector,col_view_ro);
+  vv = ALLOC(QUALIFIED_VIEW(gsl_vector,view));
+  vv->vector = *v;
+  vv->vector.owner = 0;
+  if (VEC_COL_P(obj))
+    return Data_Wrap_Struct(ro ? QUALIFIED_VIEW(cgsl_vector,view_ro) : QUALIFIED_VIEW(cgsl_vector,view),
+			    0, free, vv);
+  else
+    return Data_Wrap_Struct(ro ? QUALIFIED_VIEW(cgsl_vector,col_view_ro) : QUALIFIED_VIEW(cgsl_vector,col_view),
+			    0, free, vv);
+}
+
 static VALUE FUNCTION(rb_gsl_vector,uplus)(VALUE obj)
 {
   return obj;
@@ -718,9 +776,15 @@ static VALUE FUNCTION(rb_gsl_vector,sum)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   BASE sum = 0;
+#ifndef BASE_DOUBLE
   size_t i;
+#endif
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
+#ifdef BASE_DOUBLE
+  sum = mygsl_reduce(v->data, v->stride, v->size, MYGSL_REDUCE_SUM, 0.0);
+#else
   for (i = 0; i < v->size; i++) sum += FUNCTION(gsl_vector,get)(v, i);
+#endif
   return C_TO_VALUE2(sum);
 }
 
@@ -744,9 +808,15 @@ static VALUE FUNCTION(rb_gsl_vector,prod)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   BASE x = 1;
+#ifndef BASE_DOUBLE
   size_t i;
+#endif
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
+#ifdef BASE_DOUBLE
+  x = mygsl_reduce(v->data, v->stride, v->size, MYGSL_REDUCE_PROD, 0.0);
+#else
   for (i = 0; i < v->size; i++) x *= FUNCTION(gsl_vector,get)(v, i);
+#endif
   return C_TO_VALUE(x);
 }
 
@@ -825,9 +895,13 @@ static VALUE FUNCTION(rb_gsl_vector,abs)(VALUE obj)
   size_t i;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   vnew = FUNCTION(gsl_vector,alloc)(v->size);
+#ifdef BASE_DOUBLE
+  mygsl_vector_unop(vnew, v, MYGSL_KERNEL_ABS);
+#else
   for (i = 0; i < v->size; i++) {
     FUNCTION(gsl_vector,set)(vnew, i, (BASE) fabs(FUNCTION(gsl_vector,get)(v, i)));
   }
+#endif
   return Data_Wrap_Struct(VEC_ROW_COL(obj), 0, FUNCTION(gsl_vector,free), vnew);  
 }
 
@@ -837,9 +911,13 @@ static VALUE FUNCTION(rb_gsl_vector,square)(VALUE obj)
   size_t i;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   vnew = FUNCTION(gsl_vector,alloc)(v->size);
+#ifdef BASE_DOUBLE
+  mygsl_vector_unop(vnew, v, MYGSL_KERNEL_SQUARE);
+#else
   for (i = 0; i < v->size; i++) {
     FUNCTION(gsl_vector,set)(vnew, i, gsl_pow_2(FUNCTION(gsl_vector,get)(v, i)));
   }
+#endif
   return Data_Wrap_Struct(VEC_ROW_COL(obj), 0, FUNCTION(gsl_vector,free), vnew);  
 }
 
@@ -849,9 +927,13 @@ static VALUE FUNCTION(rb_gsl_vector,sqrt)(VALUE obj)
   size_t i;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   vnew = FUNCTION(gsl_vector,alloc)(v->size);
+#ifdef BASE_DOUBLE
+  mygsl_vector_unop(vnew, v, MYGSL_KERNEL_SQRT);
+#else
   for (i = 0; i < v->size; i++) {
     FUNCTION(gsl_vector,set)(vnew, i, sqrt(FUNCTION(gsl_vector,get)(v, i)));
   }
+#endif
   return Data_Wrap_Struct(VEC_ROW_COL(obj), 0, FUNCTION(gsl_vector,free), vnew);  
 }
 
@@ -864,7 +946,7 @@ static VALUE FUNCTION(rb_gsl_vector,memcpy)(VALUE obj, VALUE dest, VALUE src)
   return dest;
 }
 
-static VALUE FUNCTION(rb_gsl_vector,clone)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_vector,dup)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL, *vnew = NULL;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
@@ -877,6 +959,12 @@ static VALUE FUNCTION(rb_gsl_vector,clone)(VALUE obj)
     return Data_Wrap_Struct(VEC_ROW_COL(obj), 0, FUNCTION(gsl_vector,free), vnew);
 }
 
+/* shares the data of a frozen vector, see rb_gsl_array_clone in array.c */
+static VALUE FUNCTION(rb_gsl_vector,clone)(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_array_clone(argc, argv, obj, FUNCTION(rb_gsl_vector,dup));
+}
+
 /* singleton */
 static VALUE FUNCTION(rb_gsl_vector,swap)(VALUE obj, VALUE vv, VALUE ww)
 {
@@ -891,17 +979,84 @@ static VALUE FUNCTION(rb_gsl_vector,swap_elements)(VALUE obj, VALUE i, VALUE j)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   CHECK_FIXNUM(i);  CHECK_FIXNUM(j);
+  rb_check_frozen(obj);
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   FUNCTION(gsl_vector,swap_elements)(v, FIX2INT(i), FIX2INT(j));
   return obj;
 }
 
+/* Raw element bytes in native byte order, as written by fwrite */
+static VALUE FUNCTION(rb_gsl_vector,to_binary)(VALUE obj)
+{
+  GSL_TYPE(gsl_vector) *h = NULL;
+  VALUE str;
+  BASE *p;
+  size_t i;
+  Data_Get_Struct(obj, GSL_TYPE(gsl_vector), h);
+  if (h->stride == 1) return rb_str_new((char*) h->data, h->size*sizeof(BASE));
+  str = rb_str_new(NULL, h->size*sizeof(BASE));
+  p = (BASE*) RSTRING_PTR(str);
+  for (i = 0; i < h->size; i++) p[i] = h->data[i*h->stride];
+  return str;
+}
+
+static void FUNCTION(mygsl_vector,set_binary)(GSL_TYPE(gsl_vector) *h, const char *s)
+{
+  size_t i;
+  if (h->stride == 1) {
+    memcpy(h->data, s, h->size*sizeof(BASE));
+    return;
+  }
+  for (i = 0; i < h->size; i++)
+    memcpy(h->data + i*h->stride, s + i*sizeof(BASE), sizeof(BASE));
+}
+
+/* Accepts a String or anything responding to get_string (IO::Buffer) */
+static VALUE FUNCTION(rb_gsl_vector,from_binary)(VALUE klass, VALUE str)
+{
+  GSL_TYPE(gsl_vector) *h = NULL;
+  size_t len;
+  if (TYPE(str) != T_STRING && rb_respond_to(str, rb_intern("get_string")))
+    str = rb_funcall(str, rb_intern("get_string"), 0);
+  StringValue(str);
+  len = RSTRING_LEN(str);
+  if (len == 0 || len % sizeof(BASE))
+    rb_raise(rb_eArgError, "binary length %d is not a positive multiple of %d",
+	     (int) len, (int) sizeof(BASE));
+  h = FUNCTION(gsl_vector,alloc)(len/sizeof(BASE));
+  FUNCTION(mygsl_vector,set_binary)(h, RSTRING_PTR(str));
+  return Data_Wrap_Struct(GSL_TYPE(cgsl_vector), 0, FUNCTION(gsl_vector,free), h);
+}
+
+#ifdef HAVE_RUBY_IO_BUFFER_H
+/* An IO::Buffer over the vector data itself; the buffer keeps the
+   vector alive.  Strided vectors are copied. */
+static VALUE FUNCTION(rb_gsl_vector,to_io_buffer)(VALUE obj)
+{
+  GSL_TYPE(gsl_vector) *h = NULL;
+  VALUE buf;
+  Data_Get_Struct(obj, GSL_TYPE(gsl_vector), h);
+  if (h->stride != 1)
+    return rb_funcall(rb_path2class("IO::Buffer"), rb_intern("for"), 1,
+		      FUNCTION(rb_gsl_vector,to_binary)(obj));
+  buf = rb_io_buffer_new(h->data, h->size*sizeof(BASE), RB_IO_BUFFER_EXTERNAL);
+  rb_ivar_set(buf, rb_intern("@vector"), obj);
+  return buf;
+}
+#endif
+
+/* io is a file name or an object responding to write (File, Socket,
+   StringIO...); the latter go through Ruby's own IO buffering */
 static VALUE FUNCTION(rb_gsl_vector,fwrite)(VALUE obj, VALUE io)
 {
   GSL_TYPE(gsl_vector) *h = NULL;
   FILE *f = NULL;
   int status, flag = 0;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), h);
+  if (TYPE(io) != T_STRING) {
+    rb_funcall(io, rb_intern("write"), 1, FUNCTION(rb_gsl_vector,to_binary)(obj));
+    return INT2FIX(GSL_SUCCESS);
+  }
   f = rb_gsl_open_writefile(io, &flag);
   status = FUNCTION(gsl_vector,fwrite)(f, h);
   if (flag == 1) fclose(f);
@@ -912,8 +1067,16 @@ static VALUE FUNCTION(rb_gsl_vector,fread)(VALUE obj, VALUE io)
 {
   GSL_TYPE(gsl_vector) *h = NULL;
   FILE *f = NULL;
+  VALUE str;
   int status, flag = 0;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), h);
+  if (TYPE(io) != T_STRING) {
+    str = rb_funcall(io, rb_intern("read"), 1, SIZET2NUM(h->size*sizeof(BASE)));
+    if (NIL_P(str) || (size_t) RSTRING_LEN(str) != h->size*sizeof(BASE))
+      rb_raise(rb_eIOError, "end of input before %d elements were read", (int) h->size);
+    FUNCTION(mygsl_vector,set_binary)(h, RSTRING_PTR(str));
+    return INT2FIX(GSL_SUCCESS);
+  }
   f = rb_gsl_open_readfile(io, &flag);
   status = FUNCTION(gsl_vector,fread)(f, h);
   if (flag == 1) fclose(f);
@@ -1093,8 +1256,9 @@ static VALUE FUNCTION(rb_gsl_vector,graph)(int argc, VALUE *argv, VALUE obj)
 {
 #ifdef HAVE_GNU_GRAPH
   GSL_TYPE(gsl_vector) *x = NULL, *y = NULL;
-  FILE *fp = NULL;
-  size_t i;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
+  size_t i, k, m, *idx = NULL;
   char command[1024];
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), y);
   switch (argc) {
@@ -1129,16 +1293,21 @@ static VALUE FUNCTION(rb_gsl_vector,graph)(int argc, VALUE *argv, VALUE obj)
     break;
   }
   if (y == NULL) rb_raise(rb_eRuntimeError, "ydata not given");
-  fp = popen(command, "w");
-  for (i = 0; i < y->size; i++) {
+  m = y->size;
+#ifdef BASE_DOUBLE
+  idx = rb_gsl_plot_decimate(x ? x->data : NULL, x ? x->stride : 1,
+			     y->data, y->stride, y->size, &m);
+#endif
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
+  for (k = 0; k < m; k++) {
+    i = idx ? idx[k] : k;
     if (x == NULL) 
-      fprintf(fp, "%d %e\n", (int) i, (double) FUNCTION(gsl_vector,get)(y, i));
+      rb_gsl_pipe_point(fp, (double) i, (double) FUNCTION(gsl_vector,get)(y, i));
     else
-      fprintf(fp, "%e %e\n", (double) FUNCTION(gsl_vector,get)(x, i), (double) FUNCTION(gsl_vector,get)(y, i));
+      rb_gsl_pipe_point(fp, (double) FUNCTION(gsl_vector,get)(x, i), (double) FUNCTION(gsl_vector,get)(y, i));
   }
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  if (idx) xfree(idx);
+  rb_gsl_pipe_send(pipe, command, "GNU graph");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "not implemented");
@@ -1150,7 +1319,8 @@ static VALUE FUNCTION(rb_gsl_vector,graph_step)(int argc, VALUE *argv, VALUE obj
 {
 #ifdef HAVE_GNU_GRAPH
   GSL_TYPE(gsl_vector) *x = NULL, *y = NULL;
-  FILE *fp = NULL;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
   size_t i;
   char command[1024];
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), y);
@@ -1186,28 +1356,24 @@ static VALUE FUNCTION(rb_gsl_vector,graph_step)(int argc, VALUE *argv, VALUE obj
     break;
   }
   if (y == NULL) rb_raise(rb_eRuntimeError, "ydata not given");
-  fp = popen(command, "w");
+  pipe = rb_gsl_pipe_new(rb_gsl_graph_command_binary(command), &fp);
   for (i = 0; i < y->size; i++) {
     if (x == NULL) {
-      fprintf(fp, "%d %e\n%d %e\n", (int) i, (double) FUNCTION(gsl_vector,get)(y, i),
-	      (int) (i+1), (double) FUNCTION(gsl_vector,get)(y, i));
+      rb_gsl_pipe_point(fp, (double) i, (double) FUNCTION(gsl_vector,get)(y, i));
+      rb_gsl_pipe_point(fp, (double) (i+1), (double) FUNCTION(gsl_vector,get)(y, i));
     } else {
+      rb_gsl_pipe_point(fp, (double) FUNCTION(gsl_vector,get)(x, i), 
+			(double) FUNCTION(gsl_vector,get)(y, i));
       if (i != y->size-1) 
-	fprintf(fp, "%e %e\n%e %e\n", (double) FUNCTION(gsl_vector,get)(x, i), 
-	(double) FUNCTION(gsl_vector,get)(y, i),
-	(double) FUNCTION(gsl_vector,get)(x, i+1), 
-	(double) FUNCTION(gsl_vector,get)(y, i));
+	rb_gsl_pipe_point(fp, (double) FUNCTION(gsl_vector,get)(x, i+1), 
+			  (double) FUNCTION(gsl_vector,get)(y, i));
       else
-	fprintf(fp, "%e %e\n%e %e", 
-	(double) FUNCTION(gsl_vector,get)(x, i), 
-	(double) FUNCTION(gsl_vector,get)(y, i),
-	2.0*FUNCTION(gsl_vector,get)(x, i)-FUNCTION(gsl_vector,get)(x, i-1), 
-	(double) FUNCTION(gsl_vector,get)(y, i));
+	rb_gsl_pipe_point(fp,
+	  2.0*FUNCTION(gsl_vector,get)(x, i)-FUNCTION(gsl_vector,get)(x, i-1), 
+	  (double) FUNCTION(gsl_vector,get)(y, i));
     }
   }
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  rb_gsl_pipe_send(pipe, command, "GNU graph");
   return Qtrue;
 #else
   rb_raise(rb_eNoMethodError, "not implemented");
@@ -1218,19 +1384,18 @@ static VALUE FUNCTION(rb_gsl_vector,graph_step)(int argc, VALUE *argv, VALUE obj
 static VALUE FUNCTION(rb_gsl_vector,plot)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_vector) *x = NULL, *y = NULL;
-  FILE *fp = NULL;
-  size_t i;
+  rb_gsl_pipe *fp = NULL;
+  VALUE pipe;
+  const char *opts = NULL;
+  size_t i, k, m, *idx = NULL;
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), y);
-  fp = popen("gnuplot -persist", "w");
   switch (argc) {
   case 0:
-    fprintf(fp, "plot '-'\n");
     break;
   case 1:
     if (TYPE(argv[0]) == T_STRING) {
-      fprintf(fp, "plot '-' %s\n", STR2CSTR(argv[0]));
+      opts = STR2CSTR(argv[0]);
     } else if (VEC_P(argv[0])) {
-      fprintf(fp, "plot '-'\n");
       Data_Get_Struct(argv[0], GSL_TYPE(gsl_vector), x);
     } else {
       rb_raise(rb_eTypeError, "wrong argument type %s (String or Vector expected)",
@@ -1239,7 +1404,7 @@ static VALUE FUNCTION(rb_gsl_vector,plot)(int argc, VALUE *argv, VALUE obj)
     break;
   case 2:
     if (TYPE(argv[1]) == T_STRING)
-      fprintf(fp, "plot '-' %s\n", STR2CSTR(argv[1]));
+      opts = STR2CSTR(argv[1]);
     if (VEC_P(argv[0]))
       Data_Get_Struct(argv[0], GSL_TYPE(gsl_vector), x);
     break;
@@ -1248,17 +1413,23 @@ static VALUE FUNCTION(rb_gsl_vector,plot)(int argc, VALUE *argv, VALUE obj)
     break;
   }
   if (y == NULL) rb_raise(rb_eRuntimeError, "ydata not given");
-  for (i = 0; i < y->size; i++) {
+  m = y->size;
+#ifdef BASE_DOUBLE
+  idx = rb_gsl_plot_decimate(x ? x->data : NULL, x ? x->stride : 1,
+			     y->data, y->stride, y->size, &m);
+#endif
+  pipe = rb_gsl_pipe_new(1, &fp);
+  rb_gsl_pipe_gnuplot(fp, m, 2, opts);
+  for (k = 0; k < m; k++) {
+    i = idx ? idx[k] : k;
     if (x == NULL) 
-      fprintf(fp, "%d %e\n", (int) i, (double) FUNCTION(gsl_vector,get)(y, i));
+      rb_gsl_pipe_point(fp, (double) i, (double) FUNCTION(gsl_vector,get)(y, i));
     else
-      fprintf(fp, "%e %e\n", (double) FUNCTION(gsl_vector,get)(x, i), 
+      rb_gsl_pipe_point(fp, (double) FUNCTION(gsl_vector,get)(x, i), 
 	(double) FUNCTION(gsl_vector,get)(y, i));
   }
-  fprintf(fp, "e\n");
-  fflush(fp);
-  pclose(fp);
-  fp = NULL;
+  if (idx) xfree(idx);
+  rb_gsl_pipe_send(pipe, "gnuplot -persist", "gnuplot");
   return Qtrue;
 }
 
@@ -1655,10 +1826,20 @@ static VALUE FUNCTION(rb_gsl_vector,to_m_diagonal)(VALUE obj)
   return Data_Wrap_Struct(GSL_TYPE(cgsl_matrix), 0, FUNCTION(gsl_matrix,free), m);
 }
 
-static VALUE FUNCTION(rb_gsl_vector,collect)(VALUE obj)
+/* Vector#collect(f = nil): with f, a Symbol such as :bessel_J0, a
+   String or a GSL::Function::Compiled, see rb_gsl_sf_collect() */
+static VALUE FUNCTION(rb_gsl_vector,collect)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL, *vnew;
   size_t i;
+  rb_check_arity(argc, 0, 1);
+  if (argc == 1) {
+#ifdef BASE_DOUBLE
+    return rb_gsl_sf_collect(argv[0], obj, Qnil);
+#else
+    rb_raise(rb_eNotImpError, "%s#collect(f) is not implemented", rb_class2name(CLASS_OF(obj)));
+#endif
+  }
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   vnew = FUNCTION(gsl_vector,alloc)(v->size);
   for (i = 0; i < v->size; i++) {
@@ -1668,10 +1849,18 @@ static VALUE FUNCTION(rb_gsl_vector,collect)(VALUE obj)
 }
 
 /* 2004/May/03 */
-static VALUE FUNCTION(rb_gsl_vector,collect_bang)(VALUE obj)
+static VALUE FUNCTION(rb_gsl_vector,collect_bang)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
   size_t i;
+  rb_check_arity(argc, 0, 1);
+  if (argc == 1) {
+#ifdef BASE_DOUBLE
+    return rb_gsl_sf_collect(argv[0], obj, obj);
+#else
+    rb_raise(rb_eNotImpError, "%s#collect!(f) is not implemented", rb_class2name(CLASS_OF(obj)));
+#endif
+  }
   Data_Get_Struct(obj, GSL_TYPE(gsl_vector), v);
   for (i = 0; i < v->size; i++) {
     FUNCTION(gsl_vector,set)(v, i, NUMCONV(rb_yield(C_TO_VALUE(FUNCTION(gsl_vector,get)(v, i)))));
@@ -3060,6 +3249,7 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_vector), "trans!", FUNCTION(rb_gsl_vector,trans_bang), 0);
   rb_define_alias(GSL_TYPE(cgsl_vector), "transpose!", "trans!");
   rb_define_alias(GSL_TYPE(cgsl_vector), "col!", "trans!");
+  rb_define_method(GSL_TYPE(cgsl_vector), "t", FUNCTION(rb_gsl_vector,t), 0);
 #ifdef BASE_DOUBLE
   rb_define_alias(cgsl_vector_col, "row", "trans");
   rb_define_alias(cgsl_vector_col, "row!", "trans!");
@@ -3099,9 +3289,9 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
   rb_define_singleton_method(GSL_TYPE(cgsl_vector), "memcpy", 
 			     FUNCTION(rb_gsl_vector,memcpy), 2);
   rb_define_method(GSL_TYPE(cgsl_vector), "clone", 
-		   FUNCTION(rb_gsl_vector,clone), 0);
-  rb_define_alias(GSL_TYPE(cgsl_vector), "duplicate", "clone");
-  rb_define_alias(GSL_TYPE(cgsl_vector), "dup", "clone");
+		   FUNCTION(rb_gsl_vector,clone), -1);
+  rb_define_method(GSL_TYPE(cgsl_vector), "dup", FUNCTION(rb_gsl_vector,dup), 0);
+  rb_define_alias(GSL_TYPE(cgsl_vector), "duplicate", "dup");
   rb_define_singleton_method(GSL_TYPE(cgsl_vector), "swap", 
 			     FUNCTION(rb_gsl_vector,swap), 2);
   rb_define_method(GSL_TYPE(cgsl_vector), "swap_elements", 
@@ -3111,6 +3301,16 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
 		   FUNCTION(rb_gsl_vector,fwrite), 1);
   rb_define_method(GSL_TYPE(cgsl_vector), "fread", 
 		   FUNCTION(rb_gsl_vector,fread), 1);
+  rb_define_method(GSL_TYPE(cgsl_vector), "to_binary",
+		   FUNCTION(rb_gsl_vector,to_binary), 0);
+  rb_define_singleton_method(GSL_TYPE(cgsl_vector), "from_binary",
+			     FUNCTION(rb_gsl_vector,from_binary), 1);
+#ifdef HAVE_RUBY_IO_BUFFER_H
+  rb_define_method(GSL_TYPE(cgsl_vector), "to_io_buffer",
+		   FUNCTION(rb_gsl_vector,to_io_buffer), 0);
+  rb_define_singleton_method(GSL_TYPE(cgsl_vector), "from_io_buffer",
+			     FUNCTION(rb_gsl_vector,from_binary), 1);
+#endif
   rb_define_method(GSL_TYPE(cgsl_vector), "fprintf", 
 		   FUNCTION(rb_gsl_vector,fprintf), -1);
   rb_define_method(GSL_TYPE(cgsl_vector), "printf", 
@@ -3200,9 +3400,9 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
 
   /*****/
   rb_define_method(GSL_TYPE(cgsl_vector), "collect", 
-		   FUNCTION(rb_gsl_vector,collect), 0);
+		   FUNCTION(rb_gsl_vector,collect), -1);
   rb_define_method(GSL_TYPE(cgsl_vector), "collect!", 
-		   FUNCTION(rb_gsl_vector,collect_bang), 0);
+		   FUNCTION(rb_gsl_vector,collect_bang), -1);
   rb_define_alias(GSL_TYPE(cgsl_vector), "map", "collect");
   rb_define_alias(GSL_TYPE(cgsl_vector), "map!", "collect!");
 
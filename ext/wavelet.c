@@ -174,6 +174,105 @@ static VALUE rb_gsl_wavelet_workspace_new(VALUE klass, VALUE nn)
   return Data_Wrap_Struct(klass, 0, gsl_wavelet_workspace_free, wspace);
 }
 
+/* Per-thread cache of the workspaces allocated by the transform methods
+   when none is given, keyed by length and evicted least-recently-used
+   first, as for the FFT. */
+#define WAVELET_CACHE_MAX 32
+#define WAVELET_CACHE_DEFAULT 8
+
+struct wavelet_cache_entry {
+  size_t n;
+  gsl_wavelet_workspace *work;
+  unsigned long used;
+};
+
+struct wavelet_cache {
+  size_t len;
+  unsigned long clock, hits, misses;
+  struct wavelet_cache_entry e[WAVELET_CACHE_MAX];
+};
+
+static RB_GSL_THREAD_LOCAL struct wavelet_cache wavelet_cache;
+static size_t wavelet_cache_capacity = WAVELET_CACHE_DEFAULT;
+
+static void wavelet_cache_shrink(struct wavelet_cache *c, size_t max)
+{
+  size_t i, lru;
+  while (c->len > max) {
+    lru = 0;
+    for (i = 1; i < c->len; i++)
+      if (c->e[i].used < c->e[lru].used) lru = i;
+    gsl_wavelet_workspace_free(c->e[lru].work);
+    c->e[lru] = c->e[--c->len];
+  }
+}
+
+/* Returns a workspace of length n.  *owned is set to 1 when the cache is
+   disabled, in which case the caller must free the workspace itself. */
+static gsl_wavelet_workspace* wavelet_cache_get(size_t n, int *owned)
+{
+  struct wavelet_cache *c = &wavelet_cache;
+  struct wavelet_cache_entry *e;
+  gsl_wavelet_workspace *work;
+  size_t i;
+
+  *owned = 0;
+  for (i = 0; i < c->len; i++) {
+    e = &c->e[i];
+    if (e->n == n) {
+      e->used = ++c->clock;
+      c->hits++;
+      return e->work;
+    }
+  }
+  c->misses++;
+  work = gsl_wavelet_workspace_alloc(n);
+  if (work == NULL) rb_raise(rb_eNoMemError, "gsl_wavelet_workspace_alloc failed");
+  if (wavelet_cache_capacity == 0) {
+    *owned = 1;
+    return work;
+  }
+  wavelet_cache_shrink(c, wavelet_cache_capacity - 1);
+  e = &c->e[c->len++];
+  e->n = n;
+  e->work = work;
+  e->used = ++c->clock;
+  return work;
+}
+
+static VALUE rb_gsl_wavelet_cache_stats(VALUE klass)
+{
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("hits")), ULONG2NUM(wavelet_cache.hits));
+  rb_hash_aset(hash, ID2SYM(rb_intern("misses")), ULONG2NUM(wavelet_cache.misses));
+  rb_hash_aset(hash, ID2SYM(rb_intern("size")), SIZET2NUM(wavelet_cache.len));
+  rb_hash_aset(hash, ID2SYM(rb_intern("capacity")), SIZET2NUM(wavelet_cache_capacity));
+  return hash;
+}
+
+static VALUE rb_gsl_wavelet_cache_clear(VALUE klass)
+{
+  wavelet_cache_shrink(&wavelet_cache, 0);
+  wavelet_cache.hits = 0;
+  wavelet_cache.misses = 0;
+  return klass;
+}
+
+static VALUE rb_gsl_wavelet_cache_capacity(VALUE klass)
+{
+  return SIZET2NUM(wavelet_cache_capacity);
+}
+
+static VALUE rb_gsl_wavelet_set_cache_capacity(VALUE klass, VALUE val)
+{
+  long n = NUM2LONG(val);
+  if (n < 0) rb_raise(rb_eArgError, "cache capacity must be non-negative");
+  if (n > WAVELET_CACHE_MAX) n = WAVELET_CACHE_MAX;
+  wavelet_cache_capacity = (size_t) n;
+  wavelet_cache_shrink(&wavelet_cache, wavelet_cache_capacity);
+  return val;
+}
+
 static VALUE rb_gsl_wavelet2d_trans(int argc, VALUE *argv, VALUE obj,
 				    int (*trans)(const gsl_wavelet *, 
 						 gsl_matrix *,
@@ -296,8 +395,7 @@ static VALUE rb_gsl_wavelet_transform0(int argc, VALUE *argv, VALUE obj,
   case 1:
     if (TYPE(argv[itmp]) == T_FIXNUM) {
       dir = FIX2INT(argv[itmp]);
-      work = gsl_wavelet_workspace_alloc(v->size);
-      flag = 1;
+      work = wavelet_cache_get(n, &flag);
     } else if (rb_obj_is_kind_of(argv[itmp], cgsl_wavelet_workspace)) {
       Data_Get_Struct(argv[itmp], gsl_wavelet_workspace, work);
     } else {
@@ -305,8 +403,7 @@ static VALUE rb_gsl_wavelet_transform0(int argc, VALUE *argv, VALUE obj,
     }
     break;
   case 0:
-    work = gsl_wavelet_workspace_alloc(v->size);
-    flag = 1;
+    work = wavelet_cache_get(n, &flag);
     break;
   default:
     rb_raise(rb_eArgError, "too many arguments");
@@ -464,8 +561,7 @@ static VALUE rb_gsl_wavelet_trans(int argc, VALUE *argv, VALUE obj,
     Data_Get_Struct(argv[itmp], gsl_wavelet_workspace, work);
     break;
   case 0:
-    work = gsl_wavelet_workspace_alloc(v->size);
-    flag = 1;
+    work = wavelet_cache_get(n, &flag);
     break;
   default:
     rb_raise(rb_eArgError, "too many arguments");
@@ -575,8 +671,7 @@ static VALUE rb_gsl_wavelet2d(int argc, VALUE *argv, VALUE obj,
   case 1:
     if (TYPE(argv[itmp]) == T_FIXNUM) {
       dir = FIX2INT(argv[itmp]);
-      work = gsl_wavelet_workspace_alloc(m->size1);
-      flag = 1;
+      work = wavelet_cache_get(m->size1, &flag);
     } else if (rb_obj_is_kind_of(argv[itmp], cgsl_wavelet_workspace)) {
       Data_Get_Struct(argv[itmp], gsl_wavelet_workspace, work);
     } else {
@@ -584,8 +679,7 @@ static VALUE rb_gsl_wavelet2d(int argc, VALUE *argv, VALUE obj,
     }
     break;
   case 0:
-    work = gsl_wavelet_workspace_alloc(m->size1);
-    flag = 1;
+    work = wavelet_cache_get(m->size1, &flag);
     break;
   default:
     rb_raise(rb_eArgError, "too many arguments");
@@ -662,8 +756,7 @@ static VALUE rb_gsl_wavelet2d_trans(int argc, VALUE *argv, VALUE obj,
     Data_Get_Struct(argv[itmp], gsl_wavelet_workspace, work);
     break;
   case 0:
-    work = gsl_wavelet_workspace_alloc(m->size1);
-    flag = 1;
+    work = wavelet_cache_get(m->size1, &flag);
     break;
   default:
     rb_raise(rb_eArgError, "too many arguments");
@@ -750,6 +843,348 @@ static VALUE rb_gsl_wavelet2d_nstransform_matrix_inverse2(int argc, VALUE *argv,
 				RB_GSL_DWT_INPLACE);
 }
 
+
+/*
+  Batched 1-D transforms: w.transform_rows(m[, dir]) transforms every
+  row of the matrix m, w.transform_columns(m[, dir]) every column, so
+  the side transformed only needs a length of a power of 2.  The rows
+  (columns) are split over GSL.parallel_threads threads from
+  GSL.parallel_threshold elements of work on, with one workspace per
+  thread, and the GVL released.  The ! forms work in place.
+*/
+struct wavelet_batch {
+  const gsl_wavelet *w;
+  double *data;
+  size_t count, n;              /* count transforms of length n */
+  size_t step, stride;          /* transform i at data + i*step, elements stride apart */
+  gsl_wavelet_direction dir;
+  gsl_wavelet_workspace **work;
+  size_t nthreads;
+};
+
+static void wavelet_batch_range(struct wavelet_batch *b, size_t i0, size_t i1,
+				gsl_wavelet_workspace *work)
+{
+  size_t i;
+  for (i = i0; i < i1; i++)
+    gsl_wavelet_transform(b->w, b->data + i*b->step, b->stride, b->n, b->dir, work);
+}
+
+static int wavelet_batch_worker(void *data, size_t id)
+{
+  struct wavelet_batch *b = (struct wavelet_batch *) data;
+  size_t chunk = (b->count + b->nthreads - 1)/b->nthreads;
+  wavelet_batch_range(b, GSL_MIN(id*chunk, b->count), GSL_MIN((id + 1)*chunk, b->count),
+		      b->work[id]);
+  return GSL_SUCCESS;
+}
+
+static int wavelet_batch_serial(void *data)
+{
+  struct wavelet_batch *b = (struct wavelet_batch *) data;
+  wavelet_batch_range(b, 0, b->count, b->work[0]);
+  return GSL_SUCCESS;
+}
+
+static VALUE rb_gsl_wavelet_transform_batch(int argc, VALUE *argv, VALUE obj,
+					    int columns, int sss)
+{
+  struct wavelet_batch b;
+  gsl_wavelet *w = NULL;
+  gsl_matrix *m = NULL, *mnew;
+  VALUE ary, vwork;
+  size_t work, k;
+  int owned;
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  Data_Get_Struct(obj, gsl_wavelet, w);
+  CHECK_MATRIX(argv[0]);
+  Data_Get_Struct(argv[0], gsl_matrix, m);
+  b.dir = gsl_wavelet_forward;
+  if (argc == 2) {
+    CHECK_FIXNUM(argv[1]);
+    b.dir = FIX2INT(argv[1]);
+  }
+  b.count = columns ? m->size2 : m->size1;
+  b.n = columns ? m->size1 : m->size2;
+  if (b.n == 0 || (b.n & (b.n - 1)) != 0)
+    rb_raise(rb_eArgError, "%s of length %d (a power of 2 expected)",
+	     columns ? "columns" : "rows", (int) b.n);
+  if (sss == RB_GSL_DWT_COPY) {
+    mnew = make_matrix_clone(m);
+    ary = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, mnew);
+  } else {
+    mnew = m;
+    ary = argv[0];
+  }
+  b.w = w;
+  b.data = mnew->data;
+  b.step = columns ? 1 : mnew->tda;
+  b.stride = columns ? mnew->tda : 1;
+  work = b.count*b.n*w->nc;
+  b.nthreads = rb_gsl_parallel_nthreads(work, b.count);
+  if (b.nthreads < 1) b.nthreads = 1;
+  b.work = ALLOCV_N(gsl_wavelet_workspace*, vwork, b.nthreads);
+  b.work[0] = wavelet_cache_get(b.n, &owned);
+  for (k = 1; k < b.nthreads; k++) b.work[k] = gsl_wavelet_workspace_alloc(b.n);
+  if (b.nthreads > 1) rb_gsl_nogvl_parallel(wavelet_batch_worker, &b, b.nthreads);
+  else rb_gsl_nogvl_call(wavelet_batch_serial, &b, work);
+  for (k = 1; k < b.nthreads; k++) gsl_wavelet_workspace_free(b.work[k]);
+  if (owned) gsl_wavelet_workspace_free(b.work[0]);
+  ALLOCV_END(vwork);
+  return ary;
+}
+
+static VALUE rb_gsl_wavelet_transform_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_wavelet_transform_batch(argc, argv, obj, 0, RB_GSL_DWT_COPY);
+}
+
+static VALUE rb_gsl_wavelet_transform_rows2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_wavelet_transform_batch(argc, argv, obj, 0, RB_GSL_DWT_INPLACE);
+}
+
+static VALUE rb_gsl_wavelet_transform_columns(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_wavelet_transform_batch(argc, argv, obj, 1, RB_GSL_DWT_COPY);
+}
+
+static VALUE rb_gsl_wavelet_transform_columns2(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_wavelet_transform_batch(argc, argv, obj, 1, RB_GSL_DWT_INPLACE);
+}
+
+/*
+  GSL::Wavelet::Stream: multi-level decomposition of an unbounded signal.
+
+    s = GSL::Wavelet::Stream.alloc(w, levels)
+    d1, d2, ..., aL = s.push(block)      # blocks of any size
+    d1, d2, ..., aL = s.flush            # the tails; s starts over
+
+  Each level filters its input with the analysis filters h1 and g1 of
+  the wavelet w and decimates by two, exactly as one step of
+  gsl_wavelet_transform does, the approximations feeding the next
+  level.  The signal is zero before its first sample, so away from the
+  wrap-around of the periodic transform the coefficients are those of
+  w.transform_forward on the whole signal.  push returns the details of
+  levels 1 ... L and the approximations of level L produced by the
+  block (nil for a level with none yet).  A level keeps only the last
+  nc samples (nc the filter length): the memory does not grow with the
+  signal, and a coefficient is out as soon as its last sample is in.
+*/
+#define WSTREAM_LEVELS_MAX 64
+
+typedef struct {
+  VALUE vw;                     /* the GSL::Wavelet */
+  const gsl_wavelet *w;
+  size_t levels;
+  double *ring;                 /* levels x nc, the last nc inputs of each level */
+  size_t *u;                    /* inputs of each level so far, the leading zeros included */
+  size_t count;
+} rb_gsl_wavelet_stream;
+
+static VALUE cgsl_wavelet_stream;
+
+static void rb_gsl_wavelet_stream_mark(rb_gsl_wavelet_stream *s)
+{
+  rb_gc_mark(s->vw);
+}
+
+static void rb_gsl_wavelet_stream_free(rb_gsl_wavelet_stream *s)
+{
+  xfree(s->ring);
+  xfree(s->u);
+  xfree(s);
+}
+
+static void wstream_reset(rb_gsl_wavelet_stream *s)
+{
+  size_t j;
+  memset(s->ring, 0, sizeof(double)*s->levels*s->w->nc);
+  for (j = 0; j < s->levels; j++) s->u[j] = s->w->offset;
+  s->count = 0;
+}
+
+static VALUE rb_gsl_wavelet_stream_new(VALUE klass, VALUE ww, VALUE lv)
+{
+  rb_gsl_wavelet_stream *s;
+  gsl_wavelet *w;
+  long levels;
+  VALUE obj;
+  CHECK_WAVELET(ww);
+  Data_Get_Struct(ww, gsl_wavelet, w);
+  levels = NUM2LONG(lv);
+  if (levels < 1 || levels > WSTREAM_LEVELS_MAX)
+    rb_raise(rb_eArgError, "%ld levels (1 to %d expected)", levels, WSTREAM_LEVELS_MAX);
+  obj = Data_Make_Struct(klass, rb_gsl_wavelet_stream, rb_gsl_wavelet_stream_mark,
+			 rb_gsl_wavelet_stream_free, s);
+  s->vw = ww;
+  s->w = w;
+  s->levels = (size_t) levels;
+  s->ring = ALLOC_N(double, s->levels*w->nc);
+  s->u = ALLOC_N(size_t, s->levels);
+  wstream_reset(s);
+  return obj;
+}
+
+/* Feeds the n samples x (x == NULL for zeros) to level j; the
+   coefficients completed go to a and d, their number is returned */
+static size_t wstream_level(rb_gsl_wavelet_stream *s, size_t j, const double *x,
+			    size_t stride, size_t n, double *a, double *d)
+{
+  const gsl_wavelet *w = s->w;
+  double *ring = s->ring + j*w->nc;
+  size_t nc = w->nc, u = s->u[j], i, k, m = 0, r;
+  double h, g;
+  for (i = 0; i < n; i++) {
+    ring[u % nc] = x ? x[i*stride] : 0.0;
+    u++;
+    if (u < nc || ((u - nc) & 1)) continue;
+    h = 0.0;
+    g = 0.0;
+    r = (u - nc) % nc;
+    for (k = 0; k < nc; k++) {
+      h += w->h1[k]*ring[r];
+      g += w->g1[k]*ring[r];
+      if (++r == nc) r = 0;
+    }
+    a[m] = h;
+    d[m++] = g;
+  }
+  s->u[j] = u;
+  return m;
+}
+
+/* The number of zeros which complete the last coefficient of level j
+   touching one of its inputs up to uend */
+static size_t wstream_tail(const rb_gsl_wavelet_stream *s, size_t j, size_t uend)
+{
+  size_t last;
+  if (uend <= s->w->offset) return 0;
+  last = (uend - 1) & ~((size_t) 1);
+  return last + s->w->nc > s->u[j] ? last + s->w->nc - s->u[j] : 0;
+}
+
+struct wstream_run {
+  rb_gsl_wavelet_stream *s;
+  const double *x;
+  size_t stride, n;
+  int flush;
+  double *a[WSTREAM_LEVELS_MAX], *d[WSTREAM_LEVELS_MAX];   /* per level, approximations and details */
+  size_t m[WSTREAM_LEVELS_MAX];                            /* per level, their number */
+};
+
+static int wstream_run(void *data)
+{
+  struct wstream_run *r = (struct wstream_run *) data;
+  rb_gsl_wavelet_stream *s = r->s;
+  const double *x = r->x;
+  size_t j, n = r->n, stride = r->stride, uend, k;
+  for (j = 0; j < s->levels; j++) {
+    r->m[j] = wstream_level(s, j, x, stride, n, r->a[j], r->d[j]);
+    if (r->flush) {
+      uend = s->u[j];
+      k = wstream_tail(s, j, uend);
+      r->m[j] += wstream_level(s, j, NULL, 0, k, r->a[j] + r->m[j], r->d[j] + r->m[j]);
+    }
+    x = r->a[j];
+    stride = 1;
+    n = r->m[j];
+  }
+  return GSL_SUCCESS;
+}
+
+static VALUE wstream_vector(const double *p, size_t n)
+{
+  gsl_vector *v;
+  if (n == 0) return Qnil;
+  v = gsl_vector_alloc(n);
+  memcpy(v->data, p, sizeof(double)*n);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE wstream_push(rb_gsl_wavelet_stream *s, const double *x, size_t stride,
+			  size_t n, int flush)
+{
+  struct wstream_run r;
+  double *buf, *p;
+  size_t j, len, total = 0, nc = s->w->nc;
+  VALUE vbuf, ary;
+  /* level j gets at most len inputs and completes at most len/2 + nc
+     coefficients, the flush included */
+  for (j = 0, len = n; j < s->levels; j++) {
+    len = len/2 + nc + 1;
+    total += 2*len;
+  }
+  buf = ALLOCV_N(double, vbuf, total);
+  for (j = 0, len = n, p = buf; j < s->levels; j++) {
+    len = len/2 + nc + 1;
+    r.a[j] = p;
+    r.d[j] = p + len;
+    p += 2*len;
+  }
+  r.s = s;
+  r.x = x;
+  r.stride = stride;
+  r.n = n;
+  r.flush = flush;
+  rb_gsl_nogvl_call(wstream_run, &r, n*nc);
+  s->count += n;
+  ary = rb_ary_new2(s->levels + 1);
+  for (j = 0; j < s->levels; j++) rb_ary_push(ary, wstream_vector(r.d[j], r.m[j]));
+  rb_ary_push(ary, wstream_vector(r.a[s->levels-1], r.m[s->levels-1]));
+  ALLOCV_END(vbuf);
+  if (flush) wstream_reset(s);
+  return ary;
+}
+
+static VALUE rb_gsl_wavelet_stream_push(VALUE obj, VALUE vv)
+{
+  rb_gsl_wavelet_stream *s;
+  gsl_vector *v;
+  Data_Get_Struct(obj, rb_gsl_wavelet_stream, s);
+  CHECK_VECTOR(vv);
+  Data_Get_Struct(vv, gsl_vector, v);
+  return wstream_push(s, v->data, v->stride, v->size, 0);
+}
+
+static VALUE rb_gsl_wavelet_stream_flush(VALUE obj)
+{
+  rb_gsl_wavelet_stream *s;
+  Data_Get_Struct(obj, rb_gsl_wavelet_stream, s);
+  return wstream_push(s, NULL, 0, 0, 1);
+}
+
+static VALUE rb_gsl_wavelet_stream_reset(VALUE obj)
+{
+  rb_gsl_wavelet_stream *s;
+  Data_Get_Struct(obj, rb_gsl_wavelet_stream, s);
+  wstream_reset(s);
+  return obj;
+}
+
+static VALUE rb_gsl_wavelet_stream_levels(VALUE obj)
+{
+  rb_gsl_wavelet_stream *s;
+  Data_Get_Struct(obj, rb_gsl_wavelet_stream, s);
+  return SIZET2NUM(s->levels);
+}
+
+static VALUE rb_gsl_wavelet_stream_count(VALUE obj)
+{
+  rb_gsl_wavelet_stream *s;
+  Data_Get_Struct(obj, rb_gsl_wavelet_stream, s);
+  return SIZET2NUM(s->count);
+}
+
+static VALUE rb_gsl_wavelet_stream_wavelet(VALUE obj)
+{
+  rb_gsl_wavelet_stream *s;
+  Data_Get_Struct(obj, rb_gsl_wavelet_stream, s);
+  return s->vw;
+}
+
 #endif
 
 void Init_wavelet(VALUE module)
@@ -769,6 +1204,12 @@ void Init_wavelet(VALUE module)
   rb_define_singleton_method(cgsl_wavelet_workspace, "alloc", 
 			     rb_gsl_wavelet_workspace_new, 1);
 
+  rb_define_singleton_method(cgsl_wavelet, "cache_stats", rb_gsl_wavelet_cache_stats, 0);
+  rb_define_singleton_method(cgsl_wavelet, "cache_clear", rb_gsl_wavelet_cache_clear, 0);
+  rb_define_singleton_method(cgsl_wavelet, "cache_capacity", rb_gsl_wavelet_cache_capacity, 0);
+  rb_define_singleton_method(cgsl_wavelet, "cache_capacity=",
+			     rb_gsl_wavelet_set_cache_capacity, 1);
+
   /*****/
 
   rb_define_singleton_method(cgsl_wavelet, "transform", 
@@ -813,6 +1254,20 @@ void Init_wavelet(VALUE module)
   rb_define_alias(cgsl_wavelet, "inverse!", "transform_inverse!");
   rb_define_method(cgsl_vector, "wavelet_transform_inverse!", 
 		   rb_gsl_wavelet_transform_inverse2, -1);
+  rb_define_method(cgsl_wavelet, "transform_rows", rb_gsl_wavelet_transform_rows, -1);
+  rb_define_method(cgsl_wavelet, "transform_rows!", rb_gsl_wavelet_transform_rows2, -1);
+  rb_define_method(cgsl_wavelet, "transform_columns", rb_gsl_wavelet_transform_columns, -1);
+  rb_define_method(cgsl_wavelet, "transform_columns!", rb_gsl_wavelet_transform_columns2, -1);
+
+  cgsl_wavelet_stream = rb_define_class_under(cgsl_wavelet, "Stream", cGSL_Object);
+  rb_define_singleton_method(cgsl_wavelet_stream, "alloc", rb_gsl_wavelet_stream_new, 2);
+  rb_define_method(cgsl_wavelet_stream, "push", rb_gsl_wavelet_stream_push, 1);
+  rb_define_alias(cgsl_wavelet_stream, "<<", "push");
+  rb_define_method(cgsl_wavelet_stream, "flush", rb_gsl_wavelet_stream_flush, 0);
+  rb_define_method(cgsl_wavelet_stream, "reset", rb_gsl_wavelet_stream_reset, 0);
+  rb_define_method(cgsl_wavelet_stream, "levels", rb_gsl_wavelet_stream_levels, 0);
+  rb_define_method(cgsl_wavelet_stream, "count", rb_gsl_wavelet_stream_count, 0);
+  rb_define_method(cgsl_wavelet_stream, "wavelet", rb_gsl_wavelet_stream_wavelet, 0);
   /***** 2d *****/
   rb_define_singleton_method(cgsl_wavelet, "transform_matrix", 
 			     rb_gsl_wavelet2d_transform_matrix, -1);
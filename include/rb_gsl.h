@@ -50,7 +50,14 @@
 void Init_gsl_error(VALUE module);
 void Init_gsl_math(VALUE module);
 void Init_gsl_complex(VALUE module);
+void Init_gsl_coerce(VALUE module);
+void Init_gsl_profiler(VALUE module);
+void Init_gsl_thread_pool(VALUE module);
+void Init_gsl_future(VALUE module);
 void Init_gsl_array(VALUE module);
+void Init_gsl_memory(VALUE module);
+void Init_gsl_typetag(VALUE module);
+void Init_gsl_compress(VALUE module);
 void Init_gsl_blas(VALUE module);
 void Init_gsl_sort(VALUE module);
 void Init_gsl_poly(VALUE module);
@@ -59,6 +66,10 @@ void Init_gsl_poly2(VALUE module);
 void Init_gsl_rational(VALUE module);
 void Init_gsl_sf(VALUE module);
 void Init_gsl_linalg(VALUE module);
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+void Init_gsl_spmatrix(VALUE module);
+#endif
+void Init_gsl_cqp_workspace(VALUE module);
 void Init_gsl_eigen(VALUE module);
 void Init_gsl_fft(VALUE module);
 void Init_gsl_signal(VALUE module);
@@ -74,6 +85,9 @@ void Init_gsl_stats(VALUE module);
 void Init_gsl_histogram(VALUE module);
 void Init_gsl_histogram2d(VALUE module);
 void Init_gsl_histogram3d(VALUE module);
+void Init_gsl_kde(VALUE module);
+void Init_gsl_marshal(VALUE module);
+void Init_gsl_npy(VALUE module);
 void Init_gsl_ntuple(VALUE module);
 void Init_gsl_monte(VALUE module);
 void Init_gsl_siman(VALUE module);
@@ -81,6 +95,10 @@ void Init_gsl_siman(VALUE module);
 void Init_gsl_odeiv(VALUE module);
 void Init_gsl_interp(VALUE module);
 void Init_gsl_spline(VALUE module);
+void Init_gsl_seal(VALUE module);
+#ifdef HAVE_GSL_GSL_INTERP2D_H
+void Init_gsl_interp2d(VALUE module);
+#endif
 void Init_gsl_diff(VALUE module);
 #ifdef GSL_1_4_9_LATER
 void Init_gsl_deriv(VALUE module);
@@ -108,10 +126,15 @@ void Init_gsl_nmatrix(VALUE module);
 void Init_gsl_narray(VALUE module);
 # endif
 #endif
+#ifdef HAVE_NUMO_NARRAY_H
+void Init_gsl_numo(VALUE module);
+#endif
 
 void Init_wavelet(VALUE module);
 
 void Init_gsl_graph(VALUE module);
+void Init_gsl_plot_pipe(VALUE module);
+void Init_gsl_downsample(VALUE module);
 
 #ifdef HAVE_TENSOR_TENSOR_H
 void Init_tensor_init(VALUE module);
@@ -136,6 +159,9 @@ void Init_ool(VALUE module);
 void Init_jacobi(VALUE module);
 #endif
 
+#ifdef HAVE_HDF5_H
+void Init_gsl_hdf5(VALUE module);
+#endif
 #ifdef HAVE_GSL_GSL_CQP_H
 void Init_cqp(VALUE module);
 #endif
@@ -151,6 +177,7 @@ void Init_bspline(VALUE module);
 #endif
 void Init_alf(VALUE module);
 void Init_geometry(VALUE module);
+void Init_gsl_small(VALUE module);
 
 #ifdef GSL_1_14_LATER
 #include <gsl/gsl_multiset.h>
@@ -40,6 +40,76 @@
 
 #include "rb_gsl_common.h"
 
+/* Vectors and matrices are allocated and freed through these wrappers
+   (ext/memory.c), which report the size of the data blocks to the
+   garbage collector with rb_gc_adjust_memory_usage: a GSL::Matrix of
+   100 MB then weighs 100 MB when Ruby decides to start a GC, and not
+   the size of its Ruby object only.  The names are redirected with
+   object-like macros so that gsl_vector_free passed as the free
+   function of Data_Wrap_Struct is counted too. */
+gsl_vector* rb_gsl_vector_alloc(size_t n);
+gsl_vector* rb_gsl_vector_calloc(size_t n);
+void rb_gsl_vector_free(gsl_vector *v);
+gsl_vector_int* rb_gsl_vector_int_alloc(size_t n);
+gsl_vector_int* rb_gsl_vector_int_calloc(size_t n);
+void rb_gsl_vector_int_free(gsl_vector_int *v);
+gsl_vector_complex* rb_gsl_vector_complex_alloc(size_t n);
+gsl_vector_complex* rb_gsl_vector_complex_calloc(size_t n);
+void rb_gsl_vector_complex_free(gsl_vector_complex *v);
+gsl_matrix* rb_gsl_matrix_alloc(size_t n1, size_t n2);
+gsl_matrix* rb_gsl_matrix_calloc(size_t n1, size_t n2);
+void rb_gsl_matrix_free(gsl_matrix *m);
+gsl_matrix_int* rb_gsl_matrix_int_alloc(size_t n1, size_t n2);
+gsl_matrix_int* rb_gsl_matrix_int_calloc(size_t n1, size_t n2);
+void rb_gsl_matrix_int_free(gsl_matrix_int *m);
+gsl_matrix_complex* rb_gsl_matrix_complex_alloc(size_t n1, size_t n2);
+gsl_matrix_complex* rb_gsl_matrix_complex_calloc(size_t n1, size_t n2);
+void rb_gsl_matrix_complex_free(gsl_matrix_complex *m);
+size_t rb_gsl_memory_usage(void);
+int rb_gsl_vector_owns_data(const gsl_vector *v);
+int rb_gsl_matrix_owns_data(const gsl_matrix *m);
+VALUE rb_gsl_vector_share(VALUE obj);
+VALUE rb_gsl_matrix_share(VALUE obj);
+VALUE rb_gsl_array_clone(int argc, VALUE *argv, VALUE obj, VALUE (*dup)(VALUE));
+
+/* The read-only mapping holding the data of the objects sealed
+   together by GSL.seal (seal.c), released by their free functions */
+typedef struct rb_gsl_seal_region rb_gsl_seal_region;
+void rb_gsl_seal_release(rb_gsl_seal_region *r);
+
+/* GSL::Memory.align: the boundary (16, 32 or 64 bytes) on which the
+   data of the vectors and matrices allocated through the wrappers
+   starts; kernels test their operands with RB_GSL_ALIGNED */
+EXTERN size_t rb_gsl_memory_align;
+#define RB_GSL_SIMD_ALIGN 64
+#define RB_GSL_ALIGNED(p, a) ((((size_t) (p)) & ((size_t) (a) - 1)) == 0)
+#if defined(__GNUC__)
+#define RB_GSL_ASSUME_ALIGNED(p, a) __builtin_assume_aligned(p, a)
+#else
+#define RB_GSL_ASSUME_ALIGNED(p, a) (p)
+#endif
+
+#ifndef RB_GSL_MEMORY_C
+#define gsl_vector_alloc rb_gsl_vector_alloc
+#define gsl_vector_calloc rb_gsl_vector_calloc
+#define gsl_vector_free rb_gsl_vector_free
+#define gsl_vector_int_alloc rb_gsl_vector_int_alloc
+#define gsl_vector_int_calloc rb_gsl_vector_int_calloc
+#define gsl_vector_int_free rb_gsl_vector_int_free
+#define gsl_vector_complex_alloc rb_gsl_vector_complex_alloc
+#define gsl_vector_complex_calloc rb_gsl_vector_complex_calloc
+#define gsl_vector_complex_free rb_gsl_vector_complex_free
+#define gsl_matrix_alloc rb_gsl_matrix_alloc
+#define gsl_matrix_calloc rb_gsl_matrix_calloc
+#define gsl_matrix_free rb_gsl_matrix_free
+#define gsl_matrix_int_alloc rb_gsl_matrix_int_alloc
+#define gsl_matrix_int_calloc rb_gsl_matrix_int_calloc
+#define gsl_matrix_int_free rb_gsl_matrix_int_free
+#define gsl_matrix_complex_alloc rb_gsl_matrix_complex_alloc
+#define gsl_matrix_complex_calloc rb_gsl_matrix_complex_calloc
+#define gsl_matrix_complex_free rb_gsl_matrix_complex_free
+#endif
+
 typedef gsl_permutation gsl_index;
 
 #ifdef HAVE_NARRAY_H
@@ -52,6 +122,7 @@ EXTERN VALUE cNMatrix;
 
 EXTERN VALUE cgsl_block, cgsl_block_int;
 EXTERN VALUE cgsl_block_uchar;
+EXTERN VALUE cgsl_block_bit;
 EXTERN VALUE cgsl_block_complex;
 EXTERN VALUE cgsl_vector, cgsl_vector_complex;
 EXTERN VALUE cgsl_vector_col;
@@ -68,10 +139,13 @@ EXTERN VALUE cgsl_vector_int_view_ro, cgsl_vector_int_col_view_ro;
 
 EXTERN VALUE cgsl_matrix, cgsl_matrix_complex;
 EXTERN VALUE cgsl_matrix_view_ro;
+EXTERN VALUE cgsl_matrix_lazy;
 EXTERN VALUE cgsl_matrix_complex_view_ro;
 EXTERN VALUE cgsl_matrix_view, cgsl_matrix_complex_view;
 EXTERN VALUE cgsl_matrix_int, cgsl_matrix_int_view;
 EXTERN VALUE cgsl_matrix_int_view_ro;
+EXTERN VALUE cgsl_vector_float, cgsl_vector_float_view;
+EXTERN VALUE cgsl_matrix_float, cgsl_matrix_float_view;
 EXTERN VALUE cgsl_permutation;
 EXTERN VALUE cgsl_index;
 EXTERN VALUE cgsl_function;
@@ -138,6 +212,92 @@ void gsl_matrix_mul_vector(gsl_vector *vnew,
 gsl_vector_complex* vector_to_complex(const gsl_vector *v);
 
 gsl_vector* make_vector_clone(const gsl_vector *v);
+
+/* array_kernels.c */
+enum {
+  MYGSL_KERNEL_ADD,
+  MYGSL_KERNEL_SUB,
+  MYGSL_KERNEL_MUL,
+  MYGSL_KERNEL_DIV,
+  MYGSL_KERNEL_ABS,
+  MYGSL_KERNEL_SQRT,
+  MYGSL_KERNEL_SQUARE,
+};
+int mygsl_vector_binop(gsl_vector *out, const gsl_vector *a, const gsl_vector *b,
+		       int op);
+int mygsl_vector_binop_const(gsl_vector *out, const gsl_vector *a, double c, int op);
+int mygsl_vector_unop(gsl_vector *out, const gsl_vector *a, int op);
+int mygsl_matrix_binop(gsl_matrix *out, const gsl_matrix *a, const gsl_matrix *b,
+		       int op);
+int mygsl_matrix_binop_const(gsl_matrix *out, const gsl_matrix *a, double c, int op);
+
+/* reduce.c */
+enum {
+  MYGSL_REDUCE_SUM,
+  MYGSL_REDUCE_SUMSQ,
+  MYGSL_REDUCE_ABSDEV,
+  MYGSL_REDUCE_PROD,
+  MYGSL_REDUCE_NRM2,
+  MYGSL_REDUCE_MINMAX,
+  MYGSL_REDUCE_MIN,
+  MYGSL_REDUCE_MAX,
+};
+EXTERN size_t rb_gsl_parallel_threshold;
+size_t rb_gsl_parallel_nthreads(size_t n, size_t nparts);
+double mygsl_reduce(const double *x, size_t stride, size_t n, int op, double c);
+void mygsl_reduce_minmax(const double *x, size_t stride, size_t n,
+			 double *min, double *max, size_t *imin, size_t *imax);
+typedef struct {
+  double sw, sw2;               /* sums of the weights and their squares */
+  double mean, m2, m3, m4;      /* sums of weighted powers of x - mean */
+  double min, max;
+} mygsl_moments;
+void mygsl_reduce_moments(const double *x, size_t xstride, const double *w,
+			  size_t wstride, size_t n, mygsl_moments *r);
+void mygsl_moments_merge(mygsl_moments *a, const mygsl_moments *b);
+void mygsl_reduce_axis(const gsl_matrix *m, int axis, int op, const double *c,
+		       double *r, size_t rstride, size_t *ir);
+int rb_gsl_axis_opts(int argc, VALUE *argv, VALUE *out);
+
+/* vecmath.c */
+enum {
+  MYGSL_VMATH_SIN,
+  MYGSL_VMATH_COS,
+  MYGSL_VMATH_EXP,
+  MYGSL_VMATH_LOG,
+  MYGSL_VMATH_LOG10,
+};
+EXTERN int rb_gsl_vmath_fast;
+int mygsl_vector_vmath(gsl_vector *out, const gsl_vector *x, int fn);
+int mygsl_matrix_vmath(gsl_matrix *out, const gsl_matrix *x, int fn);
+VALUE rb_gsl_vmath_eval(int argc, VALUE *argv, VALUE obj, int fn,
+			double (*func)(double));
+enum {
+  MYGSL_CMATH_ABS,
+  MYGSL_CMATH_ABS2,
+  MYGSL_CMATH_ARG,
+};
+int mygsl_vector_complex_cmath(gsl_vector *out, const gsl_vector_complex *z, int fn);
+int mygsl_matrix_complex_cmath(gsl_matrix *out, const gsl_matrix_complex *z, int fn);
+int mygsl_vector_complex_mul(gsl_vector_complex *a, const gsl_vector_complex *b);
+int mygsl_matrix_complex_mul_elements(gsl_matrix_complex *a, const gsl_matrix_complex *b);
+int mygsl_vector_complex_conjugate(gsl_vector_complex *out, const gsl_vector_complex *z);
+int mygsl_matrix_complex_conjugate(gsl_matrix_complex *out, const gsl_matrix_complex *z);
+int mygsl_vector_complex_split(gsl_vector *re, gsl_vector *im, const gsl_vector_complex *z);
+int mygsl_vector_complex_join(gsl_vector_complex *z, const gsl_vector *re, const gsl_vector *im);
+
+/* transpose.c */
+int mygsl_matrix_transpose_memcpy(gsl_matrix *dst, const gsl_matrix *src);
+int mygsl_matrix_int_transpose_memcpy(gsl_matrix_int *dst, const gsl_matrix_int *src);
+int mygsl_matrix_transpose(gsl_matrix *m);
+int mygsl_matrix_int_transpose(gsl_matrix_int *m);
+
+#ifdef HAVE_NUMO_NARRAY_H
+/* gsl_numo.c */
+int rb_gsl_numo_p(VALUE obj);
+double* rb_gsl_numo_vector_ptr(VALUE obj, size_t *stride, size_t *n);
+#endif
+
 gsl_vector_complex* make_vector_complex_clone(const gsl_vector_complex *v);
 int gsl_vector_complex_add(gsl_vector_complex *cv, const gsl_vector_complex *cv2);
 int gsl_vector_complex_sub(gsl_vector_complex *cv, const gsl_vector_complex *cv2);
@@ -151,8 +311,22 @@ gsl_vector_int_view* rb_gsl_make_vector_int_view(int *data, size_t size, size_t
 void Init_gsl_array_complex(VALUE module);
 void Init_gsl_vector(VALUE module);
 void Init_gsl_vector_complex(VALUE module);
+void Init_gsl_vector_lazy(VALUE module);
 void Init_gsl_matrix(VALUE module);
+void Init_gsl_matrix_lazy(VALUE module);
+VALUE rb_gsl_matrix_lazy_operand(VALUE x);
+VALUE rb_gsl_matrix_lazy_mul(VALUE obj, VALUE other);
+gsl_matrix* rb_gsl_matrix_op(VALUE x, CBLAS_TRANSPOSE_t *trans);
 void Init_gsl_matrix_complex(VALUE module);
+void Init_gsl_vector_float(VALUE module);
+void Init_gsl_matrix_float(VALUE module);
+VALUE rb_gsl_vector_float_wrap(gsl_vector_float *v);
+gsl_vector_float* rb_gsl_get_vector_float(VALUE obj);
+void Init_gsl_array_mask(VALUE module);
+void Init_gsl_array_mmap(VALUE module);
+void Init_gsl_array_text(VALUE module);
+void Init_gsl_reduce(VALUE module);
+void Init_gsl_vmath(VALUE module);
 void Init_gsl_matrix(VALUE module);
 void Init_gsl_permutation(VALUE module);
 void Init_gsl_combination(VALUE module);
@@ -30,6 +30,56 @@
 
 EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 
+/* Type tags of the exact classes of the core objects (typetag.c).  The
+   table is filled once by Init_gsl_typetag() with the GSL classes and
+   the common Ruby ones, and only read later: VECTOR_P() and the like
+   then probe it with the class of the object, normally one pointer
+   comparison, and fall back to rb_obj_is_kind_of() for the classes not
+   in it (subclasses defined in Ruby, singleton classes). */
+#define RB_GSL_T_KNOWN          0x001
+#define RB_GSL_T_COMPLEX        0x002
+#define RB_GSL_T_VECTOR         0x004
+#define RB_GSL_T_VECTOR_INT     0x008
+#define RB_GSL_T_VECTOR_COMPLEX 0x010
+#define RB_GSL_T_MATRIX         0x020
+#define RB_GSL_T_MATRIX_INT     0x040
+#define RB_GSL_T_MATRIX_COMPLEX 0x080
+#define RB_GSL_T_VECTOR_COL     0x100
+#define RB_GSL_T_VECTOR_INT_COL 0x200
+
+#define RB_GSL_TYPETAG_SIZE 128
+typedef struct {
+  VALUE klass;
+  unsigned int tags;
+} rb_gsl_typetag;
+EXTERN rb_gsl_typetag rb_gsl_typetags[RB_GSL_TYPETAG_SIZE];
+
+static inline size_t rb_gsl_typetag_hash(VALUE klass)
+{
+  return (size_t) (((klass >> 3)*0x9E3779B97F4A7C15ULL) >> 57) & (RB_GSL_TYPETAG_SIZE - 1);
+}
+
+/* The tags of the class of x, 0 if the class is not in the table */
+static inline unsigned int rb_gsl_typetag_of(VALUE x)
+{
+  VALUE klass;
+  size_t h;
+  if (SPECIAL_CONST_P(x)) return RB_GSL_T_KNOWN;
+  klass = RBASIC_CLASS(x);
+  for (h = rb_gsl_typetag_hash(klass); rb_gsl_typetags[h].klass;
+       h = (h + 1) & (RB_GSL_TYPETAG_SIZE - 1))
+    if (rb_gsl_typetags[h].klass == klass) return rb_gsl_typetags[h].tags;
+  return 0;
+}
+
+/* rb_obj_is_kind_of(x, klass), tag being the tag of klass */
+static inline VALUE rb_gsl_kind_of(VALUE x, unsigned int tag, VALUE klass)
+{
+  unsigned int t = rb_gsl_typetag_of(x);
+  if (t) return (t & tag) ? Qtrue : Qfalse;
+  return rb_obj_is_kind_of(x, klass);
+}
+
 #ifndef CHECK_FIXNUM
 #define CHECK_FIXNUM(x) if(!FIXNUM_P(x))rb_raise(rb_eTypeError,"Fixnum expected");
 #endif
@@ -45,7 +95,7 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 #endif
 
 #ifndef COMPLEX_P
-#define COMPLEX_P(x) (rb_obj_is_kind_of(x,cgsl_complex))
+#define COMPLEX_P(x) (rb_gsl_kind_of(x,RB_GSL_T_COMPLEX,cgsl_complex))
 #endif
 
 #ifndef CHECK_RNG
@@ -54,7 +104,7 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 #endif
 
 #ifndef CHECK_COMPLEX
-#define CHECK_COMPLEX(x) if(!rb_obj_is_kind_of(x,cgsl_complex))\
+#define CHECK_COMPLEX(x) if(!rb_gsl_kind_of(x,RB_GSL_T_COMPLEX,cgsl_complex))\
     rb_raise(rb_eTypeError, "wrong argument type (GSL::Complex expected)");
 #endif
 
@@ -109,7 +159,7 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 /*****/
 
 #ifndef VECTOR_P
-#define VECTOR_P(x) (rb_obj_is_kind_of(x,cgsl_vector))
+#define VECTOR_P(x) (rb_gsl_kind_of(x,RB_GSL_T_VECTOR,cgsl_vector))
 #endif
 
 #ifndef VECTOR_VIEW_P
@@ -125,11 +175,11 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 #endif
 
 #ifndef VECTOR_ROW_COL
-#define VECTOR_ROW_COL(x) ((rb_obj_is_kind_of(x,cgsl_vector_col)||rb_obj_is_kind_of(x,cgsl_vector_int_col))?cgsl_vector_col:cgsl_vector)
+#define VECTOR_ROW_COL(x) ((rb_gsl_kind_of(x,RB_GSL_T_VECTOR_COL,cgsl_vector_col)||rb_gsl_kind_of(x,RB_GSL_T_VECTOR_INT_COL,cgsl_vector_int_col))?cgsl_vector_col:cgsl_vector)
 #endif
 
 #ifndef CHECK_VECTOR
-#define CHECK_VECTOR(x) if(!rb_obj_is_kind_of(x,cgsl_vector))\
+#define CHECK_VECTOR(x) if(!rb_gsl_kind_of(x,RB_GSL_T_VECTOR,cgsl_vector))\
     rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Vector expected)", rb_class2name(CLASS_OF(x)));
 #endif
 
@@ -151,7 +201,7 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 
 /******/
 #ifndef VECTOR_INT_P
-#define VECTOR_INT_P(x) (rb_obj_is_kind_of(x,cgsl_vector_int))
+#define VECTOR_INT_P(x) (rb_gsl_kind_of(x,RB_GSL_T_VECTOR_INT,cgsl_vector_int))
 #endif
 
 #ifndef VECTOR_INT_VIEW_P
@@ -171,13 +221,23 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 #endif
 
 #ifndef CHECK_VECTOR_INT
-#define CHECK_VECTOR_INT(x) if(!rb_obj_is_kind_of(x,cgsl_vector_int))\
+#define CHECK_VECTOR_INT(x) if(!rb_gsl_kind_of(x,RB_GSL_T_VECTOR_INT,cgsl_vector_int))\
     rb_raise(rb_eTypeError, "wrong argument type (GSL::Vector::Int expected)");
 #endif
 
+/******/
+#ifndef VECTOR_FLOAT_P
+#define VECTOR_FLOAT_P(x) (rb_obj_is_kind_of(x,cgsl_vector_float))
+#endif
+
+#ifndef CHECK_VECTOR_FLOAT
+#define CHECK_VECTOR_FLOAT(x) if(!rb_obj_is_kind_of(x,cgsl_vector_float))\
+    rb_raise(rb_eTypeError, "wrong argument type (GSL::Vector::Float expected)");
+#endif
+
 /******/
 #ifndef VECTOR_COMPLEX_P
-#define VECTOR_COMPLEX_P(x) (rb_obj_is_kind_of(x,cgsl_vector_complex))
+#define VECTOR_COMPLEX_P(x) (rb_gsl_kind_of(x,RB_GSL_T_VECTOR_COMPLEX,cgsl_vector_complex))
 #endif
 
 #ifndef VECTOR_COMPLEX_ROW_P
@@ -193,16 +253,16 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 #endif
 
 #ifndef CHECK_VECTOR_COMPLEX
-#define CHECK_VECTOR_COMPLEX(x) if(!rb_obj_is_kind_of(x,cgsl_vector_complex))\
+#define CHECK_VECTOR_COMPLEX(x) if(!rb_gsl_kind_of(x,RB_GSL_T_VECTOR_COMPLEX,cgsl_vector_complex))\
     rb_raise(rb_eTypeError, "wrong argument type (GSL::Vector::Complex expected)");
 #endif
 
 #ifndef MATRIX_P
-#define MATRIX_P(x) (rb_obj_is_kind_of(x,cgsl_matrix))
+#define MATRIX_P(x) (rb_gsl_kind_of(x,RB_GSL_T_MATRIX,cgsl_matrix))
 #endif
 
 #ifndef CHECK_MATRIX
-#define CHECK_MATRIX(x) if(!rb_obj_is_kind_of(x,cgsl_matrix))\
+#define CHECK_MATRIX(x) if(!rb_gsl_kind_of(x,RB_GSL_T_MATRIX,cgsl_matrix))\
     rb_raise(rb_eTypeError, "wrong argument type (GSL::Matrix expected)");
 #endif
 
@@ -213,20 +273,29 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 
 
 #ifndef MATRIX_INT_P
-#define MATRIX_INT_P(x) (rb_obj_is_kind_of(x,cgsl_matrix_int))
+#define MATRIX_INT_P(x) (rb_gsl_kind_of(x,RB_GSL_T_MATRIX_INT,cgsl_matrix_int))
 #endif
 
 #ifndef CHECK_MATRIX_INT
-#define CHECK_MATRIX_INT(x) if(!rb_obj_is_kind_of(x,cgsl_matrix_int))\
+#define CHECK_MATRIX_INT(x) if(!rb_gsl_kind_of(x,RB_GSL_T_MATRIX_INT,cgsl_matrix_int))\
     rb_raise(rb_eTypeError, "wrong argument type (GSL::Matrix::Int expected)");
 #endif
 
+#ifndef MATRIX_FLOAT_P
+#define MATRIX_FLOAT_P(x) (rb_obj_is_kind_of(x,cgsl_matrix_float))
+#endif
+
+#ifndef CHECK_MATRIX_FLOAT
+#define CHECK_MATRIX_FLOAT(x) if(!rb_obj_is_kind_of(x,cgsl_matrix_float))\
+    rb_raise(rb_eTypeError, "wrong argument type (GSL::Matrix::Float expected)");
+#endif
+
 #ifndef MATRIX_COMPLEX_P
-#define MATRIX_COMPLEX_P(x) (rb_obj_is_kind_of(x,cgsl_matrix_complex))
+#define MATRIX_COMPLEX_P(x) (rb_gsl_kind_of(x,RB_GSL_T_MATRIX_COMPLEX,cgsl_matrix_complex))
 #endif
 
 #ifndef CHECK_MATRIX_COMPLEX
-#define CHECK_MATRIX_COMPLEX(x) if(!rb_obj_is_kind_of(x,cgsl_matrix_complex))\
+#define CHECK_MATRIX_COMPLEX(x) if(!rb_gsl_kind_of(x,RB_GSL_T_MATRIX_COMPLEX,cgsl_matrix_complex))\
     rb_raise(rb_eTypeError, "wrong argument type (GSL::Matrix::Complex expected)");
 #endif
 
@@ -296,11 +365,42 @@ EXTERN ID rb_gsl_id_beg, rb_gsl_id_end, rb_gsl_id_excl, rb_gsl_id_to_a;
 void rb_gsl_error_handler(const char *reason, const char *file,
 				 int line, int gsl_errno);
 
+#ifndef RB_GSL_THREAD_LOCAL
+#if defined(_MSC_VER)
+#define RB_GSL_THREAD_LOCAL __declspec(thread)
+#else
+#define RB_GSL_THREAD_LOCAL __thread
+#endif
+#endif
+
+EXTERN size_t rb_gsl_nogvl_threshold;
+int rb_gsl_nogvl_call(int (*func)(void *), void *data, size_t work);
+int rb_gsl_nogvl_parallel(int (*func)(void *, size_t), void *data, size_t n);
+size_t rb_gsl_thread_pool_size(void);
+void rb_gsl_thread_pool_run(void (*task)(void *, size_t), void *data, size_t n);
+int mygsl_blas_set_num_threads(int n);
+int mygsl_blas_get_num_threads(void);
+int rb_gsl_error_take(void);
+int rb_gsl_error_defer_begin(void);
+void rb_gsl_error_defer_end(int token);
+
 FILE* rb_gsl_open_writefile(VALUE io, int *flag);
 FILE* rb_gsl_open_readfile(VALUE io, int *flag);
 
+/* compress.c */
+#define RB_GSL_CODEC_NONE 0
+#define RB_GSL_CODEC_ZSTD 1
+#define RB_GSL_CODEC_LZ4 2
+int rb_gsl_zfwrite(FILE *f, int codec, int level, size_t esize,
+		   void *const *seg, const size_t *len, size_t nseg);
+int rb_gsl_zfread(FILE *f, size_t esize, void *const *seg, const size_t *len, size_t nseg);
+int rb_gsl_compress_options(VALUE opts, int *level);
+
 VALUE rb_gsl_obj_read_only(int argc, VALUE *argv, VALUE obj);
 
+typedef VALUE (*rb_gsl_coerce_func)(VALUE obj, VALUE other);
+void rb_gsl_define_coerce(VALUE klass, rb_gsl_coerce_func fill);
+
 int str_tail_grep(const char *s0, const char *s1);
 int str_head_grep(const char *s0, const char *s1);
 
@@ -318,6 +418,21 @@ int str_head_grep(const char *s0, const char *s1);
 #endif
 
 void make_graphcommand(char *command, VALUE hash);
+
+/* Buffered, threaded data pipes to GNU graph and gnuplot (plot_pipe.c) */
+typedef struct rb_gsl_pipe rb_gsl_pipe;
+VALUE rb_gsl_pipe_new(int binary, rb_gsl_pipe **p);
+int rb_gsl_pipe_binary(const rb_gsl_pipe *p);
+void rb_gsl_pipe_printf(rb_gsl_pipe *p, const char *fmt, ...);
+void rb_gsl_pipe_record(rb_gsl_pipe *p, size_t n, const double *v);
+void rb_gsl_pipe_point(rb_gsl_pipe *p, double x, double y);
+void rb_gsl_pipe_break(rb_gsl_pipe *p);
+void rb_gsl_pipe_gnuplot(rb_gsl_pipe *p, size_t n, size_t ncols, const char *opts);
+void rb_gsl_pipe_send(VALUE pipe, const char *command, const char *errname);
+int rb_gsl_graph_command_binary(char *command);
+EXTERN size_t rb_gsl_plot_max_points;
+size_t* rb_gsl_plot_decimate(const double *x, size_t xs, const double *y, size_t ys,
+			     size_t n, size_t *m);
 int rbgsl_complex_equal(const gsl_complex *z1, const gsl_complex *z2, double eps);
 
 gsl_vector* mygsl_vector_down(gsl_vector *p);
@@ -339,6 +454,15 @@ double* get_ptr_double3(VALUE obj, size_t *size, size_t *stride, int *flag);
 gsl_complex ary2complex(VALUE obj);
 VALUE vector_eval_create(VALUE obj, double (*func)(double));
 VALUE matrix_eval_create(VALUE obj, double (*func)(double));
+VALUE vector_eval_into(VALUE obj, VALUE out, double (*func)(double));
+VALUE matrix_eval_into(VALUE obj, VALUE out, double (*func)(double));
+VALUE rb_gsl_out_arg(VALUE arg);
+VALUE rb_gsl_callback_vector(VALUE ary, long i, VALUE klass, const gsl_vector *v,
+			     gsl_vector *saved);
+void rb_gsl_callback_vector_restore(VALUE vv, const gsl_vector *saved);
+VALUE rb_gsl_callback_matrix(VALUE ary, long i, VALUE klass, const gsl_matrix *m,
+			     gsl_matrix *saved);
+void rb_gsl_callback_matrix_restore(VALUE vm, const gsl_matrix *saved);
 VALUE rb_gsl_ary_eval1(VALUE ary, double (*f)(double));
 #ifdef HAVE_NARRAY_H
 VALUE rb_gsl_nary_eval1(VALUE ary, double (*f)(double));
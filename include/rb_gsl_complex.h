@@ -21,5 +21,6 @@
 EXTERN VALUE cgsl_complex;
 VALUE rb_gsl_complex_pow(int argc, VALUE *argv, VALUE obj);
 VALUE rb_gsl_complex_pow_real(int argc, VALUE *argv, VALUE obj);
+VALUE rb_gsl_complex_to_c(gsl_complex z);
 
 #endif
@@ -59,4 +59,11 @@ EXTERN VALUE cgsl_fft_complex_wavetable, cgsl_fft_complex_workspace;
 EXTERN VALUE cgsl_fft_real_wavetable, cgsl_fft_halfcomplex_wavetable;
 EXTERN VALUE cgsl_fft_real_workspace;
 
+int rb_gsl_fft_complex_nd(double *data, size_t rank, const size_t *dims,
+			  int inverse);
+size_t rb_gsl_fft_good_size(size_t n);
+int rb_gsl_fft_real_cached(double *data, size_t n, int inverse);
+void rb_gsl_fft_convolve_same(double *x, size_t n, size_t stride, size_t dist,
+			      size_t count, const double *k, size_t nk);
+
 #endif
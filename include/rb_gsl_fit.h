@@ -22,4 +22,8 @@
 
 EXTERN VALUE mgsl_multifit;
 
+/* multifit_accumulate.c */
+void rb_gsl_multifit_accum_push(VALUE acc, const gsl_matrix *X, const gsl_vector *y,
+				const gsl_vector *w);
+
 #endif
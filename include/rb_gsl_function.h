@@ -15,13 +15,44 @@
 
 #include "ruby.h"
 #include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
 #include <gsl/gsl_integration.h>
+#include <gsl/gsl_monte.h>
 #include <gsl/gsl_math.h>
 #include "rb_gsl.h"
 
 EXTERN VALUE cgsl_function;
 EXTERN VALUE cgsl_function_fdf;
+EXTERN VALUE cgsl_function_compiled;
 extern ID RBGSL_ID_call, RBGSL_ID_arity;
 void gsl_function_mark(gsl_function *f);
 void gsl_function_free(gsl_function *f);
+void Init_gsl_function_compile(VALUE module);
+int rb_gsl_function_vectorized_p(const gsl_function *F);
+void rb_gsl_function_eval_array(gsl_function *F, const double *x, double *y, size_t n);
+VALUE rb_gsl_function_compile_multi(VALUE expr, VALUE params, size_t dim);
+void* rb_gsl_function_compiled_ptr(VALUE obj);
+double rb_gsl_function_compiled_eval_multi(void *c, const double *x);
+double rb_gsl_function_compiled_eval_params(void *c, const double *x, const double *param);
+double rb_gsl_function_compiled_eval_grad(void *c, const double *x, const double *param,
+					  double *grad);
+size_t rb_gsl_function_compiled_nparam(void *c);
+size_t rb_gsl_function_compiled_dim(void *c);
+void rb_gsl_function_compiled_get_params(void *c, double *param);
+int rb_gsl_monte_function_vectorized_p(const gsl_monte_function *F);
+void rb_gsl_monte_function_eval_array(gsl_monte_function *F, double *x, double *y, size_t n);
+
+/* Finite difference Jacobians, diff_jacobian.c */
+EXTERN VALUE cgsl_diff_jacobian;
+typedef int (*rb_gsl_fdiff_function)(const gsl_vector *x, void *data, gsl_vector *f);
+int rb_gsl_fdiff_jacobian(VALUE vfd, rb_gsl_fdiff_function f, void *data,
+			  int argc, const VALUE *argv, const gsl_vector *x,
+			  const gsl_vector *fx, gsl_matrix *J);
+#define RB_GSL_FDIFF_NATIVE 1
+#define RB_GSL_FDIFF_REENTRANT 2
+int rb_gsl_fdiff_jacobian_mt(VALUE vfd, rb_gsl_fdiff_function f, void *data, int flags,
+			     int argc, const VALUE *argv, const gsl_vector *x,
+			     const gsl_vector *fx, gsl_matrix *J);
+int rb_gsl_fdiff_threaded(VALUE vfd);
+void Init_gsl_diff_jacobian(VALUE mgsl_diff);
 #endif
@@ -23,6 +23,7 @@ EXTERN VALUE cgsl_histogram_range;
 EXTERN VALUE cgsl_histogram_bin;
 EXTERN VALUE cgsl_histogram2d;
 EXTERN VALUE cgsl_histogram2d_view;
+EXTERN VALUE cgsl_histogram3d;
 
 typedef struct {
   gsl_histogram h;
@@ -60,4 +61,42 @@ mygsl_histogram_mul (gsl_histogram * h1, const gsl_histogram * h2);
 int 
 mygsl_histogram_div (gsl_histogram * h1, const gsl_histogram * h2);
 
+/* one axis of a bulk fill: its ranges and the coordinates along it */
+typedef struct {
+  const double *range;
+  size_t n;
+  const double *x;
+  size_t stride;
+} mygsl_histogram_axis;
+
+void
+mygsl_histogram_fill_nd (double *bin, mygsl_histogram_axis *axes, size_t naxes,
+			 const double *w, size_t wstride, double weight, size_t n);
+void
+mygsl_histogram_fill_nd_serial (double *bin, mygsl_histogram_axis *axes, size_t naxes,
+				const double *w, size_t wstride, double weight, size_t n);
+void
+mygsl_histogram_fill (gsl_histogram * h, const double *x, size_t xstride,
+		      const double *w, size_t wstride, double weight, size_t n);
+const double*
+rb_gsl_histogram_fill_data (VALUE a, size_t *stride, size_t *n, VALUE *keep);
+
+/* marginal sums of a Histogram2d or Histogram3d (see histogram2d.c) */
+double*
+rb_gsl_histogram_marginals (VALUE obj, size_t n, void (*fill)(const void *, double *),
+			    const void *h, VALUE *keep);
+void
+rb_gsl_histogram_modified (VALUE obj);
+void
+rb_gsl_histogram_shared (VALUE obj);
+double
+mygsl_histogram_marginal_mean (const double *range, const double *w, size_t n);
+double
+mygsl_histogram_marginal_sigma (const double *range, const double *w, size_t n);
+const double*
+rb_gsl_histogram_fill_weights (VALUE a, double *weight, size_t *stride, size_t *n,
+			       VALUE *keep);
+size_t
+rb_gsl_histogram_fill_columns (VALUE m, mygsl_histogram_axis *ax, size_t naxes);
+
 #endif
@@ -14,4 +14,8 @@
 
 #include "gsl/gsl_integration.h"
 
+VALUE rb_gsl_integration_qag_vector_run(VALUE f, double a, double b, double epsabs,
+					double epsrel, size_t limit, VALUE opts);
+void Init_gsl_integration_vector(VALUE mgsl_integ);
+
 #endif
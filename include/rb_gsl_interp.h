@@ -30,8 +30,11 @@ typedef struct {
 typedef struct {
   gsl_spline *s;
   gsl_interp_accel *a;
+  rb_gsl_seal_region *seal;  /* holds the knots once sealed, or NULL */
 } rb_gsl_spline;
 
+rb_gsl_spline* rb_gsl_spline_ptr(VALUE obj);
+
 enum {
   GSL_INTERP_LINEAR,
   GSL_INTERP_POLYNOMIAL,
@@ -42,5 +45,15 @@ enum {
 };
 
 const gsl_interp_type* get_interp_type(VALUE t);
+size_t mygsl_interp_hunt(const double xa[], size_t last, size_t j, double x);
+void mygsl_interp_eval_bulk(const gsl_interp *p, const double xa[], const double ya[],
+			    gsl_interp_accel *a, const double *x, size_t xstride,
+			    size_t n, double *out[3], const size_t ostride[3]);
+VALUE mygsl_interp_evaluate(const gsl_interp *p, const double xa[], const double ya[],
+			    gsl_interp_accel *a, VALUE xx, int mask, VALUE *out);
+VALUE mygsl_interp_output(VALUE out, VALUE xx, size_t n1, size_t n2,
+			  double **ptr, size_t *stride, size_t *tda);
+void Init_gsl_interp_uniform(VALUE cgsl_interp);
+void Init_gsl_spline_window(VALUE cgsl_spline);
 
 #endif
@@ -14,6 +14,7 @@
 
 #include "gsl/gsl_linalg.h"
 #include "gsl/gsl_math.h"
+#include "gsl/gsl_rng.h"
 
 #ifdef HAVE_NARRAY_H
 #include "rb_gsl_with_narray.h"
@@ -22,4 +23,78 @@
 VALUE rb_gsl_linalg_complex_LU_decomp(int argc, VALUE *argv, VALUE obj);
 VALUE rb_gsl_linalg_complex_LU_decomp2(int argc, VALUE *argv, VALUE obj);
 
+/* linalg_factor.c */
+typedef int (*mygsl_solve_func)(const void *fac, const gsl_vector *b, gsl_vector *x);
+VALUE rb_gsl_linalg_solve_rhs(mygsl_solve_func solve1, const void *fac,
+			      size_t n, size_t work, VALUE vb, VALUE vx);
+int mygsl_linalg_cholesky_update(gsl_matrix *L, gsl_vector *v);
+int mygsl_linalg_cholesky_downdate(gsl_matrix *L, const gsl_vector *v,
+				   gsl_vector *work);
+
+/* linalg_lapack.c */
+#ifdef HAVE_LAPACK
+int mygsl_lapack_active(void);
+int mygsl_lapack_LU_decomp(gsl_matrix *A, gsl_permutation *p, int *signum);
+int mygsl_lapack_QR_decomp(gsl_matrix *A, gsl_vector *tau);
+int mygsl_lapack_SV_decomp(gsl_matrix *A, gsl_matrix *V, gsl_vector *S);
+int mygsl_lapack_cholesky_decomp(gsl_matrix *A);
+int mygsl_lapack_symmv(gsl_matrix *A, gsl_vector *eval, gsl_matrix *evec);
+#endif
+
+/* linalg_batch.c */
+gsl_matrix* rb_gsl_linalg_batch_systems(VALUE va, size_t *batch, size_t *n, VALUE *keep);
+
+/* linalg_iterative.c */
+/* Compressed rows with sorted column indices; diag[r] indexes A(r, r) */
+typedef struct {
+  size_t n;
+  size_t *rowptr, *col, *diag;
+  double *val;
+} mygsl_csr;
+mygsl_csr* mygsl_csr_alloc(size_t n, size_t nz);
+void mygsl_csr_free(mygsl_csr *c);
+void mygsl_csr_mul(const mygsl_csr *c, const gsl_vector *x, gsl_vector *y);
+int rb_gsl_linalg_op_arity(VALUE proc);
+void rb_gsl_linalg_op_call(VALUE proc, int arity, VALUE vin, VALUE vout,
+			   const gsl_vector *x, gsl_vector *y);
+
+/* nmf.c */
+enum {
+  MYGSL_NMF_MU,
+  MYGSL_NMF_HALS,
+  MYGSL_NMF_ALS,
+};
+typedef struct {
+  size_t m, n, k;
+  int method;
+  const gsl_matrix *V;          /* dense V, or NULL */
+  const mygsl_csr *csr;         /* or sparse V, m rows of n columns */
+  mygsl_csr *csrt;              /* V^T, owned */
+  double vsum, vnorm2;
+  gsl_matrix *W, *Ht;           /* m x k, and H^T: n x k */
+  gsl_matrix *VHt, *VtW, *WtW, *HHt, *chol;
+  double *scratch;
+  int gram;                     /* WtW is of the current W */
+  size_t iter;
+  double cost;
+} mygsl_nmf;
+mygsl_nmf* mygsl_nmf_alloc(const gsl_matrix *V, const mygsl_csr *csr, size_t n,
+			   size_t k, int method);
+void mygsl_nmf_free(mygsl_nmf *w);
+mygsl_csr* mygsl_csr_transpose(const mygsl_csr *a, size_t n);
+void mygsl_nmf_init(mygsl_nmf *w, const gsl_rng *r);
+double mygsl_nmf_iterate(mygsl_nmf *w);
+double difcost(const gsl_matrix *a, const gsl_matrix *b);
+
+#ifdef HAVE_GSL_GSL_SPMATRIX_H
+#include <gsl/gsl_spmatrix.h>
+/* spmatrix.c */
+int rb_gsl_spmatrix_p(VALUE obj);
+gsl_spmatrix* rb_gsl_get_spmatrix(VALUE obj);
+VALUE rb_gsl_spmatrix_band_rows(size_t size1, size_t size2, size_t width,
+				const size_t *start, const double *val);
+/* linalg_iterative.c */
+mygsl_csr* mygsl_csr_from_spmatrix(const gsl_spmatrix *m);
+#endif
+
 #endif
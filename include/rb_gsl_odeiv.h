@@ -18,4 +18,9 @@
 #include "rb_gsl.h"
 #include "rb_gsl_array.h"
 
+gsl_odeiv_system* rb_gsl_odeiv_get_system(VALUE obj);
+#ifdef HAVE_GSL_GSL_ODEIV2_H
+void Init_gsl_odeiv2(VALUE module);
+#endif
+
 #endif
@@ -26,6 +26,7 @@ EXTERN VALUE cgsl_poly_int;
 EXTERN VALUE cgsl_poly_dd;
 EXTERN VALUE cgsl_poly_taylor;
 EXTERN VALUE cgsl_poly_workspace;
+EXTERN VALUE cgsl_poly_complex_workspace;
 EXTERN VALUE cgsl_rational;
 
 typedef gsl_vector gsl_poly;
@@ -68,4 +69,6 @@ VALUE rb_gsl_poly_int_deconv(VALUE obj, VALUE bb);
 
 gsl_poly* get_poly_get(VALUE obj, int *flag);
 gsl_poly_int* get_poly_int_get(VALUE obj, int *flag);
+
+void Init_gsl_poly_batch(VALUE module);
 #endif
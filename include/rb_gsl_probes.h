@@ -0,0 +1,65 @@
+/*
+  rb_gsl_probes.h
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY
+*/
+
+/*
+  USDT (SystemTap/DTrace static) probes of provider rb_gsl, compiled in
+  when <sys/sdt.h> is found (ruby extconf.rb --disable-probes to leave
+  them out).  A probe is a single nop until a tracer attaches to it:
+
+    kernel__entry(char *name, size_t n1, size_t n2)
+    kernel__return(char *name, size_t n1, size_t n2, int status)
+      FFTs ("fft_complex", "fft_real", "fft_halfcomplex": n, stride;
+      "fft_batch": n, number of transforms of the Matrix and batch
+      methods) and linalg decompositions ("LU_decomp", "QR_decomp", "QRPT_decomp",
+      "SV_decomp", "SV_decomp_jacobi", "cholesky_decomp": rows, columns),
+      on the thread which runs the kernel
+    callback__entry(char *name, size_t n)
+    callback__return(char *name, size_t n)
+      calls of Ruby procs by GSL: "function" (GSL::Function, n = 1),
+      "odeiv_func", "odeiv_jac" (n = dimension), "multimin_f",
+      "multimin_df", "multimin_fdf", "multiroot_f", "multiroot_df",
+      "multiroot_fdf", "ool_f", "ool_df", "ool_Hv", "ool_hessian"
+      (n = size of x); a proc raising an exception
+      leaves without callback__return
+
+    bpftrace -e 'usdt:/path/to/gsl.so:rb_gsl:kernel__entry
+                   { @start[tid] = nsecs; }
+                 usdt:/path/to/gsl.so:rb_gsl:kernel__return /@start[tid]/
+                   { @us[str(arg0), arg1] = hist((nsecs - @start[tid])/1000);
+                     delete(@start[tid]); }'
+*/
+
+#ifndef ___RB_GSL_PROBES_H___
+#define ___RB_GSL_PROBES_H___
+
+#include "rb_gsl_config.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define RB_GSL_KERNEL_ENTRY(name, n1, n2) \
+  DTRACE_PROBE3(rb_gsl, kernel__entry, name, (size_t) (n1), (size_t) (n2))
+#define RB_GSL_KERNEL_RETURN(name, n1, n2, status) \
+  DTRACE_PROBE4(rb_gsl, kernel__return, name, (size_t) (n1), (size_t) (n2), (int) (status))
+#define RB_GSL_CALLBACK_ENTRY(name, n) \
+  DTRACE_PROBE2(rb_gsl, callback__entry, name, (size_t) (n))
+#define RB_GSL_CALLBACK_RETURN(name, n) \
+  DTRACE_PROBE2(rb_gsl, callback__return, name, (size_t) (n))
+
+#else
+
+#define RB_GSL_KERNEL_ENTRY(name, n1, n2)
+#define RB_GSL_KERNEL_RETURN(name, n1, n2, status) ((void) (status))
+#define RB_GSL_CALLBACK_ENTRY(name, n)
+#define RB_GSL_CALLBACK_RETURN(name, n)
+
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/*
+  rb_gsl_profiler.h
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY
+*/
+
+/*
+  Instrumentation of the entry points for GSL::Profiler (ext/profiler.c),
+  compiled in with "ruby extconf.rb --enable-profile":
+
+    RB_GSL_PROFILED(rb_gsl_fft_complex_forward, "GSL::Vector::Complex#forward")
+    rb_define_method(cgsl_vector_complex, "forward",
+                     RB_GSL_PROF(rb_gsl_fft_complex_forward), -1);
+
+  RB_GSL_PROFILED defines a counted wrapper of a method taking
+  (int argc, VALUE *argv, VALUE obj), which RB_GSL_PROF names;
+  RB_GSL_PROF_CALLBACK(stmt) counts stmt, a call into Ruby, as callback
+  time of the method running; RB_GSL_PROF_SECTION(entry, stmt) times
+  stmt, which may run on any thread, as an entry of its own.  Without
+  RB_GSL_PROFILE they expand to the bare function or statement.
+*/
+
+#ifndef ___RB_GSL_PROFILER_H___
+#define ___RB_GSL_PROFILER_H___
+
+#include "rb_gsl_config.h"
+#include "ruby.h"
+
+#ifdef RB_GSL_PROFILE
+
+typedef struct rb_gsl_prof_entry {
+  const char *name;
+  struct rb_gsl_prof_entry *next;
+  int listed;
+  size_t calls, callbacks, bytes;
+  size_t time, callback_time;   /* nanoseconds */
+} rb_gsl_prof_entry;
+
+VALUE rb_gsl_prof_call(rb_gsl_prof_entry *e, VALUE (*func)(int, VALUE *, VALUE),
+		       int argc, VALUE *argv, VALUE obj);
+int rb_gsl_prof_callback_begin(void);
+void rb_gsl_prof_callback_end(int token);
+size_t rb_gsl_prof_clock(void);
+void rb_gsl_prof_section(rb_gsl_prof_entry *e, size_t t0);
+void rb_gsl_prof_bytes(size_t bytes);
+
+#define RB_GSL_PROF_ENTRY(var, label) \
+  static rb_gsl_prof_entry var = { label, NULL, 0, 0, 0, 0, 0, 0 };
+
+#define RB_GSL_PROFILED(func, label) \
+  RB_GSL_PROF_ENTRY(func##_prof, label) \
+  static VALUE func##_profiled(int argc, VALUE *argv, VALUE obj) \
+  { return rb_gsl_prof_call(&func##_prof, func, argc, argv, obj); }
+
+#define RB_GSL_PROF(func) func##_profiled
+
+#define RB_GSL_PROF_CALLBACK(stmt) do { \
+    int rb_gsl_prof_token_ = rb_gsl_prof_callback_begin(); \
+    stmt; \
+    rb_gsl_prof_callback_end(rb_gsl_prof_token_); \
+  } while (0)
+
+#define RB_GSL_PROF_SECTION(var, stmt) do { \
+    size_t rb_gsl_prof_t0_ = rb_gsl_prof_clock(); \
+    stmt; \
+    rb_gsl_prof_section(&(var), rb_gsl_prof_t0_); \
+  } while (0)
+
+#define RB_GSL_PROF_BYTES(n) rb_gsl_prof_bytes(n)
+
+#else
+
+#define RB_GSL_PROF_ENTRY(var, label)
+#define RB_GSL_PROFILED(func, label)
+#define RB_GSL_PROF(func) func
+#define RB_GSL_PROF_CALLBACK(stmt) do { stmt; } while (0)
+#define RB_GSL_PROF_SECTION(var, stmt) do { stmt; } while (0)
+#define RB_GSL_PROF_BYTES(n)
+
+#endif
+
+#endif
@@ -17,5 +17,25 @@
 #include "rb_gsl.h"
 
 EXTERN VALUE cgsl_rng;
+EXTERN VALUE cgsl_rng_pool;
+
+typedef struct {
+  size_t n;
+  unsigned long seed;
+  gsl_rng **r;
+  VALUE streams;
+} rb_gsl_rng_pool;
+
+/* rng_bulk.c */
+extern const gsl_rng_type *mygsl_rng_philox4x32;
+extern const gsl_rng_type *mygsl_rng_xoshiro256ss;
+
+/* randist_sample.c */
+size_t mygsl_ran_bounded(const gsl_rng *r, size_t n);
+void mygsl_ran_choose_index(const gsl_rng *r, size_t n, size_t k, size_t *idx);
+void mygsl_ran_choose(const gsl_rng *r, gsl_vector *dest, const gsl_vector *src);
+
+unsigned long rb_gsl_rng_stream_seed(unsigned long seed, size_t i);
+size_t rb_gsl_rng_pool_get(VALUE obj, gsl_rng ***r);
 
 #endif
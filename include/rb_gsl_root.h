@@ -18,5 +18,6 @@
 #include "rb_gsl.h"
 EXTERN VALUE cgsl_fsolver;
 EXTERN VALUE cgsl_fdfsolver;
+void Init_gsl_root_batch(VALUE mgsl_root);
 
 #endif
@@ -25,6 +25,9 @@ EXTERN VALUE cgsl_sf_result, cgsl_sf_result_e10;
 VALUE rb_gsl_sf_result_new(VALUE klass);
 
 VALUE rb_gsl_sf_eval1(double (*func)(double), VALUE argv);
+VALUE rb_gsl_sf_eval1_out(double (*func)(double), VALUE x, VALUE out);
+VALUE rb_gsl_sf_eval1_argv(double (*func)(double), int argc, VALUE *argv);
+VALUE rb_gsl_sf_collect(VALUE f, VALUE x, VALUE out);
 VALUE rb_gsl_sf_eval_int_double(double (*func)(int, double), VALUE jj, VALUE argv);
 VALUE rb_gsl_sf_eval_double_double(double (*func)(double, double), VALUE ff, VALUE argv);
 VALUE rb_gsl_sf_eval1_uint(double (*func)(unsigned int), VALUE argv);
@@ -80,6 +83,24 @@ VALUE rb_gsl_sf_eval_double4_m(double (*func)(double, double, double, double,
 			       VALUE argv, VALUE x2, VALUE x3, VALUE x4, VALUE m);
 
 VALUE rb_gsl_sf_eval_complex(double (*f)(double), VALUE obj);
+VALUE rb_gsl_sf_eval_complex_e(int (*f)(double, double, gsl_sf_result*, gsl_sf_result*),
+			       int polar, int argc, VALUE *argv);
+
+/* A gsl_sf_*_array function: fill computes its nout arrays of size
+   values (and nexp exponents) at x, func and the i and d fixed */
+#define MYGSL_SF_ARRAY_MAXOUT 4
+
+typedef struct mygsl_sf_array mygsl_sf_array;
+struct mygsl_sf_array {
+  int (*fill)(const mygsl_sf_array *a, double x, double **y, double *e);
+  void (*func)(void);
+  int i0, i1;
+  double d0, d1;
+  size_t size, nout, nexp;
+  int status;                   /* the status ends the results */
+};
+
+VALUE rb_gsl_sf_array_eval(mygsl_sf_array *a, VALUE x, int argc, VALUE *out);
 
 void Init_gsl_sf_airy(VALUE module);
 void Init_gsl_sf_bessel(VALUE module);
@@ -106,6 +127,7 @@ void Init_gsl_sf_log(VALUE module);
 void Init_gsl_sf_power(VALUE module);
 void Init_gsl_sf_psi(VALUE module);
 void Init_gsl_sf_synchrotron(VALUE module);
+void Init_gsl_sf_table(VALUE module);
 void Init_gsl_sf_transport(VALUE module);
 void Init_gsl_sf_trigonometric(VALUE module);
 void Init_gsl_sf_zeta(VALUE module);
@@ -10,6 +10,12 @@ class Array
       self.length.times { |i| s << "#{self[i]}\n" }
       s
     elsif ( self[0].kind_of? GSL::Vector ) then
+      if self.size == 2 and self[1].kind_of? GSL::Vector and
+          GSL.plot_max_points > 1 and self[1].size > GSL.plot_max_points and
+          self[0].size == self[1].size and
+          (self[0].size < 2 or self[0].diff.min >= 0) then
+        return self[1].downsample_minmax(GSL.plot_max_points, self[0]).to_gplot
+      end
       tmp = self[0].zip( *self[1..-1] )
       tmp.collect { |a| a.join(" ") }.join("\n") + "\ne"
     else
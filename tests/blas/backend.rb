@@ -0,0 +1,19 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test.rb")
+include GSL::Test
+
+backend = GSL::Blas.backend
+GSL::Test::test(!%w(openblas mkl blis atlas gslcblas).include?(backend),
+                "GSL::Blas.backend (#{backend})")
+
+n = GSL::Blas.num_threads
+GSL::Test::test(n < 1, "GSL::Blas.num_threads (#{n})")
+GSL::Blas.num_threads = 1
+GSL::Test::test(GSL::Blas.num_threads != 1, "GSL::Blas.num_threads = 1")
+
+a = GSL::Matrix.alloc([1, 2, 3, 4], 2, 2)
+b = GSL::Matrix.alloc([5, 6, 7, 8], 2, 2)
+c = GSL::Blas.dgemm(GSL::Blas::NoTrans, GSL::Blas::NoTrans, 1.0, a, b)
+GSL::Test::test(c != GSL::Matrix.alloc([19, 22, 43, 50], 2, 2),
+                "dgemm on the #{backend} backend")
@@ -0,0 +1,79 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+rng = GSL::Rng.alloc
+def random_matrix(rng, m, n)
+  a = GSL::Matrix.alloc(m, n)
+  m.times { |i| n.times { |j| a[i, j] = rng.uniform - 0.5 } }
+  a
+end
+
+def max_diff(a, b)
+  (a - b).abs.max
+end
+
+[[3, 4, 5], [20, 30, 25]].each { |m, k, n|
+  batch = 7
+  as = Array.new(batch) { random_matrix(rng, m, k) }
+  bs = Array.new(batch) { random_matrix(rng, k, n) }
+  ref = Array.new(batch) { |i| as[i]*bs[i] }
+
+  cs = GSL::Blas.dgemm_batched(as, bs)
+  err = (0...batch).map { |i| max_diff(cs[i], ref[i]) }.max
+  test2(err < 1e-12, "GSL::Blas.dgemm_batched #{m}x#{k}x#{n}")
+
+  cs = GSL::Blas.dgemm_batched(as, bs[0], :alpha => 2.0)
+  err = (0...batch).map { |i| max_diff(cs[i], 2.0*(as[i]*bs[0])) }.max
+  test2(err < 1e-12, "GSL::Blas.dgemm_batched #{m}x#{k}x#{n} shared b")
+
+  c0 = GSL::Blas.dgemm_batched(as, bs)
+  cs = GSL::Blas.dgemm_batched(as.map(&:transpose), bs.map(&:transpose), c0,
+                               :trans_a => GSL::Blas::Trans, :trans_b => GSL::Blas::Trans,
+                               :beta => 1.0)
+  err = (0...batch).map { |i| max_diff(cs[i], 2.0*ref[i]) }.max
+  test2(err < 1e-12 && cs[0].object_id == c0[0].object_id,
+        "GSL::Blas.dgemm_batched #{m}x#{k}x#{n} transposed with beta")
+
+  a = GSL::Matrix.alloc(batch*m, k)
+  b = GSL::Matrix.alloc(batch*k, n)
+  batch.times { |l|
+    m.times { |i| k.times { |j| a[l*m + i, j] = as[l][i, j] } }
+    k.times { |i| n.times { |j| b[l*k + i, j] = bs[l][i, j] } }
+  }
+  c = GSL::Blas.dgemm_strided_batched(a, b)
+  err = (0...batch).map { |i| max_diff(c.submatrix(i*m, 0, m, n), ref[i]) }.max
+  test2(c.size1 == batch*m && err < 1e-12, "GSL::Blas.dgemm_strided_batched #{m}x#{k}x#{n}")
+
+  c = GSL::Blas.dgemm_strided_batched(a, bs[0], :batch => batch)
+  err = (0...batch).map { |i| max_diff(c.submatrix(i*m, 0, m, n), as[i]*bs[0]) }.max
+  test2(err < 1e-12, "GSL::Blas.dgemm_strided_batched #{m}x#{k}x#{n} shared b")
+
+  xs = Array.new(batch) { GSL::Vector.alloc(Array.new(k) { rng.uniform }) }
+  yref = Array.new(batch) { |i| GSL::Blas.dgemv(GSL::Blas::NoTrans, 1.0, as[i], xs[i]) }
+  ys = GSL::Blas.dgemv_batched(as, xs)
+  err = (0...batch).map { |i| (ys[i] - yref[i]).abs.max }.max
+  test2(err < 1e-12, "GSL::Blas.dgemv_batched #{m}x#{k}")
+
+  x = GSL::Matrix.alloc(batch, k)
+  batch.times { |i| k.times { |j| x[i, j] = xs[i][j] } }
+  y = GSL::Blas.dgemv_strided_batched(a, x)
+  err = (0...batch).map { |i| (y.row(i) - yref[i]).abs.max }.max
+  test2(y.size1 == batch && y.size2 == m && err < 1e-12,
+        "GSL::Blas.dgemv_strided_batched #{m}x#{k}")
+}
+
+begin
+  GSL::Blas.dgemm_strided_batched(GSL::Matrix.alloc(6, 2), GSL::Matrix.alloc(2, 2))
+  test2(false, "GSL::Blas.dgemm_strided_batched shared b needs :batch")
+rescue ArgumentError
+  test2(true, "GSL::Blas.dgemm_strided_batched shared b needs :batch")
+end
+
+begin
+  GSL::Blas.dgemm_batched([GSL::Matrix.alloc(2, 3)], [GSL::Matrix.alloc(2, 3)])
+  test2(false, "GSL::Blas.dgemm_batched dimension check")
+rescue ArgumentError
+  test2(true, "GSL::Blas.dgemm_batched dimension check")
+end
@@ -51,3 +51,28 @@ for order in 1..NMAX do
     test_bspline(bw)
   end
 end
+
+# design matrices over a vector of points
+bw = GSL::BSpline.alloc(4, 12)
+bw.knots_uniform(0.0, 10.0)
+x = GSL::Vector.linspace(0.0, 10.0, 57)
+d = bw.design(x)
+GSL::Test::test(d.size1 != x.size || d.size2 != bw.ncoeffs, "BSpline#design size")
+x.size.times { |i|
+  GSL::Test::test_abs((d.row(i) - bw.eval(x[i])).abs.max, 0.0, 1e-15, "BSpline#design row #{i}")
+}
+vals, start = bw.design(x, :format => :band)
+GSL::Test::test(vals.size2 != bw.order, "BSpline#design(:format => :band) width")
+x.size.times { |i|
+  bw.order.times { |j|
+    GSL::Test::test_abs(vals[i, j], d[i, start[i] + j], 0.0, "BSpline#design band (#{i}, #{j})")
+  }
+}
+d1 = bw.design(x, :nderiv => 1)
+x.size.times { |i|
+  GSL::Test::test_abs(d1.row(i).sum, 0.0, 1e-12, "BSpline#design(:nderiv => 1) row #{i} sums to 0")
+}
+if defined?(GSL::SpMatrix)
+  s = bw.design(x, :format => :sparse)
+  GSL::Test::test_abs((s.to_m - d).abs.max, 0.0, 0.0, "BSpline#design(:format => :sparse)")
+end
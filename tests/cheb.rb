@@ -110,3 +110,15 @@ while x < M_PI
 end
 
 
+
+xs = GSL::Vector.linspace(-3.0, 3.0, 101)
+y = cs.eval(xs)
+GSL::Test.test_abs(y[37], cs.eval(xs[37]), 0.0, "GSL::Cheb#eval(Vector)")
+GSL::Test.test_abs(cs.eval(xs.to_a)[60], cs.eval(xs[60]), 0.0, "GSL::Cheb#eval(Array)")
+GSL::Test.test_abs(cs.eval_n(10, xs)[5], cs.eval_n(10, xs[5]), 0.0, "GSL::Cheb#eval_n(Vector)")
+f, df = cs.eval_fdf(xs)
+GSL::Test.test_abs(f[80], y[80], 0.0, "GSL::Cheb#eval_fdf, f")
+GSL::Test.test_abs(df[80], cos(xs[80]), 1600*tol, "GSL::Cheb#eval_fdf, df")
+GSL::Test.test_abs(cs.eval_deriv(0.5), cos(0.5), 1600*tol, "GSL::Cheb#eval_deriv")
+GSL::Test.test_abs(cs.eval_integ(0.5), -(1+cos(0.5)), tol, "GSL::Cheb#eval_integ")
+GSL::Test.test(!cs.deriv.equal?(cs.deriv) || !cs.deriv.frozen?, "GSL::Cheb#deriv, cached and frozen")
@@ -121,3 +121,29 @@ for j in 0...7
   status |= (c.get(j) != j)
 end
 GSL::Test.test(status, "GSL::Combination 7 choose 7")
+
+c = GSL::Combination.calloc(6, 3)
+c.next
+seen = []
+views = []
+c.each_combination { |v| seen << [v[0], v[1], v[2]]; views << v.object_id }
+ref = (0...6).to_a.combination(3).to_a[1..-1]
+GSL::Test.test(seen == ref ? 0 : 1, "GSL::Combination#each_combination")
+GSL::Test.test(views.uniq.size == 1 && c[2] == 3 ? 0 : 1, "GSL::Combination#each_combination reused view")
+GSL::Test.test(c.each_combination.count == ref.size ? 0 : 1, "GSL::Combination#each_combination enumerator")
+
+rows = []
+more = true
+while more
+  m, more = c.batch(4)
+  m.size1.times { |i| rows << [m[i, 0], m[i, 1], m[i, 2]] }
+end
+GSL::Test.test(rows == ref ? 0 : 1, "GSL::Combination#batch")
+
+pm = GSL::Permutation.alloc(4)
+pm.init
+seen = []
+pm.each_permutation { |q| seen << q.to_a }
+GSL::Test.test(seen == (0...4).to_a.permutation.to_a ? 0 : 1, "GSL::Permutation#each_permutation")
+m, more = pm.batch(30)
+GSL::Test.test(m.size1 == 24 && !more && m[23, 0] == 3 ? 0 : 1, "GSL::Permutation#batch")
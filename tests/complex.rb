@@ -15,3 +15,58 @@ for i in 0...10
   desc = sprintf("gsl_complex_polar imag part at (r=%g,t=%g)", r, t)
   GSL::Test.test_rel(z.imag, y, 10*GSL::DBL_EPSILON, desc)
 end
+
+z = GSL::Complex.alloc(1.0, 2.0)
+z.add!(Complex(1.0, 1.0)).mul!(2).sub!([1.0, 1.0]).div!(GSL::Complex.alloc(0.0, 1.0))
+GSL::Test.test_rel(z.real, 5.0, 10*GSL::DBL_EPSILON, "gsl_complex in-place arithmetic real part")
+GSL::Test.test_rel(z.imag, -3.0, 10*GSL::DBL_EPSILON, "gsl_complex in-place arithmetic imag part")
+c = z.to_c
+GSL::Test.test_rel(c.real, 5.0, 10*GSL::DBL_EPSILON, "gsl_complex to_c real part")
+GSL::Test.test_rel(c.imaginary, -3.0, 10*GSL::DBL_EPSILON, "gsl_complex to_c imag part")
+w = z + Complex(0.0, 3.0)
+GSL::Test.test_abs(w.imag, 0.0, 10*GSL::DBL_EPSILON, "gsl_complex add Complex")
+
+v = GSL::Vector::Complex.alloc([[1.0, 2.0], Complex(3.0, 4.0), [5.0, 6.0]])
+v[1] = Complex(7.0, 8.0)
+GSL::Test.test_rel(v.get_c(1).imaginary, 8.0, 10*GSL::DBL_EPSILON, "vector_complex set Complex")
+GSL::Test.test_rel(v.get_c(-1).real, 5.0, 10*GSL::DBL_EPSILON, "vector_complex get_c")
+GSL::Test.test_rel(v.to_c_a.inject(:+).real, 13.0, 10*GSL::DBL_EPSILON, "vector_complex to_c_a")
+s = Complex(0.0, 0.0)
+v.each_c { |e| s += e }
+GSL::Test.test_rel(s.imaginary, 16.0, 10*GSL::DBL_EPSILON, "vector_complex each_c")
+
+pts = [[3.0, 4.0], [-1.0, 0.5], [0.0, 0.0], [-2.0, -0.0], [0.0, -7.0], [1e300, 1e300], [-0.3, 2.5]]
+a = GSL::Vector::Complex.alloc(pts)
+b = GSL::Vector::Complex.alloc(pts.reverse)
+m = GSL::Matrix::Complex.alloc(2, 2)
+4.times { |i| m[i/2, i%2] = GSL::Complex.alloc(*pts[i]) }
+[:libm, :fast].each do |mode|
+  GSL.vmath = mode
+  tol = ((mode == :fast) ? 4 : 2)*GSL::DBL_EPSILON
+  abs, arg = a.amp_phase
+  ab = a*b
+  pts.each_with_index do |(x, y), i|
+    GSL::Test.test_rel(abs[i], Math.hypot(x, y), tol, "vector_complex abs (#{mode}) at #{i}")
+    GSL::Test.test_rel(a.abs2[i], x*x + y*y, tol, "vector_complex abs2 (#{mode}) at #{i}")
+    GSL::Test.test_rel(arg[i], Math.atan2(y, x), tol, "vector_complex arg (#{mode}) at #{i}")
+    x2, y2 = pts[pts.size - 1 - i]
+    GSL::Test.test_rel(ab[i].real, x*x2 - y*y2, tol, "vector_complex mul real (#{mode}) at #{i}")
+    GSL::Test.test_rel(ab[i].imag, x*y2 + y*x2, tol, "vector_complex mul imag (#{mode}) at #{i}")
+  end
+  4.times do |i|
+    x, y = pts[i]
+    GSL::Test.test_rel(m.arg[i/2, i%2], Math.atan2(y, x), tol, "matrix_complex arg (#{mode}) at #{i}")
+    GSL::Test.test_rel(m.abs[i/2, i%2], Math.hypot(x, y), tol, "matrix_complex abs (#{mode}) at #{i}")
+  end
+end
+GSL.vmath = :libm
+
+c = a.conj
+re, im = a.to_planar
+pts.each_with_index do |(x, y), i|
+  GSL::Test.test_abs(c[i].imag, -y, 0.0, "vector_complex conj at #{i}")
+  GSL::Test.test_abs(re[i], x, 0.0, "vector_complex to_planar re at #{i}")
+  GSL::Test.test_abs(im[i], y, 0.0, "vector_complex to_planar im at #{i}")
+end
+GSL::Test.test_abs((GSL::Vector::Complex.alloc(re, im) - a).abs.max, 0.0, 0.0, "vector_complex alloc(re, im)")
+GSL::Test.test_abs((m.conjugate.conjugate - m).abs.max, 0.0, 0.0, "matrix_complex conjugate")
@@ -0,0 +1,49 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# minimize 1/2 |x|^2 - p^T x over the simplex: x is the projection of p,
+# x_i = max(p_i - t, 0) with sum(x) = 1
+n = 6
+p = GSL::Vector.alloc([0.9, 0.5, 0.1, -0.3, 0.6, 0.2])
+q = GSL::Matrix.identity(n)
+a = GSL::Matrix.alloc(1, n).set_all(1.0)
+b = GSL::Vector.alloc([1.0])
+c = GSL::Matrix.identity(n)
+d = GSL::Vector.calloc(n)
+
+def simplex_projection(p)
+  s = p.to_a.sort.reverse
+  t = 0.0
+  s.each_with_index { |v, k|
+    tk = (s[0..k].inject(0.0) { |sum, e| sum + e } - 1.0)/(k + 1)
+    t = tk if v - tk > 0
+  }
+  GSL::Vector.alloc(p.to_a.collect { |v| [v - t, 0.0].max })
+end
+
+ws = GSL::CQP::Workspace.alloc(n, 1, n, :eps_abs => 1e-8, :eps_rel => 1e-8)
+ws.set(q, -p, a, b, c, d)
+status = ws.solve
+test(status == GSL::SUCCESS && ws.converged? ? 0 : 1, "CQP::Workspace#solve converges")
+xt = simplex_projection(p)
+test_abs((ws.x - xt).abs.max, 0.0, 1e-6, "CQP::Workspace#x")
+test(ws.lm_ineq.min >= -1e-8 ? 0 : 1, "CQP::Workspace#lm_ineq >= 0")
+g = q*ws.x - p - a.trans*ws.lm_eq - c.trans*ws.lm_ineq
+test_abs(g.abs.max, 0.0, 1e-6, "CQP::Workspace multipliers")
+cold = ws.iter
+
+p2 = p + 0.01
+ws.update(-p2)
+ws.solve
+test_abs((ws.x - simplex_projection(p2)).abs.max, 0.0, 1e-6, "CQP::Workspace#update")
+test(ws.iter < cold ? 0 : 1, "CQP::Workspace#solve warm started")
+
+exit unless defined?(GSL::SpMatrix)
+ws.reset
+ws.set(q.to_sp, -p, a.to_sp, b, c.to_sp, d)
+ws.solve
+test_abs((ws.x - xt).abs.max, 0.0, 1e-6, "CQP::Workspace with SpMatrix")
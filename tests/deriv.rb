@@ -83,3 +83,16 @@ test_deriv("backward", f5, df5, 0.0, "x^2, x=0, backward deriv")
 test_deriv("central", f6, df6, 10.0, "1/x, x=10, central deriv")
 test_deriv("forward", f6, df6, 10.0, "1/x, x=10, forward deriv")
 test_deriv("backward", f6, df6, 10.0, "1/x, x=10, backward deriv")
+
+# A vectorized function is called once for the stencils of all the points
+n = 0
+fv = GSL::Function.vectorized { |x, y| n += 1; GSL::Sf::exp(x) }
+xv = GSL::Vector.linspace(0.5, 2.0, 1000)
+["central", "forward", "backward"].each do |deriv|
+  n = 0
+  rv, ev = fv.send("deriv_" + deriv, xv, 1e-4)
+  r1, e1 = f1.send("deriv_" + deriv, xv, 1e-4)
+  GSL::Test::test(n > 2, "exp(x), Vector, #{deriv} deriv, vectorized calls")
+  GSL::Test::test_abs((rv - r1).abs.max, 0.0, 1e-12, "exp(x), Vector, #{deriv} deriv, vectorized")
+  GSL::Test::test_abs((ev - e1).abs.max, 0.0, 1e-12, "exp(x), Vector, #{deriv} deriv, vectorized abserr")
+end
@@ -0,0 +1,36 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+N = 64
+GSL::Dht.cache_clear
+t = GSL::Dht.alloc(N, 1.0, 1.0)
+t2 = GSL::Dht.alloc(N, 1.0, 1.0)
+stats = GSL::Dht.cache_stats
+test_int(stats[:misses], 1, "GSL::Dht plan cache misses")
+test_int(stats[:hits], 1, "GSL::Dht plan cache hits")
+test2((t.Jjj - t2.Jjj).abs.max == 0.0, "GSL::Dht cached plan tables")
+t2.init(0.0, 2.0)
+t3 = GSL::Dht.alloc(N, 0.0, 2.0)
+test2((t2.J2 - t3.J2).abs.max == 0.0 && t2.xmax == 2.0, "GSL::Dht#init through the cache")
+
+[2, 7].each { |rows|
+  m = GSL::Matrix.alloc(rows, N)
+  rows.times { |i| N.times { |n| x = t.x_sample(n); m[i, n] = x*(1.0 - x*x)*(i + 1) } }
+  r = t.apply(m)
+  err = 0.0
+  rows.times { |i| err = [err, (t.apply(m.row(i)) - r.row(i)).abs.max].max }
+  test2(err < 1e-12, "GSL::Dht#apply #{rows} rows, err = #{err}")
+  t.apply(m, m)
+  test2((m - r).abs.max == 0.0, "GSL::Dht#apply #{rows} rows in place")
+}
+
+begin
+  t.apply(GSL::Matrix.alloc(3, N + 1))
+  test2(false, "GSL::Dht#apply row size check")
+rescue RangeError
+  test2(true, "GSL::Dht#apply row size check")
+end
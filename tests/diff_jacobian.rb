@@ -0,0 +1,115 @@
+#!/usr/bin/env ruby
+# Finite difference Jacobians computed in C, alone and in the solvers
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+include Math
+
+x = GSL::Vector.alloc([0.5, 2.0, -3.0])
+f = Proc.new { |x| [x[0]*x[1], sin(x[0]) + x[2]*x[2], exp(x[1])*x[2]] }
+exact = GSL::Matrix.alloc([2.0, 0.5, 0.0, cos(0.5), 0.0, -6.0,
+                           0.0, -3.0*exp(2.0), exp(2.0)], 3, 3)
+[["forward", 1e-6], ["central", 1e-9]].each do |type, tol|
+  fd = GSL::Diff::Jacobian.alloc(type.to_sym)
+  test2(fd.type == type, "Diff::Jacobian#type #{type}")
+  j = fd.jacobian(f, x)
+  test2((j - exact).abs.max < tol, "Diff::Jacobian#jacobian #{type}")
+end
+g = GSL::Diff::Jacobian.alloc.gradient(Proc.new { |x| x[0]*x[0] + 3*x[1] }, x)
+test_rel(g[0], 1.0, 1e-8, "Diff::Jacobian#gradient")
+test_rel(g[1], 3.0, 1e-8, "Diff::Jacobian#gradient")
+
+calls = 0
+batch = Proc.new { |xs|
+  calls += 1
+  Array.new(xs.size1) { |i| xs[i,0]*xs[i,0] + 3*xs[i,1] }
+}
+fd = GSL::Diff::Jacobian.alloc(:central, :batch => batch)
+g2 = fd.gradient(Proc.new { |x| x[0]*x[0] + 3*x[1] }, x)
+test2(calls == 1 && (g2 - g).abs.max < 1e-8, "Diff::Jacobian batch")
+
+# Roth's equations, Newton's method with a finite difference Jacobian
+roth_f = Proc.new { |x, f|
+  u = x[0]
+  v = x[1]
+  f[0] = -13.0 + u + ((5.0 - v)*v - 2.0)*v
+  f[1] = -29.0 + u + ((v + 1.0)*v - 14.0)*v
+}
+roth = GSL::MultiRoot::Function_fdf.alloc(roth_f, GSL::Diff::Jacobian.alloc, 2)
+s = GSL::MultiRoot::FdfSolver.alloc("hybridsj", 2)
+s.set(roth, GSL::Vector.alloc([4.5, 3.5]))
+iter = 0
+begin
+  iter += 1
+  s.iterate
+  status = GSL::MultiRoot.test_residual(s.f, 1e-10)
+end while status == GSL::CONTINUE and iter < 100
+test_rel(s.root[0], 5.0, 1e-8, "MultiRoot::Function_fdf with Diff::Jacobian")
+test_rel(s.root[1], 4.0, 1e-8, "MultiRoot::Function_fdf with Diff::Jacobian")
+
+# Minimum of a quadratic, gradient by central differences
+quad = Proc.new { |x, p| p[0]*(x[0] - 1)**2 + p[1]*(x[1] + 2)**2 }
+func = GSL::MultiMin::Function_fdf.alloc(quad, GSL::Diff::Jacobian.alloc, 2)
+func.set_params([2.0, 5.0])
+m = GSL::MultiMin::FdfMinimizer.alloc("vector_bfgs", 2)
+m.set(func, GSL::Vector.alloc([3.0, 3.0]), 0.1, 1e-4)
+iter = 0
+begin
+  iter += 1
+  m.iterate
+  status = GSL::MultiMin.test_gradient(m.gradient, 1e-6)
+end while status == GSL::CONTINUE and iter < 100
+test_abs(m.x[0], 1.0, 1e-6, "MultiMin::Function_fdf with Diff::Jacobian")
+test_abs(m.x[1], -2.0, 1e-6, "MultiMin::Function_fdf with Diff::Jacobian")
+
+# Exponential fit, Jacobian by forward differences evaluated in one batch
+t = GSL::Vector.linspace(0, 3, 20)
+y = t.collect { |ti| 2.0*exp(-1.5*ti) + 0.5 }
+expf = Proc.new { |x, t, y, f|
+  t.size.times { |i| f[i] = x[0]*exp(-x[1]*t[i]) + x[2] - y[i] }
+}
+nbatch = 0
+expb = Proc.new { |xs, t, y|
+  nbatch += 1
+  r = GSL::Matrix.alloc(xs.size1, t.size)
+  xs.size1.times { |k|
+    t.size.times { |i| r[k,i] = xs[k,0]*exp(-xs[k,1]*t[i]) + xs[k,2] - y[i] }
+  }
+  r
+}
+fit = GSL::MultiFit::Function_fdf.alloc(expf, GSL::Diff::Jacobian.alloc(:forward, :batch => expb), 3)
+fit.set_data(t, y)
+solver = GSL::MultiFit::FdfSolver.alloc(GSL::MultiFit::FdfSolver::LMSDER, t.size, 3)
+solver.set(fit, GSL::Vector.alloc([1.0, 1.0, 0.0]))
+iter = 0
+begin
+  iter += 1
+  solver.iterate
+  status = solver.test_delta(1e-10, 1e-10)
+end while status == GSL::CONTINUE and iter < 200
+test_rel(solver.position[1], 1.5, 1e-6, "MultiFit::Function_fdf with Diff::Jacobian")
+test2(nbatch > 0 && nbatch <= iter + 1, "MultiFit::Function_fdf, batched Jacobians")
+
+# The same fit with the perturbed points spread over threads: Ruby
+# threads for the proc, native ones for a compiled model
+fit_with = lambda { |f, fd|
+  fit = f.is_a?(GSL::MultiFit::Function_fdf) ? f : GSL::MultiFit::Function_fdf.alloc(f, fd, 3)
+  fit.set_data(t, y)
+  solver = GSL::MultiFit::FdfSolver.alloc(GSL::MultiFit::FdfSolver::LMSDER, t.size, 3)
+  solver.set(fit, GSL::Vector.alloc([1.0, 1.0, 0.0]))
+  iter = 0
+  begin
+    iter += 1
+    solver.iterate
+    status = solver.test_delta(1e-10, 1e-10)
+  end while status == GSL::CONTINUE and iter < 200
+  solver.position
+}
+fd4 = GSL::Diff::Jacobian.alloc(:central, :threads => 4)
+test_int(fd4.threads, 4, "Diff::Jacobian threads")
+x1 = fit_with.call(expf, GSL::Diff::Jacobian.alloc(:central))
+x4 = fit_with.call(expf, fd4)
+test2(x1 == x4, "MultiFit::Function_fdf with a threaded Diff::Jacobian")
+model = GSL::MultiFit::Function_fdf.compile("x[0]*exp(-x[1]*t) + x[2]", 3).params[0]
+xc = fit_with.call(GSL::MultiFit::Function_fdf.alloc(model, fd4, 3), nil)
+test_rel(xc[1], 1.5, 1e-6, "MultiFit compiled model with a threaded Diff::Jacobian")
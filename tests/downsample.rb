@@ -0,0 +1,46 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+n = 100000
+t = GSL::Vector.linspace(0, 10, n)
+y = t.collect { |s| Math::sin(s) }
+y[54321] = 5.0
+y[65432] = -5.0
+
+x, v = y.downsample_minmax(200)
+test2(x.size <= 200 && x.size == v.size, "GSL::Vector#downsample_minmax size")
+test2(v.max == 5.0 && v.min == -5.0, "GSL::Vector#downsample_minmax keeps extremes")
+test2(x.to_a.include?(54321.0) && x.diff.min > 0, "GSL::Vector#downsample_minmax indices in order")
+
+x, v = y.downsample_lttb(500, t)
+test2(x.size == 500 && v.size == 500, "GSL::Vector#downsample_lttb size")
+test2(x[0] == t[0] && x[-1] == t[-1], "GSL::Vector#downsample_lttb keeps the end points")
+test2(v.max == 5.0 && v.min == -5.0, "GSL::Vector#downsample_lttb keeps spikes")
+test2(x.diff.min > 0, "GSL::Vector#downsample_lttb abscissae in order")
+
+w = GSL::Vector[1, 2, 3]
+x, v = w.downsample_lttb(10)
+test2(x.to_a == [0, 1, 2] && v == w, "GSL::Vector#downsample_lttb short vector")
+
+begin
+  y.downsample_lttb(2)
+  test2(false, "GSL::Vector#downsample_lttb too few points")
+rescue ArgumentError
+  test2(true, "GSL::Vector#downsample_lttb too few points")
+end
+
+begin
+  y.downsample_minmax(100, GSL::Vector[1, 2])
+  test2(false, "GSL::Vector#downsample_minmax abscissae size")
+rescue ArgumentError
+  test2(true, "GSL::Vector#downsample_minmax abscissae size")
+end
+
+m = GSL.plot_max_points
+GSL.plot_max_points = 0
+test2(GSL.plot_max_points == 0, "GSL.plot_max_points=")
+GSL.plot_max_points = m
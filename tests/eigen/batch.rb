@@ -0,0 +1,35 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+rng = GSL::Rng.alloc
+[2, 3, 4, 12].each { |n|
+  batch = 100
+  a = GSL::Matrix.alloc(batch*n, n)
+  systems = []
+  batch.times { |k|
+    m = GSL::Matrix.alloc(n, n)
+    n.times { |i| n.times { |j| m[i, j] = rng.uniform } }
+    m = m + m.trans
+    m = GSL::Matrix.identity(n)*2.0 if k == 1
+    n.times { |i| a.set_row(k*n + i, m.row(i)) }
+    systems << m
+  }
+  eval, evec = GSL::Eigen::Batch.symmv(a)
+  eval2 = GSL::Eigen::Batch.symm(systems)
+  err = errv = 0.0
+  batch.times { |k|
+    e0 = GSL::Eigen.symm(systems[k]).sort
+    err = [err, (eval.row(k) - e0).abs.max, (eval2.row(k) - e0).abs.max].max
+    v = evec.submatrix(k*n, 0, n, n)
+    n.times { |j|
+      errv = [errv, (systems[k]*v.col(j) - v.col(j)*eval[k, j]).abs.max].max
+    }
+    errv = [errv, (v.trans*v - GSL::Matrix.identity(n)).abs.max].max
+  }
+  test_abs(err, 0.0, 1e-12, "GSL::Eigen::Batch.symm #{n} x #{n} eigenvalues")
+  test_abs(errv, 0.0, 1e-11, "GSL::Eigen::Batch.symmv #{n} x #{n} eigenvectors")
+}
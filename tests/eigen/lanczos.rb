@@ -0,0 +1,31 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+n = 120
+a = GSL::Matrix.calloc(n, n)
+n.times { |i|
+  a[i, i] = 2.0 + 0.01*i
+  a[i, i + 1] = a[i + 1, i] = -1.0 if i + 1 < n
+}
+eval0, evec0 = a.eigen_symmv
+GSL::Eigen::Symmv::sort(eval0, evec0, GSL::Eigen::SORT_VAL_DESC)
+
+k = 5
+[[:largest, GSL::Eigen::SORT_VAL_DESC], [:smallest, GSL::Eigen::SORT_VAL_ASC]].each { |which, order|
+  eval, evec = GSL::Eigen.lanczos(a, k, :which => which, :tol => 1e-12)
+  ref = eval0.clone
+  GSL::Eigen::Symmv::sort(ref, evec0.clone, order)
+  k.times { |i|
+    test_abs(eval[i], ref[i], 1e-9, "GSL::Eigen.lanczos #{which} eigenvalue #{i}")
+    y = evec.col(i)
+    test_abs((a*y - y*eval[i]).nrm2, 0.0, 1e-8, "GSL::Eigen.lanczos #{which} eigenvector #{i}")
+  }
+}
+
+op = Proc.new { |x| a*x }
+eval, evec = GSL::Eigen.lanczos(op, k, :n => n)
+test_abs(eval[0], eval0[0], 1e-8, "GSL::Eigen.lanczos with a callable operator")
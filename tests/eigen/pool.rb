@@ -0,0 +1,26 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+n = 20
+a = GSL::Matrix.alloc(n, n)
+n.times { |i| n.times { |j| a[i, j] = 1.0/(i + j + 1) } }
+eval0, evec0 = GSL::Eigen.symmv(a)
+10.times { |k|
+  eval, evec = GSL::Eigen.symmv(k.even? ? a : GSL::Matrix.alloc(n + 1, n + 1).set_identity)
+  next unless k.even?
+  test_abs((eval - eval0).abs.max, 0.0, 1e-14, "Eigen.symmv with a pooled workspace, call #{k}")
+}
+e1 = GSL::Eigen.symm(a)
+test_abs((e1.sort - eval0.sort).abs.max, 0.0, 1e-14, "Eigen.symm with a pooled workspace")
+
+b = a.clone
+eval, evec = GSL::Eigen.symmv(b, :overwrite => true)
+test_abs((eval - eval0).abs.max, 0.0, 1e-14, "Eigen.symmv :overwrite => true")
+test((b - a).abs.max > 0 ? 0 : 1, "Eigen.symmv :overwrite => true works on the input")
+a0 = a.clone
+eval, evec = GSL::Eigen.symmv(a, :overwrite => false)
+test_abs((a - a0).abs.max, 0.0, 0.0, "Eigen.symmv keeps the input by default")
@@ -0,0 +1,40 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+test2(GSL.error_mode == :raise, "GSL.error_mode is :raise by default")
+begin
+  GSL::Sf::gamma(-1.0)
+  test2(false, "GSL::Sf::gamma(-1) raises in :raise mode")
+rescue GSL::ERROR::EDOM
+  test2(true, "GSL::Sf::gamma(-1) raises in :raise mode")
+end
+
+GSL.error_mode = :status
+y = GSL::Sf::gamma(-1.0)
+test2(y.is_a?(Float), "GSL::Sf::gamma(-1) returns in :status mode")
+test2(GSL.error_status == GSL::EDOM, "GSL.error_status")
+test2(GSL.last_error.is_a?(GSL::ERROR::EDOM), "GSL.last_error")
+GSL::Sf::gamma(2.5)
+test2(GSL.error_status == GSL::EDOM, "GSL.error_status keeps the first error")
+test2(GSL.clear_error == GSL::EDOM, "GSL.clear_error returns the status")
+test2(GSL.error_status == GSL::SUCCESS && GSL.last_error.nil?, "GSL.clear_error")
+test2(Thread.new { GSL.error_mode }.value == :raise, "GSL.error_mode is per thread")
+GSL.error_mode = :raise
+
+y, status = GSL.with_error_status { GSL::Sf::gamma(-2.0) }
+test2(status == GSL::EDOM, "GSL.with_error_status returns the status")
+test2(GSL.error_mode == :raise && GSL.error_status == GSL::SUCCESS,
+      "GSL.with_error_status restores the mode")
+y, status = GSL.with_error_status { GSL::Sf::gamma(2.0) }
+test2((y - 1.0).abs < 1e-12 && status == GSL::SUCCESS, "GSL.with_error_status without error")
+
+begin
+  GSL.error_mode = :ignore
+  test2(false, "GSL.error_mode= checks its argument")
+rescue ArgumentError
+  test2(true, "GSL.error_mode= checks its argument")
+end
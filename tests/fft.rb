@@ -0,0 +1,132 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# Wavetables and workspaces are reused between transforms of equal length
+GSL::FFT.cache_clear
+n = 30
+x = GSL::Vector.alloc(n)
+n.times { |i| x[i] = Math::sin(0.3*i) + 0.1*i }
+
+y = x.fft
+stats = GSL::FFT.cache_stats
+test_int(stats[:misses], 2, "FFT cache miss on first real transform")
+test_int(stats[:hits], 0, "FFT cache has no hits before reuse")
+
+y2 = x.fft
+stats = GSL::FFT.cache_stats
+test_int(stats[:hits], 2, "FFT cache hit on second real transform")
+desc = "FFT cached transform matches"
+n.times { |i| test_abs(y2[i], y[i], 0.0, desc) }
+
+# halfcomplex inverse shares the real workspace
+z = y.ifft
+stats = GSL::FFT.cache_stats
+test_int(stats[:misses], 3, "FFT cache shares real workspace with halfcomplex")
+n.times { |i| test_abs(z[i], x[i], 1e-10, "FFT cached inverse round trip") }
+
+c = GSL::Vector::Complex.alloc(n)
+n.times { |i| c[i] = GSL::Complex.alloc(x[i], 0.0) }
+c.forward
+c.forward
+stats = GSL::FFT.cache_stats
+test_int(stats[:misses], 5, "FFT cache misses for complex transforms")
+test_int(stats[:size], 5, "FFT cache size")
+
+# Least recently used entries are evicted once the capacity is reached
+cap = GSL::FFT.cache_capacity
+GSL::FFT.cache_capacity = 2
+test_int(GSL::FFT.cache_stats[:size], 2, "FFT cache shrinks to capacity")
+[16, 17, 18].each { |m| GSL::Vector.alloc(m).fft }
+test_int(GSL::FFT.cache_stats[:size], 2, "FFT cache bounded by capacity")
+
+GSL::FFT.cache_capacity = 0
+GSL::FFT.cache_clear
+x.fft
+x.fft
+stats = GSL::FFT.cache_stats
+test_int(stats[:size], 0, "FFT cache disabled")
+test_int(stats[:hits], 0, "FFT cache disabled has no hits")
+GSL::FFT.cache_capacity = cap
+
+# Batched transforms of matrix rows and columns
+m = GSL::Matrix.alloc(4, 12)
+4.times { |i| 12.times { |j| m[i, j] = Math::cos(0.2*(i + 1)*j) + i } }
+f = m.fft_rows
+4.times { |i|
+  y = m.row(i).fft
+  12.times { |j| test_abs(f[i, j], y[j], 1e-12, "Matrix#fft_rows row #{i}") }
+}
+g = m.fft_columns(3)
+12.times { |j|
+  y = m.column(j).fft
+  4.times { |i| test_abs(g[i, j], y[i], 1e-12, "Matrix#fft_columns column #{j}") }
+}
+f.ifft_rows!(2)
+4.times { |i| 12.times { |j| test_abs(f[i, j], m[i, j], 1e-10, "Matrix#ifft_rows! round trip") } }
+
+mc = GSL::Matrix::Complex.alloc(5, 8)
+5.times { |i| 8.times { |j| mc[i, j] = GSL::Complex.alloc(i + j, i - 0.5*j) } }
+fc = mc.fft_columns
+8.times { |j|
+  y = mc.column(j).forward
+  5.times { |i|
+    test_abs(fc[i, j].re, y[i].re, 1e-12, "Matrix::Complex#fft_columns re")
+    test_abs(fc[i, j].im, y[i].im, 1e-12, "Matrix::Complex#fft_columns im")
+  }
+}
+fc.ifft_columns!
+mr = mc.fft_rows(4).ifft_rows
+5.times { |i| 8.times { |j|
+  test_abs(fc[i, j].re, mc[i, j].re, 1e-10, "Matrix::Complex#ifft_columns! round trip")
+  test_abs(mr[i, j].im, mc[i, j].im, 1e-10, "Matrix::Complex#ifft_rows round trip")
+} }
+
+# Two-dimensional and n-dimensional complex transforms
+mc = GSL::Matrix::Complex.alloc(6, 20)
+6.times { |i| 20.times { |j| mc[i, j] = GSL::Complex.alloc(Math::sin(i + 0.3*j), 0.1*i*j) } }
+f2 = mc.fft2
+ref = mc.fft_rows.fft_columns
+6.times { |i| 20.times { |j|
+  test_abs(f2[i, j].re, ref[i, j].re, 1e-10, "Matrix::Complex#fft2 re")
+  test_abs(f2[i, j].im, ref[i, j].im, 1e-10, "Matrix::Complex#fft2 im")
+} }
+f2.ifft2!
+6.times { |i| 20.times { |j|
+  test_abs(f2[i, j].re, mc[i, j].re, 1e-10, "Matrix::Complex#ifft2! round trip")
+} }
+
+v = GSL::Vector::Complex.alloc(120)
+6.times { |i| 20.times { |j| v[i*20 + j] = mc[i, j] } }
+fv = v.fftn([6, 20])
+6.times { |i| 20.times { |j|
+  test_abs(fv[i*20 + j].re, ref[i, j].re, 1e-10, "Vector::Complex#fftn rank 2")
+} }
+fv = v.fftn([2, 3, 20]).ifftn!([2, 3, 20])
+120.times { |i| test_abs(fv[i].im, v[i].im, 1e-10, "Vector::Complex#ifftn! round trip") }
+
+# Short-time Fourier transform
+sig = GSL::Vector.alloc(200)
+200.times { |i| sig[i] = Math::sin(2*Math::PI*0.125*i) + 0.5*Math::cos(0.9*i) }
+nwin, hop = 32, 12
+s = sig.stft(nwin, hop)
+nframes = (200 - nwin)/hop + 1
+test_int(s.size1, nframes, "Vector#stft frames")
+test_int(s.size2, nwin/2 + 1, "Vector#stft bins")
+hann = GSL::Vector.alloc(nwin)
+nwin.times { |i| hann[i] = 0.5 - 0.5*Math::cos(2*Math::PI*i/nwin) }
+sc = sig.stft(nwin, hop, :output => :complex)
+sp = sig.stft(nwin, hop, :window => hann, :output => :power)
+[0, 5, nframes - 1].each { |f|
+  frame = GSL::Vector.alloc(nwin)
+  nwin.times { |i| frame[i] = sig[f*hop + i]*hann[i] }
+  c = frame.fft.halfcomplex_to_complex
+  (nwin/2 + 1).times { |k|
+    test_abs(s[f, k], c[k].abs, 1e-10, "Vector#stft magnitude frame #{f}")
+    test_abs(sc[f, k].re, c[k].re, 1e-10, "Vector#stft complex frame #{f}")
+    test_abs(sp[f, k], c[k].abs**2, 1e-10, "Vector#stft power frame #{f}")
+  }
+}
@@ -75,6 +75,30 @@ GSL::Test::test_rel(cov01, expected_cov01, 1e-10, "norris gsl_fit_wlinear cov01"
 GSL::Test::test_rel(cov11, expected_cov11, 1e-10, "norris gsl_fit_wlinear cov11")
 GSL::Test::test_rel(sumsq, expected_sumsq, 1e-10, "norris gsl_fit_wlinear sumsq")
 
+# Columns y, 2y + 1 and -y fitted at once
+yy = GSL::Matrix.alloc(norris_n, 3)
+for i in 0...norris_n
+  yy[i,0] = norris_y[i]
+  yy[i,1] = 2*norris_y[i] + 1
+  yy[i,2] = -norris_y[i]
+end
+scale = [[1, 0], [2, 1], [-1, 0]]
+[[GSL::Fit.linear_batch(norris_x, yy), GSL::Fit.linear(norris_x, norris_y), "linear_batch"],
+ [GSL::Fit.wlinear_batch(norris_x, GSL::Vector.alloc(norris_n).set_all(1.0), yy),
+  GSL::Fit.wlinear(norris_x, GSL::Vector.alloc(norris_n).set_all(1.0), norris_y), "wlinear_batch"]].each do |r, r0, name|
+  weighted = name == "wlinear_batch"
+  3.times do |j|
+    a, b = scale[j]
+    GSL::Test::test_rel(r[0][j], a*r0[0] + b, 1e-10, "norris Fit.#{name} c0, column #{j}")
+    GSL::Test::test_rel(r[1][j], a*r0[1], 1e-10, "norris Fit.#{name} c1, column #{j}")
+    s2 = weighted ? 1 : a*a
+    GSL::Test::test_rel(r[2][j], s2*r0[2], 1e-10, "norris Fit.#{name} cov00, column #{j}")
+    GSL::Test::test_rel(r[3][j], s2*r0[3], 1e-10, "norris Fit.#{name} cov01, column #{j}")
+    GSL::Test::test_rel(r[4][j], s2*r0[4], 1e-10, "norris Fit.#{name} cov11, column #{j}")
+    GSL::Test::test_rel(r[5][j], a*a*r0[5], 1e-10, "norris Fit.#{name} sumsq, column #{j}")
+  end
+end
+
 for i in 0...noint1_n
   x.set(i, noint1_x[i])
   w.set(i, 1.0)
@@ -122,3 +146,32 @@ c1, cov11, sumsq = GSL::Fit.wmul(x, w, y, noint2_n)
 GSL::Test::test_rel(c1, expected_c1, 1e-10, "noint2 gsl_fit_wmul c1")
 GSL::Test::test_rel(cov11, expected_cov11, 1e-10, "noint2 gsl_fit_wmul cov11")
 GSL::Test::test_rel(sumsq, expected_sumsq, 1e-10, "noint2 gsl_fit_wmul sumsq")
+
+# Fit::Rolling over a window, and with decaying weights, against
+# Fit.wlinear on the same samples
+n = 200
+x = GSL::Vector.alloc(n)
+y = GSL::Vector.alloc(n)
+w = GSL::Vector.alloc(n)
+n.times do |i|
+  x[i] = Math.sin(0.1*i) + 0.01*i
+  y[i] = 1.0 + (2.0 + Math.cos(0.05*i))*x[i] + 0.01*Math.sin(7.0*i)
+  w[i] = 1.0 + (i % 3)
+end
+r = GSL::Fit::Rolling.alloc(1, :window => 20)
+c = r.roll(x, y, w)
+[19, 57, 120, 199].each do |i|
+  c0, c1, cov00, cov01, cov11, = GSL::Fit.wlinear(x.subvector(i - 19, 20), w.subvector(i - 19, 20),
+                                                  y.subvector(i - 19, 20))
+  GSL::Test::test_rel(c[i, 0], c0, 1e-9, "Fit::Rolling window c0 #{i}")
+  GSL::Test::test_rel(c[i, 1], c1, 1e-9, "Fit::Rolling window c1 #{i}")
+end
+GSL::Test::test_rel(r.cov[1, 1], cov11, 1e-9, "Fit::Rolling#cov")
+GSL::Test::test(c[0, 0].nan? ? 0 : 1, "Fit::Rolling NaN before two samples")
+r = GSL::Fit::Rolling.alloc(1, :decay => 0.9)
+n.times { |i| r.add(x[i], y[i]) }
+d = GSL::Vector.alloc(n)
+n.times { |i| d[i] = 0.9**(n - 1 - i) }
+c0, c1, = GSL::Fit.wlinear(x, d, y)
+GSL::Test::test_rel(r.coef[0], c0, 1e-9, "Fit::Rolling decay c0")
+GSL::Test::test_rel(r.coef[1], c1, 1e-9, "Fit::Rolling decay c1")
@@ -0,0 +1,44 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+f = GSL::Function.compile("x**2*sin(a*x) + exp(-x)/b", "a" => 2.0, "b" => 4)
+g = GSL::Function.alloc { |x, p| x**2*Math::sin(p[0]*x) + Math::exp(-x)/p[1] }
+g.set_params([2.0, 4.0])
+
+test2(f.class == GSL::Function::Compiled, "GSL::Function.compile")
+[0.0, 0.5, 1.0, 2.5].each do |x|
+  test_rel(f.eval(x), g.eval(x), 1e-15, "GSL::Function::Compiled#eval(#{x})")
+end
+v = GSL::Vector.linspace(0, 3, 10)
+test2(f.eval(v) == g.eval(v), "GSL::Function::Compiled#eval(GSL::Vector)")
+
+r1 = f.integration_qags([0, 1])
+r2 = g.integration_qags([0, 1])
+test_rel(r1[0], r2[0], 1e-12, "GSL::Function::Compiled#integration_qags")
+
+f.set_params("a" => 1.0)
+test_rel(f.eval(1.0), Math::sin(1.0) + Math::exp(-1.0)/4, 1e-15, "GSL::Function::Compiled#set_params")
+test_rel(GSL::Function.compile("-x^2 + 2**3").eval(3), -1.0, 1e-15, "GSL::Function.compile: operator precedence")
+test_rel(GSL::Function.compile("gamma(x) + pi").eval(4), 6 + Math::PI, 1e-14, "GSL::Function.compile: special function")
+
+begin
+  GSL::Function.compile("x + y")
+  test2(false, "GSL::Function.compile: unknown variable")
+rescue SyntaxError
+  test2(true, "GSL::Function.compile: unknown variable")
+end
+
+n = 0
+h = GSL::Function.vectorized { |x, y| n += 1; y.set(x.mul(x)) }
+test2(h.vectorized?, "GSL::Function.vectorized")
+v = GSL::Vector.linspace(0, 1, 100)
+test2(h.eval(v) == v.mul(v) && n == 1, "GSL::Function.vectorized: #eval(GSL::Vector) in one call")
+test_rel(h.eval(3.0), 9.0, 1e-15, "GSL::Function.vectorized: #eval(Float)")
+if GSL::Integration.const_defined?("Glfixed_table")
+  t = GSL::Integration::Glfixed_table.alloc(11)
+  n = 0
+  test_rel(h.glfixed(0, 2, t), 8.0/3, 1e-14, "GSL::Function.vectorized: #glfixed")
+  test2(n == 1, "GSL::Function.vectorized: #glfixed in one call")
+end
@@ -0,0 +1,89 @@
+#!/usr/bin/env ruby
+# Exact derivatives of compiled functions, by dual numbers
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+include Math
+
+f = GSL::Function.compile("x**2*sin(a*x) + exp(-x)/b", "a" => 2.0, "b" => 4)
+df = lambda { |x| 2*x*sin(2*x) + 2*x**2*cos(2*x) - exp(-x)/4 }
+[0.0, 0.5, 1.0, 2.5].each do |x|
+  v, d = f.eval_fdf(x)
+  test_rel(v, f.eval(x), 1e-15, "GSL::Function::Compiled#eval_fdf(#{x}), f")
+  test_abs(d, df.call(x), 1e-14, "GSL::Function::Compiled#eval_fdf(#{x}), df")
+end
+
+[["sqrt(x)", lambda { |x| 0.5/sqrt(x) }],
+ ["log(x)*atan(x)", lambda { |x| atan(x)/x + log(x)/(1 + x*x) }],
+ ["pow(x, x)", lambda { |x| x**x*(log(x) + 1) }],
+ ["erf(x)/x^3", lambda { |x| 2/sqrt(PI)*exp(-x*x)/x**3 - 3*GSL::Sf::erf(x)/x**4 }],
+ ["bessel_J0(x) + gamma(x)", lambda { |x| -GSL::Sf::bessel_J1(x) + GSL::Sf::gamma(x)*GSL::Sf::psi(x) }],
+ ["hypot(x, 2) - max(x, 1)", lambda { |x| x/GSL::hypot(x, 2) - (x >= 1 ? 1 : 0) }]].each do |e, d|
+  g = GSL::Function.compile(e)
+  [0.3, 1.7].each { |x| test_rel(g.eval_fdf(x)[1], d.call(x), 1e-13, "eval_fdf #{e} at #{x}") }
+end
+test_abs(GSL::Function.compile("x + 0*sqrt(0)").eval_fdf(2)[1], 1.0, 0, "eval_fdf, constant operands")
+
+# Newton's method with f' by dual numbers
+g = GSL::Function.compile("x**20 - 1")
+s = GSL::Root::FdfSolver.alloc("newton")
+s.set(g.fdf, 0.9)
+iter = 0
+begin
+  iter += 1
+  x0 = s.root
+  s.iterate
+  status = GSL::Root.test_delta(s.root, x0, 0, 1e-10)
+end while status == GSL::CONTINUE and iter < 100
+test_rel(s.root, 1.0, 1e-10, "GSL::Function::Compiled#fdf with Root::FdfSolver")
+h = GSL::Function_fdf.alloc(g, Proc.new { |x| 20*x**19 })
+s.set(h, 0.9)
+s.iterate
+x1 = s.root
+s.set(g.fdf, 0.9)
+s.iterate
+test_rel(s.root, x1, 1e-15, "GSL::Function_fdf with a compiled f and a Ruby df")
+
+# Roth's equations, Jacobian by dual numbers
+roth = GSL::MultiRoot::Function_fdf.compile(["-13 + x[0] + ((5 - x[1])*x[1] - 2)*x[1]",
+                                             "-29 + x[0] + ((x[1] + 1)*x[1] - c)*x[1]"],
+                                            "c" => 14)
+test_int(roth.n, 2, "MultiRoot::Function_fdf.compile, n")
+s = GSL::MultiRoot::FdfSolver.alloc("hybridsj", 2)
+s.set(roth, GSL::Vector.alloc([4.5, 3.5]))
+iter = 0
+begin
+  iter += 1
+  s.iterate
+  status = GSL::MultiRoot.test_residual(s.f, 1e-10)
+end while status == GSL::CONTINUE and iter < 100
+test_rel(s.root[0], 5.0, 1e-10, "MultiRoot::Function_fdf.compile")
+test_rel(s.root[1], 4.0, 1e-10, "MultiRoot::Function_fdf.compile")
+test_rel(s.J[1,1], 3*4.0**2 + 2*4.0 - 14, 1e-10, "MultiRoot::Function_fdf.compile, Jacobian")
+
+# Exponential fit, residuals and Jacobian in C
+t = GSL::Vector.linspace(0, 3, 20)
+y = t.collect { |ti| 2.0*exp(-1.5*ti) + 0.5 }
+sigma = GSL::Vector.alloc(t.size).set_all(0.1)
+fit = GSL::MultiFit::Function_fdf.compile("x[0]*exp(-x[1]*t) + x[2]", 3)
+fit.set_data(t, y, sigma)
+solver = GSL::MultiFit::FdfSolver.alloc(GSL::MultiFit::FdfSolver::LMSDER, t.size, 3)
+solver.set(fit, GSL::Vector.alloc([1.0, 1.0, 0.0]))
+iter = 0
+begin
+  iter += 1
+  solver.iterate
+  status = solver.test_delta(1e-12, 1e-12)
+end while status == GSL::CONTINUE and iter < 200
+test_rel(solver.position[0], 2.0, 1e-8, "MultiFit::Function_fdf.compile")
+test_rel(solver.position[1], 1.5, 1e-8, "MultiFit::Function_fdf.compile")
+test_rel(solver.position[2], 0.5, 1e-8, "MultiFit::Function_fdf.compile")
+x = solver.position
+test_rel(solver.J[3,1], -x[0]*t[3]*exp(-x[1]*t[3])/0.1, 1e-10, "MultiFit::Function_fdf.compile, Jacobian")
+
+begin
+  GSL::MultiRoot::Function_fdf.compile([])
+  test2(false, "MultiRoot::Function_fdf.compile, no expressions")
+rescue ArgumentError
+  test2(true, "MultiRoot::Function_fdf.compile, no expressions")
+end
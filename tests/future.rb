@@ -0,0 +1,36 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+r = GSL::Rng.alloc
+m = GSL::Matrix.alloc(200, 200)
+200.times { |i| 200.times { |j| m[i, j] = r.uniform } }
+lu, perm, signum = m.LU_decomp
+
+f = GSL.async(m) { |a| a.LU_decomp }
+test2(f.is_a?(GSL::Future) && f.is_a?(Thread), "GSL.async returns a GSL::Future")
+lu2, perm2, signum2 = f.value
+test2(f.done? && f.wait, "GSL::Future#done? and #wait once done")
+test2(lu2 == lu && perm2 == perm && signum2 == signum, "GSL.async(m) { |a| a.LU_decomp }")
+
+fs = 4.times.map { |k| GSL.async(k) { |kk| (m*(kk + 1)).LU_decomp[0] } }
+test2(fs.each_with_index.all? { |g, k| g.value == (m*(k + 1)).LU_decomp[0] },
+      "GSL.async, 4 futures at once")
+
+q = Thread::Queue.new
+f = GSL.async { q.pop }
+test2(f.wait(0.01) == false && !f.done?, "GSL::Future#wait(timeout) before the end")
+q << 3
+test_int(f.value, 3, "GSL::Future#value")
+
+f = GSL.async { raise ArgumentError, "in the block" }
+test2(f.wait, "GSL::Future#wait after an exception of the block")
+begin
+  f.value
+  test2(false, "GSL::Future#value raises the exception of the block")
+rescue ArgumentError => e
+  test2(e.message == "in the block", "GSL::Future#value raises the exception of the block")
+end
@@ -0,0 +1,57 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("tempfile")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+exit unless defined?(GSL::HDF5)
+
+f = Tempfile.new(["gsl", ".h5"])
+f.close
+path = f.path
+
+m = GSL::Matrix[[1, 2, 3], [4, 5, 6], [7, 8, 9], [10, 11, 12]]
+v = GSL::Vector[1, 2, 3, 4, 5, 6].subvector_with_stride(0, 2, 3)
+h = GSL::Histogram.alloc(3, [0, 3])
+h.increment(0.5)
+h.increment(2.5, 2)
+GSL::HDF5::File.open(path, "w") do |file|
+  file.write("m", m, :compress => 6)
+  file.write("series/v", v)
+  file.write("vi", GSL::Vector::Int[1, -2, 3], :chunk => true)
+  file.write("z", GSL::Vector::Complex[[1, 2], [3, -4]])
+  file.write("h", h)
+end
+
+GSL::HDF5::File.open(path) do |file|
+  test2(file.names.sort == ["h", "m", "series", "vi", "z"], "GSL::HDF5::File#names")
+  test2(file.shape("m") == [4, 3], "GSL::HDF5::File#shape")
+  test2(file.read("m") == m, "GSL::HDF5::File#read compressed matrix")
+  test2(file.read("series/v").to_a == [1, 3, 5], "GSL::HDF5::File#read strided vector")
+  test2(file.read("vi").to_a == [1, -2, 3], "GSL::HDF5::File#read Vector::Int")
+  test2(file.read("z")[1].im == -4, "GSL::HDF5::File#read Vector::Complex")
+  w = file.read("h")
+  test2(w.class == GSL::Histogram && w.range.to_a == [0, 1, 2, 3] && w.bin.to_a == [1, 0, 2],
+        "GSL::HDF5::File#read Histogram")
+  test2(file.read("m", :offset => [1, 1], :count => [2, 2]) == GSL::Matrix[[5, 6], [8, 9]],
+        "GSL::HDF5::File#read hyperslab")
+  a = GSL::Matrix.calloc(3, 3)
+  file.read_into("m", a.column(1), :offset => [0, 2])
+  test2(a.column(1).to_a == [3, 6, 9] && a.column(0).to_a == [0, 0, 0],
+        "GSL::HDF5::File#read_into a column view")
+  file.read_into("m", a.submatrix(0, 0, 2, 2), :offset => [2, 0])
+  test2(a[1, 1] == 11 && a[2, 1] == 9, "GSL::HDF5::File#read_into a submatrix view")
+  begin
+    file.read("m", :offset => [3, 0], :count => [2, 3])
+    test2(false, "GSL::HDF5::File#read out of the dataset")
+  rescue IndexError
+    test2(true, "GSL::HDF5::File#read out of the dataset")
+  end
+end
+
+GSL::HDF5::File.open(path, "r+") do |file|
+  file.write("m", GSL::Vector[0, 0, 0], :offset => [1, 0])
+end
+test2(GSL::HDF5.read(path, "m").row(1).to_a == [0, 0, 0], "GSL::HDF5::File#write into a hyperslab")
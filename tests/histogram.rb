@@ -0,0 +1,174 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("gsl_test.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# Bulk increment against one value at a time, uniform and non-uniform
+# ranges, values on the edges, outside the range and NaN; the size is
+# large enough for the fill to be cut in parts
+rng = GSL::Rng.alloc
+x = GSL::Vector.alloc(200000)
+x.size.times { |i| x[i] = -2.0 + 5.0*rng.uniform }
+x[0] = 0.0; x[1] = 2.5; x[2] = -1.0; x[3] = GSL::NAN; x[4] = 0.5
+w = GSL::Vector.alloc(x.size)
+w.size.times { |i| w[i] = 0.25*(i % 4 + 1) }
+[GSL::Histogram.alloc(10, [-1.0, 2.5]),
+ GSL::Histogram.alloc([-1.0, -0.5, 0.0, 0.1, 0.5, 1.5, 2.5])].each do |h0|
+  h1 = h0.clone
+  h2 = h0.clone
+  h3 = h0.clone
+  x.size.times do |i|
+    next if x[i].nan?
+    h0.increment(x[i])
+    h2.increment(x[i], w[i])
+  end
+  h1.increment(x)
+  h3.increment(x, w)
+  GSL::Test::test((h0.bin - h1.bin).abs.max == 0.0 ? 0 : 1,
+                  "Histogram#increment(Vector), #{h0.size} bins")
+  GSL::Test::test((h3.bin - h2.bin).abs.max == 0.0 ? 0 : 1,
+                  "Histogram#increment(Vector, Vector), #{h0.size} bins")
+  h4 = h0.clone
+  h4.reset
+  h4.increment(x.to_a.reject { |xi| xi.nan? }, 2.0)
+  GSL::Test::test((h4.bin - h0.bin*2).abs.max == 0.0 ? 0 : 1,
+                  "Histogram#increment(Array, weight), #{h0.size} bins")
+end
+
+# 2d and 3d bulk increment, one axis non-uniform
+y = GSL::Vector.alloc(x.size)
+z = GSL::Vector.alloc(x.size)
+y.size.times { |i| y[i] = -1.0 + 3.0*rng.uniform }
+z.size.times { |i| z[i] = 4.0*rng.uniform }
+h0 = GSL::Histogram2d.alloc(8, [-1.0, 2.5], 5, [-0.5, 1.5])
+h1 = h0.clone
+x.size.times { |i| h0.increment(x[i], y[i], w[i]) unless x[i].nan? }
+h1.increment(x, y, w)
+GSL::Test::test((h0.bin - h1.bin).abs.max == 0.0 ? 0 : 1,
+                "Histogram2d#increment(Vector, Vector, Vector)")
+m = GSL::Matrix.alloc(x.size, 2)
+m.set_col(0, x)
+m.set_col(1, y)
+h2 = h0.clone
+h2.reset
+h2.increment(m, w)
+GSL::Test::test((h0.bin - h2.bin).abs.max == 0.0 ? 0 : 1,
+                "Histogram2d#increment(Matrix, Vector)")
+
+g0 = GSL::Histogram3d.alloc(GSL::Vector[-1.0, 0.0, 0.3, 2.5], GSL::Vector[-1, 0, 1, 2],
+                            GSL::Vector[0.0, 1.0, 2.0, 3.5])
+g1 = g0.clone
+x.size.times { |i| g0.increment(x[i], y[i], z[i]) unless x[i].nan? }
+g1.increment(x, y, z)
+diff = 0.0
+3.times { |i| 3.times { |j| 3.times { |k| diff += (g0.get(i, j, k) - g1.get(i, j, k)).abs } } }
+GSL::Test::test(diff == 0.0 ? 0 : 1, "Histogram3d#increment(Vector, Vector, Vector)")
+m = GSL::Matrix.alloc(x.size, 3)
+m.set_col(0, x)
+m.set_col(1, y)
+m.set_col(2, z)
+g2 = g0.clone
+g2.reset
+g2.increment(m, 2.0)
+diff = 0.0
+3.times { |i| 3.times { |j| 3.times { |k| diff += (2*g0.get(i, j, k) - g2.get(i, j, k)).abs } } }
+GSL::Test::test(diff == 0.0 ? 0 : 1, "Histogram3d#increment(Matrix, weight)")
+
+# Sparse histogram against its dense conversion
+s = GSL::Histogram::Sparse.new(1e-3, -0.5)
+s.increment(x, w)
+s.increment(1e4)
+lo, hi = s.get_range(s.find(1e4))
+GSL::Test::test(lo <= 1e4 && 1e4 < hi && (s.find(1e4) - 10000500).abs <= 1 ? 0 : 1,
+                "Histogram::Sparse#find")
+GSL::Test::test_rel(s.get(s.find(1e4)), 1.0, 1e-15, "Histogram::Sparse#get")
+s2 = GSL::Histogram::Sparse.new(1e-3, -0.5)
+s2.increment(x, w)
+y.size.times { |i| s2.increment(y[i]) }
+s.reset
+s.increment(x, w)
+s.increment(y)
+GSL::Test::test(s.to_a == s2.to_a ? 0 : 1, "Histogram::Sparse#increment(Vector)")
+d = s.to_histogram
+GSL::Test::test_rel(d.min, s.min, 1e-15, "Histogram::Sparse#to_histogram min")
+GSL::Test::test_rel(d.max, s.max, 1e-15, "Histogram::Sparse#to_histogram max")
+GSL::Test::test_rel(d.sum, s.sum, 1e-15, "Histogram::Sparse#sum")
+GSL::Test::test_rel(d.mean, s.mean, 1e-15, "Histogram::Sparse#mean")
+GSL::Test::test_rel(d.sigma, s.sigma, 1e-15, "Histogram::Sparse#sigma")
+[0.1, 0.5, 0.99].each do |f|
+  GSL::Test::test_rel(d.percentile(f), s.percentile(f), 1e-15,
+                      "Histogram::Sparse#percentile(#{f})")
+end
+t = s.add(s)
+GSL::Test::test_rel(t.sum, 2*s.sum, 1e-15, "Histogram::Sparse#add")
+
+# Percentiles and sampling from the cumulative sums
+h = GSL::Histogram.alloc(10, [0, 10])
+10.times { |i| h.accumulate(i + 0.5, i % 3 + 1) }
+f = GSL::Vector[0.1, 0.5, 0.9]
+p = h.percentile(f)
+3.times { |i| GSL::Test::test_rel(p[i], h.percentile(f[i]), 1e-15, "Histogram#percentile(Vector) #{i}") }
+GSL::Test::test_rel(h.median, h.percentile(0.5), 1e-15, "Histogram#median")
+pdf = GSL::Histogram::Pdf.alloc(h)
+GSL::Test::test_rel(pdf.percentile(0.9), h.percentile(0.9), 1e-12, "Histogram::Pdf#percentile")
+s = h.sample(GSL::Rng.alloc, 20000)
+GSL::Test::test(s.size == 20000 && s.min >= 0 && s.max < 10 ? 0 : 1, "Histogram#sample(rng, n)")
+GSL::Test::test_abs(s.mean, h.mean, 0.1, "Histogram#sample mean")
+GSL::Test::test(pdf.sample(GSL::Rng.alloc, 5).size == 5 ? 0 : 1, "Histogram::Pdf#sample(rng, n)")
+
+# fwrite and fwrite2 with and without :compress, read back by fread and
+# fread2 which tell the two apart
+require("tmpdir")
+path = File.join(Dir.tmpdir, "rb-gsl-test-#{$$}.dat")
+h = GSL::Histogram.alloc(5000, [0, 1])
+(0...5000).step(37) { |i| h.accumulate((i + 0.5)/5000, i) }
+[nil, *GSL::COMPRESS_CODECS].each do |codec|
+  opts = codec ? { :compress => codec } : {}
+  h.fwrite(path, opts)
+  GSL::Test::test(codec.nil? || File.size(path) < 8*10001/4 ? 0 : 1, "Histogram#fwrite #{codec} size")
+  h2 = GSL::Histogram.alloc(5000)
+  h2.fread(path)
+  GSL::Test::test((h2.range - h.range).abs.max == 0.0 && (h2.bin - h.bin).abs.max == 0.0 ? 0 : 1,
+                  "Histogram#fread #{codec}")
+  h.fwrite2(path, opts)
+  h2 = GSL::Histogram.alloc(5000)
+  h2.fread2(path)
+  GSL::Test::test((h2.range - h.range).abs.max < 1e-15 && (h2.bin - h.bin).abs.max == 0.0 ? 0 : 1,
+                  "Histogram#fread2 #{codec}")
+end
+File.delete(path)
+
+# The moments and whole-range projections of Histogram2d and Histogram3d
+# come from cached marginal sums: they must follow every change of the bins
+h = GSL::Histogram2d.alloc(6, [0, 3], 4, [-1, 1])
+40.times { |i| h.increment(0.07*i, Math.sin(i), 1 + i % 3) }
+ref = lambda do |h|
+  x = GSL::Vector.alloc(h.nx).set_all(0); y = GSL::Vector.alloc(h.ny).set_all(0)
+  h.nx.times { |i| h.ny.times { |j| x[i] += h[i, j]; y[j] += h[i, j] } }
+  [x, y]
+end
+3.times do |k|
+  x, y = ref.call(h)
+  GSL::Test::test((h.xproject.bin - x).abs.max == 0.0 && (h.yproject.bin - y).abs.max == 0.0 ? 0 : 1,
+                  "Histogram2d#xproject, #yproject cached #{k}")
+  GSL::Test::test_rel(h.sum, x.sum, 1e-15, "Histogram2d#sum cached #{k}")
+  GSL::Test::test_rel(h.xmean, h.xproject.mean, 1e-15, "Histogram2d#xmean cached #{k}")
+  GSL::Test::test_rel(h.ysigma, h.yproject.sigma, 1e-15, "Histogram2d#ysigma cached #{k}")
+  case k
+  when 0 then h.increment(2.9, 0.9, 50)
+  when 1 then h.scale!(0.5)
+  end
+end
+b = h.bin
+s = h.sum
+b[0] += 7.0
+GSL::Test::test_rel(h.sum, s + 7.0, 1e-15, "Histogram2d#sum after writing #bin")
+g = GSL::Histogram3d.alloc(3, [0, 3], 4, [0, 4], 5, [0, 5])
+60.times { |i| g.increment(i % 3 + 0.5, i % 4 + 0.5, i % 5 + 0.5, i) }
+s = g.sum
+GSL::Test::test_rel(g.xyproject.sum, s, 1e-15, "Histogram3d#xyproject cached")
+g.increment(0.5, 0.5, 0.5, 100)
+GSL::Test::test_rel(g.sum, s + 100, 1e-15, "Histogram3d#sum after increment")
+GSL::Test::test_rel(g.yzproject.sum, s + 100, 1e-15, "Histogram3d#yzproject after increment")
@@ -0,0 +1,35 @@
+#!/usr/bin/env ruby
+# Gauss-Legendre tables cached by order, and glfixed over many intervals
+require("gsl")
+require("../gsl_test.rb")
+include Math
+
+exit unless GSL::Integration.const_defined?("Glfixed_table")
+
+cls = GSL::Integration::Glfixed_table
+cls.cache_clear
+t = cls.cache(12)
+GSL::Test::test(t.equal?(cls.cache(12)) && t.frozen? ? 0 : 1, "Glfixed_table.cache shares tables")
+GSL::Test::test_int(t.n, 12, "Glfixed_table#n")
+GSL::Test::test_int(cls.cache_size, 1, "Glfixed_table.cache_size")
+
+f = GSL::Function.alloc { |x| exp(x)*cos(x) }
+F = lambda { |u| 0.5*exp(u)*(cos(u) + sin(u)) }
+GSL::Test::test_rel(f.glfixed(0.0, 1.0, 12), F.call(1.0) - F.call(0.0), 1e-14,
+                    "glfixed with the order of a cached table")
+GSL::Test::test(f.glfixed(0.0, 1.0, 12) == f.glfixed(0.0, 1.0, GSL::Integration::Glfixed_table.alloc(12)) ? 0 : 1,
+                "glfixed, cached and allocated tables")
+
+a = GSL::Vector.linspace(0, 3, 31)
+b = a + 0.1
+n = 0
+g = GSL::Function.vectorized { |x, y| n += 1; y.set(GSL::Sf::exp(x)*GSL::Sf::cos(x)) }
+r = g.glfixed(a, b, 12)
+s = 0
+a.size.times { |i| s += 1 if (r[i] - (F.call(b[i]) - F.call(a[i]))).abs > 1e-14 }
+GSL::Test::test(s, "glfixed over many intervals")
+GSL::Test::test(n == 1 ? 0 : 1, "glfixed over many intervals, vectorized function called once")
+r2 = f.glfixed(a.to_a, b.to_a, 12)
+GSL::Test::test((r2 - r).abs.max < 1e-15 ? 0 : 1, "glfixed over intervals given as Arrays")
+r3 = GSL::Integration.glfixed(GSL::Function.compile("exp(x)*cos(x)"), a, b, 12)
+GSL::Test::test((r3 - r).abs.max < 1e-15 ? 0 : 1, "Integration.glfixed, compiled function")
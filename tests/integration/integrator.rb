@@ -0,0 +1,80 @@
+#!/usr/bin/env ruby
+# GSL::Integration::Integrator and the per-thread pool of workspaces
+require("gsl")
+require("../gsl_test.rb")
+include Math
+
+f = GSL::Function.alloc { |x| exp(x)*cos(x) }
+exact = 0.5*(exp(1.0)*(cos(1.0) + sin(1.0)) - 1.0)
+q = GSL::Integration::Integrator.alloc(200, :epsabs => 0.0, :epsrel => 1e-10)
+
+GSL::Integration.cache_clear
+r = q.qags(f, 0.0, 1.0)
+GSL::Test::test_rel(r[0], exact, 1e-10, "Integrator qags")
+GSL::Test::test_rel(q.qag(f, 0.0, 1.0)[0], exact, 1e-10, "Integrator qag")
+GSL::Test::test_rel(r[0], f.qags(0.0, 1.0, 0.0, 1e-10, 200)[0], 1e-15,
+                    "Integrator qags agrees with Function#qags")
+10.times { q.qags(f, 0.0, 1.0) }
+stats = GSL::Integration.cache_stats
+GSL::Test::test_int(stats[:misses], 1, "Integrator allocates one workspace per limit")
+GSL::Test::test_int(stats[:busy], 0, "Integrator gives its workspace back")
+
+# An integrand integrating in turn gets a workspace of its own
+g = GSL::Function.alloc { |y| q.qags(GSL::Function.alloc { |x| x*y }, 0.0, 1.0)[0] }
+GSL::Test::test_rel(q.qags(g, 0.0, 1.0)[0], 0.25, 1e-10, "Integrator nested integral")
+
+# An exception in the integrand does not keep the workspace
+bad = GSL::Function.alloc { |x| raise ArgumentError, "bad integrand" }
+3.times do
+  begin
+    q.qags(bad, 0.0, 1.0)
+  rescue ArgumentError
+  end
+end
+GSL::Test::test_int(GSL::Integration.cache_stats[:busy], 0,
+                    "Integrator workspace given back after an exception")
+
+sine = GSL::Function.alloc { |x| x }
+r = q.qawo(sine, 0.0, 2*PI, 1.0, GSL::Integration::SINE)
+GSL::Test::test_rel(r[0], -1.0/(2*PI), 1e-10, "Integrator qawo")
+r = q.qaws(GSL::Function.alloc { |x| 1.0 }, 0.0, 1.0, [0.0, 0.0, 0, 0])
+GSL::Test::test_rel(r[0], 1.0, 1e-10, "Integrator qaws")
+
+threads = 4.times.map do |t|
+  Thread.new { (0...50).map { q.qags(f, 0.0, 1.0)[0] }.uniq }
+end
+GSL::Test::test(threads.map(&:value).flatten.uniq == [q.qags(f, 0.0, 1.0)[0]] ? 0 : 1,
+                "Integrator shared by threads")
+
+# Vector-valued integrands: one subdivision shared by all the components
+exact = [2.0/3, -1.0, 1.0 - cos(1.0)]
+fs = [GSL::Function.alloc { |x| sqrt(x) }, GSL::Function.alloc { |x| log(x) },
+      GSL::Function.compile("sin(x)")]
+r, e, n, s = GSL::Integration.qag_vector(fs, 0.0, 1.0, :epsabs => 0.0, :epsrel => 1e-10)
+GSL::Test::test_int(s, GSL::SUCCESS, "qag_vector status")
+3.times { |k| GSL::Test::test_rel(r[k], exact[k], 1e-10, "qag_vector component #{k}") }
+3.times { |k| GSL::Test::test(e[k] <= 1e-10*fs.size ? 0 : 1, "qag_vector error #{k}") }
+
+f = lambda { |x| GSL::Vector[sqrt(x), log(x), sin(x)] }
+r2, e2, n2, s2 = GSL::Integration.qag_vector(f, 0.0, 1.0, :epsabs => 0.0, :epsrel => 1e-10)
+GSL::Test::test((r2 - r).abs.max == 0.0 && n2 == n ? 0 : 1, "qag_vector with a callable")
+
+calls = 0
+g = lambda do |x|
+  calls += 1
+  m = GSL::Matrix.alloc(x.size, 3)
+  x.size.times { |i| m.set_row(i, GSL::Vector[sqrt(x[i]), log(x[i]), sin(x[i])]) }
+  m
+end
+r3, e3, n3, s3 = GSL::Integration.qag_vector(g, 0.0, 1.0, :batch => true,
+                                             :epsabs => 0.0, :epsrel => 1e-10)
+GSL::Test::test((r3 - r).abs.max == 0.0 ? 0 : 1, "qag_vector with a batched callable")
+GSL::Test::test(calls <= n3 + 1 ? 0 : 1, "qag_vector batch calls once per bisection")
+
+f = (0..31).map { |k| GSL::Function.compile("x^#{k}") }
+r, e, n, s = GSL::Integration.qag_vector(f, -1.0, 1.0, :limit => 1)
+32.times do |k|
+  GSL::Test::test_abs(r[k], k.even? ? 2.0/(k + 1) : 0.0, 1e-14, "qag_vector 21-point rule, x^#{k}")
+end
+r, e, n, s = q.qag_vector(fs, 0.0, 1.0, :norm => :l2)
+GSL::Test::test_rel(r[0], exact[0], 1e-8, "Integrator qag_vector")
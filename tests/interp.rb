@@ -40,6 +40,212 @@ def test_bsearch()
 
 end
 
+# Vector evaluation walks the knots for sorted input and hunts otherwise;
+# either way the results are those of evaluating point by point
+def test_bulk_eval()
+  xa = GSL::Vector.alloc(50)
+  50.times { |i| xa[i] = i*i*0.01 }
+  ya = GSL::Sf::sin(xa)
+  sp = GSL::Spline.alloc(xa, ya)
+  rng = GSL::Rng.alloc
+  n = 2000
+  up = GSL::Vector.linspace(0, xa[49], n)
+  inputs = { "ascending" => up, "descending" => up.reverse,
+    "random" => GSL::Vector.alloc(n).collect { rng.uniform*xa[49] } }
+  inputs.each do |name, x|
+    y, dy, d2y = sp.eval_derivs(x)
+    s = 0
+    n.times do |i|
+      s += 1 if y[i] != sp.eval(x[i]) || dy[i] != sp.eval_deriv(x[i]) || d2y[i] != sp.eval_deriv2(x[i])
+    end
+    test(s, "spline eval_derivs, #{name} input")
+    s = (sp.eval(x) - y).abs.max == 0.0 ? 0 : 1
+    test(s, "spline eval, #{name} input")
+  end
 
+  out = GSL::Vector.alloc(n)
+  s = (sp.eval_deriv(up, out).object_id == out.object_id && out == sp.eval_deriv(up)) ? 0 : 1
+  test(s, "spline eval_deriv into a given vector")
+
+  interp = GSL::Interp.alloc("akima", 50)
+  interp.init(xa, ya)
+  y = interp.eval(xa, ya, up.reverse)
+  s = 0
+  n.times { |i| s += 1 if y[i] != interp.eval(xa, ya, up[n - 1 - i]) }
+  test(s, "interp eval, descending input")
+end
+
+# A frozen spline evaluated from several threads (and Ractors) at once,
+# with the per-thread accelerators or accelerators of their own
+def test_shared_spline()
+  xa = GSL::Vector.linspace(0, 10, 200)
+  sp = GSL::Spline.alloc(xa, GSL::Sf::sin(xa))
+  x = GSL::Vector.linspace(0, 10, 5000)
+  y = sp.eval(x)
+  sp.freeze
+  threads = 4.times.map do |t|
+    Thread.new do
+      acc = GSL::Interp::Accel.alloc
+      s = 0
+      x.size.times do |i|
+        j = t.even? ? i : x.size - 1 - i
+        s += 1 if sp.eval(x[j]) != y[j] || sp.eval(x[j], acc) != y[j]
+      end
+      s
+    end
+  end
+  test(threads.map(&:value).sum, "frozen spline shared by threads")
+  s = 0
+  begin
+    sp.init(xa, xa)
+  rescue FrozenError, RuntimeError
+    s = 1
+  end
+  test(s == 1 ? 0 : 1, "frozen spline cannot be initialized again")
+
+  if defined?(Ractor) && Ractor.respond_to?(:make_shareable)
+    Warning[:experimental] = false if Warning.respond_to?(:[]=)
+    Ractor.make_shareable(sp)
+    pts = [0.5, 2.5, 7.25, 9.5]
+    rs = pts.map { |u| Ractor.new(sp, u) { |spl, v| spl.eval(v) } }
+    test(rs.map(&:take) == pts.map { |u| sp.eval(u) } ? 0 : 1, "spline shared by Ractors")
+  end
+end
+
+# Two-dimensional interpolation: a bilinear surface is reproduced by both
+# types, and grid agrees with eval point by point
+def test_interp2d()
+  xa = GSL::Vector[0.0, 0.5, 1.5, 2.0, 3.0, 4.5]
+  ya = GSL::Vector[-1.0, 0.0, 0.25, 1.0, 2.0]
+  f = lambda { |x, y| 1.0 + 2.0*x - 3.0*y + 0.5*x*y }
+  z = GSL::Matrix.alloc(ya.size, xa.size)
+  ya.size.times { |j| xa.size.times { |i| z[j, i] = f.call(xa[i], ya[j]) } }
+  x = GSL::Vector.linspace(0, 4.5, 37)
+  y = GSL::Vector.linspace(-1, 2, 23)
+
+  ["bilinear", "bicubic"].each do |type|
+    sp = GSL::Spline2d.alloc(type, xa, ya, z)
+    test(sp.name == type ? 0 : 1, "spline2d #{type} name")
+    test_abs(sp.eval(1.2, 0.7), f.call(1.2, 0.7), 1e-12, "spline2d #{type} eval")
+    test_abs(sp.eval_deriv_x(1.2, 0.7), 2.0 + 0.5*0.7, 1e-12, "spline2d #{type} eval_deriv_x")
+    test_abs(sp.eval_deriv_y(1.2, 0.7), -3.0 + 0.5*1.2, 1e-12, "spline2d #{type} eval_deriv_y")
+    m = sp.grid(x, y)
+    test((m.size1 == y.size && m.size2 == x.size) ? 0 : 1, "spline2d #{type} grid shape")
+    s = 0
+    y.size.times do |j|
+      x.size.times { |i| s += 1 if m[j, i] != sp.eval(x[i], y[j]) }
+    end
+    test(s, "spline2d #{type} grid, against eval")
+    d = sp.grid(x.reverse, y, :deriv_xy)
+    s = 0
+    y.size.times do |j|
+      x.size.times { |i| s += 1 if d[j, i] != sp.eval_deriv_xy(x[x.size - 1 - i], y[j]) }
+    end
+    test(s, "spline2d #{type} grid deriv_xy, descending x")
+    u = GSL::Vector.linspace(-1, 2, x.size)
+    v = sp.eval(x, u)
+    s = 0
+    x.size.times { |i| s += 1 if v[i] != sp.eval(x[i], u[i]) }
+    test(s, "spline2d #{type} eval at vectors of points")
+
+    ip = GSL::Interp2d.alloc(type, xa.size, ya.size)
+    ip.init(xa, ya, z)
+    test((ip.grid(xa, ya, z, x, y) - m).abs.max == 0.0 ? 0 : 1, "interp2d #{type} grid")
+  end
+
+  s = 0
+  begin
+    GSL::Spline2d.alloc(xa, ya, z).grid(GSL::Vector[0.0, 5.0], y)
+  rescue GSL::ERROR::EDOM
+    s = 1
+  end
+  test(s == 1 ? 0 : 1, "spline2d grid outside the knots")
+end
+
+# Interpolation on a uniform grid: the same values as GSL::Interp, for
+# scalars, vectors and matrices of points, and the grid check of xa
+def test_uniform()
+test_spline_window()
+  n = 40
+  xa = GSL::Vector.linspace(-2.0, 5.8, n)
+  ya = xa.collect { |x| Math.sin(x) + 0.1*x*x }
+  x = GSL::Vector.linspace(-2.0, 5.8, 301)
+  ["linear", "cspline", "akima"].each do |type|
+    sp = GSL::Spline.alloc(type, xa, ya)
+    u = GSL::Interp::Uniform.alloc(type, -2.0, 0.2, ya)
+    test_rel(u[1.234], sp.eval(1.234), 1e-12, "uniform #{type} eval")
+    test_rel(u.eval_deriv(1.234), sp.eval_deriv(1.234), 1e-10, "uniform #{type} eval_deriv")
+    test_abs(u.eval_integ(-1.5, 4.1), sp.eval_integ(-1.5, 4.1), 1e-12, "uniform #{type} eval_integ")
+    test_abs((u.eval(x) - sp.eval(x)).abs.max, 0.0, 1e-12, "uniform #{type} eval at a vector")
+    test_abs((u.eval_deriv2(x) - sp.eval_deriv2(x)).abs.max, 0.0, 1e-8,
+             "uniform #{type} eval_deriv2 at a vector")
+    m = x.reshape(7, 43)
+    test_abs((u.eval(m) - sp.eval(m)).abs.max, 0.0, 1e-12, "uniform #{type} eval at a matrix")
+  end
+  u = GSL::Interp::Uniform.alloc("cspline", xa, ya)
+  test((u.size == n && u.name == "cspline") ? 0 : 1, "uniform size and name")
+  test_rel(u.dx, 0.2, 1e-14, "uniform dx from xa")
+  out = GSL::Vector.alloc(x.size)
+  u.eval(x, out)
+  test(out == u.eval(x) ? 0 : 1, "uniform eval into a vector")
+
+  s = 0
+  begin
+    GSL::Interp::Uniform.alloc("linear", GSL::Vector[0.0, 1.0, 2.5], GSL::Vector[1, 2, 3])
+  rescue ArgumentError
+    s = 1
+  end
+  test(s == 1 ? 0 : 1, "uniform with an uneven xa")
+  s = 0
+  begin
+    u.eval(GSL::Vector[0.0, 6.5])
+  rescue GSL::ERROR::EDOM
+    s = 1
+  end
+  test(s == 1 ? 0 : 1, "uniform eval outside the grid")
+end
+
+# A spline window fed point by point agrees with GSL::Spline built on the
+# points it holds, after the oldest have started to drop out
+def test_spline_window()
+  xs = (0...300).map { |i| 0.05*i + 0.02*Math.sin(i) }
+  ys = xs.map { |x| Math.sin(x) + 0.1*Math.cos(3*x) }
+  ["linear", "cspline", "akima"].each do |type|
+    w = GSL::Spline::Window.alloc(type, 120)
+    xs.each_with_index { |x, i| w.push(x, ys[i]) }
+    test((w.size == 120 && w.xmin == xs[180]) ? 0 : 1, "window #{type} keeps the last points")
+    sp = GSL::Spline.alloc(type, w.xa, w.ya)
+    x = GSL::Vector.linspace(w.xmin, w.xmax, 1001)
+    test_abs((w.eval(x) - sp.eval(x)).abs.max, 0.0, 1e-12, "window #{type} eval")
+    test_abs((w.eval_deriv(x) - sp.eval_deriv(x)).abs.max, 0.0, 1e-10, "window #{type} eval_deriv")
+    test_abs(w.eval_integ(10.0, 14.0), sp.eval_integ(10.0, 14.0), 1e-12, "window #{type} eval_integ")
+    v = GSL::Spline::Window.alloc(type, 120, xs[0, 250], ys[0, 250])
+    v.append(xs[250, 50], ys[250, 50])
+    test(v.xa == w.xa ? 0 : 1, "window #{type} append")
+    test_abs((v.eval(x) - w.eval(x)).abs.max, 0.0, 1e-13, "window #{type} append, eval")
+  end
+
+  w = GSL::Spline::Window.alloc("akima", 10)
+  s = 0
+  begin
+    w.push(1.0, 1.0)
+    w.push(1.0, 2.0)
+  rescue ArgumentError
+    s = 1
+  end
+  test(s == 1 ? 0 : 1, "window with a repeated x")
+  s = 0
+  begin
+    w.eval(1.0)
+  rescue GSL::ERROR::EINVAL
+    s = 1
+  end
+  test(s == 1 ? 0 : 1, "window below min_size")
+end
 
 test_bsearch()
+test_bulk_eval()
+test_shared_spline()
+test_interp2d() if defined?(GSL::Spline2d)
+test_uniform()
+test_spline_window()
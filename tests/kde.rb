@@ -0,0 +1,79 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+rng = GSL::Rng.alloc
+n = 2000
+x = GSL::Vector.alloc(n)
+n.times { |i| x[i] = i % 3 == 0 ? rng.gaussian(0.5) - 2.0 : rng.gaussian(1.0) + 1.0 }
+
+def direct(t, x, h)
+  s = 0.0
+  x.each { |v| s += Math::exp(-0.5*((t - v)/h)**2) }
+  s/(x.size*h*Math::sqrt(2*Math::PI))
+end
+
+# Binned estimate against the direct sum at every grid point
+grid, f = GSL::KDE.density(x, :n => 400, :bandwidth => 0.3)
+test_int(grid.size, 400, "KDE.density grid size")
+test_int(f.size, 400, "KDE.density density size")
+test_abs(grid[0], x.min - 0.9, 1e-12, "KDE.density range widened by :cut bandwidths")
+test_abs(grid[-1], x.max + 0.9, 1e-12, "KDE.density range widened by :cut bandwidths")
+err = 0.0
+grid.size.times { |i| err = [err, (f[i] - direct(grid[i], x, 0.3)).abs].max }
+test_abs(err, 0.0, 1e-4, "KDE.density against direct sums")
+test_abs(f.sum*(grid[1] - grid[0]), 1.0, 1e-6, "KDE.density integrates to 1")
+
+# Silverman's and Scott's rules
+s = x.to_a.sort
+iqr = s[(0.75*(n - 1)).round] - s[(0.25*(n - 1)).round]
+spread = [x.sd, iqr/1.34].min
+test_rel(GSL::KDE.bandwidth(x), 0.9*spread*n**-0.2, 1e-2, "KDE.bandwidth :silverman")
+test_rel(GSL::KDE.bandwidth(x, :scott), 1.06*spread*n**-0.2, 1e-2, "KDE.bandwidth :scott")
+
+# Weights of 2 are points counted twice
+y = GSL::Vector.alloc(200)
+y.size.times { |i| y[i] = rng.gaussian }
+w = GSL::Vector.alloc(200)
+w.size.times { |i| w[i] = i < 100 ? 2.0 : 1.0 }
+y2 = y.concat(y.subvector(0, 100))
+a = GSL::KDE.density(y, :weights => w, :bandwidth => 0.4, :range => [-3, 3], :n => 50)[1]
+b = GSL::KDE.density(y2, :bandwidth => 0.4, :range => [-3, 3], :n => 50)[1]
+test_abs((a - b).abs.max, 0.0, 1e-12, "KDE.density :weights")
+
+# A pre-filled histogram: the grid is its bin centres
+hist = GSL::Histogram.alloc(64, [-4.0, 4.0])
+hist.increment(x)
+grid, f = GSL::KDE.density(hist, :bandwidth => 0.3)
+test_int(grid.size, 64, "KDE.density(Histogram) grid size")
+test_abs(grid[0], -4.0 + 0.0625, 1e-12, "KDE.density(Histogram) bin centres")
+err = 0.0
+grid.size.times { |i| err = [err, (f[i] - direct(grid[i], x, 0.3)).abs].max }
+test_abs(err, 0.0, 1e-2, "KDE.density(Histogram) against direct sums")
+
+# 2-D, from x and y and from an n x 2 matrix
+m = GSL::Matrix.alloc(n, 2)
+n.times { |i| m[i, 0] = x[i]; m[i, 1] = 0.5*x[i] + rng.gaussian(0.5) }
+h2 = GSL::KDE.density2d(m, :n => [120, 90], :bandwidth => [0.3, 0.2],
+                        :range => [[-4, 4], [-3, 3]])
+test_int(h2.nx, 120, "KDE.density2d nx")
+test_int(h2.ny, 90, "KDE.density2d ny")
+h2b = GSL::KDE.density2d(m.col(0), m.col(1), :n => [120, 90], :bandwidth => [0.3, 0.2],
+                         :range => [[-4, 4], [-3, 3]])
+test_abs((h2.bin - h2b.bin).abs.max, 0.0, 0.0, "KDE.density2d(x, y) and (xy)")
+dx = 8.0/119
+dy = 6.0/89
+test_abs(h2.xrange[0], -4.0 - 0.5*dx, 1e-12, "KDE.density2d grid points at bin centres")
+err = 0.0
+[[20, 30], [60, 45], [90, 70]].each do |i, j|
+  u = -4.0 + i*dx
+  v = -3.0 + j*dy
+  sum = 0.0
+  n.times { |k| sum += Math::exp(-0.5*((u - m[k, 0])/0.3)**2 - 0.5*((v - m[k, 1])/0.2)**2) }
+  err = [err, (h2[i, j] - sum/(n*2*Math::PI*0.3*0.2)).abs].max
+end
+test_abs(err, 0.0, 2e-4, "KDE.density2d against direct sums")
+test_abs(h2.sum*dx*dy, 1.0, 1e-3, "KDE.density2d integrates to 1")
@@ -0,0 +1,65 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+n = 40
+x = GSL::Vector.alloc(n)
+n.times { |i| x[i] = Math::cos(0.2*i) + 1.0 }
+
+# Tridiagonal: general, symmetric and cyclic
+d = GSL::Vector.alloc(n); d.set_all(4.0)
+e = GSL::Vector.alloc(n - 1); e.set_all(-1.0)
+f = GSL::Vector.alloc(n - 1); f.set_all(-2.0)
+t = GSL::Matrix::Tridiag.new(d, e, f)
+test_abs(((t.to_m*x) - t*x).abs.max, 0.0, 1e-13, "Tridiag#*")
+test_abs((t.solve(t*x) - x).abs.max, 0.0, 1e-12, "Tridiag#solve")
+ts = GSL::Matrix::Tridiag.new(d, e)
+test(ts.symmetric? ? 0 : 1, "Tridiag.new(diag, offdiag) is symmetric")
+test_abs((ts.solve(ts*x) - x).abs.max, 0.0, 1e-12, "Tridiag#solve symmetric")
+ec = GSL::Vector.alloc(n); ec.set_all(-1.0)
+tc = GSL::Matrix::Tridiag.new(d, ec)
+test(tc.cyclic? ? 0 : 1, "Tridiag.new with n off-diagonal elements is cyclic")
+test_abs((tc.solve(tc.to_m*x) - x).abs.max, 0.0, 1e-12, "Tridiag#solve symmetric cyclic")
+test_abs((t.to_m.to_tridiag.to_m - t.to_m).abs.max, 0.0, 0.0, "Matrix#to_tridiag")
+
+# Banded
+a = GSL::Matrix::Band.alloc(n, 2, 3)
+n.times { |i|
+  ((i - 2)..(i + 3)).each { |j|
+    next if j < 0 or j >= n
+    a[i, j] = (i == j) ? 1.0 : 1.0/(1 + i + 2*j)
+  }
+}
+b = a*x
+test_abs((a.to_m*x - b).abs.max, 0.0, 1e-13, "Band#*")
+test_abs((a.solve(b) - x).abs.max, 0.0, 1e-12, "Band#solve")
+test_abs((a.to_m.to_band(2, 3).to_m - a.to_m).abs.max, 0.0, 0.0, "Matrix#to_band")
+
+s = GSL::Matrix::Band.alloc(n, 2, 2)
+n.times { |i|
+  ((i - 2)..(i + 2)).each { |j|
+    next if j < 0 or j >= n
+    s[i, j] = (i == j) ? 6.0 : -1.0
+  }
+}
+test_abs((s.cholesky_solve(s*x) - x).abs.max, 0.0, 1e-12, "Band#cholesky_solve")
+
+# Many right-hand sides at once
+rhs = GSL::Matrix.alloc(n, 5)
+5.times { |j| rhs.set_col(j, b*(j + 1)) }
+th = GSL.parallel_threshold
+[th, 1].each { |thr|
+  GSL.parallel_threshold = thr
+  lu = a.LU_decomp
+  xs = lu.solve(rhs)
+  err = 0.0
+  5.times { |j| err = [err, (xs.col(j) - x*(j + 1)).abs.max].max }
+  test_abs(err, 0.0, 1e-11, "Band::LU#solve(Matrix), threshold #{thr}")
+  tx = t.solve(rhs)
+  test_abs((tx.col(0) - t.solve(rhs.col(0))).abs.max, 0.0, 0.0,
+           "Tridiag#solve(Matrix), threshold #{thr}")
+}
+GSL.parallel_threshold = th
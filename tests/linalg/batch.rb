@@ -0,0 +1,41 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+rng = GSL::Rng.alloc
+[2, 3, 5, 6, 9].each { |n|
+  batch = 200
+  a = GSL::Matrix.alloc(batch*n, n)
+  s = GSL::Matrix.alloc(batch*n, n)
+  b = GSL::Matrix.alloc(batch, n)
+  systems = []
+  batch.times { |k|
+    m = GSL::Matrix.alloc(n, n)
+    n.times { |i| n.times { |j| m[i, j] = rng.uniform + (i == j ? n : 0) } }
+    spd = m*m.trans
+    n.times { |i| a.set_row(k*n + i, m.row(i)); s.set_row(k*n + i, spd.row(i)) }
+    systems << m
+    n.times { |i| b[k, i] = rng.uniform }
+  }
+  x = GSL::Linalg::Batch.solve(a, b)
+  xs = GSL::Linalg::Batch.cholesky_solve(s, b)
+  xa = GSL::Linalg::Batch.solve(systems, b)
+  d = GSL::Linalg::Batch.det(a)
+  err = errs = 0.0
+  batch.times { |k|
+    m = systems[k]
+    err = [err, (m*x.row(k).trans - b.row(k).trans).abs.max].max
+    spd = m*m.trans
+    errs = [errs, (spd*xs.row(k).trans - b.row(k).trans).abs.max].max
+  }
+  test_abs(err, 0.0, 1e-12, "Linalg::Batch.solve n = #{n}")
+  test_abs(errs, 0.0, 1e-11, "Linalg::Batch.cholesky_solve n = #{n}")
+  test_abs((xa - x).abs.max, 0.0, 0.0, "Linalg::Batch.solve with an Array n = #{n}")
+  test_abs(d[7], systems[7].det, 1e-10*d[7].abs, "Linalg::Batch.det n = #{n}")
+  xv = GSL::Linalg::Batch.solve(a, GSL::Vector.alloc(b.to_a.flatten))
+  test_abs((xv - GSL::Vector.alloc(x.to_a.flatten)).abs.max, 0.0, 0.0,
+           "Linalg::Batch.solve with a Vector n = #{n}")
+}
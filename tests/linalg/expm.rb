@@ -0,0 +1,50 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# Matrix#power by squaring against repeated products
+a = GSL::Matrix[[0.5, 0.2, -0.1], [0.3, 0.9, 0.0], [-0.4, 0.1, 0.7]]
+b = GSL::Matrix.identity(3)
+13.times { b = b*a }
+test_abs((a.power(13) - b).abs.max, 0.0, 1e-14, "GSL::Matrix#power")
+test_abs((a.power(0) - GSL::Matrix.identity(3)).abs.max, 0.0, 0.0, "GSL::Matrix#power(0)")
+mi = GSL::Matrix::Int[[1, 1], [1, 0]]
+test_int(mi.power(20)[0, 1], 6765, "GSL::Matrix::Int#power")
+
+# Rotations, nilpotent and diagonal matrices
+th = 0.7
+r = GSL::Matrix[[0, -th], [th, 0]].expm
+test_abs(r[0, 0], Math.cos(th), 1e-15, "GSL::Matrix#expm rotation")
+test_abs(r[1, 0], Math.sin(th), 1e-15, "GSL::Matrix#expm rotation")
+n3 = GSL::Matrix[[0, 1, 0], [0, 0, 1], [0, 0, 0]]
+test_abs(n3.expm(2.0)[0, 2], 2.0, 1e-15, "GSL::Matrix#expm nilpotent")
+d = GSL::Matrix[[1, 0, 0], [0, -2, 0], [0, 0, 30]]
+e = GSL::Linalg.expm(d)
+test_rel(e[2, 2], Math.exp(30), 1e-14, "GSL::Linalg.expm diagonal")
+test_rel(e[1, 1], Math.exp(-2), 1e-14, "GSL::Linalg.expm diagonal")
+
+# exp(A) exp(-A) = I, and exp(A t) v against expm
+n = 30
+g = GSL::Matrix.alloc(n, n)
+n.times { |i| n.times { |j| g[i, j] = Math.sin(i + 2.0*j) } }
+err = (g.expm*g.expm(-1.0) - GSL::Matrix.identity(n)).abs.max
+test_abs(err, 0.0, 1e-9, "GSL::Matrix#expm inverse")
+v = GSL::Vector.alloc(n)
+n.times { |i| v[i] = 1.0/(i + 1) }
+w = g.expmv(v, 0.5)
+test_abs((w - g.expm(0.5)*v).abs.max/w.abs.max, 0.0, 1e-11, "GSL::Matrix#expmv")
+
+exit unless defined?(GSL::SpMatrix)
+# A sparse generator: the 1-D Laplacian
+n = 200
+l = GSL::Matrix.calloc(n, n)
+n.times { |i| l[i, i] = -2.0; l[i, i - 1] = l[i - 1, i] = 1.0 if i > 0 }
+v = GSL::Vector.alloc(n)
+n.times { |i| v[i] = Math.exp(-0.01*(i - 100)**2) }
+ws = GSL::Linalg.expmv(l.to_sp.to_csr, v, 10.0)
+wd = GSL::Linalg.expmv(l, v, 10.0)
+test_abs((ws - wd).abs.max, 0.0, 1e-13, "GSL::Linalg.expmv(SpMatrix)")
+test_abs((wd - l.expm(10.0)*v).abs.max, 0.0, 1e-11, "GSL::Linalg.expmv against expm")
@@ -0,0 +1,94 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+n = 30
+a = GSL::Matrix.alloc(n, n)
+n.times { |i| n.times { |j| a[i, j] = 1.0/(i + j + 1) + (i == j ? n : 0) } }
+x = GSL::Vector.alloc(n)
+n.times { |i| x[i] = Math::sin(0.3*i) }
+b = a*x.col
+bm = GSL::Matrix.alloc(n, 5)
+5.times { |j| bm.set_col(j, a*(x*(j + 1)).col) }
+
+# LU
+a0 = a.clone
+lu = GSL::Linalg::LU::Factorization.new(a)
+test_abs((a - a0).abs.max, 0.0, 0.0, "LU::Factorization.new does not modify the matrix")
+test_abs((lu.solve(b) - x.col).abs.max, 0.0, 1e-12, "LU::Factorization#solve")
+y = GSL::Vector.alloc(n)
+test(lu.solve(b, y).equal?(y) ? 0 : 1, "LU::Factorization#solve(b, x) returns x")
+test_abs((y - x).abs.max, 0.0, 1e-12, "LU::Factorization#solve(b, x)")
+xm = lu.solve(bm)
+test_abs((xm.col(4) - x*5).abs.max, 0.0, 1e-11, "LU::Factorization#solve(Matrix)")
+lu.refine(a, b, y)
+test_abs((y - x).abs.max, 0.0, 1e-12, "LU::Factorization#refine")
+test_abs(lu.det, a.det, 1e-12*lu.det.abs, "LU::Factorization#det")
+test_abs((lu.invert*a - GSL::Matrix.identity(n)).abs.max, 0.0, 1e-12,
+         "LU::Factorization#invert")
+
+# QR, square and least squares
+qr = GSL::Linalg::QR::Factorization.new(a)
+test_abs((qr.solve(b) - x.col).abs.max, 0.0, 1e-12, "QR::Factorization#solve")
+test_abs((qr.solve(bm).col(2) - x*3).abs.max, 0.0, 1e-11, "QR::Factorization#solve(Matrix)")
+r = GSL::Matrix.alloc(n + 10, n)
+(n + 10).times { |i| n.times { |j| r[i, j] = Math::cos(i*j + 0.5*i) } }
+qr = GSL::Linalg::QR::Factorization.new(r)
+br = r*x.col
+test_abs((qr.lssolve(br) - x.col).abs.max, 0.0, 1e-10, "QR::Factorization#lssolve")
+test_abs(qr.residual.abs.max, 0.0, 1e-10, "QR::Factorization#residual")
+test_abs((qr.lssolve(r*(x*2).col) - x.col*2).abs.max, 0.0, 1e-10,
+         "QR::Factorization#lssolve again")
+
+# Cholesky
+ch = GSL::Linalg::Cholesky::Factorization.new(a)
+test_abs((ch.solve(b) - x.col).abs.max, 0.0, 1e-12, "Cholesky::Factorization#solve")
+test_abs((ch.solve(bm).col(1) - x*2).abs.max, 0.0, 1e-11,
+         "Cholesky::Factorization#solve(Matrix)")
+test_abs(ch.lndet, lu.lndet, 1e-10, "Cholesky::Factorization#lndet")
+
+# Cholesky rank-1 update and downdate
+v = GSL::Vector.alloc(n)
+n.times { |i| v[i] = Math::cos(0.7*i) }
+ch = GSL::Linalg::Cholesky::Factorization.new(a)
+ch.update!(v)
+av = a + v.col*v
+test_abs((ch.solve(av*x.col) - x.col).abs.max, 0.0, 1e-11, "Cholesky::Factorization#update!")
+ch.downdate!(v)
+test_abs((ch.LLT.lower - GSL::Linalg::Cholesky::Factorization.new(a).LLT.lower).abs.max,
+         0.0, 1e-12, "Cholesky::Factorization#downdate!")
+begin
+  ch.downdate!(v*100)
+  test(1, "Cholesky::Factorization#downdate! of an indefinite result raises")
+rescue
+  test(0, "Cholesky::Factorization#downdate! of an indefinite result raises")
+end
+test_abs((ch.solve(b) - x.col).abs.max, 0.0, 1e-11,
+         "Cholesky::Factorization is unchanged by a failed downdate!")
+
+# Incremental QR: streaming least squares
+inc = GSL::Linalg::QR::Incremental.new(n)
+inc.add_rows(r, br)
+test_abs((inc.solve - x.col).abs.max, 0.0, 1e-10, "QR::Incremental#add_rows, #solve")
+extra = GSL::Vector.alloc(n); extra.set_all(1.0)
+inc.add_row(extra, 5.0)
+inc.delete_row(extra, 5.0)
+test(inc.nrows == n + 10 ? 0 : 1, "QR::Incremental#nrows")
+test_abs((inc.solve - x.col).abs.max, 0.0, 1e-9, "QR::Incremental#delete_row")
+test_abs(inc.rss, 0.0, 1e-12, "QR::Incremental#rss")
+
+# Mixed precision LU with iterative refinement
+mx = GSL::Linalg::LU::Factorization.new(a, :precision => :mixed)
+test(mx.precision == :mixed ? 0 : 1, "LU::Factorization#precision")
+test_abs((mx.solve(b) - x.col).abs.max, 0.0, 1e-12, "LU::Factorization mixed solve")
+test(mx.refine_iter > 0 ? 0 : 1, "LU::Factorization#refine_iter")
+test_abs(mx.det, a.det, 1e-4*a.det.abs, "LU::Factorization mixed det")
+test_abs((mx.invert*a - GSL::Matrix.identity(n)).abs.max, 0.0, 1e-12,
+         "LU::Factorization mixed invert")
+mx = GSL::Linalg::LU::Factorization.new(a, :precision => :mixed, :max_refine => 0)
+test_abs((mx.solve(b) - x.col).abs.max, 0.0, 1e-12,
+         "LU::Factorization mixed solve falls back to double")
+test(mx.precision == :double ? 0 : 1, "LU::Factorization#precision after fallback")
@@ -0,0 +1,51 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+n = 100
+a = GSL::Matrix.calloc(n, n)
+n.times { |i|
+  a[i, i] = 2.5 + 0.1*(i % 7)
+  a[i, i + 1] = a[i + 1, i] = -1.0 if i + 1 < n
+  a[i, i + 5] = a[i + 5, i] = -0.2 if i + 5 < n
+}
+xt = GSL::Vector.alloc(n)
+n.times { |i| xt[i] = Math::sin(0.1*i) }
+b = a*xt
+
+It = GSL::Linalg::Iterative
+[It::CG, It::BiCGSTAB, It::GMRES].each { |klass|
+  [nil, :jacobi].each { |pc|
+    s = klass.new(a, :tol => 1e-12, :precond => pc, :history => true)
+    x = s.solve(b)
+    test(s.converged? ? 0 : 1, "#{klass}.new(Matrix, :precond => #{pc.inspect}) converges")
+    test_abs((x - xt).abs.max, 0.0, 1e-9, "#{klass}#solve with #{pc.inspect}")
+    test(s.history.size == s.iter + 1 ? 0 : 1, "#{klass}#history")
+    s.solve!(b, x)
+    test(s.iter <= 1 ? 0 : 1, "#{klass}#solve! warm started from the solution")
+  }
+}
+
+# a callable operator, taking x or (x, y)
+op1 = Proc.new { |x| a*x }
+op2 = Proc.new { |x, y| y.set(a*x) }
+x, iter, normr = It.cg(op1, b, :tol => 1e-12)
+test_abs((x - xt).abs.max, 0.0, 1e-9, "Iterative.cg with a Proc")
+x, iter, normr = It.bicgstab(op2, b, :tol => 1e-12, :precond => :jacobi, :diag => a.diagonal)
+test_abs((x - xt).abs.max, 0.0, 1e-9, "Iterative.bicgstab with a Proc(x, y) and :diag")
+pc = Proc.new { |r| r/a.diagonal }
+x, iter, normr = It.gmres(a, b, :tol => 1e-12, :precond => pc, :restart => 10)
+test_abs((x - xt).abs.max, 0.0, 1e-9, "Iterative.gmres with a Proc preconditioner")
+
+exit unless defined?(GSL::SpMatrix)
+sp = a.to_sp.to_csc
+[:cg, :bicgstab, :gmres].each { |m|
+  x, it0, normr = It.send(m, sp, b, :tol => 1e-12)
+  test_abs((x - xt).abs.max, 0.0, 1e-9, "Iterative.#{m}(SpMatrix)")
+  x, it1, normr = It.send(m, sp, b, :tol => 1e-12, :precond => :ilu0)
+  test_abs((x - xt).abs.max, 0.0, 1e-9, "Iterative.#{m}(SpMatrix, :precond => :ilu0)")
+  test(it1 < it0 ? 0 : 1, "Iterative.#{m} ILU0 needs fewer iterations")
+}
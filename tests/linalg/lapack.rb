@@ -0,0 +1,36 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+exit unless GSL::Linalg.engine == :lapack
+
+n = 40
+a = GSL::Matrix.alloc(n, n)
+n.times { |i| n.times { |j| a[i, j] = Math.sin(i + 2*j + 1) } }
+s = a*a.trans + GSL::Matrix.identity(n)*n
+
+def with_engine(e)
+  GSL::Linalg.engine = e
+  yield
+ensure
+  GSL::Linalg.engine = :lapack
+end
+
+lu, perm, sign = a.LU_decomp
+glu, gperm, gsign = with_engine(:gsl) { a.LU_decomp }
+test2(perm == gperm && sign == gsign, "GSL::Linalg.engine :lapack LU_decomp permutation")
+test_abs((lu - glu).abs.max, 0.0, 1e-10, "GSL::Linalg.engine :lapack LU_decomp")
+
+qr, tau = a.QR_decomp
+gqr, gtau = with_engine(:gsl) { a.QR_decomp }
+test_abs((qr - gqr).abs.max + (tau - gtau).abs.max, 0.0, 1e-10, "GSL::Linalg.engine :lapack QR_decomp")
+
+c = GSL::Linalg::Cholesky.decomp(s)
+gc = with_engine(:gsl) { GSL::Linalg::Cholesky.decomp(s) }
+test_abs((c - gc).abs.max, 0.0, 1e-10, "GSL::Linalg.engine :lapack Cholesky.decomp")
+
+eval, evec = GSL::Eigen.symmv(s)
+test_abs((s*evec - evec*eval.to_m_diagonal).abs.max, 0.0, 1e-9, "GSL::Linalg.engine :lapack Eigen.symmv")
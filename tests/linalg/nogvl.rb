@@ -0,0 +1,34 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::Rng.env_setup()
+r = GSL::Rng.alloc()
+n = 100
+m = GSL::Matrix.alloc(n, n)
+n.times { |i| n.times { |j| m[i,j] = r.uniform } }
+a = m*m.trans + GSL::Matrix.identity(n)*n
+
+threshold = GSL.nogvl_threshold
+GSL.nogvl_threshold = 0
+lu0, perm0, sign0 = a.LU_decomp
+eval0 = GSL::Eigen.symm(a)
+GSL.nogvl_threshold = 1
+lu1, perm1, sign1 = a.LU_decomp
+eval1 = GSL::Eigen.symm(a)
+test2(lu0 == lu1, "LU_decomp without GVL")
+test2(eval0 == eval1, "Eigen.symm without GVL")
+
+threads = (0...4).collect { Thread.new { a.cholesky_decomp } }
+c = threads.collect { |t| t.value }
+test2(c.all? { |x| x == c[0] }, "cholesky_decomp from concurrent threads")
+
+singular = GSL::Matrix.alloc(n, n)
+begin
+  singular.cholesky_decomp
+  test2(false, "cholesky_decomp error raised after reacquiring the GVL")
+rescue GSL::ERROR::EDOM
+  test2(true, "cholesky_decomp error raised after reacquiring the GVL")
+end
+GSL.nogvl_threshold = threshold
@@ -0,0 +1,31 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+m, n = 300, 80
+a = GSL::Matrix.alloc(m, n)
+m.times { |i| n.times { |j| a[i, j] = Math.sin(0.01*(i + 1)*(j + 1)) + 0.5**((i + 2*j) % 17) } }
+u0, v0, s0 = a.SV_decomp
+
+k = 6
+u, v, s = GSL::Linalg::SV.randomized(a, k, :power => 3)
+test_int(u.size1*100 + u.size2, m*100 + k, "GSL::Linalg::SV.randomized U shape")
+test_int(v.size1*100 + v.size2, n*100 + k, "GSL::Linalg::SV.randomized V shape")
+k.times { |i|
+  test_rel(s[i], s0[i], 1e-8, "GSL::Linalg::SV.randomized singular value #{i}")
+  test_abs((a*v.col(i) - u.col(i)*s[i]).nrm2, 0.0, 1e-6*s0[0], "GSL::Linalg::SV.randomized triplet #{i}")
+}
+test_abs((u.trans*u - GSL::Matrix.identity(k)).abs.max, 0.0, 1e-12, "GSL::Linalg::SV.randomized U orthonormal")
+
+u2, v2, s2 = GSL::Linalg::SV.randomized(a.trans, k, :power => 3, :seed => 7)
+test_rel(s2[0], s0[0], 1e-8, "GSL::Linalg::SV.randomized wide matrix")
+
+exit unless defined?(GSL::SpMatrix)
+d = GSL::Matrix.calloc(m, n)
+m.times { |i| n.times { |j| d[i, j] = a[i, j] if (i + j) % 3 == 0 } }
+ud, vd, sd = GSL::Linalg::SV.randomized(d, 3, :power => 4)
+us, vs, ss = GSL::Linalg::SV.randomized(d.to_sp.to_csc, 3, :power => 4)
+3.times { |i| test_rel(ss[i], sd[i], 1e-10, "GSL::Linalg::SV.randomized(SpMatrix) #{i}") }
@@ -0,0 +1,49 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("tempfile")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+def text_file(s)
+  f = Tempfile.new(["loadtxt", ".txt"])
+  f.write(s)
+  f.close
+  f
+end
+
+f = text_file("# comment\n1 2 3\n  4\t5   6  \n\n7,8,9 # tail\n")
+m = GSL::Matrix.loadtxt(f.path)
+test2(m == GSL::Matrix[[1, 2, 3], [4, 5, 6], [7, 8, 9]], "GSL::Matrix.loadtxt blanks, commas and comments")
+v = GSL::Vector.filescan(f.path)
+test2(v.size == 3 && v[2].to_a == [3, 6, 9], "GSL::Vector.filescan")
+
+f = text_file("x,y,z\r\n1.5,-2e3,\r\n,3,4")
+m = GSL::Matrix.loadtxt(f.path, :delimiter => ",", :header => true)
+test2(m[0, 0] == 1.5 && m[0, 1] == -2000 && m[0, 2].nan? && m[1, 0].nan? && m[1, 2] == 4,
+      "GSL::Matrix.loadtxt CSV with header, CRLF and empty fields")
+c = GSL::Vector.loadtxt(f.path, :delimiter => ",", :header => 1, :columns => [-1, 0])
+test2(c.size == 2 && c[0][0].nan? && c[0][1] == 4 && c[1].to_a[0] == 1.5,
+      "GSL::Vector.loadtxt selects columns")
+
+f = text_file("0.1 1e23 123456789012345678901234567890 -0.0 inf nan\n")
+m = GSL::Matrix.loadtxt(f.path)
+test2(m[0, 0] == 0.1 && m[0, 1] == 1e23 && m[0, 2] == 123456789012345678901234567890.0 &&
+      1 / m[0, 3] < 0 && m[0, 4] == GSL::POSINF && m[0, 5].nan?,
+      "GSL::Matrix.loadtxt parses correctly rounded doubles")
+
+srand(1)
+rows = Array.new(20000) { Array.new(3) { rand * 10**rand(-20..20) } }
+f = text_file(rows.map { |r| r.map { |x| "%.17g" % x }.join(" ") }.join("\n") + "\n")
+test2(GSL::Matrix.loadtxt(f.path).to_a == rows, "GSL::Matrix.loadtxt large file")
+
+[["1 2\n3\n", /:2: 1 fields \(2 expected\)/], ["1 2\n3 x\n", /:2: not a number/]].each do |s, re|
+  f = text_file(s)
+  begin
+    GSL::Matrix.loadtxt(f.path)
+    test2(false, "GSL::Matrix.loadtxt #{re.source}")
+  rescue ArgumentError => e
+    test2(e.message =~ re, "GSL::Matrix.loadtxt #{re.source}")
+  end
+end
@@ -0,0 +1,53 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+v = GSL::Vector[1.5, -2, 3, 1e300, 7]
+w = Marshal.load(Marshal.dump(v))
+test2(w.class == GSL::Vector && w == v, "GSL::Vector Marshal round trip")
+s = v.subvector_with_stride(0, 2, 3)
+w = Marshal.load(Marshal.dump(s))
+test2(w.class == GSL::Vector && w.to_a == [1.5, 3, 7], "GSL::Vector::View Marshal compacts the stride")
+w = Marshal.load(Marshal.dump(v.col))
+test2(w.class == GSL::Vector::Col && w.to_a == v.to_a, "GSL::Vector::Col Marshal round trip")
+
+vi = GSL::Vector::Int[1, -7, 2**31 - 1]
+test2(Marshal.load(Marshal.dump(vi)) == vi, "GSL::Vector::Int Marshal round trip")
+z = GSL::Vector::Complex[[1, 2], [3, -4]]
+w = Marshal.load(Marshal.dump(z))
+test2(w[1].re == 3 && w[1].im == -4, "GSL::Vector::Complex Marshal round trip")
+
+m = GSL::Matrix[[1, 2, 3], [4, 5, 6], [7, 8, 9]]
+w = Marshal.load(Marshal.dump(m.submatrix(1, 1, 2, 2)))
+test2(w.class == GSL::Matrix && w == GSL::Matrix[[5, 6], [8, 9]], "GSL::Matrix::View Marshal compacts the rows")
+mi = GSL::Matrix::Int[[1, -2], [3, 4]]
+test2(Marshal.load(Marshal.dump(mi)) == mi, "GSL::Matrix::Int Marshal round trip")
+mz = GSL::Matrix::Complex.alloc(2, 2)
+mz[0, 1] = GSL::Complex[1, -1]
+test2(Marshal.load(Marshal.dump(mz))[0, 1].im == -1, "GSL::Matrix::Complex Marshal round trip")
+
+h = GSL::Histogram.alloc(4, [0, 4])
+h.increment(1.5)
+h.increment(3.2, 2.0)
+w = Marshal.load(Marshal.dump(h))
+test2(w.range == h.range && w.bin == h.bin, "GSL::Histogram Marshal round trip")
+
+p = GSL::Permutation.alloc(4)
+p.reverse
+test2(Marshal.load(Marshal.dump(p)).to_a == p.to_a, "GSL::Permutation Marshal round trip")
+
+begin
+  GSL::Matrix._load(v._dump(-1))
+  test2(false, "GSL::Matrix._load of a vector dump")
+rescue TypeError
+  test2(true, "GSL::Matrix._load of a vector dump")
+end
+begin
+  GSL::Vector._load(v._dump(-1)[0..-2])
+  test2(false, "GSL::Vector._load of a truncated dump")
+rescue ArgumentError
+  test2(true, "GSL::Vector._load of a truncated dump")
+end
@@ -0,0 +1,74 @@
+#!/usr/bin/env ruby
+
+require("gsl")
+require("test/unit")
+
+class MatrixLazyTest < Test::Unit::TestCase
+	def setup
+		rng = GSL::Rng.alloc
+		@a = GSL::Matrix.alloc(30, 5)
+		@b = GSL::Matrix.alloc(5, 40)
+		@c = GSL::Matrix.alloc(40, 6)
+		[@a, @b, @c].each { |m| m.size1.times { |i| m.size2.times { |j| m[i, j] = rng.uniform - 0.5 } } }
+		@v = GSL::Vector.linspace(-1.0, 1.0, 6)
+	end
+
+	def assert_matrix_close(expected, actual)
+		assert_equal(expected.size1, actual.size1)
+		assert_equal(expected.size2, actual.size2)
+		assert((expected - actual).abs.max < 1e-12)
+	end
+
+	def test_chain_order
+		pr = @a.lazy*@b*@c*@v
+		assert_kind_of(GSL::Matrix::Lazy, pr)
+		assert_equal(4, pr.size)
+		assert_equal([30, 1], pr.shape)
+		assert_equal([0, [1, [2, 3]]], pr.order)
+		assert_equal([0, [1, 2]], (@a.lazy*@b*@c).order)
+	end
+
+	def test_chain_eval
+		expected = @a*@b*@c
+		assert_matrix_close(expected, (@a.lazy*@b*@c).eval)
+		x = (@a.lazy*@b*@c*@v).eval
+		assert_kind_of(GSL::Vector, x)
+		assert((x - GSL::Blas.dgemv(GSL::Blas::NoTrans, 1.0, expected, @v)).abs.max < 1e-12)
+	end
+
+	def test_transposed_factors
+		assert_matrix_close(@a.trans*@a, (@a.lazy.t*@a).eval)
+		assert_matrix_close(@a*@a.trans, (@a*@a.lazy.t).eval)
+		assert_matrix_close((@a*@b).trans, (@a.lazy*@b).t.eval)
+		assert_matrix_close(@a.trans, @a.lazy.t.to_m)
+	end
+
+	def test_eval_into_operand
+		s = GSL::Matrix.alloc(6, 6)
+		s2 = GSL::Matrix.alloc(6, 6)
+		36.times { |k| s[k/6, k%6] = Math.sin(k); s2[k/6, k%6] = Math.cos(k) }
+		expected = s*s2*s
+		(s.lazy*s2*s).eval(s)
+		assert_matrix_close(expected, s)
+	end
+
+	def test_transpose_views
+		assert_kind_of(GSL::Matrix::Lazy, @a.t)
+		assert_matrix_close(@a.trans*@a, GSL::Blas.dgemm(@a.t, @a))
+		assert_matrix_close(@a*@a.trans, GSL::Blas.dgemm(GSL::Blas::NoTrans, GSL::Blas::NoTrans, 1.0, @a, @a.t))
+		assert_matrix_close(@a, GSL::Blas.dgemm(GSL::Blas::Trans, GSL::Blas::NoTrans, 1.0, @a.t, GSL::Matrix.identity(5)))
+		assert_matrix_close(@b.trans*@a.trans, GSL::Blas.dgemm(@b.t, @a.t))
+		w = GSL::Vector.linspace(0.0, 1.0, 30)
+		x = GSL::Blas.dgemv(GSL::Blas::NoTrans, 1.0, @a.t, w)
+		assert_equal(5, x.size)
+		assert((x - @a.trans*w).abs.max < 1e-12)
+		assert((x - (@a.t*w).eval).abs.max < 1e-12)
+		assert_raise(TypeError) { GSL::Blas.dgemm(@a.lazy*@b, @c) }
+	end
+
+	def test_size_mismatch
+		assert_raise(RangeError) { @a.lazy*@c }
+		assert_raise(TypeError) { (@a.lazy*@b*@c*@v).t }
+		assert_raise(RangeError) { (@a.lazy*@b).eval(GSL::Matrix.alloc(3, 3)) }
+	end
+end
@@ -36,4 +36,48 @@ class MatrixNmfTest < Test::Unit::TestCase
       assert(cost <= 0.000001, "Cols: #{cols}, Delta: #{cost}")
     end
   end
+
+  def test_nmf_methods
+    [:mu, :hals].each do |method|
+      w, h = @m1.nmf(2, :method => method, :seed => 1)
+      cost = GSL::Matrix::NMF.difcost(@m1, w*h)
+      assert(cost <= 0.000001, "#{method}: #{cost}")
+      assert(w.min >= 0 && h.min >= 0, "#{method}: non-negative")
+    end
+  end
+
+  def test_solver
+    a = GSL::Matrix.alloc(30, 4)
+    b = GSL::Matrix.alloc(4, 20)
+    r = GSL::Rng.alloc
+    a.collect! { r.uniform }
+    b.collect! { r.uniform }
+    v = a*b
+    [:mu, :hals, :als].each do |method|
+      s = GSL::Matrix::NMF::Solver.new(v, 4, :method => method, :history => true,
+                                       :tol => 0, :cost => 0, :max_iter => 50)
+      costs = []
+      status = s.solve { |iter, cost| costs << cost }
+      assert_equal(GSL::EMAXITER, status)
+      assert_equal(50, costs.size)
+      assert_equal(costs, s.history.to_a)
+      assert_in_delta(GSL::Matrix::NMF.difcost(v, s.w*s.h), s.cost, 1e-9*v.norm**2)
+      assert(costs.last < costs.first, "#{method} decreases the cost")
+      assert_equal(method.to_s, s.name)
+    end
+    s = GSL::Matrix::NMF::Solver.new(v, 4)
+    assert_equal(GSL::CONTINUE, s.solve { |iter, cost| iter < 3 })
+    assert_equal(3, s.iter)
+  end
+
+  def test_sparse
+    return unless defined?(GSL::SpMatrix)
+    v = GSL::Matrix.alloc([1, 0, 2, 0], [0, 3, 0, 1], [2, 0, 4, 0])
+    dense = GSL::Matrix::NMF::Solver.new(v, 2, :seed => 3, :max_iter => 20, :tol => 0)
+    sparse = GSL::Matrix::NMF::Solver.new(v.to_sp, 2, :seed => 3, :max_iter => 20, :tol => 0)
+    dense.solve
+    sparse.solve
+    assert_in_delta(dense.cost, sparse.cost, 1e-10)
+    assert_in_delta(0, (dense.w - sparse.w).abs.max, 1e-10)
+  end
 end
@@ -0,0 +1,72 @@
+#!/usr/bin/env ruby
+
+require("gsl")
+require("test/unit")
+
+class MatrixPermuteTest < Test::Unit::TestCase
+	def setup
+		@m = GSL::Matrix.alloc(7, 5)
+		7.times { |i| 5.times { |j| @m[i, j] = 10*i + j } }
+		@p = GSL::Permutation.alloc(7)
+		[3, 0, 6, 1, 5, 2, 4].each_with_index { |v, i| @p[i] = v }
+		@q = GSL::Permutation.alloc(5)
+		[4, 2, 0, 1, 3].each_with_index { |v, i| @q[i] = v }
+	end
+
+	def test_rows
+		m = @m.clone
+		assert_equal(m, m.permute_rows!(@p))
+		7.times { |i| 5.times { |j| assert_equal(@m[@p[i], j], m[i, j]) } }
+		m.permute_rows_inverse!(@p)
+		assert_equal(@m, m)
+	end
+
+	def test_columns
+		m = @m.clone
+		m.permute_columns!(@q)
+		7.times { |i| 5.times { |j| assert_equal(@m[i, @q[j]], m[i, j]) } }
+		m.permute_columns_inverse!(@q)
+		assert_equal(@m, m)
+	end
+
+	def test_matches_permute_vector
+		m = @m.clone
+		m.permute_columns!(@q)
+		v = @m.row(2).clone
+		@q.permute(v)
+		assert_equal(v, m.row(2))
+	end
+
+	def test_int_and_complex
+		mi = GSL::Matrix::Int.alloc(7, 2)
+		7.times { |i| mi[i, 0] = i; mi[i, 1] = -i }
+		mi.permute_rows!(@p)
+		7.times { |i| assert_equal(@p[i], mi[i, 0]); assert_equal(-@p[i], mi[i, 1]) }
+		mc = GSL::Matrix::Complex.alloc(7, 1)
+		7.times { |i| mc.set(i, 0, GSL::Complex.alloc(i, -i)) }
+		mc.permute_rows!(@p)
+		7.times { |i| assert_equal(-@p[i], mc[i, 0].im) }
+	end
+
+	def test_size_check
+		assert_raise(RangeError) { @m.clone.permute_columns!(@p) }
+	end
+
+	def test_gather_scatter
+		m = @p.gather(@m)
+		n = @m.clone.permute_rows!(@p)
+		assert_equal(n, m)
+		assert_equal(@m, @p.scatter(m))
+		cols = Array.new(5) { |j| @m.col(j) }
+		vi = GSL::Vector::Int.alloc(7)
+		7.times { |i| vi[i] = 3*i }
+		out = @p.gather(cols + [vi])
+		5.times { |j| assert_equal(n.col(j).to_a, out[j].to_a) }
+		7.times { |i| assert_equal(3*@p[i], out[5][i]) }
+		v = GSL::Vector.alloc(7)
+		assert_equal(v, @p.scatter(out[0], v))
+		assert_equal(@m.col(0).to_a, v.to_a)
+		assert_raise(RangeError) { @q.gather(@m) }
+		assert_raise(ArgumentError) { @p.gather(v, v) }
+	end
+end
@@ -1,48 +1,227 @@
-#!/usr/bin/enm ruby
-
-require("gsl")
-require("test/unit")
-
-class MatrixTest < Test::Unit::TestCase
-
-	def test_matrix_ispos_neg
-		m = GSL::Matrix::Int.alloc([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], 3, 3)
-		assert_equal(m.ispos, 0)
-		assert_equal(m.ispos?, false)		
-		assert_equal(m.isneg, 0)
-		assert_equal(m.isneg?, false)
-		
-		m += 1
-		assert_equal(m.ispos, 1)
-		assert_equal(m.ispos?, true)		
-		assert_equal(m.isneg, 0)
-		assert_equal(m.isneg?, false)		
-		
-		m -= 100
-		assert_equal(m.ispos, 0)
-		assert_equal(m.ispos?, false)		
-		assert_equal(m.isneg, 1)
-		assert_equal(m.isneg?, true)				
-	end
-		
-	def test_matrix_isnonneg
-		m = GSL::Matrix::Int.alloc([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], 3, 3)
-		assert_equal(m.isnonneg, 1)
-		assert_equal(m.isnonneg?, true)		
-		assert_equal(m.isneg, 0)
-		assert_equal(m.isneg?, false)
-		
-		m -= 100
-		assert_equal(m.isnonneg, 0)
-		assert_equal(m.isnonneg?, false)		
-		assert_equal(m.isneg, 1)
-		assert_equal(m.isneg?, true)		
-		
-		m += 200
-		assert_equal(m.isnonneg, 1)
-		assert_equal(m.isnonneg?, true)		
-		assert_equal(m.ispos, 1)
-		assert_equal(m.ispos?, true)				
-	end
-end
-
+#!/usr/bin/enm ruby
+
+require("gsl")
+require("test/unit")
+
+class MatrixTest < Test::Unit::TestCase
+
+	def test_matrix_ispos_neg
+		m = GSL::Matrix::Int.alloc([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], 3, 3)
+		assert_equal(m.ispos, 0)
+		assert_equal(m.ispos?, false)		
+		assert_equal(m.isneg, 0)
+		assert_equal(m.isneg?, false)
+		
+		m += 1
+		assert_equal(m.ispos, 1)
+		assert_equal(m.ispos?, true)		
+		assert_equal(m.isneg, 0)
+		assert_equal(m.isneg?, false)		
+		
+		m -= 100
+		assert_equal(m.ispos, 0)
+		assert_equal(m.ispos?, false)		
+		assert_equal(m.isneg, 1)
+		assert_equal(m.isneg?, true)				
+	end
+		
+	def test_matrix_isnonneg
+		m = GSL::Matrix::Int.alloc([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], 3, 3)
+		assert_equal(m.isnonneg, 1)
+		assert_equal(m.isnonneg?, true)		
+		assert_equal(m.isneg, 0)
+		assert_equal(m.isneg?, false)
+		
+		m -= 100
+		assert_equal(m.isnonneg, 0)
+		assert_equal(m.isnonneg?, false)		
+		assert_equal(m.isneg, 1)
+		assert_equal(m.isneg?, true)		
+		
+		m += 200
+		assert_equal(m.isnonneg, 1)
+		assert_equal(m.isnonneg?, true)		
+		assert_equal(m.ispos, 1)
+		assert_equal(m.ispos?, true)				
+	end
+
+	def test_matrix_transpose
+		m = GSL::Matrix.alloc(70, 45)
+		m.size1.times { |i| m.size2.times { |j| m[i, j] = i*100 + j } }
+		t = m.transpose
+		assert_equal([45, 70], t.shape)
+		assert_equal(m.transpose_naive, t)
+		assert_equal(m, t.transpose)
+
+		sub = m.submatrix(3, 5, 40, 33)
+		assert_equal(sub.transpose_naive, sub.transpose)
+
+		th = GSL.parallel_threshold
+		begin
+			GSL.parallel_threshold = 1
+			assert_equal(t, m.transpose)
+		ensure
+			GSL.parallel_threshold = th
+		end
+
+		sq = m.submatrix(0, 0, 45, 45).clone
+		sqt = sq.transpose
+		sq.transpose!
+		assert_equal(sqt, sq)
+
+		r = m.clone
+		r.transpose!
+		assert_equal([45, 70], r.shape)
+		assert_equal(t, r)
+
+		mi = GSL::Matrix::Int.alloc([1, 2, 3, 4, 5, 6], 2, 3)
+		mi.transpose!
+		assert_equal(GSL::Matrix::Int.alloc([1, 4, 2, 5, 3, 6], 3, 2), mi)
+	end
+
+	def test_matrix_axis_reductions
+		m = GSL::Matrix.alloc(300, 13)
+		m.size1.times { |i| m.size2.times { |j| m[i, j] = Math.sin(i*13 + j) + j } }
+		sub = m.submatrix(1, 2, 250, 9)
+		[m, sub].each do |a|
+			means = a.mean(:axis => 0)
+			sds = a.sd(:axis => 0)
+			maxs = a.max(:axis => 0)
+			amax = a.argmax(:axis => 0)
+			assert_kind_of(GSL::Vector, means)
+			assert_equal(a.size2, means.size)
+			a.size2.times do |j|
+				assert_in_delta(a.col(j).mean, means[j], 1e-12)
+				assert_in_delta(a.col(j).sd, sds[j], 1e-12)
+				assert_equal(a.col(j).max, maxs[j])
+				assert_equal(a.col(j).max_index, amax[j])
+			end
+			sums = a.sum(:axis => 1)
+			assert_kind_of(GSL::Vector::Col, sums)
+			mins = a.min(1)
+			a.size1.times do |i|
+				assert_in_delta(a.row(i).sum, sums[i], 1e-12)
+				assert_equal(a.row(i).min, mins[i])
+			end
+			assert_in_delta(GSL::Vector.alloc(a.to_a.flatten).variance, a.variance, 1e-12)
+		end
+
+		out = GSL::Vector.alloc(13)
+		assert_same(out, m.sum(:axis => :cols, :out => out))
+		assert_in_delta(m.col(4).sum, out[4], 1e-10)
+		assert_raises(ArgumentError) { m.sum(:axis => 2) }
+
+		mi = GSL::Matrix::Int.alloc([1, 7, 3, 4, 5, 6], 2, 3)
+		assert_equal(GSL::Vector::Int[4, 7, 6], mi.max(:axis => 0))
+		assert_equal(GSL::Vector::Int[1, 0, 1], mi.argmax(:axis => 0))
+	end
+
+	def test_matrix_each_row_cursor
+		m = GSL::Matrix.alloc([1, 2, 3, 4, 5, 6], 3, 2)
+		rows, ids = [], []
+		m.each_row(:cursor => true) { |r| rows << r.to_a; ids << r.object_id }
+		assert_equal([[1, 2], [3, 4], [5, 6]], rows)
+		assert_equal(1, ids.uniq.size)
+		cols, idx = [], []
+		m.each_col(:cursor => true, :index => true) { |c, j| cols << c.to_a; idx << j }
+		assert_equal([[1, 3, 5], [2, 4, 6]], cols)
+		assert_equal([0, 1], idx)
+	end
+
+	def test_matrix_int_matrix_mul
+		a = GSL::Matrix::Int.alloc(70, 300)
+		b = GSL::Matrix::Int.alloc(300, 260)
+		a.size1.times { |i| a.size2.times { |j| a[i, j] = (i*7 + j*3) % 11 - 5 } }
+		b.size1.times { |i| b.size2.times { |j| b[i, j] = (i + 2*j) % 13 - 6 } }
+		c = a*b
+		d = (a.to_f*b.to_f).to_i
+		assert_equal(d.to_a, c.to_a)
+		x = GSL::Vector::Int.indgen(300).col
+		assert_equal(a.to_a.map { |r| r.each_with_index.sum { |e, j| e*j } }, (a*x).to_a)
+
+		big = GSL::Matrix::Int[[2**30, 2**30]]
+		col = GSL::Matrix::Int[[2], [2]]
+		assert_equal([[0]], big.matrix_mul(col).to_a)
+		assert_equal([[2**31 - 1]], big.matrix_mul(col, :overflow => :saturate).to_a)
+		assert_raise(RangeError) { big.matrix_mul(col, :overflow => :raise) }
+	end
+
+	def test_matrix_concat_block
+		a = GSL::Matrix.alloc([1, 2, 3, 4], 2, 2)
+		b = GSL::Matrix.alloc([5, 6], 2, 1)
+		c = GSL::Matrix.alloc([7, 8, 9], 1, 3)
+		assert_equal([[1, 2, 5, 5], [3, 4, 6, 6]], a.horzcat(b, b).to_a)
+		assert_equal([[1, 2, 5], [3, 4, 6], [7, 8, 9]], GSL::Matrix.vertcat(a.horzcat(b), c).to_a)
+		assert_equal([[1, 2, 1, 2], [3, 4, 3, 4]], GSL::Matrix.concat([a, a], :axis => 1).to_a)
+		assert_equal([[1, 2], [3, 4], [1, 2], [3, 4]], GSL::Matrix.concat([a, a]).to_a)
+		d = GSL::Matrix.block([[a, b], [nil, GSL::Matrix.alloc([10], 1, 1)]])
+		assert_equal([[1, 2, 5], [3, 4, 6], [0, 0, 10]], d.to_a)
+		assert_raise(RuntimeError) { a.vertcat(b) }
+		assert_raise(ArgumentError) { GSL::Matrix.block([[a, b], [c]]) }
+		mi = GSL::Matrix::Int.alloc([1, 2], 1, 2)
+		assert_equal([[1, 2], [1, 2]], GSL::Matrix::Int.block([[mi], [mi]]).to_a)
+	end
+
+	def test_matrix_collect_function
+		m = GSL::Matrix.alloc([0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5], 3, 3)
+		a = m.submatrix(0, 1, 3, 2)
+		expected = a.to_a.map { |r| r.map { |x| GSL::Sf::erf(x) } }
+		assert_equal(expected, a.collect(:erf).to_a)
+		assert_same(a, a.collect!(:erf))
+		assert_equal(expected, a.to_a)
+		assert_equal([0.5, 2.0, 3.5], m.col(0).to_a)
+		assert_equal(m.to_a.map { |r| r.map { |x| 2*x } }, m.map("2*x").to_a)
+	end
+
+	def test_matrix_builder
+		b = GSL::Matrix::Builder.alloc
+		100.times { |i| b << [i, 2*i, 3*i] }
+		b << GSL::Matrix.alloc([1, 2, 3, 4, 5, 6], 2, 3)
+		b << GSL::Vector[7, 8, 9]
+		assert_equal(103, b.size1)
+		assert(b.capacity >= 103)
+		m = b.to_m
+		assert_equal([103, 3], m.shape)
+		assert_equal([99, 198, 297], m.row(99).to_a)
+		assert_equal([7, 8, 9], m.row(102).to_a)
+		assert_raise(RuntimeError) { b << [1, 2] }
+		bi = GSL::Matrix::Int::Builder.alloc(2)
+		bi << [1, 2] << GSL::Matrix::Int.alloc([3, 4], 1, 2)
+		assert_equal([[1, 2], [3, 4]], bi.to_m.to_a)
+	end
+
+	def test_matrix_fwrite_compress
+		require("tmpdir")
+		path = File.join(Dir.tmpdir, "rb-gsl-test-#{$$}.dat")
+		m = GSL::Matrix.calloc(300, 400)
+		300.times { |i| m[i, (7*i) % 400] = i + 0.25 }
+		v = m.submatrix(10, 20, 100, 50)
+		mi = GSL::Matrix::Int.calloc(20, 30)
+		mi[3, 4] = -5
+		GSL::COMPRESS_CODECS.each do |codec|
+			m.fwrite(path, :compress => codec)
+			assert(File.size(path) < 300*400*8/10)
+			m2 = GSL::Matrix.alloc(300, 400)
+			m2.fread(path)
+			assert_equal(m, m2)
+			v.fwrite(path, :compress => codec, :level => 1)
+			v2 = GSL::Matrix.alloc(100, 50)
+			v2.fread(path)
+			assert_equal(v.to_m, v2)
+			mi.fwrite(path, :compress => codec)
+			mi2 = GSL::Matrix::Int.alloc(20, 30)
+			mi2.fread(path)
+			assert_equal(mi, mi2)
+			assert_raise(GSL::ERROR::EBADLEN) { GSL::Matrix.alloc(20, 30).fread(path) }
+		end
+		m.fwrite(path)
+		assert_equal(300*400*8, File.size(path))
+		m2 = GSL::Matrix.alloc(300, 400)
+		m2.fread(path)
+		assert_equal(m, m2)
+		assert_raise(ArgumentError) { m.fwrite(path, :compress => :gzip) }
+	ensure
+		File.delete(path) if path && File.exist?(path)
+	end
+end
+
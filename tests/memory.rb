@@ -0,0 +1,130 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+GSL::Memory.pool = false
+u0 = GSL.memory_usage
+m = GSL::Matrix.alloc(100, 200)
+test_int(GSL.memory_usage - u0, 100*200*8, "GSL.memory_usage matrix")
+z = GSL::Vector::Complex.alloc(50)
+test_int(GSL.memory_usage - u0, 100*200*8 + 50*16, "GSL.memory_usage complex vector")
+col = m.col(3)
+test_int(GSL.memory_usage - u0, 100*200*8 + 50*16, "GSL.memory_usage views not counted")
+m = z = col = nil
+GC.start
+test2(GSL.memory_usage <= u0, "GSL.memory_usage released")
+
+before = GC.count
+100.times { GSL::Vector.alloc(1_000_000); "x"*1000 }
+test2(GC.count > before, "GSL::Vector memory triggers GC")
+test2(GSL.memory_usage < 100*8_000_000, "GSL::Vector memory collected")
+GSL::Memory.pool = true
+
+x = GSL::Vector.indgen(100)
+kept = nil
+s = GSL.with_arena {
+  t = 0.0
+  1000.times { |i| t += ((x + i)*x).sum }
+  kept = x*2
+  t
+}
+test_rel(s, 1000*(x*x).sum + 499500*x.sum, 1e-12, "GSL.with_arena block value")
+GC.start
+test_rel(kept.sum, 2*x.sum, 1e-15, "GSL.with_arena escaping vector")
+m = GSL.with_arena(:chunk_size => 4096) { GSL::Matrix.alloc(8, 8).set_all(1.5) }
+test_rel(m.sum, 96.0, 1e-15, "GSL.with_arena escaping matrix")
+begin
+  GSL.with_arena(:chunk_size => 10) { }
+  test2(false, "GSL.with_arena chunk_size check")
+rescue ArgumentError
+  test2(true, "GSL.with_arena chunk_size check")
+end
+
+GSL::Memory.trim
+h0 = GSL::Memory.stats[:pool_hits]
+1000.times { GSL::Vector.alloc(64).set_all(1.0) }
+GC.start
+1000.times { GSL::Vector::Int.alloc(128); GSL::Matrix.alloc(8, 8) }
+s = GSL::Memory.stats
+test2(s[:pool_hits] > h0, "GSL::Memory pool reuse")
+test2(s[:pool_cached] <= GSL::Memory.pool_cache_size, "GSL::Memory pool_cache_size cap")
+test2(GSL::Matrix.alloc(4, 4).freeze.frozen?, "GSL::Memory pooled matrix freeze")
+GSL::Memory.trim
+test_int(GSL::Memory.stats[:pool_cached], 0, "GSL::Memory.trim")
+
+GSL::Memory.pool = false
+a = GSL::Matrix.alloc(200, 300).set_all(2.5).freeze
+u0 = GSL.memory_usage
+b = a.clone
+test_int(GSL.memory_usage - u0, 0, "GSL::Matrix#clone of frozen shares data")
+test2(b.frozen? && b == a, "GSL::Matrix#clone of frozen")
+c = b.dup
+test_int(GSL.memory_usage - u0, 200*300*8, "GSL::Matrix#dup of shared clone copies")
+c[0, 0] = 1.0
+test2(!c.frozen? && a[0, 0] == 2.5, "GSL::Matrix#dup of shared clone writable")
+v = GSL::Vector.indgen(10).freeze
+w = v.clone.clone
+v = nil
+GC.start
+test_rel(w.sum, 45.0, 1e-15, "GSL::Vector shared clone keeps data alive")
+test2(!GSL::Vector.indgen(3).clone.frozen?, "GSL::Vector#clone of unfrozen")
+test2(!w.clone(:freeze => false).frozen?, "GSL::Vector#clone :freeze => false")
+GSL::Memory.pool = true
+
+# Large blocks mapped with a placement policy and huge pages
+test2(GSL::Memory.numa_policy == :default && !GSL::Memory.hugepages,
+      "GSL::Memory large block defaults")
+size = GSL::Memory.large_size
+GSL::Memory.large_size = 1 << 20
+n0 = GSL::Memory.stats[:large_objects]
+GSL::Memory.numa_policy = :first_touch
+u0 = GSL.memory_usage
+m = GSL::Matrix.calloc(512, 512)
+test2(GSL::Memory.stats[:large_objects] == n0 + 1 && m.sum == 0.0,
+      "GSL::Memory :first_touch matrix")
+test2(GSL.memory_usage - u0 >= 512*512*8, "GSL::Memory large block usage")
+m.set_all(0.5)
+test_rel(m.sum, 0.5*512*512, 1e-15, "GSL::Memory :first_touch matrix data")
+begin
+  v = GSL::Memory.with_policy(:interleave, :hugepages => true) {
+    test2(GSL::Memory.numa_policy == :interleave && GSL::Memory.hugepages,
+          "GSL::Memory.with_policy")
+    GSL::Vector.alloc(1 << 18).set_all(2.0)
+  }
+  test_rel(v.sum, 2.0*(1 << 18), 1e-15, "GSL::Memory :interleave vector")
+rescue NotImplementedError
+end
+test2(GSL::Memory.numa_policy == :first_touch && !GSL::Memory.hugepages,
+      "GSL::Memory.with_policy restores the policy")
+GSL::Memory.numa_policy = :default
+n1 = GSL::Memory.stats[:large_objects]
+GSL::Vector.alloc(1 << 18)
+test_int(GSL::Memory.stats[:large_objects], n1, "GSL::Memory :default large block")
+begin
+  GSL::Memory.numa_policy = :nearest
+  test2(false, "GSL::Memory.numa_policy check")
+rescue ArgumentError
+  test2(true, "GSL::Memory.numa_policy check")
+end
+GSL::Memory.large_size = size
+
+# 64-byte aligned data
+test2(GSL::Memory.alignment(GSL::Vector.alloc(10)) >= 64, "GSL::Memory pooled data alignment")
+align = GSL::Memory.align
+GSL::Memory.align = 64
+x = GSL::Vector.alloc(100000).set_all(1.5)
+test2(GSL::Memory.alignment(x) >= 64, "GSL::Memory.align = 64 heap block")
+a = GSL.with_arena { (1..20).map { |n| GSL::Matrix.alloc(1, n).set_all(n) } }
+test2(a.all? { |m| GSL::Memory.alignment(m) >= 64 }, "GSL::Memory.align = 64 in an arena")
+test_rel((x + x).sum, 300000.0, 1e-15, "GSL::Vector aligned kernels")
+test_rel((x.subvector(1, 99999)*2.0).sum, 299997.0, 1e-15, "GSL::Vector unaligned kernels")
+begin
+  GSL::Memory.align = 48
+  test2(false, "GSL::Memory.align check")
+rescue ArgumentError
+  test2(true, "GSL::Memory.align check")
+end
+GSL::Memory.align = align
@@ -0,0 +1,55 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+# Integral of exp(-(x^2 + y^2 + z^2)) over [0, 1]^3
+dim = 3
+f = GSL::Monte::Function.compile("exp(-(x[0]**2 + x[1]**2 + x[2]**2))", dim)
+xl = GSL::Vector.alloc([0.0, 0.0, 0.0])
+xu = GSL::Vector.alloc([1.0, 1.0, 1.0])
+expected = (Math::sqrt(Math::PI)/2*GSL::Sf::erf(1.0))**3
+
+[:hcubature, :pcubature].each do |name|
+  result, abserr, neval, status = GSL::Monte.send(name, f, xl, xu, :epsrel => 1e-10)
+  test_int(status, GSL::SUCCESS, "Monte.#{name} status")
+  test_abs(result, expected, 1e-10, "Monte.#{name} compiled")
+  test2(abserr <= 1e-10*result && neval > 0, "Monte.#{name} error estimate")
+
+  g = GSL::Monte::Function.alloc(dim) { |x, dim| Math::exp(-(x[0]**2 + x[1]**2 + x[2]**2)) }
+  r, = GSL::Monte.send(name, g, xl, xu, :epsrel => 1e-10)
+  test_abs(r, expected, 1e-10, "Monte.#{name} Ruby function")
+
+  calls = 0
+  batch = lambda { |x|
+    calls += 1
+    Array.new(x.size1) { |i| Math::exp(-(x[i,0]**2 + x[i,1]**2 + x[i,2]**2)) }
+  }
+  r, = GSL::Monte.send(name, batch, xl, xu, :epsrel => 1e-10, :batch => true)
+  test_abs(r, expected, 1e-10, "Monte.#{name} batch")
+  test2(calls < neval/10, "Monte.#{name} batch, points evaluated together")
+
+  fs = [f, GSL::Monte::Function.compile("x[0]*x[1]*x[2]", dim)]
+  r, e, = GSL::Monte.send(name, fs, [0, 0, 0], [1, 2, 1], :epsrel => 1e-10, :norm => :l2)
+  test_abs(r[1], 0.5, 1e-10, "Monte.#{name} vector integrand")
+  v = lambda { |x| [Math::exp(-(x[0]**2 + x[1]**2 + x[2]**2)), x[0]*x[1]*x[2]] }
+  r2, = GSL::Monte.send(name, v, [0, 0, 0], [1, 2, 1], :epsrel => 1e-10, :norm => :l2)
+  test_abs(r2[0], r[0], 1e-12, "Monte.#{name} vector integrand, callable")
+
+  r, e, n, status = GSL::Monte.send(name, f, xl, xu, :epsrel => 1e-15, :maxeval => 2000)
+  test2(status == GSL::EMAXITER && n <= 2000, "Monte.#{name} maxeval")
+end
+
+# The Genz-Malik rule is exact for polynomials of degree 7
+p = GSL::Monte::Function.compile("x[0]**3*x[1]**2*x[2]*x[3] + x[2]**7", 4)
+r, = GSL::Monte.hcubature(p, [0, 0, 0, 0], [1, 2, 1, 1], :maxeval => 57)
+test_rel(r, 1.0/6 + 2.0/8, 1e-14, "Monte.hcubature degree 7 rule")
+
+# Peaked integrand: adaptive subdivision, the same with threads
+peak = GSL::Monte::Function.compile("1/(1e-3 + (x[0] - 0.3)**2 + (x[1] - 0.3)**2)", 2)
+r, e, n, status = GSL::Monte.hcubature(peak, [0, 0], [1, 1], :epsrel => 1e-8)
+threads = GSL.parallel_threads
+GSL.parallel_threads = 4
+r2, e2, n2, = GSL::Monte.hcubature(peak, [0, 0], [1, 1], :epsrel => 1e-8)
+GSL.parallel_threads = threads
+test2(r == r2 && e == e2 && n == n2, "Monte.hcubature with threads")
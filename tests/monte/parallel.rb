@@ -0,0 +1,29 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+# Integral of exp(-a*(x^2 + y^2)) over [-3, 3]^2 ~ pi/a
+dim = 2
+f = GSL::Monte::Function.compile("exp(-a*(x[0]**2 + x[1]**2))", dim, "a" => 1.0)
+test_rel(f.eval(GSL::Vector.alloc([0.5, 1.0])), Math::exp(-1.25), 1e-15,
+         "Monte::Function.compile eval")
+xl = GSL::Vector.alloc([-3.0, -3.0])
+xu = GSL::Vector.alloc([3.0, 3.0])
+expected = Math::PI*GSL::Sf::erf(3.0)**2
+
+pool = GSL::Rng::Pool.alloc("mt19937", 1, 4)
+[GSL::Monte::Plain, GSL::Monte::Miser, GSL::Monte::Vegas].each do |klass|
+  state = klass.alloc(dim)
+  result, abserr, status = state.integrate_parallel(f, xl, xu, 400000, pool)
+  test_abs(result, expected, 6*abserr, "#{klass}#integrate_parallel")
+  pool.seed = 1
+  result2, = klass.alloc(dim).integrate_parallel(f, xl, xu, 400000, pool)
+  test2(result == result2, "#{klass}#integrate_parallel is reproducible")
+  pool.seed = 1
+end
+
+f.params = {"a" => 2.0}
+result, abserr, = GSL::Monte::Vegas.alloc(dim).integrate_parallel(f, xl, xu, 400000, pool)
+test_abs(result, Math::PI/2*GSL::Sf::erf(3.0*Math::sqrt(2.0))**2, 6*abserr,
+         "Vegas#integrate_parallel after set_params")
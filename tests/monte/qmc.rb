@@ -0,0 +1,41 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+# Integral of exp(-x y z w) over [0, 1]^4 = sum_k (-1)^k/(k! (k + 1)^4)
+dim = 4
+f = GSL::Monte::Function.compile("exp(-x[0]*x[1]*x[2]*x[3])", dim)
+xl = [0, 0, 0, 0]
+xu = GSL::Vector.alloc([1.0, 1.0, 1.0, 1.0])
+expected = (0...30).inject(0.0) { |s, k| s + (-1)**k/(GSL::Sf::fact(k)*(k + 1)**4) }
+calls = 100000
+
+result, abserr, neval = GSL::Monte.qmc(f, xl, xu, calls)
+test_int(neval, calls, "Monte.qmc neval")
+test_abs(result, expected, 1e-5, "Monte.qmc sobol")
+test2(abserr < 1e-5 && (result - expected).abs < 5*abserr, "Monte.qmc error estimate")
+
+r, e, = GSL::Monte.qmc(f, xl, xu, calls, :qrng => "niederreiter_2", :shifts => 16, :seed => 3)
+test_abs(r, expected, 1e-5, "Monte.qmc niederreiter_2")
+
+# A QRng is cloned, not advanced
+q = GSL::QRng.alloc(GSL::QRng::SOBOL, dim)
+r2, e2, = GSL::Monte.qmc(f, xl, xu, calls, :qrng => q)
+test2(r2 == result && e2 == abserr, "Monte.qmc with a QRng")
+test2(q.get == GSL::QRng.alloc(GSL::QRng::SOBOL, dim).get, "Monte.qmc leaves the QRng")
+
+g = GSL::Monte::Function.alloc(dim) { |x, dim| Math::exp(-x[0]*x[1]*x[2]*x[3]) }
+r, e, = GSL::Monte.qmc(g, xl, xu, 10000, :rng => GSL::Rng.alloc("mt19937", 1))
+test_abs(r, expected, 1e-4, "Monte.qmc Ruby function")
+v = GSL::Monte::Function.vectorized(dim) { |x, y|
+  x.size1.times { |i| y[i] = Math::exp(-x[i,0]*x[i,1]*x[i,2]*x[i,3]) }
+}
+r2, = GSL::Monte.qmc(v, xl, xu, 10000, :rng => GSL::Rng.alloc("mt19937", 1))
+test_rel(r2, r, 1e-14, "Monte.qmc vectorized function")
+
+threads = GSL.parallel_threads
+GSL.parallel_threads = 4
+r, e, = GSL::Monte.qmc(f, xl, xu, calls)
+GSL.parallel_threads = threads
+test2(r == result && e == abserr, "Monte.qmc with threads")
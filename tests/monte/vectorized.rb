@@ -0,0 +1,26 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+dim = 3
+g = GSL::Monte::Function.alloc(dim) { |x, dim|
+  x[0]*x[1] + x[2]
+}
+gv = GSL::Monte::Function.vectorized(dim) { |x, y|
+  x.size1.times { |i| y[i] = x[i,0]*x[i,1] + x[i,2] }
+}
+test2(gv.vectorized? && !g.vectorized?, "Monte::Function.vectorized")
+gv.batch_size = 100
+xl = GSL::Vector.alloc([0.0, 0.0, 0.0])
+xu = GSL::Vector.alloc([1.0, 2.0, 1.0])
+
+r1 = GSL::Rng.alloc("mt19937", 7)
+r2 = GSL::Rng.alloc("mt19937", 7)
+res1, err1 = GSL::Monte::Plain.alloc(dim).integrate(g, xl, xu, 1050, r1)
+res2, err2 = GSL::Monte::Plain.alloc(dim).integrate(gv, xl, xu, 1050, r2)
+test_rel(res2, res1, 1e-12, "vectorized Plain result")
+test_rel(err2, err1, 1e-10, "vectorized Plain error")
+
+res, err = GSL::Monte::Vegas.alloc(dim).integrate(gv, xl, xu, 10000, r1)
+test_abs(res, 3.0, 6*err, "vectorized Vegas")
@@ -0,0 +1,69 @@
+#!/usr/bin/env ruby
+# Linear least squares from rows given block by block
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+include Math
+
+n = 1000
+r = GSL::Rng.alloc
+t = GSL::Vector.alloc(n)
+n.times { |i| t[i] = r.uniform*2 - 1 }
+X = GSL::Matrix.alloc(n, 3)
+n.times { |i| X[i,0] = 1.0; X[i,1] = t[i]; X[i,2] = t[i]**2 }
+y = GSL::Vector.alloc(n)
+n.times { |i| y[i] = 1.0 - 2.0*t[i] + 0.5*t[i]**2 + 0.01*r.gaussian }
+w = GSL::Vector.alloc(n)
+n.times { |i| w[i] = 0.5 + r.uniform }
+acc = GSL::MultiFit::Accumulator.alloc(3)
+[0...300, 300...301, 301...1000].each do |rg|
+  acc.push_rows(X.submatrix(rg.first, 0, rg.count, 3), y.subvector(rg.first, rg.count))
+end
+test_int(acc.n, n, "Accumulator#n")
+c, cov, chisq, status = acc.solve
+c0, cov0, chisq0, = GSL::MultiFit.linear(X, y)
+for i in 0...3
+  test_rel(c[i], c0[i], 1e-12, "Accumulator#solve c#{i}")
+  test_rel(cov[i,i], cov0[i,i], 1e-12, "Accumulator#solve cov#{i}#{i}")
+end
+test_rel(chisq, chisq0, 1e-12, "Accumulator#solve chisq")
+test_int(status, GSL::SUCCESS, "Accumulator#solve status")
+
+# Weighted rows ingested in two parts and merged
+a1 = GSL::MultiFit::Accumulator.alloc(3)
+a2 = GSL::MultiFit::Accumulator.alloc(3)
+a1.push_rows(X.submatrix(0, 0, 600, 3), y.subvector(0, 600), w.subvector(0, 600))
+a2.push_rows(X.submatrix(600, 0, 400, 3), y.subvector(600, 400), w.subvector(600, 400))
+a1.merge!(a2)
+c, cov, chisq, = a1.solve
+c0, cov0, chisq0, = GSL::MultiFit.wlinear(X, w, y)
+for i in 0...3
+  test_rel(c[i], c0[i], 1e-12, "Accumulator#merge!, weighted c#{i}")
+  test_rel(cov[i,i], cov0[i,i], 1e-12, "Accumulator#merge!, weighted cov#{i}#{i}")
+end
+test_rel(chisq, chisq0, 1e-12, "Accumulator#merge!, weighted chisq")
+
+begin
+  a1.push_rows(X.submatrix(0, 0, 10, 3), y.subvector(0, 10))
+  test2(false, "Accumulator#push_rows, unweighted rows after weighted ones")
+rescue ArgumentError
+  test2(true, "Accumulator#push_rows, unweighted rows after weighted ones")
+end
+a1.reset
+test_int(a1.n, 0, "Accumulator#reset")
+
+# A block folded by several threads into factors merged at the end
+th, nt = GSL.parallel_threshold, GSL.parallel_threads
+GSL.parallel_threshold = 1
+GSL.parallel_threads = 4
+acc = GSL::MultiFit::Accumulator.alloc(3)
+acc.push_rows(X, y)
+c, cov, chisq, = acc.solve
+c0, cov0, chisq0, = GSL::MultiFit.linear(X, y)
+for i in 0...3
+  test_rel(c[i], c0[i], 1e-12, "Accumulator#push_rows on 4 threads c#{i}")
+end
+test_rel(chisq, chisq0, 1e-12, "Accumulator#push_rows on 4 threads chisq")
+test_int(acc.n, n, "Accumulator#push_rows on 4 threads n")
+GSL.parallel_threshold = th
+GSL.parallel_threads = nt
@@ -0,0 +1,78 @@
+#!/usr/bin/env ruby
+# Trust region nonlinear least squares (gsl_multifit_nlinear, gsl_multilarge_nlinear)
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+include Math
+
+exit unless GSL::MultiFit.const_defined?("Nlinear")
+
+n = 40
+t = GSL::Vector.alloc(n)
+y = GSL::Vector.alloc(n)
+sigma = GSL::Vector.alloc(n).set_all(0.1)
+n.times { |i| t[i] = i*0.1; y[i] = 5.0*exp(-1.5*t[i]) + 1.0 }
+
+exp_f = Proc.new { |x, t, y, sigma, f|
+  t.size.times { |i| f[i] = (x[0]*exp(-x[1]*t[i]) + x[2] - y[i])/sigma[i] }
+}
+exp_df = Proc.new { |x, t, y, sigma, jac|
+  t.size.times do |i|
+    e = exp(-x[1]*t[i])
+    jac[i,0] = e/sigma[i]
+    jac[i,1] = -t[i]*x[0]*e/sigma[i]
+    jac[i,2] = 1.0/sigma[i]
+  end
+}
+
+[[exp_df, {}], [nil, {}], [exp_df, {:trs => :lmaccel}], [exp_df, {:trs => :dogleg, :solver => :svd}]].each do |df, opts|
+  f = GSL::MultiFit::Function_fdf.alloc(exp_f, df, 3)
+  f.set_data(t, y, sigma)
+  w = GSL::MultiFit::Nlinear.alloc(n, 3, opts)
+  w.set(f, GSL::Vector.alloc([1.0, 1.0, 0.0]))
+  iters = 0
+  status, info = w.driver(100, 1e-10, 1e-10, 0.0) { |iter, ws| iters = iter }
+  desc = "MultiFit::Nlinear#{df ? '' : ', finite differences'} #{opts.inspect}"
+  test_int(status, GSL::SUCCESS, "#{desc} status")
+  test_rel(w.position[0], 5.0, 1e-7, "#{desc} x0")
+  test_rel(w.position[1], 1.5, 1e-7, "#{desc} x1")
+  test_rel(w.position[2], 1.0, 1e-7, "#{desc} x2")
+  test_int(iters, w.niter, "#{desc} callback")
+  test2(w.neval[1] == 0, "#{desc} neval") unless df
+end
+
+f = GSL::MultiFit::Function_fdf.compile("x[0]*exp(-x[1]*t) + x[2]", 3)
+f.set_data(t, y, sigma)
+w = GSL::MultiFit::Nlinear.alloc(n, 3, :trs => :lmaccel, :scale => :more)
+w.set(f, GSL::Vector.alloc([1.0, 1.0, 0.0]))
+w.driver(100, 1e-10, 1e-10, 0.0)
+test_rel(w.position[1], 1.5, 1e-7, "MultiFit::Nlinear, compiled model")
+cov = w.covar(0.0)
+test_int(cov.size1, 3, "MultiFit::Nlinear#covar")
+test2(w.trs_name.size > 0, "MultiFit::Nlinear#trs_name")
+
+if GSL.const_defined?("MultiLarge")
+  jac = lambda { |x| (0...n).map { |i| e = exp(-x[1]*t[i]); [e, -t[i]*x[0]*e, 1.0] } }
+  lf = Proc.new { |x, f| n.times { |i| f[i] = x[0]*exp(-x[1]*t[i]) + x[2] - y[i] } }
+  ldf = Proc.new { |trans, x, u, v, jtj|
+    j = jac.call(x)
+    if v
+      if trans == :trans
+        3.times { |k| v[k] = (0...n).inject(0.0) { |s, i| s + j[i][k]*u[i] } }
+      else
+        n.times { |i| v[i] = (0...3).inject(0.0) { |s, k| s + j[i][k]*u[k] } }
+      end
+    end
+    if jtj
+      3.times { |a| 3.times { |b| jtj[a,b] = (0...n).inject(0.0) { |s, i| s + j[i][a]*j[i][b] } } }
+    end
+  }
+  [{}, {:trs => :cgst}].each do |opts|
+    l = GSL::MultiLarge::Nlinear.alloc(n, 3, opts)
+    l.set(lf, ldf, GSL::Vector.alloc([1.0, 1.0, 0.0]))
+    status, info = l.driver(200, 1e-10, 1e-10, 0.0)
+    test_rel(l.position[0], 5.0, 1e-6, "MultiLarge::Nlinear #{opts.inspect} x0")
+    test_rel(l.position[1], 1.5, 1e-6, "MultiLarge::Nlinear #{opts.inspect} x1")
+    test_rel(l.position[2], 1.0, 1e-6, "MultiLarge::Nlinear #{opts.inspect} x2")
+  end
+end
@@ -137,3 +137,21 @@ test_f("Wood", woodf, "wood_initpt")
 
 rosenbrockf = GSL::MultiMin::Function.alloc(Rosenbrock_f, 2)
 test_f("Rosenbrock", rosenbrockf, "rosenbrock_initpt")
+
+# The vector views handed to the procs are recycled, so an evaluation
+# should not allocate Ruby objects.
+if GC.respond_to?(:stat) and GC.stat.has_key?(:total_allocated_objects)
+  calls = 0
+  quad = GSL::MultiMin::Function.alloc(Proc.new { |x|
+    calls += 1
+    (x[0] - 1)*(x[0] - 1) + (x[1] - 2)*(x[1] - 2)
+  }, 2)
+  s = GSL::MultiMin::FMinimizer.alloc("nmsimplex", 2)
+  s.set(quad, GSL::Vector.alloc([0.0, 0.0]), GSL::Vector.alloc([1.0, 1.0]))
+  10.times { s.iterate }
+  calls = 0
+  before = GC.stat(:total_allocated_objects)
+  200.times { s.iterate }
+  per_call = (GC.stat(:total_allocated_objects) - before).to_f/calls
+  test2(per_call < 0.5, "multimin function allocations (#{per_call}/call)")
+end
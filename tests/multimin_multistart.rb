@@ -0,0 +1,54 @@
+#!/usr/bin/env ruby
+# Multi-start minimization from quasi-random starting points
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+# A double well, the global minimum near x[0] = -1.3008
+f = "x[0]**4 - 3*x[0]**2 + x[0] + x[1]**2"
+x, fv, status, iter = GSL::MultiMin.multistart(f, [-2, -2], [2, 2], :starts => 50)
+test_int(fv.size, 50, "GSL::MultiMin.multistart, number of results")
+test_abs(x[0,0], -1.30084, 1e-3, "GSL::MultiMin.multistart, global minimum")
+test_abs(x[0,1], 0.0, 1e-3, "GSL::MultiMin.multistart, global minimum")
+test2((0...fv.size - 1).all? { |i| fv[i] <= fv[i+1] }, "GSL::MultiMin.multistart, sorted by f")
+test_int(status[0], GSL::SUCCESS, "GSL::MultiMin.multistart, status")
+test2(iter[0] > 0, "GSL::MultiMin.multistart, iterations")
+
+x2, fv2 = GSL::MultiMin.multistart("(x[0] - a)**2 + (x[1] - b)**2", [-2, -2], [2, 2],
+                                   :starts => 8, :params => {"a" => 0.5, "b" => -1.0})
+test_abs(x2[0,0], 0.5, 1e-4, "GSL::MultiMin.multistart, params")
+test_abs(x2[0,1], -1.0, 1e-4, "GSL::MultiMin.multistart, params")
+
+if GSL.respond_to?(:parallel_threads=)
+  nt = GSL.parallel_threads
+  GSL.parallel_threads = 4
+  x3, fv3 = GSL::MultiMin.multistart(f, [-2, -2], [2, 2], :starts => 50)
+  GSL.parallel_threads = nt
+  test2(fv3.to_a == fv.to_a, "GSL::MultiMin.multistart, threads give the same results")
+end
+
+# Stops once a start reaches the target
+x4, fv4 = GSL::MultiMin.multistart(f, [-2, -2], [2, 2], :starts => 50, :target => -3.0)
+test2(fv4.size >= 1 && fv4.size <= 50, "GSL::MultiMin.multistart, target")
+test2(fv4[0] <= -3.0, "GSL::MultiMin.multistart, target reached")
+
+# Given starting points and a Ruby function
+pts = GSL::Matrix.alloc([1.5, 1.0], [-1.5, -1.0])
+my_f = Proc.new { |v| v[0]**4 - 3*v[0]**2 + v[0] + v[1]**2 }
+my_df = Proc.new { |v, df|
+  df[0] = 4*v[0]**3 - 6*v[0] + 1
+  df[1] = 2*v[1]
+}
+fdf = GSL::MultiMin::Function_fdf.alloc(my_f, my_df, 2)
+x5, fv5, status5 = GSL::MultiMin.multistart(fdf, [-2, -2], [2, 2], :points => pts)
+test_int(fv5.size, 2, "GSL::MultiMin.multistart, points")
+test_abs(x5[0,0], -1.30084, 1e-3, "GSL::MultiMin.multistart, Function_fdf")
+test_abs(x5[1,0], 1.13090, 1e-3, "GSL::MultiMin.multistart, local minimum")
+test_rel(fv5[0], fv[0], 1e-8, "GSL::MultiMin.multistart, Function_fdf and compiled")
+
+begin
+  GSL::MultiMin.multistart(f, [-2, -2], [2])
+  test2(false, "GSL::MultiMin.multistart, bounds of different sizes")
+rescue ArgumentError
+  test2(true, "GSL::MultiMin.multistart, bounds of different sizes")
+end
@@ -123,6 +123,59 @@ fsolvers.each do |type|
   test_f("Rosenbrock", rosenbrock, "rosenbrock_initpt", 1.0, type)
 end
 
+# The views handed to the procs are recycled, so an evaluation should
+# not allocate Ruby objects.
+if GC.stat.has_key?(:total_allocated_objects)
+  calls = 0
+  lin = GSL::MultiRoot::Function.alloc(Proc.new { |x, f|
+    calls += 1
+    f[0] = x[0] + x[1] - 3
+    f[1] = x[0] - x[1] - 1
+  }, 2)
+  s = GSL::MultiRoot::FSolver.alloc("hybrids", 2)
+  x0 = GSL::Vector.alloc([0.0, 0.0])
+  s.set(lin, x0)
+  calls = 0
+  before = GC.stat(:total_allocated_objects)
+  20.times { s.set(lin, x0); s.iterate }
+  per_call = (GC.stat(:total_allocated_objects) - before).to_f/calls
+  test2(per_call < 0.5, "multiroot function allocations (#{per_call}/call)")
+end
+
+# Many small systems at once: x^2 + y^2 = r, x = a y for each row of p
+m = 50
+x0 = GSL::Matrix.alloc(m, 2)
+p = GSL::Matrix.alloc(m, 2)
+m.times { |s|
+  x0[s,0] = 1.0 + 0.1*s; x0[s,1] = 0.5
+  p[s,0] = 1.0 + s; p[s,1] = 0.5 + 0.05*s
+}
+circle = GSL::MultiRoot::Function_fdf.compile(["x[0]**2 + x[1]**2 - r", "x[0] - a*x[1]"],
+                                              "r" => 1, "a" => 1)
+x, status, iter = GSL::MultiRoot.solve_batch(circle, x0, p)
+m.times { |s|
+  y = Math::sqrt(p[s,0]/(p[s,1]**2 + 1))
+  test_int(status[s], GSL::SUCCESS, "MultiRoot.solve_batch status #{s}")
+  test_rel(x[s,1], y, 1e-10, "MultiRoot.solve_batch compiled #{s}")
+}
+calls = 0
+batch = Proc.new { |xx, pp, fx, jac|
+  calls += 1
+  xx.size1.times { |j|
+    fx[j,0] = xx[j,0]**2 + xx[j,1]**2 - pp[j,0]
+    fx[j,1] = xx[j,0] - pp[j,1]*xx[j,1]
+    jac[2*j,0] = 2*xx[j,0]; jac[2*j,1] = 2*xx[j,1]
+    jac[2*j+1,0] = 1.0; jac[2*j+1,1] = -pp[j,1]
+  }
+}
+x2, status2, iter2 = GSL::MultiRoot.solve_batch(batch, x0, p)
+test2(x2 == x && status2 == status && iter2 == iter, "MultiRoot.solve_batch callable")
+test_int(calls, iter.max, "MultiRoot.solve_batch one call per iteration")
+x0[0,0] = x0[0,1] = 0.0
+x, status, = GSL::MultiRoot.solve_batch(circle, x0, p, :maxiter => 3)
+test_int(status[0], GSL::ESING, "MultiRoot.solve_batch singular")
+test_int(status[1], GSL::EMAXITER, "MultiRoot.solve_batch maxiter")
+
 exit
 f = 1.0
 fdfsolvers = ["newton", "gnewton", "hybridj", "hybridsj"]
@@ -50,3 +50,17 @@ while true
   i += 1
   break if c.next != GSL::SUCCESS
 end
+
+c = GSL::Multiset.alloc(4, 3)
+c.init_first
+seen = []
+c.each_multiset { |v| seen << [v[0], v[1], v[2]] }
+ref = (0...4).to_a.repeated_combination(3).to_a
+GSL::Test::test(seen == ref ? 0 : 1, "GSL::Multiset#each_multiset")
+rows = []
+more = true
+while more
+  m, more = c.batch(7)
+  m.size1.times { |i| rows << [m[i, 0], m[i, 1], m[i, 2]] }
+end
+GSL::Test::test(rows == ref ? 0 : 1, "GSL::Multiset#batch")
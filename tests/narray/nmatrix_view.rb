@@ -0,0 +1,25 @@
+#!/usr/bin/env ruby
+
+require 'rubygems'
+require 'nmatrix'
+require 'gsl'
+require '../gsl_test.rb'
+include GSL::Test
+
+exit unless GSL.have_nmatrix?
+
+nm = NMatrix.new([3, 3], [4.0, 1.0, 0.0, 1.0, 4.0, 1.0, 0.0, 1.0, 4.0], :dtype => :float64)
+m = GSL::Matrix.nm_view(nm)
+m[0, 2] = 7.0
+GSL::Test.test(nm[0, 2] != 7.0, "GSL::Matrix.nm_view shares the NMatrix storage")
+GSL::Test.test(!m.to_nm.equal?(nm), "GSL::Matrix#to_nm of an NMatrix view returns the NMatrix")
+
+sub = GSL::Matrix.nm_view(nm[1..2, 1..2])
+GSL::Test.test(sub.size1 != 2 || sub[0, 0] != 4.0, "GSL::Matrix.nm_view of an NMatrix slice")
+sub[1, 1] = -1.0
+GSL::Test.test(nm[2, 2] != -1.0, "GSL::Matrix.nm_view of a slice shares the storage")
+
+col = NMatrix.new([3, 1], [1.0, 2.0, 3.0], :dtype => :float64)
+v = GSL::Vector.nv_view(col)
+GSL::Test.test(v.to_a != [1.0, 2.0, 3.0], "GSL::Vector.nv_view of a column NMatrix")
+GSL::Test.test(!col.gsl_view.is_a?(GSL::Vector), "NMatrix#gsl_view of a column")
@@ -0,0 +1,64 @@
+#!/usr/bin/env ruby
+
+require 'rubygems'
+require 'numo/narray'
+require 'gsl'
+require '../gsl_test.rb'
+include GSL::Test
+
+exit unless GSL.have_numo?
+
+# Numo -> GSL views share the data
+na = Numo::DFloat.new(6).seq
+v = GSL::Vector.from_numo(na)
+v[2] = 10.0
+GSL::Test.test(na[2] != 10.0, "GSL::Vector.from_numo shares the data")
+
+odd = na[(1..5).step(2)]
+vo = GSL::Vector.from_numo(odd)
+GSL::Test.test(vo.to_a != [1.0, 3.0, 5.0], "GSL::Vector.from_numo of a strided view")
+vo[0] = -1.0
+GSL::Test.test(na[1] != -1.0, "GSL::Vector.from_numo of a strided view shares the data")
+
+nm = Numo::DFloat.new(3, 4).seq
+m = GSL::Matrix.from_numo(nm)
+GSL::Test.test(m[1, 2] != nm[1, 2], "GSL::Matrix.from_numo")
+sub = GSL::Matrix.from_numo(nm[1..2, 0..2])
+sub[0, 0] = 100.0
+GSL::Test.test(nm[1, 0] != 100.0, "GSL::Matrix.from_numo of a submatrix view shares the data")
+
+begin
+  GSL::Matrix.from_numo(nm[true, (0..3).step(2)])
+  GSL::Test.test(true, "GSL::Matrix.from_numo rejects non-contiguous rows")
+rescue ArgumentError
+  GSL::Test.test(false, "GSL::Matrix.from_numo rejects non-contiguous rows")
+end
+
+nz = Numo::DComplex[1+2i, 3-1i]
+z = GSL::Vector::Complex.from_numo(nz)
+GSL::Test.test_rel(z[1].im, -1.0, 0, "GSL::Vector::Complex.from_numo")
+
+# to_gsl copies only what cannot be shared
+ni = Numo::Int32.new(4).seq
+GSL::Test.test(ni.to_gsl.to_a != [0.0, 1.0, 2.0, 3.0], "Numo::Int32#to_gsl")
+rev = na[(5..0).step(-1)]
+GSL::Test.test(rev.to_gsl.to_a != rev.to_a, "Numo::NArray#to_gsl of a reversed view")
+
+# GSL -> Numo
+w = GSL::Vector.indgen(5)
+nw = w.to_numo
+nw[0] = 42.0
+GSL::Test.test(w[0] != 42.0 && w.to_numo(:copy => true).to_a == nw.to_a,
+               "GSL::Vector#to_numo shares the data")
+ws = w.subvector_with_stride(0, 2, 3)
+GSL::Test.test(ws.to_numo.to_a != ws.to_a, "GSL::Vector#to_numo of a strided view")
+mm = GSL::Matrix[[1, 2], [3, 4]]
+GSL::Test.test(mm.to_numo.to_a != mm.to_a, "GSL::Matrix#to_numo")
+GSL::Test.test(mm.submatrix(0, 1, 2, 1).to_numo.to_a != [[2.0], [4.0]],
+               "GSL::Matrix#to_numo of a submatrix")
+
+# Numo::DFloat where GSL reads a vector
+x = Numo::DFloat[1, 2, 3, 4]
+GSL::Test.test_rel(GSL::Stats.mean(x), 2.5, 1e-15, "GSL::Stats.mean(Numo::DFloat)")
+GSL::Test.test_rel(GSL::Stats.sd(x), GSL::Stats.sd(GSL::Vector[1, 2, 3, 4]), 1e-15,
+                   "GSL::Stats.sd(Numo::DFloat)")
@@ -0,0 +1,76 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("tempfile")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+def npy_path
+  f = Tempfile.new(["gsl", ".npy"])
+  f.close
+  f
+end
+
+# A .npy file as numpy.save writes it, for dtype descr and shape
+def npy_bytes(descr, shape, data, fortran = false)
+  sh = shape.size == 1 ? "(#{shape[0]},)" : "(#{shape.join(', ')})"
+  h = "{'descr': '#{descr}', 'fortran_order': #{fortran ? 'True' : 'False'}, 'shape': #{sh}, }"
+  h += " " * ((64 - (h.size + 11) % 64) % 64) + "\n"
+  "\x93NUMPY\x01\x00".b + [h.size].pack("v") + h.b + data.b
+end
+
+f = npy_path
+m = GSL::Matrix[[1, 2, 3], [4, 5, 6]]
+m.submatrix(0, 1, 2, 2).save_npy(f.path)
+s = File.binread(f.path)
+test2(s[0, 6] == "\x93NUMPY".b && (10 + s[8, 2].unpack1("v")) % 64 == 0,
+      "GSL::Matrix#save_npy header")
+test2(GSL::Matrix.load_npy(f.path) == GSL::Matrix[[2, 3], [5, 6]], "GSL::Matrix.load_npy round trip of a view")
+
+v = GSL::Vector[1.5, -2, 1e300]
+v.save_npy(f.path)
+test2(GSL.load_npy(f.path) == v, "GSL.load_npy of a GSL::Vector")
+GSL::Vector::Int[1, -7, 3].save_npy(f.path)
+w = GSL.load_npy(f.path)
+test2(w.class == GSL::Vector::Int && w.to_a == [1, -7, 3], "GSL::Vector::Int#save_npy")
+z = GSL::Vector::Complex[[1, 2], [3, -4]]
+z.save_npy(f.path)
+w = GSL::Vector::Complex.load_npy(f.path)
+test2(w[1].re == 3 && w[1].im == -4, "GSL::Vector::Complex#save_npy")
+
+File.binwrite(f.path, npy_bytes(">f4", [2], [0.5, -3.25].pack("g*")))
+test2(GSL::Vector.load_npy(f.path).to_a == [0.5, -3.25], "GSL::Vector.load_npy big-endian float32")
+File.binwrite(f.path, npy_bytes("<f8", [2, 3], [1, 4, 2, 5, 3, 6].pack("E*"), true))
+test2(GSL.load_npy(f.path) == m, "GSL.load_npy Fortran order")
+File.binwrite(f.path, npy_bytes("<i8", [2, 2], [1, -2, 3, 4].pack("q<*")))
+w = GSL.load_npy(f.path)
+test2(w.class == GSL::Matrix::Int && w[0, 1] == -2, "GSL.load_npy int64 as GSL::Matrix::Int")
+test2(GSL::Matrix.load_npy(f.path)[1, 1] == 4.0, "GSL::Matrix.load_npy int64")
+File.binwrite(f.path, npy_bytes("<i8", [1], [2**40].pack("q<")))
+begin
+  GSL::Vector::Int.load_npy(f.path)
+  test2(false, "GSL::Vector::Int.load_npy out of range")
+rescue RangeError
+  test2(true, "GSL::Vector::Int.load_npy out of range")
+end
+begin
+  GSL::Matrix.load_npy(f.path)
+  test2(false, "GSL::Matrix.load_npy of a 1-d array")
+rescue ArgumentError
+  test2(true, "GSL::Matrix.load_npy of a 1-d array")
+end
+
+npz = Tempfile.new(["gsl", ".npz"])
+npz.close
+GSL.save_npz(npz.path, "x" => v, :m => m)
+h = GSL.load_npz(npz.path)
+test2(h.keys == ["x", "m"] && h["x"] == v && h["m"] == m, "GSL.save_npz and GSL.load_npz")
+
+if GSL.have_tensor?
+  t = GSL::Tensor.alloc(3, 2)
+  t.set_all(1.5)
+  t.save_npy(f.path)
+  w = GSL.load_npy(f.path)
+  test2(w.class == GSL::Tensor && w.rank == 3 && w[1, 0, 1] == 1.5, "GSL::Tensor#save_npy")
+end
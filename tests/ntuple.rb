@@ -0,0 +1,118 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("gsl_test.rb")
+require("tmpdir")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# Columnar ntuple: round trip, chunk boundaries, projections against
+# filling the histograms from the rows
+path = File.join(Dir.tmpdir, "rb-gsl-test-#{$$}.ntc")
+rng = GSL::Rng.alloc
+m = GSL::Matrix.alloc(1000, 3)
+1000.times { |i| m[i, 0] = rng.uniform; m[i, 1] = rng.gaussian; m[i, 2] = i % 3 }
+w = GSL::Ntuple::Columnar.create(path, 3, 64)
+w.write(m.submatrix(0, 0, 10, 3))
+(10...20).each { |i| w.write(m.row(i)) }
+w << m.submatrix(20, 0, 980, 3)
+GSL::Test::test_int(w.size, 1000, "Ntuple::Columnar#size while writing")
+w.close
+
+r = GSL::Ntuple::Columnar.open(path)
+GSL::Test::test_int(r.size, 1000, "Ntuple::Columnar#size")
+GSL::Test::test_int(r.ncols, 3, "Ntuple::Columnar#ncols")
+3.times do |j|
+  c = r.column(j)
+  GSL::Test::test((0...1000).all? { |i| c[i] == m[i, j] } ? 0 : 1,
+                  "Ntuple::Columnar#column(#{j})")
+end
+
+h0 = GSL::Histogram.alloc(10, [0, 1])
+h1 = h0.clone
+h0.increment(m.col(0), m.col(2))
+r.project(h1, 0, :weight => 2)
+GSL::Test::test((h0.bin - h1.bin).abs.max == 0.0 ? 0 : 1, "Ntuple::Columnar#project")
+
+g0 = GSL::Histogram2d.alloc(10, [0, 1], 8, [-2, 2])
+g1 = g0.clone
+g0.increment(m.col(0), m.col(1))
+r.project(g1, [0, 1])
+GSL::Test::test((g0.bin - g1.bin).abs.max == 0.0 ? 0 : 1, "Ntuple::Columnar#project 2d")
+r.close
+File.delete(path)
+
+# Ntuple#project with native values and selections, against the same
+# rows filled directly; a gsl_ntuple file is the raw rows of doubles
+path = File.join(Dir.tmpdir, "rb-gsl-test-#{$$}.dat")
+rows = (0...10000).map { [rng.uniform, rng.gaussian, (3*rng.uniform).floor.to_f] }
+File.open(path, "wb") { |f| f.write(rows.flatten.pack("d*")) }
+v = GSL::Vector.alloc(3)
+
+e0 = GSL::Histogram.alloc(10, [0, 1])
+e1 = GSL::Histogram.alloc(20, [0, 4])
+e2 = GSL::Histogram.alloc(10, [0, 1])
+rows.each do |x|
+  e0.increment(x[0]) if x[1] >= -1 && x[1] < 1 && x[2] >= 1 && x[2] <= 2
+  e1.increment(x[0] + x[1]*x[1])
+  e2.increment(x[0]) if x[2] != 0.0
+end
+
+n = GSL::Ntuple.open(path, v)
+h0 = GSL::Histogram.alloc(10, [0, 1])
+n.project(h0, 0, { 1 => [-1, 1], 2 => 1..2 })
+GSL::Test::test((h0.bin - e0.bin).abs.max == 0.0 ? 0 : 1, "Ntuple#project column with cuts")
+
+n = GSL::Ntuple.open(path, v)
+h1 = GSL::Histogram.alloc(20, [0, 4])
+h2 = GSL::Histogram.alloc(10, [0, 1])
+n.project([[h1, "x[0] + x[1]^2"], [h2, 0, "x[2]"]])
+GSL::Test::test((h1.bin - e1.bin).abs.max == 0.0 ? 0 : 1, "Ntuple#project expression")
+GSL::Test::test((h2.bin - e2.bin).abs.max == 0.0 ? 0 : 1, "Ntuple#project expression select")
+File.delete(path)
+
+# Ntuple::Writer: a small buffer so that the thread wraps around it many
+# times; the file is read back as raw rows
+path = File.join(Dir.tmpdir, "rb-gsl-test-#{$$}.dat")
+v = GSL::Vector.alloc(3)
+GSL::Ntuple::Writer.create(path, v, :buffer => 100) do |w|
+  1000.times do |i|
+    v[0] = i; v[1] = -i; v[2] = 0.5*i
+    w.bookdata
+  end
+  w << [1000, -1000, 500.0]
+  w.write(GSL::Matrix[[1001, -1001, 500.5], [1002, -1002, 501]])
+  w.flush
+  GSL::Test::test_int(w.pending, 0, "Ntuple::Writer#flush")
+  GSL::Test::test_int(File.size(path), 1003*3*8, "Ntuple::Writer#flush file size")
+  GSL::Test::test_int(w.size, 1003, "Ntuple::Writer#size")
+  1003.step(1999) { |i| w << [i, -i, 0.5*i] }
+end
+x = File.binread(path).unpack("d*")
+GSL::Test::test_int(x.size, 2000*3, "Ntuple::Writer#close file size")
+GSL::Test::test((0...2000).all? { |i| x[3*i, 3] == [i, -i, 0.5*i] } ? 0 : 1,
+                "Ntuple::Writer rows")
+File.delete(path)
+
+# A file long enough to be split between threads: the mapped pass against
+# Histogram#increment over the same values
+path = File.join(Dir.tmpdir, "rb-gsl-test-#{$$}.dat")
+rows = 400000
+m = GSL::Matrix.alloc(rows, 2)
+rows.times { |i| m[i, 0] = Math.sin(0.001*i); m[i, 1] = i % 7 }
+v = GSL::Vector.alloc(2)
+GSL::Ntuple::Writer.create(path, v) { |w| w.write(m) }
+e0 = GSL::Histogram.alloc(50, [-1, 1])
+e1 = GSL::Histogram.alloc(50, [-1, 1])
+rows.times do |i|
+  e0.increment(m[i, 0])
+  e1.increment(m[i, 0]) if m[i, 1] >= 3 && m[i, 1] < 5
+end
+n = GSL::Ntuple.open(path, v)
+h0 = GSL::Histogram.alloc(50, [-1, 1])
+h1 = GSL::Histogram.alloc(50, [-1, 1])
+n.project([[h0, 0], [h1, 0, { 1 => [3, 5] }]])
+GSL::Test::test((h0.bin - e0.bin).abs.max == 0.0 ? 0 : 1, "Ntuple#project large file")
+GSL::Test::test((h1.bin - e1.bin).abs.max == 0.0 ? 0 : 1, "Ntuple#project large file with cuts")
+GSL::Test::test_int(h0.sum.to_i, rows, "Ntuple#project large file row count")
+File.delete(path)
@@ -351,3 +351,117 @@ ptypes.each do |hash|
 #  test_evolve_stiff1(hash["type"], hash["h"], GSL::SQRT_DBL_EPSILON)
 #  test_evolve_stiff5(hash["type"], hash["h"], GSL::SQRT_DBL_EPSILON)
 end
+
+# The views handed to the procs are recycled, so stepping should not
+# allocate Ruby objects per call (beyond t on platforms without flonums).
+if GC.respond_to?(:stat) and GC.stat.has_key?(:total_allocated_objects)
+  func = Proc.new { |t, y, f|
+    f[0] = y[1]
+    f[1] = -y[0]
+  }
+  sys = GSL::Odeiv::System.alloc(func, 2)
+  step = GSL::Odeiv::Step.alloc(GSL::Odeiv::Step::RK4, 2)
+  y = GSL::Vector.alloc([1.0, 0.0])
+  yerr = GSL::Vector.alloc(2)
+  t = 0.0
+  10.times { step.apply(t, 1e-3, y, yerr, sys) }
+  n = 1000
+  before = GC.stat(:total_allocated_objects)
+  n.times { step.apply(t, 1e-3, y, yerr, sys) }
+  per_step = (GC.stat(:total_allocated_objects) - before).to_f/n
+  GSL::Test::test(per_step > 16 ? 1 : 0, "odeiv RK4 step allocations (#{per_step}/step)")
+end
+
+# Solver#integrate_to_grid: y'' = -y, y(0) = 0, y'(0) = 1
+solver = GSL::Odeiv::Solver.alloc(GSL::Odeiv::Step::RKF45, [1e-10, 1e-10],
+                                  Proc.new { |t, y, f|
+                                    f[0] = y[1]
+                                    f[1] = -y[0]
+                                  }, 2)
+grid = GSL::Vector.linspace(0, 3.0, 31)
+y0 = GSL::Vector.alloc([0.0, 1.0])
+m, h, steps, failed = solver.integrate_to_grid(grid, 1e-3, y0)
+GSL::Test::test_int(m.size1, grid.size, "integrate_to_grid rows")
+GSL::Test::test2(y0[0] == 0.0 && y0[1] == 1.0, "integrate_to_grid keeps y")
+GSL::Test::test2(steps > 0, "integrate_to_grid steps (#{steps}, #{failed} failed)")
+grid.size.times do |i|
+  GSL::Test::test_abs(m[i, 0], Math::sin(grid[i]), 1e-7, "integrate_to_grid y(#{grid[i]})")
+end
+
+# Odeiv2::Driver with the implicit steppers on the stiff system
+if defined?(GSL::Odeiv2)
+  arg = 5.0
+  u0 = 2.0*exp(-arg) - exp(-1000.0*arg)
+  ["msbdf", :bsimp, "rk4imp"].each do |type|
+    d = GSL::Odeiv2::Driver.alloc(Rhs_func_stiff, type, 1e-6, 1e-10, 1e-10)
+    y = GSL::Vector.alloc([1.0, 0.0])
+    t, status = d.apply(0.0, arg, y)
+    GSL::Test::test(status, "odeiv2 #{d.name} stiff [0,5] status")
+    GSL::Test::test_rel(y[0], u0, 1e-6, "odeiv2 #{d.name} stiff [0,5]")
+    GSL::Test::test2(d.count < 5000, "odeiv2 #{d.name} stiff [0,5] steps (#{d.count})")
+  end
+  d = GSL::Odeiv2::Driver.alloc(Rhs_func_sin, "rk4", 1e-3, 1e-8, 1e-8)
+  y = GSL::Vector.alloc([1.0, 0.0])
+  t, status = d.apply_fixed_step(0.0, 1e-3, 2000, y)
+  GSL::Test::test_rel(t, 2.0, 1e-12, "odeiv2 apply_fixed_step t")
+  GSL::Test::test_abs(y[1], sin(2.0), 1e-10, "odeiv2 apply_fixed_step sin(2)")
+  d.reset
+  sys = GSL::Odeiv2::System.alloc(rhs_sin, 2)
+  GSL::Test::test2((GSL::Odeiv2::Driver.alloc(sys, :msbdf, 1e-3, 1e-8, 0.0) rescue nil).nil?,
+                   "odeiv2 msbdf without a Jacobian raises")
+end
+
+# Odeiv.ensemble: y'' = -w^2 y from 64 initial states, y(t) a rotation
+w = 1.5
+sys = GSL::Odeiv::System.compile(["x[1]", "-w*w*x[0]"], "w" => w)
+GSL::Test::test2(sys.compiled?, "odeiv System.compile compiled?")
+y0 = GSL::Matrix.alloc(64, 2)
+64.times { |i| y0[i, 0] = cos(0.1*i); y0[i, 1] = w*sin(0.1*i) }
+t1 = 2.0
+exact = lambda { |i| cos(0.1*i - w*t1) }
+batched = Proc.new { |t, y, dydt|
+  y.size1.times { |i|
+    dydt[i, 0] = y[i, 1]
+    dydt[i, 1] = -w*w*y[i, 0]
+  }
+}
+ruby_sys = GSL::Odeiv::System.alloc(Proc.new { |t, y, f|
+                                      f[0] = y[1]
+                                      f[1] = -w*w*y[0]
+                                    }, 2)
+[[sys, "compiled"], [ruby_sys, "procs"], [batched, "batched"]].each do |s, desc|
+  y1, steps, failed, status = GSL::Odeiv.ensemble("rkf45", [1e-10, 1e-10], s, 0.0, t1, 1e-3, y0)
+  GSL::Test::test_int(y1.size1, 64, "odeiv ensemble #{desc} rows")
+  GSL::Test::test2(status.to_a.all? { |st| st == 0 }, "odeiv ensemble #{desc} status")
+  GSL::Test::test2(steps.min > 0, "odeiv ensemble #{desc} steps")
+  err = (0...64).map { |i| (y1[i, 0] - exact.call(i)).abs }.max
+  GSL::Test::test2(err < 1e-7, "odeiv ensemble #{desc} max error #{err}")
+end
+y1, = GSL::Odeiv.ensemble("bsimp", [1e-10, 1e-10], sys, 0.0, t1, 1e-3, y0)
+GSL::Test::test_abs(y1[5, 0], exact.call(5), 1e-7, "odeiv ensemble bsimp, compiled Jacobian")
+
+# Solver#integrate_dense: sin(t) sampled between the steps, zeros as events
+solver = GSL::Odeiv::Solver.alloc(GSL::Odeiv::Step::RKF45, [1e-10, 1e-10],
+                                  Proc.new { |t, y, f|
+                                    f[0] = y[1]
+                                    f[1] = -y[0]
+                                  }, 2)
+times = GSL::Vector.linspace(0, 10.0, 41)
+y = GSL::Vector.alloc([0.0, 1.0])
+t, h, out, events = solver.integrate_dense(0.0, 10.0, 0.1, y, :times => times,
+                                           :events => ["x[0]"])
+GSL::Test::test_rel(t, 10.0, 1e-15, "integrate_dense t")
+GSL::Test::test_abs(y[0], Math::sin(10.0), 1e-7, "integrate_dense y(10)")
+err = (0...times.size).map { |i| (out[i, 0] - Math::sin(times[i])).abs }.max
+GSL::Test::test2(err < 1e-5, "integrate_dense output times, max error #{err}")
+GSL::Test::test_int(events.size, 3, "integrate_dense zero crossings")
+events.each_with_index do |(te, k, ye), i|
+  GSL::Test::test_abs(te, (i + 1)*M_PI, 1e-6, "integrate_dense event #{i}")
+end
+y = GSL::Vector.alloc([0.0, 1.0])
+t, h, out, events = solver.integrate_dense(0.0, 10.0, 0.1, y, :times => times,
+                                           :events => [Proc.new { |t, y| y[0] - 0.5 }],
+                                           :terminal => true)
+GSL::Test::test_abs(t, M_PI/6, 1e-6, "integrate_dense terminal event")
+GSL::Test::test_abs(y[0], 0.5, 1e-6, "integrate_dense state at the event")
+GSL::Test::test2(out[times.size - 1, 0].nan?, "integrate_dense rows past the event")
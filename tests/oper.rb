@@ -0,0 +1,24 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+test2(!Integer.method_defined?(:_orig_mul) && !Float.method_defined?(:_orig_mul),
+      "Integer and Float operators are not redefined")
+
+v = GSL::Vector[1, 2, 3]
+m = GSL::Matrix[[1, 2], [3, 4]]
+test2(2*v == v.scale(2) && 2.5*v == v.scale(2.5), "Numeric * GSL::Vector")
+test2(2*m == m.scale(2), "Numeric * GSL::Matrix")
+test2(3*GSL::Vector::Int[1, 2] == GSL::Vector::Int[3, 6], "Numeric * GSL::Vector::Int")
+test2(3 - v == GSL::Vector[2, 1, 0], "Numeric - GSL::Vector")
+test2(1 + m == m + 1, "Numeric + GSL::Matrix")
+
+c = GSL::Vector::Col[3, 4]
+test2((1/c - GSL::Vector::Col[0.12, 0.16]).dnrm2 < 1e-15, "Numeric / GSL::Vector::Col")
+r = 2/GSL::Poly[1, 1]
+test2(r.kind_of?(GSL::Rational), "Numeric / GSL::Poly")
+
+test2(6*7 == 42 && 1.5/2 == 0.75, "Integer and Float operators")
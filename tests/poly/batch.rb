@@ -0,0 +1,58 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# residual of the root z of the polynomial with coefficients row
+def residual(row, z)
+  x = Complex(z.re, z.im)
+  p = 0
+  (row.size - 1).downto(0) { |j| p = p*x + row[j] }
+  p.abs
+end
+
+rng = GSL::Rng.alloc
+[3, 4, 7].each { |deg|
+  batch = 500
+  c = GSL::Matrix.alloc(batch, deg + 1)
+  batch.times { |k| (deg + 1).times { |j| c[k, j] = rng.uniform - 0.5 } }
+  c[1, deg] = 0.0
+  z, n = GSL::Poly::Batch.complex_solve(c)
+  test2(z.size1 == batch && z.size2 == deg, "GSL::Poly::Batch.complex_solve degree #{deg} shape")
+  test_int(n[0], deg, "GSL::Poly::Batch.complex_solve degree #{deg} count")
+  test_int(n[1], deg - 1, "GSL::Poly::Batch.complex_solve degree #{deg} trimmed row")
+  test2(GSL::isnan?(z[1, deg - 1].re), "GSL::Poly::Batch.complex_solve degree #{deg} NaN padding")
+  err = 0.0
+  batch.times { |k|
+    row = c.row(k).to_a
+    n[k].times { |j| err = [err, residual(row, z[k, j])].max }
+  }
+  test2(err < 1e-10, "GSL::Poly::Batch.complex_solve degree #{deg} residuals")
+  z2 = GSL::Poly.alloc(*c.row(2).to_a).complex_solve
+  test2(z2.size == n[2], "GSL::Poly::Batch.complex_solve degree #{deg} matches Poly.complex_solve")
+
+  w = GSL::Poly::Complex::Workspace.alloc(deg + 1)
+  z3, n3 = GSL::Poly::Batch.complex_solve(c, z, :workspace => w)
+  test2(z3.object_id == z.object_id && n3 == n, "GSL::Poly::Batch.complex_solve degree #{deg} with workspace")
+}
+
+c = GSL::Matrix[[-6, 11, -6, 1], [2, -3, 1, 0], [1, 0, 1, 0], [5, 0, 0, 0]]
+x, n = GSL::Poly::Batch.solve(c)
+test_int(n[0], 3, "GSL::Poly::Batch.solve cubic count")
+test_rel(x[0, 0], 1.0, 1e-10, "GSL::Poly::Batch.solve cubic root 1")
+test_rel(x[0, 1], 2.0, 1e-10, "GSL::Poly::Batch.solve cubic root 2")
+test_rel(x[0, 2], 3.0, 1e-10, "GSL::Poly::Batch.solve cubic root 3")
+test_int(n[1], 2, "GSL::Poly::Batch.solve quadratic count")
+test_rel(x[1, 1], 2.0, 1e-10, "GSL::Poly::Batch.solve quadratic root")
+test_int(n[2], 0, "GSL::Poly::Batch.solve no real roots")
+test_int(n[3], 0, "GSL::Poly::Batch.solve constant")
+
+begin
+  GSL::Poly::Batch.complex_solve(GSL::Matrix.alloc(3, 8),
+                                 :workspace => GSL::Poly::Complex::Workspace.alloc(5))
+  test2(false, "GSL::Poly::Batch.complex_solve workspace size check")
+rescue ArgumentError
+  test2(true, "GSL::Poly::Batch.complex_solve workspace size check")
+end
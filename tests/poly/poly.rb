@@ -259,6 +259,57 @@ for i in 0...7
   test_rel(y, ya[i], 1e-10, "taylor expansion about 1.5 y[#{i}]");
 end
 
+# Bulk evaluation over Vectors, Arrays and Vector::Complex
+pc = GSL::Poly.alloc((0..20).map { |i| (-1.0)**i/(i + 1) })
+x = GSL::Vector.linspace(-1, 1, 1001)
+y = pc.eval(x)
+yh = pc.eval(x, :scheme => :horner)
+hok = true
+for i in 0...x.size
+  test_rel(y[i], pc.eval(x[i]), 1e-13, "Poly#eval(Vector), Estrin, x[#{i}]") if i % 100 == 0
+  hok &&= (yh[i] == pc.eval(x[i]))
+end
+test2(hok, "Poly#eval(Vector, :scheme => :horner) matches gsl_poly_eval")
+out = GSL::Vector.alloc(x.size)
+test2(pc.eval(x, out).equal?(out) && out == y, "Poly#eval(Vector, out)")
+test2(pc.eval(x.to_a) == y.to_a, "Poly#eval(Array)")
+z = GSL::Vector::Complex.alloc(3)
+z[0] = GSL::Complex[0.5, 0.25]
+z[1] = GSL::Complex[-0.75, 0.5]
+z[2] = GSL::Complex[1.0, -1.0]
+w = pc.eval(z)
+for i in 0...z.size
+  zi = z[i]
+  ref = GSL::Complex[pc[20], 0.0]
+  19.downto(0) { |k| ref = ref*zi + GSL::Complex[pc[k], 0.0] }
+  test_rel(w[i].re, ref.re, 1e-13, "Poly#eval(Vector::Complex) re[#{i}]")
+  test_rel(w[i].im, ref.im, 1e-13, "Poly#eval(Vector::Complex) im[#{i}]")
+end
+
+# Products above GSL::Poly.fft_threshold go through the FFT
+a = GSL::Poly.alloc((0...300).map { |i| Math.sin(i) })
+b = GSL::Poly.alloc((0...200).map { |i| Math.cos(0.5*i) })
+t0 = GSL::Poly.fft_threshold
+GSL::Poly.fft_threshold = 0
+cd = a.conv(b)
+GSL::Poly.fft_threshold = 16
+cf = a.conv(b)
+test_int(cf.size, cd.size, "Poly#conv via FFT, size")
+test2((cf - cd).abs.max < 1e-12, "Poly#conv via FFT matches the direct product")
+q, r = cf.deconv(b)
+test2((q - a).abs.max < 1e-9, "Poly#deconv by Newton iteration, quotient")
+GSL::Poly.fft_threshold = t0
+
+ai = GSL::Poly::Int[*(0...600).map { |i| (i*7919) % 200003 - 100001 }]
+bi = GSL::Poly::Int[*(0...600).map { |i| (i*104729) % 65537 - 32768 }]
+t0 = GSL::Poly::Int.fft_threshold
+GSL::Poly::Int.fft_threshold = 0
+cd = ai.conv(bi)
+GSL::Poly::Int.fft_threshold = 16
+cf = ai.conv(bi)
+test2(cf.to_a == cd.to_a, "Poly::Int#conv via FFT is exact")
+GSL::Poly::Int.fft_threshold = t0
+
 # Added GSL-1.12.90 (gsl-1.13)
 # gsl_poly_eval_derivs()
 exit unless GSL::Poly.method_defined?("eval_derivs")
@@ -275,6 +326,15 @@ test_rel(dc[3], 3.0*2.0*c[3] + 4.0*3.0*2.0*c[4]*x + 5.0*4.0*3.0*c[5]*x*x , eps,"
 test_rel(dc[4], 4.0*3.0*2.0*c[4] + 5.0*4.0*3.0*2.0*c[5]*x, eps, "eval_derivs({+1, -2, +3, -4, +5, -6} deriv 4, +480.0)");
 test_rel(dc[5], 5.0*4.0*3.0*2.0*c[5] , eps, "eval_derivs({+1, -2, +3, -4, +5, -6} deriv 5, -720.0)");
 
+xs = GSL::Vector[-0.5, 0.25, 3.75]
+dm = c.eval_derivs(xs)
+for i in 0...xs.size
+  dv = c.eval_derivs(xs[i])
+  for j in 0...dv.size
+    test_rel(dm[i,j], dv[j], eps, "Poly#eval_derivs(Vector)[#{i},#{j}]")
+  end
+end
+
 # Test Poly::fit and Poly::wfit
 x = GSL::Vector[0, 2, 2]
 y = GSL::Vector[0, 1, -1]
@@ -0,0 +1,44 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+if GSL::Profiler.available?
+  f = GSL::Function.alloc { |x| Math::exp(-x*x) }
+  GSL::Profiler.reset
+  GSL::Profiler.enable
+  f.integration_qag(0, 1)
+  GSL::Vector::Complex.alloc(GSL::Vector.alloc(64).set_all(1.0), GSL::Vector.alloc(64)).forward
+  GSL::Profiler.disable
+  r = GSL::Profiler.report
+  q = r["GSL::Integration.qag"]
+  test2(q && q[:calls] == 1, "GSL::Profiler counts GSL::Function#integration_qag")
+  test2(q && q[:callbacks] > 0 && q[:callback_time] > 0.0, "GSL::Profiler callback time")
+  test2(q && (q[:native_time] - (q[:time] - q[:callback_time])).abs < 1e-9,
+        "GSL::Profiler native time")
+  test2(r["GSL::Vector::Complex#forward"] && r["GSL::Vector::Complex#forward"][:calls] == 1,
+        "GSL::Profiler counts GSL::Vector::Complex#forward")
+
+  f.integration_qag(0, 1)
+  test2(GSL::Profiler.report["GSL::Integration.qag"][:calls] == 1, "GSL::Profiler.disable")
+
+  begin
+    GSL::Profiler.profile { GSL::Function.alloc { |x| raise "stop" }.integration_qag(0, 1) }
+  rescue RuntimeError
+  end
+  test2(!GSL::Profiler.enabled?, "GSL::Profiler.profile restores the flag")
+  r = GSL::Profiler.profile { f.integration_qag(0, 1) }
+  test2(r["GSL::Integration.qag"][:calls] == 1, "GSL::Profiler.profile report")
+  GSL::Profiler.reset
+  test2(GSL::Profiler.report.empty?, "GSL::Profiler.reset")
+else
+  test2(GSL::Profiler.report == {}, "GSL::Profiler.report without --enable-profile")
+  begin
+    GSL::Profiler.enable
+    test2(false, "GSL::Profiler.enable without --enable-profile")
+  rescue NotImplementedError
+    test2(true, "GSL::Profiler.enable without --enable-profile")
+  end
+end
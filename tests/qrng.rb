@@ -90,6 +90,30 @@ end
 test_sobol()
 test_nied2()
 
+def test_fill()
+  [GSL::QRng::SOBOL, GSL::QRng::NIEDERREITER_2].each { |t|
+    g = GSL::QRng.alloc(t, 3)
+    m = g.fill(20)
+    h = GSL::QRng.alloc(t, 3)
+    v = GSL::Vector.alloc(3)
+    status = 0
+    20.times { |i|
+      h.get(v)
+      status += (m.row(i) != v) ? 1 : 0
+    }
+    GSL::Test::test(status, "#{g.name} fill matches get")
+
+    h.init
+    h.skip(12)
+    m2 = GSL::Matrix.alloc(8, 3)
+    h.fill(m2)
+    status = (m2 != m.submatrix(12, 0, 8, 3)) ? 1 : 0
+    GSL::Test::test(status, "#{g.name} skip and fill matrix")
+  }
+end
+
+test_fill()
+
 # Tests for an extension package "qrngextra"
 
 exit unless GSL::QRng.const_defined?("HDSOBOL")
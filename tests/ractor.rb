@@ -0,0 +1,53 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+exit unless defined?(Ractor) && Ractor.respond_to?(:make_shareable)
+Warning[:experimental] = false
+
+v = GSL::Vector[1, 2, 3, 4]
+test2(!Ractor.shareable?(v), "GSL::Vector not shareable unless frozen")
+v.freeze
+test2(Ractor.shareable?(v), "GSL::Vector#freeze makes shareable")
+begin
+  v[0] = 5
+  test2(false, "GSL::Vector frozen setter")
+rescue FrozenError
+  test2(true, "GSL::Vector frozen setter")
+end
+test2(!Ractor.shareable?(v.subvector(0, 2).freeze), "GSL::Vector::View frozen not shareable")
+
+m = GSL::Matrix[[1, 2], [3, 4]].freeze
+test2(Ractor.shareable?(m), "GSL::Matrix#freeze makes shareable")
+
+rs = 4.times.map { |k|
+  Ractor.new(v, m, k) { |w, a, j|
+    x = a*GSL::Vector::Col[w[0], w[1]]
+    [w.sum, x[0], x[1], (GSL::Vector.alloc(1000).set_all(j).sum)]
+  }
+}
+rs.each_with_index { |r, k|
+  s, x0, x1, t = r.take
+  test_rel(s, 10.0, 1e-15, "GSL::Vector#sum in Ractor #{k}")
+  test2(x0 == 5 && x1 == 11, "GSL::Matrix#* in Ractor #{k}")
+  test_rel(t, 1000.0*k, 1e-15, "GSL::Vector.alloc in Ractor #{k}") if k > 0
+}
+
+base = GSL::Rng.default_seed
+GSL::Rng.default_seed = base + 12
+r = Ractor.new {
+  GSL::set_error_handler_off
+  [GSL::Rng.default_seed, GSL::Rng.default.get, GSL::Sf::legendre_Pl(-1, 0.5)]
+}
+seed, x, = r.take
+test_int(seed, base, "GSL::Rng.default_seed per Ractor")
+test_int(GSL::Rng.default_seed, base + 12, "GSL::Rng.default_seed of the main Ractor")
+test2(GSL::Rng.default.equal?(GSL::Rng.default), "GSL::Rng.default")
+GSL::Rng.env_setup
+begin
+  GSL::Sf::legendre_Pl(-1, 0.5)
+  test2(false, "GSL error handler per Ractor")
+rescue GSL::ERROR::EDOM
+  test2(true, "GSL error handler per Ractor")
+end
@@ -132,3 +132,56 @@ testPDF("ugaussian_tail", "0.1, 2.0")
 
 
 
+
+# Bulk sampling
+r1 = GSL::Rng.alloc("mt19937", 42)
+r2 = GSL::Rng.alloc("mt19937", 42)
+v = GSL::Vector.alloc(100)
+r1.fill!(:gaussian, v, 2.0)
+status = 0
+100.times { |i| status = 1 if v[i] != r2.gaussian(2.0) }
+GSL::Test::test(status, "Rng#fill! gaussian matches Rng#gaussian")
+k = r1.draw(:poisson, [10, 20], 3.0)
+GSL::Test::test2(k.class == GSL::Matrix::Int && k.size1 == 10 && k.size2 == 20,
+                 "Rng#draw poisson returns 10x20 Matrix::Int")
+m = r1.draw(:dir_3d, 50)
+status = 0
+50.times { |i| status = 1 if (m[i,0]**2 + m[i,1]**2 + m[i,2]**2 - 1.0).abs > 1e-12 }
+GSL::Test::test(status, "Rng#draw dir_3d rows are unit vectors")
+
+# Discrete tables: bulk samples, counts and updates
+g = GSL::Ran::Discrete.alloc(GSL::Vector.alloc(1, 2, 3, 4))
+s = r1.discrete(g, 10000)
+GSL::Test::test2(s.class == GSL::Vector::Int && s.size == 10000 && s.min >= 0 && s.max <= 3,
+                 "Rng#discrete(g, n) returns Vector::Int")
+c = g.counts(r1, 100000)
+GSL::Test::test2(c.sum == 100000 && ((c[3] - 40000).abs/200.0) < 5, "Ran::Discrete#counts")
+g.update(0, 6)
+GSL::Test::test_rel(GSL::Ran.discrete_pdf(0, g), 0.4, 1e-15, "Ran::Discrete#update pdf")
+c = GSL::Vector::Int.alloc(4)
+s = r1.draw(:discrete, 100000, g)
+s.each { |k| c[k] += 1 }
+GSL::Test::test2(((c[0] - 40000).abs/155.0) < 5, "Ran::Discrete#update samples")
+
+# In-place shuffles and sampling without replacement
+m = GSL::Matrix.alloc(50, 3)
+50.times { |i| 3.times { |j| m[i, j] = 10*i + j } }
+r1.shuffle!(m)
+status = 0
+50.times { |i| status = 1 if m[i, 1] != m[i, 0] + 1 || m[i, 2] != m[i, 0] + 2 }
+GSL::Test::test(status, "Rng#shuffle! keeps Matrix rows")
+GSL::Test::test2(m.col(0).sort == GSL::Vector.indgen(50)*10, "Rng#shuffle! permutes Matrix rows")
+v = GSL::Vector.indgen(20)
+GSL::Ran.shuffle!(r1, v.subvector(0, 2, 10))
+GSL::Test::test2(v.sort == GSL::Vector.indgen(20) && (0...10).all? { |i| v[2*i + 1] == 2*i + 1 },
+                 "Ran.shuffle! on a strided view")
+idx = r1.choose_index(1_000_000_000, 100)
+GSL::Test::test2(idx.size == 100 && (1...100).all? { |i| idx[i] > idx[i-1] }, "Rng#choose_index")
+c = r1.choose(GSL::Vector.indgen(10000), 10)
+GSL::Test::test2(c.size == 10 && (1...10).all? { |i| c[i] > c[i-1] }, "Rng#choose sparse path keeps order")
+res = GSL::Ran::Reservoir.alloc(r1, 10)
+res.push(GSL::Vector.indgen(5000))
+3.times { |i| res << 5000 + i }
+s = res.sample
+GSL::Test::test2(res.count == 5003 && s.size == 10 && s.to_a.uniq.size == 10 && s.max < 5003,
+                 "Ran::Reservoir")
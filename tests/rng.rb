@@ -303,3 +303,49 @@ end
 Rng.types.each do |type|
   generic_rng_test(type)
 end
+
+def rng_pool_test()
+  p1 = GSL::Rng::Pool.alloc("mt19937", 123, 4)
+  p2 = GSL::Rng::Pool.alloc("mt19937", 123, 4)
+  status = 0
+  4.times do |i|
+    100.times { status = 1 if p1[i].get != p2[i].get }
+  end
+  GSL::Test::test(status, "Rng::Pool streams are reproducible")
+  p1.seed = 123
+  a = p1.collect { |r| r.get }
+  GSL::Test::test2(a.uniq.size == 4, "Rng::Pool streams are distinct")
+  GSL::Test::test2(p1.to_a.size == 4 && p1.seed == 123, "Rng::Pool size and seed")
+  s1 = GSL::Rng.alloc("taus", 1).split(3)
+  s2 = GSL::Rng.alloc("taus", 1).split(3)
+  GSL::Test::test2(s1[2].get == s2[2].get, "Rng#split is reproducible")
+end
+
+rng_pool_test()
+
+def rng_bulk_test
+  # Philox4x32-10 known answer (Random123): counter 0, key 0
+  r = GSL::Rng.alloc("philox4x32", 0)
+  a = (0...4).collect { r.get }
+  GSL::Test::test2(a == [0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8],
+                   "philox4x32 known answer")
+  ["philox4x32", "xoshiro256ss", "taus"].each do |t|
+    r1 = GSL::Rng.alloc(t, 99)
+    r2 = GSL::Rng.alloc(t, 99)
+    r1.get; r2.get
+    v = GSL::Vector.alloc(1001)
+    r1.fill_uniform(v)
+    status = 0
+    v.size.times { |i| status = 1 if v[i] != r2.uniform }
+    GSL::Test::test(status, "#{t} fill_uniform matches Rng#uniform")
+  end
+  g = GSL::Vector.alloc(100001)
+  GSL::Rng.alloc("philox4x32", 5).fill_gaussian(g, 2.0)
+  GSL::Test::test_abs(g.mean, 0.0, 0.03, "Rng#fill_gaussian mean")
+  GSL::Test::test_rel(g.sd, 2.0, 0.02, "Rng#fill_gaussian sigma")
+  r1 = GSL::Rng.alloc("xoshiro256ss", 3)
+  r2 = GSL::Rng.alloc("xoshiro256ss", 3)
+  GSL::Test::test2(r1.jump.get != r2.get, "Rng#jump")
+end
+
+rng_bulk_test()
@@ -0,0 +1,52 @@
+#!/usr/bin/env ruby
+# Many independent equations x**3 - a*x - b = 0 solved together
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+n = 200
+rows = Array.new(n) { |i| [1.0 + i*0.05, 0.5 + i*0.01] }
+params = GSL::Matrix.alloc(rows.flatten, n, 2)
+expected = rows.map { |a, b|
+  x = 3.0
+  50.times { x -= (x*x*x - a*x - b)/(3*x*x - a) }
+  x
+}
+def max_error(r, expected)
+  (0...expected.size).map { |i| (r[i] - expected[i]).abs }.max
+end
+
+f = GSL::Function.compile("x*x*x - a*x - b", "a" => 0, "b" => 0)
+df = GSL::Function.compile("3*x*x - a", "a" => 0, "b" => 0)
+root, status, iter = GSL::Root.fsolve_batch(f, 0.0, 10.0, :params => params, :epsrel => 1e-12)
+test2(status.to_a.uniq == [GSL::SUCCESS], "Root.fsolve_batch status")
+test2(max_error(root, expected) < 1e-11, "Root.fsolve_batch compiled")
+
+threads = GSL.parallel_threads
+GSL.parallel_threads = 4
+root2, status2, iter2 = GSL::Root.fsolve_batch(f, 0.0, 10.0, :params => params, :epsrel => 1e-12)
+GSL.parallel_threads = threads
+test2(root2.to_a == root.to_a && iter2.to_a == iter.to_a, "Root.fsolve_batch with threads")
+
+calls = 0
+cb = lambda { |x, idx|
+  calls += 1
+  Array.new(x.size) { |j| a, b = rows[idx[j]]; x[j]*x[j]*x[j] - a*x[j] - b }
+}
+root3, status3, iter3 = GSL::Root.fsolve_batch(cb, [0.0]*n, [10.0]*n, :epsrel => 1e-12)
+test2(root3.to_a == root.to_a && iter3.to_a == iter.to_a, "Root.fsolve_batch callable")
+test2(calls == iter.max + 2, "Root.fsolve_batch callable, called once per iteration")
+
+root, status, = GSL::Root.fdfsolve_batch(f, df, 3.0, :params => params, :epsrel => 1e-12)
+test2(status.to_a.uniq == [GSL::SUCCESS], "Root.fdfsolve_batch status")
+test2(max_error(root, expected) < 1e-12, "Root.fdfsolve_batch compiled")
+dcb = lambda { |x, idx| Array.new(x.size) { |j| 3*x[j]*x[j] - rows[idx[j]][0] } }
+root2, = GSL::Root.fdfsolve_batch(cb, dcb, [3.0]*n, :epsrel => 1e-12)
+test2(root2.to_a == root.to_a, "Root.fdfsolve_batch callable")
+
+q = GSL::Function.alloc { |x| x*x - 2 }
+root, status, = GSL::Root.fsolve_batch(q, [2.0, 3.0, 0.0], [1.0, 4.0, 2.0])
+test2(status.to_a == [GSL::EINVAL, GSL::EINVAL, GSL::SUCCESS], "Root.fsolve_batch invalid brackets")
+test_rel(root[2], Math::sqrt(2), 1e-6, "Root.fsolve_batch Function")
+root, status, iter = GSL::Root.fsolve_batch(f, 0.0, 10.0, :params => params, :epsrel => 0, :max_iter => 3)
+test2(status.to_a.uniq == [GSL::EMAXITER] && iter.to_a.uniq == [3], "Root.fsolve_batch max_iter")
@@ -0,0 +1,63 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# GSL.seal moves the data into a read-only mapping: the objects read the
+# same, are frozen, and whatever writes them in place raises first
+m = GSL::Matrix.alloc(300, 40)
+300.times { |i| 40.times { |j| m[i, j] = i - 0.5*j } }
+vi = GSL::Vector::Int.indgen(1000)
+z = GSL::Vector::Complex.alloc(17)
+17.times { |i| z[i] = GSL::Complex.alloc(i, -i) }
+xa = GSL::Vector.linspace(0, 10, 50)
+sp = GSL::Spline.alloc(xa, GSL::Sf::sin(xa))
+h = GSL::Histogram.alloc(10, [0, 5])
+100.times { |i| h.increment(0.05*i, i % 4) }
+m0, vi0, z0 = m.dup, vi.dup, z.dup
+x = GSL::Vector.linspace(0, 10, 333)
+y0 = sp.eval(x)
+bin0 = h.bin.dup
+
+test2(GSL.seal(m, vi, z, sp, h, m).size == 6, "GSL.seal returns its arguments")
+test2(GSL.sealed?(m) && GSL.sealed?(sp) && GSL.sealed?(h) && !GSL.sealed?(m0), "GSL.sealed?")
+test2(m.frozen? && vi.frozen? && z.frozen? && sp.frozen? && h.frozen?, "GSL.seal freezes")
+test2(m == m0 && vi == vi0 && z == z0, "GSL.seal Vector and Matrix data")
+test2((sp.eval(x) - y0).abs.max == 0.0, "GSL.seal Spline#eval")
+test2((h.bin - bin0).abs.max == 0.0 && h.sum == bin0.sum, "GSL.seal Histogram data")
+test2(m.clone == m0 && m.clone.frozen?, "GSL.seal shared clone")
+[lambda { m[0, 0] = 1 }, lambda { vi.set_all(0) }, lambda { sp.init(xa, xa) },
+ lambda { h.increment(1.0) }, lambda { h.reset }, lambda { h.bin[0] = 1 }].each_with_index do |f, i|
+  begin
+    f.call
+    test2(false, "GSL.seal write #{i} raises")
+  rescue => e
+    test2(e.is_a?(FrozenError) || e.is_a?(RuntimeError), "GSL.seal write #{i} raises")
+  end
+end
+begin
+  GSL.seal(m0.row(1))
+  test2(false, "GSL.seal view raises TypeError")
+rescue TypeError
+  test2(true, "GSL.seal view raises TypeError")
+end
+test2(GSL.seal(m) == m, "GSL.seal of a sealed object")
+
+# The pages are shared with forked processes, which read them as is
+if Process.respond_to?(:fork)
+  r, w = IO.pipe
+  pid = fork do
+    r.close
+    w.write([m.sum, sp.eval(3.3), h.sum].pack("d3"))
+    w.close
+    exit!(0)
+  end
+  w.close
+  s = r.read.unpack("d3")
+  Process.wait(pid)
+  test2(s == [m0.sum, sp.eval(3.3), bin0.sum], "GSL.seal data read after fork")
+end
+m = vi = z = sp = h = nil
+GC.start
@@ -0,0 +1,42 @@
+#!/usr/bin/env ruby
+# The gsl_sf_*_array functions, at one x and over Vectors and Arrays of x
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+v = GSL::Sf::bessel_Jn_array(0, 4, 2.5)
+test_int(v.size, 5, "GSL::Sf::bessel_Jn_array size")
+test_rel(v[3], GSL::Sf::bessel_Jn(3, 2.5), 1e-12, "GSL::Sf::bessel_Jn_array")
+
+x = GSL::Vector.linspace(0.5, 10, 40)
+m = GSL::Sf::bessel_Jn_array(0, 4, x)
+test2(m.size1 == 40 && m.size2 == 5, "GSL::Sf::bessel_Jn_array(Vector), Matrix")
+test_rel(m[7, 2], GSL::Sf::bessel_Jn(2, x[7]), 1e-12, "GSL::Sf::bessel_Jn_array(Vector)")
+out = GSL::Matrix.alloc(40, 5)
+GSL::Sf::bessel_Jn_array(0, 4, x, out)
+test2(out == m, "GSL::Sf::bessel_Jn_array(Vector, out)")
+test_rel(GSL::Sf::bessel_jl_array(3, [1.0, 2.0])[1, 3], GSL::Sf::bessel_jl(3, 2.0), 1e-12,
+         "GSL::Sf::bessel_jl_array(Array)")
+
+p, dp = GSL::Sf::legendre_Pl_deriv_array(4, 0.3)
+test_rel(p[4], GSL::Sf::legendre_Pl(4, 0.3), 1e-12, "GSL::Sf::legendre_Pl_deriv_array P")
+test_rel(dp[2], 3*0.3, 1e-12, "GSL::Sf::legendre_Pl_deriv_array dP")
+pm, dpm = GSL::Sf::legendre_Plm_deriv_array(5, 2, [0.1, 0.7])
+test_rel(pm[1, 3], GSL::Sf::legendre_Plm(5, 2, 0.7), 1e-12, "GSL::Sf::legendre_Plm_deriv_array(Array)")
+test2(dpm.size1 == 2 && dpm.size2 == 4, "GSL::Sf::legendre_Plm_deriv_array dP Matrix")
+test_rel(GSL::Sf::legendre_sphPlm_array(4, 1, 0.2)[2], GSL::Sf::legendre_sphPlm(3, 1, 0.2), 1e-12,
+         "GSL::Sf::legendre_sphPlm_array")
+
+g = GSL::Sf::gegenpoly_array(3, 1.5, 0.4)
+test_int(g.size, 4, "GSL::Sf::gegenpoly_array size")
+test_rel(g[3], GSL::Sf::gegenpoly_n(3, 1.5, 0.4), 1e-12, "GSL::Sf::gegenpoly_array")
+
+f, fe, status = GSL::Sf::coulomb_wave_F_array(0.0, 3, 1.0, 5.0)
+test_int(f.size, 4, "GSL::Sf::coulomb_wave_F_array size")
+test_int(status, 0, "GSL::Sf::coulomb_wave_F_array status")
+fm, fev, = GSL::Sf::coulomb_wave_F_array(0.0, 3, 1.0, [5.0, 6.0])
+test_rel(fm[0, 2], f[2], 1e-12, "GSL::Sf::coulomb_wave_F_array(Array)")
+test2(fev.size == 2, "GSL::Sf::coulomb_wave_F_array(Array) exponents")
+F, G, = GSL::Sf::coulomb_wave_FG_array(0.0, 2, 1.0, 5.0)
+test2(F != G, "GSL::Sf::coulomb_wave_FG_array, F and G")
+test_int(GSL::Sf::coulomb_CL_array(0.0, 3, 1.0).size, 4, "GSL::Sf::coulomb_CL_array size")
@@ -0,0 +1,27 @@
+#!/usr/bin/env ruby
+# Complex Sf functions over GSL::Complex, Vector::Complex and Matrix::Complex
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+z = GSL::Complex[0.7, -1.2]
+w = GSL::Sf::complex_sin(z)
+test_rel(w.real, Math.sin(0.7)*Math.cosh(-1.2), 1e-14, "GSL::Sf::complex_sin, real")
+test_rel(w.imag, Math.cos(0.7)*Math.sinh(-1.2), 1e-14, "GSL::Sf::complex_sin, imag")
+test_rel(GSL::Sf::complex_log(3.0, 4.0).real, Math.log(5.0), 1e-14, "GSL::Sf::complex_log(re, im)")
+lnr, arg, = GSL::Sf::lngamma_complex_e(2.5, 0.5)
+test_rel(GSL::Sf::lngamma_complex(2.5, 0.5).real, lnr.val, 1e-14, "GSL::Sf::lngamma_complex")
+test_rel(GSL::Sf::complex_dilog(GSL::Complex[0.5, 0.0]).real, GSL::Sf::dilog(0.5), 1e-12,
+         "GSL::Sf::complex_dilog")
+
+pts = (0...50).map { |i| [0.1*i + 0.5, 0.03*i - 0.7] }
+v = GSL::Vector::Complex[pts]
+lg = GSL::Sf::lngamma_complex(v)
+test2(lg.is_a?(GSL::Vector::Complex) && lg.size == 50, "GSL::Sf::lngamma_complex(Vector::Complex)")
+test_rel(lg[13].real, GSL::Sf::lngamma_complex(v[13]).real, 1e-14, "GSL::Sf::lngamma_complex(Vector::Complex), real")
+test_rel(lg[13].imag, GSL::Sf::lngamma_complex(v[13]).imag, 1e-14, "GSL::Sf::lngamma_complex(Vector::Complex), imag")
+out = GSL::Vector::Complex.alloc(50)
+GSL::Sf::complex_cos(v, out)
+test_rel(out[7].real, GSL::Sf::complex_cos(v[7]).real, 1e-14, "GSL::Sf::complex_cos(Vector::Complex, out)")
+GSL::Sf::complex_logsin(v, v)
+test_rel(v[21].imag, GSL::Sf::complex_logsin(*pts[21]).imag, 1e-14, "GSL::Sf::complex_logsin in place")
@@ -0,0 +1,41 @@
+#!/usr/bin/env ruby
+# Evaluation of the Sf functions over Vectors, Matrices, Arrays and Ranges
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+x = GSL::Vector.linspace(0, 5, 11)
+y = GSL::Sf::erf(x)
+test2(y.is_a?(GSL::Vector), "GSL::Sf::erf(Vector), Vector")
+test_rel(y[4], GSL::Sf::erf(x[4]), 1e-15, "GSL::Sf::erf(Vector)")
+
+a = GSL::Sf::bessel_J0(1..4)
+test2(a.is_a?(Array) && a.size == 4, "GSL::Sf::bessel_J0(Range), Array")
+test_rel(a[2], GSL::Sf::bessel_J0(3), 1e-15, "GSL::Sf::bessel_J0(Range)")
+test_int(GSL::Sf::bessel_J0(1...4).size, 3, "GSL::Sf::bessel_J0(Range), end excluded")
+
+out = GSL::Vector.alloc(4)
+GSL::Sf::bessel_J0(1..4, out)
+test_rel(out[3], GSL::Sf::bessel_J0(4), 1e-15, "GSL::Sf::bessel_J0(Range, out)")
+GSL::Sf::bessel_J0([1, 2, 3, 4], :out => out)
+test_rel(out[0], GSL::Sf::bessel_J0(1), 1e-15, "GSL::Sf::bessel_J0(Array, out)")
+
+m = GSL::Matrix.alloc([0.5, 1.5], [2.5, 3.5])
+jn = GSL::Sf::bessel_Jn(2, m)
+test_rel(jn[1,0], GSL::Sf::bessel_Jn(2, 2.5), 1e-15, "GSL::Sf::bessel_Jn(n, Matrix)")
+test_rel(GSL::Sf::gamma_inc_P(2.0, m)[0,1], GSL::Sf::gamma_inc_P(2.0, 1.5), 1e-15,
+         "GSL::Sf::gamma_inc_P(a, Matrix)")
+
+# Threads give the same results
+big = GSL::Vector.linspace(0.1, 50, 200_001)
+r1 = GSL::Sf::bessel_Jn(3, big)
+th = GSL.parallel_threshold
+nt = GSL.parallel_threads
+GSL.parallel_threshold = 1000
+GSL.parallel_threads = 4
+r4 = GSL::Sf::bessel_Jn(3, big)
+e4 = GSL::Sf::erf(0...200_001)
+GSL.parallel_threshold = th
+GSL.parallel_threads = nt
+test2(r1 == r4, "GSL::Sf::bessel_Jn(n, Vector), threads")
+test_rel(e4[123_456], GSL::Sf::erf(123_456), 1e-15, "GSL::Sf::erf(Range), threads")
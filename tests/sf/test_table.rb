@@ -0,0 +1,33 @@
+#!/usr/bin/env ruby
+# GSL::Sf::Table, piecewise Chebyshev tables of the Sf functions
+require("gsl")
+require("../gsl_test2.rb")
+include GSL::Test
+
+t = GSL::Sf::Table.new(:fermi_dirac_half, -5, 20, 1e-12)
+test2(t.size >= 1 && t.breakpoints.size == t.size + 1, "GSL::Sf::Table#breakpoints")
+test2(t.error <= 1e-12, "GSL::Sf::Table#error")
+[-5.0, -1.3, 0.0, 2.5, 7.77, 19.9, 20.0].each do |x|
+  test_rel(t.eval(x), GSL::Sf::fermi_dirac_half(x), 1e-11, "GSL::Sf::Table#eval(#{x})")
+end
+test2(t.eval(21.0).nan?, "GSL::Sf::Table#eval outside [a, b]")
+
+x = GSL::Vector.linspace(-5, 20, 1001)
+y = t.eval(x)
+test_rel(y[321], GSL::Sf::fermi_dirac_half(x[321]), 1e-11, "GSL::Sf::Table#eval(Vector)")
+out = GSL::Vector.alloc(x.size)
+t.eval(x, out)
+test2(out == y, "GSL::Sf::Table#eval(Vector, out)")
+m = GSL::Matrix[[0.5, 1.5], [2.5, 3.5]]
+test_rel(t.eval(m)[1, 0], GSL::Sf::fermi_dirac_half(2.5), 1e-11, "GSL::Sf::Table#eval(Matrix)")
+test_rel(t.eval([1.0, 2.0])[1], GSL::Sf::fermi_dirac_half(2.0), 1e-11, "GSL::Sf::Table#eval(Array)")
+
+s = GSL::Sf::Table.new(proc { |x| Math.sin(x) }, 0, 10, 0, :atol => 1e-10, :order => 12)
+test_abs(s.eval(4.2), Math.sin(4.2), 1e-10, "GSL::Sf::Table.new(Proc)")
+begin
+  GSL::Sf::Table.new(proc { |x| Math.sin(x) }, 0, 10, 1e-12)
+  test2(false, "GSL::Sf::Table.new, relative tol at a zero")
+rescue ArgumentError
+  test2(true, "GSL::Sf::Table.new, relative tol at a zero")
+end
+test2(GSL::Sf::Table.functions.include?(:expint_E1), "GSL::Sf::Table.functions")
@@ -0,0 +1,67 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# Overlap-add streaming matches direct linear convolution
+kernel = GSL::Vector[0.5, 0.25, -0.125, 0.0625, 0.03125]
+n = 100
+x = GSL::Vector.alloc(n)
+n.times { |i| x[i] = Math::sin(0.7*i) + 0.01*i }
+
+direct = Array.new(n + kernel.size - 1, 0.0)
+n.times { |i| kernel.size.times { |k| direct[i + k] += x[i]*kernel[k] } }
+
+conv = GSL::Signal::Convolver.new(kernel, 16)
+test_int(conv.kernel_size, 5, "Convolver#kernel_size")
+test_int(conv.block_size, 16, "Convolver#block_size")
+test_int(conv.fft_size, 32, "Convolver#fft_size")
+
+out = []
+y = GSL::Vector.alloc(16)
+i = 0
+while i < n
+  len = [16, n - i].min
+  blk = x.subvector(i, len)
+  if len == 16
+    conv.process(blk, y)
+    out.concat(y.to_a)
+  else
+    out.concat(conv.process(blk).to_a)
+  end
+  i += len
+end
+out.concat(conv.flush.to_a)
+test_int(out.size, direct.size, "Convolver output length")
+out.each_with_index { |v, j| test_abs(v, direct[j], 1e-12, "Convolver overlap-add sample #{j}") }
+
+conv.reset
+y = conv.process(x.subvector(0, 10))
+10.times { |j| test_abs(y[j], direct[j], 1e-12, "Convolver#reset") }
+
+# Signal.xcorr: every pair of columns against direct lagged sums
+ns, nser, maxlag = 50, 4, 7
+m = GSL::Matrix.alloc(ns, nser)
+ns.times { |t| nser.times { |j| m[t, j] = Math::sin(0.3*t*(j + 1)) + 0.05*t*j } }
+ns.times { |t| m[t, 3] = t >= 5 ? m[t - 5, 1] : 0.0 }
+lagsum = lambda { |i, j, k|
+  s = 0.0
+  ns.times { |t| s += m[t + k, i]*m[t, j] if t + k >= 0 && t + k < ns }
+  s
+}
+r = GSL::Signal.xcorr(m, :max_lag => maxlag)
+test_int(r.size1, nser*(nser + 1)/2, "Signal.xcorr pairs")
+test_int(r.size2, 2*maxlag + 1, "Signal.xcorr lags")
+q = 0
+nser.times do |i|
+  (i...nser).each do |j|
+    (-maxlag..maxlag).each { |k| test_abs(r[q, k + maxlag], lagsum.call(i, j, k), 1e-10, "Signal.xcorr r_#{i}#{j}(#{k})") }
+    q += 1
+  end
+end
+lags, vals = m.xcorr(:max_lag => maxlag, :peak => true, :normalize => true)
+test_int(lags[1, 3], -5, "Matrix#xcorr :peak lag")
+test_int(lags[3, 1], 5, "Matrix#xcorr :peak lag, transposed pair")
+test_abs(vals[2, 2], 1.0, 1e-12, "Matrix#xcorr :normalize")
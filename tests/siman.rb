@@ -0,0 +1,36 @@
+#!/usr/bin/env ruby
+# Simulated annealing over GSL::Vector and GSL::Permutation states
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::Rng.env_setup()
+r = GSL::Rng.alloc()
+params = GSL::Siman::Params.alloc(200, 100, 1.0, 1.0, 10.0, 1.05, 0.01)
+
+efunc = GSL::Siman::Efunc.alloc { |x| (x[0] - 1.5)**2 }
+step = GSL::Siman::Step.alloc { |rng, x, s| x[0] = x[0] + s*(2*rng.uniform - 1) }
+metric = GSL::Siman::Metric.alloc { |x, y| (x[0] - y[0]).abs }
+x = GSL::Vector.alloc([10.0])
+GSL::Siman::solve(r, x, efunc, step, metric, nil, params)
+test_abs(x[0], 1.5, 0.05, "GSL::Siman.solve, Vector state")
+
+# Sorting by transpositions: the state is a Permutation
+w = [5, 3, 0, 4, 1, 2]
+pefunc = GSL::Siman::Efunc.alloc { |p| (0...w.size).inject(0) { |s, i| s + (w[p[i]] - i).abs } }
+pstep = GSL::Siman::Step.alloc { |rng, p, s|
+  p.swap(rng.uniform_int(w.size), rng.uniform_int(w.size))
+}
+pmetric = GSL::Siman::Metric.alloc { |p, q| (0...w.size).count { |i| p[i] != q[i] } }
+perm = GSL::Permutation.alloc(w.size)
+GSL::Siman::solve(r, perm, pefunc, pstep, pmetric, nil, params)
+test2(perm.to_a.map { |i| w[i] } == [0, 1, 2, 3, 4, 5], "GSL::Siman.solve, Permutation state")
+
+# A Solver reused for states of other kinds and sizes
+solver = GSL::Siman::Solver.alloc(3)
+x2 = GSL::Vector.alloc([-4.0])
+solver.solve(r, x2, efunc, step, metric, nil, params)
+test_abs(x2[0], 1.5, 0.05, "GSL::Siman::Solver#solve, Vector state")
+perm2 = GSL::Permutation.alloc(w.size)
+solver.solve(r, perm2, pefunc, pstep, pmetric, nil, params)
+test2(perm2.to_a.map { |i| w[i] } == [0, 1, 2, 3, 4, 5], "GSL::Siman::Solver#solve, Permutation state")
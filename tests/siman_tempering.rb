@@ -0,0 +1,55 @@
+#!/usr/bin/env ruby
+# Parallel tempering with GSL::Siman.tempering
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+# A tilted double well: the global minimum near x[0] = -2, the start in
+# the basin of the other one
+e = "(x[0]**2 - 4)**2 + x[1]**2 + 0.5*x[0]"
+x0 = GSL::Vector.alloc([3.0, 3.0])
+x, en, states, energies, accept, swap =
+  GSL::Siman.tempering(e, x0, :sweeps => 500, :step_size => 0.5, :seed => 3)
+test_abs(x[0], -2.0, 0.1, "GSL::Siman.tempering, global minimum")
+test_abs(x[1], 0.0, 0.1, "GSL::Siman.tempering, global minimum")
+test2(en < -0.9, "GSL::Siman.tempering, lowest energy")
+test_int(states.size1, 8, "GSL::Siman.tempering, chains")
+test_int(energies.size, 8, "GSL::Siman.tempering, chains")
+test_int(swap.size, 7, "GSL::Siman.tempering, pairs of neighbours")
+test2(energies.to_a.min >= en, "GSL::Siman.tempering, best of the chains")
+test2(accept.to_a.all? { |a| a > 0 && a <= 1 }, "GSL::Siman.tempering, acceptance")
+test2(x0.to_a == [3.0, 3.0], "GSL::Siman.tempering, x0 untouched")
+
+if GSL.respond_to?(:parallel_threads=)
+  nt = GSL.parallel_threads
+  GSL.parallel_threads = 4
+  x2, en2, states2 = GSL::Siman.tempering(e, x0, :sweeps => 500, :step_size => 0.5, :seed => 3)
+  GSL.parallel_threads = nt
+  test2(en2 == en && states2 == states, "GSL::Siman.tempering, threads give the same results")
+end
+
+# The same energy as a Proc, state by state and in batches
+f = Proc.new { |v| (v[0]**2 - 4)**2 + v[1]**2 + 0.5*v[0] }
+fb = Proc.new { |m|
+  GSL::Vector.alloc((0...m.size1).map { |i| v = m.row(i); f.call(v) })
+}
+x3, en3, states3 = GSL::Siman.tempering(f, x0, :sweeps => 200, :step_size => 0.5, :seed => 3)
+x4, en4, states4 = GSL::Siman.tempering(fb, x0, :sweeps => 200, :step_size => 0.5, :seed => 3,
+                                        :batch => true)
+test_rel(en4, en3, 1e-12, "GSL::Siman.tempering, batch energies")
+test2(states4 == states3, "GSL::Siman.tempering, batch energies")
+
+# A Ruby step, one temperature ladder given, streams from a Pool
+step = Proc.new { |rng, v, s| v[0] += s*(2*rng.uniform - 1) }
+pool = GSL::Rng::Pool.alloc(nil, 1, 4)
+x5, en5 = GSL::Siman.tempering("x[0]**2 + 10*(1 - cos(2*3.141592653589793*x[0]))",
+                               GSL::Vector.alloc([4.0]), :temperatures => [1, 4, 16],
+                               :step => step, :rng => pool, :sweeps => 500)
+test_abs(x5[0], 0.0, 0.1, "GSL::Siman.tempering, Rastrigin with a Ruby step")
+
+begin
+  GSL::Siman.tempering(e, x0, :temperatures => [2, 1], :chains => 2)
+  test2(false, "GSL::Siman.tempering, descending temperatures")
+rescue ArgumentError
+  test2(true, "GSL::Siman.tempering, descending temperatures")
+end
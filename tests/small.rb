@@ -0,0 +1,58 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+# The fixed-size types against GSL::Vector, GSL::Matrix and GSL::Linalg
+rng = GSL::Rng.alloc
+[[GSL::Vec2, GSL::Mat2, 2], [GSL::Vec3, GSL::Mat3, 3], [GSL::Vec4, GSL::Mat4, 4]].each do |vc, mc, n|
+  x = GSL::Vector.alloc(n).set_all(0)
+  y = GSL::Vector.alloc(n).set_all(0)
+  n.times { |i| x[i] = rng.uniform - 0.5; y[i] = rng.uniform - 0.5 }
+  m = GSL::Matrix.alloc(n, n)
+  q = GSL::Matrix.alloc(n, n)
+  n.times { |i| n.times { |j| m[i, j] = rng.uniform - 0.5; q[i, j] = rng.uniform } }
+  a = vc.new(x)
+  b = vc[*y.to_a]
+  s = mc.new(m)
+  t = mc.new(q.to_a)
+  test2(a.to_v == x && s.to_m == m && a.size == n, "#{vc} conversions")
+  test_rel(a.dot(b), x*y.col, 1e-15, "#{vc}#dot")
+  test_rel(a.norm, x.dnrm2, 1e-15, "#{vc}#norm")
+  test2(((a + b).to_v - (x + y)).abs.max == 0.0 && ((a - b).to_v - (x - y)).abs.max == 0.0,
+        "#{vc}#+, #-")
+  test2((2*a).to_v == x*2 && (-a).to_v == -x, "#{vc}#*, #-@")
+  test2(((s*t).to_m - m*q).abs.max < 1e-15, "#{mc}#*(#{mc})")
+  test2(((s*a).to_v - m*x.col).abs.max < 1e-15, "#{mc}#*(#{vc})")
+  test2(s.transpose.to_m == m.transpose, "#{mc}#transpose")
+  test_rel(s.det, GSL::Linalg::LU.det(m.clone), 1e-13, "#{mc}#det")
+  test2((s.inverse.to_m - GSL::Linalg::LU.invert(m.clone)).abs.max < 1e-11, "#{mc}#inverse")
+  test2((s*s.inverse - mc.identity).to_m.abs.max < 1e-13, "#{mc}#inverse product")
+  begin
+    mc.new.inverse
+    test2(false, "#{mc} singular")
+  rescue GSL::ERROR::ESING, ZeroDivisionError
+    test2(true, "#{mc} singular")
+  end
+  f = a.dup.freeze
+  begin
+    f[0] = 1
+    test2(false, "#{vc} frozen")
+  rescue FrozenError
+    test2(true, "#{vc} frozen")
+  end
+  c = a.dup
+  c[n - 1] = 7
+  test2(c[-1] == 7 && a[n - 1] == x[n - 1], "#{vc}#dup, #[]=")
+end
+
+x = GSL::Vector[1, 2, 3]
+y = GSL::Vector[-1, 0.5, 4]
+test2((GSL::Vec3.new(x).cross(GSL::Vec3.new(y)).to_v - GSL::Vector[6.5, -7, 2.5]).abs.max == 0.0,
+      "Vec3#cross")
+test_rel(GSL::Vec2[1, 2].cross(GSL::Vec2[3, 4]), -2.0, 1e-15, "Vec2#cross")
+test2((GSL::Vec3.new(x).rotate(0.3, 1.1).to_v - x.clone.rotate(0.3, 1.1)).abs.max < 1e-15,
+      "Vec3#rotate as Vector#rotate")
+test2(GSL::Vec3.new(x).rotateX(0.5) != GSL::Vec3.new(x), "Vec3#rotateX returns a new vector")
@@ -0,0 +1,53 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+exit unless defined?(GSL::SpMatrix)
+
+# 1-D Laplacian, tridiagonal (-1, 2, -1)
+n = 50
+rows, cols, vals = [], [], []
+n.times { |i|
+  rows << i; cols << i; vals << 2.0
+  if i > 0
+    rows << i; cols << i - 1; vals << -1.0
+    rows << i - 1; cols << i; vals << -1.0
+  end
+}
+a = GSL::SpMatrix.from_triplets(n, n, rows, cols, vals)
+test(a.nnz == 3*n - 2 ? 0 : 1, "SpMatrix.from_triplets nnz")
+test(a.format == :coo ? 0 : 1, "SpMatrix.from_triplets format")
+d = a.to_m
+x = GSL::Vector.alloc(n)
+n.times { |i| x[i] = Math::sin(0.3*i) }
+yd = d*x
+
+[a, a.to_csc, a.to_csr].each { |m|
+  y = m*x
+  test_abs((y - yd).abs.max, 0.0, 1e-14, "SpMatrix(#{m.format})*Vector")
+  yt = GSL::SpBlas.dgemv(GSL::Blas::Trans, 2.0, m, x)
+  test_abs((yt - 2.0*(d.transpose*x)).abs.max, 0.0, 1e-14,
+           "SpBlas.dgemv(Trans) on #{m.format}")
+  b = GSL::Matrix.alloc(n, 3)
+  n.times { |i| 3.times { |j| b[i, j] = i + 10*j } }
+  test_abs(((m*b) - d*b).abs.max, 0.0, 1e-12, "SpMatrix(#{m.format})*Matrix")
+}
+
+th = GSL.parallel_threshold
+GSL.parallel_threshold = 1
+test_abs(((a.to_csr*x) - yd).abs.max, 0.0, 1e-14, "threaded CSR SpMV")
+GSL.parallel_threshold = th
+
+t = a.to_csc.transpose
+test(t.format == :csc ? 0 : 1, "SpMatrix#transpose keeps the format")
+test_abs((t.to_m - d.transpose).abs.max, 0.0, 0.0, "SpMatrix#transpose")
+test(d.to_sp.nnz == a.nnz ? 0 : 1, "Matrix#to_sp")
+
+if defined?(GSL::SpLinalg)
+  b = a*x
+  sol, iter, normr = GSL::SpLinalg.gmres(a.to_csc, b, :tol => 1e-12, :max_iter => 500)
+  test_abs((sol - x).abs.max, 0.0, 1e-8, "SpLinalg.gmres (#{iter} iterations, residual #{normr})")
+end
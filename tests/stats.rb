@@ -172,3 +172,120 @@ GSL::Test::test_rel(quantile, expected, rel, "gsl_stats_quantile_from_sorted_dat
 quantile = rawa.subvector(0, rawa.size-1).quantile_from_sorted_data(0.5)
 expected = 0.0728
 GSL::Test::test_rel(quantile, expected, rel, "gsl_stats_quantile_from_sorted_data (50odd)")
+
+s = GSL::Stats.summary(rawb)
+GSL::Test::test_rel(s.mean, rawb.mean, rel, "gsl_stats_summary mean")
+GSL::Test::test_rel(s.variance, rawb.variance, rel, "gsl_stats_summary variance")
+GSL::Test::test_rel(s.sd, rawb.sd, rel, "gsl_stats_summary sd")
+GSL::Test::test_rel(s.skew, rawb.skew, rel, "gsl_stats_summary skew")
+GSL::Test::test_rel(s.kurtosis, rawb.kurtosis, rel, "gsl_stats_summary kurtosis")
+GSL::Test::test_rel(s.min, rawb.min, rel, "gsl_stats_summary min")
+GSL::Test::test_rel(s.max, rawb.max, rel, "gsl_stats_summary max")
+
+s = rawb.summary(raww)
+GSL::Test::test_rel(s.mean, rawb.wmean(raww), rel, "gsl_stats_summary wmean")
+GSL::Test::test_rel(s.variance, rawb.wvariance(raww), rel, "gsl_stats_summary wvariance")
+GSL::Test::test_rel(s.skew, rawb.wskew(raww), rel, "gsl_stats_summary wskew")
+GSL::Test::test_rel(s.kurtosis, rawb.wkurtosis(raww), rel, "gsl_stats_summary wkurtosis")
+
+m = GSL::Matrix.alloc(rawb.to_a + rawa.to_a, 2, rawb.size)
+cols = m.summary(:cols)
+GSL::Test::test_rel(cols[3].mean, m.col(3).mean, rel, "gsl_stats_summary matrix column mean")
+rows = m.summary(:rows)
+GSL::Test::test_rel(rows[0].variance, rawb.variance, rel, "gsl_stats_summary matrix row variance")
+GSL::Test::test_rel(m.summary.mean, (rawa.mean + rawb.mean)/2, rel, "gsl_stats_summary matrix mean")
+
+r = GSL::Stats::Running.new
+rawb.subvector(0, 5).each { |x| r.push(x) }
+r2 = GSL::Stats::Running.new
+r2.push_vector(rawb.subvector(5, rawb.size - 5))
+r.merge!(r2)
+GSL::Test::test_int(r.n, rawb.size, "gsl_stats_running n")
+GSL::Test::test_rel(r.mean, rawb.mean, rel, "gsl_stats_running mean")
+GSL::Test::test_rel(r.variance, rawb.variance, rel, "gsl_stats_running variance")
+GSL::Test::test_rel(r.skew, rawb.skew, rel, "gsl_stats_running skew")
+GSL::Test::test_rel(r.kurtosis, rawb.kurtosis, rel, "gsl_stats_running kurtosis")
+GSL::Test::test_rel(r.min, rawb.min, rel, "gsl_stats_running min")
+GSL::Test::test_rel(r.max, rawb.max, rel, "gsl_stats_running max")
+
+r = GSL::Stats::Running.new.push_vector(rawb, raww)
+GSL::Test::test_rel(r.mean, rawb.wmean(raww), rel, "gsl_stats_running wmean")
+GSL::Test::test_rel(r.variance, rawb.wvariance(raww), rel, "gsl_stats_running wvariance")
+
+rng = GSL::Rng.alloc()
+v = GSL::Vector.alloc(100000)
+v.size.times { |i| v[i] = rng.uniform() }
+sorted = v.sort
+p2 = GSL::Stats::P2.new(0.9)
+p2.push_vector(v)
+GSL::Test::test_abs(p2.quantile, sorted.quantile_from_sorted_data(0.9), 5e-3, "gsl_stats_p2 quantile")
+td1 = GSL::Stats::TDigest.new(100)
+td2 = GSL::Stats::TDigest.new(100)
+v.size.times { |i| (i.even? ? td1 : td2).push(v[i]) }
+td1.merge!(td2)
+GSL::Test::test_int(td1.n, v.size, "gsl_stats_tdigest n")
+[0.01, 0.5, 0.99].each do |q|
+  GSL::Test::test_abs(td1.quantile(q), sorted.quantile_from_sorted_data(q), 5e-3,
+                      "gsl_stats_tdigest quantile #{q}")
+end
+GSL::Test::test_abs(td1.cdf(sorted.quantile_from_sorted_data(0.25)), 0.25, 5e-3, "gsl_stats_tdigest cdf")
+GSL::Test::test_rel(td1.quantile(1.0), sorted.max, rel, "gsl_stats_tdigest max")
+
+w = 60
+x = GSL::Vector.alloc(500)
+x.size.times { |i| x[i] = 100 + Math.sin(i*0.1)*5 + (i % 7) }
+[:mean, :sd, :min, :max, :median, :mad].each do |stat|
+  r = x.rolling(w, stat)
+  GSL::Test::test_int(r.size, x.size - w + 1, "gsl_stats_rolling #{stat} size")
+  [0, 17, r.size - 1].each do |k|
+    win = x.subvector(k, w)
+    expected = case stat
+               when :median then win.sort.median_from_sorted_data
+               when :mad
+                 med = win.sort.median_from_sorted_data
+                 dev = win.to_a.map { |e| (e - med).abs }.sort
+                 1.482602218505602*GSL::Vector.alloc(dev).median_from_sorted_data
+               else win.send(stat)
+               end
+    GSL::Test::test_rel(r[k], expected, 1e-10, "gsl_stats_rolling #{stat} window #{k}")
+  end
+end
+r = GSL::Stats.rolling(x, w, :mean, :pad => true)
+GSL::Test::test_int(r.size, x.size, "gsl_stats_rolling pad size")
+GSL::Test::test(r[w-2].nan? ? 0 : 1, "gsl_stats_rolling pad NaN")
+GSL::Test::test_rel(r[w-1], x.subvector(0, w).mean, 1e-10, "gsl_stats_rolling pad first window")
+
+rng = GSL::Rng.alloc
+n, p = 50, 4
+m = GSL::Matrix.alloc(n, p)
+n.times { |i| p.times { |j| m[i, j] = rng.uniform } }
+n.times { |i| m[i, 3] = 2*m[i, 0] + 0.1*m[i, 3] }
+c = m.covariance_matrix
+r = m.correlation_matrix
+p.times do |i|
+  p.times do |j|
+    GSL::Test::test_rel(c[i, j], GSL::Stats.covariance(m.col(i), m.col(j)), 1e-10,
+                        "covariance_matrix (#{i}, #{j})")
+    GSL::Test::test_rel(r[i, j], GSL::Stats.correlation(m.col(i), m.col(j)), 1e-10,
+                        "correlation_matrix (#{i}, #{j})")
+  end
+end
+wt = GSL::Vector.alloc(n)
+n.times { |i| wt[i] = 0.5 + rng.uniform }
+cw = m.covariance_matrix(:weights => wt)
+GSL::Test::test_rel(cw[2, 2], m.col(2).wvariance(wt), 1e-10, "covariance_matrix weighted variance")
+GSL::Test::test_rel(m.correlation_matrix(:weights => wt)[0, 3],
+                    cw[0, 3]/Math.sqrt(cw[0, 0]*cw[3, 3]), 1e-10, "correlation_matrix weighted")
+
+m[3, 1] = m[7, 2] = m[8, 1] = GSL::NAN
+cp = m.covariance_matrix(:missing => :pairwise)
+rows = (0...n).to_a - [3, 7, 8]
+a = GSL::Vector.alloc(rows.map { |i| m[i, 1] })
+b = GSL::Vector.alloc(rows.map { |i| m[i, 2] })
+GSL::Test::test_rel(cp[1, 2], GSL::Stats.covariance(a, b), 1e-10, "covariance_matrix pairwise")
+rows = (0...n).to_a - [3, 8]
+a = GSL::Vector.alloc(rows.map { |i| m[i, 0] })
+b = GSL::Vector.alloc(rows.map { |i| m[i, 1] })
+GSL::Test::test_rel(m.correlation_matrix(:missing => :pairwise)[0, 1],
+                    GSL::Stats.correlation(a, b), 1e-10, "correlation_matrix pairwise")
+GSL::Test::test(m.covariance_matrix[1, 2].nan? ? 0 : 1, "covariance_matrix NaN without :missing")
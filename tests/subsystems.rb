@@ -0,0 +1,47 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+names = ["Sf", "Monte", "Siman", "Dht", "CONST", "Graph"]
+test2(GSL.subsystems.keys == names, "GSL.subsystems")
+unless GSL.subsystems["Sf"]
+  test2(!GSL.const_defined?(:Sf), "GSL::Sf is not defined before its first use")
+end
+
+test_rel(GSL::Sf::gamma(5.0), 24.0, 1e-14, "GSL::Sf defined on first use")
+test2(GSL.subsystems["Sf"] && GSL.const_defined?(:Sf), "GSL.subsystems after GSL::Sf")
+test2(GSL::Sf::Result.new.is_a?(GSL::Object), "GSL::Sf::Result")
+test2(GSL::Sf.name == "GSL::Sf" && GSL::Sf::Result.name == "GSL::Sf::Result",
+      "GSL::Sf names")
+
+# Within a module including GSL, from threads at once
+module SubsystemsTest
+  include GSL
+  def self.c
+    CONST::MKSA::SPEED_OF_LIGHT
+  end
+end
+c = 8.times.map { Thread.new { SubsystemsTest.c } }.map(&:value)
+test2(c.uniq == [GSL::CONST::MKSA::SPEED_OF_LIGHT], "GSL::CONST from threads")
+test2(SubsystemsTest.const_get(:Graph) == GSL::Graph, "GSL::Graph in a module including GSL")
+
+begin
+  GSL::NoSuchSubsystem
+  test2(false, "NameError for other constants")
+rescue NameError
+  test2(true, "NameError for other constants")
+end
+begin
+  GSL.load_subsystems(:NoSuchSubsystem)
+  test2(false, "GSL.load_subsystems of an unknown name")
+rescue ArgumentError
+  test2(true, "GSL.load_subsystems of an unknown name")
+end
+
+test2(GSL.load_subsystems(:Monte).subsystems["Monte"], "GSL.load_subsystems(:Monte)")
+GSL.load_subsystems
+test2(GSL.subsystems.values.all?, "GSL.load_subsystems")
+test2(names.all? { |n| GSL.const_defined?(n) }, "GSL.const_defined? after GSL.load_subsystems")
@@ -96,3 +96,28 @@ for n in 0...N
 end
 check_trunc(t, result, "eta(1/2)")
 check_full(t, result, "eta(1/2)")
+
+# Terms pushed in batches until the error estimate is small enough
+def check_stream(t, expected, desc)
+  s = GSL::Sum::Stream.alloc
+  sum_accel = nil
+  0.step(N - 1, 7) do |i|
+    sum_accel, err = s.push(t.subvector(i, [7, N - i].min))
+    break if err < 1e-10*sum_accel.abs
+  end
+  GSL::Test::test_rel(sum_accel, expected, 1e-8, sprintf("stream result, %s", desc))
+end
+
+for n in 0...N
+  t[n] = 1.0/((n + 1.0)*(n + 1.0))
+end
+check_stream(t, Zeta_2, "zeta(2)")
+t[0] = 1.0
+for n in 1...N
+  t[n] = t[n-1]*(-10.0/n)
+end
+check_stream(t, exp(-10.0), "exp(-10)")
+for n in 0...N
+  t[n] = (n%2 == 1 ? -1 : 1) * 1.0 /sqrt(n + 1.0)
+end
+check_stream(t, 0.6048986434216305, "eta(1/2)")
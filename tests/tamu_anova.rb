@@ -0,0 +1,37 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+exit unless defined?(GSL::TAMU_ANOVA)
+
+data = GSL::Vector[88.60, 73.20, 91.40, 68.00, 75.20, 63.00, 53.90, 69.20,
+                   50.10, 71.50, 44.90, 59.50, 40.20, 56.30, 38.70, 31.00,
+                   39.60, 45.30, 25.20, 22.70]
+factor = GSL::Vector::Int[1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4]
+t = GSL::TAMU_ANOVA::Table.oneway(data, factor, 4)
+test_int(t.dfTr, 3, "GSL::TAMU_ANOVA::Table#dfTr")
+test_int(t.dfE, 16, "GSL::TAMU_ANOVA::Table#dfE")
+test_rel(t.SST, t.SSTr + t.SSE, 1e-12, "GSL::TAMU_ANOVA::Table#SST")
+
+# Columns of a matrix against one call per column, and the same rows
+# streamed through an accumulator
+n = 40
+m = GSL::Matrix.alloc(n, 7)
+f = GSL::Vector::Int.alloc(n)
+n.times do |i|
+  f[i] = i % 3 + 1
+  7.times { |j| m[i, j] = 1000.0 + Math.sin(i*1.7 + j) + 0.1*j*f[i] }
+end
+tables = GSL::TAMU_ANOVA::Table.oneway(m, f, 3)
+acc = GSL::TAMU_ANOVA::Accumulator.alloc(3, 7)
+n.times { |i| acc.add(m.row(i), f[i]) }
+7.times do |j|
+  t = GSL::TAMU_ANOVA::Table.oneway(m.col(j), f, 3)
+  test_rel(tables[j].F, t.F, 1e-8, "GSL::TAMU_ANOVA::Table.oneway(Matrix) F #{j}")
+  test_rel(tables[j].SSE, t.SSE, 1e-10, "GSL::TAMU_ANOVA::Table.oneway(Matrix) SSE #{j}")
+  test_rel(acc.table(j).F, tables[j].F, 1e-15, "GSL::TAMU_ANOVA::Accumulator#table #{j}")
+end
+test_abs((acc.p - GSL::Vector[*tables.map { |t| t.p }]).abs.max, 0.0, 1e-15,
+         "GSL::TAMU_ANOVA::Accumulator#p")
+test_int(acc.n.sum, n, "GSL::TAMU_ANOVA::Accumulator#n")
@@ -251,6 +251,82 @@ for i in 0...DIMENSION do
 end
 Test::test(status, "#{t.class}#swap_indices swap indices")
 
+### General permutation
+a_201 = a.permute([2, 0, 1])
+status = 0
+for i in 0...DIMENSION do
+  for j in 0...DIMENSION do
+    for k in 0...DIMENSION do
+      if a[i, j, k] != a_201[k, i, j]; status += 1; end
+    end
+  end
+end
+Test::test(status, "#{t.class}#permute permutes indices")
+
+### Contraction of two tensors
+tt = a.contract(b, [2, 0], [0, 1])
+Test::test2(tt.rank == 2, "#{t.class}#contract(b, ia, ib) returns valid rank")
+status = 0
+for j in 0...DIMENSION do
+  for n in 0...DIMENSION do
+    z = 0
+    for k in 0...DIMENSION do
+      for i in 0...DIMENSION do
+        z += a[i, j, k]*b[k, i, n]
+      end
+    end
+    if (tt[j, n] - z).abs > 1e-10*z.abs; status += 1; end
+  end
+end
+Test::test(status, "#{t.class}#contract(b, ia, ib) matrix product of the unfoldings")
+
+tt = a.contract(0, 2)
+status = 0
+for j in 0...DIMENSION do
+  z = 0
+  for i in 0...DIMENSION do
+    z += a[i, j, i]
+  end
+  if tt[j] != z; status += 1; end
+end
+Test::test(status, "#{t.class}#contract(i, j) index contraction")
+
+### Broadcasting
+bias = GSL::Vector.alloc(DIMENSION)
+DIMENSION.times { |k| bias[k] = 10.0*k }
+c = a + bias
+m = a.slice(0)
+d = a.mul_elements(m)
+status = 0
+for i in 0...DIMENSION do
+  for j in 0...DIMENSION do
+    for k in 0...DIMENSION do
+      if c[i, j, k] != a[i, j, k] + bias[k]; status += 1; end
+      if d[i, j, k] != a[i, j, k]*a[0, j, k]; status += 1; end
+    end
+  end
+end
+Test::test(status, "#{t.class}#add, #mul_elements broadcast lower ranks")
+
+### Strided slices
+v = a.slice(1, nil, 2)
+w = a.slice([nil, 2], 3, 0)
+mm = a.slice(nil, 4, 1..3)
+status = 0
+for i in 0...DIMENSION do
+  if v[i] != a[1, i, 2]; status += 1; end
+end
+for i in 0...w.size do
+  if w[i] != a[2*i, 3, 0]; status += 1; end
+end
+for i in 0...DIMENSION do
+  for k in 0...3 do
+    if mm[i, k] != a[i, 4, k + 1]; status += 1; end
+  end
+end
+Test::test(status, "#{t.class}#slice strided views")
+Test::test2(w.size == (DIMENSION + 1)/2, "#{t.class}#slice with a step")
+
 ### Test text IO
 file = "tensor_test.txt"
 
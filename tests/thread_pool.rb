@@ -0,0 +1,63 @@
+#!/usr/bin/env ruby
+require("gsl")
+require("./gsl_test2.rb")
+include GSL::Test
+
+GSL::IEEE::env_setup()
+
+pool = GSL::ThreadPool
+size, threshold, threads = pool.size, GSL.parallel_threshold, GSL.parallel_threads
+test2(size >= 1, "GSL::ThreadPool.size")
+test2(pool.blas == :serial, "GSL::ThreadPool.blas is :serial by default")
+
+r = GSL::Rng.alloc
+v = GSL::Vector.alloc(100000)
+v.size.times { |i| v[i] = r.uniform - 0.5 }
+GSL.parallel_threshold = 0
+serial = [v.sum, v.minmax, v.sd]
+
+# The same parts on 1, 3 and 4 threads, and more parts than threads
+GSL.parallel_threshold = 1000
+pool.size = 4
+pool.reset_stats
+test2([v.sum, v.minmax, v.sd] == serial, "GSL::ThreadPool, 4 threads")
+s = pool.stats
+test2(s[:batches] > 0 && s[:nested] == 0, "GSL::ThreadPool.stats batches")
+test_int(s[:parts], s[:caller_parts] + s[:workers].inject(0) { |t, w| t + w[:parts] },
+         "GSL::ThreadPool.stats parts")
+GSL.parallel_threads = 9
+test2([v.sum, v.minmax, v.sd] == serial, "GSL::ThreadPool, 9 parts on 4 threads")
+GSL.parallel_threads = 0
+pool.size = 3
+test2([v.sum, v.minmax, v.sd] == serial, "GSL::ThreadPool, 3 threads")
+pool.size = 1
+pool.reset_stats
+test2([v.sum, v.minmax, v.sd] == serial && pool.stats[:batches] == 0,
+      "GSL::ThreadPool, 1 thread runs on the caller")
+
+# Kernels of several Ruby threads share the pool
+pool.size = 4
+sums = 4.times.map { Thread.new { 10.times.map { v.sum } } }.map(&:value)
+test2(sums.flatten.uniq == [serial[0]], "GSL::ThreadPool shared by Ruby threads")
+
+pool.blas = :keep
+test2(pool.blas == :keep && v.sum == serial[0], "GSL::ThreadPool.blas = :keep")
+pool.blas = :serial
+begin
+  pool.blas = :none
+  test2(false, "GSL::ThreadPool.blas = :none raises")
+rescue ArgumentError
+  test2(true, "GSL::ThreadPool.blas = :none raises")
+end
+begin
+  pool.affinity = true
+  test2(pool.affinity && v.sum == serial[0], "GSL::ThreadPool.affinity")
+  pool.affinity = false
+rescue NotImplementedError
+end
+pool.shutdown
+test2(v.sum == serial[0], "GSL::ThreadPool restarts after shutdown")
+
+pool.size = 0
+GSL.parallel_threshold = threshold
+GSL.parallel_threads = threads
@@ -0,0 +1,72 @@
+#!/usr/bin/env ruby
+
+require("gsl")
+require("test/unit")
+require("stringio")
+
+class VectorFloatTest < Test::Unit::TestCase
+  def test_alloc_and_access
+    v = GSL::Vector::Float[1.5, 2.5, -3.0]
+    assert_equal(3, v.size)
+    assert_equal([1.5, 2.5, -3.0], v.to_a)
+    v[-1] = 4.0
+    assert_equal(4.0, v[2])
+    assert_raise(IndexError) { v[3] }
+    assert_equal(GSL::Vector::Float.alloc(4).to_a, [0.0]*4)
+    assert_equal([0.5, 1.0], GSL::Vector[0.5, 1.0].to_float.to_a)
+    assert_kind_of(GSL::Vector, v.to_v)
+    assert_in_delta(0.1, GSL::Vector::Float[0.1][0], 1e-7)
+  end
+
+  def test_arithmetic
+    a = GSL::Vector::Float[1.0, 2.0, 3.0]
+    b = GSL::Vector::Float[0.5, 0.5, 2.0]
+    assert_equal([1.5, 2.5, 5.0], (a + b).to_a)
+    assert_equal([0.5, 1.5, 1.0], (a - b).to_a)
+    assert_equal([2.0, 4.0, 6.0], (a*2).to_a)
+    assert_equal([2.0, 4.0, 1.5], (a/b).to_a)
+    assert_equal([-1.0, -2.0, -3.0], (-a).to_a)
+    assert_equal([3.0, 6.0, 9.0], (3*a).to_a)
+    assert_equal(6.0, a.sum)
+    assert_equal(8.0, a.dot(b))
+    assert_in_delta(Math.sqrt(14.0), a.nrm2, 1e-6)
+    a.axpy!(2.0, b)
+    assert_equal([2.0, 3.0, 7.0], a.to_a)
+  end
+
+  def test_views
+    v = GSL::Vector::Float[0, 1, 2, 3, 4, 5]
+    s = v.subvector(1, 2, 3)
+    assert_kind_of(GSL::Vector::Float::View, s)
+    assert_equal([1.0, 3.0, 5.0], s.to_a)
+    s.set_all(-1)
+    assert_equal([0.0, -1.0, 2.0, -1.0, 4.0, -1.0], v.to_a)
+  end
+
+  def test_binary_io
+    v = GSL::Vector::Float[1.0, 2.0, 3.0]
+    assert_equal([1.0, 2.0, 3.0].pack("f*"), v.to_binary)
+    assert_equal(v.to_a, GSL::Vector::Float.from_binary(v.to_binary).to_a)
+    io = StringIO.new
+    v.fwrite(io)
+    io.rewind
+    w = GSL::Vector::Float.alloc(3)
+    w.fread(io)
+    assert_equal(v.to_a, w.to_a)
+  end
+
+  def test_matrix
+    a = GSL::Matrix::Float[[1, 2], [3, 4]]
+    x = GSL::Vector::Float[1, 1]
+    assert_equal([2, 2], a.shape)
+    assert_equal([3.0, 7.0], (a*x).to_a)
+    assert_equal([[7.0, 10.0], [15.0, 22.0]], (a*a).to_a)
+    assert_equal([[2.0, 6.0], [4.0, 8.0]], (a.transpose*2).to_a)
+    assert_equal([2.0, 4.0], a.column(1).to_a)
+    c = GSL::Blas.sgemm(GSL::Blas::Trans, GSL::Blas::NoTrans, 1.0, a, a)
+    assert_equal((a.to_m.trans*a.to_m).to_a, c.to_a)
+    y = GSL::Blas.sgemv(GSL::Blas::NoTrans, 2.0, a, x)
+    assert_equal([6.0, 14.0], y.to_a)
+    assert_equal(a.to_a, GSL::Matrix[[1, 2], [3, 4]].to_float.to_a)
+  end
+end
@@ -0,0 +1,70 @@
+#!/usr/bin/env ruby
+
+require("gsl")
+require("test/unit")
+
+class VectorLazyTest < Test::Unit::TestCase
+	def setup
+		@a = GSL::Vector.linspace(-1.0, 2.0, 1000)
+		@b = GSL::Vector.linspace(0.5, 3.0, 1000)
+		@c = GSL::Vector.linspace(-4.0, 1.0, 1000)
+	end
+
+	def assert_vector_close(expected, actual)
+		assert_equal(expected.size, actual.size)
+		expected.size.times { |i| assert_in_delta(expected[i], actual[i], 1e-12) }
+	end
+
+	def test_lazy_fused_arithmetic
+		e = @a.lazy + @b*2.0 - @c.lazy.abs
+		assert_kind_of(GSL::Vector::Lazy, e)
+		assert_equal(1000, e.size)
+		assert_vector_close(@a + @b*2.0 - @c.abs, e.to_v)
+	end
+
+	def test_lazy_functions_and_coerce
+		e = (2.0 - @a.lazy.sin.square) / @b + @b.lazy.log.exp ** 0.5
+		expected = (2.0 - @a.sin*@a.sin)/@b + @b.sqrt
+		assert_vector_close(expected, e.eval)
+	end
+
+	def test_lazy_eval_into_operand
+		expected = @a*@b + 1.0
+		(@a.lazy*@b + 1.0).eval(@a)
+		assert_vector_close(expected, @a)
+	end
+
+	def test_lazy_strided_view
+		v = @c.subvector(0, 500)
+		w = GSL::Vector.alloc(500)
+		(-v.lazy).eval(w)
+		assert_vector_close(v*(-1.0), w)
+	end
+
+	def test_lazy_size_mismatch
+		assert_raise(RangeError) { @a.lazy + GSL::Vector.alloc(3) }
+	end
+
+	def test_lazy_generators
+		assert_vector_close(GSL::Vector.linspace(-1.0, 2.0, 1000), GSL::Vector::Lazy.linspace(-1.0, 2.0, 1000).to_v)
+		assert_vector_close(GSL::Vector.logspace(-2, 1, 50), GSL::Vector::Lazy.logspace(-2, 1, 50).to_v)
+		assert_equal(GSL::Vector.indgen(7, 2, 3), GSL::Vector::Lazy.indgen(7, 2, 3).to_v)
+		e = GSL::Vector::Lazy.linspace(-1.0, 2.0, 1000).sin + @b
+		assert_vector_close(@a.sin + @b, e.to_v)
+		assert_in_delta((@a.sin + @b).sum, e.sum, 1e-10)
+		assert_in_delta(@a.sin[400] + @b[400], e[400], 1e-14)
+		assert_equal(2.0, GSL::Vector::Lazy.linspace(-1.0, 2.0, 10**9)[-1])
+		assert_equal(-1.0, GSL::Vector::Lazy.linspace(-1.0, 2.0, 10**9).min)
+	end
+
+	def test_lazy_each_chunk
+		firsts = []
+		s = 0.0
+		GSL::Vector::Lazy.linspace(-1.0, 2.0, 1000).exp.each_chunk(300) do |v, first|
+			firsts << first
+			s += v.sum
+		end
+		assert_equal([0, 300, 600, 900], firsts)
+		assert_in_delta(@a.exp.sum, s, 1e-10)
+	end
+end
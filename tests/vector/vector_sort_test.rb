@@ -0,0 +1,87 @@
+#!/usr/bin/env ruby
+
+require("gsl")
+require("test/unit")
+
+class VectorSortTest < Test::Unit::TestCase
+	def setup
+		rng = GSL::Rng.alloc
+		@v = GSL::Vector.alloc(5000)
+		@v.size.times { |i| @v[i] = (rng.uniform - 0.5)*10**(i % 7 - 3) }
+		@vi = GSL::Vector::Int.alloc(3000)
+		@vi.size.times { |i| @vi[i] = rng.uniform_int(2001) - 1000 }
+	end
+
+	def test_radix_sort
+		assert_equal(@v.sort, @v.radix_sort)
+		assert_equal(@vi.sort, @vi.radix_sort)
+		w = @v.clone
+		w.radix_sort!
+		assert_equal(@v.sort, w)
+	end
+
+	def test_parallel_sort
+		assert_equal(@v.sort, @v.parallel_sort)
+		w = @vi.clone
+		w.parallel_sort!
+		assert_equal(@vi.sort, w)
+	end
+
+	def test_sort_index
+		[@v, @vi].each { |v|
+			[v.radix_sort_index, v.parallel_sort_index].each { |p|
+				s = v.sort
+				v.size.times { |i| assert_equal(s[i], v[p[i]]) }
+				# stable: ties in ascending order of index
+				(v.size - 1).times { |i| assert(p[i] < p[i+1]) if v[p[i]] == v[p[i+1]] }
+			}
+		}
+	end
+
+	def test_stride
+		m = GSL::Matrix.alloc(100, 2)
+		100.times { |i| m[i, 0] = 100 - i; m[i, 1] = -1.0 }
+		c = m.col(0)
+		c.radix_sort!
+		100.times { |i| assert_equal(i + 1, m[i, 0]); assert_equal(-1.0, m[i, 1]) }
+	end
+
+	def test_nth_element
+		s = @v.sort
+		[0, 1, 2500, 4999].each { |k|
+			assert_equal(s[k], @v.nth_element(k))
+			w = @v.clone
+			assert_equal(s[k], w.nth_element!(k))
+			k.times { |i| assert(w[i] <= s[k]) }
+			(k + 1).upto(w.size - 1) { |i| assert(w[i] >= s[k]) }
+			assert_equal(s, w.sort)
+		}
+		assert_raise(IndexError) { @v.nth_element(@v.size) }
+	end
+
+	def test_median
+		w = @v.clone
+		assert_in_delta(@v.median, w.median!, 1e-15)
+		w = @v.subvector(0, 4999)
+		assert_in_delta(w.median, w.clone.median!, 1e-15)
+		assert_in_delta(@v.median, @v.median_approx, @v.sd/1000)
+		assert_in_delta(@v.median, @v.median_approx(10), @v.sd/10)
+	end
+
+	def test_rows
+		m = GSL::Matrix.alloc(40, 51)
+		rng = GSL::Rng.alloc
+		40.times { |i| 51.times { |j| m[i, j] = rng.uniform } }
+		e = m.clone
+		med = m.median_rows
+		kth = m.nth_element_rows(7)
+		assert_equal(e, m)
+		40.times { |i|
+			s = m.row(i).sort
+			assert_equal(s[25], med[i])
+			assert_equal(s[7], kth[i])
+		}
+		assert_equal(med, m.median_rows!)
+		assert_equal(e.row(3).sort, m.row(3).sort)
+	end
+end
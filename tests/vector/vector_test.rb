@@ -1,141 +1,360 @@
-#!/usr/bin/env ruby
-
-require("gsl")
-require("test/unit")
-
-class VectorTest < Test::Unit::TestCase
-	def test_vector_get
-		v = GSL::Vector::Int.indgen(5)
-		assert_equal(GSL::Vector::Int[3, 1, 2], v.get([3, 1, 2]))
-	end
-	
-	def test_vector_addsub
-		a = GSL::Vector::Int[2, 5, 4]
-		b = GSL::Vector::Int[10, 30, 20]
-		c = GSL::Vector::Int[12, 35, 24]
-		d = GSL::Vector::Int[8, 25, 16]
-		assert_equal(c, a+b)
-		assert_equal(d, b-a)		
-	end
-	
-	def test_vector_collect
-		v = GSL::Vector::Int.indgen(5)
-		u = GSL::Vector::Int[0, 1, 4, 9, 16]
-		w = v.collect { |val| val*val }
-		assert_equal(u, w)
-	end
-
-	def test_vector_ispos_neg
-		v = GSL::Vector::Int.indgen(5)
-		assert_equal(v.ispos, 0)
-		assert_equal(v.ispos?, false)		
-		assert_equal(v.isneg, 0)
-		assert_equal(v.isneg?, false)
-		
-		v += 1
-		assert_equal(v.ispos, 1)
-		assert_equal(v.ispos?, true)		
-		assert_equal(v.isneg, 0)
-		assert_equal(v.isneg?, false)		
-		
-		v -= 100
-		assert_equal(v.ispos, 0)
-		assert_equal(v.ispos?, false)		
-		assert_equal(v.isneg, 1)
-		assert_equal(v.isneg?, true)				
-	end
-		
-	def test_vector_isnonneg
-		v = GSL::Vector::Int.indgen(5)
-		assert_equal(v.isnonneg, 1)
-		assert_equal(v.isnonneg?, true)		
-		assert_equal(v.isneg, 0)
-		assert_equal(v.isneg?, false)
-		
-		v -= 100
-		assert_equal(v.isnonneg, 0)
-		assert_equal(v.isnonneg?, false)		
-		assert_equal(v.isneg, 1)
-		assert_equal(v.isneg?, true)		
-		
-		v += 200
-		assert_equal(v.isnonneg, 1)
-		assert_equal(v.isnonneg?, true)		
-		assert_equal(v.ispos, 1)
-		assert_equal(v.ispos?, true)				
-	end
-
-  def test_vector_subvector
-    v = GSL::Vector::Int.indgen(12)
-
-    # args = []
-    vv = v.subvector
-    assert_not_equal(v.object_id, vv.object_id)
-    assert_equal(v.subvector, v)
-
-    # args = [Fixnum]
-    vv = v.subvector(3)
-    assert_equal([0, 1, 2], vv.to_a)
-    assert_nothing_raised("subvector(-1)") {v.subvector(-1)}
-    vv = v.subvector(-1)
-    assert_equal([11], vv.to_a)
-    vv = v.subvector(-2)
-    assert_equal([10, 11], vv.to_a)
-    assert_raise(RangeError) {v.subvector(-13)}
-
-    # args = [Fixnum, Fixnum]
-    vv = v.subvector(2, 3)
-    assert_equal([2, 3, 4], vv.to_a)
-
-    vv = v.subvector(-4, 3)
-    assert_equal([8, 9, 10], vv.to_a)
-    assert_nothing_raised("subvector(-4, -3)") {v.subvector(-4, -3)}
-    vv = v.subvector(-4, -3)
-    assert_equal([8, 7, 6], vv.to_a)
-    assert_raise(GSL::ERROR::EINVAL) {v.subvector(-11, -3)}
-
-    # args = [Fixnum, Fixnum, Fixnum]
-    vv = v.subvector(1, 3, 4)
-    assert_equal([1, 4, 7, 10], vv.to_a)
-
-    # args = [Range]
-    tests = {
-    # ( range ) => [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
-      ( 1..  3) => [   1, 2, 3                          ],                                   
-      ( 1... 3) => [   1, 2                             ],
-      ( 3..  1) => [   3, 2, 1                          ],
-      ( 3... 1) => [      3, 2                          ],
-      (-7..  9) => [               5, 6, 7, 8, 9        ],
-      (-7... 9) => [               5, 6, 7, 8           ],
-      ( 4.. -3) => [            4, 5, 6, 7, 8, 9        ],
-      ( 4...-3) => [            4, 5, 6, 7, 8           ],
-      ( 2.. -2) => [      2, 3, 4, 5, 6, 7, 8, 9, 10    ],
-      ( 2...-2) => [      2, 3, 4, 5, 6, 7, 8, 9        ],
-      (-2..  2) => [     10, 9, 8, 7, 6, 5, 4, 3,  2    ],
-      (-2... 2) => [     10, 9, 8, 7, 6, 5, 4, 3        ],
-      (-3.. -1) => [                           9, 10, 11],
-      (-3...-1) => [                           9, 10    ],
-      (-1.. -3) => [                          11, 10,  9],
-      (-1...-3) => [                          11, 10    ],
-      # Add more test cases here...
-    }
-    tests.each do |r, x|
-      assert_nothing_raised("subvector(#{r})") {v.subvector(r)}
-      assert_equal(x, v.subvector(r).to_a, "subvector(#{r})")
-    end
-
-    # args = [Range, Fixnum]
-    tests = {
-    # [( range ), s] => [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
-      [( 1..  6), 2] => [   1,    3,    5                    ],
-      [( 1... 6), 2] => [   1,    3,    5                    ],
-      [( 0..  6), 3] => [0,       3,      6                  ],
-      [( 0... 6), 3] => [0,    3                             ],
-      # Add more test cases here...
-    }
-    tests.each do |(r,s), x|
-      assert_nothing_raised("subvector(#{r},#{s})") {v.subvector(r)}
-      assert_equal(x, v.subvector(r,s).to_a, "subvector(#{r},#{s})")
-    end
-  end
-end
+#!/usr/bin/env ruby
+
+require("gsl")
+require("test/unit")
+
+class VectorTest < Test::Unit::TestCase
+	def test_vector_get
+		v = GSL::Vector::Int.indgen(5)
+		assert_equal(GSL::Vector::Int[3, 1, 2], v.get([3, 1, 2]))
+	end
+	
+	def test_vector_addsub
+		a = GSL::Vector::Int[2, 5, 4]
+		b = GSL::Vector::Int[10, 30, 20]
+		c = GSL::Vector::Int[12, 35, 24]
+		d = GSL::Vector::Int[8, 25, 16]
+		assert_equal(c, a+b)
+		assert_equal(d, b-a)		
+	end
+	
+	def test_vector_collect
+		v = GSL::Vector::Int.indgen(5)
+		u = GSL::Vector::Int[0, 1, 4, 9, 16]
+		w = v.collect { |val| val*val }
+		assert_equal(u, w)
+	end
+
+	def test_vector_collect_function
+		v = GSL::Vector.linspace(0.5, 4.0, 8)
+		assert_equal(GSL::Sf::bessel_J0(v).to_a, v.collect(:bessel_J0).to_a)
+		assert_equal(v.to_a.map { |x| Math.tanh(x) }, v.map(:tanh).to_a)
+		f = GSL::Function.compile("exp(-a*x*x)", "a" => 2.0)
+		assert_equal(v.to_a.map { |x| f.eval(x) }, v.map(f).to_a)
+		s = v.subvector_with_stride(1, 2, 4)
+		expected = s.to_a.map { |x| GSL::Sf::gamma(x) }
+		assert_same(s, s.collect!(:gamma))
+		assert_equal(expected, s.to_a)
+		w = v.clone
+		assert_same(w, w.map!("x*x + 1"))
+		assert_equal(v.to_a.map { |x| x*x + 1 }, w.to_a)
+		assert_raise(ArgumentError) { v.map(:no_such_function) }
+		assert_raise(TypeError) { v.map(3) }
+	end
+
+	def test_vector_ispos_neg
+		v = GSL::Vector::Int.indgen(5)
+		assert_equal(v.ispos, 0)
+		assert_equal(v.ispos?, false)		
+		assert_equal(v.isneg, 0)
+		assert_equal(v.isneg?, false)
+		
+		v += 1
+		assert_equal(v.ispos, 1)
+		assert_equal(v.ispos?, true)		
+		assert_equal(v.isneg, 0)
+		assert_equal(v.isneg?, false)		
+		
+		v -= 100
+		assert_equal(v.ispos, 0)
+		assert_equal(v.ispos?, false)		
+		assert_equal(v.isneg, 1)
+		assert_equal(v.isneg?, true)				
+	end
+		
+	def test_vector_isnonneg
+		v = GSL::Vector::Int.indgen(5)
+		assert_equal(v.isnonneg, 1)
+		assert_equal(v.isnonneg?, true)		
+		assert_equal(v.isneg, 0)
+		assert_equal(v.isneg?, false)
+		
+		v -= 100
+		assert_equal(v.isnonneg, 0)
+		assert_equal(v.isnonneg?, false)		
+		assert_equal(v.isneg, 1)
+		assert_equal(v.isneg?, true)		
+		
+		v += 200
+		assert_equal(v.isnonneg, 1)
+		assert_equal(v.isnonneg?, true)		
+		assert_equal(v.ispos, 1)
+		assert_equal(v.ispos?, true)				
+	end
+
+  def test_vector_subvector
+    v = GSL::Vector::Int.indgen(12)
+
+    # args = []
+    vv = v.subvector
+    assert_not_equal(v.object_id, vv.object_id)
+    assert_equal(v.subvector, v)
+
+    # args = [Fixnum]
+    vv = v.subvector(3)
+    assert_equal([0, 1, 2], vv.to_a)
+    assert_nothing_raised("subvector(-1)") {v.subvector(-1)}
+    vv = v.subvector(-1)
+    assert_equal([11], vv.to_a)
+    vv = v.subvector(-2)
+    assert_equal([10, 11], vv.to_a)
+    assert_raise(RangeError) {v.subvector(-13)}
+
+    # args = [Fixnum, Fixnum]
+    vv = v.subvector(2, 3)
+    assert_equal([2, 3, 4], vv.to_a)
+
+    vv = v.subvector(-4, 3)
+    assert_equal([8, 9, 10], vv.to_a)
+    assert_nothing_raised("subvector(-4, -3)") {v.subvector(-4, -3)}
+    vv = v.subvector(-4, -3)
+    assert_equal([8, 7, 6], vv.to_a)
+    assert_raise(GSL::ERROR::EINVAL) {v.subvector(-11, -3)}
+
+    # args = [Fixnum, Fixnum, Fixnum]
+    vv = v.subvector(1, 3, 4)
+    assert_equal([1, 4, 7, 10], vv.to_a)
+
+    # args = [Range]
+    tests = {
+    # ( range ) => [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
+      ( 1..  3) => [   1, 2, 3                          ],                                   
+      ( 1... 3) => [   1, 2                             ],
+      ( 3..  1) => [   3, 2, 1                          ],
+      ( 3... 1) => [      3, 2                          ],
+      (-7..  9) => [               5, 6, 7, 8, 9        ],
+      (-7... 9) => [               5, 6, 7, 8           ],
+      ( 4.. -3) => [            4, 5, 6, 7, 8, 9        ],
+      ( 4...-3) => [            4, 5, 6, 7, 8           ],
+      ( 2.. -2) => [      2, 3, 4, 5, 6, 7, 8, 9, 10    ],
+      ( 2...-2) => [      2, 3, 4, 5, 6, 7, 8, 9        ],
+      (-2..  2) => [     10, 9, 8, 7, 6, 5, 4, 3,  2    ],
+      (-2... 2) => [     10, 9, 8, 7, 6, 5, 4, 3        ],
+      (-3.. -1) => [                           9, 10, 11],
+      (-3...-1) => [                           9, 10    ],
+      (-1.. -3) => [                          11, 10,  9],
+      (-1...-3) => [                          11, 10    ],
+      # Add more test cases here...
+    }
+    tests.each do |r, x|
+      assert_nothing_raised("subvector(#{r})") {v.subvector(r)}
+      assert_equal(x, v.subvector(r).to_a, "subvector(#{r})")
+    end
+
+    # args = [Range, Fixnum]
+    tests = {
+    # [( range ), s] => [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
+      [( 1..  6), 2] => [   1,    3,    5                    ],
+      [( 1... 6), 2] => [   1,    3,    5                    ],
+      [( 0..  6), 3] => [0,       3,      6                  ],
+      [( 0... 6), 3] => [0,    3                             ],
+      # Add more test cases here...
+    }
+    tests.each do |(r,s), x|
+      assert_nothing_raised("subvector(#{r},#{s})") {v.subvector(r)}
+      assert_equal(x, v.subvector(r,s).to_a, "subvector(#{r},#{s})")
+    end
+  end
+
+  def test_vector_arithmetic_strided
+    v = GSL::Vector.indgen(12)
+    a = v.subvector(0, 2, 6)
+    b = v.subvector(1, 2, 6)
+    {
+      "+" => lambda { |x, y| x + y }, "-" => lambda { |x, y| x - y },
+      "*" => lambda { |x, y| x * y }, "/" => lambda { |x, y| x / y },
+    }.each do |op, f|
+      expected = a.to_a.zip(b.to_a).collect { |x, y| f.call(x, y) }
+      assert_equal(expected, a.send(op, b).to_a, "strided #{op}")
+      assert_equal(a.to_a.collect { |x| f.call(x, 4.0) }, a.send(op, 4.0).to_a,
+                   "strided #{op} constant")
+    end
+    c = a - 5.0
+    assert_equal(c.to_a.collect { |x| x.abs }, c.abs.to_a)
+    assert_equal(c.to_a.collect { |x| x*x }, c.square.to_a)
+    assert_equal(a.to_a.collect { |x| Math.sqrt(x) }, a.sqrt.to_a)
+  end
+
+  def test_vector_out_buffer
+    a = GSL::Vector[0.5, 1.0, 1.5, 2.0]
+    b = GSL::Vector[2.0, 4.0, 8.0, 16.0]
+    out = GSL::Vector.alloc(4)
+    assert_same(out, a.add(b, out))
+    assert_equal((a + b).to_a, out.to_a)
+    assert_same(out, a.mul(3.0, :out => out))
+    assert_equal((a*3.0).to_a, out.to_a)
+    assert_same(out, b.log(out))
+    assert_equal(b.log.to_a, out.to_a)
+    assert_same(out, GSL::Sf::bessel_J0(a, :out => out))
+    assert_equal(GSL::Sf::bessel_J0(a).to_a, out.to_a)
+    a.sin(a)
+    assert_equal([0.5, 1.0, 1.5, 2.0].collect { |x| Math.sin(x) }, a.to_a)
+    assert_raise(ArgumentError) { a.exp(GSL::Vector.alloc(3)) }
+  end
+
+  def test_vector_mmap
+    require("tempfile")
+    tmp = Tempfile.new("vector_mmap")
+    tmp.close
+    v = GSL::Vector.indgen(1024)
+    v.fwrite(tmp.path)
+    m = GSL::Vector.mmap(tmp.path)
+    assert_equal(v.to_a, m.to_a)
+    m = GSL::Vector.mmap(tmp.path, :offset => 8*600, :size => 10)
+    assert_equal((600...610).to_a.collect { |x| x.to_f }, m.to_a)
+    m[0] = -1.0
+    assert_equal(600.0, GSL::Vector.mmap(tmp.path)[600])
+    m = GSL::Vector.mmap(tmp.path, :offset => 8*600, :mode => "r+")
+    m[0] = -1.0
+    assert_equal(-1.0, GSL::Vector.mmap(tmp.path)[600])
+    assert_raise(RangeError) { GSL::Vector.mmap(tmp.path, :size => 1025) }
+    assert_raise(ArgumentError) { GSL::Vector.mmap(tmp.path, :offset => 3) }
+    a = GSL::Matrix.mmap(tmp.path, :size2 => 100)
+    assert_equal([10, 100], a.size)
+    assert_equal(v[523], a[5, 23])
+    tmp.unlink
+  end
+
+  def test_vector_binary
+    require("stringio")
+    v = GSL::Vector[1.5, -2.0, 3.25, 4.0]
+    assert_equal(v.to_a.pack("d*"), v.to_binary)
+    assert_equal(v.to_a, GSL::Vector.from_binary(v.to_binary).to_a)
+    assert_equal([1.5, 3.25], v.subvector_with_stride(0, 2, 2).to_binary.unpack("d*"))
+    assert_raise(ArgumentError) { GSL::Vector.from_binary("abc") }
+    io = StringIO.new
+    v.fwrite(io)
+    v.fwrite(io)
+    io.rewind
+    w = GSL::Vector.alloc(4)
+    w.fread(io)
+    assert_equal(v.to_a, w.to_a)
+    w.set_zero
+    w.fread(io)
+    assert_equal(v.to_a, w.to_a)
+    assert_raise(IOError) { w.fread(io) }
+    if v.respond_to?(:to_io_buffer)
+      buf = v.to_io_buffer
+      assert_equal(v.to_binary, buf.get_string)
+      assert_equal(v.to_a, GSL::Vector.from_io_buffer(buf).to_a)
+    end
+  end
+
+  def test_vector_parallel_reduce
+    threshold, threads = GSL.parallel_threshold, GSL.parallel_threads
+    r = GSL::Rng.alloc
+    v = GSL::Vector.alloc(50000)
+    v.size.times { |i| v[i] = r.uniform - 0.5 }
+    v[31234] = 2.0
+    v[20001] = -2.0
+    reduce = lambda {
+      [v.sum, v.prod, v.minmax, v.minmax_index, v.mean, v.sd,
+       GSL::Stats::absdev(v), GSL::Stats::max_index(v)]
+    }
+    GSL.parallel_threshold = 0
+    serial = reduce.call
+    GSL.parallel_threshold = 1000
+    [1, 3, 8].each { |n|
+      GSL.parallel_threads = n
+      assert_equal(serial, reduce.call, "#{n} threads")
+    }
+    a = v.to_a
+    assert_in_delta(a.inject(0.0) { |s, x| s + x }, serial[0], 1e-9)
+    assert_in_delta(Math.sqrt(a.inject(0.0) { |s, x| s + x*x }), v.dnrm2, 1e-9)
+    assert_equal([-2.0, 2.0], serial[2])
+    assert_equal([20001, 31234], serial[3])
+    assert_equal(31234, serial[7])
+    v[40000] = 0.0/0.0
+    assert_equal([40000, 40000], v.minmax_index)
+  ensure
+    GSL.parallel_threshold = threshold
+    GSL.parallel_threads = threads
+  end
+
+  def test_vector_vmath
+    mode, threshold = GSL.vmath, GSL.parallel_threshold
+    assert_equal(:libm, mode)
+    r = GSL::Rng.alloc
+    x = GSL::Vector.alloc(10000)
+    x.size.times { |i| x[i] = 400.0*(r.uniform - 0.5) }
+    pos = x.abs
+    pos[0] = 1e-310
+    GSL.vmath = :fast
+    [0, 1000].each { |th|
+      GSL.parallel_threshold = th
+      [[:sin, x], [:cos, x], [:exp, x], [:log, pos], [:log10, pos]].each { |f, v|
+        y = v.send(f)
+        v.size.times { |i|
+          e = Math.send(f, v[i])
+          assert_in_delta(e, y[i], 2.0*Float::EPSILON*e.abs, "#{f}(#{v[i]})")
+        }
+      }
+    }
+    m = GSL::Matrix.alloc([1.0, 2.0, 3.0, 4.0], 2, 2)
+    assert_in_delta(Math.exp(4.0), m.exp[1, 1], 1e-12)
+    y = x.clone
+    y.sin(y)
+    assert_equal(x.sin.to_a, y.to_a)
+    assert_equal(Math.sin(1e7), GSL::Vector[1e7].sin[0])
+    assert(GSL::Vector[-1.0].log[0].nan?)
+    assert_equal(-1.0/0.0, GSL::Vector[0.0].log[0])
+    assert_equal(0.0, GSL::Vector[-800.0].exp[0])
+  ensure
+    GSL.vmath = mode
+    GSL.parallel_threshold = threshold
+  end
+
+  def test_mask
+    v = GSL::Vector.alloc(200)
+    200.times { |i| v[i] = Math.sin(i) }
+    m = v.mask(:gt, 0.5)
+    expected = (0...200).select { |i| v[i] > 0.5 }
+    assert_equal(expected.size, m.count)
+    assert_equal(expected, m.where.to_a)
+    assert_equal(m, v.gt(0.5).to_bit)
+    assert_equal(v.gt(0.5).to_a, m.to_byte.to_a)
+    assert_equal(expected.size, v.count(:gt, 0.5))
+    assert_equal(expected.map { |i| v[i] }, v.select(m).to_a)
+    assert_equal(v.select(m).to_a, v.select(:gt, 0.5).to_a)
+    assert_equal(v.select(m).to_a, v.select(v.gt(0.5)).to_a)
+    assert_equal(200, (m | ~m).count)
+    assert(!(m & ~m).any?)
+    assert((m | ~m).all?)
+    w = v.clone
+    w.masked_set!(m, 0.5)
+    assert_equal(v.to_a.map { |x| x > 0.5 ? 0.5 : x }, w.to_a)
+    s = v.subvector_with_stride(1, 3, 50)
+    assert_equal((0...50).count { |i| s[i] > v[2*i] }, s.count(:gt, v.subvector_with_stride(0, 2, 50)))
+    a = GSL::Matrix.alloc(v.subvector(0, 120).to_a, 10, 12).submatrix(1, 2, 8, 7)
+    assert_equal(a.to_a.flatten.select { |x| x <= 0.0 }, a.select(:le, 0.0).to_a)
+    a.masked_set!(:le, 0.0, 0.0)
+    assert_equal(0, a.count(:lt, 0.0))
+  end
+
+  def test_vector_t_view
+    v = GSL::Vector[1, 2, 3]
+    c = v.t
+    assert_kind_of(GSL::Vector::Col, c)
+    assert_equal([1.0, 2.0, 3.0], c.to_a)
+    c[1] = 5
+    assert_equal(5.0, v[1])
+    assert_kind_of(GSL::Vector::Col, v.trans)
+    assert(!c.t.kind_of?(GSL::Vector::Col))
+    assert_equal(v*v.t, GSL::Blas.ddot(v, v))
+    vi = GSL::Vector::Int[1, 2]
+    assert_kind_of(GSL::Vector::Int::Col, vi.t)
+  end
+
+  def test_vector_type_dispatch
+    sub = Class.new(GSL::Vector)
+    w = sub.alloc(3).set_all(0.5)
+    assert_in_delta(GSL::Sf::erf(0.5), GSL::Sf::erf(w)[2], 1e-15)
+    v = GSL::Vector[0.5, 0.5]
+    def v.extra; end
+    assert_in_delta(GSL::Sf::erf(0.5), GSL::Sf::erf(v)[1], 1e-15)
+    assert_in_delta(GSL::Sf::erf(0.5), GSL::Sf::erf(v.subvector(0, 1).t)[0], 1e-15)
+    assert_equal(0.5, GSL::Blas.ddot(w, GSL::Vector[0, 0, 1]))
+    assert_raise(TypeError) { GSL::Blas.ddot([1.0], v) }
+    assert_raise(TypeError) { GSL::Blas.ddot(GSL::Matrix.alloc(1, 1), v) }
+  end
+end
@@ -140,3 +140,64 @@ end
           
 
 
+
+GSL::Wavelet.cache_clear
+w = GSL::Wavelet.alloc("daubechies", 4)
+v = GSL::Vector.alloc(64)
+64.times { |i| v[i] = urand() + i*0.01 }
+w.transform_forward(v)
+w.transform_forward(v)
+stats = GSL::Wavelet.cache_stats
+GSL::Test::test(stats[:misses] == 1 && stats[:hits] == 1 ? 0 : 1,
+                "Wavelet workspace cache reuse (#{stats.inspect})")
+
+m = GSL::Matrix.alloc(5, 32)
+5.times { |i| 32.times { |j| m[i, j] = Math.sin(i + 0.3*j) } }
+r = w.transform_rows(m)
+err = 0.0
+5.times { |i|
+  row = GSL::Vector.alloc(32)
+  32.times { |j| row[j] = m[i, j] }
+  err = [err, (w.transform_forward(row) - r.row(i)).abs.max].max
+}
+GSL::Test::test(err > 1e-12 ? 1 : 0, "Wavelet#transform_rows matches transform_forward, err = #{err}")
+
+mt = m.transpose
+c = w.transform_columns(mt)
+GSL::Test::test((c.transpose - r).abs.max > 1e-12 ? 1 : 0, "Wavelet#transform_columns")
+w.transform_columns!(c, GSL::Wavelet::BACKWARD)
+GSL::Test::test((c - mt).abs.max > 1e-12 ? 1 : 0, "Wavelet#transform_columns! inverse")
+
+begin
+  w.transform_rows(GSL::Matrix.alloc(4, 6))
+  GSL::Test::test(1, "Wavelet#transform_rows length check")
+rescue ArgumentError
+  GSL::Test::test(0, "Wavelet#transform_rows length check")
+end
+
+x = GSL::Vector.alloc(64)
+64.times { |i| x[i] = urand() - 0.5 }
+out = w.transform_forward(x)
+st = GSL::Wavelet::Stream.alloc(w, 2)
+[[64], [1, 5, 3, 16]].each { |chunks|
+  d1 = []
+  d2 = []
+  i = 0
+  chunks.cycle { |c|
+    break if i >= 64
+    c = [c, 64 - i].min
+    r = st.push(x.subvector(i, c))
+    i += c
+    d1.concat(r[0].to_a) if r[0]
+    d2.concat(r[1].to_a) if r[1]
+  }
+  r = st.flush
+  d1.concat(r[0].to_a)
+  d2.concat(r[1].to_a)
+  # away from the wrap-around of the periodic transform
+  err = 0.0
+  31.times { |k| err = [err, (d1[k] - out[32 + k]).abs].max }
+  14.times { |k| err = [err, (d2[k] - out[16 + k]).abs].max }
+  GSL::Test::test(err > 1e-12 ? 1 : 0, "Wavelet::Stream #{chunks.inspect} matches transform_forward, err = #{err}")
+  GSL::Test::test(d1.size == 32 && d2.size == 16 ? 0 : 1, "Wavelet::Stream #{chunks.inspect} flush")
+}